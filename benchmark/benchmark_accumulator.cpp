@@ -19,8 +19,8 @@ using namespace xt;
 using namespace hg;
 
 
-std::size_t min_tree_size = 10;
-std::size_t max_tree_size = 20;
+static std::size_t min_tree_size = 10;
+static std::size_t max_tree_size = 20;
 
 
 static void BM_tree_accumulator(benchmark::State &state) {
@@ -43,7 +43,35 @@ static void BM_tree_accumulator(benchmark::State &state) {
 
 BENCHMARK(BM_tree_accumulator)->Range(1 << min_tree_size, 1 << max_tree_size);
 
+/*
+ * Accumulation of vectorial node features (one row of num_features values per node): the element-wise reductions
+ * of the sum, min, max, prod and mean accumulators are processed with xsimd batches (XTENSOR_USE_XSIMD, enabled with
+ * the cmake option USE_SIMD) for contiguous float, double and int32 storage.
+ */
+template<typename value_type, typename accumulator_t>
+static void BM_tree_accumulator_vectorial(benchmark::State &state) {
+    std::size_t size = state.range(0);
+    std::size_t num_features = state.range(1);
+    xt::random::seed(42);
+
+    auto t = get_complete_binary_tree(size);
+    t.compute_children();
+    array_2d<value_type> features = xt::random::randint<int>({t.num_vertices(), num_features}, 0, 10);
 
+    for (auto _ : state) {
+        auto res = hg::accumulate_parallel(t, features, accumulator_t());
+        benchmark::DoNotOptimize(res.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * features.size() * sizeof(value_type));
+}
 
-
-
+BENCHMARK_TEMPLATE(BM_tree_accumulator_vectorial, float, hg::accumulator_sum)
+        ->Args({1 << 10, 64})->Args({1 << 14, 64});
+BENCHMARK_TEMPLATE(BM_tree_accumulator_vectorial, double, hg::accumulator_sum)
+        ->Args({1 << 10, 64})->Args({1 << 14, 64});
+BENCHMARK_TEMPLATE(BM_tree_accumulator_vectorial, int32_t, hg::accumulator_sum)
+        ->Args({1 << 10, 64})->Args({1 << 14, 64});
+BENCHMARK_TEMPLATE(BM_tree_accumulator_vectorial, float, hg::accumulator_max)
+        ->Args({1 << 10, 64})->Args({1 << 14, 64});
+BENCHMARK_TEMPLATE(BM_tree_accumulator_vectorial, double, hg::accumulator_mean)
+        ->Args({1 << 10, 64})->Args({1 << 14, 64});
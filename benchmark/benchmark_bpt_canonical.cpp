@@ -0,0 +1,91 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+/*
+ * Kruskal sweep of the canonical binary partition tree on the edges of large 4 adjacency grids with random edge
+ * weights (the largest grid has 10^8 edges): sequential sweep versus pipelined sweep (gathered edge extremities and
+ * software prefetch of the union-find entries). The edges are given as flat arrays and sorted outside of the timed
+ * region.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/sorting.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+
+/*
+ * Edges of the 4 adjacency graph of a size x size grid, sorted by random weights.
+ */
+struct sorted_grid_edges {
+    index_t num_vertices;
+    array_1d<index_t> sources;
+    array_1d<index_t> targets;
+    array_1d<index_t> sorted_edge_indices;
+
+    explicit sorted_grid_edges(index_t size) {
+        num_vertices = size * size;
+        const index_t num_edges = 2 * size * (size - 1);
+        sources = array_1d<index_t>::from_shape({(size_t) num_edges});
+        targets = array_1d<index_t>::from_shape({(size_t) num_edges});
+        index_t e = 0;
+        for (index_t y = 0; y < size; y++) {
+            for (index_t x = 0; x < size; x++) {
+                const index_t v = y * size + x;
+                if (x + 1 < size) {
+                    sources(e) = v;
+                    targets(e) = v + 1;
+                    e++;
+                }
+                if (y + 1 < size) {
+                    sources(e) = v;
+                    targets(e) = v + size;
+                    e++;
+                }
+            }
+        }
+        xt::random::seed(42);
+        array_1d<float> weights = xt::random::rand<float>({(size_t) num_edges});
+        sorted_edge_indices = arg_sort(weights);
+    }
+};
+
+static void grid_sizes(benchmark::internal::Benchmark *b) {
+    b->Arg(1024)->Arg(2048)->Arg(4096)->Arg(7072)->Unit(benchmark::kMillisecond);
+}
+
+static void BM_bpt_canonical_sweep(benchmark::State &state) {
+    sorted_grid_edges data(state.range(0));
+    for (auto _ : state) {
+        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges(data.sources, data.targets,
+                                                                            data.sorted_edge_indices,
+                                                                            data.num_vertices);
+        benchmark::DoNotOptimize(res.first(0));
+    }
+    state.SetItemsProcessed(state.iterations() * data.sources.size());
+}
+
+BENCHMARK(BM_bpt_canonical_sweep)->Apply(grid_sizes);
+
+static void BM_bpt_canonical_sweep_pipelined(benchmark::State &state) {
+    sorted_grid_edges data(state.range(0));
+    for (auto _ : state) {
+        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges_pipelined(data.sources, data.targets,
+                                                                                      data.sorted_edge_indices,
+                                                                                      data.num_vertices);
+        benchmark::DoNotOptimize(res.first(0));
+    }
+    state.SetItemsProcessed(state.iterations() * data.sources.size());
+}
+
+BENCHMARK(BM_bpt_canonical_sweep_pipelined)->Apply(grid_sizes);
@@ -0,0 +1,108 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+/*
+ * Comparison of the addressable priority queues (structure/indexed_heap.hpp and structure/fibonacci_heap.hpp) on the
+ * two access patterns found in the library: Dijkstra like propagation with integer weights (many decrease-key, monotone
+ * values) and the linkage based binary partition trees (many erase and increase-key, see the bpt_* engines).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "higra/hierarchy/binary_partition_tree.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/indexed_heap.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+
+template<typename policy_t>
+struct policy_heap {
+    template<typename T>
+    using type = typename policy_t::template heap<T>;
+};
+
+/*
+ * Shortest path distances from the top left pixel of a size x size 4 adjacency graph with random integer edge weights.
+ */
+template<typename heap_t>
+static void BM_heap_dijkstra(benchmark::State &state) {
+    index_t size = state.range(0);
+    auto g = get_4_adjacency_graph({size, size});
+    xt::random::seed(42);
+    array_1d<int64_t> weights = xt::random::randint<int64_t>({num_edges(g)}, 0, 256);
+    const int64_t infinity = std::numeric_limits<int64_t>::max();
+
+    for (auto _ : state) {
+        std::vector<int64_t> distances(num_vertices(g), infinity);
+        std::vector<bool> done(num_vertices(g), false);
+        heap_t heap(num_vertices(g));
+        distances[0] = 0;
+        heap.push(0, 0);
+        while (!heap.empty()) {
+            index_t v = heap.top();
+            heap.pop();
+            done[v] = true;
+            for (auto e: out_edge_iterator(v, g)) {
+                index_t n = target(e, g);
+                int64_t d = distances[v] + weights(e.index);
+                if (!done[n] && d < distances[n]) {
+                    if (distances[n] == infinity) {
+                        heap.push(n, d);
+                    } else {
+                        heap.update(n, d);
+                    }
+                    distances[n] = d;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+#define HG_BENCHMARK_HEAP_DIJKSTRA(...) \
+    BENCHMARK_TEMPLATE(BM_heap_dijkstra, __VA_ARGS__)->RangeMultiplier(2)->Range(128, 1024) \
+        ->Unit(benchmark::kMillisecond)
+
+HG_BENCHMARK_HEAP_DIJKSTRA(indexed_dary_heap<int64_t, 2>);
+HG_BENCHMARK_HEAP_DIJKSTRA(indexed_dary_heap<int64_t, 4>);
+HG_BENCHMARK_HEAP_DIJKSTRA(indexed_dary_heap<int64_t, 8>);
+HG_BENCHMARK_HEAP_DIJKSTRA(indexed_pairing_heap<int64_t>);
+HG_BENCHMARK_HEAP_DIJKSTRA(indexed_radix_heap<int64_t>);
+HG_BENCHMARK_HEAP_DIJKSTRA(policy_heap<bpt_fibonacci_heap>::type<int64_t>);
+
+/*
+ * Complete linkage binary partition tree of a size x size 4 adjacency graph with random edge weights.
+ */
+template<typename engine_t>
+static void BM_heap_complete_linkage(benchmark::State &state) {
+    index_t size = state.range(0);
+    auto g = get_4_adjacency_graph({size, size});
+    xt::random::seed(42);
+    array_1d<double> weights = xt::random::rand<double>({num_edges(g)});
+
+    for (auto _ : state) {
+        auto res = binary_partition_tree_complete_linkage<engine_t>(g, weights);
+        benchmark::DoNotOptimize(res.altitudes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+
+#define HG_BENCHMARK_HEAP_LINKAGE(...) \
+    BENCHMARK_TEMPLATE(BM_heap_complete_linkage, __VA_ARGS__)->RangeMultiplier(2)->Range(128, 512) \
+        ->Unit(benchmark::kMillisecond)
+
+HG_BENCHMARK_HEAP_LINKAGE(bpt_dary_heap<2>);
+HG_BENCHMARK_HEAP_LINKAGE(bpt_dary_heap<4>);
+HG_BENCHMARK_HEAP_LINKAGE(bpt_dary_heap<8>);
+HG_BENCHMARK_HEAP_LINKAGE(bpt_pairing_heap);
+HG_BENCHMARK_HEAP_LINKAGE(bpt_fibonacci_heap);
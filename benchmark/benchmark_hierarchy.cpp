@@ -0,0 +1,245 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+/*
+ * End-to-end benchmarks of the main hierarchy constructions on random square images of several sizes.
+ * The inputs are generated with a fixed seed outside of the timed region (see benchmark_tree_of_shapes.cpp for the
+ * tree of shapes).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "higra/algo/connected_filter_pipeline.hpp"
+#include "higra/algo/tree.hpp"
+#include "higra/algo/watershed.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "higra/hierarchy/binary_partition_tree.hpp"
+#include "higra/hierarchy/component_tree.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/hierarchy/watershed_hierarchy.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/image/hierarchy_mean_pb.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+
+static const index_t min_image_size = 1 << 7;
+static const index_t max_image_size = 1 << 10;
+
+/*
+ * 4 adjacency graph of a size x size image with random vertex and edge weights.
+ */
+struct random_image_graph {
+    ugraph graph;
+    array_1d<double> vertex_weights;
+    array_1d<double> edge_weights;
+
+    explicit random_image_graph(index_t size) {
+        graph = get_4_adjacency_graph({size, size});
+        xt::random::seed(42);
+        vertex_weights = xt::random::randint<int>({(size_t) (size * size)}, 0, 256);
+        edge_weights = weight_graph(graph, vertex_weights, weight_functions::L1);
+    }
+};
+
+static void image_sizes(benchmark::internal::Benchmark *b) {
+    b->RangeMultiplier(2)->Range(min_image_size, max_image_size)->Unit(benchmark::kMillisecond);
+}
+
+static void set_processed_pixels(benchmark::State &state) {
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+static void BM_bpt_canonical(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = bpt_canonical(data.graph, data.edge_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_bpt_canonical)->Apply(image_sizes);
+
+static void BM_watershed_hierarchy_by_area(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = watershed_hierarchy_by_area(data.graph, data.edge_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_watershed_hierarchy_by_area)->Apply(image_sizes);
+
+static void BM_watershed_hierarchy_by_volume(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = watershed_hierarchy_by_volume(data.graph, data.edge_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_watershed_hierarchy_by_volume)->Apply(image_sizes);
+
+static void BM_watershed_hierarchy_by_dynamics(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = watershed_hierarchy_by_dynamics(data.graph, data.edge_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_watershed_hierarchy_by_dynamics)->Apply(image_sizes);
+
+static void BM_component_tree_max_tree(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = component_tree_max_tree(data.graph, data.vertex_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_component_tree_max_tree)->Apply(image_sizes);
+
+static void BM_area_opening_max_tree(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = component_tree_max_tree(data.graph, data.vertex_weights);
+        array_1d<index_t> area = attribute_area(res.tree);
+        array_1d<double> filtered = reconstruct_leaf_data(res.tree, res.altitudes, area < 100);
+        benchmark::DoNotOptimize(filtered(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_area_opening_max_tree)->Apply(image_sizes);
+
+static void BM_area_opening(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto filtered = area_opening(data.graph, data.vertex_weights, 100);
+        benchmark::DoNotOptimize(filtered(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_area_opening)->Apply(image_sizes);
+
+static void BM_connected_filter_pipeline(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    connected_filter_pipeline pipeline(filter_pipeline_tree::max_tree);
+    pipeline.remove_if(pipeline.add_attribute(filter_pipeline_attribute::area), filter_pipeline_comparison::less, 100);
+    for (auto _ : state) {
+        auto filtered = pipeline.execute(data.graph, data.vertex_weights);
+        benchmark::DoNotOptimize(filtered(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_connected_filter_pipeline)->Apply(image_sizes);
+
+static void BM_binary_partition_tree_complete_linkage(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    for (auto _ : state) {
+        auto res = binary_partition_tree_complete_linkage(data.graph, data.edge_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_binary_partition_tree_complete_linkage)->Apply(image_sizes);
+
+static void BM_binary_partition_tree_average_linkage(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    array_1d<double> edge_weight_weights = xt::ones<double>({num_edges(data.graph)});
+    for (auto _ : state) {
+        auto res = binary_partition_tree_average_linkage(data.graph, data.edge_weights, edge_weight_weights);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+// the average linkage is much slower on plateaus of equal weights: the largest size is skipped
+BENCHMARK(BM_binary_partition_tree_average_linkage)->RangeMultiplier(2)->Range(min_image_size, max_image_size / 2)
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_binary_partition_tree_ward_linkage(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    array_2d<double> vertex_centroids = xt::view(data.vertex_weights, xt::all(), xt::newaxis());
+    array_1d<double> vertex_sizes = xt::ones<double>({num_vertices(data.graph)});
+    for (auto _ : state) {
+        auto res = binary_partition_tree_ward_linkage(data.graph, vertex_centroids, vertex_sizes);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_binary_partition_tree_ward_linkage)->Apply(image_sizes);
+
+/*
+ * Ward linkage on 128 dimensional embeddings, the centroids are stored in double (range(1) = 0) or single precision.
+ */
+static void BM_binary_partition_tree_ward_linkage_embeddings(benchmark::State &state) {
+    const index_t size = state.range(0);
+    auto graph = get_4_adjacency_graph({size, size});
+    xt::random::seed(42);
+    array_2d<double> vertex_centroids = xt::random::rand<double>({(size_t) (size * size), (size_t) 128});
+    array_1d<double> vertex_sizes = xt::ones<double>({num_vertices(graph)});
+    array_2d<float> vertex_centroids_f = vertex_centroids;
+    array_1d<float> vertex_sizes_f = vertex_sizes;
+    for (auto _ : state) {
+        if (state.range(1) == 0) {
+            auto res = binary_partition_tree_ward_linkage(graph, vertex_centroids, vertex_sizes);
+            benchmark::DoNotOptimize(res.altitudes(0));
+        } else {
+            auto res = binary_partition_tree_ward_linkage(graph, vertex_centroids_f, vertex_sizes_f);
+            benchmark::DoNotOptimize(res.altitudes(0));
+        }
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_binary_partition_tree_ward_linkage_embeddings)->ArgsProduct({{128, 256}, {0, 1}})
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_labelisation_seeded_watershed(benchmark::State &state) {
+    random_image_graph data(state.range(0));
+    // about one seed every 1000 pixels, with 10 different labels
+    array_1d<int> seeds = xt::random::randint<int>({num_vertices(data.graph)}, 0, 10000);
+    seeds = xt::where(seeds < 10, seeds + 1, 0);
+    for (auto _ : state) {
+        auto res = labelisation_seeded_watershed(data.graph, data.edge_weights, seeds);
+        benchmark::DoNotOptimize(res(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_labelisation_seeded_watershed)->Apply(image_sizes);
+
+static void BM_mean_pb_hierarchy_image_size(benchmark::State &state) {
+    index_t size = state.range(0);
+    embedding_grid_2d embedding{size, size};
+    random_image_graph data(size);
+    array_1d<double> edge_orientations = xt::random::rand<double>({num_edges(data.graph)},
+                                                                  0,
+                                                                  xt::numeric_constants<double>::PI);
+    for (auto _ : state) {
+        auto res = mean_pb_hierarchy(data.graph, embedding, data.edge_weights, edge_orientations);
+        benchmark::DoNotOptimize(res.second.altitudes(0));
+    }
+    set_processed_pixels(state);
+}
+
+BENCHMARK(BM_mean_pb_hierarchy_image_size)->Apply(image_sizes);
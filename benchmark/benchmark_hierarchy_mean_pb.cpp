@@ -0,0 +1,40 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include "higra/image/hierarchy_mean_pb.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+
+// size of the images of the Berkeley segmentation dataset
+static const std::size_t image_height = 321;
+static const std::size_t image_width = 481;
+
+template<typename engine_t>
+static void BM_mean_pb_hierarchy(benchmark::State &state) {
+    embedding_grid_2d embedding{(index_t) image_height, (index_t) image_width};
+    auto graph = get_4_adjacency_graph(embedding);
+    xt::random::seed(42);
+    array_1d<double> image = xt::random::rand<double>({image_height * image_width});
+    auto edge_weights = weight_graph(graph, image, weight_functions::L1);
+    array_1d<double> edge_orientations = xt::random::rand<double>({num_edges(graph)},
+                                                                  0,
+                                                                  xt::numeric_constants<double>::PI);
+    for (auto _ : state) {
+        auto res = mean_pb_hierarchy<engine_t>(graph, embedding, edge_weights, edge_orientations);
+        benchmark::DoNotOptimize(res.second.altitudes(0));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_mean_pb_hierarchy, bpt_dary_heap<>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_mean_pb_hierarchy, bpt_nn_chain)->Unit(benchmark::kMillisecond);
@@ -10,34 +10,28 @@
 
 
 #include <benchmark/benchmark.h>
-#include "utils.h"
+#include "fixtures.h"
 
 #include "higra/image/graph_image.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
 #include "higra/hierarchy/watershed_hierarchy.hpp"
-#include "xtensor/xrandom.hpp"
 #include "higra/structure/lca_fast.hpp"
 
 using namespace xt;
 using namespace hg;
 
-index_t repetition = 1;
+static index_t repetition = 1;
 
 static void BM_lca_sparse_table_block(benchmark::State &state) {
+    index_t size = state.range(0);
+    index_t bsize = state.range(1);
+    const auto &data = get_image_graph(image_kind::piecewise_smooth, size);
+    const auto &g = data.graph;
+    auto res = watershed_hierarchy_by_area(g, data.edge_weights);
+    auto &tree = res.tree;
+
     for (auto _ : state) {
         for(index_t i = 0; i < repetition; i++){
-            state.PauseTiming();
-
-            index_t size = state.range(0);
-            index_t bsize = state.range(1);
-
-
-            auto g = get_4_adjacency_graph({size, size});
-            array_1d<double> weights = xt::random::rand<double>({num_edges(g)});
-            auto res = watershed_hierarchy_by_area(g, weights);
-            auto & tree = res.tree;
-
-            state.ResumeTiming();
             lca_sparse_table_block l(tree, bsize);
             auto ll = l.lca(sources(g), targets(g));
 
@@ -59,19 +53,33 @@ BENCHMARK(BM_lca_sparse_table_block)->Apply(gridSearch);
 
 
 static void BM_lca_sparse_table(benchmark::State &state) {
+    index_t size = state.range(0);
+    const auto &data = get_image_graph(image_kind::piecewise_smooth, size);
+    const auto &g = data.graph;
+    auto res = watershed_hierarchy_by_area(g, data.edge_weights);
+    auto &tree = res.tree;
+
     for (auto _ : state) {
         for(index_t i = 0; i < repetition; i++){
-            state.PauseTiming();
+            lca_sparse_table l(tree);
+            auto ll = l.lca(sources(g), targets(g));
 
-            index_t size = state.range(0);
+            benchmark::DoNotOptimize(ll[0]);
+        }
+    }
+}
 
-            auto g = get_4_adjacency_graph({size, size});
-            array_1d<double> weights = xt::random::rand<double>({num_edges(g)});
-            auto res = watershed_hierarchy_by_area(g, weights);
-            auto & tree = res.tree;
+BENCHMARK(BM_lca_sparse_table)->DenseRange(256, 2048, 256);
+static void BM_lca_bitmask_block(benchmark::State &state) {
+    index_t size = state.range(0);
+    const auto &data = get_image_graph(image_kind::piecewise_smooth, size);
+    const auto &g = data.graph;
+    auto res = watershed_hierarchy_by_area(g, data.edge_weights);
+    auto &tree = res.tree;
 
-            state.ResumeTiming();
-            lca_sparse_table l(tree);
+    for (auto _ : state) {
+        for(index_t i = 0; i < repetition; i++){
+            lca_bitmask_block l(tree);
             auto ll = l.lca(sources(g), targets(g));
 
             benchmark::DoNotOptimize(ll[0]);
@@ -79,4 +87,46 @@ static void BM_lca_sparse_table(benchmark::State &state) {
     }
 }
 
-BENCHMARK(BM_lca_sparse_table)->DenseRange(256, 2048, 256);
\ No newline at end of file
+BENCHMARK(BM_lca_bitmask_block)->DenseRange(256, 2048, 256);
+
+/*
+ * Queries only, the solver being built outside of the measured loop: the extremities of the edges of the graph are
+ * close in the Euler tour and most of their queries are answered inside a block (in-block tables, sub-block minima
+ * and vectorized scans).
+ */
+static void BM_lca_query_sparse_table_block(benchmark::State &state) {
+    index_t size = state.range(0);
+    index_t bsize = state.range(1);
+    const auto &data = get_image_graph(image_kind::piecewise_smooth, size);
+    const auto &g = data.graph;
+    auto res = watershed_hierarchy_by_area(g, data.edge_weights);
+    lca_sparse_table_block l(res.tree, bsize);
+
+    for (auto _ : state) {
+        auto ll = l.lca(sources(g), targets(g));
+        benchmark::DoNotOptimize(ll[0]);
+    }
+}
+
+static void querySearch(benchmark::internal::Benchmark *b) {
+    for (index_t i: {512, 2048})
+        for (int j = 32; j <= 4096; j *= 2)
+            b->Args({i, j});
+}
+
+BENCHMARK(BM_lca_query_sparse_table_block)->Apply(querySearch);
+
+static void BM_lca_query_sparse_table(benchmark::State &state) {
+    index_t size = state.range(0);
+    const auto &data = get_image_graph(image_kind::piecewise_smooth, size);
+    const auto &g = data.graph;
+    auto res = watershed_hierarchy_by_area(g, data.edge_weights);
+    lca_sparse_table l(res.tree);
+
+    for (auto _ : state) {
+        auto ll = l.lca(sources(g), targets(g));
+        benchmark::DoNotOptimize(ll[0]);
+    }
+}
+
+BENCHMARK(BM_lca_query_sparse_table)->Arg(512)->Arg(2048);
@@ -11,17 +11,21 @@
 #include <benchmark/benchmark.h>
 
 #include "higra/graph.hpp"
+#include "higra/sorting.hpp"
 #include "xtensor/xview.hpp"
 #include "xtensor/xrandom.hpp"
 #include <algorithm>
+
+#ifdef HG_USE_TBB
 #include "tbb/parallel_sort.h"
 #include "tbb-ssort/parallel_stable_sort.h"
+#endif
 
 using namespace xt;
 using namespace hg;
 
-std::size_t min_array_size = 10;
-std::size_t max_array_size = 24;
+static std::size_t min_array_size = 10;
+static std::size_t max_array_size = 24;
 
 
 
@@ -56,6 +60,8 @@ static void BM_stl_stable_sort(benchmark::State &state) {
 
 BENCHMARK(BM_stl_stable_sort)->Range(1 << min_array_size, 1 << max_array_size);
 
+#ifdef HG_USE_TBB
+
 static void BM_tbb_parallel_sort(benchmark::State &state) {
     for (auto _ : state) {
         state.PauseTiming();
@@ -84,4 +90,89 @@ static void BM_tbb_parallel_stable_sort(benchmark::State &state) {
     }
 }
 
-BENCHMARK(BM_tbb_parallel_stable_sort)->Range(1 << min_array_size, 1 << max_array_size);
\ No newline at end of file
+BENCHMARK(BM_tbb_parallel_stable_sort)->Range(1 << min_array_size, 1 << max_array_size);
+
+#endif
+
+template<typename value_t>
+static void BM_comparison_stable_arg_sort(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        size_t size = state.range(0);
+        array_1d<value_t> a = xt::random::randint<int>({size}, 0, 256);
+        state.ResumeTiming();
+        // a comparison function other than std::less/std::greater disables the radix sort
+        auto res = hg::stable_arg_sort(a, [](value_t x, value_t y) { return x < y; });
+        bool flag;
+        benchmark::DoNotOptimize(flag = (res.size() == size));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_comparison_stable_arg_sort, uint8_t)->Range(1 << min_array_size, 1 << max_array_size);
+BENCHMARK_TEMPLATE(BM_comparison_stable_arg_sort, float)->Range(1 << min_array_size, 1 << max_array_size);
+
+template<typename value_t>
+static void BM_radix_stable_arg_sort(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        size_t size = state.range(0);
+        array_1d<value_t> a = xt::random::randint<int>({size}, 0, 256);
+        state.ResumeTiming();
+        auto res = hg::stable_arg_sort(a);
+        bool flag;
+        benchmark::DoNotOptimize(flag = (res.size() == size));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_radix_stable_arg_sort, uint8_t)->Range(1 << min_array_size, 1 << max_array_size);
+BENCHMARK_TEMPLATE(BM_radix_stable_arg_sort, uint16_t)->Range(1 << min_array_size, 1 << max_array_size);
+BENCHMARK_TEMPLATE(BM_radix_stable_arg_sort, float)->Range(1 << min_array_size, 1 << max_array_size);
+
+// stable arg sort of slightly perturbed values (range(1) per mille of the values changed) from the order of the
+// unperturbed values (range(2) == 1) or from scratch (range(2) == 0)
+static void BM_stable_arg_sort_warm_start(benchmark::State &state) {
+    size_t size = state.range(0);
+    array_1d<float> a = xt::round(xt::random::rand<float>({size}) * 1000);
+    array_1d<index_t> initial_order = hg::stable_arg_sort(a);
+    index_t num_changes = (index_t) size * state.range(1) / 1000;
+    for (index_t i = 0; i < num_changes; i++) {
+        a(xt::random::randint<index_t>({1}, 0, size)(0)) += 5;
+    }
+    for (auto _ : state) {
+        array_1d<index_t> res = (state.range(2) == 1) ?
+                                hg::stable_arg_sort_warm_start(a, initial_order) :
+                                hg::stable_arg_sort(a);
+        bool flag;
+        benchmark::DoNotOptimize(flag = (res.size() == size));
+    }
+}
+
+BENCHMARK(BM_stable_arg_sort_warm_start)->Ranges({{1 << 16, 1 << 22}, {1, 100}, {0, 1}});
+
+// hg::sort and hg::stable_sort with a serial cutoff of 0 (always parallel, range(1) == 0) or with the default
+// policy (range(1) == 1): used to choose sorting_internal::default_sort_policy
+template<bool stable>
+static void BM_hg_sort_cutoff(benchmark::State &state) {
+    auto policy = (state.range(1) == 0) ?
+                  sorting_internal::default_sort_policy.with_serial_cutoff(0) :
+                  sorting_internal::default_sort_policy;
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        size_t size = state.range(0);
+        array_1d<float> a = xt::random::rand<float>({size});
+        state.ResumeTiming();
+        if (stable) {
+            hg::stable_sort(policy, a.begin(), a.end(), std::less<float>());
+        } else {
+            hg::sort(policy, a.begin(), a.end(), std::less<float>());
+        }
+        bool flag;
+        benchmark::DoNotOptimize(flag = (a.size() == size));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_hg_sort_cutoff, false)->Ranges({{1 << 6, 1 << 20}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_hg_sort_cutoff, true)->Ranges({{1 << 6, 1 << 20}, {0, 1}});
@@ -19,8 +19,8 @@ using namespace xt;
 using namespace hg;
 
 
-std::size_t min_size = 6;
-std::size_t max_size = 12;
+static std::size_t min_size = 6;
+static std::size_t max_size = 12;
 
 
 static void BM_graph_implicit_adjacency_iterator(benchmark::State &state) {
@@ -46,3 +46,30 @@ static void BM_graph_implicit_adjacency_iterator(benchmark::State &state) {
 BENCHMARK(BM_graph_implicit_adjacency_iterator)->Range(1 << min_size, 1 << max_size);
 
 
+
+static void BM_embedding_lin2grid(benchmark::State &state) {
+    hg::index_t size = state.range(0);
+    hg::embedding_grid_3d embedding({size, size + 1, 3});
+    for (auto _ : state) {
+        index_t sum = 0;
+        for (index_t i = 0; i < (index_t) embedding.size(); i++) {
+            auto p = embedding.lin2grid(i);
+            sum += p(0) + p(1) + p(2);
+        }
+        benchmark::DoNotOptimize(++sum);
+    }
+}
+
+BENCHMARK(BM_embedding_lin2grid)->Range(1 << min_size, 1 << max_size);
+
+static void BM_embedding_lin2grid_array(benchmark::State &state) {
+    hg::index_t size = state.range(0);
+    hg::embedding_grid_2d embedding({size, size + 1});
+    array_1d<index_t> indices = xt::arange<index_t>(0, (index_t) embedding.size());
+    for (auto _ : state) {
+        auto coordinates = embedding.lin2grid(indices);
+        benchmark::DoNotOptimize(coordinates.data());
+    }
+}
+
+BENCHMARK(BM_embedding_lin2grid_array)->Range(1 << min_size, 1 << max_size);
@@ -9,6 +9,7 @@
 ****************************************************************************/
 
 #include <benchmark/benchmark.h>
+#include "utils.h"
 
 #include "higra/graph.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
@@ -20,12 +21,14 @@
 #include "xtensor/xstrided_view.hpp"
 #include "xtensor/xeval.hpp"
 #include "higra/attribute/tree_attribute.hpp"
+#include "higra/hierarchy/component_tree.hpp"
+#include "higra/image/graph_image.hpp"
 
 using namespace xt;
 using namespace hg;
 
-std::size_t min_tree_size = 10;
-std::size_t max_tree_size = 16;
+static std::size_t min_tree_size = 10;
+static std::size_t max_tree_size = 16;
 
 static void BM_tree_volume_cstyle(benchmark::State &state) {
     for (auto _ : state) {
@@ -72,4 +75,122 @@ static void BM_tree_volume_xtstyle(benchmark::State &state) {
     }
 }
 
-BENCHMARK(BM_tree_volume_xtstyle)->Range(1 << min_tree_size, 1 << max_tree_size);
\ No newline at end of file
+BENCHMARK(BM_tree_volume_xtstyle)->Range(1 << min_tree_size, 1 << max_tree_size);
+
+/**
+ * Children based implementation of attribute_extinction_value (increasing altitudes) used as reference:
+ * extrema detection, deepest child selection and propagation are performed in separate passes.
+ */
+template<typename tree_t, typename T1, typename T2>
+auto extinction_value_reference(const tree_t &tree, const T1 &altitudes, const T2 &attribute) {
+    using value_type = typename T1::value_type;
+    tree.compute_children();
+
+    array_1d<index_t> ref_son({num_vertices(tree)}, invalid_index);
+    auto min_depth = xt::empty_like(altitudes);
+    for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
+        min_depth(n) = (std::numeric_limits<value_type>::max)();
+        bool flag = true;
+        for (auto c: children_iterator(n, tree)) {
+            if (!is_leaf(c, tree)) {
+                flag = false;
+                if (min_depth(c) < min_depth(n)) {
+                    min_depth(n) = min_depth(c);
+                    ref_son(n) = c;
+                }
+            }
+        }
+        if (flag) {
+            min_depth(n) = altitudes(n);
+        }
+    }
+
+    array_1d<typename T2::value_type> extinction = array_1d<typename T2::value_type>::from_shape(
+            {num_vertices(tree)});
+    extinction(root(tree)) = attribute(root(tree));
+    for (auto n: root_to_leaves_iterator(tree, leaves_it::exclude, root_it::exclude)) {
+        auto pn = parent(n, tree);
+        if (n == ref_son(pn)) {
+            extinction(n) = extinction(pn);
+        } else {
+            extinction(n) = attribute(n);
+        }
+    }
+
+    auto extrema = attribute_extrema(tree, altitudes);
+    auto indices = xt::eval(xt::arange<index_t>(num_vertices(tree)));
+    if (!extrema(root(tree))) {
+        indices(root(tree)) = -1;
+    }
+    auto extrema_leaves = propagate_sequential(tree, indices, !extrema);
+    for (auto n: leaves_iterator(tree)) {
+        if (extrema_leaves(n) != -1) {
+            extinction(n) = extinction(extrema_leaves(n));
+        } else {
+            extinction(n) = 0;
+        }
+    }
+    return extinction;
+}
+
+static auto get_random_min_tree(std::size_t size) {
+    xt::random::seed(42);
+    auto graph = get_4_adjacency_graph({(index_t) size, (index_t) size});
+    array_1d<int> vertex_weights = xt::random::randint<int>({num_vertices(graph)}, 0, 256);
+    return component_tree_min_tree(graph, vertex_weights);
+}
+
+static void BM_tree_dynamics_reference(benchmark::State &state) {
+    auto res = get_random_min_tree(state.range(0));
+    auto &tree = res.tree;
+    auto &altitudes = res.altitudes;
+    for (auto _ : state) {
+        tree.clear_children();
+        auto height = attribute_height(tree, altitudes, true);
+        auto dynamics = extinction_value_reference(tree, altitudes, height);
+        benchmark::DoNotOptimize(dynamics[0]);
+    }
+}
+
+BENCHMARK(BM_tree_dynamics_reference)->Range(1 << 7, 1 << 11);
+
+static void BM_tree_dynamics(benchmark::State &state) {
+    auto res = get_random_min_tree(state.range(0));
+    auto &tree = res.tree;
+    auto &altitudes = res.altitudes;
+    for (auto _ : state) {
+        tree.clear_children();
+        auto dynamics = attribute_dynamics(tree, altitudes, true);
+        benchmark::DoNotOptimize(dynamics[0]);
+    }
+}
+
+BENCHMARK(BM_tree_dynamics)->Range(1 << 7, 1 << 11);
+
+static void BM_tree_extinction_value_reference(benchmark::State &state) {
+    auto res = get_random_min_tree(state.range(0));
+    auto &tree = res.tree;
+    auto &altitudes = res.altitudes;
+    auto area = attribute_area(tree);
+    for (auto _ : state) {
+        tree.clear_children();
+        auto extinction = extinction_value_reference(tree, altitudes, area);
+        benchmark::DoNotOptimize(extinction[0]);
+    }
+}
+
+BENCHMARK(BM_tree_extinction_value_reference)->Range(1 << 7, 1 << 11);
+
+static void BM_tree_extinction_value(benchmark::State &state) {
+    auto res = get_random_min_tree(state.range(0));
+    auto &tree = res.tree;
+    auto &altitudes = res.altitudes;
+    auto area = attribute_area(tree);
+    for (auto _ : state) {
+        tree.clear_children();
+        auto extinction = attribute_extinction_value(tree, altitudes, area, true);
+        benchmark::DoNotOptimize(extinction[0]);
+    }
+}
+
+BENCHMARK(BM_tree_extinction_value)->Range(1 << 7, 1 << 11);
@@ -24,8 +24,8 @@
 using namespace xt;
 using namespace hg;
 
-std::size_t min_tree_size = 10;
-std::size_t max_tree_size = 16;
+static std::size_t min_tree_size = 10;
+static std::size_t max_tree_size = 16;
 
 
 
@@ -42,7 +42,7 @@ static void BM_tree_accumulate_parallel_scalar_cstyle(benchmark::State &state) {
         auto sout = output.data();
         auto sin = input.data();
         std::fill(sout, sout + t.num_vertices(), 0);
-        for (auto i: t.iterate_from_leaves_to_root(leaves_it::exclude)) {
+        for (auto i: leaves_to_root_iterator(t, leaves_it::exclude)) {
             for (auto c: t.children(i)) {
                 sout[i] += sin[c];
             }
@@ -106,6 +106,52 @@ static void BM_tree_accumulate_parallel_light_view_vectorial(benchmark::State &s
 }
 
 BENCHMARK(BM_tree_accumulate_parallel_light_view_vectorial)->Range(1 << min_tree_size, 1 << max_tree_size);
+/*
+ * Out edge traversal with the statically typed out edge iterator of tree, and with an equivalent iterator whose
+ * transform function is a std::function (former implementation).
+ */
+static void BM_tree_out_edge_iterator(benchmark::State &state) {
+    auto t = get_complete_binary_tree(state.range(0));
+    t.compute_children();
+    for (auto _ : state) {
+        index_t sum = 0;
+        for (auto v: vertex_iterator(t)) {
+            for (auto e: out_edge_iterator(v, t)) {
+                sum += target(e, t) + e.index;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(BM_tree_out_edge_iterator)->Range(1 << min_tree_size, 1 << max_tree_size);
+
+static void BM_tree_out_edge_iterator_std_function(benchmark::State &state) {
+    auto t = get_complete_binary_tree(state.range(0));
+    t.compute_children();
+    using edge_t = tree::edge_descriptor;
+    using fun_t = std::function<edge_t(index_t)>;
+    using it_t = transform_forward_iterator<fun_t, tree_internal::tree_graph_adjacent_vertex_iterator<false>, edge_t>;
+    for (auto _ : state) {
+        index_t sum = 0;
+        for (auto v: vertex_iterator(t)) {
+            fun_t fun = [v](index_t n) {
+                return edge_t(v, n, (std::min)(v, n));
+            };
+            auto c = t.children(v);
+            auto par = t.parent(v);
+            for (auto it = it_t(tree::adjacency_iterator(v, par, c.cbegin()), fun),
+                         end = it_t(tree::adjacency_iterator(par, par, c.cend()), fun); it != end; it++) {
+                auto e = *it;
+                sum += e.target + e.index;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(BM_tree_out_edge_iterator_std_function)->Range(1 << min_tree_size, 1 << max_tree_size);
+
 /*
 static void BM_tree_accumulate_parallel_vectorial(benchmark::State& state) {
     for (auto _ : state)
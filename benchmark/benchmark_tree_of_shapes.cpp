@@ -0,0 +1,72 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include "higra/graph.hpp"
+#include "higra/image/tree_of_shapes.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+
+static std::size_t min_image_size = 7;
+static std::size_t max_image_size = 11;
+
+template<typename value_t>
+static void BM_tree_of_shapes(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::size_t size = state.range(0);
+        xt::random::seed(42);
+        array_2d<value_t> image = xt::random::randint<int>({size, size}, 0, 256);
+        state.ResumeTiming();
+        auto res = component_tree_tree_of_shapes_image2d(image);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_tree_of_shapes, uint8_t)->Range(1 << min_image_size, 1 << max_image_size)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_tree_of_shapes, float)->Range(1 << min_image_size, 1 << max_image_size)
+        ->Unit(benchmark::kMillisecond);
+
+template<typename value_t>
+static void BM_parallel_tree_of_shapes(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::size_t size = state.range(0);
+        xt::random::seed(42);
+        array_2d<value_t> image = xt::random::randint<int>({size, size}, 0, 256);
+        state.ResumeTiming();
+        auto res = component_tree_parallel_tree_of_shapes_image2d(image);
+        benchmark::DoNotOptimize(res.altitudes(0));
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_parallel_tree_of_shapes, uint8_t)->Range(1 << min_image_size, 1 << max_image_size)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_parallel_tree_of_shapes, float)->Range(1 << min_image_size, 1 << max_image_size)
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_tree_of_shapes_interpolation(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::size_t size = state.range(0);
+        xt::random::seed(42);
+        array_2d<uint8_t> image = xt::random::randint<int>({size, size}, 0, 256);
+        state.ResumeTiming();
+        auto res = tree_of_shapes_internal::interpolate_plain_map_khalimsky_2d(
+                image, embedding_grid_2d{(index_t) size, (index_t) size});
+        benchmark::DoNotOptimize(res(0, 0));
+    }
+}
+
+BENCHMARK(BM_tree_of_shapes_interpolation)->Range(1 << min_image_size, 1 << max_image_size);
@@ -22,8 +22,8 @@ using namespace xt;
 using namespace hg;
 
 
-std::size_t min_size = 6;
-std::size_t max_size = 12;
+static std::size_t min_size = 6;
+static std::size_t max_size = 12;
 
 static void BM_from_edge_list_no_preallocation(benchmark::State &state) {
     for (auto _ : state) {
@@ -96,3 +96,47 @@ static void BM_graph_implicit_to_explicit(benchmark::State &state) {
 
 BENCHMARK(BM_graph_implicit_to_explicit)->Range(1 << min_size, 1 << max_size);
 
+
+/*
+ * Out edge traversal with the statically typed out edge iterator of ugraph, and with an equivalent iterator whose
+ * transform function is a std::function (former implementation).
+ */
+static void BM_out_edge_iterator(benchmark::State &state) {
+    hg::index_t size = state.range(0);
+    auto g = hg::get_4_adjacency_graph(hg::embedding_grid_2d({size, size}));
+    for (auto _ : state) {
+        hg::index_t sum = 0;
+        for (auto v: vertex_iterator(g)) {
+            for (auto e: out_edge_iterator(v, g)) {
+                sum += target(e, g) + e.index;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(BM_out_edge_iterator)->Range(1 << min_size, 1 << max_size);
+
+static void BM_out_edge_iterator_std_function(benchmark::State &state) {
+    hg::index_t size = state.range(0);
+    auto g = hg::get_4_adjacency_graph(hg::embedding_grid_2d({size, size}));
+    using edge_t = ugraph::edge_descriptor;
+    using fun_t = std::function<edge_t(index_t)>;
+    using it_t = transform_forward_iterator<fun_t, ugraph::out_edge_index_iterator, edge_t>;
+    for (auto _ : state) {
+        hg::index_t sum = 0;
+        for (auto v: vertex_iterator(g)) {
+            fun_t fun = [v, &g](index_t oei) {
+                const auto &oe = g.edge_from_index(oei);
+                return edge_t(v, (v == oe.source) ? oe.target : oe.source, oe.index);
+            };
+            for (auto it = it_t(g.out_edges_cbegin(v), fun), end = it_t(g.out_edges_cend(v), fun); it != end; it++) {
+                auto e = *it;
+                sum += e.target + e.index;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(BM_out_edge_iterator_std_function)->Range(1 << min_size, 1 << max_size);
@@ -0,0 +1,61 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+
+#include <benchmark/benchmark.h>
+
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/unionfind.hpp"
+#include "higra/sorting.hpp"
+#include "xtensor/xrandom.hpp"
+
+using namespace xt;
+using namespace hg;
+using namespace hg::union_find_internal;
+
+/*
+ * Kruskal like sweep over the edges of a 4 adjacency graph with random edge weights:
+ * this is the access pattern of bpt_canonical and of the seeded watershed.
+ */
+template<typename union_find_t>
+static void BM_union_find_kruskal(benchmark::State &state) {
+    index_t size = state.range(0);
+    auto g = get_4_adjacency_graph({size, size});
+    array_1d<float> weights = xt::random::rand<float>({num_edges(g)});
+    array_1d<index_t> sorted_edges = stable_arg_sort(weights);
+    auto &&srcs = sources(g);
+    auto &&tgts = targets(g);
+
+    for (auto _ : state) {
+        union_find_t uf(num_vertices(g));
+        index_t num_links = 0;
+        for (auto ei: sorted_edges) {
+            auto c1 = uf.find(srcs(ei));
+            auto c2 = uf.find(tgts(ei));
+            if (c1 != c2) {
+                uf.link(c1, c2);
+                num_links++;
+            }
+        }
+        benchmark::DoNotOptimize(num_links);
+    }
+}
+
+#define HG_BENCHMARK_UNION_FIND(...) \
+    BENCHMARK_TEMPLATE(BM_union_find_kruskal, __VA_ARGS__)->RangeMultiplier(2)->Range(256, 4096)
+
+HG_BENCHMARK_UNION_FIND(hg::union_find);
+HG_BENCHMARK_UNION_FIND(union_find_internal::union_find<index_t, path_halving>);
+HG_BENCHMARK_UNION_FIND(union_find_internal::union_find<index_t, path_splitting>);
+HG_BENCHMARK_UNION_FIND(union_find_internal::union_find<index_t, path_compression, link_by_size>);
+HG_BENCHMARK_UNION_FIND(union_find_internal::union_find<index_t, path_compression, link_by_rank, interleaved_layout>);
+HG_BENCHMARK_UNION_FIND(union_find_internal::union_find<int32_t>);
+HG_BENCHMARK_UNION_FIND(hg::union_find_halving<index_t>);
+HG_BENCHMARK_UNION_FIND(hg::union_find_halving<int32_t>);
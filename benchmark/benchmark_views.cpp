@@ -9,6 +9,7 @@
 ****************************************************************************/
 
 #include <benchmark/benchmark.h>
+#include "utils.h"
 
 #include "higra/graph.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
@@ -23,23 +24,8 @@
 using namespace xt;
 using namespace hg;
 
-std::size_t min_tree_size = 10;
-std::size_t max_tree_size = 16;
-
-bool is_power_of_two(std::size_t x) {
-    return (x != 0) && ((x & (x - 1)) == 0);
-}
-
-auto get_complete_binary_tree(std::size_t num_leaves) {
-    assert(is_power_of_two(num_leaves));
-    array_1d<std::size_t> parent = array_1d<std::size_t>::from_shape({num_leaves * 2 - 1});
-    for (std::size_t i = 0, j = num_leaves; i < parent.size() - 1; j++) {
-        parent(i++) = j;
-        parent(i++) = j;
-    }
-    parent(parent.size() - 1) = parent.size() - 1;
-    return tree(parent);
-}
+static std::size_t min_tree_size = 10;
+static std::size_t max_tree_size = 16;
 
 static void BM_tree_propagate_parallel(benchmark::State &state) {
     for (auto _ : state) {
@@ -77,4 +63,20 @@ static void BM_view_propagate_parallel(benchmark::State &state) {
     }
 }
 
-BENCHMARK(BM_view_propagate_parallel)->Range(1 << min_tree_size, 1 << max_tree_size);
\ No newline at end of file
+BENCHMARK(BM_view_propagate_parallel)->Range(1 << min_tree_size, 1 << max_tree_size);
+static void BM_gather_propagate_parallel(benchmark::State &state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        std::size_t size = state.range(0);
+        xt::random::seed(42);
+        auto t = get_complete_binary_tree(size);
+        auto input = eval(random::randn<double>({t.num_vertices()}));
+        state.ResumeTiming();
+        auto output = gather(input, t.parents());
+
+        benchmark::DoNotOptimize(output[t.root()]);
+    }
+}
+
+BENCHMARK(BM_gather_propagate_parallel)->Range(1 << min_tree_size, 1 << max_tree_size);
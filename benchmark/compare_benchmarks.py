@@ -0,0 +1,89 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+"""
+Compare two JSON result files of the benchmark suite (``benchmark_higra --benchmark_out=file.json
+--benchmark_out_format=json``, or ``make benchmark_json``) and report the benchmarks whose time increased by more
+than a given threshold.
+
+Usage: ``python compare_benchmarks.py baseline.json contender.json [--threshold 0.1] [--filter regex]``
+
+The exit status is 1 if a regression was found and 0 otherwise.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+
+def load_times(filename):
+    """
+    Map benchmark names to their real time in nanoseconds. When the benchmarks were repeated, the median
+    aggregate is used.
+    """
+    with open(filename) as f:
+        results = json.load(f)
+
+    units = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+    times = {}
+    medians = {}
+    for b in results["benchmarks"]:
+        if b.get("error_occurred", False):
+            continue
+        time = b["real_time"] * units[b.get("time_unit", "ns")]
+        if b.get("run_type", "iteration") == "aggregate":
+            if b.get("aggregate_name") == "median":
+                medians[b["run_name"]] = time
+        else:
+            times[b.get("run_name", b["name"])] = time
+    times.update(medians)
+    return times, results.get("context", {})
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files.")
+    parser.add_argument("baseline", help="JSON results of the reference run")
+    parser.add_argument("contender", help="JSON results of the new run")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="relative time increase above which a benchmark is reported as a regression")
+    parser.add_argument("--filter", default=None, help="only compare benchmarks whose name matches this regex")
+    args = parser.parse_args(argv)
+
+    baseline, baseline_context = load_times(args.baseline)
+    contender, contender_context = load_times(args.contender)
+
+    for name, context in (("baseline", baseline_context), ("contender", contender_context)):
+        print("%s: %s, %s CPUs at %s MHz" % (name, context.get("date", "?"), context.get("num_cpus", "?"),
+                                          context.get("mhz_per_cpu", "?")))
+
+    regressions = []
+    print("%-70s %14s %14s %8s" % ("benchmark", "baseline (ns)", "new (ns)", "change"))
+    for name in sorted(set(baseline) & set(contender)):
+        if args.filter is not None and re.search(args.filter, name) is None:
+            continue
+        old, new = baseline[name], contender[name]
+        change = (new - old) / old if old > 0 else 0
+        flag = ""
+        if change > args.threshold:
+            flag = " REGRESSION"
+            regressions.append(name)
+        print("%-70s %14.0f %14.0f %+7.1f%%%s" % (name, old, new, 100 * change, flag))
+
+    missing = sorted(set(baseline) - set(contender))
+    if missing:
+        print("\nBenchmarks missing from the contender: " + ", ".join(missing))
+
+    print("\n%d regression(s) above %.0f%%" % (len(regressions), 100 * args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
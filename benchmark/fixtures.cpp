@@ -0,0 +1,239 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "fixtures.h"
+
+#include "higra/image/graph_image.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include "higra/algo/knn_graph.hpp"
+#include "higra/io/pnm_io.hpp"
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <tuple>
+
+using namespace hg;
+
+const char *image_kind_name(image_kind kind) {
+    switch (kind) {
+        case image_kind::piecewise_smooth:
+            return "piecewise_smooth";
+        case image_kind::fractal_noise:
+            return "fractal_noise";
+        case image_kind::plateaus:
+            return "plateaus";
+        case image_kind::uniform_noise:
+            return "uniform_noise";
+    }
+    return "unknown";
+}
+
+/*
+ * Rescales the values of the image in [0, 255].
+ */
+static void normalize_image(array_2d<double> &image) {
+    double min_value = xt::amin(image)();
+    double max_value = xt::amax(image)();
+    if (max_value > min_value) {
+        image = (image - min_value) * (255.0 / (max_value - min_value));
+    } else {
+        image.fill(0);
+    }
+}
+
+array_2d<double> make_piecewise_smooth_image(index_t height, index_t width, index_t num_regions, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> noise(0, 2);
+
+    struct region {
+        double y, x, value, slope_y, slope_x;
+    };
+    std::vector<region> regions((std::size_t) num_regions);
+    for (auto &r: regions) {
+        r.y = uniform(generator) * height;
+        r.x = uniform(generator) * width;
+        r.value = uniform(generator) * 255;
+        r.slope_y = (uniform(generator) - 0.5) * 128 / height;
+        r.slope_x = (uniform(generator) - 0.5) * 128 / width;
+    }
+
+    array_2d<double> image = array_2d<double>::from_shape({(std::size_t) height, (std::size_t) width});
+    for (index_t y = 0; y < height; y++) {
+        for (index_t x = 0; x < width; x++) {
+            const region *closest = &regions[0];
+            double closest_distance = std::numeric_limits<double>::max();
+            for (const auto &r: regions) {
+                double d = (y - r.y) * (y - r.y) + (x - r.x) * (x - r.x);
+                if (d < closest_distance) {
+                    closest_distance = d;
+                    closest = &r;
+                }
+            }
+            image(y, x) = closest->value + closest->slope_y * (y - closest->y) + closest->slope_x * (x - closest->x)
+                          + noise(generator);
+        }
+    }
+    normalize_image(image);
+    return image;
+}
+
+array_2d<double> make_fractal_noise_image(index_t height, index_t width, index_t num_octaves, double persistence,
+                                          unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    array_2d<double> image = xt::zeros<double>({(std::size_t) height, (std::size_t) width});
+    double amplitude = 1;
+    double cell_size = (double) (std::max)(height, width) / 2;
+    for (index_t octave = 0; octave < num_octaves && cell_size >= 1; octave++, amplitude *= persistence) {
+        // random values on a lattice of step cell_size, bilinearly interpolated
+        const index_t lattice_height = (index_t) (height / cell_size) + 2;
+        const index_t lattice_width = (index_t) (width / cell_size) + 2;
+        array_2d<double> lattice = array_2d<double>::from_shape({(std::size_t) lattice_height,
+                                                                 (std::size_t) lattice_width});
+        for (auto &v: lattice) {
+            v = uniform(generator);
+        }
+        for (index_t y = 0; y < height; y++) {
+            const double fy = y / cell_size;
+            const index_t ly = (index_t) fy;
+            const double dy = fy - ly;
+            for (index_t x = 0; x < width; x++) {
+                const double fx = x / cell_size;
+                const index_t lx = (index_t) fx;
+                const double dx = fx - lx;
+                image(y, x) += amplitude * ((1 - dy) * ((1 - dx) * lattice(ly, lx) + dx * lattice(ly, lx + 1)) +
+                                            dy * ((1 - dx) * lattice(ly + 1, lx) + dx * lattice(ly + 1, lx + 1)));
+            }
+        }
+        cell_size /= 2;
+    }
+    normalize_image(image);
+    return image;
+}
+
+array_2d<double> make_plateau_image(index_t height, index_t width, index_t num_levels, unsigned int seed) {
+    array_2d<double> image = make_fractal_noise_image(height, width, 6, 0.5, seed);
+    const double step = 256.0 / num_levels;
+    for (auto &v: image) {
+        v = std::floor(v / step) * step;
+    }
+    return image;
+}
+
+array_2d<double> make_image(image_kind kind, index_t height, index_t width, unsigned int seed) {
+    switch (kind) {
+        case image_kind::piecewise_smooth:
+            return make_piecewise_smooth_image(height, width, 64, seed);
+        case image_kind::fractal_noise:
+            return make_fractal_noise_image(height, width, 6, 0.5, seed);
+        case image_kind::plateaus:
+            return make_plateau_image(height, width, 8, seed);
+        case image_kind::uniform_noise: {
+            std::mt19937 generator(seed);
+            std::uniform_int_distribution<int> uniform(0, 255);
+            array_2d<double> image = array_2d<double>::from_shape({(std::size_t) height, (std::size_t) width});
+            for (auto &v: image) {
+                v = uniform(generator);
+            }
+            return image;
+        }
+    }
+    throw std::runtime_error("Unknown image kind.");
+}
+
+array_2d<double> make_clustered_points(index_t num_points, index_t dim, index_t num_clusters, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> normal(0, 1);
+
+    array_2d<double> centers = array_2d<double>::from_shape({(std::size_t) num_clusters, (std::size_t) dim});
+    array_1d<double> deviations = array_1d<double>::from_shape({(std::size_t) num_clusters});
+    for (auto &v: centers) {
+        v = uniform(generator);
+    }
+    for (auto &v: deviations) {
+        v = 0.01 + 0.09 * uniform(generator);
+    }
+
+    std::uniform_int_distribution<index_t> cluster(0, num_clusters - 1);
+    array_2d<double> points = array_2d<double>::from_shape({(std::size_t) num_points, (std::size_t) dim});
+    for (index_t i = 0; i < num_points; i++) {
+        const index_t c = cluster(generator);
+        for (index_t j = 0; j < dim; j++) {
+            points(i, j) = centers(c, j) + deviations(c) * normal(generator);
+        }
+    }
+    return points;
+}
+
+static image_graph_fixture make_image_graph(const array_2d<double> &image) {
+    image_graph_fixture fixture;
+    fixture.shape = {image.shape()[0], image.shape()[1]};
+    fixture.graph = get_4_adjacency_graph(fixture.shape);
+    fixture.vertex_weights = xt::flatten(image);
+    fixture.edge_weights = weight_graph(fixture.graph, fixture.vertex_weights, weight_functions::L1);
+    return fixture;
+}
+
+/*
+ * Thread safe cache of fixtures: the fixture associated to a key is created by make on the first request and lives
+ * until the end of the process.
+ */
+template<typename key_t, typename fixture_t, typename F>
+static const fixture_t &get_cached(std::map<key_t, std::unique_ptr<fixture_t>> &cache, const key_t &key,
+                                   const F &make) {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &fixture = cache[key];
+    if (!fixture) {
+        fixture.reset(new fixture_t(make()));
+    }
+    return *fixture;
+}
+
+const image_graph_fixture &get_image_graph(image_kind kind, index_t size) {
+    static std::map<std::pair<image_kind, index_t>, std::unique_ptr<image_graph_fixture>> cache;
+    return get_cached(cache, std::make_pair(kind, size), [kind, size]() {
+        return make_image_graph(make_image(kind, size, size));
+    });
+}
+
+const knn_graph_fixture &get_knn_graph(index_t num_points, index_t dim, index_t num_neighbours) {
+    static std::map<std::tuple<index_t, index_t, index_t>, std::unique_ptr<knn_graph_fixture>> cache;
+    return get_cached(cache, std::make_tuple(num_points, dim, num_neighbours), [=]() {
+        knn_graph_fixture fixture;
+        fixture.points = make_clustered_points(num_points, dim);
+        auto res = approximate_knn_graph(fixture.points, num_neighbours);
+        fixture.graph = std::move(res.first);
+        fixture.edge_weights = std::move(res.second);
+        return fixture;
+    });
+}
+
+const image_graph_fixture &get_pnm_image_graph(const std::string &filename) {
+    static std::map<std::string, std::unique_ptr<image_graph_fixture>> cache;
+    return get_cached(cache, filename, [&filename]() {
+        std::string path = filename;
+        const char *directory = std::getenv("HG_BENCHMARK_IMAGES");
+        if (directory != nullptr && !filename.empty() && filename[0] != '/') {
+            path = std::string(directory) + "/" + filename;
+        }
+        array_nd<double> image = read_image_pnm<double>(path.c_str());
+        if (image.dimension() == 3) {
+            // color image: mean of the channels
+            return make_image_graph(xt::mean(image, {2}));
+        }
+        return make_image_graph(image);
+    });
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+/*
+ * Synthetic inputs resembling real workloads for the benchmarks.
+ *
+ * Uniform random noise produces images without any region structure and hierarchies that are pathologically
+ * unbalanced. The generators below produce structured inputs instead: piecewise smooth images (smooth regions
+ * separated by sharp contours), fractal noise (texture at all scales), plateau images (large flat zones) and clustered
+ * point clouds. All generators are deterministic for a given seed.
+ *
+ * The get_* functions return fixtures cached for the lifetime of the benchmark process: a fixture is generated the
+ * first time it is requested and all the later runs of the benchmarks (other arguments, repetitions) reuse it, so
+ * that generating the inputs is kept out of the measured time, even when a benchmark is run once per argument.
+ */
+
+#pragma once
+
+#include "higra/graph.hpp"
+#include <string>
+
+/*
+ * Kinds of synthetic images.
+ */
+enum class image_kind {
+    piecewise_smooth,
+    fractal_noise,
+    plateaus,
+    uniform_noise
+};
+
+const char *image_kind_name(image_kind kind);
+
+/*
+ * Image made of num_regions Voronoi cells of random seeds, each filled with a random affine ramp plus a small noise.
+ * Values are in [0, 255].
+ */
+hg::array_2d<double> make_piecewise_smooth_image(hg::index_t height, hg::index_t width,
+                                                 hg::index_t num_regions = 64, unsigned int seed = 42);
+
+/*
+ * Sum of num_octaves octaves of bilinearly interpolated value noise, the amplitude of each octave is persistence
+ * times the amplitude of the previous one. Values are in [0, 255].
+ */
+hg::array_2d<double> make_fractal_noise_image(hg::index_t height, hg::index_t width,
+                                              hg::index_t num_octaves = 6, double persistence = 0.5,
+                                              unsigned int seed = 42);
+
+/*
+ * Fractal noise quantized on num_levels levels: the image contains large flat zones.
+ */
+hg::array_2d<double> make_plateau_image(hg::index_t height, hg::index_t width,
+                                        hg::index_t num_levels = 8, unsigned int seed = 42);
+
+/*
+ * Image of the given kind.
+ */
+hg::array_2d<double> make_image(image_kind kind, hg::index_t height, hg::index_t width, unsigned int seed = 42);
+
+/*
+ * num_points points of dimension dim drawn from num_clusters gaussian clusters with random centers in [0, 1]^dim and
+ * random standard deviations in [0.01, 0.1].
+ */
+hg::array_2d<double> make_clustered_points(hg::index_t num_points, hg::index_t dim,
+                                           hg::index_t num_clusters = 16, unsigned int seed = 42);
+
+/*
+ * 4 adjacency graph of an image with its vertex weights and L1 edge weights.
+ */
+struct image_graph_fixture {
+    std::vector<std::size_t> shape;
+    hg::ugraph graph;
+    hg::array_1d<double> vertex_weights;
+    hg::array_1d<double> edge_weights;
+};
+
+/*
+ * Approximate k nearest neighbours graph (see approximate_knn_graph) of a clustered point cloud.
+ */
+struct knn_graph_fixture {
+    hg::array_2d<double> points;
+    hg::ugraph graph;
+    hg::array_1d<double> edge_weights;
+};
+
+/*
+ * Cached 4 adjacency graph of a size x size synthetic image.
+ */
+const image_graph_fixture &get_image_graph(image_kind kind, hg::index_t size);
+
+/*
+ * Cached k nearest neighbours graph of num_points clustered points of dimension dim.
+ */
+const knn_graph_fixture &get_knn_graph(hg::index_t num_points, hg::index_t dim, hg::index_t num_neighbours);
+
+/*
+ * Cached 4 adjacency graph of a real image read with read_image_pnm (color images are converted to gray levels).
+ * Relative file names are searched in the directory given by the environment variable HG_BENCHMARK_IMAGES (current
+ * directory if it is not defined). Throws if the image cannot be read.
+ */
+const image_graph_fixture &get_pnm_image_graph(const std::string &filename);
@@ -0,0 +1,23 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+"""
+Benchmarks of the Python API, run with airspeed velocity (https://asv.readthedocs.io) from the directory
+``benchmark/python``:
+
+- ``asv run --python=same``: benchmarks the installed version of higra;
+- ``asv run v0.6.0..master``: builds and benchmarks a range of commits, ``asv publish`` and ``asv preview`` show the
+  evolution of the results;
+- ``asv continuous master HEAD``: reports the benchmarks that changed significantly between two commits.
+
+``time_*`` benchmarks measure the wall time of a call (including the Python wrappers, argument casting and data cache
+lookups) and ``peakmem_*`` benchmarks measure the peak resident memory of the process. Benchmarks on real images
+require scikit-image and are skipped when it is not installed.
+"""
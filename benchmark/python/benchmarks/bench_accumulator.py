@@ -0,0 +1,45 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import numpy as np
+import higra as hg
+
+from .common import images, get_image_graph
+
+
+class Accumulators:
+    params = images
+    param_names = ["image"]
+
+    def setup(self, name):
+        self.image, self.graph, self.edge_weights = get_image_graph(name)
+        self.tree, self.altitudes = hg.bpt_canonical(self.graph, self.edge_weights)
+        self.node_weights = np.ones(self.tree.num_vertices())
+        self.leaf_data = self.image.reshape(-1)
+        rng = np.random.RandomState(42)
+        self.indices = rng.randint(0, 256, self.leaf_data.size)
+
+    def time_accumulate_parallel(self, name):
+        hg.accumulate_parallel(self.tree, self.node_weights, hg.Accumulators.sum)
+
+    def time_accumulate_sequential(self, name):
+        hg.accumulate_sequential(self.tree, self.leaf_data, hg.Accumulators.max)
+
+    def peakmem_accumulate_sequential(self, name):
+        hg.accumulate_sequential(self.tree, self.leaf_data, hg.Accumulators.max)
+
+    def time_accumulate_and_add_sequential(self, name):
+        hg.accumulate_and_add_sequential(self.tree, self.node_weights, self.leaf_data, hg.Accumulators.sum)
+
+    def time_accumulate_graph_edges(self, name):
+        hg.accumulate_graph_edges(self.graph, self.edge_weights, hg.Accumulators.mean)
+
+    def time_accumulate_at(self, name):
+        hg.accumulate_at(self.indices, self.leaf_data, hg.Accumulators.sum)
@@ -0,0 +1,57 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+
+from .common import images, get_image_graph
+
+
+class TreeAttributes:
+    """
+    Attributes are cached on the tree by default: the benchmarks use force_recompute=True to measure the actual
+    computation and the *_cached benchmarks measure the cost of a cache hit.
+    """
+    params = images
+    param_names = ["image"]
+
+    def setup(self, name):
+        self.image, self.graph, self.edge_weights = get_image_graph(name)
+        self.tree, self.altitudes = hg.bpt_canonical(self.graph, self.edge_weights)
+        hg.attribute_area(self.tree)
+
+    def time_attribute_area(self, name):
+        hg.attribute_area(self.tree, force_recompute=True)
+
+    def time_attribute_area_cached(self, name):
+        hg.attribute_area(self.tree)
+
+    def time_attribute_volume(self, name):
+        hg.attribute_volume(self.tree, self.altitudes, force_recompute=True)
+
+    def time_attribute_height(self, name):
+        hg.attribute_height(self.tree, self.altitudes, force_recompute=True)
+
+    def time_attribute_dynamics(self, name):
+        hg.attribute_dynamics(self.tree, self.altitudes, force_recompute=True)
+
+    def time_attribute_depth(self, name):
+        hg.attribute_depth(self.tree, force_recompute=True)
+
+    def time_attribute_contour_length(self, name):
+        hg.attribute_contour_length(self.tree, force_recompute=True)
+
+    def peakmem_attribute_contour_length(self, name):
+        hg.attribute_contour_length(self.tree, force_recompute=True)
+
+    def time_attribute_mean_vertex_weights(self, name):
+        hg.attribute_mean_vertex_weights(self.tree, self.image, force_recompute=True)
+
+    def time_attribute_extinction_value(self, name):
+        hg.attribute_extinction_value(self.tree, self.altitudes, hg.attribute_area(self.tree), force_recompute=True)
@@ -0,0 +1,64 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+
+from .common import images, get_image_graph
+
+
+class Hierarchy:
+    params = images
+    param_names = ["image"]
+
+    def setup(self, name):
+        self.image, self.graph, self.edge_weights = get_image_graph(name)
+
+    def time_bpt_canonical(self, name):
+        hg.bpt_canonical(self.graph, self.edge_weights)
+
+    def peakmem_bpt_canonical(self, name):
+        hg.bpt_canonical(self.graph, self.edge_weights)
+
+    def time_watershed_hierarchy_by_area(self, name):
+        hg.watershed_hierarchy_by_area(self.graph, self.edge_weights)
+
+    def peakmem_watershed_hierarchy_by_area(self, name):
+        hg.watershed_hierarchy_by_area(self.graph, self.edge_weights)
+
+    def time_component_tree_max_tree(self, name):
+        hg.component_tree_max_tree(self.graph, self.image)
+
+    def peakmem_component_tree_max_tree(self, name):
+        hg.component_tree_max_tree(self.graph, self.image)
+
+
+class HierarchyImage:
+    params = images
+    param_names = ["image"]
+
+    def setup(self, name):
+        self.image, self.graph, self.edge_weights = get_image_graph(name)
+        self.tree, self.altitudes = hg.watershed_hierarchy_by_area(self.graph, self.edge_weights)
+
+    def time_saliency(self, name):
+        hg.saliency(self.tree, self.altitudes)
+
+    def peakmem_saliency(self, name):
+        hg.saliency(self.tree, self.altitudes)
+
+    def time_graph_4_adjacency_2_khalimsky(self, name):
+        hg.graph_4_adjacency_2_khalimsky(self.graph, self.edge_weights)
+
+    def peakmem_graph_4_adjacency_2_khalimsky(self, name):
+        hg.graph_4_adjacency_2_khalimsky(self.graph, self.edge_weights)
+
+    def time_saliency_khalimsky(self, name):
+        # typical contour visualization pipeline
+        hg.graph_4_adjacency_2_khalimsky(self.graph, hg.saliency(self.tree, self.altitudes))
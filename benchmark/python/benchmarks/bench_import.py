@@ -0,0 +1,21 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+
+class Import:
+    """
+    Import time of higra, measured in a fresh interpreter (numpy is imported beforehand and is not measured).
+    """
+
+    def timeraw_import_higra(self):
+        return "import higra", "import numpy"
+
+    def timeraw_import_higra_and_optional_modules(self):
+        return "import higra; higra.plot; higra.interop; higra.io_utils", "import numpy"
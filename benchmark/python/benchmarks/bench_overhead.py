@@ -0,0 +1,48 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import numpy as np
+import higra as hg
+
+
+class BindingOverhead:
+    """
+    Calls on tiny inputs: the measured times are dominated by the Python wrappers, the argument casting and the data
+    cache lookups.
+    """
+
+    def setup(self):
+        self.graph = hg.get_4_adjacency_graph((8, 8))
+        rng = np.random.RandomState(42)
+        self.edge_weights = rng.rand(self.graph.num_edges())
+        self.edge_weights_int = rng.randint(0, 256, self.graph.num_edges()).astype(np.int16)
+        self.tree, self.altitudes = hg.bpt_canonical(self.graph, self.edge_weights)
+
+    def time_bpt_canonical(self):
+        hg.bpt_canonical(self.graph, self.edge_weights)
+
+    def time_bpt_canonical_cast(self):
+        # int16 weights are cast by the bindings
+        hg.bpt_canonical(self.graph, self.edge_weights_int)
+
+    def time_cast_to_dtype(self):
+        hg.cast_to_dtype(self.edge_weights_int, np.float64)
+
+    def time_attribute_area(self):
+        hg.attribute_area(self.tree, force_recompute=True)
+
+    def time_attribute_area_cached(self):
+        hg.attribute_area(self.tree)
+
+    def time_attribute_area_no_cache(self):
+        hg.attribute_area(self.tree, no_cache=True)
+
+    def time_get_4_adjacency_graph(self):
+        hg.get_4_adjacency_graph((8, 8))
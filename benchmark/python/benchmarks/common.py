@@ -0,0 +1,50 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import numpy as np
+import higra as hg
+
+# synthetic images (random_<size>) and real images from scikit-image
+images = ["random_256", "random_512", "random_1024", "camera", "astronaut"]
+
+
+def get_image(name):
+    """
+    Grayscale image (2d array of float64) of the given name.
+    Raises NotImplementedError (asv skips the benchmark) if the image is not available.
+    """
+    if name.startswith("random_"):
+        size = int(name[len("random_"):])
+        rng = np.random.RandomState(42)
+        # random noise smoothed by a box filter: produces regional extrema of various sizes
+        image = rng.rand(size + 4, size + 4)
+        image = np.cumsum(np.cumsum(image, axis=0), axis=1)
+        image = image[4:, 4:] - image[:-4, 4:] - image[4:, :-4] + image[:-4, :-4]
+        return image / 16
+
+    try:
+        import skimage.data
+    except ImportError:
+        raise NotImplementedError("scikit-image is not installed")
+
+    image = getattr(skimage.data, name)().astype(np.float64)
+    if image.ndim == 3:
+        image = np.mean(image, axis=2)
+    return image / 255
+
+
+def get_image_graph(name):
+    """
+    Image, 4 adjacency graph and edge weights (absolute difference) of the image of the given name.
+    """
+    image = get_image(name)
+    graph = hg.get_4_adjacency_graph(image.shape)
+    edge_weights = hg.weight_graph(graph, image, hg.WeightFunction.L1)
+    return image, graph, edge_weights
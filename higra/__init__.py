@@ -11,6 +11,7 @@
 # pre-declaration of globals
 globals()["__higra_global_cache"] = None
 globals()["__auto_caching"] = True
+globals()["__persistent_cache"] = None
 
 # extension module
 from .higram import *
@@ -34,11 +35,52 @@ from .assessment import *
 from .attribute import *
 from .hierarchy import *
 from .image import *
-from .interop import *
-from .io_utils import *
-from .plot import *
 from .structure import *
 
+# optional modules, imported on first access to one of their members (see __getattr__): they are not used by the
+# rest of the library and importing them eagerly would only slow down "import higra"
+__lazy_modules = ("interop", "io_utils", "plot")
+
+
+def __load_lazy_module(module_name):
+    """
+    Imports the given optional module and adds its public members to the higra namespace (as "from module import *")
+
+    :param module_name: name of a module in __lazy_modules
+    :return: the module
+    """
+    import importlib
+    module = importlib.import_module("." + module_name, __name__)
+    names = getattr(module, "__all__", None)
+    if names is None:
+        names = [n for n in dir(module) if not n.startswith("_")]
+    g = globals()
+    for n in names:
+        g.setdefault(n, getattr(module, n))
+    return module
+
+
+def __getattr__(name):
+    """
+    Module level attribute lookup (PEP 562), only called when name is not found in the higra namespace: loads the
+    optional modules until name is found.
+    """
+    if name in __lazy_modules:
+        return __load_lazy_module(name)
+    if not name.startswith("__"):
+        g = globals()
+        for module_name in __lazy_modules:
+            __load_lazy_module(module_name)
+            if name in g:
+                return g[name]
+    raise AttributeError("module '" + __name__ + "' has no attribute '" + name + "'")
+
+
+def __dir__():
+    for module_name in __lazy_modules:
+        __load_lazy_module(module_name)
+    return list(globals().keys())
+
 
 def __logger_printer(m):
     print(m)
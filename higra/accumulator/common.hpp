@@ -12,6 +12,7 @@
 
 #include "py_accumulators.hpp"
 #include "../py_common.hpp"
+#include "higra/accumulator/accumulator.hpp"
 
 template<typename functor_t>
 auto dispatch_accumulator(const functor_t & fun, const hg::accumulators & accumulator){
@@ -36,5 +37,9 @@ auto dispatch_accumulator(const functor_t & fun, const hg::accumulators & accumu
             return fun(hg::accumulator_argmin());
         case hg::accumulators::argmax:
             return fun(hg::accumulator_argmax());
+        case hg::accumulators::variance:
+            return fun(hg::accumulator_variance());
+        case hg::accumulators::covariance:
+            return fun(hg::accumulator_covariance());
     }
 }
@@ -29,5 +29,7 @@ void py_init_accumulators(pybind11::module &m) {
             .value("first", hg::accumulators::first)
             .value("last", hg::accumulators::last)
             .value("argmin", hg::accumulators::argmin)
-            .value("argmax", hg::accumulators::argmax);
+            .value("argmax", hg::accumulators::argmax)
+            .value("variance", hg::accumulators::variance)
+            .value("covariance", hg::accumulators::covariance);
 }
\ No newline at end of file
@@ -33,11 +33,13 @@ struct def_accumulate_parallel {
     void def(C &c, const char *doc) {
         c.def("_accumulate_parallel", [](const graph_t &tree, const pyarray<value_t> &input,
                                          hg::accumulators accumulator) {
-                  return dispatch_accumulator(
-                          [&tree, &input](const auto &acc) {
-                              return hg::accumulate_parallel(tree, input, acc);
-                          },
-                          accumulator);
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &input](const auto &acc) {
+                                  return hg::accumulate_parallel(tree, pyarray_view(input), acc);
+                              },
+                              accumulator);
+                  });
               },
               doc,
               py::arg("tree"),
@@ -53,11 +55,29 @@ struct def_accumulate_sequential {
     void def(C &c, const char *doc) {
         c.def("_accumulate_sequential",
               [](const graph_t &tree, const pyarray<value_t> &vertex_data, hg::accumulators accumulator) {
-                  return dispatch_accumulator(
-                          [&tree, &vertex_data](const auto &acc) {
-                              return hg::accumulate_sequential(tree, vertex_data, acc);
-                          },
-                          accumulator);
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &vertex_data](const auto &acc) {
+                                  return hg::accumulate_sequential(tree, pyarray_view(vertex_data), acc);
+                              },
+                              accumulator);
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("leaf_data"),
+              py::arg("accumulator"));
+        c.def("_accumulate_sequential_float64",
+              [](const graph_t &tree, const pyarray<value_t> &vertex_data, hg::accumulators accumulator) {
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &vertex_data](const auto &acc) {
+                                  auto data = pyarray_view(vertex_data);
+                                  return hg::accumulate_sequential<graph_t, decltype(data),
+                                          std::decay_t<decltype(acc)>, double>(tree, data, acc);
+                              },
+                              accumulator);
+                  });
               },
               doc,
               py::arg("tree"),
@@ -104,11 +124,17 @@ struct def_accumulate_and_combine_sequential {
         c.def(name,
               [&f](const graph_t &tree, const pyarray<value_t> &input, const pyarray<value_t> &vertex_data,
                    hg::accumulators accumulator) {
-                  return dispatch_accumulator(
-                          [&tree, &input, &vertex_data, &f](const auto &acc) {
-                              return hg::accumulate_and_combine_sequential(tree, input, vertex_data, acc, f);
-                          },
-                          accumulator);
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &input, &vertex_data, &f](const auto &acc) {
+                                  return hg::accumulate_and_combine_sequential(tree,
+                                                                               pyarray_view(input),
+                                                                               pyarray_view(vertex_data),
+                                                                               acc,
+                                                                               f);
+                              },
+                              accumulator);
+                  });
               },
               doc,
               py::arg("tree"),
@@ -127,7 +153,9 @@ struct def_propagate_sequential {
         c.def("_propagate_sequential",
               [](const graph_t &tree, const pyarray<value_t> &input,
                  const pyarray<bool> &condition) {
-                  return hg::propagate_sequential(tree, input, condition);
+                  return without_gil([&] {
+                      return hg::propagate_sequential(tree, pyarray_view(input), pyarray_view(condition));
+                  });
               },
               doc,
               py::arg("tree"),
@@ -144,11 +172,13 @@ struct def_propagate_parallel {
         c.def("_propagate_parallel",
               [](const graph_t &tree, const pyarray<value_t> &input,
                  const pyarray<bool> &condition) {
-                  if (condition.dimension() == 0) {
-                      return hg::propagate_parallel(tree, input);
-                  } else {
-                      return hg::propagate_parallel(tree, input, condition);
-                  }
+                  return without_gil([&] {
+                      if (condition.dimension() == 0) {
+                          return hg::propagate_parallel(tree, pyarray_view(input));
+                      } else {
+                          return hg::propagate_parallel(tree, pyarray_view(input), pyarray_view(condition));
+                      }
+                  });
               },
               doc,
               py::arg("tree"),
@@ -165,11 +195,13 @@ struct def_propagate_sequential_and_accumulate {
     void def(C &c, const char *doc) {
         c.def("_propagate_sequential_and_accumulate",
               [](const graph_t &tree, const pyarray<value_t> &vertex_data, hg::accumulators accumulator) {
-                  return dispatch_accumulator(
-                          [&tree, &vertex_data](const auto &acc) {
-                              return hg::propagate_sequential_and_accumulate(tree, vertex_data, acc);
-                          },
-                          accumulator);
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &vertex_data](const auto &acc) {
+                                  return hg::propagate_sequential_and_accumulate(tree, pyarray_view(vertex_data), acc);
+                              },
+                              accumulator);
+                  });
               },
               doc,
               py::arg("tree"),
@@ -178,11 +210,14 @@ struct def_propagate_sequential_and_accumulate {
 
         c.def("_propagate_sequential_and_accumulate",
               [](const graph_t &tree, const pyarray<value_t> &vertex_data, hg::accumulators accumulator, const pyarray<bool> &condition) {
-                  return dispatch_accumulator(
-                          [&tree, &vertex_data, &condition](const auto &acc) {
-                              return hg::propagate_sequential_and_accumulate(tree, vertex_data, acc, condition);
-                          },
-                          accumulator);
+                  return without_gil([&] {
+                      return dispatch_accumulator(
+                              [&tree, &vertex_data, &condition](const auto &acc) {
+                                  return hg::propagate_sequential_and_accumulate(tree, pyarray_view(vertex_data), acc,
+                                                                                 pyarray_view(condition));
+                              },
+                              accumulator);
+                  });
               },
               doc,
               py::arg("tree"),
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "py_alignement.hpp"
+#include "py_connected_filter_pipeline.hpp"
 #include "py_graph_core.hpp"
 #include "py_graph_weights.hpp"
 #include "py_horizontal_cuts.hpp"
@@ -0,0 +1,77 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+class ConnectedFilterPipeline:
+    """
+    Connected filter (attribute opening or closing) recorded as a lazy pipeline: component tree construction,
+    pruning criterion on node attributes and reconstruction of the filtered vertex weights.
+
+    The pipeline
+
+    >>> pipeline = hg.ConnectedFilterPipeline("max_tree").remove_if("area", "<", 100).remove_if("volume", "<", 1000)
+    >>> filtered = pipeline(graph, image)
+
+    gives the same result as
+
+    >>> tree, altitudes = hg.component_tree_max_tree(graph, image)
+    >>> area = hg.attribute_area(tree)
+    >>> volume = hg.attribute_volume(tree, altitudes, area)
+    >>> deleted = np.logical_or(area < 100, volume < 1000)
+    >>> deleted[tree.root()] = False
+    >>> filtered = hg.reconstruct_leaf_data(tree, altitudes, deleted)
+
+    but nothing is computed until the pipeline is called: the execution then computes all the attributes in a single
+    traversal of the tree (see :func:`~higra.fused_tree_attributes`) and evaluates the criterion during the
+    reconstruction. The attribute arrays and the array of deleted nodes are never returned to Python, and the tree is
+    released at the end of the execution. A pipeline can be applied to several images.
+
+    The available attributes are ``"area"``, ``"volume"``, ``"depth"`` and ``"mean_vertex_weights"`` (see the
+    corresponding ``attribute_xxx`` functions, the area of each vertex is equal to 1). A node is removed if any of the
+    clauses added with :meth:`remove_if` is true; the root of the tree is never removed.
+    """
+
+    def __init__(self, tree_type="max_tree"):
+        """
+        :param tree_type: ``"max_tree"`` (attribute opening, see :func:`~higra.component_tree_max_tree`) or
+               ``"min_tree"`` (attribute closing, see :func:`~higra.component_tree_min_tree`)
+        """
+        assert tree_type in ("max_tree", "min_tree"), "tree_type must be 'max_tree' or 'min_tree'."
+        self.tree_type = tree_type
+        self.clauses = []
+
+    def remove_if(self, attribute, comparison, threshold):
+        """
+        Adds a clause to the pruning criterion: the nodes whose attribute compares to the threshold are removed.
+
+        :param attribute: ``"area"``, ``"volume"``, ``"depth"`` or ``"mean_vertex_weights"``
+        :param comparison: ``"<"``, ``"<="``, ``">"`` or ``">="``
+        :param threshold: threshold value
+        :return: the pipeline
+        """
+        assert attribute in ("area", "volume", "depth", "mean_vertex_weights"), "Unknown attribute: " + str(attribute)
+        assert comparison in ("<", "<=", ">", ">="), "Unknown comparison: " + str(comparison)
+        self.clauses.append((attribute, comparison, float(threshold)))
+        return self
+
+    def __call__(self, graph, vertex_weights):
+        """
+        Executes the pipeline.
+
+        :param graph: input graph
+        :param vertex_weights: vertex weights of the input graph
+        :return: the filtered vertex weights
+        """
+        vertex_weights = hg.linearize_vertex_weights(vertex_weights, graph)
+        res = hg.cpp._connected_filter_pipeline(graph, vertex_weights, self.tree_type, self.clauses)
+        return hg.delinearize_vertex_weights(res, graph)
@@ -61,14 +61,16 @@ def undirected_graph_2_adjacency_matrix(graph, edge_weights=None, non_edge_value
     :param edge_weights: Graph edge weights (default to ``np.ones(graph.num_edges())`` if ``None``)
     :param non_edge_value: Value used to represent edges that are not in the input graph (must be 0 if :attr:`sparse`
            is ``True``)
-    :param sparse: if ``True`` the result will be a sparse matrix in the csr format (requires Scipy to be installed)
+    :param sparse: if ``True`` the result will be a sparse matrix in the csr format (requires Scipy to be installed).
+           For an :class:`~higra.UndirectedGraph`, the CSR structure of the matrix is built directly from the out edges
+           of the vertices (the entries of a row are in the order of the out edges of the vertex, a self loop gives a
+           single diagonal entry) and the matrix adopts it without copy.
     :return: A 2d symmetric square matrix
     """
     if edge_weights is None:
         edge_weights = np.ones((graph.num_edges(),), np.float64)
 
     num_v = graph.num_vertices()
-    sources, targets = graph.edge_list()
 
     if sparse:
         try:
@@ -80,10 +82,17 @@ def undirected_graph_2_adjacency_matrix(graph, edge_weights=None, non_edge_value
             raise ValueError("'non_edge_value' must be equal to 0 is 'sparse' is True: Scipy sparse matrix dor not "
                              "support custom default value.")
 
-        A = csr_matrix((edge_weights, (sources, targets)), shape=(num_v, num_v), dtype=edge_weights.dtype)
-        A += A.T
+        if isinstance(graph, hg.UndirectedGraph):
+            # the CSR structure is built directly from the out edges of the vertices and adopted by scipy
+            indptr, indices, edge_indices = hg.cpp._undirected_graph_2_csr_adjacency(graph)
+            A = csr_matrix((edge_weights[edge_indices], indices, indptr), shape=(num_v, num_v), copy=False)
+        else:
+            sources, targets = graph.edge_list()
+            A = csr_matrix((edge_weights, (sources, targets)), shape=(num_v, num_v), dtype=edge_weights.dtype)
+            A += A.T
 
     else:
+        sources, targets = graph.edge_list()
         A = np.empty((num_v, num_v), dtype=edge_weights.dtype)
         A.fill(non_edge_value)
         A[sources, targets] = edge_weights
@@ -98,6 +107,11 @@ def adjacency_matrix_2_undirected_graph(adjacency_matrix, non_edge_value=0):
 
     Adjacency matrix entries which are equal to :attr:`non_edge_value` are not considered to be part of the graph.
 
+    The edges correspond to the entries of the upper triangle of the matrix (diagonal included), in row major order.
+    If the adjacency matrix is a Scipy sparse matrix in the CSR format with sorted indices, no duplicate and no
+    explicit zero entries (canonical format), the graph is built directly from the CSR structure of the matrix, in
+    linear time and without copy of the matrix.
+
     :param adjacency_matrix: Input adjacency matrix (A 2d symmetric square matrix)
     :param non_edge_value: Value used to represent non existing edges in the adjacency matrix
     :return: a pair (UndirectedGraph, ndarray) representing the graph and its edge_weights (Concept :class:`~higra.CptEdgeWeightedGraph`)
@@ -114,8 +128,16 @@ def adjacency_matrix_2_undirected_graph(adjacency_matrix, non_edge_value=0):
     if scipy_available and sp.issparse(adjacency_matrix):
         if non_edge_value != 0:
             raise ValueError("'non_edge_value' must be equal to 0 is 'adjacency_matrix' is a Scipy sparse matrix.")
-        adjacency_matrix = sp.triu(adjacency_matrix)
-        sources, targets, edge_weights = sp.find(adjacency_matrix)
+        adjacency_matrix = adjacency_matrix.tocsr()
+        if not adjacency_matrix.has_canonical_format:
+            adjacency_matrix = adjacency_matrix.copy()
+            adjacency_matrix.sum_duplicates()
+        if np.any(adjacency_matrix.data == 0):
+            adjacency_matrix = adjacency_matrix.copy()
+            adjacency_matrix.eliminate_zeros()
+        # the graph is built directly from the CSR structure of the upper triangle of the matrix
+        graph, edge_map = hg.cpp._csr_adjacency_2_undirected_graph(adjacency_matrix.indptr, adjacency_matrix.indices)
+        return graph, adjacency_matrix.data[edge_map]
     else:
         adjacency_matrix = adjacency_matrix.copy()
         adjacency_matrix[np.tri(*adjacency_matrix.shape, k=-1, dtype=np.bool)] = non_edge_value
@@ -184,6 +206,9 @@ def make_graph_from_points(X, graph_type="knn+mst", symmetrization="max", **kwar
           The parameter :math:`k` can be controlled with the extra parameter 'n_neighbors' (default value 5).
         - ``"delaunay"``: creates a graph corresponding to the Delaunay triangulation of the points
           (only works in low dimensions).
+        - ``"approximate_knn"``: creates an approximate :math:`k`-nearest neighbor graph with the ``"max"``
+          symmetrization, without scipy and sklearn, see :func:`~higra.approximate_knn_graph` (suited for large sets
+          of points). The parameter :math:`k` can be controlled with the extra parameter 'n_neighbors' (default value 5).
 
     The weight of an edge :math:`\{x,y\}` is equal to the Euclidean distance between
     :math:`x` and :math:`y`: :math:`w(\{x,y\})=\|X[x, :] - X[y, :]\|`.
@@ -199,11 +224,16 @@ def make_graph_from_points(X, graph_type="knn+mst", symmetrization="max", **kwar
     This method is not suited for large set of points.
 
     :param X: A 2d array of vertex coordinates
-    :param graph_type: ``"complete"``, ``"knn"``, ``"knn+mst"`` (default), or ``"delaunay"``
+    :param graph_type: ``"complete"``, ``"knn"``, ``"knn+mst"`` (default), ``"delaunay"``, or ``"approximate_knn"``
     :param symmetrization: `"min"`` or ``"max"``
     :param kwargs: extra args depends of chosen graph type
     :return: a graph and its edge weights
     """
+    if graph_type == "approximate_knn":
+        if symmetrization != "max":
+            raise ValueError("Approximate knn graphs only support the 'max' symmetrization.")
+        return approximate_knn_graph(X, kwargs.get('n_neighbors', 5))
+
     try:
         from scipy.spatial.distance import pdist, squareform, euclidean
         from sklearn.neighbors import kneighbors_graph
@@ -270,6 +300,45 @@ def make_graph_from_points(X, graph_type="knn+mst", symmetrization="max", **kwar
     return g, edge_weights
 
 
+def approximate_knn_graph(X, n_neighbors=5, max_iterations=12, sample_rate=1, delta=0.001, seed=42):
+    """
+    Approximate :math:`k`-nearest neighbor graph of a set of points for the Euclidean distance, computed with the
+    NN-descent algorithm:
+
+        W. Dong, M. Charikar, K. Li. Efficient k-nearest neighbor graph construction for generic similarity
+        measures. In, 20th International Conference on World Wide Web, WWW 2011.
+
+    Starting from random neighbors, the :math:`k` nearest neighbors of each point are iteratively refined by
+    comparing the neighbors of the neighbors of each point. The algorithm stops after :attr:`max_iterations`
+    iterations or when less than :math:`delta \\times n \\times k` neighbors have changed during an iteration
+    (with :math:`n` the number of points). The computation is multithreaded (if Higra was compiled with TBB) and
+    uses vectorized distance kernels.
+
+    The graph contains an edge :math:`\{x,y\}` if :math:`y` is one of the approximate :math:`k` nearest neighbors of
+    :math:`x` or if :math:`x` is one of the approximate :math:`k` nearest neighbors of :math:`y` (the graph may have
+    several connected components). The weight of an edge is the Euclidean distance between its extremities. The
+    result can directly be used with the hierarchy functions, for example
+    :func:`~higra.binary_partition_tree_single_linkage` or :func:`~higra.binary_partition_tree_ward_linkage`.
+
+    Points of type ``np.float32`` are processed in single precision, other points in double precision.
+
+    :param X: a 2d array of vertex coordinates of shape (number of points, dimension)
+    :param n_neighbors: number of neighbors :math:`k` of each point
+    :param max_iterations: maximum number of iterations
+    :param sample_rate: proportion of the neighbors sampled in each iteration (lower values reduce the cost of an
+           iteration and the accuracy of the result)
+    :param delta: relative number of updates below which the algorithm stops
+    :param seed: seed of the random number generator
+    :return: a graph and its edge weights
+    """
+    X = np.asarray(X)
+    if X.ndim != 2:
+        raise ValueError("X must be a 2d array.")
+    if X.dtype != np.float32:
+        X = X.astype(np.float64, copy=False)
+    return hg.cpp._approximate_knn_graph(X, n_neighbors, max_iterations, sample_rate, delta, seed)
+
+
 def subgraph(graph, edge_indices, spanning=True, return_vertex_map=False):
     """
     Extract a subgraph of the input graph. Let :math:`G=(V,E)` be the graph :attr:`graph` and let :math:`E^*`
@@ -9,21 +9,93 @@
 ############################################################################
 
 import higra as hg
+import numpy as np
+import ctypes
 
 
-def weight_graph(graph, vertex_weights, weight_function):
+def weight_kernel_ctypes_prototype():
+    """
+    ctypes prototype of a compiled edge weighting kernel for :func:`~higra.weight_graph`.
+
+    The kernel has the C signature:
+
+    .. code-block:: c
+
+        double kernel(const double * a, const double * b, index_t num_channels, void * user_data);
+
+    where ``index_t`` is a signed integer of the size of :attr:`higra.index_t` (64 bits by default).
+
+    :return: a ``ctypes.CFUNCTYPE`` prototype
+    """
+    double_p = ctypes.POINTER(ctypes.c_double)
+    return ctypes.CFUNCTYPE(ctypes.c_double, double_p, double_p, hg.index_ctype(), ctypes.c_void_p)
+
+
+def weight_kernel_numba_signature():
+    """
+    Numba signature of a compiled edge weighting kernel for :func:`~higra.weight_graph` (see
+    :func:`~higra.weight_kernel_ctypes_prototype` for the C signature).
+
+    :return: a string
+    """
+    idx = "int32" if np.dtype(hg.index_t).itemsize == 4 else "int64"
+    return "float64(CPointer(float64), CPointer(float64), " + idx + ", voidptr)"
+
+
+def weight_graph(graph, vertex_weights, weight_function, preserve_dtype=False, user_data=None):
     """
     Compute the edge weights of a graph using source and target vertices values
     and specified weighting function (see :class:`~higra.WeightFunction` enumeration).
 
+    By default, edge weights are of type ``np.float64``. If :attr:`preserve_dtype` is ``True``, edge weights have the
+    type of the vertex weights: this requires the weighting function to be exactly computable in this type. For
+    integral types of at most 32 bits, this is the case of ``min``, ``max``, ``source``, ``target`` and ``L0``, of
+    ``L_infinity`` for unsigned types, and of ``L1`` and ``L2`` for unsigned types with a single channel
+    (for example the gradient of a ``np.uint8`` gray level image).
+
+    For multi-channel vertex weights, ``cosine`` is the cosine distance and ``chi_square`` is the chi-square distance
+    between non negative vectors such as histograms (see :class:`~higra.WeightFunction`).
+
+    :Compiled weighting kernel:
+
+    The :attr:`weight_function` can also be a compiled edge weighting kernel: a numba ``cfunc`` with the signature
+    :func:`~higra.weight_kernel_numba_signature` or a ctypes function pointer of type
+    :func:`~higra.weight_kernel_ctypes_prototype`. The weight of each edge is then the value returned by the kernel
+    for the pointers to the ``num_channels`` values of the vertex weights of its extremities (vertex weights are
+    converted to ``np.float64``). The last argument of the kernel is the address of :attr:`user_data` (a numpy array,
+    a ctypes pointer or an integer address). The kernel is called by the parallel C++ loop over the edges, without
+    going through the interpreter nor creating temporary arrays of size (number of edges, number of channels): it
+    must thus be thread safe.
+
+    .. code-block:: python
+
+        from numba import cfunc
+
+        @cfunc(hg.weight_kernel_numba_signature())
+        def hellinger(a, b, num_channels, user_data):
+            res = 0.0
+            for k in range(num_channels):
+                res += (np.sqrt(a[k]) - np.sqrt(b[k])) ** 2
+            return np.sqrt(res / 2)
+
+        edge_weights = hg.weight_graph(graph, histograms, hellinger)
+
     :param graph: input graph
     :param vertex_weights: vertex weights of the input graph
-    :param weight_function: see :class:`~higra.WeightFunction`
+    :param weight_function: see :class:`~higra.WeightFunction` or a compiled edge weighting kernel
+    :param preserve_dtype: if ``True``, the edge weights have the type of the vertex weights (default ``False``,
+           ignored for a compiled kernel)
+    :param user_data: pointer passed to a compiled :attr:`weight_function` (ignored otherwise)
     :return: edge weights of the graph
     """
 
     vertex_weights = hg.linearize_vertex_weights(vertex_weights, graph)
 
-    edge_weights = hg.cpp._weight_graph(graph, vertex_weights, weight_function)
+    address = hg.compiled_function_address(weight_function)
+    if address is not None:
+        vertex_weights = np.ascontiguousarray(vertex_weights, dtype=np.float64)
+        return hg.cpp._weight_graph_compiled_kernel(graph, vertex_weights, address, hg.data_address(user_data))
+
+    edge_weights = hg.cpp._weight_graph(graph, vertex_weights, weight_function, preserve_dtype)
 
     return edge_weights
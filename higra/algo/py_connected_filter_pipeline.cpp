@@ -0,0 +1,97 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_connected_filter_pipeline.hpp"
+#include "../py_common.hpp"
+#include "higra/algo/connected_filter_pipeline.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+namespace py = pybind11;
+
+using clause_t = std::tuple<std::string, std::string, double>;
+
+static hg::filter_pipeline_attribute parse_attribute(const std::string &name) {
+    if (name == "area") {
+        return hg::filter_pipeline_attribute::area;
+    } else if (name == "volume") {
+        return hg::filter_pipeline_attribute::volume;
+    } else if (name == "depth") {
+        return hg::filter_pipeline_attribute::depth;
+    } else if (name == "mean_vertex_weights") {
+        return hg::filter_pipeline_attribute::mean_vertex_weights;
+    }
+    throw std::runtime_error("Unknown filter attribute: " + name);
+}
+
+static hg::filter_pipeline_comparison parse_comparison(const std::string &name) {
+    if (name == "<") {
+        return hg::filter_pipeline_comparison::less;
+    } else if (name == "<=") {
+        return hg::filter_pipeline_comparison::less_equal;
+    } else if (name == ">") {
+        return hg::filter_pipeline_comparison::greater;
+    } else if (name == ">=") {
+        return hg::filter_pipeline_comparison::greater_equal;
+    }
+    throw std::runtime_error("Unknown comparison: " + name);
+}
+
+static hg::connected_filter_pipeline make_pipeline(const std::string &tree_type,
+                                                   const std::vector<clause_t> &clauses) {
+    hg::filter_pipeline_tree type;
+    if (tree_type == "max_tree") {
+        type = hg::filter_pipeline_tree::max_tree;
+    } else if (tree_type == "min_tree") {
+        type = hg::filter_pipeline_tree::min_tree;
+    } else {
+        throw std::runtime_error("Unknown tree type: " + tree_type);
+    }
+    hg::connected_filter_pipeline pipeline(type);
+    for (const auto &c: clauses) {
+        auto attribute = pipeline.add_attribute(parse_attribute(std::get<0>(c)));
+        pipeline.remove_if(attribute, parse_comparison(std::get<1>(c)), std::get<2>(c));
+    }
+    return pipeline;
+}
+
+template<typename graph_t>
+struct def_connected_filter_pipeline {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_connected_filter_pipeline",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 const std::string &tree_type,
+                 const std::vector<clause_t> &clauses) {
+                  auto pipeline = make_pipeline(tree_type, clauses);
+                  return without_gil([&] {
+                      return pipeline.execute(graph, pyarray_view(vertex_weights));
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("tree_type"),
+              py::arg("clauses"));
+    }
+};
+
+void py_init_connected_filter_pipeline(pybind11::module &m) {
+    xt::import_numpy();
+    add_type_overloads<def_connected_filter_pipeline<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_connected_filter_pipeline<hg::regular_grid_graph_1d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_connected_filter_pipeline<hg::regular_grid_graph_2d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_connected_filter_pipeline<hg::regular_grid_graph_3d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_connected_filter_pipeline<hg::regular_grid_graph_4d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+}
@@ -11,6 +11,7 @@
 #include "py_graph_core.hpp"
 #include "../py_common.hpp"
 #include "higra/algo/graph_core.hpp"
+#include "higra/algo/knn_graph.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
 
@@ -65,6 +66,49 @@ struct def_minimum_spanning_tree {
     }
 };
 
+struct def_approximate_knn_graph {
+    template<typename value_t, typename C>
+    static
+    void def(C &m, const char *doc) {
+        m.def("_approximate_knn_graph", [](const pyarray<value_t> &points,
+                                           hg::index_t num_neighbours,
+                                           hg::index_t max_iterations,
+                                           double sample_rate,
+                                           double delta,
+                                           unsigned int seed) {
+                  auto res = without_gil([&] {
+                      return hg::approximate_knn_graph(pyarray_view(points), num_neighbours, max_iterations,
+                                                       sample_rate, delta, seed);
+                  });
+                  return pybind11::make_tuple(std::move(res.first), std::move(res.second));
+              },
+              doc,
+              py::arg("points"),
+              py::arg("num_neighbours"),
+              py::arg("max_iterations"),
+              py::arg("sample_rate"),
+              py::arg("delta"),
+              py::arg("seed"));
+    }
+};
+
+struct def_csr_adjacency_2_undirected_graph {
+    template<typename value_t, typename C>
+    static
+    void def(C &m, const char *doc) {
+        m.def("_csr_adjacency_2_undirected_graph", [](const pyarray<value_t> &indptr,
+                                                      const pyarray<value_t> &indices) {
+                  auto res = without_gil([&] {
+                      return hg::csr_adjacency_2_undirected_graph(pyarray_view(indptr), pyarray_view(indices));
+                  });
+                  return py::make_tuple(std::move(res.first), std::move(res.second));
+              },
+              doc,
+              py::arg("indptr"),
+              py::arg("indices"));
+    }
+};
+
 void py_init_algo_graph_core(pybind11::module &m) {
     xt::import_numpy();
 
@@ -91,6 +135,22 @@ void py_init_algo_graph_core(pybind11::module &m) {
              ""
             );
 
+    add_type_overloads<def_approximate_knn_graph, HG_TEMPLATE_FLOAT_TYPES>(m, "");
+
+    add_type_overloads<def_csr_adjacency_2_undirected_graph, int, long long>
+            (m,
+             "Undirected graph from the CSR structure of a symmetric sparse adjacency matrix."
+            );
+
+    m.def("_undirected_graph_2_csr_adjacency", [](const hg::ugraph &graph) {
+              auto res = without_gil([&] {
+                  return hg::undirected_graph_2_csr_adjacency(graph);
+              });
+              return py::make_tuple(std::move(res.indptr), std::move(res.indices), std::move(res.edge_indices));
+          },
+          "CSR structure of the adjacency matrix of an undirected graph.",
+          py::arg("graph"));
+
     m.def("_line_graph", [](const hg::ugraph &graph) {
               return hg::line_graph(graph);
           },
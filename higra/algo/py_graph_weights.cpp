@@ -28,16 +28,48 @@ struct def_weight_graph {
     template<typename type, typename C>
     static
     void def(C &m, const char *doc) {
-        m.def("_weight_graph", [](const graph_t &graph, const pyarray<type> &data, hg::weight_functions weight_f) {
-                  return hg::weight_graph(graph, data, weight_f);
+        m.def("_weight_graph", [](const graph_t &graph, const pyarray<type> &data, hg::weight_functions weight_f,
+                                  bool preserve_dtype) -> py::object {
+                  if (preserve_dtype) {
+                      hg::index_t num_channels = (num_vertices(graph) == 0) ? 1 : data.size() / num_vertices(graph);
+                      hg_assert(hg::is_exact_weight_function<type>(weight_f, num_channels),
+                                "The given weighting function cannot be computed exactly in the type of the vertex "
+                                "weights.");
+                      return py::cast(hg::weight_graph<type>(graph, data, weight_f));
+                  }
+                  return py::cast(hg::weight_graph(graph, data, weight_f));
               },
               doc,
               py::arg("explicit_graph"),
               py::arg("vertex_weights"),
-              py::arg("weigh_function"));
+              py::arg("weigh_function"),
+              py::arg("preserve_dtype") = false);
     }
 };
 
+template<typename graph_t>
+void def_weight_graph_compiled_kernel(pybind11::module &m) {
+    m.def("_weight_graph_compiled_kernel", [](const graph_t &graph,
+                                              const pyarray<double> &data,
+                                              std::uintptr_t callback_address,
+                                              std::uintptr_t user_data_address) {
+              if (callback_address == 0) {
+                  throw std::runtime_error("Invalid edge weighting kernel address.");
+              }
+              auto callback = reinterpret_cast<hg::weight_graph_kernel_callback_t>(callback_address);
+              auto user_data = reinterpret_cast<void *>(user_data_address);
+              return without_gil([&] {
+                  return hg::weight_graph_compiled_kernel(graph, pyarray_view(data), callback, user_data);
+              });
+          },
+          "Compute the edge weights of a graph using source and target vertices values"
+          " and the given compiled edge weighting kernel.",
+          py::arg("graph"),
+          py::arg("vertex_weights"),
+          py::arg("callback_address"),
+          py::arg("user_data_address"));
+}
+
 void py_init_graph_weights(pybind11::module &m) {
     xt::import_numpy();
 
@@ -51,7 +83,9 @@ void py_init_graph_weights(pybind11::module &m) {
             .value("L_infinity", hg::weight_functions::L_infinity)
             .value("L2_squared", hg::weight_functions::L2_squared)
             .value("source", hg::weight_functions::source)
-            .value("target", hg::weight_functions::target);
+            .value("target", hg::weight_functions::target)
+            .value("cosine", hg::weight_functions::cosine)
+            .value("chi_square", hg::weight_functions::chi_square);
 
 
     add_type_overloads<def_weight_graph<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>
@@ -66,5 +100,6 @@ void py_init_graph_weights(pybind11::module &m) {
              " and specified weighting function (see WeightFunction enumeration)."
             );
 
+    def_weight_graph_compiled_kernel<hg::ugraph>(m);
+    def_weight_graph_compiled_kernel<hg::tree>(m);
 }
-
@@ -63,6 +63,33 @@ struct binary_labelisation_from_markers {
               py::arg("tree"),
               py::arg("object_marker"),
               py::arg("background_marker"));
+
+        m.def("_binary_labelisation_from_markers_packed", [](const hg::tree &tree,
+                                                             const pyarray<value_t> &object_marker,
+                                                             const pyarray<value_t> &background_marker) {
+                  return hg::binary_labelisation_from_markers_packed(tree, object_marker, background_marker);
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("object_marker"),
+              py::arg("background_marker"));
+    }
+};
+
+struct cut_stack_from_thresholds {
+    template<typename value_t>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_cut_stack_from_thresholds", [](const hg::tree &tree,
+                                               const pyarray<value_t> &altitudes,
+                                               const pyarray<double> &thresholds) {
+                  auto res = hg::cut_stack_from_thresholds(tree, altitudes, thresholds);
+                  return pybind11::make_tuple(std::move(res.offsets), std::move(res.nodes));
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("altitudes"),
+              py::arg("thresholds"));
     }
 };
 
@@ -118,10 +145,97 @@ void py_init_algo_tree(pybind11::module &m) {
              "intersection with the background marker."
             );
 
+    using incremental_labelisation_t = hg::incremental_binary_labelisation;
+    auto c = py::class_<incremental_labelisation_t>(
+            m, "IncrementalBinaryLabelisation",
+            "Binary labelisation of the leaves of a tree from object and background markers (see "
+            ":func:`~higra.binary_labelisation_from_markers`) maintained under marker insertions and removals.\n\n"
+            "Markers are given by the indices of their leaves. Adding or removing a marker and computing the final "
+            "object only visit the ancestors of the marker leaves, not the whole tree: this is intended for "
+            "interactive segmentation where the user adds a few markers at a time. A leaf that is both an object "
+            "and a background marker is a background marker.");
+    c.def(py::init<const hg::tree &>(),
+          "Empty sets of markers on the given tree.\n\n"
+          ":param tree: input tree",
+          py::arg("tree"));
+    c.def("add_object_markers",
+          [](incremental_labelisation_t &l, const pyarray<hg::index_t> &leaves) {
+              l.add_object_markers(leaves);
+          },
+          "Add the given leaves to the object markers.",
+          py::arg("leaves"));
+    c.def("remove_object_markers",
+          [](incremental_labelisation_t &l, const pyarray<hg::index_t> &leaves) {
+              l.remove_object_markers(leaves);
+          },
+          "Remove the given leaves from the object markers.",
+          py::arg("leaves"));
+    c.def("add_background_markers",
+          [](incremental_labelisation_t &l, const pyarray<hg::index_t> &leaves) {
+              l.add_background_markers(leaves);
+          },
+          "Add the given leaves to the background markers.",
+          py::arg("leaves"));
+    c.def("remove_background_markers",
+          [](incremental_labelisation_t &l, const pyarray<hg::index_t> &leaves) {
+              l.remove_background_markers(leaves);
+          },
+          "Remove the given leaves from the background markers.",
+          py::arg("leaves"));
+    c.def("num_object_markers", &incremental_labelisation_t::num_object_markers,
+          "Number of object marker leaves.");
+    c.def("num_background_markers", &incremental_labelisation_t::num_background_markers,
+          "Number of background marker leaves.");
+    c.def("object_nodes", &incremental_labelisation_t::object_nodes,
+          "Nodes of the tree (in increasing order) whose union is the final object: the largest nodes containing an "
+          "object marker leaf and no background marker leaf.");
+    c.def("labelisation", &incremental_labelisation_t::labelisation,
+          "Indicator function of the final object on the leaves of the tree.");
+
+    m.def("_unpack_binary_labelisation", [](const pyarray<uint8_t> &packed, hg::index_t num_elements) {
+              return hg::unpack_binary_labelisation(packed, num_elements);
+          },
+          "",
+          py::arg("packed"),
+          py::arg("num_elements"));
+
+    m.def("_encode_cut_stack", [](const hg::tree &tree, const pyarray<hg::index_t> &labelisations) {
+              auto res = hg::encode_cut_stack(tree, labelisations);
+              return pybind11::make_tuple(std::move(res.offsets), std::move(res.nodes));
+          },
+          "",
+          py::arg("tree"),
+          py::arg("labelisations"));
+
+    add_type_overloads<cut_stack_from_thresholds, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
     add_type_overloads<sort_hierarchy_with_altitudes, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 
     m.def("_sub_tree", [](const hg::tree &t, hg::index_t root) {
         auto res = hg::sub_tree(t, root);
         return pybind11::make_tuple(std::move(res.tree), std::move(res.node_map));
     });
+
+    m.def("_relayout_tree", [](const hg::tree &t, hg::tree_layout layout) {
+        auto res = hg::relayout_tree(t, layout);
+        return pybind11::make_tuple(std::move(res.tree), std::move(res.node_map));
+    });
+
+    m.def("_sub_trees", [](const hg::tree &t, const pyarray<hg::index_t> &roots) {
+        auto res = hg::sub_trees(t, roots);
+        return pybind11::make_tuple(std::move(res.trees), std::move(res.node_map), std::move(res.offsets));
+    });
+
+    m.def("_tree_preorder", [](const hg::tree &t) {
+        return without_gil([&] { return hg::tree_preorder(t); });
+    });
+
+    m.def("_tree_postorder", [](const hg::tree &t) {
+        return without_gil([&] { return hg::tree_postorder(t); });
+    });
+
+    m.def("_tree_depth_levels", [](const hg::tree &t) {
+        auto res = without_gil([&] { return hg::tree_depth_levels(t); });
+        return pybind11::make_tuple(std::move(res.nodes), std::move(res.offsets));
+    });
 }
\ No newline at end of file
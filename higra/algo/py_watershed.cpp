@@ -10,6 +10,7 @@
 
 #include "py_watershed.hpp"
 #include "higra/algo/watershed.hpp"
+#include "higra/algo/stochastic_watershed.hpp"
 #include "../py_common.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
@@ -54,12 +55,93 @@ struct def_labelisation_seeded_watershed {
     }
 };
 
+struct def_batched_seeded_watershed_ctr {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def(py::init([](const hg::ugraph &graph, const pyarray<value_t> &edge_weights) {
+                  return without_gil([&] {
+                      return hg::batched_seeded_watershed(graph, edge_weights);
+                  });
+              }),
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"));
+    }
+};
+
+template<typename graph_t>
+struct def_exact_stochastic_watershed {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_exact_stochastic_watershed",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &edge_weights,
+                 double num_seeds,
+                 const pyarray<double> &vertex_weights) {
+                  return without_gil([&] {
+                      return hg::exact_stochastic_watershed(graph, edge_weights, num_seeds, vertex_weights);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("num_seeds"),
+              py::arg("vertex_weights"));
+    }
+};
 
 void py_init_watershed(pybind11::module &m) {
     xt::import_numpy();
 
     add_type_overloads<def_labelisation_watershed<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m,"");
     add_type_overloads<def_labelisation_seeded_watershed<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m,"");
+    add_type_overloads<def_exact_stochastic_watershed<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    auto c = py::class_<hg::batched_seeded_watershed>(m, "BatchedSeededWatershed",
+                                                      "Seeded watershed labelisations of many seed sets on the same "
+                                                      "edge weighted graph: the minimum spanning tree and the canonical "
+                                                      "binary partition tree of the graph are computed once.");
+    add_type_overloads<def_batched_seeded_watershed_ctr, HG_TEMPLATE_NUMERIC_TYPES>
+            (c, "Computes the canonical binary partition tree and the minimum spanning tree of the given edge "
+                "weighted graph.");
+
+    c.def("num_vertices", &hg::batched_seeded_watershed::num_vertices,
+          "Number of vertices of the graph.");
+
+    c.def("bpt", [](const hg::batched_seeded_watershed &ws) {
+              return ws.bpt();
+          },
+          "Canonical binary partition tree of the graph: the internal node ``num_vertices() + k`` corresponds to the "
+          "k-th edge of the minimum spanning tree.");
+
+    c.def("mst_edge_map", [](const hg::batched_seeded_watershed &ws) {
+              return ws.mst_edge_map();
+          },
+          "Indices of the minimum spanning tree edges in the graph, in increasing order of weight.");
+
+    c.def("_labelisations",
+          [](const hg::batched_seeded_watershed &ws, const pyarray<hg::index_t> &vertex_seeds,
+             hg::index_t background_label) {
+              return without_gil([&] {
+                  return ws.labelisations(vertex_seeds, background_label);
+              });
+          },
+          "Seeded watershed labelisation of each row of the 2d array vertex_seeds, the rows are processed in "
+          "parallel.",
+          py::arg("vertex_seeds"),
+          py::arg("background_label"));
+
+    c.def("_boundary_probabilities",
+          [](const hg::batched_seeded_watershed &ws, double num_seeds, const pyarray<double> &vertex_weights) {
+              return without_gil([&] {
+                  return ws.boundary_probabilities(num_seeds, vertex_weights);
+              });
+          },
+          "Exact stochastic watershed boundary probability of each node of the canonical binary partition tree.",
+          py::arg("num_seeds"),
+          py::arg("vertex_weights"));
 }
 
 
@@ -13,7 +13,7 @@ import numpy as np
 
 
 @hg.argument_helper(hg.CptHierarchy)
-def reconstruct_leaf_data(tree, altitudes, deleted_nodes=None, leaf_graph=None):
+def reconstruct_leaf_data(tree, altitudes, deleted_nodes=None, leaf_graph=None, cut_nodes=None):
     """
     Each leaf of the tree takes the altitude of its closest non deleted ancestor.
 
@@ -23,14 +23,26 @@ def reconstruct_leaf_data(tree, altitudes, deleted_nodes=None, leaf_graph=None):
     If :attr:`deleted_nodes` is ``None`` then its default value is set to `np.zeros((tree.numvertices(),)`
     (no nodes are deleted).
 
+    Alternatively, a horizontal cut of the tree can be given by its nodes with :attr:`cut_nodes` (for example a cut of
+    a stack of cuts given by :func:`~higra.encode_cut_stack`): each leaf then takes the altitude of its closest
+    ancestor in the cut (all the other nodes are deleted).
+
     :param tree: input tree (Concept :class:`~higra.CptHierarchy`)
     :param altitudes: node altitudes of the input tree
     :param deleted_nodes: binary node weights indicating which nodes are deleted (optional)
     :param leaf_graph: graph of the tree leaves (optional, deduced from :class:`~higra.CptHierarchy`)
+    :param cut_nodes: indices of the nodes of a horizontal cut of the tree (optional, incompatible with :attr:`deleted_nodes`)
     :return: Leaf weights
     """
 
-    if deleted_nodes is None:
+    if cut_nodes is not None:
+        if deleted_nodes is not None:
+            raise ValueError("deleted_nodes and cut_nodes cannot be given simultaneously.")
+        deleted_nodes = np.ones((tree.num_vertices(),), dtype=np.bool_)
+        deleted_nodes[cut_nodes] = False
+        reconstruction = hg.propagate_sequential(tree, altitudes, deleted_nodes)
+        leaf_weights = reconstruction[0:tree.num_leaves(), ...]
+    elif deleted_nodes is None:
         if tree.category() == hg.TreeCategory.PartitionTree:
             leaf_weights = altitudes[0:tree.num_leaves(), ...]
         elif tree.category() == hg.TreeCategory.ComponentTree:
@@ -273,7 +285,7 @@ def filter_weak_frontier_nodes_from_tree(tree, altitudes, edge_weights, strength
 
 
 @hg.argument_helper(hg.CptHierarchy)
-def binary_labelisation_from_markers(tree, object_marker, background_marker, leaf_graph=None):
+def binary_labelisation_from_markers(tree, object_marker, background_marker, leaf_graph=None, packed=False):
     """
     Given two binary markers :math:`o` (object) and :math:`b` (background) (given by their indicator functions)
     on the leaves of a tree :math:`T`, the corresponding binary labelization of the leaves of :math:`T` is defined as
@@ -287,6 +299,7 @@ def binary_labelisation_from_markers(tree, object_marker, background_marker, lea
     :param object_marker: indicator function of the object marker: 1d array of size tree.num_leaves() where non zero values correspond to the object marker
     :param background_marker: indicator function of the background marker: 1d array of size tree.num_leaves() where non zero values correspond to the background marker
     :param leaf_graph: graph on the leaves of the input tree (optional, deduced from :class:`~higra.CptHierarchy`)
+    :param packed: if ``True``, the labels are packed in a 1d bit array of type ``np.uint8`` with 1 bit per leaf (see :func:`~higra.unpack_binary_labelisation`)
     :return: Leaf labels
     """
 
@@ -295,6 +308,10 @@ def binary_labelisation_from_markers(tree, object_marker, background_marker, lea
         background_marker = hg.linearize_vertex_weights(background_marker, leaf_graph)
 
     object_marker, background_marker = hg.cast_to_common_type(object_marker, background_marker)
+
+    if packed:
+        return hg.cpp._binary_labelisation_from_markers_packed(tree, object_marker, background_marker)
+
     labels = hg.cpp._binary_labelisation_from_markers(tree, object_marker, background_marker)
 
     if leaf_graph is not None:
@@ -303,6 +320,63 @@ def binary_labelisation_from_markers(tree, object_marker, background_marker, lea
     return labels
 
 
+def unpack_binary_labelisation(packed, num_elements):
+    """
+    Unpacks a binary labelisation packed with 1 bit per element (see :func:`~higra.binary_labelisation_from_markers`).
+
+    The :math:`i`-th element is stored in the bit :math:`i \\bmod 8` (starting from the least significant bit) of the
+    byte :math:`\\lfloor i / 8 \\rfloor`: this is the layout of ``np.packbits(labels, bitorder='little')``.
+
+    :param packed: 1d array of type ``np.uint8``
+    :param num_elements: number of elements of the labelisation
+    :return: a 1d array of size :attr:`num_elements` with values in :math:`\\{0, 1\\}`
+    """
+    return hg.cpp._unpack_binary_labelisation(np.asarray(packed, dtype=np.uint8), num_elements)
+
+
+@hg.argument_helper(hg.CptHierarchy)
+def encode_cut_stack(tree, labelisations, leaf_graph=None):
+    """
+    Encodes a stack of horizontal cut labelisations of a tree by the nodes of each cut.
+
+    The labels must be node indices of the tree (as given by :func:`~higra.labelisation_horizontal_cut_from_threshold`):
+    a cut with :math:`r` regions is then encoded by :math:`r` node indices instead of one label per leaf.
+
+    The result is a pair of 1d arrays :math:`(offsets, nodes)` such that the nodes of the :math:`i`-th cut
+    are ``nodes[offsets[i]:offsets[i + 1]]``, in increasing order. A cut can be decoded with
+    :func:`~higra.reconstruct_leaf_data`:
+
+    .. code-block:: python
+
+        offsets, nodes = hg.encode_cut_stack(tree, labelisations)
+        labels_i = hg.reconstruct_leaf_data(tree, np.arange(tree.num_vertices()), cut_nodes=nodes[offsets[i]:offsets[i + 1]])
+
+    :param tree: input tree (Concept :class:`~higra.CptHierarchy`)
+    :param labelisations: array of shape :math:`(num\\_cuts, num\\_leaves)` (or :math:`(num\\_cuts,) + leaf\\_graph\\_shape` if :attr:`leaf_graph` is given)
+    :param leaf_graph: graph on the leaves of the input tree (optional, deduced from :class:`~higra.CptHierarchy`)
+    :return: a pair of 1d arrays (offsets, nodes)
+    """
+    labelisations = np.asarray(labelisations, dtype=np.int64)
+    labelisations = np.reshape(labelisations, (labelisations.shape[0], tree.num_leaves()))
+    return hg.cpp._encode_cut_stack(tree, labelisations)
+
+
+def cut_stack_from_thresholds(tree, altitudes, thresholds):
+    """
+    Stack of horizontal cuts of a hierarchy for the given thresholds, encoded by the nodes of each cut (see
+    :func:`~higra.encode_cut_stack`).
+
+    The :math:`i`-th cut is the one given by :func:`~higra.labelisation_horizontal_cut_from_threshold` with the
+    threshold ``thresholds[i]``, but the leaves are never labelled.
+
+    :param tree: input tree
+    :param altitudes: node altitudes of the input tree (must be increasing)
+    :param thresholds: 1d array of thresholds
+    :return: a pair of 1d arrays (offsets, nodes)
+    """
+    return hg.cpp._cut_stack_from_thresholds(tree, altitudes, np.asarray(thresholds, dtype=np.float64))
+
+
 def sort_hierarchy_with_altitudes(tree, altitudes):
     """
     Sort the nodes of a tree according to their altitudes.
@@ -331,6 +405,94 @@ def sort_hierarchy_with_altitudes(tree, altitudes):
     return new_tree, new_altitudes, node_map
 
 
+def relayout_tree(tree, layout, altitudes=None):
+    """
+    Reorder the nodes of a tree according to the given layout (see :class:`~higra.TreeLayout`):
+
+    - :attr:`TreeLayout.Topological`: any topological order, the tree is not modified;
+    - :attr:`TreeLayout.AltitudeSorted`: nodes sorted by increasing altitudes, see
+      :func:`~higra.sort_hierarchy_with_altitudes` (requires :attr:`altitudes`);
+    - :attr:`TreeLayout.PostOrder`: the leaves, and then the non leaf nodes, are stored in depth first post-order,
+      such that the leaves and the non leaf nodes of any sub tree form two contiguous ranges.
+
+    The layout is recorded in the new tree (see :func:`~higra.Tree.layout`) and the functions that can benefit
+    from it, like :func:`~higra.Tree.sub_trees`, skip their reordering steps. If the tree already has the requested
+    layout, it is not reordered and the node map is the identity.
+
+    The returned "node_map" is an array that maps any node index :math:`i` of the new tree,
+    to the index of this node in the original tree.
+
+    :Complexity:
+
+    The post-order layout is computed in linear time :math:`\mathcal{O}(n)` with :math:`n` the number of vertices
+    in the tree.
+
+    :param tree: input tree
+    :param layout: a :class:`~higra.TreeLayout`
+    :param altitudes: node altitudes of the input tree (required for :attr:`TreeLayout.AltitudeSorted`)
+    :return: the reordered tree and the node map
+    """
+    if layout == hg.TreeLayout.AltitudeSorted:
+        if altitudes is None:
+            raise ValueError("'altitudes' are required to sort the nodes of a tree by altitudes.")
+        new_tree, _, node_map = sort_hierarchy_with_altitudes(tree, altitudes)
+        return new_tree, node_map
+
+    return hg.cpp._relayout_tree(tree, layout)
+
+
+def tree_preorder(tree):
+    """
+    Nodes of the tree in the order in which they are visited by a depth first pre-order traversal (children being
+    visited by increasing index): the root comes first and each node is followed by the nodes of its sub tree.
+
+    The traversal is computed in C++ in linear time: it replaces explicit traversals of the tree with
+    :func:`~higra.Tree.children` in vectorized code.
+
+    :param tree: input tree
+    :return: a 1d array, permutation of the nodes of the tree
+    """
+    return hg.cpp._tree_preorder(tree)
+
+
+def tree_postorder(tree):
+    """
+    Nodes of the tree in the order in which they are visited by a depth first post-order traversal (children being
+    visited by increasing index): each node is preceded by the nodes of its sub tree and the root comes last.
+
+    The traversal is computed in C++ in linear time: it replaces explicit traversals of the tree with
+    :func:`~higra.Tree.children` in vectorized code.
+
+    :param tree: input tree
+    :return: a 1d array, permutation of the nodes of the tree
+    """
+    return hg.cpp._tree_postorder(tree)
+
+
+def tree_depth_levels(tree):
+    """
+    Nodes of the tree sorted by increasing depth (the root has depth 0), nodes of a same depth being sorted by
+    increasing index.
+
+    The result is a pair of arrays ``(nodes, offsets)`` such that the nodes of depth :math:`d` are
+    ``nodes[offsets[d]:offsets[d + 1]]``. Processing the levels from the last to the first one (resp. from the first to
+    the last one) is a bottom-up (resp. top-down) traversal of the tree where all the nodes of a level can be processed
+    at once with vectorized numpy operations:
+
+    >>> nodes, offsets = hg.tree_depth_levels(tree)
+    >>> area = np.zeros(tree.num_vertices(), dtype=np.int64)
+    >>> area[:tree.num_leaves()] = 1
+    >>> parents = tree.parents()
+    >>> for d in range(len(offsets) - 2, 0, -1):
+    >>>     level = nodes[offsets[d]:offsets[d + 1]]
+    >>>     np.add.at(area, parents[level], area[level])
+
+    :param tree: input tree
+    :return: a pair of 1d arrays (nodes, offsets)
+    """
+    return hg.cpp._tree_depth_levels(tree)
+
+
 def test_altitudes_increasingness(tree, altitudes):
     """
     Test if the altitudes of the given tree are increasing; i.e. if for any nodes :math:`i, j` such that :math:`j`
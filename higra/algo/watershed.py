@@ -67,9 +67,112 @@ def labelisation_seeded_watershed(graph, edge_weights, vertex_seeds, background_
 
     vertex_seeds = hg.linearize_vertex_weights(vertex_seeds, graph)
 
-    vertex_seeds = hg.cast_to_dtype(vertex_seeds, np.int64)
+    vertex_seeds = hg.cast_to_dtype(vertex_seeds, hg.index_t)
 
     labels = hg.cpp._labelisation_seeded_watershed(graph, edge_weights, vertex_seeds, background_label)
 
     labels = hg.delinearize_vertex_weights(labels, graph)
     return labels
+
+
+@hg.extend_class(hg.BatchedSeededWatershed, method_name="labelisations")
+def __batched_seeded_watershed_labelisations(self, vertex_seeds, background_label=0):
+    """
+    Seeded watershed labelisations (see :func:`~higra.labelisation_seeded_watershed`) of many seed sets.
+
+    The first dimension of :attr:`vertex_seeds` indexes the seed sets: ``vertex_seeds[i]`` gives the seeds of the
+    i-th seed set on the vertices of the graph (possibly in the shape of the graph). Each seed set is answered with a
+    single sweep over the edges of the minimum spanning tree and the seed sets are processed in parallel.
+
+    :param vertex_seeds: array of shape :math:`(num\_seed\_sets, \ldots)` of integer seed labels
+    :param background_label: Vertices whose values are equal to :attr:`background_label` (default 0) in
+           :attr:`vertex_seeds` are not considered as seeds
+    :return: an array of labels of the same shape as :attr:`vertex_seeds`
+    """
+    if not issubclass(vertex_seeds.dtype.type, np.integer):
+        raise ValueError("vertex_seeds must be an array of integers")
+
+    shape = vertex_seeds.shape
+    vertex_seeds = hg.cast_to_dtype(vertex_seeds.reshape((shape[0], -1)), hg.index_t)
+    if vertex_seeds.shape[1] != self.num_vertices():
+        raise ValueError("The size of each seed set must be equal to the number of vertices of the graph.")
+
+    labels = self._labelisations(vertex_seeds, background_label)
+    return labels.reshape(shape)
+
+
+@hg.extend_class(hg.BatchedSeededWatershed, method_name="boundary_probabilities")
+def __batched_seeded_watershed_boundary_probabilities(self, num_seeds, vertex_weights=None):
+    """
+    Exact boundary probabilities of the stochastic watershed on the nodes of the canonical binary partition tree of
+    the graph (see :func:`~higra.BatchedSeededWatershed.bpt`).
+
+    :attr:`num_seeds` seeds with distinct labels are drawn independently at random among the vertices, the vertex
+    :math:`v` being drawn with a probability proportional to :attr:`vertex_weights` (uniform by default). The
+    probability of the internal node :math:`n` of children :math:`A` and :math:`B` is the probability that both
+    :math:`A` and :math:`B` contain a seed, which is exactly the probability that the minimum spanning tree edge of
+    :math:`n` separates two basins of the seeded watershed.
+
+    :param num_seeds: number of seeds
+    :param vertex_weights: weight of each vertex (optional)
+    :return: an array of probabilities on the nodes of the binary partition tree (0 on the leaves)
+    """
+    if vertex_weights is None:
+        vertex_weights = np.ones((self.num_vertices(),), dtype=np.float64)
+    vertex_weights = np.asarray(vertex_weights, dtype=np.float64).reshape((-1,))
+    return self._boundary_probabilities(float(num_seeds), vertex_weights)
+
+
+def labelisation_seeded_watershed_batch(graph, edge_weights, vertex_seeds, background_label=0):
+    """
+    Seeded watershed cuts (see :func:`~higra.labelisation_seeded_watershed`) of many seed sets on the same edge
+    weighted graph.
+
+    The first dimension of :attr:`vertex_seeds` indexes the seed sets. The minimum spanning tree of the graph is
+    computed only once and each seed set is then answered in linear time with respect to the number of vertices, the
+    seed sets being processed in parallel. Use :class:`~higra.BatchedSeededWatershed` directly to process several
+    batches of seed sets on the same graph.
+
+    :Complexity:
+
+    This algorithm has a runtime complexity in :math:`\mathcal{O}(m \log m + k n)` with :math:`m` the number of edges,
+    :math:`n` the number of vertices of the graph and :math:`k` the number of seed sets.
+
+    :param graph: Input graph
+    :param edge_weights: Weights on the edges of the graph
+    :param vertex_seeds: array of shape :math:`(num\_seed\_sets, \ldots)` of integer seed labels
+    :param background_label: Vertices whose values are equal to :attr:`background_label` (default 0) in
+           :attr:`vertex_seeds` are not considered as seeds
+    :return: an array of labels of the same shape as :attr:`vertex_seeds`
+    """
+    return hg.BatchedSeededWatershed(graph, edge_weights).labelisations(vertex_seeds, background_label)
+
+
+def exact_stochastic_watershed(graph, edge_weights, num_seeds, vertex_weights=None):
+    """
+    Exact stochastic watershed of an edge weighted graph.
+
+    The stochastic watershed is the probability that each edge separates two basins of a seeded watershed (see
+    :func:`~higra.labelisation_seeded_watershed`) whose :attr:`num_seeds` seeds, with distinct labels, are drawn
+    independently at random among the vertices (the vertex :math:`v` being drawn with a probability proportional to
+    :attr:`vertex_weights`, uniform by default). Instead of averaging many random seeded watersheds, the probabilities
+    are computed in closed form from the canonical binary partition tree of the graph:
+
+    - an edge of the minimum spanning tree of the graph gets the exact probability that its extremities are in
+      different basins;
+    - any other edge gets the probability of the largest minimum spanning tree edge on the path between its
+      extremities, which is a lower bound of the probability that its extremities are in different basins.
+
+    See: F. Malmberg and C. L. Luengo Hendriks, "An efficient algorithm for exact evaluation of stochastic
+    watersheds," Pattern Recognition Letters 47, 2014.
+
+    :param graph: Input graph
+    :param edge_weights: Weights on the edges of the graph
+    :param num_seeds: number of seeds
+    :param vertex_weights: weight of each vertex (optional)
+    :return: an array of probabilities on the edges of the graph
+    """
+    if vertex_weights is None:
+        vertex_weights = np.ones((graph.num_vertices(),), dtype=np.float64)
+    vertex_weights = hg.linearize_vertex_weights(np.asarray(vertex_weights, dtype=np.float64), graph)
+    return hg.cpp._exact_stochastic_watershed(graph, edge_weights, float(num_seeds), vertex_weights)
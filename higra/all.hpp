@@ -21,3 +21,4 @@
 #include "io_utils/all.hpp"
 #include "structure/all.hpp"
 #include "py_sorting.hpp"
+#include "py_utils.hpp"
@@ -10,4 +10,5 @@
 
 from .hierarchical_cost import *
 from .fragmentation_curve import *
+from .dataset_assessment import *
 
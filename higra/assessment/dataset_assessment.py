@@ -0,0 +1,110 @@
+############################################################################
+# Copyright ESIEE Paris (2021)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def __sample_vertex_map(tree):
+    # vertex map of a hierarchy built on a region adjacency graph, empty array otherwise
+    leaf_graph = hg.CptHierarchy.get_leaf_graph(tree)
+    if leaf_graph is not None and hg.CptRegionAdjacencyGraph.validate(leaf_graph):
+        return hg.cast_to_dtype(hg.CptRegionAdjacencyGraph.get_vertex_map(leaf_graph), hg.index_t)
+    return np.zeros((0,), dtype=hg.index_t)
+
+
+@hg.extend_class(hg.DatasetAssesser, method_name="add_samples")
+def __add_samples(self, trees, altitudes, ground_truths, vertex_maps=None, max_samples_in_flight=0):
+    """
+    Assess the given samples and aggregate their results with the ones of the previously added samples.
+
+    The i-th sample is made of the hierarchy ``trees[i]``, its node altitudes ``altitudes[i]`` and its ground truth(s)
+    ``ground_truths[i]``: a labelisation of the base graph vertices, or a 2d array whose rows are several
+    labelisations of the base graph vertices, or a list of labelisations. The base graph of a hierarchy is its leaf
+    graph, or the original graph of its leaf graph if it is a region adjacency graph (the vertex maps are then
+    deduced from :class:`~higra.CptRegionAdjacencyGraph` if :attr:`vertex_maps` is ``None``).
+
+    The samples are assessed in parallel by batches of at most :attr:`max_samples_in_flight` samples (twice the number
+    of threads if 0), which bounds the memory used by the intermediate results.
+
+    :param trees: list of hierarchies (Concept :class:`~higra.CptHierarchy`)
+    :param altitudes: list of node altitudes of the hierarchies
+    :param ground_truths: list of ground truths of the samples
+    :param vertex_maps: optional, list of vertex maps of the hierarchies built on region adjacency graphs (``None``
+           for the hierarchies built on their base graph)
+    :param max_samples_in_flight: maximum number of samples assessed at the same time
+    :return: ``self``
+    """
+    trees = list(trees)
+    altitudes = [hg.cast_to_dtype(np.asarray(a), np.float64) for a in altitudes]
+
+    def to_2d(ground_truth):
+        if isinstance(ground_truth, (list, tuple)):
+            ground_truth = np.stack(ground_truth)
+        ground_truth = hg.cast_to_dtype(np.asarray(ground_truth), hg.index_t)
+        if ground_truth.ndim == 1:
+            ground_truth = ground_truth.reshape((1, -1))
+        return ground_truth
+
+    ground_truths = [to_2d(g) for g in ground_truths]
+
+    if vertex_maps is None:
+        vertex_maps = [__sample_vertex_map(t) for t in trees]
+    else:
+        vertex_maps = [np.zeros((0,), dtype=hg.index_t) if v is None else hg.cast_to_dtype(v, hg.index_t)
+                       for v in vertex_maps]
+
+    self._add_samples(trees, altitudes, ground_truths, vertex_maps, int(max_samples_in_flight))
+    return self
+
+
+def assess_dataset(trees,
+                   altitudes,
+                   ground_truths,
+                   measure,
+                   max_regions=200,
+                   vertex_maps=None,
+                   compute_purity=False,
+                   max_samples_in_flight=0):
+    """
+    Assessment of the hierarchies of a whole dataset in a single native call.
+
+    For each pair (sample, ground truth), the fragmentation curve of the horizontal cuts of the hierarchy is computed
+    (see :func:`~higra.assess_fragmentation_horizontal_cut`), together with the dendrogram purity of the hierarchy
+    (see :func:`~higra.dendrogram_purity`) if :attr:`compute_purity` is ``True`` and the hierarchy is not built on a
+    region adjacency graph. The results are aggregated incrementally: the returned object gives the optimal score,
+    the optimal number of regions and the purity of each pair, and the mean fragmentation curve over the dataset.
+
+    More samples can be added later with :func:`~higra.DatasetAssesser.add_samples`, for example to process a
+    dataset that does not fit in memory chunk by chunk.
+
+    Example:
+
+    .. code-block:: python
+
+        assessment = hg.assess_dataset(trees, altitudes, ground_truths, hg.PartitionMeasure.BCE)
+        print(assessment.mean_optimal_score())
+        curve = assessment.mean_fragmentation_curve()
+        plt.plot(curve.num_regions(), curve.scores())
+
+    :param trees: list of hierarchies (Concept :class:`~higra.CptHierarchy`)
+    :param altitudes: list of node altitudes of the hierarchies
+    :param ground_truths: list of ground truths of the samples (see :func:`~higra.DatasetAssesser.add_samples`)
+    :param measure: evaluation measure to use (see enumeration :class:`~higra.PartitionMeasure`)
+    :param max_regions: maximum number of regions in the cuts
+    :param vertex_maps: optional, list of vertex maps of the hierarchies built on region adjacency graphs (deduced
+           from :class:`~higra.CptRegionAdjacencyGraph` on the leaf graphs of the trees)
+    :param compute_purity: if ``True``, the dendrogram purity of the hierarchies is computed
+    :param max_samples_in_flight: maximum number of samples assessed at the same time (twice the number of threads if
+           0)
+    :return: an object of type :class:`~higra.DatasetAssesser`
+    """
+    assesser = hg.DatasetAssesser(measure, int(max_regions), bool(compute_purity))
+    return assesser.add_samples(trees, altitudes, ground_truths, vertex_maps, max_samples_in_flight)
@@ -42,8 +42,8 @@ def dendrogram_purity(tree, leaf_labels):
     
     :Complexity:
     
-    The dendrogram purity is computed in :math:`\mathcal{O}(N\\times K \\times C^2)` with :math:`N` the number of nodes
-    in the tree, :math:`K` the number of classes, and :math:`C` the maximal number of children of a node in the tree.
+    The label histograms of the nodes are sparse and merged from small to large: the dendrogram purity is computed
+    in expected :math:`\mathcal{O}(N\log(N))` time with :math:`N` the number of nodes in the tree.
 
     :param tree: input tree
     :param leaf_labels: a 1d integral array of length `tree.num_leaves()`
@@ -52,21 +52,7 @@ def dendrogram_purity(tree, leaf_labels):
     if leaf_labels.ndim != 1 or leaf_labels.size != tree.num_leaves() or leaf_labels.dtype.kind != 'i':
         raise ValueError("leaf_labels must be a 1d integral array of length `tree.num_leaves()`")
 
-    num_l = tree.num_leaves()
-    area = hg.attribute_area(tree)
-
-    max_label = np.max(leaf_labels)
-    num_labels = max_label + 1
-    label_histo_leaves = np.zeros((num_l, num_labels), dtype=np.float64)
-    label_histo_leaves[np.arange(num_l), leaf_labels] = 1
-
-    label_histo = hg.accumulate_sequential(tree, label_histo_leaves, hg.Accumulators.sum)
-    class_purity = label_histo / area[:, np.newaxis]
-
-    weights = hg.attribute_children_pair_sum_product(tree, label_histo)
-    total = np.sum(class_purity[num_l:, :] * weights[num_l:, :])
-
-    return total / np.sum(weights[num_l:])
+    return hg.cpp._dendrogram_purity(tree, leaf_labels)
 
 
 @hg.argument_helper(hg.CptHierarchy)
@@ -100,10 +86,7 @@ def dasgupta_cost(tree, edge_weights, leaf_graph):
     """
     area = hg.attribute_area(tree, leaf_graph=leaf_graph)
 
-    lcaf = tree.lowest_common_ancestor_preprocess()
-    lca = lcaf.lca(leaf_graph)
-
-    return np.sum(area[lca] / edge_weights)
+    return hg.cpp._dasgupta_cost(tree, leaf_graph, edge_weights, area[:tree.num_leaves()].astype(np.float64))
 
 
 @hg.argument_helper(hg.CptHierarchy)
@@ -130,9 +113,8 @@ def tree_sampling_divergence(tree, edge_weights, leaf_graph):
 
     :Complexity:
 
-    The tree sampling divergence is computed in :math:`\mathcal{O}(N (\log(N) + C^2) + M)` with :math:`N` the number of
-    nodes in the tree, :math:`M` the number of edges in the leaf graph, and :math:`C` the maximal number of children of
-    a node in the tree.
+    The tree sampling divergence is computed in :math:`\mathcal{O}(N\log(N) + M)` with :math:`N` the number of
+    nodes in the tree and :math:`M` the number of edges in the leaf graph.
 
     :param tree: Input tree
     :param edge_weights: Edge weights on the leaf graph (similarities)
@@ -140,8 +122,4 @@ def tree_sampling_divergence(tree, edge_weights, leaf_graph):
     :return: a real number
     """
 
-    num_l = tree.num_leaves()
-    p = hg.attribute_tree_sampling_probability(tree, leaf_graph, edge_weights, 'edge')[num_l:]
-    q = hg.attribute_tree_sampling_probability(tree, leaf_graph, edge_weights, 'null')[num_l:]
-    index, = np.where(p)
-    return np.sum(p[index] * np.log(p[index] / q[index]))
+    return hg.cpp._tree_sampling_divergence(tree, leaf_graph, edge_weights)
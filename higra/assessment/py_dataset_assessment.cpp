@@ -0,0 +1,105 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_dataset_assessment.hpp"
+#include "../py_common.hpp"
+#include "higra/assessment/dataset_assessment.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+using namespace hg;
+namespace py = pybind11;
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+void py_init_dataset_assessment(pybind11::module &m) {
+    xt::import_numpy();
+
+    auto c = py::class_<dataset_assesser>(m, "DatasetAssesser",
+                                          "Assessment of the hierarchies of a whole dataset with respect to one or "
+                                          "several ground truths per sample: the samples are assessed in parallel "
+                                          "by batches of bounded size and the results are aggregated incrementally.");
+
+    c.def(py::init<partition_measure, hg::size_t, bool>(),
+          "Create an empty assessment.\n\n"
+          ":param measure: partition measure used to score the horizontal cuts (see :class:`~higra.PartitionMeasure`)\n"
+          ":param max_regions: maximum number of regions in the considered cuts\n"
+          ":param compute_purity: if ``True``, the dendrogram purity of the hierarchies is computed for the samples "
+          "without vertex map",
+          py::arg("measure"),
+          py::arg("max_regions") = 200,
+          py::arg("compute_purity") = false);
+
+    c.def("_add_samples",
+          [](dataset_assesser &assesser,
+             const py::list &trees,
+             const py::list &altitudes,
+             const py::list &ground_truths,
+             const py::list &vertex_maps,
+             index_t max_samples_in_flight) {
+              // the numpy arrays are kept alive by the lists, the computation only uses views on their data
+              std::vector<const hg::tree *> trees_c;
+              std::vector<pyarray<double>> altitudes_py;
+              std::vector<pyarray<index_t>> ground_truths_py;
+              std::vector<array_1d<index_t>> vertex_maps_c;
+              for (const auto &t: trees) {
+                  trees_c.push_back(&t.cast<const hg::tree &>());
+              }
+              for (const auto &a: altitudes) {
+                  altitudes_py.push_back(a.cast<pyarray<double>>());
+              }
+              for (const auto &g: ground_truths) {
+                  ground_truths_py.push_back(g.cast<pyarray<index_t>>());
+              }
+              for (const auto &v: vertex_maps) {
+                  vertex_maps_c.push_back(v.cast<pyarray<index_t>>());
+              }
+              using altitudes_view_t = decltype(pyarray_view(altitudes_py[0]));
+              using ground_truths_view_t = decltype(pyarray_view(ground_truths_py[0]));
+              std::vector<altitudes_view_t> altitudes_c;
+              std::vector<ground_truths_view_t> ground_truths_c;
+              for (const auto &a: altitudes_py) {
+                  altitudes_c.push_back(pyarray_view(a));
+              }
+              for (const auto &g: ground_truths_py) {
+                  ground_truths_c.push_back(pyarray_view(g));
+              }
+              without_gil([&] {
+                  assesser.add_samples(trees_c, altitudes_c, ground_truths_c, vertex_maps_c, max_samples_in_flight);
+              });
+          },
+          py::arg("trees"),
+          py::arg("altitudes"),
+          py::arg("ground_truths"),
+          py::arg("vertex_maps"),
+          py::arg("max_samples_in_flight") = 0);
+
+    c.def("num_samples", &dataset_assesser::num_samples,
+          "Number of samples assessed so far.");
+    c.def("num_assessments", &dataset_assesser::num_assessments,
+          "Number of pairs (sample, ground truth) assessed so far.");
+    c.def("sample_indices", &dataset_assesser::sample_indices,
+          "Index of the sample of each pair (sample, ground truth), in the order in which the samples were added.");
+    c.def("optimal_scores", &dataset_assesser::optimal_scores,
+          "Score of the optimal horizontal cut of each pair (sample, ground truth).");
+    c.def("optimal_numbers_of_regions", &dataset_assesser::optimal_numbers_of_regions,
+          "Number of regions of the optimal horizontal cut of each pair (sample, ground truth).");
+    c.def("numbers_of_regions_ground_truth", &dataset_assesser::numbers_of_regions_ground_truth,
+          "Number of non empty regions of the ground truth of each pair (sample, ground truth).");
+    c.def("purities", &dataset_assesser::purities,
+          "Dendrogram purity of each pair (sample, ground truth), NaN if it was not computed.");
+    c.def("mean_optimal_score", &dataset_assesser::mean_optimal_score,
+          "Mean of the optimal scores over all the pairs (sample, ground truth).");
+    c.def("mean_purity", &dataset_assesser::mean_purity,
+          "Mean of the dendrogram purities over the pairs (sample, ground truth) where it was computed.");
+    c.def("mean_fragmentation_curve", &dataset_assesser::mean_fragmentation_curve,
+          "Mean fragmentation curve over all the pairs (sample, ground truth): for each number of regions k between "
+          "1 and max_regions, the mean of the scores of the finest horizontal cuts having at most k regions.");
+}
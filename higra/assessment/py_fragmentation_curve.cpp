@@ -22,11 +22,17 @@ struct def_assesser_optimal_cut_ctr {
     template<typename value_type, typename C>
     static
     void def(C &c, const char *doc) {
-        c.def(py::init<const hg::tree &,
-                      const xt::pyarray<value_type> &,
-                      optimal_cut_measure,
-                      const xt::pytensor<index_t, 1> &,
-                      hg::size_t>(),
+        c.def(py::init([](const hg::tree &tree,
+                          const xt::pyarray<value_type> &ground_truth,
+                          optimal_cut_measure measure,
+                          const xt::pytensor<index_t, 1> &vertex_map,
+                          hg::size_t max_regions) {
+                  hg::array_1d<index_t> vertex_map_copy = vertex_map;
+                  return without_gil([&] {
+                      return new assesser_fragmentation_optimal_cut(tree, pyarray_view(ground_truth), measure,
+                                                                    vertex_map_copy, max_regions);
+                  });
+              }),
               doc,
               py::arg("tree"),
               py::arg("ground_truth"),
@@ -49,24 +55,29 @@ struct def_assesse_horizontal_cut {
                  const xt::pytensor<index_t, 1> &vertex_map,
                  hg::size_t max_regions
               ) {
-                  switch (measure) {
-                      case partition_measure::DHamming:
-                          return hg::assess_fragmentation_horizontal_cut(tree, altitudes, ground_truth,
-                                                                         hg::scorer_partition_DHamming(), vertex_map,
-                                                                         max_regions);
-                      case partition_measure::DCovering:
-                          return hg::assess_fragmentation_horizontal_cut(tree, altitudes, ground_truth,
-                                                                         hg::scorer_partition_DCovering(), vertex_map,
-                                                                         max_regions);
-                      case partition_measure::BCE:
-                          return hg::assess_fragmentation_horizontal_cut(tree, altitudes, ground_truth,
-                                                                         hg::scorer_partition_BCE(), vertex_map,
-                                                                         max_regions);
-                      default:
-                          throw std::runtime_error(
-                                  "Partition measure is not known, see enumeration PartitionMeasure for legal values.");
+                  hg::array_1d<index_t> vertex_map_copy = vertex_map;
+                  auto altitudes_view = pyarray_view(altitudes);
+                  auto ground_truth_view = pyarray_view(ground_truth);
+                  return without_gil([&] {
+                      switch (measure) {
+                          case partition_measure::DHamming:
+                              return hg::assess_fragmentation_horizontal_cut(tree, altitudes_view, ground_truth_view,
+                                                                             hg::scorer_partition_DHamming(),
+                                                                             vertex_map_copy, max_regions);
+                          case partition_measure::DCovering:
+                              return hg::assess_fragmentation_horizontal_cut(tree, altitudes_view, ground_truth_view,
+                                                                             hg::scorer_partition_DCovering(),
+                                                                             vertex_map_copy, max_regions);
+                          case partition_measure::BCE:
+                              return hg::assess_fragmentation_horizontal_cut(tree, altitudes_view, ground_truth_view,
+                                                                             hg::scorer_partition_BCE(),
+                                                                             vertex_map_copy, max_regions);
+                          default:
+                              throw std::runtime_error(
+                                      "Partition measure is not known, see enumeration PartitionMeasure for legal values.");
 
-                  }
+                      }
+                  });
               },
               doc,
               py::arg("tree"),
@@ -116,7 +127,8 @@ void py_init_fragmentation_curve(pybind11::module &m) {
     c.def("fragmentation_curve",
           &assesser_fragmentation_optimal_cut::fragmentation_curve,
           "Fragmentation curve, i.e. for each number of region k between 1 and max_regions, "
-          "the score of the optimal cut with k regions.");
+          "the score of the optimal cut with k regions.",
+          py::call_guard<py::gil_scoped_release>());
 
     c.def("optimal_number_of_regions",
           &assesser_fragmentation_optimal_cut::optimal_number_of_regions,
@@ -131,7 +143,8 @@ void py_init_fragmentation_curve(pybind11::module &m) {
           "Labelisation of the tree vertices that corresponds to the optimal cut with"
           "the given number of regions. If the number of regions is equal to 0 (default), the "
           "global optimal cut it returned (it will contain get_optimal_number_of_regions regions).",
-          py::arg("num_regions") = 0);
+          py::arg("num_regions") = 0,
+          py::call_guard<py::gil_scoped_release>());
 
     add_type_overloads<def_assesse_horizontal_cut<hg::tree>, HG_TEMPLATE_NUMERIC_TYPES>
             (m,
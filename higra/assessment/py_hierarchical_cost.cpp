@@ -0,0 +1,86 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+
+#include "py_hierarchical_cost.hpp"
+#include "../py_common.hpp"
+#include "higra/assessment/hierarchical_cost.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include "xtensor-python/pytensor.hpp"
+
+using namespace hg;
+namespace py = pybind11;
+
+struct def_dendrogram_purity {
+    template<typename value_type, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_dendrogram_purity",
+              [](const hg::tree &tree, const xt::pytensor<value_type, 1> &leaf_labels) {
+                  return without_gil([&] {
+                      return hg::dendrogram_purity(tree, pyarray_view(leaf_labels));
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("leaf_labels"));
+    }
+};
+
+struct def_dasgupta_cost {
+    template<typename value_type, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_dasgupta_cost",
+              [](const hg::tree &tree,
+                 const ugraph &leaf_graph,
+                 const xt::pytensor<value_type, 1> &edge_weights,
+                 const xt::pytensor<double, 1> &vertex_area) {
+                  return without_gil([&] {
+                      return hg::dasgupta_cost(tree, leaf_graph, pyarray_view(edge_weights),
+                                               pyarray_view(vertex_area));
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("leaf_graph"),
+              py::arg("edge_weights"),
+              py::arg("vertex_area"));
+    }
+};
+
+struct def_tree_sampling_divergence {
+    template<typename value_type, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_tree_sampling_divergence",
+              [](const hg::tree &tree,
+                 const ugraph &leaf_graph,
+                 const xt::pytensor<value_type, 1> &edge_weights) {
+                  return without_gil([&] {
+                      return hg::tree_sampling_divergence(tree, leaf_graph, pyarray_view(edge_weights));
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("leaf_graph"),
+              py::arg("edge_weights"));
+    }
+};
+
+void py_init_hierarchical_cost(pybind11::module &m) {
+    xt::import_numpy();
+    add_type_overloads<def_dendrogram_purity, HG_TEMPLATE_INTEGRAL_TYPES>
+            (m, "Dendrogram purity of a tree with respect to a labelisation of its leaves.");
+    add_type_overloads<def_dasgupta_cost, HG_TEMPLATE_NUMERIC_TYPES>
+            (m, "Dasgupta's cost of a tree with respect to its leaf graph and edge dissimilarities.");
+    add_type_overloads<def_tree_sampling_divergence, HG_TEMPLATE_NUMERIC_TYPES>
+            (m, "Tree sampling divergence of a tree with respect to its leaf graph and edge similarities.");
+}
@@ -25,16 +25,20 @@ struct def_assess_partition {
               [](const xt::pyarray <value_type> &candidate,
                  const xt::pyarray <value_type> &ground_truth,
                  partition_measure measure) {
-                  switch (measure) {
-                      case partition_measure::DHamming:
-                          return assess_partition(candidate, ground_truth, scorer_partition_DHamming());
-                      case partition_measure::DCovering:
-                          return assess_partition(candidate, ground_truth, scorer_partition_DCovering());
-                      case partition_measure::BCE:
-                          return assess_partition(candidate, ground_truth, scorer_partition_BCE());
-                      default:
-                          throw std::runtime_error("Partition measure is not known, see enumeration PartitionMeasure for legal values.");
-                  }
+                  auto candidate_view = pyarray_view(candidate);
+                  auto ground_truth_view = pyarray_view(ground_truth);
+                  return without_gil([&] {
+                      switch (measure) {
+                          case partition_measure::DHamming:
+                              return assess_partition(candidate_view, ground_truth_view, scorer_partition_DHamming());
+                          case partition_measure::DCovering:
+                              return assess_partition(candidate_view, ground_truth_view, scorer_partition_DCovering());
+                          case partition_measure::BCE:
+                              return assess_partition(candidate_view, ground_truth_view, scorer_partition_BCE());
+                          default:
+                              throw std::runtime_error("Partition measure is not known, see enumeration PartitionMeasure for legal values.");
+                      }
+                  });
               },
               doc,
               py::arg("candidate"),
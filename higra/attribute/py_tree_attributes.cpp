@@ -10,9 +10,13 @@
 
 #include "py_tree_attributes.hpp"
 #include "../py_common.hpp"
+#include "../accumulator/common.hpp"
 #include "higra/attribute/tree_attribute.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
+#include <functional>
+#include <list>
+#include <map>
 
 template<typename T>
 using pyarray = xt::pyarray<T>;
@@ -28,12 +32,14 @@ struct def_contour_length_component_tree {
                  const hg::ugraph &graph,
                  const pyarray<T> &vertex_perimeter,
                  const pyarray<T> &edge_length) {
-                  return hg::attribute_contour_length_component_tree(
-                          tree,
-                          graph,
-                          vertex_perimeter,
-                          edge_length
-                  );
+                  return without_gil([&] {
+                      return hg::attribute_contour_length_component_tree(
+                              tree,
+                              graph,
+                              pyarray_view(vertex_perimeter),
+                              pyarray_view(edge_length)
+                      );
+                  });
               },
               doc,
               py::arg("tree"),
@@ -43,6 +49,79 @@ struct def_contour_length_component_tree {
     }
 };
 
+template<typename lca_t>
+struct def_attribute_frontier {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_attribute_frontier_length",
+              [](const hg::tree &tree,
+                 const hg::ugraph &graph,
+                 const pyarray<T> &edge_length,
+                 const lca_t &lca) {
+                  return without_gil([&] {
+                      return hg::attribute_frontier_length(
+                              tree,
+                              graph,
+                              pyarray_view(edge_length),
+                              lca
+                      );
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("graph"),
+              py::arg("edge_length"),
+              py::arg("lca"));
+
+        m.def("_attribute_frontier_strength",
+              [](const hg::tree &tree,
+                 const hg::ugraph &graph,
+                 const pyarray<T> &edge_weights,
+                 const pyarray<double> &edge_length,
+                 const lca_t &lca) {
+                  return without_gil([&] {
+                      return hg::attribute_frontier_strength(
+                              tree,
+                              graph,
+                              pyarray_view(edge_weights),
+                              pyarray_view(edge_length),
+                              lca
+                      );
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("edge_length"),
+              py::arg("lca"));
+    }
+};
+
+struct def_attribute_gaussian_region_weights_model {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_attribute_gaussian_region_weights_model",
+              [](const hg::tree &tree,
+                 const pyarray<T> &vertex_weights,
+                 const pyarray<double> &area) {
+                  return without_gil([&] {
+                      return hg::attribute_gaussian_region_weights_model(
+                              tree,
+                              pyarray_view(vertex_weights),
+                              pyarray_view(area)
+                      );
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("vertex_weights"),
+              py::arg("area"));
+    }
+};
+
 struct def_attribute_extrema {
     template<typename T>
     static
@@ -50,10 +129,12 @@ struct def_attribute_extrema {
         m.def("_attribute_extrema",
               [](const hg::tree &tree,
                  const pyarray<T> &altitudes) {
-                  return hg::attribute_extrema(
-                          tree,
-                          altitudes
-                  );
+                  return without_gil([&] {
+                      return hg::attribute_extrema(
+                              tree,
+                              pyarray_view(altitudes)
+                      );
+                  });
               },
               doc,
               py::arg("tree"),
@@ -69,11 +150,13 @@ struct def_attribute_height {
               [](const hg::tree &tree,
                  const pyarray<T> &altitudes,
                  bool increasing_altitudes) {
-                  return hg::attribute_height(
-                          tree,
-                          altitudes,
-                          increasing_altitudes
-                  );
+                  return without_gil([&] {
+                      return hg::attribute_height(
+                              tree,
+                              pyarray_view(altitudes),
+                              increasing_altitudes
+                      );
+                  });
               },
               doc,
               py::arg("tree"),
@@ -91,12 +174,14 @@ struct def_attribute_extinction_value {
                  const pyarray<T> &altitudes,
                  const pyarray<T> &attribute,
                  bool increasing_altitudes) {
-                  return hg::attribute_extinction_value(
-                          tree,
-                          altitudes,
-                          attribute,
-                          increasing_altitudes
-                  );
+                  return without_gil([&] {
+                      return hg::attribute_extinction_value(
+                              tree,
+                              pyarray_view(altitudes),
+                              pyarray_view(attribute),
+                              increasing_altitudes
+                      );
+                  });
               },
               doc,
               py::arg("tree"),
@@ -113,10 +198,12 @@ struct def_attribute_children_pair_sum_product {
         m.def("_attribute_children_pair_sum_product",
               [](const hg::tree &tree,
                  const pyarray<T> &node_weights) {
-                  return hg::attribute_children_pair_sum_product(
-                          tree,
-                          node_weights
-                  );
+                  return without_gil([&] {
+                      return hg::attribute_children_pair_sum_product(
+                              tree,
+                              pyarray_view(node_weights)
+                      );
+                  });
               },
               doc,
               py::arg("tree"),
@@ -124,11 +211,77 @@ struct def_attribute_children_pair_sum_product {
     }
 };
 
+static py::tuple fused_tree_attributes(const hg::tree &tree,
+                                       const py::list &attributes,
+                                       const pyarray<double> &vertex_area,
+                                       const pyarray<double> &altitudes,
+                                       const pyarray<double> &vertex_weights) {
+    using leaf_data_t = xt::pyarray<double, xt::layout_type::row_major>;
+    // the engine only works on views of the numpy buffers: compute is called without the GIL
+    auto vertex_area_view = pyarray_view(vertex_area);
+    auto altitudes_view = pyarray_view(altitudes);
+    auto vertex_weights_view = pyarray_view(vertex_weights);
+    auto engine = hg::make_fused_tree_attributes(tree, vertex_area_view);
+    // leaf data of the accumulations must remain valid until compute is called
+    std::list<leaf_data_t> leaf_data;
+    std::list<decltype(pyarray_view(std::declval<const leaf_data_t &>()))> leaf_data_views;
+    std::vector<std::function<py::object()>> results;
+    // the results are moved out of the engine: the numpy arrays take ownership of the buffers without copy
+    // (an attribute requested several times is converted once)
+    std::map<const void *, py::object> converted;
+    auto add_result = [&results, &converted](auto &res) {
+        results.emplace_back([&res, &converted]() {
+            auto &obj = converted[&res];
+            if (!obj) {
+                obj = py::cast(std::move(res));
+            }
+            return obj;
+        });
+    };
+
+    for (const auto &attribute: attributes) {
+        if (py::isinstance<py::str>(attribute)) {
+            auto name = attribute.cast<std::string>();
+            if (name == "area") {
+                add_result(engine.area());
+            } else if (name == "volume") {
+                add_result(engine.add_volume(altitudes_view));
+            } else if (name == "depth") {
+                add_result(engine.add_depth());
+            } else if (name == "extrema") {
+                add_result(engine.add_extrema(altitudes_view));
+            } else if (name == "mean_vertex_weights") {
+                add_result(engine.add_mean_vertex_weights(vertex_weights_view));
+            } else {
+                throw std::runtime_error("Unknown tree attribute: " + name);
+            }
+        } else {
+            auto spec = attribute.cast<std::tuple<leaf_data_t, hg::accumulators>>();
+            leaf_data.push_back(std::get<0>(spec));
+            leaf_data_views.push_back(pyarray_view(leaf_data.back()));
+            auto &data = leaf_data_views.back();
+            dispatch_accumulator(
+                    [&engine, &data, &add_result](const auto &acc) {
+                        add_result(engine.add_accumulator(data, acc));
+                    },
+                    std::get<1>(spec));
+        }
+    }
+
+    without_gil([&engine] { engine.compute(); });
+
+    py::tuple res(results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        res[i] = results[i]();
+    }
+    return res;
+}
+
 void py_init_attributes(pybind11::module &m) {
     xt::import_numpy();
     m.def("_attribute_sibling",
           [](const hg::tree &tree, hg::index_t skip) {
-              return hg::attribute_sibling(tree, skip);
+              return without_gil([&] { return hg::attribute_sibling(tree, skip); });
           },
           "",
           pybind11::arg("tree"),
@@ -136,14 +289,23 @@ void py_init_attributes(pybind11::module &m) {
 
     m.def("_attribute_depth",
           [](const hg::tree &tree) {
-              return hg::attribute_depth(tree);
+              return without_gil([&] { return hg::attribute_depth(tree); });
           },
           "",
           pybind11::arg("tree"));
 
+    m.def("_fused_tree_attributes",
+          &fused_tree_attributes,
+          "",
+          pybind11::arg("tree"),
+          pybind11::arg("attributes"),
+          pybind11::arg("vertex_area"),
+          pybind11::arg("altitudes"),
+          pybind11::arg("vertex_weights"));
+
     m.def("_attribute_child_number",
           [](const hg::tree &tree) {
-              return hg::attribute_child_number(tree);
+              return without_gil([&] { return hg::attribute_child_number(tree); });
           },
           "",
           pybind11::arg("tree"));
@@ -151,11 +313,23 @@ void py_init_attributes(pybind11::module &m) {
     add_type_overloads<def_contour_length_component_tree,
             HG_TEMPLATE_FLOAT_TYPES>(m, "");
 
+    add_type_overloads<def_attribute_frontier<hg::lca_sparse_table>,
+            HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    add_type_overloads<def_attribute_frontier<hg::lca_sparse_table_block>,
+            HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    add_type_overloads<def_attribute_frontier<hg::lca_bitmask_block>,
+            HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    add_type_overloads<def_attribute_gaussian_region_weights_model,
+            HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
     add_type_overloads<def_attribute_extrema,
             HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 
     add_type_overloads<def_attribute_extinction_value,
-            HG_TEMPLATE_FLOAT_TYPES>(m, "");
+            HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 
     add_type_overloads<def_attribute_height,
             HG_TEMPLATE_NUMERIC_TYPES>(m, "");
@@ -100,11 +100,7 @@ def attribute_frontier_length(tree, edge_length=None, leaf_graph=None):
     if edge_length is None:
         edge_length = hg.attribute_edge_length(leaf_graph)
 
-    lca_map = attribute_lca_map(tree, leaf_graph)
-
-    frontier_length = np.zeros((tree.num_vertices(),), dtype=edge_length.dtype)
-    np.add.at(frontier_length, lca_map, edge_length)
-    return frontier_length
+    return hg.cpp._attribute_frontier_length(tree, leaf_graph, edge_length, tree.lowest_common_ancestor_preprocess())
 
 
 @hg.argument_helper(hg.CptHierarchy)
@@ -129,10 +125,9 @@ def attribute_frontier_strength(tree, edge_weights, leaf_graph):
     if hg.CptRegionAdjacencyGraph.validate(leaf_graph) and edge_weights.shape[0] != leaf_graph.num_edges():
         edge_weights = hg.rag_accumulate_on_edges(leaf_graph, hg.Accumulators.sum, edge_weights=edge_weights)
 
-    frontier_length = hg.attribute_frontier_length(tree, leaf_graph=leaf_graph)
-    frontier_strength = hg.attribute_frontier_length(tree, edge_weights, leaf_graph)
-    frontier_strength[tree.num_leaves():] = frontier_strength[tree.num_leaves():] / frontier_length[tree.num_leaves():]
-    return frontier_strength
+    edge_length = np.asarray(hg.attribute_edge_length(leaf_graph), dtype=np.float64)
+    return hg.cpp._attribute_frontier_strength(tree, leaf_graph, edge_weights, edge_length,
+                                               tree.lowest_common_ancestor_preprocess())
 
 
 @hg.argument_helper(hg.CptHierarchy)
@@ -263,10 +258,12 @@ def attribute_mean_vertex_weights(tree, vertex_weights, area=None, leaf_graph=No
     if leaf_graph is not None:
         vertex_weights = hg.linearize_vertex_weights(vertex_weights, leaf_graph)
 
-    attribute = hg.accumulate_sequential(
+    # the sums are accumulated in double precision directly from the input weights (no float64 copy of the leaves)
+    attribute = hg.cpp._accumulate_sequential_float64(
         tree,
-        vertex_weights.astype(np.float64),
-        hg.Accumulators.sum) / area.reshape([-1] + [1] * (vertex_weights.ndim - 1))
+        vertex_weights,
+        hg.Accumulators.sum)
+    attribute /= area.reshape([-1] + [1] * (vertex_weights.ndim - 1))
     return attribute
 
 
@@ -329,22 +326,15 @@ def attribute_vertex_list(tree):
     """
     List of leaf nodes inside the sub-tree rooted in a node.
 
-    **WARNING**: This function is slow and will use O(n²) space, with n the number of leaf nodes !
-
-    **SHOULD ONLY BE USED FOR DEBUGGING AND TESTING**
+    The leaves of each node are a read-only view on a single depth first permutation of the leaves of the tree
+    (see :func:`~higra.Tree.leaf_ranges_preprocess`): the result uses O(n) space, with n the number of nodes.
 
     :param tree: input tree
-    :return: a list of lists
+    :return: a list of 1d arrays
     """
-    result = [[i] for i in tree.leaves()]
-
-    for i in tree.leaves_to_root_iterator(include_leaves=False):
-        tmp = []
-        for c in tree.children(i):
-            tmp.extend(result[c])
-        result.append(tmp)
-
-    return result
+    leaf_ranges = tree.leaf_ranges_preprocess()
+    leaves = leaf_ranges.leaves()
+    return [leaves[b:e] for b, e in zip(leaf_ranges.begins(), leaf_ranges.ends())]
 
 
 @hg.argument_helper(hg.CptHierarchy)
@@ -371,27 +361,8 @@ def attribute_gaussian_region_weights_model(tree, vertex_weights, leaf_graph=Non
     if vertex_weights.ndim > 2:
         raise ValueError("Vertex weight can either be scalar or 1 dimensional.")
 
-    if vertex_weights.dtype not in (np.float32, np.float64):
-        vertex_weights = vertex_weights.astype(np.float64)
-
     area = hg.attribute_area(tree, leaf_graph=leaf_graph)
-    mean = hg.accumulate_sequential(tree, vertex_weights, hg.Accumulators.sum, leaf_graph)
-
-    if vertex_weights.ndim == 1:
-        # general case below would work but this is simpler
-        mean /= area
-        mean2 = hg.accumulate_sequential(tree, vertex_weights * vertex_weights, hg.Accumulators.sum, leaf_graph)
-        mean2 /= area
-        variance = mean2 - mean * mean
-    else:
-        mean /= area[:, None]
-        tmp = vertex_weights[:, :, None] * vertex_weights[:, None, :]
-        mean2 = hg.accumulate_sequential(tree, tmp, hg.Accumulators.sum, leaf_graph)
-        mean2 /= area[:, None, None]
-
-        variance = mean2 - mean[:, :, None] * mean[:, None, :]
-
-    return mean, variance
+    return hg.cpp._attribute_gaussian_region_weights_model(tree, vertex_weights, np.asarray(area, dtype=np.float64))
 
 
 @hg.auto_cache
@@ -747,3 +718,67 @@ def attribute_moment_of_inertia(tree, leaf_graph):
     I_1 = (miu_20 + miu_02) / (M_00 ** 2)
 
     return I_1
+
+
+@hg.argument_helper(hg.CptHierarchy)
+def fused_tree_attributes(tree, attributes, altitudes=None, vertex_weights=None, vertex_area=None, leaf_graph=None):
+    """
+    Computes several attributes of the given tree in a single leaves to root traversal (plus one root to leaves
+    traversal if the depth is requested).
+
+    Each element of :attr:`attributes` is either:
+
+    - one of the strings ``"area"``, ``"volume"``, ``"depth"``, ``"extrema"``, or ``"mean_vertex_weights"``: the
+      result is then equal to the one of the corresponding function :func:`~higra.attribute_area`,
+      :func:`~higra.attribute_volume`, :func:`~higra.attribute_depth`, :func:`~higra.attribute_extrema`, or
+      :func:`~higra.attribute_mean_vertex_weights`; or
+    - a pair ``(leaf_data, accumulator)``: the result is then equal to
+      ``hg.accumulate_sequential(tree, leaf_data, accumulator)`` (computed in float64).
+
+    Compared to successive calls to the individual attribute functions, the results are computed in a single
+    traversal of the tree and without intermediate arrays.
+
+    Example:
+
+    >>> area, depth, max_weights = hg.fused_tree_attributes(tree, ("area", "depth", (leaf_data, hg.Accumulators.max)))
+
+    :param tree: input tree (Concept :class:`~higra.CptHierarchy`)
+    :param attributes: list of requested attributes
+    :param altitudes: node altitudes of the input tree (required by ``"volume"`` and ``"extrema"``)
+    :param vertex_weights: vertex weights of the leaf graph of the input tree (required by ``"mean_vertex_weights"``)
+    :param vertex_area: area of the vertices of the leaf graph of the tree (provided by :func:`~higra.attribute_vertex_area` on `leaf_graph` )
+    :param leaf_graph: (deduced from :class:`~higra.CptHierarchy`)
+    :return: a tuple containing the requested attributes in the same order as in :attr:`attributes`
+    """
+    if vertex_area is None:
+        if leaf_graph is not None:
+            vertex_area = hg.attribute_vertex_area(leaf_graph)
+        else:
+            vertex_area = np.ones((tree.num_leaves(),), dtype=np.float64)
+
+    if leaf_graph is not None:
+        vertex_area = hg.linearize_vertex_weights(vertex_area, leaf_graph)
+        if vertex_weights is not None:
+            vertex_weights = hg.linearize_vertex_weights(vertex_weights, leaf_graph)
+
+    if altitudes is None:
+        altitudes = np.zeros((0,), dtype=np.float64)
+
+    if vertex_weights is None:
+        vertex_weights = np.zeros((0,), dtype=np.float64)
+
+    specs = []
+    for attribute in attributes:
+        if isinstance(attribute, str):
+            specs.append(attribute)
+        else:
+            leaf_data, accumulator = attribute
+            if leaf_graph is not None:
+                leaf_data = hg.linearize_vertex_weights(leaf_data, leaf_graph)
+            specs.append((np.asarray(leaf_data, dtype=np.float64), accumulator))
+
+    return hg.cpp._fused_tree_attributes(tree,
+                                         specs,
+                                         np.asarray(vertex_area, dtype=np.float64),
+                                         np.asarray(altitudes, dtype=np.float64),
+                                         np.asarray(vertex_weights, dtype=np.float64))
@@ -55,6 +55,28 @@ class Concept(object):
             return False
         return hg.has_tag(canonical_element, cls)
 
+    @classmethod
+    def _construction_plan(cls):
+        """
+        Data elements to recover in :func:`construct`: for each concept class in the method resolution order of the
+        given concept, its canonical element name and the list of its (data element name, attribute name) pairs.
+
+        The plan is computed once for each concept class.
+
+        :return: a list of pairs
+        """
+        plan = cls.__dict__.get("_Concept__plan", None)
+        if plan is None:
+            plan = []
+            for c in inspect.getmro(cls):
+                if issubclass(c, Concept) and c is not Concept:
+                    data_elements = [(data_name, data_description[1])
+                                     for data_name, data_description in c._data_elements.items()
+                                     if data_description[1] is not None]
+                    plan.append((c._canonical_data_element, data_elements))
+            cls.__plan = plan
+        return plan
+
     @classmethod
     def construct(cls, canonical_element, strict=True, data_cache=None):
         """
@@ -72,33 +94,29 @@ class Concept(object):
                             + "' does not satisfy this concept.")
         result = {cls._canonical_data_element: canonical_element}
 
-        classes = inspect.getmro(cls)
-        for c in classes:
-            if issubclass(c, Concept) and c is not Concept:
-                ce_name = c._canonical_data_element
-                if ce_name not in result:
-                    if strict:
-                        raise Exception("Construction of concept '"
-                                        + str(cls)
-                                        + "' failed: "
-                                          "cannot find canonical element named '" + ce_name + "'('" + str(c) + "')")
-                else:
-                    ce = result[ce_name]
-                    for data_name, data_description in c._data_elements.items():
-                        if data_description[1] is not None:
-                            if data_cache is None:
-                                elem = hg.get_attribute(ce, data_description[1])
-                            else:
-                                elem = data_cache.get_data(ce).get(data_description[1], None)
-                            if elem is None:
-                                if strict:
-                                    raise Exception("Construction of concept '"
-                                                    + str(cls)
-                                                    + "' failed: "
-                                                      "cannot find data element named '" + data_description[1] + "'('"
-                                                    + str(ce) + "')")
-                            else:
-                                result[data_name] = elem
+        for ce_name, data_elements in cls._construction_plan():
+            if ce_name not in result:
+                if strict:
+                    raise Exception("Construction of concept '"
+                                    + str(cls)
+                                    + "' failed: "
+                                      "cannot find canonical element named '" + ce_name + "'")
+            else:
+                ce = result[ce_name]
+                for data_name, attribute_name in data_elements:
+                    if data_cache is None:
+                        elem = hg.get_attribute(ce, attribute_name)
+                    else:
+                        elem = data_cache.get_data(ce).get(attribute_name, None)
+                    if elem is None:
+                        if strict:
+                            raise Exception("Construction of concept '"
+                                            + str(cls)
+                                            + "' failed: "
+                                              "cannot find data element named '" + attribute_name + "'('"
+                                            + str(ce) + "')")
+                    else:
+                        result[data_name] = elem
 
         return result
 
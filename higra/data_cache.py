@@ -12,6 +12,11 @@ import weakref
 import functools
 import sys
 import inspect
+import hashlib
+import os
+import tempfile
+import threading
+import numpy as np
 import higra as hg
 
 
@@ -196,6 +201,50 @@ def set_attribute(key, attribute_name, attribute, insert_dynamic=True):
         setattr(key, attribute_name, attribute)
 
 
+# locks guarding the lazy computation of the attributes of each object (see get_or_compute_attribute)
+__attribute_locks = WeakKeyDictionary()
+__attribute_locks_guard = threading.RLock()
+
+
+def __attribute_lock(key, attribute_name):
+    """
+    Lock guarding the lazy computation of the attribute :attr:`attribute_name` of the object :attr:`key`.
+    Objects that cannot be weakly referenced share a single global lock.
+    """
+    with __attribute_locks_guard:
+        try:
+            locks = __attribute_locks.setdefault(key, {})
+        except TypeError:
+            return __attribute_locks_guard
+        return locks.setdefault(attribute_name, threading.RLock())
+
+
+def get_or_compute_attribute(key, attribute_name, compute, force_recompute=False):
+    """
+    Get the Higra attribute named :attr:`attribute_name` of the object :attr:`key`, computing it with
+    :attr:`compute` and storing it with :func:`~higra.set_attribute` if it does not exist yet.
+
+    The attribute is computed exactly once even if several threads request it concurrently: the other threads wait
+    for the result of the first one. This allows several threads to share an object whose derived structures (for
+    example the lowest common ancestor index of a tree) are computed lazily, without external locks.
+
+    :param key: an object
+    :param attribute_name: a string
+    :param compute: a function without argument returning the value of the attribute
+    :param force_recompute: if ``True``, the attribute is recomputed even if it already exists
+    :return: the attribute value associated to the given name
+    """
+    attribute = get_attribute(key, attribute_name)
+    if attribute is not None and not force_recompute:
+        return attribute
+    with __attribute_lock(key, attribute_name):
+        attribute = get_attribute(key, attribute_name)
+        if attribute is None or force_recompute:
+            attribute = compute()
+            set_attribute(key, attribute_name, attribute)
+        return attribute
+
+
 def get_tags(key):
     if __support_dynamic_attributes(key):
         data = getattr(key, "__higra_tags__", None)
@@ -253,39 +302,47 @@ def __check_valid_signature(signature):
             raise Exception("Can only handle simple functions, ie with only position and keyword parameters.")
 
 
-def __transfer_to_kw_arguments(signature, args, kwargs):
+def __precompute_signature(fun):
     """
-    Transfer positional arguments to keyword arguments.
+    Inspects the signature of the given function once, at decoration time, so that the decorated function does not
+    have to go through :mod:`inspect` on each call.
 
-    ``__check_valid_signature(signature)`` must be True
+    :param fun: a function with only positional or keyword arguments
+    :return: a tuple of parameter names (in order) and a tuple of pairs (parameter name, default value)
+    """
+    signature = inspect.signature(fun)
+    __check_valid_signature(signature)
+    parameter_names = tuple(p.name for p in signature.parameters.values())
+    default_parameters = tuple((p.name, p.default) for p in signature.parameters.values() if p.default is not p.empty)
+    return parameter_names, default_parameters
 
-    :param signature:
+
+def __transfer_to_kw_arguments(parameter_names, args, kwargs):
+    """
+    Transfer positional arguments to keyword arguments.
+
+    :param parameter_names: parameter names of the function (see ``__precompute_signature``)
     :param args:
     :param kwargs:
-    :return:
+    :return: positional arguments that could not be transferred
     """
-    nargs = list(args)
-    for p in signature.parameters.values():
-        if len(nargs) == 0:
-            break
-        if p.kind == inspect.Parameter.POSITIONAL_OR_KEYWORD:
-            kwargs[p.name] = nargs[0]
-            del nargs[0]
-    return nargs
+    n = min(len(args), len(parameter_names))
+    for i in range(n):
+        kwargs[parameter_names[i]] = args[i]
+    return args[n:]
 
 
-def __add_default_parameter(signature, args, kwargs):
+def __add_default_parameter(default_parameters, kwargs):
     """
-    Add default parameters present in the signature that are not already in :attr:`kwargs`
+    Add default parameters that are not already in :attr:`kwargs`
 
-    :param signature:
-    :param args:
+    :param default_parameters: default parameters of the function (see ``__precompute_signature``)
     :param kwargs:
     :return:
     """
-    for p in signature.parameters.values():
-        if p.name not in kwargs and p.default is not p.empty:
-            kwargs[p.name] = p.default
+    for name, default in default_parameters:
+        if name not in kwargs:
+            kwargs[name] = default
 
 
 ###########################################################
@@ -395,17 +452,6 @@ def __hash_combine(h1, h2):
     return h1
 
 
-def __has_method(o, m):
-    """
-    Test if a given object has a given method
-    :param o: object
-    :param m: method name
-    :return: True or False
-    """
-    mm = getattr(o, m, None)
-    return callable(mm)
-
-
 def __make_key(o):
     """
     Computes a hash of the given object
@@ -425,17 +471,252 @@ def __make_key(o):
         keys = sum([__make_key(k) for k in o.keys()])
         values = sum([__make_key(v) for v in o.values()])
         return __hash_combine(keys, values)
-    elif __has_method(o, "__hash__"):
+    try:
+        return hash(o)
+    except TypeError:
+        # non hashable objects are identified by their id
+        return hash(str(id(o)))
+
+
+def __make_hash(args, parameter_values):
+    """
+    Computes a hash of a function call
+
+    :param args: positional arguments that could not be transferred to keyword arguments
+    :param parameter_values: values of the parameters of the function, in the order of its signature
+    :return: int
+    """
+    return __hash_combine(__make_key(args), __make_key(parameter_values))
+
+
+###########################################################
+#                                                         #
+#                  PERSISTENT CACHE                       #
+#                                                         #
+###########################################################
+
+class PersistentCache:
+    """
+    On disk store of the results of :func:`~higra.auto_cache` decorated functions (see
+    :func:`~higra.set_persistent_cache`).
+
+    Each result is stored in its own ``.npy`` file named after the content key of the function call. Files are memory
+    mapped when they are read back. When the total size of the stored results exceeds :attr:`max_size` bytes, the least
+    recently used results are deleted.
+
+    The store is safe to share between several processes: results are written in temporary files which are then
+    atomically renamed.
+    """
+
+    def __init__(self, directory, max_size=1 << 30):
+        self.directory = os.path.abspath(directory)
+        self.max_size = int(max_size)
+        os.makedirs(self.directory, exist_ok=True)
+
+    def __filename(self, key):
+        return os.path.join(self.directory, key + ".npy")
+
+    def __entries(self):
+        entries = []
+        for name in os.listdir(self.directory):
+            if name.endswith(".npy"):
+                filename = os.path.join(self.directory, name)
+                try:
+                    st = os.stat(filename)
+                    entries.append((st.st_mtime, st.st_size, filename))
+                except OSError:
+                    pass
+        return entries
+
+    def get(self, key):
+        """
+        Get the result associated to the given key.
+
+        :param key: a string
+        :return: a copy on write memory mapped array, or ``None`` if the key is not in the store
+        """
+        filename = self.__filename(key)
         try:
-            return hash(o)
-        except TypeError:
+            result = np.load(filename, mmap_mode="c", allow_pickle=False)
+            # the modification time of the file serves as last access time for the LRU eviction
+            os.utime(filename)
+        except (OSError, ValueError):
+            return None
+        return result
+
+    def put(self, key, value):
+        """
+        Store a result with the given key: the least recently used results are evicted if the store becomes larger
+        than :attr:`max_size`.
+
+        Errors when writing on disk are ignored: the store is a best effort cache.
+
+        :param key: a string
+        :param value: a numpy array (non object dtype)
+        :return: nothing
+        """
+        tmp_filename = None
+        try:
+            fd, tmp_filename = tempfile.mkstemp(suffix=".tmp", dir=self.directory)
+            with os.fdopen(fd, "wb") as f:
+                np.save(f, value, allow_pickle=False)
+            os.replace(tmp_filename, self.__filename(key))
+            tmp_filename = None
+            self.__evict()
+        except OSError:
             pass
+        finally:
+            if tmp_filename is not None:
+                try:
+                    os.remove(tmp_filename)
+                except OSError:
+                    pass
+
+    def size(self):
+        """
+        Total size in bytes of the stored results.
+        """
+        return sum(e[1] for e in self.__entries())
+
+    def clear(self):
+        """
+        Delete all the stored results.
+        """
+        for _, _, filename in self.__entries():
+            try:
+                os.remove(filename)
+            except OSError:
+                pass
+
+    def __evict(self):
+        entries = self.__entries()
+        total_size = sum(e[1] for e in entries)
+        if total_size <= self.max_size:
+            return
+        entries.sort()
+        for _, size, filename in entries:
+            if total_size <= self.max_size:
+                break
+            try:
+                os.remove(filename)
+                total_size -= size
+            except OSError:
+                pass
+
+
+def set_persistent_cache(directory, max_size=1 << 30):
+    """
+    Activates or deactivates the persistent cache of :func:`~higra.auto_cache` decorated functions.
+
+    When the persistent cache is active, a call to an auto cached function that misses the in-memory cache is
+    identified by a content key: a hash of the name of the function and of the content of its arguments
+    (the parents of a tree, the edges of an undirected graph, the values of an array...). If a result is associated
+    to this key in the persistent cache, it is memory mapped from the disk instead of being recomputed. Otherwise,
+    the result is computed and stored in the persistent cache. The results are thus reused across processes and
+    process restarts, as long as the inputs have the same content.
+
+    Only function calls whose arguments can be hashed by content (``None``, booleans, numbers, strings,
+    enumerations, numpy arrays, trees, undirected graphs and tuples, lists and dictionaries of those) and whose
+    results are numpy arrays go through the persistent cache. Results read from the persistent cache are copy on
+    write memory mapped arrays.
+
+    The results stored in the persistent cache are not invalidated when Higra is updated: the cache should be
+    cleared (see :func:`~higra.PersistentCache.clear`) after an update.
+
+    :See:
+
+    :func:`~higra.get_persistent_cache`: get the current persistent cache.
+
+    :param directory: directory where the results are stored (created if it does not exist), ``None`` deactivates
+        the persistent cache
+    :param max_size: maximum size in bytes of the stored results, the least recently used results are evicted
+        beyond this size (default 1GiB)
+    :return: the new :class:`~higra.PersistentCache` or ``None``
+    """
+    if directory is None:
+        hg.__persistent_cache = None
+    else:
+        hg.__persistent_cache = PersistentCache(directory, max_size)
+    return hg.__persistent_cache
+
+
+def get_persistent_cache():
+    """
+    Returns the current persistent cache of :func:`~higra.auto_cache` decorated functions.
+
+    :See:
+
+    :func:`~higra.set_persistent_cache`: activates or deactivates the persistent cache.
+
+    :return: a :class:`~higra.PersistentCache` or ``None`` if the persistent cache is not active
+    """
+    return hg.__persistent_cache
+
+
+# name of the attribute used to memoize the content hash of a tree
+_content_hash_attribute = "__content_hash__"
 
-    return hash(str(id(o)))
 
+def __update_content_hash(h, o):
+    """
+    Update the hash object :attr:`h` with the content of :attr:`o`
 
-def __make_hash(*args, **kwargs):
-    return __hash_combine(__make_key(args), __make_key(kwargs))
+    :param h: a hashlib hash object
+    :param o: an object
+    :return: False if the content of :attr:`o` cannot be hashed, True otherwise
+    """
+    if o is None or isinstance(o, (bool, int, float, str, bytes)):
+        h.update((type(o).__name__ + ":" + repr(o) + ";").encode())
+    elif isinstance(o, (np.ndarray, np.generic)):
+        a = np.ascontiguousarray(o)
+        if a.dtype.hasobject:
+            return False
+        h.update(("ndarray:" + a.dtype.str + str(a.shape) + ";").encode())
+        h.update(a.reshape(-1).view(np.uint8))
+    elif isinstance(o, (tuple, list)):
+        h.update((type(o).__name__ + str(len(o)) + ";").encode())
+        for e in o:
+            if not __update_content_hash(h, e):
+                return False
+    elif isinstance(o, dict):
+        h.update(("dict" + str(len(o)) + ";").encode())
+        for k in sorted(o.keys(), key=repr):
+            if not (__update_content_hash(h, k) and __update_content_hash(h, o[k])):
+                return False
+    elif isinstance(o, hg.Tree):
+        # trees are immutable: their content hash is computed once
+        digest = get_attribute(o, _content_hash_attribute)
+        if digest is None:
+            th = hashlib.blake2b(digest_size=20)
+            th.update(("tree:" + str(o.category()) + str(o.num_leaves()) + ";").encode())
+            __update_content_hash(th, o.parents())
+            digest = th.hexdigest()
+            set_attribute(o, _content_hash_attribute, digest, insert_dynamic=False)
+        h.update(digest.encode())
+    elif isinstance(o, hg.UndirectedGraph):
+        h.update(("ugraph:" + str(o.num_vertices()) + ";").encode())
+        __update_content_hash(h, o.edge_list())
+    elif hasattr(type(o), "__members__"):
+        # enumerations
+        h.update((type(o).__name__ + ":" + str(o) + ";").encode())
+    else:
+        return False
+    return True
+
+
+def __make_content_key(fun, args, kwargs):
+    """
+    Computes a key identifying a function call by the content of its arguments
+    :param fun: a function
+    :param args: positional arguments
+    :param kwargs: named arguments
+    :return: a string or None if some arguments cannot be hashed by content
+    """
+    h = hashlib.blake2b(digest_size=20)
+    h.update((fun.__module__ + "." + fun.__qualname__ + ";").encode())
+    if __update_content_hash(h, tuple(args)) and __update_content_hash(h, kwargs):
+        return h.hexdigest()
+    return None
 
 
 def auto_cache(fun):
@@ -501,6 +782,13 @@ def auto_cache(fun):
         - :func:`~set_auto_cache_state`
         - :func:`~get_auto_cache_state`
 
+    :Persistent cache:
+
+    Results can also be stored on disk and reused across processes, see:
+
+        - :func:`~set_persistent_cache`
+        - :func:`~get_persistent_cache`
+
     :return:
     """
 
@@ -508,12 +796,13 @@ def auto_cache(fun):
     while hasattr(original_fun, 'original'):
         original_fun = original_fun.original
 
-    signature = inspect.signature(original_fun)
-    __check_valid_signature(signature)
+    parameter_names, default_parameters = __precompute_signature(original_fun)
+    first_param_name = parameter_names[0] if len(parameter_names) > 0 else None
+    fun_name = fun.__name__
 
     @functools.wraps(fun)
     def wrapper(*args, **kwargs):
-        data_name = kwargs.pop("attribute_name", fun.__name__)
+        data_name = kwargs.pop("attribute_name", fun_name)
         force_recompute = kwargs.pop("force_recompute", False)
         data_cache = kwargs.pop("data_cache", hg.__higra_global_cache)
         no_cache = kwargs.pop("no_cache", False)
@@ -525,10 +814,8 @@ def auto_cache(fun):
             obj = None
             if len(args) > 0:
                 obj = args[0]
-            elif len(kwargs) > 0:
-                first_param_name = signature.parameters.values().__iter__().__next__().name
-                if first_param_name in kwargs:
-                    obj = kwargs[first_param_name]
+            elif first_param_name in kwargs:
+                obj = kwargs[first_param_name]
 
             if obj is None:
                 raise TypeError("cannot find first parameter")
@@ -537,17 +824,34 @@ def auto_cache(fun):
             cache = cache.setdefault(_auto_cache_keyword, {})
             cache = cache.setdefault(data_name, {})
 
-            args = __transfer_to_kw_arguments(signature, args, kwargs)
-            __add_default_parameter(signature, args, kwargs)
+            args = __transfer_to_kw_arguments(parameter_names, args, kwargs)
+            __add_default_parameter(default_parameters, kwargs)
             if len(args) > 0:
                 import warnings
                 warnings.warn('Auto cache: all positional parameters could not be transformed into '
                               'named parameters.')
 
-            h = __make_hash(*args, **kwargs)
+            h = __make_hash(args, [kwargs.get(name, None) for name in parameter_names])
 
             if force_recompute or h not in cache:
-                cache[h] = fun(*args, **kwargs)
+                # concurrent calls with the same arguments compute the result once
+                with __attribute_lock(obj, _auto_cache_keyword + "." + data_name):
+                    if force_recompute or h not in cache:
+                        persistent_cache = hg.__persistent_cache
+                        content_key = None
+                        result = None
+                        if persistent_cache is not None:
+                            content_key = __make_content_key(original_fun, args, kwargs)
+                            if content_key is not None and not force_recompute:
+                                result = persistent_cache.get(content_key)
+
+                        if result is None:
+                            result = fun(*args, **kwargs)
+                            if content_key is not None and isinstance(result, np.ndarray) and \
+                                    not result.dtype.hasobject and result.size > 0:
+                                persistent_cache.put(content_key, result)
+
+                        cache[h] = result
 
             return cache[h]
         except TypeError as e:
@@ -568,30 +872,20 @@ def auto_cache(fun):
 ###########################################################
 
 
-def __resolve_concept(arg_name, concept, all_parameters_name, all_data_found, kwargs, data_cache):
+def __resolve_concept(arg_name, concept_type, concept_name_to_arg_name_map, all_parameters_name, all_data_found,
+                      kwargs):
     """
-    Tries to expand the elements contained in the concept ``concept`` for the data associated to the name
+    Tries to expand the elements contained in the concept ``concept_type`` for the data associated to the name
     ``arg_name``.
 
     :param arg_name: name or the data element
-    :param concept: concept type or concept object
+    :param concept_type: concept type
+    :param concept_name_to_arg_name_map: mapping from concept element names to argument names
     :param all_parameters_name: name of all known parameters of the function
     :param all_data_found: dictionary of all found data in the concept resolutions so far
     :param kwargs: dictionary of all known name arguments so far
-    :param data_cache:
     :return:
     """
-    if not type(concept) is type:
-        # if concept is a concept object, get the associated type and potential name mapping
-        concept_type = type(concept)
-        concept_name_to_arg_name_map = concept.name_mapping
-    else:
-        concept_type = concept
-        concept_name_to_arg_name_map = {}
-
-    if not issubclass(concept_type, hg.Concept):
-        raise Exception(str(concept_type) + " is not a subclass of the abstract Concept class.")
-
     # if arg_name is not associated to any found data, then we can not do anything
     if arg_name in all_data_found:
         arg_value = all_data_found[arg_name]
@@ -601,7 +895,7 @@ def __resolve_concept(arg_name, concept, all_parameters_name, all_data_found, kw
             # tries to map the given element name to a new name or itself if no such mapping exists
             argument_name = concept_name_to_arg_name_map.get(data_element_name, data_element_name)
             # if element name is requested by function and not already in kwargs
-            if argument_name in all_parameters_name and (argument_name not in kwargs or kwargs[argument_name] is None):
+            if argument_name in all_parameters_name and kwargs.get(argument_name, None) is None:
                 kwargs[argument_name] = data_element
 
         # add all found elements to found data
@@ -618,6 +912,8 @@ def argument_helper(*concepts):
     the function has a parameter called *n* that is either undefined or ``None`` in the current call, then the decorator
     will inject ``n=e`` as a new keyword parameter in the function call.
 
+    The signature of the decorated function and the concepts are analysed once, when the function is decorated.
+
     :param concepts:
     :return:
     """
@@ -637,27 +933,39 @@ def argument_helper(*concepts):
         while hasattr(original_fun, 'original'):
             original_fun = original_fun.original
 
-        signature = inspect.signature(original_fun)
-        __check_valid_signature(signature)
+        parameter_names, _ = __precompute_signature(original_fun)
+        all_parameters_name = frozenset(parameter_names)
+
+        # (argument name, concept type, name mapping) for each concept
+        resolved_concepts = []
+        for concept_elem in concepts:
+            try:
+                arg_name, concept = concept_elem
+            except (ValueError, TypeError):  # failed to unpack, use first parameter name
+                concept = concept_elem
+                arg_name = parameter_names[0]
+
+            if not type(concept) is type:
+                # if concept is a concept object, get the associated type and potential name mapping
+                concept_type = type(concept)
+                concept_name_to_arg_name_map = concept.name_mapping
+            else:
+                concept_type = concept
+                concept_name_to_arg_name_map = {}
+
+            if not issubclass(concept_type, hg.Concept):
+                raise Exception(str(concept_type) + " is not a subclass of the abstract Concept class.")
 
-        all_parameters_name = set()
-        for p in signature.parameters.values():
-            all_parameters_name.add(p.name)
+            resolved_concepts.append((arg_name, concept_type, concept_name_to_arg_name_map))
 
         @functools.wraps(fun)
         def wrapper(*args, **kwargs):
-            args = __transfer_to_kw_arguments(signature, args, kwargs)
-            data_cache = kwargs.pop("data_cache", hg.__higra_global_cache)
+            args = __transfer_to_kw_arguments(parameter_names, args, kwargs)
+            kwargs.pop("data_cache", None)
             all_data_found = dict(kwargs)
-            for concept_elem in concepts:
-
-                try:
-                    arg_name, concept = concept_elem
-                except (ValueError, TypeError):  # failed to unpack, use first parameter name
-                    concept = concept_elem
-                    arg_name = signature.parameters.values().__iter__().__next__().name
-
-                __resolve_concept(arg_name, concept, all_parameters_name, all_data_found, kwargs, data_cache)
+            for arg_name, concept_type, concept_name_to_arg_name_map in resolved_concepts:
+                __resolve_concept(arg_name, concept_type, concept_name_to_arg_name_map, all_parameters_name,
+                                  all_data_found, kwargs)
 
             if len(args) > 0:
                 import warnings
@@ -12,7 +12,22 @@
 #include "../py_common.hpp"
 #include "higra/config.hpp"
 #include "higra/detail/log.hpp"
+#include "higra/detail/simd_dispatch.hpp"
+#include <fstream>
 
+#ifdef HG_ENABLE_PROFILING
+// counts the bytes allocated and released by the module for the profiler statistics
+HG_PROFILER_INSTRUMENT_ALLOCATIONS()
+#endif
+
+
+static bool is_python_finalizing() {
+#if PY_VERSION_HEX >= 0x030D0000
+    return Py_IsFinalizing();
+#else
+    return _Py_IsFinalizing();
+#endif
+}
 
 void py_init_log(pybind11::module &m) {
 
@@ -20,16 +35,101 @@ void py_init_log(pybind11::module &m) {
           []() { return HG_XSTR(HIGRA_VERSION_MAJOR) "." HG_XSTR(HIGRA_VERSION_MINOR) "." HG_XSTR(HIGRA_VERSION_PATCH); },
           "Gives the version number of higra.");
 
-    m.def("set_trace", [](bool enabled) { hg::logger::trace_enabled() = enabled; },
-          "Define if function call tracing is enabled.",
-          pybind11::arg("enabled"));
+    m.def("set_trace", [](bool enabled, bool events) {
+              hg::logger::trace_enabled() = enabled;
+              hg::profiler::set_events_enabled(enabled && events);
+          },
+          "Define if function call tracing is enabled.\n\n"
+          "If :attr:`events` is ``True``, the calls to the profiled C++ functions are also recorded as trace events "
+          "(with their start time, duration and thread) which can be saved with ``save_trace_events`` and "
+          "visualized with chrome://tracing or the Perfetto UI. Trace events are only recorded if Higra was built "
+          "with profiling support (see ``is_profiler_enabled``).",
+          pybind11::arg("enabled"),
+          pybind11::arg("events") = false);
 
     m.def("get_trace", []() { return hg::logger::trace_enabled(); },
           "Get the state of function call tracing.");
 
+    m.def("simd_instruction_set", []() { return hg::simd_instruction_set(); },
+          "Name of the instruction set used by the vectorized kernels (edge weighting, accumulators, sorting and "
+          "range minimum queries) on the current CPU: 'avx512f', 'avx2', 'sse4.2' or 'sse2' on x86-64, 'neon' on "
+          "aarch64, or 'generic'.\n\n"
+          "On x86-64 Linux, the kernels are compiled for each of these instruction sets and the best one supported "
+          "by the CPU is selected at import time, otherwise the kernels use the instruction set of the compilation "
+          "flags.");
+
+    m.def("is_profiler_enabled", []() {
+#ifdef HG_ENABLE_PROFILING
+              return true;
+#else
+              return false;
+#endif
+          },
+          "True if Higra was built with profiling support (option HG_ENABLE_PROFILING).");
+
+    m.def("get_profiler_stats", []() {
+              pybind11::dict result;
+              for (const auto &e: hg::profiler::snapshot()) {
+                  pybind11::dict stats;
+                  stats["calls"] = e.second.calls;
+                  stats["time"] = (double) e.second.time_ns * 1e-9;
+                  stats["allocated_bytes"] = e.second.allocated_bytes;
+                  stats["peak_bytes"] = e.second.peak_bytes;
+                  stats["retained_bytes"] = e.second.retained_bytes;
+                  result[pybind11::str(e.first)] = stats;
+              }
+              return result;
+          },
+          "Statistics of the profiled C++ functions accumulated over all the threads since the last reset: "
+          "a dictionary whose keys are function signatures and whose values are dictionaries with the number of "
+          "calls (key \"calls\"), the total wall time in seconds (key \"time\") and the number of bytes allocated "
+          "during the calls (key \"allocated_bytes\"), the maximum over the calls of the peak memory usage of a call "
+          "(key \"peak_bytes\") and the memory allocated by the calls and still in use after them "
+          "(key \"retained_bytes\"). Times and memory include the nested calls; memory is measured on the calling "
+          "thread. "
+          "The dictionary is empty if Higra was not built with profiling support (see is_profiler_enabled).");
+
+    m.def("get_profiler_counters", []() {
+              pybind11::dict result;
+              for (const auto &e: hg::profiler::snapshot_counters()) {
+                  pybind11::dict stats;
+                  stats["samples"] = e.second.samples;
+                  stats["total"] = e.second.total;
+                  stats["max"] = e.second.max;
+                  stats["mean"] = e.second.mean();
+                  result[pybind11::str(e.first)] = stats;
+              }
+              return result;
+          },
+          "Algorithm counters accumulated over all the threads since the last reset: a dictionary whose keys are "
+          "counter names and whose values are dictionaries with the number of samples (key \"samples\"), their sum "
+          "(key \"total\"), their maximum (key \"max\") and their mean (key \"mean\"). The counters are:\n\n"
+          " - \"union_find::find path length\": length of the path from the element to its canonical node (before "
+          "compression) for each find operation,\n"
+          " - \"binary_partition_tree heap push\", \"binary_partition_tree heap pop\", "
+          "\"binary_partition_tree heap update\" and \"binary_partition_tree heap erase\": number of operations on "
+          "the priority queue of the region adjacency engines of the binary partition tree (the pops are the merges, "
+          "the erasures remove the edges made redundant by the merges),\n"
+          " - \"lca_rmq table bytes\": size of the range minimum query tables of each lowest common ancestor solver,\n"
+          " - \"labelisation_watershed plateau size\": number of vertices explored from each unlabelled vertex "
+          "by the watershed (the plateau and its descending path).\n\n"
+          "The dictionary is empty if Higra was not built with profiling support (see is_profiler_enabled).");
+
+    m.def("reset_profiler_stats", []() { hg::profiler::reset(); },
+          "Reset the statistics, the algorithm counters and the trace events of the profiled C++ functions.");
+
+    m.def("save_trace_events", [](const std::string &filename) {
+              std::ofstream out(filename);
+              hg_assert(out.good(), "Cannot open file: " + filename);
+              hg::profiler::write_chrome_trace(out);
+          },
+          "Save the trace events recorded since the last reset (see ``set_trace``) in the Chrome trace event JSON "
+          "format.",
+          pybind11::arg("filename"));
+
     /*m.def("add_logger_callback",
     [](std::function<void(const std::string &)>  fun){
-        hg::logger::callbacks().push_back(fun);
+        hg::logger::add_callback(fun);
         },
     "Add a new callback for Higra logger.",
     pybind11::arg("callback"));*/
@@ -37,13 +137,29 @@ void py_init_log(pybind11::module &m) {
 
     m.def("logger_register_print_callback",
           []() {
-              hg::logger::callbacks().push_back([](const std::string &msg) {
-                  pybind11::object buildins = pybind11::module::import("builtins");
-                  pybind11::object print = buildins.attr("print");
-                  print(msg);
+              // the callbacks are called from the logger thread, add_callback waits for the messages being
+              // delivered, which may require the GIL
+              without_gil([] {
+                  hg::logger::add_callback([](const std::string &msg) {
+                      if (!Py_IsInitialized() || is_python_finalizing()) {
+                          return;
+                      }
+                      pybind11::gil_scoped_acquire gil;
+                      pybind11::object buildins = pybind11::module::import("builtins");
+                      pybind11::object print = buildins.attr("print");
+                      print(msg);
+                  });
               });
           },
           "Register the builtin print function as a logger output."
     );
 
+    m.def("logger_flush", []() {
+              without_gil([] {
+                  hg::logger::flush();
+              });
+          },
+          "Deliver the pending log messages to the logger outputs. Log messages are normally delivered "
+          "asynchronously by a background thread.");
+
 }
@@ -8,6 +8,10 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+import concurrent.futures
+import contextlib
+import ctypes
+import threading
 import higra as hg
 import numpy as np
 
@@ -94,6 +98,9 @@ def linearize_vertex_weights(vertex_weights, graph=None, shape=None):
 
     Note that this function tries its best to guess what should be done but some ambiguity might always exist.
 
+    The data of ``vertex_weights`` is never copied if it is stored contiguously: the result is then either the input
+    array or a view on it.
+
     :Examples:
 
         >>> r = hg.linearize_vertex_weights(np.ones((4, 5)), shape=(4, 5))
@@ -166,6 +173,9 @@ def delinearize_vertex_weights(vertex_weights, graph=None, shape=None):
 
     Note that this function tries its best to guess what should be done but some ambiguity might always exist.
 
+    The data of ``vertex_weights`` is never copied if it is stored contiguously: the result is then either the input
+    array or a view on it.
+
     :Examples:
 
         >>> r = hg.delinearize_vertex_weights(np.ones((20,)), shape=(4, 5))
@@ -506,9 +516,7 @@ def common_type(*arrays, safety_level='minimum'):
 def cast_to_common_type(*arrays, safety_level='minimum'):
     """
     Find a common type to a list of numpy arrays, cast all arrays that need to be cast to this type and returns the
-    list of arrays (with some of them casted).
-
-
+    list of arrays (with some of them casted). Arrays which already have the common type are returned as is (no copy).
 
     If safety level is equal to 'minimum', then the result type is the smallest that ensures that all values in all
     arrays can be represented exactly in the given type (except for `np.uint64` which is allowed to fit in a `np.int64`!)
@@ -531,7 +539,7 @@ def cast_to_common_type(*arrays, safety_level='minimum'):
 
     ctype = common_type(*arrays, safety_level=safety_level)
 
-    return [a if a.dtype == ctype else a.astype(ctype) for a in arrays]
+    return [a.astype(ctype, copy=False) for a in arrays]
 
 
 def cast_to_dtype(array, dtype):
@@ -543,9 +551,258 @@ def cast_to_dtype(array, dtype):
     :param dtype: a numpy dtype
     :return: a numpy array
     """
-    if array.dtype != dtype:
-        array = array.astype(dtype)
-    return array
+    return array.astype(dtype, copy=False)
+
+
+@contextlib.contextmanager
+def thread_limit(num_threads):
+    """
+    Context manager limiting the number of threads used by the parallel functions of Higra called from the current
+    thread in the ``with`` block (for example to share the cores with the thread pool of another library).
+    The global limit is set with :func:`~higra.set_num_threads`.
+
+    Example:
+
+    >>> with hg.thread_limit(2):
+    >>>     tree, altitudes = hg.component_tree_max_tree(graph, vertex_weights) # uses at most 2 threads
+
+    :param num_threads: maximum number of threads (0 for no limit)
+    """
+    previous = hg.cpp._get_thread_limit()
+    hg.cpp._set_thread_limit(num_threads)
+    try:
+        yield
+    finally:
+        hg.cpp._set_thread_limit(previous)
+
+
+@contextlib.contextmanager
+def deterministic(enabled=True):
+    """
+    Context manager enabling (or disabling) the deterministic mode in the ``with`` block (see
+    :func:`~higra.set_deterministic`). The mode is global to the process: it also applies to the functions called
+    from other threads during the execution of the block.
+
+    Example:
+
+    >>> with hg.deterministic():
+    >>>     mean = hg.accumulate_at(indices, weights, hg.Accumulators.mean) # same result with any number of threads
+
+    :param enabled: state of the deterministic mode in the block
+    """
+    previous = hg.is_deterministic()
+    hg.set_deterministic(enabled)
+    try:
+        yield
+    finally:
+        hg.set_deterministic(previous)
+
+
+@contextlib.contextmanager
+def validation_level(level):
+    """
+    Context manager setting the validation level of the inputs in the ``with`` block (see
+    :func:`~higra.set_validation_level`). The level is global to the process: it also applies to the functions called
+    from other threads during the execution of the block.
+
+    Example:
+
+    >>> tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+    >>> with hg.validation_level("shape"):
+    >>>     # the indices come from Higra itself: do not scan them again
+    >>>     ancestors = tree.lowest_common_ancestor(vertices1, vertices2)
+
+    :param level: ``"shape"`` (constant time checks only) or ``"full"`` (all the checks)
+    """
+    previous = hg.get_validation_level()
+    hg.set_validation_level(level)
+    try:
+        yield
+    finally:
+        hg.set_validation_level(previous)
+
+
+@contextlib.contextmanager
+def cancellation_scope(token):
+    """
+    Context manager installing a cancellation token in the current thread: the long computations of Higra called in
+    the ``with`` block (canonical binary partition trees, binary partition trees, tree of shapes...) regularly check
+    the token and raise :class:`~higra.OperationCancelled` once :meth:`~higra.CancellationToken.cancel` has been
+    called (from any thread).
+
+    Example:
+
+    >>> token = hg.CancellationToken()
+    >>> # token.cancel() may be called from another thread
+    >>> with hg.cancellation_scope(token):
+    >>>     tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+
+    The cancellation is cooperative: computations without cancellation points run to completion.
+
+    :param token: a :class:`~higra.CancellationToken` (``None`` disables the cancellation in the block)
+    :return: the token
+    """
+    previous = hg.cpp._get_cancellation_token()
+    hg.cpp._set_cancellation_token(token)
+    try:
+        yield token
+    finally:
+        hg.cpp._set_cancellation_token(previous)
+
+
+class AsyncFuture(concurrent.futures.Future):
+    """
+    Future returned by :func:`~higra.submit_async`: cancelling a running computation requests its cancellation
+    through its :class:`~higra.CancellationToken`.
+    """
+
+    def __init__(self):
+        super().__init__()
+        self.cancellation_token = hg.CancellationToken()
+
+    def cancel(self):
+        """
+        Cancel the computation: a pending computation is never started, a running computation raises
+        :class:`~higra.OperationCancelled` at its next cancellation point and the future then raises
+        :class:`concurrent.futures.CancelledError`.
+
+        :return: ``True`` if the computation was not started
+        """
+        self.cancellation_token.cancel()
+        return super().cancel()
+
+
+__async_executor = None
+__async_max_workers = None
+__async_lock = threading.Lock()
+
+
+def __get_async_executor():
+    global __async_executor
+    with __async_lock:
+        if __async_executor is None:
+            __async_executor = concurrent.futures.ThreadPoolExecutor(max_workers=__async_max_workers,
+                                                                     thread_name_prefix="higra")
+        return __async_executor
+
+
+def set_async_max_workers(max_workers):
+    """
+    Set the maximum number of computations run simultaneously by :func:`~higra.submit_async` and
+    :func:`~higra.run_async`. The computations already submitted are not affected.
+
+    :param max_workers: maximum number of simultaneous computations (``None`` for the default of
+           :class:`concurrent.futures.ThreadPoolExecutor`)
+    """
+    global __async_executor, __async_max_workers
+    with __async_lock:
+        __async_max_workers = max_workers
+        if __async_executor is not None:
+            __async_executor.shutdown(wait=False)
+            __async_executor = None
+
+
+def submit_async(function, *args, **kwargs):
+    """
+    Run ``function(*args, **kwargs)`` in a thread of an internal pool and return a :class:`concurrent.futures.Future`
+    giving its result.
+
+    The heavy functions of Higra release the GIL: the calling thread is free while the computation runs. Calling
+    :meth:`~concurrent.futures.Future.cancel` on the returned future cancels the computation at its next cancellation
+    point (see :func:`~higra.cancellation_scope`).
+
+    Example:
+
+    >>> future = hg.submit_async(hg.bpt_canonical, graph, edge_weights)
+    >>> # ...
+    >>> tree, altitudes = future.result()
+
+    :param function: function to call
+    :param args: positional arguments of the function
+    :param kwargs: keyword arguments of the function
+    :return: an :class:`~higra.AsyncFuture`
+    """
+    future = AsyncFuture()
+
+    def work():
+        if not future.set_running_or_notify_cancel():
+            return
+        try:
+            with cancellation_scope(future.cancellation_token):
+                result = function(*args, **kwargs)
+        except hg.OperationCancelled:
+            future.set_exception(concurrent.futures.CancelledError())
+        except BaseException as e:
+            future.set_exception(e)
+        else:
+            future.set_result(result)
+
+    __get_async_executor().submit(work)
+    return future
+
+
+def run_async(function, *args, **kwargs):
+    """
+    Awaitable version of :func:`~higra.submit_async` for :mod:`asyncio`: cancelling the awaiting task cancels the
+    computation at its next cancellation point.
+
+    Example:
+
+    >>> async def segment(graph, edge_weights):
+    >>>     tree, altitudes = await hg.run_async(hg.bpt_canonical, graph, edge_weights)
+    >>>     ...
+
+    Must be called from a running event loop.
+
+    :param function: function to call
+    :param args: positional arguments of the function
+    :param kwargs: keyword arguments of the function
+    :return: an :class:`asyncio.Future`
+    """
+    import asyncio
+    return asyncio.wrap_future(submit_async(function, *args, **kwargs))
+
+
+def index_ctype():
+    """
+    ctypes type of :attr:`higra.index_t` (the signed integer type used for indices by the C++ library).
+
+    :return: ``ctypes.c_int64`` or ``ctypes.c_int32``
+    """
+    return ctypes.c_int32 if np.dtype(hg.index_t).itemsize == 4 else ctypes.c_int64
+
+
+def compiled_function_address(function):
+    """
+    Address of the given compiled function (numba ``cfunc`` or ctypes function pointer) or ``None`` if
+    :attr:`function` is not a compiled function (for example a Python callable).
+
+    :param function: a compiled function or any object
+    :return: an integer address or ``None``
+    """
+    if isinstance(function, ctypes._CFuncPtr):
+        return ctypes.cast(function, ctypes.c_void_p).value
+    address = getattr(function, "address", None)
+    if isinstance(address, int) and hasattr(function, "ctypes"):
+        return address
+    return None
+
+
+def data_address(data):
+    """
+    Address of the given user data passed to a compiled function: the address of the data of a numpy array, a
+    ctypes pointer or an integer address. The address of ``None`` is 0.
+
+    :param data: ``None``, a numpy array, a ctypes pointer or an integer
+    :return: an integer address
+    """
+    if data is None:
+        return 0
+    if isinstance(data, np.ndarray):
+        return data.ctypes.data
+    if isinstance(data, int):
+        return data
+    return ctypes.cast(data, ctypes.c_void_p).value or 0
 
 
 def get_include():
@@ -8,9 +8,12 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+from .affinity_clustering import *
 from .binary_partition_tree import *
 from .component_tree import *
 from .constrained_connectivity_hierarchy import *
+from .hdbscan import *
+from .hierarchy_batch import *
 from .hierarchy_core import *
 from .random_hierarchy import *
 from .watershed_hierarchy import *
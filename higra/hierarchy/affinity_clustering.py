@@ -0,0 +1,71 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def affinity_clustering(graph, edge_weights, linkage="single", edge_weight_weights=None, thresholds=None,
+                        altitude_correction="max"):
+    """
+    Approximate agglomerative clustering computed by rounds of parallel merges (affinity clustering [1]_ and
+    Sub-Cluster Component clustering [2]_), for graphs too large for the exact binary partition trees.
+
+    In each round, every cluster is merged with its best neighbour: the edge of smallest linkage value leaving each
+    cluster is searched in parallel, as in Borůvka's algorithm, and each connected component of these edges becomes
+    a new node of the hierarchy, whose altitude is the largest linkage value of these edges. The result is a non
+    binary hierarchy, computed in a number of rounds at most logarithmic in the number of vertices.
+
+    Possible values of :attr:`linkage` are:
+
+      - ``"single"``: the linkage value between two clusters is the minimum of the weights of the edges between them
+        (the merged edges are then edges of the minimum spanning forest of the graph);
+      - ``"complete"``: the maximum of the weights of the edges between the two clusters;
+      - ``"average"``: the mean of the weights of the edges between the two clusters, weighted by
+        :attr:`edge_weight_weights`.
+
+    If :attr:`thresholds` is given, the :math:`i`-th round only merges the edges whose linkage value is smaller than
+    or equal to ``thresholds[i]`` (SCC rounds), the following rounds are unconstrained.
+
+    Valid values for ``altitude correction`` are ``"max"`` (the altitude of a node is the maximum of the linkage
+    values of the nodes of its subtree) and ``"none"`` (the altitudes are the linkage values, which may not be
+    increasing). If the graph is not connected, the roots of the components are merged in a final root node.
+
+    .. [1] M. Bateni, S. Behnezhad, M. Derakhshan, M. Hajiaghayi, R. Kiveris, S. Lattanzi, and V. Mirrokni, \
+    "Affinity clustering: hierarchical clustering at scale," NeurIPS 2017.
+
+    .. [2] N. Monath et al., "Scalable hierarchical agglomerative clustering," KDD 2021.
+
+    :param graph: input graph
+    :param edge_weights: edge weights of the input graph (dissimilarities)
+    :param linkage: ``"single"`` (default), ``"complete"``, or ``"average"``
+    :param edge_weight_weights: weighting of edge weights of the input graph for the average linkage (default to an
+        array of ones)
+    :param thresholds: increasing thresholds of the first rounds (default to ``None``)
+    :param altitude_correction: can be ``"none"`` or ``"max"`` (default)
+    :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes
+    """
+
+    if edge_weight_weights is None:
+        edge_weight_weights = np.ones_like(edge_weights)
+    else:
+        edge_weights, edge_weight_weights = hg.cast_to_common_type(edge_weights, edge_weight_weights)
+
+    if thresholds is None:
+        thresholds = np.zeros((0,), dtype=np.float64)
+    else:
+        thresholds = np.asarray(thresholds, dtype=np.float64)
+
+    tree, altitudes = hg.cpp._affinity_clustering(graph, edge_weights, linkage, edge_weight_weights, thresholds,
+                                                  altitude_correction)
+
+    hg.CptHierarchy.link(tree, graph)
+
+    return tree, altitudes
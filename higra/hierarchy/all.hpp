@@ -10,8 +10,13 @@
 
 #pragma once
 
+#include "py_affinity_clustering.hpp"
 #include "py_binary_partition_tree.hpp"
 #include "py_common.hpp"
 #include "py_component_tree.hpp"
+#include "py_constrained_connectivity_hierarchy.hpp"
+#include "py_hdbscan.hpp"
+#include "py_hierarchy_batch.hpp"
 #include "py_hierarchy_core.hpp"
+#include "py_random_hierarchy.hpp"
 #include "py_watershed_hierarchy.hpp"
@@ -10,6 +10,7 @@
 
 import higra as hg
 import numpy as np
+import ctypes
 
 
 def binary_partition_tree_complete_linkage(graph, edge_weights):
@@ -81,6 +82,14 @@ def binary_partition_tree_exponential_linkage(graph, edge_weights, alpha, edge_w
 
     with :math:`Z = \sum_{x \in X, y \in Y, \{x,y\} \in E} w_2(\{x,y\}) \\times \exp(\\alpha * w(\{x,y\}))`.
 
+    The distances are computed in the log domain: the result is numerically stable for any value of
+    :math:`\\alpha` (including :math:`\\pm\infty`) and the edge weights do not need to be rescaled or promoted to
+    ``np.float64``.
+
+    If :attr:`alpha` is a 1d array, one binary partition tree is computed for each of its values (in parallel,
+    the input arrays being shared) and a list of pairs (tree, altitudes) is returned: this is typically used to
+    search for the best value of :math:`\\alpha`.
+
     :See:
 
          Nishant Yadav, Ari Kobren, Nicholas Monath, Andrew Mccallum.
@@ -89,19 +98,30 @@ def binary_partition_tree_exponential_linkage(graph, edge_weights, alpha, edge_w
 
     :param graph: input graph
     :param edge_weights: edge weights of the input graph
-    :param alpha: exponential parameter
+    :param alpha: exponential parameter, or 1d array of exponential parameters
     :param edge_weight_weights: weighting of edge weights of the input graph (default to an array of ones)
-    :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes
+    :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes, or a list of such pairs if
+        :attr:`alpha` is an array
     """
 
-    alpha = float(alpha)
-
     if edge_weight_weights is None:
         edge_weight_weights = np.ones_like(edge_weights)
     else:
         edge_weights, edge_weight_weights = hg.cast_to_common_type(edge_weights, edge_weight_weights)
 
-    # special cases: improve efficiency and avoid numerical issues
+    if np.ndim(alpha) > 0:
+        alphas = np.asarray(alpha, dtype=edge_weights.dtype)
+        if alphas.ndim != 1:
+            raise ValueError("alpha must be a scalar or a 1d array.")
+        res = hg.cpp._binary_partition_tree_exponential_linkage_multi(graph, edge_weights, alphas,
+                                                                      edge_weight_weights)
+        for tree, _ in res:
+            hg.CptHierarchy.link(tree, graph)
+        return res
+
+    alpha = float(alpha)
+
+    # special cases: improve efficiency
     if alpha == 0:
         tree, altitudes = hg.binary_partition_tree_average_linkage(graph, edge_weights, edge_weight_weights)
     elif alpha == float('-inf'):
@@ -179,7 +199,57 @@ def binary_partition_tree_ward_linkage(graph, vertex_centroids, vertex_sizes=Non
     return tree, altitudes
 
 
-def binary_partition_tree(graph, weight_function, edge_weights):
+def linkage_callback_ctypes_prototype():
+    """
+    ctypes prototype of a compiled linkage callback for :func:`~higra.binary_partition_tree`.
+
+    The callback has the C signature:
+
+    .. code-block:: c
+
+        void callback(index_t fusion_edge_index,
+                      index_t new_region,
+                      index_t merged_region1,
+                      index_t merged_region2,
+                      index_t num_neighbours,
+                      const index_t * neighbour_vertices,
+                      const index_t * first_edge_indices,
+                      const index_t * second_edge_indices,
+                      double * new_edge_weights,
+                      void * user_data);
+
+    where ``index_t`` is a signed integer of the size of :attr:`higra.index_t` (64 bits by default).
+
+    :return: a ``ctypes.CFUNCTYPE`` prototype
+    """
+    idx = hg.index_ctype()
+    idx_p = ctypes.POINTER(idx)
+    return ctypes.CFUNCTYPE(None, idx, idx, idx, idx, idx, idx_p, idx_p, idx_p, ctypes.POINTER(ctypes.c_double),
+                            ctypes.c_void_p)
+
+
+def linkage_callback_numba_signature():
+    """
+    Numba signature of a compiled linkage callback for :func:`~higra.binary_partition_tree` (see
+    :func:`~higra.linkage_callback_ctypes_prototype` for the C signature).
+
+    Example:
+
+    >>> from numba import cfunc, carray, types
+    >>>
+    >>> @cfunc(hg.linkage_callback_numba_signature())
+    >>> def complete_linkage(fusion_edge, new_region, region1, region2, num_neighbours,
+    >>>                      neighbours, first_edges, second_edges, new_weights, user_data):
+    >>>     weights = carray(types.CPointer(types.float64)(user_data), (num_edges,))
+    >>>     ...
+
+    :return: a string
+    """
+    idx = "int32" if np.dtype(hg.index_t).itemsize == 4 else "int64"
+    return "void(" + ", ".join([idx] * 5 + ["CPointer(" + idx + ")"] * 3 + ["CPointer(float64)", "voidptr"]) + ")"
+
+
+def binary_partition_tree(graph, weight_function, edge_weights, user_data=None):
     """
     Binary partition tree of the graph with a user provided cluster distance.
 
@@ -235,6 +305,11 @@ def binary_partition_tree(graph, weight_function, edge_weights):
     - ``set_new_edge_weight(value)``: weight of the new edge. **This has to be defined in the weighting function**.
     - ``new_edge_index()``: the index of the new edge as the weighting function will probably have to track new weight values
 
+    The parameter ``graph`` is a read only view of the current region adjacency graph
+    (:class:`~higra.BinaryPartitionTreeRegionGraph`, only valid during the call): the new region is already linked
+    to its neighbours by the edges ``new_edge_index()``, the merged regions have no edge anymore, and the edges removed
+    from the graph have no extremity (their source and target are equal to -1).
+
     :Example:
 
     The following example shows how to define a weighting function for average linkage assuming that:
@@ -272,6 +347,39 @@ def binary_partition_tree(graph, weight_function, edge_weights):
                 edge_weights[n.new_edge_index()] = new_weight
                 edge_counts[n.new_edge_index()] = new_count
 
+    :Compiled weight function:
+
+    The :attr:`weight_function` can also be a compiled callback: a numba ``cfunc`` with the signature
+    :func:`~higra.linkage_callback_numba_signature` or a ctypes function pointer of type
+    :func:`~higra.linkage_callback_ctypes_prototype`. The callback is then called directly by the C++ agglomeration
+    loop on flat arrays, without going through the interpreter, and the Python GIL is released during the
+    computation. For each merge, it receives the fusion edge, the new region, the two merged regions, and, for each of
+    the :attr:`num_neighbours` neighbours of the new region, its index, the indices of the first and second edges (the
+    second edge index is -1 if there is only one edge), and it must write the weight of the new edge in
+    :attr:`new_edge_weights` (the index of the new edge is equal to the index of the first edge). The last argument is
+    the address of :attr:`user_data` (a numpy array, a ctypes pointer or an integer address), typically an array
+    holding the state of the linkage indexed by edge index:
+
+    .. code-block:: python
+
+        from numba import cfunc, carray, types
+
+        num_edges = graph.num_edges()
+        weights = edge_weights.astype(np.float64) # state of the linkage, modified in place
+
+        @cfunc(hg.linkage_callback_numba_signature())
+        def complete_linkage(fusion_edge, new_region, region1, region2, num_neighbours,
+                             neighbours, first_edges, second_edges, new_weights, user_data):
+            w = carray(types.CPointer(types.float64)(user_data), (num_edges,))
+            for i in range(num_neighbours):
+                new_weight = w[first_edges[i]]
+                if second_edges[i] >= 0:
+                    new_weight = max(new_weight, w[second_edges[i]])
+                new_weights[i] = new_weight
+                w[first_edges[i]] = new_weight
+
+        tree, altitudes = hg.binary_partition_tree(graph, complete_linkage, edge_weights, user_data=weights)
+
     :Complexity:
 
     The worst case time complexity is in :math:`\mathcal{O}(n^2\log(n))` with :math:`n` the number of vertices in the graph.
@@ -279,16 +387,24 @@ def binary_partition_tree(graph, weight_function, edge_weights):
 
      .. warning::
 
-        This function uses a Python callback (the :attr:`weight_function`) that is called frequently by the algorithm:
-        performances will be far from optimal. Please consider a C++ implementation if it is too slow (see this
-        `helper project <https://github.com/higra/Higra-cppextension-cookiecutter>`_ ).
+        With a Python :attr:`weight_function`, the callback is called frequently by the algorithm: performances
+        will be far from optimal. Please consider a compiled callback (see above) or a C++ implementation if it is
+        too slow (see this `helper project <https://github.com/higra/Higra-cppextension-cookiecutter>`_ ).
 
     :param graph: input graph
     :param weight_function: see detailed description above
     :param edge_weights: edge weights of the input graph
+    :param user_data: pointer passed to a compiled :attr:`weight_function` (ignored for a Python callable)
     :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes
     """
-    tree, altitudes = hg.cpp._binary_partition_tree(graph, edge_weights, weight_function)
+    address = hg.compiled_function_address(weight_function)
+    if address is not None:
+        if not np.issubdtype(edge_weights.dtype, np.floating):
+            edge_weights = edge_weights.astype(np.float64)
+        tree, altitudes = hg.cpp._binary_partition_tree_compiled_linkage(graph, edge_weights, address,
+                                                                         hg.data_address(user_data))
+    else:
+        tree, altitudes = hg.cpp._binary_partition_tree(graph, edge_weights, weight_function)
 
     hg.CptHierarchy.link(tree, graph)
 
@@ -9,7 +9,6 @@
 ############################################################################
 
 import higra as hg
-import numpy as np
 
 
 def constrained_connectivity_hierarchy_alpha_omega(graph, vertex_weights):
@@ -36,7 +35,8 @@ def constrained_connectivity_hierarchy_alpha_omega(graph, vertex_weights):
         in IEEE Transactions on Pattern Analysis and Machine Intelligence, vol. 30, no. 7, pp. 1132-1145, July 2008.
         doi: 10.1109/TPAMI.2007.70817
 
-    The algorithm runs in time :math:`\mathcal{O}(n\log(n))` and proceeds by filtering a quasi-flat zone hierarchy (see :func:`~higra.quasi_flat_zones_hierarchy`)
+    The algorithm runs in time :math:`\mathcal{O}(n\log(n))` and proceeds by filtering a quasi-flat zone hierarchy (see :func:`~higra.quasi_flat_zones_hierarchy`).
+    The quasi-flat zone hierarchy, the range of its nodes and the filtering are computed in a single C++ function.
 
     :param graph: input graph
     :param vertex_weights: edge_weights: edge weights of the input graph
@@ -47,29 +47,7 @@ def constrained_connectivity_hierarchy_alpha_omega(graph, vertex_weights):
     if vertex_weights.ndim != 1:
         raise ValueError("constrainted_connectivity_hierarchy_alpha_omega only works for scalar vertex weights.")
 
-    # QFZ on the L1 distance weighted graph
-    edge_weights = hg.weight_graph(graph, vertex_weights, hg.WeightFunction.L1)
-    tree, altitudes = hg.quasi_flat_zone_hierarchy(graph, edge_weights)
-    altitude_parents = altitudes[tree.parents()]
-
-    # vertex value range inside each region
-    min_value = hg.accumulate_sequential(tree, vertex_weights, hg.Accumulators.min)
-    max_value = hg.accumulate_sequential(tree, vertex_weights, hg.Accumulators.max)
-    value_range = max_value - min_value
-
-    # parent node can't be deleted
-    altitude_parents[tree.root()] = max(altitudes[tree.root()], value_range[tree.root()])
-
-    # nodes whith a range greater than the altitudes of their parent have to be deleted
-    violated_constraints = value_range >= altitude_parents
-
-    # the altitude of nodes with a range greater than their altitude but lower than the one of their parent must be changed
-    reparable_node_indices = np.nonzero(np.logical_and(value_range > altitudes, value_range < altitude_parents))
-    altitudes[reparable_node_indices] = value_range[reparable_node_indices]
-
-    # final  result construction
-    tree, node_map = hg.simplify_tree(tree, violated_constraints)
-    altitudes = altitudes[node_map]
+    tree, altitudes = hg.cpp._constrained_connectivity_hierarchy_alpha_omega(graph, vertex_weights)
     hg.CptHierarchy.link(tree, graph)
 
     return tree, altitudes
@@ -98,39 +76,15 @@ def constrained_connectivity_hierarchy_strong_connection(graph, edge_weights):
         in IEEE Transactions on Pattern Analysis and Machine Intelligence, vol. 30, no. 7, pp. 1132-1145, July 2008.
         doi: 10.1109/TPAMI.2007.70817
 
-    The algorithm runs in time :math:`\mathcal{O}(n\log(n))` and proceeds by filtering a quasi-flat zone hierarchy (see :func:`~higra.quasi_flat_zones_hierarchy`)
+    The algorithm runs in time :math:`\mathcal{O}(n\log(n))` and proceeds by filtering a quasi-flat zone hierarchy (see :func:`~higra.quasi_flat_zones_hierarchy`).
+    The quasi-flat zone hierarchy, the range of its nodes and the filtering are computed in a single C++ function.
 
     :param graph: input graph
     :param edge_weights: edge_weights: edge weights of the input graph
     :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes
     """
 
-    tree, altitudes = hg.quasi_flat_zone_hierarchy(graph, edge_weights)
-    altitude_parents = altitudes[tree.parents()]
-
-    # max edge weights inside each region
-    lca_map = hg.attribute_lca_map(tree)
-    max_edge_weights = np.zeros((tree.num_vertices(),), dtype=edge_weights.dtype)
-    np.maximum.at(max_edge_weights, lca_map, edge_weights)
-    max_edge_weights = hg.accumulate_and_max_sequential(tree,
-                                                        max_edge_weights,
-                                                        max_edge_weights[:tree.num_leaves()],
-                                                        hg.Accumulators.max)
-
-    # parent node can't be deleted
-    altitude_parents[tree.root()] = max(altitudes[tree.root()], max_edge_weights[tree.root()])
-
-    # nodes whith a range greater than the altitudes of their parent have to be deleted
-    violated_constraints = max_edge_weights >= altitude_parents
-
-    # the altitude of nodes with a range greater than their altitude but lower than the one of their parent must be changed
-    reparable_node_indices = np.nonzero(
-        np.logical_and(max_edge_weights > altitudes, max_edge_weights < altitude_parents))
-    altitudes[reparable_node_indices] = max_edge_weights[reparable_node_indices]
-
-    # final  result construction
-    tree, node_map = hg.simplify_tree(tree, violated_constraints)
-    altitudes = altitudes[node_map]
+    tree, altitudes = hg.cpp._constrained_connectivity_hierarchy_strong_connection(graph, edge_weights)
     hg.CptHierarchy.link(tree, graph)
 
     return tree, altitudes
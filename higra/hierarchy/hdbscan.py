@@ -0,0 +1,91 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def hdbscan_hierarchy(graph, edge_weights, min_samples=5, min_cluster_size=5):
+    """
+    HDBSCAN* hierarchy [1]_ of an edge weighted graph, typically a :math:`k`-nearest neighbour graph whose edge weights
+    are distances between points (see :func:`~higra.make_graph_from_points`).
+
+    The whole pipeline is computed in C++:
+
+      1. the core distance of each vertex is the distance to its :attr:`min_samples`-th nearest neighbour, the
+         vertex itself being counted as its first neighbour (as in the hdbscan library), computed in parallel from
+         the weights of the edges adjacent to the vertex;
+      2. each edge is reweighted by the mutual reachability distance: the maximum of its weight and of the core
+         distances of its extremities;
+      3. the canonical binary partition tree of the reweighted graph (single linkage clustering) is computed;
+      4. this tree is condensed with the minimum cluster size :attr:`min_cluster_size`, and the stability of each
+         cluster is computed (see :func:`~higra.condense_hierarchy`).
+
+    The input graph must be connected.
+
+    .. [1] R. J. G. B. Campello, D. Moulavi, J. Sander, \
+    "Density-Based Clustering Based on Hierarchical Density Estimates," PAKDD 2013.
+
+    :param graph: input graph
+    :param edge_weights: edge weights of the input graph (distances)
+    :param min_samples: number of samples in the neighbourhood of a core point (default to 5)
+    :param min_cluster_size: minimum number of vertices of a cluster, at least 2 (default to 5)
+    :return: the condensed tree (Concept :class:`~higra.CptHierarchy`), its node altitudes, and the stability of
+        its nodes
+    """
+
+    edge_weights = np.asarray(edge_weights)
+    if not np.issubdtype(edge_weights.dtype, np.floating):
+        edge_weights = edge_weights.astype(np.float64)
+
+    tree, altitudes, stability = hg.cpp._hdbscan_hierarchy(graph, edge_weights, min_samples, min_cluster_size)
+
+    hg.CptHierarchy.link(tree, graph)
+
+    return tree, altitudes, stability
+
+
+@hg.argument_helper(hg.CptHierarchy)
+def condense_hierarchy(tree, altitudes, min_cluster_size):
+    """
+    Condensed tree of a hierarchy for a given minimum cluster size, as in HDBSCAN* [1]_.
+
+    A node of the input tree is a cluster if it is the root, or if it contains at least :attr:`min_cluster_size`
+    leaves and one of its siblings also contains at least :attr:`min_cluster_size` leaves. The condensed tree is the
+    input tree where all the nodes except the clusters and the leaves are removed (see :func:`~higra.simplify_tree`):
+    the parent of a leaf is the smallest cluster containing it.
+
+    The altitude of a cluster is the altitude at which it vanishes, the leaves have altitude 0.
+
+    The stability of a cluster :math:`C` born at altitude :math:`b` (altitude of the parent of the cluster in the
+    input tree, or infinity for the root) is
+
+    .. math::
+
+        \\sum_{p \\in C} \\frac{1}{a_p} - \\frac{1}{b}
+
+    where :math:`a_p` is the altitude at which the leaf :math:`p` leaves :math:`C`. The stability of the leaves is 0.
+
+    .. [1] R. J. G. B. Campello, D. Moulavi, J. Sander, \
+    "Density-Based Clustering Based on Hierarchical Density Estimates," PAKDD 2013.
+
+    :param tree: input tree
+    :param altitudes: increasing altitudes of the nodes of the input tree
+    :param min_cluster_size: minimum number of leaves of a cluster, at least 2
+    :return: the condensed tree (Concept :class:`~higra.CptHierarchy` if input tree already satisfied this concept),
+        its node altitudes, and the stability of its nodes
+    """
+
+    new_tree, new_altitudes, stability = hg.cpp._condense_hierarchy(tree, altitudes, min_cluster_size)
+
+    if hg.CptHierarchy.validate(tree):
+        hg.CptHierarchy.link(new_tree, hg.CptHierarchy.get_leaf_graph(tree))
+
+    return new_tree, new_altitudes, stability
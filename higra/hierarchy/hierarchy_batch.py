@@ -0,0 +1,178 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def weight_graph_batch(graph, images, weight_function):
+    """
+    Edge weights of a graph for each image of a stack of same-shape images (see :func:`~higra.weight_graph`).
+
+    The images are processed in parallel.
+
+    :Example:
+
+    >>> images = np.random.rand(100, 256, 256)
+    >>> graph = hg.get_4_adjacency_graph((256, 256))
+    >>> edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+    >>> edge_weights.shape
+    (100, 130560)
+
+    :param graph: input graph (shared by all the images)
+    :param images: array of shape :math:`(n, s_1, \ldots, s_k)` or :math:`(n, s_1, \ldots, s_k, c)` where
+           :math:`(s_1, \ldots, s_k)` is the shape of the graph and :math:`c` the number of channels
+    :param weight_function: see :class:`~higra.WeightFunction`
+    :return: a 2d array of shape :math:`(n, graph.num\_edges())` whose i-th row contains the edge weights of the i-th
+             image (type ``np.float64``)
+    """
+    images = np.asarray(images)
+    num_images = images.shape[0]
+    num_vertices = graph.num_vertices()
+    if num_images == 0 or images[0].size == num_vertices:
+        vertex_weights = images.reshape((num_images, num_vertices))
+    else:
+        vertex_weights = images.reshape((num_images, num_vertices, -1))
+
+    return hg.cpp._weight_graph_batch(graph, vertex_weights, weight_function)
+
+
+def bpt_canonical_batch(graph, edge_weights):
+    """
+    Canonical binary partition trees (see :func:`~higra.bpt_canonical`) of a graph for a stack of edge weights.
+
+    The i-th row of :attr:`edge_weights` contains the weights of the edges of :attr:`graph` for the i-th image
+    (see :func:`~higra.weight_graph_batch`). The images are processed in parallel and the extremities of the graph
+    edges are extracted only once for the whole batch.
+
+    The trees are returned in concatenated arrays: the i-th tree and its node altitudes are given by
+
+    >>> parents, altitudes, offsets = hg.bpt_canonical_batch(graph, edge_weights)
+    >>> tree_i = hg.Tree(parents[offsets[i]:offsets[i + 1]])
+    >>> altitudes_i = altitudes[offsets[i]:offsets[i + 1]]
+
+    Each tree is identical to the binary partition tree computed by :func:`~higra.bpt_canonical` on the i-th image.
+
+    :param graph: input graph (must be connected)
+    :param edge_weights: 2d array of shape :math:`(n, graph.num\_edges())`
+    :return: the concatenated parents arrays of the trees, their concatenated node altitudes (with the type of
+             :attr:`edge_weights`) and an array of size :math:`n + 1` giving the start of each tree in the two
+             previous arrays
+    """
+    edge_weights = np.asarray(edge_weights)
+    assert edge_weights.ndim == 2, "edge_weights must be a 2d array."
+
+    return hg.cpp._bpt_canonical_batch(graph, edge_weights)
+
+
+def watershed_hierarchy_batch(graph, edge_weights, attribute="area", vertex_area=None):
+    """
+    Watershed hierarchies (see :func:`~higra.watershed_hierarchy_by_area`, :func:`~higra.watershed_hierarchy_by_volume`
+    and :func:`~higra.watershed_hierarchy_by_dynamics`) of a graph for a stack of edge weights.
+
+    The i-th row of :attr:`edge_weights` contains the weights of the edges of :attr:`graph` for the i-th image
+    (see :func:`~higra.weight_graph_batch`). The images are processed in parallel and the extremities of the graph
+    edges are extracted only once for the whole batch.
+
+    The hierarchies are returned in concatenated arrays (see :func:`~higra.bpt_canonical_batch`). Each hierarchy is
+    identical to the one computed by the corresponding function with ``canonize_tree=False`` on the i-th image (use
+    :func:`~higra.canonize_hierarchy` to obtain the canonical hierarchy); altitudes are stored as ``np.float64``.
+
+    :param graph: input graph (must be connected)
+    :param edge_weights: 2d array of shape :math:`(n, graph.num\_edges())`
+    :param attribute: regional attribute of the watershed: ``"area"`` (default), ``"volume"`` or ``"dynamics"``
+    :param vertex_area: area of the input graph vertices (provided by :func:`~higra.attribute_vertex_area`), shared by
+           all the images
+    :return: the concatenated parents arrays of the hierarchies, their concatenated node altitudes and an array of
+             size :math:`n + 1` giving the start of each hierarchy in the two previous arrays
+    """
+    edge_weights = np.asarray(edge_weights)
+    assert edge_weights.ndim == 2, "edge_weights must be a 2d array."
+
+    if vertex_area is None:
+        vertex_area = hg.attribute_vertex_area(graph)
+
+    vertex_area = hg.linearize_vertex_weights(vertex_area, graph)
+
+    return hg.cpp._watershed_hierarchy_batch(graph, edge_weights, attribute, vertex_area.astype(np.float64))
+
+
+def saliency_map_batch(graph, parents, altitudes, offsets):
+    """
+    Saliency maps (see :func:`~higra.saliency`) of a batch of hierarchies on a graph shared by all the hierarchies.
+
+    The hierarchies are given by concatenated arrays as returned by :func:`~higra.bpt_canonical_batch` or
+    :func:`~higra.watershed_hierarchy_batch`: the leaves of each hierarchy must be the vertices of :attr:`graph`.
+    The hierarchies are processed in parallel.
+
+    :param graph: input graph
+    :param parents: concatenated parents arrays of the hierarchies
+    :param altitudes: concatenated node altitudes of the hierarchies
+    :param offsets: start of each hierarchy in :attr:`parents` and :attr:`altitudes`, followed by the total number
+           of nodes
+    :return: a 2d array of shape :math:`(n, graph.num\_edges())` whose i-th row is the saliency map of the i-th
+             hierarchy
+    """
+    return hg.cpp._saliency_map_batch(graph, parents, altitudes, offsets)
+
+
+def hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets, metric="L1"):
+    """
+    Pairwise distances between a batch of hierarchies on a graph shared by all the hierarchies.
+
+    Each hierarchy is represented by its saliency map (see :func:`~higra.saliency_map_batch`), which is computed only
+    once per hierarchy, and the distance between two hierarchies is a distance between their saliency maps:
+
+      - ``"L1"``: sum of the absolute differences of the saliency maps;
+      - ``"L2"``: euclidean distance between the saliency maps;
+      - ``"correlation"``: :math:`1 - r` where :math:`r` is the Pearson correlation coefficient of the saliency maps
+        (:math:`r` is taken equal to 0 if one of the saliency maps is constant).
+
+    The distances are computed natively, in parallel and by cache-sized blocks of pairs of hierarchies, without
+    creating any temporary array per pair of hierarchies.
+
+    The hierarchies are given by concatenated arrays as returned by :func:`~higra.bpt_canonical_batch` or
+    :func:`~higra.watershed_hierarchy_batch`: the leaves of each hierarchy must be the vertices of :attr:`graph`.
+
+    :param graph: input graph
+    :param parents: concatenated parents arrays of the hierarchies
+    :param altitudes: concatenated node altitudes of the hierarchies
+    :param offsets: start of each hierarchy in :attr:`parents` and :attr:`altitudes`, followed by the total number
+           of nodes
+    :param metric: ``"L1"`` (default), ``"L2"`` or ``"correlation"``
+    :return: a symmetric 2d array of shape :math:`(n, n)` (type ``np.float64``)
+    """
+    return hg.cpp._hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets, metric)
+
+
+def attribute_batch(parents, altitudes, offsets, attribute):
+    """
+    Attribute of the nodes of a batch of trees given by concatenated arrays (as returned by
+    :func:`~higra.bpt_canonical_batch` or :func:`~higra.watershed_hierarchy_batch`).
+
+    The available attributes are:
+
+      - ``"area"``: see :func:`~higra.attribute_area` (each leaf has an area of 1);
+      - ``"volume"``: see :func:`~higra.attribute_volume` (each leaf has an area of 1);
+      - ``"height"``: see :func:`~higra.attribute_height` (altitudes must be increasing);
+      - ``"dynamics"``: see :func:`~higra.attribute_dynamics` (altitudes must be increasing);
+      - ``"depth"``: see :func:`~higra.attribute_depth`.
+
+    The trees are processed in parallel.
+
+    :param parents: concatenated parents arrays of the trees
+    :param altitudes: concatenated node altitudes of the trees
+    :param offsets: start of each tree in :attr:`parents` and :attr:`altitudes`, followed by the total number of
+           nodes
+    :param attribute: name of the attribute
+    :return: the concatenated attribute values: the attribute of the nodes of the i-th tree is stored in the range
+             ``offsets[i]:offsets[i + 1]``
+    """
+    return hg.cpp._tree_batch_attribute(parents, altitudes, offsets, attribute)
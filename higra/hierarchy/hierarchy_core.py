@@ -106,6 +106,15 @@ def bpt_canonical(graph, edge_weights=None, sorted_edge_indices=None, return_alt
         >>> tree.mst_edge_map
         array([2, 0, 6, 3])
 
+    When processing a sequence of graphs with the same edges and slightly different edge weights (for example the
+    successive frames of a video), the order of the edges of the previous graph can be reused to sort the edges of the
+    current one faster (see :func:`~higra.arg_sort`):
+
+        >>> sorted_edge_indices = None
+        >>> for edge_weights in frames_edge_weights:
+        >>>     sorted_edge_indices = hg.arg_sort(edge_weights, stable=True, initial_order=sorted_edge_indices)
+        >>>     tree, altitudes = hg.bpt_canonical(graph, edge_weights, sorted_edge_indices=sorted_edge_indices)
+
 
     :Complexity:
 
@@ -196,6 +205,73 @@ def bpt_canonical(graph, edge_weights=None, sorted_edge_indices=None, return_alt
         return tree, altitudes
 
 
+def bpt_canonical_below(graph, edge_weights, altitude):
+    """
+    Lower part of the canonical binary partition tree of the given edge weighted graph, below the given altitude:
+    Kruskal's algorithm is stopped after the edges of weight smaller than or equal to :attr:`altitude`.
+
+    The result is a forest given by its parent array :attr:`parents` in topological order: the
+    ``graph.num_vertices()`` first nodes are the vertices of the graph and a root :math:`r` satisfies
+    ``parents[r] == r``. The nodes of the forest, their altitudes and the edges of the minimum spanning forest
+    :attr:`mst_edge_map` are identical to the first nodes of the result of :func:`~higra.bpt_canonical` (only the
+    parents of the roots differ).
+
+    The trees of the forest correspond to the :attr:`altitude`-connected components of the graph (the supervertices),
+    numbered in the order of their smallest vertex: the vertex :math:`v` belongs to the supervertex
+    ``supervertex_map[v]``, and the root of the supervertex :math:`i` is the node ``roots[i]``.
+
+    The edges of weight greater than :attr:`altitude` are discarded before sorting: only the edges of the lower
+    part are sorted.
+
+    :Example:
+
+        >>> g = hg.UndirectedGraph(4)
+        >>> g.add_edges((0, 2), (1, 3))
+        >>> parents, altitudes, mst_edge_map, supervertex_map, roots = hg.bpt_canonical_below(g, np.asarray((1, 5)), 2)
+        >>> parents
+        array([4, 4, 2, 3, 4])
+        >>> supervertex_map
+        array([0, 0, 1, 2])
+        >>> roots
+        array([4, 2, 3])
+
+    :param graph: input graph
+    :param edge_weights: edge weights of the input graph
+    :param altitude: largest altitude of the nodes of the forest
+    :return: a tuple (parents, altitudes, mst_edge_map, supervertex_map, roots)
+    """
+
+    return hg.cpp._bpt_canonical_below(graph, edge_weights, altitude)
+
+
+def bpt_canonical_above(graph, edge_weights, altitude):
+    """
+    Upper part of the canonical binary partition tree of the given edge weighted graph, above the given altitude.
+
+    The leaves of the returned tree are the supervertices of the graph: the connected components of the graph
+    restricted to the edges of weight smaller than or equal to :attr:`altitude`, numbered in the order of their smallest
+    vertex (the vertex :math:`v` belongs to the leaf ``supervertex_map[v]``). The leaves have altitude 0, and the non
+    leaf nodes, their altitudes and the edges of the minimum spanning tree :attr:`mst_edge_map` are identical to the
+    last nodes of the result of :func:`~higra.bpt_canonical`.
+
+    This is sufficient for example for horizontal cuts at altitudes greater than or equal to :attr:`altitude` or in
+    a small number of regions. The supervertices are computed without sorting the edges: only the edges of weight
+    greater than :attr:`altitude` linking two different supervertices are sorted.
+
+    :Example:
+
+        >>> tree, altitudes, mst_edge_map, supervertex_map = hg.bpt_canonical_above(graph, edge_weights, 10)
+        >>> labels = hg.labelisation_horizontal_cut_from_num_regions(tree, altitudes, 5)[supervertex_map]
+
+    :param graph: input graph (must be connected)
+    :param edge_weights: edge weights of the input graph
+    :param altitude: altitude of the supervertices
+    :return: a tuple (tree, altitudes, mst_edge_map, supervertex_map)
+    """
+
+    return hg.cpp._bpt_canonical_above(graph, edge_weights, altitude)
+
+
 def quasi_flat_zone_hierarchy(graph, edge_weights):
     """
     Computes the quasi flat zone hierarchy of the given weighted graph.
@@ -214,6 +290,62 @@ def quasi_flat_zone_hierarchy(graph, edge_weights):
     return tree, altitudes
 
 
+def hierarchy_on_collapsed_flat_zones(graph, edge_weights, hierarchy_function, threshold=0, expand_leaves=False):
+    """
+    Computes a hierarchy of the given edge weighted graph on its flat zones.
+
+    The flat zones, the connected components of the graph restricted to the edges of weight smaller than or equal to
+    :attr:`threshold`, are first collapsed into the vertices of a region adjacency graph, and the hierarchy is then
+    computed by :attr:`hierarchy_function` on this region adjacency graph. On quantized images, where most edges
+    usually have a weight equal to 0, this avoids to process these edges through the sorting or heap machinery of the
+    hierarchy construction and to create as many nodes of altitude 0.
+
+    :attr:`hierarchy_function` is called with the region adjacency graph and the weights of its edges (the minimum
+    weight of the edges of the graph between two flat zones), and must return a tree and its node altitudes (other
+    returned values are ignored). Linkages other than the min linkage may use :func:`~higra.rag_accumulate_on_edges`
+    to compute the weights they need.
+
+    If :attr:`expand_leaves` is ``True``, the leaves of the returned tree are the vertices of the graph: the flat zones
+    made of several vertices become nodes of altitude :attr:`threshold`. Otherwise, the leaves of the returned tree
+    are the vertices of the region adjacency graph.
+
+    With :func:`~higra.bpt_canonical`, the saliency map of the expanded result is equal to the one of the canonical
+    binary partition tree of the graph on the edges of saliency greater than :attr:`threshold`. For the other
+    linkages, the flat zones act as a pre-segmentation of the graph.
+
+    :Example:
+
+        >>> tree, altitudes = hg.hierarchy_on_collapsed_flat_zones(
+        >>>     graph, edge_weights,
+        >>>     lambda rag, rag_edge_weights: hg.binary_partition_tree_complete_linkage(rag, rag_edge_weights),
+        >>>     expand_leaves=True)
+
+    :param graph: input graph
+    :param edge_weights: edge weights of the input graph
+    :param hierarchy_function: function computing a hierarchy of the region adjacency graph
+    :param threshold: edges of weight smaller than or equal to threshold are collapsed (default 0)
+    :param expand_leaves: if ``True``, the leaves of the result are the vertices of the graph (default ``False``)
+    :return: a tree (Concept :class:`~higra.CptHierarchy`) and its node altitudes
+    """
+
+    flat_zones = hg.graph_cut_2_labelisation(graph, edge_weights > threshold)
+    rag = hg.make_region_adjacency_graph_from_labelisation(graph, flat_zones)
+    rag_edge_weights = hg.rag_accumulate_on_edges(rag, hg.Accumulators.min, edge_weights)
+
+    res = hierarchy_function(rag, rag_edge_weights)
+    tree, altitudes = res[0], res[1]
+
+    if not expand_leaves:
+        return tree, altitudes
+
+    vertex_map = hg.CptRegionAdjacencyGraph.construct(rag)["vertex_map"]
+    tree, altitudes = hg.cpp._expand_collapsed_hierarchy(vertex_map, tree, altitudes, threshold)
+
+    hg.CptHierarchy.link(tree, graph)
+
+    return tree, altitudes
+
+
 def simplify_tree(tree, deleted_vertices, process_leaves=False):
     """
     Creates a copy of the given tree and deletes the vertices :math:`i` of the tree such that :math:`deletedVertices[i]`
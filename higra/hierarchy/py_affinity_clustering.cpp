@@ -0,0 +1,70 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_affinity_clustering.hpp"
+#include "../py_common.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include "higra/hierarchy/affinity_clustering.hpp"
+#include <string>
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+namespace py = pybind11;
+
+struct def_affinity_clustering {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_affinity_clustering",
+              [](const hg::ugraph &graph,
+                 const pyarray<T> &edge_weights,
+                 const std::string &linkage,
+                 const pyarray<T> &edge_weight_weights,
+                 const pyarray<double> &thresholds,
+                 const std::string &altitude_correction) {
+                  hg::affinity_linkage tlinkage;
+                  if (linkage == "single") {
+                      tlinkage = hg::affinity_linkage::single;
+                  } else if (linkage == "complete") {
+                      tlinkage = hg::affinity_linkage::complete;
+                  } else if (linkage == "average") {
+                      tlinkage = hg::affinity_linkage::average;
+                  } else {
+                      throw std::runtime_error("affinity_clustering: Unknown linkage option.");
+                  }
+                  if (edge_weights.dimension() != 1 || edge_weights.size() != hg::num_edges(graph) ||
+                      edge_weight_weights.dimension() != 1 || edge_weight_weights.size() != hg::num_edges(graph)) {
+                      throw std::runtime_error("affinity_clustering: Invalid edge weights.");
+                  }
+                  if (thresholds.dimension() != 1) {
+                      throw std::runtime_error("affinity_clustering: thresholds must be a 1d array.");
+                  }
+                  auto res = without_gil([&] {
+                      return hg::affinity_clustering(graph, pyarray_view(edge_weights), tlinkage,
+                                                     pyarray_view(edge_weight_weights), pyarray_view(thresholds),
+                                                     altitude_correction);
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("linkage"),
+              py::arg("edge_weight_weights"),
+              py::arg("thresholds"),
+              py::arg("altitude_correction"));
+    }
+};
+
+void py_init_affinity_clustering(pybind11::module &m) {
+    xt::import_numpy();
+    add_type_overloads<def_affinity_clustering, HG_TEMPLATE_FLOAT_TYPES>(m, "");
+}
@@ -11,13 +11,11 @@
 #include "py_binary_partition_tree.hpp"
 
 #include "../py_common.hpp"
+#include "../structure/py_common_graph.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
 #include "higra/hierarchy/binary_partition_tree.hpp"
 
-template<typename T>
-using pyarray = xt::pyarray<T>;
-
 using namespace hg;
 namespace py = pybind11;
 
@@ -48,7 +46,11 @@ struct def_binary_partition_tree_average_linkage {
     void def(pybind11::module &m, const char *doc) {
         m.def("_binary_partition_tree_average_linkage",
               [](const hg::ugraph &graph, pyarray<T> &edge_weights, pyarray<T> &edge_weight_weights) {
-                  auto res = binary_partition_tree_average_linkage(graph, edge_weights, edge_weight_weights);
+                  auto res = without_gil([&] {
+                      return binary_partition_tree_average_linkage(graph,
+                                                                   pyarray_view(edge_weights),
+                                                                   pyarray_view(edge_weight_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -64,7 +66,12 @@ struct def_binary_partition_tree_exponential_linkage {
     void def(pybind11::module &m, const char *doc) {
         m.def("_binary_partition_tree_exponential_linkage",
               [](const hg::ugraph &graph, pyarray<T> &edge_weights, T alpha, pyarray<T> &edge_weight_weights) {
-                  auto res = binary_partition_tree_exponential_linkage(graph, edge_weights, alpha, edge_weight_weights);
+                  auto res = without_gil([&] {
+                      return binary_partition_tree_exponential_linkage(graph,
+                                                                       pyarray_view(edge_weights),
+                                                                       alpha,
+                                                                       pyarray_view(edge_weight_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -72,6 +79,27 @@ struct def_binary_partition_tree_exponential_linkage {
               py::arg("edge_weights"),
               py::arg("alpha"),
               py::arg("edge_weight_weights"));
+
+        m.def("_binary_partition_tree_exponential_linkage_multi",
+              [](const hg::ugraph &graph, pyarray<T> &edge_weights, pyarray<T> &alphas,
+                 pyarray<T> &edge_weight_weights) {
+                  auto res = without_gil([&] {
+                      return binary_partition_tree_exponential_linkage_multi(graph,
+                                                                             pyarray_view(edge_weights),
+                                                                             pyarray_view(alphas),
+                                                                             pyarray_view(edge_weight_weights));
+                  });
+                  py::list result;
+                  for (auto &r: res) {
+                      result.append(py::make_tuple(std::move(r.tree), std::move(r.altitudes)));
+                  }
+                  return result;
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("alphas"),
+              py::arg("edge_weight_weights"));
     }
 };
 
@@ -84,8 +112,12 @@ struct def_binary_partition_tree_ward_linkage {
                  const pyarray<T> &vertex_centroids,
                  const pyarray<T> &vertex_sizes,
                  const std::string &altitude_correction) {
-                  auto res = binary_partition_tree_ward_linkage(graph, vertex_centroids, vertex_sizes,
+                  auto res = without_gil([&] {
+                      return binary_partition_tree_ward_linkage(graph,
+                                                                pyarray_view(vertex_centroids),
+                                                                pyarray_view(vertex_sizes),
                                                                 altitude_correction);
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -106,7 +138,7 @@ struct def_binary_partition_tree_custom_linkage {
                  py::object weighting_function) {
                   //using new_neighbours_type = const std::vector<binary_partition_tree_internal::new_neighbour<T> >;
                   auto weighter = [&weighting_function](
-                          const undirected_graph<hg::undirected_graph_internal::hash_setS> &g,
+                          const binary_partition_tree_internal::region_adjacency_graph_view &g,
                           index_t fusion_edge_index,
                           index_t new_region,
                           index_t merged_region1,
@@ -127,13 +159,43 @@ struct def_binary_partition_tree_custom_linkage {
     }
 };
 
+struct def_binary_partition_tree_compiled_linkage {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_binary_partition_tree_compiled_linkage",
+              [](const hg::ugraph &graph,
+                 pyarray<T> &edge_weights,
+                 std::uintptr_t callback_address,
+                 std::uintptr_t user_data_address) {
+                  if (callback_address == 0) {
+                      throw std::runtime_error("Invalid linkage callback address.");
+                  }
+                  auto callback = reinterpret_cast<hg::bpt_linkage_callback_t>(callback_address);
+                  auto user_data = reinterpret_cast<void *>(user_data_address);
+                  auto res = without_gil([&] {
+                      return hg::binary_partition_tree_compiled_linkage(graph, pyarray_view(edge_weights), callback,
+                                                                        user_data);
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("callback_address"),
+              py::arg("user_data_address"));
+    }
+};
+
 struct def_binary_partition_tree_complete_linkage {
     template<typename T>
     static
     void def(pybind11::module &m, const char *doc) {
         m.def("_binary_partition_tree_complete_linkage",
               [](const hg::ugraph &graph, pyarray<T> &edge_weights) {
-                  auto res = hg::binary_partition_tree_complete_linkage(graph, edge_weights);
+                  auto res = without_gil([&] {
+                      return hg::binary_partition_tree_complete_linkage(graph, pyarray_view(edge_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -142,9 +204,26 @@ struct def_binary_partition_tree_complete_linkage {
     }
 };
 
+void def_region_adjacency_graph_view(pybind11::module &m) {
+    using graph_t = binary_partition_tree_internal::region_adjacency_graph_view;
+    auto c = py::class_<graph_t>(m, "BinaryPartitionTreeRegionGraph",
+                                 "Read only view of the current region adjacency graph of a binary partition tree, "
+                                 "given to the weighting function of :func:`~higra.binary_partition_tree`. It is only "
+                                 "valid during the call of the weighting function.");
+    add_incidence_graph_concept<graph_t>(c);
+    add_bidirectionnal_graph_concept<graph_t>(c);
+    add_adjacency_graph_concept<graph_t>(c);
+    add_vertex_list_graph_concept<graph_t>(c);
+    add_edge_list_graph_concept<graph_t>(c);
+    add_edge_accessor_graph_concept<graph_t>(c);
+    add_edge_index_graph_concept<graph_t>(c);
+}
+
 void py_init_binary_partition_tree(pybind11::module &m) {
     xt::import_numpy();
 
+    def_region_adjacency_graph_view(m);
+
     add_type_overloads<def_binary_partition_tree_ward_linkage, HG_TEMPLATE_FLOAT_TYPES>(m, "");
     add_type_overloads<def_binary_partition_tree_average_linkage, HG_TEMPLATE_FLOAT_TYPES>(m, "");
     add_type_overloads<def_binary_partition_tree_complete_linkage, HG_TEMPLATE_FLOAT_TYPES>(m, "");
@@ -154,4 +233,6 @@ void py_init_binary_partition_tree(pybind11::module &m) {
     def_new_neighbour<double>(m);
     add_type_overloads<def_binary_partition_tree_custom_linkage, HG_TEMPLATE_FLOAT_TYPES>
             (m, "Compute a binary partition tree with the given linkage distance.");
+    add_type_overloads<def_binary_partition_tree_compiled_linkage, HG_TEMPLATE_FLOAT_TYPES>
+            (m, "Compute a binary partition tree with the given compiled linkage callback.");
 }
@@ -27,7 +27,9 @@ struct def_min_tree {
         c.def("_component_tree_min_tree",
               [](const graph_t &graph,
                  const pyarray<value_t> &vertex_weights) {
-                  auto res = hg::component_tree_min_tree(graph, vertex_weights);
+                  auto res = without_gil([&] {
+                      return hg::component_tree_min_tree(graph, pyarray_view(vertex_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -44,7 +46,9 @@ struct def_max_tree {
         c.def("_component_tree_max_tree",
               [](const graph_t &graph,
                  const pyarray<value_t> &vertex_weights) {
-                  auto res = hg::component_tree_max_tree(graph, vertex_weights);
+                  auto res = without_gil([&] {
+                      return hg::component_tree_max_tree(graph, pyarray_view(vertex_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -53,6 +57,75 @@ struct def_max_tree {
     }
 };
 
+template<typename graph_t>
+struct def_attribute_filters {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_area_opening",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 double threshold) {
+                  return without_gil([&] {
+                      return hg::area_opening(graph, pyarray_view(vertex_weights), threshold);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("threshold"));
+        c.def("_area_closing",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 double threshold) {
+                  return without_gil([&] {
+                      return hg::area_closing(graph, pyarray_view(vertex_weights), threshold);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("threshold"));
+        c.def("_volume_opening",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 double threshold) {
+                  return without_gil([&] {
+                      return hg::volume_opening(graph, pyarray_view(vertex_weights), threshold);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("threshold"));
+        c.def("_volume_closing",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 double threshold) {
+                  return without_gil([&] {
+                      return hg::volume_closing(graph, pyarray_view(vertex_weights), threshold);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("threshold"));
+        c.def("_area_pattern_spectrum",
+              [](const graph_t &graph,
+                 const pyarray<value_t> &vertex_weights,
+                 const pyarray<double> &area_thresholds) {
+                  return without_gil([&] {
+                      return hg::area_pattern_spectrum(graph, pyarray_view(vertex_weights),
+                                                       pyarray_view(area_thresholds));
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("area_thresholds"));
+    }
+};
+
 
 void py_init_component_tree(pybind11::module &m) {
     xt::import_numpy();
@@ -70,6 +143,12 @@ void py_init_component_tree(pybind11::module &m) {
     add_type_overloads<def_max_tree<hg::regular_grid_graph_3d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
     add_type_overloads<def_max_tree<hg::regular_grid_graph_4d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 
+    add_type_overloads<def_attribute_filters<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_attribute_filters<hg::regular_grid_graph_1d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_attribute_filters<hg::regular_grid_graph_2d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_attribute_filters<hg::regular_grid_graph_3d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_attribute_filters<hg::regular_grid_graph_4d>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
 }
 
 
@@ -0,0 +1,67 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_constrained_connectivity_hierarchy.hpp"
+#include "higra/hierarchy/constrained_connectivity_hierarchy.hpp"
+#include "../py_common.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+namespace py = pybind11;
+
+template<typename graph_t>
+struct def_constrained_connectivity_hierarchy_alpha_omega {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_constrained_connectivity_hierarchy_alpha_omega",
+              [](const graph_t &graph, const pyarray<value_t> &vertex_weights) {
+                  auto res = without_gil([&] {
+                      return hg::constrained_connectivity_hierarchy_alpha_omega(graph, pyarray_view(vertex_weights));
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"));
+    }
+};
+
+template<typename graph_t>
+struct def_constrained_connectivity_hierarchy_strong_connection {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_constrained_connectivity_hierarchy_strong_connection",
+              [](const graph_t &graph, const pyarray<value_t> &edge_weights) {
+                  auto res = without_gil([&] {
+                      return hg::constrained_connectivity_hierarchy_strong_connection(graph,
+                                                                                      pyarray_view(edge_weights));
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"));
+    }
+};
+
+void py_init_constrained_connectivity_hierarchy(pybind11::module &m) {
+    xt::import_numpy();
+
+    add_type_overloads<def_constrained_connectivity_hierarchy_alpha_omega<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>
+            (m, "Alpha-omega constrained connectivity hierarchy of a vertex weighted graph.");
+
+    add_type_overloads<def_constrained_connectivity_hierarchy_strong_connection<hg::ugraph>,
+            HG_TEMPLATE_NUMERIC_TYPES>
+            (m, "Strongly constrained connectivity hierarchy of an edge weighted graph.");
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_hdbscan.hpp"
+#include "../py_common.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include "higra/hierarchy/hdbscan.hpp"
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+namespace py = pybind11;
+
+struct def_hdbscan_hierarchy {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_hdbscan_hierarchy",
+              [](const hg::ugraph &graph,
+                 const pyarray<T> &edge_weights,
+                 const hg::index_t min_samples,
+                 const hg::index_t min_cluster_size) {
+                  if (min_cluster_size < 2) {
+                      throw std::runtime_error("hdbscan_hierarchy: min_cluster_size must be greater than or equal to 2.");
+                  }
+                  auto res = without_gil([&] {
+                      return hg::hdbscan_hierarchy(graph, pyarray_view(edge_weights), min_samples, min_cluster_size);
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes), std::move(res.stability));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("min_samples"),
+              py::arg("min_cluster_size"));
+    }
+};
+
+struct def_condense_hierarchy {
+    template<typename T>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_condense_hierarchy",
+              [](const hg::tree &tree,
+                 const pyarray<T> &altitudes,
+                 const hg::index_t min_cluster_size) {
+                  if (min_cluster_size < 2) {
+                      throw std::runtime_error("condense_hierarchy: min_cluster_size must be greater than or equal to 2.");
+                  }
+                  auto res = without_gil([&] {
+                      return hg::condense_hierarchy(tree, pyarray_view(altitudes), min_cluster_size);
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes), std::move(res.stability));
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("altitudes"),
+              py::arg("min_cluster_size"));
+    }
+};
+
+void py_init_hdbscan(pybind11::module &m) {
+    xt::import_numpy();
+    add_type_overloads<def_hdbscan_hierarchy, HG_TEMPLATE_FLOAT_TYPES>(m, "");
+    add_type_overloads<def_condense_hierarchy, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+}
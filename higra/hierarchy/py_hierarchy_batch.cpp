@@ -0,0 +1,232 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_hierarchy_batch.hpp"
+#include "higra/hierarchy/hierarchy_batch.hpp"
+#include "../py_common.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include "xtensor-python/pytensor.hpp"
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+namespace py = pybind11;
+
+template<typename value_t>
+py::tuple batch_to_tuple(hg::tree_batch<value_t> &&batch) {
+    return py::make_tuple(std::move(batch.parents), std::move(batch.altitudes), std::move(batch.offsets));
+}
+
+hg::watershed_attribute watershed_attribute_from_name(const std::string &name) {
+    if (name == "area") {
+        return hg::watershed_attribute::area;
+    }
+    if (name == "volume") {
+        return hg::watershed_attribute::volume;
+    }
+    if (name == "dynamics") {
+        return hg::watershed_attribute::dynamics;
+    }
+    throw std::runtime_error("Unknown watershed attribute: " + name);
+}
+
+hg::hierarchy_distance hierarchy_distance_from_name(const std::string &name) {
+    if (name == "L1") {
+        return hg::hierarchy_distance::L1;
+    }
+    if (name == "L2") {
+        return hg::hierarchy_distance::L2;
+    }
+    if (name == "correlation") {
+        return hg::hierarchy_distance::correlation;
+    }
+    throw std::runtime_error("Unknown hierarchy distance: " + name);
+}
+
+struct def_weight_graph_batch {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_weight_graph_batch",
+              [](const hg::ugraph &graph, const pyarray<value_t> &vertex_weights, hg::weight_functions weight) {
+                  return without_gil([&] {
+                      return hg::weight_graph_batch(graph, pyarray_view(vertex_weights), weight);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("vertex_weights"),
+              py::arg("weight_function"));
+    }
+};
+
+struct def_bpt_canonical_batch {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_bpt_canonical_batch",
+              [](const hg::ugraph &graph, const pyarray<value_t> &edge_weights) {
+                  auto batch = without_gil([&] {
+                      return hg::bpt_canonical_batch(graph, pyarray_view(edge_weights));
+                  });
+                  return batch_to_tuple(std::move(batch));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"));
+    }
+};
+
+struct def_watershed_hierarchy_batch {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_watershed_hierarchy_batch",
+              [](const hg::ugraph &graph,
+                 const pyarray<value_t> &edge_weights,
+                 const std::string &attribute,
+                 const pyarray<double> &vertex_area) {
+                  auto watershed_attribute = watershed_attribute_from_name(attribute);
+                  auto batch = without_gil([&] {
+                      return hg::watershed_hierarchy_batch(graph, pyarray_view(edge_weights), watershed_attribute,
+                                                           pyarray_view(vertex_area));
+                  });
+                  return batch_to_tuple(std::move(batch));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("attribute"),
+              py::arg("vertex_area"));
+    }
+};
+
+struct def_saliency_map_batch {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_saliency_map_batch",
+              [](const hg::ugraph &graph,
+                 const pyarray<hg::index_t> &parents,
+                 const pyarray<value_t> &altitudes,
+                 const pyarray<hg::index_t> &offsets) {
+                  return without_gil([&] {
+                      auto batch = hg::make_tree_batch(pyarray_view(parents), pyarray_view(altitudes),
+                                                       pyarray_view(offsets));
+                      return hg::saliency_map_batch(graph, batch);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("parents"),
+              py::arg("altitudes"),
+              py::arg("offsets"));
+    }
+};
+
+struct def_hierarchy_distance_matrix_batch {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_hierarchy_distance_matrix_batch",
+              [](const hg::ugraph &graph,
+                 const pyarray<hg::index_t> &parents,
+                 const pyarray<value_t> &altitudes,
+                 const pyarray<hg::index_t> &offsets,
+                 const std::string &metric) {
+                  auto distance = hierarchy_distance_from_name(metric);
+                  return without_gil([&] {
+                      auto batch = hg::make_tree_batch(pyarray_view(parents), pyarray_view(altitudes),
+                                                       pyarray_view(offsets));
+                      return hg::hierarchy_distance_matrix_batch(graph, batch, distance);
+                  });
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("parents"),
+              py::arg("altitudes"),
+              py::arg("offsets"),
+              py::arg("metric"));
+    }
+};
+
+struct def_tree_batch_attribute {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_tree_batch_attribute",
+              [](const pyarray<hg::index_t> &parents,
+                 const pyarray<value_t> &altitudes,
+                 const pyarray<hg::index_t> &offsets,
+                 const std::string &attribute) -> py::object {
+                  auto batch = without_gil([&] {
+                      return hg::make_tree_batch(pyarray_view(parents), pyarray_view(altitudes),
+                                                 pyarray_view(offsets));
+                  });
+                  if (attribute == "area") {
+                      return py::cast(without_gil([&] {
+                          return hg::tree_batch_attribute(batch, [](const hg::tree &t, const auto &) {
+                              return hg::attribute_area(t);
+                          });
+                      }));
+                  }
+                  if (attribute == "volume") {
+                      return py::cast(without_gil([&] {
+                          return hg::tree_batch_attribute(batch, [](const hg::tree &t, const auto &alt) {
+                              return hg::attribute_volume(t, alt, hg::attribute_area(t));
+                          });
+                      }));
+                  }
+                  if (attribute == "height") {
+                      return py::cast(without_gil([&] {
+                          return hg::tree_batch_attribute(batch, [](const hg::tree &t, const auto &alt) {
+                              return hg::attribute_height(t, alt, true);
+                          });
+                      }));
+                  }
+                  if (attribute == "dynamics") {
+                      return py::cast(without_gil([&] {
+                          return hg::tree_batch_attribute(batch, [](const hg::tree &t, const auto &alt) {
+                              return hg::attribute_dynamics(t, alt, true);
+                          });
+                      }));
+                  }
+                  if (attribute == "depth") {
+                      return py::cast(without_gil([&] {
+                          return hg::tree_batch_attribute(batch, [](const hg::tree &t, const auto &) {
+                              return hg::attribute_depth(t);
+                          });
+                      }));
+                  }
+                  throw std::runtime_error("Unknown attribute: " + attribute);
+              },
+              doc,
+              py::arg("parents"),
+              py::arg("altitudes"),
+              py::arg("offsets"),
+              py::arg("attribute"));
+    }
+};
+
+void py_init_hierarchy_batch(pybind11::module &m) {
+    xt::import_numpy();
+    add_type_overloads<def_weight_graph_batch, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Weights of the edges of a graph for each image of a stack of images.");
+    add_type_overloads<def_bpt_canonical_batch, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Canonical binary partition trees of a graph for a stack of edge weights.");
+    add_type_overloads<def_watershed_hierarchy_batch, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Watershed hierarchies of a graph for a stack of edge weights.");
+    add_type_overloads<def_saliency_map_batch, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Saliency maps of a batch of trees on a graph.");
+    add_type_overloads<def_hierarchy_distance_matrix_batch, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Pairwise distances between the saliency maps of a batch of trees on a graph.");
+    add_type_overloads<def_tree_batch_attribute, HG_TEMPLATE_NUMERIC_TYPES>(
+            m, "Attribute of the nodes of a batch of trees.");
+}
@@ -11,6 +11,8 @@
 #include "py_hierarchy_core.hpp"
 #include "../py_common.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/hierarchy/dynamic_bpt.hpp"
+#include "higra/hierarchy/flat_zone_collapse.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
 #include "pybind11/functional.h"
@@ -26,7 +28,9 @@ struct def_quasi_flat_zone_hierarchy {
     static
     void def(C &m, const char *doc) {
         m.def("_quasi_flat_zone_hierarchy", [](const graph_t &graph, const pyarray<value_t> &edge_weights) {
-                  auto res = hg::quasi_flat_zone_hierarchy(graph, edge_weights);
+                  auto res = without_gil([&] {
+                      return hg::quasi_flat_zone_hierarchy(graph, pyarray_view(edge_weights));
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
@@ -36,6 +40,51 @@ struct def_quasi_flat_zone_hierarchy {
     }
 };
 
+template<typename graph_t>
+struct def_bpt_canonical_below {
+    template<typename value_t, typename C>
+    static
+    void def(C &m, const char *doc) {
+        m.def("_bpt_canonical_below", [](const graph_t &graph, const pyarray<value_t> &edge_weights, double altitude) {
+                  auto res = without_gil([&] {
+                      return hg::bpt_canonical_below(graph, pyarray_view(edge_weights), altitude);
+                  });
+                  return py::make_tuple(std::move(res.parents),
+                                        std::move(res.altitudes),
+                                        std::move(res.mst_edge_map),
+                                        std::move(res.supervertex_map),
+                                        std::move(res.roots));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("altitude")
+        );
+    }
+};
+
+template<typename graph_t>
+struct def_bpt_canonical_above {
+    template<typename value_t, typename C>
+    static
+    void def(C &m, const char *doc) {
+        m.def("_bpt_canonical_above", [](const graph_t &graph, const pyarray<value_t> &edge_weights, double altitude) {
+                  auto res = without_gil([&] {
+                      return hg::bpt_canonical_above(graph, pyarray_view(edge_weights), altitude);
+                  });
+                  return py::make_tuple(std::move(res.tree),
+                                        std::move(res.altitudes),
+                                        std::move(res.mst_edge_map),
+                                        std::move(res.supervertex_map));
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"),
+              py::arg("altitude")
+        );
+    }
+};
+
 template<typename M>
 void add_simplified_tree(M &m) {
     using class_t = hg::remapped_tree<hg::tree, hg::array_1d<hg::index_t>>;
@@ -51,6 +100,30 @@ void add_simplified_tree(M &m) {
 
 }
 
+struct def_expand_collapsed_hierarchy {
+    template<typename value_t, typename C>
+    static
+    void def(C &m, const char *doc) {
+        m.def("_expand_collapsed_hierarchy", [](const pyarray<hg::index_t> &vertex_map,
+                                                const hg::tree &tree,
+                                                const pyarray<value_t> &altitudes,
+                                                double region_altitude) {
+                  hg::array_1d<hg::index_t> vertex_map_copy = vertex_map;
+                  auto res = without_gil([&] {
+                      return hg::expand_collapsed_hierarchy(vertex_map_copy, tree, pyarray_view(altitudes),
+                                                            region_altitude);
+                  });
+                  return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
+              },
+              doc,
+              py::arg("vertex_map"),
+              py::arg("tree"),
+              py::arg("altitudes"),
+              py::arg("region_altitude")
+        );
+    }
+};
+
 void py_init_hierarchy_core(pybind11::module &m) {
     xt::import_numpy();
 
@@ -59,24 +132,37 @@ void py_init_hierarchy_core(pybind11::module &m) {
                                const xt::pytensor<hg::index_t, 1> &sorted_edge_indices,
                                const hg::index_t num_vertices) {
         hg_assert(num_vertices >= 0, "Number of vertices must be a positive number.");
-        hg_assert((xt::amin)(sources)() >= 0, "Source vertex index cannot be negative.");
-        hg_assert((xt::amin)(targets)() >= 0, "Target vertex index cannot be negative.");
-        hg_assert((xt::amin)(sorted_edge_indices)() >= 0, "Edge index cannot be negative.");
-        hg_assert((xt::amax)(sources)() < num_vertices,
-                  "Source vertex index must be less than the number of vertices.");
-        hg_assert((xt::amax)(targets)() < num_vertices,
-                  "Target vertex index must be less than the number of vertices.");
-        hg_assert((xt::amax)(sorted_edge_indices)() < (hg::index_t) sorted_edge_indices.size(),
-                  "Edge index must be smaller than the number of edges in the graph/tree.");
-        auto res = hg::hierarchy_core_internal::bpt_canonical_from_sorted_edges(sources, targets, sorted_edge_indices,
+        hg_assert_content((xt::amin)(sources)() >= 0, "Source vertex index cannot be negative.");
+        hg_assert_content((xt::amin)(targets)() >= 0, "Target vertex index cannot be negative.");
+        hg_assert_content((xt::amin)(sorted_edge_indices)() >= 0, "Edge index cannot be negative.");
+        hg_assert_content((xt::amax)(sources)() < num_vertices,
+                          "Source vertex index must be less than the number of vertices.");
+        hg_assert_content((xt::amax)(targets)() < num_vertices,
+                          "Target vertex index must be less than the number of vertices.");
+        hg_assert_content((xt::amax)(sorted_edge_indices)() < (hg::index_t) sorted_edge_indices.size(),
+                          "Edge index must be smaller than the number of edges in the graph/tree.");
+        auto res = without_gil([&] {
+            if ((hg::index_t) sources.size() == num_vertices - 1) {
+                return hg::hierarchy_core_internal::bpt_canonical_from_sorted_tree_edges(pyarray_view(sources),
+                                                                                         pyarray_view(targets),
+                                                                                         pyarray_view(
+                                                                                                 sorted_edge_indices),
+                                                                                         num_vertices);
+            }
+            return hg::hierarchy_core_internal::bpt_canonical_from_sorted_edges(pyarray_view(sources),
+                                                                                pyarray_view(targets),
+                                                                                pyarray_view(sorted_edge_indices),
                                                                                 num_vertices);
+        });
         return py::make_tuple(std::move(res.first), std::move(res.second));
     });
 
     add_simplified_tree(m);
     m.def("_simplify_tree",
           [](const hg::tree &t, pyarray<bool> &criterion, bool process_leaves) {
-              return hg::simplify_tree(t, criterion, process_leaves);
+              return without_gil([&] {
+                  return hg::simplify_tree(t, pyarray_view(criterion), process_leaves);
+              });
           },
           "",
           py::arg("tree"),
@@ -88,11 +174,119 @@ void py_init_hierarchy_core(pybind11::module &m) {
              "Compute the quasi flat zones hierarchy of the given weighted graph."
             );
 
+    add_type_overloads<def_bpt_canonical_below<hg::ugraph>, HG_TEMPLATE_SNUMERIC_TYPES>
+            (m,
+             "Lower part of the canonical binary partition tree of the given weighted graph below an altitude."
+            );
+
+    add_type_overloads<def_bpt_canonical_above<hg::ugraph>, HG_TEMPLATE_SNUMERIC_TYPES>
+            (m,
+             "Upper part of the canonical binary partition tree of the given weighted graph above an altitude."
+            );
+
+    add_type_overloads<def_expand_collapsed_hierarchy, HG_TEMPLATE_SNUMERIC_TYPES>
+            (m,
+             "Expand the leaves of a hierarchy on the regions of a partition of the vertices of a graph to the "
+             "vertices of the graph."
+            );
+
     m.def("_tree_2_binary_tree",
           [](const hg::tree &t) {
-              return hg::tree_2_binary_tree(t);
+              return without_gil([&] {
+                  return hg::tree_2_binary_tree(t);
+              });
           },
           "",
           py::arg("tree")
     );
-}
\ No newline at end of file
+
+    using dynamic_bpt_t = hg::dynamic_bpt<double>;
+    auto c = py::class_<dynamic_bpt_t>(
+            m, "DynamicBPT",
+            "Minimum spanning forest of an edge weighted graph maintained under edge insertions, edge removals and "
+            "edge weight modifications, from which the canonical binary partition tree of the graph is obtained "
+            "without processing all the graph edges (for example in interactive segmentation, where the edge "
+            "weights are locally modified by the user), or built online from streams of vertices and edges (for "
+            "example to maintain the single linkage hierarchy of the last points received from a sensor, see "
+            ":meth:`~higra.DynamicBPT.keep_last_vertices`).\n\n"
+            "Decreasing the weight of an edge or inserting an edge costs the length of the forest path between the "
+            "edge extremities; increasing the weight of a forest edge or removing it costs the number of edges "
+            "incident to the smallest of the two trees it separates. The binary partition tree of the forest is "
+            "maintained along and locally repaired, on the ancestors of the modified forest edges, after each "
+            "modification: it is identical to the one of :func:`~higra.bpt_canonical` on the current graph.\n\n"
+            "The edges of the graph given at construction keep their indices, inserted edges get the following "
+            "indices, and the indices of removed edges are not reused. Similarly, added vertices get the indices "
+            "following the existing ones, the indices of removed vertices are not reused, and the leaves of the "
+            "binary partition tree are the active vertices in increasing order.");
+
+    c.def(py::init<hg::index_t>(),
+          "Empty minimum spanning forest on the given number of vertices.\n\n"
+          ":param num_vertices: initial number of vertices",
+          py::arg("num_vertices") = 0);
+
+    c.def(py::init([](const hg::ugraph &graph, const pyarray<double> &edge_weights) {
+              return new dynamic_bpt_t(graph, edge_weights);
+          }),
+          "Minimum spanning forest of the given edge weighted graph.\n\n"
+          ":param graph: input graph\n"
+          ":param edge_weights: edge weights of the input graph",
+          py::arg("graph"),
+          py::arg("edge_weights"));
+    c.def("insert_edge", &dynamic_bpt_t::insert_edge,
+          "Insert the edge {source, target} with the given weight and return its index.",
+          py::arg("source"),
+          py::arg("target"),
+          py::arg("weight"));
+    c.def("insert_edges",
+          [](dynamic_bpt_t &d,
+             const pyarray<hg::index_t> &sources,
+             const pyarray<hg::index_t> &targets,
+             const pyarray<double> &weights) {
+              return d.insert_edges(sources, targets, weights);
+          },
+          "Insert the edges {sources[i], targets[i]} with the weights weights[i] and return the index of the first "
+          "new edge.",
+          py::arg("sources"),
+          py::arg("targets"),
+          py::arg("weights"));
+    c.def("add_vertices", &dynamic_bpt_t::add_vertices,
+          "Add the given number of isolated vertices and return the index of the first new vertex.",
+          py::arg("num_vertices"));
+    c.def("remove_vertex", &dynamic_bpt_t::remove_vertex,
+          "Remove the given vertex and its incident edges.",
+          py::arg("vertex_index"));
+    c.def("keep_last_vertices", &dynamic_bpt_t::keep_last_vertices,
+          "Sliding window: remove the oldest active vertices (the ones with the smallest indices) such that at most "
+          "window_size vertices remain.",
+          py::arg("window_size"));
+    c.def("num_active_vertices", &dynamic_bpt_t::num_active_vertices,
+          "Number of vertices of the graph (without the removed vertices).");
+    c.def("active_vertices", &dynamic_bpt_t::active_vertices,
+          "Indices of the active vertices in increasing order: the i-th leaf of the binary partition tree is the "
+          "i-th active vertex.");
+    c.def("remove_edge", &dynamic_bpt_t::remove_edge,
+          "Remove the given edge.",
+          py::arg("edge_index"));
+    c.def("set_edge_weight", &dynamic_bpt_t::set_edge_weight,
+          "Set the weight of the given edge.",
+          py::arg("edge_index"),
+          py::arg("weight"));
+    c.def("edge_weight", &dynamic_bpt_t::edge_weight,
+          "Weight of the given edge.",
+          py::arg("edge_index"));
+    c.def("is_mst_edge", &dynamic_bpt_t::is_mst_edge,
+          "True if the given edge belongs to the minimum spanning forest.",
+          py::arg("edge_index"));
+    c.def("num_mst_edges", &dynamic_bpt_t::num_mst_edges,
+          "Number of edges of the minimum spanning forest.");
+    c.def("bpt",
+          [](const dynamic_bpt_t &d) {
+              auto res = without_gil([&] {
+                  return d.bpt();
+              });
+              return py::make_tuple(std::move(res.tree), std::move(res.altitudes), std::move(res.mst_edge_map));
+          },
+          "Canonical binary partition tree of the current graph (which must be connected).\n\n"
+          ":return: a tree, its node altitudes, and the indices of the edges of the minimum spanning tree "
+          "(the i-th edge of the minimum spanning tree corresponds to the (i + num_leaves)-th node of the tree)");
+}
@@ -0,0 +1,43 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_random_hierarchy.hpp"
+#include "higra/hierarchy/random_hierarchy.hpp"
+#include "../py_common.hpp"
+#include "xtensor-python/pytensor.hpp"
+
+namespace py = pybind11;
+
+void py_init_random_hierarchy(pybind11::module &m) {
+    xt::import_numpy();
+
+    m.def("_random_binary_partition_tree",
+          [](hg::index_t num_leaves, double asymmetry_probability, unsigned int seed) {
+              return without_gil([&] {
+                  return hg::random_binary_partition_tree(num_leaves, asymmetry_probability, seed);
+              });
+          },
+          "Random binary partition tree with a controlled amount of asymmetry/unbalancedness.",
+          py::arg("num_leaves"),
+          py::arg("asymmetry_probability"),
+          py::arg("seed"));
+
+    m.def("_random_binary_partition_trees",
+          [](hg::index_t num_trees, hg::index_t num_leaves, double asymmetry_probability, unsigned int seed) {
+              return without_gil([&] {
+                  return hg::random_binary_partition_trees(num_trees, num_leaves, asymmetry_probability, seed);
+              });
+          },
+          "Parents arrays of several random binary partition trees generated in parallel.",
+          py::arg("num_trees"),
+          py::arg("num_leaves"),
+          py::arg("asymmetry_probability"),
+          py::arg("seed"));
+}
@@ -13,12 +13,31 @@
 #include "../py_common.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
+#include "xtensor/xmanipulation.hpp"
 
 template<typename T>
 using pyarray = xt::pyarray<T>;
 
 namespace py = pybind11;
 
+/**
+ * Watershed hierarchy from the attribute values (converted to attribute_t) of the nodes of the canonical binary
+ * partition tree of the graph.
+ */
+template<typename attribute_t, typename graph_t, typename bpt_t>
+py::tuple watershed_hierarchy_from_bpt_attribute(const graph_t &graph, const bpt_t &bptc, const py::array &attribute) {
+    auto attr = attribute.cast<pyarray<attribute_t>>();
+    auto res = without_gil([&] {
+        return hg::watershed_hierarchy_internal::watershed_hierarchy_from_bpt_attribute(
+                graph, bptc.tree, bptc.altitudes, bptc.mst_edge_map, pyarray_view(attr));
+    });
+    return py::make_tuple(
+            std::move(res.tree),
+            std::move(res.altitudes),
+            std::move(res.mst_edge_map)
+    );
+}
+
 template<typename graph_t>
 struct def_watershed_hierarchy_by_attribute {
     template<typename value_t, typename C>
@@ -27,15 +46,26 @@ struct def_watershed_hierarchy_by_attribute {
         c.def("_watershed_hierarchy_by_attribute",
               [](const graph_t &graph,
                  const pyarray<value_t> &edge_weights,
-                      // FIXME can we do better for return type ?
-                 const std::function<pyarray<double>(const hg::tree &,
-                                                     const hg::array_1d<value_t> &)> &attribute_functor) {
-                  auto res = hg::watershed_hierarchy_by_attribute(graph, edge_weights, attribute_functor);
-                  return py::make_tuple(
-                          std::move(res.tree),
-                          std::move(res.altitudes),
-                          std::move(res.mst_edge_map)
-                  );
+                 const py::function &attribute_functor) {
+                  auto bptc = without_gil([&] {
+                      return hg::bpt_canonical(graph, pyarray_view(edge_weights));
+                  });
+                  py::array attribute = py::array::ensure(attribute_functor(bptc.tree, bptc.altitudes));
+                  hg_assert(attribute, "The attribute functor must return an array.");
+                  // the attribute keeps its type when it is the type of the edge weights, uint32 or int64 (the
+                  // altitudes of the result then have this type), other integral types are converted to int64 and
+                  // floating point types to double
+                  if (py::isinstance<py::array_t<value_t>>(attribute)) {
+                      return watershed_hierarchy_from_bpt_attribute<value_t>(graph, bptc, attribute);
+                  }
+                  if (py::isinstance<py::array_t<uint32_t>>(attribute)) {
+                      return watershed_hierarchy_from_bpt_attribute<uint32_t>(graph, bptc, attribute);
+                  }
+                  auto kind = attribute.dtype().kind();
+                  if (kind == 'i' || kind == 'u' || kind == 'b') {
+                      return watershed_hierarchy_from_bpt_attribute<int64_t>(graph, bptc, attribute);
+                  }
+                  return watershed_hierarchy_from_bpt_attribute<double>(graph, bptc, attribute);
               },
               doc,
               py::arg("graph"),
@@ -53,7 +83,10 @@ struct def_watershed_hierarchy_by_minima_ordering {
               [](const graph_t &graph,
                  const pyarray<value_t> &edge_weights,
                  const pyarray<size_t> &minima_ranks) {
-                  auto res = hg::watershed_hierarchy_by_minima_ordering(graph, edge_weights, minima_ranks);
+                  auto res = without_gil([&] {
+                      return hg::watershed_hierarchy_by_minima_ordering(graph, pyarray_view(edge_weights),
+                                                                        pyarray_view(minima_ranks));
+                  });
                   return py::make_tuple(
                           std::move(res.tree),
                           std::move(res.altitudes),
@@ -67,12 +100,95 @@ struct def_watershed_hierarchy_by_minima_ordering {
     }
 };
 
+template<typename graph_t>
+struct def_waterfall_hierarchy {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_waterfall_hierarchy",
+              [](const graph_t &graph, const pyarray<value_t> &edge_weights) {
+                  auto res = without_gil([&] {
+                      return hg::waterfall_hierarchy(graph, pyarray_view(edge_weights));
+                  });
+                  return py::make_tuple(
+                          std::move(res.tree),
+                          std::move(res.altitudes),
+                          std::move(res.mst_edge_map)
+                  );
+              },
+              doc,
+              py::arg("graph"),
+              py::arg("edge_weights"));
+    }
+};
+
+/**
+ * Watershed hierarchy by area engine and the graph it is bound to (used to link the concepts of the results).
+ */
+struct py_watershed_hierarchy_by_area_engine {
+    py_watershed_hierarchy_by_area_engine(const py::object &graph, const pyarray<double> &vertex_area) :
+            graph(graph),
+            engine(graph.cast<const hg::ugraph &>(), hg::array_1d<double>(xt::flatten(vertex_area))) {
+    }
+
+    py::object graph;
+    hg::watershed_hierarchy_by_area_engine engine;
+};
+
+struct def_watershed_hierarchy_by_area_engine_compute {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_compute",
+              [](py_watershed_hierarchy_by_area_engine &e, const pyarray<value_t> &edge_weights) {
+                  without_gil([&] {
+                      e.engine.compute(pyarray_view(edge_weights));
+                  });
+                  return py::make_tuple(
+                          hg::tree(e.engine.parents()),
+                          e.engine.altitudes(),
+                          e.engine.mst_edge_map());
+              },
+              doc,
+              py::arg("edge_weights"));
+    }
+};
+
 void py_init_watershed_hierarchy(pybind11::module &m) {
     xt::import_numpy();
 
     add_type_overloads<def_watershed_hierarchy_by_attribute<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 
     add_type_overloads<def_watershed_hierarchy_by_minima_ordering<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    add_type_overloads<def_waterfall_hierarchy<hg::ugraph>, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    auto c = py::class_<py_watershed_hierarchy_by_area_engine>(
+            m, "WatershedHierarchyByAreaEngine",
+            "Repeated computation of the watershed hierarchy by area on a fixed graph (for example the "
+            "4-adjacency graph of the frames of a video).\n\n"
+            "The extremities of the graph edges and the vertex areas are copied at construction and all the "
+            "buffers of the algorithm are allocated once: after the first call, the computation of a hierarchy "
+            "does not allocate memory, except for the copy of the result into numpy arrays. The results are "
+            "identical to the ones of :func:`~higra.watershed_hierarchy_by_area`.\n\n"
+            "An engine must only be used by one thread at a time.");
+
+    c.def(py::init([](const py::object &graph, const py::object &vertex_area) {
+              auto area = vertex_area.is_none() ?
+                          py::module::import("higra").attr("attribute_vertex_area")(graph) :
+                          vertex_area;
+              return new py_watershed_hierarchy_by_area_engine(graph, area.cast<pyarray<double>>());
+          }),
+          "Bind an engine to the given graph.\n\n"
+          ":param graph: input graph (must be connected)\n"
+          ":param vertex_area: area of the input graph vertices (default to :func:`~higra.attribute_vertex_area`)",
+          py::arg("graph"),
+          py::arg("vertex_area") = py::none());
+
+    c.def_property_readonly("graph", [](const py_watershed_hierarchy_by_area_engine &e) { return e.graph; },
+                            "Graph the engine is bound to.");
+
+    add_type_overloads<def_watershed_hierarchy_by_area_engine_compute, HG_TEMPLATE_NUMERIC_TYPES>(c, "");
 }
 
 
@@ -12,7 +12,7 @@ import higra as hg
 import numpy as np
 
 
-def random_binary_partition_tree(num_leaves, asymmetry_probability):
+def random_binary_partition_tree(num_leaves, asymmetry_probability, seed=None):
     """
     Random binary partition tree with a controlled amount of asymmetry/unbalancedness.
 
@@ -29,81 +29,35 @@ def random_binary_partition_tree(num_leaves, asymmetry_probability):
 
     A valid minimal connected graph (a tree) is associated to the leaves of the tree.
 
+    The tree is generated in :math:`\mathcal{O}(n\log(n))` time with :math:`n` the number of leaves. See
+    :func:`~higra.random_binary_partition_trees` to generate many trees in parallel.
+
     :param num_leaves: expected number of leaves in the generated tree
-    :param asymmetry_probability: real value between 0 and 1. At 0 the tree is perfectly unbalanced, at 1 it is
-            perfectly balanced (if :attr:`num_leaves` is  a power of 2)
+    :param asymmetry_probability: real value between 0 and 1. At 0 the tree is perfectly balanced (if
+            :attr:`num_leaves` is a power of 2), at 1 it is perfectly unbalanced
+    :param seed: seed of the random number generator (optional). If ``None``, a seed is drawn from Python's
+            :mod:`random` module
     :return: a tree (Concept :class:`~higra.CptBinaryHierarchy`) and its node altitudes
     """
-    import random
-    import math
-
     assert (0 <= asymmetry_probability <= 1)
     num_leaves = int(num_leaves)
     assert (num_leaves > 0)
 
-    parents = np.zeros((num_leaves * 2 - 1,), dtype=np.int64)
-
-    n = 1
-    root = {}
-    leaves = []
-    leaves.append(root)
-
-    all_nodes = [root]
-
-    i = parents.size - 1
-    root["parent"] = i
-
-    while n != 2 * num_leaves - 1:
+    if seed is None:
+        import random
+        seed = random.getrandbits(32)
 
-        ni = random.randint(0, math.floor(asymmetry_probability * (len(leaves) - 1)))
-        node = leaves[ni]
-        del leaves[ni]
-
-        node["i"] = i
-        node["left"] = {"parent": i}
-        node["right"] = {"parent": i}
-        i -= 1
-        all_nodes.append(node["left"])
-        all_nodes.append(node["right"])
-        n += 2
-
-        if random.random() <= asymmetry_probability:
-            if random.random() >= 0.5:
-                leaves.append(node["right"])
-            else:
-                leaves.append(node["left"])
-        else:
-            leaves.append(node["left"])
-            leaves.append(node["right"])
-
-    k = 0
-    for node in all_nodes:
-        if "i" not in node:
-            node["i"] = k
-            k += 1
-        parents[node["i"]] = node["parent"]
-
-    tree = hg.Tree(parents)
+    tree = hg.cpp._random_binary_partition_tree(num_leaves, asymmetry_probability, seed)
 
     altitudes = hg.attribute_regular_altitudes(tree)
 
-    def _get_associated_mst(tree, altitudes):
-        """
-        Create a valid edge mst for the given tree (returns an edge weighted undirected graph)
-        """
-        nb = tree.num_leaves()
-        link_v = np.arange(nb)
-        link_v = hg.accumulate_sequential(tree, link_v, hg.Accumulators.first)
-
-        g = hg.UndirectedGraph(nb)
-        edge_weights = np.zeros((nb - 1,), np.float32)
-        for r in tree.leaves_to_root_iterator(include_leaves=False):
-            g.add_edge(link_v[tree.child(0, r)], link_v[tree.child(1, r)])
-            edge_weights[r - nb] = altitudes[r]
-
-        return g, edge_weights
-
-    mst, edge_weights = _get_associated_mst(tree, altitudes)
+    # a valid mst: each internal node links the first leaves of its two children
+    link_v = np.arange(num_leaves)
+    link_v = hg.accumulate_sequential(tree, link_v, hg.Accumulators.first)
+    internal_nodes = np.arange(num_leaves, tree.num_vertices())
+    mst = hg.UndirectedGraph(num_leaves,
+                             link_v[tree.child(0, internal_nodes)],
+                             link_v[tree.child(1, internal_nodes)])
     mst_edge_map = np.arange(mst.num_edges())
 
     hg.CptHierarchy.link(tree, mst)
@@ -111,3 +65,32 @@ def random_binary_partition_tree(num_leaves, asymmetry_probability):
     hg.CptBinaryHierarchy.link(tree, mst_edge_map, mst)
 
     return tree, altitudes
+
+
+def random_binary_partition_trees(num_trees, num_leaves, asymmetry_probability, seed=None):
+    """
+    Generates several random binary partition trees in parallel (see :func:`~higra.random_binary_partition_tree`).
+
+    The trees are returned as a 2d array whose i-th row is the parent array of the i-th tree (a tree can then be
+    created with ``hg.Tree(parents[i])``). Each tree has its own random number generator seeded from :attr:`seed`
+    and from the index of the tree: the result does not depend on the number of threads.
+
+    :param num_trees: number of trees
+    :param num_leaves: number of leaves of each tree
+    :param asymmetry_probability: real value between 0 and 1. At 0 the trees are perfectly balanced (if
+            :attr:`num_leaves` is a power of 2), at 1 they are perfectly unbalanced
+    :param seed: seed of the random number generators (optional). If ``None``, a seed is drawn from Python's
+            :mod:`random` module
+    :return: a 2d array of shape :math:`(num\_trees, 2 \times num\_leaves - 1)`
+    """
+    assert (0 <= asymmetry_probability <= 1)
+    num_trees = int(num_trees)
+    num_leaves = int(num_leaves)
+    assert (num_trees >= 0)
+    assert (num_leaves > 0)
+
+    if seed is None:
+        import random
+        seed = random.getrandbits(32)
+
+    return hg.cpp._random_binary_partition_trees(num_trees, num_leaves, asymmetry_probability, seed)
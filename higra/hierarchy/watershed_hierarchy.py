@@ -30,7 +30,9 @@ def watershed_hierarchy_by_area(graph, edge_weights, vertex_area=None, canonize_
 
     :param graph: input graph
     :param edge_weights: input graph edge weights
-    :param vertex_area: area of the input graph vertices (provided by :func:`~higra.attribute_vertex_area`)
+    :param vertex_area: area of the input graph vertices (provided by :func:`~higra.attribute_vertex_area`). If
+           :attr:`vertex_area` has an integral type (e.g. ``np.uint32``, which must be able to represent the area of the
+           whole graph), the node altitudes of the hierarchy have the same type.
     :param canonize_tree: if ``True`` (default), the resulting hierarchy is canonized (see function :func:`~higra.canonize_hierarchy`),
            otherwise the returned hierarchy is a binary tree
     :return: a tree (Concept :class:`~higra.CptHierarchy` is ``True`` and :class:`~higra.CptBinaryHierarchy` otherwise)
@@ -46,6 +48,42 @@ def watershed_hierarchy_by_area(graph, edge_weights, vertex_area=None, canonize_
                                             canonize_tree)
 
 
+@hg.extend_class(hg.WatershedHierarchyByAreaEngine, method_name="compute")
+def __compute(self, edge_weights, canonize_tree=True):
+    """
+    Watershed hierarchy by area of the graph of the engine for the given edge weights
+    (see :func:`~higra.watershed_hierarchy_by_area`).
+
+    Example:
+
+    .. code-block:: python
+
+        engine = hg.WatershedHierarchyByAreaEngine(hg.get_4_adjacency_graph(frames[0].shape[:2]))
+        for frame in frames:
+            edge_weights = hg.weight_graph(engine.graph, frame, hg.WeightFunction.L2)
+            tree, altitudes = engine.compute(edge_weights)
+
+    :param edge_weights: edge weights of the graph of the engine
+    :param canonize_tree: if ``True`` (default), the resulting hierarchy is canonized (see function :func:`~higra.canonize_hierarchy`),
+           otherwise the returned hierarchy is a binary tree
+    :return: a tree (Concept :class:`~higra.CptHierarchy` is ``True`` and :class:`~higra.CptBinaryHierarchy` otherwise)
+             and its node altitudes
+    """
+    graph = self.graph
+    tree, altitudes, mst_edge_map = self._compute(edge_weights)
+
+    hg.CptHierarchy.link(tree, graph)
+
+    if canonize_tree:
+        tree, altitudes = hg.canonize_hierarchy(tree, altitudes)
+    else:
+        mst = hg.subgraph(graph, mst_edge_map)
+        hg.CptMinimumSpanningTree.link(mst, graph, mst_edge_map)
+        hg.CptBinaryHierarchy.link(tree, mst_edge_map, mst)
+
+    return tree, altitudes
+
+
 def watershed_hierarchy_by_volume(graph, edge_weights, vertex_area=None, canonize_tree=True):
     """
     Watershed hierarchy by volume.
@@ -195,6 +233,10 @@ def watershed_hierarchy_by_attribute(graph, edge_weights, attribute_functor, can
     The attribute functor is a function that takes a binary partition tree and an array of altitudes as argument
     and returns an array with the node attribute values for the given tree.
 
+    The node altitudes of the resulting hierarchy have the type of the attribute if it is the type of the edge weights,
+    ``np.uint32`` or ``np.int64``. Other integral types are converted to ``np.int64`` and floating point types to
+    ``np.float64``.
+
     Example:
 
     Calling watershed_hierarchy_by_area is equivalent to:
@@ -296,3 +338,44 @@ def watershed_hierarchy_by_minima_ordering(graph, edge_weights, minima_ranks, mi
         altitudes = minima_altitudes[altitudes]
 
     return tree, altitudes
+
+
+def waterfall_hierarchy(graph, edge_weights, canonize_tree=True):
+    """
+    Waterfall hierarchy.
+
+    The first level of the waterfall is the watershed of the edge weighted graph: each vertex flows along its lightest
+    adjacent edge. Each following level is the watershed of the region adjacency graph of the previous level, whose
+    edges are weighted by the pass values (lowest edge weights) between adjacent regions. The altitude of a node of the
+    hierarchy is the level (starting at 1) at which the region appears. Ties between edge weights are broken by edge
+    indices.
+
+    The waterfall is computed on the minimum spanning tree of the graph (see :func:`~higra.bpt_canonical`), as a
+    sequence of Borůvka steps, without building any region adjacency graph: after the computation of the minimum
+    spanning tree, the time complexity is linear. The link between the waterfall and the minimum spanning tree is
+    described in:
+
+        J. Cousty, L. Najman, B. Perret.
+        `Constructive links between some morphological hierarchies on edge-weighted graphs <https://hal.archives-ouvertes.fr/file/index/docid/806851/filename/ismm2013.pdf>`_..
+        ISMM 2013: 86-97.
+
+    :param graph: input graph (must be connected)
+    :param edge_weights: edge weights of the input graph
+    :param canonize_tree: if ``True`` (default), the resulting hierarchy is canonized (see function :func:`~higra.canonize_hierarchy`),
+           otherwise the returned hierarchy is a binary tree
+    :return: a tree (Concept :class:`~higra.CptHierarchy` is ``True`` and :class:`~higra.CptBinaryHierarchy` otherwise)
+             and its node altitudes
+    """
+
+    tree, altitudes, mst_edge_map = hg.cpp._waterfall_hierarchy(graph, edge_weights)
+
+    hg.CptHierarchy.link(tree, graph)
+
+    if canonize_tree:
+        tree, altitudes = hg.canonize_hierarchy(tree, altitudes)
+    else:
+        mst = hg.subgraph(graph, mst_edge_map)
+        hg.CptMinimumSpanningTree.link(mst, graph, mst_edge_map)
+        hg.CptBinaryHierarchy.link(tree, mst_edge_map, mst)
+
+    return tree, altitudes
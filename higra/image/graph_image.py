@@ -10,6 +10,7 @@
 
 import higra as hg
 import numpy as np
+import concurrent.futures
 
 
 @hg.argument_helper(hg.CptGridGraph)
@@ -27,6 +28,28 @@ def graph_4_adjacency_2_khalimsky(graph, edge_weights, shape, add_extra_border=F
     return hg.cpp._graph_4_adjacency_2_khalimsky(graph, shape, edge_weights, add_extra_border)
 
 
+@hg.argument_helper(hg.CptHierarchy, ("leaf_graph", hg.CptGridGraph))
+def ucm_khalimsky(tree, altitudes, shape, add_extra_border=False):
+    """
+    Ultrametric contour map of a hierarchy on a 2d grid in the Khalimsky grid.
+
+    The result is equal to ``hg.graph_4_adjacency_2_khalimsky(graph, hg.saliency(tree, altitudes), shape,
+    add_extra_border)`` where ``graph`` is the 4 adjacency graph of the grid, but the saliency map is never
+    materialized: the lowest common ancestors of the adjacent pixels are written directly in the Khalimsky grid.
+
+    :param tree: input tree (Concept :class:`~higra.CptHierarchy`)
+    :param altitudes: altitudes of the nodes of the tree
+    :param shape: shape of the leaf graph of the tree (deduced from :class:`~higra.CptHierarchy` and
+        :class:`~higra.CptGridGraph`)
+    :param add_extra_border: if False result size is 2 * shape - 1 and 2 * shape + 1 otherwise
+    :return: a 2d array
+    """
+    shape = hg.normalize_shape(shape)
+    if len(shape) != 2:
+        raise ValueError("ucm_khalimsky only supports 2d grids.")
+    return hg.cpp._ucm_khalimsky(tree, altitudes, shape, add_extra_border)
+
+
 def khalimsky_2_graph_4_adjacency(khalimsky, extra_border=False):
     """
     Create a 4 adjacency edge-weighted graph from a contour image in the Khalimsky grid.
@@ -122,6 +145,154 @@ def get_8_adjacency_graph(shape):
     return graph
 
 
+def get_4_adjacency_morton_graph(embedding):
+    """
+    Create an explicit undirected 4 adjacency graph whose vertices are numbered along the tiled Morton curve of the
+    given embedding: the pixel :math:`(i, j)` is the vertex ``embedding.grid2lin((i, j))``.
+
+    On large images, the vertical neighbours of a pixel are much closer to it in memory than with the row major
+    numbering of :func:`~higra.get_4_adjacency_graph`, which speeds up the algorithms working on the graph (
+    :func:`~higra.bpt_canonical`, :func:`~higra.watershed_hierarchy_by_area`...). Vertex weights are obtained from
+    an image with ``embedding.to_morton_order(image)`` and vertex indexed results are converted back to images with
+    ``embedding.to_row_major_order(values)``.
+
+    The result is not a grid graph (Concept :class:`~higra.CptGridGraph`) as its vertices are not in row major order.
+
+    :Example:
+
+    >>> embedding = hg.EmbeddingMorton2d(image.shape[:2])
+    >>> graph = hg.get_4_adjacency_morton_graph(embedding)
+    >>> edge_weights = hg.weight_graph(graph, embedding.to_morton_order(image), hg.WeightFunction.L1)
+    >>> tree, altitudes = hg.watershed_hierarchy_by_area(graph, edge_weights)
+    >>> labels = embedding.to_row_major_order(hg.labelisation_horizontal_cut_from_num_regions(tree, altitudes, 10))
+
+    :param embedding: a Morton embedding (:class:`~higra.EmbeddingMorton2d`)
+    :return: a graph
+    """
+    return hg.cpp._get_4_adjacency_morton_graph(embedding)
+
+
+def get_8_adjacency_morton_graph(embedding):
+    """
+    Create an explicit undirected 8 adjacency graph whose vertices are numbered along the tiled Morton curve of the
+    given embedding (see :func:`~higra.get_4_adjacency_morton_graph`).
+
+    :param embedding: a Morton embedding (:class:`~higra.EmbeddingMorton2d`)
+    :return: a graph
+    """
+    return hg.cpp._get_8_adjacency_morton_graph(embedding)
+
+
+def bpt_canonical_4_adjacency(image, weight_function=hg.WeightFunction.mean):
+    """
+    Canonical binary partition tree of the 4 adjacency graph of an image whose edges are weighted from the pixel
+    values (typically a boundary probability map).
+
+    The result is identical to
+
+    .. code-block:: python
+
+        graph = hg.get_4_adjacency_graph(image.shape[:2])
+        edge_weights = hg.weight_graph(graph, image, weight_function)
+        tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+
+    but no explicit graph is created: the edges are weighted on an implicit grid graph and the minimum spanning tree
+    is computed with a parallel Borůvka algorithm, which avoids the sort of all the edges of the graph.
+
+    The tree is not linked to a graph: its leaves are the pixels in raster scan order and the edge indices of
+    the minimum spanning tree are the ones of :func:`~higra.get_4_adjacency_graph`.
+
+    :param image: a 2d array of shape (height, width) or a 3d array of shape (height, width, channels)
+    :param weight_function: edge weighting function (see :class:`~higra.WeightFunction`, default to ``mean``)
+    :return: a tree, its node altitudes (of type ``np.float64``), and the indices of the minimum spanning tree edges
+             (the i-th edge of the minimum spanning tree corresponds to the (i + num_leaves)-th node of the tree)
+    """
+    image = np.asarray(image)
+    if image.ndim != 2 and image.ndim != 3:
+        raise ValueError("Image must be a 2d or a 3d array.")
+    return hg.cpp._bpt_canonical_4_adjacency(image, weight_function)
+
+
+__bpt_executor = None
+
+
+def bpt_canonical_4_adjacency_async(image, weight_function=hg.WeightFunction.mean):
+    """
+    Asynchronous version of :func:`~higra.bpt_canonical_4_adjacency`: the computation is run in a background
+    thread (without the Python global interpreter lock) and the result is obtained with the ``result`` method of
+    the returned future.
+
+    Example:
+
+    .. code-block:: python
+
+        future = hg.bpt_canonical_4_adjacency_async(boundaries)
+        # ... do something else
+        tree, altitudes, mst_edge_map = future.result()
+
+    :param image: a 2d array of shape (height, width) or a 3d array of shape (height, width, channels)
+        (the array must not be modified before the end of the computation)
+    :param weight_function: edge weighting function (see :class:`~higra.WeightFunction`, default to ``mean``)
+    :return: a :class:`concurrent.futures.Future` of the result of :func:`~higra.bpt_canonical_4_adjacency`
+    """
+    global __bpt_executor
+    if __bpt_executor is None:
+        __bpt_executor = concurrent.futures.ThreadPoolExecutor(thread_name_prefix="higra_bpt")
+    return __bpt_executor.submit(bpt_canonical_4_adjacency, image, weight_function)
+
+
+def tiled_minimum_spanning_tree(image, tile_shape=None, weight_function=hg.WeightFunction.L1, prefetch=True):
+    """
+    Minimum spanning tree of the 4 adjacency graph of an image too large to be loaded in memory, whose edges are
+    weighted from the pixel values.
+
+    The image can be any array-like object supporting numpy slicing, for example a ``numpy.memmap``, a ``zarr.Array``
+    or a ``h5py.Dataset``: it is read tile by tile in raster scan order, and only a tile plus a few rows of pixels are
+    held in memory. The edges of the result are the ones of ``hg.bpt_canonical(graph, edge_weights)`` with
+
+    .. code-block:: python
+
+        graph = hg.get_4_adjacency_graph(image.shape[:2])
+        edge_weights = hg.weight_graph(graph, image, weight_function)
+
+    If ``tile_shape`` is not given and the image is chunked (it has a ``chunks`` attribute, as Zarr and HDF5 arrays),
+    each tile is made of whole chunks (at least 512 pixels in each dimension), so that each chunk is read and
+    decompressed once. If ``prefetch`` is ``True``, the next tile is read in a background thread while the current
+    one is processed.
+
+    Example:
+
+    .. code-block:: python
+
+        boundaries = zarr.open("boundaries.zarr", mode="r")
+        mst_edges, mst_edge_weights = hg.tiled_minimum_spanning_tree(boundaries)
+
+    :param image: a 2d array-like of shape (height, width) or a 3d array-like of shape (height, width, channels)
+    :param tile_shape: shape (height, width) of the tiles (default to a shape aligned on the chunks of the image, or
+        (512, 512))
+    :param weight_function: edge weighting function (see :class:`~higra.WeightFunction`, default to ``L1``)
+    :param prefetch: if ``True`` (default), the next tile is loaded while the current one is processed
+    :return: a pair of 1d arrays: the indices of the minimum spanning tree edges in the 4 adjacency graph of the
+        image (in no particular order) and their weights (of type ``np.float64``)
+    """
+    shape = tuple(image.shape)
+    if len(shape) != 2 and len(shape) != 3:
+        raise ValueError("Image must be a 2d or a 3d array.")
+
+    if tile_shape is None:
+        chunks = getattr(image, "chunks", None)
+        if chunks is not None and len(chunks) == len(shape):
+            tile_shape = tuple(max(1, -(-512 // c)) * c for c in chunks[:2])
+        else:
+            tile_shape = (512, 512)
+
+    def tile_loader(y, x, h, w):
+        return np.asarray(image[y:y + h, x:x + w], dtype=np.float64)
+
+    return hg.cpp._tiled_minimum_spanning_tree(shape[:2], tile_shape[0], tile_shape[1], tile_loader,
+                                               weight_function, prefetch)
+
+
 def get_4_adjacency_implicit_graph(shape):
     """
     Create an implicit undirected 4 adjacency graph of the given shape (edges are not stored).
@@ -42,7 +42,8 @@ void py_init_contour_segment_2d(pybind11::module &m) {
               return py::make_iterator(transform_it_t(c.begin(), transform), transform_it_t(c.end(), transform));
               //return py::make_iterator(c.begin(), c.end());
           },
-          "Iterator on the contour elements of the contour segment. ");
+          "Iterator on the contour elements of the contour segment. ",
+          py::keep_alive<0, 1>());
     c.def("__len__", &class_t::size, "Number of elements in the contour segment.");
     c.def("__getitem__", [](class_t &c, index_t i) {
         // ::TODO:: remove this stupid thing when xtensor python supports it
@@ -72,9 +73,10 @@ void py_init_polyline_contour_2d(pybind11::module &m) {
     c.def("__iter__", [](class_t &c) {
               return py::make_iterator(c.begin(), c.end());
           },
-          "Iterator on the contour segments of the polyline contour. ");
+          "Iterator on the contour segments of the polyline contour. ",
+          py::keep_alive<0, 1>());
     c.def("__len__", &class_t::size, "Number of segments in the polyline contour.");
-    c.def("__getitem__", [](class_t &c, index_t i) { return c[i]; });
+    c.def("__getitem__", [](class_t &c, index_t i) { return c[i]; }, py::keep_alive<0, 1>());
     c.def("subdivide", &class_t::subdivide,
           "Subdivide the line such that the distance between the line\n"
           "joining the extremities of the contour segment and each of its elements is lower than the threshold (\n"
@@ -97,9 +99,10 @@ void py_init_contour_2d_impl(pybind11::module &m) {
     c.def("__iter__", [](class_t &c) {
               return py::make_iterator(c.begin(), c.end());
           },
-          "Iterator on the polyline contours. ");
+          "Iterator on the polyline contours. ",
+          py::keep_alive<0, 1>());
     c.def("__len__", &class_t::size, "Number of polyline contours.");
-    c.def("__getitem__", [](class_t &c, index_t i) { return c[i]; });
+    c.def("__getitem__", [](class_t &c, index_t i) { return c[i]; }, py::keep_alive<0, 1>());
     c.def("subdivide", &class_t::subdivide,
           "Subdivide each segment of the contour such that: "
           "For each segment, the distance between the line joining the extremities "
@@ -110,7 +113,7 @@ void py_init_contour_2d_impl(pybind11::module &m) {
           "- epsilon if relative_epsilon is false\n"
           "- epsilon times the distance between the segment extremities if relative_epsilon is true\n"
           "\n"
-          "Implementation note: simply call subdivide on each polyline of the contour.",
+          "Implementation note: the polylines are subdivided in parallel.",
           py::arg("epsilon") = 0.1,
           py::arg("relative_epsilon") = true,
           py::arg("min_size") = 2
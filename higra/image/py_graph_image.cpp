@@ -11,6 +11,8 @@
 #include "py_graph_image.hpp"
 #include "../py_common.hpp"
 #include "higra/image/graph_image.hpp"
+#include "higra/image/bpt_4_adjacency.hpp"
+#include "higra/image/tiled_mst.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
 #include "pybind11/functional.h"
@@ -54,6 +56,50 @@ struct def_contour2Khalimsky {
     }
 };
 
+struct def_ucm_khalimsky {
+    template<typename value_t>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_ucm_khalimsky", [](const hg::tree &tree,
+                                   const pyarray<value_t> &altitudes,
+                                   const std::vector<size_t> &shape,
+                                   bool add_extra_border) {
+                  hg::embedding_grid_2d embedding(shape);
+                  if (hg::num_leaves(tree) != embedding.size()) {
+                      throw std::runtime_error("ucm_khalimsky: tree number of leaves does not match the shape.");
+                  }
+                  return without_gil([&] {
+                      return hg::ucm_khalimsky(tree, pyarray_view(altitudes), embedding, add_extra_border);
+                  });
+              },
+              doc,
+              py::arg("tree"),
+              py::arg("altitudes"),
+              py::arg("shape"),
+              py::arg("add_extra_border") = false);
+    }
+};
+
+struct def_bpt_canonical_4_adjacency {
+    template<typename value_t>
+    static
+    void def(pybind11::module &m, const char *doc) {
+        m.def("_bpt_canonical_4_adjacency", [](const pyarray<value_t> &image,
+                                               hg::weight_functions weight) {
+                  auto res = without_gil([&] {
+                      return hg::bpt_canonical_4_adjacency(pyarray_view(image), weight);
+                  });
+                  return py::make_tuple(
+                          std::move(res.tree),
+                          std::move(res.altitudes),
+                          std::move(res.mst_edge_map));
+              },
+              doc,
+              py::arg("image"),
+              py::arg("weight_function"));
+    }
+};
+
 void py_init_graph_image(pybind11::module &m) {
     xt::import_numpy();
 
@@ -69,5 +115,61 @@ void py_init_graph_image(pybind11::module &m) {
              "Returns a tuple of three elements (graph, embedding, edge_weights)."
             );
 
+    add_type_overloads<def_ucm_khalimsky, HG_TEMPLATE_NUMERIC_TYPES>
+            (m,
+             "Ultrametric contour map of a hierarchy on a 2d grid in the Khalimsky grid."
+            );
+
+    add_type_overloads<def_bpt_canonical_4_adjacency, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+
+    m.def("_get_4_adjacency_morton_graph", [](const hg::embedding_morton_2d &embedding) {
+              return hg::get_4_adjacency_morton_graph(embedding);
+          },
+          "Create an explicit 4 adjacency graph whose vertices are numbered in the order of the given Morton embedding.",
+          py::arg("embedding"));
+
+    m.def("_get_8_adjacency_morton_graph", [](const hg::embedding_morton_2d &embedding) {
+              return hg::get_8_adjacency_morton_graph(embedding);
+          },
+          "Create an explicit 8 adjacency graph whose vertices are numbered in the order of the given Morton embedding.",
+          py::arg("embedding"));
+
+    m.def("_tiled_minimum_spanning_tree", [](const std::vector<size_t> &shape,
+                                             hg::index_t tile_height,
+                                             hg::index_t tile_width,
+                                             const py::function &tile_loader,
+                                             hg::weight_functions weight,
+                                             bool prefetch) {
+              hg::embedding_grid_2d embedding(shape);
+              std::vector<hg::index_t> mst_edges;
+              std::vector<double> mst_edge_weights;
+              without_gil([&] {
+                  hg::tiled_minimum_spanning_tree(
+                          embedding, tile_height, tile_width,
+                          // called without the gil, possibly from a loading thread
+                          [&tile_loader](hg::index_t y, hg::index_t x, hg::index_t h, hg::index_t w) {
+                              py::gil_scoped_acquire gil;
+                              auto tile = tile_loader(y, x, h, w).cast<pyarray<double>>();
+                              return hg::array_nd<double>(tile);
+                          },
+                          [&mst_edges, &mst_edge_weights](hg::index_t edge_index, double edge_weight) {
+                              mst_edges.push_back(edge_index);
+                              mst_edge_weights.push_back(edge_weight);
+                          },
+                          weight,
+                          prefetch);
+              });
+              return py::make_tuple(hg::array_1d<hg::index_t>(xt::adapt(mst_edges)),
+                                    hg::array_1d<double>(xt::adapt(mst_edge_weights)));
+          },
+          "Minimum spanning tree of the 4 adjacency graph of an image loaded tile by tile with the given function. "
+          "Returns a tuple (edge indices, edge weights).",
+          py::arg("shape"),
+          py::arg("tile_height"),
+          py::arg("tile_width"),
+          py::arg("tile_loader"),
+          py::arg("weight_function"),
+          py::arg("prefetch"));
+
 }
 
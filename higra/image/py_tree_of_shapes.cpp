@@ -41,8 +41,10 @@ struct def_tree_of_shapes {
                       throw std::runtime_error("tree_of_shapes_image2d: Unknown padding option.");
                   }
 
-                  auto res = hg::component_tree_tree_of_shapes_image2d(image, tpadding, original_size, immersion,
-                                                                   exterior_vertex);
+                  auto res = without_gil([&] {
+                      return hg::component_tree_tree_of_shapes_image2d(pyarray_view(image), tpadding, original_size,
+                                                                       immersion, exterior_vertex);
+                  });
                   return py::make_tuple(std::move(res.tree), std::move(res.altitudes));
               },
               doc,
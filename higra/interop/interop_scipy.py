@@ -30,19 +30,22 @@ def binary_hierarchy_to_scipy_linkage_matrix(tree, altitudes=None, area=None):
 
     If :attr:`area` is not specified, the value provided by :func:`~higra.attribute_area` on :attr:`tree` is used.
 
+    The linkage matrix is filled in a single pass on the parent relation of the tree (the regular altitudes and the
+    area are computed on the fly when they are not specified) and is returned without copy.
+
     :param tree: Input tree
     :param altitudes: Tree nodes altitudes (should be increasing w.r.t tree)
     :param area: Tree nodes area (should be increasing w.r.t tree)
     :return: A linkage matrix
     """
 
-    if altitudes is None:
-        altitudes = hg.attribute_regular_altitudes(tree)
-
     if area is None:
-        area = hg.attribute_area(tree)
+        leaf_graph = hg.CptHierarchy.get_leaf_graph(tree)
+        if leaf_graph is not None and hg.CptRegionAdjacencyGraph.validate(leaf_graph):
+            # the leaves are regions whose area is not 1
+            area = hg.attribute_area(tree)
 
-    area = hg.cast_to_dtype(area, np.int64)
+    # missing altitudes and area are computed in the same pass as the linkage matrix
     return hg.cpp._binary_hierarchy_to_scipy_linkage_matrix(tree, altitudes, area)
 
 
@@ -22,30 +22,123 @@ namespace py = pybind11;
 
 using namespace hg;
 
-template<typename tree_t, typename T1, typename T2, typename value_t=double>
+/**
+ * Fills the linkage matrix of a binary tree in a single bottom-up pass on the parent relation: the children of each
+ * node are found in increasing order (as with compute_children) and the area of a node is complete when the node
+ * is reached.
+ *
+ * If altitude_fun is nullptr, the regular altitudes (see attribute_regular_altitudes) are computed with a top-down
+ * pass on the internal nodes. If area_fun is nullptr, the area is the number of leaves of each node.
+ */
+template<typename tree_t, typename altitude_fun_t, typename area_fun_t>
 auto binary_hierarchy_to_scipy_linkage_matrix(const tree_t &tree,
-                                              const xt::xexpression<T1> &xaltitudes,
-                                              const xt::xexpression<T2> &xarea) {
-    auto &altitudes = xaltitudes.derived_cast();
-    auto &area = xarea.derived_cast();
-    hg_assert_node_weights(tree, altitudes);
-    hg_assert_node_weights(tree, area);
-    tree.compute_children();
-    hg::index_t n_leaves = num_leaves(tree);
-    hg::array_2d<value_t> M = xt::empty<value_t>({(size_t) n_leaves - 1, (size_t) 4});
-    for (auto i: hg::leaves_to_root_iterator(tree, hg::leaves_it::exclude)) {
-        hg::index_t n = i - n_leaves;
-        hg_assert(hg::num_children(i, tree) == 2, "Input hierarchy must be a binary hierarchy.");
-        M(n, 0) = (value_t)hg::child(0, i, tree);
-        M(n, 1) = (value_t)hg::child(1, i, tree);
-        M(n, 2) = (value_t)altitudes(i);
-        M(n, 3) = (value_t)area(i);
+                                              const altitude_fun_t &altitude_fun,
+                                              const area_fun_t &area_fun) {
+    const hg::index_t n_leaves = num_leaves(tree);
+    const hg::index_t root = hg::root(tree);
+    hg_assert(num_vertices(tree) == (size_t) (2 * n_leaves - 1), "Input hierarchy must be a binary hierarchy.");
+    auto &parents = tree.parents();
+
+    hg::array_2d<double> M = hg::array_2d<double>::from_shape({(size_t) n_leaves - 1, (size_t) 4});
+    for (hg::index_t n = 0; n < n_leaves - 1; n++) {
+        M(n, 0) = -1;
+        M(n, 1) = -1;
+        M(n, 3) = 0;
+    }
+
+    for (hg::index_t i = 0; i < root; i++) {
+        hg::index_t n = parents(i) - n_leaves;
+        if (M(n, 0) < 0) {
+            M(n, 0) = (double) i;
+        } else {
+            hg_assert(M(n, 1) < 0, "Input hierarchy must be a binary hierarchy.");
+            M(n, 1) = (double) i;
+        }
+        double area_i = (i < n_leaves) ? 1 : M(i - n_leaves, 3);
+        M(n, 3) += area_i;
     }
+
+    for (hg::index_t n = 0; n < n_leaves - 1; n++) {
+        hg_assert(M(n, 1) >= 0, "Input hierarchy must be a binary hierarchy.");
+    }
+
+    altitude_fun(M);
+    area_fun(M);
     return M;
+}
+
+template<typename tree_t>
+struct regular_altitudes_linkage {
+    const tree_t &tree;
+
+    void operator()(hg::array_2d<double> &M) const {
+        const hg::index_t n_leaves = num_leaves(tree);
+        const hg::index_t root = hg::root(tree);
+        auto &parents = tree.parents();
+        if (n_leaves < 2) {
+            return;
+        }
+        // depth of the internal nodes, stored in the altitude column
+        M(root - n_leaves, 2) = 0;
+        for (hg::index_t i = root - 1; i >= n_leaves; i--) {
+            M(i - n_leaves, 2) = M(parents(i) - n_leaves, 2) + 1;
+        }
+        // the maximal depth is reached on a leaf
+        double max_depth = 0;
+        for (hg::index_t i = 0; i < n_leaves; i++) {
+            max_depth = std::max(max_depth, M(parents(i) - n_leaves, 2) + 1);
+        }
+        for (hg::index_t n = 0; n < n_leaves - 1; n++) {
+            M(n, 2) = 1 - M(n, 2) / max_depth;
+        }
+    }
+};
+
+template<typename T>
+struct copy_linkage_column {
+    const T &values;
+    hg::index_t n_leaves;
+    hg::index_t column;
+
+    void operator()(hg::array_2d<double> &M) const {
+        for (hg::index_t n = 0; n < n_leaves - 1; n++) {
+            M(n, column) = (double) values(n + n_leaves);
+        }
+    }
 };
 
+template<typename T>
+copy_linkage_column<T> make_copy_linkage_column(const T &values, hg::index_t n_leaves, hg::index_t column) {
+    return {values, n_leaves, column};
+}
 
-template<typename T, typename value_t=typename T::value_type>
+struct no_op_linkage {
+    void operator()(hg::array_2d<double> &) const {
+    }
+};
+
+// area is either None or an array of node areas
+template<typename tree_t, typename altitude_fun_t>
+auto linkage_matrix_with_area(const tree_t &tree, const altitude_fun_t &altitude_fun, const py::object &area) {
+    if (area.is_none()) {
+        return without_gil([&] {
+            return binary_hierarchy_to_scipy_linkage_matrix(tree, altitude_fun, no_op_linkage());
+        });
+    }
+    auto area_array = area.cast<pyarray<double>>();
+    hg_assert_node_weights(tree, area_array);
+    hg_assert_1d_array(area_array);
+    auto area_view = pyarray_view(area_array);
+    return without_gil([&] {
+        return binary_hierarchy_to_scipy_linkage_matrix(
+                tree, altitude_fun, make_copy_linkage_column(area_view, num_leaves(tree), 3));
+    });
+}
+
+/**
+ * The rows of the linkage matrix are independent: they are processed in parallel.
+ */
+template<typename T>
 auto scipy_linkage_matrix_to_binary_hierarchy(const xt::xexpression<T> &xlinkage_matrix) {
     auto &linkage_matrix = xlinkage_matrix.derived_cast();
     hg_assert(linkage_matrix.dimension() == 2, "Linkage matrix must be a 2d array.");
@@ -54,22 +147,24 @@ auto scipy_linkage_matrix_to_binary_hierarchy(const xt::xexpression<T> &xlinkage
     index_t n_leaves = linkage_matrix.shape()[0] + 1;
     index_t n_nodes = n_leaves * 2 - 1;
 
-    array_1d<index_t> parents = xt::empty<index_t>({n_nodes});
-    array_1d<value_t> altitudes = xt::empty<index_t>({n_nodes});
-    array_1d<index_t> area = xt::empty<index_t>({n_nodes});
+    array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) n_nodes});
+    array_1d<double> altitudes = array_1d<double>::from_shape({(size_t) n_nodes});
+    array_1d<index_t> area = array_1d<index_t>::from_shape({(size_t) n_nodes});
 
-    xt::view(altitudes, xt::range(0, n_leaves)) = 0;
-    xt::view(area, xt::range(0, n_leaves)) = 1;
+    parfor(0, n_leaves, [&altitudes, &area](index_t i) {
+        altitudes(i) = 0;
+        area(i) = 1;
+    });
     parents(n_nodes - 1) = n_nodes - 1;
 
-    for (index_t i = 0; i < n_leaves - 1; i++) {
+    parfor(0, n_leaves - 1, [&](index_t i) {
         index_t n = i + n_leaves;
         parents(static_cast<index_t>(linkage_matrix(i, 0))) = n;
         parents(static_cast<index_t>(linkage_matrix(i, 1))) = n;
         altitudes(n) = linkage_matrix(i, 2);
         area(n) = static_cast<index_t>(linkage_matrix(i, 3));
-    }
-    return std::make_tuple(hg::tree(parents), std::move(altitudes), std::move(area));
+    });
+    return std::make_tuple(hg::tree(std::move(parents)), std::move(altitudes), std::move(area));
 };
 
 struct def_scipy_linkage_matrix_to_binary_hierarchy {
@@ -78,7 +173,10 @@ struct def_scipy_linkage_matrix_to_binary_hierarchy {
     void def(pybind11::module &m, const char *doc) {
         m.def("_scipy_linkage_matrix_to_binary_hierarchy", [](
                       const pyarray<value_t> &linkage_matrix) {
-                  auto res = scipy_linkage_matrix_to_binary_hierarchy(linkage_matrix);
+                  auto linkage_matrix_view = pyarray_view(linkage_matrix);
+                  auto res = without_gil([&] {
+                      return scipy_linkage_matrix_to_binary_hierarchy(linkage_matrix_view);
+                  });
                   return py::make_tuple(std::move(std::get<0>(res)), std::move(std::get<1>(res)),
                                         std::move(std::get<2>(res)));
               },
@@ -95,18 +193,32 @@ struct def_binary_hierarchy_to_scipy_linkage_matrix {
         m.def("_binary_hierarchy_to_scipy_linkage_matrix", [](
                       const tree_t &tree,
                       const pyarray<value_t> &altitudes,
-                      const pyarray<hg::index_t> &area) {
-                  return binary_hierarchy_to_scipy_linkage_matrix(tree, altitudes, area);
+                      const py::object &area) {
+                  hg_assert_node_weights(tree, altitudes);
+                  hg_assert_1d_array(altitudes);
+                  auto altitudes_view = pyarray_view(altitudes);
+                  return linkage_matrix_with_area(tree, make_copy_linkage_column(altitudes_view, num_leaves(tree), 2),
+                                                  area);
               },
               doc,
               py::arg("tree"),
               py::arg("altitudes"),
-              py::arg("area"));
+              py::arg("area") = py::none());
     }
 };
 
 void py_init_scipy(pybind11::module &m) {
     xt::import_numpy();
+    m.def("_binary_hierarchy_to_scipy_linkage_matrix", [](
+                  const hg::tree &tree,
+                  const py::none &,
+                  const py::object &area) {
+              return linkage_matrix_with_area(tree, regular_altitudes_linkage<hg::tree>{tree}, area);
+          },
+          "Converts an Higra binary hierarchy to a SciPy linkage matrix with regular altitudes.",
+          py::arg("tree"),
+          py::arg("altitudes"),
+          py::arg("area") = py::none());
     add_type_overloads<def_binary_hierarchy_to_scipy_linkage_matrix<hg::tree>, HG_TEMPLATE_FLOAT_TYPES>
             (m,
              "Converts an Higra binary hierarchy to a SciPy linkage matrix."
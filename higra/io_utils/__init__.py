@@ -8,6 +8,8 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+from .arrow_io import *
+from .graph_io import *
 from .pink_io import *
 from .tree_io import *
 
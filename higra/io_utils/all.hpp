@@ -10,5 +10,6 @@
 
 #pragma once
 
+#include "py_graph_io.hpp"
 #include "py_pink_graph_io.hpp"
 #include "py_tree_io.hpp"
@@ -0,0 +1,229 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def __columnar_writer(filename, schema, format):
+    import pyarrow as pa
+
+    if format == "arrow":
+        writer = pa.ipc.new_file(filename, schema)
+
+        def write(batch):
+            writer.write_batch(batch)
+
+    elif format == "parquet":
+        import pyarrow.parquet as pq
+        writer = pq.ParquetWriter(filename, schema)
+
+        def write(batch):
+            # one call per batch: each batch becomes one row group of the file
+            writer.write_table(pa.Table.from_batches([batch], schema=schema))
+
+    else:
+        raise ValueError("Invalid format '" + str(format) + "', possible values are 'arrow' and 'parquet'.")
+
+    return writer, write
+
+
+def __write_columns(filename, columns, metadata, format, row_group_size):
+    """
+    Write the given columns (list of pairs (name, 1d array) of equal sizes) by batches of :attr:`row_group_size` rows.
+    Each batch is built from views on the input arrays: the memory overhead is bounded by the size of one batch.
+    """
+    import pyarrow as pa
+
+    row_group_size = int(row_group_size)
+    if row_group_size <= 0:
+        raise ValueError("row_group_size must be strictly positive.")
+
+    num_rows = columns[0][1].size
+    for name, column in columns:
+        if column.ndim != 1:
+            raise ValueError("Column '" + name + "' must be a 1d array.")
+        if column.size != num_rows:
+            raise ValueError("Column '" + name + "' size does not match the number of rows.")
+
+    schema = pa.schema([pa.field(name, pa.from_numpy_dtype(column.dtype), nullable=False) for name, column in columns],
+                       metadata=metadata)
+
+    writer, write = __columnar_writer(filename, schema, format)
+    try:
+        for start in range(0, num_rows, row_group_size):
+            stop = min(start + row_group_size, num_rows)
+            # contiguous slices are wrapped without copy
+            batch = pa.record_batch([pa.array(column[start:stop]) for _, column in columns], schema=schema)
+            write(batch)
+    finally:
+        writer.close()
+
+
+def save_tree_arrow(filename, tree, altitudes=None, attributes=None, format="arrow", row_group_size=1 << 20):
+    """
+    Export a tree and node attributes as a columnar table in the Apache Arrow IPC file format or in the Apache Parquet
+    format.
+
+    The table has one row per node of the tree, in the order of the nodes, with the columns:
+
+    - ``parent``: parent of the node;
+    - ``altitude``: altitude of the node (only if :attr:`altitudes` is not ``None``);
+    - one column per attribute in :attr:`attributes`.
+
+    The number of leaves and the category of the tree are stored in the schema metadata (keys ``higra.num_leaves``
+    and ``higra.category``) so that the tree can be rebuilt with :func:`~higra.read_tree_arrow`.
+
+    The table is written by record batches (row groups in Parquet) of :attr:`row_group_size` rows: each batch refers
+    to the memory of the input arrays without copying it, so that very large hierarchies (for example a tree read
+    with ``read_tree(filename, mmap=True)``) can be exported with a bounded memory overhead.
+    Files in the Arrow IPC format can be memory mapped and consumed without copy by any Arrow based tool.
+
+    This function requires the ``pyarrow`` package.
+
+    :param filename: path to the output file (will be overwritten if the file already exists!)
+    :param tree: input tree
+    :param altitudes: node altitudes (optional)
+    :param attributes: dictionary of node attributes, numpy 1d arrays with string keys (default ``None``)
+    :param format: ``"arrow"`` (default) or ``"parquet"``
+    :param row_group_size: number of rows per record batch (default ``2**20``)
+    :return: nothing
+    """
+    columns = [("parent", tree.parents())]
+    if altitudes is not None:
+        columns.append(("altitude", np.asarray(altitudes)))
+    if attributes is not None:
+        for name in attributes:
+            if name == "parent" or (name == "altitude" and altitudes is not None):
+                raise ValueError("Attribute name '" + name + "' is reserved.")
+            columns.append((name, np.asarray(attributes[name])))
+
+    metadata = {"higra.num_leaves": str(tree.num_leaves()),
+                "higra.category": tree.category().name}
+
+    __write_columns(filename, columns, metadata, format, row_group_size)
+
+
+def save_graph_arrow(filename, graph, edge_weights=None, attributes=None, format="arrow", row_group_size=1 << 20):
+    """
+    Export the edge list of a graph and edge attributes as a columnar table in the Apache Arrow IPC file format or in
+    the Apache Parquet format.
+
+    The table has one row per edge of the graph, in the order of the edges, with the columns:
+
+    - ``source``: source vertex of the edge;
+    - ``target``: target vertex of the edge;
+    - ``weight``: weight of the edge (only if :attr:`edge_weights` is not ``None``);
+    - one column per attribute in :attr:`attributes`.
+
+    The number of vertices of the graph is stored in the schema metadata (key ``higra.num_vertices``).
+
+    The table is written by record batches (row groups in Parquet) of :attr:`row_group_size` rows, see
+    :func:`~higra.save_tree_arrow`.
+
+    This function requires the ``pyarrow`` package.
+
+    :param filename: path to the output file (will be overwritten if the file already exists!)
+    :param graph: input graph
+    :param edge_weights: edge weights of the graph (optional)
+    :param attributes: dictionary of edge attributes, numpy 1d arrays with string keys (default ``None``)
+    :param format: ``"arrow"`` (default) or ``"parquet"``
+    :param row_group_size: number of rows per record batch (default ``2**20``)
+    :return: nothing
+    """
+    sources, targets = graph.edge_list()
+    columns = [("source", sources), ("target", targets)]
+    if edge_weights is not None:
+        columns.append(("weight", np.asarray(edge_weights)))
+    if attributes is not None:
+        for name in attributes:
+            if name in ("source", "target") or (name == "weight" and edge_weights is not None):
+                raise ValueError("Attribute name '" + name + "' is reserved.")
+            columns.append((name, np.asarray(attributes[name])))
+
+    metadata = {"higra.num_vertices": str(graph.num_vertices())}
+
+    __write_columns(filename, columns, metadata, format, row_group_size)
+
+
+def __read_table(filename):
+    import pyarrow as pa
+
+    with open(filename, "rb") as f:
+        is_parquet = f.read(4) == b"PAR1"
+
+    if is_parquet:
+        import pyarrow.parquet as pq
+        return pq.read_table(filename, memory_map=True)
+    else:
+        return pa.ipc.open_file(pa.memory_map(filename, "r")).read_all()
+
+
+def __column_to_numpy(table, name):
+    return table.column(name).to_numpy()
+
+
+def read_tree_arrow(filename):
+    """
+    Read a tree and its node attributes exported with :func:`~higra.save_tree_arrow` (the format, Arrow IPC file or
+    Parquet, is detected automatically).
+
+    Arrow IPC files are memory mapped. Attributes are also registered as tree object attributes.
+
+    This function requires the ``pyarrow`` package.
+
+    :param filename: path to the file
+    :return: a pair (tree, attribute_map), the altitudes, if any, are stored in the attribute map with the
+        key ``"altitude"``
+    """
+    table = __read_table(filename)
+    metadata = table.schema.metadata
+    if metadata is None or b"higra.num_leaves" not in metadata:
+        raise ValueError("File '" + filename + "' does not contain a tree exported with save_tree_arrow.")
+
+    num_leaves = int(metadata[b"higra.num_leaves"])
+    category = hg.TreeCategory.__members__[metadata[b"higra.category"].decode()]
+    parents = np.ascontiguousarray(__column_to_numpy(table, "parent"))
+    tree = hg.Tree.from_buffer(parents, category, num_leaves)
+
+    attribute_map = {}
+    for name in table.column_names:
+        if name != "parent":
+            attribute_map[name] = __column_to_numpy(table, name)
+            hg.set_attribute(tree, name, attribute_map[name])
+
+    return tree, attribute_map
+
+
+def read_graph_arrow(filename):
+    """
+    Read a graph and its edge attributes exported with :func:`~higra.save_graph_arrow` (the format, Arrow IPC file or
+    Parquet, is detected automatically).
+
+    This function requires the ``pyarrow`` package.
+
+    :param filename: path to the file
+    :return: a pair (graph, attribute_map), the edge weights, if any, are stored in the attribute map with the
+        key ``"weight"``
+    """
+    table = __read_table(filename)
+    metadata = table.schema.metadata
+    if metadata is None or b"higra.num_vertices" not in metadata:
+        raise ValueError("File '" + filename + "' does not contain a graph exported with save_graph_arrow.")
+
+    graph = hg.UndirectedGraph(int(metadata[b"higra.num_vertices"]))
+    graph.add_edges(__column_to_numpy(table, "source"), __column_to_numpy(table, "target"))
+
+    attribute_map = {}
+    for name in table.column_names:
+        if name not in ("source", "target"):
+            attribute_map[name] = __column_to_numpy(table, name)
+
+    return graph, attribute_map
@@ -0,0 +1,83 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+def read_graph(filename, mmap=False):
+    """
+    Read a graph and its attributes stored in the binary graph format (see :func:`~higra.save_graph`).
+
+    The edges and the out edge lists of an undirected graph are loaded in bulk, without adding the edges one by one.
+    Attributes are returned in their stored type. If a shape was stored with the graph, the graph is linked to the
+    concept :class:`~higra.CptGridGraph` and the vertex attributes are delinearized according to this shape.
+
+    If :attr:`mmap` is ``True``, the file is memory mapped instead of being read: the attributes are then read-only
+    views on the mapped file and are not copied. The pages of the file are loaded on demand and are shared, through
+    the page cache, by all the processes mapping the same file: this is the preferred way to load a large precomputed
+    graph (for example a region adjacency graph or a k-nearest neighbours graph) in several worker processes.
+
+    :param filename: path to the graph file
+    :param mmap: if ``True``, memory map the graph file (default ``False``)
+    :return: a tuple (graph, vertex_attributes, edge_attributes) where the attributes are dictionaries
+             (attribute name => array)
+    """
+    if mmap:
+        buffer = np.memmap(filename, dtype=np.uint8, mode='r')
+        graph, shape, vertex_attributes, edge_attributes = hg.cpp._read_graph_from_buffer(buffer)
+    else:
+        graph, shape, vertex_attributes, edge_attributes = hg.cpp._read_graph(filename)
+
+    if len(shape) > 0:
+        shape = tuple(shape)
+        hg.CptGridGraph.link(graph, shape)
+        for k in vertex_attributes:
+            vertex_attributes[k] = hg.delinearize_vertex_weights(vertex_attributes[k], graph, shape)
+
+    return graph, vertex_attributes, edge_attributes
+
+
+@hg.argument_helper(("graph", hg.CptGridGraph))
+def save_graph(filename, graph, vertex_attributes=None, edge_attributes=None, shape=None):
+    """
+    Save a graph and its attributes in a binary graph format.
+
+    An undirected graph is stored in compressed sparse row layout (edges and out edge lists of the vertices) such that
+    it can be loaded without adding the edges one by one (see :func:`~higra.read_graph`). A regular graph is stored
+    with the shape of its grid and its neighbour list only, and cannot have edge attributes.
+
+    Attributes must be numpy arrays stored in dictionaries with string keys (attribute names): they are stored in
+    their own type. The first dimension of a vertex attribute (after linearization according to the shape of the
+    graph) must be equal to the number of vertices of the graph, and the first dimension of an edge attribute to the
+    number of edges of the graph.
+
+    :param filename: path to the graph file (will be overwritten if the file already exists!)
+    :param graph: graph to save (:class:`~higra.UndirectedGraph` or regular graph)
+    :param vertex_attributes: dictionary of vertex attributes (optional)
+    :param edge_attributes: dictionary of edge attributes (optional)
+    :param shape: shape of the graph (optional, deduced from :class:`~higra.CptGridGraph`)
+    :return: nothing
+    """
+    if vertex_attributes is None:
+        vertex_attributes = {}
+
+    if edge_attributes is None:
+        edge_attributes = {}
+
+    vertex_attributes = {k: hg.linearize_vertex_weights(v, graph, shape) for k, v in vertex_attributes.items()}
+
+    if isinstance(graph, hg.UndirectedGraph):
+        shape = [] if shape is None else [int(s) for s in shape]
+        hg.cpp._save_graph(filename, graph, shape, vertex_attributes, edge_attributes)
+    else:
+        if len(edge_attributes) > 0:
+            raise ValueError("Edge attributes cannot be saved with a regular graph.")
+        hg.cpp._save_graph(filename, graph, vertex_attributes)
@@ -14,7 +14,8 @@ import numpy as np
 
 def read_graph_pink(filename):
     """
-    Read a graph file stored in pink ascii format
+    Read a graph file stored in pink ascii format, or in the binary pink format (see :func:`~higra.save_graph_pink`).
+    The format is detected automatically.
 
     :param filename: path to the graph file
     :return: a tuple (graph, vertex_weights, edge_weights)
@@ -28,15 +29,20 @@ def read_graph_pink(filename):
 
 
 @hg.argument_helper(("graph", hg.CptGridGraph))
-def save_graph_pink(filename, graph, vertex_weights=None, edge_weights=None, shape=None):
+def save_graph_pink(filename, graph, vertex_weights=None, edge_weights=None, shape=None, binary=False):
     """
     Save a (vertex/edge weighted) graph in the pink ascii file format.
 
+    If :attr:`binary` is ``True``, the graph is saved in a binary variant of the pink format which holds the same
+    information but is much faster to read and write, and stores weights without loss of precision.
+    Both formats are read by :func:`~higra.read_graph_pink`.
+
     :param filename: path to the graph file (will be overwritten if the file already exists!)
     :param graph: graph to save (Concept :class:`~higra.CptGridGraph`)
     :param edge_weights: edge weights of the graph (optional)
     :param vertex_weights: vertex weights of the graph (optional)
     :param shape: shape of the graph (optional) (deduced from :class:`~higra.CptGridGraph`)
+    :param binary: if ``True``, use the binary pink format (default ``False``)
     :return: nothing
     """
 
@@ -51,4 +57,9 @@ def save_graph_pink(filename, graph, vertex_weights=None, edge_weights=None, sha
 
     vertex_weights = hg.linearize_vertex_weights(vertex_weights, graph, shape)
 
-    hg.cpp._save_graph_pink(filename, graph, vertex_weights=vertex_weights, edge_weights=edge_weights, shape=shape)
+    if binary:
+        hg.cpp._save_graph_pink_binary(filename, graph, vertex_weights=vertex_weights, edge_weights=edge_weights,
+                                       shape=shape)
+    else:
+        hg.cpp._save_graph_pink(filename, graph, vertex_weights=vertex_weights, edge_weights=edge_weights,
+                                shape=shape)
@@ -0,0 +1,179 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_graph_io.hpp"
+#include "../py_common.hpp"
+#include "higra/io/graph_io.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include <fstream>
+
+namespace py = pybind11;
+
+using attribute_list = std::vector<std::pair<std::string, py::array>>;
+
+static attribute_list to_attribute_list(const std::map<std::string, py::array> &attributes) {
+    attribute_list arrays;
+    for (const auto &e: attributes) {
+        py::array array = py::array::ensure(e.second, py::array::c_style);
+        hg_assert(array && array.ndim() >= 1, "Attribute " + e.first + " must be an array.");
+        arrays.emplace_back(e.first, std::move(array));
+    }
+    return arrays;
+}
+
+static void add_attributes(hg::graph_io_internal::graph_writer &writer,
+                           hg::graph_attribute_kind kind,
+                           const attribute_list &attributes) {
+    for (const auto &e: attributes) {
+        const auto &array = e.second;
+        std::vector<size_t> shape(array.shape(), array.shape() + array.ndim());
+        hg::tree_io_dtype dtype{array.dtype().kind(), (uint64_t) array.itemsize()};
+        writer.add_raw_attribute(kind, e.first, dtype, array.data(), shape);
+    }
+}
+
+// if buffer is given, the attributes are returned as views on the buffer
+static py::dict read_attributes(hg::graph_file_reader &reader,
+                                hg::graph_attribute_kind kind,
+                                const py::object &buffer = py::object()) {
+    py::dict attributes;
+    for (const auto &name: reader.attribute_names(kind)) {
+        py::dtype dtype(reader.attribute_dtype(kind, name).str());
+        const auto &s = reader.attribute_shape(kind, name);
+        std::vector<py::ssize_t> shape(s.begin(), s.end());
+        auto data = buffer ? reader.attribute_data(kind, name) : nullptr;
+        if (data != nullptr) {
+            // the view inherits the read-only flag of the buffer and keeps it alive
+            attributes[py::str(name)] = py::array(dtype, shape, {}, data, buffer);
+        } else {
+            py::array array(dtype, shape);
+            auto array_data = array.mutable_data();
+            without_gil([&] {
+                reader.read_raw_attribute(kind, name, array_data);
+            });
+            attributes[py::str(name)] = std::move(array);
+        }
+    }
+    return attributes;
+}
+
+static py::object read_graph_structure(hg::graph_file_reader &reader) {
+    if (reader.kind() == hg::graph_file_kind::undirected) {
+        return py::cast(without_gil([&] {
+            return reader.read_undirected_graph();
+        }));
+    }
+    switch (reader.shape().size()) {
+        case 1:
+            return py::cast(reader.read_regular_graph<1>());
+        case 2:
+            return py::cast(reader.read_regular_graph<2>());
+        case 3:
+            return py::cast(reader.read_regular_graph<3>());
+        case 4:
+            return py::cast(reader.read_regular_graph<4>());
+        case 5:
+            return py::cast(reader.read_regular_graph<5>());
+        default:
+            throw std::runtime_error("Unsupported dimension of regular graph in graph file.");
+    }
+}
+
+static py::tuple read_graph(hg::graph_file_reader &reader, const py::object &buffer = py::object()) {
+    auto graph = read_graph_structure(reader);
+    return py::make_tuple(std::move(graph),
+                          reader.shape(),
+                          read_attributes(reader, hg::graph_attribute_kind::vertex, buffer),
+                          read_attributes(reader, hg::graph_attribute_kind::edge, buffer));
+}
+
+template<int dim>
+void def_save_regular_graph(pybind11::module &m) {
+    m.def("_save_graph", [](const std::string &filename,
+                            const hg::regular_graph<hg::embedding_grid<dim>> &graph,
+                            const std::map<std::string, py::array> &vertex_attributes) {
+              auto vertex_arrays = to_attribute_list(vertex_attributes);
+              without_gil([&] {
+                  std::ofstream file(filename, std::ios::binary);
+                  auto writer = hg::save_graph(file, graph);
+                  add_attributes(writer, hg::graph_attribute_kind::vertex, vertex_arrays);
+                  writer.finalize();
+              });
+          },
+          "Save a regular graph (shape and neighbour list) and vertex attributes in the binary graph format.",
+          py::arg("filename"),
+          py::arg("graph"),
+          py::arg("vertex_attributes") = std::map<std::string, py::array>());
+}
+
+void py_init_graph_io(pybind11::module &m) {
+    xt::import_numpy();
+
+    m.def("_save_graph", [](const std::string &filename,
+                            const hg::ugraph &graph,
+                            const std::vector<size_t> &shape,
+                            const std::map<std::string, py::array> &vertex_attributes,
+                            const std::map<std::string, py::array> &edge_attributes) {
+              auto vertex_arrays = to_attribute_list(vertex_attributes);
+              auto edge_arrays = to_attribute_list(edge_attributes);
+              without_gil([&] {
+                  std::ofstream file(filename, std::ios::binary);
+                  auto writer = hg::save_graph(file, graph);
+                  if (!shape.empty()) {
+                      writer.add_shape(shape);
+                  }
+                  add_attributes(writer, hg::graph_attribute_kind::vertex, vertex_arrays);
+                  add_attributes(writer, hg::graph_attribute_kind::edge, edge_arrays);
+                  writer.finalize();
+              });
+          },
+          "Save an undirected graph, its shape (may be empty) and vertex and edge attributes in the binary graph "
+          "format. Attributes must be numpy arrays stored in dictionaries with string keys (attribute names): they "
+          "are stored in their own type.",
+          py::arg("filename"),
+          py::arg("graph"),
+          py::arg("shape") = std::vector<size_t>(),
+          py::arg("vertex_attributes") = std::map<std::string, py::array>(),
+          py::arg("edge_attributes") = std::map<std::string, py::array>());
+
+    def_save_regular_graph<1>(m);
+    def_save_regular_graph<2>(m);
+    def_save_regular_graph<3>(m);
+    def_save_regular_graph<4>(m);
+    def_save_regular_graph<5>(m);
+
+    m.def("_read_graph", [](const std::string &filename) {
+              std::ifstream file(filename, std::ios::binary);
+              hg_assert(file.good(), "Cannot open graph file: " + filename);
+              hg::graph_file_reader reader(file);
+              return read_graph(reader);
+          },
+          "Read a graph saved in the binary graph format. Return a tuple (graph, shape, vertex attributes, edge "
+          "attributes): the attributes have their stored type.",
+          py::arg("filename"));
+
+    m.def("_read_graph_from_buffer", [](const py::array &buffer) {
+              hg_assert(buffer.ndim() == 1 && buffer.itemsize() == 1 && buffer.strides(0) == 1,
+                        "buffer must be a contiguous 1d array of bytes.");
+              auto data = (const char *) buffer.data();
+              size_t size = buffer.size();
+              // the numpy array is released with the last attribute array using it
+              std::shared_ptr<const void> owner(new py::object(buffer), [](py::object *o) {
+                  py::gil_scoped_acquire gil;
+                  delete o;
+              });
+              hg::graph_file_reader reader(data, size, std::move(owner));
+              return read_graph(reader, buffer);
+          },
+          "Read a graph and its attributes from a buffer holding the content of a file in the binary graph format "
+          "(typically a read-only memory mapped file). The attributes are used in place in the buffer and keep a "
+          "reference on it; the edges and the out edge lists of the graph are copied in bulk from the buffer.",
+          py::arg("buffer"));
+}
@@ -26,7 +26,25 @@ void def_save(pybind11::module &m) {
                                 const pyarray<double> &vertex_values = {0},
                                 const pyarray<double> &edge_values = {0},
                                 const std::vector<size_t> &shape = {}) {
-              hg::save_pink_graph(filename, graph, vertex_values, edge_values, shape);
+              without_gil([&] {
+                  hg::save_pink_graph(filename, graph, pyarray_view(vertex_values), pyarray_view(edge_values), shape);
+              });
+          },
+          py::arg("filename"),
+          py::arg("graph"),
+          py::arg("vertex_weights") = pyarray<double>(),
+          py::arg("edge_weights") = pyarray<double>(),
+          py::arg("shape") = std::vector<size_t>());
+
+    m.def("_save_graph_pink_binary", [](const std::string &filename,
+                                       const graph_t &graph,
+                                       const pyarray<double> &vertex_values,
+                                       const pyarray<double> &edge_values,
+                                       const std::vector<size_t> &shape) {
+              without_gil([&] {
+                  hg::save_pink_graph_binary(filename, graph, pyarray_view(vertex_values), pyarray_view(edge_values),
+                                             shape);
+              });
           },
           py::arg("filename"),
           py::arg("graph"),
@@ -41,7 +59,9 @@ void py_init_pink_io(pybind11::module &m) {
     def_save<hg::ugraph>(m);
 
     m.def("_read_graph_pink", [](const std::string &filename) {
-              auto res = hg::read_pink_graph(filename);
+              auto res = without_gil([&] {
+                  return hg::read_pink_graph(filename);
+              });
               return std::make_tuple(std::move(res.graph), std::move(res.vertex_weights), std::move(res.edge_weights),
                                      std::move(res.shape));
           },
@@ -10,6 +10,8 @@
 
 #include "py_tree_io.hpp"
 #include "higra/io/tree_io.hpp"
+#include "higra/io/tree_collection_io.hpp"
+#include "higra/io/tree_sequence_io.hpp"
 #include "../py_common.hpp"
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
@@ -18,29 +20,438 @@
 template<typename T>
 using pyarray = xt::pyarray<T>;
 
+namespace py = pybind11;
+
+static hg::tree_io_codec codec_from_string(const std::string &compression) {
+    if (compression == "none") {
+        return hg::tree_io_codec::none;
+    } else if (compression == "lz4") {
+        return hg::tree_io_codec::lz4;
+    } else if (compression == "zstd") {
+        return hg::tree_io_codec::zstd;
+    }
+    throw std::runtime_error("Unknown compression codec: " + compression);
+}
+
+static py::array read_attribute_v2(hg::tree_file_reader &reader, const std::string &name) {
+    py::array array(py::dtype(reader.attribute_dtype(name).str()), {(py::ssize_t) reader.num_vertices()});
+    auto data = array.mutable_data();
+    without_gil([&] {
+        reader.read_raw_attribute(name, data);
+    });
+    return array;
+}
+
+// if buffer is given, the uncompressed attributes are returned as views on the buffer
+static py::tuple read_tree_v2(hg::tree_file_reader &reader, const py::object &buffer = py::object()) {
+    auto tree = without_gil([&] {
+        return reader.read_tree();
+    });
+    py::dict attributes;
+    for (const auto &name: reader.attribute_names()) {
+        auto data = buffer ? reader.attribute_data(name) : nullptr;
+        if (data != nullptr) {
+            // the view inherits the read-only flag of the buffer and keeps it alive
+            attributes[py::str(name)] = py::array(py::dtype(reader.attribute_dtype(name).str()),
+                                                  {(py::ssize_t) reader.num_vertices()}, {}, data, buffer);
+        } else {
+            attributes[py::str(name)] = read_attribute_v2(reader, name);
+        }
+    }
+    return py::make_tuple(std::move(tree), std::move(attributes));
+}
+
+// tree sequence writer owning its output file
+struct py_tree_sequence_writer {
+    py_tree_sequence_writer(const std::string &filename, hg::index_t keyframe_interval) :
+            file(filename, std::ios::binary),
+            writer(file, keyframe_interval) {
+        hg_assert(file.good(), "Cannot open tree sequence file: " + filename);
+    }
+
+    std::ofstream file;
+    hg::tree_sequence_io_internal::tree_sequence_writer writer;
+};
+
+using attribute_list = std::vector<std::pair<std::string, py::array>>;
+
+static attribute_list to_attribute_list(const std::map<std::string, py::array> &attributes) {
+    attribute_list arrays;
+    for (const auto &e: attributes) {
+        py::array array = py::array::ensure(e.second, py::array::c_style);
+        hg_assert(array && array.ndim() >= 1, "Attribute " + e.first + " must be an array.");
+        arrays.emplace_back(e.first, std::move(array));
+    }
+    return arrays;
+}
+
+static hg::tree_io_dtype dtype_of(const py::array &array) {
+    return {array.dtype().kind(), (uint64_t) array.itemsize()};
+}
+
+// tree of a collection and its attributes
+struct py_collection_tree {
+    std::string name;
+    const hg::tree *tree;
+    attribute_list attributes;
+};
+
+// trees: list of tuples (name, tree, attributes), write_leaf_graph: function storing the leaf graph in the writer
+template<typename write_leaf_graph_t>
+void save_tree_collection(const std::string &filename,
+                          const py::list &trees,
+                          const std::string &compression,
+                          write_leaf_graph_t &&write_leaf_graph) {
+    auto codec = codec_from_string(compression);
+    std::vector<py_collection_tree> collection_trees;
+    for (const auto &item: trees) {
+        auto t = item.cast<py::tuple>();
+        hg_assert(t.size() == 3, "Trees must be given as tuples (name, tree, attributes).");
+        collection_trees.push_back({t[0].cast<std::string>(),
+                                    &t[1].cast<const hg::tree &>(),
+                                    to_attribute_list(t[2].cast<std::map<std::string, py::array>>())});
+    }
+    without_gil([&] {
+        std::ofstream file(filename, std::ios::binary);
+        auto writer = hg::save_tree_collection(file);
+        write_leaf_graph(writer);
+        for (const auto &t: collection_trees) {
+            auto &tree_writer = writer.add_tree(t.name, *t.tree, codec);
+            for (const auto &e: t.attributes) {
+                hg_assert(e.second.ndim() == 1 && e.second.size() == (py::ssize_t) hg::num_vertices(*t.tree),
+                          "Attribute size does not match the size of the tree: " + e.first);
+                tree_writer.add_raw_attribute(e.first, dtype_of(e.second), e.second.data(), codec);
+            }
+        }
+        writer.finalize();
+    });
+}
+
+template<int dim>
+void def_save_tree_collection_regular(pybind11::module &m) {
+    m.def("_save_tree_collection", [](const std::string &filename,
+                                      const py::list &trees,
+                                      const std::string &compression,
+                                      const hg::regular_graph<hg::embedding_grid<dim>> &graph,
+                                      const std::map<std::string, py::array> &vertex_attributes) {
+              auto vertex_arrays = to_attribute_list(vertex_attributes);
+              save_tree_collection(filename, trees, compression, [&](auto &writer) {
+                  auto &graph_writer = writer.set_leaf_graph(graph);
+                  for (const auto &e: vertex_arrays) {
+                      std::vector<size_t> shape(e.second.shape(), e.second.shape() + e.second.ndim());
+                      graph_writer.add_raw_attribute(hg::graph_attribute_kind::vertex, e.first, dtype_of(e.second),
+                                                     e.second.data(), shape);
+                  }
+              });
+          },
+          "Save trees sharing a regular leaf graph in the tree collection format.",
+          py::arg("filename"),
+          py::arg("trees"),
+          py::arg("compression"),
+          py::arg("graph"),
+          py::arg("vertex_attributes"));
+}
+
+template<typename lca_t>
+void def_save_lca(pybind11::module &m) {
+    m.def("_save_lca", [](const std::string &filename, const lca_t &lca) {
+              without_gil([&] {
+                  std::ofstream file(filename, std::ios::binary);
+                  hg::save_lca(file, lca);
+              });
+          },
+          "Save the preprocessed state of a lowest common ancestor solver in binary format.",
+          py::arg("filename"),
+          py::arg("lca"));
+}
+
 void py_init_tree_io(pybind11::module &m) {
     xt::import_numpy();
 
-    m.def("_read_tree", [](const std::string &filename) {
-              std::ifstream file(filename);
-              return hg::read_tree(file);
+    m.def("_read_tree", [](const std::string &filename) -> py::tuple {
+              std::ifstream file(filename, std::ios::binary);
+              hg_assert(file.good(), "Cannot open tree file: " + filename);
+              if (!hg::tree_io_internal::is_tree_file_v2(file)) {
+                  auto res = without_gil([&] {
+                      return hg::read_tree(file);
+                  });
+                  return py::make_tuple(std::move(res.first), std::move(res.second));
+              }
+              hg::tree_file_reader reader(file);
+              return read_tree_v2(reader);
           },
-          "Read tree from mixed ascii/binary format. Return a pair with the tree and a map of attributes (tree, dict[string => 1d array[double] ])",
+          "Read tree from the v1 (mixed ascii/binary) or v2 (binary) tree format. Return a pair with the tree and a "
+          "map of attributes (tree, dict[string => 1d array]): the attributes of a v2 file have their stored type, "
+          "those of a v1 file are double.",
           pybind11::arg("filename"));
 
-    m.def("save_tree", [](const std::string &filename, const hg::tree &tree,
-                          const std::map<std::string, pyarray<double>> &attributes) {
-              std::ofstream file(filename);
-              auto s = hg::save_tree(file, tree);
-              for (auto e: attributes) {
-                  s.add_attribute(e.first, e.second);
+    m.def("_read_tree_from_buffer", [](const py::array &buffer) {
+              hg_assert(buffer.ndim() == 1 && buffer.itemsize() == 1 && buffer.strides(0) == 1,
+                        "buffer must be a contiguous 1d array of bytes.");
+              auto data = (const char *) buffer.data();
+              size_t size = buffer.size();
+              // the numpy array is released with the last tree using it, possibly from a thread without the gil
+              std::shared_ptr<const void> owner(new py::object(buffer), [](py::object *o) {
+                  py::gil_scoped_acquire gil;
+                  delete o;
+              });
+              hg::tree_file_reader reader(data, size, std::move(owner));
+              return read_tree_v2(reader, buffer);
+          },
+          "Read a tree and its attributes from a buffer holding the content of a file in the v2 tree format "
+          "(typically a read-only memory mapped file). The parents of the tree and the attributes are used in place in "
+          "the buffer when they are not compressed: the tree and the attribute arrays then keep a reference on the "
+          "buffer.",
+          py::arg("buffer"));
+
+    m.def("_read_tree_attribute", [](const std::string &filename, const std::string &name) {
+              std::ifstream file(filename, std::ios::binary);
+              hg_assert(file.good(), "Cannot open tree file: " + filename);
+              hg::tree_file_reader reader(file);
+              return read_attribute_v2(reader, name);
+          },
+          "Read a single attribute, in its stored type, from a file in the v2 tree format.",
+          py::arg("filename"),
+          py::arg("name"));
+
+    m.def("_save_tree", [](const std::string &filename, const hg::tree &tree,
+                           const std::map<std::string, py::array> &attributes,
+                           const std::string &compression) {
+              auto codec = codec_from_string(compression);
+              std::vector<std::pair<std::string, py::array>> arrays;
+              for (const auto &e: attributes) {
+                  py::array array = py::array::ensure(e.second, py::array::c_style);
+                  hg_assert(array && array.ndim() == 1, "Attribute " + e.first + " must be a 1d array.");
+                  arrays.emplace_back(e.first, std::move(array));
               }
-              s.finalize();
+              without_gil([&] {
+                  std::ofstream file(filename, std::ios::binary);
+                  auto s = hg::save_tree(file, tree, codec);
+                  for (const auto &e: arrays) {
+                      hg_assert(e.second.size() == (py::ssize_t) hg::num_vertices(tree),
+                                "Attribute size does not match the size of the tree: " + e.first);
+                      hg::tree_io_dtype dtype{e.second.dtype().kind(), (uint64_t) e.second.itemsize()};
+                      s.add_raw_attribute(e.first, dtype, e.second.data(), codec);
+                  }
+                  s.finalize();
+              });
           },
-          "Save a tree and scalar attributes to mixed ascii/binary format. "
-          "Attributes must be numpy 1d arrays stored in a dictionary with string keys (attribute names).",
+          "Save a tree and scalar attributes to the binary v2 tree format. "
+          "Attributes must be numpy 1d arrays stored in a dictionary with string keys (attribute names): "
+          "they are stored in their own type. The arrays are compressed with the given codec "
+          "('none', 'lz4' or 'zstd').",
           pybind11::arg("filename"),
           pybind11::arg("tree"),
-          pybind11::arg("attributes") = std::map<std::string, pyarray<double>>());
-}
+          pybind11::arg("attributes") = std::map<std::string, py::array>(),
+          pybind11::arg("compression") = std::string("none"));
+
+    m.def("_save_tree_collection", [](const std::string &filename,
+                                      const py::list &trees,
+                                      const std::string &compression) {
+              save_tree_collection(filename, trees, compression, [](auto &) {});
+          },
+          "Save trees in the tree collection format, without leaf graph. Trees are given as a list of tuples "
+          "(name, tree, attributes).",
+          py::arg("filename"),
+          py::arg("trees"),
+          py::arg("compression"));
+
+    m.def("_save_tree_collection", [](const std::string &filename,
+                                      const py::list &trees,
+                                      const std::string &compression,
+                                      const hg::ugraph &graph,
+                                      const std::vector<size_t> &shape,
+                                      const std::map<std::string, py::array> &vertex_attributes) {
+              auto vertex_arrays = to_attribute_list(vertex_attributes);
+              save_tree_collection(filename, trees, compression, [&](auto &writer) {
+                  auto &graph_writer = writer.set_leaf_graph(graph);
+                  if (!shape.empty()) {
+                      graph_writer.add_shape(shape);
+                  }
+                  for (const auto &e: vertex_arrays) {
+                      std::vector<size_t> ashape(e.second.shape(), e.second.shape() + e.second.ndim());
+                      graph_writer.add_raw_attribute(hg::graph_attribute_kind::vertex, e.first, dtype_of(e.second),
+                                                     e.second.data(), ashape);
+                  }
+              });
+          },
+          "Save trees sharing an undirected leaf graph, its shape (may be empty) and vertex attributes in the tree "
+          "collection format.",
+          py::arg("filename"),
+          py::arg("trees"),
+          py::arg("compression"),
+          py::arg("graph"),
+          py::arg("shape"),
+          py::arg("vertex_attributes"));
 
+    def_save_tree_collection_regular<1>(m);
+    def_save_tree_collection_regular<2>(m);
+    def_save_tree_collection_regular<3>(m);
+    def_save_tree_collection_regular<4>(m);
+    def_save_tree_collection_regular<5>(m);
+
+    m.def("_read_tree_collection_sections", [](const std::string &filename) {
+              std::ifstream file(filename, std::ios::binary);
+              hg_assert(file.good(), "Cannot open tree collection file: " + filename);
+              hg::tree_collection_reader reader(file);
+              py::list sections;
+              for (const auto &s: reader.sections()) {
+                  bool is_graph = s.kind == hg::tree_collection_io_internal::leaf_graph_section;
+                  sections.append(py::make_tuple(is_graph ? "leaf_graph" : "tree", s.name, s.offset, s.size));
+              }
+              return sections;
+          },
+          "Read the table of contents of a tree collection file: return a list of tuples (kind, name, offset, size) "
+          "where kind is 'leaf_graph' or 'tree'. Each section is a complete graph file or tree file located at the "
+          "given offset in the collection file.",
+          py::arg("filename"));
+
+    def_save_lca<hg::lca_sparse_table>(m);
+    def_save_lca<hg::lca_sparse_table_block>(m);
+    def_save_lca<hg::lca_bitmask_block>(m);
+
+    m.def("_read_lca_from_buffer", [](const py::array &buffer) -> py::object {
+              hg_assert(buffer.ndim() == 1 && buffer.itemsize() == 1 && buffer.strides(0) == 1,
+                        "buffer must be a contiguous 1d array of bytes.");
+              auto data = (const char *) buffer.data();
+              size_t size = buffer.size();
+              // the numpy array is released with the last solver using it, possibly from a thread without the gil
+              std::shared_ptr<const void> owner(new py::object(buffer), [](py::object *o) {
+                  py::gil_scoped_acquire gil;
+                  delete o;
+              });
+              switch (hg::lca_file_algorithm(data, size)) {
+                  case 1:
+                      return py::cast(hg::read_lca<hg::lca_sparse_table>(data, size, std::move(owner)));
+                  case 2:
+                      return py::cast(hg::read_lca<hg::lca_sparse_table_block>(data, size, std::move(owner)));
+                  case 3:
+                      return py::cast(hg::read_lca<hg::lca_bitmask_block>(data, size, std::move(owner)));
+                  default:
+                      throw std::runtime_error("Unknown LCA algorithm in LCA file.");
+              }
+          },
+          "Create a lowest common ancestor solver on a buffer holding the content of a file saved with _save_lca "
+          "(typically a read-only memory mapped file). The solver uses the buffer in place and keeps a reference "
+          "on it.",
+          py::arg("buffer"));
+
+    m.def("_save_succinct_tree", [](const std::string &filename, const hg::succinct_tree &tree) {
+              without_gil([&] {
+                  std::ofstream file(filename, std::ios::binary);
+                  hg::save_succinct_tree(file, tree);
+              });
+          },
+          "Save a succinct tree in binary format.",
+          py::arg("filename"),
+          py::arg("tree"));
+
+    m.def("_read_succinct_tree", [](const std::string &filename) {
+              std::ifstream file(filename, std::ios::binary);
+              hg_assert(file.good(), "Cannot open succinct tree file: " + filename);
+              return without_gil([&] {
+                  return hg::read_succinct_tree(file);
+              });
+          },
+          "Read a succinct tree saved with _save_succinct_tree.",
+          py::arg("filename"));
+
+    m.def("_read_succinct_tree_from_buffer", [](const py::array &buffer) {
+              hg_assert(buffer.ndim() == 1 && buffer.itemsize() == 1 && buffer.strides(0) == 1,
+                        "buffer must be a contiguous 1d array of bytes.");
+              auto data = (const char *) buffer.data();
+              size_t size = buffer.size();
+              // the numpy array is released with the last succinct tree using it, possibly from a thread without the
+              // gil
+              std::shared_ptr<const void> owner(new py::object(buffer), [](py::object *o) {
+                  py::gil_scoped_acquire gil;
+                  delete o;
+              });
+              return hg::read_succinct_tree(data, size, std::move(owner));
+          },
+          "Create a succinct tree on a buffer holding the content of a file saved with _save_succinct_tree "
+          "(typically a read-only memory mapped file). The succinct tree is queried in place in the buffer and keeps "
+          "a reference on it.",
+          py::arg("buffer"));
+
+    py::class_<py_tree_sequence_writer>(m, "TreeSequenceWriter",
+                                        "Writer of a sequence of trees with node altitudes in the binary tree "
+                                        "sequence format: keyframes and compact deltas between consecutive frames.")
+            .def(py::init<const std::string &, hg::index_t>(),
+                 "Create the tree sequence file with the given name: a keyframe is stored at least every "
+                 "keyframe_interval frames.",
+                 py::arg("filename"),
+                 py::arg("keyframe_interval") = 16)
+            .def("add_frame", [](py_tree_sequence_writer &w, const hg::tree &tree, const pyarray<double> &altitudes) {
+                     without_gil([&] {
+                         w.writer.add_frame(tree, altitudes);
+                     });
+                 },
+                 "Append a frame (a tree and its node altitudes) to the sequence.",
+                 py::arg("tree"),
+                 py::arg("altitudes"))
+            .def("num_frames", [](const py_tree_sequence_writer &w) {
+                     return w.writer.num_frames();
+                 },
+                 "Number of frames added to the sequence.")
+            .def("close", [](py_tree_sequence_writer &w) {
+                     w.writer.finalize();
+                     w.file.close();
+                 },
+                 "Write the frame index and close the file. No frame can be added afterward.");
+
+    py::class_<hg::tree_sequence_reader>(m, "TreeSequenceReader",
+                                         "Random access reader of a tree sequence file: a frame is decoded from the "
+                                         "closest keyframe preceding it. Reading the frames in increasing order only "
+                                         "decodes one delta per frame.")
+            .def("num_frames", &hg::tree_sequence_reader::num_frames,
+                 "Number of frames in the sequence.")
+            .def("keyframe_interval", &hg::tree_sequence_reader::keyframe_interval,
+                 "Maximal number of frames between two keyframes.")
+            .def("is_keyframe", &hg::tree_sequence_reader::is_keyframe,
+                 "True if the given frame is stored as a keyframe, False if it is stored as a delta to the previous "
+                 "frame.",
+                 py::arg("frame"))
+            .def("frame_size", &hg::tree_sequence_reader::frame_size,
+                 "Size in bytes of the given encoded frame in the file.",
+                 py::arg("frame"))
+            .def("read_frame", [](hg::tree_sequence_reader &r, hg::index_t frame) {
+                     auto res = without_gil([&] {
+                         return r.read_frame(frame);
+                     });
+                     return py::make_tuple(std::move(res.first), std::move(res.second));
+                 },
+                 "Read the given frame: return a pair (tree, altitudes).",
+                 py::arg("frame"))
+            .def("__len__", &hg::tree_sequence_reader::num_frames)
+            .def("__getitem__", [](hg::tree_sequence_reader &r, hg::index_t frame) {
+                     const auto num_frames = (hg::index_t) r.num_frames();
+                     if (frame < 0) {
+                         frame += num_frames;
+                     }
+                     if (frame < 0 || frame >= num_frames) {
+                         throw py::index_error("Frame index out of range.");
+                     }
+                     auto res = without_gil([&] {
+                         return r.read_frame(frame);
+                     });
+                     return py::make_tuple(std::move(res.first), std::move(res.second));
+                 },
+                 py::arg("frame"));
+
+    m.def("_read_tree_sequence_from_buffer", [](const py::array &buffer) {
+              hg_assert(buffer.ndim() == 1 && buffer.itemsize() == 1 && buffer.strides(0) == 1,
+                        "buffer must be a contiguous 1d array of bytes.");
+              auto data = (const char *) buffer.data();
+              size_t size = buffer.size();
+              // the numpy array is released with the reader
+              std::shared_ptr<const void> owner(new py::object(buffer), [](py::object *o) {
+                  py::gil_scoped_acquire gil;
+                  delete o;
+              });
+              return hg::tree_sequence_reader(data, size, std::move(owner));
+          },
+          "Create a tree sequence reader on a buffer holding the content of a tree sequence file (typically a "
+          "read-only memory mapped file). The reader keeps a reference on the buffer.",
+          py::arg("buffer"));
+}
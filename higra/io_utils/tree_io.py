@@ -12,23 +12,143 @@ import higra as hg
 import numpy as np
 
 
-def read_tree(filename):
+def read_tree(filename, lca_index=False, mmap=False):
     """
-    Read a tree stored in mixed ascii/binary format.
+    Read a tree stored in the binary tree format (see :func:`~higra.save_tree`), or in the former mixed ascii/binary
+    format.
 
-    Attributes are also registered as tree object attributes.
+    Attributes are also registered as tree object attributes. Attributes are returned in their stored type
+    (the attributes of a file in the former format are double arrays).
+
+    If :attr:`mmap` is ``True``, the file is memory mapped instead of being read: the parents of the tree and the
+    attributes that are not compressed are then read-only views on the mapped file and nothing is copied. The pages of
+    the file are loaded on demand and are shared, through the page cache, by all the processes mapping the same file:
+    this is the preferred way to load a large hierarchy in several worker processes. The mapping is released when the
+    tree and all the attribute arrays are deleted. Files in the former mixed ascii/binary format cannot be mapped and
+    are read normally.
+
+    If :attr:`lca_index` is ``True``, the lowest common ancestor index saved next to the tree
+    (see :func:`~higra.save_tree`) is memory mapped from the file ``filename + ".lca"`` and attached to the tree:
+    it is then used by :func:`~higra.Tree.lowest_common_ancestor_preprocess` without any recomputation.
 
     :param filename: path to the tree file
+    :param lca_index: if ``True``, also load the lowest common ancestor index of the tree (default ``False``)
+    :param mmap: if ``True``, memory map the tree file (default ``False``)
     :return: a pair (tree, attribute_map)
     """
-    tree, attribute_map = hg.cpp._read_tree(filename)
+    buffer = np.memmap(filename, dtype=np.uint8, mode='r') if mmap else None
+    if buffer is not None and buffer[:8].tobytes() == b"HGTREEV2":
+        tree, attribute_map = hg.cpp._read_tree_from_buffer(buffer)
+    else:
+        tree, attribute_map = hg.cpp._read_tree(filename)
 
     for k in attribute_map:
         hg.set_attribute(tree, k, attribute_map[k])
 
+    if lca_index:
+        buffer = np.memmap(filename + ".lca", dtype=np.uint8, mode='r')
+        lca = hg.cpp._read_lca_from_buffer(buffer)
+        if lca.num_elements() != tree.num_vertices():
+            raise ValueError("The lowest common ancestor index does not match the tree.")
+        hg.set_attribute(tree, "lca_fast", lca)
+
     return tree, attribute_map
 
 
+def read_tree_attribute(filename, name):
+    """
+    Read a single attribute, in its stored type, from a tree file saved with :func:`~higra.save_tree`.
+
+    Only the requested attribute is read from the file.
+
+    :param filename: path to the tree file
+    :param name: name of the attribute
+    :return: a 1d array
+    """
+    return hg.cpp._read_tree_attribute(filename, name)
+
+
+def save_tree(filename, tree, attributes=None, lca_index=False, compression="none"):
+    """
+    Save a tree and scalar attributes to binary format.
+
+    Attributes must be numpy 1d arrays stored in a dictionary with string keys (attribute names). They are stored
+    in their own type (boolean, integral or floating point) and can be read independently with
+    :func:`~higra.read_tree_attribute`.
+
+    The parents and the attributes are compressed by blocks with the given :attr:`compression` codec:
+    ``"none"``, ``"lz4"`` or ``"zstd"``. The compression codecs are only available if Higra was built with them.
+
+    If :attr:`lca_index` is ``True``, the lowest common ancestor index of the tree
+    (see :func:`~higra.Tree.lowest_common_ancestor_preprocess`) is saved in binary format in the file
+    ``filename + ".lca"``. It can then be loaded without recomputation with :func:`~higra.read_tree`.
+
+    :param filename: path to the tree file
+    :param tree: input tree
+    :param attributes: dictionary of node attributes (default ``None``)
+    :param lca_index: if ``True``, also save the lowest common ancestor index of the tree (default ``False``)
+    :param compression: compression codec (default ``"none"``)
+    :return: nothing
+    """
+    if attributes is None:
+        attributes = {}
+
+    hg.cpp._save_tree(filename, tree, attributes, compression)
+
+    if lca_index:
+        hg.cpp._save_lca(filename + ".lca", tree.lowest_common_ancestor_preprocess())
+
+
+def save_succinct_tree(filename, tree):
+    """
+    Save a tree in the succinct balanced parentheses format (see :class:`~higra.SuccinctTree`): its topology is
+    stored in about 2.4 bits per node, instead of 64 bits per node for the parents array of a
+    :class:`~higra.Tree`.
+
+    :attr:`tree` can be a :class:`~higra.Tree` or a :class:`~higra.SuccinctTree`. As the nodes of a succinct tree are
+    numbered in preorder, the node attributes of a :class:`~higra.Tree` must be reordered with the returned
+    ``node_map`` (``attribute[node_map]``) to be stored along the succinct tree (see :func:`~higra.make_succinct_tree`).
+
+    :Example:
+
+    >>> node_map = hg.save_succinct_tree("tree.bp", tree)
+    >>> np.save("altitudes.npy", altitudes[node_map])
+    >>> stree = hg.read_succinct_tree("tree.bp", mmap=True)
+    >>> altitudes = np.load("altitudes.npy", mmap_mode='r')
+    >>> altitudes[stree.parent(42)]
+
+    :param filename: path to the succinct tree file
+    :param tree: input tree (:class:`~higra.Tree` or :class:`~higra.SuccinctTree`)
+    :return: if :attr:`tree` is a :class:`~higra.Tree`, the node of :attr:`tree` corresponding to each node of the
+             succinct tree, ``None`` otherwise
+    """
+    if isinstance(tree, hg.Tree):
+        tree, node_map = hg.make_succinct_tree(tree)
+    else:
+        node_map = None
+
+    hg.cpp._save_succinct_tree(filename, tree)
+    return node_map
+
+
+def read_succinct_tree(filename, mmap=False):
+    """
+    Read a succinct tree saved with :func:`~higra.save_succinct_tree`.
+
+    If :attr:`mmap` is ``True``, the file is memory mapped instead of being read: the succinct tree is then queried
+    in place in the mapped file and nothing is loaded in memory except the pages touched by the queries. Use
+    :func:`~higra.SuccinctTree.to_tree` to convert the succinct tree back to a :class:`~higra.Tree`.
+
+    :param filename: path to the succinct tree file
+    :param mmap: if ``True``, memory map the file (default ``False``)
+    :return: a :class:`~higra.SuccinctTree`
+    """
+    if mmap:
+        buffer = np.memmap(filename, dtype=np.uint8, mode='r')
+        return hg.cpp._read_succinct_tree_from_buffer(buffer)
+    return hg.cpp._read_succinct_tree(filename)
+
+
 def print_partition_tree(tree, *,
                altitudes=None,
                attribute=None,
@@ -213,3 +333,227 @@ def print_partition_tree(tree, *,
         print(r)
     else:
         return r
+
+
+def save_tree_sequence(filename, trees, altitudes, keyframe_interval=16):
+    """
+    Save a sequence of trees with node altitudes, typically the hierarchies of the frames of a video, in the binary
+    tree sequence format.
+
+    A frame is stored as a keyframe every :attr:`keyframe_interval` frames and as a delta to the previous frame
+    otherwise: the delta only holds the nodes whose parent or altitude changed, their parents as variable length
+    integers and their altitudes with a XOR float encoding. A frame whose number of nodes changes, or whose delta is
+    not smaller than a keyframe (for example if the nodes are renumbered), is stored as a keyframe. Deltas are thus
+    only compact if the nodes keep their indices from one frame to the next.
+
+    Altitudes are stored as double. Frames can also be appended one at a time with a :class:`~higra.TreeSequenceWriter`.
+
+    :param filename: path to the tree sequence file
+    :param trees: iterable of trees
+    :param altitudes: iterable of node altitudes (one 1d array per tree)
+    :param keyframe_interval: maximal number of frames between two keyframes (default 16)
+    :return: nothing
+    """
+    writer = hg.TreeSequenceWriter(filename, keyframe_interval)
+    for tree, tree_altitudes in zip(trees, altitudes):
+        writer.add_frame(tree, tree_altitudes)
+    writer.close()
+
+
+def read_tree_sequence(filename):
+    """
+    Open a tree sequence file saved with :func:`~higra.save_tree_sequence`.
+
+    The file is memory mapped and the returned :class:`~higra.TreeSequenceReader` decodes the frames on demand:
+    ``reader[i]`` (or ``reader.read_frame(i)``) returns the pair ``(tree, altitudes)`` of the i-th frame, decoded from
+    the closest keyframe preceding it. Reading the frames in increasing order only decodes one delta per frame.
+
+    :Example:
+
+    >>> reader = hg.read_tree_sequence("video.hgseq")
+    >>> tree, altitudes = reader[42]
+    >>> for tree, altitudes in reader:
+    >>>     ...
+
+    :param filename: path to the tree sequence file
+    :return: a :class:`~higra.TreeSequenceReader`
+    """
+    buffer = np.memmap(filename, dtype=np.uint8, mode='r')
+    return hg.cpp._read_tree_sequence_from_buffer(buffer)
+
+
+def save_tree_collection(filename, trees, leaf_graph=None, vertex_attributes=None, shape=None, compression="none"):
+    """
+    Save several hierarchies of the same data (for example the trees of the channels of an image, or several
+    watershed hierarchies) in a single tree collection file, with the leaf graph they share.
+
+    :attr:`trees` is a dictionary whose keys are the names of the trees and whose values are either trees or pairs
+    ``(tree, attributes)`` where ``attributes`` is a dictionary of node attributes (see :func:`~higra.save_tree`).
+    All the trees must have the same number of leaves.
+
+    The leaf graph (default to the leaf graph of the first tree, if any, see :class:`~higra.CptHierarchy`) is stored
+    once with its vertex attributes, for example the image, and its shape (default to the shape of
+    :class:`~higra.CptGridGraph`), see :func:`~higra.save_graph`. Each tree is stored with its attributes as a tree file
+    in its own section of the collection: the trees can then be loaded one by one and lazily with
+    :func:`~higra.read_tree_collection`.
+
+    :Example:
+
+    >>> trees = {}
+    >>> for c in range(3):
+    >>>     edge_weights = hg.weight_graph(graph, image[:, :, c], hg.WeightFunction.L1)
+    >>>     tree, altitudes = hg.watershed_hierarchy_by_area(graph, edge_weights)
+    >>>     trees["channel" + str(c)] = (tree, {"altitudes": altitudes})
+    >>> hg.save_tree_collection("trees.hgcol", trees, graph, {"image": image})
+    >>> collection = hg.read_tree_collection("trees.hgcol")
+    >>> tree, attributes = collection["channel1"]
+
+    :param filename: path to the tree collection file
+    :param trees: dictionary of trees (tree name => tree or pair (tree, attribute dictionary))
+    :param leaf_graph: leaf graph shared by the trees (optional)
+    :param vertex_attributes: dictionary of vertex attributes of the leaf graph (optional)
+    :param shape: shape of the leaf graph (optional, deduced from :class:`~higra.CptGridGraph`)
+    :param compression: compression codec of the trees and of their attributes (default ``"none"``, see
+           :func:`~higra.save_tree`)
+    :return: nothing
+    """
+    tree_list = []
+    for name, value in trees.items():
+        if isinstance(value, hg.Tree):
+            tree, attributes = value, {}
+        else:
+            tree, attributes = value
+        tree_list.append((name, tree, {k: np.asarray(v) for k, v in attributes.items()}))
+
+    if leaf_graph is None and len(tree_list) > 0 and hg.CptHierarchy.validate(tree_list[0][1]):
+        leaf_graph = hg.CptHierarchy.get_leaf_graph(tree_list[0][1])
+
+    if vertex_attributes is None:
+        vertex_attributes = {}
+
+    if leaf_graph is None:
+        if len(vertex_attributes) > 0:
+            raise ValueError("Vertex attributes cannot be saved without leaf graph.")
+        hg.cpp._save_tree_collection(filename, tree_list, compression)
+        return
+
+    if shape is None and hg.CptGridGraph.validate(leaf_graph):
+        shape = hg.CptGridGraph.get_shape(leaf_graph)
+
+    vertex_attributes = {k: hg.linearize_vertex_weights(v, leaf_graph, shape) for k, v in vertex_attributes.items()}
+
+    if isinstance(leaf_graph, hg.UndirectedGraph):
+        shape = [] if shape is None else [int(s) for s in shape]
+        hg.cpp._save_tree_collection(filename, tree_list, compression, leaf_graph, shape, vertex_attributes)
+    else:
+        hg.cpp._save_tree_collection(filename, tree_list, compression, leaf_graph, vertex_attributes)
+
+
+class TreeCollection:
+    """
+    Tree collection file opened with :func:`~higra.read_tree_collection`: the leaf graph and the trees are read on
+    demand, only the table of contents of the file is read at creation.
+
+    ``collection[name]`` returns the pair ``(tree, attributes)`` of the tree with the given name, linked to the leaf
+    graph of the collection (see :class:`~higra.CptHierarchy`). Iterating on a collection gives the tree names.
+    """
+
+    def __init__(self, filename, mmap=True):
+        self.filename = filename
+        self.mmap = mmap
+        self.__buffer = np.memmap(filename, dtype=np.uint8, mode='r') if mmap else None
+        self.__sections = {}
+        self.__names = []
+        self.__leaf_graph_section = None
+        self.__leaf_graph = None
+        for kind, name, offset, size in hg.cpp._read_tree_collection_sections(filename):
+            if kind == "leaf_graph":
+                self.__leaf_graph_section = (offset, size)
+            else:
+                self.__names.append(name)
+                self.__sections[name] = (offset, size)
+
+    def __section_buffer(self, offset, size):
+        if self.__buffer is not None:
+            return self.__buffer[offset:offset + size]
+        return np.fromfile(self.filename, dtype=np.uint8, count=size, offset=offset)
+
+    def names(self):
+        """
+        Names of the trees of the collection, in storage order.
+
+        :return: a list of strings
+        """
+        return list(self.__names)
+
+    def __len__(self):
+        return len(self.__names)
+
+    def __iter__(self):
+        return iter(self.names())
+
+    def __contains__(self, name):
+        return name in self.__sections
+
+    def has_leaf_graph(self):
+        """
+        True if the collection contains a leaf graph.
+        """
+        return self.__leaf_graph_section is not None
+
+    def leaf_graph(self):
+        """
+        Read the leaf graph of the collection and its vertex attributes (see :func:`~higra.read_graph`). The graph is
+        read once and shared by all the trees read from the collection.
+
+        :return: a pair (graph, vertex_attributes), or ``(None, {})`` if the collection has no leaf graph
+        """
+        if self.__leaf_graph is None:
+            if self.__leaf_graph_section is None:
+                return None, {}
+            buffer = self.__section_buffer(*self.__leaf_graph_section)
+            graph, shape, vertex_attributes, _ = hg.cpp._read_graph_from_buffer(buffer)
+            if len(shape) > 0:
+                shape = tuple(shape)
+                hg.CptGridGraph.link(graph, shape)
+                for k in vertex_attributes:
+                    vertex_attributes[k] = hg.delinearize_vertex_weights(vertex_attributes[k], graph, shape)
+            self.__leaf_graph = (graph, vertex_attributes)
+        return self.__leaf_graph
+
+    def read_tree(self, name):
+        """
+        Read the tree with the given name and its attributes. With a memory mapped collection, the parents of the tree
+        and its uncompressed attributes are read-only views on the mapped file.
+
+        :param name: name of the tree
+        :return: a pair (tree, attribute_map)
+        """
+        if name not in self.__sections:
+            raise KeyError("Unknown tree in tree collection: " + str(name))
+        tree, attribute_map = hg.cpp._read_tree_from_buffer(self.__section_buffer(*self.__sections[name]))
+        for k in attribute_map:
+            hg.set_attribute(tree, k, attribute_map[k])
+        if self.has_leaf_graph():
+            hg.CptHierarchy.link(tree, self.leaf_graph()[0])
+        return tree, attribute_map
+
+    def __getitem__(self, name):
+        return self.read_tree(name)
+
+
+def read_tree_collection(filename, mmap=True):
+    """
+    Open a tree collection file saved with :func:`~higra.save_tree_collection`.
+
+    Only the table of contents of the file is read: the trees are then read one by one on demand with
+    ``collection[name]`` (see :class:`~higra.TreeCollection`), without reading the other trees of the collection.
+    If :attr:`mmap` is ``True``, the file is memory mapped and the trees and their uncompressed attributes are used
+    in place in the mapped file (see :func:`~higra.read_tree`); otherwise, only the section of the requested tree is
+    read from the file.
+
+    :param filename: path to the tree collection file
+    :param mmap: if ``True``, memory map the file (default ``True``)
+    :return: a :class:`~higra.TreeCollection`
+    """
+    return TreeCollection(filename, mmap)
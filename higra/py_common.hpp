@@ -9,11 +9,14 @@
 ****************************************************************************/
 
 #pragma once
+#include "higra/detail/memory_tracking.hpp"
 #include "xtl/xmeta_utils.hpp"
 #include "pybind11/stl.h"
 #include "pybind11/functional.h"
 #include "higra/utils.hpp"
+#include "xtensor/xadapt.hpp"
 #include <functional>
+#include <vector>
 
 
 template <typename F, typename T, typename module_t, typename... Args>
@@ -28,3 +31,30 @@ add_type_overloads(module_t & m, const char * doc, Args&&... args){
     add_type_overloads<F, Ts...>(m, "", std::forward<Args>(args)...);
 };
 
+
+/**
+ * Non owning xtensor view of the buffer of a numpy backed array.
+ *
+ * Expressions built on a pyarray/pytensor may allocate numpy backed temporaries (for example with xt::empty_like),
+ * which requires the GIL: algorithms running inside a without_gil section must thus receive their array arguments
+ * through this adaptor. The adapted array must outlive the returned view.
+ */
+template<typename T>
+auto pyarray_view(const T &array) {
+    using value_type = typename T::value_type;
+    std::vector<std::size_t> shape(array.shape().begin(), array.shape().end());
+    std::vector<std::ptrdiff_t> strides(array.strides().begin(), array.strides().end());
+    return xt::adapt(array.data(), array.size(), xt::no_ownership(), std::move(shape), std::move(strides));
+}
+
+/**
+ * Calls fun() with the GIL released and returns its result.
+ *
+ * fun must not touch any Python object: numpy backed arrays must be wrapped with pyarray_view and the result must be
+ * made of C++ containers (Python objects are created after the GIL is acquired back).
+ */
+template<typename F>
+auto without_gil(F &&fun) -> decltype(fun()) {
+    pybind11::gil_scoped_release release;
+    return fun();
+}
@@ -67,32 +67,32 @@ struct def_stable_arg_sort {
     }
 };
 
-#ifdef HG_USE_TBB
-static size_t max_threads = tbb::task_scheduler_init::default_num_threads();
-static tbb::task_scheduler_init tbb_scheduler(tbb::task_scheduler_init::default_num_threads());
-#endif
+struct def_stable_arg_sort_warm_start {
+    template<typename value_t, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_stable_arg_sort_warm_start", [](const pyarray<value_t> &array,
+                                                const pyarray<hg::index_t> &initial_order) {
+                  hg_assert_1d_array(array);
+                  hg_assert_1d_array(initial_order);
+                  hg_assert(initial_order.size() == 0 || initial_order.size() == array.size(),
+                            "The initial order must have the same size as the array to sort.");
+                  hg_assert(initial_order.size() == 0 ||
+                            (xt::amin(initial_order)() >= 0 && xt::amax(initial_order)() < (hg::index_t) array.size()),
+                            "The initial order contains invalid indices.");
+                  return hg::stable_arg_sort_warm_start(array, initial_order);
+              },
+              doc,
+              py::arg("array"),
+              py::arg("initial_order"));
+    }
+};
 
 void py_init_sorting(pybind11::module &m) {
 
-    m.def("set_num_threads", [](size_t num_threads) {
-#ifdef HG_USE_TBB
-              if (num_threads == 0) {
-                  num_threads = max_threads;
-              }
-              if (tbb_scheduler.is_active()) {
-                  tbb_scheduler.terminate();
-              }
-              tbb_scheduler.initialize(num_threads);
-#else
-              HG_LOG_WARNING("Warning: trying to set maximum number of threads but Higra was compiled without multi-threading!");
-#endif
-          },
-          "Set the maximum number of threads usable in parallel computing. If :attr:`num_threads` is equal to 0, "
-          "the maximum number of threads resets to its default value (number of logical cores available on the machine).",
-          py::arg("num_threads"));
-
     add_type_overloads<def_sort, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
     add_type_overloads<def_stable_sort, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
     add_type_overloads<def_arg_sort, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
     add_type_overloads<def_stable_arg_sort, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
+    add_type_overloads<def_stable_arg_sort_warm_start, HG_TEMPLATE_NUMERIC_TYPES>(m, "");
 }
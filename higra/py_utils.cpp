@@ -0,0 +1,95 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2026)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_common.hpp"
+#include "py_utils.hpp"
+
+namespace py = pybind11;
+
+void py_init_utils(pybind11::module &m) {
+
+    m.def("set_num_threads", [](hg::index_t num_threads) {
+              hg::set_num_threads(num_threads);
+          },
+          "Set the maximum number of threads usable in parallel computing. If :attr:`num_threads` is equal to 0, "
+          "the maximum number of threads resets to its default value (number of logical cores available on the machine).",
+          py::arg("num_threads"));
+
+    m.def("get_num_threads", &hg::get_num_threads,
+          "Maximum number of threads usable in parallel computing by a function called from the current thread "
+          "(1 if Higra was compiled without multi-threading), see :func:`~higra.set_num_threads` and "
+          ":func:`~higra.thread_limit`.");
+
+    m.def("_get_thread_limit", []() {
+        return hg::parallel_internal::current_thread_limit();
+    });
+
+    m.def("_set_thread_limit", [](hg::index_t num_threads) {
+              hg::parallel_internal::current_thread_limit() = num_threads;
+          },
+          py::arg("num_threads"));
+
+    m.def("set_deterministic", &hg::set_deterministic,
+          "Enable or disable the deterministic mode for the whole process. In deterministic mode, the parallel "
+          "floating point reductions (:func:`~higra.accumulate_at`, contour attributes...) split their input into "
+          "a number of blocks that only depends on its size and combine the partial results in a fixed order: their "
+          "results are bit reproducible whatever the number of threads. See :func:`~higra.deterministic`.",
+          py::arg("deterministic"));
+
+    m.def("is_deterministic", &hg::is_deterministic,
+          "True if the deterministic mode is enabled, see :func:`~higra.set_deterministic`.");
+
+    m.def("set_validation_level", [](const std::string &level) {
+              if (level == "shape") {
+                  hg::set_validation_level(hg::validation_level::shape);
+              } else if (level == "full") {
+                  hg::set_validation_level(hg::validation_level::full);
+              } else {
+                  throw std::runtime_error("Unknown validation level '" + level + "', must be 'shape' or 'full'.");
+              }
+          },
+          "Set the validation level of the inputs for the whole process. With ``\"full\"`` (default), all the checks "
+          "are done. With ``\"shape\"``, only the constant time checks on the dimensions and shapes of the arrays "
+          "are done: the checks scanning whole arrays (for example the range of an array of vertex indices) are "
+          "skipped, invalid inputs may then lead to undefined behaviour. See :func:`~higra.validation_level`.",
+          py::arg("level"));
+
+    m.def("get_validation_level", []() {
+              return hg::get_validation_level() == hg::validation_level::full ? "full" : "shape";
+          },
+          "Current validation level of the inputs (``\"shape\"`` or ``\"full\"``), see "
+          ":func:`~higra.set_validation_level`.");
+
+    m.def("_is_content_validation_enabled", &hg::is_content_validation_enabled);
+
+    py::register_exception<hg::operation_cancelled>(m, "OperationCancelled", PyExc_RuntimeError);
+
+    py::class_<hg::cancellation_token>(
+            m, "CancellationToken",
+            "Cooperative cancellation of long computations, see :func:`~higra.cancellation_scope`.")
+            .def(py::init<>())
+            .def("cancel", &hg::cancellation_token::cancel,
+                 "Request the cancellation of the computations running with this token: they raise "
+                 ":class:`~higra.OperationCancelled` at their next cancellation point. Can be called from any thread.")
+            .def("cancelled", &hg::cancellation_token::cancelled,
+                 "True if the token has been cancelled.")
+            .def("reset", &hg::cancellation_token::reset,
+                 "Clear the cancellation request.");
+
+    m.def("_get_cancellation_token", []() {
+              return hg::cancellation_internal::current_token();
+          },
+          py::return_value_policy::reference);
+
+    m.def("_set_cancellation_token", [](hg::cancellation_token *token) {
+              hg::cancellation_internal::current_token() = token;
+          },
+          py::arg("token").none(true));
+}
@@ -0,0 +1,16 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2026)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "pybind11/pybind11.h"
+
+
+void py_init_utils(pybind11::module &m);
@@ -11,6 +11,7 @@
 #include "pybind11/pybind11.h"
 
 #include "all.hpp"
+#include "higra/utils.hpp"
 
 #include "xtl/xmeta_utils.hpp"
 
@@ -34,7 +35,10 @@ PYBIND11_MODULE(higram, m) {
     m.attr("__version__") = "dev";
 #endif
     xt::import_numpy();
+    // numpy dtype of hg::index_t: int64 by default, int32 if Higra is compiled with HG_INDEX_32
+    m.attr("index_t") = pybind11::dtype::of<hg::index_t>();
     py_init_accumulators(m);
+    py_init_affinity_clustering(m);
     py_init_algo_graph_core(m);
     py_init_algo_tree(m);
     py_init_alignement(m);
@@ -44,22 +48,33 @@ PYBIND11_MODULE(higram, m) {
     py_init_binary_partition_tree(m);
     py_init_common_hierarchy(m);
     py_init_component_tree(m);
+    py_init_connected_filter_pipeline(m);
+    py_init_constrained_connectivity_hierarchy(m);
     py_init_contour_2d(m);
+    py_init_dataset_assessment(m);
     py_init_embedding(m);
     py_init_graph_accumulator(m);
     py_init_graph_image(m);
+    py_init_graph_io(m);
     py_init_graph_weights(m);
     py_init_fragmentation_curve(m);
+    py_init_hierarchical_cost(m);
+    py_init_hdbscan(m);
+    py_init_hierarchy_batch(m);
     py_init_hierarchy_core(m);
     py_init_hierarchy_mean_pb(m);
     py_init_horizontal_cuts(m);
     py_init_lca_fast(m);
+    py_init_leaf_ranges(m);
+    py_init_level_ancestors(m);
     py_init_log(m);
     py_init_pink_io(m);
     py_init_rag(m);
+    py_init_random_hierarchy(m);
     py_init_regular_graph(m);
     py_init_scipy(m);
     py_init_sorting(m);
+    py_init_succinct_tree(m);
     py_init_tree_accumulator(m);
     py_init_tree_contour_accumulator(m);
     py_init_tree_energy_optimization(m);
@@ -68,7 +83,10 @@ PYBIND11_MODULE(higram, m) {
     py_init_tree_io(m);
     py_init_tree_of_shapes_image(m);
     py_init_tree_monotonic_regression(m);
+    py_init_ultrametric_leaf_index(m);
     py_init_undirected_graph(m);
+    py_init_utils(m);
     py_init_watershed(m);
     py_init_watershed_hierarchy(m);
+    py_init_workspace(m);
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 ############################################################################
 
 import higra as hg
+import numpy as np
 
 
 def sort(array, stable=False):
@@ -35,10 +36,16 @@ def sort(array, stable=False):
         return hg.cpp._sort(array)
 
 
-def arg_sort(array, stable=False):
+def arg_sort(array, stable=False, initial_order=None):
     """
     Returns the indices that would sort an array. A parallel algorithm is used if possible.
 
+    If :attr:`initial_order` is given, the 1d array is sorted starting from this permutation of its indices, typically
+    the result of the arg sort of a previous version of the array whose values have only slightly changed (for example
+    the edge weights of the previous frame of a video). The cost then depends on how much the order has changed: the
+    elements out of order in :attr:`initial_order` are sorted and merged with the others. The sort is stable and the
+    result is identical to the one of ``hg.arg_sort(array, stable=True)``.
+
     If :attr:`stable` is ``True``, the relative order of equivalent elements is maintained (otherwise the ordering of
     equivalent elements may be arbitrary or even non deterministic).
 
@@ -57,8 +64,11 @@ def arg_sort(array, stable=False):
 
     :param array: input array (1d or 2d)
     :param stable: if ``True``, a stable sort is performed.
+    :param initial_order: a permutation of the indices of the input 1d array used as a starting point of the sort (optional)
     :return: A 1d array of indices that would sort the input array
     """
+    if initial_order is not None:
+        return hg.cpp._stable_arg_sort_warm_start(array, hg.cast_to_dtype(initial_order, np.int64))
     if stable:
         return hg.cpp._stable_arg_sort(array)
     else:
@@ -10,6 +10,9 @@
 
 from .embedding import *
 from .lca_fast import *
+from .level_ancestors import *
 from .regular_graph import *
+from .succinct_tree import *
 from .tree_graph import *
+from .ultrametric_leaf_index import *
 from .undirected_graph import *
@@ -12,6 +12,11 @@
 
 #include "py_embedding.hpp"
 #include "py_lca_fast.hpp"
+#include "py_leaf_ranges.hpp"
+#include "py_level_ancestors.hpp"
 #include "py_regular_graph.hpp"
+#include "py_succinct_tree.hpp"
 #include "py_tree_graph.hpp"
+#include "py_ultrametric_leaf_index.hpp"
 #include "py_undirected_graph.hpp"
+#include "py_workspace.hpp"
@@ -18,3 +18,8 @@ import higra as hg
 @hg.extend_class(hg.EmbeddingGrid5d, method_name="__reduce__")
 def ____reduce__(self):
     return self.__class__, (self.shape(),), self.__dict__
+
+
+@hg.extend_class(hg.EmbeddingMorton2d, method_name="__reduce__")
+def ____reduce__(self):
+    return self.__class__, (self.shape(), self.tile_size()), self.__dict__
@@ -29,6 +29,12 @@ def __reduce_ctr_lca_stb(*args):
     return hg.LCA_rmq_sparse_table_block._make_from_state(args)
 
 
+def __reduce_ctr_lca_bmb(*args):
+    return hg.LCA_rmq_bitmask_block._make_from_state(args)
+
+
+# the state arrays are views on the solver: with pickle protocol 5, numpy exports them out-of-band without copy, and
+# the unpickled solver uses the received buffers in place
 @hg.extend_class(hg.LCA_rmq_sparse_table, method_name="__reduce__")
 def ____reduce__(self):
     return __reduce_ctr_lca_st, self._get_state(), self.__dict__
@@ -39,4 +45,9 @@ def ____reduce__(self):
     return __reduce_ctr_lca_stb, self._get_state(), self.__dict__
 
 
+@hg.extend_class(hg.LCA_rmq_bitmask_block, method_name="__reduce__")
+def ____reduce__(self):
+    return __reduce_ctr_lca_bmb, self._get_state(), self.__dict__
+
+
 LCAFast = hg.LCA_rmq_sparse_table_block
@@ -14,6 +14,7 @@
 #include "xtensor-python/pyarray.hpp"
 #include "xtensor-python/pytensor.hpp"
 #include "higra/structure/embedding.hpp"
+#include "higra/structure/embedding_morton.hpp"
 #include "xtensor/xeval.hpp"
 #include <string>
 
@@ -123,6 +124,85 @@ void py_init_embedding_impl(pybind11::module &m) {
 
 }
 
+struct def_morton_order_conversions {
+    template<typename type, typename C>
+    static
+    void def(C &c, const char *) {
+        c.def("to_morton_order",
+              [](const embedding_morton_2d &e, const pyarray<type> &image) {
+                  return to_morton_order(e, image);
+              },
+              "Reorder the pixels of an image of shape (height, width, ...) in the linear order of the embedding: "
+              "returns an array of shape (height * width, ...) whose element self.grid2lin((i, j)) is the pixel (i, j).",
+              py::arg("image"));
+        c.def("to_row_major_order",
+              [](const embedding_morton_2d &e, const pyarray<type> &values) {
+                  return to_row_major_order(e, values);
+              },
+              "Reorder an array of shape (height * width, ...) given in the linear order of the embedding into "
+              "an image of shape (height, width, ...) (inverse of to_morton_order).",
+              py::arg("values"));
+    }
+};
+
+void py_init_embedding_morton(pybind11::module &m) {
+
+    using class_t = embedding_morton_2d;
+
+    auto c = py::class_<class_t>(m,
+                                 "EmbeddingMorton2d",
+                                 "2d grid embedding whose linear coordinates follow a tiled Morton (Z-order) curve "
+                                 "instead of the row major order: the grid is cut in square tiles of size tile_size "
+                                 "(a power of 2) numbered in row major order, the pixels of a full tile are numbered "
+                                 "along the Morton curve and the pixels of the partial border tiles in row major order.",
+                                 py::dynamic_attr());
+
+    c.def(py::init<const pyarray<hg::index_t> &, index_t>(),
+          "Create a new Morton embedding. Shape must be a 1d array with 2 striclty positive values, "
+          "tile size must be a power of 2 smaller than or equal to 65536.",
+          py::arg("shape"),
+          py::arg("tile_size") = 64);
+
+    c.def("shape", [](const class_t &e) { return pyarray<hg::index_t>(e.shape()); },
+          "Get the shape/dimensions of the grid embedding");
+
+    c.def("size", &class_t::size, "Get the total number of points contained in the embedding.");
+
+    c.def("dimension", &class_t::dimension,
+          "Get the dimension of the embedding (aka self.shape().size()).");
+
+    c.def("tile_size", &class_t::tile_size, "Get the size of the Morton ordered tiles.");
+
+    c.def("contains", [](const class_t &e, const std::vector<hg::index_t> &a) { return e.contains(a); },
+          "Takes a list or tuple representing the coordinates of a point and returns true if the point is contained in the embedding.",
+          py::arg("coordinates"));
+
+    add_type_overloads<def_contains<class_t>, HG_TEMPLATE_SINTEGRAL_TYPES>
+            (c,
+             "Takes a n1 x n2 x ... nk  array, with nk = self.dimension(), and returns a boolean array of dimension n1 x n2 x ... n(k-1) "
+             "indicating if each point is contained in the embedding.");
+
+    c.def("lin2grid", [](const class_t &e, const index_t a) { return pyarray<hg::index_t>(e.lin2grid(a)); },
+          "Compute the 2d coordinates of a point given its linear coordinate.",
+          py::arg("index"));
+
+    add_type_overloads<def_lin2grid<class_t>, HG_TEMPLATE_SINTEGRAL_TYPES>
+            (c,
+             "Takes a n1 x n2 x ... nk  array, and returns an array of dimension n1 x n2 x ... nk x 2 "
+             "where each value, seen as the linear coordinates of a point, has been replaced by the corresponding 2d coordinates.");
+
+    c.def("grid2lin", [](const class_t &e, const std::vector<hg::index_t> &a) { return e.grid2lin(a); },
+          "Compute the linear coordinate of a point given its 2d coordinates.",
+          py::arg("coordinates"));
+
+    add_type_overloads<def_grid2lin<class_t>, HG_TEMPLATE_SINTEGRAL_TYPES>
+            (c,
+             "Takes a n1 x n2 x ... nk  array, with nk = 2, and returns an array of dimension n1 x n2 x ... n(k-1) "
+             "giving the linear coordinate of each point.");
+
+    add_type_overloads<def_morton_order_conversions, HG_TEMPLATE_NUMERIC_TYPES>(c, "");
+}
+
 void py_init_embedding(pybind11::module &m) {
     xt::import_numpy();
     py_init_embedding_impl<1>(m);
@@ -130,4 +210,5 @@ void py_init_embedding(pybind11::module &m) {
     py_init_embedding_impl<3>(m);
     py_init_embedding_impl<4>(m);
     py_init_embedding_impl<5>(m);
+    py_init_embedding_morton(m);
 }
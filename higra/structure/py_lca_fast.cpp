@@ -13,7 +13,6 @@
 #include "higra/graph.hpp"
 #include "higra/structure/lca_fast.hpp"
 #include "xtensor-python/pyarray.hpp"
-#include "xtensor-python/pytensor.hpp"
 
 namespace py = pybind11;
 using namespace hg;
@@ -21,9 +20,6 @@ using namespace hg;
 template<typename T>
 using pyarray = xt::pyarray<T>;
 
-template<typename T>
-using pyarray_1d = xt::pytensor<T, 1>;
-
 template<typename lca_t>
 struct def_lca_vertices {
     template<typename value_t, typename C>
@@ -32,12 +28,12 @@ struct def_lca_vertices {
         c.def("lca", [](const lca_t &l,
                         const pyarray<value_t> &vertices1,
                         const pyarray<value_t> &vertices2) {
-                  hg_assert((xt::amin)(vertices1)() >= 0, "Vertex indices cannot be negative.");
-                  hg_assert((index_t) (index_t) (xt::amax)(vertices1)() < (index_t) l.num_elements(),
-                            "Vertex indices must be smaller than the number of vertices in the tree.");
-                  hg_assert((xt::amin)(vertices2)() >= 0, "Vertex indices cannot be negative.");
-                  hg_assert((index_t) (xt::amax)(vertices2)() < (index_t) l.num_elements(),
-                            "Vertex indices must be smaller than the number of vertices in the tree.");
+                  hg_assert_content((xt::amin)(vertices1)() >= 0, "Vertex indices cannot be negative.");
+                  hg_assert_content((index_t) (xt::amax)(vertices1)() < (index_t) l.num_elements(),
+                                    "Vertex indices must be smaller than the number of vertices in the tree.");
+                  hg_assert_content((xt::amin)(vertices2)() >= 0, "Vertex indices cannot be negative.");
+                  hg_assert_content((index_t) (xt::amax)(vertices2)() < (index_t) l.num_elements(),
+                                    "Vertex indices must be smaller than the number of vertices in the tree.");
                   return l.lca(vertices1, vertices2);
               },
               doc,
@@ -48,25 +44,61 @@ struct def_lca_vertices {
 
 using namespace range_minimum_query_internal;
 
+// read-only view on a shared array of the object self (no copy)
+template<typename T>
+py::array shared_array_to_python(const details::shared_array_1d<T> &array, const py::object &self) {
+    py::array_t<T> result({(py::ssize_t) array.size()}, {(py::ssize_t) sizeof(T)}, array.data(), self);
+    result.attr("setflags")(py::arg("write") = false);
+    return result;
+}
+
+// shared array on the buffer of a numpy array (no copy if the array is contiguous and has the right type)
+template<typename T>
+details::shared_array_1d<T> shared_array_from_python(const py::handle &object) {
+    auto array = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(object);
+    hg_assert(array && array.ndim() == 1, "Invalid state array.");
+    auto data = array.data();
+    size_t size = array.size();
+    // the numpy array is released with the last solver using it, possibly from a thread without the gil
+    std::shared_ptr<const void> owner(new py::object(std::move(array)), [](py::object *o) {
+        py::gil_scoped_acquire gil;
+        delete o;
+    });
+    return details::shared_array_1d<T>(data, size, std::move(owner));
+}
 
-auto get_rmq_state_to_python(const rmq_sparse_table<index_t>::internal_state<array_1d> &state) {
+auto get_rmq_state_to_python(const rmq_sparse_table<index_t>::internal_state<details::shared_array_1d> &state,
+                             const py::object &self) {
     py::list list;
     for (auto &t: state.sparse_table) {
-        list.append(std::move(t));
+        list.append(shared_array_to_python(t, self));
     }
     return list;
 }
 
-
-auto get_rmq_state_to_python(const rmq_sparse_table_block<index_t>::internal_state<array_1d> &state) {
+auto get_rmq_state_to_python(const rmq_sparse_table_block<index_t>::internal_state<details::shared_array_1d> &state,
+                             const py::object &self) {
     py::list list;
 
     list.append(state.data_size);
     list.append(state.block_size);
     list.append(state.num_blocks);
-    list.append(std::move(state.block_minimum_prefix));
-    list.append(std::move(state.block_minimum_suffix));
-    list.append(get_rmq_state_to_python(state.sparse_table));
+    list.append(shared_array_to_python(state.block_minimum_prefix, self));
+    list.append(shared_array_to_python(state.block_minimum_suffix, self));
+    list.append(shared_array_to_python(state.subblock_minimum, self));
+    list.append(get_rmq_state_to_python(state.sparse_table, self));
+
+    return list;
+}
+
+auto get_rmq_state_to_python(const rmq_bitmask_block<index_t>::internal_state<details::shared_array_1d> &state,
+                             const py::object &self) {
+    py::list list;
+
+    list.append(state.data_size);
+    list.append(state.num_blocks);
+    list.append(shared_array_to_python(state.masks, self));
+    list.append(get_rmq_state_to_python(state.sparse_table, self));
 
     return list;
 }
@@ -77,43 +109,56 @@ auto get_rmq_state_from_python(const py::list &list);
 template<>
 auto get_rmq_state_from_python<range_minimum_query_internal::rmq_sparse_table<index_t>>(const py::list &list) {
 
-    std::vector<pyarray_1d<size_t>> sp;
+    std::vector<details::shared_array_1d<size_t>> sp;
     for (auto &e: list) {
-        sp.push_back(e.template cast<pyarray_1d<size_t>>());
+        sp.push_back(shared_array_from_python<size_t>(e));
     }
-    return range_minimum_query_internal::rmq_sparse_table<index_t>::internal_state<pyarray_1d>(sp);
+    return range_minimum_query_internal::rmq_sparse_table<index_t>::internal_state<details::shared_array_1d>(
+            std::move(sp));
 }
 
 template<>
 auto get_rmq_state_from_python<range_minimum_query_internal::rmq_sparse_table_block<index_t>>(const py::list &list) {
-    return range_minimum_query_internal::rmq_sparse_table_block<index_t>::internal_state<pyarray_1d>(
+    return range_minimum_query_internal::rmq_sparse_table_block<index_t>::internal_state<details::shared_array_1d>(
             list[0].template cast<index_t>(),
             list[1].template cast<index_t>(),
             list[2].template cast<index_t>(),
-            list[3].template cast<pyarray_1d<index_t>>(),
-            list[4].template cast<pyarray_1d<index_t>>(),
+            shared_array_from_python<index_t>(list[3]),
+            shared_array_from_python<index_t>(list[4]),
+            shared_array_from_python<index_t>(list[5]),
             get_rmq_state_from_python<range_minimum_query_internal::rmq_sparse_table<index_t>>(
-                    list[5].template cast<py::list>())
+                    list[6].template cast<py::list>())
+    );
+}
+
+template<>
+auto get_rmq_state_from_python<range_minimum_query_internal::rmq_bitmask_block<index_t>>(const py::list &list) {
+    return range_minimum_query_internal::rmq_bitmask_block<index_t>::internal_state<details::shared_array_1d>(
+            list[0].template cast<index_t>(),
+            list[1].template cast<index_t>(),
+            shared_array_from_python<rmq_bitmask_block<index_t>::mask_type>(list[2]),
+            get_rmq_state_from_python<range_minimum_query_internal::rmq_sparse_table<index_t>>(
+                    list[3].template cast<py::list>())
     );
 }
 
 template<typename T>
-auto get_lca_state_to_python(const T &state) {
+auto get_lca_state_to_python(const T &state, const py::object &self) {
     py::list list;
-    list.append(std::move(state.tree_Euler_tour_map));
-    list.append(std::move(state.tree_Euler_tour_depth));
-    list.append(std::move(state.first_visit_in_Euler_tour));
-    list.append(get_rmq_state_to_python(state.rmq_state));
+    list.append(shared_array_to_python(state.tree_Euler_tour_map, self));
+    list.append(shared_array_to_python(state.tree_Euler_tour_depth, self));
+    list.append(shared_array_to_python(state.first_visit_in_Euler_tour, self));
+    list.append(get_rmq_state_to_python(state.rmq_state, self));
     return list;
 }
 
 template<typename lca_t>
 auto get_lca_state_from_python(const py::list &list) {
-    using state_type = typename lca_t::template internal_state<pyarray_1d>;
+    using state_type = typename lca_t::template internal_state<details::shared_array_1d>;
     return state_type(
-            list[0].template cast<pyarray_1d<index_t>>(),
-            list[1].template cast<pyarray_1d<index_t>>(),
-            list[2].template cast<pyarray_1d<index_t>>(),
+            shared_array_from_python<index_t>(list[0]),
+            shared_array_from_python<index_t>(list[1]),
+            shared_array_from_python<index_t>(list[2]),
             get_rmq_state_from_python<typename lca_t::rmq_type>(list[3])
     );
 }
@@ -128,6 +173,9 @@ auto def_lca_t(T &m, const char *name, const char *doc) {
           "avoid preprocessing the same tree several times.",
           py::arg("tree"));
 
+    c.def("num_elements", &lca_t::num_elements,
+          "Number of vertices of the preprocessed tree.");
+
     c.def("lca",
           [](const lca_t &l, index_t v1, index_t v2) {
               hg_assert(v1 >= 0 && v2 >= 0, "Vertex indices cannot be negative.");
@@ -150,16 +198,19 @@ auto def_lca_t(T &m, const char *name, const char *doc) {
                 "for all i in 0..n-1, res(i) = lca(v1(i); v2(i)).");
 
     c.def("_get_state",
-          [](const lca_t &l) {
-              return py::make_tuple(get_lca_state_to_python(l.get_state()));
+          [](const py::object &self) {
+              auto &l = self.cast<const lca_t &>();
+              return py::make_tuple(get_lca_state_to_python(l.get_shared_state(), self));
           },
-          "Return an opaque structure representing the internal state of the object");
+          "Return an opaque structure representing the internal state of the object: the arrays of the state are "
+          "read-only views on the buffers of the object (no copy).");
 
     c.def_static("_make_from_state",
                  [](py::tuple &t) {
                      return lca_t::make_from_state(get_lca_state_from_python<lca_t>(t[0].template cast<py::list>()));
                  },
-                 "Create a new lca_fast object from the saved state (see function get_state)");
+                 "Create a new lca_fast object from the saved state (see function get_state): the arrays of the "
+                 "state are used in place when they are contiguous and have the expected type.");
 
     return c;
 }
@@ -187,6 +238,11 @@ void py_init_lca_fast(pybind11::module &m) {
           py::arg("tree"),
           py::arg("block_size"));
 
+    auto c_lca_bmb = def_lca_t<lca_bitmask_block>(
+            m, "LCA_rmq_bitmask_block",
+            "Provides fast worst case :math:`\\mathcal{O}(1)` lowest common ancestor computation in a tree thanks "
+            "to a linear preprocessing of the tree.");
+
     // @TODO export symbol LCAFast python
 
 }
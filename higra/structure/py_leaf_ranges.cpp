@@ -0,0 +1,103 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_leaf_ranges.hpp"
+#include "../py_common.hpp"
+#include "higra/graph.hpp"
+#include "higra/structure/leaf_ranges.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+namespace py = pybind11;
+using namespace hg;
+
+// read-only view without copy on size elements of an array of the leaf_ranges object self
+static py::array_t<index_t> leaf_ranges_view(const py::object &self, const index_t *data, index_t size) {
+    py::array_t<index_t> result({(py::ssize_t) size}, {(py::ssize_t) sizeof(index_t)}, data, self);
+    result.attr("setflags")(py::arg("write") = false);
+    return result;
+}
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+struct def_leaf_sums {
+    template<typename type, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("leaf_sums",
+              [](const leaf_ranges &lr, const pyarray<type> &leaf_signal) {
+                  return without_gil([&] {
+                      return lr.leaf_sums(leaf_signal);
+                  });
+              },
+              doc,
+              py::arg("leaf_signal"));
+    }
+};
+
+void py_init_leaf_ranges(pybind11::module &m) {
+    xt::import_numpy();
+
+    auto c = py::class_<leaf_ranges>(m, "LeafRanges",
+                                     "Depth first ordering of the leaves of a tree: the leaves of the sub-tree rooted "
+                                     "in any node form a contiguous range of a single permutation of the leaves.",
+                                     py::dynamic_attr());
+
+    c.def(py::init<tree>(),
+          "Preprocess the given tree in order to obtain the leaves of any node in constant time.\n\n"
+          "Consider using the function :func:`~higra.Tree.leaf_ranges_preprocess` instead of calling this "
+          "constructor to avoid preprocessing the same tree several times.",
+          py::arg("tree"));
+
+    c.def("num_elements", &leaf_ranges::num_elements,
+          "Number of vertices of the preprocessed tree.");
+
+    c.def("leaves",
+          [](const py::object &self) {
+              auto &lr = self.cast<const leaf_ranges &>();
+              return leaf_ranges_view(self, lr.leaves().data(), lr.leaves().size());
+          },
+          "Depth first permutation of the leaves of the tree (read-only view without copy): the leaves of the "
+          "sub-tree rooted in the node n are ``leaves()[begins()[n]:ends()[n]]``.");
+
+    c.def("leaves",
+          [](const py::object &self, index_t node) {
+              auto &lr = self.cast<const leaf_ranges &>();
+              hg_assert(node >= 0 && node < lr.num_elements(),
+                        "Node index must be positive and smaller than the number of vertices in the tree.");
+              return leaf_ranges_view(self, lr.leaves().data() + lr.begin(node), lr.size(node));
+          },
+          "Leaves of the sub-tree rooted in the given node (read-only view without copy).",
+          py::arg("node"));
+
+    c.def("begins",
+          [](const py::object &self) {
+              auto &lr = self.cast<const leaf_ranges &>();
+              return leaf_ranges_view(self, lr.begins().data(), lr.num_elements());
+          },
+          "Position of the first leaf of the sub-tree rooted in each node in the permutation of the leaves "
+          "(read-only view without copy).");
+
+    c.def("ends",
+          [](const py::object &self) {
+              auto &lr = self.cast<const leaf_ranges &>();
+              return leaf_ranges_view(self, lr.ends().data(), lr.num_elements());
+          },
+          "Position after the last leaf of the sub-tree rooted in each node in the permutation of the leaves "
+          "(read-only view without copy).");
+
+    add_type_overloads<def_leaf_sums, HG_TEMPLATE_NUMERIC_TYPES>
+            (c, "Sum of the values of a leaf signal over the leaves of each node: the permuted signal is prefix "
+                "summed once and the sum of the node n is ``P[ends()[n]] - P[begins()[n]]``. The first dimension of "
+                "the signal must be equal to the number of leaves of the tree, the other dimensions are handled as "
+                "independent signals. The result has the same type as the signal (beware of overflows with small "
+                "integer types) and the shape ``(num_elements(),) + leaf_signal.shape[1:]``. The mean of the signal "
+                "over each node is ``leaf_sums(leaf_signal) / (ends() - begins())``.");
+}
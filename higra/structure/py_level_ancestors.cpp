@@ -0,0 +1,94 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_level_ancestors.hpp"
+#include "../py_common.hpp"
+#include "higra/graph.hpp"
+#include "higra/structure/level_ancestors.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+namespace py = pybind11;
+using namespace hg;
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+struct def_find_region_la {
+    template<typename type, typename C>
+    static
+    void def(C &c, const char *doc) {
+        c.def("_find_region",
+              [](const level_ancestors &la,
+                 const pyarray<index_t> &vertices,
+                 const pyarray<type> &lambdas,
+                 const pyarray<type> &altitudes) {
+                  hg_assert_content(vertices.size() == 0 || ((xt::amin)(vertices)() >= 0 &&
+                                                             (xt::amax)(vertices)() < la.num_elements()),
+                                    "Vertex indices must be positive and smaller than the number of vertices in the tree.");
+                  return la.find_region(vertices, lambdas, altitudes);
+              },
+              doc,
+              py::arg("vertices"),
+              py::arg("lambdas"),
+              py::arg("altitudes")
+        );
+        c.def("_find_region",
+              [](const level_ancestors &la,
+                 index_t vertex,
+                 type lambda,
+                 const pyarray<type> &altitudes) {
+                  hg_assert(vertex >= 0 && vertex < la.num_elements(),
+                            "Vertex index must be positive and smaller than the number of vertices in the tree.");
+                  hg_assert(altitudes.size() == (size_t) la.num_elements(),
+                            "altitudes size does not match the number of nodes.");
+                  return la.find_region(vertex, lambda, altitudes);
+              },
+              doc,
+              py::arg("vertex"),
+              py::arg("lambda"),
+              py::arg("altitudes")
+        );
+    }
+};
+
+void py_init_level_ancestors(pybind11::module &m) {
+    xt::import_numpy();
+
+    auto c = py::class_<level_ancestors>(m, "LevelAncestors",
+                                         "Level ancestor index of a tree: any ancestor of a node can be found in "
+                                         "logarithmic time with respect to the depth of the node.",
+                                         py::dynamic_attr());
+
+    c.def(py::init<tree>(),
+          "Preprocess the given tree in order for fast level ancestor and region queries.\n\n"
+          "Consider using the function :func:`~higra.Tree.level_ancestors_preprocess` instead of calling this "
+          "constructor to avoid preprocessing the same tree several times.",
+          py::arg("tree"));
+
+    c.def("num_elements", &level_ancestors::num_elements,
+          "Number of vertices of the preprocessed tree.");
+
+    c.def("level_ancestor",
+          [](const level_ancestors &la, const pyarray<index_t> &vertices, const pyarray<index_t> &depths) {
+              hg_assert_content(vertices.size() == 0 || ((xt::amin)(vertices)() >= 0 &&
+                                                         (xt::amax)(vertices)() < la.num_elements()),
+                                "Vertex indices must be positive and smaller than the number of vertices in the tree.");
+              hg_assert_content(depths.size() == 0 || (xt::amin)(depths)() >= 0, "Depths cannot be negative.");
+              return la.level_ancestor(vertices, depths);
+          },
+          "Ancestor of each given vertex at the given depth (the depth of the root is 0). "
+          "If a depth is larger than the depth of its vertex, the vertex itself is returned.",
+          py::arg("vertices"),
+          py::arg("depths"));
+
+    add_type_overloads<def_find_region_la, HG_TEMPLATE_NUMERIC_TYPES>
+            (c, "Searches for the largest node of altitude lower than the given level and containing the given "
+                "vertex. The altitudes must be increasing from the leaves to the root.");
+}
@@ -0,0 +1,179 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_succinct_tree.hpp"
+#include "../py_common.hpp"
+#include "higra/graph.hpp"
+#include "higra/structure/succinct_tree.hpp"
+#include "xtensor-python/pyarray.hpp"
+#include "xtensor-python/pytensor.hpp"
+
+namespace py = pybind11;
+using namespace hg;
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+template<typename T>
+using pytensor = xt::pytensor<T, 1>;
+
+static void check_node(const succinct_tree &st, index_t v) {
+    if (v < 0 || v >= st.num_vertices()) {
+        throw std::runtime_error("Node index must be positive and smaller than the number of nodes in the tree.");
+    }
+}
+
+static void check_nodes(const succinct_tree &st, const pytensor<index_t> &nodes) {
+    if (nodes.size() != 0 && ((xt::amin)(nodes)() < 0 || (xt::amax)(nodes)() >= st.num_vertices())) {
+        throw std::runtime_error("Node indices must be positive and smaller than the number of nodes in the tree.");
+    }
+}
+
+// applies the given query to each node of the array
+template<typename F>
+static auto map_nodes(const succinct_tree &st, const pytensor<index_t> &nodes, F query) {
+    check_nodes(st, nodes);
+    auto v = pyarray_view(nodes);
+    return without_gil([&] {
+        array_1d<index_t> res = array_1d<index_t>::from_shape({v.size()});
+        parfor(0, (index_t) v.size(), [&](index_t i) {
+            res(i) = query(v(i));
+        });
+        return res;
+    });
+}
+
+void py_init_succinct_tree(pybind11::module &m) {
+    xt::import_numpy();
+
+    auto c = py::class_<succinct_tree>(m, "SuccinctTree",
+                                       "Succinct representation of the topology of a tree by a balanced parentheses "
+                                       "sequence (about 2.4 bits per node). The nodes are identified by their rank "
+                                       "in the depth first preorder of the tree: the root is the node 0.",
+                                       py::dynamic_attr());
+
+    c.def(py::init([](const tree &t) {
+              return without_gil([&] {
+                  return succinct_tree(t);
+              });
+          }),
+          "Succinct representation of the given tree. Use :func:`~higra.make_succinct_tree` to get the "
+          "correspondence between the nodes of the tree and the nodes of the succinct tree.",
+          py::arg("tree"));
+
+    c.def("num_vertices", &succinct_tree::num_vertices, "Number of nodes of the tree.");
+    c.def("num_leaves", &succinct_tree::num_leaves, "Number of leaves of the tree.");
+    c.def("root", &succinct_tree::root, "Root of the tree (always 0).");
+    c.def("memory_usage", &succinct_tree::memory_usage, "Size of the succinct tree in bytes.");
+
+    c.def("parent", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              return st.parent(v);
+          },
+          "Parent of the given node (the root is its own parent).",
+          py::arg("node"));
+    c.def("parent", [](const succinct_tree &st, const pytensor<index_t> &nodes) {
+              return map_nodes(st, nodes, [&st](index_t v) { return st.parent(v); });
+          },
+          "Parent of each of the given nodes.",
+          py::arg("nodes"));
+
+    c.def("subtree_size", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              return st.subtree_size(v);
+          },
+          "Number of nodes in the subtree rooted in the given node (including the node).",
+          py::arg("node"));
+    c.def("subtree_size", [](const succinct_tree &st, const pytensor<index_t> &nodes) {
+              return map_nodes(st, nodes, [&st](index_t v) { return st.subtree_size(v); });
+          },
+          "Number of nodes in the subtree rooted in each of the given nodes.",
+          py::arg("nodes"));
+
+    c.def("depth", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              return st.depth(v);
+          },
+          "Depth of the given node (the depth of the root is 0).",
+          py::arg("node"));
+    c.def("depth", [](const succinct_tree &st, const pytensor<index_t> &nodes) {
+              return map_nodes(st, nodes, [&st](index_t v) { return st.depth(v); });
+          },
+          "Depth of each of the given nodes.",
+          py::arg("nodes"));
+
+    c.def("is_leaf", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              return st.is_leaf(v);
+          },
+          "True if the given node is a leaf.",
+          py::arg("node"));
+
+    c.def("num_children", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              return st.num_children(v);
+          },
+          "Number of children of the given node.",
+          py::arg("node"));
+
+    c.def("children", [](const succinct_tree &st, index_t v) {
+              check_node(st, v);
+              auto children = st.children(v);
+              pytensor<index_t> res = pytensor<index_t>::from_shape({children.size()});
+              std::copy(children.begin(), children.end(), res.begin());
+              return res;
+          },
+          "Children of the given node in increasing order.",
+          py::arg("node"));
+
+    c.def("lowest_common_ancestor", [](const succinct_tree &st, index_t v1, index_t v2) {
+              check_node(st, v1);
+              check_node(st, v2);
+              return st.lowest_common_ancestor(v1, v2);
+          },
+          "Lowest common ancestor of the two given nodes.",
+          py::arg("node1"),
+          py::arg("node2"));
+    c.def("lowest_common_ancestor", [](const succinct_tree &st, const pytensor<index_t> &nodes1,
+                                       const pytensor<index_t> &nodes2) {
+              check_nodes(st, nodes1);
+              check_nodes(st, nodes2);
+              if (nodes1.size() != nodes2.size()) {
+                  throw std::runtime_error("nodes1 and nodes2 must have the same size.");
+              }
+              auto v1 = pyarray_view(nodes1);
+              auto v2 = pyarray_view(nodes2);
+              return without_gil([&] {
+                  return st.lowest_common_ancestor(v1, v2);
+              });
+          },
+          "Lowest common ancestor of each pair of nodes (nodes1[i], nodes2[i]).",
+          py::arg("nodes1"),
+          py::arg("nodes2"));
+
+    c.def("to_tree", [](const succinct_tree &st) {
+              auto res = without_gil([&] {
+                  return st.to_tree();
+              });
+              return py::make_tuple(std::move(res.tree), std::move(res.node_map));
+          },
+          "Convert the succinct tree to a tree: the leaves of the tree are numbered in preorder and the internal nodes "
+          "in reverse preorder. Return the tree and an array giving the succinct tree node of each node of the tree.");
+
+    m.def("_make_succinct_tree", [](const tree &t) {
+              auto res = without_gil([&] {
+                  return make_succinct_tree(t);
+              });
+              return py::make_tuple(std::move(res.tree), std::move(res.node_map));
+          },
+          "Succinct representation of the given tree and, for each node of the succinct tree, the corresponding "
+          "node of the tree.",
+          py::arg("tree"));
+}
@@ -66,13 +66,35 @@ struct def_in_degree_tree {
     }
 };
 
+template<typename graph_t, typename type>
+graph_t make_tree(const pyarray<type> &parent, hg::tree_category category) {
+    return graph_t(parent, category);
+}
+
+// read-only contiguous arrays of indices (parents of another tree, memory mapped files...) cannot be modified behind
+// the tree: they are adopted without copy, the tree keeps a reference on the numpy array
+template<typename graph_t>
+graph_t make_tree(const pyarray<hg::index_t> &parent, hg::tree_category category) {
+    auto array = py::reinterpret_borrow<py::array>(parent);
+    if (array.writeable() || array.ndim() != 1 || (array.size() > 1 && array.strides(0) != sizeof(hg::index_t))) {
+        return graph_t(parent, category);
+    }
+    std::shared_ptr<const void> owner(new py::object(array), [](py::object *o) {
+        py::gil_scoped_acquire gil;
+        delete o;
+    });
+    return graph_t((const hg::index_t *) array.data(), array.size(), std::move(owner), category);
+}
+
 template<typename graph_t>
 struct def_tree_ctr {
     template<typename type, typename C>
     static
     void def(C &c, const char *doc) {
         c.def(py::init(
-                [](const pyarray<type> &parent, hg::tree_category category) { return graph_t(parent, category); }),
+                [](const pyarray<type> &parent, hg::tree_category category) {
+                    return make_tree<graph_t>(parent, category);
+                }),
               doc,
               py::arg("parent_relation"),
               py::arg("category") = hg::tree_category::partition_tree
@@ -158,8 +180,8 @@ struct def_child {
                   tree.compute_children();
                   hg_assert_vertex_indices(tree, vertices);
                   hg_assert(i >= 0, "Child index cannot be negative.");
-                  hg_assert(i < (index_t) (xt::amin)(num_children(vertices, tree))(),
-                            "Child index is larger than the number of children.");
+                  hg_assert_content(i < (index_t) (xt::amin)(num_children(vertices, tree))(),
+                                    "Child index is larger than the number of children.");
                   return hg::child(i, vertices, tree);
               },
               doc,
@@ -193,6 +215,12 @@ void py_init_tree_graph(pybind11::module &m) {
             .value("ComponentTree", hg::tree_category::component_tree)
             .value("PartitionTree", hg::tree_category::partition_tree);
 
+    py::enum_<hg::tree_layout>(m, "TreeLayout",
+                               "Order of the nodes of a tree (see :func:`~higra.relayout_tree`).")
+            .value("Topological", hg::tree_layout::topological)
+            .value("AltitudeSorted", hg::tree_layout::altitude_sorted)
+            .value("PostOrder", hg::tree_layout::post_order);
+
     auto c = py::class_<graph_t>(m,
                                  "Tree",
                                  "An optimized static tree structure with nodes stored linearly in topological order (from leaves to root).",
@@ -297,6 +325,7 @@ void py_init_tree_graph(pybind11::module &m) {
     add_edge_index_graph_concept<graph_t, decltype(c)>(c);
 
     c.def("category", &graph_t::category, "Get the tree category (see enumeration TreeCategory)");
+    c.def("layout", &graph_t::layout, "Get the order of the nodes of the tree (see enumeration TreeLayout)");
     c.def("root", &graph_t::root, "Get the index of the root node (i.e. self.num_vertices() - 1)");
     c.def("num_leaves", &graph_t::num_leaves, "Get the number of leaves nodes.");
     c.def("is_leaf", [](const graph_t &t, index_t i) {
@@ -365,9 +394,40 @@ void py_init_tree_graph(pybind11::module &m) {
           py::arg("node"));
 
     c.def("parents",
-          &graph_t::parents,
-          "Get the parents array representing the tree.",
-          pybind11::return_value_policy::reference_internal);
+          [](const py::object &self) {
+              auto &tree = self.cast<const graph_t &>();
+              py::array_t<hg::index_t> parents({(py::ssize_t) tree.num_vertices()},
+                                               {(py::ssize_t) sizeof(hg::index_t)},
+                                               tree.parents_data(),
+                                               self);
+              parents.attr("setflags")(py::arg("write") = false);
+              return parents;
+          },
+          "Get the parents array representing the tree (read-only view without copy).");
+
+    c.def_static("from_buffer",
+                 [](const py::array &parents, hg::tree_category category, hg::index_t num_leaves) {
+                     hg_assert(parents.ndim() == 1, "parent_relation must be a 1d array.");
+                     hg_assert(py::isinstance<py::array_t<hg::index_t>>(parents),
+                               "parent_relation must be an array of integers of type higra.index_t.");
+                     hg_assert(parents.strides(0) == sizeof(hg::index_t), "parent_relation must be contiguous.");
+                     // the numpy array is released with the last tree using it, possibly from a thread without the gil
+                     std::shared_ptr<const void> owner(new py::object(parents), [](py::object *o) {
+                         py::gil_scoped_acquire gil;
+                         delete o;
+                     });
+                     return graph_t((const hg::index_t *) parents.data(), parents.size(), std::move(owner), category,
+                                    num_leaves);
+                 },
+                 "Create a tree on the given parent relation without copying it: the tree keeps a reference on "
+                 "the array, which must not be modified afterward. This enables to work on huge trees stored in "
+                 "memory mapped files (see ``numpy.load`` with ``mmap_mode='r'``) shared between processes.\n\n"
+                 "If :attr:`num_leaves` is given, the parent relation is assumed to be a valid tree and is not read "
+                 "during the construction, otherwise the number of leaves is computed and the tree is validated "
+                 "with a linear scan of the array.",
+                 py::arg("parent_relation"),
+                 py::arg("category") = hg::tree_category::partition_tree,
+                 py::arg("num_leaves") = hg::invalid_index);
     c.def("parent", [](const graph_t &tree, vertex_t v) {
               hg_assert_vertex_index(tree, v);
               return tree.parent(v);
@@ -379,12 +439,17 @@ void py_init_tree_graph(pybind11::module &m) {
 
     c.def("ancestors", [](const graph_t &tree, vertex_t v) {
               hg_assert_vertex_index(tree, v);
-              std::vector<hg::index_t> vec;
+              // first pass counts the ancestors: the result is filled in place and returned without copy
+              hg::size_t num_ancestors = 0;
+              for (auto c: hg::ancestors_iterator(v, tree)) {
+                  (void) c;
+                  num_ancestors++;
+              }
+              hg::array_1d<hg::index_t> a = hg::array_1d<hg::index_t>::from_shape({num_ancestors});
+              hg::index_t i = 0;
               for (auto c: hg::ancestors_iterator(v, tree)) {
-                  vec.push_back(c);
+                  a(i++) = c;
               }
-              hg::array_1d<hg::index_t> a = hg::array_1d<hg::index_t>::from_shape({vec.size()});
-              std::copy(vec.begin(), vec.end(), a.begin());
               return a;
           },
           "Get the list of ancestors of the given node in topological order (starting from the given node included).",
@@ -417,6 +482,30 @@ void py_init_tree_graph(pybind11::module &m) {
           py::arg("include_leaves") = true,
           py::arg("include_root") = true);
 
+    c.def("children_csr",
+          [](const graph_t &tree) {
+              auto storage = tree.children_csr_storage();
+              // the views keep the storage alive, even if the children relation of the tree is cleared
+              auto holder = new std::shared_ptr<const graph_t::children_csr>(storage);
+              py::capsule base(holder, [](void *p) {
+                  delete reinterpret_cast<std::shared_ptr<const graph_t::children_csr> *>(p);
+              });
+              py::array_t<hg::index_t> offsets({(py::ssize_t) storage->offsets.size()},
+                                               {(py::ssize_t) sizeof(hg::index_t)},
+                                               storage->offsets.data(),
+                                               base);
+              py::array_t<hg::index_t> children({(py::ssize_t) storage->children.size()},
+                                                {(py::ssize_t) sizeof(hg::index_t)},
+                                                storage->children.data(),
+                                                base);
+              offsets.attr("setflags")(py::arg("write") = false);
+              children.attr("setflags")(py::arg("write") = false);
+              return py::make_tuple(offsets, children);
+          },
+          "Get the children relation of the tree in compressed sparse row layout (read-only views without copy): "
+          "a pair of arrays (offsets, children) such that the children of the non leaf node :math:`n` are "
+          "``children[offsets[n - num_leaves]:offsets[n - num_leaves + 1]]``, in increasing order. The children "
+          "relation is computed if needed.");
     c.def("_compute_children", &graph_t::compute_children, "Compute the children relation.");
     c.def("_children_computed", &graph_t::children_computed,
           "True if the children relation has already been computed.");
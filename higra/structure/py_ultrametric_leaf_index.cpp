@@ -0,0 +1,107 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_ultrametric_leaf_index.hpp"
+#include "../py_common.hpp"
+#include "higra/graph.hpp"
+#include "higra/structure/ultrametric_leaf_index.hpp"
+#include "xtensor-python/pyarray.hpp"
+
+namespace py = pybind11;
+using namespace hg;
+
+template<typename T>
+using pyarray = xt::pyarray<T>;
+
+void py_init_ultrametric_leaf_index(pybind11::module &m) {
+    xt::import_numpy();
+
+    auto c = py::class_<ultrametric_leaf_index>(m, "UltrametricLeafIndex",
+                                                "Nearest neighbour index on the leaves of a hierarchy for the "
+                                                "ultrametric distance of the hierarchy: the distance between two "
+                                                "distinct leaves is the altitude of their lowest common ancestor.",
+                                                py::dynamic_attr());
+
+    c.def(py::init([](const tree &t, const pyarray<double> &altitudes) {
+              return new ultrametric_leaf_index(t, altitudes);
+          }),
+          "Preprocess the given tree for nearest leaves and range queries. The altitudes must be increasing from the "
+          "leaves to the root.",
+          py::arg("tree"),
+          py::arg("altitudes"));
+
+    c.def("num_leaves", &ultrametric_leaf_index::num_leaves,
+          "Number of leaves of the preprocessed tree.");
+
+    c.def("leaf_ranges",
+          [](const ultrametric_leaf_index &index) -> const leaf_ranges & {
+              return index.ranges();
+          },
+          "Depth first ordering of the leaves of the preprocessed tree (an object of type "
+          ":class:`~higra.LeafRanges`).",
+          py::return_value_policy::reference_internal);
+
+    c.def("distance",
+          [](const ultrametric_leaf_index &index, index_t leaf1, index_t leaf2) {
+              hg_assert(leaf1 >= 0 && leaf1 < index.num_leaves() && leaf2 >= 0 && leaf2 < index.num_leaves(),
+                        "Leaf indices must be positive and smaller than the number of leaves in the tree.");
+              return index.distance(leaf1, leaf2);
+          },
+          "Ultrametric distance between two leaves: altitude of their lowest common ancestor, 0 if they are equal.",
+          py::arg("leaf1"),
+          py::arg("leaf2"));
+
+    c.def("ball",
+          [](const ultrametric_leaf_index &index, index_t leaf, double max_distance) {
+              hg_assert(leaf >= 0 && leaf < index.num_leaves(),
+                        "Leaf index must be positive and smaller than the number of leaves in the tree.");
+              return index.ball(leaf, max_distance);
+          },
+          "Largest node containing the given leaf whose altitude is lower than or equal to the given distance, or the "
+          "leaf itself if no such node exists.",
+          py::arg("leaf"),
+          py::arg("max_distance"));
+
+    c.def("_nearest_leaves",
+          [](const ultrametric_leaf_index &index, const pyarray<index_t> &leaves, index_t k) {
+              auto res = without_gil([&] {
+                  return index.nearest_leaves(leaves, k);
+              });
+              return py::make_tuple(std::move(res.leaves), std::move(res.distances));
+          },
+          py::arg("leaves"),
+          py::arg("k"));
+
+    c.def("_nearest_leaves",
+          [](const ultrametric_leaf_index &index, index_t leaf, index_t k) {
+              auto res = index.nearest_leaves(leaf, k);
+              return py::make_tuple(std::move(res.first), std::move(res.second));
+          },
+          py::arg("leaf"),
+          py::arg("k"));
+
+    c.def("_leaves_within",
+          [](const ultrametric_leaf_index &index, const pyarray<index_t> &leaves, const pyarray<double> &max_distances) {
+              auto res = without_gil([&] {
+                  return index.leaves_within(leaves, max_distances);
+              });
+              return py::make_tuple(std::move(res.offsets), std::move(res.leaves), std::move(res.distances));
+          },
+          py::arg("leaves"),
+          py::arg("max_distances"));
+
+    c.def("_leaves_within",
+          [](const ultrametric_leaf_index &index, index_t leaf, double max_distance) {
+              auto res = index.leaves_within(leaf, max_distance);
+              return py::make_tuple(std::move(res.first), std::move(res.second));
+          },
+          py::arg("leaf"),
+          py::arg("max_distance"));
+}
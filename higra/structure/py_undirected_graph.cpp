@@ -11,6 +11,7 @@
 #include "py_undirected_graph.hpp"
 #include "py_common_graph.hpp"
 #include "extra_xtensor_pybin_casters.hpp"
+#include "higra/structure/details/shared_array.hpp"
 
 namespace py = pybind11;
 
@@ -20,12 +21,14 @@ struct def_add_edges {
     static
     void def(C &c, const char *doc) {
         c.def("add_edges", [](graph_t &g,
-                              pyarray<value_t> sources,
-                              pyarray<value_t> targets
+                              const pyarray<value_t> &sources,
+                              const pyarray<value_t> &targets
               ) {
                   hg_assert_vertex_indices(g, sources);
                   hg_assert_vertex_indices(g, targets);
-                  hg::add_edges(sources, targets, g);
+                  without_gil([&] {
+                      hg::add_edges(pyarray_view(sources), pyarray_view(targets), g);
+                  });
               },
               doc,
               py::arg("sources"),
@@ -51,6 +54,30 @@ void init_graph(class_t &c) {
           py::arg("reserved_edges") = 0,
           py::arg("reserved_edge_per_vertex") = 0);
 
+    c.def(py::init([](const hg::size_t num_vertices,
+                      const pyarray<hg::index_t> &sources,
+                      const pyarray<hg::index_t> &targets) {
+              hg_assert_1d_array(sources);
+              hg_assert_same_shape(sources, targets);
+              hg_assert(sources.size() == 0 ||
+                        ((xt::amin)(sources)() >= 0 && (xt::amax)(sources)() < (hg::index_t) num_vertices &&
+                         (xt::amin)(targets)() >= 0 && (xt::amax)(targets)() < (hg::index_t) num_vertices),
+                        "Invalid vertex index.");
+              return without_gil([&] {
+                  return new graph_t(num_vertices, pyarray_view(sources), pyarray_view(targets));
+              });
+          }), R"doc(
+    Create a new graph with the given edges (faster than :meth:`add_edges` on an empty graph as the out edge list of
+    each vertex is allocated once).
+
+    :param number_of_vertices: number of vertices in the graph
+    :param sources: 1d array of edge sources
+    :param targets: 1d array of edge targets (same size as sources)
+    )doc",
+          py::arg("number_of_vertices"),
+          py::arg("sources"),
+          py::arg("targets"));
+
     add_edge_accessor_graph_concept<graph_t, decltype(c)>(c);
     add_incidence_graph_concept<graph_t, decltype(c)>(c);
     add_bidirectionnal_graph_concept<graph_t, decltype(c)>(c);
@@ -95,6 +122,53 @@ void init_graph(class_t &c) {
           py::arg("source"),
           py::arg("target"),
           "Modify the source and the target of the given edge.");
+    c.def("_get_state", [](const py::object &self) {
+              auto &g = self.cast<const graph_t &>();
+              static_assert(sizeof(edge_t) == 3 * sizeof(index_t), "Unexpected edge layout.");
+              // read-only view on the (source, target, index) triplets of the edges (no copy)
+              py::array_t<index_t> edges({(py::ssize_t) g.num_edges(), (py::ssize_t) 3},
+                                         {(py::ssize_t) sizeof(edge_t), (py::ssize_t) sizeof(index_t)},
+                                         (const index_t *) g.edges_data(),
+                                         self);
+              edges.attr("setflags")(py::arg("write") = false);
+              // out edge lists in compressed form
+              auto num_vertices = g.num_vertices();
+              py::array_t<index_t> out_edge_offsets(num_vertices + 1);
+              auto offsets = out_edge_offsets.mutable_data();
+              offsets[0] = 0;
+              for (index_t v = 0; v < (index_t) num_vertices; v++) {
+                  offsets[v + 1] = offsets[v] + (index_t) g.degree(v);
+              }
+              py::array_t<index_t> out_edge_indices(offsets[num_vertices]);
+              auto indices = out_edge_indices.mutable_data();
+              for (index_t v = 0; v < (index_t) num_vertices; v++) {
+                  std::copy(g.out_edges_cbegin(v), g.out_edges_cend(v), indices + offsets[v]);
+              }
+              return py::make_tuple(num_vertices, std::move(edges), std::move(out_edge_offsets),
+                                    std::move(out_edge_indices));
+          },
+          "Return an opaque structure representing the internal state of the object.");
+    c.def_static("_make_from_state", [](size_t num_vertices,
+                                        const py::array_t<index_t, py::array::c_style | py::array::forcecast> &edges,
+                                        const py::array_t<index_t, py::array::c_style | py::array::forcecast> &out_edge_offsets,
+                                        const py::array_t<index_t, py::array::c_style | py::array::forcecast> &out_edge_indices) {
+                     hg_assert(edges.ndim() == 2 && edges.shape(1) == 3, "Invalid edge array.");
+                     hg_assert(out_edge_offsets.ndim() == 1 && out_edge_indices.ndim() == 1,
+                               "Invalid out edge arrays.");
+                     index_t num_edges = edges.shape(0);
+                     auto indices = out_edge_indices.data();
+                     for (index_t i = 0; i < (index_t) out_edge_indices.size(); i++) {
+                         hg_assert(indices[i] >= 0 && indices[i] < num_edges, "Invalid out edge index.");
+                     }
+                     return graph_t::from_edge_lists(num_vertices, (const edge_t *) edges.data(), num_edges,
+                                                     hg::details::shared_array_1d<index_t>(
+                                                             out_edge_offsets.data(), out_edge_offsets.size(),
+                                                             nullptr),
+                                                     hg::details::shared_array_1d<index_t>(
+                                                             indices, out_edge_indices.size(), nullptr));
+                 },
+                 "Create a new graph from the saved state (see function _get_state): the edges and the out edge "
+                 "lists are copied in bulk, without adding the edges one by one.");
     c.def("remove_edge", [](graph_t &g, index_t edge) {
               hg_assert_edge_index(g, edge);
               g.remove_edge(edge);
@@ -102,6 +176,17 @@ void init_graph(class_t &c) {
           py::arg("edge_index"),
           "Remove the given edge from the graph (the edge is not really removed: "
           "its source and target are attached to a virtual node of index -1).");
+    c.def("compact_edges", [](graph_t &g) {
+              auto res = without_gil([&g] {
+                  return hg::compact_edges(g);
+              });
+              return py::make_tuple(std::move(res.first), std::move(res.second));
+          },
+          "Really remove the edges deleted with remove_edge from the graph: the remaining edges are renumbered "
+          "consecutively in their original order and the out edge lists of the vertices are updated accordingly.\n\n"
+          "Return a pair of arrays (old_to_new, new_to_old): old_to_new[i] is the new index of the edge of former "
+          "index i (or -1 if this edge was removed) and new_to_old[j] is the former index of the edge of new index j. "
+          "Edge weights are remapped with a single gather: new_edge_weights = edge_weights[new_to_old].");
 }
 
 void py_init_undirected_graph(py::module &m) {
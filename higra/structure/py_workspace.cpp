@@ -0,0 +1,58 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "py_workspace.hpp"
+#include "../py_common.hpp"
+#include "higra/structure/workspace.hpp"
+#include <memory>
+#include <vector>
+
+namespace py = pybind11;
+
+/**
+ * A workspace and the stack of its activations on the current thread (a workspace can be entered several times).
+ */
+struct py_workspace {
+    hg::workspace workspace;
+    std::vector<std::unique_ptr<hg::scoped_workspace>> scopes;
+};
+
+void py_init_workspace(pybind11::module &m) {
+    auto c = py::class_<py_workspace>(m, "Workspace",
+                                      "Cache of memory blocks for the temporary arrays of the hierarchy algorithms.\n\n"
+                                      "Used as a context manager, the workspace is active on the current thread "
+                                      "inside the ``with`` block: the temporaries of the algorithms called in the "
+                                      "block (``bpt_canonical``, ``quasi_flat_zone_hierarchy``, ``simplify_tree``, "
+                                      "``tree_2_binary_tree``, the watershed hierarchies, "
+                                      "``labelisation_horizontal_cut_from_threshold``...) are drawn from the "
+                                      "workspace and their memory is kept for the next calls instead of being "
+                                      "returned to the system. This avoids repeated allocations when the same "
+                                      "algorithms are called many times on inputs of similar sizes.\n\n"
+                                      "A workspace must only be used by one thread at a time.");
+
+    c.def(py::init<>(), "Create an empty workspace.");
+
+    c.def("__enter__", [](py_workspace &w) -> py_workspace & {
+              w.scopes.push_back(std::make_unique<hg::scoped_workspace>(w.workspace));
+              return w;
+          },
+          py::return_value_policy::reference);
+
+    c.def("__exit__", [](py_workspace &w, const py::args &) {
+        hg_assert(!w.scopes.empty(), "The workspace is not active.");
+        w.scopes.pop_back();
+    });
+
+    c.def("cached_bytes", [](const py_workspace &w) { return w.workspace.cached_bytes(); },
+          "Number of bytes held by the workspace for the next calls.");
+
+    c.def("release", [](py_workspace &w) { w.workspace.release(); },
+          "Free the memory held by the workspace.");
+}
@@ -0,0 +1,37 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+
+
+def make_succinct_tree(tree):
+    """
+    Succinct representation of a tree (see :class:`~higra.SuccinctTree`) and correspondence between the nodes of
+    the succinct tree and the nodes of the tree.
+
+    The nodes of the succinct tree are numbered in depth first preorder, the children of a node being visited in
+    increasing order: node attributes of the tree can be stored along the succinct tree in this order with
+    ``attribute[node_map]``. Note that the succinct tree only encodes the topology of the tree: if the leaves of the
+    tree have a meaning (for example the pixels of an image), their indices must be stored as an attribute.
+
+    :Example:
+
+    >>> tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+    >>> stree, node_map = hg.make_succinct_tree(tree)
+    >>> node_map
+    array([7, 5, 0, 1, 6, 2, 3, 4])
+    >>> stree.parent(2)
+    1
+
+    :param tree: input tree
+    :return: a pair (succinct tree, node_map) where ``node_map[i]`` is the node of :attr:`tree` corresponding to the
+             node :math:`i` of the succinct tree
+    """
+    return hg.cpp._make_succinct_tree(tree)
@@ -18,12 +18,20 @@ def __find_region(self, vertex, level, altitudes):
     Searches for the largest node of altitude lower than the given level and containing the given vertex.
     If no such node exists the given vertex is returned.
 
+    If the level ancestor index of the tree has been computed with :func:`~higra.Tree.level_ancestors_preprocess`,
+    it is used to answer the queries in logarithmic time with respect to the depth of the vertices, instead of
+    climbing the tree parent by parent.
+
     :param vertex: a vertex or a 1d array of vertices
     :param level: a level or a 1d array of levels (should have the same dtype as altitudes)
     :param altitudes: altitudes of the nodes of the tree
     :return: a vertex or a 1d array of vertices
     """
 
+    level_ancestors = hg.get_attribute(self, "level_ancestors")
+    if level_ancestors is not None:
+        return level_ancestors.find_region(vertex, level, altitudes)
+
     if isinstance(vertex, np.ndarray):
         if not isinstance(level, np.ndarray):
             level = np.full_like(vertex, level, dtype=altitudes.dtype)
@@ -83,9 +91,47 @@ def __num_children(self, vertex=None):
     return self._num_children(vertex)
 
 
+def __reduce_ctr(parents, category, num_leaves):
+    return hg.Tree.from_buffer(parents, category, num_leaves)
+
+
 @hg.extend_class(hg.Tree, method_name="__reduce__")
 def ____reduce__(self):
-    return self.__class__, (self.parents(),), self.__dict__
+    # parents() is a view on the tree: with pickle protocol 5, numpy exports it out-of-band without copy, and the
+    # unpickled tree is created on the received buffer without copy nor validation
+    return __reduce_ctr, (self.parents(), self.category(), self.num_leaves()), self.__dict__
+
+
+@hg.extend_class(hg.Tree, method_name="level_ancestors_preprocess")
+def __level_ancestors_preprocess(self, force_recompute=False):
+    """
+    Preprocess the tree to obtain fast level ancestor queries: any ancestor of a node, and in particular the
+    result of :func:`~higra.Tree.find_region`, is then found in logarithmic time :math:`\mathcal{O}(\log(d))` with
+    :math:`d` the depth of the node. The preprocessing time and space complexity is linear.
+
+    Once this function has been called on a given tree instance, every following calls to the function
+    :func:`~higra.Tree.find_region` will use this preprocessing, which assumes that the altitudes are increasing from
+    the leaves to the root. Calling twice this function does nothing except if :attr:`force_recompute` is ``True``.
+
+    :param force_recompute: if ``False`` (default) calling this function twice won't re-preprocess the tree
+    :return: An object of type :class:`~higra.LevelAncestors`
+    """
+    return hg.get_or_compute_attribute(self, "level_ancestors", lambda: hg.LevelAncestors(self), force_recompute)
+
+
+@hg.extend_class(hg.Tree, method_name="leaf_ranges_preprocess")
+def __leaf_ranges_preprocess(self, force_recompute=False):
+    """
+    Preprocess the tree to obtain the leaves of any node in constant time :math:`\mathcal{O}(1)`: the leaves are
+    ordered with a depth first traversal of the tree such that the leaves of the sub-tree rooted in any node form a
+    contiguous range of a single permutation of the leaves. The preprocessing time and space complexity is linear.
+
+    Calling twice this function does nothing except if :attr:`force_recompute` is ``True``.
+
+    :param force_recompute: if ``False`` (default) calling this function twice won't re-preprocess the tree
+    :return: An object of type :class:`~higra.LeafRanges`
+    """
+    return hg.get_or_compute_attribute(self, "leaf_ranges", lambda: hg.LeafRanges(self), force_recompute)
 
 
 @hg.extend_class(hg.Tree, method_name="lowest_common_ancestor_preprocess")
@@ -94,9 +140,10 @@ def __lowest_common_ancestor_preprocess(self, algorithm="sparse_table_block", bl
     Preprocess the tree to obtain a fast constant time :math:`\\mathcal{O}(1)` lowest common ancestor query.
     Once this function has been called on a given tree instance, every following calls to the function
     :func:`~higra.Tree.lowest_common_ancestor` will use this preprocessing. Calling twice this function does nothing
-    except if :attr:`force_recompute` is ``True``.
+    except if :attr:`force_recompute` is ``True``. The preprocessing is done once even if several threads call this
+    function concurrently on the same tree (see :func:`~higra.get_or_compute_attribute`).
 
-    Two algorithms are available:
+    Three algorithms are available:
 
     - ``sparse_table`` has a preprocessing time and space complexity in :math:`\\mathcal{O}(n\log(n))` with :math:`n`
       the number of vertices in the tree and performs every query in constant time :math:`\\mathcal{O}(1)`.
@@ -104,27 +151,33 @@ def __lowest_common_ancestor_preprocess(self, algorithm="sparse_table_block", bl
       and performs queries in average-case constant time :math:`\\mathcal{O}(1)`. With this algorithm the user can specify
       the block size to be used, the general rule of thumb being that larger block size will decrease the pre-processing
       time but increase the query time.
+    - ``bitmask_block`` has a linear preprocessing time and space complexity in :math:`\\mathcal{O}(n)` and performs
+      every query in constant time :math:`\\mathcal{O}(1)`. It uses less memory than the two other algorithms and is
+      well suited to very large trees.
 
-    :param algorithm: specify the algorithm to be used, can be either ``sparse_table`` or ``sparse_table_block``.
+    :param algorithm: specify the algorithm to be used, can be either ``sparse_table``, ``sparse_table_block`` or
+           ``bitmask_block``.
     :param block_size: if :attr:`algorithm` is ``sparse_table_block``, specify the block size to be used (default 1024)
     :param force_recompute: if ``False`` (default) calling this function twice won't re-preprocess the tree, even if the
            specified algorithm or algorithm parameter have changed.
-    :return: An object of type :class:`~higra.hg.LCA_rmq_sparse_table_block` or :class:`~higra.hg.LCA_rmq_sparse_table`
+    :return: An object of type :class:`~higra.hg.LCA_rmq_sparse_table_block`, :class:`~higra.hg.LCA_rmq_sparse_table`
+             or :class:`~higra.hg.LCA_rmq_bitmask_block`
     """
-    lca_fast = hg.get_attribute(self, "lca_fast")
-    if lca_fast is None or force_recompute:
+
+    def compute():
         if algorithm == "sparse_table":
-            lca_fast = hg.LCA_rmq_sparse_table(self)
+            return hg.LCA_rmq_sparse_table(self)
         elif algorithm == "sparse_table_block":
-            block_size = int(block_size)
-            if block_size <= 0:
+            size = int(block_size)
+            if size <= 0:
                 raise ValueError("Invalid block size: " + str(block_size))
-
-            lca_fast = hg.LCA_rmq_sparse_table_block(self, block_size)
+            return hg.LCA_rmq_sparse_table_block(self, size)
+        elif algorithm == "bitmask_block":
+            return hg.LCA_rmq_bitmask_block(self)
         else:
             raise ValueError("Unknown LCA algorithm: " + str(algorithm))
-        hg.set_attribute(self, "lca_fast", lca_fast)
-    return lca_fast
+
+    return hg.get_or_compute_attribute(self, "lca_fast", compute, force_recompute)
 
 
 @hg.extend_class(hg.Tree, method_name="lowest_common_ancestor")
@@ -234,4 +287,36 @@ def __sub_tree(self, root_node):
     :param root_node: a vertex of the current tree
     :return: the sub tree rooted in :attr:`root` and the node map
     """
-    return hg.cpp._sub_tree(self, root_node)
\ No newline at end of file
+    return hg.cpp._sub_tree(self, root_node)
+
+
+@hg.extend_class(hg.Tree, method_name="sub_trees")
+def __sub_trees(self, root_nodes):
+    """
+    Extract the sub trees rooted in the given nodes of the current tree.
+
+    The i-th sub tree and node map are equal to the result of :func:`~higra.Tree.sub_tree` on
+    :attr:`root_nodes[i]`, but all the sub trees are extracted in one pass: the nodes of the tree are ordered in
+    pre-order such that every sub tree is a contiguous range of nodes, the parent relations of the sub trees are
+    stored in a single shared buffer, and the node maps are views in a single array.
+
+    :Complexity:
+
+    The sub trees are constructed in time :math:`\mathcal{O}(N + \sum_i n_i\log(n_i))` with :math:`N` the number
+    of vertices in the tree and :math:`n_i` the number of vertices in the i-th sub tree.
+
+    :Example:
+
+    >>> t = Tree((5, 5, 6, 6, 6, 7, 7, 7))
+    >>> sub_trees, node_maps = t.sub_trees((6, 5))
+    >>> sub_trees[1].parents()
+    array([2, 2, 2])
+    >>> node_maps[1]
+    array([0, 1, 5])
+
+    :param root_nodes: a 1d array of vertices of the current tree
+    :return: a list of sub trees and a list of node maps
+    """
+    root_nodes = hg.cast_to_dtype(np.asarray(root_nodes), hg.index_t)
+    trees, node_map, offsets = hg.cpp._sub_trees(self, root_nodes)
+    return trees, np.split(node_map, offsets[1:-1])
@@ -0,0 +1,56 @@
+############################################################################
+# Copyright ESIEE Paris (2021)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import higra as hg
+import numpy as np
+
+
+@hg.extend_class(hg.UltrametricLeafIndex, method_name="nearest_leaves")
+def __nearest_leaves(self, leaf, k):
+    """
+    The :attr:`k` nearest leaves of the given leaf for the ultrametric distance of the hierarchy (the distance between
+    two distinct leaves is the altitude of their lowest common ancestor), by increasing distance. The query leaf
+    itself is not part of the result, and all the other leaves are returned if :attr:`k` is larger than the number of
+    leaves minus 1.
+
+    Each query walks up the ancestors of the leaf and copies contiguous ranges of the depth first permutation of the
+    leaves: it is answered in time proportional to the size of its result (for a tree without nodes with a single
+    child). Arrays of leaves are processed in parallel.
+
+    :param leaf: a leaf or a 1d array of leaves
+    :param k: number of neighbours
+    :return: a pair (leaves, distances) of 1d arrays of size ``min(k, num_leaves() - 1)`` if :attr:`leaf` is a scalar,
+             or of 2d arrays with one row per query leaf otherwise
+    """
+    if isinstance(leaf, np.ndarray):
+        return self._nearest_leaves(hg.cast_to_dtype(leaf, np.int64), int(k))
+    return self._nearest_leaves(int(leaf), int(k))
+
+
+@hg.extend_class(hg.UltrametricLeafIndex, method_name="leaves_within")
+def __leaves_within(self, leaf, max_distance):
+    """
+    The leaves at ultrametric distance lower than or equal to :attr:`max_distance` of the given leaf, by increasing
+    distance. The query leaf itself is not part of the result.
+
+    If :attr:`leaf` is an array, the results of the queries are returned in compressed sparse row format: the
+    leaves within :attr:`max_distance` of ``leaf[i]`` are ``leaves[offsets[i]:offsets[i + 1]]`` and their distances
+    are ``distances[offsets[i]:offsets[i + 1]]``. The queries are processed in parallel.
+
+    :param leaf: a leaf or a 1d array of leaves
+    :param max_distance: a distance or a 1d array of distances (one per query leaf)
+    :return: a pair (leaves, distances) of 1d arrays if :attr:`leaf` is a scalar, a triplet (offsets, leaves,
+             distances) of 1d arrays otherwise
+    """
+    if isinstance(leaf, np.ndarray):
+        if not isinstance(max_distance, np.ndarray):
+            max_distance = np.full(leaf.shape, max_distance, dtype=np.float64)
+        return self._leaves_within(hg.cast_to_dtype(leaf, np.int64), hg.cast_to_dtype(max_distance, np.float64))
+    return self._leaves_within(int(leaf), float(max_distance))
@@ -12,14 +12,20 @@ import higra as hg
 
 
 def __reduce_ctr(num_vertices, sources, targets):
+    # pickles created by previous versions
     graph = hg.UndirectedGraph(num_vertices)
     graph.add_edges(sources, targets)
     return graph
 
 
+def __reduce_ctr_state(*args):
+    return hg.UndirectedGraph._make_from_state(*args)
+
+
 @hg.extend_class(hg.UndirectedGraph, method_name="__reduce__")
 def ____reduce__(self):
-    return __reduce_ctr, (self.num_vertices(), *self.edge_list()), self.__dict__
+    # the state arrays are views on the graph: with pickle protocol 5, numpy exports them out-of-band without copy
+    return __reduce_ctr_state, self._get_state(), self.__dict__
 
 
 @hg.extend_class(hg.UndirectedGraph, method_name="sources")
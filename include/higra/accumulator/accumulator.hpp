@@ -11,10 +11,17 @@
 #pragma once
 
 #include "../utils.hpp"
+#include "../detail/simd_dispatch.hpp"
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <limits>
 #include <vector>
 
+#ifdef XTENSOR_USE_XSIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
 namespace hg {
 
 #define HG_ACCUMULATORS (min)(max)(mean)(counter)(sum)(prod)(first)(last)
@@ -29,11 +36,81 @@ namespace hg {
         sum,
         prod,
         argmin,
-        argmax
+        argmax,
+        variance,
+        covariance
     };
 
+    struct accumulator_sum;
+
     namespace accumulator_detail {
 
+        /**
+         * Element-wise reduction of the range starting at value_begin into the range [storage_begin, storage_end):
+         * storage[i] = operation::reduce(value[i], storage[i])
+         */
+        template<typename operation, typename S, typename T>
+        void reduce_range(S storage_begin, S storage_end, T value_begin) {
+            using value_type = typename std::iterator_traits<S>::value_type;
+            for (; storage_begin != storage_end; storage_begin++, value_begin++) {
+                *storage_begin = operation::template reduce<value_type>(*value_begin, *storage_begin);
+            }
+        }
+
+#if defined(HG_HAS_SIMD_DISPATCH)
+
+        /**
+         * Element-wise reduction of contiguous ranges with the runtime dispatched kernel (see
+         * detail/simd_dispatch.hpp).
+         */
+        template<typename operation, typename V, typename V2>
+        HG_SIMD_DISPATCH
+        std::enable_if_t<std::is_arithmetic<V>::value && std::is_same<std::remove_const_t<V2>, V>::value>
+        reduce_range(V *storage_begin, V *storage_end, V2 *value_begin) {
+            std::size_t size = storage_end - storage_begin;
+            for (std::size_t i = 0; i < size; i++) {
+                storage_begin[i] = operation::template reduce<V>(value_begin[i], storage_begin[i]);
+            }
+        }
+
+#elif defined(XTENSOR_USE_XSIMD)
+
+        /**
+         * Value types for which the vectorial marginal accumulators are processed with xsimd batches
+         */
+        template<typename T>
+        struct is_simd_reducible : public std::integral_constant<bool,
+                (std::is_same<T, float>::value ||
+                 std::is_same<T, double>::value ||
+                 std::is_same<T, int32_t>::value) &&
+                (xsimd::simd_traits<T>::size > 1)> {
+        };
+
+        /**
+         * Element-wise reduction of contiguous ranges with xsimd batches (the remaining elements are reduced
+         * with scalar operations).
+         *
+         * The result is identical to the one of the scalar implementation as each element is reduced independently.
+         */
+        template<typename operation, typename V, typename V2>
+        std::enable_if_t<is_simd_reducible<V>::value && std::is_same<std::remove_const_t<V2>, V>::value>
+        reduce_range(V *storage_begin, V *storage_end, V2 *value_begin) {
+            constexpr std::size_t batch_size = xsimd::simd_traits<V>::size;
+            std::size_t size = storage_end - storage_begin;
+            std::size_t simd_size = size - size % batch_size;
+            std::size_t i = 0;
+            for (; i < simd_size; i += batch_size) {
+                auto s = xsimd::load_unaligned(storage_begin + i);
+                auto v = xsimd::load_unaligned(value_begin + i);
+                xsimd::store_unaligned(storage_begin + i, operation::reduce_batch(v, s));
+            }
+            for (; i < size; i++) {
+                storage_begin[i] = operation::template reduce<V>(value_begin[i], storage_begin[i]);
+            }
+        }
+
+#endif
+
         /**
         * Marginal processing accumulator
         * @tparam S the storage type
@@ -65,10 +142,7 @@ namespace hg {
             template<typename T, typename ...Args>
             void
             accumulate(T value_begin, Args &&...) {
-                auto s = m_storage_begin;
-                for (; s != m_storage_end; s++, value_begin++) {
-                    *s = operation::template reduce<value_type>(*value_begin, *s);
-                }
+                reduce_range<operation>(m_storage_begin, m_storage_end, value_begin);
             };
 
             template<typename ...Args>
@@ -156,12 +230,14 @@ namespace hg {
             template<typename T = self_type, typename ...Args>
             typename std::enable_if_t<T::is_vectorial>
             initialize(Args &&...) {
+                m_counter = 0;
                 std::fill(m_storage_begin, m_storage_end, 0);
             }
 
             template<typename T = self_type, typename ...Args>
             typename std::enable_if_t<!T::is_vectorial>
             initialize(Args &&...) {
+                m_counter = 0;
                 *m_storage_begin = 0;
             }
 
@@ -169,10 +245,7 @@ namespace hg {
             std::enable_if_t<T1::is_vectorial>
             accumulate(T value_begin, Args &&...) {
                 m_counter++;
-                auto s = m_storage_begin;
-                for (; s != m_storage_end; s++, value_begin++) {
-                    *s += *value_begin;
-                }
+                reduce_range<accumulator_sum>(m_storage_begin, m_storage_end, value_begin);
             }
 
             template<typename T1 = self_type, typename T, typename ...Args>
@@ -540,6 +613,503 @@ namespace hg {
             S m_storage_end;
         };
 
+
+        /**
+         * Test if the accumulators of type acc_t can be merged: acc1.merge(acc2) updates the state of acc1 such that
+         * acc1 is equivalent to an accumulator having accumulated the values accumulated by acc1 and by acc2.
+         */
+        template<typename acc_t, typename = void>
+        struct is_mergeable : public std::false_type {
+        };
+
+        template<typename acc_t>
+        struct is_mergeable<acc_t, decltype(std::declval<acc_t &>().merge(std::declval<const acc_t &>()), void())>
+                : public std::true_type {
+        };
+
+        /**
+         * Test if the accumulator factory accumulator_t provides a static function reduce combining two accumulated
+         * values of type value_t (marginal accumulators: sum, min, max, prod): the result of an accumulation over the
+         * union of two sets of values is then the reduction of the results of the accumulations over each set.
+         */
+        template<typename accumulator_t, typename value_t, typename = void>
+        struct has_reduce : public std::false_type {
+        };
+
+        template<typename accumulator_t, typename value_t>
+        struct has_reduce<accumulator_t, value_t, decltype(accumulator_t::template reduce<value_t>(
+                std::declval<const value_t &>(), std::declval<const value_t &>()), void())>
+                : public std::true_type {
+        };
+
+        /**
+         * True if an accumulation of data with the given number of dimensions (including the first axis) can be
+         * performed on scalar views: both the data elements and the elements of the result must be scalars.
+         */
+        template<typename accumulator_t>
+        bool use_scalar_views(const accumulator_t &accumulator, std::size_t data_dimension) {
+            return data_dimension == 1 && accumulator.get_output_shape(std::vector<std::size_t>()).size() == 0;
+        }
+
+        /**
+         * Variance accumulator: population variance of each component computed with the Welford online algorithm.
+         *
+         * The state (number of values, mean and sum of squared differences to the mean) is stored in the accumulator,
+         * two accumulators are merged with the pairwise update of Chan et al.
+         *
+         * @tparam S the storage type
+         * @tparam vectorial bool: is dimension of storage > 0 (different from scalar)
+         */
+        template<typename S, bool vectorial = true>
+        struct acc_variance_impl {
+            using value_type = typename std::iterator_traits<S>::value_type;
+            using self_type = acc_variance_impl<S, vectorial>;
+            static const bool is_vectorial = vectorial;
+
+            acc_variance_impl(S storage_begin, S storage_end) :
+                    m_storage_begin(storage_begin),
+                    m_storage_end(storage_end),
+                    m_mean(storage_end - storage_begin),
+                    m_m2(storage_end - storage_begin) {
+            }
+
+            template<typename ...Args>
+            void initialize(Args &&...) {
+                m_count = 0;
+                std::fill(m_mean.begin(), m_mean.end(), 0.0);
+                std::fill(m_m2.begin(), m_m2.end(), 0.0);
+            }
+
+            template<typename T, typename ...Args>
+            void accumulate(T value_begin, Args &&...) {
+                m_count++;
+                for (std::size_t k = 0; k < m_mean.size(); k++, value_begin++) {
+                    double x = (double) *value_begin;
+                    double delta = x - m_mean[k];
+                    m_mean[k] += delta / m_count;
+                    m_m2[k] += delta * (x - m_mean[k]);
+                }
+            }
+
+            void merge(const self_type &other) {
+                if (other.m_count == 0) {
+                    return;
+                }
+                double n = (double) (m_count + other.m_count);
+                for (std::size_t k = 0; k < m_mean.size(); k++) {
+                    double delta = other.m_mean[k] - m_mean[k];
+                    m_mean[k] += delta * other.m_count / n;
+                    m_m2[k] += other.m_m2[k] + delta * delta * ((double) m_count * other.m_count / n);
+                }
+                m_count += other.m_count;
+            }
+
+            template<typename ...Args>
+            void finalize(Args &&...) {
+                auto s = m_storage_begin;
+                for (std::size_t k = 0; k < m_m2.size(); k++, s++) {
+                    *s = (m_count == 0) ? 0 : (value_type) (m_m2[k] / m_count);
+                }
+            }
+
+            void set_storage(S storage_begin, S storage_end) {
+                m_storage_begin = storage_begin;
+                m_storage_end = storage_end;
+            }
+
+            template<typename T>
+            void set_storage(T &range) {
+                m_storage_begin = range.begin();
+                m_storage_end = range.end();
+            }
+
+        private:
+            S m_storage_begin;
+            S m_storage_end;
+            std::size_t m_count = 0;
+            std::vector<double> m_mean;
+            std::vector<double> m_m2;
+        };
+
+        /**
+         * Covariance accumulator: population covariance matrix of vectors of dimension d (the storage has d * d
+         * elements) computed with an online co-moment update. Two accumulators are merged with the pairwise update of
+         * Chan et al.
+         *
+         * @tparam S the storage type
+         * @tparam vectorial bool: is dimension of storage > 0 (different from scalar)
+         */
+        template<typename S, bool vectorial = true>
+        struct acc_covariance_impl {
+            using value_type = typename std::iterator_traits<S>::value_type;
+            using self_type = acc_covariance_impl<S, vectorial>;
+            static const bool is_vectorial = vectorial;
+
+            acc_covariance_impl(S storage_begin, S storage_end) :
+                    m_storage_begin(storage_begin),
+                    m_storage_end(storage_end),
+                    m_dim((std::size_t) std::llround(std::sqrt((double) (storage_end - storage_begin)))),
+                    m_mean(m_dim),
+                    m_value(m_dim),
+                    m_comoment(m_dim * m_dim) {
+                hg_assert(m_dim * m_dim == (std::size_t) (storage_end - storage_begin),
+                          "Covariance storage must be a square matrix.");
+            }
+
+            template<typename ...Args>
+            void initialize(Args &&...) {
+                m_count = 0;
+                std::fill(m_mean.begin(), m_mean.end(), 0.0);
+                std::fill(m_comoment.begin(), m_comoment.end(), 0.0);
+            }
+
+            template<typename T, typename ...Args>
+            void accumulate(T value_begin, Args &&...) {
+                m_count++;
+                // m_value = x - old mean, then the mean is updated
+                for (std::size_t i = 0; i < m_dim; i++, value_begin++) {
+                    m_value[i] = (double) *value_begin - m_mean[i];
+                    m_mean[i] += m_value[i] / m_count;
+                }
+                double r = (m_count - 1.0) / m_count;
+                for (std::size_t i = 0; i < m_dim; i++) {
+                    for (std::size_t j = 0; j < m_dim; j++) {
+                        m_comoment[i * m_dim + j] += r * m_value[i] * m_value[j];
+                    }
+                }
+            }
+
+            void merge(const self_type &other) {
+                if (other.m_count == 0) {
+                    return;
+                }
+                double n = (double) (m_count + other.m_count);
+                double r = (double) m_count * other.m_count / n;
+                for (std::size_t i = 0; i < m_dim; i++) {
+                    m_value[i] = other.m_mean[i] - m_mean[i];
+                }
+                for (std::size_t i = 0; i < m_dim; i++) {
+                    for (std::size_t j = 0; j < m_dim; j++) {
+                        m_comoment[i * m_dim + j] += other.m_comoment[i * m_dim + j] + r * m_value[i] * m_value[j];
+                    }
+                    m_mean[i] += m_value[i] * other.m_count / n;
+                }
+                m_count += other.m_count;
+            }
+
+            template<typename ...Args>
+            void finalize(Args &&...) {
+                auto s = m_storage_begin;
+                for (std::size_t k = 0; k < m_comoment.size(); k++, s++) {
+                    *s = (m_count == 0) ? 0 : (value_type) (m_comoment[k] / m_count);
+                }
+            }
+
+            void set_storage(S storage_begin, S storage_end) {
+                m_storage_begin = storage_begin;
+                m_storage_end = storage_end;
+            }
+
+            template<typename T>
+            void set_storage(T &range) {
+                m_storage_begin = range.begin();
+                m_storage_end = range.end();
+            }
+
+        private:
+            S m_storage_begin;
+            S m_storage_end;
+            std::size_t m_dim;
+            std::size_t m_count = 0;
+            std::vector<double> m_mean;
+            std::vector<double> m_value;
+            std::vector<double> m_comoment;
+        };
+
+        /**
+         * Histogram accumulator: counts the values of each component in num_bins bins of equal width
+         * covering [min, max] (the last bin is closed, values outside [min, max] are ignored).
+         * The storage contains the num_bins counts of the first component, followed by the counts of the second
+         * component...
+         *
+         * @tparam S the storage type
+         * @tparam vectorial bool: is dimension of storage > 0 (different from scalar)
+         */
+        template<typename S, bool vectorial = true>
+        struct acc_histogram_impl {
+            using value_type = typename std::iterator_traits<S>::value_type;
+            using self_type = acc_histogram_impl<S, vectorial>;
+            static const bool is_vectorial = vectorial;
+
+            acc_histogram_impl(S storage_begin, S storage_end, index_t num_bins, double min, double max) :
+                    m_storage_begin(storage_begin),
+                    m_storage_end(storage_end),
+                    m_num_bins(num_bins),
+                    m_min(min),
+                    m_scale((max > min) ? num_bins / (max - min) : 0),
+                    m_max(max),
+                    m_counts(storage_end - storage_begin) {
+            }
+
+            template<typename ...Args>
+            void initialize(Args &&...) {
+                std::fill(m_counts.begin(), m_counts.end(), 0);
+            }
+
+            template<typename T, typename ...Args>
+            void accumulate(T value_begin, Args &&...) {
+                for (std::size_t c = 0; c < m_counts.size(); c += m_num_bins, value_begin++) {
+                    double x = (double) *value_begin;
+                    if (x >= m_min && x <= m_max) {
+                        index_t bin = (std::min)((index_t) ((x - m_min) * m_scale), m_num_bins - 1);
+                        m_counts[c + bin]++;
+                    }
+                }
+            }
+
+            void merge(const self_type &other) {
+                for (std::size_t k = 0; k < m_counts.size(); k++) {
+                    m_counts[k] += other.m_counts[k];
+                }
+            }
+
+            template<typename ...Args>
+            void finalize(Args &&...) {
+                std::copy(m_counts.begin(), m_counts.end(), m_storage_begin);
+            }
+
+            void set_storage(S storage_begin, S storage_end) {
+                m_storage_begin = storage_begin;
+                m_storage_end = storage_end;
+            }
+
+            template<typename T>
+            void set_storage(T &range) {
+                m_storage_begin = range.begin();
+                m_storage_end = range.end();
+            }
+
+        private:
+            S m_storage_begin;
+            S m_storage_end;
+            index_t m_num_bins;
+            double m_min;
+            double m_scale;
+            double m_max;
+            std::vector<index_t> m_counts;
+        };
+
+        /**
+         * Merging t-digest (T. Dunning and O. Ertl, Computing extremely accurate quantiles using t-digests, 2019) with
+         * the scale function k1: a mergeable summary of a distribution of real values whose size is bounded by the
+         * compression parameter and which gives accurate estimates of extreme quantiles.
+         *
+         * Quantiles are estimated by linear interpolation between the centers of the centroids, the result is thus
+         * exact (identical to the linear interpolation of numpy.quantile) as long as no centroid has been merged.
+         */
+        struct tdigest {
+
+            tdigest(double compression = 100) :
+                    m_compression(compression),
+                    m_buffer_capacity((std::size_t) (5 * compression)) {
+            }
+
+            void clear() {
+                m_centroids.clear();
+                m_buffer.clear();
+                m_total_weight = 0;
+            }
+
+            double total_weight() const {
+                return m_total_weight;
+            }
+
+            void add(double value, double weight = 1) {
+                if (m_total_weight == 0) {
+                    m_min = value;
+                    m_max = value;
+                } else {
+                    m_min = (std::min)(m_min, value);
+                    m_max = (std::max)(m_max, value);
+                }
+                m_buffer.push_back({value, weight});
+                m_total_weight += weight;
+                if (m_buffer.size() >= m_buffer_capacity) {
+                    compress();
+                }
+            }
+
+            void merge(const tdigest &other) {
+                if (other.m_total_weight == 0) {
+                    return;
+                }
+                for (const auto &c: other.m_centroids) {
+                    add(c.mean, c.weight);
+                }
+                for (const auto &c: other.m_buffer) {
+                    add(c.mean, c.weight);
+                }
+                m_min = (std::min)(m_min, other.m_min);
+                m_max = (std::max)(m_max, other.m_max);
+            }
+
+            void compress() {
+                if (m_buffer.empty()) {
+                    return;
+                }
+                m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+                std::sort(m_buffer.begin(), m_buffer.end(),
+                          [](const centroid &a, const centroid &b) { return a.mean < b.mean; });
+                m_centroids.clear();
+
+                centroid current = m_buffer[0];
+                double weight_so_far = 0;
+                double weight_limit = m_total_weight * k_inverse(k(0) + 1);
+                for (std::size_t i = 1; i < m_buffer.size(); i++) {
+                    const auto &c = m_buffer[i];
+                    if (weight_so_far + current.weight + c.weight <= weight_limit) {
+                        current.mean += (c.mean - current.mean) * c.weight / (current.weight + c.weight);
+                        current.weight += c.weight;
+                    } else {
+                        weight_so_far += current.weight;
+                        m_centroids.push_back(current);
+                        weight_limit = m_total_weight * k_inverse(k(weight_so_far / m_total_weight) + 1);
+                        current = c;
+                    }
+                }
+                m_centroids.push_back(current);
+                m_buffer.clear();
+            }
+
+            /**
+             * Estimated q-quantile (q in [0, 1]) of the values added to the digest (0 if the digest is empty).
+             */
+            double quantile(double q) {
+                compress();
+                if (m_centroids.empty()) {
+                    return 0;
+                }
+                // position of the target in the sorted sequence of values and of the center of each centroid
+                double target = q * (m_total_weight - 1);
+                double previous_center = 0;
+                double previous_value = m_min;
+                double weight_so_far = 0;
+                for (const auto &c: m_centroids) {
+                    double center = weight_so_far + (c.weight - 1) / 2;
+                    if (target <= center) {
+                        if (center == previous_center) {
+                            return c.mean;
+                        }
+                        return previous_value +
+                               (c.mean - previous_value) * (target - previous_center) / (center - previous_center);
+                    }
+                    previous_center = center;
+                    previous_value = c.mean;
+                    weight_so_far += c.weight;
+                }
+                double last = m_total_weight - 1;
+                if (last == previous_center) {
+                    return m_max;
+                }
+                return previous_value + (m_max - previous_value) * (target - previous_center) / (last - previous_center);
+            }
+
+        private:
+
+            struct centroid {
+                double mean;
+                double weight;
+            };
+
+            static constexpr double pi = 3.14159265358979323846;
+
+            double k(double q) const {
+                return m_compression / (2 * pi) * std::asin(2 * (std::min)(q, 1.0) - 1);
+            }
+
+            double k_inverse(double k) const {
+                double x = k * 2 * pi / m_compression;
+                if (x >= pi / 2) {
+                    return 1;
+                }
+                return (std::sin(x) + 1) / 2;
+            }
+
+            double m_compression;
+            std::size_t m_buffer_capacity;
+            double m_total_weight = 0;
+            double m_min = 0;
+            double m_max = 0;
+            std::vector<centroid> m_centroids;
+            std::vector<centroid> m_buffer;
+        };
+
+        /**
+         * Quantile accumulator: estimation of the q-quantile of each component with a t-digest.
+         *
+         * @tparam S the storage type
+         * @tparam vectorial bool: is dimension of storage > 0 (different from scalar)
+         */
+        template<typename S, bool vectorial = true>
+        struct acc_quantile_impl {
+            using value_type = typename std::iterator_traits<S>::value_type;
+            using self_type = acc_quantile_impl<S, vectorial>;
+            static const bool is_vectorial = vectorial;
+
+            acc_quantile_impl(S storage_begin, S storage_end, double q, double compression) :
+                    m_storage_begin(storage_begin),
+                    m_storage_end(storage_end),
+                    m_q(q),
+                    m_digests(storage_end - storage_begin, tdigest(compression)) {
+            }
+
+            template<typename ...Args>
+            void initialize(Args &&...) {
+                for (auto &d: m_digests) {
+                    d.clear();
+                }
+            }
+
+            template<typename T, typename ...Args>
+            void accumulate(T value_begin, Args &&...) {
+                for (auto &d: m_digests) {
+                    d.add((double) *value_begin);
+                    value_begin++;
+                }
+            }
+
+            void merge(const self_type &other) {
+                for (std::size_t k = 0; k < m_digests.size(); k++) {
+                    m_digests[k].merge(other.m_digests[k]);
+                }
+            }
+
+            template<typename ...Args>
+            void finalize(Args &&...) {
+                auto s = m_storage_begin;
+                for (auto &d: m_digests) {
+                    *s = (value_type) d.quantile(m_q);
+                    s++;
+                }
+            }
+
+            void set_storage(S storage_begin, S storage_end) {
+                m_storage_begin = storage_begin;
+                m_storage_end = storage_end;
+            }
+
+            template<typename T>
+            void set_storage(T &range) {
+                m_storage_begin = range.begin();
+                m_storage_end = range.end();
+            }
+
+        private:
+            S m_storage_begin;
+            S m_storage_end;
+            double m_q;
+            std::vector<tdigest> m_digests;
+        };
     }
 
     struct accumulator_sum {
@@ -568,6 +1138,13 @@ namespace hg {
         static value_type reduce(const value_type & v1, const value_type & v2){
             return v1 + v2;
         }
+
+#ifdef XTENSOR_USE_XSIMD
+        template <typename batch_t>
+        static batch_t reduce_batch(const batch_t & v1, const batch_t & v2){
+            return v1 + v2;
+        }
+#endif
     };
 
     struct accumulator_min {
@@ -596,6 +1173,13 @@ namespace hg {
         static value_type reduce(const value_type & v1, const value_type & v2){
             return (std::min)(v1, v2);
         }
+
+#ifdef XTENSOR_USE_XSIMD
+        template <typename batch_t>
+        static batch_t reduce_batch(const batch_t & v1, const batch_t & v2){
+            return xsimd::min(v1, v2);
+        }
+#endif
     };
 
     struct accumulator_max {
@@ -624,6 +1208,13 @@ namespace hg {
         static value_type reduce(const value_type & v1, const value_type & v2){
             return (std::max)(v1, v2);
         }
+
+#ifdef XTENSOR_USE_XSIMD
+        template <typename batch_t>
+        static batch_t reduce_batch(const batch_t & v1, const batch_t & v2){
+            return xsimd::max(v1, v2);
+        }
+#endif
     };
 
     struct accumulator_prod {
@@ -652,6 +1243,13 @@ namespace hg {
         static value_type reduce(const value_type & v1, const value_type & v2){
             return v1 * v2;
         }
+
+#ifdef XTENSOR_USE_XSIMD
+        template <typename batch_t>
+        static batch_t reduce_batch(const batch_t & v1, const batch_t & v2){
+            return v1 * v2;
+        }
+#endif
     };
 
     struct accumulator_mean {
@@ -757,4 +1355,136 @@ namespace hg {
             return input_shape;
         }
     };
+
+    /**
+     * Population variance of the values, computed independently on each component of vectorial values.
+     *
+     * The accumulators are mergeable: in accumulate_sequential, the variance of a node is the variance of the values
+     * of the leaves of its subtree.
+     */
+    struct accumulator_variance {
+
+        template<bool vectorial = true, typename S>
+        auto make_accumulator(S &storage) const {
+            using iterator_type = decltype(storage.begin());
+            return accumulator_detail::acc_variance_impl<iterator_type, vectorial>(
+                    storage.begin(),
+                    storage.end());
+        }
+
+        template<typename shape_t>
+        static
+        auto get_output_shape(const shape_t &input_shape) {
+            return input_shape;
+        }
+    };
+
+    /**
+     * Population covariance matrix of the values: the result associated to values of dimension d is a d x d matrix
+     * (values with several axes are flattened, scalar values give their variance).
+     *
+     * The accumulators are mergeable: in accumulate_sequential, the covariance of a node is the covariance of the
+     * values of the leaves of its subtree.
+     */
+    struct accumulator_covariance {
+
+        template<bool vectorial = true, typename S>
+        auto make_accumulator(S &storage) const {
+            using iterator_type = decltype(storage.begin());
+            return accumulator_detail::acc_covariance_impl<iterator_type, vectorial>(
+                    storage.begin(),
+                    storage.end());
+        }
+
+        template<typename shape_t>
+        static
+        auto get_output_shape(const shape_t &input_shape) {
+            std::vector<std::size_t> output_shape;
+            if (input_shape.size() > 0) {
+                std::size_t dim = 1;
+                for (auto s: input_shape) {
+                    dim *= s;
+                }
+                output_shape = {dim, dim};
+            }
+            return output_shape;
+        }
+    };
+
+    /**
+     * Histogram of the values with num_bins bins of equal width covering [min, max]: values outside [min, max] are
+     * ignored, the last bin is closed. The result associated to values of shape (s1, ..., sn) has the shape
+     * (s1, ..., sn, num_bins).
+     *
+     * The accumulators are mergeable: in accumulate_sequential, the histogram of a node is the histogram of the
+     * values of the leaves of its subtree.
+     */
+    struct accumulator_histogram {
+
+        accumulator_histogram(index_t num_bins, double min, double max) :
+                m_num_bins(num_bins), m_min(min), m_max(max) {
+            hg_assert(num_bins > 0, "The number of bins must be strictly positive.");
+            hg_assert(min <= max, "Invalid histogram range.");
+        }
+
+        template<bool vectorial = true, typename S>
+        auto make_accumulator(S &storage) const {
+            using iterator_type = decltype(storage.begin());
+            return accumulator_detail::acc_histogram_impl<iterator_type, vectorial>(
+                    storage.begin(),
+                    storage.end(),
+                    m_num_bins,
+                    m_min,
+                    m_max);
+        }
+
+        template<typename shape_t>
+        auto get_output_shape(const shape_t &input_shape) const {
+            std::vector<std::size_t> output_shape(input_shape.begin(), input_shape.end());
+            output_shape.push_back(m_num_bins);
+            return output_shape;
+        }
+
+    private:
+        index_t m_num_bins;
+        double m_min;
+        double m_max;
+    };
+
+    /**
+     * Estimation of the q-quantile (q in [0, 1]) of the values, computed independently on each component of vectorial
+     * values, with a t-digest of the given compression (the result is exact for sets of values that are small
+     * compared to the compression).
+     *
+     * The accumulators are mergeable: in accumulate_sequential, the quantile of a node is the quantile of the
+     * values of the leaves of its subtree.
+     */
+    struct accumulator_quantile {
+
+        accumulator_quantile(double q, double compression = 100) :
+                m_q(q), m_compression(compression) {
+            hg_assert(q >= 0 && q <= 1, "Quantile must be in [0, 1].");
+            hg_assert(compression > 0, "Compression must be strictly positive.");
+        }
+
+        template<bool vectorial = true, typename S>
+        auto make_accumulator(S &storage) const {
+            using iterator_type = decltype(storage.begin());
+            return accumulator_detail::acc_quantile_impl<iterator_type, vectorial>(
+                    storage.begin(),
+                    storage.end(),
+                    m_q,
+                    m_compression);
+        }
+
+        template<typename shape_t>
+        static
+        auto get_output_shape(const shape_t &input_shape) {
+            return input_shape;
+        }
+
+    private:
+        double m_q;
+        double m_compression;
+    };
 }
@@ -13,6 +13,8 @@
 #include "../structure/array.hpp"
 #include "accumulator.hpp"
 #include "../structure/details/light_axis_view.hpp"
+#include "../sorting.hpp"
+#include <algorithm>
 
 namespace hg {
 
@@ -31,7 +33,7 @@ namespace hg {
 
             index_t size = xt::amax(indices)() + 1;
             auto data_shape = std::vector<size_t>(weights.shape().begin() + 1, weights.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), size);
             array_nd<typename T::value_type> res = array_nd<typename T::value_type>::from_shape(output_shape);
 
@@ -62,6 +64,247 @@ namespace hg {
 
             return res;
         }
+
+        /**
+         * Number of blocks used by the multithreaded versions of accumulate_at for an input of the given size (see
+         * parallel_reduction_num_blocks).
+         */
+        inline
+        index_t at_accumulator_num_blocks(index_t map_size) {
+            return parallel_reduction_num_blocks(map_size, 65536);
+        }
+
+        /**
+         * True if the accumulation can be performed with private output buffers: the partial results computed on
+         * several blocks of the input can be combined, either by merging the accumulators or, for marginal
+         * accumulators, by reducing the accumulated values.
+         */
+        template<bool vectorial, typename T, typename accumulator_t>
+        struct at_accumulator_private_buffer_traits {
+            using value_type = typename T::value_type;
+            using output_view_t = decltype(make_light_axis_view<vectorial>(std::declval<array_nd<value_type> &>()));
+            using acc_t = decltype(std::declval<const accumulator_t &>().template make_accumulator<vectorial>(
+                    std::declval<output_view_t &>()));
+            using mergeable = accumulator_detail::is_mergeable<acc_t>;
+            using reducible = accumulator_detail::has_reduce<accumulator_t, value_type>;
+            static const bool is_combinable = mergeable::value || reducible::value;
+        };
+
+        /**
+         * Combination of the partial results of at_accumulate_private_buffers: the accumulators of the other blocks
+         * are merged into the accumulators of the first block (mergeable accumulators) or the private buffers are
+         * reduced into the result (marginal accumulators).
+         */
+        template<typename accumulator_t, typename value_type, typename acc_t>
+        void at_accumulate_combine(array_nd<value_type> &,
+                                   std::vector<array_nd<value_type>> &,
+                                   std::vector<std::vector<acc_t>> &accs,
+                                   index_t num_blocks,
+                                   std::true_type /* mergeable */) {
+            const index_t size = accs[0].size();
+            const index_t block_size = (size + num_blocks - 1) / num_blocks;
+            parfor(0, num_blocks, [&](index_t c) {
+                const index_t end = (std::min)(size, (c + 1) * block_size);
+                for (index_t i = c * block_size; i < end; ++i) {
+                    for (index_t b = 1; b < num_blocks; ++b) {
+                        accs[0][i].merge(accs[b][i]);
+                    }
+                    accs[0][i].finalize();
+                }
+            });
+        }
+
+        template<typename accumulator_t, typename value_type, typename acc_t>
+        void at_accumulate_combine(array_nd<value_type> &res,
+                                   std::vector<array_nd<value_type>> &buffers,
+                                   std::vector<std::vector<acc_t>> &,
+                                   index_t num_blocks,
+                                   std::false_type /* mergeable */) {
+            const index_t size = res.size();
+            const index_t block_size = (size + num_blocks - 1) / num_blocks;
+            auto res_data = res.data();
+            parfor(0, num_blocks, [&](index_t c) {
+                const index_t end = (std::min)(size, (c + 1) * block_size);
+                for (auto &buffer: buffers) {
+                    auto buffer_data = buffer.data();
+                    for (index_t i = c * block_size; i < end; ++i) {
+                        res_data[i] = accumulator_t::template reduce<value_type>(res_data[i], buffer_data[i]);
+                    }
+                }
+            });
+        }
+
+        /**
+         * Multithreaded accumulation with private output buffers: the input is split into num_blocks blocks of
+         * consecutive elements, each block is accumulated in its own set of accumulators, and the partial results
+         * are then combined element-wise in block order.
+         *
+         * Mergeable accumulators are merged before being finalized. For marginal accumulators, each block writes its
+         * results in a private buffer which are then reduced: the floating point results may thus slightly differ
+         * from the ones of the serial version.
+         */
+        template<bool vectorial,
+                typename T,
+                typename accumulator_t>
+        auto
+        at_accumulate_private_buffers(const array_1d<index_t> &indices,
+                                      const xt::xexpression<T> &xweights,
+                                      const accumulator_t &accumulator,
+                                      index_t num_blocks) {
+            HG_TRACE();
+            using value_type = typename T::value_type;
+            using traits = at_accumulator_private_buffer_traits<vectorial, T, accumulator_t>;
+            using acc_t = typename traits::acc_t;
+            const bool mergeable = traits::mergeable::value;
+            static_assert(traits::is_combinable, "Accumulator partial results cannot be combined.");
+
+            auto &weights = xweights.derived_cast();
+            hg_assert(weights.shape()[0] == indices.size(), "Weights dimension does not match rag map dimension.");
+
+            index_t size = xt::amax(indices)() + 1;
+            auto data_shape = std::vector<size_t>(weights.shape().begin() + 1, weights.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), size);
+            array_nd<value_type> res = array_nd<value_type>::from_shape(output_shape);
+
+            const index_t map_size = indices.size();
+            num_blocks = (std::max)((index_t) 1, (std::min)(num_blocks, map_size));
+            const index_t block_size = (map_size + num_blocks - 1) / num_blocks;
+            num_blocks = (map_size + block_size - 1) / block_size;
+
+            // mergeable accumulators are only finalized in the accumulators of the first block: all blocks can share
+            // the output array, otherwise each block writes in its own buffer
+            std::vector<array_nd<value_type>> buffers(mergeable ? 0 : (std::max)((index_t) 0, num_blocks - 1));
+            std::vector<std::vector<acc_t>> accs(num_blocks);
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto &output = (mergeable || b == 0) ? res : buffers[b - 1];
+                if (!mergeable && b > 0) {
+                    output = array_nd<value_type>::from_shape(output_shape);
+                }
+                auto input_view = make_light_axis_view<vectorial>(weights);
+                auto output_view = make_light_axis_view<vectorial>(output);
+                auto &block_accs = accs[b];
+                block_accs.reserve(size);
+                for (index_t i = 0; i < size; ++i) {
+                    output_view.set_position(i);
+                    block_accs.push_back(accumulator.template make_accumulator<vectorial>(output_view));
+                    block_accs[i].initialize();
+                }
+
+                const index_t end = (std::min)(map_size, (b + 1) * block_size);
+                for (index_t i = b * block_size; i < end; ++i) {
+                    if (indices.data()[i] != invalid_index) {
+                        input_view.set_position(i);
+                        block_accs[indices.data()[i]].accumulate(input_view.begin());
+                    }
+                }
+
+                if (!mergeable) {
+                    for (auto &acc: block_accs) {
+                        acc.finalize();
+                    }
+                    block_accs = std::vector<acc_t>();
+                }
+            });
+
+            at_accumulate_combine<accumulator_t>(res, buffers, accs, num_blocks, typename traits::mergeable());
+            return res;
+        }
+
+        /**
+         * Multithreaded accumulation by segmented reduction: the input elements are stably sorted by output index
+         * (radix sort), the output is split into num_blocks blocks of consecutive indices and each block accumulates
+         * the corresponding contiguous segments of sorted elements.
+         *
+         * The elements associated to a given output index are accumulated in the same order as in the serial version:
+         * the result is identical for all accumulators.
+         */
+        template<bool vectorial,
+                typename T,
+                typename accumulator_t>
+        auto
+        at_accumulate_segmented(const array_1d<index_t> &indices,
+                                const xt::xexpression<T> &xweights,
+                                const accumulator_t &accumulator,
+                                index_t num_blocks) {
+            HG_TRACE();
+            auto &weights = xweights.derived_cast();
+            hg_assert(weights.shape()[0] == indices.size(), "Weights dimension does not match rag map dimension.");
+
+            index_t size = xt::amax(indices)() + 1;
+            auto data_shape = std::vector<size_t>(weights.shape().begin() + 1, weights.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), size);
+            array_nd<typename T::value_type> res = array_nd<typename T::value_type>::from_shape(output_shape);
+            if (size == 0) {
+                return res;
+            }
+
+            // invalid indices (-1) are placed at the beginning of the sorted sequence and never reached
+            array_1d<index_t> sorted = stable_arg_sort(indices);
+            auto index_less = [&indices](index_t position, index_t index) {
+                return indices.data()[position] < index;
+            };
+
+            num_blocks = (std::max)((index_t) 1, (std::min)(num_blocks, size));
+            const index_t block_size = (size + num_blocks - 1) / num_blocks;
+            num_blocks = (size + block_size - 1) / block_size;
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto input_view = make_light_axis_view<vectorial>(weights);
+                auto output_view = make_light_axis_view<vectorial>(res);
+                auto acc = accumulator.template make_accumulator<vectorial>(output_view);
+
+                const index_t start = b * block_size;
+                const index_t end = (std::min)(size, start + block_size);
+                auto it = std::lower_bound(sorted.begin(), sorted.end(), start, index_less);
+                for (index_t i = start; i < end; ++i) {
+                    output_view.set_position(i);
+                    acc.set_storage(output_view);
+                    acc.initialize();
+                    for (; it != sorted.end() && indices.data()[*it] == i; ++it) {
+                        input_view.set_position(*it);
+                        acc.accumulate(input_view.begin());
+                    }
+                    acc.finalize();
+                }
+            });
+
+            return res;
+        }
+
+        template<bool vectorial, typename T, typename accumulator_t>
+        auto at_accumulate(execution::parallel_policy,
+                           const array_1d<index_t> &indices,
+                           const xt::xexpression<T> &xweights,
+                           const accumulator_t &accumulator,
+                           std::true_type /* combinable */) {
+            index_t map_size = indices.size();
+            index_t num_blocks = at_accumulator_num_blocks(map_size);
+            if (num_blocks <= 1) {
+                return at_accumulate<vectorial>(indices, xweights, accumulator);
+            }
+            // private buffers are used as long as their total size does not exceed the size of the input
+            index_t size = (map_size == 0) ? 0 : xt::amax(indices)() + 1;
+            if (num_blocks * size <= map_size) {
+                return at_accumulate_private_buffers<vectorial>(indices, xweights, accumulator, num_blocks);
+            }
+            return at_accumulate_segmented<vectorial>(indices, xweights, accumulator, num_blocks);
+        }
+
+        template<bool vectorial, typename T, typename accumulator_t>
+        auto at_accumulate(execution::parallel_policy,
+                           const array_1d<index_t> &indices,
+                           const xt::xexpression<T> &xweights,
+                           const accumulator_t &accumulator,
+                           std::false_type /* combinable */) {
+            index_t num_blocks = at_accumulator_num_blocks(indices.size());
+            if (num_blocks <= 1) {
+                return at_accumulate<vectorial>(indices, xweights, accumulator);
+            }
+            return at_accumulate_segmented<vectorial>(indices, xweights, accumulator, num_blocks);
+        }
     }
 
     /**
@@ -85,7 +328,7 @@ namespace hg {
     auto accumulate_at(const array_1d<index_t> &indices,
                        const xt::xexpression<T> &xweights,
                        const accumulator_t &accumulator) {
-        if (xweights.derived_cast().dimension() == 1) {
+        if (accumulator_detail::use_scalar_views(accumulator, xweights.derived_cast().dimension())) {
             return at_accumulator_internal::at_accumulate<false, T, accumulator_t, output_t>(indices,
                                                                                              xweights,
                                                                                              accumulator);
@@ -96,4 +339,50 @@ namespace hg {
         }
     };
 
+    /**
+     * Multithreaded version of accumulate_at.
+     *
+     * The input is processed in parallel with one of the two following strategies, chosen according to the ratio
+     * between the size of the output and the size of the input:
+     *
+     *  - small outputs: each thread accumulates a block of the input in private output buffers which are then combined.
+     *    This strategy requires accumulators whose partial results can be combined: mergeable accumulators (variance,
+     *    covariance, histogram, quantile) and marginal accumulators (sum, min, max, prod). For the latter, floating
+     *    point results may slightly differ from the ones of the serial version;
+     *  - large outputs (or other accumulators): the input is stably sorted by output index and each thread reduces the
+     *    segments associated to a block of output indices. The result is identical to the one of the serial version.
+     *
+     * @tparam T
+     * @tparam accumulator_t
+     * @tparam output_t
+     * @param policy execution::par
+     * @param indices a 1d array of indices (entry equals to :math:`-1` are ignored)
+     * @param xweights a nd-array of shape :math:`(s_1, \ldots, s_n)` such that :math:`s_1=indices.size()`
+     * @param accumulator
+     * @return a nd-array of size :math:`(M, s_2, \ldots, s_n)`
+     */
+    template<typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_at(execution::parallel_policy policy,
+                       const array_1d<index_t> &indices,
+                       const xt::xexpression<T> &xweights,
+                       const accumulator_t &accumulator) {
+        if (accumulator_detail::use_scalar_views(accumulator, xweights.derived_cast().dimension())) {
+            using traits = at_accumulator_internal::at_accumulator_private_buffer_traits<false, T, accumulator_t>;
+            return at_accumulator_internal::at_accumulate<false>(
+                    policy, indices, xweights, accumulator, std::integral_constant<bool, traits::is_combinable>());
+        } else {
+            using traits = at_accumulator_internal::at_accumulator_private_buffer_traits<true, T, accumulator_t>;
+            return at_accumulator_internal::at_accumulate<true>(
+                    policy, indices, xweights, accumulator, std::integral_constant<bool, traits::is_combinable>());
+        }
+    };
+
+    template<typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_at(execution::sequenced_policy,
+                       const array_1d<index_t> &indices,
+                       const xt::xexpression<T> &xweights,
+                       const accumulator_t &accumulator) {
+        return accumulate_at(indices, xweights, accumulator);
+    };
+
 }
@@ -18,6 +18,90 @@ namespace hg {
 
     namespace graph_accumulator_detail {
 
+        // number of consecutive vertices processed by a task in the multithreaded versions of the graph accumulators
+        constexpr index_t parallel_graph_accumulator_block_size = 4096;
+
+        template<typename graph_t, typename input_view_t, typename output_view_t, typename acc_t>
+        void accumulate_graph_edges_range(const graph_t &graph,
+                                          input_view_t &input_view,
+                                          output_view_t &output_view,
+                                          acc_t &acc,
+                                          index_t start,
+                                          index_t end) {
+            for (index_t i = start; i < end; i++) {
+                output_view.set_position(i);
+                acc.set_storage(output_view);
+                acc.initialize();
+                for (auto e: out_edge_iterator(i, graph)) {
+                    input_view.set_position(e);
+                    acc.accumulate(input_view.begin());
+                }
+            }
+        }
+
+        template<typename graph_t, typename input_view_t, typename output_view_t, typename acc_t>
+        void accumulate_graph_vertices_range(const graph_t &graph,
+                                             input_view_t &input_view,
+                                             output_view_t &output_view,
+                                             acc_t &acc,
+                                             index_t start,
+                                             index_t end) {
+            for (index_t i = start; i < end; i++) {
+                output_view.set_position(i);
+                acc.set_storage(output_view);
+                acc.initialize();
+                for (auto v: adjacent_vertex_iterator(i, graph)) {
+                    input_view.set_position(v);
+                    acc.accumulate(input_view.begin());
+                }
+            }
+        }
+
+        /**
+         * Regular graph fast path (see scan_regular_graph): the neighbours of a vertex in the safe area of the graph
+         * are obtained by adding constant offsets to its linear index, the other ones are the neighbours that lie
+         * inside the graph domain. Neighbours are accumulated in the same order as with adjacent_vertex_iterator.
+         */
+        template<typename embedding_t, typename input_view_t, typename output_view_t, typename acc_t>
+        void accumulate_graph_vertices_range(const regular_graph<embedding_t> &graph,
+                                             input_view_t &input_view,
+                                             output_view_t &output_view,
+                                             acc_t &acc,
+                                             index_t start,
+                                             index_t end) {
+            const auto &embedding = graph.embedding();
+            const auto &neighbours = graph.neighbours();
+            constexpr index_t dim = embedding_t::_dim;
+            point<index_t, dim> neighbour;
+
+            scan_regular_graph(
+                    graph, start, end,
+                    [&input_view, &output_view, &acc](index_t first, index_t last, const auto &offsets) {
+                        for (index_t i = first; i < last; i++) {
+                            output_view.set_position(i);
+                            acc.set_storage(output_view);
+                            acc.initialize();
+                            for (auto offset: offsets) {
+                                input_view.set_position(i + offset);
+                                acc.accumulate(input_view.begin());
+                            }
+                        }
+                    },
+                    [&](index_t i, const point<index_t, dim> &coordinates) {
+                        output_view.set_position(i);
+                        acc.set_storage(output_view);
+                        acc.initialize();
+                        for (const auto &n: neighbours) {
+                            for (index_t d = 0; d < dim; d++) {
+                                neighbour(d) = coordinates(d) + n(d);
+                            }
+                            if (embedding.contains(neighbour)) {
+                                input_view.set_position(embedding.grid2lin(neighbour));
+                                acc.accumulate(input_view.begin());
+                            }
+                        }
+                    });
+        }
 
         template<bool vectorial,
                 typename graph_t,
@@ -32,7 +116,7 @@ namespace hg {
             hg_assert_edge_weights(graph, input);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), num_vertices(graph));
 
             array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
@@ -41,15 +125,46 @@ namespace hg {
             auto output_view = make_light_axis_view<vectorial>(output);
             auto acc = accumulator.template make_accumulator<vectorial>(output_view);
 
-            for (auto i: vertex_iterator(graph)) {
-                output_view.set_position(i);
-                acc.set_storage(output_view);
-                acc.initialize();
-                for (auto e: out_edge_iterator(i, graph)) {
-                    input_view.set_position(e);
-                    acc.accumulate(input_view.begin());
-                }
-            }
+            accumulate_graph_edges_range(graph, input_view, output_view, acc, 0, num_vertices(graph));
+
+            return output;
+        };
+
+        /**
+         * Multithreaded edge accumulator: the result of each vertex is independent, vertices are thus processed
+         * by blocks of consecutive indices.
+         */
+        template<bool vectorial,
+                typename graph_t,
+                typename T,
+                typename accumulator_t,
+                typename output_t = typename T::value_type>
+        auto accumulate_graph_edges_impl(execution::parallel_policy,
+                                         const graph_t &graph,
+                                         const xt::xexpression<T> &xinput,
+                                         const accumulator_t accumulator) {
+            HG_TRACE();
+            auto &input = xinput.derived_cast();
+            hg_assert_edge_weights(graph, input);
+
+            auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), num_vertices(graph));
+
+            array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
+
+            index_t num_v = num_vertices(graph);
+            index_t num_blocks = (num_v + parallel_graph_accumulator_block_size - 1) /
+                                 parallel_graph_accumulator_block_size;
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto input_view = make_light_axis_view<vectorial>(input);
+                auto output_view = make_light_axis_view<vectorial>(output);
+                auto acc = accumulator.template make_accumulator<vectorial>(output_view);
+                accumulate_graph_edges_range(graph, input_view, output_view, acc,
+                                             b * parallel_graph_accumulator_block_size,
+                                             (std::min)(num_v, (b + 1) * parallel_graph_accumulator_block_size));
+            });
 
             return output;
         };
@@ -67,7 +182,7 @@ namespace hg {
             hg_assert_vertex_weights(graph, input);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), num_vertices(graph));
 
             array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
@@ -76,20 +191,49 @@ namespace hg {
             auto output_view = make_light_axis_view<vectorial>(output);
             auto acc = accumulator.template make_accumulator<vectorial>(output_view);
 
-            for (auto i: vertex_iterator(graph)) {
-                output_view.set_position(i);
-                acc.set_storage(output_view);
-                acc.initialize();
-                for (auto v: adjacent_vertex_iterator(i, graph)) {
-                    input_view.set_position(v);
-                    acc.accumulate(input_view.begin());
-                }
-            }
+            accumulate_graph_vertices_range(graph, input_view, output_view, acc, 0, num_vertices(graph));
 
             return output;
         };
 
+        /**
+         * Multithreaded vertex accumulator: the result of each vertex is independent, vertices are thus processed
+         * by blocks of consecutive indices.
+         */
+        template<bool vectorial,
+                typename graph_t,
+                typename T,
+                typename accumulator_t,
+                typename output_t = typename T::value_type>
+        auto accumulate_graph_vertices_impl(execution::parallel_policy,
+                                            const graph_t &graph,
+                                            const xt::xexpression<T> &xinput,
+                                            const accumulator_t accumulator) {
+            HG_TRACE();
+            auto &input = xinput.derived_cast();
+            hg_assert_vertex_weights(graph, input);
+
+            auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), num_vertices(graph));
 
+            array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
+
+            index_t num_v = num_vertices(graph);
+            index_t num_blocks = (num_v + parallel_graph_accumulator_block_size - 1) /
+                                 parallel_graph_accumulator_block_size;
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto input_view = make_light_axis_view<vectorial>(input);
+                auto output_view = make_light_axis_view<vectorial>(output);
+                auto acc = accumulator.template make_accumulator<vectorial>(output_view);
+                accumulate_graph_vertices_range(graph, input_view, output_view, acc,
+                                                b * parallel_graph_accumulator_block_size,
+                                                (std::min)(num_v, (b + 1) * parallel_graph_accumulator_block_size));
+            });
+
+            return output;
+        };
     }
 
     template<typename graph_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
@@ -97,7 +241,7 @@ namespace hg {
                                 const xt::xexpression<T> &xedge_weights,
                                 const accumulator_t &accumulator) {
         auto &edge_weights = xedge_weights.derived_cast();
-        if (edge_weights.dimension() == 1) {
+        if (accumulator_detail::use_scalar_views(accumulator, edge_weights.dimension())) {
             return graph_accumulator_detail::accumulate_graph_edges_impl<false>(graph, xedge_weights, accumulator);
         } else {
             return graph_accumulator_detail::accumulate_graph_edges_impl<true>(graph, xedge_weights, accumulator);
@@ -109,12 +253,84 @@ namespace hg {
                                    const xt::xexpression<T> &xvertex_weights,
                                    const accumulator_t &accumulator) {
         auto &vertex_weights = xvertex_weights.derived_cast();
-        if (vertex_weights.dimension() == 1) {
+        if (accumulator_detail::use_scalar_views(accumulator, vertex_weights.dimension())) {
             return graph_accumulator_detail::accumulate_graph_vertices_impl<false>(graph, xvertex_weights, accumulator);
         } else {
             return graph_accumulator_detail::accumulate_graph_vertices_impl<true>(graph, xvertex_weights, accumulator);
         }
     };
 
+    /**
+     * Multithreaded version of accumulate_graph_edges: the result is identical to the one of the serial version.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @tparam accumulator_t
+     * @tparam output_t
+     * @param policy execution::par
+     * @param graph input graph
+     * @param xedge_weights input edge weights
+     * @param accumulator accumulator
+     * @return for each vertex, the accumulation of the weights of its out edges
+     */
+    template<typename graph_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_graph_edges(execution::parallel_policy policy,
+                                const graph_t &graph,
+                                const xt::xexpression<T> &xedge_weights,
+                                const accumulator_t &accumulator) {
+        auto &edge_weights = xedge_weights.derived_cast();
+        if (accumulator_detail::use_scalar_views(accumulator, edge_weights.dimension())) {
+            return graph_accumulator_detail::accumulate_graph_edges_impl<false>(policy, graph, xedge_weights,
+                                                                                accumulator);
+        } else {
+            return graph_accumulator_detail::accumulate_graph_edges_impl<true>(policy, graph, xedge_weights,
+                                                                               accumulator);
+        }
+    };
+
+    template<typename graph_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_graph_edges(execution::sequenced_policy,
+                                const graph_t &graph,
+                                const xt::xexpression<T> &xedge_weights,
+                                const accumulator_t &accumulator) {
+        return accumulate_graph_edges(graph, xedge_weights, accumulator);
+    };
+
+    /**
+     * Multithreaded version of accumulate_graph_vertices: the result is identical to the one of the serial version.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @tparam accumulator_t
+     * @tparam output_t
+     * @param policy execution::par
+     * @param graph input graph
+     * @param xvertex_weights input vertex weights
+     * @param accumulator accumulator
+     * @return for each vertex, the accumulation of the weights of its adjacent vertices
+     */
+    template<typename graph_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_graph_vertices(execution::parallel_policy policy,
+                                   const graph_t &graph,
+                                   const xt::xexpression<T> &xvertex_weights,
+                                   const accumulator_t &accumulator) {
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        if (accumulator_detail::use_scalar_views(accumulator, vertex_weights.dimension())) {
+            return graph_accumulator_detail::accumulate_graph_vertices_impl<false>(policy, graph, xvertex_weights,
+                                                                                   accumulator);
+        } else {
+            return graph_accumulator_detail::accumulate_graph_vertices_impl<true>(policy, graph, xvertex_weights,
+                                                                                  accumulator);
+        }
+    };
+
+    template<typename graph_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_graph_vertices(execution::sequenced_policy,
+                                   const graph_t &graph,
+                                   const xt::xexpression<T> &xvertex_weights,
+                                   const accumulator_t &accumulator) {
+        return accumulate_graph_vertices(graph, xvertex_weights, accumulator);
+    };
+
 
 }
\ No newline at end of file
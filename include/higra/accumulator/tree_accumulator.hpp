@@ -13,9 +13,137 @@
 #include "../graph.hpp"
 #include "accumulator.hpp"
 #include "../structure/details/light_axis_view.hpp"
+#include <algorithm>
 
 namespace hg {
 
+    /**
+     * Level-synchronous schedule of the nodes of a tree: the nodes are grouped into levels such that the value of a
+     * node only depends on the values of nodes of previous levels. The levels are processed one after the other and
+     * the nodes of a level in parallel.
+     *
+     * The nodes of the level l are nodes(level_start(l)), ..., nodes(level_start(l + 1) - 1), in increasing order.
+     *
+     * See make_leaves_to_root_level_schedule and make_root_to_leaves_level_schedule.
+     */
+    struct tree_level_schedule {
+
+        // levels with less nodes are processed serially
+        static constexpr index_t parallel_level_min_size = 1024;
+
+        array_1d<index_t> level_start;
+        array_1d<index_t> nodes;
+
+        index_t num_levels() const {
+            return (index_t) level_start.size() - 1;
+        }
+
+        /**
+         * Calls fun(n) for each node n of the schedule, level after level.
+         *
+         * @tparam lambda_t
+         * @param fun function (index_t) -> void
+         */
+        template<typename lambda_t>
+        void for_each_node(execution::parallel_policy, const lambda_t &fun) const {
+            for (index_t l = 0; l < num_levels(); l++) {
+                const index_t start = level_start(l);
+                const index_t end = level_start(l + 1);
+                if (end - start < parallel_level_min_size) {
+                    for (index_t k = start; k < end; k++) {
+                        fun(nodes(k));
+                    }
+                } else {
+                    parfor(start, end, [this, &fun](index_t k) {
+                        fun(nodes(k));
+                    });
+                }
+            }
+        }
+
+        template<typename lambda_t>
+        void for_each_node(execution::sequenced_policy, const lambda_t &fun) const {
+            for (auto n: nodes) {
+                fun(n);
+            }
+        }
+    };
+
+    namespace tree_accumulator_detail {
+
+        /**
+         * Groups the nodes by level (counting sort): node i belongs to the level level[i], or to no level if
+         * level[i] is equal to invalid_index.
+         */
+        inline tree_level_schedule make_level_schedule(const std::vector<index_t> &level, index_t num_levels) {
+            array_1d<index_t> level_start = xt::zeros<index_t>({(size_t) num_levels + 1});
+            for (auto l: level) {
+                if (l != invalid_index) {
+                    level_start(l + 1)++;
+                }
+            }
+            for (index_t l = 0; l < num_levels; l++) {
+                level_start(l + 1) += level_start(l);
+            }
+            array_1d<index_t> nodes = array_1d<index_t>::from_shape({(size_t) level_start(num_levels)});
+            std::vector<index_t> position(level_start.begin(), level_start.end() - 1);
+            for (index_t i = 0; i < (index_t) level.size(); i++) {
+                if (level[i] != invalid_index) {
+                    nodes(position[level[i]]++) = i;
+                }
+            }
+            return {std::move(level_start), std::move(nodes)};
+        }
+    }
+
+    /**
+     * Level-synchronous schedule of the non-leaf nodes of a tree for leaves to root passes: the level of a node is
+     * its height minus 1 (the height of a leaf is 0 and the height of a node is 1 plus the maximal height of its
+     * children). Every child of a node of the level l is a leaf or belongs to a level smaller than l.
+     *
+     * @tparam tree_t
+     * @param tree input tree
+     * @return a tree_level_schedule
+     */
+    template<typename tree_t>
+    tree_level_schedule make_leaves_to_root_level_schedule(const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        std::vector<index_t> height(num_v, 0);
+        for (index_t i = 0; i < num_v - 1; i++) {
+            index_t p = parent(i, tree);
+            height[p] = (std::max)(height[p], height[i] + 1);
+        }
+        const index_t num_levels = height[num_v - 1];
+        for (index_t i = 0; i < num_v; i++) {
+            height[i] = (i < num_l) ? invalid_index : height[i] - 1;
+        }
+        return tree_accumulator_detail::make_level_schedule(height, num_levels);
+    }
+
+    /**
+     * Level-synchronous schedule of the nodes of a tree for root to leaves passes: the level of a node is its depth
+     * (the root is the only node of the level 0). The parent of a node of the level l belongs to the level l - 1.
+     *
+     * @tparam tree_t
+     * @param tree input tree
+     * @return a tree_level_schedule
+     */
+    template<typename tree_t>
+    tree_level_schedule make_root_to_leaves_level_schedule(const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        std::vector<index_t> depth(num_v);
+        depth[num_v - 1] = 0;
+        index_t num_levels = 1;
+        for (index_t i = num_v - 2; i >= 0; i--) {
+            depth[i] = depth[parent(i, tree)] + 1;
+            num_levels = (std::max)(num_levels, depth[i] + 1);
+        }
+        return tree_accumulator_detail::make_level_schedule(depth, num_levels);
+    }
+
     namespace tree_accumulator_detail {
 
 
@@ -32,7 +160,7 @@ namespace hg {
             hg_assert_node_weights(tree, input);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), num_vertices(tree));
 
             array_nd <output_t> output = array_nd<output_t>::from_shape(output_shape);
@@ -88,28 +216,71 @@ namespace hg {
             return output;
         };
 
+        // number of consecutive nodes processed by a task in the multithreaded versions of the parallel accumulators
+        constexpr index_t parallel_accumulator_block_size = 4096;
+
+        /**
+         * Multithreaded parallel accumulator: the value of a node only depends on the values of its children in the
+         * input, nodes are thus processed independently by blocks of consecutive indices.
+         */
         template<bool vectorial,
                 typename tree_t,
                 typename T,
                 typename accumulator_t,
                 typename output_t = typename T::value_type>
-        auto accumulate_sequential_impl(const tree_t &tree,
-                                        const xt::xexpression<T> &xvertex_data,
-                                        const accumulator_t &accumulator) {
+        auto accumulate_parallel_impl(execution::parallel_policy,
+                                      const tree_t &tree,
+                                      const xt::xexpression<T> &xinput,
+                                      const accumulator_t accumulator) {
             HG_TRACE();
-            auto &vertex_data = xvertex_data.derived_cast();
-            hg_assert_leaf_weights(tree, vertex_data);
+            auto &input = xinput.derived_cast();
+            hg_assert_node_weights(tree, input);
 
-            auto data_shape = std::vector<size_t>(vertex_data.shape().begin() + 1, vertex_data.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), num_vertices(tree));
 
             array_nd <output_t> output = array_nd<output_t>::from_shape(output_shape);
 
-            auto vertex_data_view = make_light_axis_view<vectorial>(vertex_data);
-            auto input_view = make_light_axis_view<vectorial>(output);
-            auto output_view = make_light_axis_view<vectorial>(output);
+            tree.compute_children();
+            index_t num_nodes = num_vertices(tree);
+            index_t num_blocks = (num_nodes + parallel_accumulator_block_size - 1) / parallel_accumulator_block_size;
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto input_view = make_light_axis_view<vectorial>(input);
+                auto output_view = make_light_axis_view<vectorial>(output);
+                auto acc = accumulator.template make_accumulator<vectorial>(output_view);
+
+                index_t end = (std::min)(num_nodes, (b + 1) * parallel_accumulator_block_size);
+                for (index_t i = b * parallel_accumulator_block_size; i < end; i++) {
+                    output_view.set_position(i);
+                    acc.set_storage(output_view);
+                    acc.initialize();
+                    for (auto c : children_iterator(i, tree)) {
+                        input_view.set_position(c);
+                        acc.accumulate(input_view.begin());
+                    }
+                    acc.finalize();
+                }
+            });
+
+            return output;
+        };
 
+        /**
+         * Leaves to root accumulation of the values of the children of each node.
+         */
+        template<bool vectorial,
+                typename tree_t,
+                typename vertex_view_t,
+                typename output_view_t,
+                typename accumulator_t>
+        void accumulate_sequential_nodes(const tree_t &tree,
+                                         vertex_view_t &vertex_data_view,
+                                         output_view_t &output_view,
+                                         output_view_t &input_view,
+                                         const accumulator_t &accumulator,
+                                         std::false_type /* mergeable */) {
             for (auto i: leaves_iterator(tree)) {
                 output_view.set_position(i);
                 vertex_data_view.set_position(i);
@@ -151,6 +322,158 @@ namespace hg {
                 }
                 accs.back().finalize();
             }
+        }
+
+        /**
+         * Leaves to root accumulation of the values of the leaves in the subtree of each node with mergeable
+         * accumulators: the result of a leaf is the result of the accumulation of its own value and the accumulator
+         * of each non-leaf node is merged into the accumulator of its parent.
+         */
+        template<bool vectorial,
+                typename tree_t,
+                typename vertex_view_t,
+                typename output_view_t,
+                typename accumulator_t>
+        void accumulate_sequential_nodes(const tree_t &tree,
+                                         vertex_view_t &vertex_data_view,
+                                         output_view_t &output_view,
+                                         output_view_t &,
+                                         const accumulator_t &accumulator,
+                                         std::true_type /* mergeable */) {
+            index_t numl = num_leaves(tree);
+            auto &parents = tree.parents();
+            using acc_t = decltype(accumulator.template make_accumulator<vectorial>(output_view));
+            std::vector<acc_t> accs;
+            accs.reserve(num_vertices(tree) - numl);
+
+            for (auto i : leaves_to_root_iterator(tree, leaves_it::exclude)) {
+                output_view.set_position(i);
+                accs.push_back(accumulator.template make_accumulator<vectorial>(output_view));
+                accs.back().initialize();
+            }
+
+            auto leaf_acc = accumulator.template make_accumulator<vectorial>(output_view);
+            for (auto i: leaves_iterator(tree)) {
+                output_view.set_position(i);
+                vertex_data_view.set_position(i);
+                leaf_acc.set_storage(output_view);
+                leaf_acc.initialize();
+                leaf_acc.accumulate(vertex_data_view.begin());
+                leaf_acc.finalize();
+                accs[parents(i) - numl].accumulate(vertex_data_view.begin());
+            }
+
+            for (auto i : leaves_to_root_iterator(tree, leaves_it::exclude, root_it::exclude)) {
+                accs[i - numl].finalize();
+                accs[parents(i) - numl].merge(accs[i - numl]);
+                // the state of the child accumulator is not needed anymore
+                acc_t released = std::move(accs[i - numl]);
+            }
+            accs.back().finalize();
+        }
+
+        template<bool vectorial,
+                typename tree_t,
+                typename T,
+                typename accumulator_t,
+                typename output_t = typename T::value_type>
+        auto accumulate_sequential_impl(const tree_t &tree,
+                                        const xt::xexpression<T> &xvertex_data,
+                                        const accumulator_t &accumulator) {
+            HG_TRACE();
+            auto &vertex_data = xvertex_data.derived_cast();
+            hg_assert_leaf_weights(tree, vertex_data);
+
+            auto data_shape = std::vector<size_t>(vertex_data.shape().begin() + 1, vertex_data.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), num_vertices(tree));
+
+            array_nd <output_t> output = array_nd<output_t>::from_shape(output_shape);
+
+            auto vertex_data_view = make_light_axis_view<vectorial>(vertex_data);
+            auto input_view = make_light_axis_view<vectorial>(output);
+            auto output_view = make_light_axis_view<vectorial>(output);
+
+            using acc_t = decltype(accumulator.template make_accumulator<vectorial>(output_view));
+            accumulate_sequential_nodes<vectorial>(tree, vertex_data_view, output_view, input_view, accumulator,
+                                                   accumulator_detail::is_mergeable<acc_t>());
+            return output;
+        };
+
+        template<typename acc_t, typename view_t>
+        void accumulate_child(acc_t &parent_acc, acc_t &, view_t &child_view, std::false_type /* mergeable */) {
+            parent_acc.accumulate(child_view.begin());
+        }
+
+        template<typename acc_t, typename view_t>
+        void accumulate_child(acc_t &parent_acc, acc_t &child_acc, view_t &, std::true_type /* mergeable */) {
+            parent_acc.merge(child_acc);
+            // the state of the child accumulator is not needed anymore
+            acc_t released = std::move(child_acc);
+        }
+
+        template<bool vectorial,
+                typename tree_t,
+                typename producer_t,
+                typename accumulator_t,
+                typename value_t>
+        auto accumulate_sequential_chunked_impl(const tree_t &tree,
+                                                array_nd<value_t> &block,
+                                                producer_t &producer,
+                                                const accumulator_t &accumulator,
+                                                index_t chunk_size) {
+            HG_TRACE();
+            const index_t numl = num_leaves(tree);
+            const index_t num_v = num_vertices(tree);
+
+            auto data_shape = std::vector<size_t>(block.shape().begin() + 1, block.shape().end());
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), num_v - numl);
+
+            array_nd<value_t> output = array_nd<value_t>::from_shape(output_shape);
+            auto output_view = make_light_axis_view<vectorial>(output);
+
+            // the storage of the accumulator of the non-leaf node n is the row n - numl of output
+            std::vector<decltype(accumulator.template make_accumulator<vectorial>(output_view))> accs;
+            accs.reserve(num_v - numl);
+            for (index_t i = 0; i < num_v - numl; i++) {
+                output_view.set_position(i);
+                accs.push_back(accumulator.template make_accumulator<vectorial>(output_view));
+                accs.back().initialize();
+            }
+
+            // children are accumulated in increasing index order as in accumulate_sequential: the leaf children
+            // of a node come before its non-leaf children
+            auto &parents = tree.parents();
+            index_t begin = 0;
+            while (true) {
+                index_t end = (std::min)(begin + chunk_size, numl);
+                hg_assert(block.dimension() == data_shape.size() + 1 &&
+                          std::equal(data_shape.begin(), data_shape.end(), block.shape().begin() + 1) &&
+                          (index_t) block.shape()[0] == end - begin,
+                          "Invalid shape for the data block of the leaves in [" + std::to_string(begin) + ", " +
+                          std::to_string(end) + ").");
+                auto block_view = make_light_axis_view<vectorial>(block);
+                for (index_t i = begin; i < end; i++) {
+                    block_view.set_position(i - begin);
+                    accs[parents(i) - numl].accumulate(block_view.begin());
+                }
+                begin = end;
+                if (begin == numl) {
+                    break;
+                }
+                block = producer(begin, (std::min)(begin + chunk_size, numl));
+            }
+
+            auto input_view = make_light_axis_view<vectorial>(output);
+            using acc_t = typename decltype(accs)::value_type;
+            for (auto i : leaves_to_root_iterator(tree, leaves_it::exclude, root_it::exclude)) {
+                accs[i - numl].finalize();
+                input_view.set_position(i - numl);
+                accumulate_child(accs[parents(i) - numl], accs[i - numl], input_view,
+                                 accumulator_detail::is_mergeable<acc_t>());
+            }
+            accs.back().finalize();
 
             return output;
         };
@@ -175,7 +498,7 @@ namespace hg {
             hg_assert_leaf_weights(tree, vertex_data);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             hg_assert(output_shape.size() == input.dimension() - 1,
                       "Input dimension does not match accumulator output dimension.");
             hg_assert(output_shape.size() == vertex_data.dimension() - 1,
@@ -306,6 +629,57 @@ namespace hg {
             return output;
         };
 
+        inline bool propagate_condition(std::nullptr_t, index_t) {
+            return true;
+        }
+
+        template<typename T>
+        bool propagate_condition(const T &condition, index_t i) {
+            return condition(i);
+        }
+
+        /**
+         * Multithreaded parallel propagation: the value of a node only depends on the input value of its parent (or on
+         * its own input value if condition is false), nodes are thus processed independently by blocks of
+         * consecutive indices. If no condition is given (condition_t is std::nullptr_t), all the nodes are propagated.
+         */
+        template<bool vectorial,
+                typename tree_t,
+                typename T1,
+                typename condition_t,
+                typename output_t = typename T1::value_type>
+        auto propagate_parallel_impl(execution::parallel_policy,
+                                     const tree_t &tree,
+                                     const xt::xexpression<T1> &xinput,
+                                     const condition_t &condition) {
+            HG_TRACE();
+            auto &input = xinput.derived_cast();
+            hg_assert_node_weights(tree, input);
+
+            array_nd <output_t> output = array_nd<output_t>::from_shape(input.shape());
+
+            auto aparents = parents(tree).storage_begin();
+            index_t num_nodes = num_vertices(tree);
+            index_t num_blocks = (num_nodes + parallel_accumulator_block_size - 1) / parallel_accumulator_block_size;
+
+            parfor(0, num_blocks, [&](index_t b) {
+                auto input_view = make_light_axis_view<vectorial>(input);
+                auto output_view = make_light_axis_view<vectorial>(output);
+
+                index_t end = (std::min)(num_nodes, (b + 1) * parallel_accumulator_block_size);
+                for (index_t i = b * parallel_accumulator_block_size; i < end; i++) {
+                    if (propagate_condition(condition, i)) {
+                        input_view.set_position(aparents[i]);
+                    } else {
+                        input_view.set_position(i);
+                    }
+                    output_view.set_position(i);
+                    output_view = input_view;
+                }
+            });
+            return output;
+        };
+
         template<bool vectorial,
                 typename tree_t,
                 typename T1,
@@ -348,6 +722,48 @@ namespace hg {
             return output;
         };
 
+        /**
+         * Multithreaded sequential propagation: the nodes are processed by depth levels (see
+         * make_root_to_leaves_level_schedule), the value of a node only depends on the value of its parent in the
+         * output.
+         */
+        template<bool vectorial,
+                typename tree_t,
+                typename T1,
+                typename T2,
+                typename output_t = typename T1::value_type>
+        auto propagate_sequential_impl(execution::parallel_policy policy,
+                                       const tree_t &tree,
+                                       const xt::xexpression<T1> &xinput,
+                                       const xt::xexpression<T2> &xcondition) {
+            HG_TRACE();
+            auto &input = xinput.derived_cast();
+            auto &condition = xcondition.derived_cast();
+            hg_assert_node_weights(tree, input);
+            hg_assert_node_weights(tree, condition);
+            hg_assert_1d_array(condition);
+
+            array_nd <output_t> output = array_nd<output_t>::from_shape(input.shape());
+            auto aparents = parents(tree).storage_begin();
+            const index_t root_node = root(tree);
+
+            make_root_to_leaves_level_schedule(tree).for_each_node(policy, [&](index_t i) {
+                auto input_view = make_light_axis_view<vectorial>(input);
+                auto output_view = make_light_axis_view<vectorial>(output);
+                output_view.set_position(i);
+                // root cannot be deleted
+                if (i != root_node && condition(i)) {
+                    auto inout_view = make_light_axis_view<vectorial>(output);
+                    inout_view.set_position(aparents[i]);
+                    output_view = inout_view;
+                } else {
+                    input_view.set_position(i);
+                    output_view = input_view;
+                }
+            });
+            return output;
+        };
+
         template<bool vectorial,
                 typename tree_t,
                 typename T,
@@ -361,7 +777,7 @@ namespace hg {
             hg_assert_node_weights(tree, input);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             hg_assert(output_shape.size() == input.dimension() - 1,
                       "Input dimension does not match accumulator output dimension.");
             hg_assert(std::equal(output_shape.begin(), output_shape.end(), input.shape().begin() + 1),
@@ -419,7 +835,7 @@ namespace hg {
             hg_assert_1d_array(condition);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             hg_assert(output_shape.size() == input.dimension() - 1,
                       "Input dimension does not match accumulator output dimension.");
             hg_assert(std::equal(output_shape.begin(), output_shape.end(), input.shape().begin() + 1),
@@ -477,7 +893,7 @@ namespace hg {
                              const xt::xexpression<T> &xinput,
                              const accumulator_t &accumulator) {
         auto &input = xinput.derived_cast();
-        if (input.dimension() == 1) {
+        if (accumulator_detail::use_scalar_views(accumulator, input.dimension())) {
             return tree_accumulator_detail::accumulate_parallel_impl<false>(tree, xinput, accumulator);
         } else {
             return tree_accumulator_detail::accumulate_parallel_impl<true>(tree, xinput, accumulator);
@@ -485,16 +901,96 @@ namespace hg {
     };
 
 
+    /**
+     * Multithreaded version of accumulate_parallel.
+     *
+     * The result is identical to the one of the serial version (including for floating point accumulators) as the
+     * children of each node are accumulated in the same order.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @tparam accumulator_t
+     * @tparam output_t
+     * @param policy execution::par
+     * @param tree input tree (its children are computed if needed)
+     * @param xinput input node weights
+     * @param accumulator accumulator
+     * @return accumulated node weights
+     */
+    template<typename tree_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_parallel(execution::parallel_policy policy,
+                             const tree_t &tree,
+                             const xt::xexpression<T> &xinput,
+                             const accumulator_t &accumulator) {
+        auto &input = xinput.derived_cast();
+        if (accumulator_detail::use_scalar_views(accumulator, input.dimension())) {
+            return tree_accumulator_detail::accumulate_parallel_impl<false>(policy, tree, xinput, accumulator);
+        } else {
+            return tree_accumulator_detail::accumulate_parallel_impl<true>(policy, tree, xinput, accumulator);
+        }
+    };
+
+    template<typename tree_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_parallel(execution::sequenced_policy,
+                             const tree_t &tree,
+                             const xt::xexpression<T> &xinput,
+                             const accumulator_t &accumulator) {
+        return accumulate_parallel(tree, xinput, accumulator);
+    };
+
     template<typename tree_t, typename T, typename accumulator_t, typename output_t = typename T::value_type>
     auto accumulate_sequential(const tree_t &tree,
                                const xt::xexpression<T> &xvertex_data,
                                const accumulator_t &accumulator) {
         auto &vertex_data = xvertex_data.derived_cast();
 
-        if (vertex_data.dimension() == 1) {
-            return tree_accumulator_detail::accumulate_sequential_impl<false>(tree, xvertex_data, accumulator);
+        if (accumulator_detail::use_scalar_views(accumulator, vertex_data.dimension())) {
+            return tree_accumulator_detail::accumulate_sequential_impl<false, tree_t, T, accumulator_t, output_t>(
+                    tree, xvertex_data, accumulator);
+        } else {
+            return tree_accumulator_detail::accumulate_sequential_impl<true, tree_t, T, accumulator_t, output_t>(
+                    tree, xvertex_data, accumulator);
+        }
+    };
+
+    /**
+     * Chunked version of accumulate_sequential: the data of the leaves is never fully stored in memory.
+     *
+     * The leaf data is obtained by successive calls to producer(begin, end) which must return an array of shape
+     * (end - begin, ...) containing the data of the leaves begin, begin + 1, ..., end - 1. The producer is called
+     * on consecutive ranges of at most chunk_size leaves covering [0, num_leaves(tree)) in increasing order, and
+     * each block is folded into the accumulators of the parents of its leaves before the next block is requested.
+     *
+     * Only the values of the non-leaf nodes are stored: the row i of the result contains the accumulated value of the
+     * node i + num_leaves(tree), it is equal to the row i + num_leaves(tree) of
+     * accumulate_sequential(tree, vertex_data, accumulator) where vertex_data is the concatenation of the blocks.
+     *
+     * @tparam tree_t tree type
+     * @tparam producer_t function (index_t, index_t) -> array
+     * @tparam accumulator_t accumulator type
+     * @param tree input tree
+     * @param producer leaf data producer
+     * @param accumulator accumulator
+     * @param chunk_size maximal number of leaves in a block
+     * @return an array with the accumulated values of the non-leaf nodes of the tree
+     */
+    template<typename tree_t, typename producer_t, typename accumulator_t>
+    auto accumulate_sequential_chunked(const tree_t &tree,
+                                       producer_t producer,
+                                       const accumulator_t &accumulator,
+                                       index_t chunk_size = 65536) {
+        hg_assert(chunk_size > 0, "Chunk size must be strictly positive.");
+        hg_assert(num_vertices(tree) > num_leaves(tree), "Tree must have at least one non-leaf node.");
+        using block_t = std::decay_t<decltype(producer(index_t(0), index_t(0)))>;
+        using value_t = typename block_t::value_type;
+
+        array_nd<value_t> block = producer(0, (std::min)(chunk_size, (index_t) num_leaves(tree)));
+        if (accumulator_detail::use_scalar_views(accumulator, block.dimension())) {
+            return tree_accumulator_detail::accumulate_sequential_chunked_impl<false>(tree, block, producer,
+                                                                                      accumulator, chunk_size);
         } else {
-            return tree_accumulator_detail::accumulate_sequential_impl<true>(tree, xvertex_data, accumulator);
+            return tree_accumulator_detail::accumulate_sequential_chunked_impl<true>(tree, block, producer,
+                                                                                     accumulator, chunk_size);
         }
     };
 
@@ -540,6 +1036,72 @@ namespace hg {
         }
     };
 
+    /**
+     * Multithreaded version of propagate_parallel.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @param policy execution::par
+     * @param tree input tree
+     * @param xinput input node weights
+     * @return propagated node weights
+     */
+    template<typename tree_t, typename T1>
+    auto propagate_parallel(execution::parallel_policy policy,
+                            const tree_t &tree,
+                            const xt::xexpression<T1> &xinput) {
+        auto &input = xinput.derived_cast();
+
+        if (input.dimension() == 1) {
+            return tree_accumulator_detail::propagate_parallel_impl<false>(policy, tree, xinput, nullptr);
+        } else {
+            return tree_accumulator_detail::propagate_parallel_impl<true>(policy, tree, xinput, nullptr);
+        }
+    };
+
+    /**
+     * Multithreaded version of propagate_parallel with a condition.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param policy execution::par
+     * @param tree input tree
+     * @param xinput input node weights
+     * @param xcondition node condition: only nodes with a true condition receive the value of their parent
+     * @return propagated node weights
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto propagate_parallel(execution::parallel_policy policy,
+                            const tree_t &tree,
+                            const xt::xexpression<T1> &xinput,
+                            const xt::xexpression<T2> &xcondition) {
+        auto &input = xinput.derived_cast();
+        auto &condition = xcondition.derived_cast();
+        hg_assert_node_weights(tree, condition);
+
+        if (input.dimension() == 1) {
+            return tree_accumulator_detail::propagate_parallel_impl<false>(policy, tree, xinput, condition);
+        } else {
+            return tree_accumulator_detail::propagate_parallel_impl<true>(policy, tree, xinput, condition);
+        }
+    };
+
+    template<typename tree_t, typename T1>
+    auto propagate_parallel(execution::sequenced_policy,
+                            const tree_t &tree,
+                            const xt::xexpression<T1> &xinput) {
+        return propagate_parallel(tree, xinput);
+    };
+
+    template<typename tree_t, typename T1, typename T2>
+    auto propagate_parallel(execution::sequenced_policy,
+                            const tree_t &tree,
+                            const xt::xexpression<T1> &xinput,
+                            const xt::xexpression<T2> &xcondition) {
+        return propagate_parallel(tree, xinput, xcondition);
+    };
+
     template<typename tree_t, typename T1, typename T2>
     auto propagate_sequential(const tree_t &tree,
                               const xt::xexpression<T1> &xinput,
@@ -553,6 +1115,41 @@ namespace hg {
         }
     };
 
+    /**
+     * Multithreaded version of propagate_sequential: the nodes of a same depth are processed in parallel and the
+     * depths from the root to the deepest leaves (see make_root_to_leaves_level_schedule).
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param policy execution::par
+     * @param tree input tree
+     * @param xinput input node weights
+     * @param xcondition node condition: only nodes with a true condition receive the value of their parent
+     * @return propagated node weights
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto propagate_sequential(execution::parallel_policy policy,
+                              const tree_t &tree,
+                              const xt::xexpression<T1> &xinput,
+                              const xt::xexpression<T2> &xcondition) {
+        auto &input = xinput.derived_cast();
+
+        if (input.dimension() == 1) {
+            return tree_accumulator_detail::propagate_sequential_impl<false>(policy, tree, xinput, xcondition);
+        } else {
+            return tree_accumulator_detail::propagate_sequential_impl<true>(policy, tree, xinput, xcondition);
+        }
+    };
+
+    template<typename tree_t, typename T1, typename T2>
+    auto propagate_sequential(execution::sequenced_policy,
+                              const tree_t &tree,
+                              const xt::xexpression<T1> &xinput,
+                              const xt::xexpression<T2> &xcondition) {
+        return propagate_sequential(tree, xinput, xcondition);
+    };
+
     template<typename tree_t, typename T, typename accumulator_t>
     auto propagate_sequential_and_accumulate(const tree_t &tree,
                                              const xt::xexpression<T> &xinput,
@@ -39,7 +39,7 @@ namespace hg {
             hg_assert_integral_value_type(depth);
 
             auto data_shape = std::vector<size_t>(input.shape().begin() + 1, input.shape().end());
-            auto output_shape = accumulator_t::get_output_shape(data_shape);
+            auto output_shape = accumulator.get_output_shape(data_shape);
             output_shape.insert(output_shape.begin(), num_edges(graph));
 
             array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
@@ -81,6 +81,97 @@ namespace hg {
             return output;
         };
 
+        template<bool vectorial,
+                typename graph_t,
+                typename tree_t,
+                typename T,
+                typename T2,
+                typename accumulator_t,
+                typename output_t = typename T::value_type>
+        auto accumulate_on_contours_impl(const graph_t &graph,
+                                         const std::vector<tree_t> &trees,
+                                         const std::vector<T> &inputs,
+                                         const std::vector<T2> &depths,
+                                         const accumulator_t accumulator) {
+            HG_TRACE();
+            hg_assert(!trees.empty(), "The list of trees must not be empty.");
+            hg_assert(inputs.size() == trees.size(), "There must be one node weight array per tree.");
+            hg_assert(depths.size() == trees.size(), "There must be one depth array per tree.");
+            const index_t num_trees = trees.size();
+            const index_t num_e = num_edges(graph);
+
+            auto data_shape = std::vector<size_t>(inputs[0].shape().begin() + 1, inputs[0].shape().end());
+            for (index_t t = 0; t < num_trees; t++) {
+                hg_assert(num_leaves(trees[t]) == num_vertices(graph),
+                          "All trees must have the vertices of the graph as leaves.");
+                hg_assert_node_weights(trees[t], inputs[t]);
+                hg_assert(std::equal(data_shape.begin(), data_shape.end(), inputs[t].shape().begin() + 1,
+                                     inputs[t].shape().end()),
+                          "All node weight arrays must have the same shape beyond their first dimension.");
+                hg_assert_node_weights(trees[t], depths[t]);
+                hg_assert_1d_array(depths[t]);
+                hg_assert_integral_value_type(depths[t]);
+            }
+
+            // the output is filled as a (num_trees * num_edges, ...) array and reshaped at the end
+            auto output_shape = accumulator.get_output_shape(data_shape);
+            output_shape.insert(output_shape.begin(), num_trees * num_e);
+
+            array_nd<output_t> output = array_nd<output_t>::from_shape(output_shape);
+
+            using input_view_t = decltype(make_light_axis_view<vectorial>(inputs[0]));
+            std::vector<input_view_t> input_views;
+            input_views.reserve(num_trees);
+            for (index_t t = 0; t < num_trees; t++) {
+                input_views.push_back(make_light_axis_view<vectorial>(inputs[t]));
+            }
+            auto output_view = make_light_axis_view<vectorial>(output);
+            auto acc = accumulator.template make_accumulator<vectorial>(output_view);
+
+            for (auto e: edge_iterator(graph)) {
+                auto s = source(e, graph);
+                auto d = target(e, graph);
+                auto i = index(e, graph);
+
+                for (index_t t = 0; t < num_trees; t++) {
+                    auto &tree = trees[t];
+                    auto &depth = depths[t];
+                    auto &input_view = input_views[t];
+                    auto n1 = s;
+                    auto n2 = d;
+
+                    output_view.set_position(t * num_e + i);
+                    acc.set_storage(output_view);
+                    acc.initialize();
+
+                    while (n1 != n2) {
+                        auto dn1 = depth(n1);
+                        auto dn2 = depth(n2);
+                        auto new_n1 = n1;
+                        auto new_n2 = n2;
+                        if (dn1 >= dn2) {
+                            input_view.set_position(n1);
+                            acc.accumulate(input_view.begin());
+                            new_n1 = parent(n1, tree);
+                        }
+                        if (dn2 >= dn1) {
+                            input_view.set_position(n2);
+                            acc.accumulate(input_view.begin());
+                            new_n2 = parent(n2, tree);
+                        }
+                        n1 = new_n1;
+                        n2 = new_n2;
+                    }
+                    acc.finalize();
+                }
+            }
+
+            output_shape[0] = num_e;
+            output_shape.insert(output_shape.begin(), num_trees);
+            output.reshape(output_shape);
+            return output;
+        };
+
     }
 
     template<typename graph_t, typename tree_t, typename T, typename T1, typename accumulator_t, typename output_t = typename T::value_type>
@@ -90,7 +181,7 @@ namespace hg {
                                 const xt::xexpression<T1> &xdepth,
                                 const accumulator_t &accumulator) {
         auto &input = xinput.derived_cast();
-        if (input.dimension() == 1) {
+        if (accumulator_detail::use_scalar_views(accumulator, input.dimension())) {
             return tree_contour_accumulator_detail::accumulate_on_contours_impl<false>(graph,
                                                                                        tree,
                                                                                        xinput,
@@ -105,4 +196,40 @@ namespace hg {
         }
     };
 
+    /**
+     * Batched version of accumulate_on_contours for several trees sharing the same leaf graph.
+     *
+     * The edges of the graph are traversed once and, for each edge, the contour accumulation is done for every tree.
+     * The result is an array of shape (num_trees, num_edges, ...) whose slice t is equal to
+     * accumulate_on_contours(graph, trees[t], inputs[t], depths[t], accumulator).
+     *
+     * @param graph leaf graph shared by all trees
+     * @param trees list of trees
+     * @param inputs node weights of each tree (same shape beyond the first dimension)
+     * @param depths node depths of each tree
+     * @param accumulator
+     * @return
+     */
+    template<typename graph_t, typename tree_t, typename T, typename T1, typename accumulator_t, typename output_t = typename T::value_type>
+    auto accumulate_on_contours(const graph_t &graph,
+                                const std::vector<tree_t> &trees,
+                                const std::vector<T> &inputs,
+                                const std::vector<T1> &depths,
+                                const accumulator_t &accumulator) {
+        hg_assert(!inputs.empty(), "The list of node weights must not be empty.");
+        if (accumulator_detail::use_scalar_views(accumulator, inputs[0].dimension())) {
+            return tree_contour_accumulator_detail::accumulate_on_contours_impl<false>(graph,
+                                                                                       trees,
+                                                                                       inputs,
+                                                                                       depths,
+                                                                                       accumulator);
+        } else {
+            return tree_contour_accumulator_detail::accumulate_on_contours_impl<true>(graph,
+                                                                                      trees,
+                                                                                      inputs,
+                                                                                      depths,
+                                                                                      accumulator);
+        }
+    };
+
 }
\ No newline at end of file
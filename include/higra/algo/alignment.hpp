@@ -28,6 +28,11 @@ namespace hg {
    *
    * If num_regions_fine or num_regions_coarse are not provided, they will
    * be determined as max(xlabelisation_fine) + 1 and max(xlabelisation_coarse) + 1
+   *
+   * If several coarse regions have the same maximal intersection with a fine region, the smallest coarse label is
+   * chosen. The intersections are computed fine region per fine region: the complexity is linear in the number of
+   * elements plus the number of regions, and no array of size num_regions_fine * num_regions_coarse is created.
+   * The fine regions are split into blocks processed in parallel, each block using its own intersection buffer.
    * @tparam T1
    * @tparam T2
    * @param xlabelisation_fine
@@ -61,14 +66,59 @@ namespace hg {
             num_regions_coarse = xt::amax(labelisation_coarse)(0) + 1;
         }
 
-        array_2d<size_t> intersections = xt::zeros<size_t>({num_regions_fine, num_regions_coarse});
-
-        for (index_t i = 0; i < (index_t)labelisation_fine.size(); i++) {
-            intersections(labelisation_fine(i), labelisation_coarse(i))++;
+        // coarse labels of the elements sorted by fine region (counting sort)
+        const index_t num_elements = labelisation_fine.size();
+        std::vector<index_t> region_start(num_regions_fine + 1, 0);
+        for (index_t i = 0; i < num_elements; i++) {
+            region_start[labelisation_fine(i) + 1]++;
+        }
+        for (index_t r = 0; r < (index_t) num_regions_fine; r++) {
+            region_start[r + 1] += region_start[r];
+        }
+        std::vector<index_t> coarse_labels(num_elements);
+        {
+            std::vector<index_t> position(region_start.begin(), region_start.end() - 1);
+            for (index_t i = 0; i < num_elements; i++) {
+                coarse_labels[position[labelisation_fine(i)]++] = labelisation_coarse(i);
+            }
         }
 
-        // cast size_t -> index_t
-        array_1d<index_t> res = xt::argmax(intersections, 1);
+        // the fine regions are processed by blocks holding about the same number of elements
+        const index_t num_blocks = (std::max)((index_t) 1,
+                                              (std::min)(get_num_threads(), num_elements / (index_t) 65536));
+        std::vector<index_t> block_start(num_blocks + 1);
+        for (index_t b = 0; b <= num_blocks; b++) {
+            block_start[b] = std::lower_bound(region_start.begin(), region_start.end() - 1,
+                                              (num_elements * b) / num_blocks) - region_start.begin();
+        }
+        block_start[num_blocks] = num_regions_fine;
+
+        array_1d<index_t> res = xt::zeros<index_t>({num_regions_fine});
+        parfor(0, num_blocks, [&](index_t b) {
+            // intersection sizes of the current fine region with the coarse regions: only the entries touched by
+            // the current fine region are non zero, they are reset after each fine region
+            std::vector<index_t> intersections(num_regions_coarse, 0);
+            for (index_t r = block_start[b]; r < block_start[b + 1]; r++) {
+                for (index_t i = region_start[r]; i < region_start[r + 1]; i++) {
+                    intersections[coarse_labels[i]]++;
+                }
+                // ties are broken by taking the smallest coarse label
+                index_t best_label = 0;
+                index_t best_intersection = 0;
+                for (index_t i = region_start[r]; i < region_start[r + 1]; i++) {
+                    index_t c = coarse_labels[i];
+                    if (intersections[c] > best_intersection ||
+                        (intersections[c] == best_intersection && c < best_label)) {
+                        best_label = c;
+                        best_intersection = intersections[c];
+                    }
+                }
+                for (index_t i = region_start[r]; i < region_start[r + 1]; i++) {
+                    intersections[coarse_labels[i]] = 0;
+                }
+                res(r) = best_label;
+            }
+        });
         return res;
     }
 
@@ -93,24 +143,24 @@ namespace hg {
 
     namespace alignment_internal {
 
-        template<typename rag_t, typename T, typename tree_t, typename T2>
-        auto project_hierarchy(const rag_t &rag_fine, const T &coarse_supervertices, const tree_t &tree_coarse,
-                               const T2 &tree_coarse_node_altitudes) {
+        /**
+         * Project the hierarchy tree_coarse on the fine rag with a precomputed projection of the fine supervertices
+         * on the coarse ones (see project_fine_to_coarse_labelisation)
+         */
+        template<typename rag_t, typename T1, typename tree_t, typename T2>
+        auto project_hierarchy_from_map(const rag_t &rag_fine, const T1 &fine_to_coarse_map, const tree_t &tree_coarse,
+                                        const T2 &tree_coarse_node_altitudes) {
             HG_TRACE();
             hg_assert_node_weights(tree_coarse, tree_coarse_node_altitudes);
             hg_assert_1d_array(tree_coarse_node_altitudes);
-            hg_assert_1d_array(coarse_supervertices);
-            hg_assert(rag_fine.vertex_map.size() == coarse_supervertices.size(),
-                      "Dimensions of the two labelisations do not match.");
+            hg_assert(fine_to_coarse_map.size() == num_vertices(rag_fine.rag),
+                      "Fine to coarse map size does not match the number of fine supervertices.");
 
-            auto &fine_supervertices = rag_fine.vertex_map;
             auto &rag = rag_fine.rag;
-
-            auto fine_to_coarse_map = project_fine_to_coarse_labelisation(fine_supervertices, coarse_supervertices);
             array_1d<typename T2::value_type> coarse_sm_on_fine_rag = xt::empty<typename T2::value_type>(
                     {num_edges(rag_fine.rag)});
 
-            lca_fast lca(tree_coarse);
+            lca_bitmask_block lca(tree_coarse);
 
             for (auto e: edge_iterator(rag)) {
                 auto projected_lca = lca.lca(fine_to_coarse_map[source(e, rag)], fine_to_coarse_map[target(e, rag)]);
@@ -119,6 +169,18 @@ namespace hg {
 
             return coarse_sm_on_fine_rag;
         }
+
+        template<typename rag_t, typename T, typename tree_t, typename T2>
+        auto project_hierarchy(const rag_t &rag_fine, const T &coarse_supervertices, const tree_t &tree_coarse,
+                               const T2 &tree_coarse_node_altitudes) {
+            HG_TRACE();
+            hg_assert_1d_array(coarse_supervertices);
+            hg_assert(rag_fine.vertex_map.size() == coarse_supervertices.size(),
+                      "Dimensions of the two labelisations do not match.");
+
+            auto fine_to_coarse_map = project_fine_to_coarse_labelisation(rag_fine.vertex_map, coarse_supervertices);
+            return project_hierarchy_from_map(rag_fine, fine_to_coarse_map, tree_coarse, tree_coarse_node_altitudes);
+        }
     }
 
     /**
@@ -162,7 +224,7 @@ namespace hg {
             hg_assert(num_leaves(tree) == m_fine_rag.vertex_map.size(),
                       "Cannot align given hierarchy: incompatible sizes!");
             auto sv_hierarchy = supervertices_hierarchy(tree, altitudes);
-            auto altitudes_sv_hierarchy = xt::index_view(altitudes, sv_hierarchy.node_map);
+            auto altitudes_sv_hierarchy = gather(altitudes, sv_hierarchy.node_map);
             auto coarse_sm_on_fine_rag =
                     alignment_internal::project_hierarchy(m_fine_rag,
                                                            sv_hierarchy.supervertex_labelisation,
@@ -215,6 +277,133 @@ namespace hg {
             return rag_back_project_weights(m_fine_rag.edge_map, coarse_sm_on_fine_rag);
         }
 
+        /**
+         * Align several hierarchies given as trees (see align_hierarchy).
+         *
+         * The hierarchies are aligned in parallel. The projection of the fine supervertices on the supervertices of
+         * a hierarchy is computed only once for all the hierarchies having the same supervertices.
+         *
+         * @tparam T
+         * @param trees input trees
+         * @param altitudes altitudes of the nodes of each tree
+         * @return a vector containing the saliency map of each aligned hierarchy
+         */
+        template<typename T>
+        auto align_hierarchies(const std::vector<hg::tree> &trees, const std::vector<T> &altitudes) const {
+            HG_TRACE();
+            hg_assert(trees.size() == altitudes.size(), "The numbers of trees and of altitudes do not match.");
+            const index_t num_hierarchies = trees.size();
+
+            for (index_t i = 0; i < num_hierarchies; i++) {
+                hg_assert_node_weights(trees[i], altitudes[i]);
+                hg_assert_1d_array(altitudes[i]);
+                hg_assert(num_leaves(trees[i]) == m_fine_rag.vertex_map.size(),
+                          "Cannot align given hierarchy: incompatible sizes!");
+                // computed before the parallel section as several items may share the same tree
+                trees[i].compute_children();
+            }
+
+            using sv_hierarchy_t = supervertex_hierarchy<array_1d<index_t>, hg::tree, array_1d<index_t>>;
+            std::vector<sv_hierarchy_t> sv_hierarchies(num_hierarchies);
+            parfor(0, num_hierarchies, [&trees, &altitudes, &sv_hierarchies](index_t i) {
+                sv_hierarchies[i] = supervertices_hierarchy(trees[i], altitudes[i]);
+            });
+
+            // hierarchies with the same supervertices share the same fine to coarse map
+            std::vector<index_t> map_index(num_hierarchies);
+            std::vector<index_t> map_representatives;
+            for (index_t i = 0; i < num_hierarchies; i++) {
+                auto &labels = sv_hierarchies[i].supervertex_labelisation;
+                map_index[i] = invalid_index;
+                for (index_t j = 0; j < (index_t) map_representatives.size(); j++) {
+                    auto &sv_j = sv_hierarchies[map_representatives[j]];
+                    if (num_leaves(sv_j.tree) == num_leaves(sv_hierarchies[i].tree) &&
+                        std::equal(labels.begin(), labels.end(), sv_j.supervertex_labelisation.begin())) {
+                        map_index[i] = j;
+                        break;
+                    }
+                }
+                if (map_index[i] == invalid_index) {
+                    map_index[i] = map_representatives.size();
+                    map_representatives.push_back(i);
+                }
+            }
+
+            std::vector<array_1d<index_t>> fine_to_coarse_maps(map_representatives.size());
+            parfor(0, (index_t) map_representatives.size(),
+                   [this, &map_representatives, &sv_hierarchies, &fine_to_coarse_maps](index_t j) {
+                       auto &sv_hierarchy = sv_hierarchies[map_representatives[j]];
+                       fine_to_coarse_maps[j] = project_fine_to_coarse_labelisation(
+                               m_fine_rag.vertex_map,
+                               sv_hierarchy.supervertex_labelisation,
+                               num_vertices(m_fine_rag.rag),
+                               num_leaves(sv_hierarchy.tree));
+                   });
+
+            std::vector<array_1d<typename T::value_type>> result(num_hierarchies);
+            parfor(0, num_hierarchies,
+                   [this, &altitudes, &sv_hierarchies, &map_index, &fine_to_coarse_maps, &result](index_t i) {
+                       auto &sv_hierarchy = sv_hierarchies[i];
+                       array_1d<typename T::value_type> altitudes_sv_hierarchy = gather(altitudes[i],
+                                                                                        sv_hierarchy.node_map);
+                       auto coarse_sm_on_fine_rag =
+                               alignment_internal::project_hierarchy_from_map(m_fine_rag,
+                                                                              fine_to_coarse_maps[map_index[i]],
+                                                                              sv_hierarchy.tree,
+                                                                              altitudes_sv_hierarchy);
+                       result[i] = rag_back_project_weights(m_fine_rag.edge_map, coarse_sm_on_fine_rag);
+                   });
+            return result;
+        }
+
+        /**
+         * Align several hierarchies defined on the same coarse supervertices (see align_hierarchy).
+         *
+         * The projection of the fine supervertices on the coarse supervertices is computed only once and the
+         * hierarchies are aligned in parallel.
+         *
+         * @tparam T1
+         * @tparam T2
+         * @param xcoarse_supervertices labelisation of the graph vertices into coarse supervertices
+         * @param trees input trees whose leaves are the coarse supervertices
+         * @param altitudes altitudes of the nodes of each tree
+         * @return a vector containing the saliency map of each aligned hierarchy
+         */
+        template<typename T1, typename T2>
+        auto align_hierarchies(const xt::xexpression<T1> &xcoarse_supervertices,
+                               const std::vector<hg::tree> &trees,
+                               const std::vector<T2> &altitudes) const {
+            HG_TRACE();
+            auto &coarse_supervertices = xcoarse_supervertices.derived_cast();
+            hg_assert_1d_array(coarse_supervertices);
+            hg_assert_integral_value_type(coarse_supervertices);
+            hg_assert(coarse_supervertices.size() == m_fine_rag.vertex_map.size(),
+                      "Cannot align given hierarchy: incompatible sizes!");
+            hg_assert(trees.size() == altitudes.size(), "The numbers of trees and of altitudes do not match.");
+            const index_t num_hierarchies = trees.size();
+
+            for (index_t i = 0; i < num_hierarchies; i++) {
+                hg_assert_node_weights(trees[i], altitudes[i]);
+                hg_assert_1d_array(altitudes[i]);
+                // computed before the parallel section as several items may share the same tree
+                trees[i].compute_children();
+            }
+
+            auto fine_to_coarse_map = project_fine_to_coarse_labelisation(m_fine_rag.vertex_map,
+                                                                          coarse_supervertices);
+
+            std::vector<array_1d<typename T2::value_type>> result(num_hierarchies);
+            parfor(0, num_hierarchies, [this, &trees, &altitudes, &fine_to_coarse_map, &result](index_t i) {
+                auto coarse_sm_on_fine_rag =
+                        alignment_internal::project_hierarchy_from_map(m_fine_rag,
+                                                                       fine_to_coarse_map,
+                                                                       trees[i],
+                                                                       altitudes[i]);
+                result[i] = rag_back_project_weights(m_fine_rag.edge_map, coarse_sm_on_fine_rag);
+            });
+            return result;
+        }
+
     private:
         region_adjacency_graph m_fine_rag;
     };
@@ -0,0 +1,241 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../attribute/tree_attribute.hpp"
+#include "../hierarchy/component_tree.hpp"
+#include <functional>
+
+namespace hg {
+
+    /**
+     * Attributes available in a connected_filter_pipeline
+     */
+    enum class filter_pipeline_attribute {
+        area,
+        volume,
+        depth,
+        mean_vertex_weights
+    };
+
+    /**
+     * Component tree built by a connected_filter_pipeline
+     */
+    enum class filter_pipeline_tree {
+        max_tree,
+        min_tree
+    };
+
+    /**
+     * Comparison operators of the clauses of a connected_filter_pipeline
+     */
+    enum class filter_pipeline_comparison {
+        less,
+        less_equal,
+        greater,
+        greater_equal
+    };
+
+    /**
+     * Values of the attributes of a connected_filter_pipeline during its execution, given to the predicate.
+     */
+    class filter_pipeline_attribute_values {
+    public:
+
+        /**
+         * Value of the attribute of the given node
+         * @param attribute index of the attribute (as returned by connected_filter_pipeline::add_attribute)
+         * @param node node index
+         * @return
+         */
+        double operator()(index_t attribute, index_t node) const {
+            auto &a = m_attributes[attribute];
+            return (a.first != nullptr) ? a.first[node] : (double) a.second[node];
+        }
+
+    private:
+        friend class connected_filter_pipeline;
+
+        std::vector<std::pair<const double *, const index_t *>> m_attributes;
+    };
+
+    /**
+     * Connected filter (attribute opening or closing) recorded as a lazy pipeline: component tree construction,
+     * attributes, pruning predicate and reconstruction of the filtered vertex weights.
+     *
+     * Nothing is computed until execute is called. The execution then builds the component tree, computes all the
+     * attributes in a single traversal (see fused_tree_attributes), and evaluates the predicate during the root to
+     * leaves traversal of the reconstruction: the nodes where the predicate is true are removed and their vertices
+     * take the reconstructed value of their parent (as with reconstruct_leaf_data, the root is never removed).
+     * The reconstruction is done in place in the altitudes of the tree and no array of deleted nodes is created;
+     * the attribute arrays are released at the end of the execution.
+     *
+     * The predicate is the disjunction of the clauses added with remove_if, or any function given to set_predicate.
+     *
+     * Example:
+     *
+     *     connected_filter_pipeline pipeline(filter_pipeline_tree::max_tree);
+     *     auto area = pipeline.add_attribute(filter_pipeline_attribute::area);
+     *     auto volume = pipeline.add_attribute(filter_pipeline_attribute::volume);
+     *     pipeline.remove_if(area, filter_pipeline_comparison::less, 100);
+     *     pipeline.remove_if(volume, filter_pipeline_comparison::less, 1000);
+     *     auto filtered = pipeline.execute(graph, vertex_weights);
+     */
+    class connected_filter_pipeline {
+    public:
+
+        using predicate_type = std::function<bool(index_t, const filter_pipeline_attribute_values &)>;
+
+        explicit connected_filter_pipeline(filter_pipeline_tree tree_type = filter_pipeline_tree::max_tree) :
+                m_tree_type(tree_type) {
+        }
+
+        /**
+         * Records an attribute: an attribute requested several times is computed once.
+         *
+         * @param attribute
+         * @return index of the attribute in the predicate
+         */
+        index_t add_attribute(filter_pipeline_attribute attribute) {
+            for (index_t i = 0; i < (index_t) m_attributes.size(); i++) {
+                if (m_attributes[i] == attribute) {
+                    return i;
+                }
+            }
+            m_attributes.push_back(attribute);
+            return (index_t) m_attributes.size() - 1;
+        }
+
+        /**
+         * Adds a clause to the predicate: the nodes whose attribute compares to the threshold with the given
+         * comparison are removed.
+         *
+         * @param attribute index of the attribute (see add_attribute)
+         * @param comparison
+         * @param threshold
+         * @return the pipeline
+         */
+        connected_filter_pipeline &remove_if(index_t attribute, filter_pipeline_comparison comparison, double threshold) {
+            hg_assert(attribute >= 0 && attribute < (index_t) m_attributes.size(), "Invalid attribute index.");
+            m_clauses.push_back({attribute, comparison, threshold});
+            return *this;
+        }
+
+        /**
+         * Replaces the clauses by the given predicate: predicate(n, attributes) is true if the node n must be removed.
+         *
+         * @param predicate
+         * @return the pipeline
+         */
+        connected_filter_pipeline &set_predicate(predicate_type predicate) {
+            m_clauses.clear();
+            m_predicate = std::move(predicate);
+            return *this;
+        }
+
+        const std::vector<filter_pipeline_attribute> &attributes() const {
+            return m_attributes;
+        }
+
+        /**
+         * Executes the pipeline on the given vertex weighted graph.
+         *
+         * @param graph input graph
+         * @param xvertex_weights graph vertex weights (1d)
+         * @return the filtered vertex weights
+         */
+        template<typename graph_t, typename T>
+        auto execute(const graph_t &graph, const xt::xexpression<T> &xvertex_weights) const {
+            HG_TRACE();
+            auto &vertex_weights = xvertex_weights.derived_cast();
+            hg_assert_vertex_weights(graph, vertex_weights);
+            hg_assert_1d_array(vertex_weights);
+
+            auto res = (m_tree_type == filter_pipeline_tree::max_tree) ?
+                       component_tree_max_tree(graph, vertex_weights) :
+                       component_tree_min_tree(graph, vertex_weights);
+            auto &tree = res.tree;
+            auto &altitudes = res.altitudes;
+            const index_t num_l = num_leaves(tree);
+
+            filter_pipeline_attribute_values values;
+            {
+                fused_tree_attributes<hg::tree, double> engine(tree, xt::ones<double>({(size_t) num_l}));
+                for (auto attribute: m_attributes) {
+                    switch (attribute) {
+                        case filter_pipeline_attribute::area:
+                            values.m_attributes.emplace_back(engine.area().data(), nullptr);
+                            break;
+                        case filter_pipeline_attribute::volume:
+                            values.m_attributes.emplace_back(engine.add_volume(altitudes).data(), nullptr);
+                            break;
+                        case filter_pipeline_attribute::depth:
+                            values.m_attributes.emplace_back(nullptr, engine.add_depth().data());
+                            break;
+                        case filter_pipeline_attribute::mean_vertex_weights:
+                            values.m_attributes.emplace_back(
+                                    engine.add_mean_vertex_weights(vertex_weights).data(), nullptr);
+                            break;
+                    }
+                }
+                engine.compute();
+
+                // fused predicate evaluation and reconstruction, in place in the altitudes
+                auto &parents = tree.parents();
+                for (auto n: root_to_leaves_iterator(tree, leaves_it::include, root_it::exclude)) {
+                    if (is_removed(n, values)) {
+                        altitudes(n) = altitudes(parents(n));
+                    }
+                }
+            }
+
+            return array_1d<typename T::value_type>(xt::view(altitudes, xt::range(0, num_l)));
+        }
+
+    private:
+
+        struct clause {
+            index_t attribute;
+            filter_pipeline_comparison comparison;
+            double threshold;
+        };
+
+        bool is_removed(index_t n, const filter_pipeline_attribute_values &values) const {
+            if (m_predicate) {
+                return m_predicate(n, values);
+            }
+            for (const auto &c: m_clauses) {
+                const double v = values(c.attribute, n);
+                switch (c.comparison) {
+                    case filter_pipeline_comparison::less:
+                        if (v < c.threshold) return true;
+                        break;
+                    case filter_pipeline_comparison::less_equal:
+                        if (v <= c.threshold) return true;
+                        break;
+                    case filter_pipeline_comparison::greater:
+                        if (v > c.threshold) return true;
+                        break;
+                    case filter_pipeline_comparison::greater_equal:
+                        if (v >= c.threshold) return true;
+                        break;
+                }
+            }
+            return false;
+        }
+
+        filter_pipeline_tree m_tree_type;
+        std::vector<filter_pipeline_attribute> m_attributes;
+        std::vector<clause> m_clauses;
+        predicate_type m_predicate;
+    };
+}
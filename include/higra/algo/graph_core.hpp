@@ -18,11 +18,64 @@
 
 namespace hg {
 
+    /**
+     * Labelize the connected components of the subgraph of the given graph composed of all its vertices and of the edges
+     * satisfying the given predicate.
+     *
+     * Components are computed in parallel with a lock-free union-find on the vertex set: each vertex is processed
+     * concurrently and united with the targets of its out edges satisfying the predicate.
+     *
+     * Components are numbered from 1 to n, in the order of their vertex of smallest index (with a parallel prefix
+     * sum): the result is thus identical to the one of a sequential graph traversal.
+     *
+     * @tparam graph_t
+     * @tparam predicate_t callable taking an edge of the graph and returning a boolean
+     * @param graph input graph
+     * @param edge_predicate edges e such that edge_predicate(e) is true connect their extremities
+     * @return array of labels on graph vertices, numbered from 1 to n with n the number of connected components
+     */
+    template<typename graph_t,
+            typename predicate_t>
+    auto parallel_connected_components(const graph_t &graph, const predicate_t &edge_predicate) {
+        HG_TRACE();
+        index_t num_v = num_vertices(graph);
+        concurrent_union_find<index_t> uf(num_v);
+
+        parfor(0, num_v, [&graph, &edge_predicate, &uf](index_t v) {
+            for (auto e: out_edge_iterator(v, graph)) {
+                auto n = (index_t) target(e, graph);
+                // undirected edges are seen from both extremities: only process them once
+                if (n > v && edge_predicate(e)) {
+                    uf.unite(v, n);
+                }
+            }
+        });
+
+        // the canonical node of a component is its vertex of smallest index: canonical nodes are numbered in
+        // increasing order with a prefix sum on their indicator
+        array_1d<index_t> labels = xt::empty<index_t>({(size_t) num_v});
+        parfor(0, num_v, [&labels, &uf](index_t v) {
+            labels(v) = (uf.find(v) == v) ? 1 : 0;
+        });
+        parallel_inclusive_scan(labels.data(), num_v);
+
+        parfor(0, num_v, [&labels, &uf](index_t v) {
+            auto root = uf.find(v);
+            if (root != v) {
+                labels(v) = labels(root);
+            }
+        });
+
+        return labels;
+    };
+
     /**
      * Labelize graph vertices according to the given graph cut.
      * Each edge having a non zero value in the given edge_weights
      * are assumed to be part of the cut.
      *
+     * Connected components are computed in parallel (see parallel_connected_components).
+     *
      * @tparam graph_t
      * @tparam T
      * @tparam label_type
@@ -39,33 +92,9 @@ namespace hg {
         hg_assert_edge_weights(graph, edge_weights);
         hg_assert_1d_array(edge_weights);
 
-        stackv<index_t> stack;
-        array_1d<index_t> labels = xt::empty<index_t>({num_vertices(graph)});
-        labels.fill(invalid_index);
-
-        index_t current_label = 0;
-        for (auto v: vertex_iterator(graph)) {
-            if (labels(v) == invalid_index) {
-                current_label++;
-                labels(v) = current_label;
-                stack.push(v);
-                while (!stack.empty()) {
-                    auto cv = stack.top();
-                    stack.pop();
-                    for (auto e: out_edge_iterator(cv, graph)) {
-                        if (edge_weights(e) == 0) {
-                            auto n = target(e, graph);
-                            if (labels(n) == invalid_index) {
-                                labels(n) = current_label;
-                                stack.push(n);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        return labels;
+        return parallel_connected_components(graph, [&edge_weights](const auto &e) {
+            return edge_weights(e) == 0;
+        });
     };
 
     /**
@@ -74,6 +103,8 @@ namespace hg {
      * The result is a weighting of the graph edges where edges with
      * a non zero weight are part of the cut.
      *
+     * Edges are processed in parallel.
+     *
      * @tparam graph_t
      * @tparam T
      * @param graph
@@ -89,7 +120,36 @@ namespace hg {
         hg_assert_vertex_weights(graph, vertex_labels);
         hg_assert_1d_array(vertex_labels);
 
-        return weight_graph<char>(graph, vertex_labels, weight_functions::L0);
+        auto result = array_1d<char>::from_shape({num_edges(graph)});
+        parfor(0, num_edges(graph), [&graph, &vertex_labels, &result](index_t i) {
+            auto e = edge_from_index(i, graph);
+            result(i) = (vertex_labels(source(e, graph)) != vertex_labels(target(e, graph))) ? 1 : 0;
+        });
+        return result;
+    };
+
+    /**
+     * Determine the graph cut that corresponds to a given labeling of the vertices of an implicit 4 adjacency grid
+     * graph.
+     *
+     * Specialization of the generic labelisation_2_graph_cut function: labels are compared row by row on contiguous
+     * ranges with the vectorized L0 kernel of weight_graph (see weight_graph on grid_4_adjacency_graph_2d).
+     *
+     * @tparam T
+     * @param graph
+     * @param xvertex_labels
+     * @return
+     */
+    template<typename T>
+    auto labelisation_2_graph_cut(const grid_4_adjacency_graph_2d &graph,
+                                  const xt::xexpression<T> &xvertex_labels) {
+        HG_TRACE();
+        auto &vertex_labels = xvertex_labels.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_labels);
+        hg_assert_1d_array(vertex_labels);
+
+        using value_type = typename std::decay_t<decltype(vertex_labels)>::value_type;
+        return weight_graph<char, value_type>(graph, vertex_labels, weight_functions::L0);
     };
 
 
@@ -178,6 +238,8 @@ namespace hg {
      *
      * The edges of the subgraph will be in the order given in edge_indices array.
      *
+     * The extremities of the selected edges are gathered in parallel and inserted at once with add_edges.
+     *
      * @tparam graph_t
      * @tparam T
      * @param graph input graph
@@ -190,15 +252,67 @@ namespace hg {
         hg_assert_1d_array(edge_indices);
         hg_assert_integral_value_type(edge_indices);
 
-        graph_t subgraph(num_vertices(graph));
-        for (index_t ei: edge_indices) {
-            auto e = edge_from_index(ei, graph);
-            add_edge(source(e, graph), target(e, graph), subgraph);
-        }
+        const index_t num_sub_edges = edge_indices.size();
+        array_1d<index_t> sources = array_1d<index_t>::from_shape({(size_t) num_sub_edges});
+        array_1d<index_t> targets = array_1d<index_t>::from_shape({(size_t) num_sub_edges});
+        parfor(0, num_sub_edges, [&graph, &edge_indices, &sources, &targets](index_t i) {
+            auto e = edge_from_index(edge_indices(i), graph);
+            sources(i) = source(e, graph);
+            targets(i) = target(e, graph);
+        });
 
+        graph_t subgraph(num_vertices(graph));
+        add_edges(sources, targets, subgraph);
         return subgraph;
     }
 
+    namespace graph_core_internal {
+
+        /**
+         * Builds a line graph from a function enumerating, for each vertex v of the original graph, the pairs of
+         * edges that must be linked in the line graph because of v: enumerate_pairs(v, output) must call
+         * output(e1, e2) for each such pair (e1, e2) of edge indices.
+         *
+         * The number of pairs of each vertex is first counted in parallel, an exclusive prefix sum gives the position
+         * of the pairs of each vertex in the edge list of the result, and the pairs are then written in place in
+         * parallel. Edges of the line graph are thus ordered by vertex of the original graph, and for each vertex in
+         * the enumeration order, independently of the number of threads.
+         *
+         * @tparam enumerate_pairs_t
+         * @param num_vertices_graph number of vertices of the original graph
+         * @param num_edges_graph number of edges of the original graph
+         * @param enumerate_pairs enumeration function
+         * @return a ugraph
+         */
+        template<typename enumerate_pairs_t>
+        ugraph line_graph_from_pairs(index_t num_vertices_graph,
+                                     index_t num_edges_graph,
+                                     const enumerate_pairs_t &enumerate_pairs) {
+            array_1d<index_t> offsets = array_1d<index_t>::from_shape({(size_t) num_vertices_graph + 1});
+            offsets(0) = 0;
+            parfor(0, num_vertices_graph, [&offsets, &enumerate_pairs](index_t v) {
+                index_t count = 0;
+                enumerate_pairs(v, [&count](index_t, index_t) { count++; });
+                offsets(v + 1) = count;
+            });
+            parallel_inclusive_scan(offsets.data(), num_vertices_graph + 1);
+
+            const index_t num_lg_edges = offsets(num_vertices_graph);
+            array_1d<index_t> sources = array_1d<index_t>::from_shape({(size_t) num_lg_edges});
+            array_1d<index_t> targets = array_1d<index_t>::from_shape({(size_t) num_lg_edges});
+            parfor(0, num_vertices_graph, [&offsets, &sources, &targets, &enumerate_pairs](index_t v) {
+                index_t pos = offsets(v);
+                enumerate_pairs(v, [&pos, &sources, &targets](index_t e1, index_t e2) {
+                    sources(pos) = e1;
+                    targets(pos) = e2;
+                    pos++;
+                });
+            });
+
+            return ugraph(num_edges_graph, sources, targets);
+        }
+    }
+
     /**
      * Compute the line graph of an undirected graph.
      *
@@ -220,22 +334,23 @@ namespace hg {
      */
     inline
     ugraph line_graph(const ugraph &graph) {
-        ugraph lg(num_edges(graph));
-        for (auto v: vertex_iterator(graph)) {
-            auto it = graph.out_edges_cbegin(v);
-            index_t n_out = out_degree(v, graph);
-            for (index_t i = 0; i < n_out; ++i) {
-                auto &e1 = edge_from_index(it[i], graph);
-                for (index_t j = i + 1; j < n_out; ++j) {
-                    auto &e2 = edge_from_index(it[j], graph);
-                    // the following test prevents multiple edges from being linked several times
-                    if (!(e1.source == e2.source && e1.source < v)) {
-                        add_edge(e1.index, e2.index, lg);
+        return graph_core_internal::line_graph_from_pairs(
+                num_vertices(graph),
+                num_edges(graph),
+                [&graph](index_t v, const auto &output) {
+                    auto it = graph.out_edges_cbegin(v);
+                    index_t n_out = out_degree(v, graph);
+                    for (index_t i = 0; i < n_out; ++i) {
+                        auto &e1 = edge_from_index(it[i], graph);
+                        for (index_t j = i + 1; j < n_out; ++j) {
+                            auto &e2 = edge_from_index(it[j], graph);
+                            // the following test prevents multiple edges from being linked several times
+                            if (!(e1.source == e2.source && e1.source < v)) {
+                                output(e1.index, e2.index);
+                            }
+                        }
                     }
-                }
-            }
-        }
-        return lg;
+                });
     }
 
 
@@ -248,20 +363,21 @@ namespace hg {
      */
     template<typename graph_t>
     ugraph line_graph(const graph_t &graph) {
-        ugraph lg(num_edges(graph));
-        for (auto v: vertex_iterator(graph)) {
-            for (const auto &e1 : out_edge_iterator(v, graph)) {
-                for (const auto &e2 : out_edge_iterator(v, graph)) {
-                    // do not proceed the same edge twice
-                    if (e1.index < e2.index) {
-                        // the following test prevents multiple edges from being linked several times
-                        if (!(e1.target == e2.target && e1.target < v)) {
-                            add_edge(e1.index, e2.index, lg);
+        return graph_core_internal::line_graph_from_pairs(
+                num_vertices(graph),
+                num_edges(graph),
+                [&graph](index_t v, const auto &output) {
+                    for (const auto &e1 : out_edge_iterator(v, graph)) {
+                        for (const auto &e2 : out_edge_iterator(v, graph)) {
+                            // do not proceed the same edge twice
+                            if (e1.index < e2.index) {
+                                // the following test prevents multiple edges from being linked several times
+                                if (!(e1.target == e2.target && e1.target < v)) {
+                                    output(e1.index, e2.index);
+                                }
+                            }
                         }
                     }
-                }
-            }
-        }
-        return lg;
+                });
     }
 }
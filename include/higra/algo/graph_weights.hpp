@@ -13,11 +13,19 @@
 #include "../graph.hpp"
 #include "xtensor/xexpression.hpp"
 #include "../structure/details/light_axis_view.hpp"
+#include "../detail/simd_dispatch.hpp"
+#include "../detail/fixed_width.hpp"
+#include <xsimd/xsimd.hpp>
 
 namespace hg {
 
     /**
      * Predefined edge-weighting functions (see weight_graph function)
+     *
+     * cosine is the cosine distance 1 - <a, b> / (||a|| ||b||) between the vertex weights a and b of the extremities
+     * of an edge (0 if a and b are both null, 1 if only one of them is null), and chi_square is the chi-square
+     * distance sum_k (a_k - b_k)^2 / (a_k + b_k) (terms with a_k + b_k = 0 are null) between non negative vertex
+     * weights such as histograms.
      */
     enum class weight_functions {
         mean,
@@ -29,9 +37,510 @@ namespace hg {
         L_infinity,
         L2_squared,
         source,
-        target
+        target,
+        cosine,
+        chi_square
     };
 
+    namespace graph_weights_internal {
+
+        /*
+         * Edge-weighting operations used by the grid graph kernels: an edge weight is computed from the element-wise
+         * values element(a, b) of the channels of its extremities, combined from init() with combine, and finalized
+         * with finalize. The result is identical to the one of the generic implementation of weight_graph.
+         */
+
+        struct op_mean {
+            template<typename P>
+            static P element(P a, P b) { return (a + b) / static_cast<P>(2.0); }
+
+            template<typename P>
+            static P init() { return 0; }
+
+            template<typename P>
+            static P combine(P, P v) { return v; }
+
+            template<typename P>
+            static P finalize(P v) { return v; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) {
+                return (a + b) / B(static_cast<typename B::value_type>(2.0));
+            }
+#endif
+        };
+
+        struct op_min : public op_mean {
+            template<typename P>
+            static P element(P a, P b) { return (std::min)(a, b); }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) { return xsimd::min(a, b); }
+#endif
+        };
+
+        struct op_max : public op_mean {
+            template<typename P>
+            static P element(P a, P b) { return (std::max)(a, b); }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) { return xsimd::max(a, b); }
+#endif
+        };
+
+        struct op_source : public op_mean {
+            template<typename P>
+            static P element(P a, P) { return a; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &) { return a; }
+#endif
+        };
+
+        struct op_target : public op_mean {
+            template<typename P>
+            static P element(P, P b) { return b; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &, const B &b) { return b; }
+#endif
+        };
+
+        struct op_L0 {
+            template<typename P>
+            static P element(P a, P b) { return (a == b) ? 0 : 1; }
+
+            template<typename P>
+            static P init() { return 0; }
+
+            template<typename P>
+            static P combine(P acc, P v) { return (std::max)(acc, v); }
+
+            template<typename P>
+            static P finalize(P v) { return v; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) {
+                using value_t = typename B::value_type;
+                return xsimd::select(a == b, B(static_cast<value_t>(0)), B(static_cast<value_t>(1)));
+            }
+#endif
+        };
+
+        struct op_L1 {
+            template<typename P>
+            static P element(P a, P b) { return std::abs(a - b); }
+
+            template<typename P>
+            static P init() { return 0; }
+
+            template<typename P>
+            static P combine(P acc, P v) { return acc + v; }
+
+            template<typename P>
+            static P finalize(P v) { return v; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) { return xsimd::abs(a - b); }
+#endif
+        };
+
+        struct op_L2_squared : public op_L1 {
+            template<typename P>
+            static P element(P a, P b) { return (a - b) * (a - b); }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static B element_batch(const B &a, const B &b) { return (a - b) * (a - b); }
+#endif
+        };
+
+        struct op_L2 : public op_L2_squared {
+            template<typename P>
+            static P finalize(P v) { return std::sqrt(v); }
+        };
+
+        struct op_L_infinity : public op_L1 {
+            template<typename P>
+            static P init() { return -1; }
+
+            template<typename P>
+            static P combine(P acc, P v) { return (std::max)(acc, v); }
+        };
+
+        /**
+         * out[k] = op::element(a[k], b[k]) for k in [0, size[
+         */
+        template<typename op, typename value_t, typename promoted_t>
+        void element_range(const value_t *a, const value_t *b, promoted_t *out, index_t size, std::false_type) {
+            for (index_t k = 0; k < size; k++) {
+                out[k] = op::element(static_cast<promoted_t>(a[k]), static_cast<promoted_t>(b[k]));
+            }
+        }
+
+#if defined(HG_HAS_SIMD_DISPATCH)
+
+        /**
+         * Value types for which element_range is processed with the runtime dispatched kernel
+         */
+        template<typename value_t, typename promoted_t>
+        struct is_simd_weightable : public std::integral_constant<bool,
+                std::is_arithmetic<value_t>::value &&
+                std::is_same<value_t, promoted_t>::value> {
+        };
+
+        template<typename op, typename value_t>
+        HG_SIMD_DISPATCH
+        void element_range(const value_t *a, const value_t *b, value_t *out, index_t size, std::true_type) {
+            for (index_t k = 0; k < size; k++) {
+                out[k] = op::element(a[k], b[k]);
+            }
+        }
+
+#elif defined(XTENSOR_USE_XSIMD)
+
+        /**
+         * Value types for which element_range is processed with xsimd batches
+         */
+        template<typename value_t, typename promoted_t>
+        struct is_simd_weightable : public std::integral_constant<bool,
+                std::is_floating_point<value_t>::value &&
+                std::is_same<value_t, promoted_t>::value &&
+                (xsimd::simd_traits<value_t>::size > 1)> {
+        };
+
+        template<typename op, typename value_t>
+        void element_range(const value_t *a, const value_t *b, value_t *out, index_t size, std::true_type) {
+            constexpr index_t batch_size = xsimd::simd_traits<value_t>::size;
+            index_t simd_size = size - size % batch_size;
+            index_t k = 0;
+            for (; k < simd_size; k += batch_size) {
+                xsimd::store_unaligned(out + k, op::element_batch(xsimd::load_unaligned(a + k),
+                                                                  xsimd::load_unaligned(b + k)));
+            }
+            for (; k < size; k++) {
+                out[k] = op::element(a[k], b[k]);
+            }
+        }
+
+#else
+        template<typename value_t, typename promoted_t>
+        struct is_simd_weightable : public std::false_type {
+        };
+#endif
+
+        /**
+         * Weights the edges of a 4 adjacency grid graph of shape (height, width) from the row major vertex weights
+         * data with the given number of channels per vertex.
+         *
+         * For each row of the grid, the element-wise values of the channels of the pixels and of their right
+         * neighbours, and of the pixels and of their bottom neighbours, are computed on contiguous ranges (the two
+         * ranges are the row data shifted by one pixel and by one row). They are then reduced per pixel and stored in
+         * the edge order of the grid graph.
+         *
+         * The reduction is instantiated for the common numbers of channels (see dispatch_fixed_width).
+         */
+        template<typename op, typename result_value_t, typename promoted_t, typename value_t, typename width_t>
+        void weight_grid_graph_2d(const value_t *data,
+                                  index_t height,
+                                  index_t width,
+                                  width_t channels,
+                                  array_1d<result_value_t> &result) {
+            const index_t row_size = 2 * width - 1;
+            const index_t pixel_row_size = width * channels;
+            auto reduce = [channels](const promoted_t *values) {
+                promoted_t res = op::template init<promoted_t>();
+                for (index_t k = 0; k < channels; k++) {
+                    res = op::template combine<promoted_t>(res, values[k]);
+                }
+                return static_cast<result_value_t>(op::template finalize<promoted_t>(res));
+            };
+
+            parfor(0, height, [&](index_t i) {
+                using simd_t = is_simd_weightable<value_t, promoted_t>;
+                std::vector<promoted_t> right((width - 1) * channels);
+                const value_t *row = data + i * pixel_row_size;
+                element_range<op>(row, row + channels, right.data(), (width - 1) * channels, simd_t());
+                result_value_t *out = result.data() + i * row_size;
+                if (i < height - 1) {
+                    std::vector<promoted_t> bottom(pixel_row_size);
+                    element_range<op>(row, row + pixel_row_size, bottom.data(), pixel_row_size, simd_t());
+                    for (index_t j = 0; j < width - 1; j++) {
+                        out[2 * j] = reduce(right.data() + j * channels);
+                        out[2 * j + 1] = reduce(bottom.data() + j * channels);
+                    }
+                    out[2 * (width - 1)] = reduce(bottom.data() + (width - 1) * channels);
+                } else {
+                    for (index_t j = 0; j < width - 1; j++) {
+                        out[j] = reduce(right.data() + j * channels);
+                    }
+                }
+            });
+        }
+
+        template<typename op, typename result_value_t, typename promoted_t, typename value_t>
+        void weight_grid_graph_2d(const value_t *data,
+                                  index_t height,
+                                  index_t width,
+                                  index_t num_channels,
+                                  array_1d<result_value_t> &result) {
+            dispatch_fixed_width(num_channels, [&](auto channels) {
+                weight_grid_graph_2d<op, result_value_t, promoted_t>(data, height, width, channels, result);
+            });
+        }
+
+        /*
+         * Reduction kernels on the channels of the extremities of an edge: the num_sums partial sums of the kernel are
+         * accumulated from the channels with accumulate and the edge weight is computed from the sums with finalize.
+         */
+
+        struct kernel_cosine {
+            static constexpr index_t num_sums = 3;
+
+            template<typename P>
+            static void accumulate(P a, P b, P *sums) {
+                sums[0] += a * b;
+                sums[1] += a * a;
+                sums[2] += b * b;
+            }
+
+            template<typename P>
+            static P finalize(const P *sums) {
+                if (sums[1] == 0 || sums[2] == 0) {
+                    return (sums[1] == sums[2]) ? 0 : 1;
+                }
+                return 1 - sums[0] / std::sqrt(sums[1] * sums[2]);
+            }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static void accumulate_batch(const B &a, const B &b, B *sums) {
+                sums[0] += a * b;
+                sums[1] += a * a;
+                sums[2] += b * b;
+            }
+#endif
+        };
+
+        struct kernel_chi_square {
+            static constexpr index_t num_sums = 1;
+
+            template<typename P>
+            static void accumulate(P a, P b, P *sums) {
+                P s = a + b;
+                P d = a - b;
+                sums[0] += (s != 0) ? d * d / s : 0;
+            }
+
+            template<typename P>
+            static P finalize(const P *sums) { return sums[0]; }
+
+#ifdef XTENSOR_USE_XSIMD
+            template<typename B>
+            static void accumulate_batch(const B &a, const B &b, B *sums) {
+                using value_t = typename B::value_type;
+                B s = a + b;
+                B d = a - b;
+                sums[0] += xsimd::select(s != B(static_cast<value_t>(0)), d * d / s, B(static_cast<value_t>(0)));
+            }
+#endif
+        };
+
+        /**
+         * Weight of an edge whose extremities have the channel values a[k] and b[k] for k in [0, size[ with the given
+         * reduction kernel
+         */
+        template<typename kernel, typename value_t, typename promoted_t>
+        promoted_t reduce_range(const value_t *a, const value_t *b, index_t size, std::false_type) {
+            promoted_t sums[kernel::num_sums] = {};
+            for (index_t k = 0; k < size; k++) {
+                kernel::accumulate(static_cast<promoted_t>(a[k]), static_cast<promoted_t>(b[k]), sums);
+            }
+            return kernel::finalize(sums);
+        }
+
+#if defined(HG_HAS_SIMD_DISPATCH)
+
+        template<typename kernel, typename value_t, typename promoted_t>
+        HG_SIMD_DISPATCH
+        promoted_t reduce_range(const value_t *a, const value_t *b, index_t size, std::true_type) {
+            value_t sums[kernel::num_sums] = {};
+            for (index_t k = 0; k < size; k++) {
+                kernel::accumulate(a[k], b[k], sums);
+            }
+            return kernel::finalize(sums);
+        }
+
+#elif defined(XTENSOR_USE_XSIMD)
+
+        template<typename kernel, typename value_t, typename promoted_t>
+        promoted_t reduce_range(const value_t *a, const value_t *b, index_t size, std::true_type) {
+            using batch_t = xsimd::simd_type<value_t>;
+            constexpr index_t batch_size = xsimd::simd_traits<value_t>::size;
+            index_t simd_size = size - size % batch_size;
+            batch_t batch_sums[kernel::num_sums];
+            for (index_t i = 0; i < kernel::num_sums; i++) {
+                batch_sums[i] = batch_t(static_cast<value_t>(0));
+            }
+            index_t k = 0;
+            for (; k < simd_size; k += batch_size) {
+                kernel::accumulate_batch(batch_t(xsimd::load_unaligned(a + k)),
+                                         batch_t(xsimd::load_unaligned(b + k)),
+                                         batch_sums);
+            }
+            value_t sums[kernel::num_sums];
+            for (index_t i = 0; i < kernel::num_sums; i++) {
+                sums[i] = xsimd::hadd(batch_sums[i]);
+            }
+            for (; k < size; k++) {
+                kernel::accumulate(a[k], b[k], sums);
+            }
+            return kernel::finalize(sums);
+        }
+
+#endif
+
+        /**
+         * Edge weighting kernel (see weight_graph_kernel) computing the combination of the element-wise values of
+         * the given operation (see op_L1) on a number of channels given by width (fixed_width or dynamic_width)
+         */
+        template<typename op, typename promoted_t, typename width_t>
+        struct channel_reduction_kernel {
+            width_t width;
+
+            template<typename value_t>
+            promoted_t operator()(const value_t *a, const value_t *b, index_t) const {
+                promoted_t res = op::template init<promoted_t>();
+                for (index_t k = 0; k < (index_t) width; k++) {
+                    res = op::template combine<promoted_t>(
+                            res, op::element(static_cast<promoted_t>(a[k]), static_cast<promoted_t>(b[k])));
+                }
+                return op::template finalize<promoted_t>(res);
+            }
+        };
+
+        /**
+         * Edge weighting kernel (see weight_graph_kernel) computing the given reduction kernel in promoted_t
+         */
+        template<typename kernel, typename promoted_t>
+        struct reduction_kernel {
+            template<typename value_t>
+            promoted_t operator()(const value_t *a, const value_t *b, index_t size) const {
+                return reduce_range<kernel, value_t, promoted_t>(a, b, size,
+                                                                 is_simd_weightable<value_t, promoted_t>());
+            }
+        };
+
+        /**
+         * Calls fun with a pointer to the row major data of vertex_weights (copied if the vertex weights are not
+         * a contiguous row major array)
+         */
+        template<typename T, typename F>
+        void with_contiguous_data(const T &vertex_weights, F &&fun, std::true_type /* has data interface */) {
+            if (vertex_weights.layout() == xt::layout_type::row_major) {
+                fun(vertex_weights.data() + vertex_weights.data_offset());
+            } else {
+                array_nd<typename T::value_type> contiguous_weights = vertex_weights;
+                fun(contiguous_weights.data());
+            }
+        }
+
+        template<typename T, typename F>
+        void with_contiguous_data(const T &vertex_weights, F &&fun, std::false_type /* has data interface */) {
+            array_nd<typename T::value_type> contiguous_weights = vertex_weights;
+            fun(contiguous_weights.data());
+        }
+
+        template<typename op, typename result_value_t, typename promoted_t, typename T>
+        void weight_grid_graph_2d(const grid_4_adjacency_graph_2d &graph,
+                                  const T &vertex_weights,
+                                  array_1d<result_value_t> &result,
+                                  std::true_type /* has data interface */) {
+            const auto &shape = graph.embedding().shape();
+            index_t channels = vertex_weights.size() / num_vertices(graph);
+            if (vertex_weights.layout() == xt::layout_type::row_major) {
+                weight_grid_graph_2d<op, result_value_t, promoted_t>(
+                        vertex_weights.data() + vertex_weights.data_offset(), shape[0], shape[1], channels, result);
+            } else {
+                array_nd<typename T::value_type> contiguous_weights = vertex_weights;
+                weight_grid_graph_2d<op, result_value_t, promoted_t>(
+                        contiguous_weights.data(), shape[0], shape[1], channels, result);
+            }
+        }
+
+        template<typename op, typename result_value_t, typename promoted_t, typename T>
+        void weight_grid_graph_2d(const grid_4_adjacency_graph_2d &graph,
+                                  const T &vertex_weights,
+                                  array_1d<result_value_t> &result,
+                                  std::false_type /* has data interface */) {
+            array_nd<typename T::value_type> contiguous_weights = vertex_weights;
+            weight_grid_graph_2d<op, result_value_t, promoted_t>(graph, contiguous_weights, result, std::true_type());
+        }
+
+        template<typename op, typename result_value_t, typename promoted_t, typename T>
+        auto weight_grid_graph_2d(const grid_4_adjacency_graph_2d &graph, const T &vertex_weights) {
+            auto result = array_1d<result_value_t>::from_shape({num_edges(graph)});
+            if (num_edges(graph) > 0) {
+                weight_grid_graph_2d<op, result_value_t, promoted_t>(graph, vertex_weights, result,
+                                                                      xt::has_data_interface<T>());
+            }
+            return result;
+        }
+    }
+
+    /**
+     * Test if the edge weights computed by the given weighting function (see weight_graph) from vertex weights of type
+     * value_t with num_channels channels per vertex are exactly representable in value_t.
+     *
+     * This is always the case for floating point types (the result is rounded to value_t). For integral types of at
+     * most 32 bits (whose values are exactly represented in double, the default promoted type of weight_graph):
+     *  - min, max, source, target and L0 are always exact;
+     *  - L_infinity is exact for unsigned types (the absolute difference of two values of an unsigned type is a value of
+     *    this type);
+     *  - L1 and L2 are exact for unsigned types with a single channel (they are then equal to L_infinity);
+     *  - mean and L2_squared are never exact.
+     * Integral types of 64 bits are never considered exact.
+     *
+     * In this case, the edge weights can be computed in the type of the vertex weights with
+     * weight_graph<value_t>(graph, vertex_weights, weight).
+     *
+     * @tparam value_t value type of the vertex weights
+     * @param weight weighting function
+     * @param num_channels number of channels per vertex
+     * @return true if the edge weights can be represented in value_t
+     */
+    template<typename value_t>
+    bool is_exact_weight_function(weight_functions weight, index_t num_channels = 1) {
+        if (std::is_floating_point<value_t>::value) {
+            return true;
+        }
+        if (sizeof(value_t) > 4) {
+            return false;
+        }
+        switch (weight) {
+            case weight_functions::min:
+            case weight_functions::max:
+            case weight_functions::source:
+            case weight_functions::target:
+            case weight_functions::L0:
+                return true;
+            case weight_functions::L_infinity:
+                return std::is_unsigned<value_t>::value;
+            case weight_functions::L1:
+            case weight_functions::L2:
+                return std::is_unsigned<value_t>::value && num_channels == 1;
+            default:
+                return false;
+        }
+    }
+
     /**
      * Compute edge-weights of a graph based on a weighting function.
      *
@@ -49,17 +558,126 @@ namespace hg {
             typename graph_t::vertex_descriptor)> &fun) {
         auto result = array_1d<result_value_t>::from_shape({num_edges(graph)});
 
-        parfor(0, num_edges(graph), [&graph, &fun, &result](index_t i) {
-            auto e = edge_from_index(i, graph);
-            result(e) = fun(source(e, graph), target(e, graph));
-        });
+        // fun is usually cheap: edges are weighted by tasks of at least 4096 edges
+        parfor(execution::par.with_grain_size(4096).with_serial_cutoff(4096), 0, num_edges(graph),
+               [&graph, &fun, &result](index_t i) {
+                   auto e = edge_from_index(i, graph);
+                   result(e) = fun(source(e, graph), target(e, graph));
+               });
+        return result;
+    };
+
+    /**
+     * Compute edge-weights of a graph from the vertex-weights with a custom edge weighting kernel.
+     *
+     * The vertex weights can be scalar or vectorial (multi-channel): the weight of an edge {x, y} is
+     * kernel(a, b, num_channels) where a and b are pointers to the num_channels contiguous values of the vertex
+     * weights of x and y, of type const T::value_type *. The kernel is a functor (typically a lambda or a struct with
+     * a templated call operator) that is inlined in the parallel loop over the edges: it must be thread safe.
+     *
+     * Example: weight_graph_kernel(graph, vertex_weights, [](const double *a, const double *b, index_t n) {...});
+     *
+     * @tparam result_value_t The value type of the result
+     * @tparam graph_t
+     * @tparam T
+     * @tparam kernel_t
+     * @param graph
+     * @param xvertex_weights
+     * @param kernel
+     * @return an array of weights
+     */
+    template<typename result_value_t = double,
+            typename graph_t,
+            typename T,
+            typename kernel_t>
+    auto weight_graph_kernel(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, const kernel_t &kernel) {
+        HG_TRACE();
+        using value_t = typename T::value_type;
+        const auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+
+        const index_t num_v = num_vertices(graph);
+        const index_t num_channels = (num_v == 0) ? 1 : vertex_weights.size() / num_v;
+        auto result = array_1d<result_value_t>::from_shape({num_edges(graph)});
+        if (num_edges(graph) == 0) {
+            return result;
+        }
+
+        // tasks of at least 4096 edge channels
+        const index_t grain_size = (std::max)((index_t) 1, (index_t) 4096 / num_channels);
+        graph_weights_internal::with_contiguous_data(vertex_weights, [&](const value_t *data) {
+            parfor(execution::par.with_grain_size(grain_size).with_serial_cutoff(grain_size), 0, num_edges(graph),
+                   [&graph, &kernel, &result, data, num_channels](index_t i) {
+                       auto e = edge_from_index(i, graph);
+                       result(i) = static_cast<result_value_t>(kernel(data + source(e, graph) * num_channels,
+                                                                      data + target(e, graph) * num_channels,
+                                                                      num_channels));
+                   });
+        }, xt::has_data_interface<T>());
         return result;
     };
 
+    /**
+     * Signature of a compiled edge weighting kernel (see weight_graph_compiled_kernel): a and b point to the
+     * num_channels values of the extremities of the edge and user_data is the pointer given to
+     * weight_graph_compiled_kernel.
+     */
+    using weight_graph_kernel_callback_t = double (*)(const double *a,
+                                                      const double *b,
+                                                      index_t num_channels,
+                                                      void *user_data);
+
+    /**
+     * Compute edge-weights of a graph from double vertex-weights with a compiled edge weighting kernel given as a
+     * plain C function pointer (typically a function compiled at runtime, see weight_graph_kernel).
+     *
+     * The callback is called concurrently from several threads.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph
+     * @param xvertex_weights vertex weights of type double
+     * @param callback edge weighting kernel
+     * @param user_data pointer passed to each call of the callback
+     * @return an array of weights
+     */
+    template<typename graph_t, typename T>
+    auto weight_graph_compiled_kernel(const graph_t &graph,
+                                      const xt::xexpression<T> &xvertex_weights,
+                                      weight_graph_kernel_callback_t callback,
+                                      void *user_data = nullptr) {
+        static_assert(std::is_same<typename T::value_type, double>::value,
+                      "Vertex weights of a compiled kernel must be of type double.");
+        hg_assert(callback != nullptr, "Invalid edge weighting kernel.");
+        return weight_graph_kernel(graph, xvertex_weights,
+                                   [callback, user_data](const double *a, const double *b, index_t num_channels) {
+                                       return callback(a, b, num_channels, user_data);
+                                   });
+    }
+
+    namespace graph_weights_internal {
+
+        /**
+         * Weights the edges of a graph from vectorial vertex weights with the given operation (see op_L1), with a
+         * kernel instantiated for the common numbers of channels (see dispatch_fixed_width)
+         */
+        template<typename op, typename result_value_t, typename promoted_t, typename graph_t, typename T>
+        auto weight_graph_channels(const graph_t &graph, const T &vertex_weights) {
+            const index_t num_v = num_vertices(graph);
+            const index_t num_channels = (num_v == 0) ? 1 : vertex_weights.size() / num_v;
+            return dispatch_fixed_width(num_channels, [&graph, &vertex_weights](auto width) {
+                return weight_graph_kernel<result_value_t>(
+                        graph, vertex_weights, channel_reduction_kernel<op, promoted_t, decltype(width)>{width});
+            });
+        }
+    }
+
     /**
      * Compute edge-weights of a graph based from the vertex-weights and a predefined weighting function (see weight_functions enum).
      *
-     * Each edge is weighted with a combination of its extremities weights.
+     * Each edge is weighted with a combination of its extremities weights. With vectorial vertex weights, the
+     * distances (L0, L1, L2, L_infinity, L2_squared) are computed with kernels specialized for 1, 2, 3, 4, 8 and 16
+     * channels.
      *
      * @tparam result_value_t The value type of the result
      * @tparam promoted_type The value type used for internal computation
@@ -77,10 +695,10 @@ namespace hg {
     auto weight_graph(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, weight_functions weight) {
         HG_TRACE();
         using vertex_t = typename graph_t::vertex_descriptor;
+        using namespace graph_weights_internal;
         const auto &vertex_weights = xvertex_weights.derived_cast();
         hg_assert_vertex_weights(graph, vertex_weights);
 
-        auto num_v = num_vertices(graph);
         switch (weight) {
             case weight_functions::mean: {
                 hg_assert_1d_array(vertex_weights);
@@ -112,18 +730,7 @@ namespace hg {
             }
             case weight_functions::L0: {
                 if (vertex_weights.dimension() > 1) {
-                    index_t dim = vertex_weights.size() / num_v;
-                    auto view = xt::reshape_view(vertex_weights, {num_v, (size_t)dim});
-                    std::function<result_value_t(vertex_t, vertex_t)> fun = [&view, dim](
-                            vertex_t i,
-                            vertex_t j) -> result_value_t {
-                        for (index_t k = 0; k < dim; k++) {
-                            if (view(i, k) != view(j, k))
-                                return 1;
-                        }
-                        return 0;
-                    };
-                    return weight_graph(graph, fun);
+                    return weight_graph_channels<op_L0, result_value_t, promoted_type>(graph, vertex_weights);
                 } else {
                     std::function<result_value_t(vertex_t, vertex_t)> fun = [&vertex_weights](vertex_t i,
                                                                                               vertex_t j) -> result_value_t {
@@ -134,18 +741,7 @@ namespace hg {
             }
             case weight_functions::L1: {
                 if (vertex_weights.dimension() > 1) {
-                    index_t dim = vertex_weights.size() / num_v;
-                    auto view = xt::reshape_view(vertex_weights, {num_v, (size_t)dim});
-                    std::function<result_value_t(vertex_t, vertex_t)> fun = [&view, dim](
-                            vertex_t i,
-                            vertex_t j) -> result_value_t {
-                        promoted_type res = 0;
-                        for (index_t k = 0; k < dim; k++) {
-                            res += std::abs(static_cast<promoted_type>(view(i, k)) - static_cast<promoted_type>(view(j,k)));
-                        }
-                        return static_cast<result_value_t>(res);
-                    };
-                    return weight_graph(graph, fun);
+                    return weight_graph_channels<op_L1, result_value_t, promoted_type>(graph, vertex_weights);
                 } else {
                     std::function<result_value_t(vertex_t, vertex_t)> fun = [&vertex_weights](vertex_t i,
                                                                                               vertex_t j) -> result_value_t {
@@ -157,19 +753,7 @@ namespace hg {
             }
             case weight_functions::L2: {
                 if (vertex_weights.dimension() > 1) {
-                    index_t dim = vertex_weights.size() / num_v;
-                    auto view = xt::reshape_view(vertex_weights, {num_v, (size_t)dim});
-                    std::function<result_value_t(vertex_t, vertex_t)> fun = [&view, dim](
-                            vertex_t i,
-                            vertex_t j) -> result_value_t {
-                        promoted_type res = 0;
-                        for (index_t k = 0; k < dim; k++) {
-                            auto tmp = static_cast<promoted_type>(view(i, k)) - static_cast<promoted_type>(view(j, k));
-                            res += tmp * tmp;
-                        }
-                        return static_cast<result_value_t>(std::sqrt(res));
-                    };
-                    return weight_graph(graph, fun);
+                    return weight_graph_channels<op_L2, result_value_t, promoted_type>(graph, vertex_weights);
                 } else {
                     std::function<result_value_t(vertex_t, vertex_t)> fun = [&vertex_weights](vertex_t i,
                                                                                               vertex_t j) -> result_value_t {
@@ -183,19 +767,7 @@ namespace hg {
             }
             case weight_functions::L_infinity: {
                 if (vertex_weights.dimension() > 1) {
-                    index_t dim = vertex_weights.size() / num_v;
-                    auto view = xt::reshape_view(vertex_weights, {num_v, (size_t)dim});
-                    std::function<result_value_t(vertex_t, vertex_t)> fun = [&view, dim](
-                            vertex_t i,
-                            vertex_t j) -> result_value_t {
-                        promoted_type res = -1;
-                        for (index_t k = 0; k < dim; k++) {
-                            res = (std::max)(res, std::abs(
-                                    static_cast<promoted_type>(view(i, k)) - static_cast<promoted_type>(view(j, k))));
-                        }
-                        return static_cast<result_value_t>(res);
-                    };
-                    return weight_graph(graph, fun);
+                    return weight_graph_channels<op_L_infinity, result_value_t, promoted_type>(graph, vertex_weights);
                 } else {
                     std::function<result_value_t(vertex_t, vertex_t)> fun = [&vertex_weights](vertex_t i,
                                                                                               vertex_t j) -> result_value_t {
@@ -207,19 +779,7 @@ namespace hg {
             }
             case weight_functions::L2_squared: {
                 if (vertex_weights.dimension() > 1) {
-                    index_t dim = vertex_weights.size() / num_v;
-                    auto view = xt::reshape_view(vertex_weights, {num_v, (size_t)dim});
-                    std::function<result_value_t(vertex_t, vertex_t)> fun = [&view, dim](
-                            vertex_t i,
-                            vertex_t j) -> result_value_t {
-                        promoted_type res = 0;
-                        for (index_t k = 0; k < dim; k++) {
-                            auto tmp = static_cast<promoted_type>(view(i, k)) - static_cast<promoted_type>(view(j, k));
-                            res += tmp * tmp;
-                        }
-                        return static_cast<result_value_t>(res);
-                    };
-                    return weight_graph(graph, fun);
+                    return weight_graph_channels<op_L2_squared, result_value_t, promoted_type>(graph, vertex_weights);
                 } else {
                     std::function<result_value_t(vertex_t, vertex_t)> fun = [&vertex_weights](
                             vertex_t i,
@@ -248,7 +808,77 @@ namespace hg {
                 };
                 return weight_graph(graph, fun);
             }
+            case weight_functions::cosine:
+                return weight_graph_kernel<result_value_t>(
+                        graph, vertex_weights, reduction_kernel<kernel_cosine, promoted_type>());
+            case weight_functions::chi_square:
+                return weight_graph_kernel<result_value_t>(
+                        graph, vertex_weights, reduction_kernel<kernel_chi_square, promoted_type>());
+        }
+        throw std::runtime_error("Unknown weight function.");
+    };
+
+    /**
+     * Compute edge-weights of an implicit 4 adjacency grid graph based from the vertex-weights and a predefined
+     * weighting function (see weight_functions enum).
+     *
+     * Specialization of the generic weight_graph function: edge weights are computed row by row on contiguous
+     * ranges of vertex weights (vectorized when the vertex weights are of type promoted_type: with the runtime
+     * dispatched kernels if HG_HAS_SIMD_DISPATCH is defined, see detail/simd_dispatch.hpp, and otherwise with xsimd
+     * for floating point types). Vertex weights can be scalar or vectorial (multi-channel).
+     *
+     * @tparam result_value_t The value type of the result
+     * @tparam promoted_type The value type used for internal computation
+     * @tparam T
+     * @param graph
+     * @param xvertex_weights
+     * @param weight
+     * @return
+     */
+    template<typename result_value_t = double,
+            typename promoted_type = double,
+            typename T>
+    auto weight_graph(const grid_4_adjacency_graph_2d &graph,
+                      const xt::xexpression<T> &xvertex_weights,
+                      weight_functions weight) {
+        HG_TRACE();
+        using namespace graph_weights_internal;
+        const auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+
+        switch (weight) {
+            case weight_functions::mean:
+                hg_assert_1d_array(vertex_weights);
+                return weight_grid_graph_2d<op_mean, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::min:
+                hg_assert_1d_array(vertex_weights);
+                return weight_grid_graph_2d<op_min, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::max:
+                hg_assert_1d_array(vertex_weights);
+                return weight_grid_graph_2d<op_max, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::L0:
+                return weight_grid_graph_2d<op_L0, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::L1:
+                return weight_grid_graph_2d<op_L1, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::L2:
+                return weight_grid_graph_2d<op_L2, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::L_infinity:
+                return weight_grid_graph_2d<op_L_infinity, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::L2_squared:
+                return weight_grid_graph_2d<op_L2_squared, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::source:
+                hg_assert_1d_array(vertex_weights);
+                return weight_grid_graph_2d<op_source, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::target:
+                hg_assert_1d_array(vertex_weights);
+                return weight_grid_graph_2d<op_target, result_value_t, promoted_type>(graph, vertex_weights);
+            case weight_functions::cosine:
+                return weight_graph_kernel<result_value_t>(
+                        graph, vertex_weights, reduction_kernel<kernel_cosine, promoted_type>());
+            case weight_functions::chi_square:
+                return weight_graph_kernel<result_value_t>(
+                        graph, vertex_weights, reduction_kernel<kernel_chi_square, promoted_type>());
         }
         throw std::runtime_error("Unknown weight function.");
     };
-}
\ No newline at end of file
+}
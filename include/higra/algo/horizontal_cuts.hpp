@@ -73,19 +73,19 @@ namespace hg {
             auto &altitudes = xaltitudes.derived_cast();
             hg_assert_node_weights(tree, altitudes);
 
-            hg_assert(xt::count_nonzero(xt::view(altitudes, xt::range(0, num_leaves(tree))))() == 0,
-                      "The altitude of the leaf nodes must be equal to 0.");
+            hg_assert_content(xt::count_nonzero(xt::view(altitudes, xt::range(0, num_leaves(tree))))() == 0,
+                              "The altitude of the leaf nodes must be equal to 0.");
 
-            hg_assert(xt::all(xt::view(altitudes, xt::range(num_leaves(tree), num_vertices(tree))) >=
-                              static_cast<typename T::value_type>(0)),
-                      "The altitude of the nodes must be greater than or equal to 0.");
+            hg_assert_content(xt::all(xt::view(altitudes, xt::range(num_leaves(tree), num_vertices(tree))) >=
+                                      static_cast<typename T::value_type>(0)),
+                              "The altitude of the nodes must be greater than or equal to 0.");
 
             if (!is_sorted(altitudes)) {
                 m_use_node_map = true;
                 auto res = sort_hierarchy_with_altitudes(tree, altitudes);
                 m_sorted_tree = std::move(res.tree);
                 m_node_map = std::move(res.node_map);
-                m_altitudes = xt::index_view(altitudes, m_node_map);
+                m_altitudes = gather(altitudes, m_node_map);
                 init(m_sorted_tree, m_altitudes);
             } else {
                 m_use_node_map = false;
@@ -118,7 +118,7 @@ namespace hg {
         auto horizontal_cut_from_index(index_t cut_index) const {
             auto num_regions = m_num_regions_cuts[cut_index];
             array_1d<index_t> nodes = array_1d<index_t>::from_shape({(size_t) num_regions});
-            const tree &ct = (m_use_node_map) ? m_sorted_tree : m_original_tree;
+            const tree &ct = explored_tree();
             ct.compute_children();
             if (cut_index == 0) { // special case for single region partition
                 nodes(0) = root(ct);
@@ -135,12 +135,15 @@ namespace hg {
             }
 
             if (m_use_node_map) {
-                nodes = xt::index_view(m_node_map, nodes);
+                nodes = gather(m_node_map, nodes);
             }
             return make_horizontal_cut_nodes(std::move(nodes), m_altitudes_cuts[cut_index]);
         }
 
-        auto horizontal_cut_from_altitude(value_t threshold) const {
+        /**
+         * Index of the cut returned by horizontal_cut_from_altitude(threshold)
+         */
+        index_t cut_index_from_altitude(value_t threshold) const {
             index_t cut_index;
             auto pos = std::upper_bound(m_altitudes_cuts.rbegin(),
                                         m_altitudes_cuts.rend(),
@@ -150,10 +153,13 @@ namespace hg {
             } else {
                 cut_index = std::distance(pos, m_altitudes_cuts.rend());
             }
-            return horizontal_cut_from_index(cut_index);
+            return cut_index;
         }
 
-        auto horizontal_cut_from_num_regions(index_t num_regions, bool at_least = true) const {
+        /**
+         * Index of the cut returned by horizontal_cut_from_num_regions(num_regions, at_least)
+         */
+        index_t cut_index_from_num_regions(index_t num_regions, bool at_least = true) const {
             index_t cut_index;
             auto pos = std::lower_bound(m_num_regions_cuts.begin(),
                                         m_num_regions_cuts.end(),
@@ -168,7 +174,39 @@ namespace hg {
                     cut_index--;
                 }
             }
-            return horizontal_cut_from_index(cut_index);
+            return cut_index;
+        }
+
+        auto horizontal_cut_from_altitude(value_t threshold) const {
+            return horizontal_cut_from_index(cut_index_from_altitude(threshold));
+        }
+
+        auto horizontal_cut_from_num_regions(index_t num_regions, bool at_least = true) const {
+            return horizontal_cut_from_index(cut_index_from_num_regions(num_regions, at_least));
+        }
+
+    protected:
+
+        /**
+         * Tree explored by the cuts: its nodes are sorted by increasing altitudes
+         */
+        const hg::tree &explored_tree() const {
+            return (m_use_node_map) ? m_sorted_tree : m_original_tree;
+        }
+
+        /**
+         * The nodes of the explored tree that are split in the cut of the given index are the nodes whose index is
+         * greater than or equal to the returned value.
+         */
+        index_t first_split_node(index_t cut_index) const {
+            return (cut_index == 0) ? (index_t) num_vertices(explored_tree()) : m_range_nodes_cuts[cut_index].first;
+        }
+
+        /**
+         * Index in the input tree of the given node of the explored tree
+         */
+        index_t original_node(index_t node) const {
+            return (m_use_node_map) ? m_node_map(node) : node;
         }
 
     private:
@@ -232,5 +270,159 @@ namespace hg {
                 std::forward<T>(altitudes));
     }
 
+    /**
+     * Horizontal cut explorer that maintains the labelisation of the leaves of a current cut.
+     *
+     * Moving from the current cut to another one with set_cut_index only relabels the leaves of the regions that
+     * are merged or split between the two cuts: the leaves are stored in depth first order so that the leaves of
+     * any node form a contiguous range. The label of a leaf in the current cut is then available in constant time
+     * and labelisation_leaves() is equal to horizontal_cut_from_index(cut_index()).labelisation_leaves(tree).
+     *
+     * The initial cut is the cut of index 0 (single region partition).
+     *
+     * @tparam tree_t
+     * @tparam value_t
+     */
+    template<typename tree_t, typename value_t>
+    class horizontal_cut_navigator : public horizontal_cut_explorer<tree_t, value_t> {
+    public:
+        using base_type = horizontal_cut_explorer<tree_t, value_t>;
+
+        template<typename T>
+        horizontal_cut_navigator(const tree_t &tree, const xt::xexpression<T> &xaltitudes):
+                base_type(tree, xaltitudes) {
+            const hg::tree &ct = this->explored_tree();
+            ct.compute_children();
+            const index_t num_nodes = num_vertices(ct);
+            const index_t num_leaves_tree = num_leaves(ct);
+
+            // leaves of the subtree of each node: [m_leaf_range_start(n), m_leaf_range_end(n)[ in m_leaves_dfs
+            m_leaf_range_start = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            m_leaf_range_end = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            array_1d<index_t> num_leaves_subtree = xt::zeros<index_t>({(size_t) num_nodes});
+            xt::view(num_leaves_subtree, xt::range(0, num_leaves_tree)) = 1;
+            for (index_t i = 0; i < num_nodes - 1; i++) {
+                num_leaves_subtree(parent(i, ct)) += num_leaves_subtree(i);
+            }
+            m_leaf_range_start(num_nodes - 1) = 0;
+            for (index_t i = num_nodes - 1; i >= num_leaves_tree; i--) {
+                index_t start = m_leaf_range_start(i);
+                for (auto c: children_iterator(i, ct)) {
+                    m_leaf_range_start(c) = start;
+                    start += num_leaves_subtree(c);
+                }
+            }
+            m_leaf_range_end = m_leaf_range_start + num_leaves_subtree;
+
+            m_leaves_dfs = array_1d<index_t>::from_shape({(size_t) num_leaves_tree});
+            for (index_t i = 0; i < num_leaves_tree; i++) {
+                m_leaves_dfs(m_leaf_range_start(i)) = i;
+            }
+
+            m_cut_index = 0;
+            m_labels = array_1d<index_t>::from_shape({(size_t) num_leaves_tree});
+            relabel_leaves(root(ct));
+        }
+
+        /**
+         * Index of the current cut
+         */
+        index_t cut_index() const {
+            return m_cut_index;
+        }
+
+        /**
+         * Changes the current cut.
+         *
+         * Only the leaves of the regions of the new cut that are not regions of the previous cut are relabelled.
+         *
+         * @param cut_index index of the new cut
+         */
+        void set_cut_index(index_t cut_index) {
+            hg_assert(cut_index >= 0 && cut_index < (index_t) this->num_cuts(), "Invalid cut index.");
+            const hg::tree &ct = this->explored_tree();
+            const index_t first_split = this->first_split_node(cut_index);
+            const index_t previous_first_split = this->first_split_node(m_cut_index);
+
+            if (cut_index > m_cut_index) {
+                // nodes split since the previous cut: their non split children are the new regions
+                for (index_t n = first_split; n < previous_first_split; n++) {
+                    for (auto c: children_iterator(n, ct)) {
+                        if (c < first_split) {
+                            relabel_leaves(c);
+                        }
+                    }
+                }
+            } else if (cut_index < m_cut_index) {
+                // nodes merged since the previous cut: the new regions are the ones whose parent is still split
+                const index_t root_node = root(ct);
+                for (index_t n = previous_first_split; n < first_split; n++) {
+                    if (n == root_node || parent(n, ct) >= first_split) {
+                        relabel_leaves(n);
+                    }
+                }
+            }
+            m_cut_index = cut_index;
+        }
+
+        /**
+         * Changes the current cut to the one returned by horizontal_cut_from_altitude(threshold)
+         */
+        void set_cut_from_altitude(value_t threshold) {
+            set_cut_index(this->cut_index_from_altitude(threshold));
+        }
+
+        /**
+         * Changes the current cut to the one returned by horizontal_cut_from_num_regions(num_regions, at_least)
+         */
+        void set_cut_from_num_regions(index_t num_regions, bool at_least = true) {
+            set_cut_index(this->cut_index_from_num_regions(num_regions, at_least));
+        }
+
+        /**
+         * Nodes of the current cut
+         */
+        auto horizontal_cut() const {
+            return this->horizontal_cut_from_index(m_cut_index);
+        }
+
+        /**
+         * Label of the given leaf in the current cut: index of the node of the current cut containing the leaf
+         */
+        index_t label_leaf(index_t leaf) const {
+            return m_labels(leaf);
+        }
+
+        /**
+         * Labelisation of the leaves of the tree by the current cut: each leaf is labelled by the index of the node
+         * of the current cut containing it.
+         */
+        const array_1d<index_t> &labelisation_leaves() const {
+            return m_labels;
+        }
+
+    private:
+
+        void relabel_leaves(index_t node) {
+            const index_t label = this->original_node(node);
+            for (index_t i = m_leaf_range_start(node); i < m_leaf_range_end(node); i++) {
+                m_labels(m_leaves_dfs(i)) = label;
+            }
+        }
+
+        index_t m_cut_index;
+        array_1d<index_t> m_labels;
+        array_1d<index_t> m_leaves_dfs;
+        array_1d<index_t> m_leaf_range_start;
+        array_1d<index_t> m_leaf_range_end;
+    };
+
+    template<typename tree_t, typename T>
+    decltype(auto) make_horizontal_cut_navigator(tree_t &&tree, T &&altitudes) {
+        return horizontal_cut_navigator<tree_t, typename std::decay_t<T>::value_type>(
+                std::forward<tree_t>(tree),
+                std::forward<T>(altitudes));
+    }
+
 
 }
@@ -0,0 +1,389 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../detail/simd_dispatch.hpp"
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+namespace hg {
+
+    namespace knn_graph_internal {
+
+        /**
+         * Squared Euclidean distance between the points a and b of dimension dim.
+         */
+        template<typename value_t>
+        HG_SIMD_DISPATCH
+        value_t squared_euclidean_distance(const value_t *a, const value_t *b, index_t dim) {
+            value_t res = 0;
+            for (index_t i = 0; i < dim; i++) {
+                value_t d = a[i] - b[i];
+                res += d * d;
+            }
+            return res;
+        }
+
+        /**
+         * Bounded max heaps of the k nearest neighbours found so far of each point (flat arrays of size n * k, the
+         * farthest neighbour of the point v is at position v * k). Free slots have an infinite distance.
+         *
+         * A neighbour is flagged as new until it has been used once in the local join of NN-descent.
+         */
+        template<typename value_t>
+        struct neighbour_heaps {
+            neighbour_heaps(index_t num_points, index_t k) :
+                    k(k),
+                    distances(num_points * k, std::numeric_limits<value_t>::infinity()),
+                    indices(num_points * k, invalid_index),
+                    is_new(num_points * k, false) {
+            }
+
+            /**
+             * Inserts the neighbour u at distance d of v if it is closer than the farthest neighbour of v and is
+             * not already a neighbour of v.
+             *
+             * @return true if the neighbours of v have changed
+             */
+            bool push(index_t v, index_t u, value_t d) {
+                value_t *dist = &distances[v * k];
+                index_t *ind = &indices[v * k];
+                char *flag = &is_new[v * k];
+                if (!(d < dist[0])) {
+                    return false;
+                }
+                for (index_t i = 0; i < k; i++) {
+                    if (ind[i] == u) {
+                        return false;
+                    }
+                }
+                // sift down from the root
+                index_t i = 0;
+                while (true) {
+                    index_t child = 2 * i + 1;
+                    if (child >= k) {
+                        break;
+                    }
+                    if (child + 1 < k && dist[child] < dist[child + 1]) {
+                        child++;
+                    }
+                    if (!(d < dist[child])) {
+                        break;
+                    }
+                    dist[i] = dist[child];
+                    ind[i] = ind[child];
+                    flag[i] = flag[child];
+                    i = child;
+                }
+                dist[i] = d;
+                ind[i] = u;
+                flag[i] = true;
+                return true;
+            }
+
+            index_t k;
+            std::vector<value_t> distances;
+            std::vector<index_t> indices;
+            std::vector<char> is_new;
+        };
+
+        /**
+         * Adds u to the candidate list of v (of capacity max_size), with reservoir sampling if the list is full.
+         */
+        template<typename rng_t>
+        void add_candidate(std::vector<index_t> &candidates,
+                           std::vector<index_t> &num_candidates,
+                           std::vector<index_t> &num_seen,
+                           index_t v,
+                           index_t u,
+                           index_t max_size,
+                           rng_t &rng) {
+            index_t seen = num_seen[v]++;
+            if (num_candidates[v] < max_size) {
+                candidates[v * max_size + num_candidates[v]++] = u;
+            } else {
+                index_t r = std::uniform_int_distribution<index_t>(0, seen)(rng);
+                if (r < max_size) {
+                    candidates[v * max_size + r] = u;
+                }
+            }
+        }
+
+        /**
+         * Pointer to the points stored contiguously in row major order with the type point_t: the points are
+         * copied in buffer if needed.
+         */
+        template<typename point_t, typename T>
+        const point_t *contiguous_points(const T &points, array_2d<point_t> &buffer, std::true_type) {
+            if (std::is_same<typename T::value_type, point_t>::value &&
+                points.layout() == xt::layout_type::row_major) {
+                return reinterpret_cast<const point_t *>(points.data() + points.data_offset());
+            }
+            buffer = points;
+            return buffer.data();
+        }
+
+        template<typename point_t, typename T>
+        const point_t *contiguous_points(const T &points, array_2d<point_t> &buffer, std::false_type) {
+            buffer = points;
+            return buffer.data();
+        }
+
+        /**
+         * NN-descent iterations, see approximate_knn_graph
+         */
+        template<typename value_t>
+        auto nn_descent(const value_t *points,
+                        index_t num_points,
+                        index_t dim,
+                        index_t k,
+                        index_t max_iterations,
+                        double sample_rate,
+                        double delta,
+                        unsigned int seed) {
+            neighbour_heaps<value_t> heaps(num_points, k);
+            auto distance = [points, dim](index_t u, index_t v) {
+                return squared_euclidean_distance(points + u * dim, points + v * dim, dim);
+            };
+
+            // random initial neighbours
+            std::mt19937_64 rng(seed);
+            std::uniform_int_distribution<index_t> random_point(0, num_points - 1);
+            for (index_t v = 0; v < num_points; v++) {
+                for (index_t n = 0; n < k;) {
+                    index_t u = random_point(rng);
+                    if (u != v && heaps.push(v, u, distance(u, v))) {
+                        n++;
+                    }
+                }
+            }
+
+            // the candidates of each point are sampled among its new neighbours, its old neighbours, and the
+            // points having it as new or old candidate (reverse neighbours), each list has at most sample_size
+            // elements
+            const index_t sample_size = (std::max)((index_t) 1, (index_t) std::ceil(sample_rate * k));
+            std::vector<index_t> new_candidates(num_points * sample_size);
+            std::vector<index_t> old_candidates(num_points * sample_size);
+            std::vector<index_t> reverse_new(num_points * sample_size);
+            std::vector<index_t> reverse_old(num_points * sample_size);
+            std::vector<index_t> num_new(num_points);
+            std::vector<index_t> num_old(num_points);
+            std::vector<index_t> num_reverse_new(num_points);
+            std::vector<index_t> num_reverse_old(num_points);
+            std::vector<index_t> num_new_seen(num_points);
+            std::vector<index_t> num_old_seen(num_points);
+            std::vector<index_t> new_positions;
+            std::vector<index_t> num_updates(num_points);
+
+            // the heaps of the points are protected by a fixed number of striped locks
+            const index_t num_locks = (std::min)(num_points, (index_t) 4096);
+            std::vector<std::mutex> locks(num_locks);
+            auto update = [&heaps, &locks, num_locks](index_t v, index_t u, value_t d) {
+                std::lock_guard<std::mutex> lock(locks[v % num_locks]);
+                return heaps.push(v, u, d);
+            };
+
+            for (index_t iteration = 0; iteration < max_iterations; iteration++) {
+                std::fill(num_old.begin(), num_old.end(), 0);
+                std::fill(num_old_seen.begin(), num_old_seen.end(), 0);
+
+                // sampling of the new neighbours, which are then flagged as old, and of the old neighbours
+                for (index_t v = 0; v < num_points; v++) {
+                    new_positions.clear();
+                    for (index_t i = v * k; i < (v + 1) * k; i++) {
+                        index_t u = heaps.indices[i];
+                        if (u == invalid_index) {
+                            continue;
+                        }
+                        if (heaps.is_new[i]) {
+                            new_positions.push_back(i);
+                        } else {
+                            add_candidate(old_candidates, num_old, num_old_seen, v, u, sample_size, rng);
+                        }
+                    }
+                    index_t n = (std::min)(sample_size, (index_t) new_positions.size());
+                    for (index_t j = 0; j < n; j++) {
+                        index_t r = std::uniform_int_distribution<index_t>(j, new_positions.size() - 1)(rng);
+                        std::swap(new_positions[j], new_positions[r]);
+                        new_candidates[v * sample_size + j] = heaps.indices[new_positions[j]];
+                        heaps.is_new[new_positions[j]] = false;
+                    }
+                    num_new[v] = n;
+                }
+
+                // sampling of the reverse neighbours
+                std::fill(num_reverse_new.begin(), num_reverse_new.end(), 0);
+                std::fill(num_reverse_old.begin(), num_reverse_old.end(), 0);
+                std::fill(num_new_seen.begin(), num_new_seen.end(), 0);
+                std::fill(num_old_seen.begin(), num_old_seen.end(), 0);
+                std::fill(num_old_seen.begin(), num_old_seen.end(), 0);
+                for (index_t v = 0; v < num_points; v++) {
+                    for (index_t i = 0; i < num_new[v]; i++) {
+                        add_candidate(reverse_new, num_reverse_new, num_new_seen, new_candidates[v * sample_size + i],
+                                      v, sample_size, rng);
+                    }
+                    for (index_t i = 0; i < num_old[v]; i++) {
+                        add_candidate(reverse_old, num_reverse_old, num_old_seen, old_candidates[v * sample_size + i],
+                                      v, sample_size, rng);
+                    }
+                }
+
+                // local join: the new candidates of each point are compared with each other and with its old
+                // candidates
+                parfor(0, num_points, [&](index_t v) {
+                    std::vector<index_t> new_list(new_candidates.begin() + v * sample_size,
+                                                  new_candidates.begin() + v * sample_size + num_new[v]);
+                    new_list.insert(new_list.end(), reverse_new.begin() + v * sample_size,
+                                    reverse_new.begin() + v * sample_size + num_reverse_new[v]);
+                    std::vector<index_t> old_list(old_candidates.begin() + v * sample_size,
+                                                  old_candidates.begin() + v * sample_size + num_old[v]);
+                    old_list.insert(old_list.end(), reverse_old.begin() + v * sample_size,
+                                    reverse_old.begin() + v * sample_size + num_reverse_old[v]);
+
+                    index_t updates = 0;
+                    for (index_t i = 0; i < (index_t) new_list.size(); i++) {
+                        index_t u1 = new_list[i];
+                        for (index_t j = i + 1; j < (index_t) new_list.size(); j++) {
+                            index_t u2 = new_list[j];
+                            if (u1 != u2) {
+                                value_t d = distance(u1, u2);
+                                updates += update(u1, u2, d) + update(u2, u1, d);
+                            }
+                        }
+                        for (auto u2: old_list) {
+                            if (u1 != u2) {
+                                value_t d = distance(u1, u2);
+                                updates += update(u1, u2, d) + update(u2, u1, d);
+                            }
+                        }
+                    }
+                    num_updates[v] = updates;
+                });
+
+                index_t total_updates = std::accumulate(num_updates.begin(), num_updates.end(), (index_t) 0);
+                if (total_updates <= delta * num_points * k) {
+                    break;
+                }
+            }
+            return heaps;
+        }
+    }
+
+    /**
+     * Approximate symmetric k-nearest neighbour graph of a set of points, for the Euclidean distance, computed with
+     * the NN-descent algorithm:
+     *
+     *   W. Dong, M. Charikar, K. Li. Efficient k-nearest neighbor graph construction for generic similarity
+     *   measures. In, 20th International Conference on World Wide Web, WWW 2011.
+     *
+     * Starting from random neighbours, the k nearest neighbours of each point are iteratively refined by comparing
+     * the neighbours of the neighbours of each point (local join, parallelized over the points). The algorithm stops
+     * after max_iterations iterations or when less than delta * num_points * k neighbours have changed during an
+     * iteration. Distances are computed with vectorized kernels (see detail/simd_dispatch.hpp).
+     *
+     * The graph contains an edge {x, y} if y is one of the approximate k nearest neighbours of x or if x is one of
+     * the approximate k nearest neighbours of y (the graph may have several connected components). The edges
+     * adjacent to a vertex are sorted by increasing neighbour index. The weight of an edge is the Euclidean distance
+     * between its extremities.
+     *
+     * Points of floating point types are processed directly when they are stored contiguously in row major order,
+     * other points are first converted to double.
+     *
+     * @tparam T
+     * @param xpoints 2d array of shape (num_points, dimension)
+     * @param num_neighbours number of neighbours k of each point (limited to num_points - 1)
+     * @param max_iterations maximum number of iterations
+     * @param sample_rate proportion of the neighbours sampled in each iteration (lower values reduce the cost of an
+     * iteration and the accuracy of the result)
+     * @param delta relative number of updates below which the algorithm stops
+     * @param seed seed of the random number generator
+     * @return a pair (ugraph, array_1d) representing the graph and its edge weights
+     */
+    template<typename T>
+    auto approximate_knn_graph(const xt::xexpression<T> &xpoints,
+                               index_t num_neighbours,
+                               index_t max_iterations = 12,
+                               double sample_rate = 1,
+                               double delta = 0.001,
+                               unsigned int seed = 42) {
+        HG_TRACE();
+        auto &points = xpoints.derived_cast();
+        hg_assert(points.dimension() == 2, "Points must be a 2d array.");
+        hg_assert(num_neighbours > 0, "Number of neighbours must be positive.");
+        hg_assert(sample_rate > 0 && sample_rate <= 1, "Sample rate must be in ]0, 1].");
+        using value_type = typename T::value_type;
+        using point_t = std::conditional_t<std::is_floating_point<value_type>::value, value_type, double>;
+
+        const index_t num_points = points.shape()[0];
+        const index_t dim = points.shape()[1];
+        const index_t k = (std::min)(num_neighbours, num_points - 1);
+        if (k <= 0) {
+            return std::make_pair(ugraph(num_points), array_1d<point_t>::from_shape({0}));
+        }
+
+        array_2d<point_t> buffer;
+        const point_t *data = knn_graph_internal::contiguous_points(points, buffer, xt::has_data_interface<T>());
+
+        auto heaps = knn_graph_internal::nn_descent(data, num_points, dim, k, max_iterations, sample_rate, delta,
+                                                    seed);
+
+        // symmetrization: the arc (v, u) gives an edge if v < u or if (u, v) is not an arc
+        auto is_arc = [&heaps, k](index_t v, index_t u) {
+            for (index_t i = v * k; i < (v + 1) * k; i++) {
+                if (heaps.indices[i] == u) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        parfor(0, num_points, [&heaps, k](index_t v) {
+            std::sort(heaps.indices.begin() + v * k, heaps.indices.begin() + (v + 1) * k);
+        });
+        std::vector<index_t> num_edges_per_vertex(num_points + 1, 0);
+        parfor(0, num_points, [&](index_t v) {
+            const index_t *begin = &heaps.indices[v * k];
+            index_t n = 0;
+            for (index_t i = 0; i < k; i++) {
+                index_t u = begin[i];
+                if (u != invalid_index && (v < u || !is_arc(u, v))) {
+                    n++;
+                }
+            }
+            num_edges_per_vertex[v + 1] = n;
+        });
+        std::partial_sum(num_edges_per_vertex.begin(), num_edges_per_vertex.end(), num_edges_per_vertex.begin());
+        const index_t num_edges = num_edges_per_vertex[num_points];
+
+        array_1d<index_t> sources = array_1d<index_t>::from_shape({(size_t) num_edges});
+        array_1d<index_t> targets = array_1d<index_t>::from_shape({(size_t) num_edges});
+        array_1d<point_t> edge_weights = array_1d<point_t>::from_shape({(size_t) num_edges});
+        parfor(0, num_points, [&](index_t v) {
+            index_t e = num_edges_per_vertex[v];
+            for (index_t i = v * k; i < (v + 1) * k; i++) {
+                index_t u = heaps.indices[i];
+                if (u != invalid_index && (v < u || !is_arc(u, v))) {
+                    sources(e) = v;
+                    targets(e) = u;
+                    edge_weights(e) = std::sqrt(knn_graph_internal::squared_euclidean_distance(
+                            data + v * dim, data + u * dim, dim));
+                    e++;
+                }
+            }
+        });
+
+        ugraph graph(num_points, num_edges, 2 * k);
+        add_edges(sources, targets, graph);
+        return std::make_pair(std::move(graph), std::move(edge_weights));
+    }
+}
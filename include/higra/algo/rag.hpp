@@ -10,10 +10,15 @@
 
 #pragma once
 
+#include "../detail/memory_tracking.hpp"
 #include "xtensor/xsort.hpp"
 
 #include "../graph.hpp"
 #include "../accumulator/at_accumulator.hpp"
+#include "graph_core.hpp"
+#include <numeric>
+#include <tuple>
+#include <memory>
 
 
 namespace hg {
@@ -39,6 +44,240 @@ namespace hg {
         array_1d<index_t> edge_map;
     };
 
+    /**
+     * Result of the region adjacency graph construction algorithms with accumulation of the vertex and edge weights
+     * of the original graph (see make_region_adjacency_graph_from_labelisation)
+     *
+     * @tparam vertex_values_t
+     * @tparam edge_values_t
+     */
+    template<typename vertex_values_t, typename edge_values_t>
+    struct accumulated_region_adjacency_graph : public region_adjacency_graph {
+
+        accumulated_region_adjacency_graph(region_adjacency_graph &&rag,
+                                           vertex_values_t &&vertex_values,
+                                           edge_values_t &&edge_values) :
+                region_adjacency_graph(std::move(rag)),
+                vertex_values(std::move(vertex_values)),
+                edge_values(std::move(edge_values)) {}
+
+        /**
+         * Tuple of rag vertex weights: the i-th element is the result of the i-th vertex accumulator
+         */
+        vertex_values_t vertex_values;
+
+        /**
+         * Tuple of rag edge weights: the i-th element is the result of the i-th edge accumulator
+         */
+        edge_values_t edge_values;
+    };
+
+    namespace rag_internal {
+
+        /**
+         * Sequential region adjacency graph construction: the regions are the connected components of the subgraph
+         * made of the edges satisfying connected(e). Regions are explored one after the other by a graph traversal
+         * and numbered in the order of their vertex of smallest index. The rag edges of a region towards the regions
+         * of smaller indices are created, in order of discovery, during its traversal.
+         */
+        template<typename graph_t, typename predicate_t>
+        auto make_region_adjacency_graph_sequential(const graph_t &graph, const predicate_t &connected) {
+            ugraph rag;
+
+            array_1d<index_t> vertex_map({num_vertices(graph)}, invalid_index);
+            array_1d<index_t> edge_map({num_edges(graph)}, invalid_index);
+
+            index_t num_regions = 0;
+            index_t num_edges = 0;
+
+            std::vector<index_t> canonical_edge_indexes;
+
+            stackv<index_t> s;
+
+            auto explore_component =
+                    [&s, &graph, &connected, &rag, &vertex_map, &edge_map, &num_regions, &num_edges,
+                            &canonical_edge_indexes]
+                            (index_t start_vertex) {
+                        s.push(start_vertex);
+                        vertex_map[start_vertex] = num_regions;
+                        canonical_edge_indexes.push_back(-1);
+                        add_vertex(rag);
+                        auto lowest_edge = num_edges;
+                        while (!s.empty()) {
+                            auto v = s.top();
+                            s.pop();
+
+                            for (auto e: out_edge_iterator(v, graph)) {
+                                auto adjv = target(e, graph);
+                                if (connected(e)) {
+                                    if (vertex_map[adjv] == invalid_index) {
+                                        vertex_map[adjv] = num_regions;
+                                        s.push(adjv);
+                                    }
+                                } else {
+                                    if (vertex_map[adjv] != invalid_index) {
+                                        auto num_region_adjacent = vertex_map[adjv];
+                                        if (canonical_edge_indexes[num_region_adjacent] < lowest_edge) {
+                                            add_edge(num_region_adjacent, num_regions, rag);
+                                            edge_map(e) = num_edges;
+                                            canonical_edge_indexes[num_region_adjacent] = num_edges;
+                                            num_edges++;
+                                        } else {
+                                            edge_map(e) = canonical_edge_indexes[num_region_adjacent];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                        num_regions++;
+                    };
+
+
+            for (auto v: vertex_iterator(graph)) {
+                if (vertex_map[v] != invalid_index)
+                    continue;
+                explore_component(v);
+
+            }
+
+            return region_adjacency_graph{std::move(rag), std::move(vertex_map), std::move(edge_map)};
+        }
+
+        /**
+         * Accumulation of the weights of the elements (vertices or edges) of the original graph into the
+         * num_rag_elements elements of the rag (see accumulate_at): several rag_element_accumulators can share the
+         * same scan of a rag map.
+         */
+        template<typename T, typename accumulator_t>
+        struct rag_element_accumulator {
+            using value_type = typename T::value_type;
+
+            rag_element_accumulator(const T &weights, const accumulator_t &accumulator, index_t num_rag_elements) :
+                    m_scalar(accumulator_detail::use_scalar_views(accumulator, weights.dimension())),
+                    m_scalar_input(weights),
+                    m_vectorial_input(weights) {
+                auto data_shape = std::vector<size_t>(weights.shape().begin() + 1, weights.shape().end());
+                auto output_shape = accumulator.get_output_shape(data_shape);
+                output_shape.insert(output_shape.begin(), (size_t) num_rag_elements);
+                m_result = array_nd<value_type>::from_shape(output_shape);
+                if (m_scalar) {
+                    initialize(accumulator, num_rag_elements, m_scalar_accs, std::false_type());
+                } else {
+                    initialize(accumulator, num_rag_elements, m_vectorial_accs, std::true_type());
+                }
+            }
+
+            void accumulate(index_t element, index_t rag_element) {
+                if (m_scalar) {
+                    m_scalar_input.set_position(element);
+                    m_scalar_accs[rag_element].accumulate(m_scalar_input.begin());
+                } else {
+                    m_vectorial_input.set_position(element);
+                    m_vectorial_accs[rag_element].accumulate(m_vectorial_input.begin());
+                }
+            }
+
+            array_nd<value_type> result() {
+                for (auto &acc: m_scalar_accs) {
+                    acc.finalize();
+                }
+                for (auto &acc: m_vectorial_accs) {
+                    acc.finalize();
+                }
+                return std::move(m_result);
+            }
+
+        private:
+
+            template<bool vectorial>
+            using acc_t = decltype(std::declval<const accumulator_t &>().template make_accumulator<vectorial>(
+                    std::declval<decltype(make_light_axis_view<vectorial>(
+                            std::declval<array_nd<value_type> &>())) &>()));
+
+            template<typename accs_t, bool vectorial>
+            void initialize(const accumulator_t &accumulator, index_t num_rag_elements, accs_t &accs,
+                            std::integral_constant<bool, vectorial>) {
+                auto output_view = make_light_axis_view<vectorial>(m_result);
+                accs.reserve(num_rag_elements);
+                for (index_t i = 0; i < num_rag_elements; ++i) {
+                    output_view.set_position(i);
+                    accs.push_back(accumulator.template make_accumulator<vectorial>(output_view));
+                    accs[i].initialize();
+                }
+            }
+
+            bool m_scalar;
+            details::light_axis_view<false, const T> m_scalar_input;
+            details::light_axis_view<true, const T> m_vectorial_input;
+            array_nd<value_type> m_result;
+            std::vector<acc_t<false>> m_scalar_accs;
+            std::vector<acc_t<true>> m_vectorial_accs;
+        };
+
+        /**
+         * Accumulates the given weights with each of the given accumulators in a single scan of the rag map.
+         *
+         * @return a tuple of arrays: the i-th array is the result of the i-th accumulator
+         */
+        template<typename T, typename... accumulators_t, std::size_t... I>
+        auto rag_accumulate_multiple(const array_1d<index_t> &rag_map,
+                                     index_t num_rag_elements,
+                                     const T &weights,
+                                     const std::tuple<accumulators_t...> &accumulators,
+                                     std::index_sequence<I...>) {
+            hg_assert(weights.shape()[0] == rag_map.size(), "Weights dimension does not match rag map dimension.");
+            // accumulators refer to their output storage: they are allocated once and never moved
+            auto accs = std::make_tuple(std::make_unique<rag_element_accumulator<T, accumulators_t>>(
+                    weights, std::get<I>(accumulators), num_rag_elements)...);
+            const index_t map_size = rag_map.size();
+            for (index_t i = 0; i < map_size; ++i) {
+                const index_t rag_element = rag_map.data()[i];
+                if (rag_element != invalid_index) {
+                    (void) std::initializer_list<int>{(std::get<I>(accs)->accumulate(i, rag_element), 0)...};
+                }
+            }
+            return std::make_tuple(std::get<I>(accs)->result()...);
+        }
+
+        /**
+         * No accumulator: nothing to scan.
+         */
+        template<typename T>
+        auto rag_accumulate_multiple(const array_1d<index_t> &rag_map,
+                                     index_t,
+                                     const T &weights,
+                                     const std::tuple<> &,
+                                     std::index_sequence<>) {
+            hg_assert(weights.shape()[0] == rag_map.size(), "Weights dimension does not match rag map dimension.");
+            return std::tuple<>();
+        }
+
+        /**
+         * Builds the rag with make_region_adjacency_graph_sequential and accumulates the vertex and edge weights of
+         * the original graph on the rag vertices and edges with one scan of the vertex map and one scan of the edge
+         * map.
+         */
+        template<typename graph_t, typename predicate_t,
+                typename T1, typename... vertex_accumulators_t,
+                typename T2, typename... edge_accumulators_t>
+        auto make_region_adjacency_graph_accumulate(const graph_t &graph,
+                                                    const predicate_t &connected,
+                                                    const T1 &vertex_weights,
+                                                    const std::tuple<vertex_accumulators_t...> &vertex_accumulators,
+                                                    const T2 &edge_weights,
+                                                    const std::tuple<edge_accumulators_t...> &edge_accumulators) {
+            auto rag = make_region_adjacency_graph_sequential(graph, connected);
+            auto vertex_values = rag_accumulate_multiple(rag.vertex_map, num_vertices(rag.rag),
+                                                         vertex_weights, vertex_accumulators,
+                                                         std::index_sequence_for<vertex_accumulators_t...>());
+            auto edge_values = rag_accumulate_multiple(rag.edge_map, num_edges(rag.rag),
+                                                       edge_weights, edge_accumulators,
+                                                       std::index_sequence_for<edge_accumulators_t...>());
+            return accumulated_region_adjacency_graph<decltype(vertex_values), decltype(edge_values)>{
+                    std::move(rag), std::move(vertex_values), std::move(edge_values)};
+        }
+    }
+
     /**
      * Construct a region adjacency graph from a vertex labeled graph in linear time.
      * @tparam graph_t
@@ -56,74 +295,17 @@ namespace hg {
         hg_assert_1d_array(vertex_labels);
         hg_assert_integral_value_type(vertex_labels);
 
-        ugraph rag;
-
-        array_1d<index_t> vertex_map({num_vertices(graph)}, invalid_index);
-        array_1d<index_t> edge_map({num_edges(graph)}, invalid_index);
-
-        index_t num_regions = 0;
-        index_t num_edges = 0;
-
-        std::vector<index_t> canonical_edge_indexes;
-
-        stackv<index_t> s;
-
-        auto explore_component =
-                [&s, &graph, &vertex_labels, &rag, &vertex_map, &edge_map, &num_regions, &num_edges, &canonical_edge_indexes]
-                        (index_t start_vertex) {
-
-                    auto label_region = vertex_labels[start_vertex];
-                    s.push(start_vertex);
-                    vertex_map[start_vertex] = num_regions;
-                    canonical_edge_indexes.push_back(-1);
-                    add_vertex(rag);
-                    auto lowest_edge = num_edges;
-                    while (!s.empty()) {
-                        auto v = s.top();
-                        s.pop();
-
-                        for (auto e: out_edge_iterator(v, graph)) {
-                            auto adjv = target(e, graph);
-                            if (vertex_labels[adjv] == label_region) {
-                                if (vertex_map[adjv] == invalid_index) {
-                                    vertex_map[adjv] = num_regions;
-                                    s.push(adjv);
-                                }
-                            } else {
-                                if (vertex_map[adjv] != invalid_index) {
-                                    auto num_region_adjacent = vertex_map[adjv];
-                                    if (canonical_edge_indexes[num_region_adjacent] < lowest_edge) {
-                                        add_edge(num_region_adjacent, num_regions, rag);
-                                        edge_map(e) = num_edges;
-                                        canonical_edge_indexes[num_region_adjacent] = num_edges;
-                                        num_edges++;
-                                    } else {
-                                        edge_map(e) = canonical_edge_indexes[num_region_adjacent];
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    num_regions++;
-                };
-
-
-        for (auto v: vertex_iterator(graph)) {
-            if (vertex_map[v] != invalid_index)
-                continue;
-            explore_component(v);
-
-        }
-
-        return region_adjacency_graph{std::move(rag), std::move(vertex_map), std::move(edge_map)};
+        return rag_internal::make_region_adjacency_graph_sequential(
+                graph,
+                [&graph, &vertex_labels](const auto &e) {
+                    return vertex_labels(source(e, graph)) == vertex_labels(target(e, graph));
+                });
     }
 
     /**
      * Construct a region adjacency graph from a graph cut in linear time.
      * Any edge with weight different from 0 belongs to the cut.
      *
-     * TODO factorize method with  make_region_adjacency_graph_from_labelisation
-     *
      * @tparam graph_t
      * @tparam T
      * @param graph
@@ -138,67 +320,228 @@ namespace hg {
         hg_assert_edge_weights(graph, edge_weights);
         hg_assert_1d_array(edge_weights);
 
-        ugraph rag;
+        return rag_internal::make_region_adjacency_graph_sequential(
+                graph,
+                [&graph, &edge_weights](const auto &e) {
+                    return edge_weights(index(e, graph)) == 0;
+                });
+    }
 
-        array_1d<index_t> vertex_map({num_vertices(graph)}, invalid_index);
-        array_1d<index_t> edge_map({num_edges(graph)}, invalid_index);
+    /**
+     * Construct a region adjacency graph from a vertex labeled graph and accumulates the vertex and edge weights of
+     * the graph on the vertices and edges of the region adjacency graph.
+     *
+     * The result is identical to the one of make_region_adjacency_graph_from_labelisation followed by a call to
+     * rag_accumulate(vertex_map, vertex_weights, accumulator) for each vertex accumulator and to
+     * rag_accumulate(edge_map, edge_weights, accumulator) for each edge accumulator, but all the vertex
+     * (resp. edge) accumulators share a single scan of the vertex (resp. edge) map.
+     *
+     * Example:
+     *
+     *      auto res = make_region_adjacency_graph_from_labelisation(
+     *              graph, labels,
+     *              vertex_weights, std::make_tuple(accumulator_sum(), accumulator_counter()),
+     *              edge_weights, std::make_tuple(accumulator_min(), accumulator_max()));
+     *      auto &region_sums = std::get<0>(res.vertex_values);
+     *      auto &rag_edge_max = std::get<1>(res.edge_values);
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @tparam T1
+     * @tparam vertex_accumulators_t
+     * @tparam T2
+     * @tparam edge_accumulators_t
+     * @param graph
+     * @param xvertex_labels
+     * @param xvertex_weights weights of the graph vertices (first dimension equal to the number of vertices)
+     * @param vertex_accumulators tuple of accumulators applied to the vertex weights (may be empty)
+     * @param xedge_weights weights of the graph edges (first dimension equal to the number of edges)
+     * @param edge_accumulators tuple of accumulators applied to the edge weights (may be empty)
+     * @return see struct accumulated_region_adjacency_graph
+     */
+    template<typename graph_t, typename T,
+            typename T1, typename... vertex_accumulators_t,
+            typename T2, typename... edge_accumulators_t>
+    auto
+    make_region_adjacency_graph_from_labelisation(const graph_t &graph,
+                                                  const xt::xexpression<T> &xvertex_labels,
+                                                  const xt::xexpression<T1> &xvertex_weights,
+                                                  const std::tuple<vertex_accumulators_t...> &vertex_accumulators,
+                                                  const xt::xexpression<T2> &xedge_weights,
+                                                  const std::tuple<edge_accumulators_t...> &edge_accumulators) {
+        HG_TRACE();
+        auto &vertex_labels = xvertex_labels.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_labels);
+        hg_assert_1d_array(vertex_labels);
+        hg_assert_integral_value_type(vertex_labels);
 
-        index_t num_regions = 0;
-        index_t num_edges = 0;
+        return rag_internal::make_region_adjacency_graph_accumulate(
+                graph,
+                [&graph, &vertex_labels](const auto &e) {
+                    return vertex_labels(source(e, graph)) == vertex_labels(target(e, graph));
+                },
+                xvertex_weights.derived_cast(), vertex_accumulators,
+                xedge_weights.derived_cast(), edge_accumulators);
+    }
 
-        std::vector<index_t> canonical_edge_indexes;
+    /**
+     * Construct a region adjacency graph from a graph cut and accumulates the vertex and edge weights of the graph
+     * on the vertices and edges of the region adjacency graph (see make_region_adjacency_graph_from_labelisation).
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @tparam T1
+     * @tparam vertex_accumulators_t
+     * @tparam T2
+     * @tparam edge_accumulators_t
+     * @param graph
+     * @param xedge_cut any edge with weight different from 0 belongs to the cut
+     * @param xvertex_weights weights of the graph vertices (first dimension equal to the number of vertices)
+     * @param vertex_accumulators tuple of accumulators applied to the vertex weights (may be empty)
+     * @param xedge_weights weights of the graph edges (first dimension equal to the number of edges)
+     * @param edge_accumulators tuple of accumulators applied to the edge weights (may be empty)
+     * @return see struct accumulated_region_adjacency_graph
+     */
+    template<typename graph_t, typename T,
+            typename T1, typename... vertex_accumulators_t,
+            typename T2, typename... edge_accumulators_t>
+    auto
+    make_region_adjacency_graph_from_graph_cut(const graph_t &graph,
+                                               const xt::xexpression<T> &xedge_cut,
+                                               const xt::xexpression<T1> &xvertex_weights,
+                                               const std::tuple<vertex_accumulators_t...> &vertex_accumulators,
+                                               const xt::xexpression<T2> &xedge_weights,
+                                               const std::tuple<edge_accumulators_t...> &edge_accumulators) {
+        HG_TRACE();
+        auto &edge_cut = xedge_cut.derived_cast();
+        hg_assert_edge_weights(graph, edge_cut);
+        hg_assert_1d_array(edge_cut);
+
+        return rag_internal::make_region_adjacency_graph_accumulate(
+                graph,
+                [&graph, &edge_cut](const auto &e) {
+                    return edge_cut(index(e, graph)) == 0;
+                },
+                xvertex_weights.derived_cast(), vertex_accumulators,
+                xedge_weights.derived_cast(), edge_accumulators);
+    }
 
-        stackv<index_t> s;
+    namespace rag_internal {
 
-        auto explore_component =
-                [&s, &graph, &edge_weights, &rag, &vertex_map, &edge_map, &num_regions, &num_edges, &canonical_edge_indexes]
-                        (index_t start_vertex) {
-                    s.push(start_vertex);
-                    vertex_map[start_vertex] = num_regions;
-                    add_vertex(rag);
-                    canonical_edge_indexes.push_back(-1);
-                    auto lowest_edge = num_edges;
-                    while (!s.empty()) {
-                        auto v = s.top();
-                        s.pop();
+        /**
+         * Multithreaded region adjacency graph construction: the regions are the connected components of the
+         * subgraph made of the edges satisfying connected(e). The result is identical to the one of the sequential
+         * graph traversals of make_region_adjacency_graph_from_labelisation and
+         * make_region_adjacency_graph_from_graph_cut.
+         *
+         * The regions are labelled with parallel_connected_components, which numbers them in the order of their
+         * vertex of smallest index as the sequential algorithm. Then, the traversal of each region performed by the
+         * sequential algorithm is replayed independently, in parallel, to find the order in which its rag edges
+         * (towards regions of smaller index) are discovered. Finally, rag edges are numbered region by region.
+         * Regions are processed by chunks of consecutive regions to amortize buffer allocations.
+         */
+        template<typename graph_t, typename predicate_t>
+        auto make_region_adjacency_graph_parallel(const graph_t &graph, const predicate_t &connected) {
+            const index_t num_v = num_vertices(graph);
+            array_1d<index_t> vertex_map = parallel_connected_components(graph, connected);
+            vertex_map -= 1;
+
+            index_t num_regions = 0;
+            std::vector<index_t> region_start;
+            for (index_t v = 0; v < num_v; v++) {
+                if (vertex_map(v) == num_regions) {
+                    region_start.push_back(v);
+                    num_regions++;
+                }
+            }
 
+            // regions are processed by chunks of consecutive regions sharing the same buffers
+            const index_t chunk_size = 1024;
+            const index_t num_chunks = (num_regions + chunk_size - 1) / chunk_size;
+            // edges of the original graph whose rag edge is discovered during the traversal of the regions of each
+            // chunk, and the index of their rag edge among the new rag edges of the chunk
+            std::vector<std::vector<std::pair<index_t, index_t>>> chunk_edges(num_chunks);
+            // extremities of the new rag edges of each chunk, in rag edge order
+            std::vector<std::vector<std::pair<index_t, index_t>>> chunk_rag_edges(num_chunks);
+            std::vector<char> visited(num_v, false);
+
+            parfor(0, num_chunks, [&](index_t c) {
+                std::vector<index_t> stack;
+                std::vector<index_t> edges;
+                std::vector<index_t> adjacent_regions;
+                std::vector<index_t> order;
+                std::vector<index_t> first;
+                auto &rag_edges = chunk_rag_edges[c];
+                auto &edge_rag_edges = chunk_edges[c];
+
+                for (index_t r = c * chunk_size; r < (std::min)(num_regions, (c + 1) * chunk_size); r++) {
+                    edges.clear();
+                    adjacent_regions.clear();
+                    stack.push_back(region_start[r]);
+                    visited[region_start[r]] = true;
+                    while (!stack.empty()) {
+                        auto v = stack.back();
+                        stack.pop_back();
                         for (auto e: out_edge_iterator(v, graph)) {
                             auto adjv = target(e, graph);
-                            if (edge_weights(index(e, graph)) == 0) {
-                                if (vertex_map[adjv] == invalid_index) {
-                                    vertex_map[adjv] = num_regions;
-                                    s.push(adjv);
-                                }
-                            } else {
-                                if (vertex_map[adjv] != invalid_index) {
-                                    auto num_region_adjacent = vertex_map[adjv];
-                                    if (canonical_edge_indexes[num_region_adjacent] < lowest_edge) {
-                                        add_edge(num_region_adjacent, num_regions, rag);
-                                        edge_map(e) = num_edges;
-                                        canonical_edge_indexes[num_region_adjacent] = num_edges;
-                                        num_edges++;
-                                    } else {
-                                        edge_map(e) = canonical_edge_indexes[num_region_adjacent];
-                                    }
+                            if (connected(e)) {
+                                if (!visited[adjv]) {
+                                    visited[adjv] = true;
+                                    stack.push_back(adjv);
                                 }
+                            } else if (vertex_map(adjv) < r || (vertex_map(adjv) == r && visited[adjv])) {
+                                edges.push_back(index(e, graph));
+                                adjacent_regions.push_back(vertex_map(adjv));
                             }
                         }
                     }
-                    num_regions++;
-                };
 
+                    // a new rag edge is created by the first edge towards each adjacent region
+                    const index_t num_edges_r = edges.size();
+                    order.resize(num_edges_r);
+                    std::iota(order.begin(), order.end(), 0);
+                    std::stable_sort(order.begin(), order.end(), [&adjacent_regions](index_t i, index_t j) {
+                        return adjacent_regions[i] < adjacent_regions[j];
+                    });
+                    first.resize(num_edges_r);
+                    for (index_t i = 0; i < num_edges_r; i++) {
+                        first[order[i]] = (i > 0 && adjacent_regions[order[i]] == adjacent_regions[order[i - 1]]) ?
+                                          first[order[i - 1]] : order[i];
+                    }
+                    const index_t start = edge_rag_edges.size();
+                    for (index_t i = 0; i < num_edges_r; i++) {
+                        if (first[i] == i) {
+                            edge_rag_edges.emplace_back(edges[i], (index_t) rag_edges.size());
+                            rag_edges.emplace_back(adjacent_regions[i], r);
+                        } else {
+                            edge_rag_edges.emplace_back(edges[i], edge_rag_edges[start + first[i]].second);
+                        }
+                    }
+                }
+            });
 
-        for (auto v: vertex_iterator(graph)) {
-            if (vertex_map[v] != invalid_index)
-                continue;
-            explore_component(v);
+            std::vector<index_t> chunk_offset(num_chunks + 1, 0);
+            for (index_t c = 0; c < num_chunks; c++) {
+                chunk_offset[c + 1] = chunk_offset[c] + chunk_rag_edges[c].size();
+            }
 
-        }
+            array_1d<index_t> edge_map({num_edges(graph)}, invalid_index);
+            parfor(0, num_chunks, [&chunk_edges, &chunk_offset, &edge_map](index_t c) {
+                for (const auto &e: chunk_edges[c]) {
+                    edge_map(e.first) = chunk_offset[c] + e.second;
+                }
+            });
 
-        return region_adjacency_graph{std::move(rag), std::move(vertex_map), std::move(edge_map)};
-    }
+            ugraph rag(num_regions, chunk_offset[num_chunks]);
+            for (const auto &rag_edges: chunk_rag_edges) {
+                for (const auto &e: rag_edges) {
+                    add_edge(e.first, e.second, rag);
+                }
+            }
+
+            return region_adjacency_graph{std::move(rag), std::move(vertex_map), std::move(edge_map)};
+        }
 
-    namespace rag_internal {
         template<bool vectorial, typename T>
         auto
         rag_back_project_weights(const array_1d<index_t> &rag_map, const xt::xexpression<T> &xrag_weights) {
@@ -209,25 +552,100 @@ namespace hg {
             std::vector<size_t> shape;
             shape.push_back(numv);
             shape.insert(shape.end(), rag_weights.shape().begin() + 1, rag_weights.shape().end());
-            array_nd<typename T::value_type> weights = xt::zeros<typename T::value_type>(shape);
-
-
-            auto input_view = make_light_axis_view<vectorial>(rag_weights);
-            auto output_view = make_light_axis_view<vectorial>(weights);
-
-            for (index_t i = 0; i < numv; ++i) {
-                if (rag_map.data()[i] != invalid_index) {
-                    output_view.set_position(i);
-                    input_view.set_position(rag_map.data()[i]);
-                    output_view = input_view;
+            auto weights = parallel_zeros<array_nd<typename T::value_type>>(shape);
+
+
+            // chunks of the output processed in parallel, each with its own views
+            const index_t chunk_size = 4096;
+            parfor(0, numv, [&rag_map, &rag_weights, &weights, numv, chunk_size](index_t start) {
+                auto input_view = make_light_axis_view<vectorial>(rag_weights);
+                auto output_view = make_light_axis_view<vectorial>(weights);
+                const index_t end = (std::min)(start + chunk_size, numv);
+                for (index_t i = start; i < end; ++i) {
+                    if (rag_map.data()[i] != invalid_index) {
+                        output_view.set_position(i);
+                        input_view.set_position(rag_map.data()[i]);
+                        output_view = input_view;
+                    }
                 }
-            }
+            }, chunk_size);
 
             return weights;
         }
 
     }
 
+    /**
+     * Multithreaded version of make_region_adjacency_graph_from_labelisation (see
+     * rag_internal::make_region_adjacency_graph_parallel): the result is identical to the one of the sequential
+     * version.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param policy execution::par
+     * @param graph
+     * @param xvertex_labels
+     * @return see struct region_adjacency_graph
+     */
+    template<typename graph_t, typename T>
+    auto
+    make_region_adjacency_graph_from_labelisation(execution::parallel_policy,
+                                                  const graph_t &graph,
+                                                  const xt::xexpression<T> &xvertex_labels) {
+        HG_TRACE();
+        auto &vertex_labels = xvertex_labels.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_labels);
+        hg_assert_1d_array(vertex_labels);
+        hg_assert_integral_value_type(vertex_labels);
+
+        return rag_internal::make_region_adjacency_graph_parallel(graph, [&graph, &vertex_labels](const auto &e) {
+            return vertex_labels(source(e, graph)) == vertex_labels(target(e, graph));
+        });
+    }
+
+    template<typename graph_t, typename T>
+    auto
+    make_region_adjacency_graph_from_labelisation(execution::sequenced_policy,
+                                                  const graph_t &graph,
+                                                  const xt::xexpression<T> &xvertex_labels) {
+        return make_region_adjacency_graph_from_labelisation(graph, xvertex_labels);
+    }
+
+    /**
+     * Multithreaded version of make_region_adjacency_graph_from_graph_cut (see
+     * rag_internal::make_region_adjacency_graph_parallel): the result is identical to the one of the sequential
+     * version.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param policy execution::par
+     * @param graph
+     * @param xedge_weights
+     * @return see struct region_adjacency_graph
+     */
+    template<typename graph_t, typename T>
+    auto
+    make_region_adjacency_graph_from_graph_cut(execution::parallel_policy,
+                                               const graph_t &graph,
+                                               const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        return rag_internal::make_region_adjacency_graph_parallel(graph, [&graph, &edge_weights](const auto &e) {
+            return edge_weights(index(e, graph)) == 0;
+        });
+    }
+
+    template<typename graph_t, typename T>
+    auto
+    make_region_adjacency_graph_from_graph_cut(execution::sequenced_policy,
+                                               const graph_t &graph,
+                                               const xt::xexpression<T> &xedge_weights) {
+        return make_region_adjacency_graph_from_graph_cut(graph, xedge_weights);
+    }
+
     /**
      * Projects weights on the rag (vertices or edges) onto the original graph.
      * @tparam T
@@ -0,0 +1,247 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "watershed.hpp"
+#include "../hierarchy/hierarchy_core.hpp"
+#include "../attribute/tree_attribute.hpp"
+#include <cmath>
+
+namespace hg {
+
+    /**
+     * Seeded watershed labelisations of many seed sets on the same edge weighted graph, typically for stochastic
+     * watersheds.
+     *
+     * The seeded watershed only depends on the minimum spanning tree of the graph and on the order of its edges
+     * (see incremental_seeded_watershed): the canonical binary partition tree of the graph, and thus its minimum
+     * spanning tree with its edges in increasing order, is computed once at construction. Each seed set is then
+     * answered with a single union-find sweep over the n - 1 minimum spanning tree edges, without sorting the edges
+     * of the graph again, and the seed sets are processed in parallel.
+     *
+     * The binary partition tree also gives the exact boundary probabilities of the stochastic watershed with
+     * uniformly drawn seeds, in closed form (see boundary_probabilities).
+     */
+    struct batched_seeded_watershed {
+
+        /**
+         * Computes the canonical binary partition tree and the minimum spanning tree of the given edge weighted graph.
+         *
+         * @tparam graph_t
+         * @tparam T
+         * @param graph input graph
+         * @param xedge_weights input graph edge weights
+         */
+        template<typename graph_t, typename T>
+        batched_seeded_watershed(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
+            HG_TRACE();
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_edge_weights(graph, edge_weights);
+            hg_assert_1d_array(edge_weights);
+
+            auto bpt = bpt_canonical(graph, edge_weights);
+            m_tree = std::move(bpt.tree);
+            m_tree.compute_children();
+            m_mst_edge_map = std::move(bpt.mst_edge_map);
+            const index_t num_mst_edges = m_mst_edge_map.size();
+            m_sources = array_1d<index_t>::from_shape({(size_t) num_mst_edges});
+            m_targets = array_1d<index_t>::from_shape({(size_t) num_mst_edges});
+            parfor(0, num_mst_edges, [this, &graph](index_t k) {
+                auto e = edge_from_index(m_mst_edge_map(k), graph);
+                m_sources(k) = source(e, graph);
+                m_targets(k) = target(e, graph);
+            });
+        }
+
+        index_t num_vertices() const {
+            return num_leaves(m_tree);
+        }
+
+        /**
+         * Canonical binary partition tree of the graph: the internal node num_vertices() + k corresponds to the k-th
+         * edge of the minimum spanning tree
+         */
+        const tree &bpt() const {
+            return m_tree;
+        }
+
+        /**
+         * Indices of the minimum spanning tree edges in the graph, in increasing order of weight
+         */
+        const array_1d<index_t> &mst_edge_map() const {
+            return m_mst_edge_map;
+        }
+
+        /**
+         * Seeded watershed labelisation of the given seeds: identical to labelisation_seeded_watershed(graph,
+         * edge_weights, vertex_seeds, background_label) in O(num_vertices()).
+         *
+         * Thread safe.
+         *
+         * @tparam T
+         * @param xvertex_seeds seed label of each vertex, background_label for non seed vertices
+         * @param background_label label of non seed vertices
+         * @return a 1d array of labels
+         */
+        template<typename T>
+        auto labelisation(const xt::xexpression<T> &xvertex_seeds,
+                          const typename T::value_type background_label = 0) const {
+            HG_TRACE();
+            auto &vertex_seeds = xvertex_seeds.derived_cast();
+            hg_assert_1d_array(vertex_seeds);
+            hg_assert((index_t) vertex_seeds.size() == num_vertices(), "Seeds size does not match graph size.");
+            array_1d<typename T::value_type> labels = vertex_seeds;
+            watershed_internal::seeded_watershed_on_sorted_mst(m_sources.data(), m_targets.data(),
+                                                               m_sources.size(), labels, background_label);
+            return labels;
+        }
+
+        /**
+         * Seeded watershed labelisations of many seed sets: the i-th row of the result is the labelisation of the seeds
+         * given in the i-th row of xvertex_seeds. The seed sets are processed in parallel.
+         *
+         * @tparam T
+         * @param xvertex_seeds 2d array of shape (num_seed_sets, num_vertices())
+         * @param background_label label of non seed vertices
+         * @return a 2d array of labels of shape (num_seed_sets, num_vertices())
+         */
+        template<typename T>
+        auto labelisations(const xt::xexpression<T> &xvertex_seeds,
+                           const typename T::value_type background_label = 0) const {
+            HG_TRACE();
+            auto &vertex_seeds = xvertex_seeds.derived_cast();
+            hg_assert(vertex_seeds.dimension() == 2, "Seeds must be a 2d array.");
+            hg_assert((index_t) vertex_seeds.shape()[1] == num_vertices(), "Seeds size does not match graph size.");
+            using label_type = typename T::value_type;
+            const index_t num_sets = vertex_seeds.shape()[0];
+            const index_t num_v = num_vertices();
+            array_2d<label_type> labels = vertex_seeds;
+            parfor(0, num_sets, [this, &labels, num_v, background_label](index_t i) {
+                auto row = xt::adapt(labels.data() + i * num_v, (size_t) num_v, xt::no_ownership(),
+                                     std::array<size_t, 1>{(size_t) num_v});
+                watershed_internal::seeded_watershed_on_sorted_mst(m_sources.data(), m_targets.data(),
+                                                                   m_sources.size(), row, background_label);
+            });
+            return labels;
+        }
+
+        /**
+         * Exact boundary probabilities of the stochastic watershed with num_seeds seeds drawn independently at random
+         * among the vertices, the vertex v being drawn with a probability proportional to vertex_weights(v) (all the
+         * seeds having distinct labels).
+         *
+         * The k-th minimum spanning tree edge is a watershed edge (its extremities are in different basins) if and
+         * only if both children A and B of the binary partition tree node num_vertices() + k contain a seed, which
+         * has the probability 1 - (1 - a)^N - (1 - b)^N + (1 - a - b)^N with a and b the normalized weights of A and
+         * B and N the number of seeds [1]. The probabilities are computed with expm1 and log1p to remain accurate for
+         * small regions.
+         *
+         * [1] F. Malmberg and C. L. Luengo Hendriks, "An efficient algorithm for exact evaluation of stochastic
+         * watersheds," Pattern Recognition Letters 47, 2014.
+         *
+         * @tparam T
+         * @param num_seeds number of seeds
+         * @param xvertex_weights weight of each vertex (drawing probability up to normalization)
+         * @return a 1d array of probabilities on the nodes of the binary partition tree (0 on the leaves)
+         */
+        template<typename T>
+        auto boundary_probabilities(double num_seeds, const xt::xexpression<T> &xvertex_weights) const {
+            HG_TRACE();
+            auto &vertex_weights = xvertex_weights.derived_cast();
+            hg_assert_leaf_weights(m_tree, vertex_weights);
+            hg_assert_1d_array(vertex_weights);
+            hg_assert(num_seeds >= 0, "The number of seeds must be positive.");
+
+            const index_t num_v = num_vertices();
+            const index_t num_nodes = hg::num_vertices(m_tree);
+            array_1d<double> area = attribute_area(m_tree, xt::cast<double>(vertex_weights));
+            const double total_area = area(num_nodes - 1);
+
+            array_1d<double> probabilities = array_1d<double>::from_shape({(size_t) num_nodes});
+            std::fill(probabilities.begin(), probabilities.begin() + num_v, 0);
+            parfor(num_v, num_nodes, [this, &area, &probabilities, total_area, num_seeds](index_t n) {
+                const double a = area(child(0, n, m_tree)) / total_area;
+                const double b = area(child(1, n, m_tree)) / total_area;
+                // log of the probability that no seed falls in A, B, and A u B
+                const double la = num_seeds * std::log1p(-a);
+                const double lb = num_seeds * std::log1p(-b);
+                const double lab = num_seeds * std::log1p(-(std::min)(a + b, 1.0));
+                double p;
+                if (std::isinf(lab)) {
+                    // A u B holds all the weight: at least one seed falls in A or B
+                    p = -std::expm1(la) - std::exp(lb);
+                } else {
+                    // (1 - q_a)(1 - q_b) - (q_a q_b - q_ab)
+                    p = std::expm1(la) * std::expm1(lb) - std::exp(lab) * std::expm1(la + lb - lab);
+                }
+                probabilities(n) = (std::min)(1.0, (std::max)(0.0, p));
+            });
+            return probabilities;
+        }
+
+        /**
+         * Exact boundary probabilities of the stochastic watershed with num_seeds seeds drawn uniformly among the
+         * vertices, see boundary_probabilities(num_seeds, vertex_weights).
+         */
+        auto boundary_probabilities(double num_seeds) const {
+            return boundary_probabilities(num_seeds, xt::ones<double>({(size_t) num_vertices()}));
+        }
+
+    private:
+        tree m_tree;
+        array_1d<index_t> m_mst_edge_map;
+        // minimum spanning tree edges in increasing order
+        array_1d<index_t> m_sources;
+        array_1d<index_t> m_targets;
+    };
+
+    /**
+     * Exact stochastic watershed of an edge weighted graph with num_seeds seeds drawn independently at random among
+     * the vertices (the vertex v being drawn with a probability proportional to vertex_weights(v)).
+     *
+     * An edge of the minimum spanning tree of the graph gets the exact probability that its extremities are in
+     * different basins of the seeded watershed (see batched_seeded_watershed::boundary_probabilities). Any other edge
+     * gets the probability of the largest minimum spanning tree edge on the path between its extremities (the
+     * saliency map of the probabilities on the canonical binary partition tree), which is a lower bound of the
+     * probability that its extremities are in different basins.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph
+     * @param xedge_weights input graph edge weights
+     * @param num_seeds number of seeds
+     * @param xvertex_weights weight of each vertex
+     * @return a 1d array of probabilities on the edges of the graph
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto exact_stochastic_watershed(const graph_t &graph,
+                                    const xt::xexpression<T1> &xedge_weights,
+                                    double num_seeds,
+                                    const xt::xexpression<T2> &xvertex_weights) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        batched_seeded_watershed ws(graph, xedge_weights);
+        auto probabilities = ws.boundary_probabilities(num_seeds, vertex_weights);
+        array_1d<index_t> mst_edge_map = ws.mst_edge_map();
+        auto bpt = make_node_weighted_tree_and_mst(tree(ws.bpt()), std::move(probabilities), std::move(mst_edge_map));
+        return saliency_map(graph, bpt);
+    }
+
+    template<typename graph_t, typename T>
+    auto exact_stochastic_watershed(const graph_t &graph,
+                                    const xt::xexpression<T> &xedge_weights,
+                                    double num_seeds) {
+        return exact_stochastic_watershed(graph, xedge_weights, num_seeds,
+                                          xt::ones<double>({(size_t) num_vertices(graph)}));
+    }
+}
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "../detail/memory_tracking.hpp"
 #include "xtensor/xgenerator.hpp"
 #include "xtensor/xeval.hpp"
 #include "xtensor/xindex_view.hpp"
@@ -18,6 +19,9 @@
 #include "../accumulator/tree_accumulator.hpp"
 #include "../hierarchy/common.hpp"
 #include "higra/sorting.hpp"
+#include "higra/structure/workspace.hpp"
+#include "higra/structure/leaf_ranges.hpp"
+#include <atomic>
 #include <queue>
 
 namespace hg {
@@ -46,6 +50,194 @@ namespace hg {
         return xt::eval(xt::strided_view(reconstruction, {xt::range(0, num_leaves(tree)), xt::ellipsis()}));
     };
 
+    namespace tree_internal {
+
+        /**
+         * For each node n of the tree, the lowest ancestor m of n (n included) such that selected(m) is true (the
+         * root is always considered as selected).
+         *
+         * The result is computed by pointer jumping: each node initially points to itself if it is selected and to
+         * its parent otherwise, then, at each round, every node replaces its pointer p by the pointer of p, in
+         * parallel. The number of rounds is logarithmic in the length of the longest chain of non selected nodes.
+         *
+         * @tparam tree_t
+         * @tparam F
+         * @param tree input tree
+         * @param selected function (index_t) -> bool
+         * @return an array of node indices
+         */
+        template<typename tree_t, typename F>
+        array_1d<index_t> lowest_selected_ancestors(const tree_t &tree, const F &selected) {
+            HG_TRACE();
+            const index_t num_v = num_vertices(tree);
+            const index_t root_node = root(tree);
+            auto &par = parents(tree);
+            array_1d<index_t> current = array_1d<index_t>::from_shape({(size_t) num_v});
+            array_1d<index_t> next = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&](index_t n) {
+                current(n) = (n == root_node || selected(n)) ? n : par(n);
+            });
+
+            bool changed = true;
+            while (changed) {
+                std::atomic<bool> any_change{false};
+                parfor(0, num_v, [&current, &next, &any_change](index_t n) {
+                    const index_t c = current(n);
+                    const index_t cc = current(c);
+                    next(n) = cc;
+                    if (cc != c) {
+                        any_change.store(true, std::memory_order_relaxed);
+                    }
+                });
+                std::swap(current, next);
+                changed = any_change.load();
+            }
+            return current;
+        }
+
+        /**
+         * Result of parallel_supervertices.
+         */
+        struct supervertices_result {
+            // supervertex of each leaf
+            array_1d<index_t> labels;
+            // lowest ancestor of each node that is either the top node of a supervertex or not included in any
+            // supervertex
+            array_1d<index_t> ancestors;
+            // label of each node that is the top node of a supervertex (invalid_index for other nodes)
+            array_1d<index_t> node_labels;
+            // top node of each supervertex
+            array_1d<index_t> supervertex_nodes;
+        };
+
+        /**
+         * Multithreaded identification of the supervertices of a tree: two leaves are in the same supervertex if
+         * they have a common ancestor of altitude 0. Supervertices are numbered in the order of their leaf of smallest
+         * index (as in labelisation_hierarchy_supervertices).
+         *
+         * The top node of the supervertex of each leaf is found with lowest_selected_ancestors, the leaf of smallest
+         * index of each supervertex with an atomic minimum, and the supervertices are numbered by a prefix sum
+         * over blocks of leaves processed in parallel.
+         */
+        template<typename tree_t, typename T>
+        auto parallel_supervertices(const tree_t &tree, const T &altitudes) {
+            const index_t num_v = num_vertices(tree);
+            const index_t num_l = num_leaves(tree);
+            auto &par = parents(tree);
+            using value_type = typename T::value_type;
+
+            auto ancestors = lowest_selected_ancestors(tree, [&altitudes, &par](index_t n) {
+                return !(altitudes(par(n)) <= static_cast<value_type>(0));
+            });
+
+            std::vector<std::atomic<index_t>> first_leaf(num_v);
+            parfor(0, num_v, [&first_leaf, num_l](index_t n) {
+                first_leaf[n].store(num_l, std::memory_order_relaxed);
+            });
+            parfor(0, num_l, [&first_leaf, &ancestors](index_t l) {
+                auto &first = first_leaf[ancestors(l)];
+                index_t current = first.load(std::memory_order_relaxed);
+                while (l < current && !first.compare_exchange_weak(current, l, std::memory_order_relaxed)) {
+                }
+            });
+
+            constexpr index_t block_size = 65536;
+            const index_t num_blocks = (num_l + block_size - 1) / block_size;
+            std::vector<index_t> block_offset(num_blocks + 1, 0);
+            parfor(0, num_blocks, [&](index_t b) {
+                index_t count = 0;
+                for (index_t l = b * block_size; l < (std::min)(num_l, (b + 1) * block_size); l++) {
+                    count += first_leaf[ancestors(l)].load(std::memory_order_relaxed) == l;
+                }
+                block_offset[b + 1] = count;
+            });
+            for (index_t b = 0; b < num_blocks; b++) {
+                block_offset[b + 1] += block_offset[b];
+            }
+
+            const index_t num_supervertices = block_offset[num_blocks];
+            array_1d<index_t> node_labels({(size_t) num_v}, invalid_index);
+            array_1d<index_t> supervertex_nodes = array_1d<index_t>::from_shape({(size_t) num_supervertices});
+            parfor(0, num_blocks, [&](index_t b) {
+                index_t label = block_offset[b];
+                for (index_t l = b * block_size; l < (std::min)(num_l, (b + 1) * block_size); l++) {
+                    const index_t a = ancestors(l);
+                    if (first_leaf[a].load(std::memory_order_relaxed) == l) {
+                        node_labels(a) = label;
+                        supervertex_nodes(label) = a;
+                        label++;
+                    }
+                }
+            });
+
+            array_1d<index_t> labels = array_1d<index_t>::from_shape({(size_t) num_l});
+            parfor(0, num_l, [&labels, &node_labels, &ancestors](index_t l) {
+                labels(l) = node_labels(ancestors(l));
+            });
+
+            return supervertices_result{std::move(labels), std::move(ancestors), std::move(node_labels),
+                                        std::move(supervertex_nodes)};
+        }
+    }
+
+    /**
+     * Multithreaded version of reconstruct_leaf_data: the lowest non deleted ancestor of each node is computed by
+     * pointer jumping (see tree_internal::lowest_selected_ancestors), then the weights of these ancestors are copied
+     * to the leaves in parallel. Only the leaf weights are allocated.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param policy execution::par
+     * @param tree
+     * @param xaltitudes node weights (scalar or vectorial)
+     * @param xdeleted_nodes
+     * @return
+     */
+    template<typename tree_t,
+            typename T1,
+            typename T2>
+    auto reconstruct_leaf_data(execution::parallel_policy,
+                               const tree_t &tree,
+                               const xt::xexpression<T1> &xaltitudes,
+                               const xt::xexpression<T2> &xdeleted_nodes) {
+        HG_TRACE();
+        using value_type = typename T1::value_type;
+        auto &altitudes = xaltitudes.derived_cast();
+        auto &deleted_nodes = xdeleted_nodes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_node_weights(tree, deleted_nodes);
+        hg_assert_1d_array(deleted_nodes);
+
+        auto ancestors = tree_internal::lowest_selected_ancestors(tree, [&deleted_nodes](index_t n) {
+            return !deleted_nodes(n);
+        });
+
+        const index_t num_l = num_leaves(tree);
+        std::vector<size_t> shape(altitudes.shape().begin(), altitudes.shape().end());
+        shape[0] = num_l;
+        array_nd<value_type> res = array_nd<value_type>::from_shape(shape);
+        const index_t row_size = altitudes.size() / num_vertices(tree);
+        array_nd<value_type> buffer;
+        const value_type *data = row_major_data(altitudes, buffer);
+        value_type *out = res.data();
+        parfor(0, num_l, [data, out, row_size, &ancestors](index_t l) {
+            const value_type *row = data + ancestors(l) * row_size;
+            std::copy(row, row + row_size, out + l * row_size);
+        });
+        return res;
+    };
+
+    template<typename tree_t,
+            typename T1,
+            typename T2>
+    auto reconstruct_leaf_data(execution::sequenced_policy,
+                               const tree_t &tree,
+                               const xt::xexpression<T1> &altitudes,
+                               const xt::xexpression<T2> &deleted_nodes) {
+        return reconstruct_leaf_data(tree, altitudes, deleted_nodes);
+    };
+
     /**
      * Labelize tree leaves according to an horizontal cut in the tree.
      *
@@ -72,10 +264,118 @@ namespace hg {
                                                     const value_t threshold) {
         HG_TRACE();
         auto &altitudes = xaltitudes.derived_cast();
-        return reconstruct_leaf_data(tree,
-                                     xt::arange<index_t>(num_vertices(tree)),
-                                     xt::index_view(altitudes, tree.parents())
-                                     <= static_cast<typename T::value_type>(threshold));
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        const auto level = static_cast<typename T::value_type>(threshold);
+
+        // label of each node, the leaves are labelled directly in the result
+        workspace_array_1d<index_t> node_labels = workspace_array_1d<index_t>::from_shape({num_vertices(tree)});
+        node_labels(root(tree)) = root(tree);
+        for (auto n: root_to_leaves_iterator(tree, leaves_it::exclude, root_it::exclude)) {
+            auto p = parent(n, tree);
+            node_labels(n) = (altitudes(p) <= level) ? node_labels(p) : n;
+        }
+
+        array_1d<index_t> labels = array_1d<index_t>::from_shape({num_leaves(tree)});
+        for (auto n: leaves_iterator(tree)) {
+            auto p = parent(n, tree);
+            labels(n) = (altitudes(p) <= level) ? node_labels(p) : n;
+        }
+        return labels;
+    };
+
+    /**
+     * Labelize tree leaves according to several horizontal cuts in the tree.
+     *
+     * The i-th row of the result is equal to labelisation_horizontal_cut_from_threshold(tree, altitudes,
+     * thresholds(i)). The thresholds must be sorted in increasing order.
+     *
+     * For a node n, let c(n) be the number of thresholds strictly smaller than the altitude of the parent of n
+     * (c(root) = num_thresholds): the label of a leaf l for the k-th threshold is the lowest ancestor m of l such that
+     * c(m) > k. A single top-down traversal of the tree links each node to its lowest ancestor with a strictly
+     * larger c value: the labels of a leaf for all the thresholds are then written in a single loop that follows
+     * these links, in time linear in the number of thresholds. Blocks of leaves are processed in parallel.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param tree
+     * @param xaltitudes node altitudes of the tree
+     * @param xthresholds 1d array of thresholds sorted in increasing order
+     * @return an array of shape (num_thresholds, num_leaves(tree))
+     */
+    template<typename tree_t,
+            typename T1,
+            typename T2>
+    auto labelisation_horizontal_cuts_from_thresholds(const tree_t &tree,
+                                                      const xt::xexpression<T1> &xaltitudes,
+                                                      const xt::xexpression<T2> &xthresholds) {
+        HG_TRACE();
+        using value_type = typename T1::value_type;
+        auto &altitudes = xaltitudes.derived_cast();
+        auto &thresholds = xthresholds.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        hg_assert_1d_array(thresholds);
+
+        const index_t num_thresholds = thresholds.size();
+        const index_t num_nodes = num_vertices(tree);
+        const index_t num_leaves_tree = num_leaves(tree);
+        std::vector<value_type> sorted_thresholds(num_thresholds);
+        for (index_t k = 0; k < num_thresholds; k++) {
+            sorted_thresholds[k] = static_cast<value_type>(thresholds(k));
+        }
+        hg_assert(std::is_sorted(sorted_thresholds.begin(), sorted_thresholds.end()),
+                  "Thresholds must be sorted in increasing order.");
+
+        array_2d<index_t> labels = array_2d<index_t>::from_shape(
+                {(size_t) num_thresholds, (size_t) num_leaves_tree});
+        if (num_thresholds == 0) {
+            return labels;
+        }
+
+        // num_kept(n) = c(n) and jump(n) is the lowest strict ancestor m of n such that c(m) > c(n)
+        auto &par = parents(tree);
+        const index_t root_node = root(tree);
+        std::vector<index_t> num_kept((size_t) num_nodes);
+        std::vector<index_t> jump((size_t) num_nodes);
+        num_kept[root_node] = num_thresholds;
+        jump[root_node] = root_node;
+        for (auto n: root_to_leaves_iterator(tree, leaves_it::include, root_it::exclude)) {
+            index_t p = par(n);
+            num_kept[n] = std::lower_bound(sorted_thresholds.begin(), sorted_thresholds.end(), altitudes(p)) -
+                          sorted_thresholds.begin();
+            jump[n] = (num_kept[p] > num_kept[n]) ? p : jump[p];
+        }
+
+        // the label of the leaf l for the threshold k is its lowest ancestor m such that c(m) > k: going from the
+        // threshold k to k + 1, the label of l changes to jump(m) if c(m) = k + 1. Leaves are processed by blocks
+        // so that the rows of the result are written contiguously.
+        constexpr index_t block_size = 512;
+        const index_t num_blocks = (num_leaves_tree + block_size - 1) / block_size;
+        index_t *out = labels.data();
+        parfor(0, num_blocks, [out, &num_kept, &jump, num_thresholds, num_leaves_tree](index_t b) {
+            const index_t first = b * block_size;
+            const index_t size = (std::min)((index_t) block_size, num_leaves_tree - first);
+            index_t current[block_size];
+            index_t end[block_size];
+            for (index_t i = 0; i < size; i++) {
+                index_t l = first + i;
+                current[i] = (num_kept[l] > 0) ? l : jump[l];
+                end[i] = num_kept[current[i]];
+            }
+            for (index_t k = 0; k < num_thresholds; k++) {
+                index_t *row = out + k * num_leaves_tree + first;
+                for (index_t i = 0; i < size; i++) {
+                    if (end[i] == k) {
+                        current[i] = jump[current[i]];
+                        end[i] = num_kept[current[i]];
+                    }
+                    row[i] = current[i];
+                }
+            }
+        });
+        return labels;
     };
 
     /**
@@ -114,6 +414,37 @@ namespace hg {
         return labels;
     };
 
+    /**
+     * Multithreaded version of labelisation_hierarchy_supervertices (see tree_internal::parallel_supervertices): the
+     * result is identical to the one of the sequential version.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param policy execution::par
+     * @param tree
+     * @param xaltitudes
+     * @return
+     */
+    template<typename tree_t,
+            typename T>
+    auto labelisation_hierarchy_supervertices(execution::parallel_policy,
+                                              const tree_t &tree,
+                                              const xt::xexpression<T> &xaltitudes) {
+        HG_TRACE();
+        auto &altitudes = xaltitudes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        return std::move(tree_internal::parallel_supervertices(tree, altitudes).labels);
+    };
+
+    template<typename tree_t,
+            typename T>
+    auto labelisation_hierarchy_supervertices(execution::sequenced_policy,
+                                              const tree_t &tree,
+                                              const xt::xexpression<T> &xaltitudes) {
+        return labelisation_hierarchy_supervertices(tree, xaltitudes);
+    };
+
     /**
      * A simple structure to hold the result of supervertices_hierarchy algorithm.
      *
@@ -236,6 +567,83 @@ namespace hg {
         };
     };
 
+    /**
+     * Multithreaded version of supervertices_hierarchy: the supervertices are identified in parallel (see
+     * tree_internal::parallel_supervertices), the nodes of the new tree are then numbered by the same breadth first
+     * traversal as the sequential version, which only visits the nodes that are not included in a supervertex. The
+     * result is identical to the one of the sequential version.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param policy execution::par
+     * @param tree
+     * @param xaltitudes
+     * @return
+     */
+    template<typename tree_t,
+            typename T>
+    auto supervertices_hierarchy(execution::parallel_policy,
+                                 const tree_t &tree,
+                                 const xt::xexpression<T> &xaltitudes) {
+        HG_TRACE();
+        auto &altitudes = xaltitudes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+
+        auto supervertices = tree_internal::parallel_supervertices(tree, altitudes);
+        auto &ancestors = supervertices.ancestors;
+        auto &node_labels = supervertices.node_labels;
+        auto &super_vertex_nodes = supervertices.supervertex_nodes;
+        const index_t num_supervertices = super_vertex_nodes.size();
+
+        // new index of each node: nodes included in a supervertex contain the index of their supervertex
+        const index_t num_v = num_vertices(tree);
+        array_1d<index_t> new_order = array_1d<index_t>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&new_order, &node_labels, &ancestors](index_t n) {
+            new_order(n) = node_labels(ancestors(n));
+        });
+        const index_t num_kept = xt::count_nonzero(xt::equal(new_order, invalid_index))();
+        const index_t num_nodes_new_tree = num_kept + num_supervertices;
+
+        tree.compute_children();
+        array_1d<index_t> parents = xt::empty<index_t>({num_nodes_new_tree});
+        array_1d<index_t> node_map = xt::empty<index_t>({num_nodes_new_tree});
+        index_t node_number = num_nodes_new_tree - 1;
+        std::queue<index_t> queue;
+        queue.push(root(tree));
+        while (!queue.empty()) {
+            auto e = queue.front();
+            queue.pop();
+            new_order(e) = node_number;
+            parents(node_number) = new_order(parent(e, tree));
+            node_map(node_number) = e;
+            node_number--;
+            for (auto c: children_iterator(e, tree)) {
+                if (new_order(c) == invalid_index) {
+                    queue.push(c);
+                }
+            }
+        }
+
+        parfor(0, num_supervertices, [&](index_t i) {
+            auto n = super_vertex_nodes(i);
+            parents(i) = new_order(parent(n, tree));
+            node_map(i) = n;
+        });
+
+        return supervertex_hierarchy<array_1d<index_t>, hg::tree, array_1d<index_t>>{
+                std::move(supervertices.labels), hg::tree(std::move(parents), tree.category()), std::move(node_map)
+        };
+    };
+
+    template<typename tree_t,
+            typename T>
+    auto supervertices_hierarchy(execution::sequenced_policy,
+                                 const tree_t &tree,
+                                 const xt::xexpression<T> &xaltitudes) {
+        return supervertices_hierarchy(tree, xaltitudes);
+    };
+
     /**
      * Test if 2 trees are isomorph assuming that they share the same leaves.
      *
@@ -339,6 +747,491 @@ namespace hg {
         return xt::eval(xt::view(attr, xt::range(0, num_leaves(tree))) - 1);
     }
 
+    /**
+     * Packs a binary labelisation into a bit array: the i-th element of the labelisation is stored in the bit i % 8
+     * (starting from the least significant bit) of the byte i / 8 of the result. The last byte is padded with 0.
+     *
+     * This is the layout of numpy.packbits(labels, bitorder='little').
+     *
+     * @tparam T
+     * @param xlabels 1d array, non zero values are mapped to 1
+     * @return a 1d array of size ceil(labels.size() / 8)
+     */
+    template<typename T>
+    auto pack_binary_labelisation(const xt::xexpression<T> &xlabels) {
+        HG_TRACE();
+        auto &labels = xlabels.derived_cast();
+        hg_assert_1d_array(labels);
+        const index_t size = labels.size();
+        const index_t num_bytes = (size + 7) / 8;
+        array_1d<uint8_t> packed = array_1d<uint8_t>::from_shape({(size_t) num_bytes});
+        parfor(0, num_bytes, [&packed, &labels, size](index_t i) {
+            const index_t end = (std::min)(size, 8 * (i + 1));
+            uint8_t byte = 0;
+            for (index_t j = 8 * i; j < end; j++) {
+                byte |= (uint8_t) ((labels(j) != 0) << (j - 8 * i));
+            }
+            packed(i) = byte;
+        });
+        return packed;
+    }
+
+    /**
+     * Inverse of pack_binary_labelisation.
+     *
+     * @tparam T
+     * @param xpacked bit array given by pack_binary_labelisation
+     * @param num_elements number of elements of the packed labelisation
+     * @return a 1d array of size num_elements with values in {0, 1}
+     */
+    template<typename T>
+    auto unpack_binary_labelisation(const xt::xexpression<T> &xpacked, index_t num_elements) {
+        HG_TRACE();
+        auto &packed = xpacked.derived_cast();
+        hg_assert_1d_array(packed);
+        hg_assert((index_t) packed.size() == (num_elements + 7) / 8,
+                  "The size of the packed array does not match the number of elements.");
+        array_1d<char> labels = array_1d<char>::from_shape({(size_t) num_elements});
+        parfor(0, (index_t) packed.size(), [&packed, &labels, num_elements](index_t i) {
+            const index_t end = (std::min)(num_elements, 8 * (i + 1));
+            const auto byte = static_cast<uint8_t>(packed(i));
+            for (index_t j = 8 * i; j < end; j++) {
+                labels(j) = (char) ((byte >> (j - 8 * i)) & 1);
+            }
+        });
+        return labels;
+    }
+
+    /**
+     * Same as binary_labelisation_from_markers but the result is packed in a bit array (see
+     * pack_binary_labelisation): 1 bit per leaf instead of 1 byte.
+     *
+     * @tparam tree_t tree type
+     * @tparam T1 xtensor type, value_type must be castable to bool
+     * @tparam T2 xtensor type, value_type must be castable to bool
+     * @param tree input tree
+     * @param xobject_marker indicator function of the object marker
+     * @param xbackground_marker indicator function of the background marker
+     * @return packed indicator function of the final_object
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto binary_labelisation_from_markers_packed(
+            const tree_t &tree,
+            const xt::xexpression<T1> &xobject_marker,
+            const xt::xexpression<T2> &xbackground_marker) {
+        return pack_binary_labelisation(binary_labelisation_from_markers(tree, xobject_marker, xbackground_marker));
+    }
+
+    /**
+     * Incremental computation of binary_labelisation_from_markers for interactive segmentation: markers are added
+     * and removed one leaf at a time and the cost of an update or of a query only depends on the marker leaves and
+     * on their ancestors, not on the size of the tree.
+     *
+     * For each node, the number of its children whose sub-tree contains a background marker leaf (1 for a background
+     * marker leaf) is maintained: adding (removing) a background marker climbs the ancestors of the leaf until it
+     * reaches a node whose count was not 0 (does not become 0). The final object is the union of the sub-trees rooted
+     * in the object nodes: the highest ancestors of the object marker leaves that do not contain any background
+     * marker. They are found by climbing the ancestors of the object marker leaves until a visited node or a node
+     * whose parent contains a background marker is reached. Finally, the leaves of the object nodes are obtained in
+     * constant time with a leaf_ranges structure.
+     *
+     * A leaf that is both an object and a background marker is a background marker. The methods of this class are
+     * not thread safe (object_nodes uses an internal buffer).
+     */
+    class incremental_binary_labelisation {
+    public:
+
+        template<typename tree_t>
+        incremental_binary_labelisation(const tree_t &tree) :
+                m_parents(parents(tree)),
+                m_num_leaves(num_leaves(tree)),
+                m_root(root(tree)),
+                m_leaf_ranges(tree),
+                m_background_count({num_vertices(tree)}, 0),
+                m_num_background_markers(0),
+                m_object_position({num_leaves(tree)}, invalid_index),
+                m_visited({num_vertices(tree)}, 0),
+                m_stamp(0) {
+        }
+
+        /**
+         * Marks the given leaf as an object marker (does nothing if it is already an object marker).
+         */
+        void add_object_marker(index_t leaf) {
+            assert_leaf(leaf);
+            if (m_object_position(leaf) == invalid_index) {
+                m_object_position(leaf) = m_object_markers.size();
+                m_object_markers.push_back(leaf);
+            }
+        }
+
+        /**
+         * Removes the given leaf from the object markers (does nothing if it is not an object marker).
+         */
+        void remove_object_marker(index_t leaf) {
+            assert_leaf(leaf);
+            const index_t position = m_object_position(leaf);
+            if (position != invalid_index) {
+                const index_t last = m_object_markers.back();
+                m_object_markers[position] = last;
+                m_object_position(last) = position;
+                m_object_markers.pop_back();
+                m_object_position(leaf) = invalid_index;
+            }
+        }
+
+        /**
+         * Marks the given leaf as a background marker (does nothing if it is already a background marker).
+         */
+        void add_background_marker(index_t leaf) {
+            assert_leaf(leaf);
+            if (m_background_count(leaf) != 0) {
+                return;
+            }
+            m_background_count(leaf) = 1;
+            m_num_background_markers++;
+            index_t n = leaf;
+            while (n != m_root) {
+                n = m_parents(n);
+                if (++m_background_count(n) > 1) {
+                    break;
+                }
+            }
+        }
+
+        /**
+         * Removes the given leaf from the background markers (does nothing if it is not a background marker).
+         */
+        void remove_background_marker(index_t leaf) {
+            assert_leaf(leaf);
+            if (m_background_count(leaf) == 0) {
+                return;
+            }
+            m_background_count(leaf) = 0;
+            m_num_background_markers--;
+            index_t n = leaf;
+            while (n != m_root) {
+                n = m_parents(n);
+                if (--m_background_count(n) > 0) {
+                    break;
+                }
+            }
+        }
+
+        template<typename T>
+        void add_object_markers(const xt::xexpression<T> &xleaves) {
+            for (auto l: xleaves.derived_cast()) {
+                add_object_marker(l);
+            }
+        }
+
+        template<typename T>
+        void remove_object_markers(const xt::xexpression<T> &xleaves) {
+            for (auto l: xleaves.derived_cast()) {
+                remove_object_marker(l);
+            }
+        }
+
+        template<typename T>
+        void add_background_markers(const xt::xexpression<T> &xleaves) {
+            for (auto l: xleaves.derived_cast()) {
+                add_background_marker(l);
+            }
+        }
+
+        template<typename T>
+        void remove_background_markers(const xt::xexpression<T> &xleaves) {
+            for (auto l: xleaves.derived_cast()) {
+                remove_background_marker(l);
+            }
+        }
+
+        index_t num_object_markers() const {
+            return m_object_markers.size();
+        }
+
+        index_t num_background_markers() const {
+            return m_num_background_markers;
+        }
+
+        /**
+         * Nodes whose union is the final object, in increasing order.
+         */
+        array_1d<index_t> object_nodes() {
+            HG_TRACE();
+            std::vector<index_t> nodes;
+            m_stamp++;
+            for (auto l: m_object_markers) {
+                if (m_background_count(l) != 0) {
+                    continue;
+                }
+                index_t n = l;
+                while (m_visited(n) != m_stamp) {
+                    m_visited(n) = m_stamp;
+                    if (n == m_root || m_background_count(m_parents(n)) != 0) {
+                        nodes.push_back(n);
+                        break;
+                    }
+                    n = m_parents(n);
+                }
+            }
+            std::sort(nodes.begin(), nodes.end());
+            array_1d<index_t> res = array_1d<index_t>::from_shape({nodes.size()});
+            std::copy(nodes.begin(), nodes.end(), res.begin());
+            return res;
+        }
+
+        /**
+         * Binary labelisation of the leaves: equal to binary_labelisation_from_markers on the indicator functions of
+         * the current markers.
+         */
+        array_1d<char> labelisation() {
+            HG_TRACE();
+            array_1d<char> res = xt::zeros<char>({m_num_leaves});
+            const index_t *leaves = m_leaf_ranges.leaves().data();
+            for (auto n: object_nodes()) {
+                for (index_t i = m_leaf_ranges.begin(n); i < m_leaf_ranges.end(n); i++) {
+                    res(leaves[i]) = 1;
+                }
+            }
+            return res;
+        }
+
+    private:
+
+        void assert_leaf(index_t leaf) const {
+            hg_assert(leaf >= 0 && leaf < m_num_leaves, "Invalid leaf index.");
+        }
+
+        array_1d<index_t> m_parents;
+        index_t m_num_leaves;
+        index_t m_root;
+        leaf_ranges m_leaf_ranges;
+        array_1d<index_t> m_background_count;
+        index_t m_num_background_markers;
+        std::vector<index_t> m_object_markers;
+        array_1d<index_t> m_object_position;
+        array_1d<index_t> m_visited;
+        index_t m_stamp;
+    };
+
+    /**
+     * Same as binary_labelisation_from_markers where the markers are given by the indices of their leaves: the object
+     * is found from the ancestors of the marker leaves only (see incremental_binary_labelisation).
+     *
+     * @tparam tree_t tree type
+     * @tparam T1 xtensor type
+     * @tparam T2 xtensor type
+     * @param tree input tree
+     * @param xobject_leaves indices of the object marker leaves
+     * @param xbackground_leaves indices of the background marker leaves
+     * @return indicator function of the final_object
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto binary_labelisation_from_marker_leaves(
+            const tree_t &tree,
+            const xt::xexpression<T1> &xobject_leaves,
+            const xt::xexpression<T2> &xbackground_leaves) {
+        HG_TRACE();
+        incremental_binary_labelisation labelisation(tree);
+        labelisation.add_background_markers(xbackground_leaves);
+        labelisation.add_object_markers(xobject_leaves);
+        return labelisation.labelisation();
+    }
+
+    /**
+     * A stack of horizontal cuts of a tree encoded by the nodes of each cut: the nodes of the i-th cut are
+     * nodes[offsets[i]:offsets[i + 1]], sorted in increasing order.
+     *
+     * A cut with r regions only requires r node indices instead of one label per leaf, and the leaf labelisation
+     * of a cut is recovered with labelisation_from_cut_nodes.
+     */
+    struct cut_stack {
+        array_1d<index_t> offsets;
+        array_1d<index_t> nodes;
+
+        index_t num_cuts() const {
+            return (index_t) offsets.size() - 1;
+        }
+
+        auto cut_nodes(index_t i) const {
+            return xt::view(nodes, xt::range(offsets(i), offsets(i + 1)));
+        }
+    };
+
+    namespace tree_internal {
+
+        /**
+         * Builds a cut_stack from the number of nodes of each cut and a function fun(i, out) that writes the nodes
+         * of the i-th cut (in increasing order) starting at the pointer out. Cuts are written in parallel.
+         */
+        template<typename F>
+        auto make_cut_stack(const std::vector<index_t> &sizes, const F &fun) {
+            const index_t num_cuts = sizes.size();
+            array_1d<index_t> offsets = array_1d<index_t>::from_shape({(size_t) num_cuts + 1});
+            offsets(0) = 0;
+            for (index_t i = 0; i < num_cuts; i++) {
+                offsets(i + 1) = offsets(i) + sizes[i];
+            }
+            array_1d<index_t> nodes = array_1d<index_t>::from_shape({(size_t) offsets(num_cuts)});
+            parfor(0, num_cuts, [&fun, &offsets, &nodes](index_t i) {
+                fun(i, nodes.data() + offsets(i));
+            });
+            return cut_stack{std::move(offsets), std::move(nodes)};
+        }
+    }
+
+    /**
+     * Encodes a stack of horizontal cut labelisations (for example given by labelisation_horizontal_cuts_from_thresholds)
+     * by the nodes of each cut (see cut_stack). The labels must be node indices of the tree: the nodes of the i-th
+     * cut are the distinct values of the i-th row of labelisations.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree input tree
+     * @param xlabelisations 2d array of shape (num_cuts, num_leaves(tree))
+     * @return a cut_stack
+     */
+    template<typename tree_t, typename T>
+    auto encode_cut_stack(const tree_t &tree, const xt::xexpression<T> &xlabelisations) {
+        HG_TRACE();
+        auto &labelisations = xlabelisations.derived_cast();
+        hg_assert(labelisations.dimension() == 2, "Labelisations must be a 2d array.");
+        hg_assert((index_t) labelisations.shape()[1] == (index_t) num_leaves(tree),
+                  "The number of columns of labelisations must be equal to the number of leaves of the tree.");
+        const index_t num_cuts = labelisations.shape()[0];
+        const index_t num_l = num_leaves(tree);
+        const index_t num_v = num_vertices(tree);
+
+        std::vector<std::vector<bool>> is_cut_node(num_cuts);
+        std::vector<index_t> sizes(num_cuts);
+        parfor(0, num_cuts, [&](index_t i) {
+            auto &marks = is_cut_node[i];
+            marks.assign(num_v, false);
+            index_t size = 0;
+            for (index_t l = 0; l < num_l; l++) {
+                const index_t n = labelisations(i, l);
+                hg_assert(n >= 0 && n < num_v, "Labels must be node indices of the tree.");
+                if (!marks[n]) {
+                    marks[n] = true;
+                    size++;
+                }
+            }
+            sizes[i] = size;
+        });
+
+        return tree_internal::make_cut_stack(sizes, [&is_cut_node, num_v](index_t i, index_t *out) {
+            auto &marks = is_cut_node[i];
+            for (index_t n = 0; n < num_v; n++) {
+                if (marks[n]) {
+                    *(out++) = n;
+                }
+            }
+            std::vector<bool>().swap(marks);
+        });
+    }
+
+    /**
+     * Stack of horizontal cuts of a hierarchy for several thresholds, encoded by the nodes of each cut (see
+     * cut_stack) and computed without labelling the leaves.
+     *
+     * The i-th cut is the encoding of labelisation_horizontal_cut_from_threshold(tree, altitudes, thresholds(i)):
+     * its nodes are the nodes n such that the altitude of the parent of n is strictly greater than the threshold
+     * (or n is the root) and n is a leaf or the altitude of n is lower than or equal to the threshold. The
+     * altitudes must be increasing (the altitude of a node is lower than or equal to the altitude of its parent).
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param tree input tree
+     * @param xaltitudes increasing node altitudes of the tree
+     * @param xthresholds 1d array of thresholds
+     * @return a cut_stack
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto cut_stack_from_thresholds(const tree_t &tree,
+                                   const xt::xexpression<T1> &xaltitudes,
+                                   const xt::xexpression<T2> &xthresholds) {
+        HG_TRACE();
+        using value_type = typename T1::value_type;
+        auto &altitudes = xaltitudes.derived_cast();
+        auto &thresholds = xthresholds.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        hg_assert_1d_array(thresholds);
+        const index_t num_cuts = thresholds.size();
+        const index_t num_l = num_leaves(tree);
+        const index_t num_v = num_vertices(tree);
+        const index_t root_node = root(tree);
+        auto &par = parents(tree);
+
+        auto is_cut_node = [&](index_t n, value_type threshold) {
+            return (n == root_node || altitudes(par(n)) > threshold) && (n < num_l || altitudes(n) <= threshold);
+        };
+
+        std::vector<index_t> sizes(num_cuts);
+        parfor(0, num_cuts, [&](index_t i) {
+            const auto threshold = static_cast<value_type>(thresholds(i));
+            index_t size = 0;
+            for (index_t n = 0; n < num_v; n++) {
+                size += is_cut_node(n, threshold);
+            }
+            sizes[i] = size;
+        });
+
+        return tree_internal::make_cut_stack(sizes, [&](index_t i, index_t *out) {
+            const auto threshold = static_cast<value_type>(thresholds(i));
+            for (index_t n = 0; n < num_v; n++) {
+                if (is_cut_node(n, threshold)) {
+                    *(out++) = n;
+                }
+            }
+        });
+    }
+
+    /**
+     * Each leaf of the tree takes the weight of its lowest ancestor belonging to the given cut (for example a cut of a
+     * cut_stack given by cut_stack::cut_nodes). This is reconstruct_leaf_data where all the nodes except the cut
+     * nodes are deleted.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param tree input tree
+     * @param altitudes node weights of the tree
+     * @param xcut_nodes 1d array of node indices
+     * @return leaf weights
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto reconstruct_leaf_data_from_cut_nodes(const tree_t &tree,
+                                              const xt::xexpression<T1> &altitudes,
+                                              const xt::xexpression<T2> &xcut_nodes) {
+        HG_TRACE();
+        auto &cut_nodes = xcut_nodes.derived_cast();
+        hg_assert_1d_array(cut_nodes);
+        array_1d<bool> deleted({num_vertices(tree)}, true);
+        for (auto n: cut_nodes) {
+            deleted(n) = false;
+        }
+        return reconstruct_leaf_data(tree, altitudes, deleted);
+    }
+
+    /**
+     * Labelisation of the leaves of the tree given by a horizontal cut encoded by its nodes: the label of a leaf is
+     * the index of its lowest ancestor belonging to the cut. This is the inverse of the encoding performed by
+     * encode_cut_stack for one cut.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree input tree
+     * @param xcut_nodes 1d array of node indices
+     * @return leaf labels
+     */
+    template<typename tree_t, typename T>
+    auto labelisation_from_cut_nodes(const tree_t &tree, const xt::xexpression<T> &xcut_nodes) {
+        return reconstruct_leaf_data_from_cut_nodes(tree, xt::arange<index_t>(num_vertices(tree)), xcut_nodes);
+    }
+
     /**
      * Sort the nodes of a tree according to their altitudes.
      * The altitudes must be increasing, i.e. for any nodes i, j such that j is an ancestor of j, then
@@ -350,6 +1243,11 @@ namespace hg {
      * The latter condition is stronger than the original condition on the altitudes as j is an ancestor of i implies
      * i<j while the converse is not true.
      *
+     * If the altitudes are already sorted, the result shares the parents array of the input tree. If they are made of
+     * a few sorted runs (for example when only a few non leaf nodes are out of order), the nodes are sorted by merging
+     * the runs (see stable_arg_sort_runs) in :math:`\mathcal{O}(n\log(r))` with :math:`r` the number of runs;
+     * otherwise, they are sorted with stable_arg_sort. The tree is then remapped in parallel.
+     *
      * Note that the altitudes of the new tree can be obtained with:
      *
      *  auto res = sort_hierarchy_with_altitudes(tree, altitudes);
@@ -371,20 +1269,277 @@ namespace hg {
         hg_assert_node_weights(tree, altitudes);
         hg_assert_1d_array(altitudes);
 
-        array_1d<index_t> sorted = stable_arg_sort(altitudes);
+        auto num_runs = count_sorted_runs(altitudes);
+        if (num_runs <= 1) {
+            // the tree is already sorted: it shares its parents array with the input tree
+            hg::tree sorted_tree(tree);
+            sorted_tree.set_layout(tree_layout::altitude_sorted);
+            return make_remapped_tree(std::move(sorted_tree), array_1d<index_t>(xt::arange<index_t>(num_vertices(tree))));
+        }
 
+        // almost sorted altitudes (a few nodes out of order) are sorted by merging their sorted runs
+        const index_t max_merged_runs = 16;
+        array_1d<index_t> sorted = (num_runs <= max_merged_runs) ?
+                                   stable_arg_sort_runs(altitudes) :
+                                   stable_arg_sort(altitudes);
+
+        const index_t num_v = sorted.size();
         array_1d<index_t> reverse_sorted = xt::empty_like(sorted);
-        for (index_t i = 0; i < (index_t) reverse_sorted.size(); i++) {
+        parfor(0, num_v, [&reverse_sorted, &sorted](index_t i) {
             reverse_sorted(sorted(i)) = i;
-        }
+        });
 
         auto &par = parents(tree);
         array_1d<index_t> new_par = xt::empty_like(sorted);
-        for (index_t i = 0; i < (index_t) reverse_sorted.size(); i++) {
+        parfor(0, num_v, [&new_par, &reverse_sorted, &sorted, &par](index_t i) {
             new_par(i) = reverse_sorted(par(sorted(i)));
+        });
+
+        hg::tree sorted_tree(std::move(new_par), tree.category());
+        sorted_tree.set_layout(tree_layout::altitude_sorted);
+        return make_remapped_tree(std::move(sorted_tree), std::move(sorted));
+    };
+
+    /**
+     * Reorder the nodes of a tree according to the given layout (see tree_layout).
+     *
+     * The result is a new tree and a node map, isomorph to the input tree, such that the node map associates each
+     * node of the new tree to its corresponding node in the input tree. The layout of the new tree is set to the
+     * given layout.
+     *
+     * If the tree already has the requested layout, or if the requested layout is topological, the tree is not
+     * reordered: the result shares the parents array of the input tree and the node map is the identity.
+     *
+     * The post-order layout stores the leaves, and then the non leaf nodes, in the order in which they are visited by
+     * a depth first post-order traversal of the tree (children being visited by increasing index).
+     * The altitude sorted layout requires altitudes, see sort_hierarchy_with_altitudes.
+     *
+     * :Complexity:
+     *
+     * The tree is reordered in linear time :math:`\mathcal{O}(n)` with :math:`n` the number of vertices in the tree.
+     *
+     * @tparam tree_t
+     * @param tree
+     * @param layout
+     * @return
+     */
+    template<typename tree_t>
+    auto relayout_tree(const tree_t &tree, tree_layout layout) {
+        HG_TRACE();
+        hg_assert(layout != tree_layout::altitude_sorted,
+                  "Altitudes are required to sort a tree, see sort_hierarchy_with_altitudes.");
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+
+        if (layout == tree_layout::topological || tree.layout() == layout) {
+            return make_remapped_tree(hg::tree(tree), array_1d<index_t>(xt::arange<index_t>(num_v)));
+        }
+
+        /*
+         * Number of leaves and of non leaf nodes in each sub tree
+         */
+        array_1d<index_t> leaf_size = xt::zeros<index_t>({num_v});
+        array_1d<index_t> non_leaf_size = xt::zeros<index_t>({num_v});
+        xt::view(leaf_size, xt::range(0, num_l)) = 1;
+        xt::view(non_leaf_size, xt::range(num_l, num_v)) = 1;
+        for (index_t i = 0; i < num_v - 1; i++) {
+            auto p = parent(i, tree);
+            leaf_size(p) += leaf_size(i);
+            non_leaf_size(p) += non_leaf_size(i);
+        }
+
+        /*
+         * The sub tree of a node n owns two ranges of new indices, one for its leaves and one for its non leaf nodes,
+         * the last one being n itself. The ranges of the children of n are allocated from the end of the ranges of n
+         * (cursors are exclusive ends), by decreasing index of the children.
+         */
+        array_1d<index_t> new_index = array_1d<index_t>::from_shape({(size_t) num_v});
+        array_1d<index_t> &leaf_cursor = leaf_size;
+        array_1d<index_t> &non_leaf_cursor = non_leaf_size;
+        new_index(num_v - 1) = num_v - 1;
+        leaf_cursor(num_v - 1) = num_l;
+        non_leaf_cursor(num_v - 1) = num_v - 1;
+        for (index_t i = num_v - 2; i >= 0; i--) {
+            auto p = parent(i, tree);
+            if (i < num_l) {
+                leaf_cursor(p)--;
+                new_index(i) = leaf_cursor(p);
+            } else {
+                auto num_sub_leaves = leaf_size(i);
+                auto num_sub_non_leaves = non_leaf_size(i);
+                new_index(i) = non_leaf_cursor(p) - 1;
+                non_leaf_cursor(i) = new_index(i);
+                non_leaf_cursor(p) -= num_sub_non_leaves;
+                leaf_cursor(i) = leaf_cursor(p);
+                leaf_cursor(p) -= num_sub_leaves;
+            }
+        }
+
+        array_1d<index_t> new_parents = array_1d<index_t>::from_shape({(size_t) num_v});
+        array_1d<index_t> node_map = array_1d<index_t>::from_shape({(size_t) num_v});
+        for (index_t i = 0; i < num_v; i++) {
+            new_parents(new_index(i)) = new_index(parent(i, tree));
+            node_map(new_index(i)) = i;
+        }
+
+        hg::tree new_tree(std::move(new_parents), tree.category());
+        new_tree.set_layout(layout);
+        return make_remapped_tree(std::move(new_tree), std::move(node_map));
+    };
+
+    /**
+     * Reorder the nodes of a tree according to the given layout (see tree_layout) and to the given altitudes.
+     *
+     * Equivalent to sort_hierarchy_with_altitudes(tree, altitudes) for the altitude sorted layout and to
+     * relayout_tree(tree, layout) otherwise.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree
+     * @param layout
+     * @param xaltitudes
+     * @return
+     */
+    template<typename tree_t, typename T>
+    auto relayout_tree(const tree_t &tree, tree_layout layout, const xt::xexpression<T> &xaltitudes) {
+        if (layout == tree_layout::altitude_sorted) {
+            return sort_hierarchy_with_altitudes(tree, xaltitudes);
+        }
+        return relayout_tree(tree, layout);
+    };
+
+    namespace tree_internal {
+
+        /**
+         * Number of nodes in each sub tree.
+         */
+        template<typename tree_t>
+        auto sub_tree_sizes(const tree_t &tree) {
+            const index_t num_v = num_vertices(tree);
+            array_1d<index_t> size = xt::ones<index_t>({(size_t) num_v});
+            for (index_t i = 0; i < num_v - 1; i++) {
+                size(parent(i, tree)) += size(i);
+            }
+            return size;
+        }
+
+        template<typename T>
+        auto invert_permutation(const T &position) {
+            array_1d<index_t> order = array_1d<index_t>::from_shape({position.size()});
+            for (index_t i = 0; i < (index_t) position.size(); i++) {
+                order(position(i)) = i;
+            }
+            return order;
+        }
+    }
+
+    /**
+     * Nodes of the tree in the order in which they are visited by a depth first pre-order traversal (children being
+     * visited by increasing index): the root comes first and each node is followed by the nodes of its sub tree.
+     *
+     * The traversal is computed without stack from the sizes of the sub trees, in linear time.
+     *
+     * @tparam tree_t
+     * @param tree
+     * @return a permutation of the nodes of the tree
+     */
+    template<typename tree_t>
+    auto tree_preorder(const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        // position of each node in the traversal, the sub tree of a node n occupies [position(n), position(n) + size(n))
+        // the ranges of the children of n are allocated from the end of the range of n by decreasing index
+        array_1d<index_t> cursor = tree_internal::sub_tree_sizes(tree);
+        array_1d<index_t> position = array_1d<index_t>::from_shape({(size_t) num_v});
+        position(num_v - 1) = 0;
+        cursor(num_v - 1) = num_v;
+        for (index_t i = num_v - 2; i >= 0; i--) {
+            auto p = parent(i, tree);
+            auto size = cursor(i);
+            cursor(p) -= size;
+            position(i) = cursor(p);
+            cursor(i) = position(i) + size;
+        }
+        return tree_internal::invert_permutation(position);
+    };
+
+    /**
+     * Nodes of the tree in the order in which they are visited by a depth first post-order traversal (children being
+     * visited by increasing index): each node is preceded by the nodes of its sub tree and the root comes last.
+     *
+     * The traversal is computed without stack from the sizes of the sub trees, in linear time.
+     *
+     * @tparam tree_t
+     * @param tree
+     * @return a permutation of the nodes of the tree
+     */
+    template<typename tree_t>
+    auto tree_postorder(const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        // position of each node in the traversal, the sub tree of a node n occupies (position(n) - size(n), position(n)]
+        // the ranges of the children of n are allocated from the end of the range of n by decreasing index
+        array_1d<index_t> cursor = tree_internal::sub_tree_sizes(tree);
+        array_1d<index_t> position = array_1d<index_t>::from_shape({(size_t) num_v});
+        position(num_v - 1) = num_v - 1;
+        cursor(num_v - 1) = num_v - 1;
+        for (index_t i = num_v - 2; i >= 0; i--) {
+            auto p = parent(i, tree);
+            auto size = cursor(i);
+            position(i) = cursor(p) - 1;
+            cursor(p) -= size;
+            cursor(i) = position(i);
         }
+        return tree_internal::invert_permutation(position);
+    };
 
-        return make_remapped_tree(hg::tree(std::move(new_par), tree.category()), std::move(sorted));
+    /**
+     * A simple structure to hold the result of tree_depth_levels: the nodes of the tree sorted by increasing depth
+     * and the offsets of each depth level in this array.
+     */
+    struct tree_levels {
+        array_1d<index_t> nodes;
+        array_1d<index_t> offsets;
+    };
+
+    /**
+     * Nodes of the tree sorted by increasing depth, the root having depth 0 (breadth first order, nodes of a same
+     * depth being sorted by increasing index): the nodes of depth d are nodes[offsets[d], offsets[d + 1]).
+     *
+     * Processing the levels from the last to the first one (resp. from the first to the last one) is a bottom-up
+     * (resp. top-down) traversal of the tree in which all the nodes of a level can be processed in parallel.
+     *
+     * The levels are computed with a counting sort on the depth of the nodes, in linear time.
+     *
+     * @tparam tree_t
+     * @param tree
+     * @return a tree_levels structure
+     */
+    template<typename tree_t>
+    auto tree_depth_levels(const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        array_1d<index_t> depth = array_1d<index_t>::from_shape({(size_t) num_v});
+        depth(num_v - 1) = 0;
+        index_t max_depth = 0;
+        for (index_t i = num_v - 2; i >= 0; i--) {
+            depth(i) = depth(parent(i, tree)) + 1;
+            max_depth = (std::max)(max_depth, depth(i));
+        }
+
+        array_1d<index_t> offsets = xt::zeros<index_t>({(size_t) max_depth + 2});
+        for (index_t i = 0; i < num_v; i++) {
+            offsets(depth(i) + 1)++;
+        }
+        for (index_t d = 1; d <= max_depth + 1; d++) {
+            offsets(d) += offsets(d - 1);
+        }
+        array_1d<index_t> nodes = array_1d<index_t>::from_shape({(size_t) num_v});
+        array_1d<index_t> cursor = xt::view(offsets, xt::range(0, max_depth + 1));
+        for (index_t i = 0; i < num_v; i++) {
+            nodes(cursor(depth(i))++) = i;
+        }
+        return tree_levels{std::move(nodes), std::move(offsets)};
     };
 
     /**
@@ -461,4 +1616,155 @@ namespace hg {
         return make_remapped_tree(hg::tree(std::move(new_parents), tree.category()), std::move(node_map));
 
     }
+
+    /**
+     * Result of sub_trees: the sub trees extracted from a tree and their node maps.
+     *
+     * The parent relations of all the sub trees are stored in a single buffer shared by the trees, and the node maps
+     * are stored consecutively in a single array: the node map of the i-th sub tree is the range
+     * [offsets(i), offsets(i + 1)) of node_map.
+     */
+    struct sub_trees_result {
+        std::vector<hg::tree> trees;
+        array_1d<index_t> node_map;
+        array_1d<index_t> offsets;
+
+        auto node_map_of(index_t i) const {
+            return xt::view(node_map, xt::range(offsets(i), offsets(i + 1)));
+        }
+    };
+
+    /**
+     * Extract the sub trees rooted in the given nodes from the given tree.
+     *
+     * The i-th sub tree and its node map are equal to the result of sub_tree(tree, roots(i)).
+     *
+     * The nodes of the tree are first ordered in pre-order, in a single pass that does not require the children
+     * relation, such that the nodes of any sub tree form a contiguous range of this ordering. The sub trees are then
+     * extracted from their ranges and their parent relations are written in a single shared buffer, without any
+     * allocation per sub tree. If the tree has a post-order layout (see relayout_tree), the nodes of any sub tree are
+     * already two contiguous and sorted ranges: the pre-order and the sorts are skipped and the sub trees are
+     * extracted in linear time.
+     *
+     * :Complexity:
+     *
+     * The sub trees are constructed in time :math:`\mathcal{O}(N + \sum_i n_i\log(n_i))` with :math:`N` the number
+     * of vertices in the tree and :math:`n_i` the number of vertices in the i-th sub tree.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree
+     * @param xroots 1d array of nodes of the tree
+     * @return a sub_trees_result
+     */
+    template<typename tree_t, typename T>
+    auto sub_trees(const tree_t &tree, const xt::xexpression<T> &xroots) {
+        HG_TRACE();
+        auto &roots = xroots.derived_cast();
+        hg_assert_1d_array(roots);
+        hg_assert_integral_value_type(roots);
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        const index_t num_roots = roots.size();
+
+        array_1d<index_t> size = xt::ones<index_t>({num_v});
+        for (index_t i = 0; i < num_v - 1; i++) {
+            size(parent(i, tree)) += size(i);
+        }
+
+        // with a post-order layout, the leaves and the non leaf nodes of a sub tree are two contiguous ranges of nodes
+        const bool post_order = tree.layout() == tree_layout::post_order;
+        array_1d<index_t> first_leaf;
+        array_1d<index_t> leaf_size;
+        // otherwise, pre-order position of each node: the sub tree rooted in n occupies [position(n), position(n) + size(n))
+        array_1d<index_t> position;
+        array_1d<index_t> cursor;
+        array_1d<index_t> order;
+
+        if (post_order) {
+            first_leaf = xt::arange<index_t>(num_v);
+            leaf_size = xt::zeros<index_t>({num_v});
+            xt::view(leaf_size, xt::range(0, num_l)) = 1;
+            for (index_t i = 0; i < num_v - 1; i++) {
+                auto p = parent(i, tree);
+                first_leaf(p) = (std::min)(first_leaf(p), first_leaf(i));
+                leaf_size(p) += leaf_size(i);
+            }
+        } else {
+            position = array_1d<index_t>::from_shape({(size_t) num_v});
+            cursor = array_1d<index_t>::from_shape({(size_t) num_v});
+            order = array_1d<index_t>::from_shape({(size_t) num_v});
+            position(num_v - 1) = 0;
+            cursor(num_v - 1) = 1;
+            order(0) = num_v - 1;
+            for (index_t i = num_v - 2; i >= 0; i--) {
+                auto p = parent(i, tree);
+                position(i) = cursor(p);
+                cursor(i) = position(i) + 1;
+                cursor(p) += size(i);
+                order(position(i)) = i;
+            }
+        }
+
+        /*
+         * Extract sub trees
+         */
+        array_1d<index_t> offsets = array_1d<index_t>::from_shape({(size_t) num_roots + 1});
+        offsets(0) = 0;
+        for (index_t i = 0; i < num_roots; i++) {
+            hg_assert_vertex_index(tree, (index_t) roots(i));
+            offsets(i + 1) = offsets(i) + size(roots(i));
+        }
+
+        const index_t total_size = offsets(num_roots);
+        auto parents_buffer = std::make_shared<array_1d<index_t>>(array_1d<index_t>::from_shape({(size_t) total_size}));
+        auto &new_parents = *parents_buffer;
+        array_1d<index_t> node_map = array_1d<index_t>::from_shape({(size_t) total_size});
+        auto &rank = cursor;
+
+        std::vector<hg::tree> trees;
+        trees.reserve(num_roots);
+        for (index_t i = 0; i < num_roots; i++) {
+            const index_t root = roots(i);
+            const index_t begin = offsets(i);
+            const index_t end = offsets(i + 1);
+            index_t sub_num_leaves;
+
+            if (post_order) {
+                sub_num_leaves = leaf_size(root);
+                const index_t first_non_leaf = root - (size(root) - sub_num_leaves) + 1;
+                for (index_t j = 0; j < sub_num_leaves; j++) {
+                    node_map(begin + j) = first_leaf(root) + j;
+                }
+                for (index_t j = begin + sub_num_leaves; j < end; j++) {
+                    node_map(j) = first_non_leaf + j - begin - sub_num_leaves;
+                }
+                for (index_t j = begin; j < end - 1; j++) {
+                    new_parents(j) = sub_num_leaves + parent(node_map(j), tree) - first_non_leaf;
+                }
+            } else {
+                auto nm_begin = node_map.begin() + begin;
+                auto nm_end = node_map.begin() + end;
+                std::copy(order.begin() + position(root), order.begin() + position(root) + size(root), nm_begin);
+                std::sort(nm_begin, nm_end);
+
+                for (index_t j = begin; j < end; j++) {
+                    rank(node_map(j)) = j - begin;
+                }
+                for (index_t j = begin; j < end - 1; j++) {
+                    new_parents(j) = rank(parent(node_map(j), tree));
+                }
+                sub_num_leaves = std::lower_bound(nm_begin, nm_end, num_l) - nm_begin;
+            }
+            new_parents(end - 1) = end - 1 - begin;
+
+            trees.emplace_back(new_parents.data() + begin, (size_t) (end - begin), parents_buffer,
+                               tree.category(), sub_num_leaves);
+            if (post_order) {
+                trees.back().set_layout(tree_layout::post_order);
+            }
+        }
+
+        return sub_trees_result{std::move(trees), std::move(node_map), std::move(offsets)};
+    }
 }
@@ -18,10 +18,15 @@
 #include "xtensor/xnoalias.hpp"
 #include "higra/accumulator/accumulator.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
+#include "higra/algo/tree.hpp"
 #include "higra/graph.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
 #include "higra/hierarchy/binary_partition_tree.hpp"
 
+#ifdef XTENSOR_USE_XSIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
 
 namespace hg {
 
@@ -272,6 +277,346 @@ namespace hg {
             std::deque<lp_t> pieces;
         };
 
+        /**
+         * Minimum over k in [0, n) of the values at the abscissa x of the lines passing through the points
+         * (origin_x[k], origin_y[k]) with the slopes slope[k].
+         */
+        template<typename value_type>
+        value_type min_lines(const value_type *origin_x, const value_type *origin_y, const value_type *slope,
+                             index_t n, value_type x, std::false_type) {
+            value_type result = std::numeric_limits<value_type>::infinity();
+            for (index_t k = 0; k < n; k++) {
+                result = (std::min)(result, (value_type) (origin_y[k] + slope[k] * (x - origin_x[k])));
+            }
+            return result;
+        }
+
+#ifdef XTENSOR_USE_XSIMD
+
+        template<typename value_type>
+        value_type min_lines(const value_type *origin_x, const value_type *origin_y, const value_type *slope,
+                             index_t n, value_type x, std::true_type) {
+            constexpr index_t batch_size = xsimd::simd_traits<value_type>::size;
+            const index_t simd_size = n - n % batch_size;
+            value_type result = std::numeric_limits<value_type>::infinity();
+            if (simd_size > 0) {
+                const xsimd::simd_type<value_type> bx(x);
+                auto bmin = xsimd::load_unaligned(origin_y) +
+                            xsimd::load_unaligned(slope) * (bx - xsimd::load_unaligned(origin_x));
+                for (index_t k = batch_size; k < simd_size; k += batch_size) {
+                    bmin = xsimd::min(bmin, xsimd::load_unaligned(origin_y + k) +
+                                            xsimd::load_unaligned(slope + k) *
+                                            (bx - xsimd::load_unaligned(origin_x + k)));
+                }
+                value_type values[batch_size];
+                xsimd::store_unaligned(values, bmin);
+                for (index_t k = 0; k < batch_size; k++) {
+                    result = (std::min)(result, values[k]);
+                }
+            }
+            return (std::min)(result, min_lines(origin_x + simd_size, origin_y + simd_size, slope + simd_size,
+                                                n - simd_size, x, std::false_type()));
+        }
+
+        template<typename value_type>
+        value_type min_lines(const value_type *origin_x, const value_type *origin_y, const value_type *slope,
+                             index_t n, value_type x) {
+            return min_lines(origin_x, origin_y, slope, n, x, std::integral_constant<bool,
+                    std::is_floating_point<value_type>::value && (xsimd::simd_traits<value_type>::size > 1)>());
+        }
+
+#else
+
+        template<typename value_type>
+        value_type min_lines(const value_type *origin_x, const value_type *origin_y, const value_type *slope,
+                             index_t n, value_type x) {
+            return min_lines(origin_x, origin_y, slope, n, x, std::false_type());
+        }
+
+#endif
+
+        /**
+         * Set of piecewise linear energy functions (see piecewise_linear_energy_function) stored in a single arena
+         * with a structure of arrays layout.
+         *
+         * Each function is identified by a slot: the k-th piece of the function in the slot f is stored at the
+         * position f * capacity() + k of the arrays of origins and slopes. Slots are obtained with allocate and
+         * given back with release: released slots are reused, so that the memory footprint is proportional to the
+         * maximal number of functions alive at the same time and no allocation occurs once the arena is warm.
+         *
+         * The capacity (maximal number of pieces of a function) is increased automatically if needed.
+         *
+         * The operations of the arena are not thread safe (sum uses an internal scratch buffer).
+         */
+        template<typename value_type=double>
+        class piecewise_linear_energy_function_arena {
+
+        public:
+            using lp_t = piecewise_linear_energy_function_piece<value_type>;
+            using lef_t = piecewise_linear_energy_function<value_type>;
+
+            /**
+             * @param capacity initial maximal number of pieces of a function
+             * @param num_slots number of slots to reserve
+             */
+            piecewise_linear_energy_function_arena(index_t capacity, index_t num_slots = 0) :
+                    m_capacity((std::max)(capacity, (index_t) 1)) {
+                reserve(num_slots);
+                resize_scratch();
+            }
+
+            index_t capacity() const {
+                return m_capacity;
+            }
+
+            /**
+             * Returns a slot holding an empty function
+             */
+            index_t allocate() {
+                index_t f;
+                if (m_free_slots.empty()) {
+                    f = m_size.size();
+                    m_size.push_back(0);
+                    m_origin_x.resize(m_size.size() * m_capacity);
+                    m_origin_y.resize(m_size.size() * m_capacity);
+                    m_slope.resize(m_size.size() * m_capacity);
+                } else {
+                    f = m_free_slots.back();
+                    m_free_slots.pop_back();
+                    m_size[f] = 0;
+                }
+                return f;
+            }
+
+            /**
+             * The given slot can be reused by a further call to allocate
+             */
+            void release(index_t f) {
+                m_free_slots.push_back(f);
+            }
+
+            void reserve(index_t num_slots) {
+                m_size.reserve(num_slots);
+                m_origin_x.reserve(num_slots * m_capacity);
+                m_origin_y.reserve(num_slots * m_capacity);
+                m_slope.reserve(num_slots * m_capacity);
+            }
+
+            /**
+             * Number of pieces of the function in the slot f
+             */
+            index_t size(index_t f) const {
+                return m_size[f];
+            }
+
+            lp_t piece(index_t f, index_t k) const {
+                const index_t i = f * m_capacity + k;
+                return lp_t(m_origin_x[i], m_origin_y[i], m_slope[i]);
+            }
+
+            /**
+             * The function in the slot f becomes the given function
+             */
+            void set(index_t f, const lef_t &function) {
+                ensure_capacity(function.size());
+                m_size[f] = function.size();
+                index_t i = f * m_capacity;
+                for (const auto &p: function) {
+                    write(i++, p.origin_x(), p.origin_y(), p.slope());
+                }
+            }
+
+            /**
+             * The function in the slot f becomes the function made of the single given piece
+             */
+            void set(index_t f, const lp_t &piece) {
+                m_size[f] = 1;
+                write(f * m_capacity, piece.origin_x(), piece.origin_y(), piece.slope());
+            }
+
+            /**
+             * Copy of the function in the slot f
+             */
+            lef_t function(index_t f) const {
+                lef_t result;
+                for (index_t k = 0; k < m_size[f]; k++) {
+                    result.add_piece(piece(f, k));
+                }
+                return result;
+            }
+
+            /**
+             * The function in the slot destination becomes a copy of the function in the slot source
+             */
+            void copy(index_t destination, index_t source) {
+                if (destination == source) {
+                    return;
+                }
+                m_size[destination] = m_size[source];
+                const index_t d = destination * m_capacity;
+                const index_t s = source * m_capacity;
+                std::copy_n(m_origin_x.begin() + s, m_size[source], m_origin_x.begin() + d);
+                std::copy_n(m_origin_y.begin() + s, m_size[source], m_origin_y.begin() + d);
+                std::copy_n(m_slope.begin() + s, m_size[source], m_slope.begin() + d);
+            }
+
+            /**
+             * The function in the slot destination becomes the sum of the functions in the slots f1 and f2 (see
+             * piecewise_linear_energy_function::sum, the result is identical). The destination may be equal to f1
+             * or f2.
+             */
+            void sum(index_t destination, index_t f1, index_t f2, int max_pieces = 10) {
+                if (m_size[f2] == 0) {
+                    copy(destination, f1);
+                    return;
+                } else if (m_size[f1] == 0) {
+                    copy(destination, f2);
+                    return;
+                }
+
+                ensure_capacity((std::min)((index_t) max_pieces, m_size[f1] + m_size[f2]));
+                // the pieces of the result are computed from right to left in the scratch buffer
+                const index_t b1 = f1 * m_capacity;
+                const index_t b2 = f2 * m_capacity;
+                index_t count = 0;
+                index_t i1 = m_size[f1] - 1;
+                index_t i2 = m_size[f2] - 1;
+                while (i1 >= 0 && i2 >= 0 && count < max_pieces) {
+                    const index_t p1 = b1 + i1;
+                    const index_t p2 = b2 + i2;
+                    m_scratch_slope[count] = m_slope[p1] + m_slope[p2];
+                    if (m_origin_x[p1] >= m_origin_x[p2]) {
+                        m_scratch_origin_x[count] = m_origin_x[p1];
+                        m_scratch_origin_y[count] = m_origin_y[p1] + line(p2, m_origin_x[p1]);
+                        if (m_origin_x[p1] == m_origin_x[p2]) {
+                            i2--;
+                        }
+                        i1--;
+                    } else {
+                        m_scratch_origin_x[count] = m_origin_x[p2];
+                        m_scratch_origin_y[count] = m_origin_y[p2] + line(p1, m_origin_x[p2]);
+                        i2--;
+                    }
+                    count++;
+                }
+
+                m_size[destination] = count;
+                const index_t d = destination * m_capacity;
+                for (index_t k = 0; k < count; k++) {
+                    write(d + k,
+                          m_scratch_origin_x[count - 1 - k],
+                          m_scratch_origin_y[count - 1 - k],
+                          m_scratch_slope[count - 1 - k]);
+                }
+                if (m_origin_x[d] > 0) {
+                    m_origin_y[d] -= m_slope[d] * m_origin_x[d];
+                    m_origin_x[d] = 0;
+                }
+            }
+
+            /**
+             * Infimum between the function in the slot f and the given linear piece (see
+             * piecewise_linear_energy_function::infimum, the result is identical).
+             *
+             * Warning: Modification is done in place
+             */
+            double infimum(index_t f, const lp_t &linear_piece) {
+                const index_t b = f * m_capacity;
+                index_t i = m_size[f] - 1;
+
+                if (linear_piece.slope() == m_slope[b + i]) {
+                    auto y = linear_piece(m_origin_x[b + i]);
+                    if (y > m_origin_y[b + i]) {
+                        return std::numeric_limits<value_type>::infinity();
+                    } else if (y == m_origin_y[b + i]) {
+                        return m_origin_x[b + i];
+                    } else {
+                        i--;
+                    }
+                }
+
+                value_type xi = 0;
+                while (i >= 0) {
+                    const index_t p = b + i;
+                    xi = (linear_piece.origin_x() * linear_piece.slope() - m_origin_x[p] * m_slope[p] -
+                          (linear_piece.origin_y() - m_origin_y[p])) / (linear_piece.slope() - m_slope[p]);
+                    i--;
+                    if (xi > m_origin_x[p]) {
+                        // the piece is kept
+                        i++;
+                        break;
+                    }
+                }
+                // pieces i + 1, ... are replaced by the new piece
+                ensure_capacity(i + 2);
+                m_size[f] = i + 2;
+                write(f * m_capacity + i + 1, xi, linear_piece(xi), linear_piece.slope());
+                return xi;
+            }
+
+            /**
+             * Value of the function in the slot f at the abscissa x.
+             *
+             * As an energy function is concave, its value is the minimum of the values of the lines supporting its
+             * pieces: the lines are evaluated with xsimd batches if available.
+             */
+            value_type operator()(index_t f, value_type x) const {
+                const index_t b = f * m_capacity;
+                return min_lines(&m_origin_x[b], &m_origin_y[b], &m_slope[b], m_size[f], x);
+            }
+
+        private:
+
+            value_type line(index_t i, value_type x) const {
+                return m_origin_y[i] + m_slope[i] * (x - m_origin_x[i]);
+            }
+
+            void write(index_t i, value_type origin_x, value_type origin_y, value_type slope) {
+                m_origin_x[i] = origin_x;
+                m_origin_y[i] = origin_y;
+                m_slope[i] = slope;
+            }
+
+            void resize_scratch() {
+                m_scratch_origin_x.resize(m_capacity);
+                m_scratch_origin_y.resize(m_capacity);
+                m_scratch_slope.resize(m_capacity);
+            }
+
+            /**
+             * Relayouts the arena if its capacity is smaller than the given number of pieces
+             */
+            void ensure_capacity(index_t num_pieces) {
+                if (num_pieces <= m_capacity) {
+                    return;
+                }
+                const index_t new_capacity = (std::max)(num_pieces, 2 * m_capacity);
+                const index_t num_slots = m_size.size();
+                auto relayout = [this, new_capacity, num_slots](std::vector<value_type> &v) {
+                    std::vector<value_type> r(num_slots * new_capacity);
+                    for (index_t f = 0; f < num_slots; f++) {
+                        std::copy_n(v.begin() + f * m_capacity, m_size[f], r.begin() + f * new_capacity);
+                    }
+                    v.swap(r);
+                };
+                relayout(m_origin_x);
+                relayout(m_origin_y);
+                relayout(m_slope);
+                m_capacity = new_capacity;
+                resize_scratch();
+            }
+
+            index_t m_capacity;
+            std::vector<index_t> m_size;
+            std::vector<value_type> m_origin_x;
+            std::vector<value_type> m_origin_y;
+            std::vector<value_type> m_slope;
+            std::vector<index_t> m_free_slots;
+            std::vector<value_type> m_scratch_origin_x;
+            std::vector<value_type> m_scratch_origin_y;
+            std::vector<value_type> m_scratch_slope;
+        };
+
         // stupid template metaprogramming for bpt function
         template<bool vectorial>
         struct container_bpt {
@@ -306,46 +651,71 @@ namespace hg {
         struct computation_helper {
         };
 
+        /**
+         * Per band kernels of the vectorial Mumford-Shah energy: the sums of the bands of a region are contiguous
+         * (row of a row major array), the loops are vectorized by the compiler.
+         */
+        HG_SIMD_DISPATCH
+        inline void add_bands(double *res, const double *a, const double *b, index_t num_bands) {
+            for (index_t c = 0; c < num_bands; c++) {
+                res[c] = a[c] + b[c];
+            }
+        }
+
+        /**
+         * Sum over the bands c of m2[c] - m[c]^2 / area
+         */
+        HG_SIMD_DISPATCH
+        inline double data_fidelity_bands(const double *m, const double *m2, double area, index_t num_bands) {
+            double res = 0;
+            for (index_t c = 0; c < num_bands; c++) {
+                res += m2[c] - m[c] * m[c] / area;
+            }
+            return res;
+        }
+
+        /**
+         * Sum over the bands c of (mi2[c] + mj2[c]) - (mi[c] + mj[c])^2 / area
+         */
+        HG_SIMD_DISPATCH
+        inline double merged_data_fidelity_bands(const double *mi, const double *mj,
+                                                 const double *mi2, const double *mj2,
+                                                 double area, index_t num_bands) {
+            double res = 0;
+            for (index_t c = 0; c < num_bands; c++) {
+                double mean = mi[c] + mj[c];
+                double mean2 = mi2[c] + mj2[c];
+                res += mean2 - mean * mean / area;
+            }
+            return res;
+        }
+
         template<>
         struct computation_helper<true> {
 
             template<typename T>
             static
             void add(T &a, index_t res, index_t i, index_t j) {
-                for (index_t c = 0; c < (index_t) a.shape()[1]; c++) {
-                    a(res, c) = a(i, c) + a(j, c);
-                }
+                const index_t num_bands = a.shape()[1];
+                add_bands(&a(res, 0), &a(i, 0), &a(j, 0), num_bands);
             }
 
             template<typename T, typename Q>
             static
             auto
             data_fidelity(const T &m, const T &m2, const Q &area, index_t i) {
-                double res = 0;
-                for (index_t c = 0; c < (index_t) m.shape()[1]; c++) {
-                    res += m2(i, c) - m(i, c) * m(i, c) / area(i);
-                }
-                return res;
+                return data_fidelity_bands(&m(i, 0), &m2(i, 0), area(i), m.shape()[1]);
             }
 
-            template<typename Q, typename T, typename R>
+            /**
+             * Data fidelity of the union of the regions i and j
+             */
+            template<typename T, typename R>
             static
-            auto
-            apparition_scale(const Q &oe, const T &area, const T &perimeter, const R &m, const R &m2,
-                             index_t i, index_t j, double edge_length) {
-                auto e = oe[i].sum(oe[j]);
-                double a = area(i) + area(j);
-                double data_fidelity = 0;
-                for (index_t c = 0; c < (index_t) m.shape()[1]; c++) {
-                    double mean = m(i, c) + m(j, c);
-                    double mean2 = m2(i, c) + m2(j, c);
-                    data_fidelity += mean2 - mean * mean / a;
-                }
-
-                auto v = e.infimum({0,
-                                    data_fidelity,
-                                    perimeter(i) + perimeter(j) - 2 * edge_length});
-                return v;
+            double
+            merged_data_fidelity(const T &area, const R &m, const R &m2, index_t i, index_t j) {
+                return merged_data_fidelity_bands(&m(i, 0), &m(j, 0), &m2(i, 0), &m2(j, 0), area(i) + area(j),
+                                                  m.shape()[1]);
             }
 
         };
@@ -366,21 +736,14 @@ namespace hg {
                 return m2(i) - m(i) * m(i) / area(i);
             }
 
-            template<typename Q, typename T, typename R>
+            template<typename T, typename R>
             static
-            auto
-            apparition_scale(const Q &oe, const T &area, const T &perimeter, const R &m, const R &m2,
-                             index_t i, index_t j, double edge_length) {
-                auto e = oe[i].sum(oe[j]);
-
+            double
+            merged_data_fidelity(const T &area, const R &m, const R &m2, index_t i, index_t j) {
                 double mean = m(i) + m(j);
                 double mean2 = m2(i) + m2(j);
                 double a = area(i) + area(j);
-
-                auto v = e.infimum({0,
-                                    mean2 - mean * mean / a,
-                                    perimeter(i) + perimeter(j) - 2 * edge_length});
-                return v;
+                return mean2 - mean * mean / a;
             }
 
         };
@@ -397,9 +760,12 @@ namespace hg {
             using ctype = typename container_bpt<vectorial>::type;
 
             using lep_t = piecewise_linear_energy_function_piece<double>;
-            using lef_t = piecewise_linear_energy_function<double>;
 
-            std::vector<lef_t> m_optimal_energies{};
+            // optimal energy of each region alive: the slot of the region i is m_slots(i)
+            piecewise_linear_energy_function_arena<double> m_optimal_energies{11};
+            array_1d<index_t> m_slots;
+            // slot of the energies of the candidate merged regions
+            index_t m_candidate_slot;
             const graph_type &m_graph;
             array_1d<double> m_area;
             array_1d<double> m_perimeter;
@@ -431,22 +797,57 @@ namespace hg {
                 m_sum = container_bpt<vectorial>::init(sum_vertex_weights);
                 m_sum2 = container_bpt<vectorial>::init(sum_square_vertex_weights);
 
+                m_optimal_energies.reserve(num_nodes + 1);
+                m_slots = array_1d<index_t>::from_shape({num_nodes_final});
                 for (index_t i = 0; i < (index_t) num_nodes; i++) {
-                    m_optimal_energies.emplace_back(
-                            lep_t{0, computation_helper<vectorial>::data_fidelity(m_sum, m_sum2, m_area, i),
-                                  m_perimeter(i)});
+                    m_slots(i) = m_optimal_energies.allocate();
+                    m_optimal_energies.set(m_slots(i),
+                                           lep_t{0, computation_helper<vectorial>::data_fidelity(m_sum, m_sum2, m_area, i),
+                                                 m_perimeter(i)});
                 }
+                m_candidate_slot = m_optimal_energies.allocate();
             }
 
+            /**
+             * Apparition scale of the region obtained by merging the regions i and j
+             */
+            double apparition_scale(index_t i, index_t j, double edge_length) {
+                m_optimal_energies.sum(m_candidate_slot, m_slots(i), m_slots(j));
+                return m_optimal_energies.infimum(
+                        m_candidate_slot,
+                        {0,
+                         computation_helper<vectorial>::merged_data_fidelity(m_area, m_sum, m_sum2, i, j),
+                         m_perimeter(i) + m_perimeter(j) - 2 * edge_length});
+            }
+
+            /**
+             * Apparition scales of the regions obtained by merging the extremities of each edge of the initial graph.
+             *
+             * The optimal energy of an initial region i is the single linear piece {0, data_fidelity(i),
+             * perimeter(i)}: the sum of the energies of two initial regions is also a single linear piece starting
+             * at 0 and its infimum with the energy of the merged region has a closed form (same result as
+             * apparition_scale). The edges are then weighted in parallel without touching the energy arena.
+             */
             auto weight_initial_edges() {
+                HG_TRACE();
                 array_1d<double> edge_weights = array_1d<double>::from_shape({num_edges(m_graph)});
-                for (auto e: edge_iterator(m_graph)) {
-                    auto s = source(e, m_graph);
-                    auto t = target(e, m_graph);
-                    edge_weights(e) = computation_helper<vectorial>::apparition_scale(
-                            m_optimal_energies, m_area, m_perimeter, m_sum, m_sum2,
-                            s, t, m_edge_length(e));
-                }
+                parfor(0, (index_t) num_edges(m_graph), [this, &edge_weights](index_t ei) {
+                    auto e = edge_from_index(ei, m_graph);
+                    auto i = source(e, m_graph);
+                    auto j = target(e, m_graph);
+                    const double sum_origin_y = computation_helper<vectorial>::data_fidelity(m_sum, m_sum2, m_area, i) +
+                                                computation_helper<vectorial>::data_fidelity(m_sum, m_sum2, m_area, j);
+                    const double sum_slope = m_perimeter(i) + m_perimeter(j);
+                    const double merged_origin_y =
+                            computation_helper<vectorial>::merged_data_fidelity(m_area, m_sum, m_sum2, i, j);
+                    const double merged_slope = m_perimeter(i) + m_perimeter(j) - 2 * m_edge_length(ei);
+                    if (merged_slope == sum_slope) {
+                        edge_weights(ei) = (merged_origin_y > sum_origin_y) ?
+                                           std::numeric_limits<double>::infinity() : 0;
+                    } else {
+                        edge_weights(ei) = -(merged_origin_y - sum_origin_y) / (merged_slope - sum_slope);
+                    }
+                });
                 return edge_weights;
             }
 
@@ -465,10 +866,12 @@ namespace hg {
                 computation_helper<vectorial>::add(m_sum, new_region, merged_region1, merged_region2);
                 computation_helper<vectorial>::add(m_sum2, new_region, merged_region1, merged_region2);
 
-                // compute energy of new region
-                m_optimal_energies.push_back(
-                        m_optimal_energies[merged_region1].sum(m_optimal_energies[merged_region2]));
-                m_optimal_energies[new_region].infimum(
+                // compute energy of new region, the slots of the merged regions are reused
+                m_slots(new_region) = m_slots(merged_region1);
+                m_optimal_energies.sum(m_slots(new_region), m_slots(merged_region1), m_slots(merged_region2));
+                m_optimal_energies.release(m_slots(merged_region2));
+                m_optimal_energies.infimum(
+                        m_slots(new_region),
                         {0,
                          computation_helper<vectorial>::data_fidelity(m_sum, m_sum2, m_area, new_region),
                          m_perimeter(new_region)});
@@ -487,9 +890,8 @@ namespace hg {
 
                     // the weight of the new edge is equal to the apparition scale of the region create by the merging of
                     // the two extremities of the edge
-                    n.new_edge_weight() = (std::max)(0.0, computation_helper<vectorial>::apparition_scale(
-                            m_optimal_energies, m_area, m_perimeter, m_sum, m_sum2,
-                            new_region, n.neighbour_vertex(), new_edge_length));
+                    n.new_edge_weight() = (std::max)(0.0, apparition_scale(new_region, n.neighbour_vertex(),
+                                                                            new_edge_length));
 
                 }
             }
@@ -582,6 +984,123 @@ namespace hg {
         return xt::eval(xt::view(labels, xt::range(0, num_leaves(tree))));
     };
 
+    /**
+     * Multithreaded version of labelisation_optimal_cut_from_energy.
+     *
+     * The optimal energies are computed by height levels (see make_leaves_to_root_level_schedule): the nodes whose
+     * children have all been processed are processed in parallel. The nodes of the optimal cut (optimal nodes
+     * without optimal ancestor) are then found by depth levels (see make_root_to_leaves_level_schedule) and their
+     * labels are propagated to the leaves with reconstruct_leaf_data(execution::par, ...).
+     *
+     * The result is equal to the result of the sequential version. The speedup depends on the number of nodes per
+     * level: deep trees, like binary partition trees of noisy images, contain many small levels processed serially.
+     * The sequential version is thus used if the tree has less than policy.serial_cutoff vertices, or if its levels
+     * contain on average less than tree_level_schedule::parallel_level_min_size nodes.
+     *
+     * @tparam tree_type input tree type
+     * @tparam T energy attribute type
+     * @tparam accumulator_type accumulator type
+     * @param policy execution::par
+     * @param tree input tree
+     * @param xenergy_attribute 1d array of energy attribute for the input tree
+     * @param accumulator accumulator used to define how children energies are combined in order to obtain the energy of the corresponding partial partition
+     * @return a 1d integer array with num_leaves(tree) elements representing the minimal energy partition
+     */
+    template<typename tree_type,
+            typename T,
+            typename accumulator_type=hg::accumulator_sum>
+    array_1d<index_t> labelisation_optimal_cut_from_energy(execution::parallel_policy policy,
+                                                           const tree_type &tree,
+                                                           const xt::xexpression<T> &xenergy_attribute,
+                                                           const accumulator_type accumulator = hg::accumulator_sum()) {
+        HG_TRACE();
+        using value_type = typename T::value_type;
+        auto &energy_attribute = xenergy_attribute.derived_cast();
+        hg_assert_node_weights(tree, energy_attribute);
+        hg_assert_1d_array(energy_attribute);
+
+        const index_t num_v = num_vertices(tree);
+        if (num_v < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return labelisation_optimal_cut_from_energy(tree, energy_attribute, accumulator);
+        }
+        const auto schedule = make_leaves_to_root_level_schedule(tree);
+        if (schedule.num_levels() * tree_level_schedule::parallel_level_min_size > num_v - (index_t) num_leaves(tree)) {
+            return labelisation_optimal_cut_from_energy(tree, energy_attribute, accumulator);
+        }
+
+        tree.compute_children();
+        array_1d<bool> optimal_nodes = array_1d<bool>::from_shape({(size_t) num_v});
+        array_1d<value_type> optimal_energy = array_1d<value_type>::from_shape({(size_t) num_v});
+
+        // forward pass
+        xt::view(optimal_nodes, xt::range(0, num_leaves(tree))) = true;
+        xt::noalias(xt::view(optimal_energy, xt::range(0, num_leaves(tree)))) =
+                xt::view(energy_attribute, xt::range(0, num_leaves(tree)));
+
+        schedule.for_each_node(policy, [&](index_t i) {
+            auto output_view = make_light_axis_view<false>(optimal_energy);
+            output_view.set_position(i);
+            auto acc = accumulator.template make_accumulator<false>(output_view);
+            acc.initialize();
+            for (auto c: children_iterator(i, tree)) {
+                acc.accumulate(&optimal_energy(c));
+            }
+            acc.finalize();
+            if (energy_attribute(i) <= optimal_energy(i)) {
+                optimal_nodes(i) = true;
+                optimal_energy(i) = energy_attribute(i);
+            } else {
+                optimal_nodes(i) = false;
+            }
+        });
+
+        // optimal cut: optimal nodes whose strict ancestors are not optimal
+        array_1d<bool> deleted_nodes = array_1d<bool>::from_shape({(size_t) num_v});
+        array_1d<bool> in_or_below_cut = array_1d<bool>::from_shape({(size_t) num_v});
+        const index_t root_node = root(tree);
+        make_root_to_leaves_level_schedule(tree).for_each_node(policy, [&](index_t i) {
+            const bool below_cut = i != root_node && in_or_below_cut(parent(i, tree));
+            deleted_nodes(i) = below_cut || !optimal_nodes(i);
+            in_or_below_cut(i) = below_cut || optimal_nodes(i);
+        });
+
+        // the regions are numbered in root to leaves order (decreasing node indices) as in the sequential version
+        constexpr index_t block_size = 4096;
+        const index_t num_blocks = (num_v + block_size - 1) / block_size;
+        std::vector<index_t> block_offset(num_blocks, 0);
+        parfor(0, num_blocks, [&](index_t b) {
+            const index_t end = (std::min)(num_v, (b + 1) * block_size);
+            for (index_t i = b * block_size; i < end; i++) {
+                block_offset[b] += !deleted_nodes(i);
+            }
+        });
+        index_t num_regions = 0;
+        for (index_t b = num_blocks - 1; b >= 0; b--) {
+            index_t block_count = block_offset[b];
+            block_offset[b] = num_regions;
+            num_regions += block_count;
+        }
+        array_1d<index_t> labels = array_1d<index_t>::from_shape({(size_t) num_v});
+        parfor(0, num_blocks, [&](index_t b) {
+            index_t count = block_offset[b];
+            for (index_t i = (std::min)(num_v, (b + 1) * block_size) - 1; i >= b * block_size; i--) {
+                labels(i) = deleted_nodes(i) ? invalid_index : count++;
+            }
+        });
+
+        return reconstruct_leaf_data(policy, tree, labels, deleted_nodes);
+    };
+
+    template<typename tree_type,
+            typename T,
+            typename accumulator_type=hg::accumulator_sum>
+    auto labelisation_optimal_cut_from_energy(execution::sequenced_policy,
+                                              const tree_type &tree,
+                                              const xt::xexpression<T> &xenergy_attribute,
+                                              const accumulator_type accumulator = hg::accumulator_sum()) {
+        return labelisation_optimal_cut_from_energy(tree, xenergy_attribute, accumulator);
+    };
+
     /**
      * Transforms the given hierarchy into its optimal energy cut hierarchy for the given energy terms.
      * In the optimal energy cut hierarchy, any horizontal cut corresponds to an optimal energy cut in the original
@@ -629,25 +1148,40 @@ namespace hg {
 
 
         using lep_t = hg::tree_energy_optimization_internal::piecewise_linear_energy_function_piece<double>;
-        using lef_t = hg::tree_energy_optimization_internal::piecewise_linear_energy_function<double>;
 
         tree.compute_children();
-        std::vector<lef_t> optimal_energies{};
+        const index_t num_l = num_leaves(tree);
         array_1d<double> apparition_scales = array_1d<double>::from_shape({num_vertices(tree)});
 
         for (auto i: leaves_iterator(tree)) {
-            optimal_energies.emplace_back(lep_t(0, data_fidelity_attribute(i), regularization_attribute(i)));
             apparition_scales(i) = -data_fidelity_attribute(i) / regularization_attribute(i);
         }
 
+        // the optimal energy of a non leaf node is stored in the slot of its first child until its parent is
+        // processed, the energies of the leaves are single pieces created on demand
+        hg::tree_energy_optimization_internal::piecewise_linear_energy_function_arena<double>
+                optimal_energies(approximation_piecewise_linear_function + 1);
+        array_1d<index_t> slots = array_1d<index_t>::from_shape({num_vertices(tree)});
+        auto take_slot = [&optimal_energies, &slots, &data_fidelity_attribute, &regularization_attribute, num_l](
+                index_t n) {
+            if (n >= num_l) {
+                return slots(n);
+            }
+            index_t f = optimal_energies.allocate();
+            optimal_energies.set(f, lep_t(0, data_fidelity_attribute(n), regularization_attribute(n)));
+            return f;
+        };
+
         for (auto i: leaves_to_root_iterator(tree, leaves_it::exclude)) {
-            optimal_energies.push_back(optimal_energies[child(0, i, tree)]);
+            index_t f = take_slot(child(0, i, tree));
             for (index_t c = 1; c < (index_t) num_children(i, tree); c++) {
-                optimal_energies[i] = optimal_energies[i].sum(optimal_energies[child(c, i, tree)],
-                                                              approximation_piecewise_linear_function);
+                index_t fc = take_slot(child(c, i, tree));
+                optimal_energies.sum(f, f, fc, approximation_piecewise_linear_function);
+                optimal_energies.release(fc);
             }
-            apparition_scales(i) = optimal_energies[i].infimum(
-                    {0, data_fidelity_attribute(i), regularization_attribute(i)});
+            slots(i) = f;
+            apparition_scales(i) = optimal_energies.infimum(
+                    f, {0, data_fidelity_attribute(i), regularization_attribute(i)});
         }
 
         for (auto i: root_to_leaves_iterator(tree, leaves_it::include, root_it::exclude)) {
@@ -659,7 +1193,7 @@ namespace hg {
         auto qfz = simplify_tree(tree, xt::equal(apparition_scales, apparition_scales_parents));
         auto &qfz_tree = qfz.tree;
         auto &node_map = qfz.node_map;
-        auto qfz_apparition_scales = xt::eval(xt::index_view(apparition_scales, node_map));
+        auto qfz_apparition_scales = gather(apparition_scales, node_map);
 
         return make_node_weighted_tree(std::move(qfz_tree), std::move(qfz_apparition_scales));
     };
@@ -12,9 +12,11 @@
 
 #include "../graph.hpp"
 #include "../attribute/tree_attribute.hpp"
+#include "../structure/lca_fast.hpp"
 #include <xtensor/xnoalias.hpp>
 #include <vector>
-#include <stack>
+#include <atomic>
+#include <memory>
 
 namespace hg {
 
@@ -22,142 +24,204 @@ namespace hg {
 
         using namespace std;
 
+        /**
+         * For each node n of the tree t1, ses(n) is the smallest node of the tree t2 containing n (see
+         * attribute_smallest_enclosing_shape): lca2 is a lowest common ancestor solver for the tree t2.
+         */
+        template<typename tree_t, typename lca_t, typename T>
+        void smallest_enclosing_shape(const tree_t &t1, const lca_t &lca2, T &ses) {
+            const index_t nleaves = num_leaves(t1);
+            const index_t nvertices = num_vertices(t1);
+            for (index_t n = 0; n < nleaves; n++) {
+                ses(n) = n;
+            }
+            for (index_t n = nleaves; n < nvertices; n++) {
+                ses(n) = invalid_index;
+            }
+            for (index_t n = 0; n < nvertices - 1; n++) {
+                auto p = parent(n, t1);
+                if (ses(p) == invalid_index) {
+                    ses(p) = ses(n);
+                } else {
+                    ses(p) = lca2.lca(ses(p), ses(n));
+                }
+            }
+        }
+
         template<typename tree_iterator>
         auto tree_fusion_depth_map(const tree_iterator first, const tree_iterator last) {
-
-            index_t i, j;
-            tree_iterator ti, tj;
-            auto ntrees = last - first;
+            HG_TRACE();
+            const index_t ntrees = last - first;
             hg_assert(ntrees > 1, "Fusion requires at least two trees");
-            auto nleaves = num_leaves(**first);
-            for (tree_iterator t = first; t != last; t++) {
-                hg_assert(num_leaves(**t), "All trees must have the same number of leaves.");
+            vector<const tree *> trees(first, last);
+            const index_t nleaves = num_leaves(*trees[0]);
+            for (auto t: trees) {
+                hg_assert((index_t) num_leaves(*t) == nleaves, "All trees must have the same number of leaves.");
             }
 
-            // cheap digraph!
-            vector<vector<index_t>> adj_lists;
-
-            // precompute areas and smallest enclosing shapes
-            vector<array_1d<index_t>> areas;
-            array_2d<array_1d<index_t>> ses = xt::empty<array_1d<index_t>>({ntrees, ntrees});
-            for (ti = first, i = 0; ti != last; ti++, i++) {
-                areas.push_back(attribute_area(**ti));
-                for (tj = first, j = 0; tj != last; tj++, j++) {
-                    if (j != i) {
-                        ses(i, j) = attribute_smallest_enclosing_shape(**ti, **tj);
-                    }
-                }
+            // the node n of the tree i has the global index offsets[i] + n
+            vector<index_t> offsets(ntrees + 1, 0);
+            for (index_t i = 0; i < ntrees; i++) {
+                offsets[i + 1] = offsets[i] + num_vertices(*trees[i]);
             }
 
+            vector<array_1d<index_t>> areas(ntrees);
+            vector<unique_ptr<lca_fast>> lcas(ntrees);
+            parfor(0, ntrees, [&](index_t i) {
+                areas[i] = attribute_area(*trees[i]);
+                lcas[i] = make_unique<lca_fast>(*trees[i]);
+            });
+
             /* ***************
-             * Add nodes to the graph of shapes (GOS)
+             * Smallest enclosing shapes, computed in parallel for each tree i against all the other trees j
+             *  - duplicates[i](n): global index of the node of the first tree j < i with the same shape as the
+             *    non-leaf node n of the tree i (invalid_index if there is no such tree)
+             *  - edges[i]: inclusion edges (global index of the smallest enclosing shape in the tree j, global index
+             *    of the node n of the tree i) of the graph of shapes (GOS)
              */
-
-            // associate each node of each tree to a node of the GOS
-            vector<array_1d<index_t>> node_maps;
-
-            // add leaves
-            adj_lists.resize(nleaves);
-
-            // add internal nodes (except root) and avoid duplication
-            for (ti = first, i = 0; ti != last; ti++, i++) {
-                node_maps.emplace_back(array_1d<index_t>::from_shape({num_vertices(**ti)}));
-                // create leaves association
-                xt::noalias(xt::view(node_maps[i], xt::range(0, nleaves))) = xt::arange<index_t>(nleaves);
-
-                for (index_t n: leaves_to_root_iterator(**ti, leaves_it::exclude, root_it::exclude)) {
-                    bool keep = true;
-                    for (index_t j = 0; j < i && keep; j++) {
-                        auto ses_ij_n = ses(i, j)(n);
-                        if (areas[j](ses_ij_n) == areas[i](n)) {
-                            keep = false;
-                            node_maps[i](n) = node_maps[j](ses_ij_n);
-                        }
+            vector<array_1d<index_t>> duplicates(ntrees);
+            vector<vector<pair<index_t, index_t>>> edges(ntrees);
+            parfor(0, ntrees, [&](index_t i) {
+                const auto &ti = *trees[i];
+                const index_t rooti = root(ti);
+                auto &duplicate = duplicates[i];
+                auto &edgesi = edges[i];
+                duplicate = array_1d<index_t>({num_vertices(ti)}, invalid_index);
+                array_1d<index_t> ses = array_1d<index_t>::from_shape({num_vertices(ti)});
+                for (index_t j = 0; j < ntrees; j++) {
+                    if (j == i) {
+                        continue;
                     }
-                    if (keep) {
-                        node_maps[i](n) = adj_lists.size();
-                        adj_lists.emplace_back();
+                    smallest_enclosing_shape(ti, *lcas[j], ses);
+                    for (index_t n = 0; n < rooti; n++) {
+                        if (areas[j](ses(n)) == areas[i](n)) {
+                            if (j < i && n >= nleaves && duplicate(n) == invalid_index) {
+                                duplicate(n) = offsets[j] + ses(n);
+                            }
+                        } else {
+                            edgesi.emplace_back(offsets[j] + ses(n), offsets[i] + n);
+                        }
                     }
                 }
-            }
-
-            // add root
-            auto rootn = adj_lists.size();
-            adj_lists.emplace_back();
-            for (ti = first, i = 0; ti != last; ti++, i++) {
-                node_maps[i](root(**ti)) = rootn;
-            }
-
+            });
 
             /* ***************
-             * Add edges to the graph of shapes (GOS)
+             * Nodes of the GOS: the leaves, the non-leaf nodes of the trees without duplicate in a previous tree,
+             * and the root
              */
-            for (ti = first, i = 0; ti != last; ti++, i++) {
-                for (index_t n: leaves_to_root_iterator(**ti, leaves_it::include, root_it::exclude)) {
-                    auto represent_n = node_maps[i](n);
-                    adj_lists[node_maps[i](parent(n, **ti))].push_back(represent_n);
-                    for (j = 0; j < (index_t) ntrees; j++) {
-                        if (i != j) {
-                            auto ses_ij_n = ses(i, j)(n);
-                            if (areas[j](ses_ij_n) != areas[i](n)) {
-                                adj_lists[node_maps[j](ses_ij_n)].push_back(represent_n);
-                            }
-                        }
-
+            array_1d<index_t> node_map = array_1d<index_t>::from_shape({(size_t) offsets[ntrees]});
+            index_t nnodes = nleaves;
+            for (index_t i = 0; i < ntrees; i++) {
+                const index_t rooti = root(*trees[i]);
+                for (index_t n = 0; n < nleaves; n++) {
+                    node_map(offsets[i] + n) = n;
+                }
+                for (index_t n = nleaves; n < rooti; n++) {
+                    if (duplicates[i](n) == invalid_index) {
+                        node_map(offsets[i] + n) = nnodes++;
+                    }
+                }
+            }
+            const index_t rootn = nnodes++;
+            for (index_t i = 0; i < ntrees; i++) {
+                node_map(offsets[i] + root(*trees[i])) = rootn;
+            }
+            // duplicates refer to nodes of previous trees
+            for (index_t i = 0; i < ntrees; i++) {
+                const index_t rooti = root(*trees[i]);
+                for (index_t n = nleaves; n < rooti; n++) {
+                    if (duplicates[i](n) != invalid_index) {
+                        node_map(offsets[i] + n) = node_map(duplicates[i](n));
                     }
                 }
             }
 
             /* ***************
-            * Transitive reduction of the GOS
-            */
-
-            // perhaps one day, doesn't bring anything in terms of complexity
-
-            /* ***************
-            * Topological sort of the GOS
-            */
-            auto nnodes = adj_lists.size();
-            array_1d<index_t> sorted_nodes = xt::empty<index_t>({nnodes});
-            // marks: 0 = never seen, 1 = being visited (not finalized and sucessors on the stack), 2 = sorted
-            array_1d<char> marks = xt::zeros<char>({nnodes});
-            stack<index_t> s;
-
-            index_t count = 0;
-            s.push(rootn);
-            while (!s.empty()) {
-                auto n = s.top();
-                if (marks(n) > 0) {
-                    s.pop();
-                    if (marks(n) == 1) {
-                        sorted_nodes(count++) = n;
-                        marks(n) = 2;
+             * Edges of the GOS in compressed sparse row form: the tree edges and the inclusion edges. A node of a
+             * tree and its parent can have the same shape as a node of a previous tree: the resulting self loops are
+             * counted apart, each of them increases the depth of the node by one.
+             */
+            array_1d<index_t> out_start = xt::zeros<index_t>({(size_t) nnodes + 1});
+            array_1d<index_t> self_loops = xt::zeros<index_t>({(size_t) nnodes});
+            auto for_each_edge = [&](auto &&fun) {
+                for (index_t i = 0; i < ntrees; i++) {
+                    const auto &ti = *trees[i];
+                    const index_t rooti = root(ti);
+                    for (index_t n = 0; n < rooti; n++) {
+                        fun(node_map(offsets[i] + parent(n, ti)), node_map(offsets[i] + n));
                     }
-                } else {
-                    marks(n) = 1;
-                    for (auto o: adj_lists[n]) {
-                        if (marks(o) != 2) {
-                            s.push(o);
-                        }
+                    for (auto &e: edges[i]) {
+                        fun(node_map(e.first), node_map(e.second));
                     }
                 }
+            };
+            for_each_edge([&out_start, &self_loops](index_t s, index_t t) {
+                if (s != t) {
+                    out_start(s + 1)++;
+                } else {
+                    self_loops(s)++;
+                }
+            });
+            for (index_t n = 0; n < nnodes; n++) {
+                out_start(n + 1) += out_start(n);
+            }
+            array_1d<index_t> out_nodes = array_1d<index_t>::from_shape({(size_t) out_start(nnodes)});
+            {
+                vector<index_t> position(out_start.begin(), out_start.end() - 1);
+                for_each_edge([&out_nodes, &position](index_t s, index_t t) {
+                    if (s != t) {
+                        out_nodes(position[s]++) = t;
+                    }
+                });
             }
+            edges.clear();
+            edges.shrink_to_fit();
 
             /* ***************
-            * Depth of the nodes of the GOS
-            */
-            array_1d<index_t> depth = xt::zeros<index_t>({nnodes});
-            for (index_t i = nnodes - 1; i >= 0; i--) {
-                index_t n = sorted_nodes[i];
-                for (auto o: adj_lists[n]) {
-                    depth(o) = (std::max)(depth(o), depth(n) + 1);
+             * Depth of the nodes of the GOS (length of the longest path from the root): level synchronous
+             * topological sweep, a node is processed in the level following the processing of its last
+             * predecessor, its depth is then final and is propagated to its successors.
+             */
+            vector<atomic<index_t>> in_degree(nnodes);
+            vector<atomic<index_t>> depth(nnodes);
+            parfor(0, nnodes, [&in_degree, &depth](index_t n) {
+                in_degree[n].store(0, memory_order_relaxed);
+                depth[n].store(0, memory_order_relaxed);
+            });
+            parfor(0, nnodes, [&](index_t n) {
+                for (index_t k = out_start(n); k < out_start(n + 1); k++) {
+                    in_degree[out_nodes(k)].fetch_add(1, memory_order_relaxed);
                 }
+            });
+
+            array_1d<index_t> sorted_nodes = array_1d<index_t>::from_shape({(size_t) nnodes});
+            sorted_nodes(0) = rootn;
+            atomic<index_t> num_sorted{1};
+            index_t level_start = 0;
+            while (level_start < num_sorted.load()) {
+                const index_t level_end = num_sorted.load();
+                parfor(level_start, level_end, [&](index_t k) {
+                    const index_t n = sorted_nodes(k);
+                    const index_t d = depth[n].load(memory_order_relaxed) + self_loops(n);
+                    depth[n].store(d, memory_order_relaxed);
+                    for (index_t e = out_start(n); e < out_start(n + 1); e++) {
+                        const index_t o = out_nodes(e);
+                        auto current = depth[o].load(memory_order_relaxed);
+                        while (current < d + 1 && !depth[o].compare_exchange_weak(current, d + 1));
+                        if (in_degree[o].fetch_sub(1) == 1) {
+                            sorted_nodes(num_sorted.fetch_add(1)) = o;
+                        }
+                    }
+                });
+                level_start = level_end;
             }
+            hg_assert(level_start == nnodes, "The graph of shapes is not a rooted directed acyclic graph.");
 
-            /* ***************
-            * Depth of the nodes of the GOS
-            */
-            return xt::eval(xt::view(depth, xt::range(0, nleaves)));
+            array_1d<index_t> leaves_depth = array_1d<index_t>::from_shape({(size_t) nleaves});
+            parfor(0, nleaves, [&leaves_depth, &depth](index_t n) {
+                leaves_depth(n) = depth[n].load(memory_order_relaxed);
+            });
+            return leaves_depth;
         }
 
         template<typename range_tree_t>
@@ -8,29 +8,18 @@
 * The full license is in the file LICENSE, distributed with this software. *
 ****************************************************************************/
 
+#pragma once
+
 #include "../graph.hpp"
 #include "xtensor/xview.hpp"
 #include "../accumulator/tree_accumulator.hpp"
-#include "../structure/fibonacci_heap.hpp"
+#include "../structure/pairing_heap.hpp"
 #include "../structure/unionfind.hpp"
 
 namespace hg {
 
     namespace tree_monotonic_regression_internal {
 
-        struct heap_node {
-            double value;
-            index_t node_index;
-        };
-
-        // reverse order to obtain a max_heap
-        bool operator<(const heap_node &n1, const heap_node &n2) {
-            return n1.value > n2.value;
-        }
-
-        using heap_type = fibonacci_heap<heap_node>;
-        using heap_element_type = heap_type::value_handle;
-
         template<typename tree_t, typename T, typename Tw>
         auto tree_monotonic_regression_least_square(const tree_t &tree, const xt::xexpression<T> &xaltitudes,
                                                     const xt::xexpression<Tw> &xweights) {
@@ -47,12 +36,6 @@ namespace hg {
             array_1d<double> node_block_weighted_sum = node_weight * node_value;
 
             array_1d<double>::shape_type shape({num_vertices(tree)});
-            array_1d<heap_type> node_heap = array_1d<heap_type>::from_shape(shape);
-            array_1d<heap_element_type> node_heap_handles = array_1d<heap_element_type>::from_shape(shape);
-
-            for (index_t i: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
-                node_heap_handles(i) = node_heap(parent(i, tree)).push({node_value(i), i});
-            }
 
             // lazy average
             auto node_average_weight = node_block_weighted_sum / node_block_total_weight;
@@ -60,18 +43,25 @@ namespace hg {
             index_t num_v = num_vertices(tree);
             union_find uf(num_v); // Block maintenance
 
+            // Children of the blocks: the block containing a node n has a max heap (shared arena, each node is
+            // inserted once in the heap of its parent) containing the children of the nodes of the block that are not
+            // in the block, with the average value of their block. The heap of a block is stored at its
+            // representative.
+            pairing_heap_forest<double, std::greater<double>> heaps(num_v);
+            std::vector<index_t> node_heap(num_v, invalid_index);
+
             /*
              * Main loop IRT_BIN
              */
             for (index_t i: leaves_to_root_iterator(tree)) {
                 // index of the representative tree node for the block containing node i
                 index_t ic = uf.find(i);
+                index_t heap = node_heap[ic];
 
                 // while we have violators among our children, fuse current block with the block of the most important violator
-                while (!node_heap(ic).empty() &&
-                       node_average_weight(ic) < node_heap(ic).top()->get_value().value) {
-                    index_t k = node_heap(ic).top()->get_value().node_index; // index of violator child k
-                    node_heap(ic).pop();
+                while (heap != invalid_index && node_average_weight(ic) < heaps.key(heap)) {
+                    index_t k = heap; // index of violator child k
+                    heap = heaps.pop(heap);
 
                     index_t kc = uf.find(k); // index of the representative tree node for the block containing node k
 
@@ -85,12 +75,14 @@ namespace hg {
                     // merge block information
                     node_block_weighted_sum(ic) += node_block_weighted_sum(new_ik);
                     node_block_total_weight(ic) += node_block_total_weight(new_ik);
-                    node_heap(ic).merge(node_heap(new_ik));
+                    heap = heaps.meld(heap, node_heap[kc]);
                 }
+                node_heap[ic] = heap;
 
-                // update parent heap to reflect the new weight of the block containing node i
+                // the block containing node i is final until the parent of i is processed: insert it in the parent heap
                 if (root(tree) != i) {
-                    node_heap(parent(i, tree)).update(node_heap_handles(i), {node_average_weight(ic), i});
+                    index_t p = parent(i, tree);
+                    node_heap[p] = heaps.push(node_heap[p], i, node_average_weight(ic));
                 }
             }
 
@@ -129,7 +121,8 @@ namespace hg {
      *
      * - For the modes ``"min"`` and ``"max"``, the runtime complexity is linear :math:`\mathcal{O}(n)`.
      * - For the mode ``"least_square"``, the runtime complexity is linearithmic :math:`\mathcal{O}(n\log(n))` and the
-     *   space complexity is linear  :math:`\mathcal{O}(n)`. The algorithm used is described in:
+     *   space complexity is linear  :math:`\mathcal{O}(n)` (the heaps of the algorithm are pairing heaps allocated in a
+     *   single arena of size :math:`n`). The algorithm used is described in:
      *
      *     P. Pardalos and G. Xue
      *     `'Algorithms for a Class of Isotonic Regression Problems.' <https://link.springer.com/article/10.1007/PL00009258>`_
@@ -15,17 +15,173 @@
 #include "../structure/array.hpp"
 #include "higra/structure/unionfind.hpp"
 #include "higra/sorting.hpp"
+#include "graph_core.hpp"
 #include <vector>
 #include <stack>
 
 namespace hg {
 
+    namespace watershed_internal {
+
+        /**
+         * Seeded watershed on a minimum spanning tree given by its edges in increasing order (see
+         * labelisation_seeded_watershed): a union-find sweep over the edges merges two components when one of them
+         * does not contain any seed.
+         *
+         * On input labels(v) is the seed label of the vertex v (background_label for non seed vertices), on output it
+         * is the label of the basin of v. If active is not null, (*active)[k] is set to true if the k-th edge links
+         * two vertices of the same basin.
+         */
+        template<typename labels_t, typename label_t>
+        void seeded_watershed_on_sorted_mst(const index_t *sources,
+                                            const index_t *targets,
+                                            index_t num_mst_edges,
+                                            labels_t &labels,
+                                            label_t background_label,
+                                            std::vector<bool> *active = nullptr) {
+            const index_t num_v = labels.size();
+            union_find uf(num_v);
+            for (index_t k = 0; k < num_mst_edges; k++) {
+                auto c1 = uf.find(sources[k]);
+                auto c2 = uf.find(targets[k]);
+                const bool merge = labels(c1) == background_label || labels(c2) == background_label;
+                if (merge) {
+                    if (labels(c1) == background_label) {
+                        labels(c1) = labels(c2);
+                    } else {
+                        labels(c2) = labels(c1);
+                    }
+                    uf.link(c1, c2);
+                }
+                if (active != nullptr) {
+                    (*active)[k] = merge;
+                }
+            }
+            for (index_t i = 0; i < num_v; i++) {
+                labels(i) = labels(uf.find(i));
+            }
+        }
+
+        /**
+         * Access to the edge weighted neighbourhoods of the vertices of a graph used by labelisation_watershed.
+         *
+         * lowest_weights(fminus) sets fminus(v) to the minimum weight of the out edges of each vertex v and
+         * visit(v, f) calls f(adjacent_vertex, edge_weight) on the out edges of v in out edge order until f returns
+         * false.
+         */
+        template<typename graph_t, typename T>
+        struct edge_weighted_neighbourhood {
+
+            edge_weighted_neighbourhood(const graph_t &graph, const T &edge_weights) :
+                    m_graph(graph), m_edge_weights(edge_weights) {}
+
+            template<typename T2>
+            void lowest_weights(T2 &fminus) const {
+                using value_type = typename T::value_type;
+                auto &graph = m_graph;
+                auto &edge_weights = m_edge_weights;
+                parfor(0, (index_t) num_vertices(graph), [&graph, &edge_weights, &fminus](index_t v) {
+                    auto minValue = (std::numeric_limits<value_type>::max)();
+                    for (auto e: out_edge_iterator(v, graph)) {
+                        minValue = (std::min)(minValue, edge_weights(e));
+                    }
+                    fminus[v] = minValue;
+                });
+            }
+
+            template<typename fun_t>
+            void visit(index_t v, fun_t &&f) const {
+                for (auto e: out_edge_iterator(v, m_graph)) {
+                    if (!f(target(e, m_graph), m_edge_weights(e))) {
+                        return;
+                    }
+                }
+            }
+
+        private:
+            const graph_t &m_graph;
+            const T &m_edge_weights;
+        };
+
+        /**
+         * Specialization for implicit 4 adjacency grid graphs: neighbours and edge indices are computed
+         * arithmetically (see grid_4_adjacency_graph_2d) and minimum weights are computed row by row in parallel.
+         * Neighbours are visited in the out edge order of the graph: top, left, right, bottom.
+         */
+        template<typename T>
+        struct edge_weighted_neighbourhood<grid_4_adjacency_graph_2d, T> {
+
+            edge_weighted_neighbourhood(const grid_4_adjacency_graph_2d &graph, const T &edge_weights) :
+                    m_edge_weights(edge_weights),
+                    m_height(graph.embedding().shape()[0]),
+                    m_width(graph.embedding().shape()[1]) {}
+
+            template<typename T2>
+            void lowest_weights(T2 &fminus) const {
+                using value_type = typename T::value_type;
+                parfor(0, m_height, [this, &fminus](index_t i) {
+                    for (index_t j = 0; j < m_width; j++) {
+                        auto minValue = (std::numeric_limits<value_type>::max)();
+                        if (i > 0) {
+                            minValue = (std::min)(minValue, m_edge_weights(bottom_edge(i - 1, j)));
+                        }
+                        if (j > 0) {
+                            minValue = (std::min)(minValue, m_edge_weights(right_edge(i, j - 1)));
+                        }
+                        if (j < m_width - 1) {
+                            minValue = (std::min)(minValue, m_edge_weights(right_edge(i, j)));
+                        }
+                        if (i < m_height - 1) {
+                            minValue = (std::min)(minValue, m_edge_weights(bottom_edge(i, j)));
+                        }
+                        fminus[i * m_width + j] = minValue;
+                    }
+                });
+            }
+
+            template<typename fun_t>
+            void visit(index_t v, fun_t &&f) const {
+                index_t i = v / m_width;
+                index_t j = v - i * m_width;
+                if (i > 0 && !f(v - m_width, m_edge_weights(bottom_edge(i - 1, j)))) {
+                    return;
+                }
+                if (j > 0 && !f(v - 1, m_edge_weights(right_edge(i, j - 1)))) {
+                    return;
+                }
+                if (j < m_width - 1 && !f(v + 1, m_edge_weights(right_edge(i, j)))) {
+                    return;
+                }
+                if (i < m_height - 1) {
+                    f(v + m_width, m_edge_weights(bottom_edge(i, j)));
+                }
+            }
+
+        private:
+
+            index_t right_edge(index_t i, index_t j) const {
+                return i * (2 * m_width - 1) + ((i < m_height - 1) ? 2 * j : j);
+            }
+
+            index_t bottom_edge(index_t i, index_t j) const {
+                return i * (2 * m_width - 1) + ((j < m_width - 1) ? 2 * j + 1 : 2 * j);
+            }
+
+            const T &m_edge_weights;
+            index_t m_height;
+            index_t m_width;
+        };
+    }
+
     /**
      * Linear time watershed cut algorithm.
      *
      * Jean Cousty, Gilles Bertrand, Laurent Najman, Michel Couprie. Watershed Cuts: Minimum Spanning
      * Forests and the Drop of Water Principle. IEEE Transactions on Pattern Analysis and Machine
      * Intelligence, Institute of Electrical and Electronics Engineers, 2009, 31 (8), pp.1362-1374.
+     *
+     * The algorithm runs in linear time whatever the range of the edge weights. On implicit 4 adjacency grid graphs
+     * (get_4_adjacency_grid_graph), the neighbourhoods are computed arithmetically without iterators.
      * @tparam graph_t
      * @tparam T
      * @param graph
@@ -43,16 +199,10 @@ namespace hg {
         using value_type = typename T::value_type;
         using vertex_t = typename graph_traits<graph_t>::vertex_descriptor;
 
-        auto fminus = array_1d<value_type>::from_shape({graph.num_vertices()});
-
-        for (auto v: vertex_iterator(graph)) {
-            auto minValue = (std::numeric_limits<value_type>::max)();
-            for (auto e: out_edge_iterator(v, graph)) {
-                minValue = (std::min)(minValue, edge_weights(e));
-            }
-            fminus[v] = minValue;
-        }
+        watershed_internal::edge_weighted_neighbourhood<graph_t, T> neighbourhood(graph, edge_weights);
 
+        auto fminus = array_1d<value_type>::from_shape({graph.num_vertices()});
+        neighbourhood.lowest_weights(fminus);
 
         auto no_label = (std::numeric_limits<index_t>::max)();
         auto labels = array_1d<index_t>::from_shape({graph.num_vertices()});
@@ -64,37 +214,39 @@ namespace hg {
         std::vector<vertex_t> L;
         std::vector<vertex_t> LL;
 
-        auto stream = [&L, &LL, &graph, &edge_weights, &fminus, &notInL, &labels, no_label](vertex_t x) {
+        auto stream = [&L, &LL, &neighbourhood, &fminus, &notInL, &labels, no_label](vertex_t x) {
             L.clear();
             LL.clear();
             L.push_back(x);
             LL.push_back(x);
             notInL[x] = false;
 
-            while (!LL.empty()) {
+            auto result = no_label;
+            while (!LL.empty() && result == no_label) {
                 auto y = LL[LL.size() - 1];
                 LL.pop_back();
 
-                for (auto e: out_edge_iterator(y, graph)) {
-                    auto adjacent_vertex = target(e, graph);
-                    if (notInL[adjacent_vertex] && edge_weights(e) == fminus[y]) {
+                neighbourhood.visit(y, [&](index_t adjacent_vertex, const value_type &weight) {
+                    if (notInL[adjacent_vertex] && weight == fminus[y]) {
                         if (labels[adjacent_vertex] != no_label) {
-                            return labels[adjacent_vertex];
+                            result = labels[adjacent_vertex];
+                            return false;
                         } else if (fminus[adjacent_vertex] < fminus[y]) {
                             L.push_back(adjacent_vertex);
                             notInL[adjacent_vertex] = false;
                             LL.clear();
                             LL.push_back(adjacent_vertex);
-                            break; // stop breadth_first
+                            return false; // stop breadth_first
                         } else {
                             L.push_back(adjacent_vertex);
                             notInL[adjacent_vertex] = false;
                             LL.push_back(adjacent_vertex);
                         }
                     }
-                }
+                    return true;
+                });
             }
-            return no_label;
+            return result;
         };
 
         index_t num_labs = 0;
@@ -102,6 +254,8 @@ namespace hg {
         for (auto v: vertex_iterator(graph)) {
             if (labels[v] == no_label) {
                 auto res = stream(v);
+                // vertices of the plateau explored by the stream (up to the lower border or to a labelled vertex)
+                HG_PROFILE_COUNT("labelisation_watershed plateau size", L.size());
                 if (res == no_label) {
                     num_labs++;
                     for (auto x: L) {
@@ -171,4 +325,279 @@ namespace hg {
         return labels;
     };
 
+    /**
+     * Seeded watershed labelisation (see labelisation_seeded_watershed) which is updated efficiently when the seeds
+     * change, for interactive segmentation.
+     *
+     * The seeded watershed only depends on the minimum spanning tree of the edge weighted graph (edges are ordered by
+     * weight, ties being broken by edge index as in labelisation_seeded_watershed): it is the minimum spanning tree
+     * of the graph augmented with a virtual vertex linked to every seed by an edge of weight -infinity, without those
+     * virtual edges. The catchment basins are the trees of this forest, each one containing a single seed vertex.
+     *
+     * The minimum spanning tree is computed once at construction and the initial labelisation is obtained with a
+     * single union-find sweep over its sorted edges. Then:
+     *  - adding a seed at a vertex v cuts the largest edge on the path between v and the seed of its basin;
+     *  - removing the seed v reconnects its basin with the smallest minimum spanning tree edge leaving it;
+     *  - changing the label of the seed v relabels its basin.
+     * Each update only traverses the basin that contains v: the other basins are never visited.
+     *
+     * Warning: not thread safe
+     *
+     * @tparam label_t label type
+     */
+    template<typename label_t>
+    struct incremental_seeded_watershed {
+        using label_type = label_t;
+
+        /**
+         * Computes the minimum spanning tree of the graph and the seeded watershed labelisation of the given seeds.
+         *
+         * @tparam graph_t
+         * @tparam T1
+         * @tparam T2
+         * @param graph input graph
+         * @param xedge_weights input graph edge weights
+         * @param xvertex_seeds seed label of each vertex, background_label for non seed vertices
+         * @param background_label label of non seed vertices
+         */
+        template<typename graph_t, typename T1, typename T2>
+        incremental_seeded_watershed(const graph_t &graph,
+                                     const xt::xexpression<T1> &xedge_weights,
+                                     const xt::xexpression<T2> &xvertex_seeds,
+                                     label_type background_label = 0) :
+                m_background_label(background_label) {
+            HG_TRACE();
+            auto &edge_weights = xedge_weights.derived_cast();
+            auto &vertex_seeds = xvertex_seeds.derived_cast();
+            hg_assert_edge_weights(graph, edge_weights);
+            hg_assert_node_weights(graph, vertex_seeds);
+            hg_assert_1d_array(edge_weights);
+            hg_assert_1d_array(vertex_seeds);
+
+            const index_t num_v = num_vertices(graph);
+            auto mst_edge_map = minimum_spanning_tree(graph, edge_weights).mst_edge_map;
+            const index_t num_mst_edges = mst_edge_map.size();
+
+            // minimum spanning tree edges in increasing order and their adjacency lists
+            m_sources.resize(num_mst_edges);
+            m_targets.resize(num_mst_edges);
+            m_adjacency_start.assign(num_v + 1, 0);
+            for (index_t k = 0; k < num_mst_edges; k++) {
+                auto e = edge_from_index(mst_edge_map(k), graph);
+                m_sources[k] = source(e, graph);
+                m_targets[k] = target(e, graph);
+                m_adjacency_start[m_sources[k] + 1]++;
+                m_adjacency_start[m_targets[k] + 1]++;
+            }
+            for (index_t i = 0; i < num_v; i++) {
+                m_adjacency_start[i + 1] += m_adjacency_start[i];
+            }
+            m_adjacency.resize(2 * num_mst_edges);
+            std::vector<index_t> position(m_adjacency_start.begin(), m_adjacency_start.end() - 1);
+            for (index_t k = 0; k < num_mst_edges; k++) {
+                m_adjacency[position[m_sources[k]]++] = k;
+                m_adjacency[position[m_targets[k]]++] = k;
+            }
+            m_parent_edge.resize(num_v);
+
+            m_seeds = vertex_seeds;
+            reset(m_seeds);
+        }
+
+        /**
+         * Current seed label of each vertex (background_label for non seed vertices)
+         */
+        const array_1d<label_type> &seeds() const {
+            return m_seeds;
+        }
+
+        /**
+         * Current seeded watershed labelisation: identical to labelisation_seeded_watershed(graph, edge_weights,
+         * seeds(), background_label)
+         */
+        const array_1d<label_type> &labels() const {
+            return m_labels;
+        }
+
+        label_type background_label() const {
+            return m_background_label;
+        }
+
+        /**
+         * Recomputes the labelisation for the given seeds with a union-find sweep over the sorted minimum spanning
+         * tree edges, in O(num_vertices).
+         *
+         * @param xvertex_seeds seed label of each vertex
+         */
+        template<typename T>
+        void reset(const xt::xexpression<T> &xvertex_seeds) {
+            HG_TRACE();
+            auto &vertex_seeds = xvertex_seeds.derived_cast();
+            hg_assert(vertex_seeds.size() == m_parent_edge.size(), "Seeds size does not match graph size.");
+            array_1d<label_type> seeds = vertex_seeds;
+            const index_t num_mst_edges = m_sources.size();
+            array_1d<label_type> labels = seeds;
+            m_active.resize(num_mst_edges);
+            watershed_internal::seeded_watershed_on_sorted_mst(m_sources.data(), m_targets.data(), num_mst_edges,
+                                                               labels, m_background_label, &m_active);
+            m_seeds = std::move(seeds);
+            m_labels = std::move(labels);
+        }
+
+        /**
+         * Sets the seed label of the vertex v: background_label removes the seed of v.
+         *
+         * @param v vertex
+         * @param label new seed label of v
+         */
+        void set_seed(index_t v, label_type label) {
+            if (m_seeds(v) == label) {
+                return;
+            }
+            if (label == m_background_label) {
+                remove_seed(v);
+            } else if (m_seeds(v) == m_background_label) {
+                add_seed(v, label);
+            } else {
+                m_seeds(v) = label;
+                relabel_basin(v, label);
+            }
+        }
+
+        /**
+         * Sets the seed label of every vertex whose seed label differs from the given one.
+         *
+         * @param xvertex_seeds seed label of each vertex
+         */
+        template<typename T>
+        void update_seeds(const xt::xexpression<T> &xvertex_seeds) {
+            HG_TRACE();
+            auto &vertex_seeds = xvertex_seeds.derived_cast();
+            hg_assert(vertex_seeds.size() == m_seeds.size(), "Seeds size does not match graph size.");
+            for (index_t i = 0; i < (index_t) m_seeds.size(); i++) {
+                set_seed(i, vertex_seeds(i));
+            }
+        }
+
+    private:
+
+        index_t other_extremity(index_t k, index_t v) const {
+            return (m_sources[k] == v) ? m_targets[k] : m_sources[k];
+        }
+
+        /**
+         * Visits the vertices of the basin of v (connected by active edges), v first: visit(x) returns false to stop
+         * the traversal. m_parent_edge(x) is the edge through which x was reached.
+         */
+        template<typename visitor_t>
+        void traverse_basin(index_t v, visitor_t visit) {
+            m_stack.clear();
+            m_stack.push_back(v);
+            m_parent_edge[v] = invalid_index;
+            while (!m_stack.empty()) {
+                index_t x = m_stack.back();
+                m_stack.pop_back();
+                if (!visit(x)) {
+                    return;
+                }
+                for (index_t i = m_adjacency_start[x]; i < m_adjacency_start[x + 1]; i++) {
+                    index_t k = m_adjacency[i];
+                    if (m_active[k] && k != m_parent_edge[x]) {
+                        index_t y = other_extremity(k, x);
+                        m_parent_edge[y] = k;
+                        m_stack.push_back(y);
+                    }
+                }
+            }
+        }
+
+        void relabel_basin(index_t v, label_type label) {
+            traverse_basin(v, [this, label](index_t x) {
+                m_labels(x) = label;
+                return true;
+            });
+        }
+
+        void add_seed(index_t v, label_type label) {
+            index_t seed = invalid_index;
+            traverse_basin(v, [this, &seed](index_t x) {
+                if (m_seeds(x) != m_background_label) {
+                    seed = x;
+                    return false;
+                }
+                return true;
+            });
+            if (seed != invalid_index) {
+                // cut the largest edge of the path between the seed and v
+                index_t largest = invalid_index;
+                for (index_t x = seed; x != v;) {
+                    index_t k = m_parent_edge[x];
+                    largest = (largest == invalid_index) ? k : (std::max)(largest, k);
+                    x = other_extremity(k, x);
+                }
+                m_active[largest] = false;
+            }
+            m_seeds(v) = label;
+            relabel_basin(v, label);
+        }
+
+        void remove_seed(index_t v) {
+            // smallest edge between the basin of v and another basin
+            index_t smallest = invalid_index;
+            index_t neighbour = invalid_index;
+            traverse_basin(v, [this, &smallest, &neighbour](index_t x) {
+                for (index_t i = m_adjacency_start[x]; i < m_adjacency_start[x + 1]; i++) {
+                    index_t k = m_adjacency[i];
+                    if (!m_active[k] && (smallest == invalid_index || k < smallest)) {
+                        smallest = k;
+                        neighbour = other_extremity(k, x);
+                    }
+                }
+                return true;
+            });
+            m_seeds(v) = m_background_label;
+            if (smallest != invalid_index) {
+                m_active[smallest] = true;
+                relabel_basin(v, m_labels(neighbour));
+            } else {
+                relabel_basin(v, m_background_label);
+            }
+        }
+
+        label_type m_background_label;
+        // minimum spanning tree edges in increasing order
+        std::vector<index_t> m_sources;
+        std::vector<index_t> m_targets;
+        // true if the minimum spanning tree edge belongs to the seeded minimum spanning forest
+        std::vector<bool> m_active;
+        // minimum spanning tree edges adjacent to each vertex
+        std::vector<index_t> m_adjacency_start;
+        std::vector<index_t> m_adjacency;
+        array_1d<label_type> m_seeds;
+        array_1d<label_type> m_labels;
+        // traversal buffers
+        std::vector<index_t> m_parent_edge;
+        std::vector<index_t> m_stack;
+    };
+
+    /**
+     * Creates an incremental_seeded_watershed of the given edge weighted graph and seeds.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph
+     * @param xedge_weights input graph edge weights
+     * @param xvertex_seeds seed label of each vertex, background_label for non seed vertices
+     * @param background_label label of non seed vertices
+     * @return an incremental_seeded_watershed
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto make_incremental_seeded_watershed(const graph_t &graph,
+                                           const xt::xexpression<T1> &xedge_weights,
+                                           const xt::xexpression<T2> &xvertex_seeds,
+                                           const typename T2::value_type background_label = 0) {
+        return incremental_seeded_watershed<typename T2::value_type>(graph, xedge_weights, xvertex_seeds,
+                                                                     background_label);
+    }
 }
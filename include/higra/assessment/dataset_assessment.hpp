@@ -0,0 +1,301 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "fragmentation_curve.hpp"
+#include "partition.hpp"
+#include "dendrogram_purity.hpp"
+#include <functional>
+#include <limits>
+
+namespace hg {
+
+    namespace dataset_assessment_internal {
+
+        template<typename T>
+        const T &deref(const T &x) {
+            return x;
+        }
+
+        template<typename T>
+        const T &deref(T *x) {
+            return *x;
+        }
+
+        template<typename T>
+        const T &deref(const std::reference_wrapper<T> &x) {
+            return x.get();
+        }
+
+        /**
+         * Assessment of one sample of the dataset: one fragmentation curve and one dendrogram purity (NaN if not
+         * computed) per ground truth.
+         */
+        struct sample_assessment {
+            std::vector<fragmentation_curve<>> curves;
+            std::vector<double> purities;
+        };
+    }
+
+    /**
+     * Assessment of the hierarchies of a whole dataset (for example the hierarchies of the images of a segmentation
+     * benchmark) with respect to one or several ground truth labelisations per sample.
+     *
+     * For each pair (sample, ground truth), the fragmentation curve of the horizontal cuts of the hierarchy is
+     * computed with the given partition measure (see assess_fragmentation_horizontal_cut), together with the
+     * dendrogram purity of the hierarchy (see dendrogram_purity) if requested. The curves are aggregated
+     * incrementally: only the scalar results of each pair (optimal score, optimal number of regions...) and the sum
+     * of the curves are kept.
+     *
+     * The samples given to add_samples are assessed in parallel, by batches of at most max_samples_in_flight
+     * samples: the memory used by the intermediate results (card intersections, horizontal cuts...) is bounded by
+     * the size of a batch. The results of a batch are aggregated in the order of the samples, such that the
+     * aggregated results do not depend on the number of threads. The cancellation token of the calling thread (see
+     * scoped_cancellation_token) is checked between the batches.
+     */
+    class dataset_assesser {
+    public:
+
+        /**
+         * Create an empty assessment.
+         *
+         * @param measure partition measure used to score the horizontal cuts
+         * @param max_regions maximum number of regions in the considered cuts
+         * @param compute_purity if true, the dendrogram purity of the hierarchies is computed for the samples whose
+         * ground truths are labelisations of the tree leaves (i.e. without vertex map)
+         */
+        dataset_assesser(partition_measure measure, size_t max_regions = 200, bool compute_purity = false) :
+                m_measure(measure),
+                m_max_regions(max_regions),
+                m_compute_purity(compute_purity),
+                m_score_sums(xt::zeros<double>({max_regions})) {
+            hg_assert(max_regions > 0, "The maximum number of regions must be strictly positive.");
+        }
+
+        /**
+         * Assess the given samples and aggregate their results with the previous ones: the i-th sample is made of
+         * the tree trees[i], its node altitudes altitudes[i], and the 2d array ground_truths[i] of shape
+         * (num_ground_truths, n) whose rows are the ground truth labelisations of the tree leaves (or of the rag
+         * vertices if vertex_maps[i] is not empty).
+         *
+         * The elements of the vectors can be the objects themselves, pointers or std::reference_wrapper on the
+         * objects.
+         *
+         * @param trees trees of the samples
+         * @param altitudes altitudes of the samples
+         * @param ground_truths ground truths of the samples
+         * @param vertex_maps super-vertices maps of the samples (empty vector or empty arrays if the trees are not
+         * built on rags)
+         * @param max_samples_in_flight maximum number of samples assessed at the same time (0 for twice the number
+         * of threads)
+         */
+        template<typename trees_t, typename altitudes_t, typename ground_truths_t>
+        void add_samples(const std::vector<trees_t> &trees,
+                         const std::vector<altitudes_t> &altitudes,
+                         const std::vector<ground_truths_t> &ground_truths,
+                         const std::vector<array_1d<index_t>> &vertex_maps = {},
+                         index_t max_samples_in_flight = 0) {
+            HG_TRACE();
+            hg_assert(trees.size() == altitudes.size(), "The number of trees and of altitudes do not match.");
+            hg_assert(trees.size() == ground_truths.size(), "The number of trees and of ground truths do not match.");
+            hg_assert(vertex_maps.empty() || vertex_maps.size() == trees.size(),
+                      "The number of trees and of vertex maps do not match.");
+            switch (m_measure) {
+                case partition_measure::DHamming:
+                    add_samples_impl(trees, altitudes, ground_truths, vertex_maps, max_samples_in_flight,
+                                     scorer_partition_DHamming());
+                    break;
+                case partition_measure::DCovering:
+                    add_samples_impl(trees, altitudes, ground_truths, vertex_maps, max_samples_in_flight,
+                                     scorer_partition_DCovering());
+                    break;
+                case partition_measure::BCE:
+                    add_samples_impl(trees, altitudes, ground_truths, vertex_maps, max_samples_in_flight,
+                                     scorer_partition_BCE());
+                    break;
+                default:
+                    throw std::runtime_error("Partition measure is not known.");
+            }
+        }
+
+        /**
+         * Number of samples assessed so far
+         */
+        index_t num_samples() const {
+            return m_num_samples;
+        }
+
+        /**
+         * Number of pairs (sample, ground truth) assessed so far
+         */
+        index_t num_assessments() const {
+            return m_sample_indices.size();
+        }
+
+        /**
+         * Index of the sample of each pair (sample, ground truth), in the order in which the samples were added
+         */
+        array_1d<index_t> sample_indices() const {
+            return xt::adapt(m_sample_indices, {m_sample_indices.size()});
+        }
+
+        /**
+         * Score of the optimal horizontal cut of each pair (sample, ground truth)
+         */
+        array_1d<double> optimal_scores() const {
+            return xt::adapt(m_optimal_scores, {m_optimal_scores.size()});
+        }
+
+        /**
+         * Number of regions of the optimal horizontal cut of each pair (sample, ground truth)
+         */
+        array_1d<double> optimal_numbers_of_regions() const {
+            return xt::adapt(m_optimal_num_regions, {m_optimal_num_regions.size()});
+        }
+
+        /**
+         * Number of non empty regions of the ground truth of each pair (sample, ground truth)
+         */
+        array_1d<double> numbers_of_regions_ground_truth() const {
+            return xt::adapt(m_num_regions_ground_truth, {m_num_regions_ground_truth.size()});
+        }
+
+        /**
+         * Dendrogram purity of each pair (sample, ground truth), NaN if it was not computed
+         */
+        array_1d<double> purities() const {
+            return xt::adapt(m_purities, {m_purities.size()});
+        }
+
+        /**
+         * Mean of the optimal scores over all the pairs (sample, ground truth), NaN if nothing was assessed
+         */
+        double mean_optimal_score() const {
+            return mean(m_optimal_scores);
+        }
+
+        /**
+         * Mean of the dendrogram purities over the pairs (sample, ground truth) where it was computed, NaN if none
+         */
+        double mean_purity() const {
+            return mean(m_purities);
+        }
+
+        /**
+         * Mean fragmentation curve over all the pairs (sample, ground truth): for each number of regions k between 1
+         * and max_regions, the mean over the pairs of the score of the horizontal cut with the largest number of
+         * regions smaller than or equal to k (the finest cut of a curve is held beyond its last number of regions).
+         * The number of regions of the ground truth of the result is the rounded mean of the numbers of regions of
+         * the ground truths.
+         */
+        auto mean_fragmentation_curve() const {
+            const double n = (double) num_assessments();
+            const double num_regions_gt = (n == 0) ? 0 : std::round(
+                    std::accumulate(m_num_regions_ground_truth.begin(), m_num_regions_ground_truth.end(), 0.0) / n);
+            return fragmentation_curve<>{xt::eval(xt::arange<double>(1, (double) m_max_regions + 1)),
+                                         xt::eval(m_score_sums / n),
+                                         (size_t) num_regions_gt};
+        }
+
+    private:
+
+        static double mean(const std::vector<double> &values) {
+            double sum = 0;
+            index_t count = 0;
+            for (auto v: values) {
+                if (!std::isnan(v)) {
+                    sum += v;
+                    count++;
+                }
+            }
+            return (count == 0) ? std::numeric_limits<double>::quiet_NaN() : sum / (double) count;
+        }
+
+        template<typename trees_t, typename altitudes_t, typename ground_truths_t, typename scorer_t>
+        void add_samples_impl(const std::vector<trees_t> &trees,
+                              const std::vector<altitudes_t> &altitudes,
+                              const std::vector<ground_truths_t> &ground_truths,
+                              const std::vector<array_1d<index_t>> &vertex_maps,
+                              index_t max_samples_in_flight,
+                              const scorer_t &scorer) {
+            using namespace dataset_assessment_internal;
+            const index_t num_new_samples = trees.size();
+            if (max_samples_in_flight <= 0) {
+                max_samples_in_flight = 2 * get_num_threads();
+            }
+            const array_1d<index_t> no_vertex_map{};
+            std::vector<sample_assessment> batch;
+            for (index_t start = 0; start < num_new_samples; start += max_samples_in_flight) {
+                check_cancellation();
+                const index_t end = (std::min)(num_new_samples, start + max_samples_in_flight);
+                batch.clear();
+                batch.resize(end - start);
+                parfor(start, end, [&](index_t i) {
+                    const auto &tree = deref(trees[i]);
+                    const auto &sample_altitudes = deref(altitudes[i]);
+                    const auto &sample_ground_truths = deref(ground_truths[i]);
+                    const auto &vertex_map = vertex_maps.empty() ? no_vertex_map : vertex_maps[i];
+                    hg_assert(sample_ground_truths.dimension() == 2, "Ground truths must be 2d arrays.");
+
+                    auto &result = batch[i - start];
+                    result.curves = assess_fragmentation_horizontal_cut_ground_truths(
+                            tree, sample_altitudes, sample_ground_truths, scorer, vertex_map, m_max_regions);
+                    const index_t num_ground_truths = sample_ground_truths.shape()[0];
+                    result.purities.assign(num_ground_truths, std::numeric_limits<double>::quiet_NaN());
+                    if (m_compute_purity && vertex_map.size() <= 1) {
+                        for (index_t g = 0; g < num_ground_truths; g++) {
+                            array_1d<index_t> ground_truth = xt::view(sample_ground_truths, g, xt::all());
+                            result.purities[g] = dendrogram_purity(tree, ground_truth);
+                        }
+                    }
+                });
+                for (index_t i = start; i < end; i++) {
+                    aggregate(m_num_samples + i, batch[i - start]);
+                }
+            }
+            m_num_samples += num_new_samples;
+        }
+
+        void aggregate(index_t sample_index, const dataset_assessment_internal::sample_assessment &result) {
+            for (index_t g = 0; g < (index_t) result.curves.size(); g++) {
+                const auto &curve = result.curves[g];
+                const auto &num_regions = curve.num_regions();
+                const auto &scores = curve.scores();
+                m_sample_indices.push_back(sample_index);
+                m_optimal_scores.push_back(curve.optimal_score());
+                m_optimal_num_regions.push_back(curve.optimal_number_of_regions());
+                m_num_regions_ground_truth.push_back(curve.num_regions_ground_truth());
+                m_purities.push_back(result.purities[g]);
+
+                // step interpolation of the curve on the numbers of regions 1 to max_regions
+                index_t c = 0;
+                for (index_t k = 1; k <= (index_t) m_max_regions; k++) {
+                    while (c + 1 < (index_t) num_regions.size() && num_regions(c + 1) <= k) {
+                        c++;
+                    }
+                    m_score_sums(k - 1) += scores(c);
+                }
+            }
+        }
+
+        partition_measure m_measure;
+        size_t m_max_regions;
+        bool m_compute_purity;
+        index_t m_num_samples = 0;
+
+        array_1d<double> m_score_sums;
+        std::vector<index_t> m_sample_indices;
+        std::vector<double> m_optimal_scores;
+        std::vector<double> m_optimal_num_regions;
+        std::vector<double> m_num_regions_ground_truth;
+        std::vector<double> m_purities;
+    };
+}
@@ -13,12 +13,66 @@
 #include "../graph.hpp"
 #include "../attribute/tree_attribute.hpp"
 #include "../accumulator/tree_accumulator.hpp"
+#include <unordered_map>
 
 namespace hg {
 
     using namespace xt;
     using namespace xt::placeholders;
 
+    namespace dendrogram_purity_internal {
+
+        /**
+         * Partition of the non leaf nodes of a tree into disjoint sub trees having at most max_leaves leaves and a
+         * top part made of the remaining nodes (whose areas are larger than max_leaves). The nodes of the i-th sub
+         * tree are nodes(k) for k in [start(i), start(i + 1)[ (in increasing order), the nodes of the top part are
+         * the ones of the group num_sub_trees.
+         */
+        struct sub_tree_decomposition {
+            array_1d<index_t> start;
+            array_1d<index_t> nodes;
+            index_t num_sub_trees;
+        };
+
+        template<typename tree_t, typename T>
+        sub_tree_decomposition decompose_sub_trees(const tree_t &tree, const T &area, index_t max_leaves) {
+            const index_t num_l = num_leaves(tree);
+            const index_t num_v = num_vertices(tree);
+            const index_t num_nodes = num_v - num_l;
+
+            // top-down: a node belongs to the sub tree of its parent or is a new sub tree root if it is small enough
+            array_1d<index_t> group = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            index_t num_sub_trees = 0;
+            for (index_t n = num_v - 1; n >= num_l; n--) {
+                const index_t p = parent(n, tree);
+                if (p != n && group(p - num_l) != invalid_index) {
+                    group(n - num_l) = group(p - num_l);
+                } else if (area(n) <= max_leaves) {
+                    group(n - num_l) = num_sub_trees++;
+                } else {
+                    group(n - num_l) = invalid_index;
+                }
+            }
+
+            array_1d<index_t> start = xt::zeros<index_t>({(size_t) num_sub_trees + 2});
+            for (index_t i = 0; i < num_nodes; i++) {
+                if (group(i) == invalid_index) {
+                    group(i) = num_sub_trees;
+                }
+                start(group(i) + 1)++;
+            }
+            for (index_t i = 0; i <= num_sub_trees; i++) {
+                start(i + 1) += start(i);
+            }
+            array_1d<index_t> nodes = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            std::vector<index_t> position(start.begin(), start.end() - 1);
+            for (index_t i = 0; i < num_nodes; i++) {
+                nodes(position[group(i)]++) = i + num_l;
+            }
+            return {std::move(start), std::move(nodes), num_sub_trees};
+        }
+    }
+
     /**
      * Weighted average of the purity of each node of the tree with respect to a ground truth
      * labelization of the tree leaves.
@@ -48,8 +102,9 @@ namespace hg {
      *
      * :Complexity:
      *
-     * The dendrogram purity is computed in :math:`\mathcal{O}(N\\times K \\times C^2)` with :math:`N` the number of nodes
-     * in the tree, :math:`K` the number of classes, and :math:`C` the maximal number of children of a node in the tree.
+     * The label histograms of the nodes are sparse and merged from small to large: the dendrogram purity is computed
+     * in expected :math:`\mathcal{O}(N\log(N))` time with :math:`N` the number of nodes in the tree. Disjoint sub
+     * trees are processed in parallel.
      *
      * @tparam tree_t
      * @tparam T
@@ -59,29 +114,99 @@ namespace hg {
      */
     template<typename tree_t, typename T>
     auto dendrogram_purity(const tree_t &tree, const xt::xexpression<T> &xleaf_labels) {
+        HG_TRACE();
         auto &leaf_labels = xleaf_labels.derived_cast();
         hg_assert_1d_array(leaf_labels);
         hg_assert_leaf_weights(tree, leaf_labels);
         hg_assert_integral_value_type(leaf_labels);
+        using label_histogram = std::unordered_map<index_t, index_t>;
 
-        auto num_l = num_leaves(tree);
+        const index_t num_l = num_leaves(tree);
+        const index_t num_v = num_vertices(tree);
         auto area = attribute_area(tree);
+        tree.compute_children();
 
-        auto max_label = xt::amax(leaf_labels)();
-        size_t num_labels = max_label + 1;
-        array_2d<double> label_histo_leaves = zeros<double>({num_l, num_labels});
-        for (index_t i = 0; i < (index_t) num_l; i++) {
-            label_histo_leaves(i, leaf_labels(i)) = 1;
-        }
+        // sparse label histogram of each non leaf node
+        std::vector<label_histogram> histograms(num_v - num_l);
+
+        // Merges the label histograms of the children of n, the histogram of the largest child is reused and the
+        // others are inserted into it (small to large merging). The sum of the products of the counts of a label
+        // in the pairs of children of n is accumulated for each label present in at least two children.
+        auto process_node = [&tree, &leaf_labels, &area, &histograms, num_l](
+                index_t n, std::vector<std::pair<index_t, double>> &pairs, double &total, double &Z) {
+            auto histogram_size = [&histograms, num_l](index_t c) {
+                return (c < num_l) ? (size_t) 1 : histograms[c - num_l].size();
+            };
+            index_t largest = child(0, n, tree);
+            for (auto c: children_iterator(n, tree)) {
+                if (histogram_size(c) > histogram_size(largest)) {
+                    largest = c;
+                }
+            }
+
+            auto &histogram = histograms[n - num_l];
+            if (largest < num_l) {
+                histogram.emplace((index_t) leaf_labels(largest), 1);
+            } else {
+                histogram = std::move(histograms[largest - num_l]);
+                label_histogram().swap(histograms[largest - num_l]);
+            }
 
-        auto label_histo = accumulate_sequential(tree, label_histo_leaves, accumulator_sum());
-        auto class_purity = label_histo / view(area, all(), newaxis());
+            pairs.clear();
+            auto add = [&histogram, &pairs](index_t label, index_t count) {
+                auto it = histogram.find(label);
+                if (it == histogram.end()) {
+                    histogram.emplace(label, count);
+                } else {
+                    pairs.emplace_back(label, (double) it->second * (double) count);
+                    it->second += count;
+                }
+            };
+            for (auto c: children_iterator(n, tree)) {
+                if (c == largest) {
+                    continue;
+                }
+                if (c < num_l) {
+                    add((index_t) leaf_labels(c), 1);
+                } else {
+                    for (const auto &e: histograms[c - num_l]) {
+                        add(e.first, e.second);
+                    }
+                    // the histogram of the child is not needed anymore
+                    label_histogram().swap(histograms[c - num_l]);
+                }
+            }
 
-        auto weights = attribute_children_pair_sum_product(tree, label_histo);
-        double Z = sum(weights)();
-        double total = sum(view(class_purity, range(num_l, _), all()) *
-                           view(weights, range(num_l, _), all()))();
+            double node_total = 0;
+            for (const auto &p: pairs) {
+                Z += p.second;
+                node_total += p.second * (double) histogram.find(p.first)->second;
+            }
+            total += node_total / (double) area(n);
+        };
 
+        const index_t max_leaves = (std::max)((index_t) 1024, num_l / 256);
+        auto decomposition = dendrogram_purity_internal::decompose_sub_trees(tree, area, max_leaves);
+        const index_t num_groups = decomposition.num_sub_trees + 1;
+        std::vector<double> totals(num_groups, 0);
+        std::vector<double> Zs(num_groups, 0);
+
+        auto process_group = [&decomposition, &process_node, &totals, &Zs](index_t g) {
+            std::vector<std::pair<index_t, double>> pairs;
+            for (index_t k = decomposition.start(g); k < decomposition.start(g + 1); k++) {
+                process_node(decomposition.nodes(k), pairs, totals[g], Zs[g]);
+            }
+        };
+        // the sub trees are independent, the top part depends on all of them
+        parfor(0, decomposition.num_sub_trees, process_group);
+        process_group(decomposition.num_sub_trees);
+
+        double total = 0;
+        double Z = 0;
+        for (index_t g = 0; g < num_groups; g++) {
+            total += totals[g];
+            Z += Zs[g];
+        }
         return total / Z;
     }
 };
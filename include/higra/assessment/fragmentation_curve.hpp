@@ -88,33 +88,175 @@ namespace hg {
             size_t back_track_k_right; // number of regions coming from right/second  child
         };
 
-        template<typename value_t=index_t, typename tree_t, typename T>
-        auto compute_card_intersection_tree_ground_truth(
+        /**
+         * Sparse matrix of the cardinal of the intersections between the regions of a tree and the regions of a
+         * ground truth labelisation: the non zero entries of the row of the tree node i are the pairs
+         * (labels(k), counts(k)) for k in [row_start(i), row_start(i + 1)[ (labels are not sorted).
+         */
+        struct sparse_card_intersection {
+            array_1d<index_t> row_start;
+            array_1d<index_t> labels;
+            array_1d<index_t> counts;
+            index_t num_regions_ground_truth;
+
+            /**
+             * Dense sub-matrix made of the rows of the given tree nodes
+             */
+            template<typename value_t, typename T>
+            array_2d<value_t> rows(const T &nodes) const {
+                array_2d<value_t> result = xt::zeros<value_t>({(size_t) nodes.size(),
+                                                               (size_t) num_regions_ground_truth});
+                for (index_t i = 0; i < (index_t) nodes.size(); i++) {
+                    const index_t n = nodes(i);
+                    for (index_t k = row_start(n); k < row_start(n + 1); k++) {
+                        result(i, labels(k)) = (value_t) counts(k);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * Number of non empty ground truth regions
+             */
+            index_t num_non_empty_regions_ground_truth(index_t root_node) const {
+                return row_start(root_node + 1) - row_start(root_node);
+            }
+        };
+
+        /**
+         * Sparse cardinal of the intersections between the regions of the tree and the regions of the ground truth
+         * (see sparse_card_intersection).
+         *
+         * The rows of the leaves are computed from the ground truth and the rows of the non leaf nodes are obtained
+         * by merging the rows of their children in a single bottom-up pass: the size of the result is the sum over
+         * all nodes of the number of ground truth regions they intersect.
+         *
+         * @param tree input tree
+         * @param xground_truth ground truth labelisation of the tree leaves (or of the rag vertices)
+         * @param vertex_map super-vertices map (if tree is built on a rag, leave empty otherwise)
+         */
+        template<typename tree_t, typename T>
+        auto compute_sparse_card_intersection_tree_ground_truth(
                 const tree_t &tree,
                 const xt::xexpression<T> &xground_truth,
                 const array_1d<index_t> &vertex_map = {}) {
+            HG_TRACE();
             auto &ground_truth = xground_truth.derived_cast();
             hg_assert_1d_array(ground_truth);
 
-            auto num_regions_ground_truth = xt::amax(ground_truth)() + 1;
-            array_2d<index_t> card_intersection_leaves({num_leaves(tree), (size_t) num_regions_ground_truth}, 0);
+            const index_t num_regions_ground_truth = xt::amax(ground_truth)() + 1;
+            const index_t num_nodes = num_vertices(tree);
+            const index_t num_leaves_tree = num_leaves(tree);
+
+            std::vector<index_t> row_start(num_nodes + 1);
+            std::vector<index_t> labels;
+            std::vector<index_t> counts;
+            labels.reserve(num_nodes);
+            counts.reserve(num_nodes);
+
+            // dense accumulator of the row being built
+            std::vector<index_t> row_counts(num_regions_ground_truth, 0);
+            std::vector<index_t> row_labels;
+            auto add = [&row_counts, &row_labels](index_t label, index_t count) {
+                if (row_counts[label] == 0) {
+                    row_labels.push_back(label);
+                }
+                row_counts[label] += count;
+            };
+            auto emit_row = [&row_counts, &row_labels, &labels, &counts]() {
+                for (auto l: row_labels) {
+                    labels.push_back(l);
+                    counts.push_back(row_counts[l]);
+                    row_counts[l] = 0;
+                }
+                row_labels.clear();
+            };
+
             if (vertex_map.size() <= 1) { // no rag
                 hg_assert_leaf_weights(tree, ground_truth);
-                for (auto i: leaves_iterator(tree)) {
-                    card_intersection_leaves(i, ground_truth(i))++;
+                for (index_t i = 0; i < num_leaves_tree; i++) {
+                    row_start[i] = i;
+                    labels.push_back(ground_truth(i));
+                    counts.push_back(1);
                 }
             } else { // tree on rag
                 hg_assert(vertex_map.size() == ground_truth.size(), "Vertex map and ground truth sizes do not match.");
+                // vertices of each leaf
+                std::vector<index_t> leaf_start(num_leaves_tree + 1, 0);
                 for (index_t i = 0; i < (index_t) vertex_map.size(); i++) {
-                    card_intersection_leaves(vertex_map(i), ground_truth(i))++;
+                    leaf_start[vertex_map(i) + 1]++;
+                }
+                for (index_t i = 0; i < num_leaves_tree; i++) {
+                    leaf_start[i + 1] += leaf_start[i];
+                }
+                std::vector<index_t> leaf_vertices(vertex_map.size());
+                std::vector<index_t> position(leaf_start.begin(), leaf_start.end() - 1);
+                for (index_t i = 0; i < (index_t) vertex_map.size(); i++) {
+                    leaf_vertices[position[vertex_map(i)]++] = i;
+                }
+                for (index_t i = 0; i < num_leaves_tree; i++) {
+                    row_start[i] = labels.size();
+                    for (index_t k = leaf_start[i]; k < leaf_start[i + 1]; k++) {
+                        add(ground_truth(leaf_vertices[k]), 1);
+                    }
+                    emit_row();
                 }
             }
 
-            array_2d<value_t> card_intersection = accumulate_sequential(tree, card_intersection_leaves,
-                                                                        accumulator_sum());
-            return card_intersection;
-        };
+            tree.compute_children();
+            for (index_t n = num_leaves_tree; n < num_nodes; n++) {
+                row_start[n] = labels.size();
+                for (auto c: children_iterator(n, tree)) {
+                    // row_start[c + 1] is known as c < n
+                    const index_t end = (c + 1 < n) ? row_start[c + 1] : row_start[n];
+                    for (index_t k = row_start[c]; k < end; k++) {
+                        add(labels[k], counts[k]);
+                    }
+                }
+                emit_row();
+            }
+            row_start[num_nodes] = labels.size();
 
+            return sparse_card_intersection{xt::adapt(row_start, {row_start.size()}),
+                                            xt::adapt(labels, {labels.size()}),
+                                            xt::adapt(counts, {counts.size()}),
+                                            num_regions_ground_truth};
+        }
+
+        /**
+         * Scores of the given cuts: the score of the i-th cut is computed by the partition scorer on the cardinal
+         * of the intersections between the nodes cut_nodes[i] and the ground truth regions. The cuts are scored in
+         * parallel.
+         */
+        template<typename scorer_t>
+        array_1d<double> score_cuts(const std::vector<array_1d<index_t>> &cut_nodes,
+                                    const sparse_card_intersection &card_intersection,
+                                    const scorer_t &partition_scorer) {
+            array_1d<double> scores = array_1d<double>::from_shape({cut_nodes.size()});
+            parfor(0, cut_nodes.size(), [&scores, &cut_nodes, &card_intersection, &partition_scorer](index_t i) {
+                scores(i) = partition_scorer.score(card_intersection.template rows<double>(cut_nodes[i]));
+            });
+            return scores;
+        }
+
+        /**
+         * Nodes of the horizontal cuts of the hierarchy having at most max_regions regions
+         */
+        template<typename tree_t, typename T>
+        auto horizontal_cuts_nodes(const tree_t &tree, const T &altitudes, size_t max_regions) {
+            auto hc_explorer = make_horizontal_cut_explorer(tree, altitudes);
+            auto &num_regions_cuts = hc_explorer.num_regions_cuts();
+            auto last_cut = std::upper_bound(num_regions_cuts.begin(), num_regions_cuts.end(), max_regions);
+            index_t num_cuts = std::distance(num_regions_cuts.begin(), last_cut);
+
+            std::vector<array_1d<index_t>> cut_nodes(num_cuts);
+            parfor(0, num_cuts, [&cut_nodes, &hc_explorer](index_t i) {
+                cut_nodes[i] = std::move(hc_explorer.horizontal_cut_from_index(i).nodes);
+            });
+            array_1d<index_t> num_regions = xt::empty<index_t>({(size_t) num_cuts});
+            std::copy(num_regions_cuts.begin(), num_regions_cuts.begin() + num_cuts, num_regions.begin());
+            return std::make_pair(std::move(cut_nodes), std::move(num_regions));
+        }
     }
 
     /**
@@ -388,6 +530,25 @@ namespace hg {
         size_t m_num_regions_ground_truth;
     };
 
+    /**
+     * Fragmentation curve of the horizontal cuts of a hierarchy with respect to a ground truth labelisation of its
+     * base graph: for each horizontal cut with at most max_regions regions, the score of the cut computed with the
+     * given partition scorer (see scorer_partition_BCE, scorer_partition_DHamming, scorer_partition_DCovering).
+     *
+     * The cuts are scored in parallel: the score function of the partition scorer must be thread safe.
+     *
+     * @tparam tree_t tree type
+     * @tparam T1 altitudes type
+     * @tparam T2 ground truth type
+     * @tparam scorer_t partition scorer type
+     * @param tree input hierarchy
+     * @param xaltitudes node altitudes of the hierarchy
+     * @param xground_truth ground truth labelisation of the tree leaves (or of the rag vertices)
+     * @param partition_scorer partition scorer
+     * @param vertex_map super-vertices map (if tree is built on a rag, leave empty otherwise)
+     * @param max_regions maximum number of regions in the considered cuts
+     * @return a fragmentation_curve
+     */
     template<typename tree_t, typename T1, typename T2, typename scorer_t>
     auto assess_fragmentation_horizontal_cut(
             const tree_t &tree,
@@ -396,6 +557,7 @@ namespace hg {
             const scorer_t &partition_scorer,
             const array_1d<index_t> &vertex_map = {},
             size_t max_regions = 200) {
+        HG_TRACE();
         auto &altitudes = xaltitudes.derived_cast();
         auto &ground_truth = xground_truth.derived_cast();
 
@@ -404,29 +566,88 @@ namespace hg {
         hg_assert_1d_array(ground_truth);
         max_regions = (std::min)(max_regions, num_leaves(tree));
 
-        auto card_intersection = fragmentation_curve_internal::compute_card_intersection_tree_ground_truth<double>(
+        auto card_intersection = fragmentation_curve_internal::compute_sparse_card_intersection_tree_ground_truth(
                 tree, ground_truth, vertex_map);
 
-        auto hc_explorer = make_horizontal_cut_explorer(tree, altitudes);
-        auto &num_regions_cuts = hc_explorer.num_regions_cuts();
-        auto last_cut = std::upper_bound(num_regions_cuts.begin(), num_regions_cuts.end(), max_regions);
-
-        index_t num_cuts = std::distance(num_regions_cuts.begin(), last_cut);
-
-        array_1d<double> scores = xt::empty<double>({num_cuts});
-        array_1d<index_t> num_regions = xt::empty<index_t>({num_cuts});
-        std::copy(num_regions_cuts.begin(), num_regions_cuts.begin() + num_cuts, num_regions.begin());
-
-        for (index_t i = 0; i < num_cuts; i++) {
-            auto hc = hc_explorer.horizontal_cut_from_index(i);
-            scores(i) = partition_scorer.score(xt::view(card_intersection, xt::keep(hc.nodes), xt::all()));
-        }
+        auto cuts = fragmentation_curve_internal::horizontal_cuts_nodes(tree, altitudes, max_regions);
+        auto scores = fragmentation_curve_internal::score_cuts(cuts.first, card_intersection, partition_scorer);
 
-        size_t num_regions_ground_truth = xt::count_nonzero(xt::view(card_intersection, root(tree), xt::all()))();;
+        size_t num_regions_ground_truth = card_intersection.num_non_empty_regions_ground_truth(root(tree));
 
-        return hg::fragmentation_curve<>{std::move(num_regions),
+        return hg::fragmentation_curve<>{std::move(cuts.second),
                                          std::move(scores),
                                          num_regions_ground_truth};
     };
 
+    /**
+     * Fragmentation curves of the horizontal cuts of a hierarchy with respect to several ground truth labelisations
+     * of its base graph (see assess_fragmentation_horizontal_cut).
+     *
+     * The horizontal cuts are computed once and shared by all the ground truths. The sparse card intersection
+     * matrices of the ground truths are computed in parallel and all the pairs (ground truth, cut) are then scored
+     * in parallel: the score function of the partition scorer must be thread safe.
+     *
+     * @tparam tree_t tree type
+     * @tparam T1 altitudes type
+     * @tparam T2 ground truths type
+     * @tparam scorer_t partition scorer type
+     * @param tree input hierarchy
+     * @param xaltitudes node altitudes of the hierarchy
+     * @param xground_truths 2d array of shape (num_ground_truths, n): each row is a ground truth labelisation of
+     * the tree leaves (or of the rag vertices)
+     * @param partition_scorer partition scorer
+     * @param vertex_map super-vertices map (if tree is built on a rag, leave empty otherwise)
+     * @param max_regions maximum number of regions in the considered cuts
+     * @return a vector containing the fragmentation_curve of each ground truth
+     */
+    template<typename tree_t, typename T1, typename T2, typename scorer_t>
+    auto assess_fragmentation_horizontal_cut_ground_truths(
+            const tree_t &tree,
+            const xt::xexpression<T1> &xaltitudes,
+            const xt::xexpression<T2> &xground_truths,
+            const scorer_t &partition_scorer,
+            const array_1d<index_t> &vertex_map = {},
+            size_t max_regions = 200) {
+        HG_TRACE();
+        using namespace fragmentation_curve_internal;
+        auto &altitudes = xaltitudes.derived_cast();
+        auto &ground_truths = xground_truths.derived_cast();
+
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_integral_value_type(ground_truths);
+        hg_assert(ground_truths.dimension() == 2, "Ground truths must be a 2d array.");
+        max_regions = (std::min)(max_regions, num_leaves(tree));
+        const index_t num_ground_truths = ground_truths.shape()[0];
+
+        tree.compute_children();
+        std::vector<sparse_card_intersection> card_intersections(num_ground_truths);
+        parfor(0, num_ground_truths, [&card_intersections, &tree, &ground_truths, &vertex_map](index_t g) {
+            array_1d<index_t> ground_truth = xt::view(ground_truths, g, xt::all());
+            card_intersections[g] = compute_sparse_card_intersection_tree_ground_truth(tree, ground_truth,
+                                                                                       vertex_map);
+        });
+
+        auto cuts = horizontal_cuts_nodes(tree, altitudes, max_regions);
+        auto &cut_nodes = cuts.first;
+        const index_t num_cuts = cut_nodes.size();
+
+        array_2d<double> scores = array_2d<double>::from_shape({(size_t) num_ground_truths, (size_t) num_cuts});
+        parfor(0, num_ground_truths * num_cuts,
+               [&scores, &cut_nodes, &card_intersections, &partition_scorer, num_cuts](index_t i) {
+                   const index_t g = i / num_cuts;
+                   const index_t c = i % num_cuts;
+                   scores(g, c) = partition_scorer.score(
+                           card_intersections[g].template rows<double>(cut_nodes[c]));
+               });
+
+        std::vector<hg::fragmentation_curve<>> result;
+        result.reserve(num_ground_truths);
+        for (index_t g = 0; g < num_ground_truths; g++) {
+            result.emplace_back(array_1d<double>(cuts.second),
+                                array_1d<double>(xt::view(scores, g, xt::all())),
+                                card_intersections[g].num_non_empty_regions_ground_truth(root(tree)));
+        }
+        return result;
+    };
+
 };
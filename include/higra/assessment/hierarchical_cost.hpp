@@ -0,0 +1,194 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "dendrogram_purity.hpp"
+#include "../structure/lca_fast.hpp"
+#include <cmath>
+
+namespace hg {
+
+    namespace hierarchical_cost_internal {
+
+        /**
+         * Calls fun(i, lca) for each edge i of the graph with the lowest common ancestor lca of its extremities in
+         * the tree (see for_each_lca: the edges are processed in parallel, in any order).
+         */
+        template<typename tree_t, typename graph_t, typename F>
+        void for_each_edge_lca(const tree_t &tree, const graph_t &leaf_graph, const F &fun) {
+            hg_assert(num_vertices(leaf_graph) == num_leaves(tree),
+                      "The number of vertices of the leaf graph does not match the number of leaves of the tree.");
+            lca_fast lca(tree);
+            lca.for_each_lca(num_edges(leaf_graph),
+                             [&leaf_graph](index_t i) {
+                                 return (index_t) source(edge_from_index(i, leaf_graph), leaf_graph);
+                             },
+                             [&leaf_graph](index_t i) {
+                                 return (index_t) target(edge_from_index(i, leaf_graph), leaf_graph);
+                             },
+                             fun);
+        }
+    }
+
+    /**
+     * Dasgupta's cost is an unsupervised measure of the quality of a hierarchical clustering of an edge weighted graph.
+     *
+     * Let :math:`T` be a tree representing a hierarchical clustering of the graph :math:`G=(V, E)`.
+     * Let :math:`w` be a dissimilarity function on the edges :math:`E` of the graph.
+     *
+     * The Dasgupta's cost is define as:
+     *
+     * .. math::
+     *
+     *     dasgupta(T, V, E, w) = \sum_{\{x,y\}\in E} \frac{area(lca_T(x,y))}{w(\{x,y\})}
+     *
+     * :See:
+     *
+     *     S. Dasgupta. "A cost function for similarity-based hierarchical clustering."
+     *     In Proc. STOC, pages 118–127, Cambridge, MA, USA, 2016
+     *
+     * :Complexity:
+     *
+     * The lowest common ancestors of the edges are computed in a parallel batch: the runtime complexity is
+     * :math:`\mathcal{O}(n\log(n) + m)` with :math:`n` the number of nodes in :math:`T` and :math:`m` the number of
+     * edges in :math:`E`.
+     *
+     * @tparam tree_t
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param tree input tree
+     * @param leaf_graph graph on the leaves of the tree
+     * @param xedge_weights edge weights of the leaf graph (dissimilarities)
+     * @param xvertex_area area of the vertices of the leaf graph
+     * @return a real number
+     */
+    template<typename tree_t, typename graph_t, typename T1, typename T2>
+    double dasgupta_cost(const tree_t &tree,
+                         const graph_t &leaf_graph,
+                         const xt::xexpression<T1> &xedge_weights,
+                         const xt::xexpression<T2> &xvertex_area) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &vertex_area = xvertex_area.derived_cast();
+        hg_assert_edge_weights(leaf_graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        hg_assert_leaf_weights(tree, vertex_area);
+        hg_assert_1d_array(vertex_area);
+
+        auto area = attribute_area(tree, vertex_area);
+        array_1d<double> cost = array_1d<double>::from_shape({num_edges(leaf_graph)});
+        hierarchical_cost_internal::for_each_edge_lca(tree, leaf_graph,
+                                                      [&cost, &area, &edge_weights](index_t i, index_t n) {
+                                                          cost(i) = (double) area(n) / (double) edge_weights(i);
+                                                      });
+        return xt::sum(cost)();
+    }
+
+    /**
+     * Dasgupta's cost with leaves of unit area (see dasgupta_cost).
+     *
+     * @tparam tree_t
+     * @tparam graph_t
+     * @tparam T
+     * @param tree input tree
+     * @param leaf_graph graph on the leaves of the tree
+     * @param xedge_weights edge weights of the leaf graph (dissimilarities)
+     * @return a real number
+     */
+    template<typename tree_t, typename graph_t, typename T>
+    double dasgupta_cost(const tree_t &tree,
+                         const graph_t &leaf_graph,
+                         const xt::xexpression<T> &xedge_weights) {
+        return dasgupta_cost(tree, leaf_graph, xedge_weights, xt::ones<index_t>({num_leaves(tree)}));
+    }
+
+    /**
+     * Tree sampling divergence is an unsupervised measure of the quality of a hierarchical clustering of an
+     * edge weighted graph.
+     *
+     * It is defined as the Kullback-Leibler divergence between the edge sampling model :math:`p` and the independent
+     * (null) sampling model :math:`q` of the non leaf nodes of a tree:
+     *
+     * .. math::
+     *
+     *     TSD(T) = \sum_{x \in T} p(x) \log\frac{p(x)}{q(x)}
+     *
+     * where :math:`p(x)` is the normalized weight of the edges whose lowest common ancestor is :math:`x` and
+     * :math:`q(x)` is the children pair sum product of the normalized weights of the nodes, the weight of a leaf
+     * being the sum of the weights of its incident edges.
+     *
+     * :See:
+     *
+     *     Charpentier, B. & Bonald, T. (2019). "Tree Sampling Divergence: An Information-Theoretic Metric for
+     *     Hierarchical Graph Clustering." Proceedings of IJCAI.
+     *
+     * :Complexity:
+     *
+     * The lowest common ancestors of the edges are computed in a parallel batch and the node probabilities in
+     * linear time: the runtime complexity is :math:`\mathcal{O}(N\log(N) + M)` with :math:`N` the number of nodes in
+     * the tree and :math:`M` the number of edges in the leaf graph.
+     *
+     * @tparam tree_t
+     * @tparam graph_t
+     * @tparam T
+     * @param tree input tree
+     * @param leaf_graph graph on the leaves of the tree
+     * @param xedge_weights edge weights of the leaf graph (similarities)
+     * @return a real number
+     */
+    template<typename tree_t, typename graph_t, typename T>
+    double tree_sampling_divergence(const tree_t &tree,
+                                    const graph_t &leaf_graph,
+                                    const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(leaf_graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        const index_t num_l = num_leaves(tree);
+        const index_t num_v = num_vertices(tree);
+        const double total_weight = xt::sum(edge_weights)();
+
+        // edge model
+        array_1d<index_t> lca_map = array_1d<index_t>::from_shape({num_edges(leaf_graph)});
+        hierarchical_cost_internal::for_each_edge_lca(tree, leaf_graph, [&lca_map](index_t i, index_t n) {
+            lca_map(i) = n;
+        });
+        array_1d<double> p = xt::zeros<double>({num_v});
+        array_1d<double> leaf_weights = xt::zeros<double>({num_l});
+        for (index_t i = 0; i < (index_t) lca_map.size(); i++) {
+            const double w = edge_weights(i) / total_weight;
+            p(lca_map(i)) += w;
+            auto e = edge_from_index(i, leaf_graph);
+            leaf_weights(source(e, leaf_graph)) += w;
+            leaf_weights(target(e, leaf_graph)) += w;
+        }
+
+        // null model
+        auto node_weights = accumulate_sequential(tree, leaf_weights, accumulator_sum());
+        tree.compute_children();
+        array_1d<double> divergence = xt::zeros<double>({num_v});
+        parfor(num_l, num_v, [&tree, &p, &node_weights, &divergence](index_t n) {
+            if (p(n) == 0) {
+                return;
+            }
+            double q = 0;
+            double sum = 0;
+            for (auto c: children_iterator(n, tree)) {
+                q += node_weights(c) * sum;
+                sum += node_weights(c);
+            }
+            divergence(n) = p(n) * std::log(p(n) / q);
+        });
+        return xt::sum(divergence)();
+    }
+}
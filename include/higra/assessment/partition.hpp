@@ -11,6 +11,8 @@
 #pragma once
 
 #include "../structure/array.hpp"
+#include "../utils.hpp"
+#include <algorithm>
 #include <vector>
 #include <xtensor/xview.hpp>
 
@@ -60,6 +62,144 @@ namespace hg {
         return result;
     }
 
+    /**
+     * Sparse matrix of the cardinal of the intersections between the regions of a candidate partition and the
+     * regions of a ground truth partition: the non zero entries of the row of the candidate region i are the pairs
+     * (labels(k), counts(k)) for k in [row_start(i), row_start(i + 1)[ (labels are sorted in increasing order).
+     *
+     * candidate_area(i) and ground_truth_area(j) are the sums of the row i and of the column j.
+     */
+    struct sparse_contingency_table {
+        array_1d<index_t> row_start;
+        array_1d<index_t> labels;
+        array_1d<index_t> counts;
+        array_1d<index_t> candidate_area;
+        array_1d<index_t> ground_truth_area;
+
+        index_t num_regions_candidate() const {
+            return candidate_area.size();
+        }
+
+        index_t num_regions_ground_truth() const {
+            return ground_truth_area.size();
+        }
+
+        index_t num_elements() const {
+            return xt::sum(candidate_area)();
+        }
+
+        /**
+         * Dense version of the table (see card_intersections)
+         */
+        template<typename value_type=index_t>
+        array_2d<value_type> to_dense() const {
+            array_2d<value_type> result = xt::zeros<value_type>({(size_t) num_regions_candidate(),
+                                                                 (size_t) num_regions_ground_truth()});
+            for (index_t i = 0; i < num_regions_candidate(); i++) {
+                for (index_t k = row_start(i); k < row_start(i + 1); k++) {
+                    result(i, labels(k)) = (value_type) counts(k);
+                }
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Sparse version of card_intersections: the size of each result is linear in the number of pairs of candidate
+     * and ground truth regions that intersect instead of being the product of their number of regions.
+     *
+     * The elements are sorted once by candidate region with a counting sort, then the rows of each ground truth are
+     * accumulated with a dense buffer of the size of the number of ground truth regions. The ground truths are
+     * processed in parallel.
+     *
+     * @param xcandidate candidate labelisation
+     * @param xground_truths ground truth labelisation or stacked ground truth labelisations
+     * @return a vector of sparse_contingency_table (one per ground truth)
+     */
+    template<typename T1, typename T2>
+    auto sparse_card_intersections(const xt::xexpression<T1> &xcandidate,
+                                   const xt::xexpression<T2> &xground_truths) {
+        HG_TRACE();
+        auto &candidate = xcandidate.derived_cast();
+        auto &ground_truths = xground_truths.derived_cast();
+
+        hg_assert_integral_value_type(candidate);
+        hg_assert_integral_value_type(ground_truths);
+
+        const auto cf = xt::eval(xt::flatten(candidate));
+        const index_t num_elements = cf.size();
+        const index_t num_regions_candidate = (num_elements == 0) ? 0 : xt::amax(cf)() + 1;
+
+        // elements sorted by candidate region
+        array_1d<index_t> candidate_start = xt::zeros<index_t>({(size_t) num_regions_candidate + 1});
+        for (index_t i = 0; i < num_elements; i++) {
+            candidate_start(cf(i) + 1)++;
+        }
+        for (index_t i = 0; i < num_regions_candidate; i++) {
+            candidate_start(i + 1) += candidate_start(i);
+        }
+        array_1d<index_t> candidate_area = xt::view(candidate_start, xt::range(1, num_regions_candidate + 1)) -
+                                           xt::view(candidate_start, xt::range(0, num_regions_candidate));
+        std::vector<index_t> elements(num_elements);
+        {
+            std::vector<index_t> position(candidate_start.begin(), candidate_start.end() - 1);
+            for (index_t i = 0; i < num_elements; i++) {
+                elements[position[cf(i)]++] = i;
+            }
+        }
+
+        auto compute = [&candidate_start, &candidate_area, &elements, num_regions_candidate, num_elements](
+                const auto &gtf) {
+            const index_t num_regions_ground_truth = (num_elements == 0) ? 0 : xt::amax(gtf)() + 1;
+            std::vector<index_t> row_start(num_regions_candidate + 1);
+            std::vector<index_t> labels;
+            std::vector<index_t> counts;
+            array_1d<index_t> ground_truth_area = xt::zeros<index_t>({(size_t) num_regions_ground_truth});
+
+            // dense accumulator of the row being built
+            std::vector<index_t> row_counts(num_regions_ground_truth, 0);
+            std::vector<index_t> row_labels;
+            for (index_t i = 0; i < num_regions_candidate; i++) {
+                row_start[i] = labels.size();
+                for (index_t k = candidate_start(i); k < candidate_start(i + 1); k++) {
+                    const index_t l = gtf(elements[k]);
+                    if (row_counts[l]++ == 0) {
+                        row_labels.push_back(l);
+                    }
+                }
+                std::sort(row_labels.begin(), row_labels.end());
+                for (auto l: row_labels) {
+                    labels.push_back(l);
+                    counts.push_back(row_counts[l]);
+                    ground_truth_area(l) += row_counts[l];
+                    row_counts[l] = 0;
+                }
+                row_labels.clear();
+            }
+            row_start[num_regions_candidate] = labels.size();
+
+            return sparse_contingency_table{xt::adapt(row_start, {row_start.size()}),
+                                            xt::adapt(labels, {labels.size()}),
+                                            xt::adapt(counts, {counts.size()}),
+                                            candidate_area,
+                                            std::move(ground_truth_area)};
+        };
+
+        std::vector<sparse_contingency_table> result;
+        if (xt::same_shape(candidate.shape(), ground_truths.shape())) {
+            result.push_back(compute(xt::eval(xt::flatten(ground_truths))));
+        } else {
+            const index_t num_ground_truths = ground_truths.shape()[0];
+            result.resize(num_ground_truths);
+            parfor(0, num_ground_truths, [&result, &compute, &candidate, &ground_truths](index_t g) {
+                const auto ground_truth = xt::eval(xt::view(ground_truths, g));
+                hg_assert_same_shape(candidate, ground_truth);
+                result[g] = compute(xt::flatten(ground_truth));
+            });
+        }
+        return result;
+    }
+
     struct scorer_partition_BCE {
         template<typename T>
         static
@@ -74,6 +214,20 @@ namespace hg {
 
             return score / xt::sum(candidate_regions_area)();
         }
+
+        static
+        double score(const sparse_contingency_table &card_intersection) {
+            const auto &c = card_intersection;
+            double score = 0;
+            for (index_t i = 0; i < c.num_regions_candidate(); i++) {
+                const double area = (double) c.candidate_area(i);
+                for (index_t k = c.row_start(i); k < c.row_start(i + 1); k++) {
+                    const double count = (double) c.counts(k);
+                    score += count * (std::min)(count / (double) c.ground_truth_area(c.labels(k)), count / area);
+                }
+            }
+            return score / (double) c.num_elements();
+        }
     };
 
     struct scorer_partition_DHamming {
@@ -84,6 +238,20 @@ namespace hg {
 
             return (xt::sum(xt::amax(card_intersection, {1}))() / xt::sum(card_intersection)());
         }
+
+        static
+        double score(const sparse_contingency_table &card_intersection) {
+            const auto &c = card_intersection;
+            double score = 0;
+            for (index_t i = 0; i < c.num_regions_candidate(); i++) {
+                index_t max_count = 0;
+                for (index_t k = c.row_start(i); k < c.row_start(i + 1); k++) {
+                    max_count = (std::max)(max_count, c.counts(k));
+                }
+                score += (double) max_count;
+            }
+            return score / (double) c.num_elements();
+        }
     };
 
     struct scorer_partition_DCovering {
@@ -100,6 +268,23 @@ namespace hg {
 
             return score / xt::sum(candidate_regions_area)();
         }
+
+        static
+        double score(const sparse_contingency_table &card_intersection) {
+            const auto &c = card_intersection;
+            double score = 0;
+            for (index_t i = 0; i < c.num_regions_candidate(); i++) {
+                const double area = (double) c.candidate_area(i);
+                double max_ratio = 0;
+                for (index_t k = c.row_start(i); k < c.row_start(i + 1); k++) {
+                    const double count = (double) c.counts(k);
+                    const double card_union = (double) c.ground_truth_area(c.labels(k)) - count + area;
+                    max_ratio = (std::max)(max_ratio, count / card_union);
+                }
+                score += max_ratio * area;
+            }
+            return score / (double) c.num_elements();
+        }
     };
 
     template<typename T, typename scorer_t>
@@ -115,7 +300,7 @@ namespace hg {
     auto assess_partition(const xt::xexpression<T1> &xcandidate,
                           const xt::xexpression<T2> &xground_truths,
                           const scorer_t &scorer) {
-        auto card_intersections = hg::card_intersections<double>(xcandidate, xground_truths);
+        auto card_intersections = hg::sparse_card_intersections(xcandidate, xground_truths);
         return assess_partition(card_intersections, scorer);
     }
 
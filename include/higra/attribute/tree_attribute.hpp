@@ -12,12 +12,160 @@
 
 #include "../graph.hpp"
 #include "../accumulator/tree_accumulator.hpp"
+#include "../hierarchy/common.hpp"
+#include "../structure/lca_fast.hpp"
+#include "../sorting.hpp"
 #include "xtensor/xview.hpp"
 #include "xtensor/xindex_view.hpp"
 #include "xtensor/xnoalias.hpp"
+#include <atomic>
+#include <memory>
 
 namespace hg {
 
+    namespace tree_attribute_parallel_internal {
+
+        /**
+         * Suffix sums of linked lists by pointer jumping (Wyllie's algorithm).
+         *
+         * next(i) is the successor of the element i: all the lists end with the sentinel element next.size() - 1,
+         * which is its own successor and whose value must be 0 (several elements may share a successor, the lists
+         * can thus form an in-tree, for example the parent relation of a tree). On output, values(i) is the sum of
+         * the values of the elements from i (included) to the end of its list, and next(i) is the sentinel.
+         *
+         * Each round halves the distance of every element to the sentinel: all the elements are processed in
+         * parallel in O(log(length of the longest list)) rounds.
+         */
+        template<typename value_t>
+        void pointer_jumping_suffix_sums(array_1d<index_t> &next, array_1d<value_t> &values) {
+            const index_t size = next.size();
+            const index_t sentinel = size - 1;
+            array_1d<index_t> next2 = array_1d<index_t>::from_shape({(size_t) size});
+            array_1d<value_t> values2 = array_1d<value_t>::from_shape({(size_t) size});
+            bool unfinished = true;
+            while (unfinished) {
+                std::atomic<bool> jumped(false);
+                parfor(0, size, [&](index_t i) {
+                    const index_t j = next(i);
+                    values2(i) = values(i) + values(j);
+                    next2(i) = next(j);
+                    if (next2(i) != sentinel) {
+                        jumped.store(true, std::memory_order_relaxed);
+                    }
+                });
+                std::swap(next, next2);
+                std::swap(values, values2);
+                unfinished = jumped.load();
+            }
+        }
+
+        /**
+         * Children of the nodes of a tree computed in parallel: the non root nodes are stably sorted by parent, the
+         * children of the node n are then children(child_start(n)), ..., children(child_end(n) - 1) in increasing
+         * order (as with tree.compute_children) and position(c) is the position of the node c in children.
+         * child_start(n) is invalid_index if n is a leaf.
+         */
+        struct parallel_children {
+            array_1d<index_t> children;
+            array_1d<index_t> child_start;
+            array_1d<index_t> child_end;
+            array_1d<index_t> position;
+        };
+
+        template<typename tree_t>
+        parallel_children make_parallel_children(const tree_t &tree) {
+            const index_t num_v = num_vertices(tree);
+            auto &parents = tree.parents();
+            parallel_children res;
+            res.children = xt::arange<index_t>(num_v - 1);
+            stable_sort(execution::par, res.children.begin(), res.children.end(), [&parents](index_t a, index_t b) {
+                return parents(a) < parents(b);
+            });
+            res.child_start = array_1d<index_t>::from_shape({(size_t) num_v});
+            res.child_end = array_1d<index_t>::from_shape({(size_t) num_v});
+            res.position = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&res](index_t n) {
+                res.child_start(n) = invalid_index;
+                res.child_end(n) = invalid_index;
+            });
+            const index_t num_c = num_v - 1;
+            parfor(0, num_c, [&res, &parents, num_c](index_t k) {
+                const index_t c = res.children(k);
+                const index_t p = parents(c);
+                res.position(c) = k;
+                if (k == 0 || parents(res.children(k - 1)) != p) {
+                    res.child_start(p) = k;
+                }
+                if (k == num_c - 1 || parents(res.children(k + 1)) != p) {
+                    res.child_end(p) = k + 1;
+                }
+            });
+            res.position(root(tree)) = invalid_index;
+            return res;
+        }
+
+        /**
+         * Suffix sums along the Euler tour of a tree (see pointer_jumping_suffix_sums).
+         *
+         * Each non root node c is entered by the element c of the tour (coming from its parent) and left by the
+         * element num_vertices(tree) + c (going back to its parent). The value of the element c is leaf_value(c) if c
+         * is a leaf and 0 otherwise, the value of the element num_vertices(tree) + c is 0. For a non root node c,
+         * sums(c) - sums(num_vertices(tree) + c) is then the sum of the values of the leaves of the subtree rooted in
+         * c, and sums(children(child_start(root))) is the sum of the values of all the leaves.
+         */
+        template<typename value_t, typename tree_t, typename F>
+        array_1d<value_t> euler_tour_suffix_sums(const tree_t &tree, const parallel_children &ch,
+                                                 const F &leaf_value) {
+            const index_t num_v = num_vertices(tree);
+            const index_t root_node = root(tree);
+            const index_t sentinel = 2 * num_v;
+            auto &parents = tree.parents();
+            array_1d<index_t> next = array_1d<index_t>::from_shape({(size_t) sentinel + 1});
+            array_1d<value_t> sums = array_1d<value_t>::from_shape({(size_t) sentinel + 1});
+            parfor(0, num_v, [&](index_t c) {
+                if (c == root_node) {
+                    next(c) = sentinel;
+                    next(num_v + c) = sentinel;
+                    sums(c) = 0;
+                    sums(num_v + c) = 0;
+                    return;
+                }
+                const bool leaf = ch.child_start(c) == invalid_index;
+                next(c) = leaf ? num_v + c : ch.children(ch.child_start(c));
+                sums(c) = leaf ? (value_t) leaf_value(c) : (value_t) 0;
+                const index_t p = parents(c);
+                const index_t k = ch.position(c);
+                if (k + 1 < ch.child_end(p)) {
+                    next(num_v + c) = ch.children(k + 1);
+                } else {
+                    next(num_v + c) = (p == root_node) ? sentinel : num_v + p;
+                }
+                sums(num_v + c) = 0;
+            });
+            next(sentinel) = sentinel;
+            sums(sentinel) = 0;
+            pointer_jumping_suffix_sums(next, sums);
+            return sums;
+        }
+
+        /**
+         * Sum of the leaf values of the subtree rooted in each node, from the Euler tour suffix sums.
+         */
+        template<typename value_t, typename tree_t>
+        array_1d<value_t> subtree_sums_from_euler_tour(const tree_t &tree, const parallel_children &ch,
+                                                       const array_1d<value_t> &sums) {
+            const index_t num_v = num_vertices(tree);
+            const index_t root_node = root(tree);
+            array_1d<value_t> res = array_1d<value_t>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&](index_t n) {
+                res(n) = (n == root_node) ?
+                         sums(ch.children(ch.child_start(root_node))) :
+                         (value_t) (sums(n) - sums(num_v + n));
+            });
+            return res;
+        }
+    }
+
     /**
      * The area  of a node n of the tree t is equal to the sum of the area of the leaves in the subtree rooted in n.
      *
@@ -51,6 +199,54 @@ namespace hg {
         return attribute_area(tree, xt::ones<index_t>({num_leaves(tree)}));
     }
 
+    /**
+     * Multithreaded version of attribute_area: the area of the nodes is computed from the suffix sums of the leaf
+     * areas along the Euler tour of the tree, obtained by pointer jumping in O(log(num_vertices(tree))) parallel
+     * rounds (the children of the nodes are computed with a parallel stable sort), instead of a sequential leaves to
+     * root pass. The total work is O(num_vertices(tree) * log(num_vertices(tree))).
+     *
+     * With integral leaf areas, the result is identical to the one of attribute_area. With floating point leaf
+     * areas, the area of a node is the difference of two suffix sums and may differ from the one of attribute_area
+     * by rounding errors.
+     *
+     * Trees with less than policy.serial_cutoff nodes are processed by attribute_area.
+     *
+     * @tparam tree_t tree type
+     * @tparam T xexpression derived type of xleaf_area
+     * @param policy execution::par
+     * @param tree input tree
+     * @param xleaf_area area of the leaves of the input tree
+     * @return an array with the area of each node of the tree
+     */
+    template<typename tree_t, typename T>
+    auto attribute_area(execution::parallel_policy policy, const tree_t &tree, const xt::xexpression<T> &xleaf_area) {
+        HG_TRACE();
+        using namespace tree_attribute_parallel_internal;
+        using value_type = typename T::value_type;
+        auto &leaf_area = xleaf_area.derived_cast();
+        hg_assert_leaf_weights(tree, leaf_area);
+        hg_assert_1d_array(leaf_area);
+        if ((index_t) num_vertices(tree) < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return array_1d<value_type>(attribute_area(tree, leaf_area));
+        }
+        auto ch = make_parallel_children(tree);
+        auto sums = euler_tour_suffix_sums<value_type>(tree, ch, [&leaf_area](index_t l) { return leaf_area(l); });
+        return subtree_sums_from_euler_tour(tree, ch, sums);
+    }
+
+    /**
+     * Multithreaded version of attribute_area(tree) (see attribute_area(execution::parallel_policy, tree, leaf_area)).
+     *
+     * @tparam tree_t tree type
+     * @param policy execution::par
+     * @param tree input tree
+     * @return an array with the area of each node of the tree
+     */
+    template<typename tree_t>
+    auto attribute_area(execution::parallel_policy policy, const tree_t &tree) {
+        return attribute_area(policy, tree, xt::ones<index_t>({num_leaves(tree)}));
+    }
+
     /**
      * The volume of a node n of the tree t is defined recursively as:
      *    volume(n) = abs(altitude(n) - altitude(parent(n)) * area(n) + sum_{c in children(n, t)} volume(c)
@@ -102,6 +298,127 @@ namespace hg {
         return depth;
     };
 
+    /**
+     * Multithreaded version of attribute_depth: the depth of all the nodes is computed by pointer jumping on the
+     * parent relation, in O(log(depth of the tree)) parallel rounds, instead of a sequential root to leaves pass.
+     * The total work is O(num_vertices(tree) * log(depth of the tree)).
+     *
+     * Trees with less than policy.serial_cutoff nodes are processed by attribute_depth.
+     *
+     * @tparam tree_t tree type
+     * @param policy execution::par
+     * @param tree input tree
+     * @return an array with the depth of each node of the tree
+     */
+    template<typename tree_t>
+    auto attribute_depth(execution::parallel_policy policy, const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        if (num_v < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return attribute_depth(tree);
+        }
+        const index_t root_node = root(tree);
+        auto &parents = tree.parents();
+        // the lists are the paths from the nodes to the root, followed by the sentinel num_v
+        array_1d<index_t> next = array_1d<index_t>::from_shape({(size_t) num_v + 1});
+        array_1d<index_t> depth = array_1d<index_t>::from_shape({(size_t) num_v + 1});
+        parfor(0, num_v, [&](index_t n) {
+            next(n) = (n == root_node) ? num_v : parents(n);
+            depth(n) = (n == root_node) ? 0 : 1;
+        });
+        next(num_v) = num_v;
+        depth(num_v) = 0;
+        tree_attribute_parallel_internal::pointer_jumping_suffix_sums(next, depth);
+        return array_1d<index_t>(xt::view(depth, xt::range(0, num_v)));
+    };
+
+    /**
+     * The topological height of a node n of the tree t is the number of edges of the longest path from n to a leaf of
+     * the subtree rooted in n: the topological height of a leaf is 0.
+     *
+     * @tparam tree_t tree type
+     * @param tree input tree
+     * @return an array with the topological height of each node of the tree
+     */
+    template<typename tree_t>
+    auto attribute_topological_height(const tree_t &tree) {
+        HG_TRACE();
+        array_1d<index_t> height = xt::zeros<index_t>({num_vertices(tree)});
+        for (auto i: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+            auto p = parent(i, tree);
+            height(p) = (std::max)(height(p), height(i) + 1);
+        }
+        return height;
+    };
+
+    /**
+     * Multithreaded version of attribute_topological_height.
+     *
+     * The leaves of the subtree rooted in a node are consecutive in the preorder of the leaves: the rank of the
+     * leaves in this order and the range of leaves of each node are obtained from the suffix sums of the Euler tour
+     * of the tree (see attribute_area(execution::parallel_policy, tree)). The topological height of a node is then
+     * the largest depth (see attribute_depth(execution::parallel_policy, tree)) of the leaves in its range, given by
+     * a segment tree built and queried in parallel, minus its own depth.
+     *
+     * Trees with less than policy.serial_cutoff nodes are processed by attribute_topological_height.
+     *
+     * @tparam tree_t tree type
+     * @param policy execution::par
+     * @param tree input tree
+     * @return an array with the topological height of each node of the tree
+     */
+    template<typename tree_t>
+    auto attribute_topological_height(execution::parallel_policy policy, const tree_t &tree) {
+        HG_TRACE();
+        using namespace tree_attribute_parallel_internal;
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        if (num_v < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return attribute_topological_height(tree);
+        }
+        const index_t root_node = root(tree);
+        auto depth = attribute_depth(policy, tree);
+        auto ch = make_parallel_children(tree);
+        // sums(c) is the number of leaves after the node c in the preorder of the leaves (c included)
+        auto sums = euler_tour_suffix_sums<index_t>(tree, ch, [](index_t) { return 1; });
+
+        // segment tree of the depths of the leaves in preorder, padded to a power of 2 with 0
+        index_t size = 1;
+        while (size < num_l) {
+            size *= 2;
+        }
+        array_1d<index_t> segments = xt::zeros<index_t>({(size_t) (2 * size)});
+        parfor(0, num_l, [&](index_t l) {
+            segments(size + num_l - sums(l)) = depth(l);
+        });
+        for (index_t level_size = size / 2; level_size >= 1; level_size /= 2) {
+            parfor(level_size, 2 * level_size, [&segments](index_t i) {
+                segments(i) = (std::max)(segments(2 * i), segments(2 * i + 1));
+            });
+        }
+
+        array_1d<index_t> height = array_1d<index_t>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&](index_t n) {
+            if (n < num_l) {
+                height(n) = 0;
+                return;
+            }
+            index_t lo = (n == root_node) ? 0 : num_l - sums(n);
+            index_t hi = (n == root_node) ? num_l : lo + sums(n) - sums(num_v + n);
+            index_t max_depth = 0;
+            for (lo += size, hi += size; lo < hi; lo /= 2, hi /= 2) {
+                if (lo & 1) {
+                    max_depth = (std::max)(max_depth, segments(lo++));
+                }
+                if (hi & 1) {
+                    max_depth = (std::max)(max_depth, segments(--hi));
+                }
+            }
+            height(n) = max_depth - depth(n);
+        });
+        return height;
+    };
+
     /**
      * In a tree :math:`t`, given that the altitudes of the nodes vary monotically from the leaves to the root,
      * the height of a node :math:`n` of :math:`t` is equal to the difference between the altitude of the parent
@@ -130,10 +447,11 @@ namespace hg {
         using value_type = typename T::value_type;
 
         tree.compute_children();
+        auto parent_altitudes = gather(altitudes, tree.parents());
         if (increasing_altitudes) {
             auto min_depth = xt::empty_like(altitudes);
             xt::noalias(xt::view(min_depth, xt::range(0, num_leaves(tree)))) =
-                    xt::view(xt::index_view(altitudes, tree.parents()), xt::range(0, num_leaves(tree)));
+                    xt::view(parent_altitudes, xt::range(0, num_leaves(tree)));
             for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
                 min_depth(n) = (std::numeric_limits<value_type>::max)();
                 bool flag = true;
@@ -149,11 +467,11 @@ namespace hg {
                     min_depth(n) = altitudes(n);
                 }
             }
-            return xt::eval(xt::index_view(altitudes, tree.parents()) - min_depth);
+            return xt::eval(parent_altitudes - min_depth);
         } else {
             auto max_depth = xt::empty_like(altitudes);
             xt::noalias(xt::view(max_depth, xt::range(0, num_leaves(tree)))) =
-                    xt::view(xt::index_view(altitudes, tree.parents()), xt::range(0, num_leaves(tree)));
+                    xt::view(parent_altitudes, xt::range(0, num_leaves(tree)));
             for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
                 max_depth(n) = std::numeric_limits<value_type>::lowest();
                 bool flag = true;
@@ -169,7 +487,7 @@ namespace hg {
                     max_depth(n) = altitudes(n);
                 }
             }
-            return xt::eval(max_depth - xt::index_view(altitudes, tree.parents()));
+            return xt::eval(max_depth - parent_altitudes);
         }
     };
 
@@ -212,6 +530,98 @@ namespace hg {
         return extrema;
     }
 
+    namespace tree_attribute_detail {
+
+        /**
+         * Extinction values computed with two linear passes on the parent array (children are never enumerated).
+         *
+         * The bottom-up pass computes, for each non leaf node n, the depth of its deepest extremum (the altitude of
+         * the deepest non leaf node of its subtree), the first non leaf child of n containing it (ref_son), and
+         * whether n is an extremum of the tree (see attribute_extrema). Children have smaller indices than their
+         * parent and are thus visited in the order of children_iterator: ties are resolved as in a children based
+         * traversal.
+         *
+         * The top-down pass propagates the extinction values along the paths to the deepest extrema, and the closest
+         * extremum ancestor of each node. The extinction value of the leaves only depends on their parent: the last
+         * pass is done in parallel.
+         *
+         * @param tree input tree
+         * @param altitudes node altitudes
+         * @param attribute_fun attribute_fun(n, depth) gives the attribute of the non leaf node n whose deepest
+         *        extremum has the given depth
+         * @param deeper comparison function: deeper(a, b) is true if altitude a is deeper than altitude b
+         * @param no_depth depth value such that deeper(a, no_depth) is true for any altitude a
+         */
+        template<typename attribute_type, typename tree_t, typename T, typename attribute_fun_t, typename compare_t>
+        auto extinction_value_impl(const tree_t &tree,
+                                   const T &altitudes,
+                                   const attribute_fun_t &attribute_fun,
+                                   const compare_t &deeper,
+                                   typename T::value_type no_depth) {
+            HG_TRACE();
+            using value_type = typename T::value_type;
+            const index_t num_v = num_vertices(tree);
+            const index_t num_l = num_leaves(tree);
+            const index_t root_node = root(tree);
+            auto &parents = tree.parents();
+
+            if (num_l == num_v) {  // single node tree: the root is a leaf and not an extremum
+                return array_1d<attribute_type>(xt::zeros<attribute_type>({(size_t) num_v}));
+            }
+
+            array_1d<value_type> depth = array_1d<value_type>::from_shape({(size_t) num_v});
+            array_1d<index_t> ref_son({(size_t) num_v}, invalid_index);
+            // bit 0: has a non leaf child, bit 1: has a child preventing it to be an extremum
+            std::vector<unsigned char> flags(num_v, 0);
+            // extremum(n) before removal of the non canonical nodes
+            std::vector<unsigned char> extremum(num_v, 0);
+            const unsigned char has_non_leaf_child = 1;
+            const unsigned char not_extremum = 2;
+
+            std::fill(depth.begin() + num_l, depth.end(), no_depth);
+            for (index_t n = num_l; n < num_v; n++) {
+                if (!(flags[n] & has_non_leaf_child)) {
+                    depth(n) = altitudes(n);
+                }
+                extremum[n] = !(flags[n] & not_extremum);
+                if (n == root_node) {
+                    continue;
+                }
+                index_t p = parents(n);
+                flags[p] |= has_non_leaf_child;
+                if (deeper(depth(n), depth(p))) {
+                    depth(p) = depth(n);
+                    ref_son(p) = n;
+                }
+                bool non_canonical = altitudes(n) == altitudes(p);
+                if (!(non_canonical && extremum[n])) {
+                    flags[p] |= not_extremum;
+                }
+                if (non_canonical) {
+                    extremum[n] = false;
+                }
+            }
+
+            array_1d<attribute_type> extinction = array_1d<attribute_type>::from_shape({(size_t) num_v});
+            // closest extremum ancestor (or self) of each non leaf node
+            array_1d<index_t> extremum_node = array_1d<index_t>::from_shape({(size_t) num_v});
+            extinction(root_node) = attribute_fun(root_node, depth(root_node));
+            extremum_node(root_node) = extremum[root_node] ? root_node : invalid_index;
+            for (index_t n = root_node - 1; n >= num_l; n--) {
+                index_t p = parents(n);
+                extinction(n) = (n == ref_son(p)) ? extinction(p) : attribute_fun(n, depth(n));
+                extremum_node(n) = extremum[n] ? n : extremum_node(p);
+            }
+
+            parfor(0, num_l, [&](index_t n) {
+                index_t e = extremum_node(parents(n));
+                extinction(n) = (e != invalid_index) ? extinction(e) : 0;
+            });
+
+            return extinction;
+        }
+    }
+
     /**
      * The extinction value of a node :math:`n` of the input tree :math:`t` with increasing altitudes :math:`alt`
      * for the increasing attribute :math:`att` is the equal to the threshold :math:`k` such that the node :math:`n`
@@ -259,76 +669,19 @@ namespace hg {
         hg_assert_node_weights(tree, attribute);
         hg_assert_1d_array(attribute);
 
-        tree.compute_children();
-
-        // identify path to the deepest extrema
-        array_1d<index_t> ref_son({num_vertices(tree)}, invalid_index);
+        using attribute_type = typename T2::value_type;
+        auto attribute_fun = [&attribute](index_t n, value_type) {
+            return attribute(n);
+        };
         if (increasing_altitudes) {
-            auto min_depth = xt::empty_like(altitudes);
-            for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
-                min_depth(n) = (std::numeric_limits<value_type>::max)();
-                bool flag = true;
-                for (auto c: children_iterator(n, tree)) {
-                    if (!is_leaf(c, tree)) {
-                        flag = false;
-                        if (min_depth(c) < min_depth(n)) {
-                            min_depth(n) = min_depth(c);
-                            ref_son(n) = c;
-                        }
-                    }
-                }
-                if (flag) {
-                    min_depth(n) = altitudes(n);
-                }
-            }
+            return tree_attribute_detail::extinction_value_impl<attribute_type>(
+                    tree, altitudes, attribute_fun, std::less<value_type>(),
+                    (std::numeric_limits<value_type>::max)());
         } else {
-            auto max_depth = xt::empty_like(altitudes);
-            for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
-                max_depth(n) = std::numeric_limits<value_type>::lowest();
-                bool flag = true;
-                for (auto c: children_iterator(n, tree)) {
-                    if (!is_leaf(c, tree)) {
-                        flag = false;
-                        if (max_depth(c) > max_depth(n)) {
-                            max_depth(n) = max_depth(c);
-                            ref_son(n) = c;
-                        }
-                    }
-                }
-                if (flag) {
-                    max_depth(n) = altitudes(n);
-                }
-            }
-        }
-
-        // extinction of non leaf nodes
-        array_1d<typename T2::value_type> extinction = array_1d<typename T2::value_type>::from_shape(
-                {num_vertices(tree)});
-        extinction(root(tree)) = attribute(root(tree));
-        for (auto n: root_to_leaves_iterator(tree, leaves_it::exclude, root_it::exclude)) {
-            auto pn = parent(n, tree);
-            if (n == ref_son(pn)) {
-                extinction(n) = extinction(pn);
-            } else {
-                extinction(n) = attribute(n);
-            }
-        }
-
-        auto extrema = attribute_extrema(tree, altitudes);
-        auto indices = xt::eval(xt::arange<index_t>(num_vertices(tree)));
-        if (!extrema(root(tree))) {
-            indices(root(tree)) = -1;
-        }
-        auto extrema_leaves = propagate_sequential(tree, indices, !extrema);
-        for (auto n: leaves_iterator(tree)) {
-            if (extrema_leaves(n) != -1) {
-                extinction(n) = extinction(extrema_leaves(n));
-            } else {
-                extinction(n) = 0;
-            }
+            return tree_attribute_detail::extinction_value_impl<attribute_type>(
+                    tree, altitudes, attribute_fun, std::greater<value_type>(),
+                    std::numeric_limits<value_type>::lowest());
         }
-
-        return extinction;
     };
 
     /**
@@ -361,9 +714,25 @@ namespace hg {
         hg_assert_node_weights(tree, altitudes);
         hg_assert_1d_array(altitudes);
 
-        auto height = attribute_height(tree, altitudes, increasing_altitudes);
-
-        return attribute_extinction_value(tree, altitudes, height, increasing_altitudes);
+        // the height of a node is computed from the depth of its deepest extremum during the extinction passes: it is
+        // the difference of two ordered altitudes which is exactly represented in the type of unsigned altitudes
+        using height_type = typename std::conditional<std::is_unsigned<value_type>::value,
+                value_type,
+                decltype(std::declval<value_type>() - std::declval<value_type>())>::type;
+        auto &parents = tree.parents();
+        if (increasing_altitudes) {
+            auto height_fun = [&altitudes, &parents](index_t n, value_type min_depth) {
+                return altitudes(parents(n)) - min_depth;
+            };
+            return tree_attribute_detail::extinction_value_impl<height_type>(
+                    tree, altitudes, height_fun, std::less<value_type>(), (std::numeric_limits<value_type>::max)());
+        } else {
+            auto height_fun = [&altitudes, &parents](index_t n, value_type max_depth) {
+                return max_depth - altitudes(parents(n));
+            };
+            return tree_attribute_detail::extinction_value_impl<height_type>(
+                    tree, altitudes, height_fun, std::greater<value_type>(), std::numeric_limits<value_type>::lowest());
+        }
     };
 
     /**
@@ -402,9 +771,143 @@ namespace hg {
         return attribute;
     }
 
+    /**
+     * Multithreaded version of attribute_sibling: the children of the nodes are computed with a parallel stable sort
+     * of the nodes by parent (see attribute_child_number(execution::parallel_policy, tree)) and the nodes are then
+     * processed in parallel.
+     *
+     * Trees with less than policy.serial_cutoff nodes are processed by attribute_sibling.
+     *
+     * @tparam tree_t
+     * @param policy execution::par
+     * @param tree Input tree
+     * @param skip Number of skipped element in the children list (including yourself)
+     * @return an array with the sibling index of each node of the tree
+     */
+    template<typename tree_t>
+    auto attribute_sibling(execution::parallel_policy policy, const tree_t &tree, index_t skip = 1) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        if (num_v < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return attribute_sibling(tree, skip);
+        }
+        const index_t root_node = root(tree);
+        auto &parents = tree.parents();
+        auto ch = tree_attribute_parallel_internal::make_parallel_children(tree);
+        array_1d<index_t> attribute = array_1d<index_t>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&](index_t n) {
+            if (n == root_node) {
+                attribute(n) = n;
+                return;
+            }
+            const index_t p = parents(n);
+            const index_t start = ch.child_start(p);
+            const index_t nchs = ch.child_end(p) - start;
+            index_t j = (ch.position(n) - start + skip) % nchs;
+            if (j < 0) {
+                j += nchs;
+            }
+            attribute(n) = ch.children(start + j);
+        });
+        return attribute;
+    }
+
+    namespace tree_attribute_internal {
+
+        /**
+         * Number of blocks used by edge_node_sums for a graph with the given number of edges (see
+         * parallel_reduction_num_blocks).
+         */
+        inline
+        index_t edge_node_sums_num_blocks(index_t num_edges) {
+            return parallel_reduction_num_blocks(num_edges, 65536);
+        }
+
+        /**
+         * Computes res(k, n) = sum of edge_value(i, k) for all the edges e of index i of the graph such that
+         * edge_node(e) = n, for k in [0, num_sums[.
+         *
+         * The nodes associated to the edges are not stored: the edges are split into blocks of consecutive edges
+         * processed in parallel, each block accumulates its values in a private buffer, and the buffers are then
+         * summed in block order.
+         *
+         * @tparam value_t
+         * @tparam graph_t
+         * @tparam F1
+         * @tparam F2
+         * @param graph input graph
+         * @param num_nodes number of nodes
+         * @param num_sums number of values associated to each edge
+         * @param edge_node function returning the node associated to an edge (or invalid_index to skip the edge)
+         * @param edge_value function returning the k-th value of the edge of index i
+         * @return a 2d array of shape (num_sums, num_nodes)
+         */
+        template<typename value_t, typename graph_t, typename F1, typename F2>
+        auto edge_node_sums(const graph_t &graph, index_t num_nodes, index_t num_sums,
+                            const F1 &edge_node, const F2 &edge_value) {
+            const index_t num_e = num_edges(graph);
+            index_t num_blocks = (std::max)((index_t) 1, (std::min)(edge_node_sums_num_blocks(num_e), num_e));
+            const index_t block_size = (num_e + num_blocks - 1) / num_blocks;
+            if (block_size > 0) {
+                num_blocks = (num_e + block_size - 1) / block_size;
+            }
+
+            std::vector<array_2d<value_t>> sums(num_blocks);
+            parfor(0, num_blocks, [&](index_t b) {
+                auto &block_sums = sums[b];
+                block_sums = xt::zeros<value_t>({(size_t) num_sums, (size_t) num_nodes});
+                const index_t end = (std::min)(num_e, (b + 1) * block_size);
+                for (index_t i = b * block_size; i < end; i++) {
+                    index_t n = edge_node(edge_from_index(i, graph));
+                    if (n != invalid_index) {
+                        for (index_t k = 0; k < num_sums; k++) {
+                            block_sums(k, n) += edge_value(i, k);
+                        }
+                    }
+                }
+            });
+
+            if (num_blocks > 1) {
+                const index_t node_block_size = (num_nodes + num_blocks - 1) / num_blocks;
+                parfor(0, num_blocks, [&](index_t c) {
+                    const index_t end = (std::min)(num_nodes, (c + 1) * node_block_size);
+                    for (index_t b = 1; b < num_blocks; b++) {
+                        for (index_t k = 0; k < num_sums; k++) {
+                            for (index_t n = c * node_block_size; n < end; n++) {
+                                sums[0](k, n) += sums[b](k, n);
+                            }
+                        }
+                    }
+                });
+            }
+            return std::move(sums[0]);
+        }
+
+        /**
+         * Computes res(k, n) = sum of edge_value(i, k) for all the edges e of index i of the graph whose extremities
+         * have the node n as lowest common ancestor (see edge_node_sums).
+         */
+        template<typename value_t, typename graph_t, typename lca_t, typename F>
+        auto edge_lca_sums(const graph_t &graph, const lca_t &lca, index_t num_nodes, index_t num_sums,
+                           const F &edge_value) {
+            return edge_node_sums<value_t>(
+                    graph, num_nodes, num_sums,
+                    [&graph, &lca](const typename graph_t::edge_descriptor &e) {
+                        return lca.lca(source(e, graph), target(e, graph));
+                    },
+                    edge_value);
+        }
+    }
+
     /**
      * Computes the contour length (perimeter) of each node of the input component tree.
      *
+     * An edge {x, y} of the base graph is inside the node max(parent(x), parent(y)) and all its ancestors: its
+     * contribution (twice its length) is subtracted from the sum of the perimeters of the leaves at this node. The
+     * contributions are computed in parallel on blocks of edges (see tree_attribute_internal::edge_node_sums)
+     * and accumulated in a single bottom-up pass. With a graph with implicit edges (e.g. grid_4_adjacency_graph_2d),
+     * the extremities of the edges are computed from their indices and the adjacency is never read from memory.
+     *
      * Warning: does not work for tree of shapes left in original space (the problem is that
      * two children of a node may become adjacent when the interpolated pixels are removed).
      *
@@ -424,6 +927,7 @@ namespace hg {
             const graph_t &base_graph,
             const xt::xexpression<T1> &xvertex_perimeter,
             const xt::xexpression<T2> &xedge_length) {
+        HG_TRACE();
         hg_assert_component_tree(tree);
         auto &vertex_perimeter = xvertex_perimeter.derived_cast();
         hg_assert_1d_array(vertex_perimeter);
@@ -432,28 +936,133 @@ namespace hg {
         hg_assert_1d_array(edge_length);
         hg_assert_edge_weights(base_graph, edge_length);
 
-        array_1d<double> res = array_1d<double>::from_shape({num_vertices(tree)});
-        xt::noalias(xt::view(res, xt::range(0, num_leaves(tree)))) = vertex_perimeter;
-        array_1d<bool> visited({num_leaves(tree)}, false);
-        tree.compute_children();
+        const index_t num_l = num_leaves(tree);
+        const auto &parents = tree.parents();
+        auto delta = tree_attribute_internal::edge_node_sums<double>(
+                base_graph, num_vertices(tree), 1,
+                [&base_graph, &parents](const typename graph_t::edge_descriptor &e) {
+                    index_t s = source(e, base_graph);
+                    index_t t = target(e, base_graph);
+                    return (s == t) ? invalid_index : (std::max)(parents(s), parents(t));
+                },
+                [&edge_length](index_t i, index_t) { return -2.0 * edge_length(i); });
 
-        for (auto i: leaves_to_root_iterator(tree, leaves_it::exclude)) {
-            res(i) = 0;
-            for (auto c: children_iterator(i, tree)) {
-                res(i) += res(c);
-                if (is_leaf(c, tree)) {
-                    for (auto e: out_edge_iterator(c, base_graph)) {
-                        if (visited(target(e, base_graph))) {
-                            res(i) -= 2.0 * edge_length(e);
-                        }
-                    }
-                    visited(c) = true;
-                }
-            }
+        array_1d<double> res = xt::view(delta, 0, xt::all());
+        xt::noalias(xt::view(res, xt::range(0, num_l))) = vertex_perimeter;
+        for (auto i: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+            res(parents(i)) += res(i);
         }
         return res;
     }
 
+    /**
+     * Length of the frontier represented by each node of the given partition tree.
+     *
+     * In a partition tree, each node represents the merging of 2 or more regions. The frontier of a node is the
+     * common contour between the merged regions: its length is the sum of the lengths of the edges of the leaf graph
+     * whose lowest common ancestor is the node.
+     *
+     * The lowest common ancestors of the edges and the sums are computed in a single parallel pass (see
+     * tree_attribute_internal::edge_lca_sums).
+     *
+     * @tparam tree_t
+     * @tparam graph_t
+     * @tparam T
+     * @tparam lca_t
+     * @param tree input tree
+     * @param leaf_graph graph on the leaves of the tree
+     * @param xedge_length length of the edges of the leaf graph
+     * @param lca lowest common ancestor solver of the tree (see lca_fast)
+     * @return an array with the same value type as edge_length
+     */
+    template<typename tree_t, typename graph_t, typename T, typename lca_t>
+    auto attribute_frontier_length(const tree_t &tree,
+                                   const graph_t &leaf_graph,
+                                   const xt::xexpression<T> &xedge_length,
+                                   const lca_t &lca) {
+        HG_TRACE();
+        auto &edge_length = xedge_length.derived_cast();
+        hg_assert_1d_array(edge_length);
+        hg_assert_edge_weights(leaf_graph, edge_length);
+        hg_assert(num_vertices(leaf_graph) == num_leaves(tree),
+                  "The number of vertices of the leaf graph must be equal to the number of leaves of the tree.");
+        using value_t = typename T::value_type;
+
+        auto sums = tree_attribute_internal::edge_lca_sums<value_t>(
+                leaf_graph, lca, num_vertices(tree), 1,
+                [&edge_length](index_t i, index_t) { return edge_length(i); });
+        array_1d<value_t> res = xt::view(sums, 0, xt::all());
+        return res;
+    }
+
+    template<typename tree_t, typename graph_t, typename T>
+    auto attribute_frontier_length(const tree_t &tree,
+                                   const graph_t &leaf_graph,
+                                   const xt::xexpression<T> &xedge_length) {
+        return attribute_frontier_length(tree, leaf_graph, xedge_length, lca_fast(tree));
+    }
+
+    /**
+     * Mean edge weight along the frontier represented by each node of the given partition tree.
+     *
+     * The strength of the frontier of a non leaf node is the sum of the weights of the edges of the leaf graph whose
+     * lowest common ancestor is the node divided by the sum of their lengths (see attribute_frontier_length). The
+     * value of a leaf is the sum of the weights of the edges whose extremities are both equal to the leaf (0 if
+     * the leaf graph has no self loop).
+     *
+     * Both sums are computed in a single parallel pass (see tree_attribute_internal::edge_lca_sums).
+     *
+     * @tparam tree_t
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @tparam lca_t
+     * @param tree input tree
+     * @param leaf_graph graph on the leaves of the tree
+     * @param xedge_weights weights of the edges of the leaf graph
+     * @param xedge_length length of the edges of the leaf graph
+     * @param lca lowest common ancestor solver of the tree (see lca_fast)
+     * @return an array with the same value type as edge_weights
+     */
+    template<typename tree_t, typename graph_t, typename T1, typename T2, typename lca_t>
+    auto attribute_frontier_strength(const tree_t &tree,
+                                     const graph_t &leaf_graph,
+                                     const xt::xexpression<T1> &xedge_weights,
+                                     const xt::xexpression<T2> &xedge_length,
+                                     const lca_t &lca) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &edge_length = xedge_length.derived_cast();
+        hg_assert_1d_array(edge_weights);
+        hg_assert_edge_weights(leaf_graph, edge_weights);
+        hg_assert_1d_array(edge_length);
+        hg_assert_edge_weights(leaf_graph, edge_length);
+        hg_assert(num_vertices(leaf_graph) == num_leaves(tree),
+                  "The number of vertices of the leaf graph must be equal to the number of leaves of the tree.");
+        using value_t = typename T1::value_type;
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+
+        auto sums = tree_attribute_internal::edge_lca_sums<double>(
+                leaf_graph, lca, num_v, 2,
+                [&edge_weights, &edge_length](index_t i, index_t k) {
+                    return (k == 0) ? (double) edge_weights(i) : (double) edge_length(i);
+                });
+        array_1d<value_t> res = array_1d<value_t>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&res, &sums, num_l](index_t n) {
+            res(n) = static_cast<value_t>((n < num_l) ? sums(0, n) : sums(0, n) / sums(1, n));
+        });
+        return res;
+    }
+
+    template<typename tree_t, typename graph_t, typename T1, typename T2>
+    auto attribute_frontier_strength(const tree_t &tree,
+                                     const graph_t &leaf_graph,
+                                     const xt::xexpression<T1> &xedge_weights,
+                                     const xt::xexpression<T2> &xedge_length) {
+        return attribute_frontier_strength(tree, leaf_graph, xedge_weights, xedge_length, lca_fast(tree));
+    }
+
 
     /**
      * Given a node :math:`n` whose parent is :math:`p`, the attribute value of :math:`n` is the rank of :math:`n`
@@ -480,6 +1089,35 @@ namespace hg {
         return res;
     }
 
+    /**
+     * Multithreaded version of attribute_child_number: the non root nodes are stably sorted by parent with a parallel
+     * sort, the rank of a node among the children of its parent is then its position in the sorted sequence minus
+     * the position of the first child of its parent.
+     *
+     * Trees with less than policy.serial_cutoff nodes are processed by attribute_child_number.
+     *
+     * @tparam tree_t
+     * @param policy execution::par
+     * @param tree input tree
+     * @return an array with the rank of each node among the children of its parent
+     */
+    template<typename tree_t>
+    auto attribute_child_number(execution::parallel_policy policy, const tree_t &tree) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(tree);
+        if (num_v < (std::max)(policy.serial_cutoff, (index_t) 2)) {
+            return attribute_child_number(tree);
+        }
+        const index_t root_node = root(tree);
+        auto &parents = tree.parents();
+        auto ch = tree_attribute_parallel_internal::make_parallel_children(tree);
+        array_1d<index_t> res = array_1d<index_t>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&](index_t n) {
+            res(n) = (n == root_node) ? invalid_index : ch.position(n) - ch.child_start(parents(n));
+        });
+        return res;
+    }
+
 
     /**
      * Given two trees :math:`t_1` and :math:`t_2` defined over the same domain, ie sharing the same set of leaves.
@@ -564,4 +1202,701 @@ namespace hg {
         return res;
     }
 
+    /**
+     * Estimates a gaussian model (mean, (co-)variance) of the leaf weights inside each node of the tree.
+     *
+     * The result is a pair of arrays:
+     *
+     *  - the mean of the leaf weights inside each node: shape (num_vertices(tree)) if vertex weights are scalar and
+     *    (num_vertices(tree), d) if vertex weights are vectors of size d;
+     *  - the (biased) variance of the leaf weights inside each node: shape (num_vertices(tree)) if vertex weights
+     *    are scalar and (num_vertices(tree), d, d) (covariance matrices) otherwise.
+     *
+     * The sufficient statistics (sum of the weights and sum of their outer products) are accumulated in a single
+     * bottom-up pass directly in the result arrays, with vectorized row reductions: no per leaf temporary of shape
+     * (num_leaves(tree), d, d) is created.
+     *
+     * @tparam tree_t
+     * @tparam T1
+     * @tparam T2
+     * @param tree input tree
+     * @param xvertex_weights leaf weights (1d or 2d array, integral weights give double precision results)
+     * @param xnode_area area of each node of the tree
+     * @return a pair of arrays (mean, variance)
+     */
+    template<typename tree_t, typename T1, typename T2>
+    auto attribute_gaussian_region_weights_model(const tree_t &tree,
+                                                 const xt::xexpression<T1> &xvertex_weights,
+                                                 const xt::xexpression<T2> &xnode_area) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        auto &node_area = xnode_area.derived_cast();
+        using input_value_type = typename T1::value_type;
+        // integral weights are read directly and accumulated in double precision
+        using value_type = std::conditional_t<std::is_floating_point<input_value_type>::value,
+                input_value_type, double>;
+        hg_assert_leaf_weights(tree, vertex_weights);
+        hg_assert(vertex_weights.dimension() <= 2, "Vertex weights can either be scalar or 1 dimensional.");
+        hg_assert_node_weights(tree, node_area);
+        hg_assert_1d_array(node_area);
+
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        const bool scalar = vertex_weights.dimension() == 1;
+        const index_t d = scalar ? 1 : vertex_weights.shape()[1];
+        const index_t d2 = d * d;
+
+        array_nd<value_type> mean;
+        array_nd<value_type> variance;
+        if (scalar) {
+            mean = array_nd<value_type>::from_shape({(size_t) num_v});
+            variance = array_nd<value_type>::from_shape({(size_t) num_v});
+        } else {
+            mean = array_nd<value_type>::from_shape({(size_t) num_v, (size_t) d});
+            variance = array_nd<value_type>::from_shape({(size_t) num_v, (size_t) d, (size_t) d});
+        }
+        value_type *sums = mean.data();
+        value_type *sums2 = variance.data();
+
+        array_nd<input_value_type> buffer;
+        const input_value_type *weights = row_major_data(vertex_weights, buffer);
+        parfor(0, num_l, [sums, sums2, weights, d, d2](index_t i) {
+            const input_value_type *x = weights + i * d;
+            value_type *m = sums + i * d;
+            value_type *m2 = sums2 + i * d2;
+            for (index_t k = 0; k < d; k++) {
+                m[k] = static_cast<value_type>(x[k]);
+                for (index_t l = 0; l < d; l++) {
+                    m2[k * d + l] = static_cast<value_type>(x[k]) * static_cast<value_type>(x[l]);
+                }
+            }
+        });
+        std::fill(sums + num_l * d, sums + num_v * d, 0);
+        std::fill(sums2 + num_l * d2, sums2 + num_v * d2, 0);
+
+        const auto &parents = tree.parents();
+        for (auto i: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+            const index_t p = parents(i);
+            accumulator_detail::reduce_range<accumulator_sum>(sums + p * d, sums + (p + 1) * d,
+                                                              (const value_type *) sums + i * d);
+            accumulator_detail::reduce_range<accumulator_sum>(sums2 + p * d2, sums2 + (p + 1) * d2,
+                                                              (const value_type *) sums2 + i * d2);
+        }
+
+        parfor(0, num_v, [sums, sums2, &node_area, d, d2](index_t i) {
+            const value_type area = static_cast<value_type>(node_area(i));
+            value_type *m = sums + i * d;
+            value_type *m2 = sums2 + i * d2;
+            for (index_t k = 0; k < d; k++) {
+                m[k] /= area;
+            }
+            for (index_t k = 0; k < d; k++) {
+                for (index_t l = 0; l < d; l++) {
+                    m2[k * d + l] = m2[k * d + l] / area - m[k] * m[l];
+                }
+            }
+        });
+
+        return std::make_pair(std::move(mean), std::move(variance));
+    }
+
+    template<typename tree_t, typename T>
+    auto attribute_gaussian_region_weights_model(const tree_t &tree, const xt::xexpression<T> &xvertex_weights) {
+        return attribute_gaussian_region_weights_model(tree, xvertex_weights, attribute_area(tree));
+    }
+
+    namespace tree_attribute_detail {
+
+        /**
+         * res[i, ...] = attribute[node_map[i], ...] for i in [0, size)
+         */
+        template<typename value_type, typename T, typename node_map_t>
+        auto gather_nodes(const T &attribute, const node_map_t &node_map, index_t size) {
+            hg_assert(attribute.dimension() > 0, "Attribute must be at least 1 dimensional.");
+            std::vector<size_t> shape(attribute.shape().begin(), attribute.shape().end());
+            shape[0] = size;
+            array_nd<value_type> res = array_nd<value_type>::from_shape(shape);
+
+            const size_t num_d = attribute.size() / (std::max)((size_t) attribute.shape()[0], (size_t) 1);
+            auto vattribute = xt::reshape_view(attribute, {(size_t) attribute.shape()[0], num_d});
+            auto vres = xt::reshape_view(res, {(size_t) size, num_d});
+            for (index_t i = 0; i < size; i++) {
+                for (index_t k = 0; k < (index_t) num_d; k++) {
+                    vres(i, k) = vattribute(node_map(i), k);
+                }
+            }
+            return res;
+        }
+    }
+
+    /**
+     * Remaps a node attribute computed on a tree t to the tree obtained by removing nodes of t with simplify_tree
+     * (or any other operation returning a remapped_tree whose node_map maps the nodes of the new tree to nodes of t):
+     *
+     *      res(n) = attribute(node_map(n))
+     *
+     * If the leaves of t are preserved (simplify_tree with process_leaves = false), the set of leaves below a node
+     * that is not removed is unchanged: this remapping is thus exact for any attribute that only depends on the set of
+     * leaves below a node (area, contour length, mean vertex weights, compactness, results of accumulate_sequential...)
+     * and avoids recomputing it from the leaves.
+     *
+     * @tparam tree_t
+     * @tparam node_map_t
+     * @tparam T
+     * @param rtree a remapped tree
+     * @param xattribute node attribute of the original tree (an array of shape (num_vertices(t), ...))
+     * @return an array of shape (num_vertices(rtree.tree), ...)
+     */
+    template<typename tree_t, typename node_map_t, typename T, typename value_type=typename T::value_type>
+    auto remap_tree_attribute(const remapped_tree<tree_t, node_map_t> &rtree, const xt::xexpression<T> &xattribute) {
+        HG_TRACE();
+        hg_assert_node_weights(rtree.tree, rtree.node_map);
+        return tree_attribute_detail::gather_nodes<value_type>(xattribute.derived_cast(), rtree.node_map,
+                                                               rtree.node_map.size());
+    }
+
+    /**
+     * Remaps a node attribute computed on a tree t to the tree obtained by removing nodes of t with simplify_tree when
+     * the attribute of a node is the accumulation of the attributes of its children with a marginal accumulator
+     * (sum, min, max, prod) such as the area, or the sum, the min, or the max of leaf values.
+     *
+     * The leaves of the new tree keep the attribute of their corresponding node in t, and the attribute of the other
+     * nodes is accumulated from their children in the new tree. If leaves were removed (simplify_tree with
+     * process_leaves = true), the contribution of the removed branches is thus discarded and the nodes of t that
+     * became leaves keep the value of the region they represent. Otherwise, the result is equal to the one of
+     * remap_tree_attribute(rtree, attribute).
+     *
+     * @tparam tree_t
+     * @tparam node_map_t
+     * @tparam T
+     * @tparam accumulator_t
+     * @param rtree a remapped tree
+     * @param xattribute node attribute of the original tree
+     * @param accumulator sum, min, max or prod accumulator used to compute the attribute
+     * @return an array of shape (num_vertices(rtree.tree), ...)
+     */
+    template<typename tree_t, typename node_map_t, typename T, typename accumulator_t,
+            typename value_type=typename T::value_type>
+    auto remap_tree_attribute(const remapped_tree<tree_t, node_map_t> &rtree,
+                              const xt::xexpression<T> &xattribute,
+                              const accumulator_t &accumulator) {
+        HG_TRACE();
+        static_assert(accumulator_detail::has_reduce<accumulator_t, value_type>::value,
+                      "Only attributes computed with a marginal accumulator (sum, min, max, prod) can be remapped.");
+        auto &attribute = xattribute.derived_cast();
+        auto &tree = rtree.tree;
+        auto &node_map = rtree.node_map;
+        hg_assert_node_weights(tree, node_map);
+
+        auto leaf_values = tree_attribute_detail::gather_nodes<value_type>(attribute, node_map, num_leaves(tree));
+        return accumulate_sequential(tree, leaf_values, accumulator);
+    }
+
+    /**
+     * Updates the volume attribute of a tree t (see attribute_volume) for the tree obtained by removing non leaf nodes
+     * of t with simplify_tree (process_leaves = false).
+     *
+     * The volume of a node n is the sum, over the non leaf nodes x of the subtree rooted in n, of the terms
+     * abs(altitude(x) - altitude(parent(x))) * area(x). The volume of the corresponding node in t is thus corrected by
+     * the terms of the removed nodes and by the terms of the nodes whose parent has changed: the update only visits
+     * the removed nodes and their children, and does not require any leaf data.
+     *
+     * @tparam tree_t
+     * @tparam node_map_t
+     * @tparam T1
+     * @tparam T2
+     * @tparam T3
+     * @param rtree result of simplify_tree(original_tree, criterion, false)
+     * @param original_tree tree before the simplification
+     * @param xnode_altitude altitude of the nodes of the original tree
+     * @param xnode_area area of the nodes of the original tree
+     * @param xnode_volume volume of the nodes of the original tree
+     * @return an array with the volume of each node of the new tree
+     */
+    template<typename tree_t, typename node_map_t, typename T1, typename T2, typename T3>
+    auto update_attribute_volume(const remapped_tree<tree_t, node_map_t> &rtree,
+                                 const tree_t &original_tree,
+                                 const xt::xexpression<T1> &xnode_altitude,
+                                 const xt::xexpression<T2> &xnode_area,
+                                 const xt::xexpression<T3> &xnode_volume) {
+        HG_TRACE();
+        auto &node_altitude = xnode_altitude.derived_cast();
+        auto &node_area = xnode_area.derived_cast();
+        auto &node_volume = xnode_volume.derived_cast();
+        hg_assert_node_weights(original_tree, node_altitude);
+        hg_assert_1d_array(node_altitude);
+        hg_assert_node_weights(original_tree, node_area);
+        hg_assert_1d_array(node_area);
+        hg_assert_node_weights(original_tree, node_volume);
+        hg_assert_1d_array(node_volume);
+        auto &tree = rtree.tree;
+        auto &node_map = rtree.node_map;
+        hg_assert(num_leaves(tree) == num_leaves(original_tree),
+                  "The volume can only be updated if the leaves of the original tree are preserved.");
+
+        auto term = [&node_altitude, &node_area](index_t x, index_t parent_x) {
+            return std::fabs(node_altitude(x) - node_altitude(parent_x)) * node_area(x);
+        };
+
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        auto &original_parents = original_tree.parents();
+        auto &parents = tree.parents();
+
+        // correction[n]: sum of the terms of the volume in t that disappear or change in the subtree rooted in n
+        array_1d<double> correction = xt::zeros<double>({(size_t) num_v});
+        std::vector<bool> removed_visited(num_vertices(original_tree), false);
+        for (index_t n = 0; n < num_v - 1; n++) {
+            index_t x = node_map(n);
+            index_t new_parent = parents(n);
+            index_t target = node_map(new_parent);
+            index_t p = original_parents(x);
+            if (p == target) {
+                continue;
+            }
+            if (n >= num_l) {
+                correction(n) += term(x, p) - term(x, target);
+            }
+            // removed nodes between x and its nearest preserved ancestor
+            while (p != target && !removed_visited[p]) {
+                removed_visited[p] = true;
+                correction(new_parent) += term(p, original_parents(p));
+                p = original_parents(p);
+            }
+        }
+
+        array_1d<double> volume = xt::empty<double>({(size_t) num_v});
+        for (index_t n = 0; n < num_v - 1; n++) {
+            correction(parents(n)) += correction(n);
+            volume(n) = node_volume(node_map(n)) - correction(n);
+        }
+        volume(num_v - 1) = node_volume(node_map(num_v - 1)) - correction(num_v - 1);
+        xt::view(volume, xt::range(0, num_l)) = 0;
+        return volume;
+    }
+
+    namespace tree_attribute_detail {
+
+        /**
+         * Base class of the attributes computed by fused_tree_attributes.
+         *
+         * The engine calls, in this order:
+         *   - initialize(area) once: the values of the leaves must be set;
+         *   - leaves_to_root(n, area) for each non-leaf node n in leaves to root order: the values of the children of n
+         *     and the area of n are already computed;
+         *   - root_to_leaves(n) for each non root node n in root to leaves order, if uses_root_to_leaves() is true:
+         *     the value of the parent of n is already computed;
+         *   - finalize(area) once.
+         */
+        template<typename tree_t, typename area_t>
+        struct fused_attribute {
+
+            fused_attribute(const tree_t &tree) : m_tree(tree) {}
+
+            virtual ~fused_attribute() {}
+
+            virtual void initialize(const array_1d<area_t> &area) = 0;
+
+            virtual void leaves_to_root(index_t, const array_1d<area_t> &) {}
+
+            virtual bool uses_root_to_leaves() const {
+                return false;
+            }
+
+            virtual void root_to_leaves(index_t) {}
+
+            virtual void finalize(const array_1d<area_t> &) {}
+
+        protected:
+            const tree_t &m_tree;
+        };
+
+        template<typename tree_t, typename area_t, typename T>
+        struct fused_attribute_volume : public fused_attribute<tree_t, area_t> {
+
+            fused_attribute_volume(const tree_t &tree, const T &altitudes) :
+                    fused_attribute<tree_t, area_t>(tree),
+                    m_altitudes(altitudes),
+                    m_volume(array_1d<double>::from_shape({num_vertices(tree)})) {}
+
+            void initialize(const array_1d<area_t> &) override {
+                xt::view(m_volume, xt::range(0, num_leaves(this->m_tree))) = 0;
+            }
+
+            void leaves_to_root(index_t n, const array_1d<area_t> &area) override {
+                double volume = std::fabs(m_altitudes(n) - m_altitudes(parent(n, this->m_tree))) * area(n);
+                for (auto c: children_iterator(n, this->m_tree)) {
+                    volume += m_volume(c);
+                }
+                m_volume(n) = volume;
+            }
+
+            const T &m_altitudes;
+            array_1d<double> m_volume;
+        };
+
+        template<typename tree_t, typename area_t>
+        struct fused_attribute_depth : public fused_attribute<tree_t, area_t> {
+
+            fused_attribute_depth(const tree_t &tree) :
+                    fused_attribute<tree_t, area_t>(tree),
+                    m_depth(array_1d<index_t>::from_shape({num_vertices(tree)})) {}
+
+            void initialize(const array_1d<area_t> &) override {
+                m_depth(this->m_tree.root()) = 0;
+            }
+
+            bool uses_root_to_leaves() const override {
+                return true;
+            }
+
+            void root_to_leaves(index_t n) override {
+                m_depth(n) = m_depth(parent(n, this->m_tree)) + 1;
+            }
+
+            array_1d<index_t> m_depth;
+        };
+
+        template<typename tree_t, typename area_t, typename T>
+        struct fused_attribute_extrema : public fused_attribute<tree_t, area_t> {
+
+            fused_attribute_extrema(const tree_t &tree, const T &altitudes) :
+                    fused_attribute<tree_t, area_t>(tree),
+                    m_altitudes(altitudes),
+                    m_extrema(array_1d<bool>::from_shape({num_vertices(tree)})) {}
+
+            void initialize(const array_1d<area_t> &) override {
+                xt::view(m_extrema, xt::range(0, num_leaves(this->m_tree))) = false;
+            }
+
+            void leaves_to_root(index_t n, const array_1d<area_t> &) override {
+                bool flag = true;
+                for (auto c: children_iterator(n, this->m_tree)) {
+                    bool c_non_canonical = m_altitudes(c) == m_altitudes(n);
+                    if (!(is_leaf(c, this->m_tree) || (c_non_canonical && m_extrema(c)))) {
+                        flag = false;
+                    }
+                    m_extrema(c) = m_extrema(c) && !c_non_canonical;
+                }
+                m_extrema(n) = flag;
+            }
+
+            const T &m_altitudes;
+            array_1d<bool> m_extrema;
+        };
+
+        template<typename tree_t, typename area_t, typename T>
+        struct fused_attribute_mean_vertex_weights : public fused_attribute<tree_t, area_t> {
+
+            fused_attribute_mean_vertex_weights(const tree_t &tree, const T &vertex_weights) :
+                    fused_attribute<tree_t, area_t>(tree),
+                    m_vertex_weights(vertex_weights) {
+                std::vector<size_t> shape(vertex_weights.shape().begin(), vertex_weights.shape().end());
+                shape[0] = num_vertices(tree);
+                m_mean = array_nd<double>::from_shape(shape);
+                m_row_size = vertex_weights.size() / num_leaves(tree);
+            }
+
+            void initialize(const array_1d<area_t> &) override {
+                xt::noalias(xt::view(m_mean, xt::range(0, num_leaves(this->m_tree)))) = m_vertex_weights;
+            }
+
+            // sum of the vertex weights, the division by the area is done in finalize
+            void leaves_to_root(index_t n, const array_1d<area_t> &) override {
+                double *row = m_mean.data() + n * m_row_size;
+                std::fill(row, row + m_row_size, 0.0);
+                for (auto c: children_iterator(n, this->m_tree)) {
+                    const double *child_row = m_mean.data() + c * m_row_size;
+                    for (size_t k = 0; k < m_row_size; k++) {
+                        row[k] += child_row[k];
+                    }
+                }
+            }
+
+            void finalize(const array_1d<area_t> &area) override {
+                double *data = m_mean.data();
+                for (index_t i = 0; i < (index_t) num_vertices(this->m_tree); i++) {
+                    double a = (double) area(i);
+                    for (size_t k = 0; k < m_row_size; k++) {
+                        *(data++) /= a;
+                    }
+                }
+            }
+
+            const T &m_vertex_weights;
+            array_nd<double> m_mean;
+            size_t m_row_size;
+        };
+
+        template<bool vectorial, typename tree_t, typename area_t, typename T, typename accumulator_t, typename output_t>
+        struct fused_attribute_accumulator : public fused_attribute<tree_t, area_t> {
+
+            using output_view_t = decltype(make_light_axis_view<vectorial>(std::declval<array_nd<output_t> &>()));
+            using vertex_view_t = decltype(make_light_axis_view<vectorial>(std::declval<const T &>()));
+            using acc_t = decltype(std::declval<const accumulator_t &>().template make_accumulator<vectorial>(
+                    std::declval<output_view_t &>()));
+
+            fused_attribute_accumulator(const tree_t &tree, const T &vertex_data, const accumulator_t &accumulator) :
+                    fused_attribute<tree_t, area_t>(tree),
+                    m_output(array_nd<output_t>::from_shape(output_shape(tree, vertex_data, accumulator))),
+                    m_vertex_data_view(make_light_axis_view<vectorial>(vertex_data)),
+                    m_output_view(make_light_axis_view<vectorial>(m_output)),
+                    m_input_view(make_light_axis_view<vectorial>(m_output)),
+                    m_acc(accumulator.template make_accumulator<vectorial>(m_output_view)) {}
+
+            void initialize(const array_1d<area_t> &) override {
+                for (auto i: leaves_iterator(this->m_tree)) {
+                    m_output_view.set_position(i);
+                    m_vertex_data_view.set_position(i);
+                    m_output_view = m_vertex_data_view;
+                }
+            }
+
+            void leaves_to_root(index_t n, const array_1d<area_t> &) override {
+                m_output_view.set_position(n);
+                m_acc.set_storage(m_output_view);
+                m_acc.initialize();
+                for (auto c : children_iterator(n, this->m_tree)) {
+                    m_input_view.set_position(c);
+                    m_acc.accumulate(m_input_view.begin());
+                }
+                m_acc.finalize();
+            }
+
+            static std::vector<size_t> output_shape(const tree_t &tree, const T &vertex_data,
+                                                    const accumulator_t &accumulator) {
+                auto data_shape = std::vector<size_t>(vertex_data.shape().begin() + 1, vertex_data.shape().end());
+                auto shape = accumulator.get_output_shape(data_shape);
+                shape.insert(shape.begin(), num_vertices(tree));
+                return shape;
+            }
+
+            array_nd<output_t> m_output;
+            vertex_view_t m_vertex_data_view;
+            output_view_t m_output_view;
+            output_view_t m_input_view;
+            acc_t m_acc;
+        };
+    }
+
+    /**
+     * Computes several attributes of a tree in a single leaves to root traversal (plus one root to leaves traversal
+     * if a registered attribute requires it, eg. the depth).
+     *
+     * Attributes are registered with the add_xxx functions which return a reference to the array that will contain
+     * the attribute values: the arrays are owned by the engine and are filled by the function compute.
+     * The input arrays given to the add_xxx functions are not copied: they must remain valid until compute is called.
+     *
+     * The area of the nodes is computed when it is requested (function area) or when a registered attribute
+     * depends on it (volume, mean vertex weights).
+     *
+     * Example:
+     *
+     *     auto attributes = make_fused_tree_attributes(tree);
+     *     auto &area = attributes.area();
+     *     auto &volume = attributes.add_volume(altitudes);
+     *     auto &depth = attributes.add_depth();
+     *     auto &max_weights = attributes.add_accumulator(vertex_weights, accumulator_max());
+     *     attributes.compute();
+     *
+     * @tparam tree_t tree type
+     * @tparam area_t value type of the area of the nodes
+     */
+    template<typename tree_t, typename area_t = index_t>
+    class fused_tree_attributes {
+    public:
+
+        /**
+         * Engine where the area of any leaf is equal to 1.
+         *
+         * @param tree input tree
+         */
+        fused_tree_attributes(const tree_t &tree) :
+                m_tree(tree),
+                m_area(array_1d<area_t>::from_shape({num_vertices(tree)})) {
+            xt::view(m_area, xt::range(0, num_leaves(tree))) = 1;
+        }
+
+        /**
+         * Engine with the given leaf area.
+         *
+         * @param tree input tree
+         * @param xleaf_area area of the leaves of the input tree
+         */
+        template<typename T>
+        fused_tree_attributes(const tree_t &tree, const xt::xexpression<T> &xleaf_area) :
+                m_tree(tree),
+                m_area(array_1d<area_t>::from_shape({num_vertices(tree)})) {
+            auto &leaf_area = xleaf_area.derived_cast();
+            hg_assert_leaf_weights(tree, leaf_area);
+            hg_assert_1d_array(leaf_area);
+            xt::noalias(xt::view(m_area, xt::range(0, num_leaves(tree)))) = leaf_area;
+        }
+
+        /**
+         * Requests the area of the nodes (see attribute_area).
+         *
+         * @return the array that will contain the area of each node after compute
+         */
+        array_1d<area_t> &area() {
+            m_compute_area = true;
+            return m_area;
+        }
+
+        /**
+         * Registers the volume of the nodes (see attribute_volume).
+         *
+         * @param xaltitudes altitude of the nodes of the input tree
+         * @return the array that will contain the volume of each node after compute
+         */
+        template<typename T>
+        array_1d<double> &add_volume(const xt::xexpression<T> &xaltitudes) {
+            auto &altitudes = xaltitudes.derived_cast();
+            hg_assert_node_weights(m_tree, altitudes);
+            hg_assert_1d_array(altitudes);
+            m_compute_area = true;
+            return add<tree_attribute_detail::fused_attribute_volume<tree_t, area_t, T>>(altitudes)->m_volume;
+        }
+
+        /**
+         * Registers the depth of the nodes (see attribute_depth).
+         *
+         * @return the array that will contain the depth of each node after compute
+         */
+        array_1d<index_t> &add_depth() {
+            return add<tree_attribute_detail::fused_attribute_depth<tree_t, area_t>>()->m_depth;
+        }
+
+        /**
+         * Registers the extrema of the nodes (see attribute_extrema).
+         *
+         * @param xaltitudes altitude of the nodes of the input tree
+         * @return the array that will contain the extrema indicator of each node after compute
+         */
+        template<typename T>
+        array_1d<bool> &add_extrema(const xt::xexpression<T> &xaltitudes) {
+            auto &altitudes = xaltitudes.derived_cast();
+            hg_assert_node_weights(m_tree, altitudes);
+            hg_assert_1d_array(altitudes);
+            return add<tree_attribute_detail::fused_attribute_extrema<tree_t, area_t, T>>(altitudes)->m_extrema;
+        }
+
+        /**
+         * Registers the mean of the leaf weights inside each node: the sum of the weights of the leaves in the subtree
+         * rooted in the node divided by the area of the node.
+         *
+         * @param xvertex_weights weights of the leaves of the input tree (scalar or vectorial)
+         * @return the array that will contain the mean vertex weights of each node after compute
+         */
+        template<typename T>
+        array_nd<double> &add_mean_vertex_weights(const xt::xexpression<T> &xvertex_weights) {
+            auto &vertex_weights = xvertex_weights.derived_cast();
+            hg_assert_leaf_weights(m_tree, vertex_weights);
+            m_compute_area = true;
+            return add<tree_attribute_detail::fused_attribute_mean_vertex_weights<tree_t, area_t, T>>(
+                    vertex_weights)->m_mean;
+        }
+
+        /**
+         * Registers the accumulation of the given leaf data with the given accumulator (see accumulate_sequential).
+         *
+         * @param xvertex_data data of the leaves of the input tree (scalar or vectorial)
+         * @param accumulator
+         * @return the array that will contain the accumulated values of each node after compute
+         */
+        template<typename T, typename accumulator_t, typename output_t = typename T::value_type>
+        array_nd<output_t> &add_accumulator(const xt::xexpression<T> &xvertex_data,
+                                            const accumulator_t &accumulator) {
+            auto &vertex_data = xvertex_data.derived_cast();
+            hg_assert_leaf_weights(m_tree, vertex_data);
+            if (accumulator_detail::use_scalar_views(accumulator, vertex_data.dimension())) {
+                return add<tree_attribute_detail::fused_attribute_accumulator<
+                        false, tree_t, area_t, T, accumulator_t, output_t>>(vertex_data, accumulator)->m_output;
+            } else {
+                return add<tree_attribute_detail::fused_attribute_accumulator<
+                        true, tree_t, area_t, T, accumulator_t, output_t>>(vertex_data, accumulator)->m_output;
+            }
+        }
+
+        /**
+         * Computes all the registered attributes.
+         */
+        void compute() {
+            HG_TRACE();
+            m_tree.compute_children();
+
+            std::vector<tree_attribute_detail::fused_attribute<tree_t, area_t> *> root_to_leaves_attributes;
+            for (auto &a: m_attributes) {
+                a->initialize(m_area);
+                if (a->uses_root_to_leaves()) {
+                    root_to_leaves_attributes.push_back(a.get());
+                }
+            }
+
+            for (auto n: leaves_to_root_iterator(m_tree, leaves_it::exclude)) {
+                if (m_compute_area) {
+                    area_t area = 0;
+                    for (auto c: children_iterator(n, m_tree)) {
+                        area += m_area(c);
+                    }
+                    m_area(n) = area;
+                }
+                for (auto &a: m_attributes) {
+                    a->leaves_to_root(n, m_area);
+                }
+            }
+
+            if (!root_to_leaves_attributes.empty()) {
+                for (auto n: root_to_leaves_iterator(m_tree, leaves_it::include, root_it::exclude)) {
+                    for (auto a: root_to_leaves_attributes) {
+                        a->root_to_leaves(n);
+                    }
+                }
+            }
+
+            for (auto &a: m_attributes) {
+                a->finalize(m_area);
+            }
+        }
+
+    private:
+
+        template<typename attribute_t, typename ...Args>
+        attribute_t *add(Args &&... args) {
+            auto attribute = new attribute_t(m_tree, std::forward<Args>(args)...);
+            m_attributes.emplace_back(attribute);
+            return attribute;
+        }
+
+        const tree_t &m_tree;
+        array_1d<area_t> m_area;
+        bool m_compute_area = false;
+        std::vector<std::unique_ptr<tree_attribute_detail::fused_attribute<tree_t, area_t>>> m_attributes;
+    };
+
+    /**
+     * Creates a fused attribute engine where the area of any leaf is equal to 1 (see fused_tree_attributes).
+     *
+     * @tparam tree_t tree type
+     * @param tree input tree
+     * @return
+     */
+    template<typename tree_t>
+    auto make_fused_tree_attributes(const tree_t &tree) {
+        return fused_tree_attributes<tree_t, index_t>(tree);
+    }
+
+    /**
+     * Creates a fused attribute engine with the given leaf area (see fused_tree_attributes).
+     *
+     * @tparam tree_t tree type
+     * @tparam T xexpression derived type of xleaf_area
+     * @param tree input tree
+     * @param xleaf_area area of the leaves of the input tree
+     * @return
+     */
+    template<typename tree_t, typename T>
+    auto make_fused_tree_attributes(const tree_t &tree, const xt::xexpression<T> &xleaf_area) {
+        return fused_tree_attributes<tree_t, typename T::value_type>(tree, xleaf_area);
+    }
 }
@@ -0,0 +1,116 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace hg {
+
+    /**
+     * Exception thrown at a cancellation point (see check_cancellation) when the cancellation token of the current
+     * thread is cancelled.
+     */
+    class operation_cancelled : public std::runtime_error {
+    public:
+        operation_cancelled() : std::runtime_error("The operation was cancelled.") {
+        }
+    };
+
+    /**
+     * Cooperative cancellation of long computations.
+     *
+     * A token is installed in a thread with scoped_cancellation_token: the long sequential loops of the library
+     * (Kruskal sweep of the canonical binary partition tree, main loop of the binary partition tree, propagation of
+     * the tree of shapes...) then regularly call check_cancellation, which throws operation_cancelled once the token
+     * is cancelled (from any thread). The loops executed by the threads of a parallel backend are not cancellation
+     * points.
+     */
+    class cancellation_token {
+    public:
+
+        void cancel() {
+            m_cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        bool cancelled() const {
+            return m_cancelled.load(std::memory_order_relaxed);
+        }
+
+        void reset() {
+            m_cancelled.store(false, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<bool> m_cancelled{false};
+    };
+
+    namespace cancellation_internal {
+
+        /**
+         * Cancellation token of the current thread (nullptr if the current computation cannot be cancelled)
+         */
+        inline cancellation_token *&current_token() {
+            static thread_local cancellation_token *token = nullptr;
+            return token;
+        }
+
+        /**
+         * check_cancellation(iteration) checks the token once every 2^14 iterations
+         */
+        const int64_t check_period_mask = (1 << 14) - 1;
+    }
+
+    /**
+     * Installs the given token (which may be nullptr) in the current thread for the lifetime of the object.
+     */
+    class scoped_cancellation_token {
+    public:
+        explicit scoped_cancellation_token(cancellation_token *token) :
+                m_previous(cancellation_internal::current_token()) {
+            cancellation_internal::current_token() = token;
+        }
+
+        ~scoped_cancellation_token() {
+            cancellation_internal::current_token() = m_previous;
+        }
+
+        scoped_cancellation_token(const scoped_cancellation_token &) = delete;
+
+        scoped_cancellation_token &operator=(const scoped_cancellation_token &) = delete;
+
+    private:
+        cancellation_token *m_previous;
+    };
+
+    /**
+     * Throws operation_cancelled if the cancellation token of the current thread is cancelled.
+     */
+    inline void check_cancellation() {
+        auto token = cancellation_internal::current_token();
+        if (token != nullptr && token->cancelled()) {
+            throw operation_cancelled();
+        }
+    }
+
+    /**
+     * Cancellation point of a tight loop: checks the cancellation token of the current thread once every 2^14
+     * iterations.
+     *
+     * @param iteration index of the current iteration
+     */
+    inline void check_cancellation(int64_t iteration) {
+        if ((iteration & cancellation_internal::check_period_mask) == 0) {
+            check_cancellation();
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace hg {
+
+    namespace fast_division_internal {
+
+        /**
+         * High 64 bits of the 128 bits product x * y
+         */
+        inline uint64_t mul_hi(uint64_t x, uint64_t y) {
+#if defined(__SIZEOF_INT128__)
+            return (uint64_t) (((unsigned __int128) x * y) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            return __umulh(x, y);
+#else
+            const uint64_t x_lo = x & 0xffffffff;
+            const uint64_t x_hi = x >> 32;
+            const uint64_t y_lo = y & 0xffffffff;
+            const uint64_t y_hi = y >> 32;
+            const uint64_t lo_lo = x_lo * y_lo;
+            const uint64_t hi_lo = x_hi * y_lo;
+            const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + x_lo * y_hi;
+            return (hi_lo >> 32) + (cross >> 32) + x_hi * y_hi;
+#endif
+        }
+
+        /**
+         * Number of bits needed to represent x
+         */
+        inline int bit_width(uint64_t x) {
+            int n = 0;
+            while (x != 0) {
+                x >>= 1;
+                n++;
+            }
+            return n;
+        }
+    }
+
+    /**
+     * Division of unsigned 64 bits integers by a divisor known at runtime but used many times.
+     *
+     * The quotient is computed with a multiplication and shifts (round-up method of Granlund and Montgomery, as in
+     * libdivide): the magic number is computed once at construction.
+     */
+    class fast_divider {
+    public:
+
+        fast_divider() : fast_divider(1) {
+        }
+
+        /**
+         * @param divisor a strictly positive integer
+         */
+        explicit fast_divider(uint64_t divisor) : m_divisor(divisor) {
+            const int width = fast_division_internal::bit_width(divisor - 1);
+            if ((divisor & (divisor - 1)) == 0) {
+                // power of 2 (including 1)
+                m_magic = 0;
+                m_shift = width;
+            } else {
+                // magic = floor(2^64 * (2^width - divisor) / divisor) + 1, computed by long division
+                uint64_t remainder = (width == 64) ? (uint64_t) 0 - divisor : ((uint64_t) 1 << width) - divisor;
+                uint64_t quotient = 0;
+                for (int i = 0; i < 64; i++) {
+                    const bool carry = (remainder >> 63) != 0;
+                    remainder <<= 1;
+                    quotient <<= 1;
+                    if (carry || remainder >= divisor) {
+                        remainder -= divisor;
+                        quotient |= 1;
+                    }
+                }
+                m_magic = quotient + 1;
+                m_shift = width - 1;
+            }
+        }
+
+        uint64_t divisor() const {
+            return m_divisor;
+        }
+
+        /**
+         * @param numerator any unsigned 64 bits integer
+         * @return numerator / divisor
+         */
+        uint64_t divide(uint64_t numerator) const {
+            if (m_magic == 0) {
+                return numerator >> m_shift;
+            }
+            const uint64_t t = fast_division_internal::mul_hi(m_magic, numerator);
+            return (t + ((numerator - t) >> 1)) >> m_shift;
+        }
+
+    private:
+        uint64_t m_divisor;
+        uint64_t m_magic;
+        int m_shift;
+    };
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../utils.hpp"
+#include <type_traits>
+
+namespace hg {
+
+    /**
+     * Width known at compile time: kernels looping over the channels of a vector with a fixed width can be fully
+     * unrolled and keep the vectors in registers.
+     */
+    template<index_t N>
+    using fixed_width = std::integral_constant<index_t, N>;
+
+    /**
+     * Width only known at runtime (fallback of dispatch_fixed_width).
+     */
+    struct dynamic_width {
+        index_t value;
+
+        constexpr operator index_t() const {
+            return value;
+        }
+    };
+
+    /**
+     * Calls fun(fixed_width<width>()) if width is one of the common widths 1, 2, 3, 4, 8 or 16 (typically the number
+     * of channels of an image or the dimension of a small feature vector) and fun(dynamic_width{width}) otherwise.
+     *
+     * fun is a generic function whose argument converts to index_t: loops bounded by this argument get a constant
+     * trip count in the fixed width instantiations. The dispatch costs a single switch: it should be done outside of
+     * the loops over the vectors, or on a value that does not change between calls so that the branch is predicted.
+     *
+     * @tparam F
+     * @param width runtime width
+     * @param fun generic function
+     * @return the result of fun
+     */
+    template<typename F>
+    decltype(auto) dispatch_fixed_width(index_t width, F &&fun) {
+        switch (width) {
+            case 1:
+                return fun(fixed_width<1>());
+            case 2:
+                return fun(fixed_width<2>());
+            case 3:
+                return fun(fixed_width<3>());
+            case 4:
+                return fun(fixed_width<4>());
+            case 8:
+                return fun(fixed_width<8>());
+            case 16:
+                return fun(fixed_width<16>());
+            default:
+                return fun(dynamic_width{width});
+        }
+    }
+}
@@ -10,38 +10,239 @@
 
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include "profiler.hpp"
 
 namespace hg {
 
+    /**
+     * Thread safe logger.
+     *
+     * Messages are formatted directly into the slots of a bounded lock-free queue (multiple producers, single
+     * consumer): emitting a message never allocates memory, and only takes a lock to wake up the background thread
+     * when it is idle. If the queue is full, the message is dropped and counted (see dropped_messages). Messages are
+     * delivered to the callbacks by a background thread, started with the first message and sleeping while the queue
+     * is empty, or synchronously by flush.
+     *
+     * The list of callbacks is immutable: registering a callback publishes a new list. The callbacks are never called
+     * concurrently and must not register callbacks nor flush the logger themselves.
+     */
     struct logger {
 
-        static const std::size_t MAX_MSG_SIZE = 8096;
-        using callback_list = std::vector<std::function<void(const std::string &)>>;
+        // maximal size of a message including the terminating null character, longer messages are truncated
+        static const std::size_t MAX_MSG_SIZE = 2048;
+        // number of slots of the message queue (power of 2)
+        static const std::size_t QUEUE_SIZE = 128;
+
+        using callback = std::function<void(const std::string &)>;
+        using callback_list = std::vector<callback>;
 
         static bool &trace_enabled() {
             static bool value{false};
             return value;
         }
 
-        static callback_list &callbacks() {
-            static callback_list callbacks{
-                    [](const std::string &msg) { std::cout << msg; }}; //not the perfect initialization...
-            return callbacks;
+        /**
+         * Snapshot of the current list of callbacks.
+         *
+         * Note: this used to return a mutable reference on the list; the list must now be modified with
+         * set_callbacks or add_callback.
+         */
+        static std::shared_ptr<const callback_list> callbacks() {
+            return std::atomic_load(&get_backend().m_callbacks);
+        }
+
+        /**
+         * Replaces the list of callbacks.
+         *
+         * Waits for the messages being delivered: when this function returns, the previous callbacks are not called
+         * anymore and can be safely destroyed.
+         */
+        static void set_callbacks(callback_list callbacks) {
+            auto &b = get_backend();
+            std::lock_guard<std::mutex> lock(b.m_drain_mutex);
+            std::atomic_store(&b.m_callbacks, std::shared_ptr<const callback_list>(
+                    std::make_shared<callback_list>(std::move(callbacks))));
+        }
+
+        /**
+         * Adds a callback to the list of callbacks, see set_callbacks.
+         */
+        static void add_callback(callback c) {
+            auto &b = get_backend();
+            std::lock_guard<std::mutex> lock(b.m_drain_mutex);
+            auto list = std::make_shared<callback_list>(*std::atomic_load(&b.m_callbacks));
+            list->push_back(std::move(c));
+            std::atomic_store(&b.m_callbacks, std::shared_ptr<const callback_list>(std::move(list)));
         }
 
         template<typename ...Args>
         static void emit(const char *format, Args &&...args) {
+            auto &b = get_backend();
+            b.start();
+            std::size_t position;
+            auto cell = b.claim(position);
+            if (cell == nullptr) {
+                b.m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            snprintf(cell->message, MAX_MSG_SIZE, format, std::forward<Args>(args)...);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            b.wake_up();
+        }
+
+        /**
+         * Delivers all the pending messages to the callbacks from the calling thread.
+         */
+        static void flush() {
+            get_backend().drain();
+        }
+
+        /**
+         * Number of messages dropped because the queue was full.
+         */
+        static std::size_t dropped_messages() {
+            return get_backend().m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+
+        struct cell_t {
+            std::atomic<std::size_t> sequence;
             char message[MAX_MSG_SIZE];
-            snprintf(message, MAX_MSG_SIZE, format, std::forward<Args>(args)...);
-            std::string sm(message);
-            for (auto c: callbacks()) {
-                c(sm);
+        };
+
+        struct backend {
+
+            backend() : m_callbacks(std::make_shared<callback_list>(callback_list{
+                    [](const std::string &msg) { std::cout << msg; }})) {
+                for (std::size_t i = 0; i < QUEUE_SIZE; i++) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
             }
 
+            ~backend() {
+                if (m_started.load()) {
+                    {
+                        std::lock_guard<std::mutex> lock(m_wait_mutex);
+                        m_stop = true;
+                    }
+                    m_wait_condition.notify_one();
+                    m_thread.join();
+                }
+                drain();
+            }
+
+            void start() {
+                if (!m_started.load(std::memory_order_acquire)) {
+                    std::call_once(m_start_flag, [this] {
+                        m_thread = std::thread([this] { run(); });
+                        m_started.store(true, std::memory_order_release);
+                    });
+                }
+            }
+
+            // bounded queue of D. Vyukov: a cell is free for the position p if its sequence is p, and holds the
+            // message of the position p if its sequence is p + 1
+            cell_t *claim(std::size_t &position) {
+                position = m_enqueue_position.load(std::memory_order_relaxed);
+                while (true) {
+                    cell_t *cell = &m_cells[position & (QUEUE_SIZE - 1)];
+                    std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    auto diff = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+                    if (diff == 0) {
+                        if (m_enqueue_position.compare_exchange_weak(position, position + 1,
+                                                                     std::memory_order_relaxed)) {
+                            return cell;
+                        }
+                    } else if (diff < 0) {
+                        return nullptr;
+                    } else {
+                        position = m_enqueue_position.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool has_pending_message() const {
+                auto position = m_dequeue_position.load(std::memory_order_relaxed);
+                return m_cells[position & (QUEUE_SIZE - 1)].sequence.load(std::memory_order_acquire) == position + 1;
+            }
+
+            // single consumer
+            void drain() {
+                std::lock_guard<std::mutex> lock(m_drain_mutex);
+                auto callbacks = std::atomic_load(&m_callbacks);
+                while (true) {
+                    auto position = m_dequeue_position.load(std::memory_order_relaxed);
+                    cell_t *cell = &m_cells[position & (QUEUE_SIZE - 1)];
+                    if (cell->sequence.load(std::memory_order_acquire) != position + 1) {
+                        return;
+                    }
+                    std::string message(cell->message);
+                    cell->sequence.store(position + QUEUE_SIZE, std::memory_order_release);
+                    m_dequeue_position.store(position + 1, std::memory_order_relaxed);
+                    for (const auto &c: *callbacks) {
+                        c(message);
+                    }
+                }
+            }
+
+            // the fences of wake_up and run ensure that either the producer sees the background thread idle, or
+            // the background thread sees the message before going to sleep
+            void wake_up() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_idle.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(m_wait_mutex);
+                    m_wait_condition.notify_one();
+                }
+            }
+
+            void run() {
+                std::unique_lock<std::mutex> lock(m_wait_mutex);
+                while (!m_stop) {
+                    m_idle.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (!has_pending_message()) {
+                        m_wait_condition.wait(lock);
+                    }
+                    m_idle.store(false, std::memory_order_relaxed);
+                    lock.unlock();
+                    drain();
+                    lock.lock();
+                }
+            }
+
+            cell_t m_cells[QUEUE_SIZE];
+            std::atomic<std::size_t> m_enqueue_position{0};
+            // modified only by drain, under m_drain_mutex
+            std::atomic<std::size_t> m_dequeue_position{0};
+            // serializes the deliveries and the modifications of the callbacks
+            std::mutex m_drain_mutex;
+            std::atomic<std::size_t> m_dropped{0};
+
+            std::shared_ptr<const callback_list> m_callbacks;
+
+            std::once_flag m_start_flag;
+            std::atomic<bool> m_started{false};
+            std::mutex m_wait_mutex;
+            std::condition_variable m_wait_condition;
+            std::atomic<bool> m_idle{false};
+            bool m_stop = false;
+            std::thread m_thread;
+        };
+
+        static backend &get_backend() {
+            static backend b;
+            return b;
         }
     };
 
@@ -107,12 +308,13 @@ namespace hg {
 #define HG_LOG_DETAIL(...) do{}while(0)
 #endif
 
+// with HG_ENABLE_PROFILING, HG_TRACE also profiles the enclosing function (see profiler.hpp)
 #ifdef HG_ENABLE_TRACE
-#define HG_TRACE(M, ...) do{                                            \
+#define HG_TRACE(M, ...) HG_PROFILE_SCOPE(HG_PRETTY_FUNCTION); do{      \
 if(hg::logger::trace_enabled()){                                        \
     HG_LOG_EMIT("TRACE", "function called " M, ##__VA_ARGS__);          \
 }                                                                       \
 }while(0)
 #else
-#define HG_TRACE(...)  do{}while(0)
+#define HG_TRACE(...)  HG_PROFILE_SCOPE(HG_PRETTY_FUNCTION)
 #endif
@@ -0,0 +1,127 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+namespace hg {
+
+    /**
+     * Estimations of the peak memory usage (in bytes) of the main algorithms from the size of their inputs, to
+     * check that a computation fits in memory before running it.
+     *
+     * The estimations include the temporary buffers and the result of the algorithm but not its inputs. They are
+     * upper bounds calibrated with the profiler (see HG_ENABLE_MEMORY_TRACKING) on 4-adjacency graphs of random images
+     * with a 64 bits index_t; the actual peak may be lower on regular data.
+     */
+    namespace memory_estimate {
+
+        inline std::size_t ceil_log2(std::size_t x) {
+            std::size_t r = 0;
+            while (((std::size_t) 1 << r) < x) {
+                r++;
+            }
+            return r;
+        }
+
+        /**
+         * bpt_canonical: sorted edge indices and sort buffers (edges), union-find, parents and mst edge map (vertices)
+         * and the resulting tree and altitudes.
+         *
+         * @param num_vertices number of vertices of the graph
+         * @param num_edges number of edges of the graph
+         * @param weight_size size in bytes of an edge weight
+         */
+        inline std::size_t bpt_canonical(std::size_t num_vertices, std::size_t num_edges, std::size_t weight_size) {
+            return num_edges * (16 + weight_size) + num_vertices * (88 + 2 * weight_size);
+        }
+
+        /**
+         * watershed_hierarchy_by_area, by_volume, by_dynamics...: bpt_canonical of the graph followed by the
+         * computation of the extinction values and of the canonical tree of the minimum spanning tree.
+         *
+         * @param num_vertices number of vertices of the graph
+         * @param num_edges number of edges of the graph
+         * @param weight_size size in bytes of an edge weight
+         */
+        inline std::size_t
+        watershed_hierarchy(std::size_t num_vertices, std::size_t num_edges, std::size_t weight_size) {
+            return bpt_canonical(num_vertices, num_edges, weight_size) + num_vertices * (240 + 2 * weight_size);
+        }
+
+        /**
+         * component_tree_max_tree and component_tree_min_tree.
+         *
+         * @param num_vertices number of vertices of the graph
+         * @param weight_size size in bytes of a vertex weight
+         */
+        inline std::size_t component_tree(std::size_t num_vertices, std::size_t weight_size) {
+            return num_vertices * (104 + 5 * weight_size);
+        }
+
+        /**
+         * binary_partition_tree_*_linkage: region adjacency structure and heap of the edges, and the resulting tree.
+         *
+         * @param num_vertices number of vertices of the graph
+         * @param num_edges number of edges of the graph
+         * @param weight_size size in bytes of an edge weight
+         */
+        inline std::size_t
+        binary_partition_tree(std::size_t num_vertices, std::size_t num_edges, std::size_t weight_size) {
+            return num_edges * (160 + weight_size) + num_vertices * (64 + 2 * weight_size);
+        }
+
+        /**
+         * lca_sparse_table_block (lca_fast) with the default block size: Euler tour of the tree and sparse table of
+         * the block minimums.
+         *
+         * @param num_nodes number of nodes of the tree
+         */
+        inline std::size_t lca_sparse_table_block(std::size_t num_nodes) {
+            return num_nodes * 176 + (1 << 16);
+        }
+
+        /**
+         * lca_sparse_table: Euler tour of the tree and the full sparse table (log2 levels of size 2 * num_nodes).
+         *
+         * @param num_nodes number of nodes of the tree
+         */
+        inline std::size_t lca_sparse_table(std::size_t num_nodes) {
+            return num_nodes * (56 + 32 * ceil_log2(2 * num_nodes));
+        }
+
+        /**
+         * component_tree_tree_of_shapes_image2d: the plain map of the padded and interpolated image, the sort of its
+         * pixels and the tree in this space (the interpolated space has about 4 times more pixels than the image).
+         *
+         * @param height height of the image
+         * @param width width of the image
+         * @param value_size size in bytes of a pixel value
+         * @param padding true if the image is padded (tos_padding::zero or tos_padding::mean)
+         * @param immersion true if the image is interpolated in the Khalimsky grid (default)
+         */
+        inline std::size_t tree_of_shapes_image2d(std::size_t height,
+                                                  std::size_t width,
+                                                  std::size_t value_size,
+                                                  bool padding = true,
+                                                  bool immersion = true) {
+            if (padding) {
+                height += 2;
+                width += 2;
+            }
+            if (immersion) {
+                height = height * 2 - 1;
+                width = width * 2 - 1;
+            }
+            return height * width * (160 + 12 * value_size);
+        }
+    }
+}
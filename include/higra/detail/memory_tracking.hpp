@@ -0,0 +1,98 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "profiler.hpp"
+#include <memory>
+
+namespace hg {
+
+    /**
+     * Allocator adaptor that reports the memory allocated and released through the base allocator to the
+     * profiler memory counters of the current thread (see profiler::count_allocation).
+     *
+     * If HG_ENABLE_MEMORY_TRACKING is defined, it becomes the default allocator of the xtensor containers (and thus of
+     * array_1d, array_nd...) which would otherwise escape the instrumented global allocation functions when the
+     * aligned xsimd allocator is used.
+     *
+     * @tparam T value type
+     * @tparam base_allocator_t base allocator
+     */
+    template<typename T, typename base_allocator_t = std::allocator<T>>
+    struct tracking_allocator : private base_allocator_t {
+        using base_type = base_allocator_t;
+        using traits = std::allocator_traits<base_allocator_t>;
+        using value_type = T;
+        using reference = T &;
+        using const_reference = const T &;
+        using pointer = typename traits::pointer;
+        using const_pointer = typename traits::const_pointer;
+        using size_type = typename traits::size_type;
+        using difference_type = typename traits::difference_type;
+
+        template<typename U>
+        struct rebind {
+            using other = tracking_allocator<U, typename traits::template rebind_alloc<U>>;
+        };
+
+        tracking_allocator() = default;
+
+        template<typename U, typename A>
+        tracking_allocator(const tracking_allocator<U, A> &other) noexcept : base_type(other.base()) {
+        }
+
+        pointer allocate(size_type n) {
+            auto p = traits::allocate(base(), n);
+            profiler::count_allocation(n * sizeof(T));
+            return p;
+        }
+
+        void deallocate(pointer p, size_type n) {
+            profiler::count_deallocation(n * sizeof(T));
+            traits::deallocate(base(), p, n);
+        }
+
+        const base_type &base() const noexcept {
+            return *this;
+        }
+
+        base_type &base() noexcept {
+            return *this;
+        }
+    };
+
+    template<typename T, typename A1, typename U, typename A2>
+    inline bool operator==(const tracking_allocator<T, A1> &a, const tracking_allocator<U, A2> &b) {
+        return a.base() == b.base();
+    }
+
+    template<typename T, typename A1, typename U, typename A2>
+    inline bool operator!=(const tracking_allocator<T, A1> &a, const tracking_allocator<U, A2> &b) {
+        return !(a == b);
+    }
+}
+
+#ifdef HG_ENABLE_MEMORY_TRACKING
+
+#ifdef XTENSOR_DEFAULT_ALLOCATOR
+#error "With HG_ENABLE_MEMORY_TRACKING, higra headers must be included before any xtensor header."
+#endif
+
+#ifdef XTENSOR_USE_XSIMD
+#include <xsimd/xsimd.hpp>
+#define XTENSOR_DEFAULT_ALLOCATOR(T) \
+    hg::tracking_allocator<T, xsimd::aligned_allocator<T, XSIMD_DEFAULT_ALIGNMENT>>
+#else
+#define XTENSOR_DEFAULT_ALLOCATOR(T) \
+    hg::tracking_allocator<T, std::allocator<T>>
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+/*
+ * Explicit instantiations of the optional prebuilt library (CMake option HG_BUILD_LIBRARY, target higra).
+ *
+ * Each header of an algorithm of the prebuilt library ends with the list of its instantiations for the standard
+ * type combinations, expanded with the prefix extern if HG_USE_PREBUILT_LIBRARY is defined (the higra target defines
+ * it for its consumers): the translation units of the consumers then do not generate the code of these
+ * instantiations and link with the one of the library instead. The sources of the library (directory src) expand
+ * the same lists without prefix to define the instantiations.
+ *
+ * Without HG_USE_PREBUILT_LIBRARY, Higra is header only and nothing changes.
+ *
+ * Note that the frontend of the compiler still has to parse the headers and, as the algorithms have deduced return
+ * types, to instantiate their bodies to determine their result types: only the code generation and the optimization
+ * of the instantiations are saved.
+ */
+
+/**
+ * Applies macro(prefix, value_t) to each edge or vertex weight type of the prebuilt library.
+ */
+#define HG_PREBUILT_FOR_EACH_VALUE_TYPE(macro, prefix) \
+    macro(prefix, float)                               \
+    macro(prefix, double)                              \
+    macro(prefix, uint8_t)
+
+/**
+ * Applies macro(prefix, value_t) to each floating point weight type of the prebuilt library.
+ */
+#define HG_PREBUILT_FOR_EACH_FLOAT_TYPE(macro, prefix) \
+    macro(prefix, float)                               \
+    macro(prefix, double)
+
+/**
+ * Declaration (prefix extern) or definition (empty prefix) of the instantiation of a function template
+ * fun<graph_t, array_1d<value_t>>(const graph_t &, const xt::xexpression<array_1d<value_t>> &).
+ */
+#define HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, fun, graph_t, value_t) \
+    prefix template auto fun<graph_t, array_1d<value_t>>(const graph_t &, const xt::xexpression<array_1d<value_t>> &);
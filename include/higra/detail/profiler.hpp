@@ -0,0 +1,488 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__linux__) || defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace hg {
+
+    /**
+     * Scoped timers and counters.
+     *
+     * Each thread accumulates, for each profiled scope (identified by a static string, usually the signature of the
+     * function), the number of calls, the total wall time, the number of bytes allocated during the calls, the peak
+     * memory usage of a call and the memory retained after the calls (inclusive of nested scopes). The counters of a thread are only written by this thread: a profiled call only
+     * costs two clock reads and a few relaxed atomic additions. The statistics of all the threads, including the
+     * threads that have exited, are merged by snapshot.
+     *
+     * The functions marked by HG_TRACE() are profiled when HG_ENABLE_PROFILING is defined, otherwise HG_TRACE() does
+     * not create any timer. Memory is only counted if the global allocation functions are instrumented with
+     * HG_PROFILER_INSTRUMENT_ALLOCATIONS() (see below) and/or if the xtensor containers use the tracking_allocator
+     * (see HG_ENABLE_MEMORY_TRACKING in memory_tracking.hpp).
+     *
+     * Memory usage is measured per thread: the peak of a call is the maximum increase of the memory held by the
+     * calling thread during the call, memory allocated by worker threads (parallel loops) is not included.
+     *
+     * When trace events are enabled (see set_events_enabled), each profiled call is also recorded as a complete
+     * event (start time, duration and thread) which can be exported in the Chrome trace event format, readable by
+     * chrome://tracing and by the Perfetto UI, to visualize nested calls on a time line.
+     *
+     * Algorithms can also report named samples with HG_PROFILE_COUNT(NAME, VALUE) (path lengths of the union-find,
+     * heap operations, plateau sizes...): for each name, the number of samples, their sum and their maximum are
+     * accumulated and merged by snapshot_counters. They explain why an input is slower than another one of the same
+     * size, which timings alone do not tell.
+     */
+    struct profiler {
+
+        /**
+         * Accumulated statistics of a scope.
+         */
+        struct stats {
+            uint64_t calls = 0;
+            uint64_t time_ns = 0;
+            uint64_t allocated_bytes = 0;
+            // maximum over the calls of the peak memory usage during the call (relative to the start of the call)
+            int64_t peak_bytes = 0;
+            // total memory allocated by the calls and not released at their end (typically the results)
+            int64_t retained_bytes = 0;
+        };
+
+        /**
+         * Accumulated samples of an algorithm counter (see HG_PROFILE_COUNT).
+         */
+        struct counter_stats {
+            uint64_t samples = 0;
+            uint64_t total = 0;
+            uint64_t max = 0;
+
+            double mean() const {
+                return samples == 0 ? 0.0 : (double) total / (double) samples;
+            }
+        };
+
+        struct sample_counters {
+            std::atomic<uint64_t> samples{0};
+            std::atomic<uint64_t> total{0};
+            std::atomic<uint64_t> max{0};
+        };
+
+        struct counters {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> time_ns{0};
+            std::atomic<uint64_t> allocated_bytes{0};
+            std::atomic<int64_t> peak_bytes{0};
+            std::atomic<int64_t> retained_bytes{0};
+        };
+
+        /**
+         * Memory counters of a thread: the current memory can be negative if the thread releases memory allocated by
+         * another thread.
+         */
+        struct memory_counters {
+            uint64_t allocated_bytes = 0;
+            int64_t current_bytes = 0;
+            int64_t peak_bytes = 0;
+        };
+
+        /**
+         * A profiled call: times are in nanoseconds since the steady clock epoch.
+         */
+        struct trace_event {
+            const char *name;
+            int64_t start_ns;
+            int64_t duration_ns;
+        };
+
+        /**
+         * Counters and events of one thread: they are only modified by their thread, under the lock which is also
+         * taken by the snapshots (counters are only locked on the insertion of a new scope).
+         */
+
+        struct thread_store {
+            std::mutex mutex;
+            std::unordered_map<const char *, counters> scopes;
+            std::unordered_map<const char *, sample_counters> samples;
+            std::vector<trace_event> events;
+            uint64_t thread_id = 0;
+
+            counters &get(const char *name) {
+                auto it = scopes.find(name);
+                if (it != scopes.end()) {
+                    return it->second;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                return scopes[name];
+            }
+
+            sample_counters &get_samples(const char *name) {
+                auto it = samples.find(name);
+                if (it != samples.end()) {
+                    return it->second;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                return samples[name];
+            }
+        };
+
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<thread_store>> stores;
+            uint64_t num_threads = 0;
+        };
+
+        static registry &get_registry() {
+            static registry r;
+            return r;
+        }
+
+        static thread_store &local_store() {
+            thread_local std::shared_ptr<thread_store> store = [] {
+                auto s = std::make_shared<thread_store>();
+                auto &r = get_registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                s->thread_id = ++r.num_threads;
+                r.stores.push_back(s);
+                return s;
+            }();
+            return *store;
+        }
+
+        /**
+         * Memory counters of the current thread (only updated if the allocation functions are instrumented).
+         */
+        static memory_counters &thread_memory() {
+            thread_local memory_counters memory;
+            return memory;
+        }
+
+        static void count_allocation(std::size_t bytes) {
+            auto &memory = thread_memory();
+            memory.allocated_bytes += bytes;
+            memory.current_bytes += (int64_t) bytes;
+            if (memory.current_bytes > memory.peak_bytes) {
+                memory.peak_bytes = memory.current_bytes;
+            }
+        }
+
+        static void count_deallocation(std::size_t bytes) {
+            thread_memory().current_bytes -= (int64_t) bytes;
+        }
+
+        /**
+         * Adds a sample to counters of the current thread: only the owner thread writes the counters, no atomic
+         * read-modify-write is needed.
+         */
+        static void add_sample(sample_counters &counters, uint64_t value) {
+            counters.samples.store(counters.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            counters.total.store(counters.total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            if (value > counters.max.load(std::memory_order_relaxed)) {
+                counters.max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Size of a block returned by malloc (0 if the platform does not provide this information).
+         */
+        static std::size_t malloc_block_size(void *p) {
+#if defined(__APPLE__)
+            return malloc_size(p);
+#elif defined(__linux__)
+            return malloc_usable_size(p);
+#elif defined(_WIN32)
+            return _msize(p);
+#else
+            return 0;
+#endif
+        }
+
+        /**
+         * Accumulates the statistics of all the threads by scope name.
+         *
+         * Scopes with the same name (for example the different instantiations of a function template whose
+         * signature does not name the template arguments) are merged.
+         */
+        static std::map<std::string, stats> snapshot() {
+            std::map<std::string, stats> result;
+            auto &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (auto &store: r.stores) {
+                std::lock_guard<std::mutex> store_lock(store->mutex);
+                for (auto &e: store->scopes) {
+                    auto &s = result[e.first];
+                    s.calls += e.second.calls.load(std::memory_order_relaxed);
+                    s.time_ns += e.second.time_ns.load(std::memory_order_relaxed);
+                    s.allocated_bytes += e.second.allocated_bytes.load(std::memory_order_relaxed);
+                    s.peak_bytes = std::max(s.peak_bytes, e.second.peak_bytes.load(std::memory_order_relaxed));
+                    s.retained_bytes += e.second.retained_bytes.load(std::memory_order_relaxed);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Accumulates the algorithm counters of all the threads by name.
+         */
+        static std::map<std::string, counter_stats> snapshot_counters() {
+            std::map<std::string, counter_stats> result;
+            auto &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (auto &store: r.stores) {
+                std::lock_guard<std::mutex> store_lock(store->mutex);
+                for (auto &e: store->samples) {
+                    auto &s = result[e.first];
+                    s.samples += e.second.samples.load(std::memory_order_relaxed);
+                    s.total += e.second.total.load(std::memory_order_relaxed);
+                    s.max = std::max(s.max, e.second.max.load(std::memory_order_relaxed));
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Resets the statistics, the algorithm counters and the trace events of all the threads (the stores of the threads that have exited
+         * are released).
+         */
+        static void reset() {
+            auto &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            std::vector<std::shared_ptr<thread_store>> alive;
+            for (auto &store: r.stores) {
+                std::lock_guard<std::mutex> store_lock(store->mutex);
+                for (auto &e: store->scopes) {
+                    e.second.calls.store(0, std::memory_order_relaxed);
+                    e.second.time_ns.store(0, std::memory_order_relaxed);
+                    e.second.allocated_bytes.store(0, std::memory_order_relaxed);
+                    e.second.peak_bytes.store(0, std::memory_order_relaxed);
+                    e.second.retained_bytes.store(0, std::memory_order_relaxed);
+                }
+                for (auto &e: store->samples) {
+                    e.second.samples.store(0, std::memory_order_relaxed);
+                    e.second.total.store(0, std::memory_order_relaxed);
+                    e.second.max.store(0, std::memory_order_relaxed);
+                }
+                store->events.clear();
+                if (store.use_count() > 1) {
+                    alive.push_back(store);
+                }
+            }
+            r.stores.swap(alive);
+        }
+
+        static std::atomic<bool> &events_enabled() {
+            static std::atomic<bool> value{false};
+            return value;
+        }
+
+        /**
+         * Starts or stops the recording of trace events (the recorded events are kept until the next reset).
+         */
+        static void set_events_enabled(bool enabled) {
+            events_enabled().store(enabled, std::memory_order_relaxed);
+        }
+
+        static void record_event(const char *name, int64_t start_ns, int64_t duration_ns) {
+            auto &store = local_store();
+            std::lock_guard<std::mutex> lock(store.mutex);
+            store.events.push_back({name, start_ns, duration_ns});
+        }
+
+        /**
+         * Writes the recorded events of all the threads in the Chrome trace event JSON format.
+         */
+        static void write_chrome_trace(std::ostream &out) {
+            auto &r = get_registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            int64_t origin = INT64_MAX;
+            for (auto &store: r.stores) {
+                std::lock_guard<std::mutex> store_lock(store->mutex);
+                for (auto &e: store->events) {
+                    origin = std::min(origin, e.start_ns);
+                }
+            }
+
+            out << "{\"traceEvents\":[";
+            bool first = true;
+            char buffer[128];
+            for (auto &store: r.stores) {
+                std::lock_guard<std::mutex> store_lock(store->mutex);
+                for (auto &e: store->events) {
+                    out << (first ? "\n" : ",\n") << "{\"name\":\"";
+                    first = false;
+                    write_json_string(out, e.name);
+                    // times in microseconds
+                    snprintf(buffer, sizeof(buffer),
+                             "\",\"cat\":\"higra\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%llu}",
+                             (double) (e.start_ns - origin) * 1e-3, (double) e.duration_ns * 1e-3,
+                             (unsigned long long) store->thread_id);
+                    out << buffer;
+                }
+            }
+            out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+
+        static void write_json_string(std::ostream &out, const char *str) {
+            for (const char *c = str; *c != 0; c++) {
+                if (*c == '"' || *c == '\\') {
+                    out << '\\' << *c;
+                } else if ((unsigned char) *c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned) (unsigned char) *c);
+                    out << buffer;
+                } else {
+                    out << *c;
+                }
+            }
+        }
+
+        /**
+         * Accumulates the duration and the memory usage of its lifetime in the counters of the given scope.
+         */
+        class scoped_timer {
+        public:
+            explicit scoped_timer(const char *name) :
+                    m_name(name),
+                    m_counters(local_store().get(name)),
+                    m_memory(thread_memory()),
+                    m_allocated_bytes(m_memory.allocated_bytes),
+                    m_current_bytes(m_memory.current_bytes),
+                    m_enclosing_peak_bytes(m_memory.peak_bytes),
+                    m_start(std::chrono::steady_clock::now()) {
+                // the thread peak is restarted for this scope and restored at its end
+                m_memory.peak_bytes = m_memory.current_bytes;
+            }
+
+            scoped_timer(const scoped_timer &) = delete;
+
+            scoped_timer &operator=(const scoped_timer &) = delete;
+
+            ~scoped_timer() {
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - m_start).count();
+                auto peak_bytes = m_memory.peak_bytes - m_current_bytes;
+                auto retained_bytes = m_memory.current_bytes - m_current_bytes;
+                m_memory.peak_bytes = std::max(m_memory.peak_bytes, m_enclosing_peak_bytes);
+                if (events_enabled().load(std::memory_order_relaxed)) {
+                    record_event(m_name, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            m_start.time_since_epoch()).count(), duration);
+                }
+                m_counters.calls.fetch_add(1, std::memory_order_relaxed);
+                m_counters.time_ns.fetch_add((uint64_t) duration, std::memory_order_relaxed);
+                m_counters.allocated_bytes.fetch_add(m_memory.allocated_bytes - m_allocated_bytes,
+                                                     std::memory_order_relaxed);
+                m_counters.retained_bytes.fetch_add(retained_bytes, std::memory_order_relaxed);
+                // only the owner thread increases the peak
+                if (peak_bytes > m_counters.peak_bytes.load(std::memory_order_relaxed)) {
+                    m_counters.peak_bytes.store(peak_bytes, std::memory_order_relaxed);
+                }
+            }
+
+        private:
+            const char *m_name;
+            counters &m_counters;
+            memory_counters &m_memory;
+            uint64_t m_allocated_bytes;
+            int64_t m_current_bytes;
+            int64_t m_enclosing_peak_bytes;
+            std::chrono::steady_clock::time_point m_start;
+        };
+    };
+}
+
+#define HG_PROFILER_CONCAT_IMPL(A, B) A ## B
+#define HG_PROFILER_CONCAT(A, B) HG_PROFILER_CONCAT_IMPL(A, B)
+
+/**
+ * Profiles the enclosing scope under the given name (a static string).
+ */
+#ifdef HG_ENABLE_PROFILING
+#define HG_PROFILE_SCOPE(NAME) hg::profiler::scoped_timer HG_PROFILER_CONCAT(hg_profiler_scoped_timer_, __LINE__)(NAME)
+#else
+#define HG_PROFILE_SCOPE(NAME) do{}while(0)
+#endif
+
+/**
+ * Adds a sample VALUE (converted to uint64_t) to the algorithm counter NAME (a static string) of the current thread.
+ * The counter of the thread is looked up once per call site, the expression VALUE is not evaluated without
+ * HG_ENABLE_PROFILING.
+ */
+#ifdef HG_ENABLE_PROFILING
+#define HG_PROFILE_COUNT(NAME, VALUE) do {                                                      \
+    static thread_local hg::profiler::sample_counters &hg_profiler_sample_counters =           \
+            hg::profiler::local_store().get_samples(NAME);                                     \
+    hg::profiler::add_sample(hg_profiler_sample_counters, (uint64_t) (VALUE));                 \
+} while(0)
+#else
+#define HG_PROFILE_COUNT(NAME, VALUE) do{}while(0)
+#endif
+
+/**
+ * Defines replacements of the global allocation functions that count the allocated and released bytes of each thread
+ * (see profiler::thread_memory). Must be used at most once in a program, outside of any namespace.
+ *
+ * The sizes of the blocks are obtained from the allocator (malloc_usable_size or equivalent) so that blocks released
+ * by the non sized deallocation functions are also counted.
+ */
+#define HG_PROFILER_INSTRUMENT_ALLOCATIONS()                                    \
+void *operator new(std::size_t size) {                                          \
+    void *p = std::malloc(size == 0 ? 1 : size);                                \
+    if (p == nullptr) {                                                         \
+        throw std::bad_alloc();                                                 \
+    }                                                                           \
+    hg::profiler::count_allocation(hg::profiler::malloc_block_size(p));         \
+    return p;                                                                   \
+}                                                                               \
+void *operator new[](std::size_t size) {                                        \
+    return operator new(size);                                                  \
+}                                                                               \
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {         \
+    void *p = std::malloc(size == 0 ? 1 : size);                                \
+    if (p != nullptr) {                                                         \
+        hg::profiler::count_allocation(hg::profiler::malloc_block_size(p));     \
+    }                                                                           \
+    return p;                                                                   \
+}                                                                               \
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {    \
+    return operator new(size, tag);                                             \
+}                                                                               \
+void operator delete(void *p) noexcept {                                        \
+    if (p != nullptr) {                                                         \
+        hg::profiler::count_deallocation(hg::profiler::malloc_block_size(p));   \
+        std::free(p);                                                           \
+    }                                                                           \
+}                                                                               \
+void operator delete[](void *p) noexcept {                                      \
+    operator delete(p);                                                         \
+}                                                                               \
+void operator delete(void *p, std::size_t) noexcept {                           \
+    operator delete(p);                                                         \
+}                                                                               \
+void operator delete[](void *p, std::size_t) noexcept {                         \
+    operator delete(p);                                                         \
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <string>
+
+/*
+ * Runtime dispatch of the SIMD kernels.
+ *
+ * The binaries distributed as Python wheels target a generic baseline (SSE2 on x86-64), so the kernels vectorized at
+ * compile time would only use the baseline instruction set. On x86-64 Linux with GCC >= 9 or Clang >= 14, the
+ * functions marked with HG_SIMD_DISPATCH are compiled for AVX-512, AVX2, SSE4.2 and the baseline, and the variant
+ * matching the CPU is selected by the dynamic loader the first time the function is resolved (GNU indirect functions).
+ * The kernels are then written as plain loops on contiguous ranges that the compiler vectorizes for each instruction
+ * set, and HG_HAS_SIMD_DISPATCH is defined.
+ *
+ * Elsewhere (or if HG_NO_SIMD_DISPATCH is defined), HG_SIMD_DISPATCH is empty and the kernels use the instruction set
+ * of the compilation flags (with xsimd if XTENSOR_USE_XSIMD is defined). NEON is part of the aarch64 baseline and
+ * does not need runtime dispatch.
+ */
+#if !defined(HG_NO_SIMD_DISPATCH) && defined(__x86_64__) && defined(__linux__) && \
+    ((defined(__clang__) && __clang_major__ >= 14) || \
+     (!defined(__clang__) && !defined(__INTEL_COMPILER) && defined(__GNUC__) && __GNUC__ >= 9))
+#define HG_HAS_SIMD_DISPATCH
+#define HG_SIMD_DISPATCH __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define HG_SIMD_DISPATCH
+#endif
+
+namespace hg {
+
+    /**
+     * Name of the instruction set used by the SIMD kernels on the current CPU: "avx512f", "avx2", "sse4.2" or "sse2"
+     * on x86-64, "neon" on aarch64, and "generic" otherwise.
+     *
+     * With runtime dispatch (HG_HAS_SIMD_DISPATCH), this is the best instruction set of the dispatched variants
+     * supported by the CPU, otherwise this is the instruction set of the compilation flags.
+     */
+    inline std::string simd_instruction_set() {
+#if defined(HG_HAS_SIMD_DISPATCH)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return "avx512f";
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return "avx2";
+        }
+        if (__builtin_cpu_supports("sse4.2")) {
+            return "sse4.2";
+        }
+        return "sse2";
+#elif defined(__AVX512F__)
+        return "avx512f";
+#elif defined(__AVX2__)
+        return "avx2";
+#elif defined(__SSE4_2__)
+        return "sse4.2";
+#elif defined(__x86_64__) || defined(_M_X64)
+        return "sse2";
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+        return "neon";
+#else
+        return "generic";
+#endif
+    }
+}
@@ -0,0 +1,263 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hg {
+
+    namespace thread_pool_internal {
+
+        /**
+         * True in the threads of the pool and in a thread executing a parallel loop: nested parallel loops are
+         * executed serially.
+         */
+        inline bool &in_parallel_region() {
+            static thread_local bool flag = false;
+            return flag;
+        }
+
+        /**
+         * Sets in_parallel_region() to true for the lifetime of the object.
+         */
+        struct parallel_region_guard {
+            parallel_region_guard() : m_previous(in_parallel_region()) {
+                in_parallel_region() = true;
+            }
+
+            ~parallel_region_guard() {
+                in_parallel_region() = m_previous;
+            }
+
+        private:
+            bool m_previous;
+        };
+
+        inline int64_t default_num_threads() {
+            return (std::max)((int64_t) 1, (int64_t) std::thread::hardware_concurrency());
+        }
+
+        /**
+         * Process wide pool of threads used by parfor when Higra is compiled without TBB (HG_USE_THREAD_POOL).
+         *
+         * A parallel loop is split into chunks of consecutive iterations distributed dynamically: the calling thread
+         * and the workers of the pool repeatedly take the next unprocessed chunk from a shared atomic counter until
+         * all the chunks are processed, so that threads finishing early take the work left by the slower ones.
+         * The pool executes one loop at a time: a loop started while the pool is busy (from another thread, or
+         * nested in a parallel loop) is executed serially by the calling thread. The first exception thrown by an
+         * iteration cancels the remaining chunks and is rethrown in the calling thread.
+         *
+         * The worker threads are created with the first parallel loop.
+         */
+        class thread_pool {
+        public:
+
+            static thread_pool &instance() {
+                static thread_pool pool;
+                return pool;
+            }
+
+            thread_pool(const thread_pool &) = delete;
+
+            thread_pool &operator=(const thread_pool &) = delete;
+
+            ~thread_pool() {
+                stop_workers();
+            }
+
+            /**
+             * Maximum number of threads (including the calling thread) used by a parallel loop
+             */
+            int64_t num_threads() const {
+                return m_num_threads.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * Changes the number of threads of the pool, 0 restores the default (number of logical cores). Waits for
+             * the completion of the running parallel loop.
+             */
+            void set_num_threads(int64_t num_threads) {
+                std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+                stop_workers();
+                m_num_threads = (num_threads <= 0) ? default_num_threads() : num_threads;
+            }
+
+            /**
+             * Calls fun(i) for i = start, start + step, ... < end with at most max_threads threads, each chunk of
+             * iterations contains at least grain_size iterations (except the last one).
+             */
+            template<typename lambda_t>
+            void parallel_for(int64_t start, int64_t end, int64_t step, const lambda_t &fun, int64_t max_threads,
+                              int64_t grain_size) {
+                if (start >= end) {
+                    return;
+                }
+                grain_size = (std::max)((int64_t) 1, grain_size);
+                const int64_t num_iterations = (end - start + step - 1) / step;
+                const int64_t num_threads = (std::min)((std::min)(max_threads, this->num_threads()),
+                                                       (num_iterations + grain_size - 1) / grain_size);
+                if (num_threads <= 1 || in_parallel_region() || !m_submit_mutex.try_lock()) {
+                    for (int64_t i = start; i < end; i += step) {
+                        fun(i);
+                    }
+                    return;
+                }
+                std::lock_guard<std::mutex> submit_lock(m_submit_mutex, std::adopt_lock);
+                start_workers();
+
+                loop_context<lambda_t> context{fun, start, step};
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_run = &loop_context<lambda_t>::run;
+                    m_context = &context;
+                    m_num_iterations = num_iterations;
+                    // a few chunks per thread for load balancing
+                    m_chunk_size = (std::max)(grain_size, num_iterations / (num_threads * 8));
+                    m_num_chunks = (num_iterations + m_chunk_size - 1) / m_chunk_size;
+                    m_next_chunk = 0;
+                    m_free_slots = num_threads - 1;
+                    m_exception = nullptr;
+                    m_generation++;
+                }
+                m_start_condition.notify_all();
+
+                {
+                    parallel_region_guard guard;
+                    run_chunks();
+                }
+
+                std::exception_ptr exception;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_free_slots = 0;
+                    m_done_condition.wait(lock, [this] { return m_num_active == 0; });
+                    exception = m_exception;
+                    m_exception = nullptr;
+                }
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+        private:
+
+            template<typename lambda_t>
+            struct loop_context {
+                const lambda_t &fun;
+                int64_t start;
+                int64_t step;
+
+                static void run(const void *context, int64_t first, int64_t last) {
+                    auto &c = *static_cast<const loop_context *>(context);
+                    for (int64_t i = first; i < last; i++) {
+                        c.fun(c.start + i * c.step);
+                    }
+                }
+            };
+
+            thread_pool() : m_num_threads(default_num_threads()) {
+            }
+
+            void run_chunks() {
+                while (true) {
+                    int64_t chunk = m_next_chunk.fetch_add(1);
+                    if (chunk >= m_num_chunks) {
+                        return;
+                    }
+                    int64_t first = chunk * m_chunk_size;
+                    int64_t last = (std::min)(m_num_iterations, first + m_chunk_size);
+                    try {
+                        m_run(m_context, first, last);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_exception) {
+                            m_exception = std::current_exception();
+                        }
+                        m_next_chunk = m_num_chunks;
+                    }
+                }
+            }
+
+            void worker_loop() {
+                in_parallel_region() = true;
+                uint64_t generation = 0;
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (true) {
+                    m_start_condition.wait(lock, [this, generation] {
+                        return m_stop || (m_generation != generation && m_free_slots > 0);
+                    });
+                    if (m_stop) {
+                        return;
+                    }
+                    generation = m_generation;
+                    m_free_slots--;
+                    m_num_active++;
+                    lock.unlock();
+                    run_chunks();
+                    lock.lock();
+                    if (--m_num_active == 0) {
+                        m_done_condition.notify_all();
+                    }
+                }
+            }
+
+            // must be called with m_submit_mutex locked
+            void start_workers() {
+                const int64_t num_workers = num_threads() - 1;
+                while ((int64_t) m_workers.size() < num_workers) {
+                    m_workers.emplace_back(&thread_pool::worker_loop, this);
+                }
+            }
+
+            void stop_workers() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_start_condition.notify_all();
+                for (auto &w: m_workers) {
+                    w.join();
+                }
+                m_workers.clear();
+                m_stop = false;
+            }
+
+            std::atomic<int64_t> m_num_threads;
+            std::vector<std::thread> m_workers;
+
+            // one parallel loop at a time
+            std::mutex m_submit_mutex;
+
+            // state of the current loop, protected by m_mutex (except the chunk counter)
+            std::mutex m_mutex;
+            std::condition_variable m_start_condition;
+            std::condition_variable m_done_condition;
+            void (*m_run)(const void *, int64_t, int64_t) = nullptr;
+            const void *m_context = nullptr;
+            int64_t m_num_iterations = 0;
+            int64_t m_chunk_size = 1;
+            int64_t m_num_chunks = 0;
+            std::atomic<int64_t> m_next_chunk{0};
+            int64_t m_free_slots = 0;
+            int64_t m_num_active = 0;
+            uint64_t m_generation = 0;
+            bool m_stop = false;
+            std::exception_ptr m_exception;
+        };
+    }
+}
@@ -13,6 +13,8 @@
 #include "structure/undirected_graph.hpp"
 #include "structure/regular_graph.hpp"
 #include "structure/tree_graph.hpp"
+#include "structure/csr_graph.hpp"
+#include "structure/grid_graph.hpp"
 
 namespace hg {
 
@@ -275,6 +277,29 @@ namespace hg {
             g.add_edge(sources(i), targets(i));
     }
 
+    /**
+     * Add the given edges to the given undirected graph (the out edge lists of the vertices are allocated once, see
+     * undirected_graph::add_edges).
+     *
+     * @tparam T xexpression type
+     * @tparam edgeS
+     * @param xsources Must be a 1d array of integral values
+     * @param xtargets Must have the same shape as xsources
+     * @param g An undirected graph
+     */
+    template<typename T, typename edgeS>
+    void add_edges(const xt::xexpression<T> &xsources,
+                   const xt::xexpression<T> &xtargets,
+                   undirected_graph<edgeS> &g) {
+        auto &sources = xsources.derived_cast();
+        auto &targets = xtargets.derived_cast();
+        hg_assert_1d_array(sources);
+        hg_assert_integral_value_type(sources);
+        hg_assert_same_shape(sources, targets);
+
+        g.add_edges(sources, targets);
+    }
+
     namespace graph_internal {
         /**
          * SFINAE type to provides size estimates of graph for preallocations
@@ -335,6 +360,14 @@ namespace hg {
 
             size_t estimate_number_of_edge_per_vertex(const tree &) { return 1; }
         };
+
+        template<>
+        struct graph_size_estimator<grid_4_adjacency_graph_2d> {
+
+            size_t estimate_edge_number(const grid_4_adjacency_graph_2d &g) { return num_edges(g); }
+
+            size_t estimate_number_of_edge_per_vertex(const grid_4_adjacency_graph_2d &) { return 4; }
+        };
     }
 
     /**
@@ -389,6 +422,40 @@ namespace hg {
         return ugraph(graph);
     };
 
+    template<typename output_graph_type>
+    output_graph_type
+    copy_graph(const csr_graph &graph) {
+        HG_TRACE();
+        output_graph_type g(num_vertices(graph), num_edges(graph), 0);
+        auto edge_it = edges(graph);
+        for (auto eb = edge_it.first; eb != edge_it.second; eb++) {
+            g.add_edge(source(*eb, graph), target(*eb, graph));
+        }
+        return g;
+    };
+
+    /**
+     * Create an immutable copy of the given graph with a compressed sparse row storage (see csr_graph).
+     *
+     * Edge indices are preserved: edge weights of the input graph are valid edge weights of the result.
+     *
+     * @tparam graph_t input graph type, must provide edge sources and targets (ugraph, tree...)
+     * @param graph
+     * @return a csr_graph
+     */
+    template<typename graph_t>
+    csr_graph freeze(const graph_t &graph) {
+        HG_TRACE();
+        return csr_graph(num_vertices(graph), sources(graph), targets(graph));
+    }
+
+    template<>
+    inline
+    csr_graph copy_graph(const csr_graph &graph) {
+        HG_TRACE();
+        return csr_graph(graph);
+    };
+
     /**
      * Given an edge and one of the two extremities of this edge, return the other extremity
      * (if the source is given it returns the target and vice versa).
@@ -479,4 +546,114 @@ namespace hg {
         }
         return std::make_pair(std::move(g), std::move(edge_weights));
     }
+
+    /**
+     * Compressed sparse row (CSR) structure of the symmetric adjacency matrix of an undirected graph: the non zero
+     * entries of the row i are the entries of positions indptr(i) (included) to indptr(i + 1) (excluded) of the arrays
+     * indices (column of the entry) and edge_indices (index of the corresponding edge of the graph).
+     */
+    struct csr_adjacency {
+        array_1d<index_t> indptr;
+        array_1d<index_t> indices;
+        array_1d<index_t> edge_indices;
+    };
+
+    /**
+     * CSR structure of the adjacency matrix of the given undirected graph (see csr_adjacency): the entries of the row
+     * i are the out edges of the vertex i in the order of the graph (a self loop gives a single entry). The values of
+     * the adjacency matrix for some edge weights are given by gathering the edge weights with edge_indices.
+     *
+     * The structure is filled in a single pass over the out edges of the vertices, in parallel.
+     *
+     * @tparam graph_t
+     * @param graph input undirected graph
+     * @return a csr_adjacency
+     */
+    template<typename graph_t>
+    auto undirected_graph_2_csr_adjacency(const graph_t &graph) {
+        HG_TRACE();
+        const index_t num_v = num_vertices(graph);
+        array_1d<index_t> indptr = array_1d<index_t>::from_shape({(size_t) num_v + 1});
+        indptr(0) = 0;
+        for (index_t v = 0; v < num_v; v++) {
+            indptr(v + 1) = indptr(v) + out_degree(v, graph);
+        }
+        array_1d<index_t> indices = array_1d<index_t>::from_shape({(size_t) indptr(num_v)});
+        array_1d<index_t> edge_indices = array_1d<index_t>::from_shape({(size_t) indptr(num_v)});
+        parfor(0, num_v, [&graph, &indptr, &indices, &edge_indices](index_t v) {
+            index_t position = indptr(v);
+            for (auto e: out_edge_iterator(v, graph)) {
+                indices(position) = target(e, graph);
+                edge_indices(position) = index(e, graph);
+                position++;
+            }
+        });
+        return csr_adjacency{std::move(indptr), std::move(indices), std::move(edge_indices)};
+    }
+
+    /**
+     * Creates an undirected graph from the CSR structure (indptr, indices) of a symmetric sparse adjacency matrix with
+     * indptr.size() - 1 rows, without adding the edges one by one.
+     *
+     * Only the entries of the upper triangle, diagonal included, are read (the lower triangle is ignored): the
+     * entry (i, j), with i <= j, gives the edge {i, j}, and the edges are indexed in the order of the entries
+     * (row by row). The result also contains, for each edge, the position in indices of its entry: the weights of
+     * the edges are obtained by gathering the values of the matrix with this edge map.
+     *
+     * @tparam T1
+     * @tparam T2
+     * @param xindptr 1d array of num_vertices + 1 non decreasing offsets
+     * @param xindices 1d array of column indices
+     * @return a pair (ugraph, edge map)
+     */
+    template<typename T1, typename T2>
+    auto csr_adjacency_2_undirected_graph(const xt::xexpression<T1> &xindptr, const xt::xexpression<T2> &xindices) {
+        HG_TRACE();
+        auto &indptr = xindptr.derived_cast();
+        auto &indices = xindices.derived_cast();
+        hg_assert_1d_array(indptr);
+        hg_assert_1d_array(indices);
+        hg_assert_integral_value_type(indptr);
+        hg_assert_integral_value_type(indices);
+        hg_assert(indptr.size() >= 1, "The CSR index pointer array cannot be empty.");
+        const index_t num_v = indptr.size() - 1;
+        hg_assert(indptr(0) == 0 && (index_t) indptr(num_v) == (index_t) indices.size(),
+                  "Invalid CSR index pointer array.");
+
+        using edge_t = ugraph::edge_descriptor;
+        std::vector<edge_t> edges;
+        std::vector<index_t> edge_map;
+        std::vector<index_t> offsets(num_v + 1, 0);
+        for (index_t i = 0; i < num_v; i++) {
+            hg_assert(indptr(i) <= indptr(i + 1), "Invalid CSR index pointer array.");
+            for (index_t p = indptr(i); p < (index_t) indptr(i + 1); p++) {
+                const index_t j = indices(p);
+                hg_assert(j >= 0 && j < num_v, "Invalid vertex index.");
+                if (i <= j) {
+                    offsets[i + 1]++;
+                    if (i != j) {
+                        offsets[j + 1]++;
+                    }
+                    edges.emplace_back(i, j, (index_t) edges.size());
+                    edge_map.push_back(p);
+                }
+            }
+        }
+        for (index_t v = 0; v < num_v; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+
+        // out edges in increasing edge index order, as with add_edges
+        std::vector<index_t> out_edge_indices(offsets[num_v]);
+        std::vector<index_t> positions(offsets.begin(), offsets.end() - 1);
+        for (const auto &e: edges) {
+            out_edge_indices[positions[e.source]++] = e.index;
+            if (e.source != e.target) {
+                out_edge_indices[positions[e.target]++] = e.index;
+            }
+        }
+
+        return std::make_pair(ugraph::from_edge_lists(num_v, edges.data(), edges.size(), offsets, out_edge_indices),
+                              array_1d<index_t>(xt::adapt(edge_map, {edge_map.size()})));
+    }
 };
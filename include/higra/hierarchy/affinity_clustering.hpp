@@ -0,0 +1,338 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../sorting.hpp"
+#include "../structure/unionfind.hpp"
+#include "common.hpp"
+#include <atomic>
+
+namespace hg {
+
+    /**
+     * Linkage rules of affinity_clustering
+     */
+    enum class affinity_linkage {
+        single,
+        complete,
+        average
+    };
+
+    namespace affinity_clustering_internal {
+
+        /**
+         * Edges of the graph of the clusters of a round: the linkage value of an edge between two clusters is
+         * value(e) for the single and complete linkages, and value(e) / weight(e) for the average linkage.
+         */
+        struct cluster_edges {
+            std::vector<index_t> sources;
+            std::vector<index_t> targets;
+            std::vector<double> values;
+            std::vector<double> weights;
+
+            index_t size() const {
+                return (index_t) sources.size();
+            }
+
+            void resize(index_t size) {
+                sources.resize(size);
+                targets.resize(size);
+                values.resize(size);
+                weights.resize(size);
+            }
+        };
+
+        inline
+        double linkage_value(const cluster_edges &edges, index_t e, affinity_linkage linkage) {
+            return (linkage == affinity_linkage::average) ? edges.values[e] / edges.weights[e] : edges.values[e];
+        }
+
+        /**
+         * Replaces the extremities of the edges by the labels of their clusters in the next round, removes the
+         * edges inside a cluster, and merges the parallel edges according to the linkage rule. The edges are
+         * sorted in parallel on their pair of extremities.
+         */
+        inline
+        void contract_cluster_edges(cluster_edges &edges,
+                                    const std::vector<index_t> &cluster_label,
+                                    affinity_linkage linkage) {
+            const index_t num_e = edges.size();
+            std::vector<char> kept(num_e);
+            parfor(0, num_e, [&edges, &cluster_label, &kept](index_t e) {
+                auto s = cluster_label[edges.sources[e]];
+                auto t = cluster_label[edges.targets[e]];
+                edges.sources[e] = (std::min)(s, t);
+                edges.targets[e] = (std::max)(s, t);
+                kept[e] = s != t;
+            });
+            std::vector<index_t> order;
+            order.reserve(num_e);
+            for (index_t e = 0; e < num_e; e++) {
+                if (kept[e]) {
+                    order.push_back(e);
+                }
+            }
+            hg::sort(order.begin(), order.end(), [&edges](index_t e1, index_t e2) {
+                return edges.sources[e1] < edges.sources[e2] ||
+                       (edges.sources[e1] == edges.sources[e2] && edges.targets[e1] < edges.targets[e2]);
+            });
+
+            cluster_edges result;
+            result.sources.reserve(order.size());
+            result.targets.reserve(order.size());
+            result.values.reserve(order.size());
+            result.weights.reserve(order.size());
+            for (index_t i = 0; i < (index_t) order.size(); i++) {
+                auto e = order[i];
+                auto last = result.size() - 1;
+                if (last >= 0 && result.sources[last] == edges.sources[e] && result.targets[last] == edges.targets[e]) {
+                    switch (linkage) {
+                        case affinity_linkage::single:
+                            result.values[last] = (std::min)(result.values[last], edges.values[e]);
+                            break;
+                        case affinity_linkage::complete:
+                            result.values[last] = (std::max)(result.values[last], edges.values[e]);
+                            break;
+                        case affinity_linkage::average:
+                            result.values[last] += edges.values[e];
+                            result.weights[last] += edges.weights[e];
+                            break;
+                    }
+                } else {
+                    result.sources.push_back(edges.sources[e]);
+                    result.targets.push_back(edges.targets[e]);
+                    result.values.push_back(edges.values[e]);
+                    result.weights.push_back(edges.weights[e]);
+                }
+            }
+            edges = std::move(result);
+        }
+    }
+
+    /**
+     * Approximate agglomerative clustering computed by rounds of parallel merges: affinity clustering [1] and
+     * Sub-Cluster Component (SCC) clustering [2].
+     *
+     * Contrarily to the binary partition trees (see binary_partition_tree), which merge one pair of clusters at a
+     * time, each round of this algorithm merges all the clusters along the best edge of each cluster (the edge with
+     * the smallest linkage value, ties being broken by edge index): the best edges are searched in parallel, as in
+     * Borůvka's algorithm, and each connected component of the best edges becomes a new node of the hierarchy, whose
+     * altitude is the largest linkage value of the best edges of the component. The graph of the new clusters is then
+     * computed and the linkage values of its edges are updated according to the linkage rule:
+     *
+     *   - single: minimum of the weights of the edges between two clusters;
+     *   - complete: maximum of the weights of the edges between two clusters;
+     *   - average: mean of the weights of the edges between two clusters, weighted by edge_weight_weights.
+     *
+     * The result is thus a non binary hierarchy. As every cluster having a neighbour is merged in each round, the
+     * number of rounds is at most logarithmic in the number of vertices. With the single linkage, the best edges are
+     * edges of the minimum spanning forest of the graph; with the other linkages, the merges are approximations of
+     * the merges of the corresponding binary partition tree.
+     *
+     * If thresholds is not empty, the i-th round only merges the best edges whose linkage value is smaller than or
+     * equal to thresholds(i), as in SCC [2] (the thresholds should be increasing): this limits the merges of
+     * clusters at different scales in a same round. The following rounds are unconstrained affinity rounds.
+     *
+     * The linkage value of a new node may be smaller than the one of one of its children: if altitude_correction is
+     * "max", the altitude of a node is the maximum of the linkage values of the nodes of its subtree (as in
+     * binary_partition_tree_ward_linkage), and if it is "none", the altitudes are the linkage values.
+     *
+     * If the graph is not connected, the roots of the components are finally merged in a root node whose altitude
+     * is the maximal altitude of the other nodes.
+     *
+     * [1] M. Bateni, S. Behnezhad, M. Derakhshan, M. Hajiaghayi, R. Kiveris, S. Lattanzi, and V. Mirrokni,
+     * "Affinity clustering: hierarchical clustering at scale," NeurIPS 2017.
+     *
+     * [2] N. Monath, K. A. Dubey, G. Guruganesh, M. Zaheer, A. Ahmed, A. McCallum, G. Mergen, M. Najork, M. Terzihan,
+     * B. Tjanaka, Y. Wang, and Y. Wu, "Scalable hierarchical agglomerative clustering," KDD 2021.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @tparam T3
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph (dissimilarities)
+     * @param linkage linkage rule
+     * @param xedge_weight_weights weights of the edge weights, used by the average linkage
+     * @param xthresholds thresholds of the first rounds (may be empty)
+     * @param altitude_correction can be "none" or "max"
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T1, typename T2, typename T3>
+    auto affinity_clustering(const graph_t &graph,
+                             const xt::xexpression<T1> &xedge_weights,
+                             affinity_linkage linkage,
+                             const xt::xexpression<T2> &xedge_weight_weights,
+                             const xt::xexpression<T3> &xthresholds,
+                             const std::string &altitude_correction = "max") {
+        HG_TRACE();
+        using namespace affinity_clustering_internal;
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &edge_weight_weights = xedge_weight_weights.derived_cast();
+        auto &thresholds = xthresholds.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        hg_assert_edge_weights(graph, edge_weight_weights);
+        hg_assert_1d_array(edge_weight_weights);
+        hg_assert_1d_array(thresholds);
+        if (altitude_correction != "max" && altitude_correction != "none") {
+            throw std::runtime_error("Invalid altitude_correction mode.");
+        }
+
+        const index_t num_v = num_vertices(graph);
+        const index_t num_e = num_edges(graph);
+
+        cluster_edges edges;
+        edges.resize(num_e);
+        parfor(0, num_e, [&](index_t i) {
+            auto e = edge_from_index(i, graph);
+            edges.sources[i] = source(e, graph);
+            edges.targets[i] = target(e, graph);
+            if (linkage == affinity_linkage::average) {
+                edges.weights[i] = (double) edge_weight_weights(i);
+                edges.values[i] = (double) edge_weights(i) * edges.weights[i];
+            } else {
+                edges.weights[i] = 1;
+                edges.values[i] = (double) edge_weights(i);
+            }
+        });
+
+        std::vector<index_t> parents(num_v);
+        std::iota(parents.begin(), parents.end(), 0);
+        std::vector<double> altitudes(num_v, 0);
+
+        // tree node of each cluster of the current round
+        std::vector<index_t> cluster_node(num_v);
+        std::iota(cluster_node.begin(), cluster_node.end(), 0);
+
+        index_t round = 0;
+        while (edges.size() > 0) {
+            const index_t num_c = cluster_node.size();
+            const bool constrained = round < (index_t) thresholds.size();
+            const double threshold = constrained ? (double) thresholds(round) : 0;
+            round++;
+
+            // best edge of each cluster
+            std::vector<std::atomic<index_t>> best_edge(num_c);
+            parfor(0, num_c, [&best_edge](index_t c) {
+                best_edge[c].store(invalid_index, std::memory_order_relaxed);
+            });
+            auto less = [&edges, linkage](index_t e1, index_t e2) {
+                auto v1 = linkage_value(edges, e1, linkage);
+                auto v2 = linkage_value(edges, e2, linkage);
+                return v1 < v2 || (!(v2 < v1) && e1 < e2);
+            };
+            parfor(0, edges.size(), [&](index_t e) {
+                if (constrained && linkage_value(edges, e, linkage) > threshold) {
+                    return;
+                }
+                for (auto c: {edges.sources[e], edges.targets[e]}) {
+                    auto current = best_edge[c].load();
+                    while ((current == invalid_index || less(e, current)) &&
+                           !best_edge[c].compare_exchange_weak(current, e));
+                }
+            });
+
+            // the best edges form a forest: its trees are the clusters of the next round
+            union_find uf(num_c);
+            std::vector<char> component_merged(num_c, false);
+            std::vector<double> component_value(num_c);
+            bool merged = false;
+            for (index_t c = 0; c < num_c; c++) {
+                auto e = best_edge[c].load();
+                if (e == invalid_index) {
+                    continue;
+                }
+                auto r1 = uf.find(edges.sources[e]);
+                auto r2 = uf.find(edges.targets[e]);
+                auto value = linkage_value(edges, e, linkage);
+                if (r1 != r2) {
+                    auto r = uf.link(r1, r2);
+                    double v1 = component_merged[r1] ? component_value[r1] : value;
+                    double v2 = component_merged[r2] ? component_value[r2] : value;
+                    component_value[r] = (std::max)({v1, v2, value});
+                    component_merged[r] = true;
+                    merged = true;
+                } else {
+                    component_value[r1] = (std::max)(component_value[r1], value);
+                }
+            }
+            if (!merged) {
+                continue;
+            }
+
+            // a new node is created for each tree with at least two clusters
+            std::vector<index_t> cluster_label(num_c);
+            std::vector<index_t> component_label(num_c, invalid_index);
+            std::vector<index_t> new_cluster_node;
+            for (index_t c = 0; c < num_c; c++) {
+                auto r = uf.find(c);
+                if (component_label[r] == invalid_index) {
+                    component_label[r] = new_cluster_node.size();
+                    if (component_merged[r]) {
+                        new_cluster_node.push_back(parents.size());
+                        parents.push_back(parents.size());
+                        altitudes.push_back(component_value[r]);
+                    } else {
+                        new_cluster_node.push_back(cluster_node[c]);
+                    }
+                }
+                cluster_label[c] = component_label[r];
+                if (component_merged[r]) {
+                    parents[cluster_node[c]] = new_cluster_node[cluster_label[c]];
+                }
+            }
+
+            contract_cluster_edges(edges, cluster_label, linkage);
+            cluster_node = std::move(new_cluster_node);
+        }
+
+        if (cluster_node.size() > 1) {
+            // the graph is not connected
+            auto root_node = (index_t) parents.size();
+            parents.push_back(root_node);
+            altitudes.push_back(*std::max_element(altitudes.begin(), altitudes.end()));
+            for (auto n: cluster_node) {
+                parents[n] = root_node;
+            }
+        }
+
+        array_1d<double> res_altitudes = xt::adapt(altitudes, {altitudes.size()});
+        hg::tree res_tree(xt::adapt(parents, {parents.size()}));
+        if (altitude_correction == "max") {
+            for (auto i: leaves_to_root_iterator(res_tree, leaves_it::include, root_it::exclude)) {
+                res_altitudes(parent(i, res_tree)) = (std::max)(res_altitudes(i), res_altitudes(parent(i, res_tree)));
+            }
+        }
+        return make_node_weighted_tree(std::move(res_tree), std::move(res_altitudes));
+    }
+
+    /**
+     * Affinity clustering without edge weight weights and thresholds (see affinity_clustering).
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph (dissimilarities)
+     * @param linkage linkage rule
+     * @param altitude_correction can be "none" or "max"
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T>
+    auto affinity_clustering(const graph_t &graph,
+                             const xt::xexpression<T> &xedge_weights,
+                             affinity_linkage linkage = affinity_linkage::single,
+                             const std::string &altitude_correction = "max") {
+        return affinity_clustering(graph, xedge_weights, linkage, xt::ones<double>({num_edges(graph)}),
+                                   array_1d<double>::from_shape({0}), altitude_correction);
+    }
+}
@@ -14,9 +14,15 @@
 #include "../graph.hpp"
 #include "hierarchy_core.hpp"
 #include "../structure/fibonacci_heap.hpp"
+#include "../structure/indexed_heap.hpp"
+#include "../detail/simd_dispatch.hpp"
+#include "../detail/fixed_width.hpp"
 #include "xtensor/xview.hpp"
 #include "xtensor/xnoalias.hpp"
+#include <xsimd/xsimd.hpp>
 #include <string>
+#include <queue>
+#include <numeric>
 
 namespace hg {
 
@@ -293,6 +299,12 @@ namespace hg {
        *      d(X,Y) = (1 / Z) + sum_{x in X, y in Y, {x,y} in G} W({x,y}) x exp(alpha * V({x,y})) x V({x,y})
        * with Z = sum_{x in X, y in Y, {x,y} in G} W({x,y}) x exp(alpha * V({x,y}))
        *
+       * The state of an edge is computed in the log domain: the distance d(X,Y) itself (a weighted mean of
+       * values) and log(Z). Two states are merged with a log-sum-exp, in which the exponential of the difference
+       * of the two log(Z) is at most 1: no overflow nor underflow can occur, whatever alpha and the range of the values,
+       * and the state can be stored in the value type of the input (for example float32). If alpha is infinite, the
+       * distance is the maximum (alpha = +infinity) or the minimum (alpha = -infinity) of the values.
+       *
        * @tparam T
        */
         template<typename T>
@@ -300,20 +312,34 @@ namespace hg {
             using value_type = typename T::value_type;
 
             array_1d<value_type> m_values;
-            array_1d<value_type> m_weights;
+            array_1d<value_type> m_log_weights;
             value_type m_alpha;
 
             binary_partition_tree_exponential_linkage_weighting_functor(
                     const xt::xexpression<T> &xvalues,
                     const xt::xexpression<T> &xweights,
-                    const value_type &alpha)
-                    : m_alpha(alpha) {
-                auto &values = xvalues.derived_cast();
-                auto &weights = xweights.derived_cast();
-                hg_assert_same_shape(values, weights);
+                    const value_type &alpha) :
+                    binary_partition_tree_exponential_linkage_weighting_functor(
+                            xvalues, array_1d<value_type>(xt::log(xweights.derived_cast())), alpha) {
+            }
 
-                m_weights = weights * xt::exp(alpha * values);
-                m_values = m_weights * values;
+            /**
+             * Initialize the clustering with the logarithms of the weights of the edges (shared by several runs of
+             * the clustering with different alphas)
+             */
+            template<typename T2>
+            binary_partition_tree_exponential_linkage_weighting_functor(
+                    const xt::xexpression<T> &xvalues,
+                    const T2 &log_weights,
+                    const value_type &alpha)
+                    : m_values(xvalues), m_alpha(alpha) {
+                hg_assert_same_shape(m_values, log_weights);
+                if (std::isinf(m_alpha)) {
+                    // the log of the weight is only used to select the largest or the smallest value
+                    m_log_weights = (m_alpha > 0) ? m_values : xt::eval(-m_values);
+                } else {
+                    m_log_weights = log_weights + m_alpha * m_values;
+                }
             }
 
             template<typename graph_t, typename neighbours_t>
@@ -325,34 +351,111 @@ namespace hg {
                             neighbours_t &new_neighbours) {
 
                 for (auto &n: new_neighbours) {
-                    value_type new_value;
-                    value_type new_weight;
+                    value_type new_value = m_values[n.first_edge_index()];
+                    value_type new_log_weight = m_log_weights[n.first_edge_index()];
                     if (n.num_edges() > 1) {
-                        new_weight = m_weights[n.first_edge_index()] + m_weights[n.second_edge_index()];
-                        new_value = (m_values[n.first_edge_index()] + m_values[n.second_edge_index()]);
-                    } else {
-                        new_weight = m_weights[n.first_edge_index()];
-                        new_value = m_values[n.first_edge_index()];
+                        merge(new_value, new_log_weight,
+                              m_values[n.second_edge_index()], m_log_weights[n.second_edge_index()]);
                     }
-                    n.new_edge_weight() = new_value / new_weight;
+                    n.new_edge_weight() = new_value;
                     m_values[n.new_edge_index()] = new_value;
-                    m_weights[n.new_edge_index()] = new_weight;
+                    m_log_weights[n.new_edge_index()] = new_log_weight;
+                }
+            }
+
+        private:
+
+            /**
+             * Merges the state (value2, log_weight2) into the state (value1, log_weight1)
+             */
+            void merge(value_type &value1, value_type &log_weight1, value_type value2, value_type log_weight2) const {
+                if (log_weight1 < log_weight2) {
+                    std::swap(value1, value2);
+                    std::swap(log_weight1, log_weight2);
                 }
+                if (std::isinf(m_alpha) || log_weight1 == -std::numeric_limits<value_type>::infinity()) {
+                    // limit cases: value of largest log weight, or both weights equal to 0
+                    if (log_weight1 == log_weight2) {
+                        value1 = (value1 + value2) / 2;
+                    }
+                    return;
+                }
+                // ratio of the two weights, in [0, 1]
+                value_type ratio = std::exp(log_weight2 - log_weight1);
+                value1 = (value1 + ratio * value2) / (1 + ratio);
+                log_weight1 += std::log1p(ratio);
             }
         };
 
+        /**
+         * Number of values of a block of the padded centroid rows of the Ward linkage (64 bytes)
+         */
+        template<typename value_t>
+        struct ward_centroid_block : public std::integral_constant<index_t, 64 / sizeof(value_t)> {
+        };
+
+        /**
+         * Squared euclidean distance between the vectors a and b of the given size, which must be a multiple of
+         * ward_centroid_block<value_t>::value: the squared differences are accumulated in one partial sum per
+         * position in the block, which vectorizes without reordering floating point operations inside a sum.
+         */
+#if !defined(HG_HAS_SIMD_DISPATCH) && defined(XTENSOR_USE_XSIMD)
+        template<typename value_t>
+        double squared_euclidean_distance_blocks(const value_t *a, const value_t *b, index_t size) {
+            using batch_t = xsimd::simd_type<value_t>;
+            constexpr index_t batch_size = xsimd::simd_traits<value_t>::size;
+            batch_t acc((value_t) 0);
+            for (index_t k = 0; k < size; k += batch_size) {
+                batch_t d = xsimd::load_unaligned(a + k) - xsimd::load_unaligned(b + k);
+                acc += d * d;
+            }
+            return (double) xsimd::hadd(acc);
+        }
+#else
+
+        template<typename value_t>
+        HG_SIMD_DISPATCH
+        double squared_euclidean_distance_blocks(const value_t *a, const value_t *b, index_t size) {
+            constexpr index_t block_size = ward_centroid_block<value_t>::value;
+            value_t acc[block_size] = {};
+            for (index_t k = 0; k < size; k += block_size) {
+                for (index_t j = 0; j < block_size; j++) {
+                    value_t d = a[k + j] - b[k + j];
+                    acc[j] += d * d;
+                }
+            }
+            double r = 0;
+            for (index_t j = 0; j < block_size; j++) {
+                r += acc[j];
+            }
+            return r;
+        }
+
+#endif
+
         /**
        * Weighting function to be used in conjunction to the binary_partition_tree method in order to perform a Ward linkage clustering.
        *
+       * The centroids are stored row by row in a single buffer, in single precision if the vertex centroids are in
+       * single precision and in double precision otherwise. If the dimension of the centroids is at least the size
+       * of a block (see ward_centroid_block), the rows are padded with zeros to a multiple of the block size and
+       * the distances are computed with the vectorized kernel squared_euclidean_distance_blocks, otherwise with a
+       * kernel specialized for the common small dimensions (see dispatch_fixed_width).
+       *
        * @tparam T
        */
         template<typename T1, typename T2>
         struct binary_partition_tree_ward_linkage_weighting_functor {
 
         private:
+            using centroid_t = typename std::conditional<
+                    std::is_same<typename T1::value_type, float>::value, float, double>::type;
+
             array_1d<double> m_sizes;
-            array_2d<double> m_centroids;
+            array_1d<centroid_t> m_centroids;
             index_t m_dim;
+            // number of values of a centroid row
+            index_t m_stride;
 
         public:
 
@@ -369,21 +472,30 @@ namespace hg {
 
                 auto num_elem = vertex_sizes.size() * 2 - 1;
                 m_dim = vertex_centroids.shape(1);
+                const index_t block_size = ward_centroid_block<centroid_t>::value;
+                m_stride = (m_dim < block_size) ? m_dim : ((m_dim + block_size - 1) / block_size) * block_size;
 
                 m_sizes = xt::empty<double>({num_elem});
                 xt::noalias(xt::view(m_sizes, xt::range(0, vertex_sizes.size()))) = vertex_sizes;
-                m_centroids = xt::empty<double>({num_elem, vertex_centroids.shape(1)});
-                xt::noalias(
-                        xt::view(m_centroids, xt::range(0, vertex_centroids.shape(0)), xt::all())) = vertex_centroids;
-
+                m_centroids = xt::zeros<centroid_t>({num_elem * m_stride});
+                const index_t num_v = vertex_centroids.shape(0);
+                const index_t dim = m_dim;
+                const index_t stride = m_stride;
+                centroid_t *centroids = m_centroids.data();
+                parfor(0, num_v, [&vertex_centroids, centroids, dim, stride](index_t i) {
+                    for (index_t k = 0; k < dim; k++) {
+                        centroids[i * stride + k] = (centroid_t) vertex_centroids(i, k);
+                    }
+                });
             }
 
             template<typename graph_t>
             auto get_weights(const graph_t &graph) {
                 array_1d<double> weights = xt::empty<double>({num_edges(graph)});
-                for (auto e: edge_iterator(graph)) {
-                    weights(e) = cluster_distance(source(e, graph), target(e, graph));
-                }
+                parfor(0, (index_t) num_edges(graph), [this, &graph, &weights](index_t i) {
+                    auto e = edge_from_index(i, graph);
+                    weights(i) = cluster_distance(source(e, graph), target(e, graph));
+                });
                 return weights;
             };
 
@@ -401,12 +513,14 @@ namespace hg {
                 auto new_size = n1 + n2;
                 m_sizes(new_region) = new_size;
 
-                for (index_t k = 0; k < m_dim; k++) {
-                    m_centroids(new_region, k) =
-                            (n1 * m_centroids(merged_region1, k) +
-                             n2 * m_centroids(merged_region2, k)) / new_size;
+                centroid_t *c = centroid(new_region);
+                const centroid_t *c1 = centroid(merged_region1);
+                const centroid_t *c2 = centroid(merged_region2);
+                for (index_t k = 0; k < m_stride; k++) {
+                    c[k] = (centroid_t) ((n1 * c1[k] + n2 * c2[k]) / new_size);
                 }
 
+                // the new centroid stays in cache while the distances to all the new neighbours are computed
                 for (auto &n: new_neighbours) {
                     double new_weight = cluster_distance(new_region, n.neighbour_vertex());
 
@@ -415,25 +529,843 @@ namespace hg {
             }
 
         private:
-            auto cluster_distance(index_t ci, index_t cj) {
+            centroid_t *centroid(index_t ci) {
+                return m_centroids.data() + ci * m_stride;
+            }
+
+            double cluster_distance(index_t ci, index_t cj) {
                 auto si = m_sizes(ci);
                 auto sj = m_sizes(cj);
                 return (si * sj) * squared_cluster_euclidean_distance(ci, cj) / (si + sj);
             }
 
-            auto squared_cluster_euclidean_distance(index_t ci, index_t cj) {
-                double r = 0;
-                for (index_t k = 0; k < m_dim; k++) {
-                    double tmp = m_centroids(ci, k) - m_centroids(cj, k);
-                    r += tmp * tmp;
+            double squared_cluster_euclidean_distance(index_t ci, index_t cj) {
+                const centroid_t *a = centroid(ci);
+                const centroid_t *b = centroid(cj);
+                if (m_stride >= ward_centroid_block<centroid_t>::value) {
+                    return squared_euclidean_distance_blocks(a, b, m_stride);
+                }
+                // the dimension is the same for all the calls: the branch of the dispatch is predicted
+                return dispatch_fixed_width(m_dim, [a, b](auto dim) {
+                    double r = 0;
+                    for (index_t k = 0; k < (index_t) dim; k++) {
+                        double tmp = (double) a[k] - (double) b[k];
+                        r += tmp * tmp;
+                    }
+                    return r;
+                });
+            }
+        };
+
+        /**
+         * Heap policy of the region adjacency engine: Fibonacci heap with one handle per edge.
+         */
+        struct fibonacci_heap_policy {
+            template<typename T>
+            struct heap {
+                heap(size_t capacity) : m_handles(capacity, nullptr) {}
+
+                bool empty() const {
+                    return m_heap.empty();
+                }
+
+                void push(index_t key, const T &value) {
+                    m_handles[key] = m_heap.push({value, key});
+                }
+
+                index_t top() {
+                    return m_heap.top()->get_value().index;
+                }
+
+                T top_value() {
+                    return m_heap.top()->get_value().value;
+                }
+
+                void pop() {
+                    m_handles[top()] = nullptr;
+                    m_heap.pop();
+                }
+
+                void erase(index_t key) {
+                    m_heap.erase(m_handles[key]);
+                    m_handles[key] = nullptr;
+                }
+
+                void update(index_t key, const T &value) {
+                    m_heap.update(m_handles[key], {value, key});
+                }
+
+            private:
+                using heap_t = fibonacci_heap<heap_element<T>>;
+                heap_t m_heap;
+                std::vector<typename heap_t::value_handle> m_handles;
+            };
+        };
+
+        /**
+         * Heap policy of the region adjacency engine: indexed d-ary heap stored in a flat array.
+         *
+         * @tparam arity
+         */
+        template<index_t arity>
+        struct dary_heap_policy {
+            template<typename T>
+            struct heap : public indexed_dary_heap<T, arity> {
+                heap(size_t capacity) : indexed_dary_heap<T, arity>(capacity) {}
+            };
+        };
+
+        /**
+         * Heap policy of the region adjacency engine: indexed pairing heap stored in flat arrays.
+         */
+        struct pairing_heap_policy {
+            template<typename T>
+            struct heap : public indexed_pairing_heap<T> {
+                heap(size_t capacity) : indexed_pairing_heap<T>(capacity) {}
+            };
+        };
+
+        /**
+         * Nearest-neighbour chain engine policy (see binary_partition_tree_nn_chain).
+         */
+        struct nn_chain_policy {
+        };
+
+        /**
+         * Region adjacency graph stored in flat arrays, used by the linkage based binary partition tree engines.
+         *
+         * The region adjacency graph is not stored in an undirected_graph<hash_setS> but in flat arrays: the
+         * extremities of each edge and, for each region, a range in a single array of edge indices listing the edges
+         * incident to the region. When two regions are merged, the edges linking the new region to its neighbours are
+         * appended at the end of the array. Edges removed from the graph are only marked as dead: they are lazily
+         * skipped while exploring the adjacency list of a region, and the array is compacted when more than half of its
+         * entries are not used anymore.
+         *
+         * The regions are the vertices of the input graph (leaves) followed by the regions created by successive
+         * merges (region of index num_vertices(graph) + i is created by the i-th merge).
+         */
+        struct region_adjacency_graph {
+
+            template<typename graph_t>
+            region_adjacency_graph(const graph_t &graph) {
+                index_t num_points = num_vertices(graph);
+                index_t num_regions = (num_points > 0) ? num_points * 2 - 1 : 0;
+                index_t num_e = hg::num_edges(graph);
+                m_num_regions = num_points;
+
+                m_sources.resize(num_e);
+                m_targets.resize(num_e);
+                m_alive.resize(num_e, true);
+                m_adjacency_begin.resize(num_regions + 1, 0);
+                m_adjacency_end.resize(num_regions, 0);
+                m_new_neighbour_indices.resize(num_regions, invalid_index);
+
+                for (index_t i = 0; i < num_e; i++) {
+                    auto e = edge_from_index(i, graph);
+                    m_sources[i] = hg::source(e, graph);
+                    m_targets[i] = hg::target(e, graph);
+                    m_adjacency_begin[m_sources[i] + 1]++;
+                    if (m_sources[i] != m_targets[i]) {
+                        m_adjacency_begin[m_targets[i] + 1]++;
+                    }
+                }
+                for (index_t v = 0; v < num_points; v++) {
+                    m_adjacency_begin[v + 1] += m_adjacency_begin[v];
+                }
+                m_adjacency.resize(m_adjacency_begin[num_points]);
+                std::copy(m_adjacency_begin.begin(), m_adjacency_begin.begin() + num_points, m_adjacency_end.begin());
+                for (index_t i = 0; i < num_e; i++) {
+                    m_adjacency[m_adjacency_end[m_sources[i]]++] = i;
+                    if (m_sources[i] != m_targets[i]) {
+                        m_adjacency[m_adjacency_end[m_targets[i]]++] = i;
+                    }
+                }
+                m_compaction_threshold = (std::max)(2 * m_adjacency.size(), (size_t) 1024);
+            }
+
+            index_t num_regions() const {
+                return m_num_regions;
+            }
+
+            index_t num_edges() const {
+                return m_sources.size();
+            }
+
+            index_t source(index_t edge) const {
+                return m_sources[edge];
+            }
+
+            index_t target(index_t edge) const {
+                return m_targets[edge];
+            }
+
+            bool alive(index_t edge) const {
+                return m_alive[edge];
+            }
+
+            void remove_edge(index_t edge) {
+                m_alive[edge] = false;
+            }
+
+            /**
+             * The edges incident to the given region are stored at the positions adjacency_begin(region) ...
+             * adjacency_end(region) - 1 of the adjacency array (removed edges included).
+             */
+            index_t adjacency_begin(index_t region) const {
+                return m_adjacency_begin[region];
+            }
+
+            index_t adjacency_end(index_t region) const {
+                return m_adjacency_end[region];
+            }
+
+            index_t adjacency(index_t position) const {
+                return m_adjacency[position];
+            }
+
+            /**
+             * Calls fun(e, n) for every edge e linking the given region to a region n.
+             */
+            template<typename fun_t>
+            void for_each_edge(index_t region, fun_t fun) const {
+                for (index_t p = m_adjacency_begin[region]; p < m_adjacency_end[region]; p++) {
+                    auto e = m_adjacency[p];
+                    if (m_alive[e]) {
+                        fun(e, (m_sources[e] == region) ? m_targets[e] : m_sources[e]);
+                    }
+                }
+            }
+
+            /**
+             * Store in new_neighbours the neighbours of the union of the two given regions. The remaining edges linking
+             * region1 and region2 (multiple edges) are removed and removed_edge(e) is called for each of them.
+             */
+            template<typename neighbours_t, typename callback_t>
+            void collect_neighbours(index_t region1,
+                                    index_t region2,
+                                    neighbours_t &new_neighbours,
+                                    callback_t removed_edge) {
+                new_neighbours.clear();
+                auto explore_region = [this, &new_neighbours, &removed_edge](index_t region, index_t other_region) {
+                    for (index_t p = m_adjacency_begin[region]; p < m_adjacency_end[region]; p++) {
+                        auto e = m_adjacency[p];
+                        if (!m_alive[e]) {
+                            continue;
+                        }
+                        auto n = (m_sources[e] == region) ? m_targets[e] : m_sources[e];
+                        if (n != other_region) {
+                            if (m_new_neighbour_indices[n] != invalid_index) {
+                                new_neighbours[m_new_neighbour_indices[n]].second_edge_index() = e;
+                            } else {
+                                m_new_neighbour_indices[n] = new_neighbours.size();
+                                new_neighbours.emplace_back(n, e);
+                            }
+                        } else { // may happen with multiple edges
+                            m_alive[e] = false;
+                            removed_edge(e);
+                        }
+                    }
+                };
+                explore_region(region1, region2);
+                explore_region(region2, region1);
+                for (auto &n: new_neighbours) {
+                    m_new_neighbour_indices[n.neighbour_vertex()] = invalid_index;
+                }
+            }
+
+            /**
+             * Create a new region, union of region1 and region2, whose neighbours are given by new_neighbours (see
+             * collect_neighbours): for each neighbour, the second edge is removed (removed_edge(e) is called) and the
+             * first edge now links the neighbour and the new region.
+             *
+             * @return index of the new region
+             */
+            template<typename neighbours_t, typename callback_t>
+            index_t merge_regions(index_t region1,
+                                  index_t region2,
+                                  const neighbours_t &new_neighbours,
+                                  callback_t removed_edge) {
+                auto new_region = m_num_regions++;
+                // the adjacency lists of region1 and region2 are not used anymore
+                m_adjacency_end[region1] = m_adjacency_begin[region1];
+                m_adjacency_end[region2] = m_adjacency_begin[region2];
+                if (m_adjacency.size() + new_neighbours.size() > m_compaction_threshold) {
+                    compact(new_region);
+                }
+
+                m_adjacency_begin[new_region] = m_adjacency.size();
+                for (auto &nn: new_neighbours) {
+                    if (nn.num_edges() > 1) {
+                        m_alive[nn.second_edge_index()] = false;
+                        removed_edge(nn.second_edge_index());
+                    }
+                    auto e = nn.first_edge_index();
+                    m_sources[e] = nn.neighbour_vertex();
+                    m_targets[e] = new_region;
+                    m_adjacency.push_back(e);
+                }
+                m_adjacency_end[new_region] = m_adjacency.size();
+                return new_region;
+            }
+
+        private:
+
+            // copy the live entries of the adjacency lists at the beginning of the array
+            void compact(index_t num_regions) {
+                index_t position = 0;
+                for (index_t r = 0; r < num_regions; r++) {
+                    auto begin = m_adjacency_begin[r];
+                    m_adjacency_begin[r] = position;
+                    for (index_t p = begin; p < m_adjacency_end[r]; p++) {
+                        if (m_alive[m_adjacency[p]]) {
+                            m_adjacency[position++] = m_adjacency[p];
+                        }
+                    }
+                    m_adjacency_end[r] = position;
+                }
+                m_adjacency.resize(position);
+                m_compaction_threshold = (std::max)(2 * m_adjacency.size(), (size_t) 1024);
+            }
+
+            index_t m_num_regions;
+
+            // edges of the region adjacency graph
+            std::vector<index_t> m_sources;
+            std::vector<index_t> m_targets;
+            std::vector<char> m_alive;
+
+            // adjacency lists: the edges incident to the region r are stored in
+            // adjacency[adjacency_begin[r]] ... adjacency[adjacency_end[r] - 1]
+            std::vector<index_t> m_adjacency_begin;
+            std::vector<index_t> m_adjacency_end;
+            std::vector<index_t> m_adjacency;
+            size_t m_compaction_threshold;
+
+            // optimization to detect already visited neighbours during neighbour search
+            std::vector<index_t> m_new_neighbour_indices;
+        };
+    }
+
+    namespace region_adjacency_graph_view_internal {
+
+        using binary_partition_tree_internal::region_adjacency_graph;
+
+        /**
+         * Read only view of the current state of a region_adjacency_graph with the interface of an undirected graph:
+         * this is the graph given to the weighting functions by the binary partition tree engines.
+         *
+         * Its vertices are the regions created so far, and its edges have the indices of the edges of the input graph.
+         * An edge removed from the region adjacency graph has no extremities anymore (its source and target are equal
+         * to invalid_index), and it does not appear in the adjacency of any region.
+         */
+        struct region_adjacency_graph_view {
+
+            using vertex_descriptor = index_t;
+            using edge_index_t = index_t;
+            using edge_descriptor = indexed_edge<vertex_descriptor, edge_index_t>;
+            using directed_category = graph::undirected_tag;
+            using edge_parallel_category = graph::allow_parallel_edge_tag;
+            using traversal_category = undirected_graph_internal::undirected_graph_traversal_category;
+            using vertex_iterator = counting_iterator<vertex_descriptor>;
+            using vertices_size_type = size_t;
+            using edges_size_type = size_t;
+            using degree_size_type = size_t;
+
+            /**
+             * Iterator on the indices of the edges incident to a region, the removed edges are skipped.
+             */
+            struct incident_edge_index_iterator :
+                    public forward_iterator_facade<incident_edge_index_iterator, edge_index_t> {
+
+                incident_edge_index_iterator() : m_rag(nullptr), m_position(0), m_end(0) {}
+
+                incident_edge_index_iterator(const region_adjacency_graph *rag, index_t position, index_t end) :
+                        m_rag(rag), m_position(position), m_end(end) {
+                    skip_removed_edges();
+                }
+
+                void increment() {
+                    m_position++;
+                    skip_removed_edges();
+                }
+
+                bool equal(const incident_edge_index_iterator &other) const {
+                    return m_position == other.m_position;
+                }
+
+                edge_index_t dereference() const {
+                    return m_rag->adjacency(m_position);
+                }
+
+            private:
+                void skip_removed_edges() {
+                    while (m_position < m_end && !m_rag->alive(m_rag->adjacency(m_position))) {
+                        m_position++;
+                    }
+                }
+
+                const region_adjacency_graph *m_rag;
+                index_t m_position;
+                index_t m_end;
+            };
+
+            template<bool in_edge>
+            struct incident_edge_transform {
+                vertex_descriptor vertex;
+                const region_adjacency_graph *rag;
+
+                edge_descriptor operator()(edge_index_t ei) const {
+                    auto other = (vertex == rag->source(ei)) ? rag->target(ei) : rag->source(ei);
+                    return in_edge ? edge_descriptor(other, vertex, ei) : edge_descriptor(vertex, other, ei);
+                }
+            };
+
+            struct adjacent_vertex_transform {
+                vertex_descriptor vertex;
+                const region_adjacency_graph *rag;
+
+                vertex_descriptor operator()(edge_index_t ei) const {
+                    return (vertex == rag->source(ei)) ? rag->target(ei) : rag->source(ei);
+                }
+            };
+
+            struct edge_transform {
+                const region_adjacency_graph_view *graph;
+
+                edge_descriptor operator()(edge_index_t ei) const {
+                    return graph->edge_from_index(ei);
+                }
+            };
+
+            using out_edge_iterator = transform_forward_iterator<incident_edge_transform<false>,
+                    incident_edge_index_iterator, edge_descriptor>;
+            using in_edge_iterator = transform_forward_iterator<incident_edge_transform<true>,
+                    incident_edge_index_iterator, edge_descriptor>;
+            using adjacency_iterator = transform_forward_iterator<adjacent_vertex_transform,
+                    incident_edge_index_iterator, vertex_descriptor>;
+            using edge_iterator = transform_forward_iterator<edge_transform,
+                    counting_iterator<edge_index_t>, edge_descriptor>;
+
+            region_adjacency_graph_view(const region_adjacency_graph &rag) : m_rag(&rag) {}
+
+            size_t num_vertices() const {
+                return m_rag->num_regions();
+            }
+
+            size_t num_edges() const {
+                return m_rag->num_edges();
+            }
+
+            edge_descriptor edge_from_index(edge_index_t ei) const {
+                if (m_rag->alive(ei)) {
+                    return edge_descriptor(m_rag->source(ei), m_rag->target(ei), ei);
                 }
-                return r;
+                return edge_descriptor(invalid_index, invalid_index, ei);
+            }
+
+            incident_edge_index_iterator incident_edges_cbegin(vertex_descriptor v) const {
+                return incident_edge_index_iterator(m_rag, m_rag->adjacency_begin(v), m_rag->adjacency_end(v));
+            }
+
+            incident_edge_index_iterator incident_edges_cend(vertex_descriptor v) const {
+                return incident_edge_index_iterator(m_rag, m_rag->adjacency_end(v), m_rag->adjacency_end(v));
+            }
+
+            size_t degree(vertex_descriptor v) const {
+                return std::distance(incident_edges_cbegin(v), incident_edges_cend(v));
+            }
+
+            const region_adjacency_graph &rag() const {
+                return *m_rag;
             }
+
+        private:
+            const region_adjacency_graph *m_rag;
         };
 
+        inline auto edge_from_index(index_t ei, const region_adjacency_graph_view &g) {
+            return g.edge_from_index(ei);
+        }
+
+        inline size_t num_vertices(const region_adjacency_graph_view &g) {
+            return g.num_vertices();
+        }
+
+        inline size_t num_edges(const region_adjacency_graph_view &g) {
+            return g.num_edges();
+        }
+
+        inline size_t degree(index_t v, const region_adjacency_graph_view &g) {
+            return g.degree(v);
+        }
+
+        inline size_t in_degree(index_t v, const region_adjacency_graph_view &g) {
+            return g.degree(v);
+        }
+
+        inline size_t out_degree(index_t v, const region_adjacency_graph_view &g) {
+            return g.degree(v);
+        }
+
+        inline auto vertices(const region_adjacency_graph_view &g) {
+            using it = region_adjacency_graph_view::vertex_iterator;
+            return std::make_pair(it(0), it(g.num_vertices()));
+        }
+
+        inline auto edges(const region_adjacency_graph_view &g) {
+            using it = region_adjacency_graph_view::edge_iterator;
+            region_adjacency_graph_view::edge_transform fun{&g};
+            return std::make_pair(it(counting_iterator<index_t>(0), fun),
+                                  it(counting_iterator<index_t>(g.num_edges()), fun));
+        }
+
+        inline auto out_edges(index_t v, const region_adjacency_graph_view &g) {
+            using it = region_adjacency_graph_view::out_edge_iterator;
+            region_adjacency_graph_view::incident_edge_transform<false> fun{v, &g.rag()};
+            return std::make_pair(it(g.incident_edges_cbegin(v), fun), it(g.incident_edges_cend(v), fun));
+        }
 
+        inline auto in_edges(index_t v, const region_adjacency_graph_view &g) {
+            using it = region_adjacency_graph_view::in_edge_iterator;
+            region_adjacency_graph_view::incident_edge_transform<true> fun{v, &g.rag()};
+            return std::make_pair(it(g.incident_edges_cbegin(v), fun), it(g.incident_edges_cend(v), fun));
+        }
+
+        inline auto adjacent_vertices(index_t v, const region_adjacency_graph_view &g) {
+            using it = region_adjacency_graph_view::adjacency_iterator;
+            region_adjacency_graph_view::adjacent_vertex_transform fun{v, &g.rag()};
+            return std::make_pair(it(g.incident_edges_cbegin(v), fun), it(g.incident_edges_cend(v), fun));
+        }
+    }
+
+    namespace graph {
+        template<>
+        struct graph_traits<region_adjacency_graph_view_internal::region_adjacency_graph_view> {
+            using G = region_adjacency_graph_view_internal::region_adjacency_graph_view;
+
+            using vertex_descriptor = typename G::vertex_descriptor;
+            using edge_descriptor = typename G::edge_descriptor;
+            using edge_iterator = typename G::edge_iterator;
+            using out_edge_iterator = typename G::out_edge_iterator;
+
+            using directed_category = typename G::directed_category;
+            using edge_parallel_category = typename G::edge_parallel_category;
+            using traversal_category = typename G::traversal_category;
+
+            using degree_size_type = typename G::degree_size_type;
+
+            using in_edge_iterator = typename G::in_edge_iterator;
+            using vertex_iterator = typename G::vertex_iterator;
+            using vertices_size_type = typename G::vertices_size_type;
+            using edges_size_type = typename G::edges_size_type;
+            using adjacency_iterator = typename G::adjacency_iterator;
+
+            using edge_index = typename G::edge_index_t;
+        };
+    }
+
+    // graph functions of region_adjacency_graph_view are also available as qualified names (hg::num_vertices...)
+    using region_adjacency_graph_view_internal::edge_from_index;
+    using region_adjacency_graph_view_internal::num_vertices;
+    using region_adjacency_graph_view_internal::num_edges;
+    using region_adjacency_graph_view_internal::degree;
+    using region_adjacency_graph_view_internal::in_degree;
+    using region_adjacency_graph_view_internal::out_degree;
+    using region_adjacency_graph_view_internal::vertices;
+    using region_adjacency_graph_view_internal::edges;
+    using region_adjacency_graph_view_internal::out_edges;
+    using region_adjacency_graph_view_internal::in_edges;
+    using region_adjacency_graph_view_internal::adjacent_vertices;
+
+    namespace binary_partition_tree_internal {
+
+        using region_adjacency_graph_view_internal::region_adjacency_graph_view;
+
+        /**
+         * Binary partition tree engine based on a global priority queue of the edges of a flat region adjacency graph.
+         *
+         * Edges are ordered in the heap by increasing weight, ties are broken by the heap policy (increasing edge index
+         * for dary_heap_policy).
+         *
+         * The weighting function is called with the same arguments as the one of the function binary_partition_tree:
+         * its first argument is a region_adjacency_graph_view of the current region adjacency graph.
+         *
+         * @tparam heap_policy_t fibonacci_heap_policy, dary_heap_policy, or pairing_heap_policy
+         * @tparam graph_t
+         * @tparam weighter
+         * @tparam T
+         * @param graph input graph
+         * @param xedge_weights initial edge weights
+         * @param weight_function weighting function
+         * @return a node weighted tree
+         */
+        template<typename heap_policy_t, typename graph_t, typename weighter, typename T>
+        auto binary_partition_tree_region_adjacency(const graph_t &graph,
+                                                    const xt::xexpression<T> &xedge_weights,
+                                                    weighter weight_function) {
+            using weight_t = typename T::value_type;
+            using heap_t = typename heap_policy_t::template heap<weight_t>;
+
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_edge_weights(graph, edge_weights);
+
+            index_t num_points = num_vertices(graph);
+            index_t num_nodes_tree = (num_points > 0) ? num_points * 2 - 1 : 0;
+            index_t num_e = num_edges(graph);
+
+            array_1d<index_t> parents = xt::arange(num_nodes_tree);
+            array_1d<weight_t> levels = xt::zeros<weight_t>({(size_t) num_nodes_tree});
+
+            region_adjacency_graph rag(graph);
+
+            // special structure to store the list of neighbours adjacent to the fused regions.
+            std::vector<new_neighbour<weight_t> > new_neighbours;
+            const decltype(new_neighbours) &const_new_neighbours = new_neighbours;
+
+            heap_t heap(num_e);
+            for (index_t i = 0; i < num_e; i++) {
+                heap.push(i, edge_weights(i));
+            }
+            HG_PROFILE_COUNT("binary_partition_tree heap push", num_e);
+            auto remove_from_heap = [&heap](index_t e) {
+                heap.erase(e);
+                HG_PROFILE_COUNT("binary_partition_tree heap erase", 1);
+            };
+
+            // main loop
+            int64_t iteration = 0;
+            while (!heap.empty() && rag.num_regions() < num_nodes_tree) {
+                check_cancellation(iteration++);
+
+                auto fusion_edge_index = heap.top();
+                auto fusion_edge_weight = heap.top_value();
+                heap.pop();
+                HG_PROFILE_COUNT("binary_partition_tree heap pop", 1);
+                rag.remove_edge(fusion_edge_index);
+
+                auto region1 = rag.source(fusion_edge_index);
+                auto region2 = rag.target(fusion_edge_index);
+
+                // search for neighbours of region1 and region2 and store them in new_neighbours
+                rag.collect_neighbours(region1, region2, new_neighbours, remove_from_heap);
+
+                // create new region, update tree
+                auto new_parent = rag.merge_regions(region1, region2, new_neighbours, remove_from_heap);
+                parents[region1] = new_parent;
+                parents[region2] = new_parent;
+                levels[new_parent] = fusion_edge_weight;
+
+                // external callback : compute new edge weights, and update heap
+                if (!new_neighbours.empty()) { // should only happen at last iteration
+                    weight_function(region_adjacency_graph_view(rag), fusion_edge_index, new_parent, region1, region2,
+                                    const_new_neighbours);
+                }
+                for (auto &nn: new_neighbours) {
+                    heap.update(nn.first_edge_index(), nn.new_edge_weight());
+                }
+                HG_PROFILE_COUNT("binary_partition_tree heap update", new_neighbours.size());
+            }
+            return make_node_weighted_tree(tree(parents), std::move(levels));
+        }
+
+        /**
+         * Binary partition tree engine based on the nearest-neighbour chain algorithm.
+         *
+         * Starting from an arbitrary region, the algorithm follows the chain of nearest neighbours until it finds two
+         * reciprocal nearest neighbours, which are merged, and then restarts from the end of the chain. The global
+         * priority queue of the edges is thus replaced by local scans of the adjacency lists of the regions at the top
+         * of the chain. The merges are finally sorted by increasing altitudes (children being always placed before
+         * their parent) in order to number the nodes of the tree as the heap engine does.
+         *
+         * The nearest neighbour of a region is the one linked by the edge of smallest weight, ties being broken by
+         * increasing edge index.
+         *
+         * The result is the same as the one of the heap engine if the linkage is reducible: for any regions X, Y, and Z,
+         * d(X u Y, Z) >= min(d(X, Z), d(Y, Z)), where the distance between non adjacent regions is infinite, and if
+         * no two edges have the same weight during the agglomeration. This holds for the complete, average, and
+         * exponential linkages (the new distance is either a maximum or a weighted mean of the previous distances);
+         * the graph constrained Ward linkage is not reducible in general (the Ward distance of a tree built by the heap
+         * engine is not necessarily increasing), and the results of the two engines may differ when the heap engine
+         * produces non increasing altitudes.
+         *
+         * See:
+         *
+         *      F. Murtagh, A survey of recent advances in hierarchical clustering algorithms,
+         *      The Computer Journal, 26(4):354-359, 1983.
+         *
+         * @tparam graph_t
+         * @tparam weighter
+         * @tparam T
+         * @param graph input graph
+         * @param xedge_weights initial edge weights
+         * @param weight_function weighting function (see binary_partition_tree_region_adjacency)
+         * @return a node weighted tree
+         */
+        template<typename graph_t, typename weighter, typename T>
+        auto binary_partition_tree_nn_chain(const graph_t &graph,
+                                            const xt::xexpression<T> &xedge_weights,
+                                            weighter weight_function) {
+            using weight_t = typename T::value_type;
+
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_edge_weights(graph, edge_weights);
+
+            index_t num_points = num_vertices(graph);
+            index_t num_nodes_tree = (num_points > 0) ? num_points * 2 - 1 : 0;
+
+            region_adjacency_graph rag(graph);
+            std::vector<weight_t> values(edge_weights.begin(), edge_weights.end());
+
+            // special structure to store the list of neighbours adjacent to the fused regions.
+            std::vector<new_neighbour<weight_t> > new_neighbours;
+            const decltype(new_neighbours) &const_new_neighbours = new_neighbours;
+            auto no_op = [](index_t) {};
+
+            // the i-th merge creates the region num_points + i, children are regions of the region adjacency graph
+            std::vector<std::pair<index_t, index_t>> merge_children;
+            std::vector<weight_t> merge_altitudes;
+
+            std::vector<index_t> chain;
+            index_t next_start = 0;
+            int64_t iteration = 0;
+            while (rag.num_regions() < num_nodes_tree) {
+                check_cancellation(iteration++);
+                if (chain.empty()) {
+                    // regions before next_start are either merged or isolated
+                    if (next_start == rag.num_regions()) {
+                        break;
+                    }
+                    chain.push_back(next_start++);
+                }
+
+                auto region = chain.back();
+                index_t nearest_edge = invalid_index;
+                rag.for_each_edge(region, [&values, &nearest_edge](index_t e, index_t) {
+                    if (nearest_edge == invalid_index || values[e] < values[nearest_edge] ||
+                        (!(values[nearest_edge] < values[e]) && e < nearest_edge)) {
+                        nearest_edge = e;
+                    }
+                });
+
+                if (nearest_edge == invalid_index) { // isolated region
+                    chain.pop_back();
+                    continue;
+                }
+
+                auto nearest_region = (rag.source(nearest_edge) == region) ?
+                                      rag.target(nearest_edge) : rag.source(nearest_edge);
+                if (chain.size() < 2 || chain[chain.size() - 2] != nearest_region) {
+                    chain.push_back(nearest_region);
+                    continue;
+                }
+
+                // region and nearest_region are reciprocal nearest neighbours
+                chain.pop_back();
+                chain.pop_back();
+                rag.remove_edge(nearest_edge);
+                auto region1 = rag.source(nearest_edge);
+                auto region2 = rag.target(nearest_edge);
+
+                rag.collect_neighbours(region1, region2, new_neighbours, no_op);
+                auto new_region = rag.merge_regions(region1, region2, new_neighbours, no_op);
+                if (!new_neighbours.empty()) {
+                    weight_function(region_adjacency_graph_view(rag), nearest_edge, new_region, region1, region2,
+                                    const_new_neighbours);
+                }
+                for (auto &nn: new_neighbours) {
+                    values[nn.first_edge_index()] = nn.new_edge_weight();
+                }
+                merge_children.emplace_back(region1, region2);
+                merge_altitudes.push_back(values[nearest_edge]);
+            }
+
+            // number the merges by increasing altitude, each merge being placed after the merges of its children
+            index_t num_merges = merge_children.size();
+            std::vector<index_t> merge_parent(num_merges, invalid_index);
+            std::vector<char> num_pending_children(num_merges, 0);
+            for (index_t i = 0; i < num_merges; i++) {
+                for (auto c: {merge_children[i].first, merge_children[i].second}) {
+                    if (c >= num_points) {
+                        merge_parent[c - num_points] = i;
+                        num_pending_children[i]++;
+                    }
+                }
+            }
+
+            using queue_element = std::pair<weight_t, index_t>;
+            std::priority_queue<queue_element, std::vector<queue_element>, std::greater<queue_element>> ready;
+            for (index_t i = 0; i < num_merges; i++) {
+                if (num_pending_children[i] == 0) {
+                    ready.push({merge_altitudes[i], i});
+                }
+            }
+
+            array_1d<index_t> parents = xt::arange(num_nodes_tree);
+            array_1d<weight_t> levels = xt::zeros<weight_t>({(size_t) num_nodes_tree});
+            std::vector<index_t> node_index(num_nodes_tree);
+            std::iota(node_index.begin(), node_index.begin() + num_points, 0);
+
+            index_t num_nodes = num_points;
+            while (!ready.empty()) {
+                auto i = ready.top().second;
+                ready.pop();
+                auto n = num_nodes++;
+                node_index[num_points + i] = n;
+                parents[node_index[merge_children[i].first]] = n;
+                parents[node_index[merge_children[i].second]] = n;
+                levels[n] = merge_altitudes[i];
+                auto p = merge_parent[i];
+                if (p != invalid_index && --num_pending_children[p] == 0) {
+                    ready.push({merge_altitudes[p], p});
+                }
+            }
+
+            return make_node_weighted_tree(tree(parents), std::move(levels));
+        }
+
+        /**
+         * Dispatch the linkage based binary partition tree to the engine given by the engine policy.
+         */
+        template<typename engine_t>
+        struct linkage_engine {
+            template<typename graph_t, typename T, typename weighter>
+            static auto run(const graph_t &graph, const xt::xexpression<T> &xedge_weights, weighter weight_function) {
+                return binary_partition_tree_region_adjacency<engine_t>(graph, xedge_weights, weight_function);
+            }
+        };
+
+        template<>
+        struct linkage_engine<nn_chain_policy> {
+            template<typename graph_t, typename T, typename weighter>
+            static auto run(const graph_t &graph, const xt::xexpression<T> &xedge_weights, weighter weight_function) {
+                return binary_partition_tree_nn_chain(graph, xedge_weights, weight_function);
+            }
+        };
     }
 
+    /**
+     * Engines of the linkage based binary partition tree functions (binary_partition_tree_complete_linkage,
+     * binary_partition_tree_average_linkage, binary_partition_tree_exponential_linkage, and
+     * binary_partition_tree_ward_linkage).
+     *
+     * - bpt_fibonacci_heap: global Fibonacci heap, ties between edges of equal weights are broken arbitrarily
+     * - bpt_dary_heap<arity>: global indexed d-ary heap stored in a flat array (default, with arity 4), ties between
+     *   edges of equal weights are broken by increasing edge index
+     * - bpt_pairing_heap: global indexed pairing heap, ties between edges of equal weights are broken by increasing
+     *   edge index (same result as bpt_dary_heap)
+     * - bpt_nn_chain: nearest-neighbour chain algorithm, gives the same result as the heap engines for reducible
+     *   linkages (complete, average, and exponential linkages) if no two edges have the same weight during the
+     *   agglomeration (see binary_partition_tree_internal::binary_partition_tree_nn_chain)
+     */
+    using bpt_fibonacci_heap = binary_partition_tree_internal::fibonacci_heap_policy;
+
+    template<index_t arity = 4>
+    using bpt_dary_heap = binary_partition_tree_internal::dary_heap_policy<arity>;
+
+    using bpt_pairing_heap = binary_partition_tree_internal::pairing_heap_policy;
+
+    using bpt_nn_chain = binary_partition_tree_internal::nn_chain_policy;
+
     /**
      * Compute the binary partition tree of the graph.
      *
@@ -478,6 +1410,13 @@ namespace hg {
      *
      * Example of weighting function: binary_partition_tree_min_linkage
      *
+     * The graph g is a read only view of the current region adjacency graph (see
+     * binary_partition_tree_internal::region_adjacency_graph_view): the new region is already linked to its neighbours
+     * by the edges new_neighbours[i].new_edge_index(), the merged regions have no edge anymore, and the edges removed
+     * from the graph have no extremity (source and target are equal to invalid_index). The regions are stored in the
+     * flat region adjacency graph of the linkage engines, with a Fibonacci heap of the edges: the input graph is not
+     * copied into a graph supporting edge removals (see binary_partition_tree_internal::region_adjacency_graph).
+     *
      * @tparam graph_t
      * @tparam weighter
      * @tparam T
@@ -489,120 +1428,109 @@ namespace hg {
     template<typename graph_t, typename weighter, typename T>
     auto
     binary_partition_tree(const graph_t &graph, const xt::xexpression<T> &xedge_weights, weighter weight_function) {
-        using weight_t = typename T::value_type;
-        using heap_t = fibonacci_heap<binary_partition_tree_internal::heap_element<weight_t> >;
-
-        auto &edge_weights = xedge_weights.derived_cast();
-        hg_assert_edge_weights(graph, edge_weights);
-
-        auto g = copy_graph<undirected_graph<hash_setS> >(graph); // optimized for removal
-
-        auto num_points = num_vertices(g);
-        auto num_nodes_tree = num_points * 2 - 1;
-
-        array_1d<index_t> parents = xt::arange(num_nodes_tree);
-        array_1d<weight_t> levels = xt::zeros<weight_t>({num_nodes_tree});
-
-        // optimization to detect already visited neighbours during neighbour search
-        array_1d<index_t> new_neighbour_indices({num_nodes_tree}, invalid_index);
+        return binary_partition_tree_internal::binary_partition_tree_region_adjacency<bpt_fibonacci_heap>(
+                graph, xedge_weights, weight_function);
+    }
 
-        // active edges are in the heap and still present in the graph (removed edges are leazily left in the heap)
-        // TODO: check for performance impact
-        array_1d<bool> active = xt::zeros<bool>({num_edges(g)});
 
-        // special structure to store the list of neighbours adjacent to the fused regions.
-        std::vector<binary_partition_tree_internal::new_neighbour<weight_t> > new_neighbours;
-        const decltype(new_neighbours) &const_new_neighbours = new_neighbours;
+    /**
+     * Compiled linkage callback of binary_partition_tree_compiled_linkage: a plain C function that can be produced
+     * by any compiler or JIT (numba cfunc, ctypes, cffi...).
+     *
+     * It is called once for each merge with the fusion edge, the new region and the two merged regions, and with
+     * num_neighbours neighbours of the new region described by the arrays:
+     *
+     *  - neighbour_vertices: the neighbour regions;
+     *  - first_edge_indices: the index of the edge linking one of the merged region to the neighbour region, which
+     *    is also the index of the new edge linking the new region to the neighbour region;
+     *  - second_edge_indices: the index of the edge linking the other merged region to the neighbour region, or
+     *    invalid_index (-1) if there is no such edge;
+     *  - new_edge_weights: the callback must set the weight of the new edges in this array.
+     *
+     * user_data is the pointer given to binary_partition_tree_compiled_linkage, typically the data of the arrays
+     * holding the state of the linkage (edge weights, edge counts...) indexed by edge index.
+     */
+    using bpt_linkage_callback_t = void (*)(index_t fusion_edge_index,
+                                            index_t new_region,
+                                            index_t merged_region1,
+                                            index_t merged_region2,
+                                            index_t num_neighbours,
+                                            const index_t *neighbour_vertices,
+                                            const index_t *first_edge_indices,
+                                            const index_t *second_edge_indices,
+                                            double *new_edge_weights,
+                                            void *user_data);
 
-        // init heap
-        heap_t heap;
-        array_1d<typename heap_t::value_handle> heap_handles({num_edges(g)}, nullptr);
+    namespace binary_partition_tree_internal {
 
-        for (auto v: vertex_iterator(graph)) {
-            for (auto &e: out_edge_iterator(v, g)) {
-                if (!active(e)) {
-                    heap_handles(e) = heap.push({edge_weights(e), e});
-                    active(e) = true;
-                }
+        /**
+         * Weighting function calling a compiled linkage callback (see bpt_linkage_callback_t): the neighbours are
+         * copied into flat arrays reused from one merge to the next.
+         */
+        struct binary_partition_tree_callback_weighting_functor {
+            bpt_linkage_callback_t m_callback;
+            void *m_user_data;
+            std::vector<index_t> m_neighbour_vertices;
+            std::vector<index_t> m_first_edge_indices;
+            std::vector<index_t> m_second_edge_indices;
+            std::vector<double> m_new_edge_weights;
+
+            binary_partition_tree_callback_weighting_functor(bpt_linkage_callback_t callback, void *user_data) :
+                    m_callback(callback), m_user_data(user_data) {
             }
-        }
-
-        // main loop
-        size_t current_num_nodes_tree = num_points;
-        while (!heap.empty() && current_num_nodes_tree < num_nodes_tree) {
-
-            auto heap_handle = heap.top();
-            auto min_element = heap_handle->get_value();
-
-            auto fusion_edge_index = min_element.index;
-            auto fusion_edge_weight = min_element.value;
-
-            heap.pop();
-            heap_handles[fusion_edge_index] = nullptr;
-
-            if (active[fusion_edge_index]) {
-                active[fusion_edge_index] = false;
-                // create new region, update tree
-                auto new_parent = g.add_vertex();
-                auto fusion_edge = edge_from_index(fusion_edge_index, g);
-                auto region1 = source(fusion_edge, g);
-                auto region2 = target(fusion_edge, g);
-                parents[region1] = new_parent;
-                parents[region2] = new_parent;
-                levels[new_parent] = fusion_edge_weight;
-                current_num_nodes_tree++;
-
-                // remove fusion edge
-                remove_edge(fusion_edge_index, g);
-                active[fusion_edge_index] = false;
-
-                // search for neighbours of region1 and region2 and store them in new_neighbours
-                new_neighbours.clear();
-                auto explore_region = [&active, &g, &new_neighbours, &new_neighbour_indices](
-                        index_t region, index_t other_region) {
-                    for (auto e: out_edge_iterator(region, g)) {
-                        auto n = other_vertex(e, region, g);
-                        if (n != other_region) { // may happen with multiple edges
-                            if (new_neighbour_indices[n] != invalid_index) {
-                                new_neighbours[new_neighbour_indices[n]].second_edge_index() = e;
-                            } else {
-                                new_neighbour_indices[n] = new_neighbours.size();
-                                new_neighbours.emplace_back(n, e);
-                            }
-                        } else {
-                            active[index(e, g)] = false;
-                        }
-                    }
-                };
 
-                explore_region(region1, region2);
-                explore_region(region2, region1);
+            template<typename graph_t, typename neighbours_t>
+            void operator()(const graph_t &,
+                            index_t fusion_edge_index,
+                            index_t new_region,
+                            index_t merged_region1,
+                            index_t merged_region2,
+                            neighbours_t &new_neighbours) {
+                m_neighbour_vertices.clear();
+                m_first_edge_indices.clear();
+                m_second_edge_indices.clear();
                 for (auto &n: new_neighbours) {
-                    new_neighbour_indices[n.neighbour_vertex()] = invalid_index;
+                    m_neighbour_vertices.push_back(n.neighbour_vertex());
+                    m_first_edge_indices.push_back(n.first_edge_index());
+                    m_second_edge_indices.push_back(n.second_edge_index());
                 }
-
-                // update edge weights
-                if (!new_neighbours.empty()) { // should only happen at last iteration
-                    // external callback : compute new edge weights
-                    weight_function(g, fusion_edge_index, new_parent, region1, region2, const_new_neighbours);
-
-                    // process new weights, update heap and things
-                    for (auto &nn: new_neighbours) {
-                        if (nn.num_edges() > 1) {
-                            active[nn.second_edge_index()] = false;
-                            // not removed from heap: maybe not necessary
-                            remove_edge(nn.second_edge_index(), g);
-                        }
-                        set_edge(nn.first_edge_index(), nn.neighbour_vertex(), new_parent, g);
-                        heap.update(heap_handles[nn.first_edge_index()], {nn.new_edge_weight(), nn.first_edge_index()});
-                        active[nn.first_edge_index()] = true;
-                    }
+                const index_t num_neighbours = m_neighbour_vertices.size();
+                m_new_edge_weights.resize(num_neighbours);
+                m_callback(fusion_edge_index, new_region, merged_region1, merged_region2, num_neighbours,
+                           m_neighbour_vertices.data(), m_first_edge_indices.data(), m_second_edge_indices.data(),
+                           m_new_edge_weights.data(), m_user_data);
+                index_t i = 0;
+                for (auto &n: new_neighbours) {
+                    n.new_edge_weight() = m_new_edge_weights[i++];
                 }
             }
-        }
-        return make_node_weighted_tree(tree(parents), std::move(levels));
+        };
     }
 
+    /**
+     * Binary partition tree of the graph with a compiled linkage callback (see bpt_linkage_callback_t): same as
+     * binary_partition_tree, but the weights of the new edges are computed by a plain C function operating on flat
+     * arrays, which can be called without going through an interpreter.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights initial edge weights
+     * @param callback compiled linkage callback
+     * @param user_data pointer passed to each call of the callback
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T>
+    auto binary_partition_tree_compiled_linkage(const graph_t &graph,
+                                                const xt::xexpression<T> &xedge_weights,
+                                                bpt_linkage_callback_t callback,
+                                                void *user_data = nullptr) {
+        HG_TRACE();
+        hg_assert(callback != nullptr, "Invalid linkage callback.");
+        return binary_partition_tree(graph, xedge_weights,
+                                     binary_partition_tree_internal::binary_partition_tree_callback_weighting_functor(
+                                             callback, user_data));
+    }
 
     /**
      * Binary partition tree, i.e. the agglomerative clustering, with the  minimum/single linkage rule.
@@ -640,15 +1568,16 @@ namespace hg {
      *
      * Regions are then iteratively merged following the above distance (closest first) until a single region remains
      *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
      * @tparam graph_t
      * @tparam T
      * @param graph
      * @param xedge_weights
      * @return a node weighted tree
      */
-    template<typename graph_t, typename T>
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T>
     auto binary_partition_tree_complete_linkage(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
-        return binary_partition_tree(
+        return binary_partition_tree_internal::linkage_engine<engine_t>::run(
                 graph,
                 xedge_weights,
                 binary_partition_tree_internal::binary_partition_tree_complete_linkage_weighting_functor<T>(
@@ -669,6 +1598,7 @@ namespace hg {
      *
      * Regions are then iteratively merged following the above distance (closest first) until a single region remains
      *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
      * @tparam graph_t
      * @tparam T
      * @param graph
@@ -676,11 +1606,11 @@ namespace hg {
      * @param xedge_weight_weights
      * @return a node weighted tree
      */
-    template<typename graph_t, typename T>
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T>
     auto binary_partition_tree_average_linkage(const graph_t &graph,
                                                const xt::xexpression<T> &xedge_weights,
                                                const xt::xexpression<T> &xedge_weight_weights) {
-        return binary_partition_tree(
+        return binary_partition_tree_internal::linkage_engine<engine_t>::run(
                 graph,
                 xedge_weights,
                 binary_partition_tree_internal::binary_partition_tree_average_linkage_weighting_functor<T>(
@@ -714,6 +1644,7 @@ namespace hg {
      *      Supervised Hierarchical Clustering with Exponential Linkage
      *      Proceedings of the 36th International Conference on Machine Learning, PMLR 97:6973-6983, 2019.
      *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
      * @tparam graph_t
      * @tparam T
      * @param graph
@@ -722,12 +1653,12 @@ namespace hg {
      * @param xedge_weight_weights
      * @return a node weighted tree
      */
-    template<typename graph_t, typename T>
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T>
     auto binary_partition_tree_exponential_linkage(const graph_t &graph,
                                                const xt::xexpression<T> &xedge_weights,
                                                const typename T::value_type &alpha,
                                                const xt::xexpression<T> &xedge_weight_weights) {
-        return binary_partition_tree(
+        return binary_partition_tree_internal::linkage_engine<engine_t>::run(
                 graph,
                 xedge_weights,
                 binary_partition_tree_internal::binary_partition_tree_exponential_linkage_weighting_functor<T>(
@@ -736,6 +1667,53 @@ namespace hg {
                         alpha));
     }
 
+    /**
+     * Binary partition trees with the exponential linkage rule for several values of alpha (see
+     * binary_partition_tree_exponential_linkage).
+     *
+     * The input arrays and the logarithms of the edge weight weights are shared by the clusterings, which are
+     * computed in parallel.
+     *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
+     * @tparam graph_t
+     * @tparam T
+     * @tparam T2
+     * @param graph
+     * @param xedge_weights
+     * @param xalphas 1d array of alpha values
+     * @param xedge_weight_weights
+     * @return a vector of node weighted trees: the i-th tree is the clustering for the i-th alpha value
+     */
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T, typename T2>
+    auto binary_partition_tree_exponential_linkage_multi(const graph_t &graph,
+                                                         const xt::xexpression<T> &xedge_weights,
+                                                         const xt::xexpression<T2> &xalphas,
+                                                         const xt::xexpression<T> &xedge_weight_weights) {
+        HG_TRACE();
+        using value_type = typename T::value_type;
+        using functor_t = binary_partition_tree_internal::binary_partition_tree_exponential_linkage_weighting_functor<T>;
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &alphas = xalphas.derived_cast();
+        hg_assert_1d_array(alphas);
+        hg_assert_same_shape(edge_weights, xedge_weight_weights.derived_cast());
+
+        const array_1d<value_type> log_weights = xt::log(xedge_weight_weights.derived_cast());
+        using result_t = decltype(binary_partition_tree_internal::linkage_engine<engine_t>::run(
+                graph, edge_weights, functor_t(edge_weights, log_weights, 0)));
+        const index_t num_alphas = alphas.size();
+        std::vector<std::unique_ptr<result_t>> results(num_alphas);
+        parfor(0, num_alphas, [&](index_t i) {
+            results[i] = std::make_unique<result_t>(binary_partition_tree_internal::linkage_engine<engine_t>::run(
+                    graph, edge_weights, functor_t(edge_weights, log_weights, (value_type) alphas(i))));
+        });
+        std::vector<result_t> trees;
+        trees.reserve(num_alphas);
+        for (auto &r: results) {
+            trees.push_back(std::move(*r));
+        }
+        return trees;
+    }
+
     /**
      * Binary partition tree, i.e. the agglomerative clustering, with the Ward linkage rule.
      *
@@ -758,6 +1736,7 @@ namespace hg {
      *      - ``"max"``: the altitude of a node :math:`n` is defined as the maximum of the the Ward distance associated
      *          to each node in the subtree rooted in :math:`n`.
      *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
      * @tparam graph_t
      * @tparam T1
      * @tparam T2
@@ -767,7 +1746,7 @@ namespace hg {
      * @param altitude_correction can be ``"none"`` or ``"max"`` (default)
      * @return a node weighted tree
      */
-    template<typename graph_t, typename T1, typename T2>
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T1, typename T2>
     auto binary_partition_tree_ward_linkage(const graph_t &graph,
                                             const xt::xexpression<T1> &xvertex_centroids,
                                             const xt::xexpression<T2> &xvertex_sizes,
@@ -776,7 +1755,7 @@ namespace hg {
         auto f = binary_partition_tree_internal::binary_partition_tree_ward_linkage_weighting_functor<T1, T2>
                 (xvertex_centroids, xvertex_sizes);
 
-        auto res = binary_partition_tree(
+        auto res = binary_partition_tree_internal::linkage_engine<engine_t>::run(
                 graph,
                 f.get_weights(graph),
                 f);
@@ -796,3 +1775,27 @@ namespace hg {
     }
 
 }
+
+#include "../detail/prebuilt.hpp"
+
+// the linkage functions are small wrappers, usually inlined, around the agglomeration engine: the engine is
+// instantiated for the standard linkages
+#define HG_PREBUILT_BINARY_PARTITION_TREE(prefix, value_t)                                                            \
+    prefix template auto binary_partition_tree_internal::binary_partition_tree_region_adjacency<                     \
+            bpt_dary_heap<>, ugraph,                                                                                 \
+            binary_partition_tree_internal::binary_partition_tree_complete_linkage_weighting_functor<array_1d<value_t>>, \
+            array_1d<value_t>>(                                                                                       \
+            const ugraph &, const xt::xexpression<array_1d<value_t>> &,                                              \
+            binary_partition_tree_internal::binary_partition_tree_complete_linkage_weighting_functor<array_1d<value_t>>); \
+    prefix template auto binary_partition_tree_internal::binary_partition_tree_region_adjacency<                     \
+            bpt_dary_heap<>, ugraph,                                                                                 \
+            binary_partition_tree_internal::binary_partition_tree_average_linkage_weighting_functor<array_1d<value_t>>, \
+            array_1d<value_t>>(                                                                                       \
+            const ugraph &, const xt::xexpression<array_1d<value_t>> &,                                              \
+            binary_partition_tree_internal::binary_partition_tree_average_linkage_weighting_functor<array_1d<value_t>>);
+
+#ifdef HG_USE_PREBUILT_LIBRARY
+namespace hg {
+    HG_PREBUILT_FOR_EACH_FLOAT_TYPE(HG_PREBUILT_BINARY_PARTITION_TREE, extern)
+}
+#endif
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <utility>
 
 namespace hg {
 
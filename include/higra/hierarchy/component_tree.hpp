@@ -15,6 +15,7 @@
 #include "higra/graph.hpp"
 #include "higra/sorting.hpp"
 #include "xtensor/xadapt.hpp"
+#include "xtensor/xview.hpp"
 
 namespace hg {
     namespace component_tree_internal {
@@ -59,6 +60,59 @@ namespace hg {
             return parent;
         }
 
+        /**
+         * Regular graph fast path of pre_tree_construction: the vertices of the safe area of the graph are first
+         * marked with scan_regular_graph, the neighbours of such a vertex are then obtained by adding constant offsets
+         * to its linear index. Neighbours are processed in the same order as with adjacent_vertex_iterator and the
+         * result is identical.
+         */
+        template<typename embedding_t, typename E>
+        auto pre_tree_construction(const regular_graph<embedding_t> &graph,
+                                   const E &sorted_vertex_indices) {
+            index_t nbe = num_vertices(graph);
+            array_1d<index_t> parent = array_1d<index_t>::from_shape({(size_t) nbe});
+            array_1d<index_t> representing = array_1d<index_t>::from_shape({(size_t) nbe});
+            array_1d<bool> processed({(size_t) nbe}, false);
+            array_1d<bool> interior({(size_t) nbe}, false);
+            union_find uf(nbe);
+
+            scan_regular_graph(graph, 0, nbe,
+                               [&interior](index_t first, index_t last, const auto &) {
+                                   std::fill(interior.begin() + first, interior.begin() + last, true);
+                               },
+                               [](index_t, const auto &) {});
+
+            dispatch_relative_neighbours(graph, [&](const auto &offsets) {
+                for (index_t i = nbe - 1; i >= 0; i--) {
+                    index_t current_vertex = sorted_vertex_indices[i];
+                    parent(current_vertex) = current_vertex;
+                    representing(current_vertex) = current_vertex;
+                    processed(current_vertex) = true;
+                    auto current_vertex_reprez = current_vertex;
+                    auto process_neighbour = [&](index_t n) {
+                        if (processed(n)) {
+                            auto neighbor_component = uf.find(n);
+                            if (neighbor_component != current_vertex_reprez) {
+                                parent[representing[neighbor_component]] = current_vertex;
+                                current_vertex_reprez = uf.link(neighbor_component, current_vertex_reprez);
+                                representing(current_vertex_reprez) = current_vertex;
+                            }
+                        }
+                    };
+                    if (interior(current_vertex)) {
+                        for (auto offset: offsets) {
+                            process_neighbour(current_vertex + offset);
+                        }
+                    } else {
+                        for (auto n: adjacent_vertex_iterator(current_vertex, graph)) {
+                            process_neighbour(n);
+                        }
+                    }
+                }
+            });
+            return parent;
+        }
+
         /**
          * Parent relation "canonization" (path compression) after pre_tree_construction
          *
@@ -125,6 +179,198 @@ namespace hg {
             return std::make_pair(std::move(new_parents), std::move(altitudes));
         }
 
+        /**
+         * Pre-tree construction restricted to the vertices of the block [start, end[ (to be used by
+         * parallel_tree_from_sorted_vertices).
+         *
+         * Only the edges between two vertices of the block are considered. On return, the restriction of parent
+         * to the block is the pre-parent relation of the subgraph induced by the block.
+         *
+         * @param graph
+         * @param block_sorted_vertices the vertices of the block sorted according to rank
+         * @param rank rank of each vertex in the global sorted order
+         * @param start first vertex of the block
+         * @param end after last vertex of the block
+         * @param parent parent relation (modified in place on the block)
+         * @param representing working array (modified in place on the block)
+         */
+        template<typename graph_t, typename T1, typename T2>
+        void pre_tree_construction_block(const graph_t &graph,
+                                         const T1 &block_sorted_vertices,
+                                         const T2 &rank,
+                                         index_t start,
+                                         index_t end,
+                                         array_1d<index_t> &parent,
+                                         array_1d<index_t> &representing) {
+            union_find uf(end - start);
+
+            for (index_t i = (index_t) block_sorted_vertices.size() - 1; i >= 0; i--) {
+                index_t current_vertex = block_sorted_vertices[i];
+                parent(current_vertex) = current_vertex;
+                representing(current_vertex) = current_vertex;
+                auto current_vertex_reprez = current_vertex - start;
+                for (auto n: adjacent_vertex_iterator(current_vertex, graph)) {
+                    index_t nn = n;
+                    // vertex n has already been processed if it belongs to the block and has a larger rank
+                    if (nn >= start && nn < end && rank(nn) > rank(current_vertex)) {
+                        auto neighbor_component = uf.find(nn - start);
+                        if (neighbor_component != current_vertex_reprez) {
+                            parent[representing[neighbor_component + start]] = current_vertex;
+                            current_vertex_reprez = uf.link(neighbor_component, current_vertex_reprez);
+                            representing(current_vertex_reprez + start) = current_vertex;
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Merge, along the edge {x, y}, the two parent relations containing x and y
+         * (to be used by parallel_tree_from_sorted_vertices).
+         *
+         * The parent relations must be such that the parent of a non root node has a strictly smaller rank,
+         * and that the canonical element of each node (the element whose parent has a different level) is its
+         * element of minimal rank. The ancestor chains of x and y are zipped, nodes of same level are merged,
+         * and these properties are preserved.
+         *
+         * Michael H. F. Wilkinson, Hui Gao, Wim H. Hesselink, Jan-Eppo Jonker, and Arnold Meijster. Concurrent
+         * computation of attribute filters on shared memory parallel machines. IEEE Transactions on Pattern Analysis
+         * and Machine Intelligence, 30(10):1800-1813, 2008.
+         */
+        template<typename T1, typename T2>
+        void merge_parent_relations(index_t x,
+                                    index_t y,
+                                    array_1d<index_t> &parent,
+                                    const T1 &vertex_weights,
+                                    const T2 &rank) {
+            // canonical element of the node containing x, with path compression
+            auto level_root = [&parent, &vertex_weights](index_t v) {
+                auto r = v;
+                while (parent(r) != r && vertex_weights(parent(r)) == vertex_weights(r)) {
+                    r = parent(r);
+                }
+                while (v != r) {
+                    auto n = parent(v);
+                    parent(v) = r;
+                    v = n;
+                }
+                return r;
+            };
+
+            auto a = level_root(x);
+            auto b = level_root(y);
+            while (a != b) {
+                // a is the deepest of the two nodes
+                if (rank(a) < rank(b)) {
+                    std::swap(a, b);
+                }
+                auto pa = parent(a);
+                if (vertex_weights(a) == vertex_weights(b)) {
+                    // same level: b becomes the canonical element of the merged node
+                    parent(a) = b;
+                    if (pa == a) {
+                        break;
+                    }
+                    a = level_root(pa);
+                } else {
+                    if (pa == a) {
+                        parent(a) = b;
+                        break;
+                    }
+                    pa = level_root(pa);
+                    if (rank(pa) > rank(b) || vertex_weights(pa) == vertex_weights(b)) {
+                        parent(a) = pa;
+                    } else {
+                        parent(a) = b;
+                    }
+                    a = pa;
+                }
+            }
+        }
+
+        /**
+         * Number of blocks used by parallel_tree_from_sorted_vertices when the requested number of blocks is 0
+         */
+        inline
+        index_t component_tree_num_blocks(index_t num_vertices) {
+            index_t max_blocks = get_num_threads();
+            return (std::max)((index_t) 1, (std::min)(max_blocks, num_vertices / (index_t) 65536));
+        }
+
+        /**
+         * Parallel version of canonize_tree: the result is identical.
+         *
+         * After canonization, the parent of a vertex is the canonical element of the node of its pre-parent: the
+         * first ancestor c of the pre-parent (included) such that c is the root or the level of the parent of c is
+         * different from the level of c. The canonical elements are computed by blocks of consecutive ranks in
+         * parallel: in a block, a vertex whose pre-parent belongs to a previous block temporarily points to its
+         * pre-parent. These references are then resolved block by block, in rank order.
+         *
+         * @param parents a pre-parent relation as constructed by pre_tree_construction (modified in place)
+         * @param vertex_weights the node levels associated to the pre-parent relation
+         * @param sorted_vertex_indices the sorted vertex indices
+         * @param num_blocks number of blocks (if 0, a number of blocks depending on the number of threads
+         *        and on the size of the graph is chosen)
+         */
+        template<typename T1, typename T2, typename T3>
+        void parallel_canonize_tree(T1 &parents,
+                                    const T2 &vertex_weights,
+                                    const T3 &sorted_vertex_indices,
+                                    index_t num_blocks = 0) {
+            index_t num_v = parents.size();
+            if (num_blocks <= 0) {
+                num_blocks = component_tree_num_blocks(num_v);
+            }
+            num_blocks = (std::max)((index_t) 1, (std::min)(num_blocks, num_v));
+            if (num_blocks == 1) {
+                canonize_tree(parents, vertex_weights, sorted_vertex_indices);
+                return;
+            }
+
+            const index_t block_size = (num_v + num_blocks - 1) / num_blocks;
+            num_blocks = (num_v + block_size - 1) / block_size;
+            auto block_start = [block_size, num_v](index_t b) {
+                return (std::min)(b * block_size, num_v);
+            };
+
+            array_1d<index_t> rank = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&rank, &sorted_vertex_indices](index_t i) {
+                rank(sorted_vertex_indices[i]) = i;
+            });
+
+            array_1d<index_t> canonical = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_blocks, [&](index_t b) {
+                auto start = block_start(b);
+                auto end = block_start(b + 1);
+                for (index_t i = start; i < end; i++) {
+                    index_t v = sorted_vertex_indices[i];
+                    index_t p = parents[v];
+                    if (p == v || vertex_weights[p] != vertex_weights[v]) {
+                        canonical(v) = v;
+                    } else if (rank(p) >= start) {
+                        canonical(v) = canonical(p);
+                    } else {
+                        canonical(v) = p;
+                    }
+                }
+            });
+
+            for (index_t b = 1; b < num_blocks; b++) {
+                auto start = block_start(b);
+                parfor(start, block_start(b + 1), [&canonical, &rank, &sorted_vertex_indices, start](index_t i) {
+                    index_t v = sorted_vertex_indices[i];
+                    index_t c = canonical(v);
+                    if (rank(c) < start) {
+                        canonical(v) = canonical(c);
+                    }
+                });
+            }
+
+            parfor(0, num_v, [&parents, &canonical](index_t v) {
+                parents[v] = canonical(parents[v]);
+            });
+        }
+
         template<typename graph_t, typename T1, typename T2>
         auto
         tree_from_sorted_vertices(const graph_t &graph, const T1 &vertex_weights, const T2 &sorted_vertex_indices) {
@@ -136,6 +382,292 @@ namespace hg {
                     tree(xt::adapt(res.first, {res.first.size()}), tree_category::component_tree),
                     std::move(altitudes));
         }
+
+        /**
+         * Calls process_vertex(v) for each vertex v of the graph in the reverse order of sorted_vertex_indices, then
+         * process_neighbour(v, n) for each neighbour n of v (neighbours are visited in the same order as in
+         * pre_tree_construction).
+         */
+        template<typename graph_t, typename E, typename F1, typename F2>
+        void reverse_sorted_vertex_sweep(const graph_t &graph,
+                                         const E &sorted_vertex_indices,
+                                         F1 &&process_vertex,
+                                         F2 &&process_neighbour) {
+            for (index_t i = (index_t) num_vertices(graph) - 1; i >= 0; i--) {
+                index_t current_vertex = sorted_vertex_indices[i];
+                process_vertex(current_vertex);
+                for (auto n: adjacent_vertex_iterator(current_vertex, graph)) {
+                    process_neighbour(current_vertex, (index_t) n);
+                }
+            }
+        }
+
+        /**
+         * Regular graph fast path of reverse_sorted_vertex_sweep (see the regular graph overload of
+         * pre_tree_construction).
+         */
+        template<typename embedding_t, typename E, typename F1, typename F2>
+        void reverse_sorted_vertex_sweep(const regular_graph<embedding_t> &graph,
+                                         const E &sorted_vertex_indices,
+                                         F1 &&process_vertex,
+                                         F2 &&process_neighbour) {
+            index_t nbe = num_vertices(graph);
+            array_1d<bool> interior({(size_t) nbe}, false);
+            scan_regular_graph(graph, 0, nbe,
+                               [&interior](index_t first, index_t last, const auto &) {
+                                   std::fill(interior.begin() + first, interior.begin() + last, true);
+                               },
+                               [](index_t, const auto &) {});
+
+            dispatch_relative_neighbours(graph, [&](const auto &offsets) {
+                for (index_t i = nbe - 1; i >= 0; i--) {
+                    index_t current_vertex = sorted_vertex_indices[i];
+                    process_vertex(current_vertex);
+                    if (interior(current_vertex)) {
+                        for (auto offset: offsets) {
+                            process_neighbour(current_vertex, current_vertex + offset);
+                        }
+                    } else {
+                        for (auto n: adjacent_vertex_iterator(current_vertex, graph)) {
+                            process_neighbour(current_vertex, (index_t) n);
+                        }
+                    }
+                }
+            });
+        }
+
+        /**
+         * Root of the union-find set containing v in a parent array where roots are their own parent (path halving)
+         */
+        template<typename T>
+        index_t find_root_path_halving(T &parent, index_t v) {
+            while (parent(v) != v) {
+                parent(v) = parent(parent(v));
+                v = parent(v);
+            }
+            return v;
+        }
+
+        enum class filter_attribute {
+            area,
+            volume
+        };
+
+        /**
+         * Direct attribute filter of a vertex weighted graph without building the component tree.
+         *
+         * The nodes of the component tree (max tree if the vertices are sorted by increasing weights, min tree if
+         * they are sorted by decreasing weights) whose attribute is strictly smaller than threshold are removed: the
+         * result is identical to reconstruct_leaf_data on the component tree where the deleted nodes are the nodes
+         * with an attribute smaller than the threshold.
+         *
+         * The union-find sets are the components of the tree being constructed, their root is their last processed
+         * vertex: a component is merged with the current vertex if they have the same level or if its attribute is
+         * below the threshold, otherwise the component of the current vertex is marked as kept (the attribute is
+         * increasing) [1].
+         *
+         * [1] A. Meijster and M. H. F. Wilkinson, "A comparison of algorithms for connected set openings and
+         * closings," IEEE Trans. Pattern Anal. Mach. Intell., vol. 24, no. 4, pp. 484-494, 2002.
+         *
+         * @param graph
+         * @param vertex_weights
+         * @param sorted_vertex_indices
+         * @param threshold
+         * @param attribute
+         * @return the filtered vertex weights
+         */
+        template<typename graph_t, typename T1, typename T2>
+        auto attribute_filter_from_sorted_vertices(const graph_t &graph,
+                                                   const T1 &vertex_weights,
+                                                   const T2 &sorted_vertex_indices,
+                                                   double threshold,
+                                                   filter_attribute attribute) {
+            using value_type = typename T1::value_type;
+            index_t num_v = num_vertices(graph);
+            // invalid_index for the vertices not processed yet
+            array_1d<index_t> parent({(size_t) num_v}, invalid_index);
+            array_1d<double> area = array_1d<double>::from_shape({(size_t) num_v});
+            array_1d<double> sum;
+            if (attribute == filter_attribute::volume) {
+                sum.resize({(size_t) num_v});
+            }
+            array_1d<bool> kept({(size_t) num_v}, false);
+
+            auto attribute_value = [&](index_t root, value_type parent_level) {
+                if (attribute == filter_attribute::area) {
+                    return area(root);
+                }
+                return std::abs(sum(root) - area(root) * (double) parent_level);
+            };
+
+            reverse_sorted_vertex_sweep(
+                    graph, sorted_vertex_indices,
+                    [&](index_t v) {
+                        parent(v) = v;
+                        area(v) = 1;
+                        if (attribute == filter_attribute::volume) {
+                            sum(v) = (double) vertex_weights(v);
+                        }
+                    },
+                    [&](index_t v, index_t n) {
+                        if (parent(n) == invalid_index) {
+                            return;
+                        }
+                        auto root = find_root_path_halving(parent, n);
+                        if (root == v) {
+                            return;
+                        }
+                        if (vertex_weights(root) == vertex_weights(v) ||
+                            (!kept(root) && attribute_value(root, vertex_weights(v)) < threshold)) {
+                            parent(root) = v;
+                            area(v) += area(root);
+                            if (attribute == filter_attribute::volume) {
+                                sum(v) += sum(root);
+                            }
+                            kept(v) = kept(v) || kept(root);
+                        } else {
+                            kept(v) = true;
+                        }
+                    });
+
+            // the parent of a vertex is processed before it in the sorting order
+            array_1d<value_type> result = array_1d<value_type>::from_shape({(size_t) num_v});
+            for (index_t i = 0; i < num_v; i++) {
+                index_t v = sorted_vertex_indices[i];
+                result(v) = (parent(v) == v) ? vertex_weights(v) : result(parent(v));
+            }
+            return result;
+        }
+
+        /**
+         * Parent relation of the component tree computed by blocks (see parallel_tree_from_sorted_vertices) before
+         * the final canonization: a pre-tree is computed independently
+         * on each block of consecutive vertex indices and the pre-trees are merged along the edges between blocks
+         * following a binary reduction.
+         *
+         * @param graph
+         * @param vertex_weights
+         * @param sorted_vertex_indices
+         * @param num_blocks number of blocks (at least 2 and at most the number of vertices)
+         * @return a parent relation which has to be canonized with parallel_canonize_tree
+         */
+        template<typename graph_t, typename T1, typename T2>
+        auto parallel_pre_tree_construction(const graph_t &graph,
+                                            const T1 &vertex_weights,
+                                            const T2 &sorted_vertex_indices,
+                                            index_t num_blocks) {
+            index_t num_v = num_vertices(graph);
+            const index_t block_size = (num_v + num_blocks - 1) / num_blocks;
+            num_blocks = (num_v + block_size - 1) / block_size;
+            auto block_start = [block_size, num_v](index_t b) {
+                return (std::min)(b * block_size, num_v);
+            };
+
+            array_1d<index_t> rank = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&rank, &sorted_vertex_indices](index_t i) {
+                rank(sorted_vertex_indices(i)) = i;
+            });
+
+            // vertices of each block in rank order
+            array_1d<index_t> block_sorted = array_1d<index_t>::from_shape({(size_t) num_v});
+            std::vector<index_t> block_position(num_blocks);
+            for (index_t b = 0; b < num_blocks; b++) {
+                block_position[b] = block_start(b);
+            }
+            for (index_t i = 0; i < num_v; i++) {
+                auto v = sorted_vertex_indices(i);
+                block_sorted(block_position[v / block_size]++) = v;
+            }
+
+            // local trees
+            array_1d<index_t> parent = array_1d<index_t>::from_shape({(size_t) num_v});
+            array_1d<index_t> representing = array_1d<index_t>::from_shape({(size_t) num_v});
+            parfor(0, num_blocks, [&](index_t b) {
+                auto start = block_start(b);
+                auto end = block_start(b + 1);
+                auto block_vertices = xt::view(block_sorted, xt::range(start, end));
+                pre_tree_construction_block(graph, block_vertices, rank, start, end, parent, representing);
+                canonize_tree(parent, vertex_weights, block_vertices);
+            });
+
+            // edges between blocks: edges of block b, tagged with the merge round where their blocks meet
+            std::vector<std::vector<std::pair<index_t, index_t>>> border_edges(num_blocks);
+            std::vector<std::vector<index_t>> border_edge_rounds(num_blocks);
+            parfor(0, num_blocks, [&](index_t b) {
+                for (index_t v = block_start(b); v < block_start(b + 1); v++) {
+                    for (auto n: adjacent_vertex_iterator(v, graph)) {
+                        index_t nn = n;
+                        index_t bn = nn / block_size;
+                        if (bn > b) {
+                            index_t round = 0;
+                            for (index_t d = b ^ bn; d != 0; d >>= 1) {
+                                round++;
+                            }
+                            border_edges[b].emplace_back(v, nn);
+                            border_edge_rounds[b].push_back(round);
+                        }
+                    }
+                }
+            });
+
+            for (index_t round = 1; ((index_t) 1 << (round - 1)) < num_blocks; round++) {
+                const index_t group_size = (index_t) 1 << round;
+                const index_t num_groups = (num_blocks + group_size - 1) / group_size;
+                parfor(0, num_groups, [&](index_t g) {
+                    auto first_block = g * group_size;
+                    auto last_block = (std::min)(first_block + group_size / 2, num_blocks);
+                    for (index_t b = first_block; b < last_block; b++) {
+                        for (index_t i = 0; i < (index_t) border_edges[b].size(); i++) {
+                            if (border_edge_rounds[b][i] == round) {
+                                merge_parent_relations(border_edges[b][i].first, border_edges[b][i].second,
+                                                       parent, vertex_weights, rank);
+                            }
+                        }
+                    }
+                });
+            }
+
+            return parent;
+        }
+
+        /**
+         * Parallel version of tree_from_sorted_vertices: the result is identical.
+         *
+         * The vertex set is split into num_blocks blocks of consecutive indices (for images in raster scan
+         * order, these are bands of rows). A pre-tree is computed independently on each block, and the pre-trees
+         * are merged along the edges between blocks following a binary reduction: at round l, pairs of groups of 2^(l-1)
+         * consecutive blocks are merged in parallel. The final parent relation is then canonized in parallel (see
+         * parallel_canonize_tree) and expanded as in the sequential algorithm.
+         *
+         * @param graph
+         * @param vertex_weights
+         * @param sorted_vertex_indices
+         * @param num_blocks number of blocks (if 0, a number of blocks depending on the number of threads
+         *        and on the size of the graph is chosen)
+         * @return
+         */
+        template<typename graph_t, typename T1, typename T2>
+        auto parallel_tree_from_sorted_vertices(const graph_t &graph,
+                                                const T1 &vertex_weights,
+                                                const T2 &sorted_vertex_indices,
+                                                index_t num_blocks = 0) {
+            index_t num_v = num_vertices(graph);
+            if (num_blocks <= 0) {
+                num_blocks = component_tree_num_blocks(num_v);
+            }
+            num_blocks = (std::max)((index_t) 1, (std::min)(num_blocks, num_v));
+            if (num_blocks == 1) {
+                return tree_from_sorted_vertices(graph, vertex_weights, sorted_vertex_indices);
+            }
+
+            auto parent = parallel_pre_tree_construction(graph, vertex_weights, sorted_vertex_indices, num_blocks);
+            parallel_canonize_tree(parent, vertex_weights, sorted_vertex_indices, num_blocks);
+            auto res = expand_canonized_parent_relation(parent, vertex_weights, sorted_vertex_indices);
+            array_1d<typename T1::value_type> altitudes = xt::adapt(res.second, {res.second.size()});
+            return make_node_weighted_tree(
+                    tree(xt::adapt(res.first, {res.first.size()}), tree_category::component_tree),
+                    std::move(altitudes));
+        }
     }
 
     /**
@@ -205,4 +737,262 @@ namespace hg {
         return component_tree_internal::tree_from_sorted_vertices(graph, vertex_weights, sorted_vertex_indices);
     }
 
+    /**
+     * Construct the Max Tree of the vertex weighted graph in parallel.
+     *
+     * The vertex set is split into blocks of consecutive vertex indices (bands of rows for a 2d grid graph in
+     * raster scan order): a tree is built independently on each block and the trees are then merged along the
+     * edges between blocks, following [1]. The result is identical to the one of component_tree_max_tree.
+     *
+     * [1] M. H. F. Wilkinson, H. Gao, W. H. Hesselink, J.-E. Jonker, and A. Meijster, "Concurrent computation of
+     * attribute filters on shared memory parallel machines," IEEE Trans. Pattern Anal. Mach. Intell.,
+     * vol. 30, no. 10, pp. 1800-1813, 2008.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param num_blocks number of blocks (if 0, the number of blocks is chosen according to the number of available
+     *        threads and to the size of the graph)
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T>
+    auto component_tree_parallel_max_tree(const graph_t &graph,
+                                          const xt::xexpression<T> &xvertex_weights,
+                                          index_t num_blocks = 0) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights);
+        return component_tree_internal::parallel_tree_from_sorted_vertices(graph, vertex_weights,
+                                                                           sorted_vertex_indices, num_blocks);
+    }
+
+    /**
+     * Construct the Min Tree of the vertex weighted graph in parallel.
+     *
+     * See component_tree_parallel_max_tree. The result is identical to the one of component_tree_min_tree.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param num_blocks number of blocks (if 0, the number of blocks is chosen according to the number of available
+     *        threads and to the size of the graph)
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T>
+    auto component_tree_parallel_min_tree(const graph_t &graph,
+                                          const xt::xexpression<T> &xvertex_weights,
+                                          index_t num_blocks = 0) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights,
+                                                                  std::greater<typename T::value_type>());
+        return component_tree_internal::parallel_tree_from_sorted_vertices(graph, vertex_weights,
+                                                                           sorted_vertex_indices, num_blocks);
+    }
+
+    /**
+     * Area opening of a vertex weighted graph: removes the connected components of the upper level sets whose area
+     * (number of vertices) is strictly smaller than the given threshold.
+     *
+     * The result is identical to reconstruct_leaf_data on the Max Tree (see component_tree_max_tree) where the nodes
+     * whose area is smaller than the threshold are deleted, but the tree is never built: the filter is computed
+     * during a single union-find sweep over the sorted vertices [1].
+     *
+     * [1] A. Meijster and M. H. F. Wilkinson, "A comparison of algorithms for connected set openings and
+     * closings," IEEE Trans. Pattern Anal. Mach. Intell., vol. 24, no. 4, pp. 484-494, 2002.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param area_threshold components with an area strictly smaller than this value are removed
+     * @return the filtered vertex weights
+     */
+    template<typename graph_t, typename T>
+    auto area_opening(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, double area_threshold) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights);
+        return component_tree_internal::attribute_filter_from_sorted_vertices(
+                graph, vertex_weights, sorted_vertex_indices, area_threshold,
+                component_tree_internal::filter_attribute::area);
+    }
+
+    /**
+     * Area closing of a vertex weighted graph: removes the connected components of the lower level sets whose area
+     * (number of vertices) is strictly smaller than the given threshold.
+     *
+     * See area_opening (the Min Tree replaces the Max Tree).
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param area_threshold components with an area strictly smaller than this value are removed
+     * @return the filtered vertex weights
+     */
+    template<typename graph_t, typename T>
+    auto area_closing(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, double area_threshold) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights,
+                                                                  std::greater<typename T::value_type>());
+        return component_tree_internal::attribute_filter_from_sorted_vertices(
+                graph, vertex_weights, sorted_vertex_indices, area_threshold,
+                component_tree_internal::filter_attribute::area);
+    }
+
+    /**
+     * Volume opening of a vertex weighted graph: removes the nodes of the Max Tree whose volume (see
+     * attribute_volume) is strictly smaller than the given threshold.
+     *
+     * See area_opening.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param volume_threshold nodes with a volume strictly smaller than this value are removed
+     * @return the filtered vertex weights
+     */
+    template<typename graph_t, typename T>
+    auto volume_opening(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, double volume_threshold) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights);
+        return component_tree_internal::attribute_filter_from_sorted_vertices(
+                graph, vertex_weights, sorted_vertex_indices, volume_threshold,
+                component_tree_internal::filter_attribute::volume);
+    }
+
+    /**
+     * Volume closing of a vertex weighted graph: removes the nodes of the Min Tree whose volume (see
+     * attribute_volume) is strictly smaller than the given threshold.
+     *
+     * See area_opening.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param volume_threshold nodes with a volume strictly smaller than this value are removed
+     * @return the filtered vertex weights
+     */
+    template<typename graph_t, typename T>
+    auto volume_closing(const graph_t &graph, const xt::xexpression<T> &xvertex_weights, double volume_threshold) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights,
+                                                                  std::greater<typename T::value_type>());
+        return component_tree_internal::attribute_filter_from_sorted_vertices(
+                graph, vertex_weights, sorted_vertex_indices, volume_threshold,
+                component_tree_internal::filter_attribute::volume);
+    }
+
+    /**
+     * Area pattern spectrum of a vertex weighted graph: granulometry by area openings for a sequence of increasing
+     * area thresholds, computed in a single union-find sweep without building the Max Tree.
+     *
+     * The i-th value of the result is the sum over all the vertices of the difference between the area openings
+     * (see area_opening) of the vertex weights with the thresholds area_thresholds[i - 1] and area_thresholds[i]
+     * (the area opening with the threshold area_thresholds[-1] is the identity): each node of the Max Tree whose
+     * area a satisfies area_thresholds[i - 1] <= a < area_thresholds[i] contributes its area times the difference
+     * between its altitude and the altitude of its parent.
+     *
+     * The pattern spectrum of closings is obtained by negating the vertex weights.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph
+     * @param vertex_weights graph vertex weights
+     * @param area_thresholds increasing area thresholds
+     * @return an array of the size of area_thresholds
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto area_pattern_spectrum(const graph_t &graph,
+                               const xt::xexpression<T1> &xvertex_weights,
+                               const xt::xexpression<T2> &xarea_thresholds) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        auto &area_thresholds = xarea_thresholds.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+        hg_assert_1d_array(area_thresholds);
+        hg_assert(std::is_sorted(area_thresholds.begin(), area_thresholds.end()),
+                  "Area thresholds must be increasing.");
+
+        using value_type = typename T1::value_type;
+        index_t num_v = num_vertices(graph);
+        std::vector<double> thresholds(area_thresholds.begin(), area_thresholds.end());
+        array_1d<double> spectrum({thresholds.size()}, 0);
+
+        array_1d<index_t> sorted_vertex_indices = stable_arg_sort(vertex_weights);
+        array_1d<index_t> parent({(size_t) num_v}, invalid_index);
+        array_1d<index_t> area = array_1d<index_t>::from_shape({(size_t) num_v});
+
+        component_tree_internal::reverse_sorted_vertex_sweep(
+                graph, sorted_vertex_indices,
+                [&](index_t v) {
+                    parent(v) = v;
+                    area(v) = 1;
+                },
+                [&](index_t v, index_t n) {
+                    if (parent(n) == invalid_index) {
+                        return;
+                    }
+                    auto root = component_tree_internal::find_root_path_halving(parent, n);
+                    if (root == v) {
+                        return;
+                    }
+                    value_type root_level = vertex_weights(root);
+                    value_type level = vertex_weights(v);
+                    if (root_level != level) {
+                        // the node of root is complete and its parent has the level of v
+                        auto bin = std::upper_bound(thresholds.begin(), thresholds.end(), (double) area(root)) -
+                                   thresholds.begin();
+                        if (bin < (index_t) thresholds.size()) {
+                            spectrum(bin) += (double) area(root) * ((double) root_level - (double) level);
+                        }
+                    }
+                    parent(root) = v;
+                    area(v) += area(root);
+                });
+        return spectrum;
+    }
+
+}
+
+#include "../detail/prebuilt.hpp"
+
+#define HG_PREBUILT_COMPONENT_TREE(prefix, value_t)                                                        \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, component_tree_max_tree, ugraph, value_t)                   \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, component_tree_min_tree, ugraph, value_t)                   \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, component_tree_max_tree, regular_grid_graph_2d, value_t)    \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, component_tree_min_tree, regular_grid_graph_2d, value_t)
+
+#ifdef HG_USE_PREBUILT_LIBRARY
+namespace hg {
+    HG_PREBUILT_FOR_EACH_VALUE_TYPE(HG_PREBUILT_COMPONENT_TREE, extern)
 }
+#endif
@@ -0,0 +1,179 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "higra/graph.hpp"
+#include "hierarchy_core.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include "higra/structure/lca_fast.hpp"
+#include "xtensor/xindex_view.hpp"
+
+namespace hg {
+
+    namespace constrained_connectivity_hierarchy_internal {
+
+        /**
+         * Filters a quasi-flat zone hierarchy with the given range of its nodes:
+         *
+         *  - nodes whose range is greater than or equal to the altitude of their parent are removed (the root is never
+         *    removed); and
+         *  - the altitude of the remaining nodes whose range is greater than their altitude is set to their range.
+         *
+         * The altitudes of the nodes are updated in place and the tree is simplified in a single pass.
+         *
+         * @tparam value_t
+         * @tparam range_t
+         * @param t quasi-flat zone hierarchy
+         * @param altitudes altitudes of the quasi-flat zone hierarchy, modified in place
+         * @param range range of the nodes
+         * @return a node weighted tree
+         */
+        template<typename value_t, typename range_t>
+        auto filter_qfz_hierarchy_by_range(const tree &t,
+                                           array_1d<value_t> &altitudes,
+                                           const array_1d<range_t> &range) {
+            const index_t num_v = num_vertices(t);
+            const index_t root_node = root(t);
+            array_1d<bool> violated_constraints = array_1d<bool>::from_shape({(size_t) num_v});
+            parfor(0, num_v, [&t, &altitudes, &range, &violated_constraints, root_node](index_t n) {
+                value_t altitude_parent = (n == root_node) ?
+                                          (std::max)(altitudes(n), static_cast<value_t>(range(n))) :
+                                          altitudes(parent(n, t));
+                value_t node_range = static_cast<value_t>(range(n));
+                violated_constraints(n) = node_range >= altitude_parent;
+                if (node_range > altitudes(n) && node_range < altitude_parent) {
+                    altitudes(n) = node_range;
+                }
+            });
+
+            auto res = simplify_tree(t, violated_constraints);
+            array_1d<value_t> new_altitudes = gather(altitudes, res.node_map);
+            return make_node_weighted_tree(std::move(res.tree), std::move(new_altitudes));
+        }
+    }
+
+    /**
+     * Alpha-omega constrained connectivity hierarchy based on the given vertex weighted graph.
+     *
+     * Let X be a set of vertices, the range of X is the maximal absolute difference between the weights of any two
+     * vertices in X. The alpha-omega constrained connectivity hierarchy is composed of the maximal alpha'-connected sets
+     * of vertices (alpha' <= alpha) with a range lower than or equal to omega, for alpha = omega = k and all positive
+     * k (see constrained_connectivity_hierarchy_alpha_omega in Python for a complete definition).
+     *
+     * See:
+     *
+     *      P. Soille, "Constrained connectivity for hierarchical image partitioning and simplification,"
+     *      in IEEE Transactions on Pattern Analysis and Machine Intelligence, vol. 30, no. 7, pp. 1132-1145, July 2008.
+     *
+     * The quasi-flat zone hierarchy of the graph weighted by the L1 distance between the vertex weights is computed,
+     * the range of its nodes is obtained with a single bottom-up pass on the parents array, and the hierarchy is then
+     * filtered according to the range of its nodes.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xvertex_weights scalar vertex weights
+     * @return a node weighted tree with altitudes of type double
+     */
+    template<typename graph_t, typename T>
+    auto constrained_connectivity_hierarchy_alpha_omega(const graph_t &graph,
+                                                        const xt::xexpression<T> &xvertex_weights) {
+        HG_TRACE();
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert_vertex_weights(graph, vertex_weights);
+        hg_assert_1d_array(vertex_weights);
+        using value_t = typename T::value_type;
+
+        auto edge_weights = weight_graph(graph, vertex_weights, weight_functions::L1);
+        auto qfz = quasi_flat_zone_hierarchy(graph, edge_weights);
+        auto &tree = qfz.tree;
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+
+        // vertex value range inside each region
+        array_1d<value_t> min_value = array_1d<value_t>::from_shape({(size_t) num_v});
+        array_1d<value_t> max_value = array_1d<value_t>::from_shape({(size_t) num_v});
+        std::copy(vertex_weights.cbegin(), vertex_weights.cend(), min_value.begin());
+        std::copy(vertex_weights.cbegin(), vertex_weights.cend(), max_value.begin());
+        std::fill(min_value.begin() + num_l, min_value.end(), std::numeric_limits<value_t>::max());
+        std::fill(max_value.begin() + num_l, max_value.end(), std::numeric_limits<value_t>::lowest());
+        for (index_t n = 0; n < num_v - 1; n++) {
+            const index_t p = parent(n, tree);
+            min_value(p) = (std::min)(min_value(p), min_value(n));
+            max_value(p) = (std::max)(max_value(p), max_value(n));
+        }
+        array_1d<double> value_range = array_1d<double>::from_shape({(size_t) num_v});
+        parfor(0, num_v, [&value_range, &min_value, &max_value](index_t n) {
+            value_range(n) = static_cast<double>(max_value(n)) - static_cast<double>(min_value(n));
+        });
+
+        return constrained_connectivity_hierarchy_internal::filter_qfz_hierarchy_by_range(tree, qfz.altitudes,
+                                                                                          value_range);
+    }
+
+    /**
+     * Strongly constrained connectivity hierarchy based on the given edge weighted graph.
+     *
+     * Let X be a set of vertices, the range of X is the maximal weight of the edges linking two vertices inside X.
+     * The strongly constrained connectivity hierarchy is composed of the maximal alpha'-connected sets of vertices
+     * (alpha' <= alpha) with a range lower than or equal to alpha, for all positive alpha (see
+     * constrained_connectivity_hierarchy_strong_connection in Python for a complete definition).
+     *
+     * See:
+     *
+     *      P. Soille, "Constrained connectivity for hierarchical image partitioning and simplification,"
+     *      in IEEE Transactions on Pattern Analysis and Machine Intelligence, vol. 30, no. 7, pp. 1132-1145, July 2008.
+     *
+     * The quasi-flat zone hierarchy of the graph is computed, the lowest common ancestors of the edges are computed
+     * in a parallel batch (see lca_fast) to obtain the maximal weight of the edges inside each node with a single
+     * bottom-up pass on the parents array, and the hierarchy is then filtered according to the range of its nodes.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights edge weights
+     * @return a node weighted tree
+     */
+    template<typename graph_t, typename T>
+    auto constrained_connectivity_hierarchy_strong_connection(const graph_t &graph,
+                                                              const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_t = typename T::value_type;
+
+        auto qfz = quasi_flat_zone_hierarchy(graph, edge_weights);
+        auto &tree = qfz.tree;
+        const index_t num_v = num_vertices(tree);
+        const index_t num_e = num_edges(graph);
+
+        array_1d<index_t> lca_map = array_1d<index_t>::from_shape({(size_t) num_e});
+        lca_fast lca(tree);
+        lca.for_each_lca(num_e,
+                         [&graph](index_t i) { return (index_t) source(edge_from_index(i, graph), graph); },
+                         [&graph](index_t i) { return (index_t) target(edge_from_index(i, graph), graph); },
+                         [&lca_map](index_t i, index_t n) { lca_map(i) = n; });
+
+        // max edge weights inside each region
+        array_1d<value_t> max_edge_weights = xt::zeros<value_t>({(size_t) num_v});
+        for (index_t i = 0; i < num_e; i++) {
+            max_edge_weights(lca_map(i)) = (std::max)(max_edge_weights(lca_map(i)), edge_weights(i));
+        }
+        for (index_t n = 0; n < num_v - 1; n++) {
+            const index_t p = parent(n, tree);
+            max_edge_weights(p) = (std::max)(max_edge_weights(p), max_edge_weights(n));
+        }
+
+        return constrained_connectivity_hierarchy_internal::filter_qfz_hierarchy_by_range(tree, qfz.altitudes,
+                                                                                          max_edge_weights);
+    }
+}
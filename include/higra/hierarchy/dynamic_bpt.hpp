@@ -0,0 +1,738 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "hierarchy_core.hpp"
+#include <array>
+#include <set>
+#include <vector>
+
+namespace hg {
+
+    /**
+     * Minimum spanning forest of an edge weighted graph maintained under edge insertions, edge removals and edge
+     * weight modifications, from which the canonical binary partition tree of the graph can be obtained
+     * without processing all the graph edges (typically in interactive segmentation, where the user locally modifies
+     * the edge weights of an image graph), or built online from streams of vertices and edges (for example to
+     * maintain the single linkage hierarchy of the last points received from a sensor).
+     *
+     * Edges are compared by weight and ties are broken by edge index (see bpt_canonical): the minimum spanning forest
+     * is thus unique and bpt() is identical to bpt_canonical on the current graph. The edges given at construction
+     * keep their indices, inserted edges get the following indices, and the indices of removed edges are not reused.
+     * Similarly, added vertices get the indices following the existing ones, and the indices of removed vertices are
+     * not reused: the leaves of the binary partition tree are the remaining (active) vertices in increasing order.
+     *
+     * The forest is stored with parent pointers (each tree is rooted at an arbitrary vertex), and the binary partition
+     * tree of each tree of the forest (its Kruskal tree: leaves are vertices and internal nodes are forest edges) is
+     * maintained along: when an edge is added to the forest, the ancestors of its extremities heavier than the edge
+     * are merged (zipped) in a single chain, and when an edge is removed from the forest, the chain of its
+     * ancestors is split (unzipped) between the two resulting trees. With n the number of vertices:
+     *   - decreasing the weight of a non forest edge or inserting an edge walks the forest path between the edge
+     *     extremities: O(length of the path);
+     *   - increasing the weight of a forest edge or removing it searches the lightest edge reconnecting the two
+     *     resulting trees from the smallest one: O(number of edges incident to the smallest tree);
+     *   - each edge added to or removed from the forest, and each weight modification of a forest edge, repairs
+     *     the binary partition tree along the ancestors of the edge and of its extremities: O(depth of the binary
+     *     partition tree + log(n)), and the repair of a removal additionally walks the subtrees hanging from the
+     *     removed ancestors up to their roots;
+     *   - other modifications are in O(1) (plus the update of the incidence lists for removals);
+     *   - removing a vertex removes its incident edges;
+     *   - bpt() copies the maintained binary partition tree with the canonical node numbering: O(n) (plus the
+     *     renumbering of the active vertices if vertices were removed).
+     *
+     * @tparam value_t type of the edge weights
+     */
+    template<typename value_t = double>
+    class dynamic_bpt {
+    public:
+
+        /**
+         * Empty minimum spanning forest on the given number of vertices (without edges).
+         *
+         * @param num_vertices initial number of vertices
+         */
+        dynamic_bpt(index_t num_vertices = 0) {
+            add_vertices(num_vertices);
+        }
+
+        /**
+         * Minimum spanning forest of the given edge weighted graph.
+         *
+         * @tparam graph_t
+         * @tparam T
+         * @param graph input graph
+         * @param xedge_weights input graph edge weights
+         */
+        template<typename graph_t, typename T>
+        dynamic_bpt(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_1d_array(edge_weights);
+            hg_assert((index_t) edge_weights.size() == (index_t) hg::num_edges(graph),
+                      "Edge weights size does not match the number of edges in the graph.");
+
+            const index_t num_v = hg::num_vertices(graph);
+            const index_t num_e = hg::num_edges(graph);
+            auto &&graph_sources = hg::sources(graph);
+            auto &&graph_targets = hg::targets(graph);
+
+            m_sources.assign(graph_sources.begin(), graph_sources.end());
+            m_targets.assign(graph_targets.begin(), graph_targets.end());
+            m_weights.assign(edge_weights.begin(), edge_weights.end());
+            m_alive.assign(num_e, true);
+            m_mst_position.assign(num_e, invalid_index);
+            m_bpt_edge_parent.assign(num_e, invalid_index);
+            m_bpt_children.resize(num_e);
+            m_bpt_edge_label.assign(num_e, 0);
+            add_vertices(num_v);
+            for (index_t e = 0; e < num_e; e++) {
+                add_incident_edge(e);
+            }
+
+            array_1d<value_t> weights = edge_weights;
+            array_1d<index_t> msf = hierarchy_core_internal::minimum_spanning_forest_filter_boruvka(
+                    graph_sources, graph_targets, weights, num_v);
+            for (auto e: msf) {
+                link_forest(e);
+            }
+            build_bpt();
+        }
+
+        /**
+         * Adds the given number of isolated vertices.
+         *
+         * @return index of the first new vertex
+         */
+        index_t add_vertices(index_t num_vertices) {
+            hg_assert(num_vertices >= 0, "Number of vertices must be a positive number.");
+            index_t first = m_parent.size();
+            index_t size = first + num_vertices;
+            m_incident.resize(size);
+            m_parent.resize(size, invalid_index);
+            m_parent_edge.resize(size, invalid_index);
+            m_mark.resize(size, 0);
+            m_bpt_vertex_parent.resize(size, invalid_index);
+            m_bpt_vertex_label.resize(size, 0);
+            m_vertex_alive.resize(size, true);
+            m_num_active_vertices += num_vertices;
+            return first;
+        }
+
+        /**
+         * Removes the given vertex and its incident edges.
+         */
+        void remove_vertex(index_t vertex) {
+            assert_vertex_index(vertex);
+            // the non forest edges are removed first: the removal of the forest edges then never reconnects the trees
+            // through the removed vertex
+            std::vector<index_t> forest_edges;
+            while (!m_incident[vertex].empty()) {
+                index_t e = m_incident[vertex].back();
+                if (is_mst_edge(e)) {
+                    forest_edges.push_back(e);
+                    m_incident[vertex].pop_back();
+                } else {
+                    remove_edge(e);
+                }
+            }
+            m_incident[vertex] = std::move(forest_edges);
+            while (!m_incident[vertex].empty()) {
+                remove_edge(m_incident[vertex].back());
+            }
+            m_vertex_alive[vertex] = false;
+            m_num_active_vertices--;
+        }
+
+        /**
+         * Sliding window: removes the oldest active vertices (the ones with the smallest indices) such that at most
+         * window_size vertices remain.
+         */
+        void keep_last_vertices(index_t window_size) {
+            hg_assert(window_size >= 0, "Window size must be a positive number.");
+            while (m_num_active_vertices > window_size) {
+                while (!m_vertex_alive[m_oldest_vertex]) {
+                    m_oldest_vertex++;
+                }
+                remove_vertex(m_oldest_vertex);
+            }
+        }
+
+        /**
+         * Inserts the edge {source, target} with the given weight.
+         *
+         * @return index of the new edge
+         */
+        index_t insert_edge(index_t source, index_t target, value_t weight) {
+            assert_vertex_index(source);
+            assert_vertex_index(target);
+            index_t e = m_sources.size();
+            m_sources.push_back(source);
+            m_targets.push_back(target);
+            m_weights.push_back(weight);
+            m_alive.push_back(true);
+            m_mst_position.push_back(invalid_index);
+            m_bpt_edge_parent.push_back(invalid_index);
+            m_bpt_children.push_back({invalid_index, invalid_index});
+            m_bpt_edge_label.push_back(0);
+            add_incident_edge(e);
+            insert_non_forest_edge(e);
+            return e;
+        }
+
+        /**
+         * Inserts the edges {sources(i), targets(i)} with the weights weights(i).
+         *
+         * @return index of the first new edge
+         */
+        template<typename T1, typename T2, typename T3>
+        index_t insert_edges(const xt::xexpression<T1> &xsources,
+                             const xt::xexpression<T2> &xtargets,
+                             const xt::xexpression<T3> &xweights) {
+            auto &sources = xsources.derived_cast();
+            auto &targets = xtargets.derived_cast();
+            auto &weights = xweights.derived_cast();
+            hg_assert_1d_array(sources);
+            hg_assert_same_shape(sources, targets);
+            hg_assert_same_shape(sources, weights);
+            index_t first = m_sources.size();
+            for (index_t i = 0; i < (index_t) sources.size(); i++) {
+                insert_edge(sources(i), targets(i), weights(i));
+            }
+            return first;
+        }
+
+        /**
+         * Removes the given edge from the graph.
+         */
+        void remove_edge(index_t edge) {
+            assert_alive_edge(edge);
+            remove_incident_edge(edge);
+            m_alive[edge] = false;
+            if (is_mst_edge(edge)) {
+                cut(edge);
+                reconnect(m_sources[edge], m_targets[edge]);
+            }
+        }
+
+        /**
+         * Sets the weight of the given edge.
+         */
+        void set_edge_weight(index_t edge, value_t weight) {
+            assert_alive_edge(edge);
+            value_t old_weight = m_weights[edge];
+            if (is_mst_edge(edge)) {
+                if (old_weight < weight) {
+                    // the edge is now a non forest edge candidate to reconnect the two trees
+                    cut(edge);
+                    m_weights[edge] = weight;
+                    reconnect(m_sources[edge], m_targets[edge]);
+                } else if (weight < old_weight) {
+                    // the forest is unchanged: only the position of the edge in the binary partition tree changes
+                    bpt_remove(edge);
+                    m_weights[edge] = weight;
+                    bpt_insert(edge);
+                }
+                return;
+            }
+            m_weights[edge] = weight;
+            if (weight < old_weight) {
+                insert_non_forest_edge(edge);
+            }
+        }
+
+        value_t edge_weight(index_t edge) const {
+            return m_weights[edge];
+        }
+
+        bool is_edge_alive(index_t edge) const {
+            return m_alive[edge];
+        }
+
+        /**
+         * True if the given edge belongs to the minimum spanning forest.
+         */
+        bool is_mst_edge(index_t edge) const {
+            return m_mst_position[edge] != invalid_index;
+        }
+
+        bool is_vertex_active(index_t vertex) const {
+            return m_vertex_alive[vertex];
+        }
+
+        /**
+         * Number of vertices of the graph (without the removed vertices).
+         */
+        index_t num_active_vertices() const {
+            return m_num_active_vertices;
+        }
+
+        /**
+         * Indices of the active vertices in increasing order: the i-th leaf of bpt() is the vertex active_vertices()(i).
+         */
+        array_1d<index_t> active_vertices() const {
+            array_1d<index_t> res = array_1d<index_t>::from_shape({(size_t) m_num_active_vertices});
+            index_t n = 0;
+            for (index_t v = 0; v < (index_t) m_vertex_alive.size(); v++) {
+                if (m_vertex_alive[v]) {
+                    res(n++) = v;
+                }
+            }
+            return res;
+        }
+
+        /**
+         * Number of edges of the minimum spanning forest (the number of active vertices minus 1 if the graph is
+         * connected).
+         */
+        index_t num_mst_edges() const {
+            return m_mst_edges.size();
+        }
+
+        /**
+         * Canonical binary partition tree of the current graph (must be connected): the result is identical to the
+         * one of bpt_canonical on the graph made of the active vertices and of the remaining edges (the
+         * mst_edge_map of the result contains edge indices of this structure, and the leaves of the tree are the
+         * active vertices in increasing order, see active_vertices()).
+         *
+         * The maintained tree is copied with the node numbering of bpt_canonical: the i-th internal node is the i-th
+         * forest edge in the order (weight, index).
+         *
+         * @return a node_weighted_tree_and_mst
+         */
+        auto bpt() const {
+            const index_t num_v = m_num_active_vertices;
+            hg_assert(num_mst_edges() == num_v - 1, "The graph must be connected.");
+            const index_t num_nodes = (num_v == 0) ? 0 : 2 * num_v - 1;
+            array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            array_1d<value_t> altitudes = array_1d<value_t>::from_shape({(size_t) num_nodes});
+            array_1d<index_t> mst_edge_map = array_1d<index_t>::from_shape({(size_t) m_mst_edges.size()});
+            // node of each forest edge, only read for the forest edges
+            array_1d<index_t> edge_node_index = array_1d<index_t>::from_shape({m_sources.size()});
+            index_t n = num_v;
+            for (const auto &key: m_sorted_mst_edges) {
+                edge_node_index(key.second) = n;
+                mst_edge_map(n - num_v) = key.second;
+                altitudes(n) = key.first;
+                n++;
+            }
+            auto node_parent_index = [&edge_node_index](index_t parent_edge, index_t node) {
+                return (parent_edge == invalid_index) ? node : edge_node_index(parent_edge);
+            };
+            n = 0;
+            for (index_t v = m_oldest_vertex; v < (index_t) m_vertex_alive.size(); v++) {
+                if (m_vertex_alive[v]) {
+                    parents(n) = node_parent_index(m_bpt_vertex_parent[v], n);
+                    altitudes(n) = 0;
+                    n++;
+                }
+            }
+            for (auto e: mst_edge_map) {
+                const index_t node = edge_node_index(e);
+                parents(node) = node_parent_index(m_bpt_edge_parent[e], node);
+            }
+            return make_node_weighted_tree_and_mst(tree(std::move(parents)), std::move(altitudes),
+                                                   std::move(mst_edge_map));
+        }
+
+    private:
+
+        void assert_vertex_index(index_t vertex) const {
+            hg_assert(vertex >= 0 && vertex < (index_t) m_parent.size() && m_vertex_alive[vertex],
+                      "Invalid vertex index.");
+        }
+
+        void assert_alive_edge(index_t edge) const {
+            hg_assert(edge >= 0 && edge < (index_t) m_alive.size() && m_alive[edge], "Invalid edge index.");
+        }
+
+        /**
+         * Strict total order on edges (weight, then index)
+         */
+        bool less(index_t e1, index_t e2) const {
+            return m_weights[e1] < m_weights[e2] || (!(m_weights[e2] < m_weights[e1]) && e1 < e2);
+        }
+
+        void add_incident_edge(index_t edge) {
+            m_incident[m_sources[edge]].push_back(edge);
+            if (m_sources[edge] != m_targets[edge]) {
+                m_incident[m_targets[edge]].push_back(edge);
+            }
+        }
+
+        void remove_incident_edge(index_t edge) {
+            for (auto v: {m_sources[edge], m_targets[edge]}) {
+                auto &incident = m_incident[v];
+                auto it = std::find(incident.begin(), incident.end(), edge);
+                if (it != incident.end()) {
+                    *it = incident.back();
+                    incident.pop_back();
+                }
+            }
+        }
+
+        /**
+         * Inserts in the forest the given non forest edge if it is lighter than the heaviest edge of the forest path
+         * between its extremities.
+         */
+        void insert_non_forest_edge(index_t edge) {
+            index_t u = m_sources[edge];
+            index_t v = m_targets[edge];
+            if (u == v) {
+                return;
+            }
+            index_t heaviest = path_max_edge(u, v);
+            if (heaviest == invalid_index) { // u and v are in different trees
+                link(edge);
+            } else if (less(edge, heaviest)) {
+                cut(heaviest);
+                link(edge);
+            }
+        }
+
+        /**
+         * Heaviest edge on the forest path between the distinct vertices u and v (invalid_index if u and v are in
+         * different trees).
+         */
+        index_t path_max_edge(index_t u, index_t v) {
+            index_t stamp = ++m_stamp;
+            for (index_t x = u; x != invalid_index; x = m_parent[x]) {
+                m_mark[x] = stamp;
+            }
+            index_t ancestor = v;
+            while (ancestor != invalid_index && m_mark[ancestor] != stamp) {
+                ancestor = m_parent[ancestor];
+            }
+            if (ancestor == invalid_index) {
+                return invalid_index;
+            }
+            index_t heaviest = invalid_index;
+            for (auto x: {u, v}) {
+                for (; x != ancestor; x = m_parent[x]) {
+                    if (heaviest == invalid_index || less(heaviest, m_parent_edge[x])) {
+                        heaviest = m_parent_edge[x];
+                    }
+                }
+            }
+            return heaviest;
+        }
+
+        /**
+         * Makes the given vertex the root of its tree.
+         */
+        void reroot(index_t vertex) {
+            index_t previous = invalid_index;
+            index_t previous_edge = invalid_index;
+            index_t current = vertex;
+            while (current != invalid_index) {
+                index_t next = m_parent[current];
+                index_t next_edge = m_parent_edge[current];
+                m_parent[current] = previous;
+                m_parent_edge[current] = previous_edge;
+                previous = current;
+                previous_edge = next_edge;
+                current = next;
+            }
+        }
+
+        /**
+         * Adds the given edge, whose extremities are in different trees, to the forest and to the binary partition
+         * tree.
+         */
+        void link(index_t edge) {
+            link_forest(edge);
+            bpt_insert(edge);
+        }
+
+        /**
+         * Adds the given edge, whose extremities are in different trees, to the forest only.
+         */
+        void link_forest(index_t edge) {
+            index_t u = m_sources[edge];
+            reroot(u);
+            m_parent[u] = m_targets[edge];
+            m_parent_edge[u] = edge;
+            m_mst_position[edge] = m_mst_edges.size();
+            m_mst_edges.push_back(edge);
+        }
+
+        /**
+         * Removes the given edge from the forest and from the binary partition tree.
+         */
+        void cut(index_t edge) {
+            bpt_remove(edge);
+            index_t child = (m_parent_edge[m_sources[edge]] == edge) ? m_sources[edge] : m_targets[edge];
+            m_parent[child] = invalid_index;
+            m_parent_edge[child] = invalid_index;
+            index_t position = m_mst_position[edge];
+            m_mst_edges[position] = m_mst_edges.back();
+            m_mst_position[m_mst_edges[position]] = position;
+            m_mst_edges.pop_back();
+            m_mst_position[edge] = invalid_index;
+        }
+
+        /**
+         * Links the trees containing the vertices a and b (previously in the same tree) with the lightest non forest
+         * edge between them if any.
+         *
+         * The two trees are explored simultaneously (one vertex of each tree at a time) until one of them is
+         * entirely explored: the lightest reconnecting edge is then searched among the edges incident to this tree.
+         */
+        void reconnect(index_t a, index_t b) {
+            index_t stamp_a = ++m_stamp;
+            index_t stamp_b = ++m_stamp;
+            std::vector<index_t> queue_a{a};
+            std::vector<index_t> queue_b{b};
+            m_mark[a] = stamp_a;
+            m_mark[b] = stamp_b;
+            index_t next_a = 0;
+            index_t next_b = 0;
+
+            auto explore = [this](std::vector<index_t> &queue, index_t &next, index_t stamp) {
+                index_t x = queue[next++];
+                for (auto e: m_incident[x]) {
+                    if (is_mst_edge(e)) {
+                        index_t y = (m_sources[e] == x) ? m_targets[e] : m_sources[e];
+                        if (m_mark[y] != stamp) {
+                            m_mark[y] = stamp;
+                            queue.push_back(y);
+                        }
+                    }
+                }
+            };
+
+            std::vector<index_t> *component;
+            index_t component_stamp;
+            while (true) {
+                if (next_a == (index_t) queue_a.size()) {
+                    component = &queue_a;
+                    component_stamp = stamp_a;
+                    break;
+                }
+                explore(queue_a, next_a, stamp_a);
+                if (next_b == (index_t) queue_b.size()) {
+                    component = &queue_b;
+                    component_stamp = stamp_b;
+                    break;
+                }
+                explore(queue_b, next_b, stamp_b);
+            }
+
+            index_t lightest = invalid_index;
+            for (auto x: *component) {
+                for (auto e: m_incident[x]) {
+                    index_t y = (m_sources[e] == x) ? m_targets[e] : m_sources[e];
+                    if (m_mark[y] != component_stamp && (lightest == invalid_index || less(e, lightest))) {
+                        lightest = e;
+                    }
+                }
+            }
+            if (lightest != invalid_index) {
+                link(lightest);
+            }
+        }
+
+        // nodes of the binary partition tree: the vertex v is the leaf 2 * v and the forest edge e is the internal
+        // node 2 * e + 1
+        static index_t leaf_node(index_t vertex) {
+            return 2 * vertex;
+        }
+
+        static index_t edge_node(index_t edge) {
+            return 2 * edge + 1;
+        }
+
+        static bool is_edge_node(index_t node) {
+            return (node & 1) != 0;
+        }
+
+        // parent (a forest edge, or invalid_index for a root) of a node of the binary partition tree
+        index_t &node_parent(index_t node) {
+            return is_edge_node(node) ? m_bpt_edge_parent[node >> 1] : m_bpt_vertex_parent[node >> 1];
+        }
+
+        // label of a node in the traversal of the given stamp (see bpt_cut), -1 if the node is not labelled
+        index_t node_label(index_t node, index_t stamp) const {
+            index_t label = is_edge_node(node) ? m_bpt_edge_label[node >> 1] : m_bpt_vertex_label[node >> 1];
+            return (label / 4 == stamp) ? label % 4 : -1;
+        }
+
+        void set_node_label(index_t node, index_t stamp, index_t label) {
+            (is_edge_node(node) ? m_bpt_edge_label[node >> 1] : m_bpt_vertex_label[node >> 1]) = 4 * stamp + label;
+        }
+
+        /**
+         * Binary partition tree of the initial forest, with Kruskal algorithm.
+         */
+        void build_bpt() {
+            std::vector<index_t> sorted_edges(m_mst_edges);
+            std::sort(sorted_edges.begin(), sorted_edges.end(), [this](index_t e1, index_t e2) {
+                return less(e1, e2);
+            });
+            // union find on the vertices, the canonical element of each set holds the root of its tree
+            std::vector<index_t> sets(m_parent.size());
+            std::vector<index_t> roots(m_parent.size());
+            for (index_t v = 0; v < (index_t) m_parent.size(); v++) {
+                sets[v] = v;
+                roots[v] = leaf_node(v);
+            }
+            auto find = [&sets](index_t x) {
+                while (sets[x] != x) {
+                    sets[x] = sets[sets[x]];
+                    x = sets[x];
+                }
+                return x;
+            };
+            for (auto e: sorted_edges) {
+                index_t c1 = find(m_sources[e]);
+                index_t c2 = find(m_targets[e]);
+                m_bpt_children[e] = {roots[c1], roots[c2]};
+                node_parent(roots[c1]) = e;
+                node_parent(roots[c2]) = e;
+                sets[c1] = c2;
+                roots[c2] = edge_node(e);
+                m_sorted_mst_edges.emplace_hint(m_sorted_mst_edges.end(), m_weights[e], e);
+            }
+        }
+
+        void bpt_insert(index_t edge) {
+            m_sorted_mst_edges.emplace(m_weights[edge], edge);
+            bpt_link(edge);
+        }
+
+        void bpt_remove(index_t edge) {
+            m_sorted_mst_edges.erase(std::make_pair(m_weights[edge], edge));
+            bpt_cut(edge);
+        }
+
+        /**
+         * Adds the given edge, whose extremities are in different trees, to the binary partition tree: the edge
+         * becomes the parent of the largest ancestors of its extremities lighter than itself, and the two chains of
+         * heavier ancestors are merged by increasing order.
+         */
+        void bpt_link(index_t edge) {
+            const index_t extremities[2] = {m_sources[edge], m_targets[edge]};
+            index_t below[2];
+            std::vector<index_t> chains[2];
+            for (index_t i = 0; i < 2; i++) {
+                index_t n = leaf_node(extremities[i]);
+                index_t p = node_parent(n);
+                while (p != invalid_index && less(p, edge)) {
+                    n = edge_node(p);
+                    p = m_bpt_edge_parent[p];
+                }
+                below[i] = n;
+                for (; p != invalid_index; p = m_bpt_edge_parent[p]) {
+                    chains[i].push_back(p);
+                }
+            }
+            m_bpt_children[edge] = {below[0], below[1]};
+            node_parent(below[0]) = edge;
+            node_parent(below[1]) = edge;
+
+            // each node of the merged chain replaces the child of the next node on its former chain
+            index_t previous = edge;
+            index_t former_child[2] = {below[0], below[1]};
+            size_t next[2] = {0, 0};
+            while (next[0] < chains[0].size() || next[1] < chains[1].size()) {
+                index_t c = (next[1] == chains[1].size() ||
+                             (next[0] < chains[0].size() && less(chains[0][next[0]], chains[1][next[1]]))) ? 0 : 1;
+                index_t a = chains[c][next[c]++];
+                auto &children = m_bpt_children[a];
+                (children[0] == former_child[c] ? children[0] : children[1]) = edge_node(previous);
+                m_bpt_edge_parent[previous] = a;
+                former_child[c] = edge_node(a);
+                previous = a;
+            }
+            m_bpt_edge_parent[previous] = invalid_index;
+        }
+
+        /**
+         * Removes the given edge from the binary partition tree: the chain of the ancestors of the edge is split
+         * between the two trees containing its children. Each ancestor is an edge between a vertex of its other
+         * child subtree and a vertex of one of the two trees, found by walking up from the vertex until a node
+         * already assigned to a tree is met.
+         */
+        void bpt_cut(index_t edge) {
+            const index_t stamp = ++m_bpt_stamp;
+            const index_t other_label = 2;
+            index_t tops[2] = {m_bpt_children[edge][0], m_bpt_children[edge][1]};
+            set_node_label(tops[0], stamp, 0);
+            set_node_label(tops[1], stamp, 1);
+            auto side_of = [this, stamp](index_t vertex) {
+                index_t n = leaf_node(vertex);
+                index_t label;
+                while ((label = node_label(n, stamp)) < 0) {
+                    n = edge_node(node_parent(n));
+                }
+                return label;
+            };
+
+            index_t previous = edge_node(edge);
+            index_t a = m_bpt_edge_parent[edge];
+            while (a != invalid_index) {
+                const index_t next = m_bpt_edge_parent[a];
+                auto &children = m_bpt_children[a];
+                const index_t chain_child = (children[0] == previous) ? 0 : 1;
+                const index_t other = children[1 - chain_child];
+                set_node_label(other, stamp, other_label);
+                index_t side = side_of(m_sources[a]);
+                if (side == other_label) {
+                    side = side_of(m_targets[a]);
+                }
+                children[chain_child] = tops[side];
+                node_parent(tops[side]) = a;
+                tops[side] = edge_node(a);
+                set_node_label(other, stamp, side);
+                set_node_label(tops[side], stamp, side);
+                previous = edge_node(a);
+                a = next;
+            }
+            node_parent(tops[0]) = invalid_index;
+            node_parent(tops[1]) = invalid_index;
+            m_bpt_edge_parent[edge] = invalid_index;
+        }
+
+        // edges of the graph (removed edges are kept with m_alive false)
+        std::vector<index_t> m_sources;
+        std::vector<index_t> m_targets;
+        std::vector<value_t> m_weights;
+        std::vector<bool> m_alive;
+        // indices of the edges incident to each vertex (without the removed edges)
+        std::vector<std::vector<index_t>> m_incident;
+
+        // minimum spanning forest: edge list, position of each edge in the list (invalid_index if not in the forest),
+        // parent and edge to the parent of each vertex (invalid_index for the roots)
+        std::vector<index_t> m_mst_edges;
+        std::vector<index_t> m_mst_position;
+        std::vector<index_t> m_parent;
+        std::vector<index_t> m_parent_edge;
+
+        // vertex marks of the forest traversals (a new stamp is used for each traversal)
+        std::vector<index_t> m_mark;
+        index_t m_stamp = 0;
+
+        // binary partition tree of the forest: parent (a forest edge or invalid_index) of each vertex and of each
+        // forest edge, and children of each forest edge
+        std::vector<index_t> m_bpt_vertex_parent;
+        std::vector<index_t> m_bpt_edge_parent;
+        std::vector<std::array<index_t, 2>> m_bpt_children;
+        // forest edges in the order of the internal nodes of bpt_canonical
+        std::set<std::pair<value_t, index_t>> m_sorted_mst_edges;
+        // node labels of the splits of the binary partition tree (4 * stamp + label)
+        std::vector<index_t> m_bpt_vertex_label;
+        std::vector<index_t> m_bpt_edge_label;
+        index_t m_bpt_stamp = 0;
+
+        // removed vertices are kept with m_vertex_alive false, vertices before m_oldest_vertex are all removed
+        std::vector<bool> m_vertex_alive;
+        index_t m_num_active_vertices = 0;
+        index_t m_oldest_vertex = 0;
+    };
+}
@@ -0,0 +1,190 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "common.hpp"
+#include "../graph.hpp"
+#include "../algo/graph_core.hpp"
+#include "../algo/rag.hpp"
+#include "../accumulator/accumulator.hpp"
+#include "../structure/tree_graph.hpp"
+
+namespace hg {
+
+    /**
+     * Result of hierarchy_on_collapsed_flat_zones: a hierarchy and its node altitudes, and the leaf vertex_map(v) of
+     * the hierarchy containing the vertex v of the graph (identity if the leaves have been expanded to the vertices
+     * of the graph).
+     *
+     * @tparam tree_t
+     * @tparam altitude_t
+     */
+    template<typename tree_t, typename altitude_t>
+    struct collapsed_node_weighted_tree {
+        tree_t tree;
+        altitude_t altitudes;
+        array_1d<index_t> vertex_map;
+    };
+
+    /**
+     * Expands a hierarchy whose leaves are the regions of a partition of the vertices of a graph (typically the
+     * vertices of a region adjacency graph) into a hierarchy whose leaves are the vertices of the graph.
+     *
+     * Each region containing several vertices becomes a node of altitude region_altitude, parent of its vertices. A
+     * region made of a single vertex is replaced by this vertex. The nodes of the result are, in this order, the
+     * vertices of the graph, the regions made of several vertices, and the non leaf nodes of the given tree.
+     *
+     * The altitudes of the non leaf nodes of the given tree must be greater than or equal to region_altitude for the
+     * result to be a valid hierarchy.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param vertex_map region (leaf of the tree) of each vertex of the graph
+     * @param tree hierarchy whose leaves are the regions
+     * @param xaltitudes node altitudes of the hierarchy
+     * @param region_altitude altitude of the nodes representing the regions
+     * @return a node_weighted_tree
+     */
+    template<typename tree_t, typename T>
+    auto expand_collapsed_hierarchy(const array_1d<index_t> &vertex_map,
+                                    const tree_t &tree,
+                                    const xt::xexpression<T> &xaltitudes,
+                                    double region_altitude = 0) {
+        HG_TRACE();
+        auto &altitudes = xaltitudes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        using value_type = typename T::value_type;
+
+        const index_t num_v = vertex_map.size();
+        const index_t num_regions = num_leaves(tree);
+        const index_t num_tree_nodes = num_vertices(tree);
+
+        array_1d<index_t> region_sizes = xt::zeros<index_t>({(size_t) num_regions});
+        for (index_t v = 0; v < num_v; v++) {
+            hg_assert(vertex_map(v) >= 0 && vertex_map(v) < num_regions,
+                      "Vertex map values must be leaves of the tree.");
+            region_sizes(vertex_map(v))++;
+        }
+
+        // index of each node of the tree in the result
+        array_1d<index_t> node_map = array_1d<index_t>::from_shape({(size_t) num_tree_nodes});
+        for (index_t v = 0; v < num_v; v++) {
+            node_map(vertex_map(v)) = v;
+        }
+        index_t num_nodes = num_v;
+        for (index_t r = 0; r < num_regions; r++) {
+            if (region_sizes(r) > 1) {
+                node_map(r) = num_nodes++;
+            }
+        }
+        for (index_t n = num_regions; n < num_tree_nodes; n++) {
+            node_map(n) = num_nodes++;
+        }
+
+        array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) num_nodes});
+        array_1d<value_type> new_altitudes = array_1d<value_type>::from_shape({(size_t) num_nodes});
+        for (index_t v = 0; v < num_v; v++) {
+            auto r = vertex_map(v);
+            parents(v) = (region_sizes(r) > 1) ? node_map(r) : node_map(parent(r, tree));
+            new_altitudes(v) = 0;
+        }
+        for (index_t n = 0; n < num_tree_nodes; n++) {
+            if (n >= num_regions || region_sizes(n) > 1) {
+                parents(node_map(n)) = node_map(parent(n, tree));
+                new_altitudes(node_map(n)) = (n < num_regions) ? static_cast<value_type>(region_altitude)
+                                                               : altitudes(n);
+            }
+        }
+
+        return make_node_weighted_tree(hg::tree(std::move(parents)), std::move(new_altitudes));
+    }
+
+    /**
+     * Computes a hierarchy of an edge weighted graph on its flat zones: the connected components of the graph
+     * restricted to the edges of weight smaller than or equal to threshold (computed in parallel) are first collapsed
+     * into the vertices of a region adjacency graph, and the hierarchy is then computed by hierarchy_function on
+     * this region adjacency graph.
+     *
+     * On quantized images, most edges usually have a weight equal to 0: this avoids to process them through the
+     * sorting or heap machinery of the hierarchy construction, and to create as many nodes of altitude 0 that
+     * are removed afterwards by simplify_tree.
+     *
+     * hierarchy_function is called with the region adjacency graph (see region_adjacency_graph) and the weights of
+     * its edges (the minimum weight of the edges of the graph between two regions). It must return a
+     * node_weighted_tree (or any structure with the fields tree and altitudes) whose leaves are the vertices of
+     * the region adjacency graph, for example:
+     *
+     *      auto res = hierarchy_on_collapsed_flat_zones(graph, edge_weights,
+     *              [](const region_adjacency_graph &rag, const array_1d<double> &rag_edge_weights) {
+     *                  return binary_partition_tree_complete_linkage(rag.rag, rag_edge_weights);
+     *              });
+     *
+     * Linkages other than the min linkage may use rag_accumulate on the edge_map of the region adjacency graph to
+     * compute the weights they need (for example the number of graph edges between two regions for the average
+     * linkage).
+     *
+     * If expand_leaves is true, the leaves of the result are expanded to the vertices of the graph and vertex_map is
+     * the identity: the flat zones made of several vertices become nodes of altitude threshold (see
+     * expand_collapsed_hierarchy). Otherwise, the leaves of the result are the flat zones and vertex_map is the
+     * vertex_map of the region adjacency graph.
+     *
+     * With bpt_canonical (min linkage), the expanded result has the same saliency map as the canonical binary
+     * partition tree of the graph on the edges of saliency greater than threshold (with a threshold equal to 0 on
+     * non negative edge weights, the saliency maps are identical). For the other linkages, the flat zones act as a
+     * pre-segmentation of the graph.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @tparam hierarchy_function_t
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph
+     * @param hierarchy_function function computing the hierarchy of the region adjacency graph
+     * @param threshold edges of weight smaller than or equal to threshold are collapsed
+     * @param expand_leaves if true, the leaves of the result are the vertices of the graph
+     * @return a collapsed_node_weighted_tree
+     */
+    template<typename graph_t, typename T, typename hierarchy_function_t>
+    auto hierarchy_on_collapsed_flat_zones(const graph_t &graph,
+                                           const xt::xexpression<T> &xedge_weights,
+                                           const hierarchy_function_t &hierarchy_function,
+                                           double threshold = 0,
+                                           bool expand_leaves = false) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_type = typename T::value_type;
+
+        // a thresholded edge map is not a closed graph cut (an edge of weight greater than threshold may link two
+        // vertices of the same flat zone): the rag is built from the labels of the flat zones instead
+        array_1d<index_t> flat_zones = parallel_connected_components(
+                graph,
+                [&edge_weights, &graph, threshold](const auto &e) {
+                    return edge_weights(index(e, graph)) <= threshold;
+                });
+        auto rag = make_region_adjacency_graph_from_labelisation(execution::par, graph, flat_zones);
+        array_1d<value_type> rag_edge_weights = rag_accumulate(rag.edge_map, edge_weights, accumulator_min());
+
+        auto res = hierarchy_function(static_cast<const region_adjacency_graph &>(rag), rag_edge_weights);
+        using altitude_type = array_1d<typename std::decay_t<decltype(res.altitudes)>::value_type>;
+
+        if (!expand_leaves) {
+            return collapsed_node_weighted_tree<hg::tree, altitude_type>{
+                    std::move(res.tree), std::move(res.altitudes), std::move(rag.vertex_map)};
+        }
+        auto expanded = expand_collapsed_hierarchy(rag.vertex_map, res.tree, res.altitudes, threshold);
+        return collapsed_node_weighted_tree<hg::tree, altitude_type>{
+                std::move(expanded.tree),
+                std::move(expanded.altitudes),
+                xt::arange<index_t>(num_vertices(graph))};
+    }
+}
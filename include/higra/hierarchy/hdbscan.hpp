@@ -0,0 +1,286 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "hierarchy_core.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace hg {
+
+    /**
+     * A simple structure to hold the result of condense_hierarchy and hdbscan_hierarchy.
+     *
+     * @tparam tree_t
+     * @tparam altitude_t
+     */
+    template<typename tree_t, typename altitude_t>
+    struct condensed_hierarchy {
+        tree_t tree;
+        altitude_t altitudes;
+        array_1d<double> stability;
+    };
+
+    template<typename tree_t, typename altitude_t>
+    decltype(auto) make_condensed_hierarchy(tree_t &&tree,
+                                            altitude_t &&altitudes,
+                                            array_1d<double> &&stability) {
+        return condensed_hierarchy<tree_t, altitude_t>{std::forward<tree_t>(tree),
+                                                       std::forward<altitude_t>(altitudes),
+                                                       std::forward<array_1d<double>>(stability)};
+    }
+
+    /**
+     * Core distances of the vertices of an edge weighted graph, typically a k-nearest neighbour graph whose edge
+     * weights are distances.
+     *
+     * The core distance of a vertex is the distance to its min_samples-th nearest neighbour, the vertex itself being
+     * counted as its first neighbour (as in the hdbscan library): it is thus the (min_samples - 1)-th smallest
+     * weight of the edges adjacent to the vertex. If the vertex has less adjacent edges, its core distance is the
+     * largest weight of its adjacent edges. The core distance of an isolated vertex, or of any vertex if
+     * min_samples is smaller than or equal to 1, is 0.
+     *
+     * The vertices are processed in parallel.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph
+     * @param min_samples number of samples in the neighbourhood of a core point
+     * @return a 1d array of vertex weights
+     */
+    template<typename graph_t, typename T>
+    auto core_distances(const graph_t &graph, const xt::xexpression<T> &xedge_weights, index_t min_samples) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_type = typename T::value_type;
+
+        const index_t num_v = num_vertices(graph);
+        auto result = parallel_zeros<array_1d<value_type>>({(size_t) num_v});
+        if (min_samples <= 1) {
+            return result;
+        }
+        parfor(0, num_v, [&graph, &edge_weights, &result, min_samples](index_t v) {
+            workspace_vector<value_type> weights;
+            for (auto e: out_edge_iterator(v, graph)) {
+                weights.push_back(edge_weights(index(e, graph)));
+            }
+            if (weights.empty()) {
+                return;
+            }
+            const index_t k = (std::min)(min_samples - 1, (index_t) weights.size()) - 1;
+            std::nth_element(weights.begin(), weights.begin() + k, weights.end());
+            result(v) = weights[k];
+        });
+        return result;
+    }
+
+    /**
+     * Mutual reachability distance of the edges of an edge weighted graph: the weight of an edge {x, y} becomes
+     * the maximum of its weight and of the core distances of x and y (see core_distances).
+     *
+     * The edges are processed in parallel.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph
+     * @param xcore_distances core distances of the vertices of the input graph
+     * @return a 1d array of edge weights
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto mutual_reachability_weights(const graph_t &graph,
+                                     const xt::xexpression<T1> &xedge_weights,
+                                     const xt::xexpression<T2> &xcore_distances) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &core_distances = xcore_distances.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        hg_assert_vertex_weights(graph, core_distances);
+        hg_assert_1d_array(core_distances);
+        using value_type = typename T1::value_type;
+
+        const index_t num_e = num_edges(graph);
+        array_1d<value_type> result = array_1d<value_type>::from_shape({(size_t) num_e});
+        parfor(0, num_e, [&graph, &edge_weights, &core_distances, &result](index_t i) {
+            auto e = edge_from_index(i, graph);
+            result(i) = (std::max)({edge_weights(i),
+                                    (value_type) core_distances(source(e, graph)),
+                                    (value_type) core_distances(target(e, graph))});
+        });
+        return result;
+    }
+
+    /**
+     * Condensed tree of a hierarchy for a given minimum cluster size, as in HDBSCAN*.
+     *
+     * A node of the input tree is a cluster if it is the root, or if it contains at least min_cluster_size leaves
+     * and at least one of its siblings also contains at least min_cluster_size leaves. The condensed tree is the
+     * input tree simplified such that only its clusters and its leaves remain (see simplify_tree): the parent of a
+     * leaf is thus the smallest cluster containing it, from which it falls out as noise or when the cluster splits.
+     *
+     * The altitude of a node of the condensed tree is the altitude at which the cluster vanishes (smallest
+     * altitude of the nodes of the input tree merged into the cluster); leaves have altitude 0.
+     *
+     * The stability of a cluster C born at altitude b (altitude of the parent of the cluster in the input tree, or
+     * infinity for the root) is the sum over its leaves p of 1 / a_p - 1 / b, where a_p is the altitude at which p
+     * leaves C. The stability of the leaves is 0. Altitudes equal to 0 lead to infinite stabilities.
+     *
+     * The areas, the clusters, their lifetimes and their stabilities are computed in one bottom-up and one top-down
+     * traversal of the input tree, followed by the simplification.
+     *
+     * R. J. G. B. Campello, D. Moulavi, J. Sander, "Density-Based Clustering Based on Hierarchical Density
+     * Estimates," PAKDD 2013.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree input tree (with increasing altitudes)
+     * @param xaltitudes altitudes of the nodes of the input tree
+     * @param min_cluster_size minimum number of leaves of a cluster (at least 2)
+     * @return a condensed_hierarchy
+     */
+    template<typename tree_t, typename T>
+    auto condense_hierarchy(const tree_t &tree, const xt::xexpression<T> &xaltitudes, index_t min_cluster_size) {
+        HG_TRACE();
+        auto &altitudes = xaltitudes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        hg_assert(min_cluster_size >= 2, "Minimum cluster size must be greater than or equal to 2.");
+        using value_type = typename T::value_type;
+
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        const index_t root_node = root(tree);
+        auto &parents = tree.parents();
+
+        // number of leaves and number of children with at least min_cluster_size leaves
+        workspace_array_1d<index_t> area = workspace_array_1d<index_t>::from_shape({(size_t) num_v});
+        workspace_array_1d<index_t> num_large_children = xt::zeros<index_t>({(size_t) num_v});
+        xt::view(area, xt::range(0, num_l)) = 1;
+        xt::view(area, xt::range(num_l, num_v)) = 0;
+        for (index_t n = 0; n < root_node; n++) {
+            area(parents(n)) += area(n);
+            if (area(n) >= min_cluster_size) {
+                num_large_children(parents(n))++;
+            }
+        }
+
+        // cluster containing each node with at least min_cluster_size leaves (invalid_index for other nodes),
+        // death altitude and stability of each cluster
+        workspace_array_1d<index_t> owner = workspace_array_1d<index_t>::from_shape({(size_t) num_v});
+        array_1d<bool> removed = xt::ones<bool>({(size_t) num_v});
+        workspace_array_1d<double> birth_lambda = workspace_array_1d<double>::from_shape({(size_t) num_v});
+        array_1d<value_type> death = array_1d<value_type>::from_shape({(size_t) num_v});
+        array_1d<double> stability = xt::zeros<double>({(size_t) num_v});
+
+        owner(root_node) = root_node;
+        removed(root_node) = false;
+        birth_lambda(root_node) = 0;
+        death(root_node) = altitudes(root_node);
+        for (index_t n = root_node - 1; n >= 0; n--) {
+            const index_t p = parents(n);
+            const index_t c = owner(p);
+            const bool large = area(n) >= min_cluster_size;
+            if (large && num_large_children(p) >= 2) {
+                // new cluster
+                owner(n) = n;
+                removed(n) = false;
+                birth_lambda(n) = 1.0 / (double) altitudes(p);
+                death(n) = altitudes(n);
+            } else {
+                owner(n) = large ? c : invalid_index;
+            }
+            if (c == invalid_index) {
+                continue;
+            }
+            if (large && num_large_children(p) == 1) {
+                // the cluster of p continues in n
+                death(c) = (std::min)(death(c), (value_type) altitudes(n));
+            } else {
+                // the leaves of n leave the cluster of p
+                stability(c) += (double) area(n) * (1.0 / (double) altitudes(p) - birth_lambda(c));
+            }
+        }
+
+        auto res = simplify_tree(tree, removed);
+        auto &node_map = res.node_map;
+        const index_t num_nodes = node_map.size();
+        array_1d<value_type> condensed_altitudes = array_1d<value_type>::from_shape({(size_t) num_nodes});
+        array_1d<double> condensed_stability = array_1d<double>::from_shape({(size_t) num_nodes});
+        for (index_t i = 0; i < num_nodes; i++) {
+            if (i < num_l) {
+                condensed_altitudes(i) = 0;
+                condensed_stability(i) = 0;
+            } else {
+                condensed_altitudes(i) = death(node_map(i));
+                condensed_stability(i) = stability(node_map(i));
+            }
+        }
+        return make_condensed_hierarchy(std::move(res.tree), std::move(condensed_altitudes),
+                                        std::move(condensed_stability));
+    }
+
+    /**
+     * HDBSCAN* hierarchy of an edge weighted graph, typically a k-nearest neighbour graph whose edge weights are
+     * distances between points.
+     *
+     * The pipeline is:
+     *
+     *  1. compute the core distances of the vertices (see core_distances),
+     *  2. reweight the edges by the mutual reachability distance (see mutual_reachability_weights),
+     *  3. compute the canonical binary partition tree of the reweighted graph (single linkage clustering),
+     *  4. condense the binary partition tree with the given minimum cluster size and compute the stability of
+     *     each cluster (see condense_hierarchy).
+     *
+     * The input graph must be connected (a k-nearest neighbour graph augmented with the edges of a minimum
+     * spanning tree of the complete graph is for example suitable).
+     *
+     * R. J. G. B. Campello, D. Moulavi, J. Sander, "Density-Based Clustering Based on Hierarchical Density
+     * Estimates," PAKDD 2013.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights edge weights of the input graph (distances)
+     * @param min_samples number of samples in the neighbourhood of a core point
+     * @param min_cluster_size minimum number of vertices of a cluster (at least 2)
+     * @return a condensed_hierarchy
+     */
+    template<typename graph_t, typename T>
+    auto hdbscan_hierarchy(const graph_t &graph,
+                           const xt::xexpression<T> &xedge_weights,
+                           index_t min_samples,
+                           index_t min_cluster_size) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        auto mr_weights = mutual_reachability_weights(graph, edge_weights,
+                                                      core_distances(graph, edge_weights, min_samples));
+
+        array_1d<index_t> sorted_edges_indices = stable_arg_sort(mr_weights);
+        auto bpt = hierarchy_core_internal::bpt_canonical_from_sorted_edges(sources(graph),
+                                                                            targets(graph),
+                                                                            sorted_edges_indices,
+                                                                            num_vertices(graph));
+        auto res = hierarchy_core_internal::make_bpt_canonical_result(graph,
+                                                                      mr_weights,
+                                                                      std::move(bpt.first),
+                                                                      std::move(bpt.second));
+        return condense_hierarchy(res.tree, res.altitudes, min_cluster_size);
+    }
+}
@@ -0,0 +1,524 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "hierarchy_core.hpp"
+#include "watershed_hierarchy.hpp"
+#include "../algo/graph_weights.hpp"
+#include "../attribute/tree_attribute.hpp"
+#include "../structure/lca_fast.hpp"
+
+namespace hg {
+
+    /**
+     * Batch of trees stored in concatenated arrays, typically the hierarchies of a stack of same-shape images.
+     *
+     * The nodes of the i-th tree are stored in the range [offsets(i), offsets(i + 1)) of parents and altitudes:
+     * parents(offsets(i) + n) is the parent of the node n of the i-th tree (parents are given by their index in their
+     * own tree, so that each range of the parents array is a valid parents array).
+     *
+     * For the binary partition trees of a graph (bpt_canonical_batch, watershed_hierarchy_batch), mst_edge_map is a 2d
+     * array whose i-th row is the minimum spanning tree edge map of the i-th tree (see bpt_canonical). It is empty
+     * otherwise.
+     *
+     * @tparam value_t value type of the altitudes
+     */
+    template<typename value_t>
+    struct tree_batch {
+        array_1d<index_t> parents;
+        array_1d<value_t> altitudes;
+        array_1d<index_t> offsets = xt::zeros<index_t>({1});
+        array_2d<index_t> mst_edge_map;
+
+        index_t num_trees() const {
+            return (index_t) offsets.size() - 1;
+        }
+
+        /**
+         * Tree of index i of the batch
+         */
+        hg::tree get_tree(index_t i) const {
+            return hg::tree(array_1d<index_t>(xt::view(parents, xt::range(offsets(i), offsets(i + 1)))));
+        }
+
+        /**
+         * View on the node altitudes of the tree of index i of the batch
+         */
+        auto tree_altitudes(index_t i) const {
+            return xt::view(altitudes, xt::range(offsets(i), offsets(i + 1)));
+        }
+    };
+
+    /**
+     * Creates a batch of trees from its concatenated arrays (see tree_batch).
+     *
+     * @param xparents concatenated parents arrays
+     * @param xaltitudes concatenated node altitudes
+     * @param xoffsets start of each tree in the concatenated arrays, followed by the total number of nodes
+     * @return a tree_batch
+     */
+    template<typename T1, typename T2, typename T3>
+    auto make_tree_batch(const xt::xexpression<T1> &xparents,
+                         const xt::xexpression<T2> &xaltitudes,
+                         const xt::xexpression<T3> &xoffsets) {
+        auto &parents = xparents.derived_cast();
+        auto &altitudes = xaltitudes.derived_cast();
+        auto &offsets = xoffsets.derived_cast();
+        hg_assert_1d_array(parents);
+        hg_assert_1d_array(altitudes);
+        hg_assert_1d_array(offsets);
+        hg_assert_integral_value_type(parents);
+        hg_assert_integral_value_type(offsets);
+        hg_assert_same_shape(parents, altitudes);
+        hg_assert(offsets.size() > 0 && offsets(0) == 0 && offsets(offsets.size() - 1) == (index_t) parents.size(),
+                  "Offsets must start with 0 and end with the total number of nodes.");
+        for (index_t i = 0; i + 1 < (index_t) offsets.size(); i++) {
+            hg_assert(offsets(i) < offsets(i + 1), "Offsets must be strictly increasing.");
+        }
+        tree_batch<typename T2::value_type> batch;
+        batch.parents = parents;
+        batch.altitudes = altitudes;
+        batch.offsets = offsets;
+        return batch;
+    }
+
+    namespace hierarchy_batch_internal {
+
+        /**
+         * Extremities of the edges of the graph shared by all the images of a batch (computed once per batch).
+         */
+        template<typename graph_t>
+        auto graph_edge_extremities(const graph_t &graph) {
+            const index_t num_e = num_edges(graph);
+            array_1d<index_t> edge_sources = array_1d<index_t>::from_shape({(size_t) num_e});
+            array_1d<index_t> edge_targets = array_1d<index_t>::from_shape({(size_t) num_e});
+            for (index_t i = 0; i < num_e; i++) {
+                auto e = edge_from_index(i, graph);
+                edge_sources(i) = source(e, graph);
+                edge_targets(i) = target(e, graph);
+            }
+            return std::make_pair(std::move(edge_sources), std::move(edge_targets));
+        }
+
+        /**
+         * Batch of num_trees binary partition trees of a graph with num_vertices vertices (the arrays are allocated,
+         * the offsets are set).
+         */
+        template<typename value_t>
+        auto make_binary_batch(index_t num_trees, index_t num_vertices) {
+            const index_t num_nodes = 2 * num_vertices - 1;
+            tree_batch<value_t> batch;
+            batch.parents = array_1d<index_t>::from_shape({(size_t) (num_trees * num_nodes)});
+            batch.altitudes = array_1d<value_t>::from_shape({(size_t) (num_trees * num_nodes)});
+            batch.offsets = xt::arange<index_t>(0, (num_trees + 1) * num_nodes, num_nodes);
+            batch.mst_edge_map = array_2d<index_t>::from_shape({(size_t) num_trees, (size_t) (num_vertices - 1)});
+            return batch;
+        }
+
+        /**
+         * Copies the binary partition tree bptc (see node_weighted_tree_and_mst) in the i-th slot of the batch.
+         */
+        template<typename value_t, typename bpt_t>
+        void store_binary_tree(tree_batch<value_t> &batch, index_t i, const bpt_t &bptc) {
+            const index_t start = batch.offsets(i);
+            const auto &parents = bptc.tree.parents();
+            std::copy(parents.begin(), parents.end(), batch.parents.begin() + start);
+            std::copy(bptc.altitudes.begin(), bptc.altitudes.end(), batch.altitudes.begin() + start);
+            std::copy(bptc.mst_edge_map.begin(), bptc.mst_edge_map.end(),
+                      batch.mst_edge_map.begin() + i * batch.mst_edge_map.shape()[1]);
+        }
+
+        /**
+         * Canonical binary partition tree of the graph whose edges are given by edge_sources and edge_targets,
+         * weighted by edge_weights (see bpt_canonical).
+         */
+        template<typename T>
+        auto bpt_canonical_shared_edges(const array_1d<index_t> &edge_sources,
+                                        const array_1d<index_t> &edge_targets,
+                                        const T &edge_weights,
+                                        index_t num_vertices) {
+            array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+            auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges(edge_sources, edge_targets,
+                                                                                sorted_edges_indices, num_vertices);
+            return hierarchy_core_internal::make_bpt_canonical_result(num_vertices, edge_weights,
+                                                                      std::move(res.first), std::move(res.second));
+        }
+
+        template<typename T>
+        void assert_batch_edge_weights(const T &edge_weights, index_t num_edges) {
+            hg_assert(edge_weights.dimension() == 2,
+                      "Edge weights must be a 2d array whose i-th row contains the edge weights of the i-th image.");
+            hg_assert((index_t) edge_weights.shape()[1] == num_edges,
+                      "The number of columns of the edge weights does not match the number of edges of the graph.");
+        }
+    }
+
+    /**
+     * Weights the edges of a graph for each image of a stack of images (see weight_graph): the images are processed in
+     * parallel.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph, shared by all the images
+     * @param xvertex_weights array of shape (num_images, num_vertices(graph), ...): the i-th element of the first axis
+     * contains the vertex weights of the i-th image
+     * @param weight weighting function
+     * @return a 2d array of shape (num_images, num_edges(graph))
+     */
+    template<typename result_value_t = double, typename graph_t, typename T>
+    auto weight_graph_batch(const graph_t &graph, const xt::xexpression<T> &xvertex_weights,
+                            weight_functions weight) {
+        HG_TRACE();
+        using value_type = typename T::value_type;
+        auto &vertex_weights = xvertex_weights.derived_cast();
+        hg_assert(vertex_weights.dimension() >= 2,
+                  "Vertex weights must have at least 2 dimensions (number of images, number of vertices).");
+        hg_assert((index_t) vertex_weights.shape()[1] == (index_t) num_vertices(graph),
+                  "The second dimension of the vertex weights does not match the number of vertices of the graph.");
+        const index_t num_images = vertex_weights.shape()[0];
+        array_2d<result_value_t> result = array_2d<result_value_t>::from_shape(
+                {(size_t) num_images, (size_t) num_edges(graph)});
+        parfor(0, num_images, [&](index_t i) {
+            array_nd<value_type> image = xt::view(vertex_weights, i);
+            xt::view(result, i, xt::all()) = weight_graph<result_value_t>(graph, image, weight);
+        });
+        return result;
+    }
+
+    /**
+     * Canonical binary partition trees (see bpt_canonical) of a graph for a stack of edge weights: the i-th row of the
+     * edge weights gives the weights of the graph edges for the i-th image.
+     *
+     * The extremities of the graph edges are extracted once and shared by all the images, which are processed in
+     * parallel. The i-th tree of the result is identical to bpt_canonical(graph, row i of the edge weights).
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph (must be connected)
+     * @param xedge_weights 2d array of shape (num_images, num_edges(graph))
+     * @return a tree_batch (with mst_edge_map) whose altitudes have the value type of the edge weights
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_batch(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        using namespace hierarchy_batch_internal;
+        using value_type = typename T::value_type;
+        auto &edge_weights = xedge_weights.derived_cast();
+        assert_batch_edge_weights(edge_weights, num_edges(graph));
+
+        const index_t num_images = edge_weights.shape()[0];
+        const index_t num_v = num_vertices(graph);
+        auto edges = graph_edge_extremities(graph);
+        auto batch = make_binary_batch<value_type>(num_images, num_v);
+        parfor(0, num_images, [&](index_t i) {
+            array_1d<value_type> weights = xt::view(edge_weights, i, xt::all());
+            store_binary_tree(batch, i, bpt_canonical_shared_edges(edges.first, edges.second, weights, num_v));
+        });
+        return batch;
+    }
+
+    /**
+     * Watershed hierarchies (see watershed_hierarchy_by_area, watershed_hierarchy_by_volume and
+     * watershed_hierarchy_by_dynamics) of a graph for a stack of edge weights: the i-th row of the edge weights gives
+     * the weights of the graph edges for the i-th image.
+     *
+     * The extremities of the graph edges are extracted once and shared by all the images, which are processed in
+     * parallel. The i-th tree of the result is identical to the binary hierarchy computed by the corresponding
+     * watershed_hierarchy_by_* function on the i-th image, except that altitudes are stored as double.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph (must be connected)
+     * @param xedge_weights 2d array of shape (num_images, num_edges(graph))
+     * @param attribute regional attribute of the watershed
+     * @param xvertex_area area of the vertices of the graph (area and volume attributes)
+     * @return a tree_batch (with mst_edge_map)
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto watershed_hierarchy_batch(const graph_t &graph,
+                                   const xt::xexpression<T1> &xedge_weights,
+                                   watershed_attribute attribute,
+                                   const xt::xexpression<T2> &xvertex_area) {
+        HG_TRACE();
+        using namespace hierarchy_batch_internal;
+        using value_type = typename T1::value_type;
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &vertex_area = xvertex_area.derived_cast();
+        assert_batch_edge_weights(edge_weights, num_edges(graph));
+        hg_assert_vertex_weights(graph, vertex_area);
+        hg_assert_1d_array(vertex_area);
+
+        const index_t num_images = edge_weights.shape()[0];
+        const index_t num_v = num_vertices(graph);
+        auto edges = graph_edge_extremities(graph);
+        auto batch = make_binary_batch<double>(num_images, num_v);
+        parfor(0, num_images, [&](index_t i) {
+            array_1d<value_type> weights = xt::view(edge_weights, i, xt::all());
+            auto bptc = bpt_canonical_shared_edges(edges.first, edges.second, weights, num_v);
+            auto &bpt = bptc.tree;
+            auto &altitude = bptc.altitudes;
+            bpt.compute_children();
+
+            array_1d<double> persistence;
+            switch (attribute) {
+                case watershed_attribute::area:
+                    persistence = watershed_hierarchy_internal::bpt_persistence(
+                            bpt, altitude, attribute_area(bpt, vertex_area));
+                    break;
+                case watershed_attribute::volume:
+                    persistence = watershed_hierarchy_internal::bpt_persistence(
+                            bpt, altitude, attribute_volume(bpt, altitude, attribute_area(bpt, vertex_area)));
+                    break;
+                case watershed_attribute::dynamics:
+                    persistence = watershed_hierarchy_internal::bpt_persistence(
+                            bpt, altitude, attribute_dynamics(bpt, altitude, true));
+                    break;
+            }
+
+            array_1d<index_t> mst_sources = gather(edges.first, bptc.mst_edge_map);
+            array_1d<index_t> mst_targets = gather(edges.second, bptc.mst_edge_map);
+            auto res = hierarchy_core_internal::bpt_canonical_from_tree_edges(mst_sources, mst_targets, persistence,
+                                                                              num_v);
+            // edges of the result are given in the minimum spanning tree: map them back to the graph
+            for (auto &e: res.mst_edge_map) {
+                e = bptc.mst_edge_map(e);
+            }
+            store_binary_tree(batch, i, res);
+        });
+        return batch;
+    }
+
+    template<typename graph_t, typename T>
+    auto watershed_hierarchy_batch(const graph_t &graph,
+                                   const xt::xexpression<T> &xedge_weights,
+                                   watershed_attribute attribute) {
+        return watershed_hierarchy_batch(graph, xedge_weights, attribute, xt::ones<index_t>({num_vertices(graph)}));
+    }
+
+    /**
+     * Saliency maps (see saliency_map) of the trees of a batch on the graph shared by all the images of the batch: the
+     * leaves of each tree must be the vertices of the graph. The trees are processed in parallel.
+     *
+     * @tparam graph_t
+     * @tparam value_t
+     * @param graph input graph
+     * @param batch batch of trees
+     * @return a 2d array of shape (num_trees, num_edges(graph)) with the value type of the altitudes of the batch
+     */
+    template<typename graph_t, typename value_t>
+    auto saliency_map_batch(const graph_t &graph, const tree_batch<value_t> &batch) {
+        HG_TRACE();
+        const index_t num_trees = batch.num_trees();
+        const index_t num_e = num_edges(graph);
+        auto edges = hierarchy_batch_internal::graph_edge_extremities(graph);
+        array_2d<value_t> result = array_2d<value_t>::from_shape({(size_t) num_trees, (size_t) num_e});
+        parfor(0, num_trees, [&](index_t i) {
+            auto t = batch.get_tree(i);
+            hg_assert((index_t) num_leaves(t) == (index_t) num_vertices(graph),
+                      "The leaves of the trees of the batch do not match the graph vertices.");
+            const index_t start = batch.offsets(i);
+            lca_bitmask_block lca(t);
+            lca.for_each_lca(num_e,
+                             [&edges](index_t k) { return edges.first(k); },
+                             [&edges](index_t k) { return edges.second(k); },
+                             [&result, &batch, i, start](index_t k, index_t n) {
+                                 result(i, k) = batch.altitudes(start + n);
+                             });
+        });
+        return result;
+    }
+
+    /**
+     * Distances between the saliency maps (ultrametrics on the graph edges) of two hierarchies (see
+     * hierarchy_distance_matrix_batch).
+     */
+    enum class hierarchy_distance {
+        L1,
+        L2,
+        correlation
+    };
+
+    namespace hierarchy_batch_internal {
+
+        /**
+         * Symmetric matrix of the sums over the columns k of term(rows(i, k), rows(j, k)) for every pair of rows i < j,
+         * the diagonal is left to 0.
+         *
+         * Pairs of rows are processed by blocks of row_block x row_block rows in parallel, and each block sweeps the
+         * columns by chunks of col_block values, so that the 2 * row_block row chunks of a block stay in cache while
+         * they are combined.
+         */
+        template<typename value_t, typename F>
+        array_2d<double> blocked_pairwise_sums(const array_2d<value_t> &rows, const F &term) {
+            constexpr index_t row_block = 8;
+            constexpr index_t col_block = 2048;
+            const index_t num_rows = rows.shape()[0];
+            const index_t num_cols = rows.shape()[1];
+            const index_t num_blocks = (num_rows + row_block - 1) / row_block;
+            array_2d<double> result = xt::zeros<double>({(size_t) num_rows, (size_t) num_rows});
+            parfor(0, num_blocks * num_blocks, [&](index_t b) {
+                const index_t bi = b / num_blocks;
+                const index_t bj = b % num_blocks;
+                if (bj < bi) {
+                    return;
+                }
+                const index_t i_start = bi * row_block;
+                const index_t i_end = (std::min)(num_rows, i_start + row_block);
+                const index_t j_start = bj * row_block;
+                const index_t j_end = (std::min)(num_rows, j_start + row_block);
+                double sums[row_block][row_block] = {};
+                for (index_t k_start = 0; k_start < num_cols; k_start += col_block) {
+                    const index_t k_end = (std::min)(num_cols, k_start + col_block);
+                    for (index_t i = i_start; i < i_end; i++) {
+                        const value_t *row_i = &rows(i, 0);
+                        for (index_t j = (std::max)(j_start, i + 1); j < j_end; j++) {
+                            const value_t *row_j = &rows(j, 0);
+                            double sum = 0;
+                            for (index_t k = k_start; k < k_end; k++) {
+                                sum += term(row_i[k], row_j[k]);
+                            }
+                            sums[i - i_start][j - j_start] += sum;
+                        }
+                    }
+                }
+                for (index_t i = i_start; i < i_end; i++) {
+                    for (index_t j = (std::max)(j_start, i + 1); j < j_end; j++) {
+                        result(i, j) = result(j, i) = sums[i - i_start][j - j_start];
+                    }
+                }
+            });
+            return result;
+        }
+    }
+
+    /**
+     * Pairwise distances between the rows of a 2d array of ultrametrics, typically the saliency maps of several
+     * hierarchies on the same graph (see saliency_map_batch):
+     *
+     *  - L1: sum of the absolute differences of the ultrametrics;
+     *  - L2: euclidean distance between the ultrametrics;
+     *  - correlation: 1 - r where r is the Pearson correlation coefficient of the ultrametrics (r is taken equal to 0
+     *    if one of the ultrametrics is constant).
+     *
+     * Pairs of rows are processed by cache-sized blocks in parallel: no temporary of the size of the rows is created
+     * per pair of rows.
+     *
+     * @tparam T
+     * @param xultrametrics 2d array of shape (num_hierarchies, num_edges)
+     * @param metric distance between two ultrametrics
+     * @return a symmetric 2d array of shape (num_hierarchies, num_hierarchies) of double
+     */
+    template<typename T>
+    auto ultrametric_distance_matrix(const xt::xexpression<T> &xultrametrics, hierarchy_distance metric) {
+        HG_TRACE();
+        using value_type = typename T::value_type;
+        auto &ultrametrics = xultrametrics.derived_cast();
+        hg_assert(ultrametrics.dimension() == 2,
+                  "Ultrametrics must be a 2d array whose i-th row contains the ultrametric of the i-th hierarchy.");
+        using namespace hierarchy_batch_internal;
+        switch (metric) {
+            case hierarchy_distance::L1: {
+                array_2d<value_type> rows = ultrametrics;
+                return blocked_pairwise_sums(rows, [](value_type a, value_type b) {
+                    return std::abs((double) a - (double) b);
+                });
+            }
+            case hierarchy_distance::L2: {
+                array_2d<value_type> rows = ultrametrics;
+                array_2d<double> result = blocked_pairwise_sums(rows, [](value_type a, value_type b) {
+                    double d = (double) a - (double) b;
+                    return d * d;
+                });
+                return array_2d<double>(xt::sqrt(result));
+            }
+            case hierarchy_distance::correlation: {
+                // rows are centered and normalized once, the correlation is then a dot product
+                array_2d<double> rows = ultrametrics;
+                const index_t num_rows = rows.shape()[0];
+                const index_t num_cols = rows.shape()[1];
+                parfor(0, num_rows, [&rows, num_cols](index_t i) {
+                    auto row = xt::view(rows, i, xt::all());
+                    double mean = (num_cols > 0) ? xt::sum(row)() / num_cols : 0;
+                    row -= mean;
+                    double norm = std::sqrt(xt::sum(row * row)());
+                    if (norm > 0) {
+                        row /= norm;
+                    }
+                });
+                array_2d<double> result = blocked_pairwise_sums(rows, [](double a, double b) {
+                    return a * b;
+                });
+                result = 1 - result;
+                for (index_t i = 0; i < num_rows; i++) {
+                    result(i, i) = 0;
+                }
+                return result;
+            }
+            default:
+                throw std::runtime_error("Unknown hierarchy distance.");
+        }
+    }
+
+    /**
+     * Pairwise distances between the hierarchies of a batch on the graph shared by all the images of the batch (see
+     * ultrametric_distance_matrix): the saliency map of each tree is computed only once (see saliency_map_batch), then
+     * the distances between all the pairs of saliency maps are computed by cache-sized blocks.
+     *
+     * @tparam graph_t
+     * @tparam value_t
+     * @param graph input graph
+     * @param batch batch of trees whose leaves are the vertices of the graph
+     * @param metric distance between two saliency maps
+     * @return a symmetric 2d array of shape (num_trees, num_trees) of double
+     */
+    template<typename graph_t, typename value_t>
+    auto hierarchy_distance_matrix_batch(const graph_t &graph, const tree_batch<value_t> &batch,
+                                         hierarchy_distance metric) {
+        HG_TRACE();
+        return ultrametric_distance_matrix(saliency_map_batch(graph, batch), metric);
+    }
+
+    /**
+     * Computes an attribute on each tree of a batch: the trees are processed in parallel.
+     *
+     * The attribute functor takes a tree and its node altitudes and returns an 1d array giving the
+     * attribute value of each node of the tree, for example:
+     *
+     *   tree_batch_attribute(batch, [](const tree &t, const auto &altitudes) {
+     *       return attribute_height(t, altitudes, true);
+     *   });
+     *
+     * @tparam value_t
+     * @tparam F
+     * @param batch batch of trees
+     * @param attribute_functor function that computes the attribute value from a tree and its node altitudes
+     * @return the concatenated attribute values: the attribute of the nodes of the i-th tree is stored in the range
+     * [offsets(i), offsets(i + 1)) of the result
+     */
+    template<typename value_t, typename F>
+    auto tree_batch_attribute(const tree_batch<value_t> &batch, const F &attribute_functor) {
+        HG_TRACE();
+        using attribute_t = std::decay_t<decltype(attribute_functor(std::declval<const tree &>(),
+                                                                    std::declval<const array_1d<value_t> &>()))>;
+        using result_value_t = typename attribute_t::value_type;
+        array_1d<result_value_t> result = array_1d<result_value_t>::from_shape({batch.parents.size()});
+        parfor(0, batch.num_trees(), [&](index_t i) {
+            auto t = batch.get_tree(i);
+            array_1d<value_t> altitudes = batch.tree_altitudes(i);
+            auto attribute = attribute_functor(t, altitudes);
+            hg_assert_node_weights(t, attribute);
+            std::copy(attribute.begin(), attribute.end(), result.begin() + batch.offsets(i));
+        });
+        return result;
+    }
+}
@@ -12,6 +12,7 @@
 
 #include "common.hpp"
 #include "higra/structure/unionfind.hpp"
+#include "higra/structure/workspace.hpp"
 #include "higra/graph.hpp"
 #include "higra/sorting.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
@@ -22,6 +23,10 @@
 #include <utility>
 #include <tuple>
 #include <queue>
+#include <numeric>
+#include <deque>
+#include <atomic>
+#include <numeric>
 
 namespace hg {
 
@@ -72,9 +77,9 @@ namespace hg {
 
             array_1d<index_t> mst_edge_map = xt::empty<index_t>({num_edge_mst});
 
-            union_find uf(num_vertices);
+            workspace_union_find uf(num_vertices);
 
-            array_1d<index_t> roots = xt::arange<index_t>(num_vertices);
+            workspace_array_1d<index_t> roots = xt::arange<index_t>(num_vertices);
             array_1d<index_t> parents = xt::arange<index_t>(num_vertices * 2 - 1);
 
             index_t num_nodes = num_vertices;
@@ -82,6 +87,7 @@ namespace hg {
             index_t i = 0;
 
             while (num_edge_found < num_edge_mst && i < (index_t) sorted_edge_indices.size()) {
+                check_cancellation(i);
                 auto ei = sorted_edge_indices[i];
                 auto c1 = uf.find(sources(ei));
                 auto c2 = uf.find(targets(ei));
@@ -99,9 +105,502 @@ namespace hg {
             hg_assert(num_edge_found == num_edge_mst, "Input graph must be connected.");
 
             return std::make_pair(
-                    parents,
+                    std::move(parents),
+                    std::move(mst_edge_map));
+        };
+
+        /**
+         * Pipelined variant of bpt_canonical_from_sorted_edges, with the same result.
+         *
+         * In the sequential sweep, the extremities of an edge are read through the random permutation
+         * sorted_edge_indices and the union-find entries of these extremities are then accessed: each iteration
+         * is a chain of dependent cache misses. Here, the extremities of the sorted edges are first gathered, in
+         * parallel, in two buffers of block_size elements in sorted order, and the sweep over a block
+         * software-prefetches the parents of the extremities of the edge prefetch_distance iterations ahead, and
+         * the grandparents of the extremities of the edge prefetch_distance / 2 iterations ahead.
+         *
+         * @param xsources sources of the graph edges
+         * @param xtargets targets of the graph edges
+         * @param xsorted_edge_indices sorted edge indices
+         * @param num_vertices number of vertices in the graph
+         * @param block_size number of edges gathered at once
+         * @param prefetch_distance number of iterations between the prefetch of the union-find entries of an edge
+         * and their use
+         * @return a pair (parents, mst_edge_map)
+         */
+        template<typename E1, typename E2, typename T>
+        auto bpt_canonical_from_sorted_edges_pipelined(const xt::xexpression<E1> &xsources,
+                                                       const xt::xexpression<E2> &xtargets,
+                                                       const xt::xexpression<T> &xsorted_edge_indices,
+                                                       const index_t num_vertices,
+                                                       const index_t block_size = 1 << 16,
+                                                       const index_t prefetch_distance = 16) {
+            HG_TRACE();
+            auto &sorted_edge_indices = xsorted_edge_indices.derived_cast();
+            auto &sources = xsources.derived_cast();
+            auto &targets = xtargets.derived_cast();
+            hg_assert_1d_array(sources);
+            hg_assert_same_shape(sources, targets);
+            hg_assert_same_shape(sources, sorted_edge_indices);
+            hg_assert_integral_value_type(sources);
+            hg_assert_integral_value_type(targets);
+            hg_assert_integral_value_type(sorted_edge_indices);
+            hg_assert(block_size > 0, "Block size must be positive.");
+
+            const index_t num_edge_mst = num_vertices - 1;
+            const index_t num_e = sorted_edge_indices.size();
+            const index_t buffer_size = (std::max)((index_t) 1, (std::min)(block_size, num_e));
+            const index_t distance = (std::max)(prefetch_distance, (index_t) 2);
+
+            array_1d<index_t> mst_edge_map = xt::empty<index_t>({num_edge_mst});
+
+            workspace_union_find uf(num_vertices);
+
+            workspace_array_1d<index_t> roots = xt::arange<index_t>(num_vertices);
+            array_1d<index_t> parents = xt::arange<index_t>(num_vertices * 2 - 1);
+
+            workspace_array_1d<index_t> block_sources = workspace_array_1d<index_t>::from_shape({(size_t) buffer_size});
+            workspace_array_1d<index_t> block_targets = workspace_array_1d<index_t>::from_shape({(size_t) buffer_size});
+
+            index_t num_nodes = num_vertices;
+            index_t num_edge_found = 0;
+
+            for (index_t start = 0; start < num_e && num_edge_found < num_edge_mst; start += buffer_size) {
+                const index_t size = (std::min)(buffer_size, num_e - start);
+                parfor(0, size, [&](index_t j) {
+                    auto ei = sorted_edge_indices(start + j);
+                    block_sources(j) = sources(ei);
+                    block_targets(j) = targets(ei);
+                });
+
+                for (index_t j = 0; j < size && num_edge_found < num_edge_mst; j++) {
+                    check_cancellation(start + j);
+                    if (j + distance < size) {
+                        uf.prefetch(block_sources(j + distance));
+                        uf.prefetch(block_targets(j + distance));
+                    }
+                    if (j + distance / 2 < size) {
+                        uf.prefetch(block_sources(j + distance / 2), true);
+                        uf.prefetch(block_targets(j + distance / 2), true);
+                    }
+                    auto c1 = uf.find(block_sources(j));
+                    auto c2 = uf.find(block_targets(j));
+                    if (c1 != c2) {
+                        parents[roots[c1]] = num_nodes;
+                        parents[roots[c2]] = num_nodes;
+                        auto newRoot = uf.link(c1, c2);
+                        roots[newRoot] = num_nodes;
+                        mst_edge_map(num_edge_found) = sorted_edge_indices(start + j);
+                        num_nodes++;
+                        num_edge_found++;
+                    }
+                }
+            }
+            hg_assert(num_edge_found == num_edge_mst, "Input graph must be connected.");
+
+            return std::make_pair(
+                    std::move(parents),
+                    std::move(mst_edge_map));
+        };
+
+        /**
+         * Canonical binary partition tree of a tree (a connected graph with num_vertices - 1 edges) whose edges are
+         * given in increasing order.
+         *
+         * Every edge of a tree belongs to its minimum spanning tree: the mst_edge_map is thus the given edge order
+         * and the union-find is only used to locate the current roots of the merged regions, without checking for
+         * cycles or searching for the remaining minimum spanning tree edges.
+         *
+         * @param xsources sources of the tree edges
+         * @param xtargets targets of the tree edges
+         * @param xsorted_edge_indices sorted edge indices
+         * @param num_vertices number of vertices in the tree
+         * @return a pair (parents, mst_edge_map)
+         */
+        template<typename E1, typename E2, typename T>
+        auto bpt_canonical_from_sorted_tree_edges(const xt::xexpression<E1> &xsources,
+                                                  const xt::xexpression<E2> &xtargets,
+                                                  const xt::xexpression<T> &xsorted_edge_indices,
+                                                  const index_t num_vertices) {
+            HG_TRACE();
+            auto &sorted_edge_indices = xsorted_edge_indices.derived_cast();
+            auto &sources = xsources.derived_cast();
+            auto &targets = xtargets.derived_cast();
+            hg_assert_1d_array(sources);
+            hg_assert_same_shape(sources, targets);
+            hg_assert_same_shape(sources, sorted_edge_indices);
+            hg_assert_integral_value_type(sources);
+            hg_assert_integral_value_type(targets);
+            hg_assert_integral_value_type(sorted_edge_indices);
+            hg_assert((index_t) sources.size() == num_vertices - 1,
+                      "The number of edges must be equal to the number of vertices minus 1.");
+
+            const index_t num_edge_mst = num_vertices - 1;
+
+            array_1d<index_t> mst_edge_map = sorted_edge_indices;
+
+            workspace_union_find uf(num_vertices);
+
+            workspace_array_1d<index_t> roots = xt::arange<index_t>(num_vertices);
+            array_1d<index_t> parents = xt::arange<index_t>(num_vertices * 2 - 1);
+
+            for (index_t i = 0; i < num_edge_mst; i++) {
+                check_cancellation(i);
+                auto ei = mst_edge_map(i);
+                auto c1 = uf.find(sources(ei));
+                auto c2 = uf.find(targets(ei));
+                hg_assert(c1 != c2, "Input graph must be a tree.");
+                parents(roots(c1)) = num_vertices + i;
+                parents(roots(c2)) = num_vertices + i;
+                roots(uf.link(c1, c2)) = num_vertices + i;
+            }
+
+            return std::make_pair(
+                    std::move(parents),
                     std::move(mst_edge_map));
         };
+
+        /**
+         * Quasi-flat zone hierarchy from the parents array of the canonical binary partition tree of a graph with
+         * num_vertices vertices and its minimum spanning tree edge map (see bpt_canonical_from_sorted_edges).
+         *
+         * The nodes of the binary partition tree with the same altitude as their parent are removed with two top-down
+         * passes on flat arrays: the first one redirects each node to its closest non removed ancestor and the
+         * second one numbers the remaining nodes. The parents array is modified in place. The result is identical to
+         * simplify_tree(bpt, altitudes == altitudes of the parents) (see quasi_flat_zone_hierarchy) without building
+         * the binary partition tree, its children lists or the node map.
+         *
+         * @param parents parents array of the canonical binary partition tree, modified in place
+         * @param mst_edge_map minimum spanning tree edge map of the canonical binary partition tree
+         * @param edge_weights weights of the graph edges
+         * @param num_vertices number of vertices in the graph
+         * @return a pair (parents, altitudes)
+         */
+        template<typename T>
+        auto qfz_hierarchy_from_bpt_canonical(array_1d<index_t> &parents,
+                                              const array_1d<index_t> &mst_edge_map,
+                                              const T &edge_weights,
+                                              const index_t num_vertices) {
+            HG_TRACE();
+            using value_type = typename T::value_type;
+            const index_t num_nodes = parents.size();
+            if (num_nodes == num_vertices) {
+                return std::make_pair(array_1d<index_t>(parents),
+                                      array_1d<value_type>(xt::zeros<value_type>({(size_t) num_vertices})));
+            }
+            const index_t root_node = num_nodes - 1;
+            auto level = [&mst_edge_map, &edge_weights, num_vertices](index_t n) {
+                return edge_weights(mst_edge_map(n - num_vertices));
+            };
+
+            // new_index(n) = 0 if the internal node n is kept, invalid_index otherwise; then, index of n in the result
+            workspace_array_1d<index_t> new_index = workspace_array_1d<index_t>::from_shape({(size_t) num_nodes});
+            new_index(root_node) = 0;
+            index_t num_kept = 1;
+            for (index_t n = root_node - 1; n >= num_vertices; n--) {
+                const index_t p = parents(n);
+                if (level(n) == level(p)) {
+                    new_index(n) = invalid_index;
+                } else {
+                    new_index(n) = 0;
+                    num_kept++;
+                }
+                // the parent of p has already been redirected to the closest kept ancestor of p
+                parents(n) = (new_index(p) == invalid_index) ? parents(p) : p;
+            }
+
+            const index_t num_qfz_nodes = num_vertices + num_kept;
+            array_1d<index_t> qfz_parents = array_1d<index_t>::from_shape({(size_t) num_qfz_nodes});
+            array_1d<value_type> qfz_altitudes = array_1d<value_type>::from_shape({(size_t) num_qfz_nodes});
+            index_t current = num_qfz_nodes - 1;
+            new_index(root_node) = current;
+            qfz_parents(current) = current;
+            qfz_altitudes(current) = level(root_node);
+            for (index_t n = root_node - 1; n >= num_vertices; n--) {
+                if (new_index(n) != invalid_index) {
+                    current--;
+                    new_index(n) = current;
+                    qfz_parents(current) = new_index(parents(n));
+                    qfz_altitudes(current) = level(n);
+                }
+            }
+            for (index_t n = 0; n < num_vertices; n++) {
+                const index_t p = parents(n);
+                qfz_parents(n) = new_index((new_index(p) == invalid_index) ? parents(p) : p);
+                qfz_altitudes(n) = 0;
+            }
+
+            return std::make_pair(std::move(qfz_parents), std::move(qfz_altitudes));
+        }
+
+
+        /**
+         * Strict total order on edges: edges are compared by weight and ties are broken by edge index.
+         * This is the order implicitly used by Kruskal's algorithm on a stable sort of the edges, the minimum
+         * spanning forest for this order is unique.
+         */
+        template<typename T>
+        struct edge_weight_index_less {
+            const T &edge_weights;
+
+            bool operator()(index_t i, index_t j) const {
+                return edge_weights(i) < edge_weights(j) || (!(edge_weights(j) < edge_weights(i)) && i < j);
+            }
+        };
+
+        /**
+         * Adds to the minimum spanning forest msf the minimum spanning forest of the graph induced by the given
+         * candidate edges and the current partition represented by uf, using Borůvka's algorithm.
+         *
+         * In each round, the lightest edge leaving each component is searched in parallel and those edges are then
+         * added to the forest. The candidate edges lying inside a single component are discarded.
+         */
+        template<typename E1, typename E2, typename less_t>
+        void boruvka_rounds(std::vector<index_t> &candidates,
+                            const E1 &sources,
+                            const E2 &targets,
+                            const less_t &less,
+                            union_find &uf,
+                            std::vector<std::atomic<index_t>> &best_edge,
+                            std::vector<index_t> &msf) {
+            std::vector<index_t> source_comp;
+            std::vector<index_t> target_comp;
+
+            while (!candidates.empty()) {
+                index_t num_candidates = candidates.size();
+                source_comp.resize(num_candidates);
+                target_comp.resize(num_candidates);
+
+                parfor(0, num_candidates, [&](index_t i) {
+                    auto ei = candidates[i];
+                    auto c1 = uf.find_root(sources(ei));
+                    auto c2 = uf.find_root(targets(ei));
+                    source_comp[i] = c1;
+                    target_comp[i] = c2;
+                    if (c1 != c2) {
+                        for (auto c: {c1, c2}) {
+                            auto current = best_edge[c].load();
+                            while ((current == invalid_index || less(ei, current)) &&
+                                   !best_edge[c].compare_exchange_weak(current, ei));
+                        }
+                    }
+                });
+
+                index_t num_kept = 0;
+                for (index_t i = 0; i < num_candidates; i++) {
+                    auto c1 = source_comp[i];
+                    auto c2 = target_comp[i];
+                    if (c1 == c2) {
+                        continue;
+                    }
+                    auto ei = candidates[i];
+                    if (best_edge[c1].load() == ei || best_edge[c2].load() == ei) {
+                        auto r1 = uf.find(c1);
+                        auto r2 = uf.find(c2);
+                        if (r1 != r2) {
+                            uf.link(r1, r2);
+                            msf.push_back(ei);
+                        }
+                    } else {
+                        candidates[num_kept++] = ei;
+                    }
+                }
+
+                for (index_t i = 0; i < num_candidates; i++) {
+                    best_edge[source_comp[i]].store(invalid_index);
+                    best_edge[target_comp[i]].store(invalid_index);
+                }
+                candidates.resize(num_kept);
+            }
+        }
+
+        /**
+         * Filter-Kruskal recursion: the candidate edges are split around a pivot, the minimum spanning forest of the
+         * light edges is computed first, and the heavy edges whose extremities have already been merged are then
+         * discarded before processing the remaining heavy edges. Small sub-problems are solved with Borůvka rounds.
+         */
+        template<typename E1, typename E2, typename less_t>
+        void filter_kruskal(std::vector<index_t> &candidates,
+                            const E1 &sources,
+                            const E2 &targets,
+                            const less_t &less,
+                            union_find &uf,
+                            std::vector<std::atomic<index_t>> &best_edge,
+                            std::vector<index_t> &msf,
+                            index_t serial_cutoff) {
+            index_t num_candidates = candidates.size();
+            if (num_candidates <= serial_cutoff) {
+                boruvka_rounds(candidates, sources, targets, less, uf, best_edge, msf);
+                return;
+            }
+
+            // pivot: median of a regular sample of the candidate edges
+            const index_t sample_size = 31;
+            std::vector<index_t> sample(sample_size);
+            for (index_t i = 0; i < sample_size; i++) {
+                sample[i] = candidates[(i * num_candidates) / sample_size];
+            }
+            std::nth_element(sample.begin(), sample.begin() + sample_size / 2, sample.end(), less);
+            auto pivot = sample[sample_size / 2];
+
+            auto middle = std::partition(candidates.begin(), candidates.end(),
+                                         [&less, pivot](index_t ei) { return !less(pivot, ei); });
+            if (middle == candidates.end()) {
+                boruvka_rounds(candidates, sources, targets, less, uf, best_edge, msf);
+                return;
+            }
+
+            std::vector<index_t> heavy(middle, candidates.end());
+            candidates.resize(middle - candidates.begin());
+            filter_kruskal(candidates, sources, targets, less, uf, best_edge, msf, serial_cutoff);
+
+            array_1d<bool> discarded = xt::empty<bool>({heavy.size()});
+            parfor(0, heavy.size(), [&](index_t i) {
+                auto ei = heavy[i];
+                discarded(i) = uf.find_root(sources(ei)) == uf.find_root(targets(ei));
+            });
+            index_t num_kept = 0;
+            for (index_t i = 0; i < (index_t) heavy.size(); i++) {
+                if (!discarded(i)) {
+                    heavy[num_kept++] = heavy[i];
+                }
+            }
+            heavy.resize(num_kept);
+            filter_kruskal(heavy, sources, targets, less, uf, best_edge, msf, serial_cutoff);
+        }
+
+        /**
+         * Computes the minimum spanning forest of the given edge weighted graph with a filter-Kruskal/Borůvka
+         * algorithm. Ties between edge weights are broken by edge indices, the result is thus equal to the minimum
+         * spanning forest computed by Kruskal's algorithm on a stable sort of the edges.
+         *
+         * The edges of the result are sorted in increasing order of weight (with ties broken by edge index).
+         *
+         * @param sources sources of the graph edges
+         * @param targets targets of the graph edges
+         * @param edge_weights weights of the graph edges
+         * @param num_vertices number of vertices in the graph
+         * @param serial_cutoff sub-problems with less edges than this value are directly solved with Borůvka rounds
+         * @return a 1d array of edge indices
+         */
+        template<typename E1, typename E2, typename T>
+        auto minimum_spanning_forest_filter_boruvka(const xt::xexpression<E1> &xsources,
+                                                    const xt::xexpression<E2> &xtargets,
+                                                    const xt::xexpression<T> &xedge_weights,
+                                                    const index_t num_vertices,
+                                                    const index_t serial_cutoff = 65536) {
+            HG_TRACE();
+            auto &sources = xsources.derived_cast();
+            auto &targets = xtargets.derived_cast();
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_1d_array(sources);
+            hg_assert_same_shape(sources, targets);
+            hg_assert_same_shape(sources, edge_weights);
+            hg_assert_integral_value_type(sources);
+            hg_assert_integral_value_type(targets);
+
+            edge_weight_index_less<T> less{edge_weights};
+
+            std::vector<index_t> candidates(sources.size());
+            std::iota(candidates.begin(), candidates.end(), 0);
+
+            union_find uf(num_vertices);
+            std::vector<std::atomic<index_t>> best_edge(num_vertices);
+            for (auto &b: best_edge) {
+                b.store(invalid_index);
+            }
+
+            std::vector<index_t> msf;
+            msf.reserve((std::max)(num_vertices - 1, (index_t) 0));
+
+            filter_kruskal(candidates, sources, targets, less, uf, best_edge, msf, (std::max)(serial_cutoff, (index_t) 1));
+
+            array_1d<index_t> result = xt::adapt(msf, {msf.size()});
+            hg::sort(result.begin(), result.end(), less);
+            return result;
+        }
+
+        template<typename T>
+        auto make_bpt_canonical_result(index_t num_points,
+                                       const T &edge_weights,
+                                       array_1d<index_t> &&parents,
+                                       array_1d<index_t> &&mst_edge_map) {
+            array_1d<typename T::value_type> levels = array_1d<typename T::value_type>::from_shape({parents.size()});
+            std::fill(levels.begin(), levels.begin() + num_points, 0);
+            gather(edge_weights, mst_edge_map, levels.data() + num_points);
+
+            return make_node_weighted_tree_and_mst(
+                    tree(std::move(parents)),
+                    std::move(levels),
+                    std::move(mst_edge_map));
+        }
+
+        template<typename graph_t, typename T>
+        auto make_bpt_canonical_result(const graph_t &graph,
+                                       const T &edge_weights,
+                                       array_1d<index_t> &&parents,
+                                       array_1d<index_t> &&mst_edge_map) {
+            return make_bpt_canonical_result((index_t) num_vertices(graph), edge_weights, std::move(parents),
+                                             std::move(mst_edge_map));
+        }
+
+        /**
+         * Canonical binary partition tree of an edge weighted tree with num_vertices vertices whose edges are given
+         * by the flat arrays sources and targets (see bpt_canonical_from_mst): no graph structure is required.
+         *
+         * @param sources sources of the tree edges
+         * @param targets targets of the tree edges
+         * @param edge_weights weights of the tree edges
+         * @param num_vertices number of vertices in the tree
+         * @return a node_weighted_tree_and_mst
+         */
+        template<typename E1, typename E2, typename T>
+        auto bpt_canonical_from_tree_edges(const E1 &sources,
+                                           const E2 &targets,
+                                           const T &edge_weights,
+                                           index_t num_vertices) {
+            HG_TRACE();
+            hg_assert_1d_array(edge_weights);
+            hg_assert((index_t) edge_weights.size() == num_vertices - 1,
+                      "The number of tree edges must be equal to the number of vertices minus 1.");
+
+            array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+            auto res = bpt_canonical_from_sorted_tree_edges(sources, targets, sorted_edges_indices, num_vertices);
+            return make_bpt_canonical_result(num_vertices, edge_weights, std::move(res.first),
+                                             std::move(res.second));
+        }
+    }
+
+    namespace hierarchy_core_internal {
+
+        /**
+         * Canonical binary partition tree of the given edge weighted graph from the indices of its edges sorted by
+         * increasing weights (with the tree edge variant if the graph is a tree).
+         */
+        template<typename graph_t, typename T>
+        auto bpt_canonical_from_sorted_graph_edges(const graph_t &graph,
+                                                   const T &edge_weights,
+                                                   const array_1d<index_t> &sorted_edges_indices) {
+            if ((index_t) num_edges(graph) == (index_t) num_vertices(graph) - 1) {
+                auto res = bpt_canonical_from_sorted_tree_edges(sources(graph),
+                                                                targets(graph),
+                                                                sorted_edges_indices,
+                                                                num_vertices(graph));
+                return make_bpt_canonical_result(graph,
+                                                 edge_weights,
+                                                 std::move(res.first),
+                                                 std::move(res.second));
+            }
+
+            auto res = bpt_canonical_from_sorted_edges_pipelined(sources(graph),
+                                                                 targets(graph),
+                                                                 sorted_edges_indices,
+                                                                 num_vertices(graph));
+            return make_bpt_canonical_result(graph,
+                                             edge_weights,
+                                             std::move(res.first),
+                                             std::move(res.second));
+        }
     }
 
     /**
@@ -130,24 +629,347 @@ namespace hg {
         hg_assert_1d_array(edge_weights);
 
         array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+        return hierarchy_core_internal::bpt_canonical_from_sorted_graph_edges(graph, edge_weights,
+                                                                              sorted_edges_indices);
+    };
 
-        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges(sources(graph),
-                                                                            targets(graph),
-                                                                            sorted_edges_indices,
-                                                                            num_vertices(graph));
-        auto &parents = res.first;
-        auto &mst_edge_map = res.second;
+    /**
+     * Compute the canonical binary partition tree of the given edge weighted graph, reusing the order of the edges
+     * of a previous computation on the same graph with different edge weights (warm start).
+     *
+     * This is typically used to process the frames of a video: the edge weights of consecutive frames are nearly
+     * identical, and sorting the edges from their order in the previous frame with stable_arg_sort_warm_start takes a
+     * time that depends on how much the weights have changed instead of a full sort.
+     *
+     * On input, sorted_edges contains the indices of the edges sorted by the edge weights of the previous computation
+     * (if it is empty, the edges are fully sorted). On output, it contains the indices of the edges sorted by the
+     * given edge weights, to be used for the next computation. The result is identical to the one of bpt_canonical.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights 1d array of edge weights
+     * @param sorted_edges edge indices sorted by the previous edge weights (updated in place)
+     * @return a node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_warm_start(const graph_t &graph,
+                                  const xt::xexpression<T> &xedge_weights,
+                                  array_1d<index_t> &sorted_edges) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        sorted_edges = stable_arg_sort_warm_start(edge_weights, sorted_edges);
+        return hierarchy_core_internal::bpt_canonical_from_sorted_graph_edges(graph, edge_weights, sorted_edges);
+    };
 
-        auto num_points = num_vertices(graph);
+    /**
+     * Compute the canonical binary partition tree of an edge weighted tree, typically a minimum spanning tree
+     * computed with minimum_spanning_tree or obtained from the mst_edge_map of a previous call to bpt_canonical.
+     *
+     * As every edge of a tree belongs to its minimum spanning tree, the computation only requires a sort of the
+     * edges and a linear scan of the sorted edges. The mst_edge_map of the result is then simply the sorted
+     * edge indices.
+     *
+     * Note that bpt_canonical automatically uses this function if the number of edges of the input graph is equal
+     * to its number of vertices minus 1.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param mst input graph: must be a tree (connected with num_vertices(mst) - 1 edges)
+     * @param xedge_weights 1d array of edge weights
+     * @return a node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_from_mst(const graph_t &mst, const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(mst, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        hg_assert((index_t) num_edges(mst) == (index_t) num_vertices(mst) - 1,
+                  "The number of edges of the input graph must be equal to its number of vertices minus 1.");
+
+        array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+
+        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_tree_edges(sources(mst),
+                                                                                 targets(mst),
+                                                                                 sorted_edges_indices,
+                                                                                 num_vertices(mst));
+        return hierarchy_core_internal::make_bpt_canonical_result(mst,
+                                                                  edge_weights,
+                                                                  std::move(res.first),
+                                                                  std::move(res.second));
+    };
 
-        array_1d<typename T::value_type> levels = xt::zeros<typename T::value_type>({parents.size()});
-        xt::noalias(xt::view(levels, xt::range(num_points, levels.size()))) = xt::index_view(edge_weights,
-                                                                                             mst_edge_map);
+    /**
+     * Compute the canonical binary partition tree of the given edge weighted graph with a parallel
+     * filter-Kruskal/Borůvka minimum spanning tree algorithm.
+     *
+     * The result is identical to the one of bpt_canonical: ties between edge weights are broken by edge indices.
+     *
+     * The minimum spanning tree is first computed without sorting all the edges: the edges are recursively split
+     * around a pivot weight, heavy edges whose extremities are already connected by lighter edges are discarded
+     * early and small sub-problems are solved with Borůvka rounds in which the lightest edge leaving each component
+     * is searched in parallel. The canonical binary partition tree is then obtained from the sorted edges of the
+     * minimum spanning tree alone.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph (must be connected)
+     * @param xedge_weights 1d array of edge weights
+     * @return a node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_filter_boruvka(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        auto &&graph_sources = sources(graph);
+        auto &&graph_targets = targets(graph);
+        index_t num_v = num_vertices(graph);
+
+        array_1d<index_t> msf = hierarchy_core_internal::minimum_spanning_forest_filter_boruvka(graph_sources,
+                                                                                                 graph_targets,
+                                                                                                 edge_weights,
+                                                                                                 num_v);
+        hg_assert((index_t) msf.size() == num_v - 1, "Input graph must be connected.");
+
+        array_1d<index_t> mst_sources = gather(graph_sources, msf);
+        array_1d<index_t> mst_targets = gather(graph_targets, msf);
+
+        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges(mst_sources,
+                                                                            mst_targets,
+                                                                            xt::arange<index_t>(msf.size()),
+                                                                            num_v);
+        // edges of msf are already sorted: res.second is the identity
+        return hierarchy_core_internal::make_bpt_canonical_result(graph,
+                                                                  edge_weights,
+                                                                  std::move(res.first),
+                                                                  std::move(msf));
+    };
+
+
+    /**
+     * A simple structure to hold the result of bpt_canonical_below: the lower part of a canonical binary
+     * partition tree, which is a forest whose trees are the canonical binary partition trees of the
+     * connected components of the graph restricted to the edges of weight smaller than or equal to a threshold.
+     *
+     * The nodes of the forest are given in topological order: the num_vertices(graph) first nodes are the vertices
+     * of the graph, and a root r satisfies parents(r) == r. The i-th connected component (supervertex) of
+     * the graph, the components being numbered in the order of their smallest vertex, is represented by the root
+     * node roots(i) of the forest, and supervertex_map(v) is the index of the supervertex containing the vertex v.
+     *
+     * @tparam altitude_t
+     */
+    template<typename altitude_t>
+    struct node_weighted_forest_and_msf {
+        array_1d<index_t> parents;
+        altitude_t altitudes;
+        array_1d<index_t> mst_edge_map;
+        array_1d<index_t> supervertex_map;
+        array_1d<index_t> roots;
+    };
 
-        return make_node_weighted_tree_and_mst(
-                tree(std::move(parents)),
-                std::move(levels),
-                std::move(mst_edge_map));
+    /**
+     * A simple structure to hold the result of bpt_canonical_above: the upper part of a canonical binary partition
+     * tree, whose leaves are the supervertices of the graph (see node_weighted_forest_and_msf), and the index
+     * supervertex_map(v) of the leaf containing the vertex v of the graph.
+     *
+     * @tparam tree_t
+     * @tparam altitude_t
+     */
+    template<typename tree_t, typename altitude_t>
+    struct partial_node_weighted_tree_and_mst {
+        tree_t tree;
+        altitude_t altitudes;
+        array_1d<index_t> mst_edge_map;
+        array_1d<index_t> supervertex_map;
+    };
+
+    namespace hierarchy_core_internal {
+
+        /**
+         * Index of the component of each element of a union find structure of num_elements elements, the
+         * components being numbered in the order of their smallest element.
+         *
+         * @return a pair (labels, number of components)
+         */
+        template<typename uf_t>
+        auto label_union_find_components(uf_t &uf, index_t num_elements) {
+            array_1d<index_t> labels = array_1d<index_t>::from_shape({(size_t) num_elements});
+            workspace_array_1d<index_t> root_labels = xt::empty<index_t>({(size_t) num_elements});
+            std::fill(root_labels.begin(), root_labels.end(), invalid_index);
+            index_t num_components = 0;
+            for (index_t i = 0; i < num_elements; i++) {
+                auto r = uf.find(i);
+                if (root_labels(r) == invalid_index) {
+                    root_labels(r) = num_components++;
+                }
+                labels(i) = root_labels(r);
+            }
+            return std::make_pair(std::move(labels), num_components);
+        }
+    }
+
+    /**
+     * Lower part of the canonical binary partition tree of the given edge weighted graph, below the given altitude:
+     * Kruskal's algorithm is stopped after the edges of weight smaller than or equal to altitude.
+     *
+     * The result is a forest (see node_weighted_forest_and_msf) whose nodes, altitudes and minimum spanning
+     * forest edges are identical to the num_vertices(graph) + mst_edge_map.size() first nodes of the result of
+     * bpt_canonical (only the parents of the roots of the forest differ). The edges heavier than altitude are
+     * discarded in a linear time partition step before sorting: only the edges of the lower part are sorted.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights 1d array of edge weights
+     * @param altitude largest altitude of the nodes of the forest
+     * @return a node_weighted_forest_and_msf
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_below(const graph_t &graph, const xt::xexpression<T> &xedge_weights, double altitude) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_type = typename T::value_type;
+
+        auto &&graph_sources = sources(graph);
+        auto &&graph_targets = targets(graph);
+        const index_t num_v = num_vertices(graph);
+        const index_t num_e = num_edges(graph);
+
+        workspace_vector<index_t> selected_edges;
+        for (index_t i = 0; i < num_e; i++) {
+            if (edge_weights(i) <= altitude) {
+                selected_edges.push_back(i);
+            }
+        }
+        array_1d<index_t> selected = xt::adapt(selected_edges, {selected_edges.size()});
+        array_1d<value_type> selected_weights = gather(edge_weights, selected);
+        array_1d<index_t> order = stable_arg_sort(selected_weights);
+
+        workspace_union_find uf(num_v);
+        workspace_array_1d<index_t> uf_roots = xt::arange<index_t>(num_v);
+        std::vector<index_t> parents(num_v);
+        std::iota(parents.begin(), parents.end(), 0);
+        std::vector<index_t> mst_edge_map;
+
+        for (index_t i = 0; i < (index_t) order.size() && (index_t) mst_edge_map.size() < num_v - 1; i++) {
+            check_cancellation(i);
+            auto ei = selected(order(i));
+            auto c1 = uf.find(graph_sources(ei));
+            auto c2 = uf.find(graph_targets(ei));
+            if (c1 != c2) {
+                index_t new_node = parents.size();
+                parents[uf_roots(c1)] = new_node;
+                parents[uf_roots(c2)] = new_node;
+                parents.push_back(new_node);
+                uf_roots(uf.link(c1, c2)) = new_node;
+                mst_edge_map.push_back(ei);
+            }
+        }
+
+        auto labels = hierarchy_core_internal::label_union_find_components(uf, num_v);
+        array_1d<index_t> roots = array_1d<index_t>::from_shape({(size_t) labels.second});
+        for (index_t v = 0; v < num_v; v++) {
+            roots(labels.first(v)) = uf_roots(uf.find(v));
+        }
+
+        const index_t num_nodes = parents.size();
+        array_1d<value_type> altitudes = array_1d<value_type>::from_shape({(size_t) num_nodes});
+        std::fill(altitudes.begin(), altitudes.begin() + num_v, 0);
+        for (index_t i = num_v; i < num_nodes; i++) {
+            altitudes(i) = edge_weights(mst_edge_map[i - num_v]);
+        }
+
+        return node_weighted_forest_and_msf<array_1d<value_type>>{
+                xt::adapt(parents, {parents.size()}),
+                std::move(altitudes),
+                xt::adapt(mst_edge_map, {mst_edge_map.size()}),
+                std::move(labels.first),
+                std::move(roots)};
+    };
+
+    /**
+     * Upper part of the canonical binary partition tree of the given edge weighted graph, above the given altitude.
+     *
+     * The leaves of the result are the supervertices of the graph: the connected components of the graph restricted
+     * to the edges of weight smaller than or equal to altitude, numbered in the order of their smallest vertex
+     * (supervertex_map(v) is the leaf containing the vertex v). The leaves have altitude 0, and the non leaf nodes,
+     * their altitudes and their minimum spanning tree edges are identical to the ones of the last nodes of the result
+     * of bpt_canonical (in the same order). This is for example sufficient for a horizontal cut at an altitude
+     * greater than or equal to the given one.
+     *
+     * The supervertices are computed with a union find over the light edges taken in any order: only the edges
+     * of weight greater than altitude linking two different supervertices are sorted.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph (must be connected)
+     * @param xedge_weights 1d array of edge weights
+     * @param altitude altitude of the supervertices
+     * @return a partial_node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T>
+    auto bpt_canonical_above(const graph_t &graph, const xt::xexpression<T> &xedge_weights, double altitude) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_type = typename T::value_type;
+
+        auto &&graph_sources = sources(graph);
+        auto &&graph_targets = targets(graph);
+        const index_t num_v = num_vertices(graph);
+        const index_t num_e = num_edges(graph);
+
+        workspace_union_find uf(num_v);
+        for (index_t i = 0; i < num_e; i++) {
+            if (edge_weights(i) <= altitude) {
+                auto c1 = uf.find(graph_sources(i));
+                auto c2 = uf.find(graph_targets(i));
+                if (c1 != c2) {
+                    uf.link(c1, c2);
+                }
+            }
+        }
+        auto labels = hierarchy_core_internal::label_union_find_components(uf, num_v);
+        auto &supervertex_map = labels.first;
+
+        // edges between supervertices, in increasing index order
+        workspace_vector<index_t> quotient_edges;
+        for (index_t i = 0; i < num_e; i++) {
+            if (edge_weights(i) > altitude &&
+                supervertex_map(graph_sources(i)) != supervertex_map(graph_targets(i))) {
+                quotient_edges.push_back(i);
+            }
+        }
+        array_1d<index_t> quotient_edge_map = xt::adapt(quotient_edges, {quotient_edges.size()});
+        array_1d<index_t> quotient_sources = gather(supervertex_map, gather(graph_sources, quotient_edge_map));
+        array_1d<index_t> quotient_targets = gather(supervertex_map, gather(graph_targets, quotient_edge_map));
+        array_1d<value_type> quotient_weights = gather(edge_weights, quotient_edge_map);
+        array_1d<index_t> sorted_edges_indices = stable_arg_sort(quotient_weights);
+
+        auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges(quotient_sources,
+                                                                            quotient_targets,
+                                                                            sorted_edges_indices,
+                                                                            labels.second);
+        array_1d<index_t> mst_edge_map = gather(quotient_edge_map, res.second);
+        auto bpt = hierarchy_core_internal::make_bpt_canonical_result(labels.second,
+                                                                      edge_weights,
+                                                                      std::move(res.first),
+                                                                      std::move(mst_edge_map));
+        return partial_node_weighted_tree_and_mst<decltype(bpt.tree), decltype(bpt.altitudes)>{
+                std::move(bpt.tree),
+                std::move(bpt.altitudes),
+                std::move(bpt.mst_edge_map),
+                std::move(supervertex_map)};
     };
 
 
@@ -179,7 +1001,7 @@ namespace hg {
             // identification of deleted sub-trees
             // true if all nodes below a given  node are deleted
             // a non deleted non leaf node i such that removed_branch(i) && !removed_branch(parent(i)) is thus a new leaf
-            array_1d<bool> removed_branch = xt::zeros<bool>({num_vertices(t)});
+            workspace_array_1d<bool> removed_branch = xt::zeros<bool>({num_vertices(t)});
             for (index_t i = 0; i < (index_t) num_leaves(t); i++) {
                 removed_branch(i) = criterion(i);
             }
@@ -196,7 +1018,7 @@ namespace hg {
             // ********************************
             // Identification and labeling of leaves
 
-            std::vector<index_t> new_leaves;
+            workspace_vector<index_t> new_leaves;
             index_t removed = 0;
 
             for (index_t i : leaves_iterator(t)) {
@@ -230,10 +1052,10 @@ namespace hg {
             array_1d<index_t> node_map = xt::empty<index_t>({num_nodes_new_tree});
             index_t node_number = num_nodes_new_tree - 1;
 
-            std::queue<index_t> queue;
+            std::queue<index_t, std::deque<index_t, workspace_allocator<index_t>>> queue;
 
             // new index of each node
-            array_1d<index_t> new_order({num_vertices(t)}, invalid_index);
+            workspace_array_1d<index_t> new_order({num_vertices(t)}, invalid_index);
             for (index_t i = 0; i < (index_t) new_leaves.size(); i++) {
                 new_order(new_leaves[i]) = i;
             }
@@ -265,12 +1087,12 @@ namespace hg {
                 node_map(i) = n;
                 i++;
             }
-            return make_remapped_tree(tree(new_parent, t.category()), std::move(node_map));
+            return make_remapped_tree(tree(std::move(new_parent), t.category()), std::move(node_map));
         } else {
             auto n_nodes = num_vertices(t);
             auto n_leaves = num_leaves(t);
 
-            array_1d<index_t> new_ranks = xt::empty<index_t>({n_nodes});
+            workspace_array_1d<index_t> new_ranks = xt::empty<index_t>({n_nodes});
 
             xt::view(new_ranks, xt::range(0, n_leaves)) = xt::arange<index_t>(n_leaves);
             index_t count = n_leaves;
@@ -333,19 +1155,21 @@ namespace hg {
         hg_assert_edge_weights(graph, edge_weights);
         hg_assert_1d_array(edge_weights);
 
-        auto bpt = bpt_canonical(graph, edge_weights);
-        auto &tree = bpt.tree;
-        auto &altitudes = bpt.altitudes;
-
-        auto altitude_parents = propagate_parallel(tree, altitudes);
-
-        auto qfz = simplify_tree(tree, xt::equal(altitudes, altitude_parents));
-        auto &qfz_tree = qfz.tree;
-        auto &node_map = qfz.node_map;
-
-        auto qfz_altitude = xt::eval(xt::index_view(altitudes, node_map));
-
-        return make_node_weighted_tree(std::move(qfz_tree), std::move(qfz_altitude));
+        array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+        auto bpt = ((index_t) num_edges(graph) == (index_t) num_vertices(graph) - 1) ?
+                   hierarchy_core_internal::bpt_canonical_from_sorted_tree_edges(sources(graph),
+                                                                                 targets(graph),
+                                                                                 sorted_edges_indices,
+                                                                                 num_vertices(graph)) :
+                   hierarchy_core_internal::bpt_canonical_from_sorted_edges(sources(graph),
+                                                                            targets(graph),
+                                                                            sorted_edges_indices,
+                                                                            num_vertices(graph));
+        auto res = hierarchy_core_internal::qfz_hierarchy_from_bpt_canonical(bpt.first,
+                                                                             bpt.second,
+                                                                             edge_weights,
+                                                                             num_vertices(graph));
+        return make_node_weighted_tree(tree(std::move(res.first)), std::move(res.second));
     }
 
     /**
@@ -366,10 +1190,82 @@ namespace hg {
     auto saliency_map(const graph_t &graph,
                       const tree_t &tree,
                       const xt::xexpression<T> &xaltitudes) {
+        HG_TRACE();
         auto &altitudes = xaltitudes.derived_cast();
-        lca_fast lca(tree);
-        auto lca_edges = lca.lca(edge_iterator(graph));
-        return xt::eval(xt::index_view(altitudes, lca_edges));
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        using value_type = typename T::value_type;
+
+        lca_bitmask_block lca(tree);
+        array_1d<value_type> result = array_1d<value_type>::from_shape({num_edges(graph)});
+        auto edges = edge_iterator(graph);
+        auto it = edges.begin();
+        lca.for_each_lca(num_edges(graph),
+                         [&it](index_t i) { return (index_t) it[i].first; },
+                         [&it](index_t i) { return (index_t) it[i].second; },
+                         [&result, &altitudes](index_t i, index_t n) { result(i) = altitudes(n); });
+        return result;
+    }
+
+    /**
+     * Compute the saliency map of a canonical binary partition tree (see bpt_canonical) for the graph it was
+     * computed on.
+     *
+     * The lowest common ancestor of the extremities of the i-th edge of the minimum spanning tree is the node
+     * num_leaves(tree) + i: the altitude of this node is thus directly assigned to the edge mst_edge_map(i) and lowest
+     * common ancestors are only computed for the edges that are not in the minimum spanning tree.
+     *
+     * @tparam graph_t Input graph type
+     * @tparam tree_t Input tree type
+     * @tparam altitude_t Input altitudes type
+     * @param graph Input graph
+     * @param bpt Canonical binary partition tree of the graph with its altitudes and its minimum spanning tree edge map
+     * @return An array of shape (num_edges(graph)) and with the same value type as altitude_t.
+     */
+    template<typename graph_t, typename tree_t, typename altitude_t>
+    auto saliency_map(const graph_t &graph,
+                      const node_weighted_tree_and_mst<tree_t, altitude_t> &bpt) {
+        HG_TRACE();
+        auto &tree = bpt.tree;
+        auto &altitudes = bpt.altitudes;
+        auto &mst_edge_map = bpt.mst_edge_map;
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        hg_assert(num_vertices(tree) == num_leaves(tree) + mst_edge_map.size(),
+                  "The minimum spanning tree edge map does not match the tree.");
+        hg_assert(num_leaves(tree) == num_vertices(graph), "The tree leaves do not match the graph vertices.");
+        using value_type = typename std::decay_t<altitude_t>::value_type;
+
+        const index_t num_edges_graph = num_edges(graph);
+        const index_t num_leaves_tree = num_leaves(tree);
+        const index_t num_mst_edges = mst_edge_map.size();
+        array_1d<value_type> result = array_1d<value_type>::from_shape({(size_t) num_edges_graph});
+        scatter(xt::view(altitudes, xt::range(num_leaves_tree, num_leaves_tree + num_mst_edges)), mst_edge_map,
+                result.data());
+        std::vector<bool> in_mst(num_edges_graph, false);
+        for (index_t i = 0; i < num_mst_edges; i++) {
+            in_mst[mst_edge_map(i)] = true;
+        }
+
+        array_1d<index_t> other_edges = array_1d<index_t>::from_shape({(size_t) (num_edges_graph - num_mst_edges)});
+        for (index_t i = 0, k = 0; i < num_edges_graph; i++) {
+            if (!in_mst[i]) {
+                other_edges(k++) = i;
+            }
+        }
+
+        lca_bitmask_block lca(tree);
+        lca.for_each_lca(other_edges.size(),
+                         [&graph, &other_edges](index_t i) {
+                             return (index_t) source(edge_from_index(other_edges(i), graph), graph);
+                         },
+                         [&graph, &other_edges](index_t i) {
+                             return (index_t) target(edge_from_index(other_edges(i), graph), graph);
+                         },
+                         [&result, &altitudes, &other_edges](index_t i, index_t n) {
+                             result(other_edges(i)) = altitudes(n);
+                         });
+        return result;
     }
 
     /**
@@ -386,6 +1282,9 @@ namespace hg {
      * The number of children of :math:`n` is thus reduced by 1.
      * This operation is repeated :math:`k-2` times, i.e. until :math:`n` has only 2 children.
      *
+     * The nodes of the result are numbered with a prefix sum on the number of children of the non-leaf nodes of the
+     * input tree, and the tree is then built in parallel.
+     *
      * @tparam tree_t Input tree type
      * @param tree Input tree
      * @return a remapped_tree
@@ -393,39 +1292,59 @@ namespace hg {
     template<typename tree_t>
     auto tree_2_binary_tree(const tree_t &tree) {
 
-        auto num_v = num_vertices(tree);
-        auto num_l = num_leaves(tree);
-        auto num_v_res = num_l * 2 - 1;
+        const index_t num_v = num_vertices(tree);
+        const index_t num_l = num_leaves(tree);
+        const index_t num_v_res = num_l * 2 - 1;
 
         tree.compute_children();
-        array_1d<index_t> node_map = array_1d<index_t>::from_shape({num_v});
-        array_1d<index_t> reverse_node_map = array_1d<index_t>::from_shape({num_v_res});
-        for (index_t i = 0; i < (index_t) num_l; i++) {
-            node_map(i) = i;
-            reverse_node_map(i) = i;
-        }
 
-        array_1d<index_t> new_parents = array_1d<index_t>::from_shape({num_v_res});
-        index_t cur_par_index = num_l;
+        // the k - 1 nodes of the binary tree representing the non leaf node num_l + i with k children are numbered
+        // from first_new_node(i) (first extra node) to first_new_node(i) + k - 2 (node representing num_l + i)
+        array_1d<index_t> first_new_node = array_1d<index_t>::from_shape({(size_t) (num_v - num_l + 1)});
+        first_new_node(0) = num_l;
+        parfor(num_l, num_v, [&tree, &first_new_node, num_l](index_t i) {
+            first_new_node(i - num_l + 1) = (index_t) num_children(i, tree) - 1;
+        });
+        parallel_inclusive_scan(first_new_node.data(), num_v - num_l + 1);
 
-        for (auto i: leaves_to_root_iterator(tree, leaves_it::exclude)) {
-            auto num_c = (index_t) num_children(i, tree);
-            new_parents(node_map(child(0, i, tree))) = cur_par_index;
-            new_parents(node_map(child(1, i, tree))) = cur_par_index;
+        auto node_map = [&first_new_node, num_l](index_t n) {
+            return (n < num_l) ? n : first_new_node(n - num_l + 1) - 1;
+        };
 
+        array_1d<index_t> new_parents = array_1d<index_t>::from_shape({(size_t) num_v_res});
+        array_1d<index_t> reverse_node_map = array_1d<index_t>::from_shape({(size_t) num_v_res});
+        parfor(0, num_l, [&reverse_node_map](index_t i) {
+            reverse_node_map(i) = i;
+        });
+
+        parfor(num_l, num_v, [&tree, &first_new_node, &new_parents, &reverse_node_map, &node_map, num_l](index_t i) {
+            const index_t num_c = num_children(i, tree);
+            const index_t first = first_new_node(i - num_l);
+            new_parents(node_map(child(0, i, tree))) = first;
+            new_parents(node_map(child(1, i, tree))) = first;
             for (index_t c = 2; c < num_c; c++) {
-                new_parents(cur_par_index) = cur_par_index + 1;
-                reverse_node_map(cur_par_index) = i;
-                cur_par_index++;
-                new_parents(node_map(child(c, i, tree))) = cur_par_index;
-            }
-            node_map(i) = cur_par_index;
-            reverse_node_map(cur_par_index) = i;
-            cur_par_index++;
-        }
+                new_parents(first + c - 2) = first + c - 1;
+                new_parents(node_map(child(c, i, tree))) = first + c - 1;
+            }
+            for (index_t n = first; n < first + num_c - 1; n++) {
+                reverse_node_map(n) = i;
+            }
+        });
 
         new_parents(num_v_res - 1) = num_v_res - 1;
 
-        return make_remapped_tree(hg::tree(new_parents, tree.category()), std::move(reverse_node_map));
+        return make_remapped_tree(hg::tree(std::move(new_parents), tree.category()), std::move(reverse_node_map));
     }
 }
+
+#include "../detail/prebuilt.hpp"
+
+#define HG_PREBUILT_HIERARCHY_CORE(prefix, value_t)                                           \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, bpt_canonical, ugraph, value_t)                \
+    HG_PREBUILT_GRAPH_WEIGHTS_FUNCTION(prefix, quasi_flat_zone_hierarchy, ugraph, value_t)
+
+#ifdef HG_USE_PREBUILT_LIBRARY
+namespace hg {
+    HG_PREBUILT_FOR_EACH_VALUE_TYPE(HG_PREBUILT_HIERARCHY_CORE, extern)
+}
+#endif
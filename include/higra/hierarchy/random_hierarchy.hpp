@@ -0,0 +1,190 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include <random>
+
+namespace hg {
+
+    namespace random_hierarchy_internal {
+
+        /**
+         * Ordered list of growable nodes supporting the removal of the k-th element in logarithmic time: the elements
+         * are stored in their insertion order and a Fenwick tree counts the elements that are still present.
+         */
+        struct growable_list {
+
+            growable_list(index_t capacity) :
+                    m_counts(capacity + 1, 0),
+                    m_nodes(capacity),
+                    m_size(0),
+                    m_num_inserted(0) {
+                m_log = 1;
+                while ((m_log << 1) <= capacity) {
+                    m_log <<= 1;
+                }
+            }
+
+            index_t size() const {
+                return m_size;
+            }
+
+            void push_back(index_t node) {
+                m_nodes[m_num_inserted] = node;
+                for (index_t i = m_num_inserted + 1; i < (index_t) m_counts.size(); i += i & (-i)) {
+                    m_counts[i]++;
+                }
+                m_num_inserted++;
+                m_size++;
+            }
+
+            /**
+             * Removes and returns the k-th element (starting from 0) of the list
+             */
+            index_t pop(index_t k) {
+                // position of the first prefix containing k + 1 elements
+                index_t pos = 0;
+                for (index_t step = m_log; step > 0; step >>= 1) {
+                    if (pos + step < (index_t) m_counts.size() && m_counts[pos + step] <= k) {
+                        pos += step;
+                        k -= m_counts[pos];
+                    }
+                }
+                for (index_t i = pos + 1; i < (index_t) m_counts.size(); i += i & (-i)) {
+                    m_counts[i]--;
+                }
+                m_size--;
+                return m_nodes[pos];
+            }
+
+        private:
+            std::vector<index_t> m_counts;
+            std::vector<index_t> m_nodes;
+            index_t m_log;
+            index_t m_size;
+            index_t m_num_inserted;
+        };
+
+        /**
+         * Fills the parents array of a random binary partition tree, see random_binary_partition_tree.
+         *
+         * @tparam rng_t
+         * @param num_leaves number of leaves of the tree
+         * @param asymmetry_probability real value between 0 and 1
+         * @param rng random number generator
+         * @param parents pointer to an array of size 2 * num_leaves - 1
+         */
+        template<typename rng_t>
+        void random_binary_partition_tree(index_t num_leaves, double asymmetry_probability, rng_t &rng,
+                                          index_t *parents) {
+            const index_t num_nodes = num_leaves * 2 - 1;
+            // nodes are identified by their creation order: the root is 0 and the children of the node split
+            // at step k (split_node[k]) are 2k + 1 and 2k + 2
+            std::vector<index_t> node_index(num_nodes, invalid_index);
+            std::vector<index_t> split_node(num_leaves - 1);
+            growable_list growable(num_nodes);
+            growable.push_back(0);
+
+            std::uniform_real_distribution<double> uniform(0, 1);
+            index_t next_internal_node = num_nodes - 1;
+            for (index_t k = 0; k < num_leaves - 1; k++) {
+                auto max_rank = (index_t) std::floor(asymmetry_probability * (double) (growable.size() - 1));
+                std::uniform_int_distribution<index_t> random_rank(0, max_rank);
+                index_t node = growable.pop(random_rank(rng));
+                split_node[k] = node;
+                node_index[node] = next_internal_node--;
+
+                const index_t left = 2 * k + 1;
+                const index_t right = 2 * k + 2;
+                if (uniform(rng) < asymmetry_probability) {
+                    growable.push_back((uniform(rng) >= 0.5) ? right : left);
+                } else {
+                    growable.push_back(left);
+                    growable.push_back(right);
+                }
+            }
+
+            // leaves are numbered in creation order
+            index_t next_leaf = 0;
+            for (index_t n = 0; n < num_nodes; n++) {
+                if (node_index[n] == invalid_index) {
+                    node_index[n] = next_leaf++;
+                }
+            }
+            parents[node_index[0]] = node_index[0];
+            for (index_t n = 1; n < num_nodes; n++) {
+                parents[node_index[n]] = node_index[split_node[(n - 1) / 2]];
+            }
+        }
+    }
+
+    /**
+     * Random binary partition tree with a controlled amount of asymmetry/unbalancedness.
+     *
+     * The tree is grown from the root to the leaves. At each step, the algorithm randomly selects one of the first
+     * floor(asymmetry_probability * (g - 1)) + 1 growable leaves of the current tree (in their insertion order),
+     * with g the number of growable leaves. Two children are added to the selected node, then:
+     *
+     *  - with probability 1 - asymmetry_probability, both new children are marked as growable; and
+     *  - with probability asymmetry_probability, only one of the children is marked as growable.
+     *
+     * At 0 the tree is perfectly balanced (if num_leaves is a power of 2), at 1 it is perfectly unbalanced.
+     * The generation time is O(n log(n)) with n the number of leaves.
+     *
+     * @param num_leaves number of leaves of the tree
+     * @param asymmetry_probability real value between 0 and 1
+     * @param seed seed of the random number generator
+     * @return a tree
+     */
+    inline auto random_binary_partition_tree(index_t num_leaves, double asymmetry_probability,
+                                             unsigned int seed) {
+        HG_TRACE();
+        hg_assert(num_leaves > 0, "The number of leaves must be positive.");
+        hg_assert(asymmetry_probability >= 0 && asymmetry_probability <= 1,
+                  "The asymmetry probability must be between 0 and 1.");
+        std::mt19937_64 rng(seed);
+        array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) (2 * num_leaves - 1)});
+        random_hierarchy_internal::random_binary_partition_tree(num_leaves, asymmetry_probability, rng,
+                                                                &parents(0));
+        return tree(std::move(parents));
+    }
+
+    /**
+     * Generates num_trees random binary partition trees in parallel (see random_binary_partition_tree).
+     *
+     * Each tree has its own random number generator, seeded from the given seed and the index of the tree: the
+     * result does not depend on the number of threads.
+     *
+     * @param num_trees number of trees
+     * @param num_leaves number of leaves of each tree
+     * @param asymmetry_probability real value between 0 and 1
+     * @param seed seed of the random number generators
+     * @return a 2d array of shape (num_trees, 2 * num_leaves - 1): the i-th row is the parents array of the i-th tree
+     */
+    inline auto random_binary_partition_trees(index_t num_trees, index_t num_leaves, double asymmetry_probability,
+                                              unsigned int seed) {
+        HG_TRACE();
+        hg_assert(num_trees >= 0, "The number of trees cannot be negative.");
+        hg_assert(num_leaves > 0, "The number of leaves must be positive.");
+        hg_assert(asymmetry_probability >= 0 && asymmetry_probability <= 1,
+                  "The asymmetry probability must be between 0 and 1.");
+        const index_t num_nodes = 2 * num_leaves - 1;
+        array_2d<index_t> parents = array_2d<index_t>::from_shape({(size_t) num_trees, (size_t) num_nodes});
+        parfor(0, num_trees, [&parents, num_nodes, num_leaves, asymmetry_probability, seed](index_t i) {
+            std::seed_seq seq{seed, (unsigned int) i, (unsigned int) (i >> 32)};
+            std::mt19937_64 rng(seq);
+            random_hierarchy_internal::random_binary_partition_tree(num_leaves, asymmetry_probability, rng,
+                                                                    parents.data() + i * num_nodes);
+        });
+        return parents;
+    }
+}
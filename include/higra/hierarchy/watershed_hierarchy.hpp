@@ -15,18 +15,38 @@
 #include "hierarchy_core.hpp"
 #include "higra/attribute/tree_attribute.hpp"
 #include "higra/algo/graph_core.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
 
 namespace hg {
 
     namespace watershed_hierarchy_internal {
 
+        /**
+         * Sources and targets of the edges of the minimum spanning tree of the graph given by the mst_edge_map of
+         * bpt_canonical: the i-th edge of the minimum spanning tree is the edge mst_edge_map(i) of the graph.
+         */
+        template<typename graph_t, typename T>
+        auto mst_edge_extremities(const graph_t &graph, const T &mst_edge_map) {
+            const size_t num_mst_edges = mst_edge_map.size();
+            workspace_array_1d<index_t> mst_sources = workspace_array_1d<index_t>::from_shape({num_mst_edges});
+            workspace_array_1d<index_t> mst_targets = workspace_array_1d<index_t>::from_shape({num_mst_edges});
+            for (index_t i = 0; i < (index_t) num_mst_edges; i++) {
+                auto e = edge_from_index(mst_edge_map(i), graph);
+                mst_sources(i) = source(e, graph);
+                mst_targets(i) = target(e, graph);
+            }
+            return std::make_pair(std::move(mst_sources), std::move(mst_targets));
+        }
+
         template<typename tree_t, typename T1, typename T2>
         auto correct_attribute_BPT(const tree_t &tree,
                                    const T1 &altitude,
                                    const T2 &attribute) {
             using value_type = typename T2::value_type;
             tree.compute_children();
-            array_1d<value_type> result = xt::empty_like(attribute);
+            workspace_array_1d<value_type> result = workspace_array_1d<value_type>::from_shape({attribute.size()});
             for (auto n: leaves_iterator(tree)) {
                 result(n) = 0;
             }
@@ -36,7 +56,7 @@ namespace hg {
                 } else {
                     value_type maxc = std::numeric_limits<value_type>::lowest();
                     for (auto c: children_iterator(n, tree)) {
-                        maxc = (std::max)(maxc, (is_leaf(c, tree)) ? 0 : result(c));
+                        maxc = (std::max)(maxc, (is_leaf(c, tree)) ? (value_type) 0 : result(c));
                     }
                     result(n) = maxc;
                 }
@@ -44,8 +64,209 @@ namespace hg {
             result(root(tree)) = attribute(root(tree));
             return result;
         };
+
+        /**
+         * Fused correct_attribute_BPT and children minimum (see watershed_hierarchy_by_attribute) of the
+         * attribute of the canonical binary partition tree bpt: returns the persistence of the internal nodes of
+         * bpt, that is the weights of the corresponding edges of the minimum spanning tree.
+         *
+         * The children of bpt must be computed.
+         */
+        template<typename tree_t, typename T1, typename T2>
+        array_1d<double> bpt_persistence(const tree_t &bpt, const T1 &altitude, const T2 &attribute) {
+            const index_t num_l = num_leaves(bpt);
+            const index_t num_n = num_vertices(bpt);
+            const index_t root_node = root(bpt);
+            workspace_vector<double> corrected(num_n, 0);
+            array_1d<double> persistence = array_1d<double>::from_shape({(size_t) (num_n - num_l)});
+            for (index_t n = num_l; n < num_n; n++) {
+                double c0 = corrected[child(0, n, bpt)];
+                double c1 = corrected[child(1, n, bpt)];
+                persistence(n - num_l) = (std::min)(c0, c1);
+                corrected[n] = (n == root_node || altitude(n) != altitude(parent(n, bpt))) ?
+                               (double) attribute(n) : (std::max)(c0, c1);
+            }
+            return persistence;
+        }
+
+        /**
+         * Watershed hierarchy of the graph for the given attribute values of the nodes of its canonical binary
+         * partition tree bpt (see watershed_hierarchy_by_attribute): the altitudes of the result have the value type of
+         * the attribute.
+         */
+        template<typename graph_t, typename tree_t, typename T1, typename T2, typename T3>
+        auto watershed_hierarchy_from_bpt_attribute(const graph_t &graph,
+                                                    const tree_t &bpt,
+                                                    const T1 &altitude,
+                                                    const T2 &mst_edge_map,
+                                                    const T3 &bpt_attribute) {
+            auto mst = mst_edge_extremities(graph, mst_edge_map);
+
+            auto corrected_attribute = correct_attribute_BPT(bpt, altitude, bpt_attribute);
+            auto persistence = accumulate_parallel(bpt, corrected_attribute, accumulator_min());
+            xt::view(persistence, xt::range(0, num_leaves(bpt))) = 0;
+
+            auto mst_edge_weights = xt::view(persistence, xt::range(num_leaves(bpt), num_vertices(bpt)));
+
+            return hierarchy_core_internal::bpt_canonical_from_tree_edges(mst.first, mst.second, mst_edge_weights,
+                                                                          num_vertices(graph));
+        }
+
+        /**
+         * Waterfall level of each edge of a minimum spanning tree whose edges are sorted by increasing weights (the
+         * i-th edge of the tree is lighter than the (i+1)-th edge): the level of an edge is the index of the
+         * waterfall iteration in which the two regions it links are merged (see waterfall_hierarchy).
+         *
+         * Each iteration is a Borůvka step on the quotient of the minimum spanning tree by the current regions: each
+         * region is merged with the region at the other end of its lightest adjacent edge. The quotient is a tree and
+         * each region is merged with at least one other region, thus the number of regions is at least halved and
+         * the total cost of the iterations is linear (up to the inverse Ackermann function of the union find).
+         *
+         * @param mst_sources sources of the edges of the minimum spanning tree
+         * @param mst_targets targets of the edges of the minimum spanning tree
+         * @param num_vertices number of vertices of the minimum spanning tree
+         * @return a 1d array of levels (starting at 1) of the edges of the minimum spanning tree
+         */
+        template<typename T1, typename T2>
+        auto waterfall_levels(const T1 &mst_sources, const T2 &mst_targets, index_t num_vertices) {
+            const index_t num_mst_edges = mst_sources.size();
+            array_1d<index_t> levels = array_1d<index_t>::from_shape({(size_t) num_mst_edges});
+
+            // edges of the quotient tree that are not merged yet, in increasing order: index in the minimum
+            // spanning tree and extremities (indices of regions)
+            workspace_vector<index_t> edges(num_mst_edges);
+            workspace_vector<index_t> sources(mst_sources.begin(), mst_sources.end());
+            workspace_vector<index_t> targets(mst_targets.begin(), mst_targets.end());
+            std::iota(edges.begin(), edges.end(), 0);
+            workspace_vector<index_t> lightest_edge;
+
+            index_t num_regions = num_vertices;
+            for (index_t level = 1; !edges.empty(); level++) {
+                lightest_edge.assign(num_regions, invalid_index);
+                for (index_t i = 0; i < (index_t) edges.size(); i++) {
+                    if (lightest_edge[sources[i]] == invalid_index) {
+                        lightest_edge[sources[i]] = i;
+                    }
+                    if (lightest_edge[targets[i]] == invalid_index) {
+                        lightest_edge[targets[i]] = i;
+                    }
+                }
+
+                workspace_union_find uf(num_regions);
+                for (index_t r = 0; r < num_regions; r++) {
+                    auto i = lightest_edge[r];
+                    auto c1 = uf.find(sources[i]);
+                    auto c2 = uf.find(targets[i]);
+                    if (c1 != c2) {
+                        uf.link(c1, c2);
+                    }
+                }
+                auto labels = hierarchy_core_internal::label_union_find_components(uf, num_regions);
+                auto &region_map = labels.first;
+
+                // the edges inside the new regions are merged at this level (as the quotient is a tree, these are
+                // exactly the lightest edges of the regions), the other ones are kept in the same order
+                index_t num_kept = 0;
+                for (index_t i = 0; i < (index_t) edges.size(); i++) {
+                    auto s = region_map(sources[i]);
+                    auto t = region_map(targets[i]);
+                    if (s == t) {
+                        levels(edges[i]) = level;
+                    } else {
+                        edges[num_kept] = edges[i];
+                        sources[num_kept] = s;
+                        targets[num_kept] = t;
+                        num_kept++;
+                    }
+                }
+                edges.resize(num_kept);
+                sources.resize(num_kept);
+                targets.resize(num_kept);
+                num_regions = labels.second;
+            }
+            return levels;
+        }
+
+        /**
+         * Watershed hierarchy of the graph for a regional attribute whose persistence can be computed during the
+         * Kruskal sweep of the graph edges that builds the minimum spanning tree, without building the canonical binary
+         * partition tree of the graph nor computing the attribute on its nodes (see watershed_hierarchy_by_dynamics and
+         * watershed_hierarchy_by_minima_ordering).
+         *
+         * Each region of the sweep (component of the union-find) carries an annotation: init(v) is the annotation of
+         * the vertex v. When an edge of weight w merges two regions with annotations a1 and a2,
+         * persistence(a1, a2, w) is the weight of this edge of the minimum spanning tree in the watershed hierarchy
+         * and merge(a1, a2, w) is the annotation of the merged region. The persistence is 0 if one of the two regions
+         * is a single vertex.
+         *
+         * The result is identical to watershed_hierarchy_from_bpt_attribute with the corresponding attribute: the
+         * minimum spanning tree edges are found in the same order as in bpt_canonical.
+         */
+        template<typename persistence_t, typename annotation_t, typename graph_t, typename T,
+                typename F1, typename F2, typename F3>
+        auto watershed_hierarchy_from_kruskal_annotations(const graph_t &graph,
+                                                          const T &edge_weights,
+                                                          const F1 &init,
+                                                          const F2 &persistence,
+                                                          const F3 &merge) {
+            const index_t num_v = num_vertices(graph);
+            const index_t num_mst_edges = num_v - 1;
+            const auto &graph_sources = sources(graph);
+            const auto &graph_targets = targets(graph);
+            array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+
+            workspace_union_find uf(num_v);
+            workspace_vector<annotation_t> annotations(num_v);
+            // single(c) is true if the region of root c in the union-find is a single vertex
+            workspace_vector<unsigned char> single(num_v, 1);
+            for (index_t v = 0; v < num_v; v++) {
+                annotations[v] = init(v);
+            }
+
+            workspace_array_1d<index_t> mst_sources = workspace_array_1d<index_t>::from_shape(
+                    {(size_t) num_mst_edges});
+            workspace_array_1d<index_t> mst_targets = workspace_array_1d<index_t>::from_shape(
+                    {(size_t) num_mst_edges});
+            array_1d<persistence_t> mst_persistence = array_1d<persistence_t>::from_shape({(size_t) num_mst_edges});
+
+            index_t num_edge_found = 0;
+            for (index_t i = 0; num_edge_found < num_mst_edges && i < (index_t) sorted_edges_indices.size(); i++) {
+                check_cancellation(i);
+                auto ei = sorted_edges_indices(i);
+                auto s = graph_sources(ei);
+                auto t = graph_targets(ei);
+                auto c1 = uf.find(s);
+                auto c2 = uf.find(t);
+                if (c1 != c2) {
+                    auto w = edge_weights(ei);
+                    mst_sources(num_edge_found) = s;
+                    mst_targets(num_edge_found) = t;
+                    mst_persistence(num_edge_found) = (single[c1] || single[c2]) ?
+                                                      (persistence_t) 0 :
+                                                      (persistence_t) persistence(annotations[c1], annotations[c2], w);
+                    auto merged = merge(annotations[c1], annotations[c2], w);
+                    auto new_root = uf.link(c1, c2);
+                    annotations[new_root] = merged;
+                    single[new_root] = 0;
+                    num_edge_found++;
+                }
+            }
+            hg_assert(num_edge_found == num_mst_edges, "Input graph must be connected.");
+
+            return hierarchy_core_internal::bpt_canonical_from_tree_edges(mst_sources, mst_targets, mst_persistence,
+                                                                          num_v);
+        }
     }
 
+    /**
+     * Regional attributes of the watershed hierarchies computed by watershed_hierarchies_by_attributes
+     */
+    enum class watershed_attribute {
+        area,
+        volume,
+        dynamics
+    };
+
     /**
      * Computes a hierarchical watershed for the given regional attribute.
      *
@@ -59,6 +280,8 @@ namespace hg {
      *   - returns an 1d array giving the attribute value for each node of the input tree.
      * The computed regional attribute must be scalar, positive and increasing
      * (the attribute value of a node is smaller than or equal to the attribute value of its parent).
+     * The altitudes of the resulting hierarchy have the value type of the attribute: an integral attribute (e.g. the
+     * area of the regions) gives integral altitudes.
      *
      * @tparam graph_t
      * @tparam T
@@ -78,19 +301,9 @@ namespace hg {
         hg_assert_1d_array(edge_weights);
 
         auto bptc = bpt_canonical(graph, edge_weights);
-        auto &bpt = bptc.tree;
-        auto &altitude = bptc.altitudes;
-        auto &mst_edge_map = bptc.mst_edge_map;
-        auto mst = subgraph_spanning(graph, mst_edge_map);
-
-        auto bpt_attribute = attribute_functor(bpt, altitude);
-        auto corrected_attribute = watershed_hierarchy_internal::correct_attribute_BPT(bpt, altitude, bpt_attribute);
-        auto persistence = accumulate_parallel(bpt, corrected_attribute, accumulator_min());
-        xt::view(persistence, xt::range(0, num_leaves(bpt))) = 0;
-
-        auto mst_edge_weights = xt::view(persistence, xt::range(num_leaves(bpt), num_vertices(bpt)));
-
-        return bpt_canonical(mst, mst_edge_weights);
+        auto bpt_attribute = attribute_functor(bptc.tree, bptc.altitudes);
+        return watershed_hierarchy_internal::watershed_hierarchy_from_bpt_attribute(graph, bptc.tree, bptc.altitudes,
+                                                                                    bptc.mst_edge_map, bpt_attribute);
     };
 
     /**
@@ -134,19 +347,15 @@ namespace hg {
         hg_assert_1d_array(minima_ranks);
         hg_assert_integral_value_type(minima_ranks);
 
-        auto bptc = bpt_canonical(graph, edge_weights);
-        auto &bpt = bptc.tree;
-        auto &mst_edge_map = bptc.mst_edge_map;
-        auto mst = subgraph_spanning(graph, mst_edge_map);
-
-        auto extinction = accumulate_sequential(bpt, minima_ranks, accumulator_max());
-        xt::view(extinction, xt::range(0, num_leaves(bpt))) = 0;
-        auto persistence = accumulate_parallel(bpt, extinction, accumulator_min());
-        xt::view(persistence, xt::range(0, num_leaves(bpt))) = 0;
-
-        auto mst_edge_weights = xt::view(persistence, xt::range(num_leaves(bpt), num_vertices(bpt)));
-
-        return bpt_canonical(mst, mst_edge_weights);
+        // the extinction value of a region is the largest rank of its minima: it is carried by the union-find during
+        // the Kruskal sweep and the persistence of an edge is the smallest extinction value of the two merged regions
+        using value_type = typename T2::value_type;
+        return watershed_hierarchy_internal::watershed_hierarchy_from_kruskal_annotations<value_type, value_type>(
+                graph,
+                edge_weights,
+                [&minima_ranks](index_t v) { return minima_ranks(v); },
+                [](value_type r1, value_type r2, const auto &) { return (std::min)(r1, r2); },
+                [](value_type r1, value_type r2, const auto &) { return (std::max)(r1, r2); });
     };
 
     template<typename graph_t, typename T1, typename T2>
@@ -191,17 +400,390 @@ namespace hg {
         return watershed_hierarchy_by_volume(graph, xedge_weights, xt::ones<index_t>({num_vertices(graph)}));
     };
 
+    /**
+     * Computes the watershed hierarchy by dynamics of the given edge weighted graph.
+     *
+     * The dynamics are not computed on the canonical binary partition tree of the graph (see attribute_dynamics):
+     * each region of the Kruskal sweep that builds the minimum spanning tree carries the altitude of its deepest
+     * minimum, and the persistence of an edge merging two regions is the difference between its weight and the
+     * altitude of the deepest minimum of the shallowest region. The result is identical to
+     * watershed_hierarchy_by_attribute with the attribute attribute_dynamics.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph
+     * @param xedge_weights input graph edge weights
+     * @return a node_weighted_tree_and_mst
+     */
     template<typename graph_t, typename T>
     auto watershed_hierarchy_by_dynamics(
             const graph_t &graph,
-            const xt::xexpression<T> &edge_weights) {
+            const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        using value_type = typename T::value_type;
+        // same type as attribute_dynamics
+        using height_type = typename std::conditional<std::is_unsigned<value_type>::value,
+                value_type,
+                decltype(std::declval<value_type>() - std::declval<value_type>())>::type;
 
-        return watershed_hierarchy_by_attribute(
+        // the annotation of a region is the altitude of its deepest minimum (the lowest edge inside the region)
+        return watershed_hierarchy_internal::watershed_hierarchy_from_kruskal_annotations<height_type, value_type>(
                 graph,
                 edge_weights,
-                [](const tree &t, const auto &altitude) {
-                    return attribute_dynamics(t, altitude, true);
-                });
+                [](index_t) { return (std::numeric_limits<value_type>::max)(); },
+                [](value_type d1, value_type d2, value_type w) { return w - (std::max)(d1, d2); },
+                [](value_type d1, value_type d2, value_type w) { return (std::min)((std::min)(d1, d2), w); });
+    };
+
+    /**
+     * Computes the waterfall hierarchy of the given edge weighted graph.
+     *
+     * The first level of the waterfall is the watershed of the graph: each vertex flows along its lightest adjacent
+     * edge. Each following level is the watershed of the region adjacency graph of the previous level, whose edges are
+     * weighted by the pass values (lowest edge weights) between the regions. The waterfall is computed on the minimum
+     * spanning tree of the graph given by bpt_canonical, as a sequence of Borůvka steps, without building any region
+     * adjacency graph, in linear time after the computation of the minimum spanning tree:
+     *
+     *   J. Cousty, L. Najman, B. Perret:
+     *   Constructive links between some morphological hierarchies on edge-weighted graphs. ISMM 2013: 86-97
+     *
+     * Ties between edge weights are broken by edge indices (as in bpt_canonical). The result is the canonical
+     * binary partition tree of the minimum spanning tree weighted by the waterfall levels of its edges: the altitude
+     * of a non leaf node is the level (starting at 1) of the waterfall in which the region appears, and the
+     * mst_edge_map gives the indices of the corresponding edges of the graph.
+     *
+     * @tparam graph_t
+     * @tparam T
+     * @param graph input graph (must be connected)
+     * @param xedge_weights input graph edge weights
+     * @return a node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T>
+    auto waterfall_hierarchy(const graph_t &graph, const xt::xexpression<T> &xedge_weights) {
+        HG_TRACE();
+        auto &edge_weights = xedge_weights.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+
+        auto bptc = bpt_canonical(graph, edge_weights);
+        auto mst = watershed_hierarchy_internal::mst_edge_extremities(graph, bptc.mst_edge_map);
+        auto levels = watershed_hierarchy_internal::waterfall_levels(mst.first, mst.second, num_vertices(graph));
+
+        auto res = hierarchy_core_internal::bpt_canonical_from_tree_edges(mst.first, mst.second, levels,
+                                                                          num_vertices(graph));
+        res.mst_edge_map = gather(bptc.mst_edge_map, res.mst_edge_map);
+        return res;
+    };
+
+    /**
+     * Computes several hierarchical watersheds of the same edge weighted graph for the given regional attributes
+     * (see watershed_hierarchy_by_area, watershed_hierarchy_by_volume and watershed_hierarchy_by_dynamics).
+     *
+     * The canonical binary partition tree of the graph, its children and its minimum spanning tree are computed
+     * once and shared by all the attributes. The area and volume attributes, their correction and their
+     * persistence are computed in a single pass over the binary partition tree. The final binary partition trees
+     * of the minimum spanning tree weighted by the persistence of each attribute are computed in parallel.
+     *
+     * The i-th element of the result is the watershed hierarchy for the attribute attributes[i]: it is identical
+     * to the result of the corresponding watershed_hierarchy_by_* function except that altitudes are stored as
+     * double.
+     *
+     * @tparam graph_t
+     * @tparam T1
+     * @tparam T2
+     * @param graph input graph
+     * @param xedge_weights input graph edge weights
+     * @param attributes requested attributes
+     * @param xvertex_area area of the vertices of the graph (area and volume attributes)
+     * @return a vector of node_weighted_tree_and_mst
+     */
+    template<typename graph_t, typename T1, typename T2>
+    auto watershed_hierarchies_by_attributes(
+            const graph_t &graph,
+            const xt::xexpression<T1> &xedge_weights,
+            const std::vector<watershed_attribute> &attributes,
+            const xt::xexpression<T2> &xvertex_area) {
+        HG_TRACE();
+        using namespace watershed_hierarchy_internal;
+        auto &edge_weights = xedge_weights.derived_cast();
+        auto &vertex_area = xvertex_area.derived_cast();
+        hg_assert_edge_weights(graph, edge_weights);
+        hg_assert_1d_array(edge_weights);
+        hg_assert_vertex_weights(graph, vertex_area);
+        hg_assert_1d_array(vertex_area);
+
+        auto bptc = bpt_canonical(graph, edge_weights);
+        auto &bpt = bptc.tree;
+        auto &altitude = bptc.altitudes;
+        auto mst = mst_edge_extremities(graph, bptc.mst_edge_map);
+        bpt.compute_children();
+
+        const index_t num_l = num_leaves(bpt);
+        const index_t num_n = num_vertices(bpt);
+        auto requested = [&attributes](watershed_attribute a) {
+            return std::find(attributes.begin(), attributes.end(), a) != attributes.end();
+        };
+
+        // area, volume, their correction and their persistence in a single pass
+        array_1d<double> persistence_area;
+        array_1d<double> persistence_volume;
+        if (requested(watershed_attribute::area) || requested(watershed_attribute::volume)) {
+            using area_type = typename T2::value_type;
+            workspace_vector<area_type> area(num_n);
+            workspace_vector<double> volume(num_n, 0);
+            workspace_vector<double> corrected_area(num_n, 0);
+            workspace_vector<double> corrected_volume(num_n, 0);
+            persistence_area = array_1d<double>::from_shape({(size_t) (num_n - num_l)});
+            persistence_volume = array_1d<double>::from_shape({(size_t) (num_n - num_l)});
+            for (index_t n = 0; n < num_l; n++) {
+                area[n] = vertex_area(n);
+            }
+            const index_t root_node = root(bpt);
+            for (index_t n = num_l; n < num_n; n++) {
+                index_t c0 = child(0, n, bpt);
+                index_t c1 = child(1, n, bpt);
+                index_t p = parent(n, bpt);
+                area[n] = area[c0] + area[c1];
+                volume[n] = std::fabs(altitude(n) - altitude(p)) * area[n] + volume[c0] + volume[c1];
+                persistence_area(n - num_l) = (std::min)(corrected_area[c0], corrected_area[c1]);
+                persistence_volume(n - num_l) = (std::min)(corrected_volume[c0], corrected_volume[c1]);
+                if (n == root_node || altitude(n) != altitude(p)) {
+                    corrected_area[n] = (double) area[n];
+                    corrected_volume[n] = volume[n];
+                } else {
+                    corrected_area[n] = (std::max)(corrected_area[c0], corrected_area[c1]);
+                    corrected_volume[n] = (std::max)(corrected_volume[c0], corrected_volume[c1]);
+                }
+            }
+        }
+
+        array_1d<double> persistence_dynamics;
+        if (requested(watershed_attribute::dynamics)) {
+            persistence_dynamics = bpt_persistence(bpt, altitude, attribute_dynamics(bpt, altitude, true));
+        }
+
+        auto bpt_mst = [&mst, num_l](const array_1d<double> &persistence) {
+            return hierarchy_core_internal::bpt_canonical_from_tree_edges(mst.first, mst.second, persistence, num_l);
+        };
+        using result_type = decltype(bpt_mst(persistence_area));
+        std::vector<result_type> result(attributes.size());
+        parfor(0, attributes.size(), [&](index_t i) {
+            switch (attributes[i]) {
+                case watershed_attribute::area:
+                    result[i] = bpt_mst(persistence_area);
+                    break;
+                case watershed_attribute::volume:
+                    result[i] = bpt_mst(persistence_volume);
+                    break;
+                case watershed_attribute::dynamics:
+                    result[i] = bpt_mst(persistence_dynamics);
+                    break;
+            }
+        });
+        return result;
     };
 
-}
+    template<typename graph_t, typename T>
+    auto watershed_hierarchies_by_attributes(
+            const graph_t &graph,
+            const xt::xexpression<T> &xedge_weights,
+            const std::vector<watershed_attribute> &attributes) {
+        return watershed_hierarchies_by_attributes(graph, xedge_weights, attributes,
+                                                   xt::ones<index_t>({num_vertices(graph)}));
+    };
+
+    /**
+     * Repeated computation of the watershed hierarchy by area (see watershed_hierarchy_by_area) on a fixed graph,
+     * typically the 4-adjacency graph of the frames of a video.
+     *
+     * The engine is bound to a graph: the extremities of its edges and the area of its vertices are copied at
+     * construction, and all the buffers of the algorithm (sorted edges, parents and minimum spanning tree of the
+     * canonical binary partition tree, persistence of its nodes, resulting hierarchy) are allocated once. The
+     * temporaries (union-find structures, radix sort keys) are drawn from a workspace owned by the engine (see
+     * workspace.hpp). After the first call, compute thus performs no allocation for edge weights of arithmetic
+     * types.
+     *
+     * The resulting binary hierarchy is identical to the one computed by watershed_hierarchy_by_area and is
+     * overwritten by the next call: its parents, its altitudes and its minimum spanning tree are given as
+     * references to the internal buffers of the engine.
+     *
+     * The engine is not thread safe: a different engine must be used in each thread.
+     */
+    class watershed_hierarchy_by_area_engine {
+    public:
+
+        template<typename graph_t>
+        explicit watershed_hierarchy_by_area_engine(const graph_t &graph) :
+                watershed_hierarchy_by_area_engine(graph, xt::ones<double>({num_vertices(graph)})) {
+        }
+
+        template<typename graph_t, typename T>
+        watershed_hierarchy_by_area_engine(const graph_t &graph, const xt::xexpression<T> &xvertex_area) :
+                m_num_vertices(num_vertices(graph)) {
+            auto &vertex_area = xvertex_area.derived_cast();
+            hg_assert_vertex_weights(graph, vertex_area);
+            hg_assert_1d_array(vertex_area);
+            hg_assert(m_num_vertices > 0, "The graph must have at least one vertex.");
+
+            const size_t num_e = num_edges(graph);
+            const size_t num_v = m_num_vertices;
+            const size_t num_n = 2 * num_v - 1;
+            m_sources = array_1d<index_t>::from_shape({num_e});
+            m_targets = array_1d<index_t>::from_shape({num_e});
+            for (index_t i = 0; i < (index_t) num_e; i++) {
+                auto e = edge_from_index(i, graph);
+                m_sources(i) = source(e, graph);
+                m_targets(i) = target(e, graph);
+            }
+            m_vertex_area = vertex_area;
+
+            m_sorted_edges = array_1d<index_t>::from_shape({num_e});
+            m_sorted_edges_tmp = array_1d<index_t>::from_shape({num_e});
+            m_bpt_parents = array_1d<index_t>::from_shape({num_n});
+            m_bpt_mst_edge_map = array_1d<index_t>::from_shape({num_v - 1});
+            m_area = array_1d<double>::from_shape({num_n});
+            m_children_max = array_1d<double>::from_shape({num_v - 1});
+            m_persistence = array_1d<double>::from_shape({num_v - 1});
+            m_sorted_mst_edges = array_1d<index_t>::from_shape({num_v - 1});
+            m_sorted_mst_edges_tmp = array_1d<index_t>::from_shape({num_v - 1});
+            m_parents = xt::arange<index_t>(num_n);
+            m_altitudes = xt::zeros<double>({num_n});
+            m_mst_edge_map = array_1d<index_t>::from_shape({num_v - 1});
+        }
+
+        /**
+         * Computes the watershed hierarchy by area of the graph weighted by the given edge weights.
+         *
+         * @param xedge_weights 1d array of edge weights
+         */
+        template<typename T>
+        void compute(const xt::xexpression<T> &xedge_weights) {
+            HG_TRACE();
+            auto &edge_weights = xedge_weights.derived_cast();
+            hg_assert_1d_array(edge_weights);
+            hg_assert(edge_weights.size() == m_sources.size(),
+                      "The size of the edge weights does not match the number of edges of the graph.");
+            using value_type = typename T::value_type;
+
+            scoped_workspace scope(m_workspace);
+            const index_t num_v = m_num_vertices;
+            const index_t num_n = 2 * num_v - 1;
+            const index_t root_node = num_n - 1;
+
+            // canonical binary partition tree of the graph
+            auto sorted_edges = sorting_internal::stable_arg_sort_buffers(
+                    edge_weights, m_sorted_edges.data(), m_sorted_edges_tmp.data(), std::less<value_type>());
+            {
+                workspace_union_find uf(num_v);
+                workspace_array_1d<index_t> roots = xt::arange<index_t>(num_v);
+                std::iota(m_bpt_parents.begin(), m_bpt_parents.end(), 0);
+                index_t num_edge_found = 0;
+                for (index_t i = 0; num_edge_found < num_v - 1 && i < (index_t) m_sources.size(); i++) {
+                    auto ei = sorted_edges[i];
+                    auto c1 = uf.find(m_sources(ei));
+                    auto c2 = uf.find(m_targets(ei));
+                    if (c1 != c2) {
+                        const index_t n = num_v + num_edge_found;
+                        m_bpt_parents(roots(c1)) = n;
+                        m_bpt_parents(roots(c2)) = n;
+                        roots(uf.link(c1, c2)) = n;
+                        m_bpt_mst_edge_map(num_edge_found) = ei;
+                        num_edge_found++;
+                    }
+                }
+                hg_assert(num_edge_found == num_v - 1, "Input graph must be connected.");
+            }
+
+            // area, corrected area (see correct_attribute_BPT) and persistence (minimum of the corrected area of
+            // the children) of the nodes in a single pass: the children of a node have smaller indices
+            auto level = [&](index_t n) {
+                return edge_weights(m_bpt_mst_edge_map(n - num_v));
+            };
+            std::copy(m_vertex_area.begin(), m_vertex_area.end(), m_area.begin());
+            std::fill(m_area.begin() + num_v, m_area.end(), 0);
+            std::fill(m_children_max.begin(), m_children_max.end(), std::numeric_limits<double>::lowest());
+            std::fill(m_persistence.begin(), m_persistence.end(), (std::numeric_limits<double>::max)());
+            for (index_t n = 0; n < num_n; n++) {
+                double corrected = 0;
+                if (n >= num_v) {
+                    corrected = (n == root_node || level(n) != level(m_bpt_parents(n))) ?
+                                m_area(n) : m_children_max(n - num_v);
+                }
+                if (n != root_node) {
+                    const index_t p = m_bpt_parents(n);
+                    m_area(p) += m_area(n);
+                    m_children_max(p - num_v) = (std::max)(m_children_max(p - num_v), corrected);
+                    m_persistence(p - num_v) = (std::min)(m_persistence(p - num_v), corrected);
+                }
+            }
+
+            // canonical binary partition tree of the minimum spanning tree weighted by the persistence
+            auto sorted_mst_edges = sorting_internal::stable_arg_sort_buffers(
+                    m_persistence, m_sorted_mst_edges.data(), m_sorted_mst_edges_tmp.data(), std::less<double>());
+            {
+                workspace_union_find uf(num_v);
+                workspace_array_1d<index_t> roots = xt::arange<index_t>(num_v);
+                std::iota(m_parents.begin(), m_parents.end(), 0);
+                for (index_t i = 0; i < num_v - 1; i++) {
+                    auto ei = sorted_mst_edges[i];
+                    auto graph_edge = m_bpt_mst_edge_map(ei);
+                    auto c1 = uf.find(m_sources(graph_edge));
+                    auto c2 = uf.find(m_targets(graph_edge));
+                    const index_t n = num_v + i;
+                    m_parents(roots(c1)) = n;
+                    m_parents(roots(c2)) = n;
+                    roots(uf.link(c1, c2)) = n;
+                    m_altitudes(n) = m_persistence(ei);
+                    m_mst_edge_map(i) = graph_edge;
+                }
+            }
+        }
+
+        /**
+         * Parents of the nodes of the binary hierarchy computed by the last call to compute.
+         */
+        const array_1d<index_t> &parents() const {
+            return m_parents;
+        }
+
+        /**
+         * Altitudes of the nodes of the binary hierarchy computed by the last call to compute.
+         */
+        const array_1d<double> &altitudes() const {
+            return m_altitudes;
+        }
+
+        /**
+         * Edges of the graph associated to the internal nodes of the binary hierarchy computed by the last call to
+         * compute: the i-th internal node of the hierarchy (node num_vertices(graph) + i) corresponds to the graph edge
+         * mst_edge_map()(i).
+         */
+        const array_1d<index_t> &mst_edge_map() const {
+            return m_mst_edge_map;
+        }
+
+    private:
+        workspace m_workspace;
+        index_t m_num_vertices;
+        array_1d<index_t> m_sources;
+        array_1d<index_t> m_targets;
+        array_1d<double> m_vertex_area;
+
+        array_1d<index_t> m_sorted_edges;
+        array_1d<index_t> m_sorted_edges_tmp;
+        array_1d<index_t> m_bpt_parents;
+        array_1d<index_t> m_bpt_mst_edge_map;
+        array_1d<double> m_area;
+        array_1d<double> m_children_max;
+        array_1d<double> m_persistence;
+        array_1d<index_t> m_sorted_mst_edges;
+        array_1d<index_t> m_sorted_mst_edges_tmp;
+
+        array_1d<index_t> m_parents;
+        array_1d<double> m_altitudes;
+        array_1d<index_t> m_mst_edge_map;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "graph_image.hpp"
+#include "../algo/graph_weights.hpp"
+#include "../hierarchy/hierarchy_core.hpp"
+#include <future>
+
+namespace hg {
+
+    /**
+     * Canonical binary partition tree of the 4 adjacency graph of an image, whose edges are weighted from the pixel
+     * values with the given weighting function (typically a boundary probability map with weight_functions::mean).
+     *
+     * The result is identical to
+     *
+     *     auto graph = get_4_adjacency_graph(embedding);
+     *     bpt_canonical(graph, weight_graph(graph, vertex_weights, weight));
+     *
+     * but no explicit graph is created: edges are weighted on the implicit 4 adjacency grid graph (see
+     * get_4_adjacency_grid_graph) with the vectorized kernels of weight_graph, and the minimum spanning tree is
+     * computed with the parallel filter-Kruskal/Borůvka algorithm of bpt_canonical_filter_boruvka, which avoids the
+     * sort of all the edges. Edges are indexed as in get_4_adjacency_graph.
+     *
+     * @tparam T
+     * @param ximage 2d array of shape (height, width) or 3d array of shape (height, width, channels)
+     * @param weight weighting function
+     * @return a node_weighted_tree_and_mst (the leaves of the tree are the pixels in raster scan order)
+     */
+    template<typename T>
+    auto bpt_canonical_4_adjacency(const xt::xexpression<T> &ximage, weight_functions weight) {
+        HG_TRACE();
+        auto &image = ximage.derived_cast();
+        hg_assert(image.dimension() == 2 || image.dimension() == 3, "Image must be a 2d or a 3d array.");
+        const index_t height = image.shape()[0];
+        const index_t width = image.shape()[1];
+        hg_assert(height > 0 && width > 0, "Image must not be empty.");
+
+        auto graph = get_4_adjacency_grid_graph(embedding_grid_2d{height, width});
+        array_1d<double> edge_weights;
+        if (image.dimension() == 2) {
+            edge_weights = weight_graph(graph, xt::reshape_view(image, {height * width}), weight);
+        } else {
+            edge_weights = weight_graph(graph, xt::reshape_view(image, {height * width, (index_t) image.shape()[2]}),
+                                        weight);
+        }
+        return bpt_canonical_filter_boruvka(graph, edge_weights);
+    }
+
+    /**
+     * Asynchronous version of bpt_canonical_4_adjacency: the computation is launched in a new thread and the result
+     * is obtained with the get method of the returned future.
+     *
+     * The image is moved (or copied) into the task, the caller does not have to keep it alive.
+     *
+     * @tparam value_t
+     * @param image 2d array of shape (height, width) or 3d array of shape (height, width, channels)
+     * @param weight weighting function
+     * @return a std::future of node_weighted_tree_and_mst
+     */
+    template<typename value_t>
+    auto bpt_canonical_4_adjacency_async(array_nd<value_t> image, weight_functions weight) {
+        return std::async(std::launch::async, [image = std::move(image), weight]() {
+            return bpt_canonical_4_adjacency(image, weight);
+        });
+    }
+}
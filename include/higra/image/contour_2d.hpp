@@ -22,28 +22,31 @@ namespace hg {
     namespace contour_2d_internal {
         // forward declaration
         template<typename point_type>
-        class polyline_contour_2d;
+        class contour_2d;
 
         template<typename point_type>
         class contour_segment_2d_iterator;
 
+        /**
+         * A contour segment is a view on a range of consecutive elements of a contour_2d.
+         */
         template<typename point_type=point_2d_f>
         class contour_segment_2d {
-            const polyline_contour_2d<point_type> &m_polyline;
-            const index_t m_first_control_point;
-            const index_t m_second_control_point;
-            const index_t m_size;
+            const contour_2d<point_type> *m_contour;
+            index_t m_first_element;
+            index_t m_last_element;
+            index_t m_size;
 
         public:
             using value_type = std::pair<index_t, point_2d_f>;
 
-            contour_segment_2d(const polyline_contour_2d<point_type> &polyline,
-                               index_t first_control_point,
-                               index_t second_control_point) :
-                    m_polyline(polyline),
-                    m_first_control_point(first_control_point),
-                    m_second_control_point(second_control_point),
-                    m_size(m_second_control_point - m_first_control_point + 1) {
+            contour_segment_2d(const contour_2d<point_type> &contour,
+                               index_t first_element,
+                               index_t last_element) :
+                    m_contour(&contour),
+                    m_first_element(first_element),
+                    m_last_element(last_element),
+                    m_size(m_last_element - m_first_element + 1) {
             }
 
 
@@ -56,8 +59,8 @@ namespace hg {
             }
 
             decltype(auto) operator[](index_t i) const {
-                return std::make_pair(m_polyline.m_contour_elements[i + m_first_control_point],
-                                      m_polyline.m_contour_points[i + m_first_control_point]);
+                return std::make_pair(m_contour->contour_elements()[i + m_first_element],
+                                      m_contour->contour_points()[i + m_first_element]);
             }
 
             /**
@@ -85,14 +88,14 @@ namespace hg {
             }
 
             auto norm() const {
-                auto v = first().second;
-                auto w = last().second;
+                const auto &v = m_contour->contour_points()[m_first_element];
+                const auto &w = m_contour->contour_points()[m_last_element];
                 return std::sqrt((v[0] - w[0]) * (v[0] - w[0]) + (v[1] - w[1]) * (v[1] - w[1]));
             };
 
-            auto distance_to_point(const point_type &p) {
-                auto v = first().second;
-                auto w = last().second;
+            auto distance_to_point(const point_type &p) const {
+                const auto &v = m_contour->contour_points()[m_first_element];
+                const auto &w = m_contour->contour_points()[m_last_element];
                 auto l2 = std::sqrt((v[0] - w[0]) * (v[0] - w[0]) + (v[1] - w[1]) * (v[1] - w[1]));
                 if (l2 == 0.0)
                     return std::sqrt((v[0] - p[0]) * (v[0] - p[0]) + (v[1] - p[1]) * (v[1] - p[1]));;   // v == w case
@@ -100,8 +103,8 @@ namespace hg {
             };
 
             auto angle() const {
-                auto v = first().second;
-                auto w = last().second;
+                const auto &v = m_contour->contour_points()[m_first_element];
+                const auto &w = m_contour->contour_points()[m_last_element];
                 return std::atan2(v[0] - w[0], v[1] - w[1]);
             }
 
@@ -131,7 +134,7 @@ namespace hg {
             }
 
         private:
-            const contour_segment_2d<point_type> &m_segment;
+            contour_segment_2d<point_type> m_segment;
             index_t m_position;
 
         };
@@ -143,39 +146,41 @@ namespace hg {
 
         /**
          * A polyline contour is a set of contour segments that represent a connected frontier between two regions.
+         *
+         * A polyline contour is a view on a polyline of a contour_2d.
          */
         template<typename point_type=point_2d_f>
         class polyline_contour_2d {
-            std::vector<index_t> m_contour_elements;
-            std::vector<point_type> m_contour_points;
-            std::vector<index_t> m_control_points;
-
-            friend class contour_segment_2d<point_type>;
+            contour_2d<point_type> *m_contour;
+            index_t m_index;
 
         public:
             using value_type = contour_segment_2d<point_type>;
 
-            polyline_contour_2d() {
-
+            polyline_contour_2d(contour_2d<point_type> &contour, index_t index) :
+                    m_contour(&contour),
+                    m_index(index) {
             }
 
+            /**
+             * Add an element at the end of the polyline: the polyline must be the last polyline of its contour.
+             *
+             * @param element
+             * @param coordinates
+             */
             void add_contour_element(index_t element, point_type coordinates) {
-                m_contour_elements.push_back(element);
-                m_contour_points.push_back(coordinates);
-                if (m_contour_points.size() == 1) {
-                    m_control_points.push_back(0);
-                    m_control_points.push_back(0);
-                } else {
-                    m_control_points.back() = m_contour_points.size() - 1;
-                }
+                hg_assert(m_index == (index_t) m_contour->size() - 1,
+                          "Elements can only be added to the last polyline of a contour.");
+                m_contour->add_contour_element(element, coordinates);
             }
 
             auto operator[](index_t i) const {
-                return contour_segment_2d<point_type>(*this, m_control_points[i], m_control_points[i + 1]);
+                const index_t *control_points = m_contour->polyline_control_points(m_index);
+                return contour_segment_2d<point_type>(*m_contour, control_points[i], control_points[i + 1]);
             }
 
             auto size() const {
-                return m_control_points.size() - 1;
+                return (size_t) std::max<index_t>(m_contour->num_polyline_control_points(m_index) - 1, 0);
             }
 
             const auto begin() const {
@@ -187,7 +192,8 @@ namespace hg {
             }
 
             auto number_of_contour_elements() const {
-                return m_contour_elements.size();
+                return m_contour->polyline_element_offsets()[m_index + 1] -
+                       m_contour->polyline_element_offsets()[m_index];
             }
 
             /**
@@ -206,20 +212,139 @@ namespace hg {
             void subdivide(double epsilon = 0.1,
                            bool relative_epsilon = true,
                            int min_size = 2) {
+                std::vector<char> is_subdivision_element(number_of_contour_elements());
+                m_contour->subdivide_polyline(m_index, epsilon, relative_epsilon, min_size,
+                                              is_subdivision_element.data());
+            }
+        };
 
-                // stack elements are the portions of the segment that have to be checked for subdivision
-                stackv<std::pair<index_t, index_t>> stack;
+        template<typename point_type=point_2d_f>
+        class polyline_contour_2d_iterator :
+                public forward_iterator_facade<polyline_contour_2d_iterator<point_type>,
+                        typename polyline_contour_2d<point_type>::value_type,
+                        typename polyline_contour_2d<point_type>::value_type> {
+        public:
+
+            polyline_contour_2d_iterator(const polyline_contour_2d<point_type> &polyline, index_t position = 0) :
+                    m_polyline(polyline),
+                    m_position(position) {}
+
+            void increment() {
+                m_position++;
+            }
+
+            bool equal(polyline_contour_2d_iterator<point_type> const &other) const {
+                return this->m_position == other.m_position;
+            }
+
+            decltype(auto) dereference() const {
+                return m_polyline[m_position];
+            }
+
+        private:
+            polyline_contour_2d<point_type> m_polyline;
+            index_t m_position;
+
+        };
+
+        template<typename point_type=point_2d_f>
+        class contour_2d_iterator :
+                public forward_iterator_facade<contour_2d_iterator<point_type>,
+                        polyline_contour_2d<point_type>,
+                        polyline_contour_2d<point_type>> {
+        public:
+
+            contour_2d_iterator(contour_2d<point_type> &contour, index_t position = 0) :
+                    m_contour(&contour),
+                    m_position(position) {}
+
+            void increment() {
+                m_position++;
+            }
+
+            bool equal(contour_2d_iterator<point_type> const &other) const {
+                return this->m_position == other.m_position;
+            }
+
+            decltype(auto) dereference() const {
+                return polyline_contour_2d<point_type>(*m_contour, m_position);
+            }
+
+        private:
+            contour_2d<point_type> *m_contour;
+            index_t m_position;
+
+        };
+
+        /**
+         * A contour is a set of polyline contours that represent the frontiers separating regions.
+         *
+         * The contour is stored in flat arrays:
+         *
+         *  - the edge indices and the coordinates of the elements of all the polylines, polyline after polyline:
+         *    the elements of the i-th polyline are in the range [polyline_element_offsets()[i],
+         *    polyline_element_offsets()[i + 1])
+         *  - the control points of the polylines (indices of the elements that delimit the segments of the
+         *    polylines): as the control points of a polyline are a subset of its elements, each polyline has a fixed
+         *    range of the control point array whose size is its number of elements plus one
+         *
+         * Polylines and contour segments are lightweight views on this storage.
+         */
+        template<typename point_type=point_2d_f>
+        class contour_2d {
+            std::vector<index_t> m_contour_elements;
+            std::vector<point_type> m_contour_points;
+            std::vector<index_t> m_polyline_element_offsets{0};
+            std::vector<index_t> m_control_points;
+            std::vector<index_t> m_num_control_points;
+
+            friend class polyline_contour_2d<point_type>;
+
+            // adds an element at the end of the last polyline
+            void add_contour_element(index_t element, point_type coordinates) {
+                m_contour_elements.push_back(element);
+                m_contour_points.push_back(coordinates);
+                m_control_points.push_back(invalid_index);
+                index_t polyline = (index_t) m_num_control_points.size() - 1;
+                index_t first_element = m_polyline_element_offsets[polyline];
+                index_t last_element = m_polyline_element_offsets[polyline + 1]++;
+                auto control_points = &m_control_points[first_element + polyline];
+                control_points[0] = first_element;
+                control_points[1] = last_element;
+                m_num_control_points[polyline] = 2;
+            }
+
+            /*
+             * Subdivide the given polyline, is_subdivision_element must point to a buffer with one value for
+             * each element of the polyline. Polylines are independent: different polylines can be subdivided
+             * concurrently.
+             */
+            void subdivide_polyline(index_t polyline,
+                                    double epsilon,
+                                    bool relative_epsilon,
+                                    int min_size,
+                                    char *is_subdivision_element) {
+                const index_t first_polyline_element = m_polyline_element_offsets[polyline];
+                const index_t num_polyline_elements = m_polyline_element_offsets[polyline + 1] - first_polyline_element;
+                const index_t num_control_points = m_num_control_points[polyline];
+                index_t *control_points = &m_control_points[first_polyline_element + polyline];
+
+                if (num_control_points < 2) {
+                    return;
+                }
 
                 // if i-th element true the polyline has to be subdivided at this element
-                std::vector<bool> is_subdivision_element(m_contour_elements.size(), false);
+                std::fill(is_subdivision_element, is_subdivision_element + num_polyline_elements, false);
 
-                for (index_t segment_index = 0; segment_index < (index_t) size(); segment_index++) {
-                    stack.push({m_control_points[segment_index], m_control_points[segment_index + 1]});
+                // stack elements are the portions of the segment that have to be checked for subdivision
+                stackv<std::pair<index_t, index_t>> stack;
 
-                    // current segment points are preserved
-                    is_subdivision_element[m_control_points[segment_index]] = true;
-                    is_subdivision_element[m_control_points[segment_index + 1]] = true;
+                for (index_t segment_index = 0; segment_index < num_control_points - 1; segment_index++) {
+                    stack.push({control_points[segment_index], control_points[segment_index + 1]});
 
+                    // current segment points are preserved
+                    is_subdivision_element[control_points[segment_index] - first_polyline_element] = true;
+                    is_subdivision_element[control_points[segment_index + 1] - first_polyline_element] = true;
 
                     // recursive identification of subdivision elements
                     while (!stack.empty()) {
@@ -247,8 +372,7 @@ namespace hg {
                         auto max_distance_element = invalid_index;
 
                         for (index_t i = first_element + 1; i < last_element; i++) {
-                            auto &coordinate_element = m_contour_points[i];
-                            auto d = segment.distance_to_point(coordinate_element);
+                            auto d = segment.distance_to_point(m_contour_points[i]);
                             if (d >= max_distance && d > min_size) {
                                 max_distance = d;
                                 max_distance_element = i;
@@ -256,92 +380,99 @@ namespace hg {
                         }
 
                         if (max_distance_element != invalid_index) {
-                            is_subdivision_element[max_distance_element] = true;
+                            is_subdivision_element[max_distance_element - first_polyline_element] = true;
                             stack.push({first_element, max_distance_element});
                             stack.push({max_distance_element, last_element});
                         }
                     }
+                }
 
-                    // final subdivision
-                    m_control_points.clear();
-
-                    for (index_t i = 0; i < (index_t) m_contour_elements.size(); i++) {
-                        if (is_subdivision_element[i]) {
-                            m_control_points.push_back(i);
-                        }
+                // final subdivision: the new control points are a superset of the old ones
+                index_t num_new_control_points = 0;
+                for (index_t i = 0; i < num_polyline_elements; i++) {
+                    if (is_subdivision_element[i]) {
+                        control_points[num_new_control_points++] = first_polyline_element + i;
                     }
-                    if (m_control_points.size() == 1)
-                        m_control_points.push_back(0);
                 }
-
+                if (num_new_control_points == 1)
+                    control_points[num_new_control_points++] = first_polyline_element;
+                m_num_control_points[polyline] = num_new_control_points;
             }
-        };
 
-        template<typename point_type=point_2d_f>
-        class polyline_contour_2d_iterator :
-                public forward_iterator_facade<polyline_contour_2d_iterator<point_type>,
-                        typename polyline_contour_2d<point_type>::value_type,
-                        typename polyline_contour_2d<point_type>::value_type> {
         public:
 
-            polyline_contour_2d_iterator(const polyline_contour_2d<point_type> &polyline, index_t position = 0) :
-                    m_polyline(polyline),
-                    m_position(position) {}
-
-            void increment() {
-                m_position++;
+            /**
+             * Start a new polyline at the end of the contour
+             * @return a view on the new polyline
+             */
+            auto new_polyline_contour_2d() {
+                m_polyline_element_offsets.push_back(m_polyline_element_offsets.back());
+                m_num_control_points.push_back(0);
+                m_control_points.push_back(invalid_index);
+                return polyline_contour_2d<point_type>(*this, (index_t) m_num_control_points.size() - 1);
             }
 
-            bool equal(polyline_contour_2d_iterator<point_type> const &other) const {
-                return this->m_position == other.m_position;
+            auto size() const {
+                return m_num_control_points.size();
             }
 
-            decltype(auto) dereference() const {
-                return m_polyline[m_position];
+            auto begin() {
+                return contour_2d_iterator<point_type>(*this, 0);
             }
 
-        private:
-            const polyline_contour_2d<point_type> &m_polyline;
-            index_t m_position;
-
-        };
-
+            auto end() {
+                return contour_2d_iterator<point_type>(*this, size());
+            }
 
-        /**
-         * A contour is a set of polyline contours that represent the frontiers separating regions.
-         */
-        template<typename point_type=point_2d_f>
-        class contour_2d {
-            std::vector<polyline_contour_2d<point_type>> m_polyline_contours;
+            // polyline views are mutable (see polyline_contour_2d::subdivide) but do not modify the contour otherwise
+            const auto begin() const {
+                return contour_2d_iterator<point_type>(const_cast<contour_2d<point_type> &>(*this), 0);
+            }
 
-        public:
-            auto &new_polyline_contour_2d() {
-                m_polyline_contours.emplace_back();
-                return m_polyline_contours[m_polyline_contours.size() - 1];
+            const auto end() const {
+                return contour_2d_iterator<point_type>(const_cast<contour_2d<point_type> &>(*this), size());
             }
 
-            auto size() {
-                return m_polyline_contours.size();
+            auto operator[](index_t i) {
+                return polyline_contour_2d<point_type>(*this, i);
             }
 
-            auto begin() {
-                return m_polyline_contours.begin();
+            /**
+             * Edge indices of the elements of the contour (polyline after polyline)
+             */
+            const auto &contour_elements() const {
+                return m_contour_elements;
             }
 
-            auto end() {
-                return m_polyline_contours.end();
+            /**
+             * Coordinates of the elements of the contour (polyline after polyline)
+             */
+            const auto &contour_points() const {
+                return m_contour_points;
             }
 
-            const auto begin() const {
-                return m_polyline_contours.begin();
+            /**
+             * The elements of the i-th polyline are in the range
+             * [polyline_element_offsets()[i], polyline_element_offsets()[i + 1])
+             */
+            const auto &polyline_element_offsets() const {
+                return m_polyline_element_offsets;
             }
 
-            const auto end() const {
-                return m_polyline_contours.end();
+            /**
+             * Control points of the i-th polyline: indices (in contour_elements()) of the extremities of its segments.
+             * The j-th segment of the polyline goes from polyline_control_points(i)[j] to
+             * polyline_control_points(i)[j + 1].
+             */
+            const index_t *polyline_control_points(index_t i) const {
+                return &m_control_points[m_polyline_element_offsets[i] + i];
             }
 
-            auto operator[](index_t i) {
-                return m_polyline_contours[i];
+            /**
+             * Number of control points of the i-th polyline (its number of segments plus one)
+             */
+            index_t num_polyline_control_points(index_t i) const {
+                return m_num_control_points[i];
             }
 
             /**
@@ -353,7 +484,8 @@ namespace hg {
              *  - epsilon if relative_epsilon is false
              *  - epsilon times the distance between the segment extremities if relative_epsilon is true
              *
-             * Implementation note: simply call subdivide on each polyline of the contour.
+             * Implementation note: the polylines are subdivided in parallel, each polyline only modifies its own range
+             * of the control point array.
              *
              * @param epsilon
              * @param relative_epsilon
@@ -363,9 +495,12 @@ namespace hg {
                     double epsilon = 0.1,
                     bool relative_epsilon = true,
                     int min_size = 2) {
-                for (auto &polyline: m_polyline_contours) {
-                    polyline.subdivide(epsilon, relative_epsilon, min_size);
-                }
+                std::vector<char> is_subdivision_element(m_contour_elements.size());
+                parfor(0, (index_t) size(),
+                       [this, epsilon, relative_epsilon, min_size, &is_subdivision_element](index_t i) {
+                           subdivide_polyline(i, epsilon, relative_epsilon, min_size,
+                                              is_subdivision_element.data() + m_polyline_element_offsets[i]);
+                       });
             };
 
         };
@@ -531,26 +666,26 @@ namespace hg {
                     if (is_intersection(y, x)) { // explore each polyline starting from this point
                         if (x != 0 && contours_khalimsky(y, x - 1) != invalid_index && !processed(y, x - 1)) {
                             explore_contour_part(y, x - 1, EAST);
-                            auto &polyline = result.new_polyline_contour_2d();
+                            auto polyline = result.new_polyline_contour_2d();
                             add_contour_parts_to_polyline(polyline);
                         }
                         if (x != width - 1 && contours_khalimsky(y, x + 1) != invalid_index && !processed(y, x + 1)) {
                             explore_contour_part(y, x + 1, WEST);
-                            auto &polyline = result.new_polyline_contour_2d();
+                            auto polyline = result.new_polyline_contour_2d();
                             add_contour_parts_to_polyline(polyline);
                         }
                         if (y != 0 && contours_khalimsky(y - 1, x) != invalid_index && !processed(y - 1, x)) {
                             explore_contour_part(y - 1, x, SOUTH);
-                            auto &polyline = result.new_polyline_contour_2d();
+                            auto polyline = result.new_polyline_contour_2d();
                             add_contour_parts_to_polyline(polyline);
                         }
                         if (y != height - 1 && contours_khalimsky(y + 1, x) != invalid_index && !processed(y + 1, x)) {
                             explore_contour_part(y + 1, x, NORTH);
-                            auto &polyline = result.new_polyline_contour_2d();
+                            auto polyline = result.new_polyline_contour_2d();
                             add_contour_parts_to_polyline(polyline);
                         }
                     } else { // explore the two ends of the polyline passing by this point and join them
-                        auto &polyline = result.new_polyline_contour_2d();
+                        auto polyline = result.new_polyline_contour_2d();
                         bool first = true;
                         if (x != 0 && contours_khalimsky(y, x - 1) != invalid_index && !processed(y, x - 1)) {
                             explore_contour_part(y, x - 1, EAST);
@@ -645,11 +780,16 @@ namespace hg {
         array_1d<double> vertex_perimeter = xt::zeros<double>({num_vertices(rag_graph)});
         array_1d<double> edge_length = xt::zeros<double>({num_edges(rag_graph)});
 
-        for (auto &polyline: contour2d) {
-
-            for (auto &segment: polyline) {
-                auto segment_length = segment.norm() + 1;
-                auto rag_edge_index = edge_map(segment.first().first);
+        const auto &contour_elements = contour2d.contour_elements();
+        const auto &contour_points = contour2d.contour_points();
+        for (index_t i = 0; i < (index_t) contour2d.size(); i++) {
+            const index_t *control_points = contour2d.polyline_control_points(i);
+            const index_t num_control_points = contour2d.num_polyline_control_points(i);
+            for (index_t j = 0; j < num_control_points - 1; j++) {
+                const auto &v = contour_points[control_points[j]];
+                const auto &w = contour_points[control_points[j + 1]];
+                auto segment_length = std::sqrt((v[0] - w[0]) * (v[0] - w[0]) + (v[1] - w[1]) * (v[1] - w[1])) + 1;
+                auto rag_edge_index = edge_map(contour_elements[control_points[j]]);
                 auto rag_edge = edge_from_index(rag_edge_index, rag_graph);
                 edge_length(rag_edge_index) += segment_length;
                 vertex_perimeter(source(rag_edge, rag_graph)) += segment_length;
@@ -0,0 +1,300 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "tiled_mst.hpp"
+#include <array>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace hg {
+
+    /**
+     * Partial minimum spanning tree of the 4 adjacency graph of an image, restricted to the edges owned by a set of
+     * disjoint rectangular regions of the image (see make_region_mst and merge_region_mst).
+     *
+     * An edge is owned by a region if its source, that is its top or left extremity, belongs to the region. The
+     * partial minimum spanning tree only stores the reduced graph of the owned edges: the edges that may still be
+     * modified by the edges owned by other regions. Its size is proportional to the perimeter of the regions.
+     */
+    struct region_mst {
+        /**
+         * Shape of the whole image
+         */
+        embedding_grid_2d embedding;
+
+        /**
+         * Owned regions: (y, x, height, width) of each rectangle
+         */
+        std::vector<std::array<index_t, 4>> regions;
+
+        /**
+         * Edges of the reduced graph
+         */
+        std::vector<tiled_mst_internal::reduced_edge> edges;
+
+        /**
+         * True if the pixel of coordinates (y, x) belongs to an owned region
+         */
+        bool owns(index_t y, index_t x) const {
+            for (const auto &r: regions) {
+                if (y >= r[0] && y < r[0] + r[2] && x >= r[1] && x < r[1] + r[3]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * True if the owned regions cover the whole image: the reduced graph is then empty and all the edges of the
+         * minimum spanning tree have been reported.
+         */
+        bool complete() const {
+            index_t area = 0;
+            for (const auto &r: regions) {
+                area += r[2] * r[3];
+            }
+            return area == (index_t) embedding.size();
+        }
+    };
+
+    namespace distributed_mst_internal {
+
+        /**
+         * Reduces the given edges with respect to the regions of the partial minimum spanning tree mst: the key
+         * vertices are the vertices incident to an edge that is not owned by the regions of mst.
+         */
+        template<typename edge_output_t>
+        void reduce_region_mst(region_mst &mst,
+                               std::vector<tiled_mst_internal::tiled_edge> &edges,
+                               std::vector<index_t> &local_to_global,
+                               edge_output_t &edge_output) {
+            const index_t height = mst.embedding.shape()[0];
+            const index_t width = mst.embedding.shape()[1];
+            auto is_key = [&mst, &local_to_global, height, width](index_t local) {
+                index_t global = local_to_global[local];
+                index_t y = global / width;
+                index_t x = global % width;
+                return (!mst.owns(y, x) && (x + 1 < width || y + 1 < height)) ||
+                       (x > 0 && !mst.owns(y, x - 1)) ||
+                       (y > 0 && !mst.owns(y - 1, x));
+            };
+            auto global_index = [&local_to_global](index_t local) {
+                return local_to_global[local];
+            };
+            tiled_mst_internal::reduce_spanning_forest(edges, local_to_global.size(), is_key, global_index,
+                                                       edge_output, mst.edges);
+        }
+
+        template<typename T>
+        void write_scalar(std::ostream &out, T value) {
+            uint64_t v = (uint64_t) value;
+            out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        inline uint64_t read_scalar(std::istream &in) {
+            uint64_t v;
+            in.read(reinterpret_cast<char *>(&v), sizeof(v));
+            hg_assert(in.gcount() == (std::streamsize) sizeof(v), "Unexpected end of region mst data.");
+            return v;
+        }
+
+        static const char region_mst_magic[8] = {'H', 'G', 'R', 'G', 'M', 'S', 'T', '1'};
+    }
+
+    /**
+     * Partial minimum spanning tree of the rectangular region of origin (y, x) and of shape (height, width) of the
+     * 4 adjacency graph of an image of shape embedding.
+     *
+     * The region values array contains the values of the pixels of the region extended by a one pixel halo on its
+     * bottom side and on its right side, if those exist in the image: its shape is
+     * (height + (y + height < image height), width + (x + width < image width), channels...). The weights of the edges
+     * owned by the region (whose top or left extremity is in the region) are computed with the given weighting
+     * function (see weight_graph).
+     *
+     * The minimum spanning tree edges found are reported with the function edge_output(edge_index, edge_weight),
+     * where edge_index is the index of the edge in the 4 adjacency graph of the whole image (see
+     * tiled_minimum_spanning_tree). The result contains the reduced graph of the region: partial minimum spanning
+     * trees of disjoint regions can then be combined with merge_region_mst, for example on different processes after
+     * being serialized with save_region_mst and read_region_mst.
+     *
+     * @tparam T
+     * @tparam edge_output_t function (index_t, double) -> void
+     * @param embedding shape of the whole image
+     * @param y first row of the region
+     * @param x first column of the region
+     * @param height number of rows of the region
+     * @param width number of columns of the region
+     * @param xregion_values pixel values of the region and of its bottom and right halo
+     * @param edge_output minimum spanning tree edges consumer
+     * @param weight edge weighting function (default weight_functions::L1)
+     * @return a region_mst
+     */
+    template<typename T, typename edge_output_t>
+    region_mst make_region_mst(const embedding_grid_2d &embedding,
+                               index_t y,
+                               index_t x,
+                               index_t height,
+                               index_t width,
+                               const xt::xexpression<T> &xregion_values,
+                               edge_output_t &&edge_output,
+                               weight_functions weight = weight_functions::L1) {
+        HG_TRACE();
+        using namespace tiled_mst_internal;
+        const index_t image_height = embedding.shape()[0];
+        const index_t image_width = embedding.shape()[1];
+        hg_assert(y >= 0 && x >= 0 && height > 0 && width > 0 &&
+                  y + height <= image_height && x + width <= image_width,
+                  "The region must be a non empty rectangle inside the image.");
+        const index_t block_height = height + (y + height < image_height);
+        const index_t block_width = width + (x + width < image_width);
+        const index_t num_block_pixels = block_height * block_width;
+
+        array_nd<typename T::value_type> block_values = xregion_values.derived_cast();
+        hg_assert(block_values.dimension() >= 2 &&
+                  (index_t) block_values.shape()[0] == block_height &&
+                  (index_t) block_values.shape()[1] == block_width,
+                  "The shape of the region values does not match the region and its halo.");
+        const index_t channels = block_values.size() / num_block_pixels;
+        if (channels == 1) {
+            block_values.reshape({(size_t) num_block_pixels});
+        } else {
+            block_values.reshape({(size_t) num_block_pixels, (size_t) channels});
+        }
+
+        region_mst result{embedding, {{y, x, height, width}}, {}};
+        const grid_4_adjacency_graph_2d image_graph(embedding);
+        auto block_graph = get_4_adjacency_grid_graph(embedding_grid_2d{block_height, block_width});
+        auto block_weights = weight_graph(block_graph, block_values, weight);
+
+        // local indices are the indices of the pixels in the extended block
+        std::vector<index_t> local_to_global(num_block_pixels);
+        for (index_t i = 0; i < num_block_pixels; i++) {
+            local_to_global[i] = (y + i / block_width) * image_width + x + i % block_width;
+        }
+        std::vector<tiled_edge> edges;
+        for (index_t ei = 0; ei < (index_t) num_edges(block_graph); ei++) {
+            index_t s = block_graph.source(ei);
+            if (s / block_width < height && s % block_width < width) {
+                index_t t = block_graph.target(ei);
+                index_t gs = local_to_global[s];
+                index_t index = (t == s + 1) ? image_graph.right_edge(gs) : image_graph.bottom_edge(gs);
+                edges.push_back({block_weights(ei), index, s, t});
+            }
+        }
+        distributed_mst_internal::reduce_region_mst(result, edges, local_to_global, edge_output);
+        return result;
+    }
+
+    /**
+     * Merges the partial minimum spanning tree other into the partial minimum spanning tree mst: the regions of mst
+     * and other must be disjoint regions of the same image.
+     *
+     * The minimum spanning tree edges found are reported with the function edge_output(edge_index, edge_weight).
+     * When the merged regions cover the whole image, all the remaining edges of the minimum spanning tree are
+     * reported and the reduced graph of mst is empty.
+     *
+     * @tparam edge_output_t function (index_t, double) -> void
+     * @param mst partial minimum spanning tree (modified)
+     * @param other partial minimum spanning tree
+     * @param edge_output minimum spanning tree edges consumer
+     */
+    template<typename edge_output_t>
+    void merge_region_mst(region_mst &mst, const region_mst &other, edge_output_t &&edge_output) {
+        HG_TRACE();
+        using namespace tiled_mst_internal;
+        hg_assert(mst.embedding.shape() == other.embedding.shape(),
+                  "Partial minimum spanning trees must be defined on the same image.");
+        mst.regions.insert(mst.regions.end(), other.regions.begin(), other.regions.end());
+
+        std::vector<index_t> local_to_global;
+        std::unordered_map<index_t, index_t> global_to_local;
+        auto local_index = [&local_to_global, &global_to_local](index_t global) {
+            auto it = global_to_local.find(global);
+            if (it != global_to_local.end()) {
+                return it->second;
+            }
+            index_t local = local_to_global.size();
+            global_to_local.emplace(global, local);
+            local_to_global.push_back(global);
+            return local;
+        };
+
+        std::vector<tiled_edge> edges;
+        edges.reserve(mst.edges.size() + other.edges.size());
+        for (const auto &e: mst.edges) {
+            edges.push_back({e.weight, e.index, local_index(e.source), local_index(e.target)});
+        }
+        for (const auto &e: other.edges) {
+            edges.push_back({e.weight, e.index, local_index(e.source), local_index(e.target)});
+        }
+        distributed_mst_internal::reduce_region_mst(mst, edges, local_to_global, edge_output);
+    }
+
+    /**
+     * Writes the partial minimum spanning tree in a binary stream (see read_region_mst).
+     *
+     * @param out output stream
+     * @param mst partial minimum spanning tree
+     */
+    inline void save_region_mst(std::ostream &out, const region_mst &mst) {
+        using namespace distributed_mst_internal;
+        out.write(region_mst_magic, sizeof(region_mst_magic));
+        write_scalar(out, mst.embedding.shape()[0]);
+        write_scalar(out, mst.embedding.shape()[1]);
+        write_scalar(out, mst.regions.size());
+        for (const auto &r: mst.regions) {
+            for (auto v: r) {
+                write_scalar(out, v);
+            }
+        }
+        write_scalar(out, mst.edges.size());
+        for (const auto &e: mst.edges) {
+            out.write(reinterpret_cast<const char *>(&e.weight), sizeof(e.weight));
+            write_scalar(out, e.index);
+            write_scalar(out, e.source);
+            write_scalar(out, e.target);
+        }
+    }
+
+    /**
+     * Reads a partial minimum spanning tree written with save_region_mst.
+     *
+     * @param in input stream
+     * @return a region_mst
+     */
+    inline region_mst read_region_mst(std::istream &in) {
+        using namespace distributed_mst_internal;
+        char magic[sizeof(region_mst_magic)];
+        in.read(magic, sizeof(magic));
+        hg_assert(in.gcount() == (std::streamsize) sizeof(magic) &&
+                  std::memcmp(magic, region_mst_magic, sizeof(magic)) == 0,
+                  "Invalid region mst data.");
+        index_t height = read_scalar(in);
+        index_t width = read_scalar(in);
+        region_mst mst{embedding_grid_2d{height, width}, {}, {}};
+        mst.regions.resize(read_scalar(in));
+        for (auto &r: mst.regions) {
+            for (auto &v: r) {
+                v = read_scalar(in);
+            }
+        }
+        mst.edges.resize(read_scalar(in));
+        for (auto &e: mst.edges) {
+            in.read(reinterpret_cast<char *>(&e.weight), sizeof(e.weight));
+            e.index = read_scalar(in);
+            e.source = read_scalar(in);
+            e.target = read_scalar(in);
+        }
+        return mst;
+    }
+}
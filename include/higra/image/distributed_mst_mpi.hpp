@@ -0,0 +1,113 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+/**
+ * MPI backend of the distributed minimum spanning tree computation (see distributed_mst.hpp).
+ *
+ * This header requires an MPI implementation and is not included by any other higra header.
+ */
+
+#include "distributed_mst.hpp"
+#include <mpi.h>
+#include <climits>
+#include <sstream>
+
+namespace hg {
+
+    /**
+     * Merges the partial minimum spanning trees of all the processes of an MPI communicator.
+     *
+     * The partial minimum spanning trees are merged along a binary reduction tree: at the step s (s = 1, 2, 4...)
+     * the process of rank r such that r % 2s == s sends its partial minimum spanning tree to the process of rank
+     * r - s which merges it with its own. The regions of the processes must be disjoint. As the size of a partial
+     * minimum spanning tree is proportional to the perimeter of its regions, ranks should be assigned to the regions
+     * such that the regions of ranks r and r + s are adjacent (for example, consecutive horizontal strips in rank
+     * order).
+     *
+     * The minimum spanning tree edges are reported with the function edge_output(edge_index, edge_weight) on the
+     * process that finds them: the union of the edges reported on all the processes is the minimum spanning tree of
+     * the union of the regions. Each process can thus write its part of the result independently.
+     *
+     * This is a collective operation.
+     *
+     * @tparam edge_output_t function (index_t, double) -> void
+     * @param mst partial minimum spanning tree of the process
+     * @param comm MPI communicator
+     * @param edge_output minimum spanning tree edges consumer
+     * @return on the process of rank 0, the merged partial minimum spanning tree of all the processes (its reduced
+     * graph is empty if the regions cover the whole image)
+     */
+    template<typename edge_output_t>
+    region_mst mpi_merge_region_mst(region_mst mst, MPI_Comm comm, edge_output_t &&edge_output) {
+        HG_TRACE();
+        int rank;
+        int num_processes;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &num_processes);
+        const int tag = 0;
+
+        for (int step = 1; step < num_processes; step *= 2) {
+            if (rank % (2 * step) == step) {
+                std::ostringstream out;
+                save_region_mst(out, mst);
+                const std::string buffer = out.str();
+                hg_assert(buffer.size() <= (size_t) INT_MAX, "Partial minimum spanning tree too large.");
+                uint64_t size = buffer.size();
+                MPI_Send(&size, 1, MPI_UINT64_T, rank - step, tag, comm);
+                MPI_Send(buffer.data(), (int) size, MPI_BYTE, rank - step, tag, comm);
+                break;
+            } else if (rank % (2 * step) == 0 && rank + step < num_processes) {
+                uint64_t size;
+                MPI_Recv(&size, 1, MPI_UINT64_T, rank + step, tag, comm, MPI_STATUS_IGNORE);
+                std::string buffer(size, '\0');
+                MPI_Recv(&buffer[0], (int) size, MPI_BYTE, rank + step, tag, comm, MPI_STATUS_IGNORE);
+                std::istringstream in(buffer);
+                merge_region_mst(mst, read_region_mst(in), edge_output);
+            }
+        }
+        return mst;
+    }
+
+    /**
+     * Distributed minimum spanning tree of the 4 adjacency graph of an image: each process of the MPI communicator
+     * computes the partial minimum spanning tree of its region of the image (see make_region_mst) and the partial
+     * minimum spanning trees are then merged with mpi_merge_region_mst.
+     *
+     * This is a collective operation.
+     *
+     * @tparam T
+     * @tparam edge_output_t function (index_t, double) -> void
+     * @param comm MPI communicator
+     * @param embedding shape of the whole image
+     * @param y first row of the region of the process
+     * @param x first column of the region of the process
+     * @param height number of rows of the region of the process
+     * @param width number of columns of the region of the process
+     * @param xregion_values pixel values of the region and of its bottom and right halo (see make_region_mst)
+     * @param edge_output minimum spanning tree edges consumer
+     * @param weight edge weighting function (default weight_functions::L1)
+     * @return see mpi_merge_region_mst
+     */
+    template<typename T, typename edge_output_t>
+    region_mst mpi_minimum_spanning_tree(MPI_Comm comm,
+                                         const embedding_grid_2d &embedding,
+                                         index_t y,
+                                         index_t x,
+                                         index_t height,
+                                         index_t width,
+                                         const xt::xexpression<T> &xregion_values,
+                                         edge_output_t &&edge_output,
+                                         weight_functions weight = weight_functions::L1) {
+        auto mst = make_region_mst(embedding, y, x, height, width, xregion_values, edge_output, weight);
+        return mpi_merge_region_mst(std::move(mst), comm, edge_output);
+    }
+}
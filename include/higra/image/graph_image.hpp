@@ -11,6 +11,7 @@
 #pragma once
 
 #include "../graph.hpp"
+#include "../structure/lca_fast.hpp"
 #include <stack>
 
 namespace hg {
@@ -49,6 +50,20 @@ namespace hg {
         return regular_grid_graph_2d(embedding, std::move(neighbours));
     }
 
+    /**
+     * Create a 4 adjacency implicit graph with implicit edge indices for the given embedding.
+     *
+     * Contrarily to get_4_adjacency_implicit_graph, edges are indexed and the result can be used with any algorithm
+     * working on edge weighted graphs (bpt_canonical, weight_graph, labelisation_watershed...) without materializing
+     * the adjacency: edges are indexed as in the graph returned by get_4_adjacency_graph.
+     * @param embedding
+     * @return
+     */
+    inline
+    auto get_4_adjacency_grid_graph(const embedding_grid_2d &embedding) {
+        return grid_4_adjacency_graph_2d(embedding);
+    }
+
     /**
      * Create of 4 adjacency explicit regular graph for the given embedding
      * @param embedding
@@ -56,7 +71,22 @@ namespace hg {
      */
     inline
     auto get_4_adjacency_graph(const embedding_grid_2d &embedding) {
-        return hg::copy_graph<ugraph>(get_4_adjacency_implicit_graph(embedding));
+        const index_t h = embedding.shape()[0];
+        const index_t w = embedding.shape()[1];
+        ugraph graph(embedding.size(), grid_4_adjacency_graph_2d(embedding).num_edges(), 4);
+        // edges in raster scan order, right edge before bottom edge (see grid_4_adjacency_graph_2d)
+        for (index_t i = 0; i < h; i++) {
+            for (index_t j = 0; j < w; j++) {
+                index_t v = i * w + j;
+                if (j < w - 1) {
+                    add_edge(v, v + 1, graph);
+                }
+                if (i < h - 1) {
+                    add_edge(v, v + w, graph);
+                }
+            }
+        }
+        return graph;
     }
 
     /**
@@ -69,9 +99,216 @@ namespace hg {
         return hg::copy_graph<ugraph>(get_8_adjacency_implicit_graph(embedding));
     }
 
+    /**
+     * Create a 4 adjacency implicit regular graph whose vertices are numbered along the tiled Morton curve of the
+     * given embedding (see embedding_morton_2d)
+     * @param embedding
+     * @return
+     */
+    inline
+    auto get_4_adjacency_implicit_morton_graph(const embedding_morton_2d &embedding) {
+        std::vector<point_2d_i> neighbours{{{-1, 0}},
+                                           {{0,  -1}},
+                                           {{0,  1}},
+                                           {{1,  0}}}; // 4 adjacency
+
+        return regular_morton_graph_2d(embedding, std::move(neighbours));
+    }
+
+    /**
+     * Create a 8 adjacency implicit regular graph whose vertices are numbered along the tiled Morton curve of the
+     * given embedding (see embedding_morton_2d)
+     * @param embedding
+     * @return
+     */
+    inline
+    auto get_8_adjacency_implicit_morton_graph(const embedding_morton_2d &embedding) {
+        std::vector<point_2d_i> neighbours{{{-1, -1}},
+                                           {{-1, 0}},
+                                           {{-1, 1}},
+                                           {{0,  -1}},
+                                           {{0,  1}},
+                                           {{1,  -1}},
+                                           {{1,  0}},
+                                           {{1,  1}}}; // 8 adjacency
+
+        return regular_morton_graph_2d(embedding, std::move(neighbours));
+    }
+
+    /**
+     * Create a 4 adjacency explicit graph whose vertices are numbered along the tiled Morton curve of the given
+     * embedding: the pixel (i, j) is the vertex embedding.grid2lin(i, j).
+     *
+     * The edges are sorted by source vertex in the order of the curve, the right edge of a pixel before its bottom
+     * edge. Vertex weights are obtained from a row major image with to_morton_order, and vertex indexed results are
+     * converted back to a row major image with to_row_major_order. All the algorithms working on explicit graphs can
+     * be used on the result; on large images, they benefit from the locality of the vertical neighbours in the Morton
+     * order.
+     *
+     * @param embedding
+     * @return
+     */
+    inline
+    auto get_4_adjacency_morton_graph(const embedding_morton_2d &embedding) {
+        HG_TRACE();
+        const index_t h = embedding.shape()[0];
+        const index_t w = embedding.shape()[1];
+        const index_t n = embedding.size();
+        ugraph graph(n, (h - 1) * w + h * (w - 1), 4);
+        for (index_t v = 0; v < n; v++) {
+            auto p = embedding.lin2grid(v);
+            if (p(1) < w - 1) {
+                add_edge(v, embedding.grid2lin(p(0), p(1) + 1), graph);
+            }
+            if (p(0) < h - 1) {
+                add_edge(v, embedding.grid2lin(p(0) + 1, p(1)), graph);
+            }
+        }
+        return graph;
+    }
+
+    /**
+     * Create a 8 adjacency explicit graph whose vertices are numbered along the tiled Morton curve of the given
+     * embedding (see get_4_adjacency_morton_graph)
+     * @param embedding
+     * @return
+     */
+    inline
+    auto get_8_adjacency_morton_graph(const embedding_morton_2d &embedding) {
+        return hg::copy_graph<ugraph>(get_8_adjacency_implicit_morton_graph(embedding));
+    }
+
+
+    namespace graph_image_internal {
+
+        /**
+         * True if the edges of the given graph are the edges of the 4 adjacency graph of the embedding indexed as in
+         * get_4_adjacency_graph: the edges of the pixel (i, j) are numbered in raster scan order, its right edge
+         * before its bottom edge. Runs in O(num_edges) for arbitrary graphs.
+         */
+        template<typename graph_t>
+        bool has_4_adjacency_grid_edge_order(const graph_t &graph, const embedding_grid_2d &embedding) {
+            const index_t h = embedding.shape()[0];
+            const index_t w = embedding.shape()[1];
+            if ((index_t) num_edges(graph) != h * (w - 1) + (h - 1) * w) {
+                return false;
+            }
+            auto is_edge = [&graph](index_t ei, index_t s, index_t t) {
+                auto e = edge_from_index(ei, graph);
+                index_t u = source(e, graph);
+                index_t v = target(e, graph);
+                return (u == s && v == t) || (u == t && v == s);
+            };
+            index_t ei = 0;
+            for (index_t i = 0; i < h; i++) {
+                for (index_t j = 0; j < w; j++) {
+                    index_t v = i * w + j;
+                    if (j < w - 1 && !is_edge(ei++, v, v + 1)) {
+                        return false;
+                    }
+                    if (i < h - 1 && !is_edge(ei++, v, v + w)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        inline
+        bool has_4_adjacency_grid_edge_order(const grid_4_adjacency_graph_2d &graph,
+                                             const embedding_grid_2d &embedding) {
+            return graph.embedding().shape() == embedding.shape();
+        }
+
+        /**
+         * Copies the edge weights of the 4 adjacency graph of a grid of shape (h, w) (edges indexed as in
+         * get_4_adjacency_graph) into the 1-faces of the row major Khalimsky grid res of width res_width. The pixel
+         * (i, j) corresponds to the 2-face (2 * i + offset, 2 * j + offset). The rows are processed in parallel.
+         */
+        template<typename value_type, typename result_type>
+        void grid_4_adjacency_edge_weights_2_khalimsky(const value_type *weights, index_t h, index_t w,
+                                                       result_type *res, index_t res_width, index_t offset) {
+            parfor(0, h, [weights, h, w, res, res_width, offset](index_t i) {
+                const value_type *row = weights + i * (2 * w - 1);
+                result_type *horizontal = res + (2 * i + offset) * res_width + offset;
+                if (i < h - 1) {
+                    result_type *vertical = horizontal + res_width;
+                    for (index_t j = 0; j < w - 1; j++) {
+                        horizontal[2 * j + 1] = row[2 * j];
+                        vertical[2 * j] = row[2 * j + 1];
+                    }
+                    vertical[2 * (w - 1)] = row[2 * (w - 1)];
+                } else {
+                    // the last row only contains right edges
+                    for (index_t j = 0; j < w - 1; j++) {
+                        horizontal[2 * j + 1] = row[j];
+                    }
+                }
+            });
+        }
+
+        /**
+         * Inverse of grid_4_adjacency_edge_weights_2_khalimsky.
+         */
+        template<typename value_type, typename result_type>
+        void khalimsky_2_grid_4_adjacency_edge_weights(const value_type *khalimsky, index_t k_width,
+                                                       index_t offset, result_type *weights, index_t h, index_t w) {
+            parfor(0, h, [khalimsky, k_width, offset, weights, h, w](index_t i) {
+                result_type *row = weights + i * (2 * w - 1);
+                const value_type *horizontal = khalimsky + (2 * i + offset) * k_width + offset;
+                if (i < h - 1) {
+                    const value_type *vertical = horizontal + k_width;
+                    for (index_t j = 0; j < w - 1; j++) {
+                        row[2 * j] = horizontal[2 * j + 1];
+                        row[2 * j + 1] = vertical[2 * j];
+                    }
+                    row[2 * (w - 1)] = vertical[2 * (w - 1)];
+                } else {
+                    for (index_t j = 0; j < w - 1; j++) {
+                        row[j] = horizontal[2 * j + 1];
+                    }
+                }
+            });
+        }
+
+        /**
+         * Sets each 0-face (y, x), with y and x of the same parity as first, of the row major Khalimsky grid res of
+         * shape (h, w) to the maximum of its adjacent 1-faces. The rows are processed in parallel.
+         */
+        template<typename result_type>
+        void khalimsky_0_faces_max(result_type *res, index_t h, index_t w, index_t first) {
+            parfor(0, (h - first + 1) / 2, [res, h, w, first](index_t k) {
+                const index_t y = first + 2 * k;
+                result_type *row = res + y * w;
+                const result_type *up = (y > 0) ? row - w : nullptr;
+                const result_type *down = (y < h - 1) ? row + w : nullptr;
+                for (index_t x = first; x < w; x += 2) {
+                    result_type max_v = std::numeric_limits<result_type>::lowest();
+                    if (up != nullptr) {
+                        max_v = (std::max)(max_v, up[x]);
+                    }
+                    if (down != nullptr) {
+                        max_v = (std::max)(max_v, down[x]);
+                    }
+                    if (x > 0) {
+                        max_v = (std::max)(max_v, row[x - 1]);
+                    }
+                    if (x < w - 1) {
+                        max_v = (std::max)(max_v, row[x + 1]);
+                    }
+                    row[x] = max_v;
+                }
+            });
+        }
+    }
 
     /**
      * Represents a 4 adjacency edge weighted regular graph in 2d Khalimsky space
+     *
+     * If the edges of the graph are indexed as in get_4_adjacency_graph (which is always the case for
+     * get_4_adjacency_grid_graph), the edge weights are copied row by row with strided accesses; otherwise the
+     * position of each edge is computed from its extremities.
+     *
      * @param embedding
      * @return
      */
@@ -94,27 +331,29 @@ namespace hg {
         std::array<index_t, 2> res_shape{(index_t)shape[0] * 2 + border, (index_t)shape[1] * 2 + border};
 
         array_2d <result_type> res = xt::zeros<result_type>(res_shape);
+        auto h = res_shape[0];
+        auto w = res_shape[1];
 
-        point_2d_i one{{1, 1}};
-        for (auto e: edge_iterator(graph)) {
-            auto s = source(e, graph);
-            auto t = target(e, graph);
-            if (t > s) {
-                auto ti = embedding.lin2grid(t);
-                auto si = embedding.lin2grid(s);
-                if (add_extra_border)
-                    res[ti + si + one] = weight(e);
-                else
-                    res[ti + si] = weight(e);
+        if (graph_image_internal::has_4_adjacency_grid_edge_order(graph, embedding)) {
+            array_nd<typename T::value_type> buffer;
+            graph_image_internal::grid_4_adjacency_edge_weights_2_khalimsky(
+                    row_major_data(weight, buffer), shape[0], shape[1], res.data(), w, add_extra_border ? 1 : 0);
+        } else {
+            point_2d_i one{{1, 1}};
+            for (auto e: edge_iterator(graph)) {
+                auto s = source(e, graph);
+                auto t = target(e, graph);
+                if (t > s) {
+                    auto ti = embedding.lin2grid(t);
+                    auto si = embedding.lin2grid(s);
+                    if (add_extra_border)
+                        res[ti + si + one] = weight(e);
+                    else
+                        res[ti + si] = weight(e);
+                }
             }
         }
 
-        embedding_grid_2d res_embedding(res_shape);
-        auto adj4 = get_4_adjacency_implicit_graph(res_embedding);
-        auto h = res_embedding.shape()[0];
-        auto w = res_embedding.shape()[1];
-        auto flat_res = xt::flatten(res);
-
         if (add_extra_border && extra_border_value != 0) {
             for (index_t x = 1; x < w; x += 2) {
                 res(0, x) = extra_border_value;
@@ -126,21 +365,7 @@ namespace hg {
             }
         }
 
-        index_t ymin = (add_extra_border) ? 0 : 1;
-        index_t ymax = (add_extra_border) ? h : h - 1;
-        index_t xmin = (add_extra_border) ? 0 : 1;
-        index_t xmax = (add_extra_border) ? w : w - 1;
-
-        for (index_t y = ymin; y < ymax; y += 2) {
-            for (index_t x = xmin; x < xmax; x += 2) {
-                auto v = res_embedding.grid2lin({y, x});
-                result_type max_v = std::numeric_limits<result_type>::lowest();
-                for (auto av: adjacent_vertex_iterator(v, adj4)) {
-                    max_v = (std::max)(max_v, flat_res(av));
-                }
-                res(y, x) = max_v;
-            }
-        }
+        graph_image_internal::khalimsky_0_faces_max(res.data(), h, w, add_extra_border ? 0 : 1);
 
         return res;
     };
@@ -166,20 +391,84 @@ namespace hg {
         embedding_grid_2d res_embedding(res_shape);
 
         auto g = get_4_adjacency_graph(res_embedding);
-        array_1d <result_type> weights = xt::zeros<result_type>({num_edges(g)});
-
-        point_2d_i one{{1, 1}};
-        for (auto e : edge_iterator(g)) {
-            auto s = res_embedding.lin2grid(source(e, g));
-            auto t = res_embedding.lin2grid(target(e, g));
-            if (extra_border) {
-                weights(e) = khalimsky[s + t + one];
-            } else {
-                weights(e) = khalimsky[s + t];
+        array_1d <result_type> weights = array_1d<result_type>::from_shape({num_edges(g)});
+
+        array_nd<typename T::value_type> buffer;
+        graph_image_internal::khalimsky_2_grid_4_adjacency_edge_weights(
+                row_major_data(khalimsky, buffer), shape[1], extra_border ? 1 : 0,
+                weights.data(), res_shape[0], res_shape[1]);
+
+        return std::make_tuple(std::move(g), std::move(res_embedding), std::move(weights));
+    };
+
+    /**
+     * Ultrametric contour map of a hierarchy on a 2d grid represented in 2d Khalimsky space.
+     *
+     * The result is equal to graph_4_adjacency_2_khalimsky(graph, embedding, saliency_map(graph, tree, altitudes),
+     * add_extra_border, extra_border_value) where graph is the 4 adjacency graph of the embedding, but the saliency
+     * of each edge is written directly in its 1-face: the lowest common ancestors of the pairs of adjacent pixels
+     * are computed row by row, in parallel, and no array of edge weights is created.
+     *
+     * @tparam tree_t
+     * @tparam T
+     * @param tree input tree, its leaves must be the pixels of the embedding
+     * @param xaltitudes node altitudes of the input tree
+     * @param embedding 2d grid
+     * @param add_extra_border if false result size is 2 * shape - 1 and 2 * shape + 1 otherwise
+     * @param extra_border_value value of the 1-faces of the extra border
+     * @return a 2d array
+     */
+    template<typename tree_t, typename T, typename result_type = typename T::value_type>
+    auto ucm_khalimsky(const tree_t &tree,
+                       const xt::xexpression<T> &xaltitudes,
+                       const embedding_grid_2d &embedding,
+                       bool add_extra_border = false,
+                       result_type extra_border_value = 0) {
+        HG_TRACE();
+        auto &altitudes = xaltitudes.derived_cast();
+        hg_assert_node_weights(tree, altitudes);
+        hg_assert_1d_array(altitudes);
+        hg_assert(num_leaves(tree) == embedding.size(),
+                  "Tree number of leaves does not match the size of the embedding.");
+
+        const index_t h = embedding.shape()[0];
+        const index_t w = embedding.shape()[1];
+        const index_t offset = add_extra_border ? 1 : 0;
+        const index_t rh = 2 * h - 1 + 2 * offset;
+        const index_t rw = 2 * w - 1 + 2 * offset;
+
+        array_2d<result_type> res = xt::zeros<result_type>({(size_t) rh, (size_t) rw});
+        lca_bitmask_block lca(tree);
+
+        result_type *data = res.data();
+        parfor(0, h, [&lca, &altitudes, data, h, w, rw, offset](index_t i) {
+            result_type *horizontal = data + (2 * i + offset) * rw + offset;
+            result_type *vertical = horizontal + rw;
+            const index_t first = i * w;
+            for (index_t j = 0; j < w - 1; j++) {
+                horizontal[2 * j + 1] = altitudes(lca.lca(first + j, first + j + 1));
+            }
+            if (i < h - 1) {
+                for (index_t j = 0; j < w; j++) {
+                    vertical[2 * j] = altitudes(lca.lca(first + j, first + j + w));
+                }
+            }
+        });
+
+        if (add_extra_border && extra_border_value != 0) {
+            for (index_t x = 1; x < rw; x += 2) {
+                res(0, x) = extra_border_value;
+                res(rh - 1, x) = extra_border_value;
+            }
+            for (index_t y = 1; y < rh; y += 2) {
+                res(y, 0) = extra_border_value;
+                res(y, rw - 1) = extra_border_value;
             }
         }
 
-        return std::make_tuple(std::move(g), std::move(res_embedding), std::move(weights));
+        graph_image_internal::khalimsky_0_faces_max(data, rh, rw, add_extra_border ? 0 : 1);
+
+        return res;
     };
 
 }
\ No newline at end of file
@@ -33,6 +33,9 @@ namespace hg {
      *
      *  The algorithm returns the region adjacency graph of watershed pixels and its edge weights.
      *
+     *  The region adjacency graph is built with the parallel engine (see make_region_adjacency_graph_from_labelisation)
+     *  and the subdivision and the reweighting of the polylines of the contour are done in parallel.
+     *
      * .. [ArbelaezPAMI2011] Arbelaez, P., Maire, M., Fowlkes, C., & Malik, J..
      *    Contour detection and hierarchical image segmentation.
      *    IEEE transactions on pattern analysis and machine intelligence, 33(5), 898-916.
@@ -60,7 +63,7 @@ namespace hg {
         hg_assert(num_vertices(graph) == embedding.size(),
                   "Graph number of vertices does not match the size of the embedding.");
         auto watershed_labels = labelisation_watershed(graph, edge_weights);
-        auto rag = make_region_adjacency_graph_from_labelisation(graph, watershed_labels);
+        auto rag = make_region_adjacency_graph_from_labelisation(execution::par, graph, watershed_labels);
 
         array_1d<value_t> final_weights = xt::zeros<value_t>({num_edges(graph)});
 
@@ -73,8 +76,9 @@ namespace hg {
             auto contour2d = fit_contour_2d(graph, embedding, watershed_cut);
             contour2d.subdivide();
 
-            for (auto &polyline: contour2d) {
-                for (auto &segment: polyline) {
+            // each edge of the watershed cut belongs to a single polyline: polylines can be processed in parallel
+            parfor(0, (index_t) contour2d.size(), [&contour2d, &edge_weights, &edge_orientations, &final_weights](index_t i) {
+                for (auto &segment: contour2d[i]) {
                     auto segment_orientation = std::fmod(segment.angle(), xt::numeric_constants<double>::PI);
 
                     for (auto element: segment) {
@@ -89,7 +93,7 @@ namespace hg {
                         }
                     }
                 }
-            }
+            });
         } else {
             final_weights = edge_weights;
         }
@@ -110,10 +114,15 @@ namespace hg {
      *
      *  The algorithm returns the region adjacency graph of watershed pixels and teh valued tree computed on this graph.
      *
+     *  The agglomeration engine of the average linkage can be chosen with the template parameter engine_t (see
+     *  binary_partition_tree_average_linkage): bpt_nn_chain is faster but, as the mean boundary probabilities of the
+     *  region adjacency graph edges frequently contain ties, it may not give the same tree as the heap engines.
+     *
      * .. [ArbelaezPAMI2011] Arbelaez, P., Maire, M., Fowlkes, C., & Malik, J..
      *    Contour detection and hierarchical image segmentation.
      *    IEEE transactions on pattern analysis and machine intelligence, 33(5), 898-916.
      *
+     * @tparam engine_t agglomeration engine: bpt_dary_heap<> (default), bpt_pairing_heap, bpt_fibonacci_heap, or bpt_nn_chain
      * @tparam graph_t
      * @tparam T1
      * @tparam T2
@@ -123,7 +132,7 @@ namespace hg {
      * @param xedge_orientations
      * @return
      */
-    template<typename graph_t, typename T1, typename T2>
+    template<typename engine_t = bpt_dary_heap<>, typename graph_t, typename T1, typename T2>
     auto mean_pb_hierarchy(const graph_t &graph,
                            const embedding_grid_2d &embedding,
                            const xt::xexpression<T1> &xedge_weights,
@@ -144,7 +153,7 @@ namespace hg {
 
         auto rag_edge_length = rag_accumulate(rag.edge_map, edge_weights, accumulator_counter());
 
-        auto tree = binary_partition_tree_average_linkage(rag.rag,
+        auto tree = binary_partition_tree_average_linkage<engine_t>(rag.rag,
                                                           rag_edge_weights,
                                                           rag_edge_length);
         return std::make_pair(std::move(rag), std::move(tree));
@@ -0,0 +1,310 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "graph_image.hpp"
+#include "../algo/graph_weights.hpp"
+#include "../hierarchy/hierarchy_core.hpp"
+#include "../hierarchy/watershed_hierarchy.hpp"
+
+namespace hg {
+
+    namespace multiresolution_hierarchy_internal {
+
+        /**
+         * Level of an image pyramid: the pixel (y, x) of the level l covers the pixels of the full resolution image
+         * in the block [y * 2^l, (y + 1) * 2^l[ x [x * 2^l, (x + 1) * 2^l[ (clipped to the image domain).
+         *
+         * sums(i, c) is the sum of the channel c of the full resolution pixels covered by the pixel i and area(i)
+         * is their number.
+         */
+        struct pyramid_level {
+            embedding_grid_2d embedding;
+            array_2d<double> sums;
+            array_1d<index_t> area;
+        };
+
+        /**
+         * Next level of the image pyramid: each pixel covers a block of 2x2 pixels of the given level.
+         */
+        inline pyramid_level downsample(const pyramid_level &fine) {
+            const index_t height = fine.embedding.shape()[0];
+            const index_t width = fine.embedding.shape()[1];
+            const index_t channels = fine.sums.shape()[1];
+            const index_t coarse_height = (height + 1) / 2;
+            const index_t coarse_width = (width + 1) / 2;
+            const size_t num_coarse_pixels = (size_t) (coarse_height * coarse_width);
+
+            pyramid_level coarse{embedding_grid_2d{coarse_height, coarse_width},
+                                 xt::zeros<double>({num_coarse_pixels, (size_t) channels}),
+                                 xt::zeros<index_t>({num_coarse_pixels})};
+            for (index_t y = 0; y < height; y++) {
+                for (index_t x = 0; x < width; x++) {
+                    index_t i = y * width + x;
+                    index_t c = (y / 2) * coarse_width + x / 2;
+                    coarse.area(c) += fine.area(i);
+                    for (index_t k = 0; k < channels; k++) {
+                        coarse.sums(c, k) += fine.sums(i, k);
+                    }
+                }
+            }
+            return coarse;
+        }
+
+        /**
+         * Hierarchy on the pixels of the full resolution image obtained by adding the full resolution pixels as new
+         * leaves below the leaves of the given hierarchy: the full resolution pixel i becomes a child of the leaf
+         * leaf_map(i) of the given hierarchy. The new leaves have the altitude 0.
+         */
+        template<typename tree_t, typename T1, typename T2>
+        auto expand_hierarchy_leaves(const tree_t &tree, const T1 &altitudes, const T2 &leaf_map) {
+            const index_t num_new_leaves = leaf_map.size();
+            const index_t num_nodes = num_vertices(tree);
+            array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) (num_new_leaves + num_nodes)});
+            array_1d<double> new_altitudes = array_1d<double>::from_shape({(size_t) (num_new_leaves + num_nodes)});
+            for (index_t i = 0; i < num_new_leaves; i++) {
+                parents(i) = num_new_leaves + leaf_map(i);
+                new_altitudes(i) = 0;
+            }
+            for (index_t i = 0; i < num_nodes; i++) {
+                parents(num_new_leaves + i) = num_new_leaves + parent(i, tree);
+                new_altitudes(num_new_leaves + i) = altitudes(i);
+            }
+            return make_node_weighted_tree(hg::tree(std::move(parents), tree.category()), std::move(new_altitudes));
+        }
+    }
+
+    /**
+     * Multi-resolution computation of a hierarchy of the 4 adjacency graph of an image for progressive display.
+     *
+     * An image pyramid is built by successive 2x2 block averaging of the image. At construction, the hierarchy of
+     * the coarsest level of the pyramid is computed: its cost is divided by 4 for each level of the pyramid. Each
+     * call to refine computes the hierarchy of the next finer level, until the full resolution level 0 is reached:
+     * the hierarchy of the level 0 is exactly the hierarchy of the full resolution image.
+     *
+     * At any time, full_resolution_hierarchy returns the current hierarchy with refined leaves: the pixels of the
+     * full resolution image are attached below the leaf of the current level that covers them, so that the current
+     * hierarchy can be used in place of the full resolution one (saliency maps, cuts...).
+     *
+     * The hierarchy of a level is computed by the function hierarchy_fun(graph, edge_weights, vertex_area) where
+     * graph is the 4 adjacency graph of the level, edge_weights are computed with the given weighting function on
+     * the mean values of the pixels of the level, and vertex_area gives the number of full resolution pixels covered
+     * by each pixel of the level. The function must return a structure with a tree and an altitudes fields (see
+     * make_multiresolution_bpt_canonical and make_multiresolution_watershed_hierarchy_by_area).
+     *
+     * @tparam hierarchy_fun_t
+     */
+    template<typename hierarchy_fun_t>
+    struct multiresolution_hierarchy {
+
+        using hierarchy_type = node_weighted_tree<tree, array_1d<double>>;
+
+        /**
+         * Builds the image pyramid and computes the hierarchy of its coarsest level.
+         *
+         * The image must have the shape of the embedding, possibly followed by channel dimensions.
+         *
+         * @tparam T
+         * @param embedding shape of the image
+         * @param ximage pixel values
+         * @param num_levels number of levels of the pyramid (the number of levels is reduced if the coarsest level
+         * would contain a single pixel)
+         * @param weight edge weighting function
+         * @param hierarchy_fun hierarchy function
+         */
+        template<typename T>
+        multiresolution_hierarchy(const embedding_grid_2d &embedding,
+                                  const xt::xexpression<T> &ximage,
+                                  index_t num_levels,
+                                  weight_functions weight,
+                                  hierarchy_fun_t hierarchy_fun) :
+                m_weight(weight),
+                m_hierarchy_fun(std::move(hierarchy_fun)) {
+            HG_TRACE();
+            using namespace multiresolution_hierarchy_internal;
+            auto &image = ximage.derived_cast();
+            const index_t num_pixels = embedding.size();
+            hg_assert(num_levels >= 1, "The number of levels must be strictly positive.");
+            hg_assert(image.dimension() >= 2 &&
+                      image.shape()[0] == (size_t) embedding.shape()[0] &&
+                      image.shape()[1] == (size_t) embedding.shape()[1],
+                      "Image shape does not match the embedding.");
+
+            const index_t channels = image.size() / num_pixels;
+            array_2d<double> sums = xt::reshape_view(image, {(size_t) num_pixels, (size_t) channels});
+            m_levels.push_back({embedding, std::move(sums), xt::ones<index_t>({(size_t) num_pixels})});
+            while ((index_t) m_levels.size() < num_levels) {
+                const auto &shape = m_levels.back().embedding.shape();
+                if ((shape[0] + 1) / 2 * ((shape[1] + 1) / 2) <= 1) {
+                    break;
+                }
+                m_levels.push_back(downsample(m_levels.back()));
+            }
+            compute_level(m_levels.size() - 1);
+        }
+
+        /**
+         * Number of levels of the image pyramid
+         */
+        index_t num_levels() const {
+            return m_levels.size();
+        }
+
+        /**
+         * Current level: the pixels of the current level cover blocks of 2^level x 2^level full resolution pixels
+         */
+        index_t level() const {
+            return m_level;
+        }
+
+        /**
+         * True if the current hierarchy is the hierarchy of the full resolution image
+         */
+        bool is_full_resolution() const {
+            return m_level == 0;
+        }
+
+        /**
+         * Shape of the current level
+         */
+        const embedding_grid_2d &embedding() const {
+            return m_levels[m_level].embedding;
+        }
+
+        /**
+         * Number of full resolution pixels covered by each pixel of the current level
+         */
+        const array_1d<index_t> &vertex_area() const {
+            return m_levels[m_level].area;
+        }
+
+        /**
+         * Hierarchy of the current level: its leaves are the pixels of the current level
+         */
+        const hierarchy_type &hierarchy() const {
+            return m_hierarchy;
+        }
+
+        /**
+         * For each pixel of the full resolution image, the index of the pixel of the current level (leaf of the
+         * current hierarchy) that covers it.
+         */
+        array_1d<index_t> leaf_map() const {
+            const auto &shape = m_levels[0].embedding.shape();
+            const index_t coarse_width = embedding().shape()[1];
+            array_1d<index_t> result = array_1d<index_t>::from_shape({(size_t) (shape[0] * shape[1])});
+            for (index_t y = 0; y < shape[0]; y++) {
+                for (index_t x = 0; x < shape[1]; x++) {
+                    result(y * shape[1] + x) = (y >> m_level) * coarse_width + (x >> m_level);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * The current hierarchy with refined leaves: its leaves are the pixels of the full resolution image
+         */
+        hierarchy_type full_resolution_hierarchy() const {
+            if (m_level == 0) {
+                return m_hierarchy;
+            }
+            return multiresolution_hierarchy_internal::expand_hierarchy_leaves(m_hierarchy.tree,
+                                                                               m_hierarchy.altitudes,
+                                                                               leaf_map());
+        }
+
+        /**
+         * Computes the hierarchy of the next finer level of the pyramid.
+         *
+         * @return false if the current hierarchy is already the full resolution hierarchy, true otherwise
+         */
+        bool refine() {
+            if (m_level == 0) {
+                return false;
+            }
+            HG_TRACE();
+            compute_level(m_level - 1);
+            return true;
+        }
+
+    private:
+
+        void compute_level(index_t level) {
+            const auto &l = m_levels[level];
+            const index_t num_pixels = l.area.size();
+            const index_t channels = l.sums.shape()[1];
+            array_nd<double> values = l.sums / xt::view(l.area, xt::all(), xt::newaxis());
+            if (channels == 1) {
+                values.reshape({(size_t) num_pixels});
+            }
+            auto graph = get_4_adjacency_graph(l.embedding);
+            array_1d<double> edge_weights = weight_graph(graph, values, m_weight);
+            auto res = m_hierarchy_fun(graph, edge_weights, l.area);
+            array_1d<double> altitudes = res.altitudes;
+            m_hierarchy = hierarchy_type{std::move(res.tree), std::move(altitudes)};
+            m_level = level;
+        }
+
+        weight_functions m_weight;
+        hierarchy_fun_t m_hierarchy_fun;
+        std::vector<multiresolution_hierarchy_internal::pyramid_level> m_levels;
+        hierarchy_type m_hierarchy;
+        index_t m_level;
+    };
+
+    /**
+     * Multi-resolution canonical binary partition tree of the 4 adjacency graph of an image (see
+     * multiresolution_hierarchy and bpt_canonical).
+     *
+     * @tparam T
+     * @param embedding shape of the image
+     * @param ximage pixel values
+     * @param num_levels number of levels of the image pyramid
+     * @param weight edge weighting function (default weight_functions::L1)
+     * @return a multiresolution_hierarchy
+     */
+    template<typename T>
+    auto make_multiresolution_bpt_canonical(const embedding_grid_2d &embedding,
+                                            const xt::xexpression<T> &ximage,
+                                            index_t num_levels,
+                                            weight_functions weight = weight_functions::L1) {
+        auto fun = [](const ugraph &graph, const array_1d<double> &edge_weights, const array_1d<index_t> &) {
+            return bpt_canonical(graph, edge_weights);
+        };
+        return multiresolution_hierarchy<decltype(fun)>(embedding, ximage, num_levels, weight, fun);
+    }
+
+    /**
+     * Multi-resolution watershed hierarchy by area of the 4 adjacency graph of an image (see
+     * multiresolution_hierarchy and watershed_hierarchy_by_area).
+     *
+     * The area of a pixel of a coarse level is the number of full resolution pixels it covers: the altitudes of the
+     * coarse hierarchies are thus expressed in full resolution pixels.
+     *
+     * @tparam T
+     * @param embedding shape of the image
+     * @param ximage pixel values
+     * @param num_levels number of levels of the image pyramid
+     * @param weight edge weighting function (default weight_functions::L1)
+     * @return a multiresolution_hierarchy
+     */
+    template<typename T>
+    auto make_multiresolution_watershed_hierarchy_by_area(const embedding_grid_2d &embedding,
+                                                          const xt::xexpression<T> &ximage,
+                                                          index_t num_levels,
+                                                          weight_functions weight = weight_functions::L1) {
+        auto fun = [](const ugraph &graph, const array_1d<double> &edge_weights,
+                      const array_1d<index_t> &vertex_area) {
+            return watershed_hierarchy_by_area(graph, edge_weights, vertex_area);
+        };
+        return multiresolution_hierarchy<decltype(fun)>(embedding, ximage, num_levels, weight, fun);
+    }
+}
@@ -0,0 +1,394 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "graph_image.hpp"
+#include "../algo/graph_weights.hpp"
+#include "../structure/unionfind.hpp"
+#include <unordered_map>
+#include <future>
+
+namespace hg {
+
+    namespace tiled_mst_internal {
+
+        /**
+         * Edge of the graph processed at each step of tiled_minimum_spanning_tree: index is the index of the edge in
+         * the 4 adjacency graph of the whole image, u and v are the local indices of its extremities.
+         */
+        struct tiled_edge {
+            double weight;
+            index_t index;
+            index_t u;
+            index_t v;
+        };
+
+        /**
+         * Strict total order on edges: by weight, ties are broken by the index of the edge in the whole image graph.
+         * The minimum spanning tree of the image for this order is unique.
+         */
+        inline bool tiled_edge_less(const tiled_edge &e1, const tiled_edge &e2) {
+            return e1.weight < e2.weight || (!(e2.weight < e1.weight) && e1.index < e2.index);
+        }
+
+        /**
+         * Edge of the reduced graph kept between two steps: its extremities are given by their linear coordinates
+         * in the image.
+         */
+        struct reduced_edge {
+            double weight;
+            index_t index;
+            index_t source;
+            index_t target;
+        };
+
+        /**
+         * Computes the minimum spanning forest of the given edges (whose extremities are local vertex indices in
+         * [0, num_local[) and reduces it to the part that may still be modified by edges that are not known yet.
+         *
+         * The key vertices (is_key_vertex(v) is true) are the vertices that may be incident to unknown edges. The
+         * branches of the forest that do not lead to a key vertex are pruned, and the paths whose interior vertices
+         * are neither key vertices nor branching vertices are contracted into their maximal edge. The removed edges
+         * belong to the minimum spanning tree of the whole graph and are reported with
+         * edge_output(edge_index, edge_weight). The remaining edges are stored in reduced_graph with the global
+         * indices of their extremities (given by global_index(v)).
+         */
+        template<typename is_key_t, typename global_index_t, typename edge_output_t>
+        void reduce_spanning_forest(std::vector<tiled_edge> &edges,
+                                    index_t num_local,
+                                    const is_key_t &is_key_vertex,
+                                    const global_index_t &global_index,
+                                    edge_output_t &edge_output,
+                                    std::vector<reduced_edge> &reduced_graph) {
+            // minimum spanning forest of the current graph (Kruskal)
+            std::sort(edges.begin(), edges.end(), tiled_edge_less);
+            union_find uf(num_local);
+            std::vector<tiled_edge> forest;
+            for (const auto &e: edges) {
+                auto c1 = uf.find(e.u);
+                auto c2 = uf.find(e.v);
+                if (c1 != c2) {
+                    uf.link(c1, c2);
+                    forest.push_back(e);
+                }
+            }
+
+            // adjacency of the forest
+            const index_t num_forest_edges = forest.size();
+            std::vector<index_t> degree(num_local, 0);
+            for (const auto &e: forest) {
+                degree[e.u]++;
+                degree[e.v]++;
+            }
+            std::vector<index_t> adjacency_offsets(num_local + 1, 0);
+            for (index_t i = 0; i < num_local; i++) {
+                adjacency_offsets[i + 1] = adjacency_offsets[i] + degree[i];
+            }
+            std::vector<index_t> adjacency(2 * num_forest_edges);
+            {
+                std::vector<index_t> position(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (index_t ei = 0; ei < num_forest_edges; ei++) {
+                    adjacency[position[forest[ei].u]++] = ei;
+                    adjacency[position[forest[ei].v]++] = ei;
+                }
+            }
+            std::vector<char> is_key(num_local);
+            for (index_t i = 0; i < num_local; i++) {
+                is_key[i] = is_key_vertex(i);
+            }
+            std::vector<char> edge_done(num_forest_edges, false);
+            auto opposite = [&forest](index_t ei, index_t v) {
+                return (forest[ei].u == v) ? forest[ei].v : forest[ei].u;
+            };
+            auto next_edge = [&](index_t v) {
+                for (index_t k = adjacency_offsets[v]; k < adjacency_offsets[v + 1]; k++) {
+                    if (!edge_done[adjacency[k]]) {
+                        return adjacency[k];
+                    }
+                }
+                return invalid_index;
+            };
+            auto output = [&](index_t ei) {
+                edge_done[ei] = true;
+                edge_output(forest[ei].index, forest[ei].weight);
+            };
+
+            // prune the branches of the forest that do not lead to a key vertex
+            std::vector<index_t> leaves;
+            for (index_t i = 0; i < num_local; i++) {
+                if (!is_key[i] && degree[i] == 1) {
+                    leaves.push_back(i);
+                }
+            }
+            while (!leaves.empty()) {
+                index_t v = leaves.back();
+                leaves.pop_back();
+                if (degree[v] != 1) { // the last edge of v has been removed with its other extremity
+                    continue;
+                }
+                index_t ei = next_edge(v);
+                output(ei);
+                degree[v]--;
+                index_t n = opposite(ei, v);
+                degree[n]--;
+                if (!is_key[n] && degree[n] == 1) {
+                    leaves.push_back(n);
+                }
+            }
+
+            // contract the paths between key vertices into their maximal edge
+            reduced_graph.clear();
+            std::vector<index_t> path;
+            for (index_t i = 0; i < num_local; i++) {
+                if (degree[i] == 0 || (!is_key[i] && degree[i] == 2)) {
+                    continue;
+                }
+                for (index_t ei = next_edge(i); ei != invalid_index; ei = next_edge(i)) {
+                    path.clear();
+                    index_t v = i;
+                    index_t best = ei;
+                    while (true) {
+                        edge_done[ei] = true;
+                        path.push_back(ei);
+                        if (tiled_edge_less(forest[best], forest[ei])) {
+                            best = ei;
+                        }
+                        v = opposite(ei, v);
+                        if (is_key[v] || degree[v] != 2) {
+                            break;
+                        }
+                        ei = next_edge(v);
+                    }
+                    for (auto pe: path) {
+                        if (pe != best) {
+                            output(pe);
+                        }
+                    }
+                    reduced_graph.push_back({forest[best].weight, forest[best].index, global_index(i),
+                                             global_index(v)});
+                }
+            }
+        }
+    }
+
+    /**
+     * Out-of-core minimum spanning tree of the 4 adjacency graph of an image that does not fit in memory.
+     *
+     * The image of shape embedding is read tile by tile in raster scan order with the function tile_loader,
+     * tile_loader(y, x, height, width) must return the pixel values of the rectangle of the image of origin (y, x)
+     * and of the given shape, as an array of shape (height, width) or (height, width, channels...). The weight of
+     * the edge between two adjacent pixels is computed with the given weighting function (see weight_graph).
+     *
+     * The minimum spanning tree edges are reported, in no particular order, with the function
+     * edge_output(edge_index, edge_weight), where edge_index is the index of the edge in the 4 adjacency graph of the
+     * whole image (as given by get_4_adjacency_grid_graph(embedding), which gives the extremities of each edge).
+     * Ties between edge weights are broken by edge indices: the result is the one of bpt_canonical applied on
+     * the whole image graph. Edges are reported as soon as they are known to belong to the minimum spanning tree,
+     * the output can thus be written progressively to disk.
+     *
+     * The memory usage is bounded by the size of a tile plus a size proportional to the width of the image. At each
+     * step, the minimum spanning forest of the graph composed of the edges of the new tile, of the edges linking
+     * the tile to the already processed region (seams), and of the reduced graph of the processed region is
+     * computed. This forest is then reduced to the part that may still be modified by the edges of the tiles to
+     * come, that is the smallest sub-forest spanning the frontier pixels (processed pixels having an unprocessed
+     * neighbour) in which paths whose interior vertices are neither frontier pixels nor branching vertices are
+     * contracted into their maximal edge. The other edges belong to the minimum spanning tree of the whole image and
+     * are output.
+     *
+     * If prefetch is true, the next tile is loaded on another thread while the current one is processed, so that
+     * reading the image (for example from a chunked file store) overlaps with the computation: tile_loader is then
+     * called from a thread other than the calling one, but never concurrently with itself, and the memory usage is
+     * increased by one tile.
+     *
+     * @tparam tile_loader_t function (index_t, index_t, index_t, index_t) -> xexpression
+     * @tparam edge_output_t function (index_t, double) -> void
+     * @param embedding shape of the whole image
+     * @param tile_height height of a tile (the last tile row may be smaller)
+     * @param tile_width width of a tile (the last tile column may be smaller)
+     * @param tile_loader pixel values provider
+     * @param edge_output minimum spanning tree edges consumer
+     * @param weight edge weighting function (default weight_functions::L1)
+     * @param prefetch if true, the next tile is loaded while the current one is processed (default true)
+     */
+    template<typename tile_loader_t, typename edge_output_t>
+    void tiled_minimum_spanning_tree(const embedding_grid_2d &embedding,
+                                     index_t tile_height,
+                                     index_t tile_width,
+                                     tile_loader_t &&tile_loader,
+                                     edge_output_t &&edge_output,
+                                     weight_functions weight = weight_functions::L1,
+                                     bool prefetch = true) {
+        HG_TRACE();
+        using namespace tiled_mst_internal;
+        using value_type = typename std::decay_t<decltype(xt::eval(tile_loader(0, 0, 0, 0)))>::value_type;
+        hg_assert(tile_height > 0 && tile_width > 0, "Tile dimensions must be positive.");
+
+        const index_t height = embedding.shape()[0];
+        const index_t width = embedding.shape()[1];
+        const index_t num_tile_rows = (height + tile_height - 1) / tile_height;
+        const index_t num_tile_columns = (width + tile_width - 1) / tile_width;
+        const grid_4_adjacency_graph_2d image_graph(embedding);
+
+        // number of channels of a pixel, known after loading the first tile
+        index_t channels = 0;
+        auto vertex_shape = [&channels](index_t num_pixels) -> std::vector<size_t> {
+            if (channels == 1) {
+                return {(size_t) num_pixels};
+            }
+            return {(size_t) num_pixels, (size_t) channels};
+        };
+
+        // pixel values of the last row of the processed region and of the last column of the last processed tile
+        array_nd<value_type> bottom_row;
+        array_nd<value_type> right_column;
+
+        std::vector<reduced_edge> reduced_graph;
+        std::vector<tiled_edge> edges;
+        std::vector<index_t> local_to_global;
+        std::unordered_map<index_t, index_t> global_to_local;
+
+        // loads the k-th tile in raster scan order, immediately (prefetch is true) or when the result is requested
+        const auto launch_policy = prefetch ? std::launch::async : std::launch::deferred;
+        auto load_tile = [&tile_loader, tile_height, tile_width, height, width, num_tile_columns](index_t k) {
+            const index_t y0 = (k / num_tile_columns) * tile_height;
+            const index_t x0 = (k % num_tile_columns) * tile_width;
+            return array_nd<value_type>(tile_loader(y0, x0, (std::min)(tile_height, height - y0),
+                                                    (std::min)(tile_width, width - x0)));
+        };
+        // declared last: if an exception is thrown, a pending load completes before the variables it uses are
+        // destroyed
+        std::future<array_nd<value_type>> next_tile = std::async(launch_policy, load_tile, 0);
+
+        for (index_t ti = 0; ti < num_tile_rows; ti++) {
+            for (index_t tj = 0; tj < num_tile_columns; tj++) {
+                const index_t y0 = ti * tile_height;
+                const index_t x0 = tj * tile_width;
+                const index_t h = (std::min)(tile_height, height - y0);
+                const index_t w = (std::min)(tile_width, width - x0);
+                const index_t num_tile_pixels = h * w;
+
+                array_nd<value_type> tile = next_tile.get();
+                const index_t next_k = ti * num_tile_columns + tj + 1;
+                if (next_k < num_tile_rows * num_tile_columns) {
+                    next_tile = std::async(launch_policy, load_tile, next_k);
+                }
+                hg_assert(tile.dimension() >= 2 && (index_t) tile.shape()[0] == h && (index_t) tile.shape()[1] == w,
+                          "The shape of the tile returned by tile_loader does not match the requested shape.");
+                if (channels == 0) {
+                    channels = tile.size() / num_tile_pixels;
+                    bottom_row = array_nd<value_type>::from_shape(vertex_shape(width));
+                    right_column = array_nd<value_type>::from_shape(vertex_shape(tile_height));
+                }
+                hg_assert((index_t) tile.size() == num_tile_pixels * channels,
+                          "The number of channels of the tiles must be constant.");
+                tile.reshape(vertex_shape(num_tile_pixels));
+
+                // local vertex indices: pixels of the tile first, then the other vertices in order of appearance
+                local_to_global.clear();
+                global_to_local.clear();
+                auto tile_to_global = [y0, x0, w, width](index_t i) {
+                    return (y0 + i / w) * width + x0 + i % w;
+                };
+                auto local_index = [&](index_t global) {
+                    index_t y = global / width;
+                    index_t x = global % width;
+                    if (y >= y0 && y < y0 + h && x >= x0 && x < x0 + w) {
+                        return (y - y0) * w + x - x0;
+                    }
+                    auto it = global_to_local.find(global);
+                    if (it != global_to_local.end()) {
+                        return it->second;
+                    }
+                    index_t local = num_tile_pixels + local_to_global.size();
+                    global_to_local.emplace(global, local);
+                    local_to_global.push_back(global);
+                    return local;
+                };
+                auto global_index = [&](index_t local) {
+                    return (local < num_tile_pixels) ? tile_to_global(local) :
+                           local_to_global[local - num_tile_pixels];
+                };
+
+                edges.clear();
+                for (const auto &e: reduced_graph) {
+                    edges.push_back({e.weight, e.index, local_index(e.source), local_index(e.target)});
+                }
+
+                // edges of the tile
+                auto tile_graph = get_4_adjacency_grid_graph(embedding_grid_2d{h, w});
+                auto tile_weights = weight_graph(tile_graph, tile, weight);
+                for (index_t ei = 0; ei < (index_t) num_edges(tile_graph); ei++) {
+                    index_t s = tile_graph.source(ei);
+                    index_t t = tile_graph.target(ei);
+                    index_t gs = tile_to_global(s);
+                    index_t index = (t == s + 1) ? image_graph.right_edge(gs) : image_graph.bottom_edge(gs);
+                    edges.push_back({tile_weights(ei), index, s, t});
+                }
+
+                // seam edges between the tile and the processed region above and on the left
+                auto add_seam = [&](const array_nd<value_type> &outside_values,
+                                    index_t outside_first,
+                                    index_t num_seam_edges,
+                                    bool top) {
+                    ugraph seam_graph(2 * num_seam_edges);
+                    auto seam_values = array_nd<value_type>::from_shape(vertex_shape(2 * num_seam_edges));
+                    for (index_t k = 0; k < num_seam_edges; k++) {
+                        index_t inside = top ? k : k * w;
+                        std::copy_n(outside_values.data() + (outside_first + k) * channels, channels,
+                                    seam_values.data() + k * channels);
+                        std::copy_n(tile.data() + inside * channels, channels,
+                                    seam_values.data() + (num_seam_edges + k) * channels);
+                        add_edge(k, num_seam_edges + k, seam_graph);
+                    }
+                    auto seam_weights = weight_graph(seam_graph, seam_values, weight);
+                    for (index_t k = 0; k < num_seam_edges; k++) {
+                        index_t inside = top ? k : k * w;
+                        index_t global_inside = tile_to_global(inside);
+                        index_t global_outside = top ? global_inside - width : global_inside - 1;
+                        index_t index = top ? image_graph.bottom_edge(global_outside) :
+                                        image_graph.right_edge(global_outside);
+                        edges.push_back({seam_weights(k), index, local_index(global_outside), inside});
+                    }
+                };
+                if (ti > 0) {
+                    add_seam(bottom_row, x0, w, true);
+                }
+                if (tj > 0) {
+                    add_seam(right_column, 0, h, false);
+                }
+
+                // frontier: processed pixels having an unprocessed neighbour (tiles are processed in raster order)
+                auto is_processed = [&](index_t y, index_t x) {
+                    index_t tile_row = y / tile_height;
+                    return tile_row < ti || (tile_row == ti && x / tile_width <= tj);
+                };
+                auto is_frontier = [&](index_t local) {
+                    index_t global = global_index(local);
+                    index_t y = global / width;
+                    index_t x = global % width;
+                    return (y + 1 < height && !is_processed(y + 1, x)) || (x + 1 < width && !is_processed(y, x + 1));
+                };
+
+                reduce_spanning_forest(edges, num_tile_pixels + local_to_global.size(), is_frontier, global_index,
+                                       edge_output, reduced_graph);
+
+                // update the pixel values along the frontier
+                std::copy_n(tile.data() + (h - 1) * w * channels, w * channels,
+                            bottom_row.data() + x0 * channels);
+                for (index_t r = 0; r < h; r++) {
+                    std::copy_n(tile.data() + (r * w + w - 1) * channels, channels,
+                                right_column.data() + r * channels);
+                }
+            }
+        }
+        hg_assert(reduced_graph.empty(), "Internal error: the reduced graph must be empty after the last tile.");
+    }
+}
@@ -15,24 +15,27 @@
 #include "higra/hierarchy/component_tree.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
+#include "higra/structure/hierarchical_queue.hpp"
 #include "xtensor/xview.hpp"
 #include "xtensor/xnoalias.hpp"
 #include "xtensor/xindex_view.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <map>
-#include <deque>
 
 namespace hg {
 
     namespace tree_of_shapes_internal {
 
         /**
-         * A simple multi-level priority queue with fixed number of integer levels in [min_level, nax_level].
+         * A multi-level priority queue with fixed number of integer levels in [min_level, max_level]: each level is a
+         * FIFO queue.
          *
-         * All operations are done in constant time, except:
-         * - constructor, and
-         * - find_closest_non_empty_level
-         * which both run in O(num_levels = max_level - min_level + 1).
+         * Thin wrapper around a hierarchical_queue (see hierarchical_queue.hpp) which shifts the levels to [0,
+         * num_levels[. All operations are done in constant time, except the constructor which runs in
+         * O(num_levels = max_level - min_level + 1) and find_closest_non_empty_level which runs in O(num_levels / 4096).
          *
          * @paramt value_t type of sored values
          */
@@ -48,8 +51,7 @@ namespace hg {
             integer_level_multi_queue(level_type min_level, level_type max_level) :
                     m_min_level(min_level),
                     m_max_level(max_level),
-                    m_num_levels(max_level - min_level + 1),
-                    m_data(m_num_levels) {
+                    m_queue((index_t) max_level - (index_t) min_level + 1) {
             }
 
             auto min_level() const {
@@ -65,7 +67,7 @@ namespace hg {
              * @return number of levels in the queue
              */
             auto num_levels() const {
-                return m_num_levels;
+                return m_queue.num_levels();
             }
 
             /**
@@ -73,7 +75,7 @@ namespace hg {
              * @return number of elements in the queue
              */
             auto size() const {
-                return m_size;
+                return m_queue.size();
             }
 
             /**
@@ -81,7 +83,7 @@ namespace hg {
              * @return true if the queue is empty
              */
             auto empty() const {
-                return m_size == 0;
+                return m_queue.empty();
             }
 
             /**
@@ -90,7 +92,7 @@ namespace hg {
              * @return true if the given level of the queue is empty
              */
             auto level_empty(level_type level) const {
-                return m_data[level - min_level()].size() == 0;
+                return m_queue.level_empty(index(level));
             }
 
             /**
@@ -99,35 +101,33 @@ namespace hg {
              * @param v new element
              */
             void push(level_type level, value_type v) {
-                m_data[level - min_level()].push_back(v);
-                m_size++;
+                m_queue.push(index(level), v);
             }
 
             /**
-             * Return a reference to the last element of the given queue level
+             * Return a reference to the first element of the given queue level
              * @param level in [min_level, max_level]
              * @return a reference to a value_type element
              */
             auto &top(level_type level) {
-                return m_data[level - min_level()].front();
+                return m_queue.top(index(level));
             }
 
             /**
-            * Return a const reference to the last element of the given queue level
+            * Return a const reference to the first element of the given queue level
             * @param level in [min_level, max_level]
             * @return a const reference to a value_type element
             */
             const auto &top(level_type level) const {
-                return m_data[level - min_level()].front();
+                return m_queue.top(index(level));
             }
 
             /**
-             * Removes the last element of the given queue level
+             * Removes the first element of the given queue level
              * @param level in [min_level, max_level]
              */
             void pop(level_type level) {
-                m_data[level - min_level()].pop_front();
-                m_size--;
+                m_queue.pop(index(level));
             }
 
             /**
@@ -135,131 +135,119 @@ namespace hg {
              * In case of equality the smallest level is returned.
              *
              * @param level in [min_level, max_level]
-             * @return a queue level or hg::invalid_index if the queue is empty
+             * @return a queue level, throws a runtime_error if the queue is empty
              */
             auto find_closest_non_empty_level(level_type level) const {
-                if (!level_empty(level)) {
-                    return level;
+                index_t res = m_queue.find_closest_non_empty_level(index(level));
+                if (res == invalid_index) {
+                    throw std::runtime_error("Empty queue!");
                 }
-
-                level_type level_low = level;
-                level_type level_high = level;
-                bool flag_low = true;
-                bool flag_high = true;
-
-                while (flag_low || flag_high) {
-                    if (flag_low) {
-                        if (!level_empty(level_low)) {
-                            return level_low;
-                        }
-                        if (level_low == m_min_level) {
-                            flag_low = false;
-                        } else {
-                            level_low--;
-                        }
-                    }
-                    if (flag_high) {
-                        if (!level_empty(level_high)) {
-                            return level_high;
-                        }
-                        if (level_high == m_max_level) {
-                            flag_high = false;
-                        } else {
-                            level_high++;
-                        }
-                    }
-                }
-                throw std::runtime_error("Empty queue!");
-                return (level_type) 0;
+                return (level_type) (res + (index_t) m_min_level);
             }
 
         private:
+            index_t index(level_type level) const {
+                return (index_t) level - (index_t) m_min_level;
+            }
+
             level_t m_min_level;
             level_t m_max_level;
-            index_t m_num_levels;
-            std::vector<std::deque<value_type>> m_data;
-            index_t m_size = 0;
+            hierarchical_queue<value_type> m_queue;
         };
 
+        /**
+         * Khalimsky interpolation of the row major image data of shape (h, w) into the plain map of shape
+         * ((h * 2 - 1) * (w * 2 - 1), 2): the rows of the plain map are computed in parallel.
+         */
+        template<typename value_type>
+        void interpolate_plain_map_khalimsky_2d(const value_type *image, index_t h, index_t w,
+                                                array_2d<value_type> &plain_map) {
+            const index_t h2 = h * 2 - 1;
+            const index_t w2 = w * 2 - 1;
+            parfor(0, h2, [image, w, w2, &plain_map](index_t i) {
+                value_type *out = plain_map.data() + i * w2 * 2;
+                const value_type *row = image + (i / 2) * w;
+                if (i % 2 == 0) {
+                    // 2 faces and horizontal 1 faces
+                    for (index_t j = 0; j < w - 1; j++) {
+                        out[4 * j] = out[4 * j + 1] = row[j];
+                        out[4 * j + 2] = (std::min)(row[j], row[j + 1]);
+                        out[4 * j + 3] = (std::max)(row[j], row[j + 1]);
+                    }
+                    out[4 * (w - 1)] = out[4 * (w - 1) + 1] = row[w - 1];
+                } else {
+                    // vertical 1 faces and 0 faces
+                    const value_type *next_row = row + w;
+                    for (index_t j = 0; j < w - 1; j++) {
+                        out[4 * j] = (std::min)(row[j], next_row[j]);
+                        out[4 * j + 1] = (std::max)(row[j], next_row[j]);
+                        out[4 * j + 2] = (std::min)(out[4 * j], (std::min)(row[j + 1], next_row[j + 1]));
+                        out[4 * j + 3] = (std::max)(out[4 * j + 1], (std::max)(row[j + 1], next_row[j + 1]));
+                    }
+                    out[4 * (w - 1)] = (std::min)(row[w - 1], next_row[w - 1]);
+                    out[4 * (w - 1) + 1] = (std::max)(row[w - 1], next_row[w - 1]);
+                }
+            });
+        }
+
         template<typename T, typename value_type=typename T::value_type>
         auto interpolate_plain_map_khalimsky_2d(const xt::xexpression<T> &ximage, const embedding_grid_2d &embedding) {
             auto &image = ximage.derived_cast();
-            size_t h = embedding.shape()[0];
-            size_t w = embedding.shape()[1];
-            size_t h2 = h * 2 - 1;
-            size_t w2 = w * 2 - 1;
-
-            array_2d<value_type> plain_map = array_2d<value_type>::from_shape({h2 * w2, 2});
-            const auto image2d = xt::reshape_view(image, {h, w});
-            auto plain_map2d = xt::reshape_view(plain_map, {h2, w2, (size_t) 2});
-
-            // 2 faces
-            xt::noalias(xt::view(plain_map2d, xt::range(0, h2, 2), xt::range(0, w2, 2), 0)) = image2d;
-            xt::noalias(xt::view(plain_map2d, xt::range(0, h2, 2), xt::range(0, w2, 2), 1)) = image2d;
-
-            // horizontal 1 face
-            xt::noalias(xt::view(plain_map2d, xt::range(0, h2, 2), xt::range(1, w2, 2), 0)) =
-                    xt::minimum(xt::view(image2d, xt::all(), xt::range(0, w - 1)),
-                                xt::view(image2d, xt::all(), xt::range(1, w)));
-            xt::noalias(xt::view(plain_map2d, xt::range(0, h2, 2), xt::range(1, w2, 2), 1)) =
-                    xt::maximum(xt::view(image2d, xt::all(), xt::range(0, w - 1)),
-                                xt::view(image2d, xt::all(), xt::range(1, w)));
-
-            // vertical 1 face
-            xt::noalias(xt::view(plain_map2d, xt::range(1, h2, 2), xt::range(0, w2, 2), 0)) =
-                    xt::minimum(xt::view(image2d, xt::range(0, h - 1), xt::all()),
-                                xt::view(image2d, xt::range(1, h), xt::all()));
-            xt::noalias(xt::view(plain_map2d, xt::range(1, h2, 2), xt::range(0, w2, 2), 1)) =
-                    xt::maximum(xt::view(image2d, xt::range(0, h - 1), xt::all()),
-                                xt::view(image2d, xt::range(1, h), xt::all()));
-
-            // 0 face
-            xt::noalias(xt::view(plain_map2d, xt::range(1, h2, 2), xt::range(1, w2, 2), 0)) =
-                    xt::minimum(
-                            xt::minimum(xt::view(image2d, xt::range(0, h - 1), xt::range(0, w - 1)),
-                                        xt::view(image2d, xt::range(0, h - 1), xt::range(1, w))),
-                            xt::minimum(xt::view(image2d, xt::range(1, h), xt::range(0, w - 1)),
-                                        xt::view(image2d, xt::range(1, h), xt::range(1, w))));
-            xt::noalias(xt::view(plain_map2d, xt::range(1, h2, 2), xt::range(1, w2, 2), 1)) =
-                    xt::maximum(
-                            xt::maximum(xt::view(image2d, xt::range(0, h - 1), xt::range(0, w - 1)),
-                                        xt::view(image2d, xt::range(0, h - 1), xt::range(1, w))),
-                            xt::maximum(xt::view(image2d, xt::range(1, h), xt::range(0, w - 1)),
-                                        xt::view(image2d, xt::range(1, h), xt::range(1, w))));
+            index_t h = embedding.shape()[0];
+            index_t w = embedding.shape()[1];
+            hg_assert((index_t) image.size() == h * w, "Image size does not match embedding size.");
+
+            array_2d<value_type> plain_map = array_2d<value_type>::from_shape({(size_t) ((h * 2 - 1) * (w * 2 - 1)), 2});
+            array_nd<value_type> buffer;
+            interpolate_plain_map_khalimsky_2d(row_major_data(image, buffer), h, w, plain_map);
             return plain_map;
         }
 
-        template<typename graph_t,
-                typename T,
-                typename value_type = typename T::value_type,
-                typename std::enable_if_t<sizeof(value_type) <= 2 && std::is_integral<value_type>::value, int> = 0>
-        auto sort_vertices_tree_of_shapes(const graph_t &graph,
-                                          const xt::xexpression<T> &xplain_map, index_t exterior_vertex = 0) {
+        /**
+         * True if the levels of the given type are propagated with an integer_level_multi_queue
+         */
+        template<typename value_type>
+        using is_small_integral = std::integral_constant<bool,
+                sizeof(value_type) <= 2 && std::is_integral<value_type>::value>;
 
-            auto &plain_map = xplain_map.derived_cast();
+        /**
+         * Propagation order of the tree of shapes (see sort_vertices_tree_of_shapes) where the plain map is given by
+         * the function interval(n) -> std::pair(lower bound, upper bound) of the values of the vertex n. The
+         * interval of each vertex is computed once, when the vertex is enqueued. The plain map values must be in
+         * [min_level, max_level].
+         */
+        template<typename value_type, typename graph_t, typename interval_t>
+        auto sort_vertices_tree_of_shapes_impl(const graph_t &graph,
+                                               const interval_t &interval,
+                                               index_t exterior_vertex,
+                                               value_type min_level,
+                                               value_type max_level,
+                                               std::true_type /* small integral levels */) {
             auto num_v = num_vertices(graph);
-            array_1d<bool> dejavu({num_v}, false);
+            std::vector<bool> dejavu(num_v, false);
             array_1d<index_t> sorted_vertex_indices = array_1d<index_t>::from_shape({num_v});
             array_1d<value_type> enqueued_level = array_1d<value_type>::from_shape({num_v});
-            integer_level_multi_queue<value_type, index_t> queue(xt::amin(plain_map)(), xt::amax(plain_map)());
+            integer_level_multi_queue<value_type, index_t> queue(min_level, max_level);
 
-            value_type current_level = (value_type) ((plain_map(exterior_vertex, 0) + plain_map(exterior_vertex, 1)) /
-                                                     2.0);
+            auto exterior_interval = interval(exterior_vertex);
+            value_type current_level = (value_type) ((exterior_interval.first + exterior_interval.second) / 2.0);
             queue.push(current_level, exterior_vertex);
-            dejavu(exterior_vertex) = true;
+            dejavu[exterior_vertex] = true;
 
             index_t i = 0;
             while (!queue.empty()) {
+                check_cancellation(i);
                 current_level = queue.find_closest_non_empty_level(current_level);
                 auto current_point = queue.top(current_level);
                 queue.pop(current_level);
                 enqueued_level(current_point) = current_level;
                 sorted_vertex_indices(i++) = current_point;
                 for (auto n: adjacent_vertex_iterator(current_point, graph)) {
-                    if (!dejavu(n)) {
-                        auto newLevel = (std::min)(plain_map(n, 1), (std::max)(plain_map(n, 0), current_level));
+                    if (!dejavu[n]) {
+                        auto bounds = interval(n);
+                        auto newLevel = (std::min)(bounds.second, (std::max)(bounds.first, current_level));
                         queue.push(newLevel, n);
-                        dejavu(n) = true;
+                        dejavu[n] = true;
                     }
                 }
 
@@ -267,19 +255,15 @@ namespace hg {
             return std::make_pair(std::move(sorted_vertex_indices), std::move(enqueued_level));
         }
 
-        template<typename graph_t,
-                typename T,
-                typename value_type = typename T::value_type,
-                typename std::enable_if_t<3 <= sizeof(value_type) || !std::is_integral<value_type>::value, int> = 0>
-        auto sort_vertices_tree_of_shapes(const graph_t &graph,
-                                          const xt::xexpression<T> &xplain_map, index_t exterior_vertex = 0) {
-
-            auto &plain_map = xplain_map.derived_cast();
-            hg_assert(plain_map.dimension() == 2, "Invalid plain map");
-            hg_assert(plain_map.shape()[1] == 2, "Invalid plain map");
-            hg_assert_vertex_weights(graph, plain_map);
+        template<typename value_type, typename graph_t, typename interval_t>
+        auto sort_vertices_tree_of_shapes_impl(const graph_t &graph,
+                                               const interval_t &interval,
+                                               index_t exterior_vertex,
+                                               value_type,
+                                               value_type,
+                                               std::false_type /* small integral levels */) {
             auto num_v = num_vertices(graph);
-            array_1d<bool> dejavu({num_v}, false);
+            std::vector<bool> dejavu(num_v, false);
             array_1d<index_t> sorted_vertex_indices = array_1d<index_t>::from_shape({num_v});
             array_1d<value_type> enqueued_level = array_1d<value_type>::from_shape({num_v});
 
@@ -300,24 +284,26 @@ namespace hg {
                 }
             };
 
-            value_type current_level = (value_type) ((plain_map(exterior_vertex, 0) + plain_map(exterior_vertex, 1)) /
-                                                     2.0);
+            auto exterior_interval = interval(exterior_vertex);
+            value_type current_level = (value_type) ((exterior_interval.first + exterior_interval.second) / 2.0);
 
             auto position = queue.insert({current_level, exterior_vertex});
-            dejavu(exterior_vertex) = true;
+            dejavu[exterior_vertex] = true;
 
             index_t i = 0;
             do {
+                check_cancellation(i);
                 current_level = position->first;
                 index_t current_point = position->second;
 
                 enqueued_level(current_point) = current_level;
                 sorted_vertex_indices(i++) = current_point;
                 for (auto n: adjacent_vertex_iterator(current_point, graph)) {
-                    if (!dejavu(n)) {
-                        auto newLevel = (std::min)(plain_map(n, 1), (std::max)(plain_map(n, 0), current_level));
+                    if (!dejavu[n]) {
+                        auto bounds = interval(n);
+                        auto newLevel = (std::min)(bounds.second, (std::max)(bounds.first, current_level));
                         queue.insert({newLevel, n});
-                        dejavu(n) = true;
+                        dejavu[n] = true;
                     }
                 }
 
@@ -328,6 +314,119 @@ namespace hg {
             return std::make_pair(std::move(sorted_vertex_indices), std::move(enqueued_level));
         }
 
+        template<typename T>
+        auto plain_map_level_bounds(const T &plain_map, std::true_type /* small integral levels */) {
+            return std::make_pair(xt::amin(plain_map)(), xt::amax(plain_map)());
+        }
+
+        template<typename T>
+        auto plain_map_level_bounds(const T &, std::false_type /* small integral levels */) {
+            return std::make_pair(typename T::value_type(), typename T::value_type());
+        }
+
+        /**
+         * Propagation order of the tree of shapes: the vertices of the graph are sorted according to the
+         * hierarchical queue propagation of [Géraud et al. 2013] on the given plain map. The plain map is a
+         * (num_vertices, 2) array giving the lower and upper bounds of the values of each vertex.
+         *
+         * @return a pair (sorted vertex indices, enqueued level of each vertex)
+         */
+        template<typename graph_t, typename T>
+        auto sort_vertices_tree_of_shapes(const graph_t &graph,
+                                          const xt::xexpression<T> &xplain_map, index_t exterior_vertex = 0) {
+
+            auto &plain_map = xplain_map.derived_cast();
+            hg_assert(plain_map.dimension() == 2, "Invalid plain map");
+            hg_assert(plain_map.shape()[1] == 2, "Invalid plain map");
+            hg_assert_vertex_weights(graph, plain_map);
+            using value_type = typename T::value_type;
+            auto bounds = plain_map_level_bounds(plain_map, is_small_integral<value_type>());
+            return sort_vertices_tree_of_shapes_impl<value_type>(
+                    graph,
+                    [&plain_map](index_t n) {
+                        return std::make_pair(plain_map(n, 0), plain_map(n, 1));
+                    },
+                    exterior_vertex, bounds.first, bounds.second, is_small_integral<value_type>());
+        }
+
+        /**
+         * Tree of shapes from the propagation order of the vertices of the graph (see sort_vertices_tree_of_shapes).
+         *
+         * If prune is true, the leaves such that keep_leaf(leaf) is false are removed from the tree, together with
+         * the non leaf nodes whose leaves are all removed.
+         *
+         * If num_blocks is different from 1, the pre-tree is computed by blocks of consecutive vertex indices which
+         * are then merged (see parallel_pre_tree_construction): the pre-tree is the max-tree of the propagation rank
+         * of the vertices, which has distinct values, so that the result is identical to the sequential construction.
+         * If num_blocks is 0, the number of blocks depends on the number of threads and on the size of the graph.
+         */
+        template<typename graph_t, typename T1, typename T2, typename keep_leaf_t>
+        auto tree_of_shapes_from_sorted_vertices(const graph_t &graph,
+                                                 const T1 &sorted_vertex_indices,
+                                                 const T2 &enqueued_levels,
+                                                 bool prune,
+                                                 const keep_leaf_t &keep_leaf,
+                                                 index_t num_blocks = 1) {
+            using namespace component_tree_internal;
+            using value_type = typename T2::value_type;
+            index_t num_v = num_vertices(graph);
+            if (num_blocks <= 0) {
+                num_blocks = component_tree_num_blocks(num_v);
+            }
+            num_blocks = (std::max)((index_t) 1, (std::min)(num_blocks, num_v));
+            array_1d<index_t> parents;
+            if (num_blocks == 1) {
+                parents = pre_tree_construction(graph, sorted_vertex_indices);
+            } else {
+                array_1d<index_t> rank = array_1d<index_t>::from_shape({(size_t) num_v});
+                parfor(0, num_v, [&rank, &sorted_vertex_indices](index_t i) {
+                    rank(sorted_vertex_indices(i)) = i;
+                });
+                parents = parallel_pre_tree_construction(graph, rank, sorted_vertex_indices, num_blocks);
+            }
+            parallel_canonize_tree(parents, enqueued_levels, sorted_vertex_indices,
+                                   (num_blocks == 1) ? 0 : num_blocks);
+            auto res = expand_canonized_parent_relation(parents, enqueued_levels, sorted_vertex_indices);
+            array_1d<value_type> res_altitudes = xt::adapt(res.second, {res.second.size()});
+            auto res_tree = make_node_weighted_tree(
+                    tree(xt::adapt(res.first, {res.first.size()}), tree_category::component_tree),
+                    std::move(res_altitudes));
+            auto &tree = res_tree.tree;
+            auto &altitudes = res_tree.altitudes;
+
+            if (!prune) {
+                return res_tree;
+            }
+
+            // a non leaf node is kept if it is the ancestor of a kept leaf: each kept leaf marks its ancestors
+            // until it reaches an already marked node
+            index_t num_nodes = num_vertices(tree);
+            index_t num_l = num_leaves(tree);
+            auto &parents_tree = tree.parents();
+            std::vector<std::atomic<bool>> kept(num_nodes - num_l);
+            parfor(0, num_nodes - num_l, [&kept](index_t n) {
+                kept[n].store(false, std::memory_order_relaxed);
+            });
+            parfor(0, num_l, [&](index_t i) {
+                if (keep_leaf(i)) {
+                    index_t n = parents_tree(i);
+                    while (!kept[n - num_l].exchange(true, std::memory_order_relaxed) && n != tree.root()) {
+                        n = parents_tree(n);
+                    }
+                }
+            });
+            array_1d<bool> deleted = array_1d<bool>::from_shape({(size_t) num_nodes});
+            parfor(0, num_nodes, [&](index_t n) {
+                deleted(n) = (n < num_l) ? !keep_leaf(n) : !kept[n - num_l].load(std::memory_order_relaxed);
+            });
+
+            auto stree = simplify_tree(tree, deleted, true);
+            array_1d<value_type> saltitudes = array_1d<value_type>::from_shape({stree.node_map.size()});
+            parfor(0, (index_t) stree.node_map.size(), [&saltitudes, &altitudes, &stree](index_t n) {
+                saltitudes(n) = altitudes(stree.node_map(n));
+            });
+            return make_node_weighted_tree(std::move(stree.tree), std::move(saltitudes));
+        }
     }
 
     /**
@@ -339,6 +438,149 @@ namespace hg {
         zero
     };
 
+    namespace tree_of_shapes_internal {
+
+        /**
+         * See component_tree_tree_of_shapes_image2d and component_tree_parallel_tree_of_shapes_image2d
+         */
+        template<typename T>
+        auto tree_of_shapes_image2d(const xt::xexpression<T> &ximage,
+                                    tos_padding padding,
+                                    bool original_size,
+                                    bool immersion,
+                                    index_t exterior_vertex,
+                                    index_t num_blocks) {
+            auto &image = ximage.derived_cast();
+            hg_assert(image.dimension() == 2, "image must be a 2d array");
+            embedding_grid_2d embedding(image.shape());
+            auto shape = embedding.shape();
+            size_t h = shape[0];
+            size_t w = shape[1];
+            using value_type = typename T::value_type;
+
+            array_nd<value_type> image_buffer;
+            const value_type *image_data = row_major_data(image, image_buffer);
+
+            size_t rh;
+            size_t rw;
+
+            auto do_padding = [&padding, &h, &w, &image, image_data]() {
+                value_type pad_value;
+                switch (padding) {
+                    case tos_padding::zero:
+                        pad_value = 0;
+                        break;
+                    case tos_padding::mean: {
+                        auto tmp = xt::sum(xt::view(image, 0, xt::all()))() +
+                                   xt::sum(xt::view(image, h - 1, xt::all()))();
+                        if (h > 2) {
+                            tmp += xt::sum(xt::view(image, xt::range(1, h - 1), 0))() +
+                                   xt::sum(xt::view(image, xt::range(1, h - 1), w - 1))();
+                        }
+                        pad_value = (value_type) (tmp / ((std::max)(2.0 * (w + h) - 4, 1.0)));
+                        break;
+                    }
+                    case none:
+                    default:
+                        throw std::runtime_error("Incorrect padding value.");
+                }
+                array_1d<value_type> padded_vertices = array_1d<value_type>::from_shape({(w + 2) * (h + 2)});
+                parfor(0, (index_t) h + 2, [&padded_vertices, h, w, image_data, pad_value](index_t i) {
+                    value_type *row = padded_vertices.data() + i * (w + 2);
+                    if (i == 0 || i == (index_t) h + 1) {
+                        std::fill(row, row + w + 2, pad_value);
+                    } else {
+                        row[0] = pad_value;
+                        std::copy(image_data + (i - 1) * w, image_data + i * w, row + 1);
+                        row[w + 1] = pad_value;
+                    }
+                });
+                return padded_vertices;
+            };
+
+            // plain map of a non interpolated image: the lower and upper bounds of each pixel are both equal to its value
+            auto make_plain_map = [](const value_type *values, size_t size) {
+                array_2d<value_type> plain_map = array_2d<value_type>::from_shape({size, 2});
+                value_type *out = plain_map.data();
+                parfor(0, (index_t) size, [out, values](index_t i) {
+                    out[2 * i] = out[2 * i + 1] = values[i];
+                });
+                return plain_map;
+            };
+
+            auto process_sorted_pixels = [&original_size, &padding, &rh, &rw, &immersion, num_blocks](
+                    auto &graph, auto &sorted_vertex_indices, auto &enqueued_levels) {
+                bool prune = original_size && (immersion || padding != tos_padding::none);
+
+                // a leaf is kept if it corresponds to a pixel of the input image
+                index_t first = 0;
+                index_t last_row = rh;
+                index_t last_column = rw;
+                index_t step = 1;
+                if (immersion) {
+                    step = 2;
+                    if (padding != tos_padding::none) {
+                        first = 2;
+                        last_row = rh - 2;
+                        last_column = rw - 2;
+                    }
+                } else {
+                    first = 1;
+                    last_row = rh - 1;
+                    last_column = rw - 1;
+                }
+                auto keep_leaf = [first, last_row, last_column, step, &rw](index_t i) {
+                    index_t y = i / rw;
+                    index_t x = i % rw;
+                    return y >= first && y < last_row && (y - first) % step == 0 &&
+                           x >= first && x < last_column && (x - first) % step == 0;
+                };
+                return tree_of_shapes_from_sorted_vertices(
+                        graph, sorted_vertex_indices, enqueued_levels, prune, keep_leaf, num_blocks);
+            };
+
+            if (immersion) {
+                array_1d<value_type> padded_vertices;
+                const value_type *values = image_data;
+                index_t ih = h;
+                index_t iw = w;
+                if (padding != tos_padding::none) {
+                    padded_vertices = do_padding();
+                    values = padded_vertices.data();
+                    ih = h + 2;
+                    iw = w + 2;
+                }
+                rh = ih * 2 - 1;
+                rw = iw * 2 - 1;
+                array_2d<value_type> cooked_vertex_values = array_2d<value_type>::from_shape({rh * rw, 2});
+                interpolate_plain_map_khalimsky_2d(values, ih, iw, cooked_vertex_values);
+                auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
+                auto res_sort = sort_vertices_tree_of_shapes(graph, cooked_vertex_values,
+                                                                                      exterior_vertex);
+                return process_sorted_pixels(graph, res_sort.first, res_sort.second);
+            } else {
+                if (padding != tos_padding::none) {
+                    auto padded_vertices = do_padding();
+                    rh = h + 2;
+                    rw = w + 2;
+                    auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
+                    auto plain_map = make_plain_map(padded_vertices.data(), rh * rw);
+                    auto res_sort = sort_vertices_tree_of_shapes(graph, plain_map,
+                                                                                          exterior_vertex);
+                    return process_sorted_pixels(graph, res_sort.first, res_sort.second);
+                } else {
+                    rh = h;
+                    rw = w;
+                    auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
+                    auto plain_map = make_plain_map(image_data, rh * rw);
+                    auto res_sort = sort_vertices_tree_of_shapes(graph, plain_map,
+                                                                                          exterior_vertex);
+                    return process_sorted_pixels(graph, res_sort.first, res_sort.second);
+                }
+            }
+        }
+    }
+
     /**
      * Computes the tree of shapes of a 2d image.
      * The Tree of Shapes was described in [1].
@@ -396,139 +638,318 @@ namespace hg {
                                                bool immersion = true,
                                                index_t exterior_vertex = 0) {
         HG_TRACE();
-        auto &image = ximage.derived_cast();
-        hg_assert(image.dimension() == 2, "image must be a 2d array");
-        embedding_grid_2d embedding(image.shape());
-        auto shape = embedding.shape();
-        size_t h = shape[0];
-        size_t w = shape[1];
-        auto vertex_weights = xt::flatten(image);
-        using value_type = typename T::value_type;
+        return tree_of_shapes_internal::tree_of_shapes_image2d(ximage, padding, original_size, immersion,
+                                                               exterior_vertex, 1);
+    }
 
-        size_t rh;
-        size_t rw;
+    /**
+     * Computes the tree of shapes of a 2d image in parallel: the result is identical to the one of
+     * component_tree_tree_of_shapes_image2d (see this function for the description of the parameters).
+     *
+     * The propagation order of the vertices given by the hierarchical queue is inherently sequential and is
+     * computed as in component_tree_tree_of_shapes_image2d. The union-find construction of the tree, which is its
+     * most expensive part on large images, is then done in parallel: the interpolated image is split into bands of
+     * rows, a pre-tree is computed independently on each band, and the pre-trees are merged along the band
+     * borders [1, 2] before the parallel canonization and pruning steps.
+     *
+     * [1] M. H. F. Wilkinson, H. Gao, W. H. Hesselink, J.-E. Jonker, and A. Meijster, "Concurrent computation of
+     * attribute filters on shared memory parallel machines," IEEE Trans. Pattern Anal. Mach. Intell.,
+     * vol. 30, no. 10, pp. 1800-1813, 2008.
+     *
+     * [2] S. Crozet and Th. Géraud, "A first parallel algorithm to compute the morphological tree of shapes of
+     * nD images," IEEE ICIP 2014.
+     *
+     * @tparam T
+     * @param ximage Must be a 2d array
+     * @param padding Defines if an extra boundary of pixels is added to the original image (see enum tos_padding).
+     * @param original_size remove all nodes corresponding to interpolated/padded pixels
+     * @param immersion performs a plain map continuous immersion of the original image
+     * @param exterior_vertex linear coordinate of the exterior point
+     * @param num_blocks number of bands (if 0, the number of bands is chosen according to the number of available
+     *        threads and to the size of the image)
+     * @return a node weighted tree
+     */
+    template<typename T>
+    auto component_tree_parallel_tree_of_shapes_image2d(const xt::xexpression<T> &ximage,
+                                                        tos_padding padding = tos_padding::mean,
+                                                        bool original_size = true,
+                                                        bool immersion = true,
+                                                        index_t exterior_vertex = 0,
+                                                        index_t num_blocks = 0) {
+        HG_TRACE();
+        return tree_of_shapes_internal::tree_of_shapes_image2d(ximage, padding, original_size, immersion,
+                                                               exterior_vertex, num_blocks);
+    }
 
-        array_2d<value_type> cooked_vertex_values;
+    namespace tree_of_shapes_internal {
 
-        auto do_padding = [&padding, &h, &w](const auto &image) {
-            value_type pad_value;
-            switch (padding) {
-                case tos_padding::zero:
-                    pad_value = 0;
-                    break;
-                case tos_padding::mean: {
-                    auto tmp = xt::sum(xt::view(image, 0, xt::all()))() +
-                               xt::sum(xt::view(image, h - 1, xt::all()))();
-                    if (h > 2) {
-                        tmp += xt::sum(xt::view(image, xt::range(1, h - 1), 0))() +
-                               xt::sum(xt::view(image, xt::range(1, h - 1), w - 1))();
-                    }
-                    pad_value = (value_type) (tmp / ((std::max)(2.0 * (w + h) - 4, 1.0)));
-                    break;
+        /**
+         * Plain map of the Khalimsky interpolation of a nD image, computed on the fly.
+         *
+         * The faces of the Khalimsky grid of an image of shape (s_1, ..., s_d) form a grid of shape
+         * (2 * s_1 - 1, ..., 2 * s_d - 1): the face of coordinates (c_1, ..., c_d) is adjacent to the pixels whose
+         * coordinates are in [c_1 / 2, (c_1 + 1) / 2] x ... x [c_d / 2, (c_d + 1) / 2] (integer divisions), its
+         * interval is given by the minimum and the maximum of the values of these (at most 2^d) pixels. Without
+         * immersion, the faces are the pixels and the interval of a pixel is reduced to its value.
+         *
+         * If padded is true, the image is virtually extended by a border of one pixel of value pad_value.
+         */
+        template<int dim, typename value_type>
+        struct khalimsky_plain_map {
+
+            khalimsky_plain_map(const value_type *data,
+                                const std::array<index_t, dim> &image_shape,
+                                bool padded,
+                                value_type pad_value,
+                                bool immersion) :
+                    m_data(data),
+                    m_image_shape(image_shape),
+                    m_offset(padded ? 1 : 0),
+                    m_pad_value(pad_value),
+                    m_immersion(immersion) {
+                for (index_t i = 0; i < dim; i++) {
+                    index_t grid_size = image_shape[i] + 2 * m_offset;
+                    m_face_shape[i] = immersion ? grid_size * 2 - 1 : grid_size;
                 }
-                case none:
-                default:
-                    throw std::runtime_error("Incorrect padding value.");
             }
-            array_1d<value_type> padded_vertices = array_1d<value_type>::from_shape({(w + 2) * (h + 2)});
-            auto padded_image = xt::reshape_view(padded_vertices, {h + 2, w + 2});
-
-            xt::noalias(xt::view(padded_image, xt::range(1, h + 1), xt::range(1, w + 1))) = image;
-            xt::view(padded_image, 0, xt::all()) = pad_value;
-            xt::view(padded_image, h + 1, xt::all()) = pad_value;
-            xt::view(padded_image, xt::all(), 0) = pad_value;
-            xt::view(padded_image, xt::all(), w + 1) = pad_value;
-            return padded_vertices;
-        };
 
-        auto process_sorted_pixels = [&original_size, &padding, &rh, &rw, &immersion](auto &graph,
-                                                                                      auto &sorted_vertex_indices,
-                                                                                      auto &enqueued_levels) {
-            auto res_tree = component_tree_internal::tree_from_sorted_vertices(graph, enqueued_levels,
-                                                                               sorted_vertex_indices);
-            auto &tree = res_tree.tree;
-            auto &altitudes = res_tree.altitudes;
-
-            if (!original_size || (!immersion && padding == tos_padding::none)) {
-                return res_tree;
+            /**
+             * Shape of the grid of faces
+             */
+            const std::array<index_t, dim> &shape() const {
+                return m_face_shape;
             }
 
-            array_1d<bool> deleted_vertices({num_leaves(res_tree.tree)}, true);
-            auto deleted = xt::reshape_view(deleted_vertices, {rh, rw});
-            if (immersion) {
-                if (padding != tos_padding::none) {
-                    xt::view(deleted, xt::range(2, rh - 2, 2), xt::range(2, rw - 2, 2)) = false;
-                } else {
-                    xt::view(deleted, xt::range(0, rh, 2), xt::range(0, rw, 2)) = false;
+            /**
+             * Lower and upper bounds of the values of the given face
+             */
+            std::pair<value_type, value_type> operator()(index_t face) const {
+                std::array<index_t, dim> low;
+                std::array<index_t, dim> high;
+                for (index_t i = dim - 1; i >= 0; i--) {
+                    index_t c = face % m_face_shape[i];
+                    face /= m_face_shape[i];
+                    low[i] = m_immersion ? c / 2 : c;
+                    high[i] = m_immersion ? (c + 1) / 2 : c;
                 }
-            } else {
-                if (padding != tos_padding::none) {
-                    xt::view(deleted, xt::range(1, rh - 1), xt::range(1, rw - 1)) = false;
-                } // else handled by bypass if on top
+                auto q = low;
+                value_type lower = pixel(q);
+                value_type upper = lower;
+                while (true) {
+                    index_t i = dim - 1;
+                    while (i >= 0 && q[i] == high[i]) {
+                        q[i] = low[i];
+                        i--;
+                    }
+                    if (i < 0) {
+                        break;
+                    }
+                    q[i]++;
+                    value_type v = pixel(q);
+                    lower = (std::min)(lower, v);
+                    upper = (std::max)(upper, v);
+                }
+                return {lower, upper};
             }
 
-            auto all_deleted = accumulate_sequential(tree, deleted_vertices, accumulator_min());
-
-            auto stree = simplify_tree(tree, all_deleted, true);
-            array_1d<value_type> saltitudes = xt::index_view(altitudes, stree.node_map);
-            return make_node_weighted_tree(std::move(stree.tree), std::move(saltitudes));
-        };
+        private:
 
-        if (immersion) {
-            if (padding != tos_padding::none) {
+            // value of the pixel of coordinates q in the padded image
+            value_type pixel(const std::array<index_t, dim> &q) const {
+                index_t index = 0;
+                for (index_t i = 0; i < dim; i++) {
+                    index_t c = q[i] - m_offset;
+                    if (c < 0 || c >= m_image_shape[i]) {
+                        return m_pad_value;
+                    }
+                    index = index * m_image_shape[i] + c;
+                }
+                return m_data[index];
+            }
 
+            const value_type *m_data;
+            std::array<index_t, dim> m_image_shape;
+            std::array<index_t, dim> m_face_shape;
+            index_t m_offset;
+            value_type m_pad_value;
+            bool m_immersion;
+        };
 
-                auto cooked_vertex_values =
-                        tree_of_shapes_internal::interpolate_plain_map_khalimsky_2d(
-                                do_padding(image),
-                                {(index_t) (h + 2), (index_t) (w + 2)});
-                rh = (h + 2) * 2 - 1;
-                rw = (w + 2) * 2 - 1;
-                auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
-                auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, cooked_vertex_values,
-                                                                                      exterior_vertex);
-                return process_sorted_pixels(graph, res_sort.first, res_sort.second);
-            } else {
-                auto cooked_vertex_values =
-                        tree_of_shapes_internal::interpolate_plain_map_khalimsky_2d(
-                                vertex_weights,
-                                embedding);
-                rh = h * 2 - 1;
-                rw = w * 2 - 1;
-                auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
-                auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, cooked_vertex_values,
-                                                                                      exterior_vertex);
-                return process_sorted_pixels(graph, res_sort.first, res_sort.second);
+        /**
+         * Padding value of the image for the given padding mode: 0 or the mean value of the pixels on the border of
+         * the image.
+         */
+        template<int dim, typename value_type>
+        value_type tree_of_shapes_pad_value(const value_type *data,
+                                            const std::array<index_t, dim> &image_shape,
+                                            tos_padding padding) {
+            switch (padding) {
+                case tos_padding::zero:
+                    return 0;
+                case tos_padding::mean: {
+                    index_t size = 1;
+                    for (auto s: image_shape) {
+                        size *= s;
+                    }
+                    double sum = 0;
+                    index_t count = 0;
+                    std::array<index_t, dim> q{};
+                    for (index_t i = 0; i < size; i++) {
+                        bool border = false;
+                        for (index_t k = 0; k < dim; k++) {
+                            border = border || q[k] == 0 || q[k] == image_shape[k] - 1;
+                        }
+                        if (border) {
+                            sum += data[i];
+                            count++;
+                        }
+                        for (index_t k = dim - 1; k >= 0 && ++q[k] == image_shape[k]; k--) {
+                            q[k] = 0;
+                        }
+                    }
+                    return (value_type) (sum / (std::max)((double) count, 1.0));
+                }
+                case tos_padding::none:
+                default:
+                    throw std::runtime_error("Incorrect padding value.");
             }
-        } else {
-            if (padding != tos_padding::none) {
-                auto padded_vertices = do_padding(image);
-
-                rh = h + 2;
-                rw = w + 2;
-                auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
+        }
 
-                // clearly not optimal
-                array_2d<value_type> plain_map = array_2d<value_type>::from_shape({rh * rw, 2});
-                xt::noalias(xt::view(plain_map, xt::all(), 0)) = padded_vertices;
-                xt::noalias(xt::view(plain_map, xt::all(), 1)) = padded_vertices;
-                auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, plain_map,
-                                                                                      exterior_vertex);
-                return process_sorted_pixels(graph, res_sort.first, res_sort.second);
-            } else {
-                rh = h;
-                rw = w;
-                auto graph = get_4_adjacency_implicit_graph({(index_t) rh, (index_t) rw});
-                array_2d<value_type> plain_map = array_2d<value_type>::from_shape({rh * rw, 2});
-                xt::noalias(xt::view(plain_map, xt::all(), 0)) = xt::ravel(image);
-                xt::noalias(xt::view(plain_map, xt::all(), 1)) = xt::ravel(image);
-                auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, plain_map,
-                                                                                      exterior_vertex);
-                return process_sorted_pixels(graph, res_sort.first, res_sort.second);
+        template<typename value_type>
+        std::pair<value_type, value_type> tree_of_shapes_level_bounds(const value_type *data,
+                                                                      index_t size,
+                                                                      bool padded,
+                                                                      value_type pad_value,
+                                                                      std::true_type /* small integral levels */) {
+            auto bounds = std::minmax_element(data, data + size);
+            value_type min_level = *bounds.first;
+            value_type max_level = *bounds.second;
+            if (padded) {
+                min_level = (std::min)(min_level, pad_value);
+                max_level = (std::max)(max_level, pad_value);
             }
+            return {min_level, max_level};
+        }
 
+        template<typename value_type>
+        std::pair<value_type, value_type> tree_of_shapes_level_bounds(const value_type *,
+                                                                      index_t,
+                                                                      bool,
+                                                                      value_type,
+                                                                      std::false_type /* small integral levels */) {
+            return {value_type(), value_type()};
         }
 
+        template<int dim, typename T>
+        auto component_tree_tree_of_shapes_image_nd(const T &image,
+                                                    tos_padding padding,
+                                                    bool original_size,
+                                                    bool immersion,
+                                                    index_t exterior_vertex) {
+            using value_type = typename T::value_type;
+            array_nd<value_type> buffer;
+            const value_type *data = row_major_data(image, buffer);
+
+            std::array<index_t, dim> image_shape;
+            for (index_t i = 0; i < dim; i++) {
+                image_shape[i] = image.shape()[i];
+            }
+            bool padded = padding != tos_padding::none;
+            value_type pad_value = padded ? tree_of_shapes_pad_value<dim>(data, image_shape, padding) : value_type();
+
+            khalimsky_plain_map<dim, value_type> plain_map(data, image_shape, padded, pad_value, immersion);
+            const auto &face_shape = plain_map.shape();
+            embedding_grid<dim> face_embedding(face_shape);
+            hg_assert(exterior_vertex >= 0 && exterior_vertex < (index_t) face_embedding.size(),
+                      "Invalid exterior vertex.");
+
+            // 2 * dim adjacency, neighbours are listed in lexicographic order as in get_4_adjacency_implicit_graph
+            std::vector<point<index_t, dim>> neighbours;
+            for (index_t i = 0; i < 2 * dim; i++) {
+                point<index_t, dim> neighbour;
+                neighbour.fill(0);
+                if (i < dim) {
+                    neighbour[i] = -1;
+                } else {
+                    neighbour[2 * dim - 1 - i] = 1;
+                }
+                neighbours.push_back(neighbour);
+            }
+            regular_graph<embedding_grid<dim>> graph(face_embedding, std::move(neighbours));
+
+            auto bounds = tree_of_shapes_level_bounds(data, image.size(), padded, pad_value,
+                                                      is_small_integral<value_type>());
+            auto res_sort = sort_vertices_tree_of_shapes_impl<value_type>(graph, plain_map, exterior_vertex,
+                                                                          bounds.first, bounds.second,
+                                                                          is_small_integral<value_type>());
+
+            // a leaf is kept if it corresponds to a pixel of the input image
+            bool prune = original_size && (immersion || padded);
+            const index_t step = immersion ? 2 : 1;
+            const index_t margin = padded ? step : 0;
+            auto keep_leaf = [&face_shape, step, margin](index_t face) {
+                for (index_t i = dim - 1; i >= 0; i--) {
+                    index_t c = face % face_shape[i];
+                    face /= face_shape[i];
+                    if (c < margin || c >= face_shape[i] - margin || (c - margin) % step != 0) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            return tree_of_shapes_from_sorted_vertices(graph, res_sort.first, res_sort.second, prune, keep_leaf);
+        }
+    }
 
+    /**
+     * Computes the tree of shapes of a nD image (with 1 <= n <= 4), see component_tree_tree_of_shapes_image2d for
+     * the definition of the tree of shapes and for the description of the parameters.
+     *
+     * Contrarily to component_tree_tree_of_shapes_image2d, neither the padded image nor the plain map of the
+     * interpolated image are materialized: the interval of each face of the Khalimsky grid is computed from the
+     * (at most 2^n) pixels adjacent to the face when the face is reached by the propagation, and the padding is
+     * virtual. The propagation order and the tree are still computed on all the faces of the Khalimsky grid.
+     *
+     * The leaves of the returned tree correspond to an image of shape:
+     *   - the shape (s_1, ..., s_n) of the input image if original_size is true;
+     *   - (s_1 * 2 - 1, ..., s_n * 2 - 1) if original_size is false and padding is tos_padding::none; and
+     *   - ((s_1 + 2) * 2 - 1, ..., (s_n + 2) * 2 - 1) otherwise.
+     * If immersion is false, the factor "* 2 - 1" has to be removed in the above shapes.
+     *
+     * For a 2d image, the result is identical to the result of component_tree_tree_of_shapes_image2d.
+     *
+     * @tparam T
+     * @param ximage a nD array with 1 <= n <= 4
+     * @param padding Defines if an extra boundary of pixels is added to the original image (see enum tos_padding).
+     * @param original_size remove all nodes corresponding to interpolated/padded pixels
+     * @param immersion compute the tree on the Khalimsky interpolation of the image
+     * @param exterior_vertex linear coordinate of the exterior point (in the padded/interpolated space)
+     * @return a node weighted tree
+     */
+    template<typename T>
+    auto component_tree_tree_of_shapes_image(const xt::xexpression<T> &ximage,
+                                             tos_padding padding = tos_padding::mean,
+                                             bool original_size = true,
+                                             bool immersion = true,
+                                             index_t exterior_vertex = 0) {
+        HG_TRACE();
+        auto &image = ximage.derived_cast();
+        using namespace tree_of_shapes_internal;
+        switch (image.dimension()) {
+            case 1:
+                return component_tree_tree_of_shapes_image_nd<1>(image, padding, original_size, immersion,
+                                                                 exterior_vertex);
+            case 2:
+                return component_tree_tree_of_shapes_image_nd<2>(image, padding, original_size, immersion,
+                                                                 exterior_vertex);
+            case 3:
+                return component_tree_tree_of_shapes_image_nd<3>(image, padding, original_size, immersion,
+                                                                 exterior_vertex);
+            case 4:
+                return component_tree_tree_of_shapes_image_nd<4>(image, padding, original_size, immersion,
+                                                                 exterior_vertex);
+            default:
+                throw std::runtime_error("Tree of shapes: image dimension must be between 1 and 4.");
+        }
     }
 };
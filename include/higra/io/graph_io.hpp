@@ -0,0 +1,780 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../structure/details/shared_array.hpp"
+#include "mapped_file.hpp"
+#include "tree_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hg {
+
+#define HG_GRAPH_IO_MAGIC "HGGRAPHB"
+#define HG_GRAPH_IO_VERSION 1
+
+    /**
+     * Kind of graph stored in a graph file (see save_graph).
+     */
+    enum class graph_file_kind : uint64_t {
+        // explicit undirected graph: edges and out edges in compressed sparse row layout
+        undirected = 0,
+        // implicit regular graph: shape of the grid and neighbour list
+        regular = 1
+    };
+
+    /**
+     * Domain of an attribute stored in a graph file.
+     */
+    enum class graph_attribute_kind : uint64_t {
+        vertex = 0,
+        edge = 1
+    };
+
+    namespace graph_io_internal {
+
+        // arrays are aligned on 64 bytes in graph files, such that they can be used in place when the file is memory
+        // mapped
+        const uint64_t alignment = 64;
+        const uint64_t header_size = 64;
+        // maximal dimension of an array and maximal size of an attribute name in bytes
+        const uint64_t max_ndim = 32;
+        const uint64_t max_name_size = 1 << 16;
+
+        enum entry_kind : uint64_t {
+            edges_entry = 0,
+            offsets_entry = 1,
+            out_edges_entry = 2,
+            shape_entry = 3,
+            neighbours_entry = 4,
+            vertex_attribute_entry = 5,
+            edge_attribute_entry = 6
+        };
+
+        using edge_t = csr_graph::edge_descriptor;
+        using out_edge_t = csr_graph::out_edge_t;
+
+        static_assert(sizeof(edge_t) == 3 * sizeof(index_t), "Unexpected edge layout.");
+        static_assert(sizeof(out_edge_t) == 2 * sizeof(index_t), "Unexpected out edge layout.");
+
+        /**
+         * Entry of the table of contents of a graph file.
+         */
+        struct entry {
+            uint64_t kind;
+            std::string name;
+            tree_io_dtype dtype;
+            // position of the data relative to the beginning of the file
+            uint64_t offset;
+            // size of the data in bytes
+            uint64_t size;
+            std::vector<size_t> shape;
+
+            // throws if the number of elements overflows
+            uint64_t num_elements() const {
+                uint64_t n = 1;
+                for (auto s: shape) {
+                    n = tree_io_internal::array_size(n, s);
+                }
+                return n;
+            }
+        };
+
+        inline
+        uint64_t padding(uint64_t position) {
+            return (alignment - position % alignment) % alignment;
+        }
+
+        inline
+        uint64_t attribute_entry_kind(graph_attribute_kind kind) {
+            return kind == graph_attribute_kind::vertex ? vertex_attribute_entry : edge_attribute_entry;
+        }
+
+        /**
+         * Writer of the graph file format (see save_graph).
+         */
+        struct graph_writer {
+
+            graph_writer(std::ostream &out, graph_file_kind kind, size_t num_vertices, size_t num_edges) :
+                    m_out(out), m_kind(kind), m_num_vertices(num_vertices), m_num_edges(num_edges) {
+                m_start = m_out.tellp();
+                const char header[header_size] = {0};
+                write(header, header_size);
+            }
+
+            graph_writer(graph_writer &&other) :
+                    m_out(other.m_out),
+                    m_kind(other.m_kind),
+                    m_num_vertices(other.m_num_vertices),
+                    m_num_edges(other.m_num_edges),
+                    m_start(other.m_start),
+                    m_position(other.m_position),
+                    m_entries(std::move(other.m_entries)),
+                    m_finalized(other.m_finalized) {
+                other.m_finalized = true;
+            }
+
+            ~graph_writer() {
+                finalize();
+            }
+
+            /**
+             * Adds a vertex attribute (array whose first dimension is the number of vertices of the graph) stored with
+             * its own value type.
+             */
+            template<typename T>
+            graph_writer &add_vertex_attribute(const std::string &name, const xt::xexpression<T> &xarray) {
+                return add_attribute(graph_attribute_kind::vertex, name, xarray);
+            }
+
+            /**
+             * Adds an edge attribute (array whose first dimension is the number of edges of the graph) stored with its
+             * own value type.
+             */
+            template<typename T>
+            graph_writer &add_edge_attribute(const std::string &name, const xt::xexpression<T> &xarray) {
+                return add_attribute(graph_attribute_kind::edge, name, xarray);
+            }
+
+            template<typename T>
+            graph_writer &add_attribute(graph_attribute_kind kind, const std::string &name,
+                                        const xt::xexpression<T> &xarray) {
+                using value_type = typename T::value_type;
+                auto &array = xarray.derived_cast();
+                std::vector<size_t> shape(array.shape().begin(), array.shape().end());
+                // row major copy only if the array is not a contiguous row major container
+                array_nd<value_type> buffer;
+                const value_type *data = row_major_data(array, buffer);
+                return add_raw_attribute(kind, name, tree_io_dtype::of<value_type>(), data, shape);
+            }
+
+            /**
+             * Adds an attribute given by a contiguous row major buffer of the given type and shape.
+             */
+            graph_writer &add_raw_attribute(graph_attribute_kind kind, const std::string &name,
+                                            const tree_io_dtype &dtype, const void *data,
+                                            const std::vector<size_t> &shape) {
+                hg_assert(!m_finalized, "The graph file has already been finalized.");
+                hg_assert(shape.size() >= 1, "Attributes must have at least one dimension.");
+                if (kind == graph_attribute_kind::vertex) {
+                    hg_assert(shape[0] == m_num_vertices,
+                              "Vertex attribute size does not match the number of vertices of the graph: " + name);
+                } else {
+                    hg_assert(m_kind == graph_file_kind::undirected,
+                              "Edge attributes cannot be stored with a regular graph.");
+                    hg_assert(shape[0] == m_num_edges,
+                              "Edge attribute size does not match the number of edges of the graph: " + name);
+                }
+                tree_io_internal::dispatch_dtype(dtype, [](auto) {});
+                auto entry_kind = attribute_entry_kind(kind);
+                for (const auto &e: m_entries) {
+                    hg_assert(e.kind != entry_kind || e.name != name, "Duplicated attribute name: " + name);
+                }
+                write_entry(entry_kind, name, dtype, data, shape);
+                return *this;
+            }
+
+            /**
+             * Stores the shape of the grid of an undirected graph (for example a 4 adjacency graph), whose product
+             * must be equal to the number of vertices of the graph.
+             */
+            graph_writer &add_shape(const std::vector<size_t> &shape) {
+                hg_assert(m_kind == graph_file_kind::undirected, "The shape of a regular graph is always stored.");
+                size_t size = 1;
+                for (auto s: shape) {
+                    size *= s;
+                }
+                hg_assert(size == m_num_vertices, "Shape does not match the number of vertices of the graph.");
+                std::vector<index_t> ishape(shape.begin(), shape.end());
+                add_structure(shape_entry, tree_io_dtype::of<index_t>(), ishape.data(), {shape.size()});
+                return *this;
+            }
+
+            /**
+             * Writes an array of the structure of the graph.
+             */
+            void add_structure(uint64_t kind, const tree_io_dtype &dtype, const void *data,
+                               const std::vector<size_t> &shape) {
+                write_entry(kind, "", dtype, data, shape);
+            }
+
+            /**
+             * Writes the table of contents and the header.
+             */
+            void finalize() {
+                if (m_finalized) {
+                    return;
+                }
+                m_finalized = true;
+                write_padding();
+                uint64_t toc_offset = m_position;
+                for (const auto &e: m_entries) {
+                    uint64_t fields[] = {e.kind, tree_io_internal::dtype_code(e.dtype), e.offset, e.size,
+                                         e.shape.size(), e.name.size()};
+                    write(reinterpret_cast<const char *>(fields), sizeof(fields));
+                    for (uint64_t s: e.shape) {
+                        write(reinterpret_cast<const char *>(&s), sizeof(s));
+                    }
+                    write(e.name.data(), e.name.size());
+                }
+                uint64_t end = m_position;
+
+                char header[header_size] = {0};
+                uint64_t fields[] = {HG_GRAPH_IO_VERSION,
+                                     (uint64_t) m_kind,
+                                     m_num_vertices,
+                                     m_num_edges,
+                                     m_entries.size(),
+                                     toc_offset,
+                                     end - toc_offset};
+                std::memcpy(header, HG_GRAPH_IO_MAGIC, 8);
+                std::memcpy(header + 8, fields, sizeof(fields));
+                m_out.seekp(m_start);
+                m_out.write(header, header_size);
+                m_out.seekp(m_start + std::streamoff(end));
+            }
+
+        private:
+
+            void write(const char *data, uint64_t size) {
+                m_out.write(data, std::streamsize(size));
+                m_position += size;
+            }
+
+            void write_padding() {
+                const char zeros[alignment] = {0};
+                write(zeros, padding(m_position));
+            }
+
+            void write_entry(uint64_t kind, const std::string &name, const tree_io_dtype &dtype, const void *data,
+                             const std::vector<size_t> &shape) {
+                hg_assert(name.size() <= max_name_size, "Attribute name is too long: " + name.substr(0, 64) + "...");
+                hg_assert(shape.size() <= max_ndim, "Attribute dimension is too large.");
+                write_padding();
+                entry e{kind, name, dtype, m_position, 0, shape};
+                e.size = e.num_elements() * dtype.size;
+                write((const char *) data, e.size);
+                m_entries.push_back(std::move(e));
+            }
+
+            std::ostream &m_out;
+            graph_file_kind m_kind;
+            uint64_t m_num_vertices;
+            uint64_t m_num_edges;
+            std::streamoff m_start;
+            uint64_t m_position = 0;
+            std::vector<entry> m_entries;
+            bool m_finalized = false;
+        };
+
+        template<typename graph_t>
+        graph_writer save_undirected_graph(std::ostream &out, const graph_t &graph, const edge_t *edges,
+                                           const index_t *offsets, const out_edge_t *out_edges) {
+            const size_t num_v = num_vertices(graph);
+            const size_t num_e = num_edges(graph);
+            graph_writer writer(out, graph_file_kind::undirected, num_v, num_e);
+            writer.add_structure(edges_entry, tree_io_dtype::of<index_t>(), edges, {num_e, 3});
+            writer.add_structure(offsets_entry, tree_io_dtype::of<index_t>(), offsets, {num_v + 1});
+            writer.add_structure(out_edges_entry, tree_io_dtype::of<index_t>(), out_edges,
+                                 {(size_t) offsets[num_v], 2});
+            return writer;
+        }
+
+        inline
+        bool is_graph_file(std::istream &in) {
+            char magic[8] = {0};
+            auto position = in.tellg();
+            in.read(magic, 8);
+            bool res = in.gcount() == 8 && std::memcmp(magic, HG_GRAPH_IO_MAGIC, 8) == 0;
+            in.clear();
+            in.seekg(position);
+            return res;
+        }
+    }
+
+    /**
+     * Random access reader of a graph file (see save_graph).
+     *
+     * Only the header and the table of contents are read at construction: the graph and each attribute are then
+     * read independently on demand. The reader can work on a stream, which must outlive the reader, or on a memory
+     * buffer holding the whole file, typically a memory mapped file (see map_graph_file): read_csr_graph and the
+     * attribute views then use the buffer in place.
+     */
+    class graph_file_reader {
+    public:
+
+        /**
+         * Reader on a seekable input stream (opened in binary mode) positioned at the beginning of a graph file.
+         */
+        explicit graph_file_reader(std::istream &in) : m_in(&in) {
+            m_start = in.tellg();
+            read_header();
+        }
+
+        /**
+         * Reader on a memory buffer holding the content of a graph file. The buffer must not be modified during the
+         * lifetime of the reader and of the graphs read in place. The owner object is kept alive as long as the
+         * buffer is used.
+         *
+         * @param buffer pointer to the file content
+         * @param size size of the buffer in bytes
+         * @param owner object owning the buffer (can be nullptr if the buffer outlives the reader and the graphs)
+         */
+        graph_file_reader(const char *buffer, size_t size, std::shared_ptr<const void> owner) :
+                m_in_memory(true), m_buffer(buffer), m_size(size), m_owner(std::move(owner)) {
+            hg_assert(size >= graph_io_internal::header_size, "Invalid graph file.");
+            read_header();
+        }
+
+        graph_file_kind kind() const {
+            return m_kind;
+        }
+
+        size_t num_vertices() const {
+            return m_num_vertices;
+        }
+
+        size_t num_edges() const {
+            return m_num_edges;
+        }
+
+        /**
+         * Shape of the grid of a regular graph, or shape stored with an undirected graph (empty if none).
+         */
+        std::vector<size_t> shape() {
+            auto e = find_entry(graph_io_internal::shape_entry, "");
+            if (e == nullptr) {
+                return {};
+            }
+            auto shape = read_entry<index_t>(*e);
+            return std::vector<size_t>(shape.begin(), shape.end());
+        }
+
+        /**
+         * Reads an undirected graph stored in the file: the edges and the out edge lists are copied in bulk, without
+         * adding the edges one by one. A regular graph is converted to an explicit graph.
+         */
+        ugraph read_undirected_graph() {
+            if (m_kind == graph_file_kind::regular) {
+                switch (shape().size()) {
+                    case 1:
+                        return copy_graph<ugraph>(read_regular_graph<1>());
+                    case 2:
+                        return copy_graph<ugraph>(read_regular_graph<2>());
+                    case 3:
+                        return copy_graph<ugraph>(read_regular_graph<3>());
+                    case 4:
+                        return copy_graph<ugraph>(read_regular_graph<4>());
+                    case 5:
+                        return copy_graph<ugraph>(read_regular_graph<5>());
+                    default:
+                        throw std::runtime_error("Unsupported dimension of regular graph in graph file.");
+                }
+            }
+            using namespace graph_io_internal;
+            auto edges = read_entry<index_t>(get_entry(edges_entry));
+            auto offsets = read_entry<index_t>(get_entry(offsets_entry));
+            auto out_edges = read_entry<index_t>(get_entry(out_edges_entry));
+            check_structure((const edge_t *) edges.data(), offsets.data(), (const out_edge_t *) out_edges.data(),
+                            out_edges.size() / 2);
+            auto indices = array_1d<index_t>::from_shape({out_edges.size() / 2});
+            auto records = (const out_edge_t *) out_edges.data();
+            for (index_t i = 0; i < (index_t) indices.size(); i++) {
+                indices(i) = records[i].index;
+            }
+            return ugraph::from_edge_lists(m_num_vertices, (const edge_t *) edges.data(), m_num_edges,
+                                           offsets, indices);
+        }
+
+        /**
+         * Reads an undirected graph stored in the file as a csr_graph. With a buffer reader, the graph is created in
+         * place in the buffer when its arrays are stored with the index type of this build: nothing is read or
+         * copied. A regular graph is converted to an explicit graph.
+         */
+        csr_graph read_csr_graph() {
+            if (m_kind == graph_file_kind::regular) {
+                return freeze(read_undirected_graph());
+            }
+            using namespace graph_io_internal;
+            const auto &e_edges = get_entry(edges_entry);
+            const auto &e_offsets = get_entry(offsets_entry);
+            const auto &e_out_edges = get_entry(out_edges_entry);
+            auto edges = (const edge_t *) entry_data(e_edges);
+            auto offsets = (const index_t *) entry_data(e_offsets);
+            auto out_edges = (const out_edge_t *) entry_data(e_out_edges);
+            if (edges != nullptr && offsets != nullptr && out_edges != nullptr &&
+                e_edges.dtype == tree_io_dtype::of<index_t>() &&
+                e_offsets.dtype == tree_io_dtype::of<index_t>() &&
+                e_out_edges.dtype == tree_io_dtype::of<index_t>()) {
+                check_structure(edges, offsets, out_edges, e_out_edges.shape[0]);
+                return csr_graph(m_num_vertices, edges, m_num_edges, offsets, out_edges, m_owner);
+            }
+
+            struct storage {
+                array_1d<index_t> edges;
+                array_1d<index_t> offsets;
+                array_1d<index_t> out_edges;
+            };
+            auto s = std::make_shared<storage>(storage{read_entry<index_t>(e_edges),
+                                                       read_entry<index_t>(e_offsets),
+                                                       read_entry<index_t>(e_out_edges)});
+            check_structure((const edge_t *) s->edges.data(), s->offsets.data(),
+                            (const out_edge_t *) s->out_edges.data(), s->out_edges.size() / 2);
+            return csr_graph(m_num_vertices,
+                             (const edge_t *) s->edges.data(),
+                             m_num_edges,
+                             s->offsets.data(),
+                             (const out_edge_t *) s->out_edges.data(),
+                             s);
+        }
+
+        /**
+         * Reads a regular graph of the given dimension stored in the file.
+         */
+        template<int dim>
+        regular_graph<embedding_grid<dim>> read_regular_graph() {
+            using namespace graph_io_internal;
+            hg_assert(m_kind == graph_file_kind::regular, "The graph file does not contain a regular graph.");
+            auto shape = read_entry<index_t>(get_entry(shape_entry));
+            hg_assert(shape.size() == (size_t) dim, "Invalid dimension of the regular graph.");
+            auto neighbours = read_entry<index_t>(get_entry(neighbours_entry));
+            std::vector<point<index_t, dim>> points(neighbours.size() / dim);
+            for (index_t i = 0; i < (index_t) points.size(); i++) {
+                for (index_t j = 0; j < dim; j++) {
+                    points[i](j) = neighbours(i * dim + j);
+                }
+            }
+            return regular_graph<embedding_grid<dim>>(embedding_grid<dim>(shape), points);
+        }
+
+        /**
+         * Names of the stored vertex or edge attributes, in storage order.
+         */
+        std::vector<std::string> attribute_names(graph_attribute_kind kind) const {
+            auto entry_kind = graph_io_internal::attribute_entry_kind(kind);
+            std::vector<std::string> names;
+            for (const auto &e: m_entries) {
+                if (e.kind == entry_kind) {
+                    names.push_back(e.name);
+                }
+            }
+            return names;
+        }
+
+        bool has_attribute(graph_attribute_kind kind, const std::string &name) const {
+            return find_entry(graph_io_internal::attribute_entry_kind(kind), name) != nullptr;
+        }
+
+        tree_io_dtype attribute_dtype(graph_attribute_kind kind, const std::string &name) const {
+            return get_attribute(kind, name).dtype;
+        }
+
+        const std::vector<size_t> &attribute_shape(graph_attribute_kind kind, const std::string &name) const {
+            return get_attribute(kind, name).shape;
+        }
+
+        /**
+         * Reads the attribute with the given name converted to the value type T.
+         */
+        template<typename T = double>
+        array_nd<T> read_attribute(graph_attribute_kind kind, const std::string &name) {
+            const auto &e = get_attribute(kind, name);
+            array_nd<T> res = read_entry<T>(e);
+            res.reshape(e.shape);
+            return res;
+        }
+
+        /**
+         * Reads the attribute with the given name in its stored type (see attribute_dtype) in a buffer of
+         * attribute_dtype(kind, name).size times the number of elements of the attribute bytes.
+         */
+        void read_raw_attribute(graph_attribute_kind kind, const std::string &name, void *data) {
+            const auto &e = get_attribute(kind, name);
+            read(e.offset, (char *) data, e.size);
+        }
+
+        /**
+         * Pointer to the attribute with the given name in the buffer of a buffer reader if it is suitably aligned for
+         * its stored type (see attribute_dtype). Returns nullptr otherwise.
+         *
+         * The pointer is valid as long as the buffer is alive (see owner).
+         */
+        const void *attribute_data(graph_attribute_kind kind, const std::string &name) const {
+            return entry_data(get_attribute(kind, name));
+        }
+
+        /**
+         * Object owning the buffer of a buffer reader.
+         */
+        const std::shared_ptr<const void> &owner() const {
+            return m_owner;
+        }
+
+    private:
+
+        using edge_t = graph_io_internal::edge_t;
+        using out_edge_t = graph_io_internal::out_edge_t;
+
+        void check_structure(const edge_t *edges, const index_t *offsets, const out_edge_t *out_edges,
+                             size_t num_out_edges) const {
+            hg_assert(offsets[0] == 0 && offsets[m_num_vertices] == (index_t) num_out_edges,
+                      "Invalid out edge offsets in graph file.");
+            const index_t num_v = m_num_vertices;
+            const index_t num_e = m_num_edges;
+            // checked whatever the validation level: the graph is indexed with these values
+            hg_assert(std::is_sorted(offsets, offsets + num_v + 1), "Invalid out edge offsets in graph file.");
+            // the endpoints of removed edges are invalid_index
+            hg_assert(std::all_of(edges, edges + num_e, [num_v](const edge_t &e) {
+                return (e.source >= 0 && e.source < num_v && e.target >= 0 && e.target < num_v) ||
+                       (e.source == invalid_index && e.target == invalid_index);
+            }), "Invalid edge in graph file.");
+            hg_assert(std::all_of(out_edges, out_edges + num_out_edges, [num_v, num_e](const out_edge_t &e) {
+                return e.adjacent_vertex >= 0 && e.adjacent_vertex < num_v && e.index >= 0 && e.index < num_e;
+            }), "Invalid out edge in graph file.");
+        }
+
+        void read(uint64_t offset, char *data, uint64_t size) {
+            if (m_in_memory) {
+                hg_assert(tree_io_internal::in_bounds(offset, size, m_size), "Unexpected end of graph buffer.");
+                std::memcpy(data, m_buffer + offset, size);
+            } else {
+                m_in->clear();
+                m_in->seekg(m_start + std::streamoff(offset));
+                m_in->read(data, std::streamsize(size));
+                hg_assert(m_in->gcount() == (std::streamsize) size, "Unexpected end of graph file.");
+            }
+        }
+
+        uint64_t read_scalar(uint64_t &position) {
+            uint64_t value;
+            read(position, reinterpret_cast<char *>(&value), sizeof(value));
+            position += sizeof(value);
+            return value;
+        }
+
+        void read_header() {
+            using namespace graph_io_internal;
+            char header[header_size];
+            read(0, header, header_size);
+            hg_assert(std::memcmp(header, HG_GRAPH_IO_MAGIC, 8) == 0, "Invalid graph file.");
+            uint64_t fields[7];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(fields[0] == HG_GRAPH_IO_VERSION, "Unsupported graph file version.");
+            hg_assert(fields[1] <= (uint64_t) graph_file_kind::regular, "Unknown graph kind in graph file.");
+            m_kind = (graph_file_kind) fields[1];
+            m_num_vertices = fields[2];
+            m_num_edges = fields[3];
+            uint64_t num_entries = fields[4];
+            uint64_t position = fields[5];
+
+            for (uint64_t i = 0; i < num_entries; i++) {
+                entry e;
+                e.kind = read_scalar(position);
+                e.dtype = tree_io_internal::dtype_from_code(read_scalar(position));
+                // throws on unknown types
+                tree_io_internal::dispatch_dtype(e.dtype, [](auto) {});
+                e.offset = read_scalar(position);
+                e.size = read_scalar(position);
+                uint64_t ndim = read_scalar(position);
+                uint64_t name_size = read_scalar(position);
+                hg_assert(ndim <= max_ndim, "Invalid array dimension in graph file.");
+                hg_assert(name_size <= max_name_size, "Invalid attribute name in graph file.");
+                for (uint64_t j = 0; j < ndim; j++) {
+                    e.shape.push_back(read_scalar(position));
+                }
+                e.name.resize(name_size);
+                read(position, &e.name[0], name_size);
+                position += name_size;
+                hg_assert(e.size == tree_io_internal::array_size(e.num_elements(), e.dtype.size),
+                          "Invalid array size in graph file.");
+                if (e.kind == vertex_attribute_entry) {
+                    hg_assert(!e.shape.empty() && e.shape[0] == m_num_vertices,
+                              "Invalid vertex attribute size in graph file.");
+                } else if (e.kind == edge_attribute_entry) {
+                    hg_assert(!e.shape.empty() && e.shape[0] == m_num_edges,
+                              "Invalid edge attribute size in graph file.");
+                } else if (e.kind == edges_entry) {
+                    hg_assert(e.num_elements() == 3 * m_num_edges, "Invalid edge array size in graph file.");
+                } else if (e.kind == offsets_entry) {
+                    hg_assert(e.num_elements() == m_num_vertices + 1, "Invalid offset array size in graph file.");
+                } else if (e.kind == out_edges_entry) {
+                    hg_assert(e.shape.size() == 2 && e.shape[1] == 2, "Invalid out edge array shape in graph file.");
+                }
+                m_entries.push_back(std::move(e));
+            }
+        }
+
+        using entry = graph_io_internal::entry;
+
+        const entry *find_entry(uint64_t kind, const std::string &name) const {
+            for (const auto &e: m_entries) {
+                if (e.kind == kind && e.name == name) {
+                    return &e;
+                }
+            }
+            return nullptr;
+        }
+
+        const entry &get_entry(uint64_t kind) const {
+            auto e = find_entry(kind, "");
+            hg_assert(e != nullptr, "Missing graph structure in graph file.");
+            return *e;
+        }
+
+        const entry &get_attribute(graph_attribute_kind kind, const std::string &name) const {
+            auto e = find_entry(graph_io_internal::attribute_entry_kind(kind), name);
+            hg_assert(e != nullptr, "Unknown attribute in graph file: " + name);
+            return *e;
+        }
+
+        const void *entry_data(const entry &e) const {
+            if (!m_in_memory) {
+                return nullptr;
+            }
+            hg_assert(tree_io_internal::in_bounds(e.offset, e.size, m_size), "Unexpected end of graph buffer.");
+            const char *data = m_buffer + e.offset;
+            if (((uintptr_t) data) % e.dtype.size != 0) {
+                return nullptr;
+            }
+            return data;
+        }
+
+        template<typename T>
+        array_1d<T> read_entry(const entry &e) {
+            if (e.dtype == tree_io_dtype::of<T>()) {
+                auto res = array_1d<T>::from_shape({(size_t) e.num_elements()});
+                read(e.offset, (char *) res.data(), e.size);
+                return res;
+            }
+            return tree_io_internal::dispatch_dtype(e.dtype, [this, &e](auto dummy) {
+                using stored_t = decltype(dummy);
+                auto stored = array_1d<stored_t>::from_shape({(size_t) e.num_elements()});
+                read(e.offset, (char *) stored.data(), e.size);
+                array_1d<T> res = xt::cast<T>(stored);
+                return res;
+            });
+        }
+
+        // true for a buffer reader, false for a stream reader
+        bool m_in_memory = false;
+        std::istream *m_in = nullptr;
+        std::streamoff m_start = 0;
+        const char *m_buffer = nullptr;
+        size_t m_size = 0;
+        std::shared_ptr<const void> m_owner;
+        graph_file_kind m_kind = graph_file_kind::undirected;
+        size_t m_num_vertices = 0;
+        size_t m_num_edges = 0;
+        std::vector<entry> m_entries;
+    };
+
+    /**
+     * Memory map a graph file (see save_graph) and return a reader on the mapped file: the graph returned by
+     * read_csr_graph and the attribute data (see graph_file_reader::attribute_data) then directly use the mapped file
+     * and nothing is copied.
+     *
+     * The mapping is shared by the readers and the graphs using it, and is released with the last of them.
+     *
+     * @param filename path to the graph file
+     * @return a graph_file_reader
+     */
+    inline
+    graph_file_reader map_graph_file(const std::string &filename) {
+        auto file = std::make_shared<mapped_file>(filename);
+        auto data = file->data();
+        auto size = file->size();
+        return graph_file_reader(data, size, std::move(file));
+    }
+
+    /**
+     * Save an undirected graph in the binary graph format: vertex and edge attributes can then be added to the
+     * returned writer with add_vertex_attribute(name, array) and add_edge_attribute(name, array) before a call to
+     * finalize (which is also called by the destructor of the writer).
+     *
+     * The file starts with a fixed size header followed by the arrays of the graph and the attributes: each array is
+     * stored in its own value type and is aligned on 64 bytes. The graph is stored in compressed sparse row layout:
+     * the (source, target, index) triplets of the edges, the offsets of the out edges of each vertex, and the
+     * (adjacent vertex, edge index) pairs of the out edges. A table of contents at the end of the file gives the
+     * location, type and shape of each array: a graph file can thus be loaded without adding the edges one by one,
+     * or used in place when it is memory mapped (see graph_file_reader and map_graph_file). Values are stored with
+     * the endianness of the machine.
+     *
+     * @tparam edgeS
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @param graph input graph
+     * @return a writer
+     */
+    template<typename edgeS>
+    auto save_graph(std::ostream &out, const undirected_graph<edgeS> &graph) {
+        using namespace graph_io_internal;
+        const index_t num_v = num_vertices(graph);
+        std::vector<index_t> offsets(num_v + 1);
+        offsets[0] = 0;
+        for (index_t v = 0; v < num_v; v++) {
+            offsets[v + 1] = offsets[v] + (index_t) graph.degree(v);
+        }
+        std::vector<out_edge_t> out_edges(offsets[num_v]);
+        const edge_t *edges = graph.edges_data();
+        parfor(0, num_v, [&graph, &offsets, &out_edges, edges](index_t v) {
+            auto position = offsets[v];
+            for (auto it = graph.out_edges_cbegin(v); it != graph.out_edges_cend(v); it++) {
+                const auto &e = edges[*it];
+                out_edges[position++] = {e.source == v ? e.target : e.source, e.index};
+            }
+        });
+        return save_undirected_graph(out, graph, edges, offsets.data(), out_edges.data());
+    }
+
+    /**
+     * Save a csr_graph in the binary graph format (see save_graph).
+     *
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @param graph input graph
+     * @return a writer
+     */
+    inline
+    auto save_graph(std::ostream &out, const csr_graph &graph) {
+        return graph_io_internal::save_undirected_graph(out, graph, graph.edges_data(), graph.offsets_data(),
+                                                        graph.out_edges_data());
+    }
+
+    /**
+     * Save a regular graph in the binary graph format (see save_graph): only the shape of the grid and the neighbour
+     * list are stored. Vertex attributes can be added to the returned writer.
+     *
+     * @tparam embedding_t
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @param graph input graph
+     * @return a writer
+     */
+    template<typename embedding_t>
+    auto save_graph(std::ostream &out, const regular_graph<embedding_t> &graph) {
+        static_assert(embedding_t::_row_major, "Only regular graphs with a row major embedding can be saved.");
+        using namespace graph_io_internal;
+        const size_t dim = embedding_t::_dim;
+        graph_io_internal::graph_writer writer(out, graph_file_kind::regular, num_vertices(graph), 0);
+        std::vector<index_t> shape(graph.embedding().shape().begin(), graph.embedding().shape().end());
+        writer.add_structure(shape_entry, tree_io_dtype::of<index_t>(), shape.data(), {dim});
+        const auto &neighbours = graph.neighbours();
+        std::vector<index_t> points;
+        for (const auto &p: neighbours) {
+            points.insert(points.end(), p.begin(), p.end());
+        }
+        writer.add_structure(neighbours_entry, tree_io_dtype::of<index_t>(), points.data(), {neighbours.size(), dim});
+        return writer;
+    }
+}
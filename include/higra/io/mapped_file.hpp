@@ -0,0 +1,137 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../utils.hpp"
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+namespace hg {
+
+    /**
+     * Read-only memory mapping of a whole file.
+     *
+     * The pages of the file are loaded lazily by the operating system and are shared with all the processes mapping
+     * the same file. The content of the file must not be modified while it is mapped.
+     */
+    class mapped_file {
+    public:
+
+        explicit mapped_file(const std::string &filename) {
+#ifdef _WIN32
+            m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+            hg_assert(m_file != INVALID_HANDLE_VALUE, "Cannot open file: " + filename);
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size)) {
+                close();
+                throw std::runtime_error("Cannot get size of file: " + filename);
+            }
+            m_size = (size_t) size.QuadPart;
+            if (m_size > 0) {
+                m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (m_mapping != nullptr) {
+                    m_data = (const char *) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+                }
+                if (m_data == nullptr) {
+                    close();
+                    throw std::runtime_error("Cannot map file: " + filename);
+                }
+            }
+#else
+            m_file = ::open(filename.c_str(), O_RDONLY);
+            hg_assert(m_file >= 0, "Cannot open file: " + filename);
+            struct stat st;
+            if (::fstat(m_file, &st) != 0) {
+                close();
+                throw std::runtime_error("Cannot get size of file: " + filename);
+            }
+            m_size = (size_t) st.st_size;
+            if (m_size > 0) {
+                void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+                if (data == MAP_FAILED) {
+                    close();
+                    throw std::runtime_error("Cannot map file: " + filename);
+                }
+                m_data = (const char *) data;
+            }
+#endif
+        }
+
+        mapped_file(const mapped_file &) = delete;
+
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        ~mapped_file() {
+            close();
+        }
+
+        /**
+         * Start of the mapping (aligned on a page boundary), nullptr if the file is empty.
+         */
+        const char *data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+    private:
+
+        void close() {
+#ifdef _WIN32
+            if (m_data != nullptr) {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping != nullptr) {
+                CloseHandle(m_mapping);
+            }
+            if (m_file != INVALID_HANDLE_VALUE) {
+                CloseHandle(m_file);
+            }
+            m_mapping = nullptr;
+            m_file = INVALID_HANDLE_VALUE;
+#else
+            if (m_data != nullptr) {
+                ::munmap((void *) m_data, m_size);
+            }
+            if (m_file >= 0) {
+                ::close(m_file);
+            }
+            m_file = -1;
+#endif
+            m_data = nullptr;
+        }
+
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+    };
+}
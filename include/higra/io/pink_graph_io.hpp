@@ -11,7 +11,11 @@
 #pragma once
 
 #include "../graph.hpp"
+#include "mapped_file.hpp"
+#include <cstdlib>
+#include <cstring>
 #include <istream>
+#include <iterator>
 #include <ostream>
 #include <fstream>
 #include <string>
@@ -22,6 +26,9 @@
 
 namespace hg {
 
+#define HG_PINK_GRAPH_BINARY_MAGIC "HGPINKBN"
+#define HG_PINK_GRAPH_BINARY_VERSION 1
+
     template<typename A=array_1d<double>,
             typename B=A>
     struct pink_graph {
@@ -31,74 +38,294 @@ namespace hg {
         B edge_weights;
     };
 
-    inline
-    auto read_pink_graph(std::istream &in) {
-        HG_TRACE();
-        std::string discard;
+    namespace pink_graph_io_internal {
 
-        std::vector<std::size_t> shape;
+        const uint64_t binary_header_size = 64;
 
-        // maybe shape
-        if (in.peek() == '#') {
-            std::size_t rs;
-            std::size_t cs;
-            in >> discard >> rs >> discard >> cs;
-            shape.push_back(cs);
-            shape.push_back(rs);
-        }
+        /**
+         * Parser on the content of a pink graph file: numbers are parsed in place in the buffer, without any
+         * stream or locale machinery.
+         */
+        struct text_parser {
+            const char *m_pos;
+            const char *m_end;
+
+            static bool is_space(char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+            }
+
+            static bool is_digit(char c) {
+                return c >= '0' && c <= '9';
+            }
+
+            void skip_spaces() {
+                while (m_pos != m_end && is_space(*m_pos)) {
+                    m_pos++;
+                }
+            }
+
+            char peek() {
+                skip_spaces();
+                return m_pos != m_end ? *m_pos : '\0';
+            }
 
-        index_t num_points;
-        index_t num_edges;
-        in >> num_points >> num_edges;
+            // returns the next token as a [begin, end) range
+            std::pair<const char *, const char *> token() {
+                skip_spaces();
+                hg_assert(m_pos != m_end, "Invalid graph file: unexpected end of file.");
+                auto begin = m_pos;
+                while (m_pos != m_end && !is_space(*m_pos)) {
+                    m_pos++;
+                }
+                return {begin, m_pos};
+            }
 
-        hg_assert(num_points > 0, "The number of vertices cannot be negative.");
-        hg_assert(num_edges > 0, "The number of edges cannot be negative.");
+            void skip_token() {
+                token();
+            }
 
-        if (shape.empty()) // construct valid shape
-        {
-            shape.push_back(num_points);
+            index_t read_index() {
+                auto t = token();
+                auto p = t.first;
+                bool negative = false;
+                if (*p == '-' || *p == '+') {
+                    negative = *p == '-';
+                    p++;
+                }
+                hg_assert(p != t.second, "Invalid graph file: integer expected.");
+                index_t value = 0;
+                for (; p != t.second; p++) {
+                    hg_assert(is_digit(*p), "Invalid graph file: integer expected.");
+                    value = value * 10 + (*p - '0');
+                }
+                return negative ? -value : value;
+            }
+
+            double read_double() {
+                auto t = token();
+                auto p = t.first;
+                bool negative = false;
+                if (*p == '-' || *p == '+') {
+                    negative = *p == '-';
+                    p++;
+                }
+                // fast path: integral values of at most 15 digits are exactly representable
+                if (p != t.second && t.second - p <= 15) {
+                    int64_t value = 0;
+                    auto q = p;
+                    for (; q != t.second && is_digit(*q); q++) {
+                        value = value * 10 + (*q - '0');
+                    }
+                    if (q == t.second) {
+                        return negative ? -(double) value : (double) value;
+                    }
+                }
+                // general case: null terminated copy of the token for strtod
+                char small[64];
+                std::string large;
+                size_t length = t.second - t.first;
+                const char *str;
+                if (length < sizeof(small)) {
+                    std::memcpy(small, t.first, length);
+                    small[length] = '\0';
+                    str = small;
+                } else {
+                    large.assign(t.first, t.second);
+                    str = large.c_str();
+                }
+                char *end;
+                double value = std::strtod(str, &end);
+                hg_assert(end == str + length, "Invalid graph file: number expected.");
+                return value;
+            }
+        };
+
+        /**
+         * Creates an undirected graph from its edge list without adding the edges one by one: the out edge lists
+         * are allocated once with their final size. The edges and out edges are the same as the ones obtained by
+         * adding the edges in order with add_edge.
+         */
+        template<typename T1, typename T2>
+        ugraph make_ugraph(size_t num_vertices, const T1 &sources, const T2 &targets) {
+            size_t num_edges = sources.size();
+            std::vector<ugraph::edge_descriptor> edges;
+            edges.reserve(num_edges);
+            std::vector<index_t> offsets(num_vertices + 1, 0);
+            for (index_t i = 0; i < (index_t) num_edges; i++) {
+                index_t s = sources[i];
+                index_t t = targets[i];
+                if (s > t) {
+                    std::swap(s, t);
+                }
+                edges.emplace_back(s, t, i);
+                offsets[s + 1]++;
+                if (s != t) {
+                    offsets[t + 1]++;
+                }
+            }
+            for (size_t i = 0; i < num_vertices; i++) {
+                offsets[i + 1] += offsets[i];
+            }
+            std::vector<index_t> indices(offsets[num_vertices]);
+            std::vector<index_t> position(offsets.begin(), offsets.end() - 1);
+            for (index_t i = 0; i < (index_t) num_edges; i++) {
+                indices[position[edges[i].source]++] = i;
+                if (edges[i].source != edges[i].target) {
+                    indices[position[edges[i].target]++] = i;
+                }
+            }
+            return ugraph::from_edge_lists(num_vertices, edges.data(), num_edges, offsets, indices);
+        }
+
+        inline
+        bool is_binary_pink_graph(const char *data, size_t size) {
+            return size >= 8 && std::memcmp(data, HG_PINK_GRAPH_BINARY_MAGIC, 8) == 0;
         }
 
-        //useless line to announce vertex list
-        in >> discard >> discard;
+        inline
+        auto read_pink_graph_text(const char *data, size_t size) {
+            text_parser parser{data, data + size};
+            std::vector<std::size_t> shape;
+
+            // maybe shape
+            if (parser.peek() == '#') {
+                parser.skip_token();
+                std::size_t rs = parser.read_index();
+                parser.skip_token();
+                std::size_t cs = parser.read_index();
+                shape.push_back(cs);
+                shape.push_back(rs);
+            }
+
+            index_t num_points = parser.read_index();
+            index_t num_edges = parser.read_index();
 
-        // vertex list
-        ugraph g(num_points);
-        auto vertex_weight = array_1d<double>::from_shape({(size_t)num_points});
+            hg_assert(num_points > 0, "The number of vertices cannot be negative.");
+            hg_assert(num_edges > 0, "The number of edges cannot be negative.");
 
-        for (index_t l = 0; l < num_points; ++l) {
-            index_t i;
-            double d;
-            in >> i >> d;
-            hg_assert(0 <= i && i < num_points, "Invalid graph file: vertex index out of range.");
-            vertex_weight(i) = d;
+            if (shape.empty()) // construct valid shape
+            {
+                shape.push_back(num_points);
+            }
+
+            //useless line to announce vertex list
+            parser.skip_token();
+            parser.skip_token();
+
+            // vertex list
+            auto vertex_weight = array_1d<double>::from_shape({(size_t) num_points});
+
+            for (index_t l = 0; l < num_points; ++l) {
+                index_t i = parser.read_index();
+                double d = parser.read_double();
+                hg_assert(0 <= i && i < num_points, "Invalid graph file: vertex index out of range.");
+                vertex_weight(i) = d;
+            }
+
+            //useless line to announce edge list
+            parser.skip_token();
+            parser.skip_token();
+
+            auto sources = array_1d<index_t>::from_shape({(size_t) num_edges});
+            auto targets = array_1d<index_t>::from_shape({(size_t) num_edges});
+            auto edge_weight = array_1d<double>::from_shape({(size_t) num_edges});
+
+            for (index_t l = 0; l < num_edges; ++l) {
+                index_t i = parser.read_index();
+                index_t j = parser.read_index();
+                double d = parser.read_double();
+                hg_assert(0 <= i && 0 <= j && i < num_points && j < num_points,
+                          "Invalid graph file: vertex index out of range in edge definition.");
+                sources(l) = i;
+                targets(l) = j;
+                edge_weight(l) = d;
+            }
+
+            return pink_graph<>{make_ugraph(num_points, sources, targets), std::move(shape),
+                                std::move(vertex_weight), std::move(edge_weight)};
         }
 
-        //useless line to announce edge list
-        in >> discard >> discard;
+        inline
+        auto read_pink_graph_binary(const char *data, size_t size) {
+            hg_assert(size >= binary_header_size && is_binary_pink_graph(data, size), "Invalid binary graph file.");
+            uint64_t fields[6];
+            std::memcpy(fields, data + 8, sizeof(fields));
+            hg_assert(fields[0] == HG_PINK_GRAPH_BINARY_VERSION, "Unsupported binary graph file version.");
+            uint64_t num_points = fields[1];
+            uint64_t num_edges = fields[2];
+            uint64_t ndim = fields[3];
+            hg_assert(ndim <= 2, "Invalid binary graph file.");
+            hg_assert(size == binary_header_size + 8 * (num_points + 3 * num_edges),
+                      "Invalid binary graph file: unexpected file size.");
+
+            std::vector<std::size_t> shape(fields + 4, fields + 4 + ndim);
+            if (shape.empty()) {
+                shape.push_back(num_points);
+            }
+
+            const char *position = data + binary_header_size;
+            auto read_array = [&position](auto &array) {
+                using value_type = typename std::decay_t<decltype(array)>::value_type;
+                std::memcpy(array.data(), position, array.size() * sizeof(value_type));
+                position += array.size() * sizeof(value_type);
+            };
+
+            auto vertex_weight = array_1d<double>::from_shape({(size_t) num_points});
+            auto sources = array_1d<int64_t>::from_shape({(size_t) num_edges});
+            auto targets = array_1d<int64_t>::from_shape({(size_t) num_edges});
+            auto edge_weight = array_1d<double>::from_shape({(size_t) num_edges});
+            read_array(vertex_weight);
+            read_array(sources);
+            read_array(targets);
+            read_array(edge_weight);
+
+            for (index_t l = 0; l < (index_t) num_edges; ++l) {
+                hg_assert(0 <= sources(l) && 0 <= targets(l) &&
+                          sources(l) < (int64_t) num_points && targets(l) < (int64_t) num_points,
+                          "Invalid graph file: vertex index out of range in edge definition.");
+            }
 
-        auto edge_weight = array_1d<double>::from_shape({(size_t)num_edges});
+            return pink_graph<>{make_ugraph(num_points, sources, targets), std::move(shape),
+                                std::move(vertex_weight), std::move(edge_weight)};
+        }
 
-        for (index_t l = 0; l < num_edges; ++l) {
-            index_t i, j;
-            double d;
-            in >> i >> j >> d;
-            hg_assert(0 <= i && 0 <= j && i < num_points && j < num_points,
-                      "Invalid graph file: vertex index out of range in edge definition.");
-            g.add_edge(i, j);
-            edge_weight(l) = d;
+        inline
+        auto read_pink_graph(const char *data, size_t size) {
+            if (is_binary_pink_graph(data, size)) {
+                return read_pink_graph_binary(data, size);
+            }
+            return read_pink_graph_text(data, size);
         }
+    }
 
-        return pink_graph<>{std::move(g), std::move(shape), std::move(vertex_weight), std::move(edge_weight)};
+    /**
+     * Read a graph in the pink ascii format, or in the binary pink format (see save_pink_graph_binary), from an
+     * input stream.
+     *
+     * @param in input stream (opened in binary mode for the binary format)
+     * @return a pink_graph
+     */
+    inline
+    auto read_pink_graph(std::istream &in) {
+        HG_TRACE();
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return pink_graph_io_internal::read_pink_graph(content.data(), content.size());
     }
 
+    /**
+     * Read a graph in the pink ascii format, or in the binary pink format (see save_pink_graph_binary), from a
+     * file. The file is memory mapped and parsed in place.
+     *
+     * @param filename path to the graph file
+     * @return a pink_graph
+     */
     inline
     auto read_pink_graph(const std::string &filename) {
-        std::ifstream file(filename);
-        return read_pink_graph(file);
+        HG_TRACE();
+        mapped_file file(filename);
+        return pink_graph_io_internal::read_pink_graph(file.data(), file.size());
     };
 
-
     template<typename graph_t,
             typename T1,
             typename T2,
@@ -173,4 +400,85 @@ namespace hg {
         save_pink_graph(file, graph, xvertex_values, xedge_values, shape);
     };
 
+
+    /**
+     * Save a graph in the binary pink format: a fixed size header (magic number, version, number of vertices and
+     * edges, shape) followed by the vertex weights, the sources, the targets and the edge weights of the graph
+     * stored as arrays of double, int64, int64 and double (with the endianness of the machine).
+     *
+     * The binary format holds the same information as the pink ascii format (see save_pink_graph) but it is read
+     * and written in bulk: it is much faster and it is lossless. It is read by read_pink_graph.
+     *
+     * @param out output stream (opened in binary mode)
+     * @param graph graph
+     * @param xvertex_values vertex weights (if empty, all vertex weights are 1)
+     * @param xedge_values edge weights (if empty, all edge weights are 1)
+     * @param shape shape of the graph (at most 2 dimensions)
+     */
+    template<typename graph_t,
+            typename T1,
+            typename T2,
+            typename S>
+    void save_pink_graph_binary(std::ostream &out,
+                                const graph_t &graph,
+                                const xt::xexpression<T1> &xvertex_values,
+                                const xt::xexpression<T2> &xedge_values,
+                                const S &shape) {
+        HG_TRACE();
+        auto &vertex_values = xvertex_values.derived_cast();
+        auto &edge_values = xedge_values.derived_cast();
+
+        hg_assert(vertex_values.dimension() <= 1, "Too many dimensions for vertex values!");
+        hg_assert(edge_values.dimension() <= 1, "Too many dimensions for edge values!");
+        hg_assert(shape.size() <= 2, "Too many dimensions !");
+
+        auto write_array = [&out](const auto &array) {
+            using value_type = typename std::decay_t<decltype(array)>::value_type;
+            out.write(reinterpret_cast<const char *>(array.data()),
+                      std::streamsize(array.size() * sizeof(value_type)));
+        };
+
+        size_t nv = num_vertices(graph);
+        size_t ne = num_edges(graph);
+
+        char header[pink_graph_io_internal::binary_header_size] = {0};
+        uint64_t fields[6] = {HG_PINK_GRAPH_BINARY_VERSION, nv, ne, shape.size(), 0, 0};
+        for (size_t i = 0; i < shape.size(); i++) {
+            fields[4 + i] = shape[i];
+        }
+        std::memcpy(header, HG_PINK_GRAPH_BINARY_MAGIC, 8);
+        std::memcpy(header + 8, fields, sizeof(fields));
+        out.write(header, sizeof(header));
+
+        if (vertex_values.size() == 0) {
+            write_array(array_1d<double>(xt::ones<double>({nv})));
+        } else {
+            hg_assert_vertex_weights(graph, vertex_values);
+            write_array(array_1d<double>(xt::cast<double>(vertex_values)));
+        }
+
+        write_array(array_1d<int64_t>(xt::cast<int64_t>(sources(graph))));
+        write_array(array_1d<int64_t>(xt::cast<int64_t>(targets(graph))));
+
+        if (edge_values.size() == 0) {
+            write_array(array_1d<double>(xt::ones<double>({ne})));
+        } else {
+            hg_assert_edge_weights(graph, edge_values);
+            write_array(array_1d<double>(xt::cast<double>(edge_values)));
+        }
+    }
+
+    template<typename graph_t,
+            typename T1,
+            typename T2,
+            typename S>
+    void save_pink_graph_binary(const std::string &filename,
+                                const graph_t &graph,
+                                const xt::xexpression<T1> &xvertex_values,
+                                const xt::xexpression<T2> &xedge_values,
+                                const S &shape) {
+        std::ofstream file(filename, std::ios::binary);
+        save_pink_graph_binary(file, graph, xvertex_values, xedge_values, shape);
+    };
+
 }
@@ -9,14 +9,17 @@
 ****************************************************************************/
 
 /**
- * TODO: support max value > 255 (muti-byte components)
- * TODO: support P3 format (raw binary data)
+ * TODO: support P4 format (raw binary data)
  */
 #pragma once
 
 #include "../utils.hpp"
 #include "../structure/array.hpp"
+#include "mapped_file.hpp"
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <fstream>
@@ -25,50 +28,92 @@ namespace hg {
 
     namespace pnm_io_internal {
 
-        class tokenizer {
+        /**
+         * Header of a pnm file
+         */
+        struct pnm_header {
+            // format number (1 to 6, see read_image_pnm)
+            int format;
+            size_t width;
+            size_t height;
+            size_t bands;
+            size_t max_value;
+            // position of the first byte of pixel data in the file
+            size_t data_offset;
+
+            bool ascii() const {
+                return format <= 3;
+            }
+
+            size_t bytes_per_sample() const {
+                return max_value <= 255 ? 1 : 2;
+            }
+
+            size_t num_values() const {
+                return width * height * bands;
+            }
 
-        public:
-            inline
-            tokenizer(std::istream &in) : m_in(in), m_stream("") {
+            std::vector<size_t> shape() const {
+                std::vector<size_t> shape{height, width};
+                if (bands != 1) {
+                    shape.push_back(bands);
+                }
+                return shape;
+            }
+        };
+
+        /**
+         * Parser on the content of a pnm file: tokens are separated by white spaces, and comments start with '#'
+         * and end with the line.
+         */
+        struct pnm_parser {
+            const char *m_begin;
+            const char *m_pos;
+            const char *m_end;
 
+            static bool is_space(char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
             }
 
-            inline
-            std::string next_token() {
-                if (m_stream.eof()) {
-                    do {
-                        if (m_in.eof())
-                            return "";
-                        std::getline(m_in, m_current_line);
-                    } while (m_current_line.size() == 0 || m_current_line[0] == '#');
-                    m_stream.clear();
-                    m_stream.str(m_current_line);
+            void skip_comment() {
+                while (m_pos != m_end && *m_pos != '\n') {
+                    m_pos++;
                 }
-                std::string token;
-                m_stream >> token;
-                if (token == "") { // empty stream does not indicate eof on first read even if empty
-                    return next_token();
+                if (m_pos != m_end) {
+                    m_pos++;
+                }
+            }
+
+            void skip_spaces_and_comments() {
+                while (m_pos != m_end) {
+                    if (is_space(*m_pos)) {
+                        m_pos++;
+                    } else if (*m_pos == '#') {
+                        skip_comment();
+                    } else {
+                        break;
+                    }
                 }
-                return token;
             }
 
-        private:
-            std::istream &m_in;
-            std::string m_current_line;
-            std::stringstream m_stream;
+            size_t read_number(const char *error) {
+                skip_spaces_and_comments();
+                hg_assert(m_pos != m_end && *m_pos >= '0' && *m_pos <= '9', error);
+                size_t value = 0;
+                while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9') {
+                    value = value * 10 + (*m_pos - '0');
+                    m_pos++;
+                }
+                return value;
+            }
         };
 
+        /**
+         * Parses the header of the pnm file held in the given buffer.
+         */
         inline
-        array_nd<unsigned char> read_image_pnm(std::istream &in) {
-            std::string tmp;
-            bool ascii;
-            bool binary;
-            int max_value = 1;
-            size_t bands;
-            tokenizer tok(in);
-            tmp = tok.next_token();
-            hg_assert(tmp.size() == 2 && tmp[0] == 'P',
-                      "Incorrect file format (magic number).");
+        pnm_header read_pnm_header(const char *data, size_t size) {
+            hg_assert(size >= 2 && data[0] == 'P', "Incorrect file format (magic number).");
 
             /*
              * Type	Magic number	Extension	Colors
@@ -77,90 +122,84 @@ namespace hg {
              * Portable GrayMap[2]	P2	P5	.pgm	0–255 (gray scale)
              * Portable PixMap[3]	P3	P6	.ppm	0–255 (RGB)
              */
-            switch (tmp[1]) {
-                case '1':
-                    ascii = true;
-                    binary = true;
-                    bands = 1;
-                    break;
-                case '2':
-                    ascii = true;
-                    binary = false;
-                    bands = 1;
-                    break;
-                case '3':
-                    ascii = true;
-                    binary = false;
-                    bands = 3;
-                    break;
-                case '4':
-                    ascii = false;
-                    binary = true;
-                    bands = 1;
-                    break;
-                case '5':
-                    ascii = false;
-                    binary = false;
-                    bands = 1;
-                    break;
-                case '6':
-                    ascii = false;
-                    binary = false;
-                    bands = 3;
-                    break;
-                default:
-                    hg_assert(false, "Unknown file format (magic number): " + tmp);
-            }
-            tmp = tok.next_token();
-            hg_assert(tmp != "", "End of header reached too soon.");
-            size_t width = std::stoi(tmp);
-
-            tmp = tok.next_token();
-            hg_assert(tmp != "", "End of header reached too soon.");
-            size_t height = std::stoi(tmp);
-
-            if (!binary) {
-                tmp = tok.next_token();
-                hg_assert(tmp != "", "End of header reached too soon.");
-                max_value = std::stoi(tmp);
-            }
+            pnm_header header;
+            hg_assert(data[1] >= '1' && data[1] <= '6', "Unknown file format (magic number): " + std::string(data, 2));
+            hg_assert(size == 2 || pnm_parser::is_space(data[2]) || data[2] == '#',
+                      "Incorrect file format (magic number).");
+            header.format = data[1] - '0';
+            header.bands = (header.format == 3 || header.format == 6) ? 3 : 1;
 
-            hg_assert(width > 0 && height > 0, "Incorrect dimensions.");
+            pnm_parser parser{data, data + 2, data + size};
+            header.width = parser.read_number("End of header reached too soon.");
+            header.height = parser.read_number("End of header reached too soon.");
+            bool bitmap = header.format == 1 || header.format == 4;
+            header.max_value = bitmap ? 1 : parser.read_number("End of header reached too soon.");
 
-            hg_assert(max_value <= 255, "Multi-byte values not supported.");
+            hg_assert(header.width > 0 && header.height > 0, "Incorrect dimensions.");
+            hg_assert(header.max_value > 0 && header.max_value <= 65535, "Incorrect max value.");
 
-            index_t num_values = width * height * bands;
-            std::vector<size_t> shape{height, width};
-            if (bands != 1) {
-                shape.push_back(bands);
+            if (!header.ascii()) {
+                // a single white space separates the header from the data, comments may follow
+                hg_assert(parser.m_pos != parser.m_end && pnm_parser::is_space(*parser.m_pos),
+                          "End of header reached too soon.");
+                parser.m_pos++;
+                while (parser.m_pos != parser.m_end && *parser.m_pos == '#') {
+                    parser.skip_comment();
+                }
             }
-            array_nd<unsigned char> result = xt::empty<unsigned char>(shape);
-            auto r = xt::flatten(result);
-            if (ascii) {
-                for (index_t i = 0; i < num_values; i++) {
-                    tmp = tok.next_token();
-                    hg_assert(tmp != "", "End of data reached too soon.");
-                    r(i) = std::stoi(tmp);
+            header.data_offset = parser.m_pos - data;
+            return header;
+        }
+
+        /**
+         * Decodes the pixel data of the pnm file held in the given buffer.
+         *
+         * Values larger than 255 (max value > 255) require a value type T of at least 16 bits.
+         */
+        template<typename T>
+        array_nd<T> read_pnm_data(const pnm_header &header, const char *data, size_t size) {
+            hg_assert(header.max_value <= (size_t) std::numeric_limits<T>::max(),
+                      "Multi-byte values (max value > 255) require a value type of at least 16 bits.");
+            hg_assert(header.format != 4, "Binary raw data not supported.");
+
+            size_t num_values = header.num_values();
+            array_nd<T> result = xt::empty<T>(header.shape());
+            T *r = result.data();
+            if (header.ascii()) {
+                pnm_parser parser{data, data + header.data_offset, data + size};
+                for (size_t i = 0; i < num_values; i++) {
+                    size_t value = parser.read_number("End of data reached too soon.");
+                    hg_assert(value <= header.max_value, "Value larger than max value.");
+                    r[i] = (T) value;
                 }
             } else {
-                //consume remaining comments
-                while(in.peek() == '#'){
-                    std::string tmp;
-                    std::getline(in, tmp);
-                }
-                if (binary) {
-                    hg_assert(false, "Binary raw data not supported.");
+                size_t bytes = header.bytes_per_sample();
+                hg_assert(header.data_offset + num_values * bytes <= size, "End of data reached too soon.");
+                auto d = (const unsigned char *) data + header.data_offset;
+                if (bytes == 1) {
+                    std::copy(d, d + num_values, r);
                 } else {
-                    in.read((char*)result.data(), num_values);
+                    // 16 bits samples are stored most significant byte first
+                    for (size_t i = 0; i < num_values; i++) {
+                        r[i] = (T) ((d[2 * i] << 8) | d[2 * i + 1]);
+                    }
                 }
             }
             return result;
+        }
 
+        template<typename T = unsigned char>
+        array_nd<T> read_image_pnm(std::istream &in) {
+            std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            auto header = read_pnm_header(content.data(), content.size());
+            return read_pnm_data<T>(header, content.data(), content.size());
         }
 
         template<typename T>
         void save_image_pnm(std::ostream &out, const xt::xexpression<T> &ximage) {
-            static_assert(std::is_same<typename T::value_type, unsigned char>::value, "Can only save unsigned char values");
+            using value_type = typename T::value_type;
+            static_assert(std::is_same<value_type, unsigned char>::value || std::is_same<value_type, uint16_t>::value,
+                          "Can only save unsigned char or uint16 values");
             auto &image = ximage.derived_cast();
             hg_assert(image.dimension() == 2 || image.dimension() == 3, "Array must have 2 or 3 dimensions.");
             hg_assert(image.dimension() == 2 || image.shape()[2] == 3,
@@ -175,9 +214,20 @@ namespace hg {
             out << image.shape()[1] << " " << image.shape()[0] << std::endl;
 
             // max value
-            out << "255" << std::endl;
+            out << (size_t) std::numeric_limits<value_type>::max() << std::endl;
 
-            out.write((char*)image.data(), image.size());
+            if (sizeof(value_type) == 1) {
+                out.write((char *) image.data(), image.size());
+            } else {
+                // 16 bits samples are stored most significant byte first
+                std::vector<char> buffer(2 * image.size());
+                auto data = image.data();
+                for (size_t i = 0; i < image.size(); i++) {
+                    buffer[2 * i] = (char) (data[i] >> 8);
+                    buffer[2 * i + 1] = (char) (data[i] & 0xff);
+                }
+                out.write(buffer.data(), buffer.size());
+            }
         }
 
     }
@@ -186,24 +236,99 @@ namespace hg {
      * Read the given pnm image (pbm, pgm or ppm formats).
      * Current the following pnm specification are supported
      * P1 binary ascii: supported
-     * P2 byte ascii: supported (max value <= 255)
-     * P3 RGB ascii: supported (max value <= 255)
+     * P2 byte ascii: supported
+     * P3 RGB ascii: supported
      * P4 binary raw: NOT supported
-     * P5 byte raw: supported (max value <= 255)
-     * P6 RGB rax: supported (max value <= 255)
+     * P5 byte raw: supported
+     * P6 RGB rax: supported
+     *
+     * Images with a max value larger than 255 (2 bytes per sample) must be read with a value type T of at least 16
+     * bits (e.g. read_image_pnm<uint16_t>(filename)).
      *
+     * The file is memory mapped and decoded in place (see also map_image_pnm to use the pixel data without copy).
+     *
+     * @tparam T value type of the result
      * @param filename Path to the file to read
      * @return an array with pixel data
      */
+    template<typename T = unsigned char>
+    array_nd<T> read_image_pnm(const char *filename) {
+        mapped_file file(filename);
+        auto header = pnm_io_internal::read_pnm_header(file.data(), file.size());
+        return pnm_io_internal::read_pnm_data<T>(header, file.data(), file.size());
+    }
+
+    /**
+     * A pnm image file memory mapped in read-only mode (see map_image_pnm).
+     */
+    class mapped_pnm_image {
+    public:
+
+        explicit mapped_pnm_image(const char *filename) :
+                m_file(std::make_shared<mapped_file>(filename)),
+                m_header(pnm_io_internal::read_pnm_header(m_file->data(), m_file->size())) {
+        }
+
+        /**
+         * Shape of the image: (height, width) or (height, width, 3) for ppm images
+         */
+        std::vector<size_t> shape() const {
+            return m_header.shape();
+        }
+
+        size_t max_value() const {
+            return m_header.max_value;
+        }
+
+        /**
+         * True if the pixel data can be viewed in place (raw format with 1 byte per sample: P5 or P6 with a max
+         * value smaller than 256)
+         */
+        bool has_view() const {
+            return (m_header.format == 5 || m_header.format == 6) && m_header.bytes_per_sample() == 1;
+        }
+
+        /**
+         * Read-only view on the pixel data in the mapped file (see has_view). The view is valid as long as this
+         * object is alive.
+         */
+        auto view() const {
+            hg_assert(has_view(), "The pixel data of this image cannot be viewed in place.");
+            size_t size = m_header.num_values();
+            hg_assert(m_header.data_offset + size <= m_file->size(), "End of data reached too soon.");
+            return xt::adapt((const unsigned char *) m_file->data() + m_header.data_offset, size,
+                             xt::no_ownership(), shape());
+        }
+
+        /**
+         * Copy of the pixel data decoded in an array of the given value type (any pnm format supported by
+         * read_image_pnm).
+         */
+        template<typename T = unsigned char>
+        array_nd<T> to_array() const {
+            return pnm_io_internal::read_pnm_data<T>(m_header, m_file->data(), m_file->size());
+        }
+
+    private:
+        std::shared_ptr<mapped_file> m_file;
+        pnm_io_internal::pnm_header m_header;
+    };
+
+    /**
+     * Memory map the given pnm image: the header is parsed in the mapped file and, for P5 and P6 images with 1 byte
+     * per sample, the pixel data can be used without any copy through mapped_pnm_image::view.
+     *
+     * @param filename Path to the file to read
+     * @return a mapped_pnm_image
+     */
     inline
-    array_nd<unsigned char> read_image_pnm(const char *filename) {
-        std::ifstream s(filename);
-        return pnm_io_internal::read_image_pnm(s);
+    mapped_pnm_image map_image_pnm(const char *filename) {
+        return mapped_pnm_image(filename);
     }
 
     /**
      * Save an array as a pnm file (pgm or ppm).
-     * The array value_type MUST be unsigned char.
+     * The array value_type MUST be unsigned char or uint16_t (saved with a max value of 65535).
      * If the array has 2 dimensions it is saved as a pgm raw file (format P5).
      * If the array has 3 dimensions, the size of the third dimension must be 3
      * and it is saved as a ppm raw file (format P6).
@@ -216,7 +341,7 @@ namespace hg {
      */
     template<typename T>
     void save_image_pnm(const char *filename, const xt::xexpression<T> &ximage) {
-        std::ofstream s(filename);
+        std::ofstream s(filename, std::ios::binary);
         return pnm_io_internal::save_image_pnm(s, ximage);
     }
 }
\ No newline at end of file
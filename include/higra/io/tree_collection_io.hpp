@@ -0,0 +1,428 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "graph_io.hpp"
+#include "tree_io.hpp"
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hg {
+
+#define HG_TREE_COLLECTION_IO_MAGIC "HGTRECOL"
+#define HG_TREE_COLLECTION_IO_VERSION 1
+
+    namespace tree_collection_io_internal {
+
+        // sections are aligned on 64 bytes such that the arrays of the embedded graph and tree files remain aligned
+        // when the collection is memory mapped
+        const uint64_t alignment = 64;
+        const uint64_t header_size = 64;
+        // maximal size of a tree name in bytes
+        const uint64_t max_name_size = 1 << 16;
+
+        enum section_kind : uint64_t {
+            leaf_graph_section = 0,
+            tree_section = 1
+        };
+
+        /**
+         * Entry of the table of contents of a tree collection file: an embedded graph file or v2 tree file.
+         */
+        struct section {
+            uint64_t kind;
+            std::string name;
+            // position of the section relative to the beginning of the collection
+            uint64_t offset;
+            // size of the section in bytes
+            uint64_t size;
+        };
+
+        inline
+        uint64_t padding(uint64_t position) {
+            return (alignment - position % alignment) % alignment;
+        }
+
+        /**
+         * Writer of the tree collection format (see save_tree_collection).
+         */
+        struct tree_collection_writer {
+
+            explicit tree_collection_writer(std::ostream &out) : m_out(out) {
+                m_start = m_out.tellp();
+                const char header[header_size] = {0};
+                write(header, header_size);
+            }
+
+            tree_collection_writer(tree_collection_writer &&other) :
+                    m_out(other.m_out),
+                    m_start(other.m_start),
+                    m_position(other.m_position),
+                    m_sections(std::move(other.m_sections)),
+                    m_graph_writer(std::move(other.m_graph_writer)),
+                    m_tree_writer(std::move(other.m_tree_writer)),
+                    m_num_leaves(other.m_num_leaves),
+                    m_finalized(other.m_finalized) {
+                other.m_finalized = true;
+            }
+
+            ~tree_collection_writer() {
+                finalize();
+            }
+
+            /**
+             * Stores the leaf graph shared by the trees of the collection (see save_graph). Vertex and edge
+             * attributes, and the shape of an undirected grid graph, can be added to the returned writer until the
+             * next call to add_tree or finalize.
+             */
+            template<typename graph_t>
+            graph_io_internal::graph_writer &set_leaf_graph(const graph_t &graph) {
+                hg_assert(!m_finalized, "The tree collection has already been finalized.");
+                for (const auto &s: m_sections) {
+                    hg_assert(s.kind != leaf_graph_section, "The leaf graph of the collection has already been set.");
+                }
+                hg_assert(m_num_leaves < 0 || m_num_leaves == (index_t) num_vertices(graph),
+                          "The number of vertices of the leaf graph does not match the number of leaves of the trees.");
+                begin_section(leaf_graph_section, "");
+                m_graph_writer.reset(new graph_io_internal::graph_writer(save_graph(m_out, graph)));
+                m_num_leaves = num_vertices(graph);
+                return *m_graph_writer;
+            }
+
+            /**
+             * Stores a tree with the given name in the v2 tree format (see save_tree). Attributes can be added to the
+             * returned writer until the next call to add_tree, set_leaf_graph or finalize: the tree must remain alive
+             * until then.
+             */
+            tree_io_internal::tree_writer &add_tree(const std::string &name, const tree &t,
+                                                    tree_io_codec codec = tree_io_codec::none) {
+                hg_assert(!m_finalized, "The tree collection has already been finalized.");
+                hg_assert(name.size() <= max_name_size, "Tree name is too long: " + name.substr(0, 64) + "...");
+                for (const auto &s: m_sections) {
+                    hg_assert(s.kind != tree_section || s.name != name, "Duplicated tree name: " + name);
+                }
+                hg_assert(m_num_leaves < 0 || m_num_leaves == (index_t) num_leaves(t),
+                          "The number of leaves of the tree does not match the other elements of the collection: " +
+                          name);
+                begin_section(tree_section, name);
+                m_tree_writer.reset(new tree_io_internal::tree_writer(m_out, t, codec));
+                m_num_leaves = num_leaves(t);
+                return *m_tree_writer;
+            }
+
+            /**
+             * Writes the table of contents and the header.
+             */
+            void finalize() {
+                if (m_finalized) {
+                    return;
+                }
+                end_section();
+                m_finalized = true;
+                write_padding();
+                uint64_t toc_offset = m_position;
+                for (const auto &s: m_sections) {
+                    uint64_t fields[] = {s.kind, s.offset, s.size, s.name.size()};
+                    write(reinterpret_cast<const char *>(fields), sizeof(fields));
+                    write(s.name.data(), s.name.size());
+                }
+                uint64_t end = m_position;
+
+                char header[header_size] = {0};
+                uint64_t fields[] = {HG_TREE_COLLECTION_IO_VERSION,
+                                     m_sections.size(),
+                                     toc_offset,
+                                     end - toc_offset};
+                std::memcpy(header, HG_TREE_COLLECTION_IO_MAGIC, 8);
+                std::memcpy(header + 8, fields, sizeof(fields));
+                m_out.seekp(m_start);
+                m_out.write(header, header_size);
+                m_out.seekp(m_start + std::streamoff(end));
+            }
+
+        private:
+
+            void write(const char *data, uint64_t size) {
+                m_out.write(data, std::streamsize(size));
+                m_position += size;
+            }
+
+            void write_padding() {
+                const char zeros[alignment] = {0};
+                write(zeros, padding(m_position));
+            }
+
+            void begin_section(uint64_t kind, const std::string &name) {
+                end_section();
+                write_padding();
+                m_sections.push_back({kind, name, m_position, 0});
+            }
+
+            // finalizes the embedded file of the current section, which may have moved the stream position
+            void end_section() {
+                if (m_graph_writer) {
+                    m_graph_writer->finalize();
+                    m_graph_writer.reset();
+                }
+                if (m_tree_writer) {
+                    m_tree_writer->finalize();
+                    m_tree_writer.reset();
+                }
+                if (!m_sections.empty() && m_sections.back().size == 0) {
+                    m_position = (uint64_t) (m_out.tellp() - m_start);
+                    m_sections.back().size = m_position - m_sections.back().offset;
+                }
+            }
+
+            std::ostream &m_out;
+            std::streamoff m_start;
+            uint64_t m_position = 0;
+            std::vector<section> m_sections;
+            std::unique_ptr<graph_io_internal::graph_writer> m_graph_writer;
+            std::unique_ptr<tree_io_internal::tree_writer> m_tree_writer;
+            index_t m_num_leaves = -1;
+            bool m_finalized = false;
+        };
+    }
+
+    /**
+     * Random access reader of a tree collection file (see save_tree_collection).
+     *
+     * Only the header and the table of contents are read at construction: the leaf graph and each tree are then read
+     * on demand with the graph_file_reader and tree_file_reader returned by leaf_graph_reader and tree_reader. With a
+     * buffer reader, typically on a memory mapped file (see map_tree_collection), these readers work in place in the
+     * buffer and only the pages of the requested trees are loaded. The readers returned by a stream reader share its
+     * stream and must not be used concurrently.
+     */
+    class tree_collection_reader {
+    public:
+
+        /**
+         * Reader on a seekable input stream (opened in binary mode) positioned at the beginning of a tree collection
+         * file.
+         */
+        explicit tree_collection_reader(std::istream &in) : m_in(&in) {
+            m_start = in.tellg();
+            read_header();
+        }
+
+        /**
+         * Reader on a memory buffer holding the content of a tree collection file. The buffer must not be modified
+         * during the lifetime of the reader and of the graphs and trees read in place. The owner object is kept
+         * alive as long as the buffer is used.
+         *
+         * @param buffer pointer to the file content
+         * @param size size of the buffer in bytes
+         * @param owner object owning the buffer (can be nullptr if the buffer outlives the reader and the trees)
+         */
+        tree_collection_reader(const char *buffer, size_t size, std::shared_ptr<const void> owner) :
+                m_in_memory(true), m_buffer(buffer), m_size(size), m_owner(std::move(owner)) {
+            hg_assert(size >= tree_collection_io_internal::header_size, "Invalid tree collection file.");
+            read_header();
+        }
+
+        /**
+         * Number of trees in the collection.
+         */
+        size_t num_trees() const {
+            return m_tree_sections.size();
+        }
+
+        /**
+         * Names of the trees, in storage order.
+         */
+        std::vector<std::string> tree_names() const {
+            std::vector<std::string> names;
+            for (auto i: m_tree_sections) {
+                names.push_back(m_sections[i].name);
+            }
+            return names;
+        }
+
+        bool has_tree(const std::string &name) const {
+            return find_tree(name) >= 0;
+        }
+
+        bool has_leaf_graph() const {
+            return m_leaf_graph_section >= 0;
+        }
+
+        /**
+         * Reader of the leaf graph of the collection.
+         */
+        graph_file_reader leaf_graph_reader() {
+            hg_assert(has_leaf_graph(), "The tree collection has no leaf graph.");
+            const auto &s = m_sections[m_leaf_graph_section];
+            if (m_in_memory) {
+                return graph_file_reader(m_buffer + s.offset, s.size, m_owner);
+            }
+            seek(s.offset);
+            return graph_file_reader(*m_in);
+        }
+
+        /**
+         * Reader of the i-th tree of the collection.
+         */
+        tree_file_reader tree_reader(index_t i) {
+            hg_assert(i >= 0 && i < (index_t) num_trees(), "Tree index out of bounds.");
+            const auto &s = m_sections[m_tree_sections[i]];
+            if (m_in_memory) {
+                return tree_file_reader(m_buffer + s.offset, s.size, m_owner);
+            }
+            seek(s.offset);
+            return tree_file_reader(*m_in);
+        }
+
+        /**
+         * Reader of the tree with the given name.
+         */
+        tree_file_reader tree_reader(const std::string &name) {
+            auto i = find_tree(name);
+            hg_assert(i >= 0, "Unknown tree in tree collection: " + name);
+            return tree_reader(i);
+        }
+
+        /**
+         * Sections of the collection (leaf graph and trees) in storage order: each section is a complete graph file
+         * or v2 tree file located at the given offset relative to the beginning of the collection.
+         */
+        const std::vector<tree_collection_io_internal::section> &sections() const {
+            return m_sections;
+        }
+
+        /**
+         * Object owning the buffer of a buffer reader.
+         */
+        const std::shared_ptr<const void> &owner() const {
+            return m_owner;
+        }
+
+    private:
+
+        void seek(uint64_t offset) {
+            m_in->clear();
+            m_in->seekg(m_start + std::streamoff(offset));
+        }
+
+        void read(uint64_t offset, char *data, uint64_t size) {
+            if (m_in_memory) {
+                hg_assert(tree_io_internal::in_bounds(offset, size, m_size), "Unexpected end of tree collection buffer.");
+                std::memcpy(data, m_buffer + offset, size);
+            } else {
+                seek(offset);
+                m_in->read(data, std::streamsize(size));
+                hg_assert(m_in->gcount() == (std::streamsize) size, "Unexpected end of tree collection file.");
+            }
+        }
+
+        uint64_t read_scalar(uint64_t &position) {
+            uint64_t value;
+            read(position, reinterpret_cast<char *>(&value), sizeof(value));
+            position += sizeof(value);
+            return value;
+        }
+
+        void read_header() {
+            using namespace tree_collection_io_internal;
+            char header[header_size];
+            read(0, header, header_size);
+            hg_assert(std::memcmp(header, HG_TREE_COLLECTION_IO_MAGIC, 8) == 0, "Invalid tree collection file.");
+            uint64_t fields[4];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(fields[0] == HG_TREE_COLLECTION_IO_VERSION, "Unsupported tree collection file version.");
+            uint64_t num_sections = fields[1];
+            uint64_t position = fields[2];
+
+            for (uint64_t i = 0; i < num_sections; i++) {
+                section s;
+                s.kind = read_scalar(position);
+                s.offset = read_scalar(position);
+                s.size = read_scalar(position);
+                uint64_t name_size = read_scalar(position);
+                hg_assert(name_size <= max_name_size, "Invalid tree name in tree collection file.");
+                s.name.resize(name_size);
+                read(position, &s.name[0], name_size);
+                position += name_size;
+                hg_assert(tree_io_internal::in_bounds(s.offset, s.size, fields[2]),
+                          "Invalid section in tree collection file.");
+                if (s.kind == leaf_graph_section) {
+                    hg_assert(m_leaf_graph_section < 0, "Duplicated leaf graph in tree collection file.");
+                    m_leaf_graph_section = m_sections.size();
+                } else {
+                    hg_assert(s.kind == tree_section, "Unknown section in tree collection file.");
+                    m_tree_sections.push_back(m_sections.size());
+                }
+                m_sections.push_back(std::move(s));
+            }
+        }
+
+        index_t find_tree(const std::string &name) const {
+            for (index_t i = 0; i < (index_t) m_tree_sections.size(); i++) {
+                if (m_sections[m_tree_sections[i]].name == name) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        // true for a buffer reader, false for a stream reader
+        bool m_in_memory = false;
+        std::istream *m_in = nullptr;
+        std::streamoff m_start = 0;
+        const char *m_buffer = nullptr;
+        size_t m_size = 0;
+        std::shared_ptr<const void> m_owner;
+        std::vector<tree_collection_io_internal::section> m_sections;
+        std::vector<index_t> m_tree_sections;
+        index_t m_leaf_graph_section = -1;
+    };
+
+    /**
+     * Memory map a tree collection file (see save_tree_collection) and return a reader on the mapped file: the trees
+     * and the graph read with the readers returned by tree_reader and leaf_graph_reader then directly use the mapped
+     * file when their arrays are not compressed, and only the pages of the accessed trees are loaded.
+     *
+     * @param filename path to the tree collection file
+     * @return a tree_collection_reader
+     */
+    inline
+    tree_collection_reader map_tree_collection(const std::string &filename) {
+        auto file = std::make_shared<mapped_file>(filename);
+        auto data = file->data();
+        auto size = file->size();
+        return tree_collection_reader(data, size, std::move(file));
+    }
+
+    /**
+     * Save several hierarchies of the same data, for example the trees of the channels of an image or several
+     * watershed hierarchies, in a single tree collection file: the leaf graph shared by the trees is stored once with
+     * set_leaf_graph(graph) and the trees are added with add_tree(name, tree[, codec]) on the returned writer. Both
+     * functions return the writer of the embedded graph file or tree file, on which attributes can be added (see
+     * save_graph and save_tree) until the next section is started or the collection is finalized (finalize is also
+     * called by the destructor of the writer).
+     *
+     * The file starts with a fixed size header followed by the sections (a graph file for the leaf graph and a v2 tree
+     * file for each tree) aligned on 64 bytes, and ends with a table of contents giving the kind, name and location of
+     * each section: a single tree can then be read without reading the rest of the collection, or used in place in a
+     * memory mapped file (see tree_collection_reader and map_tree_collection).
+     *
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @return a writer
+     */
+    inline
+    auto save_tree_collection(std::ostream &out) {
+        return tree_collection_io_internal::tree_collection_writer(out);
+    }
+}
@@ -11,11 +11,24 @@
 #pragma once
 
 #include "../graph.hpp"
+#include "../structure/lca_fast.hpp"
+#include "../structure/succinct_tree.hpp"
+#include "mapped_file.hpp"
 #include "xtensor/xexpression.hpp"
+#include <cstring>
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <map>
 
+#ifdef HG_USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HG_USE_ZSTD
+#include <zstd.h>
+#endif
+
 namespace hg {
 
 #define HG_TREE_IO_VERSION "1"
@@ -26,9 +39,61 @@ namespace hg {
 #define HG_TREE_IO_HEADEREND_KEY "END"
 #define HG_TREE_IO_NAME_KEY "NAME"
 
+#define HG_TREE_IO_V2_MAGIC "HGTREEV2"
+#define HG_TREE_IO_V2_VERSION 2
+
+#define HG_LCA_IO_MAGIC "HGLCAIDX"
+#define HG_LCA_IO_VERSION 2
+
+#define HG_SUCCINCT_TREE_IO_MAGIC "HGSUCTRE"
+#define HG_SUCCINCT_TREE_IO_VERSION 1
+
     //bool saveBPT(char * path, int nbnodes, int * parents, int numAttr, double ** attrs, char ** attrNames);
     //bool readBPT(char * path, int * nbnodes, int ** parents, int * numAttr, double *** attrs, char *** attrNames);
 
+    /**
+     * Compression codec of the arrays of a tree file (see save_tree).
+     *
+     * LZ4 and zstd are optional dependencies: they are only available if Higra is compiled with HG_USE_LZ4 and
+     * HG_USE_ZSTD respectively.
+     */
+    enum class tree_io_codec : uint64_t {
+        none = 0,
+        lz4 = 1,
+        zstd = 2
+    };
+
+    /**
+     * Element type of an array stored in a tree file: a kind, as in numpy ('b' boolean, 'i' signed integer,
+     * 'u' unsigned integer, 'f' floating point), and a size in bytes.
+     */
+    struct tree_io_dtype {
+        char kind;
+        uint64_t size;
+
+        bool operator==(const tree_io_dtype &other) const {
+            return kind == other.kind && size == other.size;
+        }
+
+        bool operator!=(const tree_io_dtype &other) const {
+            return !(*this == other);
+        }
+
+        /**
+         * Numpy name of the type, for example "i8" or "f4".
+         */
+        std::string str() const {
+            return kind + std::to_string(size);
+        }
+
+        template<typename T>
+        static tree_io_dtype of() {
+            static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be stored in tree files.");
+            char kind = std::is_same<T, bool>::value ? 'b' :
+                        (std::is_floating_point<T>::value ? 'f' : (std::is_signed<T>::value ? 'i' : 'u'));
+            return {kind, sizeof(T)};
+        }
+    };
 
     namespace tree_io_internal {
 
@@ -51,16 +116,22 @@ namespace hg {
                 hg_assert(array.dimension() == 1, "Only scalar attributes are supported.");
                 hg_assert(array.size() == m_tree.num_vertices(), "Attribute size does not match the size of the tree.");
 
-                // force conversion to double
-                // TODO avoid copy when not needed
-                xt::xarray<double> a = array;
-
                 m_num_attr++;
 
                 m_out << HG_TREE_IO_NAME_KEY << "=" << name << std::endl;
                 m_out << HG_TREE_IO_HEADEREND_KEY << std::endl;
 
-                m_out.write(reinterpret_cast<const char *>(a.data()), std::streamsize(array.size() * sizeof(double)));
+                // values are converted to double by chunks: no copy of the whole array
+                double buffer[1024];
+                size_t n = 0;
+                for (auto v: array) {
+                    buffer[n++] = (double) v;
+                    if (n == 1024) {
+                        m_out.write(reinterpret_cast<const char *>(buffer), std::streamsize(n * sizeof(double)));
+                        n = 0;
+                    }
+                }
+                m_out.write(reinterpret_cast<const char *>(buffer), std::streamsize(n * sizeof(double)));
 
                 return *this;
             }
@@ -100,96 +171,1233 @@ namespace hg {
             bool finalized = false;
         };
 
+        inline
+        auto
+        read_tree_v1(std::istream &in) {
+            std::string key = "";
+            char dummy;
+            std::string tmp;
+
+            int num_vertices = -1;
+            int num_attributes = -1;
+
+            while (key != HG_TREE_IO_HEADEREND_KEY) {
+                int value;
+                in >> tmp;
+                std::size_t pos = tmp.find('=');
+                if (pos != std::string::npos) {
+                    key = tmp.substr(0, pos);
+                    value = std::stoi(tmp.substr(pos + 1));
+                } else {
+                    key = tmp;
+                }
+
+                if (key == HG_TREE_IO_VERSION_KEY) {
+
+                } else if (key == HG_TREE_IO_NBNODES_KEY) {
+                    num_vertices = value;
+                } else if (key == HG_TREE_IO_NBATTRIBUTES_KEY) {
+                    num_attributes = value;
+                } else if (key == HG_TREE_IO_HEADEREND_KEY) {
+
+                } else {
+                    HG_LOG_WARNING("Key '%s' is unknown and will be ignored.", key.c_str());
+                }
+
+            }
+
+            hg_assert(num_vertices > 0, "Incorrect or missing key "
+                    HG_TREE_IO_NBNODES_KEY);
+            hg_assert(num_attributes >= 0, "Incorrect or missing key "
+                    HG_TREE_IO_NBATTRIBUTES_KEY);
+
+            in.read(&dummy, 1); // consumme the last \n left by cin...
+
+            array_1d<int> parents;
+            parents.resize({std::size_t(num_vertices)});
+            in.read(reinterpret_cast<char *>(parents.data()), std::streamsize(num_vertices * sizeof(int)));
+
+            std::map<std::string, array_1d<double>> attributes;
+
+            for (int i = 0; i < num_attributes; i++) {
+                std::string name = "";
+                key = "";
+                while (key != HG_TREE_IO_HEADEREND_KEY) {
+                    in >> tmp;
+                    std::size_t pos = tmp.find('=');
+                    std::string value;
+                    if (pos != std::string::npos) {
+                        key = tmp.substr(0, pos);
+                        value = tmp.substr(pos + 1);
+                    } else {
+                        key = tmp;
+                    }
+
+                    if (key == HG_TREE_IO_NAME_KEY) {
+                        name = value;
+                    } else if (key == HG_TREE_IO_HEADEREND_KEY) {
+
+                    } else {
+                        HG_LOG_WARNING("Key '%s' is unknown and will be ignored.", key.c_str());
+                    }
+                }
+                hg_assert(name != "", "Incorrect or missing key for attribute " + std::to_string(i) + " " +
+                                      HG_TREE_IO_NAME_KEY);
+                in.read(&dummy, 1); // consumme the last \n left by cin...
+
+                attributes.emplace(name, array_1d<double>::from_shape({std::size_t(num_vertices)}));
+                in.read(reinterpret_cast<char *>(attributes[name].data()),
+                        std::streamsize(num_vertices * sizeof(double)));
+            }
+
+            return std::make_pair(tree(parents), std::move(attributes));
+        }
+
+        // arrays are aligned on 64 bytes in v2 tree files, such that they can be used in place when the file is memory
+        // mapped
+        const uint64_t v2_alignment = 64;
+        const uint64_t v2_header_size = 64;
+        // uncompressed size of the compression blocks
+        const uint64_t v2_block_size = 1 << 20;
+        // maximal size of an attribute name in bytes
+        const uint64_t v2_max_name_size = 1 << 16;
+
+        enum v2_entry_kind : uint64_t {
+            parents_entry = 0,
+            attribute_entry = 1
+        };
+
+        /**
+         * Entry of the table of contents of a v2 tree file.
+         */
+        struct v2_entry {
+            uint64_t kind;
+            std::string name;
+            tree_io_dtype dtype;
+            tree_io_codec codec;
+            // position of the data relative to the beginning of the file
+            uint64_t offset;
+            // size of the data in the file in bytes
+            uint64_t stored_size;
+            uint64_t num_elements;
+            // uncompressed size of the compression blocks (0 if the data is not compressed)
+            uint64_t block_size;
+        };
+
+        inline
+        uint64_t v2_padding(uint64_t position) {
+            return (v2_alignment - position % v2_alignment) % v2_alignment;
+        }
+
+        inline
+        uint64_t dtype_code(const tree_io_dtype &dtype) {
+            return (uint64_t) (unsigned char) dtype.kind | (dtype.size << 8);
+        }
+
+        inline
+        tree_io_dtype dtype_from_code(uint64_t code) {
+            return {(char) (code & 0xff), code >> 8};
+        }
+
+        /**
+         * True if the range [offset, offset + size[ lies in a buffer of buffer_size bytes (written such that the
+         * test cannot overflow).
+         */
+        inline
+        bool in_bounds(uint64_t offset, uint64_t size, uint64_t buffer_size) {
+            return offset <= buffer_size && size <= buffer_size - offset;
+        }
+
+        /**
+         * Size in bytes of an array of num_elements elements of element_size bytes: throws if it overflows.
+         */
+        inline
+        uint64_t array_size(uint64_t num_elements, uint64_t element_size) {
+            hg_assert(element_size == 0 || num_elements <= std::numeric_limits<uint64_t>::max() / element_size,
+                      "Invalid array size in tree file.");
+            return num_elements * element_size;
+        }
+
+        /**
+         * Calls fun(T()) where T is the C++ type of the given stored type.
+         */
+        template<typename F>
+        auto dispatch_dtype(const tree_io_dtype &dtype, F &&fun) {
+            switch (dtype.kind) {
+                case 'b':
+                    if (dtype.size == 1) return fun(bool());
+                    break;
+                case 'i':
+                    switch (dtype.size) {
+                        case 1:
+                            return fun(int8_t());
+                        case 2:
+                            return fun(int16_t());
+                        case 4:
+                            return fun(int32_t());
+                        case 8:
+                            return fun(int64_t());
+                    }
+                    break;
+                case 'u':
+                    switch (dtype.size) {
+                        case 1:
+                            return fun(uint8_t());
+                        case 2:
+                            return fun(uint16_t());
+                        case 4:
+                            return fun(uint32_t());
+                        case 8:
+                            return fun(uint64_t());
+                    }
+                    break;
+                case 'f':
+                    switch (dtype.size) {
+                        case 4:
+                            return fun(float());
+                        case 8:
+                            return fun(double());
+                    }
+                    break;
+            }
+            throw std::runtime_error("Unsupported data type '" + dtype.str() + "' in tree file.");
+        }
+
+        inline
+        void check_codec(tree_io_codec codec) {
+            switch (codec) {
+                case tree_io_codec::none:
+                    return;
+                case tree_io_codec::lz4:
+#ifdef HG_USE_LZ4
+                    return;
+#else
+                    throw std::runtime_error("LZ4 compression is not available: Higra was compiled without HG_USE_LZ4.");
+#endif
+                case tree_io_codec::zstd:
+#ifdef HG_USE_ZSTD
+                    return;
+#else
+                    throw std::runtime_error("zstd compression is not available: Higra was compiled without HG_USE_ZSTD.");
+#endif
+            }
+            throw std::runtime_error("Unknown compression codec in tree file.");
+        }
+
+        /**
+         * Compresses a block: returns the size of the compressed data written in dst.
+         */
+        inline
+        uint64_t compress_block(tree_io_codec codec, const char *src, uint64_t size, std::vector<char> &dst) {
+            switch (codec) {
+#ifdef HG_USE_LZ4
+                case tree_io_codec::lz4: {
+                    dst.resize((size_t) LZ4_compressBound((int) size));
+                    int res = LZ4_compress_default(src, dst.data(), (int) size, (int) dst.size());
+                    hg_assert(res > 0, "LZ4 compression failed.");
+                    return (uint64_t) res;
+                }
+#endif
+#ifdef HG_USE_ZSTD
+                case tree_io_codec::zstd: {
+                    dst.resize(ZSTD_compressBound((size_t) size));
+                    size_t res = ZSTD_compress(dst.data(), dst.size(), src, (size_t) size, ZSTD_CLEVEL_DEFAULT);
+                    hg_assert(!ZSTD_isError(res), "zstd compression failed.");
+                    return (uint64_t) res;
+                }
+#endif
+                default:
+                    check_codec(codec);
+                    throw std::runtime_error("Invalid compression codec.");
+            }
+        }
+
+        inline
+        void decompress_block(tree_io_codec codec, const char *src, uint64_t size, char *dst, uint64_t raw_size) {
+            switch (codec) {
+#ifdef HG_USE_LZ4
+                case tree_io_codec::lz4: {
+                    int res = LZ4_decompress_safe(src, dst, (int) size, (int) raw_size);
+                    hg_assert(res == (int) raw_size, "Corrupted LZ4 block in tree file.");
+                    return;
+                }
+#endif
+#ifdef HG_USE_ZSTD
+                case tree_io_codec::zstd: {
+                    size_t res = ZSTD_decompress(dst, (size_t) raw_size, src, (size_t) size);
+                    hg_assert(!ZSTD_isError(res) && res == raw_size, "Corrupted zstd block in tree file.");
+                    return;
+                }
+#endif
+                default:
+                    check_codec(codec);
+                    throw std::runtime_error("Invalid compression codec.");
+            }
+        }
+
+        /**
+         * Compressed array layout: the compressed size of each block (uint64) followed by the compressed blocks.
+         * The blocks are compressed in parallel.
+         */
+        inline
+        std::vector<char> compress_array(tree_io_codec codec, const char *data, uint64_t size, uint64_t block_size) {
+            const index_t num_blocks = (index_t) ((size + block_size - 1) / block_size);
+            std::vector<std::vector<char>> blocks(num_blocks);
+            std::vector<uint64_t> block_sizes(num_blocks);
+            parfor(0, num_blocks, [&](index_t b) {
+                uint64_t start = b * block_size;
+                block_sizes[b] = compress_block(codec, data + start, (std::min)(block_size, size - start), blocks[b]);
+            });
+            uint64_t total = num_blocks * sizeof(uint64_t);
+            for (auto s: block_sizes) {
+                total += s;
+            }
+            std::vector<char> res(total);
+            std::memcpy(res.data(), block_sizes.data(), num_blocks * sizeof(uint64_t));
+            uint64_t position = num_blocks * sizeof(uint64_t);
+            for (index_t b = 0; b < num_blocks; b++) {
+                std::memcpy(res.data() + position, blocks[b].data(), block_sizes[b]);
+                position += block_sizes[b];
+            }
+            return res;
+        }
+
+        inline
+        void decompress_array(tree_io_codec codec, const char *stored, uint64_t stored_size, char *data,
+                              uint64_t size, uint64_t block_size) {
+            hg_assert(block_size > 0, "Invalid compression block size in tree file.");
+            const index_t num_blocks = (index_t) ((size + block_size - 1) / block_size);
+            hg_assert((uint64_t) num_blocks <= stored_size / sizeof(uint64_t),
+                      "Corrupted compressed array in tree file.");
+            std::vector<uint64_t> block_starts(num_blocks + 1);
+            std::memcpy(block_starts.data() + 1, stored, num_blocks * sizeof(uint64_t));
+            block_starts[0] = num_blocks * sizeof(uint64_t);
+            for (index_t b = 1; b <= num_blocks; b++) {
+                hg_assert(in_bounds(block_starts[b - 1], block_starts[b], stored_size),
+                          "Corrupted compressed array in tree file.");
+                block_starts[b] += block_starts[b - 1];
+            }
+            parfor(0, num_blocks, [&](index_t b) {
+                uint64_t start = b * block_size;
+                decompress_block(codec, stored + block_starts[b], block_starts[b + 1] - block_starts[b], data + start,
+                                 (std::min)(block_size, size - start));
+            });
+        }
+
+        /**
+         * Writer of the v2 tree format (see save_tree).
+         */
+        struct tree_writer {
+
+            tree_writer(std::ostream &out, const tree &t, tree_io_codec codec) :
+                    m_tree(t), m_out(out), m_codec(codec) {
+                check_codec(codec);
+                m_start = m_out.tellp();
+                const char header[v2_header_size] = {0};
+                write(header, v2_header_size);
+                write_entry(parents_entry, "", tree_io_dtype::of<index_t>(), m_tree.parents().data(), m_codec);
+            }
+
+            tree_writer(tree_writer &&other) :
+                    m_tree(other.m_tree),
+                    m_out(other.m_out),
+                    m_codec(other.m_codec),
+                    m_start(other.m_start),
+                    m_position(other.m_position),
+                    m_entries(std::move(other.m_entries)),
+                    m_finalized(other.m_finalized) {
+                other.m_finalized = true;
+            }
+
+            ~tree_writer() {
+                finalize();
+            }
+
+            /**
+             * Adds a node attribute stored with its own value type and the default compression codec of the writer.
+             */
+            template<typename T>
+            tree_writer &add_attribute(const std::string &name, const xt::xexpression<T> &xarray) {
+                return add_attribute(name, xarray, m_codec);
+            }
+
+            /**
+             * Adds a node attribute stored with its own value type and the given compression codec.
+             */
+            template<typename T>
+            tree_writer &add_attribute(const std::string &name, const xt::xexpression<T> &xarray,
+                                       tree_io_codec codec) {
+                using value_type = typename T::value_type;
+                auto &array = xarray.derived_cast();
+                hg_assert(array.dimension() == 1, "Only scalar attributes are supported.");
+                hg_assert(array.size() == m_tree.num_vertices(), "Attribute size does not match the size of the tree.");
+                return add_attribute_impl(name, array, codec, xt::has_data_interface<T>());
+            }
+
+            /**
+             * Adds a node attribute given by a contiguous buffer of num_vertices(tree) elements of the given type.
+             */
+            tree_writer &add_raw_attribute(const std::string &name, const tree_io_dtype &dtype, const void *data,
+                                           tree_io_codec codec) {
+                hg_assert(!m_finalized, "The tree file has already been finalized.");
+                hg_assert(name.size() <= v2_max_name_size, "Attribute name is too long: " + name.substr(0, 64) + "...");
+                check_codec(codec);
+                dispatch_dtype(dtype, [](auto) {});
+                for (const auto &e: m_entries) {
+                    hg_assert(e.kind != attribute_entry || e.name != name, "Duplicated attribute name: " + name);
+                }
+                write_entry(attribute_entry, name, dtype, data, codec);
+                return *this;
+            }
+
+            /**
+             * Writes the table of contents and the header.
+             */
+            void finalize() {
+                if (m_finalized) {
+                    return;
+                }
+                m_finalized = true;
+                write_padding();
+                uint64_t toc_offset = m_position;
+                for (const auto &e: m_entries) {
+                    uint64_t fields[] = {e.kind, dtype_code(e.dtype), (uint64_t) e.codec, e.offset, e.stored_size,
+                                         e.num_elements, e.block_size, e.name.size()};
+                    write(reinterpret_cast<const char *>(fields), sizeof(fields));
+                    write(e.name.data(), e.name.size());
+                }
+                uint64_t end = m_position;
+
+                char header[v2_header_size] = {0};
+                uint64_t fields[] = {HG_TREE_IO_V2_VERSION,
+                                     num_vertices(m_tree),
+                                     num_leaves(m_tree),
+                                     (uint64_t) m_tree.category(),
+                                     m_entries.size(),
+                                     toc_offset,
+                                     end - toc_offset};
+                std::memcpy(header, HG_TREE_IO_V2_MAGIC, 8);
+                std::memcpy(header + 8, fields, sizeof(fields));
+                m_out.seekp(m_start);
+                m_out.write(header, v2_header_size);
+                m_out.seekp(m_start + std::streamoff(end));
+            }
+
+        private:
+
+            template<typename T>
+            tree_writer &add_attribute_impl(const std::string &name, const T &array, tree_io_codec codec,
+                                            std::true_type /* has data interface */) {
+                using value_type = typename T::value_type;
+                if (array.size() <= 1 || array.strides()[0] == 1) {
+                    // contiguous buffer: written without copy
+                    return add_raw_attribute(name, tree_io_dtype::of<value_type>(), array.data() + array.data_offset(),
+                                             codec);
+                }
+                const array_1d<value_type> a = array;
+                return add_raw_attribute(name, tree_io_dtype::of<value_type>(), a.data(), codec);
+            }
+
+            template<typename T>
+            tree_writer &add_attribute_impl(const std::string &name, const T &array, tree_io_codec codec,
+                                            std::false_type /* has data interface */) {
+                using value_type = typename T::value_type;
+                const array_1d<value_type> a = array;
+                return add_raw_attribute(name, tree_io_dtype::of<value_type>(), a.data(), codec);
+            }
+
+            void write(const char *data, uint64_t size) {
+                m_out.write(data, std::streamsize(size));
+                m_position += size;
+            }
+
+            void write_padding() {
+                const char zeros[v2_alignment] = {0};
+                write(zeros, v2_padding(m_position));
+            }
+
+            void write_entry(uint64_t kind, const std::string &name, const tree_io_dtype &dtype, const void *data,
+                             tree_io_codec codec) {
+                write_padding();
+                v2_entry e{kind, name, dtype, codec, m_position, 0, num_vertices(m_tree), 0};
+                uint64_t size = e.num_elements * dtype.size;
+                if (codec == tree_io_codec::none) {
+                    write((const char *) data, size);
+                    e.stored_size = size;
+                } else {
+                    auto compressed = compress_array(codec, (const char *) data, size, v2_block_size);
+                    write(compressed.data(), compressed.size());
+                    e.stored_size = compressed.size();
+                    e.block_size = v2_block_size;
+                }
+                m_entries.push_back(std::move(e));
+            }
+
+            const tree &m_tree;
+            std::ostream &m_out;
+            tree_io_codec m_codec;
+            std::streamoff m_start;
+            uint64_t m_position = 0;
+            std::vector<v2_entry> m_entries;
+            bool m_finalized = false;
+        };
+
+        inline
+        bool is_tree_file_v2(std::istream &in) {
+            char magic[8] = {0};
+            auto position = in.tellg();
+            in.read(magic, 8);
+            bool res = in.gcount() == 8 && std::memcmp(magic, HG_TREE_IO_V2_MAGIC, 8) == 0;
+            in.clear();
+            in.seekg(position);
+            return res;
+        }
+    }
+
+    /**
+     * Random access reader of a tree file in the v2 format (see save_tree).
+     *
+     * Only the header and the table of contents are read at construction: the parents and each attribute are
+     * then read independently on demand. The reader can work on a stream, which must outlive the reader, or on a
+     * memory buffer holding the whole file, typically a memory mapped file: the parents of the tree are then used in
+     * place if they are not compressed.
+     */
+    class tree_file_reader {
+    public:
+
+        /**
+         * Reader on a seekable input stream (opened in binary mode) positioned at the beginning of a tree file.
+         */
+        explicit tree_file_reader(std::istream &in) : m_in(&in) {
+            m_start = in.tellg();
+            read_header();
+        }
+
+        /**
+         * Reader on a memory buffer holding the content of a tree file. The buffer must not be modified during the
+         * lifetime of the reader and of the trees read in place. The owner object is kept alive as long as the
+         * buffer is used.
+         *
+         * @param buffer pointer to the file content
+         * @param size size of the buffer in bytes
+         * @param owner object owning the buffer (can be nullptr if the buffer outlives the reader and the trees)
+         */
+        tree_file_reader(const char *buffer, size_t size, std::shared_ptr<const void> owner) :
+                m_in_memory(true), m_buffer(buffer), m_size(size), m_owner(std::move(owner)) {
+            hg_assert(size >= tree_io_internal::v2_header_size, "Invalid tree file.");
+            read_header();
+        }
+
+        size_t num_vertices() const {
+            return m_num_vertices;
+        }
+
+        size_t num_leaves() const {
+            return m_num_leaves;
+        }
+
+        /**
+         * Names of the stored attributes, in storage order.
+         */
+        std::vector<std::string> attribute_names() const {
+            std::vector<std::string> names;
+            for (const auto &e: m_entries) {
+                if (e.kind == tree_io_internal::attribute_entry) {
+                    names.push_back(e.name);
+                }
+            }
+            return names;
+        }
+
+        bool has_attribute(const std::string &name) const {
+            return find_attribute(name) != nullptr;
+        }
+
+        tree_io_dtype attribute_dtype(const std::string &name) const {
+            return get_attribute(name).dtype;
+        }
+
+        tree_io_codec attribute_codec(const std::string &name) const {
+            return get_attribute(name).codec;
+        }
+
+        /**
+         * Reads the tree. With a buffer reader, the parents array is used in place when it is not compressed and
+         * stored with the index type of this build: the tree is then only validated if content validation is
+         * enabled (see set_validation_level).
+         */
+        tree read_tree() {
+            const auto &e = m_entries[0];
+            auto category = (tree_category) m_category;
+            if (m_in_memory && e.codec == tree_io_codec::none && e.dtype == tree_io_dtype::of<index_t>()) {
+                hg_assert(e.stored_size == tree_io_internal::array_size(e.num_elements, e.dtype.size),
+                          "Invalid array size in tree file.");
+                hg_assert(tree_io_internal::in_bounds(e.offset, e.stored_size, m_size), "Unexpected end of tree buffer.");
+                const char *data = m_buffer + e.offset;
+                if (((uintptr_t) data) % alignof(index_t) == 0) {
+                    index_t num_leaves = is_content_validation_enabled() ? invalid_index : (index_t) m_num_leaves;
+                    tree t((const index_t *) data, m_num_vertices, m_owner, category, num_leaves);
+                    hg_assert(t.num_leaves() == m_num_leaves, "Invalid number of leaves in tree file.");
+                    return t;
+                }
+            }
+            tree t(read_entry<index_t>(e), category);
+            hg_assert(t.num_leaves() == m_num_leaves, "Invalid number of leaves in tree file.");
+            return t;
+        }
+
+        /**
+         * Reads the attribute with the given name converted to the value type T.
+         */
+        template<typename T = double>
+        array_1d<T> read_attribute(const std::string &name) {
+            return read_entry<T>(get_attribute(name));
+        }
+
+        /**
+         * Reads the attribute with the given name in its stored type (see attribute_dtype) in a buffer of
+         * num_vertices() * attribute_dtype(name).size bytes.
+         */
+        void read_raw_attribute(const std::string &name, void *data) {
+            read_entry_raw(get_attribute(name), (char *) data);
+        }
+
+        /**
+         * Pointer to the attribute with the given name in the buffer of a buffer reader, if it can be used in place:
+         * i.e. if it is not compressed and suitably aligned for its stored type (see attribute_dtype).
+         * Returns nullptr otherwise.
+         *
+         * The pointer is valid as long as the buffer is alive (see owner).
+         */
+        const void *attribute_data(const std::string &name) const {
+            const auto &e = get_attribute(name);
+            if (!m_in_memory || e.codec != tree_io_codec::none) {
+                return nullptr;
+            }
+            hg_assert(e.stored_size == tree_io_internal::array_size(e.num_elements, e.dtype.size),
+                      "Invalid array size in tree file.");
+            hg_assert(tree_io_internal::in_bounds(e.offset, e.stored_size, m_size), "Unexpected end of tree buffer.");
+            const char *data = m_buffer + e.offset;
+            if (((uintptr_t) data) % e.dtype.size != 0) {
+                return nullptr;
+            }
+            return data;
+        }
+
+        /**
+         * Read-only view of the attribute with the given name in the buffer of a buffer reader: the value type T
+         * must be the stored type of the attribute and the attribute must be usable in place (see attribute_data).
+         *
+         * The view is valid as long as the buffer is alive (see owner).
+         */
+        template<typename T>
+        auto attribute_view(const std::string &name) const {
+            hg_assert(attribute_dtype(name) == tree_io_dtype::of<T>(),
+                      "Attribute " + name + " is stored with type " + attribute_dtype(name).str() + ".");
+            auto data = (const T *) attribute_data(name);
+            hg_assert(data != nullptr, "Attribute " + name + " cannot be used in place.");
+            return xt::adapt((const T *) data, m_num_vertices, xt::no_ownership(), std::array<size_t, 1>{m_num_vertices});
+        }
+
+        /**
+         * Object owning the buffer of a buffer reader.
+         */
+        const std::shared_ptr<const void> &owner() const {
+            return m_owner;
+        }
+
+    private:
+
+        void read(uint64_t offset, char *data, uint64_t size) {
+            if (m_in_memory) {
+                hg_assert(tree_io_internal::in_bounds(offset, size, m_size), "Unexpected end of tree buffer.");
+                std::memcpy(data, m_buffer + offset, size);
+            } else {
+                m_in->clear();
+                m_in->seekg(m_start + std::streamoff(offset));
+                m_in->read(data, std::streamsize(size));
+                hg_assert(m_in->gcount() == (std::streamsize) size, "Unexpected end of tree file.");
+            }
+        }
+
+        uint64_t read_scalar(uint64_t &position) {
+            uint64_t value;
+            read(position, reinterpret_cast<char *>(&value), sizeof(value));
+            position += sizeof(value);
+            return value;
+        }
+
+        void read_header() {
+            using namespace tree_io_internal;
+            char header[v2_header_size];
+            read(0, header, v2_header_size);
+            hg_assert(std::memcmp(header, HG_TREE_IO_V2_MAGIC, 8) == 0, "Invalid tree file.");
+            uint64_t fields[7];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(fields[0] == HG_TREE_IO_V2_VERSION, "Unsupported tree file version.");
+            m_num_vertices = fields[1];
+            m_num_leaves = fields[2];
+            m_category = fields[3];
+            uint64_t num_entries = fields[4];
+            uint64_t position = fields[5];
+            hg_assert(num_entries > 0, "Missing parents in tree file.");
+
+            for (uint64_t i = 0; i < num_entries; i++) {
+                v2_entry e;
+                e.kind = read_scalar(position);
+                e.dtype = dtype_from_code(read_scalar(position));
+                // throws on unknown types
+                dispatch_dtype(e.dtype, [](auto) {});
+                e.codec = (tree_io_codec) read_scalar(position);
+                e.offset = read_scalar(position);
+                e.stored_size = read_scalar(position);
+                e.num_elements = read_scalar(position);
+                e.block_size = read_scalar(position);
+                uint64_t name_size = read_scalar(position);
+                hg_assert(name_size <= v2_max_name_size, "Invalid attribute name in tree file.");
+                hg_assert(!m_in_memory || in_bounds(position, name_size, m_size), "Unexpected end of tree buffer.");
+                e.name.resize(name_size);
+                read(position, &e.name[0], name_size);
+                position += name_size;
+                hg_assert(e.num_elements == m_num_vertices, "Invalid array size in tree file.");
+                m_entries.push_back(std::move(e));
+            }
+            hg_assert(m_entries[0].kind == parents_entry, "Missing parents in tree file.");
+        }
+
+        const tree_io_internal::v2_entry *find_attribute(const std::string &name) const {
+            for (const auto &e: m_entries) {
+                if (e.kind == tree_io_internal::attribute_entry && e.name == name) {
+                    return &e;
+                }
+            }
+            return nullptr;
+        }
+
+        const tree_io_internal::v2_entry &get_attribute(const std::string &name) const {
+            auto e = find_attribute(name);
+            hg_assert(e != nullptr, "Unknown attribute in tree file: " + name);
+            return *e;
+        }
+
+        void read_entry_raw(const tree_io_internal::v2_entry &e, char *data) {
+            tree_io_internal::check_codec(e.codec);
+            uint64_t size = tree_io_internal::array_size(e.num_elements, e.dtype.size);
+            if (e.codec == tree_io_codec::none) {
+                hg_assert(e.stored_size == size, "Invalid array size in tree file.");
+                read(e.offset, data, size);
+            } else if (m_in_memory) {
+                hg_assert(tree_io_internal::in_bounds(e.offset, e.stored_size, m_size), "Unexpected end of tree buffer.");
+                tree_io_internal::decompress_array(e.codec, m_buffer + e.offset, e.stored_size, data, size,
+                                                   e.block_size);
+            } else {
+                std::vector<char> stored(e.stored_size);
+                read(e.offset, stored.data(), e.stored_size);
+                tree_io_internal::decompress_array(e.codec, stored.data(), e.stored_size, data, size, e.block_size);
+            }
+        }
+
+        template<typename T>
+        array_1d<T> read_entry(const tree_io_internal::v2_entry &e) {
+            if (e.dtype == tree_io_dtype::of<T>()) {
+                auto res = array_1d<T>::from_shape({(size_t) e.num_elements});
+                read_entry_raw(e, (char *) res.data());
+                return res;
+            }
+            return tree_io_internal::dispatch_dtype(e.dtype, [this, &e](auto dummy) {
+                using stored_t = decltype(dummy);
+                auto stored = array_1d<stored_t>::from_shape({(size_t) e.num_elements});
+                read_entry_raw(e, (char *) stored.data());
+                array_1d<T> res = xt::cast<T>(stored);
+                return res;
+            });
+        }
+
+        // true for a buffer reader, false for a stream reader
+        bool m_in_memory = false;
+        std::istream *m_in = nullptr;
+        std::streamoff m_start = 0;
+        const char *m_buffer = nullptr;
+        size_t m_size = 0;
+        std::shared_ptr<const void> m_owner;
+        size_t m_num_vertices = 0;
+        size_t m_num_leaves = 0;
+        uint64_t m_category = 0;
+        std::vector<tree_io_internal::v2_entry> m_entries;
+    };
+
+    /**
+     * Memory map a file in the v2 tree format (see save_tree) and return a reader on the mapped file: the tree
+     * returned by read_tree and the attribute views (see tree_file_reader::attribute_view) then directly use the
+     * mapped file when the arrays are not compressed, and nothing is copied.
+     *
+     * The mapping is shared by the readers and the trees using it, and is released with the last of them. As the
+     * pages of the file are shared with the page cache, several processes mapping the same file do not duplicate it
+     * in memory.
+     *
+     * @param filename path to the tree file
+     * @return a tree_file_reader
+     */
+    inline
+    tree_file_reader map_tree_file(const std::string &filename) {
+        auto file = std::make_shared<mapped_file>(filename);
+        auto data = file->data();
+        auto size = file->size();
+        return tree_file_reader(data, size, std::move(file));
     }
 
+    /**
+     * Save a tree in the binary v2 tree format: attributes can then be added to the returned writer with
+     * add_attribute(name, array[, codec]) before a call to finalize (which is also called by the destructor of the
+     * writer).
+     *
+     * The file starts with a fixed size header followed by the parents array and the attributes: each array is
+     * stored in its own value type (no conversion is done) and is aligned on 64 bytes. A table of contents at the end
+     * of the file gives the location, type and compression codec of each array: it enables to read a single
+     * attribute, or to use the parents of the tree in place in a memory mapped file, without reading the whole file
+     * (see tree_file_reader). Compressed arrays are split in blocks of 1MB which are compressed and decompressed in
+     * parallel. Values are stored with the endianness of the machine.
+     *
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @param t tree
+     * @param codec default compression codec of the arrays (see tree_io_codec)
+     * @return a writer
+     */
     inline
     auto
-    save_tree(std::ostream &out, const tree &t) {
-        return tree_io_internal::tree_saver_helper(out, t);
+    save_tree(std::ostream &out, const tree &t, tree_io_codec codec = tree_io_codec::none) {
+        return tree_io_internal::tree_writer(out, t, codec);
     }
 
+    /**
+     * Save a tree in the legacy mixed ascii/binary v1 tree format: parents are stored as int and attributes as
+     * double.
+     *
+     * @param out output stream
+     * @param t tree
+     * @return a writer
+     */
+    inline
+    auto
+    save_tree_v1(std::ostream &out, const tree &t) {
+        return tree_io_internal::tree_saver_helper(out, t);
+    }
 
+    /**
+     * Read a tree and all its attributes, converted to double, from a file in the v1 or v2 tree format (see
+     * save_tree). Use tree_file_reader to read the attributes of a v2 file in their stored types.
+     *
+     * @param in input stream
+     * @return a pair (tree, map of attributes)
+     */
     inline
     auto
     read_tree(std::istream &in) {
-        std::string key = "";
-        char dummy;
-        std::string tmp;
-
-        int num_vertices = -1;
-        int num_attributes = -1;
-
-        while (key != HG_TREE_IO_HEADEREND_KEY) {
-            int value;
-            in >> tmp;
-            std::size_t pos = tmp.find('=');
-            if (pos != std::string::npos) {
-                key = tmp.substr(0, pos);
-                value = std::stoi(tmp.substr(pos + 1));
-            } else {
-                key = tmp;
+        if (!tree_io_internal::is_tree_file_v2(in)) {
+            return tree_io_internal::read_tree_v1(in);
+        }
+        tree_file_reader reader(in);
+        std::map<std::string, array_1d<double>> attributes;
+        for (const auto &name: reader.attribute_names()) {
+            attributes.emplace(name, reader.read_attribute<double>(name));
+        }
+        return std::make_pair(reader.read_tree(), std::move(attributes));
+    }
+
+    namespace lca_io_internal {
+
+        using namespace range_minimum_query_internal;
+
+        // arrays are aligned on 64 bytes in LCA files, such that they can be used in place when the file is memory mapped
+        const uint64_t alignment = 64;
+        const uint64_t header_size = 64;
+
+        template<typename rmq_t>
+        struct algorithm_id;
+
+        template<>
+        struct algorithm_id<rmq_sparse_table<index_t>> : std::integral_constant<uint64_t, 1> {
+        };
+
+        template<>
+        struct algorithm_id<rmq_sparse_table_block<index_t>> : std::integral_constant<uint64_t, 2> {
+        };
+
+        template<>
+        struct algorithm_id<rmq_bitmask_block<index_t>> : std::integral_constant<uint64_t, 3> {
+        };
+
+        inline
+        uint64_t padding(uint64_t position) {
+            return (alignment - position % alignment) % alignment;
+        }
+
+        struct lca_writer {
+
+            lca_writer(std::ostream &out) : m_out(out) {
             }
 
-            if (key == HG_TREE_IO_VERSION_KEY) {
+            void write_header(uint64_t algorithm) {
+                char header[header_size] = {0};
+                uint64_t fields[] = {HG_LCA_IO_VERSION, algorithm, sizeof(index_t)};
+                std::memcpy(header, HG_LCA_IO_MAGIC, 8);
+                std::memcpy(header + 8, fields, sizeof(fields));
+                write(header, header_size);
+            }
 
-            } else if (key == HG_TREE_IO_NBNODES_KEY) {
-                num_vertices = value;
-            } else if (key == HG_TREE_IO_NBATTRIBUTES_KEY) {
-                num_attributes = value;
-            } else if (key == HG_TREE_IO_HEADEREND_KEY) {
+            void write_scalar(uint64_t value) {
+                write(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
 
-            } else {
-                HG_LOG_WARNING("Key '%s' is unknown and will be ignored.", key.c_str());
+            template<typename T>
+            void write_array(const T &array) {
+                using value_type = typename T::value_type;
+                write_scalar(array.size());
+                write_scalar(sizeof(value_type));
+                const char zeros[alignment] = {0};
+                write(zeros, padding(m_position));
+                write(reinterpret_cast<const char *>(array.data()), array.size() * sizeof(value_type));
             }
 
+        private:
+            void write(const char *data, uint64_t size) {
+                m_out.write(data, std::streamsize(size));
+                m_position += size;
+            }
+
+            std::ostream &m_out;
+            uint64_t m_position = 0;
+        };
+
+        /**
+         * Read LCA data from a stream: arrays are copied in new arrays.
+         */
+        struct lca_stream_reader {
+
+            lca_stream_reader(std::istream &in) : m_in(in) {
+            }
+
+            void read(char *data, uint64_t size) {
+                m_in.read(data, std::streamsize(size));
+                hg_assert(m_in.gcount() == (std::streamsize) size, "Unexpected end of LCA file.");
+                m_position += size;
+            }
+
+            template<typename T>
+            auto read_array(uint64_t size) {
+                char dummy[alignment];
+                read(dummy, padding(m_position));
+                auto array = array_1d<T>::from_shape({(size_t) size});
+                read(reinterpret_cast<char *>(array.data()), size * sizeof(T));
+                return details::make_shared_array_1d(std::move(array));
+            }
+
+        private:
+            std::istream &m_in;
+            uint64_t m_position = 0;
+        };
+
+        /**
+         * Read LCA data from a memory buffer: arrays are views in the buffer.
+         */
+        struct lca_buffer_reader {
+
+            lca_buffer_reader(const char *buffer, uint64_t size, std::shared_ptr<const void> owner) :
+                    m_buffer(buffer), m_size(size), m_owner(std::move(owner)) {
+            }
+
+            void read(char *data, uint64_t size) {
+                hg_assert(tree_io_internal::in_bounds(m_position, size, m_size), "Unexpected end of LCA buffer.");
+                std::memcpy(data, m_buffer + m_position, size);
+                m_position += size;
+            }
+
+            template<typename T>
+            auto read_array(uint64_t size) {
+                m_position += padding(m_position);
+                hg_assert(m_position <= m_size && size <= (m_size - m_position) / sizeof(T),
+                          "Unexpected end of LCA buffer.");
+                hg_assert(((uintptr_t) (m_buffer + m_position)) % alignof(T) == 0, "Misaligned LCA buffer.");
+                details::shared_array_1d<T> array((const T *) (m_buffer + m_position), (size_t) size, m_owner);
+                m_position += size * sizeof(T);
+                return array;
+            }
+
+        private:
+            const char *m_buffer;
+            uint64_t m_size;
+            std::shared_ptr<const void> m_owner;
+            uint64_t m_position = 0;
+        };
+
+        template<typename reader_t>
+        uint64_t read_scalar(reader_t &reader) {
+            uint64_t value;
+            reader.read(reinterpret_cast<char *>(&value), sizeof(value));
+            return value;
         }
 
-        hg_assert(num_vertices > 0, "Incorrect or missing key "
-                HG_TREE_IO_NBNODES_KEY);
-        hg_assert(num_attributes >= 0, "Incorrect or missing key "
-                HG_TREE_IO_NBATTRIBUTES_KEY);
+        template<typename T, typename reader_t>
+        auto read_array(reader_t &reader) {
+            auto size = read_scalar(reader);
+            auto value_size = read_scalar(reader);
+            hg_assert(value_size == sizeof(T), "Invalid array element size in LCA file.");
+            return reader.template read_array<T>(size);
+        }
 
-        in.read(&dummy, 1); // consumme the last \n left by cin...
+        template<typename reader_t>
+        uint64_t read_header(reader_t &reader) {
+            char header[header_size];
+            reader.read(header, header_size);
+            uint64_t fields[3];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(std::memcmp(header, HG_LCA_IO_MAGIC, 8) == 0, "Invalid LCA file.");
+            hg_assert(fields[0] == HG_LCA_IO_VERSION, "Unsupported LCA file version.");
+            hg_assert(fields[2] == sizeof(index_t), "The LCA file was saved with a different index type size.");
+            return fields[1];
+        }
 
-        array_1d<int> parents;
-        parents.resize({std::size_t(num_vertices)});
-        in.read(reinterpret_cast<char *>(parents.data()), std::streamsize(num_vertices * sizeof(int)));
+        inline
+        void write_rmq_state(lca_writer &writer, const rmq_sparse_table<index_t>::internal_state<array_1d> &state) {
+            writer.write_scalar(state.sparse_table.size());
+            for (auto &a: state.sparse_table) {
+                writer.write_array(a);
+            }
+        }
 
-        std::map<std::string, array_1d<double>> attributes;
+        inline
+        void write_rmq_state(lca_writer &writer,
+                             const rmq_sparse_table_block<index_t>::internal_state<array_1d> &state) {
+            writer.write_scalar(state.data_size);
+            writer.write_scalar(state.block_size);
+            writer.write_scalar(state.num_blocks);
+            writer.write_array(state.block_minimum_prefix);
+            writer.write_array(state.block_minimum_suffix);
+            writer.write_array(state.subblock_minimum);
+            write_rmq_state(writer, state.sparse_table);
+        }
 
-        for (int i = 0; i < num_attributes; i++) {
-            std::string name = "";
-            key = "";
-            while (key != HG_TREE_IO_HEADEREND_KEY) {
-                in >> tmp;
-                std::size_t pos = tmp.find('=');
-                std::string value;
-                if (pos != std::string::npos) {
-                    key = tmp.substr(0, pos);
-                    value = tmp.substr(pos + 1);
-                } else {
-                    key = tmp;
-                }
+        inline
+        void write_rmq_state(lca_writer &writer, const rmq_bitmask_block<index_t>::internal_state<array_1d> &state) {
+            writer.write_scalar(state.data_size);
+            writer.write_scalar(state.num_blocks);
+            writer.write_array(state.masks);
+            write_rmq_state(writer, state.sparse_table);
+        }
 
-                if (key == HG_TREE_IO_NAME_KEY) {
-                    name = value;
-                } else if (key == HG_TREE_IO_HEADEREND_KEY) {
+        template<typename rmq_t>
+        struct rmq_state_reader;
 
-                } else {
-                    HG_LOG_WARNING("Key '%s' is unknown and will be ignored.", key.c_str());
+        template<>
+        struct rmq_state_reader<rmq_sparse_table<index_t>> {
+            template<typename reader_t>
+            static auto read(reader_t &reader) {
+                std::vector<details::shared_array_1d<size_t>> sparse_table;
+                auto num_levels = read_scalar(reader);
+                for (uint64_t i = 0; i < num_levels; i++) {
+                    sparse_table.push_back(read_array<size_t>(reader));
                 }
+                return rmq_sparse_table<index_t>::internal_state<details::shared_array_1d>(std::move(sparse_table));
             }
-            hg_assert(name != "", "Incorrect or missing key for attribute " + std::to_string(i) + " " +
-                                  HG_TREE_IO_NAME_KEY);
-            in.read(&dummy, 1); // consumme the last \n left by cin...
+        };
 
-            attributes.emplace(name, array_1d<double>::from_shape({std::size_t(num_vertices)}));
-            in.read(reinterpret_cast<char *>(attributes[name].data()), std::streamsize(num_vertices * sizeof(double)));
+        template<>
+        struct rmq_state_reader<rmq_sparse_table_block<index_t>> {
+            template<typename reader_t>
+            static auto read(reader_t &reader) {
+                index_t data_size = read_scalar(reader);
+                index_t block_size = read_scalar(reader);
+                index_t num_blocks = read_scalar(reader);
+                auto block_minimum_prefix = read_array<index_t>(reader);
+                auto block_minimum_suffix = read_array<index_t>(reader);
+                auto subblock_minimum = read_array<index_t>(reader);
+                auto sparse_table = rmq_state_reader<rmq_sparse_table<index_t>>::read(reader);
+                return rmq_sparse_table_block<index_t>::internal_state<details::shared_array_1d>(
+                        data_size, block_size, num_blocks, std::move(block_minimum_prefix),
+                        std::move(block_minimum_suffix), std::move(subblock_minimum), std::move(sparse_table));
+            }
+        };
+
+        template<>
+        struct rmq_state_reader<rmq_bitmask_block<index_t>> {
+            template<typename reader_t>
+            static auto read(reader_t &reader) {
+                index_t data_size = read_scalar(reader);
+                index_t num_blocks = read_scalar(reader);
+                auto masks = read_array<rmq_bitmask_block<index_t>::mask_type>(reader);
+                auto sparse_table = rmq_state_reader<rmq_sparse_table<index_t>>::read(reader);
+                return rmq_bitmask_block<index_t>::internal_state<details::shared_array_1d>(
+                        data_size, num_blocks, std::move(masks), std::move(sparse_table));
+            }
+        };
+
+        template<typename lca_t, typename reader_t>
+        auto read_lca(reader_t &reader) {
+            using rmq_t = typename lca_t::rmq_type;
+            hg_assert(read_header(reader) == algorithm_id<rmq_t>::value,
+                      "The LCA file was saved with a different algorithm.");
+            auto tree_Euler_tour_map = read_array<index_t>(reader);
+            auto tree_Euler_tour_depth = read_array<index_t>(reader);
+            auto first_visit_in_Euler_tour = read_array<index_t>(reader);
+            auto rmq_state = rmq_state_reader<rmq_t>::read(reader);
+            return lca_t::make_from_state(typename lca_t::template internal_state<details::shared_array_1d>(
+                    std::move(tree_Euler_tour_map),
+                    std::move(tree_Euler_tour_depth),
+                    std::move(first_visit_in_Euler_tour),
+                    std::move(rmq_state)));
         }
+    }
 
-        return std::make_pair(tree(parents), std::move(attributes));
+    /**
+     * Save the preprocessed state of a lowest common ancestor solver (see lca_fast.hpp) in binary format.
+     *
+     * The solver can then be restored with read_lca without preprocessing the tree again, for example next to a
+     * tree saved with save_tree. Arrays are aligned in the output such that the solver can be used in place from a
+     * memory mapped file (see read_lca).
+     *
+     * @tparam lca_t
+     * @param out output stream (opened in binary mode)
+     * @param lca
+     */
+    template<typename lca_t>
+    void save_lca(std::ostream &out, const lca_t &lca) {
+        using namespace lca_io_internal;
+        lca_writer writer(out);
+        writer.write_header(algorithm_id<typename lca_t::rmq_type>::value);
+        auto state = lca.get_state();
+        writer.write_array(state.tree_Euler_tour_map);
+        writer.write_array(state.tree_Euler_tour_depth);
+        writer.write_array(state.first_visit_in_Euler_tour);
+        write_rmq_state(writer, state.rmq_state);
     }
 
-}
+    /**
+     * Read a lowest common ancestor solver saved with save_lca from a stream.
+     *
+     * @tparam lca_t type of the saved solver
+     * @param in input stream (opened in binary mode)
+     * @return
+     */
+    template<typename lca_t>
+    auto read_lca(std::istream &in) {
+        lca_io_internal::lca_stream_reader reader(in);
+        return lca_io_internal::read_lca<lca_t>(reader);
+    }
 
+    /**
+     * Create a lowest common ancestor solver on a memory buffer holding the content of a file saved with save_lca,
+     * typically a memory mapped file.
+     *
+     * The arrays of the solver are not copied: they are used in place in the buffer, which must not be modified during
+     * the lifetime of the solver and of its copies. The owner object is kept alive as long as the buffer is used.
+     * The buffer must be aligned on 64 bytes (memory mapped files are aligned on pages).
+     *
+     * @tparam lca_t type of the saved solver
+     * @param buffer pointer to the file content
+     * @param size size of the buffer in bytes
+     * @param owner object owning the buffer (can be nullptr if the buffer outlives the solver)
+     * @return
+     */
+    template<typename lca_t>
+    auto read_lca(const char *buffer, size_t size, std::shared_ptr<const void> owner) {
+        lca_io_internal::lca_buffer_reader reader(buffer, size, std::move(owner));
+        return lca_io_internal::read_lca<lca_t>(reader);
+    }
 
+    /**
+     * Identifier of the algorithm of a lowest common ancestor solver saved with save_lca:
+     * 1 for lca_sparse_table, 2 for lca_sparse_table_block, and 3 for lca_bitmask_block.
+     *
+     * @param buffer pointer to the file content
+     * @param size size of the buffer in bytes
+     * @return
+     */
+    inline
+    auto lca_file_algorithm(const char *buffer, size_t size) {
+        lca_io_internal::lca_buffer_reader reader(buffer, size, nullptr);
+        return lca_io_internal::read_header(reader);
+    }
+
+    namespace succinct_tree_io_internal {
+
+        // the arrays are written and read as the arrays of an LCA file
+        using namespace lca_io_internal;
+
+        template<typename reader_t>
+        auto read_succinct_tree(reader_t &reader) {
+            char header[header_size];
+            reader.read(header, header_size);
+            uint64_t fields[4];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(std::memcmp(header, HG_SUCCINCT_TREE_IO_MAGIC, 8) == 0, "Invalid succinct tree file.");
+            hg_assert(fields[0] == HG_SUCCINCT_TREE_IO_VERSION, "Unsupported succinct tree file version.");
+            hg_assert(fields[3] == (uint64_t) succinct_tree_internal::block_bits,
+                      "The succinct tree file was saved with a different block size.");
+            auto bits = read_array<uint64_t>(reader);
+            auto block_rank = read_array<uint64_t>(reader);
+            auto min_excess = read_array<int64_t>(reader);
+            return succinct_tree((index_t) fields[1], (index_t) fields[2], std::move(bits), std::move(block_rank),
+                                 std::move(min_excess));
+        }
+    }
+
+    /**
+     * Save a succinct tree (see succinct_tree.hpp) in binary format: about 2.4 bits per node.
+     *
+     * Arrays are aligned in the output such that the succinct tree can be queried in place from a memory mapped file
+     * (see read_succinct_tree). The node attributes of the tree can be saved next to it, in preorder (see
+     * make_succinct_tree), as raw arrays.
+     *
+     * @param out output stream (opened in binary mode)
+     * @param t succinct tree
+     */
+    inline
+    void save_succinct_tree(std::ostream &out, const succinct_tree &t) {
+        using namespace lca_io_internal;
+        lca_writer writer(out);
+        uint64_t magic;
+        std::memcpy(&magic, HG_SUCCINCT_TREE_IO_MAGIC, 8);
+        uint64_t fields[] = {magic, HG_SUCCINCT_TREE_IO_VERSION, (uint64_t) t.num_vertices(),
+                             (uint64_t) t.num_leaves(), (uint64_t) succinct_tree_internal::block_bits};
+        for (auto f: fields) {
+            writer.write_scalar(f);
+        }
+        for (uint64_t i = sizeof(fields); i < header_size; i += sizeof(uint64_t)) {
+            writer.write_scalar(0);
+        }
+        writer.write_array(t.bits());
+        writer.write_array(t.block_rank());
+        writer.write_array(t.min_excess());
+    }
+
+    /**
+     * Read a succinct tree saved with save_succinct_tree from a stream.
+     *
+     * @param in input stream (opened in binary mode)
+     * @return a succinct_tree
+     */
+    inline
+    succinct_tree read_succinct_tree(std::istream &in) {
+        lca_io_internal::lca_stream_reader reader(in);
+        return succinct_tree_io_internal::read_succinct_tree(reader);
+    }
+
+    /**
+     * Create a succinct tree on a memory buffer holding the content of a file saved with save_succinct_tree,
+     * typically a memory mapped file.
+     *
+     * The arrays of the succinct tree are not copied: they are used in place in the buffer, which must not be modified
+     * during the lifetime of the succinct tree and of its copies. The owner object is kept alive as long as the
+     * buffer is used. The buffer must be aligned on 64 bytes (memory mapped files are aligned on pages).
+     *
+     * @param buffer pointer to the file content
+     * @param size size of the buffer in bytes
+     * @param owner object owning the buffer (can be nullptr if the buffer outlives the succinct tree)
+     * @return a succinct_tree
+     */
+    inline
+    succinct_tree read_succinct_tree(const char *buffer, size_t size, std::shared_ptr<const void> owner) {
+        lca_io_internal::lca_buffer_reader reader(buffer, size, std::move(owner));
+        return succinct_tree_io_internal::read_succinct_tree(reader);
+    }
+}
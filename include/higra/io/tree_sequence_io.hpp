@@ -0,0 +1,551 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../structure/tree_graph.hpp"
+#include "xtensor/xexpression.hpp"
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+
+namespace hg {
+
+#define HG_TREE_SEQUENCE_IO_MAGIC "HGTRESEQ"
+#define HG_TREE_SEQUENCE_IO_VERSION 1
+
+    namespace tree_sequence_io_internal {
+
+        const uint64_t header_size = 64;
+
+        /**
+         * Entry of the frame index of a tree sequence file.
+         */
+        struct frame_entry {
+            // position of the frame relative to the beginning of the file
+            uint64_t offset;
+            // size of the encoded frame in bytes
+            uint64_t size;
+            // 1 if the frame is a keyframe, 0 if it is a delta to the previous frame
+            uint64_t keyframe;
+        };
+
+        inline
+        void write_varint(std::vector<char> &out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back((char) ((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back((char) value);
+        }
+
+        inline
+        uint64_t read_varint(const char *&data, const char *end) {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                hg_assert(data < end, "Corrupted frame in tree sequence file.");
+                auto byte = (unsigned char) *data++;
+                value |= (uint64_t) (byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Corrupted frame in tree sequence file.");
+        }
+
+        inline
+        uint64_t zigzag_encode(int64_t value) {
+            return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+        }
+
+        inline
+        int64_t zigzag_decode(uint64_t value) {
+            return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+        }
+
+        inline
+        uint64_t double_bits(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        inline
+        double bits_double(uint64_t bits) {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        /**
+         * XOR float encoding of value with respect to the reference value: the xor x of their bit patterns is stored
+         * as a single 0 byte if x = 0, or as a header byte (number of trailing zero bytes of x << 4 | number n of
+         * significant bytes of x) followed by the n significant bytes. Close values share their sign, exponent and
+         * high order mantissa bits and are thus stored in a few bytes.
+         */
+        inline
+        void write_xor_double(std::vector<char> &out, double value, double reference) {
+            uint64_t x = double_bits(value) ^ double_bits(reference);
+            if (x == 0) {
+                out.push_back(0);
+                return;
+            }
+            int trailing = 0;
+            while ((x & 0xff) == 0) {
+                x >>= 8;
+                trailing++;
+            }
+            int n = 0;
+            for (uint64_t y = x; y != 0; y >>= 8) {
+                n++;
+            }
+            out.push_back((char) ((trailing << 4) | n));
+            for (int i = 0; i < n; i++) {
+                out.push_back((char) (x >> (8 * i)));
+            }
+        }
+
+        inline
+        double read_xor_double(const char *&data, const char *end, double reference) {
+            hg_assert(data < end, "Corrupted frame in tree sequence file.");
+            auto header = (unsigned char) *data++;
+            if (header == 0) {
+                return reference;
+            }
+            int trailing = header >> 4;
+            int n = header & 0xf;
+            hg_assert(n >= 1 && trailing + n <= 8 && end - data >= n, "Corrupted frame in tree sequence file.");
+            uint64_t x = 0;
+            for (int i = 0; i < n; i++) {
+                x |= (uint64_t) (unsigned char) *data++ << (8 * i);
+            }
+            return bits_double(double_bits(reference) ^ (x << (8 * trailing)));
+        }
+
+        /**
+         * Keyframe layout: number of nodes, number of leaves, the parent of each node i as a zigzag varint of
+         * parent(i) - i, and the altitude of each node i xor encoded with respect to the altitude of node i - 1.
+         */
+        inline
+        void encode_keyframe(std::vector<char> &out, const array_1d<index_t> &parents, index_t num_leaves,
+                             const array_1d<double> &altitudes) {
+            const index_t num_nodes = parents.size();
+            write_varint(out, (uint64_t) num_nodes);
+            write_varint(out, (uint64_t) num_leaves);
+            for (index_t i = 0; i < num_nodes; i++) {
+                write_varint(out, zigzag_encode(parents(i) - i));
+            }
+            double previous = 0;
+            for (index_t i = 0; i < num_nodes; i++) {
+                write_xor_double(out, altitudes(i), previous);
+                previous = altitudes(i);
+            }
+        }
+
+        inline
+        void decode_keyframe(const char *data, const char *end, array_1d<index_t> &parents, index_t &num_leaves,
+                             array_1d<double> &altitudes) {
+            const auto num_nodes = (index_t) read_varint(data, end);
+            num_leaves = (index_t) read_varint(data, end);
+            // each node takes at least one byte
+            hg_assert(num_nodes > 0 && num_leaves > 0 && num_leaves <= num_nodes && num_nodes <= end - data,
+                      "Corrupted frame in tree sequence file.");
+            parents.resize({(size_t) num_nodes});
+            altitudes.resize({(size_t) num_nodes});
+            for (index_t i = 0; i < num_nodes; i++) {
+                parents(i) = i + zigzag_decode(read_varint(data, end));
+            }
+            double previous = 0;
+            for (index_t i = 0; i < num_nodes; i++) {
+                altitudes(i) = read_xor_double(data, end, previous);
+                previous = altitudes(i);
+            }
+        }
+
+        /**
+         * Delta frame layout: number of changed nodes, and for each changed node i, in increasing order, the gap to
+         * the previous changed node as a varint, the difference with its previous parent as a zigzag varint, and its
+         * altitude xor encoded with respect to its previous altitude.
+         */
+        inline
+        void encode_delta(std::vector<char> &out,
+                          const array_1d<index_t> &previous_parents, const array_1d<double> &previous_altitudes,
+                          const array_1d<index_t> &parents, const array_1d<double> &altitudes) {
+            const index_t num_nodes = parents.size();
+            std::vector<index_t> changes;
+            for (index_t i = 0; i < num_nodes; i++) {
+                if (parents(i) != previous_parents(i) ||
+                    double_bits(altitudes(i)) != double_bits(previous_altitudes(i))) {
+                    changes.push_back(i);
+                }
+            }
+            write_varint(out, changes.size());
+            index_t last = -1;
+            for (auto i: changes) {
+                write_varint(out, (uint64_t) (i - last - 1));
+                write_varint(out, zigzag_encode(parents(i) - previous_parents(i)));
+                write_xor_double(out, altitudes(i), previous_altitudes(i));
+                last = i;
+            }
+        }
+
+        inline
+        void decode_delta(const char *data, const char *end, array_1d<index_t> &parents,
+                          array_1d<double> &altitudes) {
+            const index_t num_nodes = parents.size();
+            const auto num_changes = read_varint(data, end);
+            index_t i = -1;
+            for (uint64_t c = 0; c < num_changes; c++) {
+                const uint64_t gap = read_varint(data, end);
+                hg_assert(gap < (uint64_t) (num_nodes - i - 1), "Corrupted frame in tree sequence file.");
+                i += (index_t) gap + 1;
+                parents(i) += zigzag_decode(read_varint(data, end));
+                altitudes(i) = read_xor_double(data, end, altitudes(i));
+            }
+        }
+
+        /**
+         * Writer of the tree sequence format (see save_tree_sequence).
+         */
+        struct tree_sequence_writer {
+
+            tree_sequence_writer(std::ostream &out, index_t keyframe_interval) :
+                    m_out(out), m_keyframe_interval(keyframe_interval) {
+                hg_assert(keyframe_interval > 0, "The keyframe interval must be positive.");
+                m_start = m_out.tellp();
+                const char header[header_size] = {0};
+                write(header, header_size);
+            }
+
+            tree_sequence_writer(tree_sequence_writer &&other) :
+                    m_out(other.m_out),
+                    m_keyframe_interval(other.m_keyframe_interval),
+                    m_start(other.m_start),
+                    m_position(other.m_position),
+                    m_frames(std::move(other.m_frames)),
+                    m_parents(std::move(other.m_parents)),
+                    m_altitudes(std::move(other.m_altitudes)),
+                    m_num_leaves(other.m_num_leaves),
+                    m_frames_since_keyframe(other.m_frames_since_keyframe),
+                    m_finalized(other.m_finalized) {
+                other.m_finalized = true;
+            }
+
+            ~tree_sequence_writer() {
+                finalize();
+            }
+
+            /**
+             * Appends a frame to the sequence: a tree and its node altitudes, stored as double.
+             *
+             * The frame is stored as a keyframe every keyframe_interval frames, when its number of nodes or of
+             * leaves differs from the previous frame, or when its delta to the previous frame is not smaller than a
+             * keyframe. Otherwise, only the nodes whose parent or altitude changed since the previous frame are
+             * stored.
+             */
+            template<typename T>
+            tree_sequence_writer &add_frame(const tree &t, const xt::xexpression<T> &xaltitudes) {
+                HG_TRACE();
+                auto &altitudes = xaltitudes.derived_cast();
+                hg_assert(!m_finalized, "The tree sequence file has already been finalized.");
+                hg_assert_node_weights(t, altitudes);
+                hg_assert_1d_array(altitudes);
+
+                array_1d<index_t> parents = hg::parents(t);
+                array_1d<double> frame_altitudes = xt::cast<double>(altitudes);
+                const bool keyframe = m_frames.empty() ||
+                                      m_frames_since_keyframe + 1 >= m_keyframe_interval ||
+                                      parents.size() != m_parents.size() ||
+                                      (index_t) num_leaves(t) != m_num_leaves;
+
+                m_keyframe_buffer.clear();
+                encode_keyframe(m_keyframe_buffer, parents, num_leaves(t), frame_altitudes);
+                m_delta_buffer.clear();
+                if (!keyframe) {
+                    encode_delta(m_delta_buffer, m_parents, m_altitudes, parents, frame_altitudes);
+                }
+                // a reordering of the nodes changes most parents: the frame is then smaller as a keyframe
+                if (keyframe || m_delta_buffer.size() >= m_keyframe_buffer.size()) {
+                    m_frames.push_back({m_position, m_keyframe_buffer.size(), 1});
+                    write(m_keyframe_buffer.data(), m_keyframe_buffer.size());
+                    m_frames_since_keyframe = 0;
+                } else {
+                    m_frames.push_back({m_position, m_delta_buffer.size(), 0});
+                    write(m_delta_buffer.data(), m_delta_buffer.size());
+                    m_frames_since_keyframe++;
+                }
+
+                m_parents = std::move(parents);
+                m_altitudes = std::move(frame_altitudes);
+                m_num_leaves = num_leaves(t);
+                return *this;
+            }
+
+            size_t num_frames() const {
+                return m_frames.size();
+            }
+
+            /**
+             * Writes the frame index and the header.
+             */
+            void finalize() {
+                if (m_finalized) {
+                    return;
+                }
+                m_finalized = true;
+                uint64_t index_offset = m_position;
+                for (const auto &f: m_frames) {
+                    uint64_t fields[] = {f.offset, f.size, f.keyframe};
+                    write(reinterpret_cast<const char *>(fields), sizeof(fields));
+                }
+                uint64_t end = m_position;
+
+                char header[header_size] = {0};
+                uint64_t fields[] = {HG_TREE_SEQUENCE_IO_VERSION,
+                                     m_frames.size(),
+                                     (uint64_t) m_keyframe_interval,
+                                     index_offset};
+                std::memcpy(header, HG_TREE_SEQUENCE_IO_MAGIC, 8);
+                std::memcpy(header + 8, fields, sizeof(fields));
+                m_out.seekp(m_start);
+                m_out.write(header, header_size);
+                m_out.seekp(m_start + std::streamoff(end));
+            }
+
+        private:
+
+            void write(const char *data, uint64_t size) {
+                m_out.write(data, std::streamsize(size));
+                m_position += size;
+            }
+
+            std::ostream &m_out;
+            index_t m_keyframe_interval;
+            std::streamoff m_start;
+            uint64_t m_position = 0;
+            std::vector<frame_entry> m_frames;
+            // previous frame
+            array_1d<index_t> m_parents;
+            array_1d<double> m_altitudes;
+            index_t m_num_leaves = 0;
+            index_t m_frames_since_keyframe = 0;
+            std::vector<char> m_keyframe_buffer;
+            std::vector<char> m_delta_buffer;
+            bool m_finalized = false;
+        };
+    }
+
+    /**
+     * Random access reader of a tree sequence file (see save_tree_sequence).
+     *
+     * Only the header and the frame index are read at construction. A frame is decoded from the closest keyframe
+     * preceding it, followed by the deltas up to the frame. The last decoded frame is cached: reading the frames in
+     * increasing order only decodes one delta per frame. As the cache is modified by read_frame, a reader must not
+     * be used by several threads at the same time.
+     *
+     * The reader can work on a stream, which must outlive the reader, or on a memory buffer holding the whole file,
+     * typically a memory mapped file.
+     */
+    class tree_sequence_reader {
+    public:
+
+        /**
+         * Reader on a seekable input stream (opened in binary mode) positioned at the beginning of a tree sequence file.
+         */
+        explicit tree_sequence_reader(std::istream &in) : m_in(&in) {
+            m_start = in.tellg();
+            read_header();
+        }
+
+        /**
+         * Reader on a memory buffer holding the content of a tree sequence file. The buffer must not be modified
+         * during the lifetime of the reader. The owner object is kept alive as long as the reader.
+         *
+         * @param buffer pointer to the file content
+         * @param size size of the buffer in bytes
+         * @param owner object owning the buffer (can be nullptr if the buffer outlives the reader)
+         */
+        tree_sequence_reader(const char *buffer, size_t size, std::shared_ptr<const void> owner) :
+                m_in_memory(true), m_buffer(buffer), m_size(size), m_owner(std::move(owner)) {
+            hg_assert(size >= tree_sequence_io_internal::header_size, "Invalid tree sequence file.");
+            read_header();
+        }
+
+        size_t num_frames() const {
+            return m_frames.size();
+        }
+
+        index_t keyframe_interval() const {
+            return m_keyframe_interval;
+        }
+
+        bool is_keyframe(index_t frame) const {
+            check_frame(frame);
+            return m_frames[frame].keyframe != 0;
+        }
+
+        /**
+         * Size in bytes of the encoded frame in the file.
+         */
+        size_t frame_size(index_t frame) const {
+            check_frame(frame);
+            return m_frames[frame].size;
+        }
+
+        /**
+         * Reads the given frame.
+         *
+         * @param frame index of the frame
+         * @return a pair (tree, altitudes)
+         */
+        std::pair<tree, array_1d<double>> read_frame(index_t frame) {
+            HG_TRACE();
+            check_frame(frame);
+            index_t keyframe = frame;
+            while (m_frames[keyframe].keyframe == 0) {
+                keyframe--;
+            }
+            index_t first;
+            if (m_current_frame >= keyframe && m_current_frame <= frame) {
+                first = m_current_frame + 1;
+            } else {
+                decode_frame(keyframe);
+                first = keyframe + 1;
+            }
+            for (index_t f = first; f <= frame; f++) {
+                decode_frame(f);
+            }
+            m_current_frame = frame;
+            tree t(m_parents);
+            hg_assert(hg::num_leaves(t) == (size_t) m_num_leaves, "Corrupted frame in tree sequence file.");
+            return {std::move(t), m_altitudes};
+        }
+
+        /**
+         * Object owning the buffer of a buffer reader.
+         */
+        const std::shared_ptr<const void> &owner() const {
+            return m_owner;
+        }
+
+    private:
+
+        void check_frame(index_t frame) const {
+            hg_assert(frame >= 0 && frame < (index_t) m_frames.size(),
+                      "Frame index " + std::to_string(frame) + " is out of range.");
+        }
+
+        void read(uint64_t offset, char *data, uint64_t size) {
+            if (m_in_memory) {
+                hg_assert(offset <= m_size && size <= m_size - offset, "Unexpected end of tree sequence buffer.");
+                std::memcpy(data, m_buffer + offset, size);
+            } else {
+                m_in->clear();
+                m_in->seekg(m_start + std::streamoff(offset));
+                m_in->read(data, std::streamsize(size));
+                hg_assert(m_in->gcount() == (std::streamsize) size, "Unexpected end of tree sequence file.");
+            }
+        }
+
+        // checks that the range [offset, offset + size[ is in the file before allocating a buffer for it
+        void check_range(uint64_t offset, uint64_t size) {
+            hg_assert(offset <= std::numeric_limits<uint64_t>::max() - size, "Corrupted tree sequence file.");
+            if (size > 0) {
+                char last;
+                read(offset + size - 1, &last, 1);
+            }
+        }
+
+        void read_header() {
+            using namespace tree_sequence_io_internal;
+            char header[tree_sequence_io_internal::header_size];
+            read(0, header, tree_sequence_io_internal::header_size);
+            hg_assert(std::memcmp(header, HG_TREE_SEQUENCE_IO_MAGIC, 8) == 0, "Invalid tree sequence file.");
+            uint64_t fields[4];
+            std::memcpy(fields, header + 8, sizeof(fields));
+            hg_assert(fields[0] == HG_TREE_SEQUENCE_IO_VERSION, "Unsupported tree sequence file version.");
+            const uint64_t num_frames = fields[1];
+            m_keyframe_interval = (index_t) fields[2];
+            hg_assert(num_frames <= std::numeric_limits<uint64_t>::max() / sizeof(frame_entry),
+                      "Corrupted tree sequence file.");
+            if (num_frames > 0) {
+                check_range(fields[3], num_frames * sizeof(frame_entry));
+                m_frames.resize(num_frames);
+                read(fields[3], reinterpret_cast<char *>(m_frames.data()), num_frames * sizeof(frame_entry));
+                hg_assert(m_frames[0].keyframe != 0, "Corrupted tree sequence file.");
+            }
+        }
+
+        void decode_frame(index_t frame) {
+            using namespace tree_sequence_io_internal;
+            const auto &f = m_frames[frame];
+            const char *data;
+            if (m_in_memory) {
+                hg_assert(f.offset <= m_size && f.size <= m_size - f.offset, "Unexpected end of tree sequence buffer.");
+                data = m_buffer + f.offset;
+            } else {
+                check_range(f.offset, f.size);
+                m_frame_buffer.resize(f.size);
+                read(f.offset, m_frame_buffer.data(), f.size);
+                data = m_frame_buffer.data();
+            }
+            if (f.keyframe != 0) {
+                decode_keyframe(data, data + f.size, m_parents, m_num_leaves, m_altitudes);
+            } else {
+                decode_delta(data, data + f.size, m_parents, m_altitudes);
+            }
+        }
+
+        // true for a buffer reader, false for a stream reader
+        bool m_in_memory = false;
+        std::istream *m_in = nullptr;
+        std::streamoff m_start = 0;
+        const char *m_buffer = nullptr;
+        size_t m_size = 0;
+        std::shared_ptr<const void> m_owner;
+        index_t m_keyframe_interval = 0;
+        std::vector<tree_sequence_io_internal::frame_entry> m_frames;
+        // last decoded frame
+        index_t m_current_frame = invalid_index;
+        array_1d<index_t> m_parents;
+        array_1d<double> m_altitudes;
+        index_t m_num_leaves = 0;
+        std::vector<char> m_frame_buffer;
+    };
+
+    /**
+     * Save a sequence of trees with node altitudes, typically the hierarchies of the frames of a video, in the binary
+     * tree sequence format: frames are then appended to the returned writer with add_frame(tree, altitudes) before a
+     * call to finalize (which is also called by the destructor of the writer).
+     *
+     * Consecutive hierarchies of a video share most of their structure: a frame is thus stored as a keyframe every
+     * keyframe_interval frames and as a delta to the previous frame otherwise (unless the delta is larger than a
+     * keyframe, for example if the nodes are renumbered). Deltas are only compact if the nodes keep their indices from
+     * one frame to the next. A keyframe stores the parents as variable length integers (differences between the parent
+     * and the index of each node) and the altitudes with a XOR float encoding (xor of the bit patterns of the altitudes
+     * of consecutive nodes, without its zero bytes). A delta frame only stores the nodes whose parent or altitude
+     * changed: their indices and parent differences as variable length integers and their altitudes xor encoded with
+     * their previous values. A frame index at the end of the file gives the location of each frame, such that any frame
+     * can be read from its closest keyframe (see tree_sequence_reader): keyframe_interval bounds the number of deltas
+     * decoded to access a frame.
+     *
+     * Values are stored with the endianness of the machine.
+     *
+     * @param out output stream (opened in binary mode, must be seekable)
+     * @param keyframe_interval maximal number of frames between two keyframes
+     * @return a writer
+     */
+    inline
+    auto save_tree_sequence(std::ostream &out, index_t keyframe_interval = 16) {
+        return tree_sequence_io_internal::tree_sequence_writer(out, keyframe_interval);
+    }
+}
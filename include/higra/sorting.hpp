@@ -11,40 +11,169 @@
 #pragma once
 
 #include "structure/array.hpp"
+#include "structure/workspace.hpp"
+#include "detail/simd_dispatch.hpp"
+#include "utils.hpp"
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
 #ifdef HG_USE_TBB
 
 #include "tbb/parallel_sort.h"
+#include "tbb/task_arena.h"
 #include "tbb-ssort/parallel_stable_sort.h"
 
-#else
+#endif
 
 #include <algorithm>
-
-#endif
+#include <iterator>
 
 namespace hg {
 
+    namespace sorting_internal {
+
+        /**
+         * Policy of hg::sort and hg::stable_sort when no policy is given: arrays with less than 2^15 elements are
+         * sorted serially (below this size, the task spawning overhead of the parallel sorts is larger than the
+         * gain), and the blocks of parallel_merge_sort contain at least 2^14 elements.
+         *
+         * These values were chosen with benchmark_parallel_sort.cpp (BM_hg_sort_cutoff).
+         */
+        constexpr execution::parallel_policy default_sort_policy =
+                execution::par.with_grain_size(1 << 14).with_serial_cutoff(1 << 15);
 
+        /**
+         * Sorts the range [xs, xe) with the threads of the built-in thread pool (see parfor): the range is split
+         * into a power of 2 number of blocks sorted in parallel (with std::sort or std::stable_sort), which are then
+         * merged by pairs, in parallel, in log2(number of blocks) rounds alternating between the range and a buffer.
+         * Merges take the elements of the left block first in case of equality: the sort is stable if the blocks
+         * are sorted with std::stable_sort.
+         *
+         * @tparam stable
+         * @tparam RandomAccessIterator
+         * @tparam Compare
+         * @param xs
+         * @param xe
+         * @param comp
+         * @param min_block_size minimum number of elements of a block
+         */
+        template<bool stable, typename RandomAccessIterator, typename Compare>
+        void parallel_merge_sort(RandomAccessIterator xs, RandomAccessIterator xe, Compare comp,
+                                 index_t min_block_size = default_sort_policy.grain_size) {
+            using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+            const index_t size = xe - xs;
+            const index_t max_blocks = (std::min)(get_num_threads(), size / (std::max)((index_t) 1, min_block_size));
+            index_t num_blocks = 1;
+            while (num_blocks * 2 <= max_blocks) {
+                num_blocks *= 2;
+            }
+            if (num_blocks <= 1) {
+                if (stable) {
+                    std::stable_sort(xs, xe, comp);
+                } else {
+                    std::sort(xs, xe, comp);
+                }
+                return;
+            }
+
+            std::vector<index_t> bounds(num_blocks + 1);
+            for (index_t b = 0; b <= num_blocks; b++) {
+                bounds[b] = b * size / num_blocks;
+            }
+            parfor(0, num_blocks, [&xs, &bounds, &comp](index_t b) {
+                if (stable) {
+                    std::stable_sort(xs + bounds[b], xs + bounds[b + 1], comp);
+                } else {
+                    std::sort(xs + bounds[b], xs + bounds[b + 1], comp);
+                }
+            });
+
+            std::vector<value_type> buffer(size);
+            auto merge_round = [&bounds, &comp, num_blocks](auto src, auto dst, index_t width) {
+                parfor(0, num_blocks / (2 * width), [&bounds, &comp, src, dst, width](index_t p) {
+                    const index_t first = bounds[2 * p * width];
+                    const index_t middle = bounds[(2 * p + 1) * width];
+                    const index_t last = bounds[(2 * p + 2) * width];
+                    std::merge(std::make_move_iterator(src + first), std::make_move_iterator(src + middle),
+                               std::make_move_iterator(src + middle), std::make_move_iterator(src + last),
+                               dst + first, comp);
+                });
+            };
+            bool in_buffer = false;
+            for (index_t width = 1; width < num_blocks; width *= 2) {
+                if (in_buffer) {
+                    merge_round(buffer.begin(), xs, width);
+                } else {
+                    merge_round(xs, buffer.begin(), width);
+                }
+                in_buffer = !in_buffer;
+            }
+            if (in_buffer) {
+                parfor(0, num_blocks, [&xs, &bounds, &buffer](index_t b) {
+                    std::move(buffer.begin() + bounds[b], buffer.begin() + bounds[b + 1], xs + bounds[b]);
+                });
+            }
+        }
+    }
+
+    /**
+     * Parallel stable sort: ranges with less elements than policy.serial_cutoff are sorted serially. With the built-in
+     * thread pool, policy.grain_size is the minimum number of elements sorted by a task.
+     */
     template<typename RandomAccessIterator, typename Compare>
-    void stable_sort(RandomAccessIterator xs, RandomAccessIterator xe, Compare comp) {
+    void stable_sort(const execution::parallel_policy &policy, RandomAccessIterator xs, RandomAccessIterator xe,
+                     Compare comp) {
+        if (xe - xs < policy.serial_cutoff) {
+            std::stable_sort(xs, xe, comp);
+            return;
+        }
 #ifdef HG_USE_TBB
-        pss::parallel_stable_sort(xs, xe, comp);
+        parallel_internal::with_thread_limit([&]() {
+            pss::parallel_stable_sort(xs, xe, comp);
+        });
+#elif defined(HG_USE_THREAD_POOL)
+        sorting_internal::parallel_merge_sort<true>(xs, xe, comp, policy.grain_size);
 #else
         std::stable_sort(xs, xe, comp);
 #endif
     }
 
-
+    /**
+     * Parallel sort: ranges with less elements than policy.serial_cutoff are sorted serially. With the built-in
+     * thread pool, policy.grain_size is the minimum number of elements sorted by a task.
+     */
     template<typename RandomAccessIterator, typename Compare>
-    void sort(RandomAccessIterator xs, RandomAccessIterator xe, Compare comp) {
+    void sort(const execution::parallel_policy &policy, RandomAccessIterator xs, RandomAccessIterator xe,
+              Compare comp) {
+        if (xe - xs < policy.serial_cutoff) {
+            std::sort(xs, xe, comp);
+            return;
+        }
 #ifdef HG_USE_TBB
-        tbb::parallel_sort(xs, xe, comp);
+        parallel_internal::with_thread_limit([&]() {
+            tbb::parallel_sort(xs, xe, comp);
+        });
+#elif defined(HG_USE_THREAD_POOL)
+        sorting_internal::parallel_merge_sort<false>(xs, xe, comp, policy.grain_size);
 #else
         std::sort(xs, xe, comp);
 #endif
     }
 
+    template<typename RandomAccessIterator, typename Compare>
+    void stable_sort(RandomAccessIterator xs, RandomAccessIterator xe, Compare comp) {
+        hg::stable_sort(sorting_internal::default_sort_policy, xs, xe, comp);
+    }
+
+
+    template<typename RandomAccessIterator, typename Compare>
+    void sort(RandomAccessIterator xs, RandomAccessIterator xe, Compare comp) {
+        hg::sort(sorting_internal::default_sort_policy, xs, xe, comp);
+    }
+
 
     template<typename RandomAccessIterator>
     void stable_sort(RandomAccessIterator xs, RandomAccessIterator xe) {
@@ -116,9 +245,280 @@ return indices;
         return arg_sort(arrayx, std::less<typename T::value_type>());
     }
 
+    namespace sorting_internal {
+
+        /**
+         * Maps values of an arithmetic type to unsigned integer keys whose natural order is the same as the order of
+         * the values: the sign bit of signed integers is flipped, and the bits of negative (resp. positive) floating
+         * point values are all flipped (resp. only the sign bit is flipped).
+         * Negative zero is mapped to the same key as positive zero.
+         */
+        template<typename value_t, typename = void>
+        struct radix_key {
+            static const bool is_defined = false;
+        };
+
+        template<typename value_t>
+        struct radix_key<value_t, std::enable_if_t<std::is_integral<value_t>::value &&
+                                                   !std::is_same<value_t, bool>::value>> {
+            static const bool is_defined = true;
+            using key_type = std::make_unsigned_t<value_t>;
+
+            static key_type get(value_t value) {
+                constexpr key_type sign_bit = std::is_signed<value_t>::value ?
+                                              (key_type) ((key_type) 1 << (sizeof(key_type) * 8 - 1)) : 0;
+                return (key_type) ((key_type) value ^ sign_bit);
+            }
+        };
+
+        template<typename value_t>
+        struct radix_key<value_t, std::enable_if_t<std::is_floating_point<value_t>::value &&
+                                                   (sizeof(value_t) == 4 || sizeof(value_t) == 8)>> {
+            static const bool is_defined = true;
+            using key_type = std::conditional_t<sizeof(value_t) == 4, uint32_t, uint64_t>;
+
+            static key_type get(value_t value) {
+                constexpr key_type sign_bit = (key_type) 1 << (sizeof(key_type) * 8 - 1);
+                key_type bits;
+                std::memcpy(&bits, &value, sizeof(value_t));
+                if (bits == sign_bit) { // negative zero
+                    bits = 0;
+                }
+                return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+            }
+        };
+
+        /**
+         * True if stable_arg_sort with the comparison function comp_t on values of type value_t
+         * can be done with a radix sort (comp_t is std::less or std::greater)
+         */
+        template<typename value_t, typename comp_t>
+        struct is_radix_sortable : public std::false_type {
+        };
+
+        template<typename value_t>
+        struct is_radix_sortable<value_t, std::less<value_t>> :
+                public std::integral_constant<bool, radix_key<value_t>::is_defined> {
+        };
+
+        template<typename value_t>
+        struct is_radix_sortable<value_t, std::greater<value_t>> :
+                public std::integral_constant<bool, radix_key<value_t>::is_defined> {
+        };
+
+        /**
+         * Arrays smaller than this size are sorted with a comparison sort.
+         */
+        const index_t radix_sort_min_size = 64;
+
+        /**
+         * Number of blocks processed in parallel by a radix sort pass: each block computes its own histogram
+         * of digits and then scatters its elements independently.
+         */
+        inline
+        index_t radix_sort_num_blocks(index_t size, index_t num_buckets) {
+            index_t max_blocks = get_num_threads();
+            index_t min_block_size = (std::max)((index_t) 16384, 4 * num_buckets);
+            return (std::max)((index_t) 1, (std::min)(max_blocks, size / min_block_size));
+        }
+
+        /**
+         * Stable least significant digit radix arg sort of the given keys.
+         *
+         * Keys of 8 bits and keys of 16 bits (for large arrays) are sorted in a single counting sort pass,
+         * larger keys are sorted by digits of 11 bits. Passes where all the keys share the same digit are skipped.
+         *
+         * The passes alternate between the given buffers: the sorted indices end up either in indices or in
+         * tmp_indices.
+         *
+         * @tparam key_t unsigned integer type
+         * @param keys keys to sort (modified)
+         * @param tmp_keys buffer of the size of keys
+         * @param indices buffer of the size of keys
+         * @param tmp_indices buffer of the size of keys
+         * @param size number of keys
+         * @return the buffer (indices or tmp_indices) containing the indices that sort the keys in increasing order
+         */
+        template<typename key_t>
+        index_t *radix_arg_sort(key_t *keys, key_t *tmp_keys, index_t *indices, index_t *tmp_indices,
+                                const index_t size) {
+            static_assert(std::is_unsigned<key_t>::value, "Radix sort keys must be unsigned integers.");
+            const index_t key_bits = sizeof(key_t) * 8;
+            const index_t digit_bits = (sizeof(key_t) == 1) ? 8 :
+                                       (sizeof(key_t) == 2) ? ((size >= (1 << 16)) ? 16 : 8) :
+                                       11;
+            const index_t num_buckets = (index_t) 1 << digit_bits;
+            const index_t num_passes = (key_bits + digit_bits - 1) / digit_bits;
+            const index_t num_blocks = radix_sort_num_blocks(size, num_buckets);
+            const index_t block_size = (size + num_blocks - 1) / num_blocks;
+
+            workspace_vector<index_t> offsets(num_blocks * num_buckets);
+            // indices are implicitly equal to the identity until the first non trivial pass
+            bool identity = true;
+
+            for (index_t pass = 0; pass < num_passes; pass++) {
+                const index_t shift = pass * digit_bits;
+                const key_t mask = (key_t) (num_buckets - 1);
+                std::fill(offsets.begin(), offsets.end(), 0);
+
+                parfor(0, num_blocks, [&](index_t b) {
+                    auto histogram = offsets.data() + b * num_buckets;
+                    const index_t end = (std::min)(size, (b + 1) * block_size);
+                    for (index_t i = b * block_size; i < end; i++) {
+                        histogram[(keys[i] >> shift) & mask]++;
+                    }
+                });
+
+                // exclusive prefix sum in (bucket, block) order ensures stability
+                index_t sum = 0;
+                bool trivial_pass = false;
+                for (index_t d = 0; d < num_buckets && !trivial_pass; d++) {
+                    index_t bucket_start = sum;
+                    for (index_t b = 0; b < num_blocks; b++) {
+                        auto &count = offsets[b * num_buckets + d];
+                        auto tmp = count;
+                        count = sum;
+                        sum += tmp;
+                    }
+                    trivial_pass = (bucket_start == 0 && sum == size);
+                }
+                if (trivial_pass) {
+                    continue;
+                }
+
+                const bool last_pass = pass == num_passes - 1;
+                parfor(0, num_blocks, [&](index_t b) {
+                    auto offset = offsets.data() + b * num_buckets;
+                    const index_t end = (std::min)(size, (b + 1) * block_size);
+                    for (index_t i = b * block_size; i < end; i++) {
+                        auto position = offset[(keys[i] >> shift) & mask]++;
+                        if (!last_pass) {
+                            tmp_keys[position] = keys[i];
+                        }
+                        tmp_indices[position] = identity ? i : indices[i];
+                    }
+                });
+                identity = false;
+                std::swap(keys, tmp_keys);
+                std::swap(indices, tmp_indices);
+            }
+            if (identity) {
+                std::iota(indices, indices + size, 0);
+            }
+            return indices;
+        }
+
+        template<typename T, typename Compare>
+        index_t *stable_arg_sort_buffers_impl(const T &array, index_t *indices, index_t *, Compare comp,
+                                              std::false_type) {
+            std::iota(indices, indices + array.size(), 0);
+            hg::stable_sort(indices, indices + array.size(),
+                            [&array, &comp](index_t i, index_t j) { return comp(array(i), array(j)); });
+            return indices;
+        }
+
+        /**
+         * keys[i] = radix key of values[i] for i in [0, size[ (bitwise negated if descending is true)
+         */
+        template<typename value_t, typename key_t>
+        HG_SIMD_DISPATCH
+        void radix_keys(const value_t *values, key_t *keys, index_t size, bool descending) {
+            const key_t mask = descending ? (key_t) ~(key_t) 0 : (key_t) 0;
+            for (index_t i = 0; i < size; i++) {
+                keys[i] = (key_t) (radix_key<value_t>::get(values[i]) ^ mask);
+            }
+        }
+
+        template<typename T, typename key_t>
+        void compute_radix_keys(const T &array, key_t *keys, bool descending, std::false_type /* has data interface */) {
+            using key_traits = radix_key<typename T::value_type>;
+            parfor(0, array.size(), [&array, keys, descending](index_t i) {
+                auto key = key_traits::get(array(i));
+                keys[i] = descending ? (key_t) ~key : key;
+            });
+        }
+
+        template<typename T, typename key_t>
+        void compute_radix_keys(const T &array, key_t *keys, bool descending, std::true_type /* has data interface */) {
+            const index_t size = array.size();
+            if (size > 1 && array.strides()[0] != 1) {
+                compute_radix_keys(array, keys, descending, std::false_type());
+                return;
+            }
+            // the keys are computed by chunks of contiguous elements (vectorized kernel)
+            const index_t chunk_size = 4096;
+            const auto values = array.data() + array.data_offset();
+            parfor(0, size, [values, keys, size, descending, chunk_size](index_t i) {
+                radix_keys(values + i, keys + i, (std::min)(chunk_size, size - i), descending);
+            }, chunk_size);
+        }
+
+        template<typename T, typename Compare>
+        index_t *stable_arg_sort_buffers_impl(const T &array, index_t *indices, index_t *tmp_indices, Compare,
+                                              std::true_type) {
+            using value_type = typename T::value_type;
+            using key_traits = radix_key<value_type>;
+            using key_type = typename key_traits::key_type;
+            const bool descending = std::is_same<Compare, std::greater<value_type>>::value;
+
+            workspace_vector<key_type> keys(array.size());
+            workspace_vector<key_type> tmp_keys(array.size());
+            compute_radix_keys(array, keys.data(), descending, xt::has_data_interface<T>());
+            return radix_arg_sort(keys.data(), tmp_keys.data(), indices, tmp_indices, (index_t) array.size());
+        }
+
+        /**
+         * Stable arg sort of the 1d array into the given buffers, which must have the size of the array. Arrays of
+         * arithmetic values compared with std::less or std::greater are radix sorted: the temporary keys are then
+         * drawn from the active workspace (see workspace.hpp).
+         *
+         * @return the buffer (indices or tmp_indices) containing the sorted indices
+         */
+        template<typename T, typename Compare>
+        index_t *stable_arg_sort_buffers(const T &array, index_t *indices, index_t *tmp_indices, Compare comp) {
+            return stable_arg_sort_buffers_impl(array, indices, tmp_indices, comp,
+                                                is_radix_sortable<typename T::value_type, Compare>());
+        }
+
+        template<typename T, typename Compare>
+        auto stable_arg_sort_impl(const xt::xexpression<T> &arrayx, Compare comp, std::false_type) {
+            HIGRA_ARG_SORT(hg::stable_sort);
+        }
+
+        template<typename T, typename Compare>
+        auto stable_arg_sort_impl(const xt::xexpression<T> &arrayx, Compare comp, std::true_type) {
+            auto &array = arrayx.derived_cast();
+            if (array.dimension() != 1 || (index_t) array.size() < radix_sort_min_size) {
+                return stable_arg_sort_impl(arrayx, comp, std::false_type());
+            }
+            array_1d<index_t> indices = array_1d<index_t>::from_shape({array.size()});
+            array_1d<index_t> tmp_indices = array_1d<index_t>::from_shape({array.size()});
+            auto sorted = stable_arg_sort_buffers_impl(array, indices.data(), tmp_indices.data(), comp,
+                                                       std::true_type());
+            if (sorted != indices.data()) {
+                std::swap(indices, tmp_indices);
+            }
+            return indices;
+        }
+    }
+
+    /**
+     * Stable arg sort of a 1d or 2d array (lexicographic order on rows).
+     *
+     * If the values of the array are integral or floating point numbers and if the comparison function is
+     * std::less or std::greater, 1d arrays are sorted with a stable radix sort (parallelised with TBB if available).
+     * Otherwise, a comparison based stable sort is used.
+     *
+     * @tparam T
+     * @tparam Compare
+     * @param arrayx
+     * @param comp
+     * @return
+     */
     template<typename T, typename Compare>
     auto stable_arg_sort(const xt::xexpression<T> &arrayx, Compare comp) {
-        HIGRA_ARG_SORT(hg::stable_sort);
+        return sorting_internal::stable_arg_sort_impl(
+                arrayx, comp, sorting_internal::is_radix_sortable<typename T::value_type, Compare>());
     }
 
     template<typename T>
@@ -126,5 +526,167 @@ return indices;
         return stable_arg_sort(arrayx, std::less<typename T::value_type>());
     }
 
+    /**
+     * Number of maximal non decreasing runs of the given 1d array (according to the comparison function comp): 0 if
+     * the array is empty, 1 if it is sorted.
+     *
+     * @tparam T
+     * @tparam Compare
+     * @param arrayx
+     * @param comp
+     * @return
+     */
+    template<typename T, typename Compare>
+    index_t count_sorted_runs(const xt::xexpression<T> &arrayx, Compare comp) {
+        auto &array = arrayx.derived_cast();
+        hg_assert_1d_array(array);
+        const index_t size = array.size();
+        if (size == 0) {
+            return 0;
+        }
+        index_t num_runs = 1;
+        for (index_t i = 1; i < size; i++) {
+            if (comp(array(i), array(i - 1))) {
+                num_runs++;
+            }
+        }
+        return num_runs;
+    }
+
+    template<typename T>
+    index_t count_sorted_runs(const xt::xexpression<T> &arrayx) {
+        return count_sorted_runs(arrayx, std::less<typename T::value_type>());
+    }
+
+    /**
+     * Stable arg sort of a 1d array made of a few non decreasing runs (natural merge sort).
+     *
+     * The maximal non decreasing runs of the array are merged pairwise, the merges of a pass being done in parallel:
+     * the complexity is in :math:`\mathcal{O}(n\log(r))` with :math:`n` the size of the array and :math:`r` its number
+     * of runs (see count_sorted_runs). This is faster than stable_arg_sort when the array is almost sorted, for
+     * example an array made of two sorted parts is sorted in linear time.
+     *
+     * @tparam T
+     * @tparam Compare
+     * @param arrayx
+     * @param comp
+     * @return
+     */
+    template<typename T, typename Compare>
+    auto stable_arg_sort_runs(const xt::xexpression<T> &arrayx, Compare comp) {
+        auto &array = arrayx.derived_cast();
+        hg_assert_1d_array(array);
+        const index_t size = array.size();
+
+        std::vector<index_t> run_starts;
+        for (index_t i = 0; i < size; i++) {
+            if (i == 0 || comp(array(i), array(i - 1))) {
+                run_starts.push_back(i);
+            }
+        }
+        run_starts.push_back(size);
+
+        array_1d<index_t> indices = xt::arange<index_t>(size);
+        array_1d<index_t> tmp_indices = array_1d<index_t>::from_shape({(size_t) size});
+        auto index_comp = [&array, &comp](index_t i, index_t j) {
+            return comp(array(i), array(j));
+        };
+
+        while (run_starts.size() > 2) {
+            const index_t num_runs = run_starts.size() - 1;
+            parfor(0, (num_runs + 1) / 2, [&](index_t k) {
+                auto begin = indices.data() + run_starts[2 * k];
+                auto middle = indices.data() + run_starts[(std::min)(2 * k + 1, num_runs)];
+                auto end = indices.data() + run_starts[(std::min)(2 * k + 2, num_runs)];
+                // std::merge takes equivalent elements from the first range first: the merge is stable
+                std::merge(begin, middle, middle, end, tmp_indices.data() + run_starts[2 * k], index_comp);
+            });
+            std::swap(indices, tmp_indices);
+            index_t num_merged_runs = 0;
+            for (index_t k = 0; k < num_runs; k += 2) {
+                run_starts[num_merged_runs++] = run_starts[k];
+            }
+            run_starts[num_merged_runs] = size;
+            run_starts.resize(num_merged_runs + 1);
+        }
+        return indices;
+    }
+
+    template<typename T>
+    auto stable_arg_sort_runs(const xt::xexpression<T> &arrayx) {
+        return stable_arg_sort_runs(arrayx, std::less<typename T::value_type>());
+    }
+
+    /**
+     * Stable arg sort of a 1d array starting from an initial order of its elements, typically the result of the
+     * stable arg sort of a previous version of the array whose values have only slightly changed (for example the
+     * edge weights of the previous frame of a video). The result is identical to the one of stable_arg_sort.
+     *
+     * The initial order is scanned to extract a sorted sub sequence: when an element is smaller than the last
+     * element of the sub sequence, both are removed (the number of removed elements is then at most twice the minimum
+     * number of elements to remove to obtain a sorted sub sequence). The removed elements are then sorted and merged
+     * with the sub sequence. The complexity is in :math:`\mathcal{O}(n + k\log(k))` with :math:`n` the size of the
+     * array and :math:`k` the number of removed elements: the cost depends on how much the order has changed. If
+     * more than n / max_removed_ratio elements have to be removed, the array is sorted with stable_arg_sort instead.
+     *
+     * @tparam T1
+     * @tparam T2
+     * @tparam Compare
+     * @param arrayx 1d array to sort
+     * @param xinitial_order permutation of the indices of the array (if it is empty, stable_arg_sort is used)
+     * @param comp comparison function
+     * @param max_removed_ratio
+     * @return
+     */
+    template<typename T1, typename T2, typename Compare>
+    auto stable_arg_sort_warm_start(const xt::xexpression<T1> &arrayx,
+                                    const xt::xexpression<T2> &xinitial_order,
+                                    Compare comp,
+                                    index_t max_removed_ratio = 8) {
+        HG_TRACE();
+        auto &array = arrayx.derived_cast();
+        auto &initial_order = xinitial_order.derived_cast();
+        hg_assert_1d_array(array);
+        hg_assert_1d_array(initial_order);
+        const index_t size = array.size();
+        if (initial_order.size() == 0) {
+            return array_1d<index_t>(stable_arg_sort(array, comp));
+        }
+        hg_assert((index_t) initial_order.size() == size,
+                  "The initial order must have the same size as the array to sort.");
+
+        // strict total order on the indices: ties between values are broken by indices
+        auto less = [&array, &comp](index_t i, index_t j) {
+            return comp(array(i), array(j)) || (!comp(array(j), array(i)) && i < j);
+        };
+
+        array_1d<index_t> kept = array_1d<index_t>::from_shape({(size_t) size});
+        index_t num_kept = 0;
+        workspace_vector<index_t> removed;
+        const index_t max_removed = size / (std::max)(max_removed_ratio, (index_t) 1);
+        for (index_t k = 0; k < size; k++) {
+            const index_t i = initial_order(k);
+            if (num_kept > 0 && less(i, kept(num_kept - 1))) {
+                removed.push_back(i);
+                removed.push_back(kept(--num_kept));
+                if ((index_t) removed.size() > max_removed) {
+                    return array_1d<index_t>(stable_arg_sort(array, comp));
+                }
+            } else {
+                kept(num_kept++) = i;
+            }
+        }
+
+        hg::sort(removed.begin(), removed.end(), less);
+        array_1d<index_t> result = array_1d<index_t>::from_shape({(size_t) size});
+        std::merge(kept.begin(), kept.begin() + num_kept, removed.begin(), removed.end(), result.begin(), less);
+        return result;
+    }
+
+    template<typename T1, typename T2>
+    auto stable_arg_sort_warm_start(const xt::xexpression<T1> &arrayx, const xt::xexpression<T2> &xinitial_order) {
+        return stable_arg_sort_warm_start(arrayx, xinitial_order, std::less<typename T1::value_type>());
+    }
+
 #undef HIGRA_ARG_SORT
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "../detail/memory_tracking.hpp"
 #include "xtensor/xarray.hpp"
 #include "xtensor/xtensor.hpp"
 #include "xtensor/xgenerator.hpp"
@@ -36,4 +37,70 @@ namespace hg {
 
     template<typename value_t>
     using array_nd = xt::xarray<value_t>;
+
+    /**
+     * Array of the given shape whose elements are all equal to value. Contrarily to xt::full or xt::ones, the
+     * elements are initialized in parallel (see parallel_fill) such that the pages of a large array are spread over
+     * the memory nodes of the threads that will process it.
+     *
+     * Example:
+     *
+     *     auto size = parallel_full<array_1d<index_t>>({num_nodes}, 1);
+     *
+     * @tparam array_t type of the result (array_1d, array_nd...)
+     * @tparam shape_t
+     * @param shape shape of the result
+     * @param value fill value
+     * @return
+     */
+    template<typename array_t, typename shape_t = typename array_t::shape_type>
+    array_t parallel_full(const shape_t &shape, const typename array_t::value_type &value) {
+        array_t result = array_t::from_shape(shape);
+        parallel_fill(result.data(), (index_t) result.size(), value);
+        return result;
+    }
+
+    /**
+     * Array of the given shape filled with zeros in parallel (see parallel_full).
+     *
+     * @tparam array_t type of the result (array_1d, array_nd...)
+     * @tparam shape_t
+     * @param shape shape of the result
+     * @return
+     */
+    template<typename array_t, typename shape_t = typename array_t::shape_type>
+    array_t parallel_zeros(const shape_t &shape) {
+        return parallel_full<array_t>(shape, typename array_t::value_type(0));
+    }
+
+    namespace array_internal {
+
+        template<typename T>
+        const typename T::value_type *row_major_data(const T &array,
+                                                     array_nd<typename T::value_type> &buffer,
+                                                     std::true_type /* has data interface */) {
+            if (array.layout() == xt::layout_type::row_major) {
+                return array.data() + array.data_offset();
+            }
+            buffer = array;
+            return buffer.data();
+        }
+
+        template<typename T>
+        const typename T::value_type *row_major_data(const T &array,
+                                                     array_nd<typename T::value_type> &buffer,
+                                                     std::false_type /* has data interface */) {
+            buffer = array;
+            return buffer.data();
+        }
+    }
+
+    /**
+     * Pointer to the elements of the given array in row major order: if the array does not provide a row major
+     * data interface, its elements are first copied into buffer.
+     */
+    template<typename T>
+    const typename T::value_type *row_major_data(const T &array, array_nd<typename T::value_type> &buffer) {
+        return array_internal::row_major_data(array, buffer, xt::has_data_interface<T>());
+    }
 }
@@ -0,0 +1,423 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "details/graph_concepts.hpp"
+#include "details/indexed_edge.hpp"
+#include "higra/structure/details/iterators.hpp"
+#include "higra/structure/array.hpp"
+#include <memory>
+#include <vector>
+
+namespace hg {
+
+    namespace csr_graph_internal {
+
+        struct csr_graph_traversal_category :
+                virtual public graph::incidence_graph_tag,
+                virtual public graph::bidirectional_graph_tag,
+                virtual public graph::adjacency_graph_tag,
+                virtual public graph::vertex_list_graph_tag,
+                virtual public graph::edge_list_graph_tag {
+        };
+
+        template<typename vertex_descriptor, typename edge_index_t>
+        struct out_edge {
+            vertex_descriptor adjacent_vertex;
+            edge_index_t index;
+        };
+
+        /**
+         * Iterator on the out edges (or in edges if in_edges is true) of a vertex
+         */
+        template<typename edge_descriptor, typename out_edge_t, bool in_edges>
+        struct incident_edge_iterator :
+                public forward_iterator_facade<incident_edge_iterator<edge_descriptor, out_edge_t, in_edges>,
+                        edge_descriptor> {
+
+            using self_type = incident_edge_iterator<edge_descriptor, out_edge_t, in_edges>;
+
+            incident_edge_iterator(index_t vertex, const out_edge_t *position) :
+                    m_vertex(vertex), m_position(position) {}
+
+            void increment() {
+                m_position++;
+            }
+
+            bool equal(const self_type &other) const {
+                return m_position == other.m_position;
+            }
+
+            edge_descriptor dereference() const {
+                if (in_edges) {
+                    return edge_descriptor(m_position->adjacent_vertex, m_vertex, m_position->index);
+                } else {
+                    return edge_descriptor(m_vertex, m_position->adjacent_vertex, m_position->index);
+                }
+            }
+
+        private:
+            index_t m_vertex;
+            const out_edge_t *m_position;
+        };
+
+        /**
+         * Iterator on the adjacent vertices of a vertex
+         */
+        template<typename out_edge_t>
+        struct adjacent_vertex_iterator :
+                public forward_iterator_facade<adjacent_vertex_iterator<out_edge_t>, index_t> {
+
+            using self_type = adjacent_vertex_iterator<out_edge_t>;
+
+            adjacent_vertex_iterator(const out_edge_t *position) :
+                    m_position(position) {}
+
+            void increment() {
+                m_position++;
+            }
+
+            bool equal(const self_type &other) const {
+                return m_position == other.m_position;
+            }
+
+            index_t dereference() const {
+                return m_position->adjacent_vertex;
+            }
+
+        private:
+            const out_edge_t *m_position;
+        };
+
+        /**
+         * Immutable undirected graph with a compressed sparse row (CSR) storage of the out edges.
+         *
+         * The out edges of all the vertices are stored contiguously in a single array: the out edges of the vertex v
+         * are stored between positions offsets[v] and offsets[v + 1]. Each out edge stores the adjacent vertex and the
+         * edge index, so that traversing the neighbourhood of a vertex does not require any random access to the edge
+         * list.
+         *
+         * Edges are indexed as in the undirected_graph class (the source of an edge is its extremity of smallest index),
+         * and the out edges of each vertex are stored in increasing edge index order: algorithms thus traverse a csr_graph
+         * in the same order as the undirected_graph it has been built from.
+         *
+         * The three arrays (edges, offsets and out edges) are immutable and shared by the copies of a graph: they are
+         * either owned by the graph or stored in an external buffer, for example a memory mapped graph file (see
+         * graph_file_reader::read_csr_graph).
+         */
+        struct csr_graph {
+
+            // Graph associated types
+            using vertex_descriptor = index_t;
+            using edge_index_t = index_t;
+            using edge_descriptor = indexed_edge<vertex_descriptor, edge_index_t>;
+            using out_edge_t = out_edge<vertex_descriptor, edge_index_t>;
+            using directed_category = graph::undirected_tag;
+            using edge_parallel_category = graph::allow_parallel_edge_tag;
+            using traversal_category = csr_graph_traversal_category;
+
+            // VertexListGraph associated types
+            using vertex_iterator = counting_iterator<vertex_descriptor>;
+            using vertices_size_type = size_t;
+
+            // EdgeListGraph associated types
+            using edges_size_type = size_t;
+            using edge_iterator = const edge_descriptor *;
+
+            // IncidenceGraph associated types
+            using out_edge_iterator = incident_edge_iterator<edge_descriptor, out_edge_t, false>;
+            using degree_size_type = size_t;
+
+            //BidirectionalGraph associated types
+            using in_edge_iterator = incident_edge_iterator<edge_descriptor, out_edge_t, true>;
+
+            //AdjacencyGraph associated types
+            using adjacency_iterator = csr_graph_internal::adjacent_vertex_iterator<out_edge_t>;
+
+            csr_graph() {
+                auto storage = std::make_shared<csr_storage>();
+                storage->offsets.push_back(0);
+                set_storage(std::move(storage));
+            }
+
+            /**
+             * Create a graph with the given number of vertices and the edges (sources(i), targets(i)).
+             *
+             * @param num_vertices number of vertices of the graph
+             * @param xsources 1d array of integral values
+             * @param xtargets 1d array of integral values of the same size as xsources
+             */
+            template<typename T1, typename T2>
+            csr_graph(const size_t num_vertices,
+                      const xt::xexpression<T1> &xsources,
+                      const xt::xexpression<T2> &xtargets) {
+                auto &sources = xsources.derived_cast();
+                auto &targets = xtargets.derived_cast();
+                hg_assert_1d_array(sources);
+                hg_assert_integral_value_type(sources);
+                hg_assert_same_shape(sources, targets);
+
+                auto storage = std::make_shared<csr_storage>();
+                auto &edges = storage->edges;
+                auto &offsets = storage->offsets;
+                auto &out_edges = storage->out_edges;
+
+                index_t num_e = sources.size();
+                edges.reserve(num_e);
+                offsets.resize(num_vertices + 1, 0);
+                for (index_t i = 0; i < num_e; i++) {
+                    index_t v1 = sources(i);
+                    index_t v2 = targets(i);
+                    hg_assert(v1 >= 0 && v1 < (index_t) num_vertices && v2 >= 0 && v2 < (index_t) num_vertices,
+                              "Invalid vertex index.");
+                    if (v1 > v2) {
+                        std::swap(v1, v2);
+                    }
+                    edges.emplace_back(v1, v2, i);
+                    offsets[v1 + 1]++;
+                    if (v1 != v2) {
+                        offsets[v2 + 1]++;
+                    }
+                }
+
+                for (index_t v = 0; v < (index_t) num_vertices; v++) {
+                    offsets[v + 1] += offsets[v];
+                }
+
+                out_edges.resize(offsets[num_vertices]);
+                std::vector<index_t> positions(offsets.begin(), offsets.end() - 1);
+                for (const auto &e: edges) {
+                    out_edges[positions[e.source]++] = {e.target, e.index};
+                    if (e.source != e.target) {
+                        out_edges[positions[e.target]++] = {e.source, e.index};
+                    }
+                }
+                set_storage(std::move(storage));
+            }
+
+            /**
+             * Creates a graph on external read-only buffers holding its compressed sparse row representation, without
+             * copying them (for example a memory mapped file): the buffers are typically obtained from the functions
+             * edges_data, offsets_data and out_edges_data of another csr_graph.
+             *
+             * The buffers are trusted to describe a valid graph and are not read during the construction. They must
+             * not be modified during the lifetime of the graph (and of its copies, which share the same buffers). The
+             * object owner is kept alive as long as the buffers are used by a graph.
+             *
+             * @param num_vertices number of vertices of the graph
+             * @param edges array of num_edges edges, the edge i having the index i
+             * @param num_edges number of edges of the graph
+             * @param offsets array of num_vertices + 1 offsets in the out edges array
+             * @param out_edges array of offsets[num_vertices] out edges
+             * @param owner object owning the buffers (can be nullptr if the buffers outlive the graph)
+             */
+            csr_graph(size_t num_vertices,
+                      const edge_descriptor *edges,
+                      size_t num_edges,
+                      const index_t *offsets,
+                      const out_edge_t *out_edges,
+                      std::shared_ptr<const void> owner) :
+                    m_owner(std::move(owner)),
+                    m_edges(edges),
+                    m_num_edges(num_edges),
+                    m_offsets(offsets),
+                    m_num_vertices(num_vertices),
+                    m_out_edges(out_edges) {
+            }
+
+            vertices_size_type num_vertices() const {
+                return m_num_vertices;
+            }
+
+            edges_size_type num_edges() const {
+                return m_num_edges;
+            }
+
+            degree_size_type degree(vertex_descriptor v) const {
+                return m_offsets[v + 1] - m_offsets[v];
+            }
+
+            const auto &edge_from_index(index_t i) const {
+                return m_edges[i];
+            }
+
+            edge_iterator edges_cbegin() const {
+                return m_edges;
+            }
+
+            edge_iterator edges_cend() const {
+                return m_edges + m_num_edges;
+            }
+
+            const out_edge_t *out_edges_cbegin(vertex_descriptor v) const {
+                return m_out_edges + m_offsets[v];
+            }
+
+            const out_edge_t *out_edges_cend(vertex_descriptor v) const {
+                return m_out_edges + m_offsets[v + 1];
+            }
+
+            /**
+             * Contiguous array of the num_edges() edges of the graph
+             */
+            const edge_descriptor *edges_data() const {
+                return m_edges;
+            }
+
+            /**
+             * Contiguous array of the num_vertices() + 1 offsets of the out edges of the vertices
+             */
+            const index_t *offsets_data() const {
+                return m_offsets;
+            }
+
+            /**
+             * Contiguous array of the out edges of all the vertices (offsets_data()[num_vertices()] elements)
+             */
+            const out_edge_t *out_edges_data() const {
+                return m_out_edges;
+            }
+
+            auto sources() const {
+                return HG_ADAPT_STRUCT_ARRAY(m_edges, source, num_edges());
+            }
+
+            auto targets() const {
+                return HG_ADAPT_STRUCT_ARRAY(m_edges, target, num_edges());
+            }
+
+        private:
+
+            struct csr_storage {
+                std::vector<edge_descriptor> edges;
+                std::vector<index_t> offsets;
+                std::vector<out_edge_t> out_edges;
+            };
+
+            void set_storage(std::shared_ptr<csr_storage> storage) {
+                m_edges = storage->edges.data();
+                m_num_edges = storage->edges.size();
+                m_offsets = storage->offsets.data();
+                m_num_vertices = storage->offsets.size() - 1;
+                m_out_edges = storage->out_edges.data();
+                m_owner = std::move(storage);
+            }
+
+            std::shared_ptr<const void> m_owner;
+            const edge_descriptor *m_edges;
+            size_t m_num_edges;
+            const index_t *m_offsets;
+            size_t m_num_vertices;
+            const out_edge_t *m_out_edges;
+        };
+    }
+
+    using csr_graph = csr_graph_internal::csr_graph;
+
+    namespace graph {
+        template<>
+        struct graph_traits<hg::csr_graph> {
+            using G = hg::csr_graph;
+
+            using vertex_descriptor = typename G::vertex_descriptor;
+            using edge_descriptor = typename G::edge_descriptor;
+            using edge_iterator = typename G::edge_iterator;
+            using out_edge_iterator = typename G::out_edge_iterator;
+
+            using directed_category = typename G::directed_category;
+            using edge_parallel_category = typename G::edge_parallel_category;
+            using traversal_category = typename G::traversal_category;
+
+            using degree_size_type = typename G::degree_size_type;
+
+            using in_edge_iterator = typename G::in_edge_iterator;
+            using vertex_iterator = typename G::vertex_iterator;
+            using vertices_size_type = typename G::vertices_size_type;
+            using edges_size_type = typename G::edges_size_type;
+            using adjacency_iterator = typename G::adjacency_iterator;
+
+            using edge_index = typename G::edge_index_t;
+        };
+    }
+
+    inline
+    const auto &edge_from_index(const csr_graph::edge_index_t i, const csr_graph &g) {
+        return g.edge_from_index(i);
+    }
+
+    inline
+    csr_graph::vertices_size_type num_vertices(const csr_graph &g) {
+        return g.num_vertices();
+    }
+
+    inline
+    csr_graph::edges_size_type num_edges(const csr_graph &g) {
+        return g.num_edges();
+    }
+
+    inline
+    csr_graph::degree_size_type degree(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        return g.degree(v);
+    }
+
+    inline
+    csr_graph::degree_size_type in_degree(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        return g.degree(v);
+    }
+
+    inline
+    csr_graph::degree_size_type out_degree(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        return g.degree(v);
+    }
+
+    inline
+    std::pair<csr_graph::vertex_iterator, csr_graph::vertex_iterator>
+    vertices(const csr_graph &g) {
+        return std::make_pair(
+                csr_graph::vertex_iterator(0),                 // The first iterator position
+                csr_graph::vertex_iterator(num_vertices(g))); // The last iterator position
+    }
+
+    inline
+    std::pair<csr_graph::edge_iterator, csr_graph::edge_iterator>
+    edges(const csr_graph &g) {
+        return std::make_pair(
+                g.edges_cbegin(),                 // The first iterator position
+                g.edges_cend()); // The last iterator position
+    }
+
+    inline
+    std::pair<csr_graph::out_edge_iterator, csr_graph::out_edge_iterator>
+    out_edges(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        using it = csr_graph::out_edge_iterator;
+        return std::make_pair(
+                it(v, g.out_edges_cbegin(v)),
+                it(v, g.out_edges_cend(v)));
+    }
+
+    inline
+    std::pair<csr_graph::in_edge_iterator, csr_graph::in_edge_iterator>
+    in_edges(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        using it = csr_graph::in_edge_iterator;
+        return std::make_pair(
+                it(v, g.out_edges_cbegin(v)),
+                it(v, g.out_edges_cend(v)));
+    }
+
+    inline
+    std::pair<csr_graph::adjacency_iterator, csr_graph::adjacency_iterator>
+    adjacent_vertices(csr_graph::vertex_descriptor v, const csr_graph &g) {
+        using it = csr_graph::adjacency_iterator;
+        return std::make_pair(
+                it(g.out_edges_cbegin(v)),
+                it(g.out_edges_cend(v)));
+    }
+}
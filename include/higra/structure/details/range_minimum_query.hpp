@@ -11,16 +11,69 @@
 #pragma once
 
 #include "higra/structure/array.hpp"
+#include "shared_array.hpp"
+#include "../../detail/simd_dispatch.hpp"
 #include <vector>
 
 #ifdef _MSC_VER
 #include <intrin.h>
 #pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_BitScanForward64)
 #endif
 
 namespace hg {
 
     namespace range_minimum_query_internal {
+
+        // blocks are preprocessed by tasks of at least 64 blocks, small arrays are preprocessed serially
+        constexpr execution::parallel_policy block_parallel_policy =
+                execution::par.with_grain_size(64).with_serial_cutoff(256);
+
+        /**
+         * Level lvl + 1 of a sparse table on the elements [begin, end) from its level lvl:
+         * next[i] = argmin(data[previous[i]], data[previous[i + offset]]) with offset = 2^lvl.
+         */
+        template<typename data_t>
+        HG_SIMD_DISPATCH
+        void sparse_table_next_level(const data_t *data,
+                                     const size_t *previous,
+                                     size_t *next,
+                                     index_t offset,
+                                     index_t begin,
+                                     index_t end) {
+            for (index_t i = begin; i < end; i++) {
+                auto p1 = previous[i];
+                auto p2 = previous[i + offset];
+                next[i] = data[p1] < data[p2] ? p1 : p2;
+            }
+        }
+
+        /**
+         * Position of a minimum of data[begin, end) (precondition begin < end): the minimum value is found with a
+         * vectorized reduction, and its first position with a scan by chunks of 16 elements.
+         */
+        template<typename data_t>
+        HG_SIMD_DISPATCH
+        index_t range_argmin(const data_t *data, index_t begin, index_t end) {
+            data_t minimum = data[begin];
+            for (index_t i = begin + 1; i < end; i++) {
+                minimum = data[i] < minimum ? data[i] : minimum;
+            }
+            index_t i = begin;
+            for (; i + 16 <= end; i += 16) {
+                bool found = false;
+                for (index_t j = 0; j < 16; j++) {
+                    found |= data[i + j] == minimum;
+                }
+                if (found) {
+                    break;
+                }
+            }
+            while (data[i] != minimum) {
+                i++;
+            }
+            return i;
+        }
         /*
          * The 2 following classes rmq_sparse_table and rmq_sparse_table_block are freely adapted from
          * https://github.com/wx-csy/librmq (release 2.0 on Jul 28, 2019, commit 32bac30f1a1e1debf482a0477098bd0db203d849)
@@ -68,23 +121,17 @@ namespace hg {
             template<typename T>
             rmq_sparse_table(const T &values) : m_data(values.data()) {
                 index_t size = values.size();
-                reserve_sparse_table(size);
-                m_sparse_table.push_back(xt::arange<size_t>(0, size));
-                init_sparse_table();
+                init_sparse_table(xt::arange<size_t>(0, size));
             }
 
             template<typename T>
             rmq_sparse_table(const T &values, array_1d <size_t> &&element_map) : m_data(values.data()) {
-                reserve_sparse_table(element_map.size());
-                m_sparse_table.push_back(std::move(element_map));
-                init_sparse_table();
+                init_sparse_table(std::move(element_map));
             }
 
             template<typename T>
             rmq_sparse_table(const T &values, const array_1d <size_t> &element_map) : m_data(values.data()) {
-                reserve_sparse_table(element_map.size());
-                m_sparse_table.push_back(element_map);
-                init_sparse_table();
+                init_sparse_table(element_map);
             }
 
             /**
@@ -100,6 +147,17 @@ namespace hg {
                 return m_data[p1] < m_data[p2] ? p1 : p2;
             }
 
+            /**
+             * Size in bytes of the tables of the solver (the values are not included).
+             */
+            size_t table_bytes() const {
+                size_t bytes = 0;
+                for (auto &e: m_sparse_table) {
+                    bytes += e.size() * sizeof(size_t);
+                }
+                return bytes;
+            }
+
             template<template<typename> typename container_t>
             struct internal_state {
                 using type = self_type;
@@ -115,7 +173,18 @@ namespace hg {
             };
 
             auto get_state() const {
-                return internal_state<array_1d>(m_sparse_table);
+                std::vector<array_1d<size_t>> sparse_table;
+                for (auto &e: m_sparse_table) {
+                    sparse_table.push_back(e.to_array());
+                }
+                return internal_state<array_1d>(std::move(sparse_table));
+            }
+
+            /**
+             * State sharing the buffers of this object (no copy)
+             */
+            auto get_shared_state() const {
+                return internal_state<details::shared_array_1d>(m_sparse_table);
             }
 
             template<template<typename> typename container_t, typename T>
@@ -138,7 +207,7 @@ namespace hg {
             void set_state(internal_state<container_t> &&state, const T &data) {
                 m_sparse_table.clear();
                 for(auto & e: state.sparse_table){
-                    m_sparse_table.push_back(std::move(e));
+                    m_sparse_table.push_back(details::make_shared_array_1d(std::move(e)));
                 }
                 m_data = data.begin();
             }
@@ -147,7 +216,7 @@ namespace hg {
             void set_state(const internal_state<container_t> &state, const T &data) {
                 m_sparse_table.clear();
                 for(auto & e: state.sparse_table){
-                    m_sparse_table.push_back(e);
+                    m_sparse_table.push_back(details::make_shared_array_1d(e));
                 }
                 m_data = data.begin();
             }
@@ -171,25 +240,35 @@ namespace hg {
 
 
 
-            void reserve_sparse_table(size_t size) {
-                m_sparse_table.reserve((size_t) ceil(log((double) (size)) / log(2.0)));
-            }
-
-            void init_sparse_table() {
-                index_t size = m_sparse_table[0].size();
+            template<typename T>
+            void init_sparse_table(T &&element_map) {
+                index_t size = element_map.size();
+                std::vector<array_1d<size_t>> sparse_table;
+                sparse_table.reserve((size_t) ceil(log((double) (size)) / log(2.0)));
+                sparse_table.push_back(std::forward<T>(element_map));
 
                 for (index_t lvl = 0; (2 << lvl) <= size; lvl++) {
                     index_t size_lvlp1 = size - (2 << lvl) + 1;
-                    m_sparse_table.push_back(array_1d<index_t>::from_shape({(size_t) size_lvlp1}));
-                    parfor(0, size_lvlp1, [this, lvl](index_t i) {
-                        auto p1 = m_sparse_table[lvl](i);
-                        auto p2 = m_sparse_table[lvl](i + (1 << lvl));
-                        m_sparse_table[lvl + 1](i) = m_data[p1] < m_data[p2] ? p1 : p2;
-                    });
+                    sparse_table.push_back(array_1d<size_t>::from_shape({(size_t) size_lvlp1}));
+                    // the level is processed by chunks of contiguous elements (vectorized kernel), tasks contain
+                    // at least 4 chunks and levels with less than 4 chunks are processed serially
+                    const index_t chunk_size = 4096;
+                    const index_t num_chunks = (size_lvlp1 + chunk_size - 1) / chunk_size;
+                    parfor(execution::par.with_grain_size(4).with_serial_cutoff(4), 0, num_chunks,
+                           [this, &sparse_table, lvl, size_lvlp1, chunk_size](index_t c) {
+                               index_t i = c * chunk_size;
+                               sparse_table_next_level(m_data, sparse_table[lvl].data(), sparse_table[lvl + 1].data(),
+                                                       (index_t) 1 << lvl, i, (std::min)(i + chunk_size, size_lvlp1));
+                           });
+                }
+
+                m_sparse_table.clear();
+                for (auto &e: sparse_table) {
+                    m_sparse_table.push_back(details::make_shared_array_1d(std::move(e)));
                 }
             }
 
-            std::vector<array_1d < size_t>> m_sparse_table;
+            std::vector<details::shared_array_1d<size_t>> m_sparse_table;
             const data_t *m_data;
         };
 
@@ -197,6 +276,11 @@ namespace hg {
          * RMQ based on sparse table on blocks,
          * - O(n) preprocessing (if block size is in  O(log(n)))
          * - average O(1) query (for uniformly distributed queries)
+         *
+         * A query inside a block is answered by the in-block minimum prefix and suffix tables, unless the minimum of
+         * the block lies on both sides of the range: the range is then covered by the minima of its sub-blocks of
+         * subblock_size elements plus two partial sub-blocks scanned with a vectorized argmin, instead of an element
+         * by element scan of up to block_size elements.
          * @tparam data_t
          */
         template<typename data_t>
@@ -204,6 +288,8 @@ namespace hg {
 
             using self_type = rmq_sparse_table_block<data_t>;
 
+            static constexpr index_t subblock_size = 32;
+
             rmq_sparse_table_block() {
 
             }
@@ -214,8 +300,6 @@ namespace hg {
                 hg_assert(block_size > 0, "Block size must be strictly positive");
                 m_data_size = values.size();
                 m_num_blocks = (m_data_size + m_block_size - 1) / m_block_size;
-                m_block_minimum_prefix.resize({(size_t) (m_num_blocks * m_block_size)});
-                m_block_minimum_suffix.resize({(size_t) (m_num_blocks * m_block_size)});
                 init(values);
             }
 
@@ -234,11 +318,11 @@ namespace hg {
                     index_t ret = m_sparse_table.query(lb, std::min(m_num_blocks, rb + 1));
                     if (ret >= l && ret < r) return ret;
                 } else {
-                    if (m_block_minimum_prefix(r) >= l)
-                        return m_block_minimum_prefix(r);
-                    if (m_block_minimum_suffix(l) <= r)
+                    if (m_block_minimum_prefix(r - 1) >= l)
+                        return m_block_minimum_prefix(r - 1);
+                    if (m_block_minimum_suffix(l) < r)
                         return m_block_minimum_suffix(l);
-                    return std::min_element(m_data + l, m_data + r) - m_data;
+                    return in_block_query(l, r);
                 }
                 //index_t lbase = lb * m_block_size;
                 index_t rbase = rb * m_block_size;
@@ -252,6 +336,14 @@ namespace hg {
                 return m_data[vv] < m_data[v] ? vv : v;
             }
 
+            /**
+             * Size in bytes of the tables of the solver (the values are not included).
+             */
+            size_t table_bytes() const {
+                return (m_block_minimum_prefix.size() + m_block_minimum_suffix.size() + m_subblock_minimum.size()) *
+                       sizeof(index_t) + m_sparse_table.table_bytes();
+            }
+
             template<template<typename> typename container_t>
             struct internal_state {
                 using type = self_type;
@@ -261,6 +353,7 @@ namespace hg {
                 index_t num_blocks;
                 container_t<index_t> block_minimum_prefix;
                 container_t<index_t> block_minimum_suffix;
+                container_t<index_t> subblock_minimum;
                 sp_state_type sparse_table;
 
                 internal_state(index_t _data_size,
@@ -268,12 +361,14 @@ namespace hg {
                                index_t _num_blocks,
                                container_t<index_t> &&_block_minimum_prefix,
                                container_t<index_t> &&_block_minimum_suffix,
+                               container_t<index_t> &&_subblock_minimum,
                                sp_state_type &&_sp_state) :
                         data_size(_data_size),
                         block_size(_block_size),
                         num_blocks(_num_blocks),
                         block_minimum_prefix(std::move(_block_minimum_prefix)),
                         block_minimum_suffix(std::move(_block_minimum_suffix)),
+                        subblock_minimum(std::move(_subblock_minimum)),
                         sparse_table(std::move(_sp_state)) {}
 
                 internal_state(index_t _data_size,
@@ -281,12 +376,14 @@ namespace hg {
                                index_t _num_blocks,
                                const container_t<index_t> &_block_minimum_prefix,
                                const container_t<index_t> &_block_minimum_suffix,
+                               const container_t<index_t> &_subblock_minimum,
                                const sp_state_type &_sp_state) :
                         data_size(_data_size),
                         block_size(_block_size),
                         num_blocks(_num_blocks),
                         block_minimum_prefix(_block_minimum_prefix),
                         block_minimum_suffix(_block_minimum_suffix),
+                        subblock_minimum(_subblock_minimum),
                         sparse_table(_sp_state) {}
             };
 
@@ -294,11 +391,25 @@ namespace hg {
                 return internal_state<array_1d>(m_data_size,
                         m_block_size,
                         m_num_blocks,
-                        m_block_minimum_prefix,
-                        m_block_minimum_suffix,
+                        m_block_minimum_prefix.to_array(),
+                        m_block_minimum_suffix.to_array(),
+                        m_subblock_minimum.to_array(),
                         m_sparse_table.get_state());
             }
 
+            /**
+             * State sharing the buffers of this object (no copy)
+             */
+            auto get_shared_state() const {
+                return internal_state<details::shared_array_1d>(m_data_size,
+                                                                m_block_size,
+                                                                m_num_blocks,
+                                                                m_block_minimum_prefix,
+                                                                m_block_minimum_suffix,
+                                                                m_subblock_minimum,
+                                                                m_sparse_table.get_shared_state());
+            }
+
             template<template<typename> typename container_t, typename T>
             static auto make_from_state(internal_state<container_t> &&state, const T &data) {
                 rmq_sparse_table_block<typename T::value_type> rmq;
@@ -320,8 +431,9 @@ namespace hg {
                 m_data_size = state.data_size;
                 m_block_size = state.block_size;
                 m_num_blocks = state.num_blocks;
-                m_block_minimum_prefix = std::move(state.block_minimum_prefix);
-                m_block_minimum_suffix = std::move(state.block_minimum_suffix);
+                m_block_minimum_prefix = details::make_shared_array_1d(std::move(state.block_minimum_prefix));
+                m_block_minimum_suffix = details::make_shared_array_1d(std::move(state.block_minimum_suffix));
+                m_subblock_minimum = details::make_shared_array_1d(std::move(state.subblock_minimum));
                 m_sparse_table = rmq_sparse_table<typename T::value_type>::make_from_state(
                         std::move(state.sparse_table), data);
                 m_data = data.begin();
@@ -332,8 +444,9 @@ namespace hg {
                 m_data_size = state.data_size;
                 m_block_size = state.block_size;
                 m_num_blocks = state.num_blocks;
-                m_block_minimum_prefix = state.block_minimum_prefix;
-                m_block_minimum_suffix = state.block_minimum_suffix;
+                m_block_minimum_prefix = details::make_shared_array_1d(state.block_minimum_prefix);
+                m_block_minimum_suffix = details::make_shared_array_1d(state.block_minimum_suffix);
+                m_subblock_minimum = details::make_shared_array_1d(state.subblock_minimum);
                 m_sparse_table = rmq_sparse_table<typename T::value_type>::make_from_state(state.sparse_table, data);
                 m_data = data.begin();
             }
@@ -345,51 +458,315 @@ namespace hg {
                  * Blocks preprocessing
                  */
                 array_1d<index_t> element_map = array_1d<index_t>::from_shape({(size_t) m_num_blocks});
-                parfor(0, m_num_blocks, [&element_map, this](index_t i) {
+                array_1d<index_t> block_minimum_prefix = array_1d<index_t>::from_shape(
+                        {(size_t) (m_num_blocks * m_block_size)});
+                array_1d<index_t> block_minimum_suffix = array_1d<index_t>::from_shape(
+                        {(size_t) (m_num_blocks * m_block_size)});
+                parfor(block_parallel_policy, 0, m_num_blocks, [&element_map, &block_minimum_prefix, &block_minimum_suffix, this](index_t i) {
                     index_t block_start = i * m_block_size;
                     index_t block_end = std::min(block_start + m_block_size, m_data_size);
 
                     // smallest element position in the i-th block
-                    element_map(i) = std::min_element(m_data + block_start, m_data + block_end) - m_data;
+                    element_map(i) = range_argmin(m_data, block_start, block_end);
 
                     // minimum prefix block
                     index_t current_minimum_index = block_start;
                     index_t current_minimum = m_data[current_minimum_index];
 
-                    m_block_minimum_prefix(block_start) = current_minimum_index;
+                    block_minimum_prefix(block_start) = current_minimum_index;
                     for (index_t j = block_start + 1; j < block_start + m_block_size; ++j) {
                         if (j < block_end && m_data[j] < current_minimum) {
                             current_minimum = m_data[j];
                             current_minimum_index = j;
                         }
-                        m_block_minimum_prefix(j) = current_minimum_index;
+                        block_minimum_prefix(j) = current_minimum_index;
                     }
 
                     // minimum suffix block
                     current_minimum_index = block_start + m_block_size - 1;
                     current_minimum = (current_minimum_index < block_end) ? m_data[current_minimum_index] : -1;
 
-                    m_block_minimum_suffix(block_start + m_block_size - 1) = current_minimum_index;
+                    block_minimum_suffix(block_start + m_block_size - 1) = current_minimum_index;
                     for (index_t j = block_start + m_block_size - 2; j >= block_start; --j) {
                         if (j < block_end && m_data[j] < current_minimum) {
                             current_minimum = m_data[j];
                             current_minimum_index = j;
                         }
-                        m_block_minimum_suffix(j) = current_minimum_index;
+                        block_minimum_suffix(j) = current_minimum_index;
                     }
                 });
 
+                m_block_minimum_prefix = details::make_shared_array_1d(std::move(block_minimum_prefix));
+                m_block_minimum_suffix = details::make_shared_array_1d(std::move(block_minimum_suffix));
+
+                /*
+                 * Sub-blocks preprocessing
+                 */
+                const index_t num_subblocks = (m_data_size + subblock_size - 1) / subblock_size;
+                array_1d<index_t> subblock_minimum = array_1d<index_t>::from_shape({(size_t) num_subblocks});
+                parfor(block_parallel_policy, 0, num_subblocks, [&subblock_minimum, this](index_t i) {
+                    index_t subblock_start = i * subblock_size;
+                    subblock_minimum(i) = range_argmin(m_data, subblock_start,
+                                                       (std::min)(subblock_start + subblock_size, m_data_size));
+                });
+                m_subblock_minimum = details::make_shared_array_1d(std::move(subblock_minimum));
+
                 m_sparse_table = rmq_sparse_table<index_t>(values, std::move(element_map));
             }
 
+            /**
+             * Minimum of the range [l, r) inside a block: minima of the sub-blocks included in the range, and
+             * vectorized scans of the partial sub-blocks at both ends.
+             */
+            index_t in_block_query(index_t l, index_t r) const {
+                index_t first_subblock = (l + subblock_size - 1) / subblock_size;
+                index_t end_subblock = r / subblock_size;
+                if (first_subblock >= end_subblock) {
+                    return range_argmin(m_data, l, r);
+                }
+                index_t v = m_subblock_minimum(first_subblock);
+                for (index_t i = first_subblock + 1; i < end_subblock; i++) {
+                    index_t vi = m_subblock_minimum(i);
+                    if (m_data[vi] < m_data[v]) v = vi;
+                }
+                if (l < first_subblock * subblock_size) {
+                    index_t v2 = range_argmin(m_data, l, first_subblock * subblock_size);
+                    if (m_data[v2] < m_data[v]) v = v2;
+                }
+                if (r > end_subblock * subblock_size) {
+                    index_t v2 = range_argmin(m_data, end_subblock * subblock_size, r);
+                    if (m_data[v2] < m_data[v]) v = v2;
+                }
+                return v;
+            }
+
             const data_t *m_data;
             index_t m_data_size;
             index_t m_block_size;
             index_t m_num_blocks;
-            array_1d <index_t> m_block_minimum_prefix;
-            array_1d <index_t> m_block_minimum_suffix;
+            details::shared_array_1d<index_t> m_block_minimum_prefix;
+            details::shared_array_1d<index_t> m_block_minimum_suffix;
+            // position of the minimum of each sub-block of subblock_size elements
+            details::shared_array_1d<index_t> m_subblock_minimum;
             rmq_sparse_table<index_t> m_sparse_table;
 
         };
+
+        /**
+         * RMQ based on a sparse table on blocks of 64 elements and on in-block bitmasks (Fischer-Heun like decomposition):
+         * - O(n) preprocessing and space (one 64 bits mask per element and a sparse table on the n/64 block minima)
+         * - worst case O(1) query
+         *
+         * Bit k of the mask of the element j is set if the element at position block_start + k is the minimum of the
+         * range [block_start + k, j]: the minimum of a range [l, j] inside a block is thus given by the lowest bit of
+         * the mask of j whose position is greater than or equal to l - block_start.
+         * @tparam data_t
+         */
+        template<typename data_t>
+        struct rmq_bitmask_block {
+
+            using self_type = rmq_bitmask_block<data_t>;
+            using mask_type = uint64_t;
+            static constexpr index_t block_size = 64;
+
+            rmq_bitmask_block() {
+
+            }
+
+            template<typename T>
+            rmq_bitmask_block(const T &values) : m_data(values.data()) {
+                m_data_size = values.size();
+                m_num_blocks = (m_data_size + block_size - 1) / block_size;
+                init(values);
+            }
+
+            /**
+             * Precondition l < r
+             * @param l
+             * @param r
+             * @return
+             */
+            index_t query(index_t l, index_t r) const {
+                // inclusive upper bound
+                r--;
+                index_t lb = l / block_size;
+                index_t rb = r / block_size;
+                if (lb == rb) {
+                    return in_block_query(l, r);
+                }
+
+                index_t v = in_block_query(l, lb * block_size + block_size - 1);
+                index_t v2 = in_block_query(rb * block_size, r);
+                if (m_data[v2] < m_data[v]) v = v2;
+                if (lb + 1 == rb) return v;
+                index_t vv = m_sparse_table.query(lb + 1, rb);
+                return m_data[vv] < m_data[v] ? vv : v;
+            }
+
+            /**
+             * Size in bytes of the tables of the solver (the values are not included).
+             */
+            size_t table_bytes() const {
+                return m_masks.size() * sizeof(mask_type) + m_sparse_table.table_bytes();
+            }
+
+            template<template<typename> typename container_t>
+            struct internal_state {
+                using type = self_type;
+                using sp_state_type = typename rmq_sparse_table<data_t>::template internal_state<container_t>;
+                index_t data_size;
+                index_t num_blocks;
+                container_t<mask_type> masks;
+                sp_state_type sparse_table;
+
+                internal_state(index_t _data_size,
+                               index_t _num_blocks,
+                               container_t<mask_type> &&_masks,
+                               sp_state_type &&_sp_state) :
+                        data_size(_data_size),
+                        num_blocks(_num_blocks),
+                        masks(std::move(_masks)),
+                        sparse_table(std::move(_sp_state)) {}
+
+                internal_state(index_t _data_size,
+                               index_t _num_blocks,
+                               const container_t<mask_type> &_masks,
+                               const sp_state_type &_sp_state) :
+                        data_size(_data_size),
+                        num_blocks(_num_blocks),
+                        masks(_masks),
+                        sparse_table(_sp_state) {}
+            };
+
+            auto get_state() const {
+                return internal_state<array_1d>(m_data_size,
+                                                m_num_blocks,
+                                                m_masks.to_array(),
+                                                m_sparse_table.get_state());
+            }
+
+            /**
+             * State sharing the buffers of this object (no copy)
+             */
+            auto get_shared_state() const {
+                return internal_state<details::shared_array_1d>(m_data_size,
+                                                                m_num_blocks,
+                                                                m_masks,
+                                                                m_sparse_table.get_shared_state());
+            }
+
+            template<template<typename> typename container_t, typename T>
+            static auto make_from_state(internal_state<container_t> &&state, const T &data) {
+                rmq_bitmask_block<typename T::value_type> rmq;
+                rmq.set_state(std::move(state), data);
+                return rmq;
+            }
+
+            template<template<typename> typename container_t, typename T>
+            static auto make_from_state(const internal_state<container_t> &state, const T &data) {
+                rmq_bitmask_block<typename T::value_type> rmq;
+                rmq.set_state(state, data);
+                return rmq;
+            }
+
+        private:
+
+            template<template<typename> typename container_t, typename T>
+            void set_state(internal_state<container_t> &&state, const T &data) {
+                m_data_size = state.data_size;
+                m_num_blocks = state.num_blocks;
+                m_masks = details::make_shared_array_1d(std::move(state.masks));
+                m_sparse_table = rmq_sparse_table<typename T::value_type>::make_from_state(
+                        std::move(state.sparse_table), data);
+                m_data = data.begin();
+            }
+
+            template<template<typename> typename container_t, typename T>
+            void set_state(const internal_state<container_t> &state, const T &data) {
+                m_data_size = state.data_size;
+                m_num_blocks = state.num_blocks;
+                m_masks = details::make_shared_array_1d(state.masks);
+                m_sparse_table = rmq_sparse_table<typename T::value_type>::make_from_state(state.sparse_table, data);
+                m_data = data.begin();
+            }
+
+            /**
+             * Precondition: mask != 0
+             * @param mask
+             * @return
+             */
+            static inline index_t lowest_set_bit(mask_type mask) {
+#ifdef _MSC_VER
+                unsigned long least_significant_bit_index = 0;
+                _BitScanForward64(&least_significant_bit_index, mask);
+                return least_significant_bit_index;
+#else
+                return __builtin_ctzll(mask);
+#endif
+            }
+
+            /**
+             * Precondition: mask != 0
+             * @param mask
+             * @return
+             */
+            static inline index_t highest_set_bit(mask_type mask) {
+#ifdef _MSC_VER
+                unsigned long most_significant_bit_index = 0;
+                _BitScanReverse64(&most_significant_bit_index, mask);
+                return most_significant_bit_index;
+#else
+                return sizeof(mask_type) * 8 - 1 - __builtin_clzll(mask);
+#endif
+            }
+
+            /**
+             * Precondition: l <= r and l and r are in the same block
+             * @param l
+             * @param r
+             * @return position of the minimum in [l, r]
+             */
+            index_t in_block_query(index_t l, index_t r) const {
+                index_t block_start = l - l % block_size;
+                mask_type mask = m_masks(r) & (~(mask_type) 0 << (l - block_start));
+                return block_start + lowest_set_bit(mask);
+            }
+
+            template<typename T>
+            void init(const T &values) {
+                array_1d<size_t> element_map = array_1d<size_t>::from_shape({(size_t) m_num_blocks});
+                array_1d<mask_type> masks = array_1d<mask_type>::from_shape({(size_t) m_data_size});
+                parfor(block_parallel_policy, 0, m_num_blocks, [&element_map, &masks, this](index_t i) {
+                    index_t block_start = i * block_size;
+                    index_t block_end = std::min(block_start + block_size, m_data_size);
+
+                    // the mask is the stack of the positions k such that m_data[k] is the minimum of [k, j]
+                    mask_type mask = 0;
+                    for (index_t j = block_start; j < block_end; ++j) {
+                        while (mask != 0) {
+                            index_t top = highest_set_bit(mask);
+                            if (m_data[block_start + top] <= m_data[j]) {
+                                break;
+                            }
+                            mask ^= (mask_type) 1 << top;
+                        }
+                        mask |= (mask_type) 1 << (j - block_start);
+                        masks(j) = mask;
+                    }
+
+                    // smallest element position in the i-th block
+                    element_map(i) = block_start + lowest_set_bit(masks(block_end - 1));
+                });
+
+                m_masks = details::make_shared_array_1d(std::move(masks));
+                m_sparse_table = rmq_sparse_table<data_t>(values, std::move(element_map));
+            }
+
+            const data_t *m_data;
+            index_t m_data_size;
+            index_t m_num_blocks;
+            details::shared_array_1d<mask_type> m_masks;
+            rmq_sparse_table<data_t> m_sparse_table;
+        };
     }
 }
@@ -0,0 +1,128 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../../utils.hpp"
+#include "../array.hpp"
+#include <memory>
+#include <type_traits>
+
+namespace hg {
+
+    namespace details {
+
+        /**
+         * Read-only 1d array whose elements are stored in a buffer shared by all its copies.
+         *
+         * The buffer is either a contiguous container moved (or copied) into the shared array, or an external buffer
+         * (for example a memory mapped file) which is kept alive by an owner object as long as it is used.
+         *
+         * @tparam T value type
+         */
+        template<typename T>
+        class shared_array_1d {
+        public:
+            using value_type = T;
+            using const_iterator = const T *;
+
+            shared_array_1d() : m_data(nullptr), m_size(0) {
+            }
+
+            /**
+             * View on an external buffer
+             *
+             * @param data pointer to the first element of the buffer
+             * @param size number of elements in the buffer
+             * @param owner object owning the buffer (can be nullptr if the buffer outlives the array)
+             */
+            shared_array_1d(const T *data, size_t size, std::shared_ptr<const void> owner) :
+                    m_owner(std::move(owner)), m_data(data), m_size(size) {
+            }
+
+            const T &operator()(index_t i) const {
+                return m_data[i];
+            }
+
+            const T &operator[](index_t i) const {
+                return m_data[i];
+            }
+
+            const T *data() const {
+                return m_data;
+            }
+
+            size_t size() const {
+                return m_size;
+            }
+
+            const_iterator begin() const {
+                return m_data;
+            }
+
+            const_iterator end() const {
+                return m_data + m_size;
+            }
+
+            const_iterator cbegin() const {
+                return m_data;
+            }
+
+            const_iterator cend() const {
+                return m_data + m_size;
+            }
+
+            /**
+             * Copy of the elements in a new array
+             */
+            array_1d<T> to_array() const {
+                array_1d<T> result = array_1d<T>::from_shape({m_size});
+                std::copy(m_data, m_data + m_size, result.begin());
+                return result;
+            }
+
+        private:
+            std::shared_ptr<const void> m_owner;
+            const T *m_data;
+            size_t m_size;
+        };
+
+        template<typename T>
+        struct is_shared_array_1d : std::false_type {
+        };
+
+        template<typename T>
+        struct is_shared_array_1d<shared_array_1d<T>> : std::true_type {
+        };
+
+        /**
+         * Shared array on the elements of the given contiguous container: the container is moved, or copied if it is
+         * an lvalue, in the shared buffer.
+         */
+        template<typename container_t,
+                typename = std::enable_if_t<!is_shared_array_1d<std::decay_t<container_t>>::value>>
+        auto make_shared_array_1d(container_t &&container) {
+            using storage_t = std::decay_t<container_t>;
+            using value_t = typename storage_t::value_type;
+            auto storage = std::make_shared<storage_t>(std::forward<container_t>(container));
+            const value_t *data = storage->data();
+            size_t size = storage->size();
+            return shared_array_1d<value_t>(data, size, std::move(storage));
+        }
+
+        /**
+         * Shared arrays are not copied: the result shares the buffer of the given array
+         */
+        template<typename T>
+        auto make_shared_array_1d(const shared_array_1d<T> &array) {
+            return array;
+        }
+    }
+}
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include "../detail/fast_division.hpp"
+#include "../detail/memory_tracking.hpp"
 #include "xtensor/xexpression.hpp"
 #include "xtensor/xreducer.hpp"
 #include "xtensor/xgenerator.hpp"
@@ -17,6 +19,7 @@
 #include "array.hpp"
 #include "point.hpp"
 #include "../utils.hpp"
+#include <array>
 
 
 namespace hg {
@@ -42,6 +45,8 @@ namespace hg {
             size_t nbElement = 0;
             shape_type _shape; // signed for safer comparisons
             point<size_t, dim> sum_prod;
+            // division by the elements of sum_prod without hardware division
+            std::array<fast_divider, dim> sum_prod_divider;
 
             void computeSize() {
                 if (dim == 0)
@@ -58,6 +63,9 @@ namespace hg {
                 for (index_t i = dim - 2; i >= 0; --i) {
                     sum_prod(i) = sum_prod(i + 1) * _shape(i + 1);
                 }
+                for (index_t i = 0; i < dim; ++i) {
+                    sum_prod_divider[i] = fast_divider(sum_prod(i));
+                }
             }
 
             void assert_positive_shape() {
@@ -71,6 +79,9 @@ namespace hg {
 
             static const int _dim = dim;
 
+            // linear coordinates are in row major order
+            static const bool _row_major = true;
+
             /**
              * Creates an embedding of size 0.
              */
@@ -280,20 +291,36 @@ namespace hg {
                 return true;
             }
 
+            /**
+             * Converts the coordinates of a point from linear to grid system and writes the dim grid coordinates
+             * in out[0], ..., out[dim - 1].
+             *
+             * The divisions by the axis strides are replaced by multiplications (see fast_divider) and the loop over
+             * the dimensions is unrolled by the compiler.
+             *
+             * @param index a non negative linear coordinate
+             * @param out output iterator
+             */
+            template<typename output_t>
+            void lin2grid(index_t index, output_t out) const {
+                uint64_t remainder = (uint64_t) index;
+                for (index_t i = 0; i < dim - 1; ++i) {
+                    const uint64_t q = sum_prod_divider[i].divide(remainder);
+                    *out = q;
+                    ++out;
+                    remainder -= q * sum_prod(i);
+                }
+                *out = remainder;
+            }
+
             /**
              * Converts the coordinates of a point from linear to grid system
-             * @param index
+             * @param index a non negative linear coordinate
              * @return
              */
             auto lin2grid(index_t index) const {
                 point_type result;
-
-                for (index_t i = 0; i < dim - 1; ++i) {
-
-                    result[i] = index / sum_prod(i);
-                    index = index % sum_prod(i);
-                }
-                result[dim - 1] = index / sum_prod(dim - 1);
+                lin2grid(index, result.data());
                 return result;
             }
 
@@ -309,26 +336,18 @@ namespace hg {
                               "Indices must have integral value type.");
                 const auto &indices = xindices.derived_cast();
 
-                index_t size = (index_t) indices.size();
                 auto shapeO = indices.shape();
                 std::vector<size_t> shape(shapeO.begin(), shapeO.end());
                 shape.push_back(dim);
 
-                array_nd<coordinates_t> result = array_nd<coordinates_t>::from_shape({(size_t) size, (size_t) dim});
-
-
-                const auto indicesLin = xt::flatten(indices);
-
-                for (index_t j = 0; j < size; ++j) {
-                    auto index = indicesLin(j);
-                    for (index_t i = 0; i < dim - 1; ++i) {
+                array_nd<coordinates_t> result = array_nd<coordinates_t>::from_shape(shape);
 
-                        result(j, i) = index / sum_prod[i];
-                        index = index % sum_prod[i];
-                    }
-                    result(j, dim - 1) = index / sum_prod[dim - 1];
+                // row major traversal of the indices, the coordinates of each point are contiguous in the result
+                auto out = result.data();
+                for (const auto index: indices) {
+                    lin2grid((index_t) index, out);
+                    out += dim;
                 }
-                result.reshape(shape);
                 return result;
             }
         };
@@ -0,0 +1,372 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "embedding.hpp"
+
+namespace hg {
+
+    namespace embedding_internal {
+
+        /**
+         * Interleaves the bits of the 16 lower bits of x with zeros: bit k of x becomes bit 2k of the result.
+         */
+        inline
+        uint32_t morton_spread(uint32_t x) {
+            x &= 0x0000ffff;
+            x = (x | (x << 8)) & 0x00ff00ff;
+            x = (x | (x << 4)) & 0x0f0f0f0f;
+            x = (x | (x << 2)) & 0x33333333;
+            x = (x | (x << 1)) & 0x55555555;
+            return x;
+        }
+
+        /**
+         * Inverse of morton_spread: bit 2k of x becomes bit k of the result.
+         */
+        inline
+        uint32_t morton_compact(uint32_t x) {
+            x &= 0x55555555;
+            x = (x | (x >> 1)) & 0x33333333;
+            x = (x | (x >> 2)) & 0x0f0f0f0f;
+            x = (x | (x >> 4)) & 0x00ff00ff;
+            x = (x | (x >> 8)) & 0x0000ffff;
+            return x;
+        }
+
+        /**
+         * 2d grid embedding whose linear coordinates follow a tiled Morton (Z-order) curve instead of the row major
+         * order of embedding_grid.
+         *
+         * The grid is cut in square tiles of tile_size x tile_size pixels (tile_size is a power of 2), numbered in
+         * row major order. The pixels of a full tile are numbered along the Morton curve, and the pixels of the
+         * partial tiles on the bottom and right borders of the grid are numbered in row major order inside the tile.
+         * The linear coordinates are thus a permutation of [0, height * width) for any shape, and the vertical
+         * neighbours of most pixels are close to them in memory: on large images, algorithms on graphs numbered with
+         * this embedding (see get_4_adjacency_morton_graph) access the vertex and edge arrays with a
+         * much better locality than with the row major order, whose vertical neighbours are one image row apart.
+         *
+         * The embedding has the same interface as embedding_grid_2d (shape, size, contains, grid2lin, lin2grid) and
+         * can be used as the embedding of a regular_graph. Images are converted from and to the order of the
+         * embedding with to_morton_order and to_row_major_order.
+         */
+        class embedding_morton_2d : private embedding_grid<2, index_t> {
+            using base_type = embedding_grid<2, index_t>;
+        public:
+            using coordinate_type = index_t;
+            using point_type = point<index_t, 2>;
+            using shape_type = point_type;
+            using self_type = embedding_morton_2d;
+
+            static const int _dim = 2;
+
+            // linear coordinates are not row major: neighbours of a point are not at constant offsets
+            static const bool _row_major = false;
+
+            using base_type::shape;
+            using base_type::size;
+            using base_type::dimension;
+            using base_type::contains;
+
+            /**
+             * Creates an embedding of size 0.
+             */
+            embedding_morton_2d() {}
+
+            /**
+             * Creates an embedding with the given shape
+             * @param shape list of 2 positive integers
+             * @param tile_size size of the Morton ordered tiles, a power of 2 smaller than or equal to 65536
+             */
+            embedding_morton_2d(const std::initializer_list<index_t> &shape, index_t tile_size = 64) :
+                    base_type(shape) {
+                init(tile_size);
+            }
+
+            /**
+             * Creates an embedding with the given shape
+             * @param shape container or array of 2 positive integers
+             * @param tile_size size of the Morton ordered tiles, a power of 2 smaller than or equal to 65536
+             */
+            template<typename T>
+            embedding_morton_2d(const T &shape, index_t tile_size = 64) : base_type(shape) {
+                init(tile_size);
+            }
+
+            /**
+             * Size of the Morton ordered tiles
+             */
+            index_t tile_size() const {
+                return m_tile_size;
+            }
+
+            /**
+             * Convert the coordinates (i, j) of a point (in the grid coordinate system) into linear coordinates
+             * @param i row
+             * @param j column
+             * @return
+             */
+            index_t grid2lin(index_t i, index_t j) const {
+                const index_t ti = i >> m_tile_shift;
+                const index_t tj = j >> m_tile_shift;
+                const index_t ii = i & (m_tile_size - 1);
+                const index_t jj = j & (m_tile_size - 1);
+                const index_t tile_height = (ti == m_last_tile_row) ? m_last_tile_height : m_tile_size;
+                const index_t tile_width = (tj == m_last_tile_column) ? m_last_tile_width : m_tile_size;
+                const index_t tile_start = ti * m_tile_size * shape()(1) + tj * m_tile_size * tile_height;
+                if (tile_height == m_tile_size && tile_width == m_tile_size) {
+                    return tile_start + (index_t) ((morton_spread((uint32_t) ii) << 1) | morton_spread((uint32_t) jj));
+                }
+                return tile_start + ii * tile_width + jj;
+            }
+
+            /**
+             * Convert the coordinates of a point (in the grid coordinate system) into linear coordinates
+             * @tparam T
+             * @param coordinates
+             * @return
+             */
+            template<typename T>
+            index_t grid2lin(const point<T, 2> &coordinates) const {
+                return grid2lin((index_t) coordinates[0], (index_t) coordinates[1]);
+            }
+
+            /**
+             * Convert the coordinates of a point (in the grid coordinate system) into linear coordinates
+             * @param coordinates
+             * @return
+             */
+            index_t grid2lin(const std::initializer_list<index_t> &coordinates) const {
+                hg_assert(coordinates.size() == 2, "Coordinates size does not match embedding dimension.");
+                return grid2lin(*coordinates.begin(), *(coordinates.begin() + 1));
+            }
+
+            /**
+             * Convert the coordinates of a point (in the grid coordinate system) into linear coordinates
+             * @tparam T
+             * @param coordinates
+             * @return
+             */
+            template<typename T,
+                    typename = std::enable_if_t<!std::is_base_of<xt::xexpression<T>, T>::value>
+            >
+            index_t grid2lin(const T &coordinates) const {
+                hg_assert(coordinates.size() == 2, "Coordinates size does not match embedding dimension.");
+                auto it = coordinates.begin();
+                index_t i = *it;
+                ++it;
+                return grid2lin(i, (index_t) *it);
+            }
+
+            /**
+             * Convert an array of points coordinates (in the grid coordinate system) into linear coordinates
+             * @tparam T
+             * @param coordinates an array of grid coordinates of shape (n1, n2, .., nx, 2)
+             * @return an array of linear coordinates of shape (n1, n2, .., nx)
+             */
+            template<typename T>
+            auto grid2lin(const xt::xexpression<T> &xcoordinates) const {
+                static_assert(std::is_integral<typename T::value_type>::value,
+                              "Coordinates must have integral value type.");
+                const auto &coordinates = xcoordinates.derived_cast();
+                hg_assert(coordinates.dimension() > 0 && coordinates.shape().back() == 2,
+                          "Coordinates size does not match embedding dimension.");
+                const array_nd<index_t> c = coordinates;
+                std::vector<size_t> shape(c.shape().begin(), c.shape().end() - 1);
+                array_nd<index_t> result = array_nd<index_t>::from_shape(shape);
+                const auto data = c.data();
+                for (index_t k = 0; k < (index_t) result.size(); k++) {
+                    result.data()[k] = grid2lin(data[2 * k], data[2 * k + 1]);
+                }
+                return result;
+            }
+
+            /**
+             * Converts the coordinates of a point from linear to grid system and writes the 2 grid coordinates
+             * in out[0] and out[1].
+             *
+             * @param index a non negative linear coordinate
+             * @param out output iterator
+             */
+            template<typename output_t>
+            void lin2grid(index_t index, output_t out) const {
+                const uint64_t ti = m_tile_row_divider.divide((uint64_t) index);
+                const uint64_t r = (uint64_t) index - ti * m_tile_row_size;
+                uint64_t tj, offset;
+                index_t tile_height;
+                if ((index_t) ti == m_last_tile_row) {
+                    tj = m_last_row_tile_divider.divide(r);
+                    offset = r - tj * m_tile_size * m_last_tile_height;
+                    tile_height = m_last_tile_height;
+                } else {
+                    tj = r >> (2 * m_tile_shift);
+                    offset = r - (tj << (2 * m_tile_shift));
+                    tile_height = m_tile_size;
+                }
+                const bool last_column = (index_t) tj == m_last_tile_column;
+                uint64_t ii, jj;
+                if (tile_height == m_tile_size && (!last_column || m_last_tile_width == m_tile_size)) {
+                    ii = morton_compact((uint32_t) (offset >> 1));
+                    jj = morton_compact((uint32_t) offset);
+                } else if (last_column) {
+                    ii = m_last_tile_width_divider.divide(offset);
+                    jj = offset - ii * m_last_tile_width;
+                } else {
+                    ii = offset >> m_tile_shift;
+                    jj = offset & (m_tile_size - 1);
+                }
+                *out = (index_t) ((ti << m_tile_shift) + ii);
+                ++out;
+                *out = (index_t) ((tj << m_tile_shift) + jj);
+            }
+
+            /**
+             * Converts the coordinates of a point from linear to grid system
+             * @param index a non negative linear coordinate
+             * @return
+             */
+            auto lin2grid(index_t index) const {
+                point_type result;
+                lin2grid(index, result.data());
+                return result;
+            }
+
+            /**
+             * Converts the coordinates of points from linear to grid system
+             * @tparam T
+             * @param xindices an array of points linear coordinates of shape (n1, n2,... nx)
+             * @return an array of points grid coordinates of shape (n1, n2,... nx, 2)
+             */
+            template<typename T>
+            xt::xarray<index_t> lin2grid(const xt::xexpression<T> &xindices) const {
+                static_assert(std::is_integral<typename T::value_type>::value,
+                              "Indices must have integral value type.");
+                const auto &indices = xindices.derived_cast();
+
+                auto shapeO = indices.shape();
+                std::vector<size_t> shape(shapeO.begin(), shapeO.end());
+                shape.push_back(2);
+
+                array_nd<index_t> result = array_nd<index_t>::from_shape(shape);
+                auto out = result.data();
+                for (const auto index: indices) {
+                    lin2grid((index_t) index, out);
+                    out += 2;
+                }
+                return result;
+            }
+
+        private:
+
+            void init(index_t tile_size) {
+                hg_assert(tile_size > 0 && tile_size <= (1 << 16) && (tile_size & (tile_size - 1)) == 0,
+                          "Tile size must be a power of 2 smaller than or equal to 65536.");
+                m_tile_size = tile_size;
+                m_tile_shift = 0;
+                while (((index_t) 1 << m_tile_shift) < tile_size) {
+                    m_tile_shift++;
+                }
+                const index_t h = shape()(0);
+                const index_t w = shape()(1);
+                m_last_tile_row = (h - 1) >> m_tile_shift;
+                m_last_tile_column = (w - 1) >> m_tile_shift;
+                m_last_tile_height = h - m_last_tile_row * tile_size;
+                m_last_tile_width = w - m_last_tile_column * tile_size;
+                m_tile_row_size = tile_size * w;
+                m_tile_row_divider = fast_divider(m_tile_row_size);
+                m_last_row_tile_divider = fast_divider(tile_size * m_last_tile_height);
+                m_last_tile_width_divider = fast_divider(m_last_tile_width);
+            }
+
+            index_t m_tile_size = 1;
+            index_t m_tile_shift = 0;
+            index_t m_last_tile_row = 0;
+            index_t m_last_tile_column = 0;
+            index_t m_last_tile_height = 1;
+            index_t m_last_tile_width = 1;
+            // number of pixels in a row of full height tiles
+            index_t m_tile_row_size = 1;
+            fast_divider m_tile_row_divider;
+            fast_divider m_last_row_tile_divider;
+            fast_divider m_last_tile_width_divider;
+        };
+    }
+
+    using embedding_morton_2d = embedding_internal::embedding_morton_2d;
+
+    /**
+     * Reorders the pixels of an image in the linear order of the given Morton embedding: the pixel (i, j) of the
+     * image becomes the element embedding.grid2lin(i, j) of the result. The image can have trailing dimensions
+     * (for example color channels), which are kept.
+     *
+     * @tparam T
+     * @param embedding Morton embedding
+     * @param ximage array of shape (height, width, ...)
+     * @return an array of shape (height * width, ...)
+     */
+    template<typename T>
+    auto to_morton_order(const embedding_morton_2d &embedding, const xt::xexpression<T> &ximage) {
+        HG_TRACE();
+        auto &image = ximage.derived_cast();
+        hg_assert(image.dimension() >= 2 &&
+                  (index_t) image.shape()[0] == embedding.shape()(0) &&
+                  (index_t) image.shape()[1] == embedding.shape()(1),
+                  "Image shape does not match embedding shape.");
+        using value_type = typename T::value_type;
+        const array_nd<value_type> source = image;
+        std::vector<size_t> shape(source.shape().begin() + 1, source.shape().end());
+        shape[0] = embedding.size();
+        array_nd<value_type> result = array_nd<value_type>::from_shape(shape);
+        const index_t width = embedding.shape()(1);
+        const index_t channels = (index_t) (source.size() / embedding.size());
+        parfor(0, embedding.shape()(0), [&source, &result, &embedding, width, channels](index_t i) {
+            for (index_t j = 0; j < width; j++) {
+                std::copy_n(source.data() + (i * width + j) * channels, channels,
+                            result.data() + embedding.grid2lin(i, j) * channels);
+            }
+        });
+        return result;
+    }
+
+    /**
+     * Reorders values given in the linear order of the given Morton embedding (for example vertex weights of a graph
+     * built with get_4_adjacency_morton_graph) into a row major image: the element
+     * embedding.grid2lin(i, j) of the input becomes the pixel (i, j) of the result. Inverse of to_morton_order.
+     *
+     * @tparam T
+     * @param embedding Morton embedding
+     * @param xvalues array of shape (height * width, ...)
+     * @return an array of shape (height, width, ...)
+     */
+    template<typename T>
+    auto to_row_major_order(const embedding_morton_2d &embedding, const xt::xexpression<T> &xvalues) {
+        HG_TRACE();
+        auto &values = xvalues.derived_cast();
+        hg_assert(values.dimension() >= 1 && (index_t) values.shape()[0] == (index_t) embedding.size(),
+                  "Values size does not match embedding size.");
+        using value_type = typename T::value_type;
+        const array_nd<value_type> source = values;
+        std::vector<size_t> shape;
+        shape.push_back(embedding.shape()(0));
+        shape.push_back(embedding.shape()(1));
+        shape.insert(shape.end(), source.shape().begin() + 1, source.shape().end());
+        array_nd<value_type> result = array_nd<value_type>::from_shape(shape);
+        const index_t width = embedding.shape()(1);
+        const index_t channels = (index_t) (source.size() / embedding.size());
+        parfor(0, embedding.shape()(0), [&source, &result, &embedding, width, channels](index_t i) {
+            for (index_t j = 0; j < width; j++) {
+                std::copy_n(source.data() + embedding.grid2lin(i, j) * channels, channels,
+                            result.data() + (i * width + j) * channels);
+            }
+        });
+        return result;
+    }
+}
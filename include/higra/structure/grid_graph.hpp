@@ -0,0 +1,387 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "details/graph_concepts.hpp"
+#include "details/indexed_edge.hpp"
+#include "higra/structure/details/iterators.hpp"
+#include "higra/structure/array.hpp"
+#include "higra/structure/embedding.hpp"
+#include "xtensor/xvectorize.hpp"
+
+namespace hg {
+
+    namespace grid_graph_internal {
+
+        struct grid_graph_traversal_category :
+                virtual public graph::incidence_graph_tag,
+                virtual public graph::bidirectional_graph_tag,
+                virtual public graph::adjacency_graph_tag,
+                virtual public graph::vertex_list_graph_tag,
+                virtual public graph::edge_list_graph_tag {
+        };
+
+        // what an incident edge iterator dereferences to
+        enum class incidence_value {
+            out_edge,
+            in_edge,
+            adjacent_vertex
+        };
+
+        template<typename graph_t, incidence_value value>
+        struct incident_edge_iterator;
+
+        /**
+         * Implicit 4 adjacency graph on a 2d grid with implicit edge indices.
+         *
+         * Vertices and edges are not stored: the extremities of an edge and the edge indices of the neighbourhood of
+         * a vertex are computed from the grid shape. Edges are indexed as in the explicit graph returned by
+         * get_4_adjacency_graph (graph_image.hpp): the edges of the pixel (i, j) of a grid of shape (h, w) are
+         * numbered in raster scan order, its right edge (to (i, j + 1)) before its bottom edge (to (i + 1, j)).
+         * Edge weights computed on one graph are thus valid edge weights of the other.
+         *
+         * The source of an edge is its extremity of smallest index.
+         */
+        struct grid_4_adjacency_graph_2d {
+
+            // Graph associated types
+            using self_type = grid_4_adjacency_graph_2d;
+            using vertex_descriptor = index_t;
+            using edge_index_t = index_t;
+            using edge_descriptor = indexed_edge<vertex_descriptor, edge_index_t>;
+            using directed_category = graph::undirected_tag;
+            using edge_parallel_category = graph::disallow_parallel_edge_tag;
+            using traversal_category = grid_graph_traversal_category;
+
+            // VertexListGraph associated types
+            using vertex_iterator = counting_iterator<vertex_descriptor>;
+            using vertices_size_type = size_t;
+
+            // EdgeListGraph associated types
+            struct edge_from_index_fun {
+                const self_type *graph;
+
+                edge_descriptor operator()(index_t i) const {
+                    return graph->edge_from_index(i);
+                }
+            };
+
+            using edges_size_type = size_t;
+            using edge_iterator = transform_forward_iterator<edge_from_index_fun,
+                    counting_iterator<edge_index_t>,
+                    edge_descriptor>;
+
+            // IncidenceGraph associated types
+            using out_edge_iterator = incident_edge_iterator<self_type, incidence_value::out_edge>;
+            using degree_size_type = size_t;
+
+            //BidirectionalGraph associated types
+            using in_edge_iterator = incident_edge_iterator<self_type, incidence_value::in_edge>;
+
+            //AdjacencyGraph associated types
+            using adjacency_iterator = incident_edge_iterator<self_type, incidence_value::adjacent_vertex>;
+
+            grid_4_adjacency_graph_2d(const embedding_grid_2d &embedding) :
+                    m_embedding(embedding),
+                    m_height(embedding.shape()[0]),
+                    m_width(embedding.shape()[1]) {
+            }
+
+            const auto &embedding() const {
+                return m_embedding;
+            }
+
+            vertices_size_type num_vertices() const {
+                return m_height * m_width;
+            }
+
+            edges_size_type num_edges() const {
+                if (m_height == 0 || m_width == 0) {
+                    return 0;
+                }
+                return m_height * (m_width - 1) + (m_height - 1) * m_width;
+            }
+
+            degree_size_type degree(vertex_descriptor v) const {
+                index_t i = v / m_width;
+                index_t j = v % m_width;
+                return (i > 0) + (j > 0) + (j < m_width - 1) + (i < m_height - 1);
+            }
+
+            /**
+             * Index of the edge between the vertex v = (i, j) and its right neighbour (i, j + 1).
+             */
+            edge_index_t right_edge(vertex_descriptor v) const {
+                index_t i = v / m_width;
+                index_t j = v % m_width;
+                return i * (2 * m_width - 1) + ((i < m_height - 1) ? 2 * j : j);
+            }
+
+            /**
+             * Index of the edge between the vertex v = (i, j) and its bottom neighbour (i + 1, j).
+             */
+            edge_index_t bottom_edge(vertex_descriptor v) const {
+                index_t i = v / m_width;
+                index_t j = v % m_width;
+                return i * (2 * m_width - 1) + ((j < m_width - 1) ? 2 * j + 1 : 2 * j);
+            }
+
+            vertex_descriptor source(edge_index_t e) const {
+                index_t row_size = 2 * m_width - 1;
+                index_t i = e / row_size;
+                index_t r = e % row_size;
+                // the last row only contains right edges
+                return i * m_width + ((i == m_height - 1) ? r : r / 2);
+            }
+
+            vertex_descriptor target(edge_index_t e) const {
+                index_t row_size = 2 * m_width - 1;
+                index_t i = e / row_size;
+                index_t r = e % row_size;
+                if (i == m_height - 1) {
+                    return i * m_width + r + 1;
+                }
+                // odd positions and the last position of a row are bottom edges
+                if ((r & 1) || r == row_size - 1) {
+                    return i * m_width + r / 2 + m_width;
+                }
+                return i * m_width + r / 2 + 1;
+            }
+
+            edge_descriptor edge_from_index(edge_index_t e) const {
+                return edge_descriptor(source(e), target(e), e);
+            }
+
+            /**
+             * Lazy 1d expression of the sources of all the edges
+             */
+            auto sources() const {
+                auto graph = *this;
+                return xt::vectorize([graph](index_t e) { return graph.source(e); })(
+                        xt::arange<index_t>(num_edges()));
+            }
+
+            /**
+             * Lazy 1d expression of the targets of all the edges
+             */
+            auto targets() const {
+                auto graph = *this;
+                return xt::vectorize([graph](index_t e) { return graph.target(e); })(
+                        xt::arange<index_t>(num_edges()));
+            }
+
+            /**
+             * Adjacent vertex and edge index of the k-th neighbour (top, left, right, bottom) of the vertex v, or
+             * invalid_index if v has no such neighbour.
+             */
+            std::pair<vertex_descriptor, edge_index_t> neighbour(vertex_descriptor v, index_t k) const {
+                index_t i = v / m_width;
+                index_t j = v % m_width;
+                switch (k) {
+                    case 0:
+                        if (i > 0) {
+                            return {v - m_width, bottom_edge(v - m_width)};
+                        }
+                        break;
+                    case 1:
+                        if (j > 0) {
+                            return {v - 1, right_edge(v - 1)};
+                        }
+                        break;
+                    case 2:
+                        if (j < m_width - 1) {
+                            return {v + 1, right_edge(v)};
+                        }
+                        break;
+                    case 3:
+                        if (i < m_height - 1) {
+                            return {v + m_width, bottom_edge(v)};
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                return {invalid_index, invalid_index};
+            }
+
+        private:
+            embedding_grid_2d m_embedding;
+            index_t m_height;
+            index_t m_width;
+        };
+
+        /**
+         * Iterator on the out edges, in edges, or adjacent vertices of a vertex of a grid graph
+         */
+        template<typename graph_t, incidence_value value>
+        struct incident_edge_iterator :
+                public forward_iterator_facade<incident_edge_iterator<graph_t, value>,
+                        std::conditional_t<value == incidence_value::adjacent_vertex,
+                                typename graph_t::vertex_descriptor,
+                                typename graph_t::edge_descriptor>> {
+
+            using self_type = incident_edge_iterator<graph_t, value>;
+            using value_type = std::conditional_t<value == incidence_value::adjacent_vertex,
+                    typename graph_t::vertex_descriptor,
+                    typename graph_t::edge_descriptor>;
+
+            incident_edge_iterator(const graph_t *graph, index_t vertex, index_t position) :
+                    m_graph(graph), m_vertex(vertex), m_position(position) {
+                skip_invalid();
+            }
+
+            incident_edge_iterator() : m_graph(nullptr), m_vertex(invalid_index), m_position(4) {}
+
+            void increment() {
+                m_position++;
+                skip_invalid();
+            }
+
+            bool equal(const self_type &other) const {
+                return m_position == other.m_position;
+            }
+
+            value_type dereference() const {
+                return make_value(std::integral_constant<incidence_value, value>());
+            }
+
+        private:
+
+            void skip_invalid() {
+                while (m_position < 4) {
+                    m_neighbour = m_graph->neighbour(m_vertex, m_position);
+                    if (m_neighbour.first != invalid_index) {
+                        return;
+                    }
+                    m_position++;
+                }
+            }
+
+            value_type make_value(std::integral_constant<incidence_value, incidence_value::out_edge>) const {
+                return value_type(m_vertex, m_neighbour.first, m_neighbour.second);
+            }
+
+            value_type make_value(std::integral_constant<incidence_value, incidence_value::in_edge>) const {
+                return value_type(m_neighbour.first, m_vertex, m_neighbour.second);
+            }
+
+            value_type make_value(std::integral_constant<incidence_value, incidence_value::adjacent_vertex>) const {
+                return m_neighbour.first;
+            }
+
+            const graph_t *m_graph;
+            index_t m_vertex;
+            index_t m_position;
+            std::pair<index_t, index_t> m_neighbour;
+        };
+    }
+
+    using grid_4_adjacency_graph_2d = grid_graph_internal::grid_4_adjacency_graph_2d;
+
+    namespace graph {
+        template<>
+        struct graph_traits<hg::grid_4_adjacency_graph_2d> {
+            using G = hg::grid_4_adjacency_graph_2d;
+
+            using vertex_descriptor = typename G::vertex_descriptor;
+            using edge_descriptor = typename G::edge_descriptor;
+            using edge_iterator = typename G::edge_iterator;
+            using out_edge_iterator = typename G::out_edge_iterator;
+
+            using directed_category = typename G::directed_category;
+            using edge_parallel_category = typename G::edge_parallel_category;
+            using traversal_category = typename G::traversal_category;
+
+            using degree_size_type = typename G::degree_size_type;
+
+            using in_edge_iterator = typename G::in_edge_iterator;
+            using vertex_iterator = typename G::vertex_iterator;
+            using vertices_size_type = typename G::vertices_size_type;
+            using edges_size_type = typename G::edges_size_type;
+            using adjacency_iterator = typename G::adjacency_iterator;
+
+            using edge_index = typename G::edge_index_t;
+        };
+    }
+
+    inline
+    auto edge_from_index(const grid_4_adjacency_graph_2d::edge_index_t i, const grid_4_adjacency_graph_2d &g) {
+        return g.edge_from_index(i);
+    }
+
+    inline
+    grid_4_adjacency_graph_2d::vertices_size_type num_vertices(const grid_4_adjacency_graph_2d &g) {
+        return g.num_vertices();
+    }
+
+    inline
+    grid_4_adjacency_graph_2d::edges_size_type num_edges(const grid_4_adjacency_graph_2d &g) {
+        return g.num_edges();
+    }
+
+    inline
+    grid_4_adjacency_graph_2d::degree_size_type
+    degree(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        return g.degree(v);
+    }
+
+    inline
+    grid_4_adjacency_graph_2d::degree_size_type
+    in_degree(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        return g.degree(v);
+    }
+
+    inline
+    grid_4_adjacency_graph_2d::degree_size_type
+    out_degree(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        return g.degree(v);
+    }
+
+    inline
+    std::pair<grid_4_adjacency_graph_2d::vertex_iterator, grid_4_adjacency_graph_2d::vertex_iterator>
+    vertices(const grid_4_adjacency_graph_2d &g) {
+        return std::make_pair(
+                grid_4_adjacency_graph_2d::vertex_iterator(0),                 // The first iterator position
+                grid_4_adjacency_graph_2d::vertex_iterator(num_vertices(g))); // The last iterator position
+    }
+
+    inline
+    std::pair<grid_4_adjacency_graph_2d::edge_iterator, grid_4_adjacency_graph_2d::edge_iterator>
+    edges(const grid_4_adjacency_graph_2d &g) {
+        using it = grid_4_adjacency_graph_2d::edge_iterator;
+        using fun = grid_4_adjacency_graph_2d::edge_from_index_fun;
+        using counting_it = counting_iterator<grid_4_adjacency_graph_2d::edge_index_t>;
+        return std::make_pair(
+                it(counting_it(0), fun{&g}),                 // The first iterator position
+                it(counting_it(num_edges(g)), fun{&g})); // The last iterator position
+    }
+
+    inline
+    std::pair<grid_4_adjacency_graph_2d::out_edge_iterator, grid_4_adjacency_graph_2d::out_edge_iterator>
+    out_edges(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        using it = grid_4_adjacency_graph_2d::out_edge_iterator;
+        return std::make_pair(it(&g, v, 0), it(&g, v, 4));
+    }
+
+    inline
+    std::pair<grid_4_adjacency_graph_2d::in_edge_iterator, grid_4_adjacency_graph_2d::in_edge_iterator>
+    in_edges(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        using it = grid_4_adjacency_graph_2d::in_edge_iterator;
+        return std::make_pair(it(&g, v, 0), it(&g, v, 4));
+    }
+
+    inline
+    std::pair<grid_4_adjacency_graph_2d::adjacency_iterator, grid_4_adjacency_graph_2d::adjacency_iterator>
+    adjacent_vertices(grid_4_adjacency_graph_2d::vertex_descriptor v, const grid_4_adjacency_graph_2d &g) {
+        using it = grid_4_adjacency_graph_2d::adjacency_iterator;
+        return std::make_pair(it(&g, v, 0), it(&g, v, 4));
+    }
+}
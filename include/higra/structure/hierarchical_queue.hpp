@@ -0,0 +1,353 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "../utils.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_BitScanForward64)
+#endif
+
+namespace hg {
+
+    namespace hierarchical_queue_internal {
+
+        using mask_type = uint64_t;
+
+        const index_t bits_per_word = 64;
+
+        /**
+         * Precondition: mask != 0
+         * @param mask
+         * @return
+         */
+        inline index_t lowest_set_bit(mask_type mask) {
+#ifdef _MSC_VER
+            unsigned long least_significant_bit_index = 0;
+            _BitScanForward64(&least_significant_bit_index, mask);
+            return least_significant_bit_index;
+#else
+            return __builtin_ctzll(mask);
+#endif
+        }
+
+        /**
+         * Precondition: mask != 0
+         * @param mask
+         * @return
+         */
+        inline index_t highest_set_bit(mask_type mask) {
+#ifdef _MSC_VER
+            unsigned long most_significant_bit_index = 0;
+            _BitScanReverse64(&most_significant_bit_index, mask);
+            return most_significant_bit_index;
+#else
+            return bits_per_word - 1 - __builtin_clzll(mask);
+#endif
+        }
+
+        /**
+         * Mask of the bits of index greater than or equal to i (i in [0, 64[)
+         */
+        inline mask_type mask_from(index_t i) {
+            return ~(mask_type) 0 << i;
+        }
+
+        /**
+         * Mask of the bits of index lower than or equal to i (i in [0, 64[)
+         */
+        inline mask_type mask_to(index_t i) {
+            return ~(mask_type) 0 >> (bits_per_word - 1 - i);
+        }
+
+        /**
+         * Hierarchical queue (bucket priority queue) with a fixed number of integer levels in [0, num_levels[.
+         *
+         * Each level is a FIFO queue. The elements of all the levels are stored in a single pooled buffer of linked
+         * nodes whose size is the maximal number of elements simultaneously present in the queue: a level only costs
+         * two indices whatever its number of elements.
+         *
+         * The non empty levels are indexed by a two level occupancy bitmap: a bit per level and a summary bit per
+         * 64 levels. The nearest non empty level above or below a given level is found with a few bit scan
+         * instructions: the search is O(1) for up to 4096 levels and O(num_levels / 4096) in general (16 words for
+         * 16 bits levels).
+         *
+         * All other operations are done in constant time, except the constructor which runs in O(num_levels).
+         *
+         * Warning: not thread safe
+         *
+         * @tparam value_t type of stored values
+         */
+        template<typename value_t>
+        struct hierarchical_queue {
+            using value_type = value_t;
+
+            /**
+             * Create an empty queue with the integer levels in [0, num_levels[
+             * @param num_levels
+             */
+            hierarchical_queue(index_t num_levels) :
+                    m_num_levels(num_levels),
+                    m_head(num_levels, invalid_index),
+                    m_tail(num_levels, invalid_index),
+                    m_occupancy((num_levels + bits_per_word - 1) / bits_per_word, 0),
+                    m_summary((m_occupancy.size() + bits_per_word - 1) / bits_per_word, 0) {
+            }
+
+            /**
+             *
+             * @return number of levels in the queue
+             */
+            index_t num_levels() const {
+                return m_num_levels;
+            }
+
+            /**
+             *
+             * @return number of elements in the queue
+             */
+            index_t size() const {
+                return m_size;
+            }
+
+            /**
+             *
+             * @return true if the queue is empty
+             */
+            bool empty() const {
+                return m_size == 0;
+            }
+
+            /**
+             *
+             * @param level in [0, num_levels[
+             * @return true if the given level of the queue is empty
+             */
+            bool level_empty(index_t level) const {
+                return m_head[level] == invalid_index;
+            }
+
+            /**
+             * Add a new element at the end of the given level of the queue
+             * @param level in [0, num_levels[
+             * @param v new element
+             */
+            void push(index_t level, const value_type &v) {
+                index_t node;
+                if (m_free != invalid_index) {
+                    node = m_free;
+                    m_free = m_nodes[node].next;
+                    m_nodes[node] = {v, invalid_index};
+                } else {
+                    node = m_nodes.size();
+                    m_nodes.push_back({v, invalid_index});
+                }
+                if (m_head[level] == invalid_index) {
+                    m_head[level] = node;
+                    index_t word = level / bits_per_word;
+                    if (m_occupancy[word] == 0) {
+                        m_summary[word / bits_per_word] |= (mask_type) 1 << (word % bits_per_word);
+                    }
+                    m_occupancy[word] |= (mask_type) 1 << (level % bits_per_word);
+                } else {
+                    m_nodes[m_tail[level]].next = node;
+                }
+                m_tail[level] = node;
+                m_size++;
+            }
+
+            /**
+             * Return a reference to the first element of the given queue level
+             * @param level in [0, num_levels[
+             * @return a reference to a value_type element
+             */
+            value_type &top(index_t level) {
+                return m_nodes[m_head[level]].value;
+            }
+
+            /**
+             * Return a const reference to the first element of the given queue level
+             * @param level in [0, num_levels[
+             * @return a const reference to a value_type element
+             */
+            const value_type &top(index_t level) const {
+                return m_nodes[m_head[level]].value;
+            }
+
+            /**
+             * Removes the first element of the given queue level
+             * @param level in [0, num_levels[
+             */
+            void pop(index_t level) {
+                index_t node = m_head[level];
+                m_head[level] = m_nodes[node].next;
+                m_nodes[node].next = m_free;
+                m_free = node;
+                if (m_head[level] == invalid_index) {
+                    m_tail[level] = invalid_index;
+                    index_t word = level / bits_per_word;
+                    m_occupancy[word] &= ~((mask_type) 1 << (level % bits_per_word));
+                    if (m_occupancy[word] == 0) {
+                        m_summary[word / bits_per_word] &= ~((mask_type) 1 << (word % bits_per_word));
+                    }
+                }
+                m_size--;
+            }
+
+            /**
+             * Smallest non empty level greater than or equal to the given level
+             *
+             * @param level in [0, num_levels[
+             * @return a queue level or hg::invalid_index if no such level exists
+             */
+            index_t next_non_empty_level(index_t level) const {
+                index_t word = level / bits_per_word;
+                mask_type mask = m_occupancy[word] & mask_from(level % bits_per_word);
+                if (mask != 0) {
+                    return word * bits_per_word + lowest_set_bit(mask);
+                }
+                word++;
+                index_t summary_word = word / bits_per_word;
+                if (summary_word >= (index_t) m_summary.size()) {
+                    return invalid_index;
+                }
+                mask = m_summary[summary_word] & mask_from(word % bits_per_word);
+                while (mask == 0) {
+                    summary_word++;
+                    if (summary_word == (index_t) m_summary.size()) {
+                        return invalid_index;
+                    }
+                    mask = m_summary[summary_word];
+                }
+                word = summary_word * bits_per_word + lowest_set_bit(mask);
+                return word * bits_per_word + lowest_set_bit(m_occupancy[word]);
+            }
+
+            /**
+             * Largest non empty level lower than or equal to the given level
+             *
+             * @param level in [0, num_levels[
+             * @return a queue level or hg::invalid_index if no such level exists
+             */
+            index_t previous_non_empty_level(index_t level) const {
+                index_t word = level / bits_per_word;
+                mask_type mask = m_occupancy[word] & mask_to(level % bits_per_word);
+                if (mask != 0) {
+                    return word * bits_per_word + highest_set_bit(mask);
+                }
+                if (word == 0) {
+                    return invalid_index;
+                }
+                word--;
+                index_t summary_word = word / bits_per_word;
+                mask = m_summary[summary_word] & mask_to(word % bits_per_word);
+                while (mask == 0) {
+                    if (summary_word == 0) {
+                        return invalid_index;
+                    }
+                    summary_word--;
+                    mask = m_summary[summary_word];
+                }
+                word = summary_word * bits_per_word + highest_set_bit(mask);
+                return word * bits_per_word + highest_set_bit(m_occupancy[word]);
+            }
+
+            /**
+             * Smallest non empty level of the queue
+             *
+             * @return a queue level or hg::invalid_index if the queue is empty
+             */
+            index_t first_non_empty_level() const {
+                return next_non_empty_level(0);
+            }
+
+            /**
+             * Largest non empty level of the queue
+             *
+             * @return a queue level or hg::invalid_index if the queue is empty
+             */
+            index_t last_non_empty_level() const {
+                return previous_non_empty_level(m_num_levels - 1);
+            }
+
+            /**
+             * Given a queue level, find the closest non empty level in the queue.
+             * In case of equality the smallest level is returned.
+             *
+             * @param level in [0, num_levels[
+             * @return a queue level or hg::invalid_index if the queue is empty
+             */
+            index_t find_closest_non_empty_level(index_t level) const {
+                index_t low = previous_non_empty_level(level);
+                if (low == level) {
+                    return level;
+                }
+                index_t high = (level + 1 < m_num_levels) ? next_non_empty_level(level + 1) : invalid_index;
+                if (low == invalid_index) {
+                    return high;
+                }
+                if (high == invalid_index || level - low <= high - level) {
+                    return low;
+                }
+                return high;
+            }
+
+            /**
+             * Removes all the elements of the queue: the pooled buffer keeps its capacity
+             */
+            void clear() {
+                for (auto &word: m_summary) {
+                    while (word != 0) {
+                        index_t occupancy_word = (&word - m_summary.data()) * bits_per_word + lowest_set_bit(word);
+                        word &= word - 1;
+                        auto &occupancy = m_occupancy[occupancy_word];
+                        while (occupancy != 0) {
+                            index_t level = occupancy_word * bits_per_word + lowest_set_bit(occupancy);
+                            occupancy &= occupancy - 1;
+                            m_head[level] = invalid_index;
+                            m_tail[level] = invalid_index;
+                        }
+                    }
+                }
+                m_nodes.clear();
+                m_free = invalid_index;
+                m_size = 0;
+            }
+
+        private:
+
+            struct node {
+                value_type value;
+                index_t next;
+            };
+
+            index_t m_num_levels;
+            // first and last node of each level
+            std::vector<index_t> m_head;
+            std::vector<index_t> m_tail;
+            // one bit per level
+            std::vector<mask_type> m_occupancy;
+            // one bit per word of m_occupancy
+            std::vector<mask_type> m_summary;
+            // pooled nodes and head of the list of free nodes
+            std::vector<node> m_nodes;
+            index_t m_free = invalid_index;
+            index_t m_size = 0;
+        };
+    }
+
+    template<typename value_t>
+    using hierarchical_queue = hierarchical_queue_internal::hierarchical_queue<value_t>;
+}
@@ -0,0 +1,861 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <type_traits>
+#include <limits>
+#include "../utils.hpp"
+#include "hierarchical_queue.hpp"
+
+namespace hg {
+
+    namespace indexed_heap_internal {
+
+        /**
+         * Indexed d-ary min heap stored in a flat array.
+         *
+         * Each element of the heap is identified by a key in [0, capacity): the position of every key in the heap
+         * array is tracked, so that the value associated to a key can be updated (increased or decreased) or removed
+         * in O(log_d(n)) without any handle. Values and keys are stored contiguously in the heap array, so that
+         * sift operations do not perform any indirect access to compare two elements.
+         *
+         * Elements are ordered by increasing value, ties are broken by increasing key: the top of the heap is thus
+         * always well defined and does not depend on the history of the heap.
+         *
+         * Warning: not thread safe
+         *
+         * @tparam T Value type, must define the operator <
+         * @tparam arity number of children of each node of the heap (4 is usually a good trade-off between the depth of
+         *               the heap and the number of comparisons per level)
+         */
+        template<typename T, index_t arity = 4>
+        struct indexed_dary_heap {
+
+            static_assert(arity >= 2, "Heap arity must be greater than or equal to 2.");
+
+            using value_type = T;
+
+            /**
+             * Create an empty heap able to store the keys in [0, capacity)
+             *
+             * @param capacity
+             */
+            indexed_dary_heap(size_t capacity = 0) : m_position(capacity, invalid_index) {
+            }
+
+            /**
+             * Change the range of possible keys to [0, capacity). Keys outside the new range must not be in the heap.
+             *
+             * @param capacity
+             */
+            void resize(size_t capacity) {
+                m_position.resize(capacity, invalid_index);
+            }
+
+            size_t capacity() const {
+                return m_position.size();
+            }
+
+            size_t size() const {
+                return m_heap.size();
+            }
+
+            bool empty() const {
+                return m_heap.empty();
+            }
+
+            /**
+             * Test if the given key is in the heap
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             * @return
+             */
+            bool contains(index_t key) const {
+                return m_position[key] != invalid_index;
+            }
+
+            /**
+             * Insert a new key with the given value in the heap. The key must not already be in the heap.
+             *
+             * Complexity O(log_d(n))
+             *
+             * @param key
+             * @param value
+             */
+            void push(index_t key, const T &value) {
+                hg_assert(!contains(key), "Key is already in the heap.");
+                m_heap.push_back({value, key});
+                m_position[key] = m_heap.size() - 1;
+                sift_up(m_heap.size() - 1);
+            }
+
+            /**
+             * Key of the min element of the heap
+             *
+             * Complexity O(1)
+             *
+             * @return
+             */
+            index_t top() const {
+                return m_heap[0].key;
+            }
+
+            /**
+             * Value of the min element of the heap
+             *
+             * Complexity O(1)
+             *
+             * @return
+             */
+            const T &top_value() const {
+                return m_heap[0].value;
+            }
+
+            /**
+             * Value associated to the given key. The key must be in the heap.
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             * @return
+             */
+            const T &value(index_t key) const {
+                return m_heap[m_position[key]].value;
+            }
+
+            /**
+             * Removes the min element from the heap
+             *
+             * Complexity O(d log_d(n))
+             */
+            void pop() {
+                erase_at(0);
+            }
+
+            /**
+             * Removes the given key from the heap. The key must be in the heap.
+             *
+             * Complexity O(d log_d(n))
+             *
+             * @param key
+             */
+            void erase(index_t key) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                erase_at(m_position[key]);
+            }
+
+            /**
+             * Changes the value associated to the given key. The key must be in the heap.
+             *
+             * Complexity O(d log_d(n))
+             *
+             * @param key
+             * @param value
+             */
+            void update(index_t key, const T &value) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                index_t i = m_position[key];
+                if (value < m_heap[i].value) {
+                    m_heap[i].value = value;
+                    sift_up(i);
+                } else {
+                    m_heap[i].value = value;
+                    sift_down(i);
+                }
+            }
+
+            /**
+             * Moves all the elements of the other heap into this heap: the two heaps must have the same capacity and
+             * must not share any key. The other heap is empty after the operation.
+             *
+             * Complexity O(n + m) if the other heap is larger than this one (the heap is rebuilt), and O(m log_d(n + m))
+             * otherwise
+             *
+             * @param other
+             */
+            void merge(indexed_dary_heap &other) {
+                hg_assert(capacity() == other.capacity(), "Heaps must have the same capacity.");
+                if (other.empty()) {
+                    return;
+                }
+                const index_t size_before = m_heap.size();
+                for (const auto &n: other.m_heap) {
+                    hg_assert(!contains(n.key), "Key is already in the heap.");
+                    m_heap.push_back(n);
+                    m_position[n.key] = m_heap.size() - 1;
+                    other.m_position[n.key] = invalid_index;
+                }
+                other.m_heap.clear();
+                if ((index_t) m_heap.size() - size_before >= size_before) {
+                    for (index_t i = ((index_t) m_heap.size() - 2) / arity; i >= 0; i--) {
+                        sift_down(i);
+                    }
+                } else {
+                    for (index_t i = size_before; i < (index_t) m_heap.size(); i++) {
+                        sift_up(i);
+                    }
+                }
+            }
+
+            /**
+             * Empties the heap
+             *
+             * Complexity O(n)
+             */
+            void clear() {
+                for (const auto &n: m_heap) {
+                    m_position[n.key] = invalid_index;
+                }
+                m_heap.clear();
+            }
+
+        private:
+
+            struct node {
+                T value;
+                index_t key;
+            };
+
+            static bool less(const node &a, const node &b) {
+                return a.value < b.value || (!(b.value < a.value) && a.key < b.key);
+            }
+
+            void erase_at(index_t i) {
+                m_position[m_heap[i].key] = invalid_index;
+                index_t last = m_heap.size() - 1;
+                if (i != last) {
+                    bool up = less(m_heap[last], m_heap[i]);
+                    m_heap[i] = m_heap[last];
+                    m_position[m_heap[i].key] = i;
+                    m_heap.pop_back();
+                    if (up) {
+                        sift_up(i);
+                    } else {
+                        sift_down(i);
+                    }
+                } else {
+                    m_heap.pop_back();
+                }
+            }
+
+            void sift_up(index_t i) {
+                node n = m_heap[i];
+                while (i > 0) {
+                    index_t parent = (i - 1) / arity;
+                    if (!less(n, m_heap[parent])) {
+                        break;
+                    }
+                    m_heap[i] = m_heap[parent];
+                    m_position[m_heap[i].key] = i;
+                    i = parent;
+                }
+                m_heap[i] = n;
+                m_position[n.key] = i;
+            }
+
+            void sift_down(index_t i) {
+                index_t size = m_heap.size();
+                node n = m_heap[i];
+                while (true) {
+                    index_t first_child = i * arity + 1;
+                    if (first_child >= size) {
+                        break;
+                    }
+                    index_t last_child = (std::min)(first_child + arity, size);
+                    index_t min_child = first_child;
+                    for (index_t c = first_child + 1; c < last_child; c++) {
+                        if (less(m_heap[c], m_heap[min_child])) {
+                            min_child = c;
+                        }
+                    }
+                    if (!less(m_heap[min_child], n)) {
+                        break;
+                    }
+                    m_heap[i] = m_heap[min_child];
+                    m_position[m_heap[i].key] = i;
+                    i = min_child;
+                }
+                m_heap[i] = n;
+                m_position[n.key] = i;
+            }
+
+            std::vector<node> m_heap;
+            std::vector<index_t> m_position;
+        };
+
+        /**
+         * Indexed pairing min heap: same interface as indexed_dary_heap.
+         *
+         * Each key in [0, capacity) is a node of the heap: the value and the links of a key (first child, next
+         * sibling, and previous sibling or parent) are stored in flat arrays indexed by the key, no memory is
+         * allocated after construction. Push, decrease-key and merge are in O(1) (merge is in O(m) as the nodes of
+         * the other heap are copied), pop, erase, and increase-key are in O(log(n)) amortized.
+         *
+         * Elements are ordered by increasing value, ties are broken by increasing key.
+         *
+         * Warning: not thread safe
+         *
+         * @tparam T Value type, must define the operator <
+         */
+        template<typename T>
+        struct indexed_pairing_heap {
+
+            using value_type = T;
+
+            /**
+             * Create an empty heap able to store the keys in [0, capacity)
+             *
+             * @param capacity
+             */
+            indexed_pairing_heap(size_t capacity = 0) :
+                    m_value(capacity),
+                    m_child(capacity, invalid_index),
+                    m_next(capacity, invalid_index),
+                    m_prev(capacity, invalid_index),
+                    m_contains(capacity, false),
+                    m_root(invalid_index),
+                    m_size(0) {
+            }
+
+            /**
+             * Change the range of possible keys to [0, capacity). Keys outside the new range must not be in the heap.
+             *
+             * @param capacity
+             */
+            void resize(size_t capacity) {
+                m_value.resize(capacity);
+                m_child.resize(capacity, invalid_index);
+                m_next.resize(capacity, invalid_index);
+                m_prev.resize(capacity, invalid_index);
+                m_contains.resize(capacity, false);
+            }
+
+            size_t capacity() const {
+                return m_value.size();
+            }
+
+            size_t size() const {
+                return m_size;
+            }
+
+            bool empty() const {
+                return m_size == 0;
+            }
+
+            bool contains(index_t key) const {
+                return m_contains[key];
+            }
+
+            /**
+             * Insert a new key with the given value in the heap. The key must not already be in the heap.
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             * @param value
+             */
+            void push(index_t key, const T &value) {
+                hg_assert(!contains(key), "Key is already in the heap.");
+                m_value[key] = value;
+                m_child[key] = invalid_index;
+                m_next[key] = invalid_index;
+                m_prev[key] = invalid_index;
+                m_contains[key] = true;
+                m_size++;
+                m_root = (m_root == invalid_index) ? key : link(m_root, key);
+            }
+
+            index_t top() const {
+                return m_root;
+            }
+
+            const T &top_value() const {
+                return m_value[m_root];
+            }
+
+            const T &value(index_t key) const {
+                return m_value[key];
+            }
+
+            /**
+             * Removes the min element from the heap
+             *
+             * Complexity O(log(n)) amortized
+             */
+            void pop() {
+                index_t root = m_root;
+                m_root = merge_pairs(m_child[root]);
+                release(root);
+            }
+
+            /**
+             * Removes the given key from the heap. The key must be in the heap.
+             *
+             * Complexity O(log(n)) amortized
+             *
+             * @param key
+             */
+            void erase(index_t key) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                if (key == m_root) {
+                    pop();
+                    return;
+                }
+                detach(key);
+                index_t sub_heap = merge_pairs(m_child[key]);
+                if (sub_heap != invalid_index) {
+                    m_root = link(m_root, sub_heap);
+                }
+                release(key);
+            }
+
+            /**
+             * Changes the value associated to the given key. The key must be in the heap.
+             *
+             * Complexity O(1) if the value decreases, O(log(n)) amortized otherwise
+             *
+             * @param key
+             * @param value
+             */
+            void update(index_t key, const T &value) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                if (value < m_value[key]) {
+                    m_value[key] = value;
+                    if (key != m_root) {
+                        detach(key);
+                        m_root = link(m_root, key);
+                    }
+                } else {
+                    erase(key);
+                    push(key, value);
+                }
+            }
+
+            /**
+             * Moves all the elements of the other heap into this heap: the two heaps must have the same capacity and
+             * must not share any key. The other heap is empty after the operation.
+             *
+             * Complexity O(m)
+             *
+             * @param other
+             */
+            void merge(indexed_pairing_heap &other) {
+                hg_assert(capacity() == other.capacity(), "Heaps must have the same capacity.");
+                if (other.m_root == invalid_index) {
+                    return;
+                }
+                other.for_each_node([this, &other](index_t n) {
+                    hg_assert(!contains(n), "Key is already in the heap.");
+                    m_value[n] = other.m_value[n];
+                    m_child[n] = other.m_child[n];
+                    m_next[n] = other.m_next[n];
+                    m_prev[n] = other.m_prev[n];
+                    m_contains[n] = true;
+                    other.m_contains[n] = false;
+                });
+                m_size += other.m_size;
+                m_root = (m_root == invalid_index) ? other.m_root : link(m_root, other.m_root);
+                other.m_root = invalid_index;
+                other.m_size = 0;
+            }
+
+            /**
+             * Empties the heap
+             *
+             * Complexity O(n)
+             */
+            void clear() {
+                for_each_node([this](index_t n) { m_contains[n] = false; });
+                m_root = invalid_index;
+                m_size = 0;
+            }
+
+        private:
+
+            bool less(index_t a, index_t b) const {
+                return m_value[a] < m_value[b] || (!(m_value[b] < m_value[a]) && a < b);
+            }
+
+            /**
+             * Links two roots: the loser becomes the first child of the winner, which is returned.
+             */
+            index_t link(index_t a, index_t b) {
+                if (less(b, a)) {
+                    std::swap(a, b);
+                }
+                index_t first_child = m_child[a];
+                m_next[b] = first_child;
+                if (first_child != invalid_index) {
+                    m_prev[first_child] = b;
+                }
+                m_prev[b] = a;
+                m_child[a] = b;
+                return a;
+            }
+
+            /**
+             * Removes the sub-heap rooted in the given node (which is not the root) from the sibling list of its parent.
+             */
+            void detach(index_t n) {
+                index_t prev = m_prev[n];
+                index_t next = m_next[n];
+                if (m_child[prev] == n) {
+                    m_child[prev] = next;
+                } else {
+                    m_next[prev] = next;
+                }
+                if (next != invalid_index) {
+                    m_prev[next] = prev;
+                }
+                m_prev[n] = invalid_index;
+                m_next[n] = invalid_index;
+            }
+
+            /**
+             * Two pass pairing of a list of siblings, returns the new root (invalid_index if the list is empty).
+             */
+            index_t merge_pairs(index_t first) {
+                // first pass: link pairs from left to right, the results are stacked using the next links
+                index_t stack = invalid_index;
+                index_t a = first;
+                while (a != invalid_index) {
+                    index_t b = m_next[a];
+                    index_t next = invalid_index;
+                    if (b != invalid_index) {
+                        next = m_next[b];
+                        a = link(a, b);
+                    }
+                    m_next[a] = stack;
+                    stack = a;
+                    a = next;
+                }
+                // second pass: link the stacked heaps from right to left
+                index_t result = invalid_index;
+                while (stack != invalid_index) {
+                    index_t next = m_next[stack];
+                    m_next[stack] = invalid_index;
+                    m_prev[stack] = invalid_index;
+                    result = (result == invalid_index) ? stack : link(result, stack);
+                    stack = next;
+                }
+                return result;
+            }
+
+            void release(index_t n) {
+                m_contains[n] = false;
+                m_child[n] = invalid_index;
+                m_next[n] = invalid_index;
+                m_prev[n] = invalid_index;
+                m_size--;
+            }
+
+            template<typename fun_t>
+            void for_each_node(fun_t fun) {
+                if (m_root == invalid_index) {
+                    return;
+                }
+                std::vector<index_t> stack{m_root};
+                while (!stack.empty()) {
+                    index_t n = stack.back();
+                    stack.pop_back();
+                    for (index_t c = m_child[n]; c != invalid_index; c = m_next[c]) {
+                        stack.push_back(c);
+                    }
+                    fun(n);
+                }
+            }
+
+            std::vector<T> m_value;
+            std::vector<index_t> m_child;
+            std::vector<index_t> m_next;
+            std::vector<index_t> m_prev;
+            std::vector<bool> m_contains;
+            index_t m_root;
+            size_t m_size;
+        };
+
+        /**
+         * Indexed radix min heap for integral values: same interface as indexed_dary_heap, with the restriction that
+         * the values are monotone: a value pushed or updated in the heap must be greater than or equal to the last
+         * min value extracted from the heap with top or top_value (this is the case in Dijkstra-like and flooding
+         * algorithms with non negative integer weights). The restriction is lifted each time the heap becomes empty.
+         *
+         * The keys are distributed in 65 buckets: the bucket of a key with value v is given by the highest bit
+         * that differs between v and the last min value. The bucket 0 contains the keys whose value is equal to
+         * the last min value. When the top of the heap is queried and the bucket 0 is empty, the first non empty
+         * bucket is redistributed in the lower buckets: each key moves at most 64 times between buckets whatever the
+         * number of elements in the heap. Push, erase, and update are in O(1), top is in O(log(C)) amortized with C
+         * the range of the values.
+         *
+         * Elements are ordered by increasing value, ties are broken arbitrarily.
+         *
+         * Warning: not thread safe
+         *
+         * @tparam T integral value type (at most 64 bits)
+         */
+        template<typename T>
+        struct indexed_radix_heap {
+
+            static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                          "Radix heap values must be of an integral type of at most 64 bits.");
+
+            using value_type = T;
+
+            /**
+             * Create an empty heap able to store the keys in [0, capacity)
+             *
+             * @param capacity
+             */
+            indexed_radix_heap(size_t capacity = 0) :
+                    m_value(capacity),
+                    m_bucket(capacity, invalid_index),
+                    m_position(capacity),
+                    m_buckets(num_buckets),
+                    m_non_empty_buckets(0),
+                    m_last(std::numeric_limits<T>::lowest()),
+                    m_size(0) {
+            }
+
+            /**
+             * Change the range of possible keys to [0, capacity). Keys outside the new range must not be in the heap.
+             *
+             * @param capacity
+             */
+            void resize(size_t capacity) {
+                m_value.resize(capacity);
+                m_bucket.resize(capacity, invalid_index);
+                m_position.resize(capacity);
+            }
+
+            size_t capacity() const {
+                return m_value.size();
+            }
+
+            size_t size() const {
+                return m_size;
+            }
+
+            bool empty() const {
+                return m_size == 0;
+            }
+
+            bool contains(index_t key) const {
+                return m_bucket[key] != invalid_index;
+            }
+
+            /**
+             * Insert a new key with the given value in the heap. The key must not already be in the heap and the value
+             * must be greater than or equal to the last min value (if the heap is not empty).
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             * @param value
+             */
+            void push(index_t key, const T &value) {
+                hg_assert(!contains(key), "Key is already in the heap.");
+                if (m_size == 0) {
+                    m_last = std::numeric_limits<T>::lowest();
+                }
+                hg_assert(!(value < m_last), "Radix heap values must be greater than or equal to the last min value.");
+                m_value[key] = value;
+                insert(key);
+                m_size++;
+            }
+
+            /**
+             * Key of the min element of the heap
+             *
+             * Complexity O(log(C)) amortized
+             *
+             * @return
+             */
+            index_t top() {
+                if (m_buckets[0].empty()) {
+                    refill();
+                }
+                return m_buckets[0].back();
+            }
+
+            /**
+             * Value of the min element of the heap
+             *
+             * Complexity O(log(C)) amortized
+             *
+             * @return
+             */
+            const T &top_value() {
+                return m_value[top()];
+            }
+
+            const T &value(index_t key) const {
+                return m_value[key];
+            }
+
+            /**
+             * Removes the min element from the heap
+             *
+             * Complexity O(log(C)) amortized
+             */
+            void pop() {
+                erase(top());
+            }
+
+            /**
+             * Removes the given key from the heap. The key must be in the heap.
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             */
+            void erase(index_t key) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                remove(key);
+                m_size--;
+            }
+
+            /**
+             * Changes the value associated to the given key. The key must be in the heap and the new value must be
+             * greater than or equal to the last min value.
+             *
+             * Complexity O(1)
+             *
+             * @param key
+             * @param value
+             */
+            void update(index_t key, const T &value) {
+                hg_assert(contains(key), "Key is not in the heap.");
+                hg_assert(!(value < m_last), "Radix heap values must be greater than or equal to the last min value.");
+                remove(key);
+                m_value[key] = value;
+                insert(key);
+            }
+
+            /**
+             * Moves all the elements of the other heap into this heap: the two heaps must have the same capacity and
+             * must not share any key, and the values of the other heap must be greater than or equal to the last min
+             * value of this heap. The other heap is empty after the operation.
+             *
+             * Complexity O(m)
+             *
+             * @param other
+             */
+            void merge(indexed_radix_heap &other) {
+                hg_assert(capacity() == other.capacity(), "Heaps must have the same capacity.");
+                for (auto &bucket: other.m_buckets) {
+                    for (auto key: bucket) {
+                        other.m_bucket[key] = invalid_index;
+                        push(key, other.m_value[key]);
+                    }
+                    bucket.clear();
+                }
+                other.m_non_empty_buckets = 0;
+                other.m_size = 0;
+            }
+
+            /**
+             * Empties the heap
+             *
+             * Complexity O(n)
+             */
+            void clear() {
+                for (auto &bucket: m_buckets) {
+                    for (auto key: bucket) {
+                        m_bucket[key] = invalid_index;
+                    }
+                    bucket.clear();
+                }
+                m_non_empty_buckets = 0;
+                m_size = 0;
+            }
+
+        private:
+
+            static const index_t num_buckets = 65;
+
+            /**
+             * Order preserving conversion of a value to a 64 bits unsigned integer.
+             */
+            static uint64_t to_bits(T value) {
+                if (std::is_signed<T>::value) {
+                    return (uint64_t) (int64_t) value ^ ((uint64_t) 1 << 63);
+                }
+                return (uint64_t) value;
+            }
+
+            void insert(index_t key) {
+                uint64_t diff = to_bits(m_value[key]) ^ to_bits(m_last);
+                index_t b = (diff == 0) ? 0 : hierarchical_queue_internal::highest_set_bit(diff) + 1;
+                m_bucket[key] = b;
+                m_position[key] = m_buckets[b].size();
+                m_buckets[b].push_back(key);
+                if (b > 0) {
+                    m_non_empty_buckets |= (uint64_t) 1 << (b - 1);
+                }
+            }
+
+            void remove(index_t key) {
+                index_t b = m_bucket[key];
+                auto &bucket = m_buckets[b];
+                index_t last = bucket.back();
+                bucket[m_position[key]] = last;
+                m_position[last] = m_position[key];
+                bucket.pop_back();
+                m_bucket[key] = invalid_index;
+                if (b > 0 && bucket.empty()) {
+                    m_non_empty_buckets &= ~((uint64_t) 1 << (b - 1));
+                }
+            }
+
+            /**
+             * Empty bucket 0 in a non empty heap: the first non empty bucket is redistributed using its min value as
+             * the new last min value.
+             */
+            void refill() {
+                index_t b = hierarchical_queue_internal::lowest_set_bit(m_non_empty_buckets) + 1;
+                m_non_empty_buckets &= ~((uint64_t) 1 << (b - 1));
+                std::swap(m_buffer, m_buckets[b]);
+                m_last = m_value[m_buffer[0]];
+                for (auto key: m_buffer) {
+                    if (m_value[key] < m_last) {
+                        m_last = m_value[key];
+                    }
+                }
+                for (auto key: m_buffer) {
+                    insert(key);
+                }
+                m_buffer.clear();
+            }
+
+            std::vector<T> m_value;
+            std::vector<index_t> m_bucket;
+            std::vector<index_t> m_position;
+            std::vector<std::vector<index_t>> m_buckets;
+            std::vector<index_t> m_buffer;
+            uint64_t m_non_empty_buckets;
+            T m_last;
+            size_t m_size;
+        };
+    }
+
+    template<typename T, index_t arity = 4>
+    using indexed_dary_heap = indexed_heap_internal::indexed_dary_heap<T, arity>;
+
+    template<typename T>
+    using indexed_pairing_heap = indexed_heap_internal::indexed_pairing_heap<T>;
+
+    template<typename T>
+    using indexed_radix_heap = indexed_heap_internal::indexed_radix_heap<T>;
+
+}
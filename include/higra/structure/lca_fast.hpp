@@ -15,8 +15,33 @@
 #include <stack>
 
 namespace hg {
+
+    /**
+     * Strategy used to answer a batch of lowest common ancestor queries:
+     *  - independent: each query is answered on its own, in the input order;
+     *  - sorted: queries are answered offline, in the order of the Euler tour, which gives a streaming memory access
+     *    pattern on large trees at the cost of a linear bucket sort of the queries;
+     *  - automatic: sorted for large batches on large trees, independent otherwise.
+     */
+    enum class lca_batch_mode {
+        independent,
+        sorted,
+        automatic
+    };
+
+    // minimal batch size for which lca_batch_mode::automatic selects the sorted mode
+    const index_t lca_sorted_batch_min_size = 1 << 20;
+    // minimal Euler tour size for which lca_batch_mode::automatic selects the sorted mode: below this size, the
+    // Euler tour and the rmq solver mostly fit in the last level cache and sorting the queries does not pay off
+    const index_t lca_sorted_tree_min_size = 1 << 25;
+
     namespace lca_internal {
 
+        // a query costs a few tens of nanoseconds: queries are processed by tasks of at least 1024 queries and
+        // batches of less than 4096 queries are processed serially
+        constexpr execution::parallel_policy lca_parallel_policy =
+                execution::par.with_grain_size(1024).with_serial_cutoff(4096);
+
         /**
          * Lowest common ancestor solver based on the range minimum query
          * @tparam tree_t
@@ -39,15 +64,9 @@ namespace hg {
             template<typename ...Args>
             lca_rmq(const tree_t &tree, Args &&... args) {
                 HG_TRACE();
-                auto num_nodes = hg::num_vertices(tree);
-                auto num_elements_Euler_tour = 2 * num_nodes - 1;
-
-                m_first_visit_in_Euler_tour.resize({num_nodes});
-                m_tree_Euler_tour_map.resize({num_elements_Euler_tour});
-                m_tree_Euler_tour_depth.resize({num_elements_Euler_tour});
-
                 compute_Euler_tour(tree);
                 m_rmq_solver = rmq_t(m_tree_Euler_tour_depth, std::forward<Args>(args)...);
+                HG_PROFILE_COUNT("lca_rmq table bytes", table_bytes());
             }
 
             /**
@@ -74,20 +93,18 @@ namespace hg {
              * Return the lowest common ancestors of a range of pairs of nodes
              * @tparam T
              * @param range
+             * @param mode query ordering strategy (see lca_batch_mode)
              * @return
              */
             template<typename T>
-            auto lca(const T &range) const {
+            auto lca(const T &range, lca_batch_mode mode = lca_batch_mode::automatic) const {
                 HG_TRACE();
                 size_t size = range.end() - range.begin();
-                auto result = array_1d<index_t>::from_shape({size});
-
                 auto it = range.begin();
-                parfor(0, size, [&result, &it, this](index_t i) {
-                    auto e = it[i];
-                    result(i) = this->lca(e.first, e.second);
-                });
-                return result;
+                return lca_batch(size,
+                                 [&it](index_t i) { return it[i].first; },
+                                 [&it](index_t i) { return it[i].second; },
+                                 mode);
             }
 
             /**
@@ -98,10 +115,12 @@ namespace hg {
              * @tparam T
              * @param xvertices1 first array of graph vertices
              * @param xvertices2 second array of graph vertices
+             * @param mode query ordering strategy (see lca_batch_mode)
              * @return array of lowest common ancestors
              */
             template<typename T>
-            auto lca(const xt::xexpression<T> &xvertices1, const xt::xexpression<T> &xvertices2) const {
+            auto lca(const xt::xexpression<T> &xvertices1, const xt::xexpression<T> &xvertices2,
+                     lca_batch_mode mode = lca_batch_mode::automatic) const {
                 HG_TRACE();
                 auto &vertices1 = xvertices1.derived_cast();
                 auto &vertices2 = xvertices2.derived_cast();
@@ -109,13 +128,74 @@ namespace hg {
                 hg_assert_integral_value_type(vertices1);
                 hg_assert_same_shape(vertices1, vertices2);
 
-                auto size = vertices1.size();
-                auto result = array_1d<index_t>::from_shape({size});
+                return lca_batch(vertices1.size(),
+                                 [&vertices1](index_t i) { return (index_t) vertices1(i); },
+                                 [&vertices2](index_t i) { return (index_t) vertices2(i); },
+                                 mode);
+            }
 
-                parfor(0, size, [&vertices1, &vertices2, &result, this](index_t i) {
-                    result(i) = this->lca(vertices1(i), vertices2(i));
+            /**
+             * Calls fun(i, lca(first_node(i), second_node(i))) for each query i in [0, size[ without materializing the
+             * array of lowest common ancestors. Queries may be answered in any order and concurrently (see
+             * lca_batch_mode).
+             *
+             * @tparam F1
+             * @tparam F2
+             * @tparam F3
+             * @param size number of queries
+             * @param first_node first node of the i-th query
+             * @param second_node second node of the i-th query
+             * @param fun function called with the index of each query and its lowest common ancestor
+             * @param mode query ordering strategy (see lca_batch_mode)
+             */
+            template<typename F1, typename F2, typename F3>
+            void for_each_lca(size_t size, const F1 &first_node, const F2 &second_node, const F3 &fun,
+                              lca_batch_mode mode = lca_batch_mode::automatic) const {
+                if (mode == lca_batch_mode::automatic) {
+                    mode = ((index_t) size >= lca_sorted_batch_min_size &&
+                            (index_t) m_tree_Euler_tour_depth.size() >= lca_sorted_tree_min_size) ?
+                           lca_batch_mode::sorted : lca_batch_mode::independent;
+                }
+
+                if (mode == lca_batch_mode::independent) {
+                    parfor(lca_parallel_policy, 0, size, [&fun, &first_node, &second_node, this](index_t i) {
+                        fun(i, this->lca(first_node(i), second_node(i)));
+                    });
+                    return;
+                }
+
+                // offline mode: queries are bucket sorted on the position of their first end in the Euler tour
+                // and answered in this order, so that the Euler tour and the rmq solver are read in streaming order
+                const index_t bucket_shift = 6;
+                const index_t num_buckets = (m_tree_Euler_tour_depth.size() >> bucket_shift) + 1;
+                array_1d<index_t> lower = array_1d<index_t>::from_shape({size});
+                array_1d<index_t> upper = array_1d<index_t>::from_shape({size});
+                parfor(lca_parallel_policy, 0, size, [&lower, &upper, &first_node, &second_node, this](index_t i) {
+                    index_t ii = m_first_visit_in_Euler_tour(first_node(i));
+                    index_t jj = m_first_visit_in_Euler_tour(second_node(i));
+                    lower(i) = (std::min)(ii, jj);
+                    upper(i) = (std::max)(ii, jj);
+                });
+
+                array_1d<index_t> bucket_start = xt::zeros<index_t>({(size_t) num_buckets + 1});
+                for (index_t i = 0; i < (index_t) size; i++) {
+                    bucket_start(1 + (lower(i) >> bucket_shift))++;
+                }
+                for (index_t b = 0; b < num_buckets; b++) {
+                    bucket_start(b + 1) += bucket_start(b);
+                }
+                array_1d<index_t> order = array_1d<index_t>::from_shape({size});
+                for (index_t i = 0; i < (index_t) size; i++) {
+                    order(bucket_start(lower(i) >> bucket_shift)++) = i;
+                }
+
+                parfor(lca_parallel_policy, 0, size, [&fun, &order, &lower, &upper, this](index_t k) {
+                    index_t i = order(k);
+                    index_t ii = lower(i);
+                    index_t jj = upper(i);
+                    fun(i, (ii == jj) ? m_tree_Euler_tour_map(ii) :
+                           m_tree_Euler_tour_map(m_rmq_solver.query(ii, jj)));
                 });
-                return result;
             }
 
             template<template<typename> typename container_t>
@@ -147,12 +227,23 @@ namespace hg {
             };
 
             auto get_state() const {
-                return internal_state<array_1d>(m_tree_Euler_tour_map,
-                                                m_tree_Euler_tour_depth,
-                                                m_first_visit_in_Euler_tour,
+                return internal_state<array_1d>(m_tree_Euler_tour_map.to_array(),
+                                                m_tree_Euler_tour_depth.to_array(),
+                                                m_first_visit_in_Euler_tour.to_array(),
                                                 m_rmq_solver.get_state());
             }
 
+            /**
+             * State sharing the buffers of this object (no copy): the solver can be recreated from it with
+             * make_from_state without any preprocessing.
+             */
+            auto get_shared_state() const {
+                return internal_state<details::shared_array_1d>(m_tree_Euler_tour_map,
+                                                                m_tree_Euler_tour_depth,
+                                                                m_first_visit_in_Euler_tour,
+                                                                m_rmq_solver.get_shared_state());
+            }
+
             template<template<typename> typename container_t>
             static auto make_from_state(internal_state<container_t> &&state) {
                 using lca_t = typename internal_state<container_t>::type;
@@ -173,68 +264,108 @@ namespace hg {
                 return m_first_visit_in_Euler_tour.size();
             }
 
+            /**
+             * Size in bytes of the tables of the range minimum query solver (the Euler tour is not included).
+             */
+            size_t table_bytes() const {
+                return m_rmq_solver.table_bytes();
+            }
+
         private:
 
             lca_rmq(){};
 
             template<template<typename> typename container_t>
             void set_state(internal_state<container_t> &&state) {
-                m_tree_Euler_tour_map = std::move(state.tree_Euler_tour_map);
-                m_tree_Euler_tour_depth = std::move(state.tree_Euler_tour_depth);
-                m_first_visit_in_Euler_tour = std::move(state.first_visit_in_Euler_tour);
+                m_tree_Euler_tour_map = details::make_shared_array_1d(std::move(state.tree_Euler_tour_map));
+                m_tree_Euler_tour_depth = details::make_shared_array_1d(std::move(state.tree_Euler_tour_depth));
+                m_first_visit_in_Euler_tour = details::make_shared_array_1d(std::move(state.first_visit_in_Euler_tour));
                 m_rmq_solver = rmq_t::make_from_state(std::move(state.rmq_state), m_tree_Euler_tour_depth);
             }
 
             template<template<typename> typename container_t>
             void set_state(const internal_state<container_t> &state) {
-                m_tree_Euler_tour_map = state.tree_Euler_tour_map;
-                m_tree_Euler_tour_depth = state.tree_Euler_tour_depth;
-                m_first_visit_in_Euler_tour = state.first_visit_in_Euler_tour;
+                m_tree_Euler_tour_map = details::make_shared_array_1d(state.tree_Euler_tour_map);
+                m_tree_Euler_tour_depth = details::make_shared_array_1d(state.tree_Euler_tour_depth);
+                m_first_visit_in_Euler_tour = details::make_shared_array_1d(state.first_visit_in_Euler_tour);
                 m_rmq_solver = rmq_t::make_from_state(state.rmq_state, m_tree_Euler_tour_depth);
             }
 
+            /**
+             * Answer a batch of queries: the i-th query is given by the nodes first_node(i) and second_node(i).
+             */
+            template<typename F1, typename F2>
+            auto lca_batch(size_t size, const F1 &first_node, const F2 &second_node, lca_batch_mode mode) const {
+                auto result = array_1d<index_t>::from_shape({size});
+                for_each_lca(size, first_node, second_node, [&result](index_t i, index_t lca) {
+                    result(i) = lca;
+                }, mode);
+                return result;
+            }
+
             // tree node index visited at each step of the Euler tour
-            array_1d<index_t> m_tree_Euler_tour_map;
+            details::shared_array_1d<index_t> m_tree_Euler_tour_map;
             // depth of the tree node visited at each step of the Euler tour
-            array_1d<index_t> m_tree_Euler_tour_depth;
+            details::shared_array_1d<index_t> m_tree_Euler_tour_depth;
             // index of the first time a node of the tree is visited in the Euler tour
-            array_1d<index_t> m_first_visit_in_Euler_tour;
+            details::shared_array_1d<index_t> m_first_visit_in_Euler_tour;
 
             // rmq solver
             rmq_t m_rmq_solver;
 
+            /**
+             * Euler tour of the tree, the children of a node being visited by increasing index: the tour of the sub
+             * tree rooted in a node n has 2 * size(n) - 1 elements (n followed by the tour of each child of n and by n
+             * again). The position of the first visit of each node is thus obtained from the sub tree sizes with a
+             * prefix sum on the children of each node, and the tour elements of each node are then written
+             * independently, in parallel.
+             */
             void compute_Euler_tour(const tree_t &tree) {
                 tree.compute_children();
+                const index_t num_nodes = num_vertices(tree);
+                const index_t num_l = num_leaves(tree);
+                const index_t root_node = root(tree);
 
-                struct se {
-                    index_t node;
-                    bool first_visit;
-                };
-
-                index_t nbr = -1;
-
-                std::stack<se> stack;
-                stack.push({tree.root(), true});
-
-                while (!stack.empty()) {
-                    auto e = stack.top();
-                    stack.pop();
-                    nbr++;
-                    m_tree_Euler_tour_map[nbr] = e.node;
-                    if (e.first_visit) {
-                        m_first_visit_in_Euler_tour[e.node] = nbr;
-                        for (auto son: children_iterator(e.node, tree)) {
-                            stack.push({e.node, false});
-                            stack.push({son, true});
-                        }
-                    }
-                    if (e.node == tree.root()) {
-                        m_tree_Euler_tour_depth[nbr] = 0;
-                    } else {
-                        m_tree_Euler_tour_depth[nbr] =
-                                m_tree_Euler_tour_depth[m_first_visit_in_Euler_tour[parent(e.node, tree)]] + 1;
+                auto size = parallel_full<array_1d<index_t>>({(size_t) num_nodes}, 1);
+                for (index_t i = 0; i < root_node; i++) {
+                    size(parent(i, tree)) += size(i);
+                }
+
+                // position of the first visit of each node relatively to the first visit of its parent
+                array_1d<index_t> first_visit = array_1d<index_t>::from_shape({(size_t) num_nodes});
+                first_visit(root_node) = 0;
+                parfor(num_l, num_nodes, [&tree, &size, &first_visit](index_t n) {
+                    index_t offset = 1;
+                    for (auto c: children_iterator(n, tree)) {
+                        first_visit(c) = offset;
+                        offset += 2 * size(c);
                     }
+                });
+
+                array_1d<index_t> depth = array_1d<index_t>::from_shape({(size_t) num_nodes});
+                depth(root_node) = 0;
+                for (index_t i = root_node - 1; i >= 0; i--) {
+                    auto p = parent(i, tree);
+                    first_visit(i) += first_visit(p);
+                    depth(i) = depth(p) + 1;
                 }
+
+                array_1d<index_t> tour_map = array_1d<index_t>::from_shape({(size_t) (2 * num_nodes - 1)});
+                array_1d<index_t> tour_depth = array_1d<index_t>::from_shape({(size_t) (2 * num_nodes - 1)});
+                parfor(0, num_nodes, [&tree, &size, &first_visit, &depth, &tour_map, &tour_depth](index_t n) {
+                    auto d = depth(n);
+                    tour_map(first_visit(n)) = n;
+                    tour_depth(first_visit(n)) = d;
+                    for (auto c: children_iterator(n, tree)) {
+                        auto i = first_visit(c) + 2 * size(c) - 1;
+                        tour_map(i) = n;
+                        tour_depth(i) = d;
+                    }
+                });
+
+                m_first_visit_in_Euler_tour = details::make_shared_array_1d(std::move(first_visit));
+                m_tree_Euler_tour_map = details::make_shared_array_1d(std::move(tour_map));
+                m_tree_Euler_tour_depth = details::make_shared_array_1d(std::move(tour_depth));
             }
 
         };
@@ -243,6 +374,7 @@ namespace hg {
 
     using lca_sparse_table_block = lca_internal::lca_rmq<tree, range_minimum_query_internal::rmq_sparse_table_block<index_t>>;
     using lca_sparse_table = lca_internal::lca_rmq<tree, range_minimum_query_internal::rmq_sparse_table<index_t>>;
+    using lca_bitmask_block = lca_internal::lca_rmq<tree, range_minimum_query_internal::rmq_bitmask_block<index_t>>;
 
     using lca_fast = lca_sparse_table_block;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../utils.hpp"
+#include "xtensor/xview.hpp"
+#include <numeric>
+
+namespace hg {
+
+    namespace leaf_ranges_internal {
+
+        /**
+         * In place inclusive prefix sum of the rows of a row major matrix of shape (num_rows, width): the row i is
+         * replaced by the sum of the rows 0 to i. Same block decomposition as parallel_inclusive_scan, the inner loops
+         * over the columns being contiguous.
+         */
+        template<typename value_t>
+        void parallel_inclusive_scan_rows(value_t *data, index_t num_rows, index_t width) {
+            const index_t block_size = (std::max)((index_t) 1, (index_t) (1 << 15) / width);
+            const index_t num_blocks = (num_rows + block_size - 1) / block_size;
+            auto add_row = [width](value_t *row, const value_t *other) {
+                for (index_t j = 0; j < width; j++) {
+                    row[j] += other[j];
+                }
+            };
+            if (num_blocks > 1 && (get_num_threads() > 1 || is_deterministic())) {
+                parfor(0, num_blocks, [data, num_rows, width, block_size, &add_row](index_t b) {
+                    const index_t end = (std::min)(num_rows, (b + 1) * block_size);
+                    for (index_t i = b * block_size + 1; i < end; i++) {
+                        add_row(data + i * width, data + (i - 1) * width);
+                    }
+                });
+                // the last row of each block becomes the prefix sum of the previous blocks
+                std::vector<value_t> offsets((size_t) (num_blocks * width));
+                std::copy_n(data + ((std::min)(num_rows, block_size) - 1) * width, width, offsets.data());
+                for (index_t b = 1; b < num_blocks; b++) {
+                    const index_t end = (std::min)(num_rows, (b + 1) * block_size);
+                    std::copy_n(data + (end - 1) * width, width, offsets.data() + b * width);
+                    add_row(offsets.data() + b * width, offsets.data() + (b - 1) * width);
+                }
+                parfor(1, num_blocks, [data, num_rows, width, block_size, &offsets, &add_row](index_t b) {
+                    const index_t end = (std::min)(num_rows, (b + 1) * block_size);
+                    const value_t *offset = offsets.data() + (b - 1) * width;
+                    for (index_t i = b * block_size; i < end; i++) {
+                        add_row(data + i * width, offset);
+                    }
+                });
+                return;
+            }
+            for (index_t i = 1; i < num_rows; i++) {
+                add_row(data + i * width, data + (i - 1) * width);
+            }
+        }
+    }
+
+    /**
+     * Leaves of the sub-trees of a tree.
+     *
+     * The leaves of the tree are ordered with a depth first traversal of the tree (children being visited in
+     * increasing order): the leaves of the sub-tree rooted in any node n then form the contiguous range
+     * [begin(n), end(n)[ of a single permutation of the leaves.
+     *
+     * The index has a linear size, it is built in linear time, and the leaves of any node are obtained in constant
+     * time as a view on the permutation.
+     */
+    struct leaf_ranges {
+
+        leaf_ranges(const tree &t) {
+            HG_TRACE();
+            t.compute_children();
+            const index_t num_nodes = num_vertices(t);
+            const index_t num_leaves_tree = num_leaves(t);
+
+            array_1d<index_t> num_leaves_subtree = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            std::fill(num_leaves_subtree.begin(), num_leaves_subtree.begin() + num_leaves_tree, 1);
+            std::fill(num_leaves_subtree.begin() + num_leaves_tree, num_leaves_subtree.end(), 0);
+            for (index_t i = 0; i < num_nodes - 1; i++) {
+                num_leaves_subtree(parent(i, t)) += num_leaves_subtree(i);
+            }
+
+            // the range of a child starts after the ranges of its previous siblings
+            m_begin = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            m_begin(num_nodes - 1) = 0;
+            for (index_t i = num_nodes - 1; i >= num_leaves_tree; i--) {
+                index_t start = m_begin(i);
+                for (auto c: children_iterator(i, t)) {
+                    m_begin(c) = start;
+                    start += num_leaves_subtree(c);
+                }
+            }
+
+            m_end = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            m_leaves = array_1d<index_t>::from_shape({(size_t) num_leaves_tree});
+            parfor(0, num_nodes, [this, &num_leaves_subtree, num_leaves_tree](index_t i) {
+                m_end(i) = m_begin(i) + num_leaves_subtree(i);
+                if (i < num_leaves_tree) {
+                    m_leaves(m_begin(i)) = i;
+                }
+            });
+        }
+
+        /**
+         * Number of vertices of the indexed tree
+         */
+        index_t num_elements() const {
+            return m_begin.size();
+        }
+
+        /**
+         * Position of the first leaf of the sub-tree rooted in n in the permutation of the leaves
+         */
+        index_t begin(index_t n) const {
+            return m_begin(n);
+        }
+
+        /**
+         * Position after the last leaf of the sub-tree rooted in n in the permutation of the leaves
+         */
+        index_t end(index_t n) const {
+            return m_end(n);
+        }
+
+        /**
+         * Number of leaves in the sub-tree rooted in n
+         */
+        index_t size(index_t n) const {
+            return m_end(n) - m_begin(n);
+        }
+
+        /**
+         * Leaves of the sub-tree rooted in n (view on the permutation of the leaves)
+         */
+        auto leaves(index_t n) const {
+            return xt::view(m_leaves, xt::range(m_begin(n), m_end(n)));
+        }
+
+        /**
+         * Depth first permutation of the leaves of the tree
+         */
+        const array_1d<index_t> &leaves() const {
+            return m_leaves;
+        }
+
+        /**
+         * Position of the first leaf of the sub-tree rooted in each node in the permutation of the leaves
+         */
+        const array_1d<index_t> &begins() const {
+            return m_begin;
+        }
+
+        /**
+         * Position after the last leaf of the sub-tree rooted in each node in the permutation of the leaves
+         */
+        const array_1d<index_t> &ends() const {
+            return m_end;
+        }
+
+        /**
+         * Sum of the values of a leaf signal over the leaves of each sub-tree.
+         *
+         * The values of the signal are permuted in the depth first order of the leaves and their prefix sums P are
+         * computed in parallel (with a zero prepended): the sum of the sub-tree rooted in any node n is then
+         * P[end(n)] - P[begin(n)], independently of the other nodes. Unlike the bottom-up accumulation of an
+         * attribute (see accumulate_sequential with accumulator_sum), the whole computation is made of parallel
+         * gathers and prefix sums, which pays off when many signals are accumulated on the same tree.
+         *
+         * The first dimension of the signal must be equal to the number of leaves of the tree; the other dimensions
+         * (if any) are handled as many independent signals. Note that with floating point values, the sum of a small
+         * sub-tree is the difference of two large prefix sums and is less accurate than with a bottom-up
+         * accumulation.
+         *
+         * @tparam T
+         * @param xleaf_signal leaf signal
+         * @return an array of shape (num_elements(), leaf_signal.shape[1:]) of the same value type as the signal
+         */
+        template<typename T>
+        auto leaf_sums(const xt::xexpression<T> &xleaf_signal) const {
+            HG_TRACE();
+            auto &leaf_signal = xleaf_signal.derived_cast();
+            using value_type = typename T::value_type;
+            const index_t num_leaves_tree = m_leaves.size();
+            const index_t num_nodes = num_elements();
+            hg_assert(leaf_signal.dimension() >= 1 && (index_t) leaf_signal.shape()[0] == num_leaves_tree,
+                      "The first dimension of the leaf signal must be equal to the number of leaves of the tree.");
+
+            std::vector<size_t> shape(leaf_signal.shape().begin(), leaf_signal.shape().end());
+            const index_t width = std::accumulate(shape.begin() + 1, shape.end(), (index_t) 1,
+                                                  std::multiplies<index_t>());
+            array_nd<value_type> signal = leaf_signal;
+
+            // prefix sums of the rows of the permuted signal: the row 0 is zero and the row i + 1 is the sum of the
+            // rows 0 to i of the permuted signal
+            array_1d<value_type> prefix = array_1d<value_type>::from_shape({(size_t) ((num_leaves_tree + 1) * width)});
+            std::fill(prefix.begin(), prefix.begin() + width, 0);
+            const value_type *signal_data = signal.data();
+            value_type *prefix_data = prefix.data();
+            parfor(0, num_leaves_tree, [this, signal_data, prefix_data, width](index_t i) {
+                std::copy_n(signal_data + m_leaves(i) * width, width, prefix_data + (i + 1) * width);
+            });
+            if (width == 1) {
+                parallel_inclusive_scan(prefix_data, num_leaves_tree + 1);
+            } else {
+                leaf_ranges_internal::parallel_inclusive_scan_rows(prefix_data, num_leaves_tree + 1, width);
+            }
+
+            shape[0] = num_nodes;
+            array_nd<value_type> result = array_nd<value_type>::from_shape(shape);
+            value_type *result_data = result.data();
+            parfor(0, num_nodes, [this, prefix_data, result_data, width](index_t n) {
+                const value_type *end = prefix_data + m_end(n) * width;
+                const value_type *begin = prefix_data + m_begin(n) * width;
+                value_type *out = result_data + n * width;
+                for (index_t j = 0; j < width; j++) {
+                    out[j] = end[j] - begin[j];
+                }
+            });
+            return result;
+        }
+
+    private:
+        array_1d<index_t> m_leaves;
+        array_1d<index_t> m_begin;
+        array_1d<index_t> m_end;
+    };
+}
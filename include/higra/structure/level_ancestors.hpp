@@ -0,0 +1,145 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+
+namespace hg {
+
+    /**
+     * Level ancestor index of a tree based on skew-binary jump pointers (Myers 1983).
+     *
+     * Each node stores, besides its parent, a single jump pointer to one of its ancestors, chosen such that any
+     * ancestor of a node can be reached in O(log(depth)) jumps. The index has a linear size and is built in linear
+     * time.
+     *
+     * It answers:
+     *  - level ancestor queries: the ancestor of a node at a given depth;
+     *  - region queries (see tree::find_region): the largest node containing a given vertex whose altitude is lower
+     *    than a given level. The altitudes must be increasing from the leaves to the root (as the altitudes of a
+     *    hierarchy), the search for the last ancestor under the level is then a dichotomy along the jump pointers.
+     */
+    struct level_ancestors {
+
+        level_ancestors(const tree &t) {
+            HG_TRACE();
+            index_t num_nodes = num_vertices(t);
+            m_parents = parents(t);
+            m_jump = array_1d<index_t>::from_shape({(size_t) num_nodes});
+            m_depth = array_1d<index_t>::from_shape({(size_t) num_nodes});
+
+            index_t root = t.root();
+            m_jump(root) = root;
+            m_depth(root) = 0;
+            // parents are processed before their children
+            for (index_t n = root - 1; n >= 0; n--) {
+                index_t p = m_parents(n);
+                index_t jp = m_jump(p);
+                m_depth(n) = m_depth(p) + 1;
+                if (m_depth(p) - m_depth(jp) == m_depth(jp) - m_depth(m_jump(jp))) {
+                    m_jump(n) = m_jump(jp);
+                } else {
+                    m_jump(n) = p;
+                }
+            }
+        }
+
+        /**
+         * Number of vertices of the indexed tree
+         */
+        index_t num_elements() const {
+            return m_parents.size();
+        }
+
+        /**
+         * Depth of the given node (the depth of the root is 0)
+         */
+        index_t depth(index_t v) const {
+            return m_depth(v);
+        }
+
+        /**
+         * Ancestor of the given node at the given depth: the depth must be positive and lower than or equal to the
+         * depth of the node.
+         */
+        index_t level_ancestor(index_t v, index_t depth) const {
+            while (m_depth(v) > depth) {
+                index_t j = m_jump(v);
+                v = (m_depth(j) >= depth) ? j : m_parents(v);
+            }
+            return v;
+        }
+
+        /**
+         * Batch version of level_ancestor: res(i) = level_ancestor(vertices(i), depths(i)).
+         */
+        template<typename T1, typename T2>
+        auto level_ancestor(const xt::xexpression<T1> &xvertices, const xt::xexpression<T2> &xdepths) const {
+            HG_TRACE();
+            auto &vertices = xvertices.derived_cast();
+            auto &depths = xdepths.derived_cast();
+            hg_assert_1d_array(vertices);
+            hg_assert_integral_value_type(vertices);
+            hg_assert_1d_array(depths);
+            hg_assert_integral_value_type(depths);
+            hg_assert_same_shape(vertices, depths);
+
+            array_1d<index_t> result = array_1d<index_t>::from_shape({vertices.size()});
+            parfor(0, vertices.size(), [&result, &vertices, &depths, this](index_t i) {
+                result(i) = level_ancestor(vertices(i), depths(i));
+            });
+            return result;
+        }
+
+        /**
+         * Largest node containing the vertex v whose altitude is strictly lower than lambda, or v if no such node
+         * exists. The altitudes must be increasing from the leaves to the root.
+         */
+        template<typename T>
+        index_t find_region(index_t v, const typename T::value_type &lambda, const T &altitudes) const {
+            while (m_parents(v) != v && altitudes(m_parents(v)) < lambda) {
+                index_t j = m_jump(v);
+                v = (altitudes(j) < lambda) ? j : m_parents(v);
+            }
+            return v;
+        }
+
+        /**
+         * Batch version of find_region: res(i) = find_region(vertices(i), lambdas(i), altitudes).
+         */
+        template<typename T1, typename T2, typename T3>
+        auto find_region(const xt::xexpression<T1> &xvertices,
+                         const xt::xexpression<T2> &xlambdas,
+                         const xt::xexpression<T3> &xaltitudes) const {
+            HG_TRACE();
+            auto &vertices = xvertices.derived_cast();
+            auto &lambdas = xlambdas.derived_cast();
+            auto &altitudes = xaltitudes.derived_cast();
+            hg_assert_1d_array(altitudes);
+            hg_assert(altitudes.size() == m_parents.size(), "altitudes size does not match the number of nodes.");
+            hg_assert_1d_array(vertices);
+            hg_assert_integral_value_type(vertices);
+            hg_assert_1d_array(lambdas);
+            hg_assert_same_shape(vertices, lambdas);
+
+            array_1d<index_t> result = array_1d<index_t>::from_shape({vertices.size()});
+            parfor(0, vertices.size(), [&result, &vertices, &lambdas, &altitudes, this](index_t i) {
+                result(i) = find_region(vertices(i), lambdas(i), altitudes);
+            });
+            return result;
+        }
+
+    private:
+        array_1d<index_t> m_parents;
+        array_1d<index_t> m_jump;
+        array_1d<index_t> m_depth;
+    };
+}
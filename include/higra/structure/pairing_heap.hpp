@@ -0,0 +1,144 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include "../utils.hpp"
+
+namespace hg {
+
+    /**
+     * A forest of meldable pairing heaps sharing a single arena.
+     *
+     * The elements of the heaps are the integers 0, 1, ..., num_elements - 1: each element carries a key and belongs
+     * to at most one heap at a time. A heap is represented by its top element, the empty heap is invalid_index.
+     * The memory is allocated once at construction: 3 values per element, whatever the number of heaps.
+     *
+     * The top of a heap is an element whose key is minimal for the given comparison function (use std::greater to
+     * obtain max heaps).
+     *
+     * Complexity: meld, push and top are in O(1), pop is in O(log(n)) amortized.
+     *
+     * Warning: the heaps are not thread safe.
+     *
+     * @tparam key_t key type
+     * @tparam compare_t strict weak ordering on keys
+     */
+    template<typename key_t, typename compare_t = std::less<key_t>>
+    struct pairing_heap_forest {
+
+        pairing_heap_forest(size_t num_elements, compare_t compare = compare_t()) :
+                m_key(num_elements),
+                m_child(num_elements, invalid_index),
+                m_sibling(num_elements, invalid_index),
+                m_compare(compare) {
+        }
+
+        size_t num_elements() const {
+            return m_key.size();
+        }
+
+        /**
+         * Key of the given element
+         */
+        const key_t &key(index_t element) const {
+            return m_key[element];
+        }
+
+        /**
+         * Merges two heaps: the given heaps must not be used anymore.
+         *
+         * @param heap1 a heap
+         * @param heap2 a heap
+         * @return the merged heap
+         */
+        index_t meld(index_t heap1, index_t heap2) {
+            if (heap1 == invalid_index) {
+                return heap2;
+            }
+            if (heap2 == invalid_index) {
+                return heap1;
+            }
+            return link(heap1, heap2);
+        }
+
+        /**
+         * Inserts an element, which must not belong to any heap, with the given key into a heap.
+         *
+         * @param heap a heap
+         * @param element an element
+         * @param key key of the element
+         * @return the new heap
+         */
+        index_t push(index_t heap, index_t element, const key_t &key) {
+            m_key[element] = key;
+            m_child[element] = invalid_index;
+            m_sibling[element] = invalid_index;
+            return meld(heap, element);
+        }
+
+        /**
+         * Removes the top element of a non empty heap (two pass pairing of the children of the top element).
+         *
+         * @param heap a non empty heap
+         * @return the new heap
+         */
+        index_t pop(index_t heap) {
+            index_t first = m_child[heap];
+            m_child[heap] = invalid_index;
+
+            // first pass: links the children pairwise from left to right, the results are stacked with the sibling
+            // links
+            index_t stack = invalid_index;
+            while (first != invalid_index) {
+                index_t a = first;
+                index_t b = m_sibling[a];
+                if (b == invalid_index) {
+                    m_sibling[a] = stack;
+                    stack = a;
+                    break;
+                }
+                first = m_sibling[b];
+                index_t l = link(a, b);
+                m_sibling[l] = stack;
+                stack = l;
+            }
+
+            // second pass: melds the results from right to left
+            index_t result = invalid_index;
+            while (stack != invalid_index) {
+                index_t next = m_sibling[stack];
+                m_sibling[stack] = invalid_index;
+                result = meld(result, stack);
+                stack = next;
+            }
+            return result;
+        }
+
+    private:
+
+        // makes the root with the largest key the leftmost child of the other one
+        index_t link(index_t root1, index_t root2) {
+            if (m_compare(m_key[root2], m_key[root1])) {
+                std::swap(root1, root2);
+            }
+            m_sibling[root2] = m_child[root1];
+            m_child[root1] = root2;
+            return root1;
+        }
+
+        std::vector<key_t> m_key;
+        std::vector<index_t> m_child;
+        std::vector<index_t> m_sibling;
+        compare_t m_compare;
+    };
+}
@@ -13,12 +13,14 @@
 
 #include "details/graph_concepts.hpp"
 #include "higra/structure/details/iterators.hpp"
+#include <array>
 #include <functional>
 #include <vector>
 #include <utility>
 
 #include "xtensor/xarray.hpp"
 #include "embedding.hpp"
+#include "embedding_morton.hpp"
 
 namespace hg {
 
@@ -62,7 +64,21 @@ namespace hg {
 
             // IncidenceGraph associated types
             using edge_descriptor = std::pair<vertex_descriptor, vertex_descriptor>;
-            using iterator_transform_function = std::function<edge_descriptor(vertex_descriptor)>;
+
+            /**
+             * Transforms a vertex adjacent to a vertex into an edge whose source
+             * (or target if in_edge is true) is the vertex
+             */
+            template<bool in_edge>
+            struct incident_edge_transform {
+                vertex_descriptor vertex;
+
+                edge_descriptor operator()(vertex_descriptor v) const {
+                    return in_edge ? edge_descriptor(v, vertex) : edge_descriptor(vertex, v);
+                }
+            };
+
+            using iterator_transform_function = incident_edge_transform<false>;
 
             using out_edge_iterator = transform_forward_iterator<iterator_transform_function,
                     adjacency_iterator,
@@ -70,7 +86,10 @@ namespace hg {
             using degree_size_type = size_t;
 
             //BidirectionalGraph associated types
-            using in_edge_iterator = out_edge_iterator;
+            using in_iterator_transform_function = incident_edge_transform<true>;
+            using in_edge_iterator = transform_forward_iterator<in_iterator_transform_function,
+                    adjacency_iterator,
+                    edge_descriptor>;
 
             using point_type = typename embedding_t::point_type;
 
@@ -103,6 +122,40 @@ namespace hg {
 
             degree_size_type out_degree(const vertex_descriptor v) const;
 
+            /**
+             * True if all the neighbours of the vertex of the given coordinates are inside the graph domain
+             */
+            bool is_in_safe_area(const point<index_t, embedding_t::_dim> &point) const {
+                for (index_t i = 0; i < embedding_t::_dim; ++i) {
+                    if (point(i) < m_safe_lower_bound(i) || point(i) > m_safe_upper_bound(i)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * Differences between the linear indices of the neighbours of a vertex in the safe area and the linear
+             * index of this vertex (in the same order as neighbours()). Empty if the safe area is empty.
+             */
+            const auto &relative_neighbours() const {
+                return m_relative_neighbours;
+            }
+
+            /**
+             * Lower bound (inclusive) of the coordinates of the vertices in the safe area
+             */
+            const auto &safe_lower_bound() const {
+                return m_safe_lower_bound;
+            }
+
+            /**
+             * Upper bound (inclusive) of the coordinates of the vertices in the safe area
+             */
+            const auto &safe_upper_bound() const {
+                return m_safe_upper_bound;
+            }
+
         private:
 
             void init_safe_area() {
@@ -114,6 +167,13 @@ namespace hg {
                     return;
                 }
 
+                if (!embedding_t::_row_major) {
+                    // the neighbours of a vertex are not at constant linear offsets: empty safe area
+                    m_safe_lower_bound.fill(std::numeric_limits<index_t>::max());
+                    m_safe_upper_bound.fill(std::numeric_limits<index_t>::lowest());
+                    return;
+                }
+
                 m_safe_lower_bound.fill(std::numeric_limits<index_t>::max());
                 m_safe_upper_bound.fill(std::numeric_limits<index_t>::lowest());
 
@@ -144,15 +204,6 @@ namespace hg {
                 }
             }
 
-            bool is_in_safe_area(const point<index_t, embedding_t::_dim> &point) const {
-                for (index_t i = 0; i < embedding_t::_dim; ++i) {
-                    if (point(i) < m_safe_lower_bound(i) || point(i) > m_safe_upper_bound(i)) {
-                        return false;
-                    }
-                }
-                return true;
-            }
-
             embedding_t m_embedding;
             point_list_t<index_t, embedding_t::_dim> m_neighbours;
             point<index_t, embedding_t::_dim> m_safe_lower_bound;
@@ -256,6 +307,7 @@ namespace hg {
     using regular_grid_graph_2d = regular_graph<hg::embedding_grid_2d>;
     using regular_grid_graph_3d = regular_graph<hg::embedding_grid_3d>;
     using regular_grid_graph_4d = regular_graph<hg::embedding_grid_4d>;
+    using regular_morton_graph_2d = regular_graph<hg::embedding_morton_2d>;
 
     namespace graph {
         template<typename embedding_t>
@@ -288,34 +340,23 @@ namespace hg {
     template<typename embedding_t>
     std::pair<typename hg::regular_graph<embedding_t>::out_edge_iterator, typename hg::regular_graph<embedding_t>::out_edge_iterator>
     out_edges(typename hg::regular_graph<embedding_t>::vertex_descriptor u, const hg::regular_graph<embedding_t> &g) {
+        typename hg::regular_graph<embedding_t>::iterator_transform_function fun{u};
         return std::make_pair(
                 hg::regular_graph_out_edge_iterator<embedding_t>(
-                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g),
-                        [u](typename hg::regular_graph<embedding_t>::vertex_descriptor v) {
-                            return std::make_pair(u, v);
-                        }),
+                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g), fun),
                 hg::regular_graph_out_edge_iterator<embedding_t>(
-                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g, true),
-                        [u](typename hg::regular_graph<embedding_t>::vertex_descriptor v) {
-                            return std::make_pair(u, v);
-                        })
+                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g, true), fun)
         );
     }
 
     template<typename embedding_t>
-    std::pair<typename hg::regular_graph<embedding_t>::out_edge_iterator, typename hg::regular_graph<embedding_t>::out_edge_iterator>
+    std::pair<typename hg::regular_graph<embedding_t>::in_edge_iterator, typename hg::regular_graph<embedding_t>::in_edge_iterator>
     in_edges(typename hg::regular_graph<embedding_t>::vertex_descriptor u, const hg::regular_graph<embedding_t> &g) {
+        typename hg::regular_graph<embedding_t>::in_iterator_transform_function fun{u};
+        using it = typename hg::regular_graph<embedding_t>::in_edge_iterator;
         return std::make_pair(
-                hg::regular_graph_out_edge_iterator<embedding_t>(
-                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g),
-                        [u](typename hg::regular_graph<embedding_t>::vertex_descriptor v) {
-                            return std::make_pair(v, u);
-                        }),
-                hg::regular_graph_out_edge_iterator<embedding_t>(
-                        hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g, true),
-                        [u](typename hg::regular_graph<embedding_t>::vertex_descriptor v) {
-                            return std::make_pair(v, u);
-                        })
+                it(hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g), fun),
+                it(hg::regular_graph_adjacent_vertex_iterator<embedding_t>(u, g, true), fun)
         );
     }
 
@@ -387,6 +428,144 @@ namespace hg {
 
 }
 
+namespace hg {
+
+    namespace regular_graph_internal {
+
+        template<index_t N>
+        auto make_fixed_offsets(const std::vector<index_t> &offsets) {
+            std::array<index_t, N> result;
+            std::copy(offsets.begin(), offsets.end(), result.begin());
+            return result;
+        }
+    }
+
+    /**
+     * Calls fun(offsets) where offsets are the relative neighbours of the regular graph (see
+     * regular_graph::relative_neighbours).
+     *
+     * For the usual adjacencies (2, 4, 6, 8 or 26 neighbours), offsets is a std::array whose size is a compile time
+     * constant: loops on the neighbours of a vertex in the safe area can then be unrolled by the compiler. Otherwise,
+     * offsets is a std::vector.
+     *
+     * @param graph
+     * @param fun a generic function taking a random access container of index_t as argument
+     */
+    template<typename embedding_t, typename fun_t>
+    void dispatch_relative_neighbours(const regular_graph<embedding_t> &graph, fun_t &&fun) {
+        using namespace regular_graph_internal;
+        const auto &offsets = graph.relative_neighbours();
+        switch (offsets.size()) {
+            case 2:
+                fun(make_fixed_offsets<2>(offsets));
+                break;
+            case 4:
+                fun(make_fixed_offsets<4>(offsets));
+                break;
+            case 6:
+                fun(make_fixed_offsets<6>(offsets));
+                break;
+            case 8:
+                fun(make_fixed_offsets<8>(offsets));
+                break;
+            case 26:
+                fun(make_fixed_offsets<26>(offsets));
+                break;
+            default:
+                fun(offsets);
+        }
+    }
+
+    /**
+     * Scans the vertices of the range [start, end[ of a regular graph in increasing order, separating the vertices of
+     * the safe area (whose neighbours all lie inside the graph domain) from the border vertices:
+     *
+     *  - interior_fun(first, last, offsets) is called on each run [first, last[ of consecutive vertices of the safe
+     *    area: the neighbours of such a vertex v are the vertices v + offsets[k], in the order of graph.neighbours()
+     *    (offsets is given by dispatch_relative_neighbours);
+     *  - border_fun(v, coordinates) is called on each other vertex v with its coordinates in the graph embedding.
+     *
+     * This enables to write branch-free inner loops on the interior of the domain, that is on most vertices.
+     * If the linear coordinates of the embedding are not row major (embedding_t::_row_major is false, see
+     * embedding_morton_2d), the safe area is empty and border_fun is called on every vertex.
+     *
+     * @param graph
+     * @param start first vertex of the range
+     * @param end after last vertex of the range
+     * @param interior_fun
+     * @param border_fun
+     */
+    template<typename embedding_t, typename interior_fun_t, typename border_fun_t>
+    void scan_regular_graph(const regular_graph<embedding_t> &graph,
+                            index_t start,
+                            index_t end,
+                            interior_fun_t &&interior_fun,
+                            border_fun_t &&border_fun) {
+        if (start >= end) {
+            return;
+        }
+        if (!embedding_t::_row_major) {
+            // rows are not runs of consecutive vertices: every vertex is handled as a border vertex
+            const auto &embedding = graph.embedding();
+            for (index_t v = start; v < end; v++) {
+                border_fun(v, embedding.lin2grid(v));
+            }
+            return;
+        }
+        dispatch_relative_neighbours(graph, [&](const auto &offsets) {
+            constexpr index_t dim = embedding_t::_dim;
+            const auto &embedding = graph.embedding();
+            const auto &shape = embedding.shape();
+            const auto &lower = graph.safe_lower_bound();
+            const auto &upper = graph.safe_upper_bound();
+            const index_t row_size = shape(dim - 1);
+            // the safe area is empty if the relative neighbours are not defined while the graph has neighbours
+            const bool has_safe_area = !graph.relative_neighbours().empty() || graph.neighbours().empty();
+            const index_t row_lower = (std::max)(lower(dim - 1), (index_t) 0);
+            const index_t row_upper = (std::min)(upper(dim - 1), row_size - 1);
+
+            // vertices are scanned by rows along the last axis: the safe area of a row is a run of consecutive vertices
+            point<index_t, dim> coordinates = embedding.lin2grid(start);
+            index_t v = start;
+            while (v < end) {
+                index_t row_first = v - coordinates(dim - 1);
+                index_t row_end = (std::min)(row_first + row_size, end);
+                bool row_safe = has_safe_area;
+                for (index_t d = 0; d < dim - 1 && row_safe; d++) {
+                    row_safe = coordinates(d) >= lower(d) && coordinates(d) <= upper(d);
+                }
+                index_t safe_first = row_end;
+                index_t safe_end = row_end;
+                if (row_safe) {
+                    safe_first = (std::min)((std::max)(v, row_first + row_lower), row_end);
+                    safe_end = (std::max)(safe_first, (std::min)(row_end, row_first + row_upper + 1));
+                }
+                for (; v < safe_first; v++) {
+                    coordinates(dim - 1) = v - row_first;
+                    border_fun(v, coordinates);
+                }
+                if (v < safe_end) {
+                    interior_fun(v, safe_end, offsets);
+                    v = safe_end;
+                }
+                for (; v < row_end; v++) {
+                    coordinates(dim - 1) = v - row_first;
+                    border_fun(v, coordinates);
+                }
+
+                // next row
+                coordinates(dim - 1) = 0;
+                for (index_t d = dim - 2; d >= 0; d--) {
+                    if (++coordinates(d) < shape(d)) {
+                        break;
+                    }
+                    coordinates(d) = 0;
+                }
+            }
+        });
+    }
+}
+
 #ifdef HG_USE_BOOST_GRAPH
 namespace boost {
 
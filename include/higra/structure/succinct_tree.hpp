@@ -0,0 +1,702 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "../graph.hpp"
+#include "../hierarchy/common.hpp"
+#include "details/shared_array.hpp"
+#include <limits>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace hg {
+
+    class succinct_tree;
+
+    remapped_tree<succinct_tree, array_1d<index_t>> make_succinct_tree(const tree &t);
+
+    namespace succinct_tree_internal {
+
+        // number of bits of the blocks of the rank and excess indexes
+        const index_t block_bits = 1024;
+        const index_t block_words = block_bits / 64;
+
+        inline index_t popcount(uint64_t x) {
+#ifdef _MSC_VER
+            return (index_t) __popcnt64(x);
+#else
+            return __builtin_popcountll(x);
+#endif
+        }
+
+        /**
+         * For each byte: excess variation over the byte, and minimum excess over the 8 prefixes of the byte
+         * (bits are read from the least significant one, a set bit is an opening parenthesis)
+         */
+        struct byte_tables {
+            int8_t delta[256];
+            int8_t min_prefix[256];
+
+            byte_tables() {
+                for (int b = 0; b < 256; b++) {
+                    int e = 0;
+                    int m = 8;
+                    for (int k = 0; k < 8; k++) {
+                        e += ((b >> k) & 1) ? 1 : -1;
+                        m = (std::min)(m, e);
+                    }
+                    delta[b] = (int8_t) e;
+                    min_prefix[b] = (int8_t) m;
+                }
+            }
+        };
+
+        inline const byte_tables &tables() {
+            static const byte_tables t;
+            return t;
+        }
+    }
+
+    /**
+     * Succinct representation of the topology of a tree by a balanced parentheses sequence.
+     *
+     * The tree is encoded by a depth first traversal: a node is an opening parenthesis (set bit) when it is
+     * entered and a closing parenthesis when it is left, which takes 2 bits per node. The sequence is completed by a
+     * rank index (number of set bits before each block of 1024 bits) and a range min-max tree on the excess (number of
+     * opening minus closing parentheses) of the blocks, which take about 0.4 bit per node. Parent, subtree size,
+     * children, depth and lowest common ancestor queries are answered with rank/select and excess searches in
+     * logarithmic time.
+     *
+     * The nodes of a succinct tree are identified by their rank in the depth first preorder: the root is the node 0
+     * and the children of a node are visited in increasing index order in the original tree. The correspondence with
+     * the nodes of the original tree is given by make_succinct_tree, and to_tree converts the succinct tree back to a
+     * tree. Note that the balanced parentheses sequence only encodes the topology of the tree: the order of the leaves
+     * of the original tree (for example the pixels of an image) must be archived separately if needed, as any node
+     * attribute, in preorder.
+     *
+     * The arrays of a succinct tree are shared by its copies and can be used in place in a memory mapped file
+     * (see save_succinct_tree and read_succinct_tree in tree_io.hpp).
+     */
+    class succinct_tree {
+    public:
+
+        using array_type = details::shared_array_1d<uint64_t>;
+        using excess_array_type = details::shared_array_1d<int64_t>;
+
+        succinct_tree() = default;
+
+        /**
+         * Succinct representation of the given tree (see make_succinct_tree to get the preorder of the nodes).
+         */
+        explicit succinct_tree(const tree &t) {
+            HG_TRACE();
+            array_1d<index_t> preorder;
+            init(t, preorder);
+        }
+
+        /**
+         * Succinct tree from its arrays (see save_succinct_tree and read_succinct_tree).
+         *
+         * @param num_nodes number of nodes
+         * @param num_leaves number of leaves
+         * @param bits balanced parentheses sequence (2 * num_nodes bits)
+         * @param block_rank number of set bits before each block of bits
+         * @param min_excess range min-max tree of the excess of the blocks
+         */
+        succinct_tree(index_t num_nodes, index_t num_leaves, array_type bits, array_type block_rank,
+                      excess_array_type min_excess) :
+                m_num_nodes(num_nodes),
+                m_num_leaves(num_leaves),
+                m_bits(std::move(bits)),
+                m_block_rank(std::move(block_rank)),
+                m_min_excess(std::move(min_excess)) {
+            using namespace succinct_tree_internal;
+            index_t num_blocks = (2 * m_num_nodes + block_bits - 1) / block_bits;
+            hg_assert(num_nodes > 0 && num_leaves > 0 && num_leaves <= num_nodes, "Invalid number of nodes.");
+            hg_assert((index_t) m_bits.size() == (2 * m_num_nodes + 63) / 64, "Invalid size of succinct tree bits.");
+            hg_assert((index_t) m_block_rank.size() == num_blocks + 1, "Invalid size of succinct tree rank index.");
+            hg_assert((index_t) m_min_excess.size() == 2 * tree_leaf_offset(num_blocks),
+                      "Invalid size of succinct tree excess index.");
+        }
+
+        index_t num_vertices() const {
+            return m_num_nodes;
+        }
+
+        index_t num_leaves() const {
+            return m_num_leaves;
+        }
+
+        index_t root() const {
+            return 0;
+        }
+
+        /**
+         * Parent of the given node (the root is its own parent)
+         */
+        index_t parent(index_t v) const {
+            if (v == 0) {
+                return 0;
+            }
+            return rank(enclose(select(v)));
+        }
+
+        /**
+         * Number of nodes in the subtree rooted in the given node (including the node)
+         */
+        index_t subtree_size(index_t v) const {
+            auto p = select(v);
+            return (find_close(p) - p + 1) / 2;
+        }
+
+        /**
+         * Depth of the given node (the depth of the root is 0)
+         */
+        index_t depth(index_t v) const {
+            return excess(select(v)) - 1;
+        }
+
+        bool is_leaf(index_t v) const {
+            return !bit(select(v) + 1);
+        }
+
+        /**
+         * First child of the given node, or invalid_index if the node is a leaf
+         */
+        index_t first_child(index_t v) const {
+            // the first child of a node is the next node in preorder
+            return is_leaf(v) ? invalid_index : v + 1;
+        }
+
+        /**
+         * Next sibling of the given node, or invalid_index if the node is the last child of its parent
+         */
+        index_t next_sibling(index_t v) const {
+            if (v == 0) {
+                return invalid_index;
+            }
+            auto p = find_close(select(v)) + 1;
+            return bit(p) ? rank(p) : invalid_index;
+        }
+
+        index_t num_children(index_t v) const {
+            index_t n = 0;
+            for (auto c = first_child(v); c != invalid_index; c = next_sibling(c)) {
+                n++;
+            }
+            return n;
+        }
+
+        /**
+         * Children of the given node in increasing order
+         */
+        std::vector<index_t> children(index_t v) const {
+            std::vector<index_t> res;
+            for (auto c = first_child(v); c != invalid_index; c = next_sibling(c)) {
+                res.push_back(c);
+            }
+            return res;
+        }
+
+        /**
+         * Lowest common ancestor of the two given nodes
+         */
+        index_t lowest_common_ancestor(index_t u, index_t v) const {
+            if (u == v) {
+                return u;
+            }
+            if (u > v) {
+                std::swap(u, v);
+            }
+            auto pu = select(u);
+            auto pv = select(v);
+            if (find_close(pu) > pv) {
+                return u;
+            }
+            return rank(enclose(min_excess_position(pu, pv) + 1));
+        }
+
+        /**
+         * Lowest common ancestor of each pair of nodes (vertices1(i), vertices2(i))
+         */
+        template<typename T>
+        auto lowest_common_ancestor(const xt::xexpression<T> &xvertices1, const xt::xexpression<T> &xvertices2) const {
+            auto &vertices1 = xvertices1.derived_cast();
+            auto &vertices2 = xvertices2.derived_cast();
+            hg_assert_1d_array(vertices1);
+            hg_assert_same_shape(vertices1, vertices2);
+            array_1d<index_t> res = array_1d<index_t>::from_shape({vertices1.size()});
+            parfor(0, (index_t) vertices1.size(), [&](index_t i) {
+                res(i) = lowest_common_ancestor(vertices1(i), vertices2(i));
+            });
+            return res;
+        }
+
+        /**
+         * Converts the succinct tree to a tree: the leaves of the tree are numbered in preorder and the internal nodes
+         * in reverse preorder.
+         *
+         * @return a remapped_tree whose node_map gives the preorder index of each node of the tree
+         */
+        auto to_tree() const {
+            HG_TRACE();
+            array_1d<index_t> parents = array_1d<index_t>::from_shape({(size_t) m_num_nodes});
+            array_1d<index_t> node_map = array_1d<index_t>::from_shape({(size_t) m_num_nodes});
+            std::vector<index_t> stack;
+            index_t preorder = 0;
+            index_t leaf = 0;
+            index_t internal_node = m_num_nodes - 1;
+            for (index_t p = 0; p < 2 * m_num_nodes; p++) {
+                if (bit(p)) {
+                    index_t n = bit(p + 1) ? internal_node-- : leaf++;
+                    node_map(n) = preorder++;
+                    parents(n) = stack.empty() ? n : stack.back();
+                    stack.push_back(n);
+                } else {
+                    stack.pop_back();
+                }
+            }
+            return make_remapped_tree(tree(std::move(parents)), std::move(node_map));
+        }
+
+        /**
+         * Size of the succinct tree arrays in bytes
+         */
+        size_t memory_usage() const {
+            return (m_bits.size() + m_block_rank.size()) * sizeof(uint64_t) + m_min_excess.size() * sizeof(int64_t);
+        }
+
+        const array_type &bits() const {
+            return m_bits;
+        }
+
+        const array_type &block_rank() const {
+            return m_block_rank;
+        }
+
+        const excess_array_type &min_excess() const {
+            return m_min_excess;
+        }
+
+        /**
+         * Position of the opening parenthesis of the node of given preorder index
+         */
+        index_t select(index_t v) const {
+            using namespace succinct_tree_internal;
+            hg_assert(v >= 0 && v < m_num_nodes, "Invalid node index.");
+            // last block with less than v + 1 set bits before it
+            index_t lo = 0;
+            index_t hi = (index_t) m_block_rank.size() - 1;
+            while (hi - lo > 1) {
+                index_t mid = (lo + hi) / 2;
+                if ((index_t) m_block_rank[mid] <= v) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            index_t k = v - (index_t) m_block_rank[lo];
+            index_t w = lo * block_words;
+            index_t c;
+            while ((c = popcount(m_bits[w])) <= k) {
+                k -= c;
+                w++;
+            }
+            uint64_t word = m_bits[w];
+            for (index_t i = 0; i < k; i++) {
+                word &= word - 1;
+            }
+            return w * 64 + lowest_set_bit(word);
+        }
+
+        /**
+         * Preorder index of the node whose opening parenthesis is at the given position (number of set bits before
+         * the position)
+         */
+        index_t rank(index_t p) const {
+            using namespace succinct_tree_internal;
+            index_t b = p / block_bits;
+            index_t r = (index_t) m_block_rank[b];
+            index_t last_word = p / 64;
+            for (index_t w = b * block_words; w < last_word; w++) {
+                r += popcount(m_bits[w]);
+            }
+            if (p % 64 != 0) {
+                r += popcount(m_bits[last_word] & ((((uint64_t) 1) << (p % 64)) - 1));
+            }
+            return r;
+        }
+
+        /**
+         * Excess after the given position
+         */
+        index_t excess(index_t p) const {
+            return 2 * rank(p + 1) - (p + 1);
+        }
+
+        /**
+         * Position of the closing parenthesis matching the opening parenthesis at the given position
+         */
+        index_t find_close(index_t p) const {
+            return forward_search(p, excess(p) - 1);
+        }
+
+        /**
+         * Position of the opening parenthesis of the parent of the node whose opening parenthesis is at the given
+         * position (not the root)
+         */
+        index_t enclose(index_t p) const {
+            return backward_search(p, excess(p) - 2) + 1;
+        }
+
+    private:
+
+        bool bit(index_t p) const {
+            return p < 2 * m_num_nodes && ((m_bits[p / 64] >> (p % 64)) & 1) != 0;
+        }
+
+        static index_t lowest_set_bit(uint64_t mask) {
+#ifdef _MSC_VER
+            unsigned long index = 0;
+            _BitScanForward64(&index, mask);
+            return index;
+#else
+            return __builtin_ctzll(mask);
+#endif
+        }
+
+        uint8_t byte(index_t b) const {
+            return (uint8_t) (m_bits[b / 8] >> ((b % 8) * 8));
+        }
+
+        index_t num_blocks() const {
+            return (index_t) m_block_rank.size() - 1;
+        }
+
+        // index of the first leaf of the range min-max tree
+        static index_t tree_leaf_offset(index_t num_blocks) {
+            index_t n = 1;
+            while (n < num_blocks) {
+                n *= 2;
+            }
+            return n;
+        }
+
+        /**
+         * First position q in [from, to) with excess(q) <= target, or invalid_index.
+         * e is the excess before from.
+         */
+        index_t scan_forward(index_t from, index_t to, index_t e, index_t target) const {
+            using namespace succinct_tree_internal;
+            auto &t = tables();
+            index_t q = from;
+            while (q < to) {
+                if (q % 8 == 0 && q + 8 <= to) {
+                    auto b = byte(q / 8);
+                    if (e + t.min_prefix[b] > target) {
+                        e += t.delta[b];
+                        q += 8;
+                        continue;
+                    }
+                }
+                e += bit(q) ? 1 : -1;
+                if (e <= target) {
+                    return q;
+                }
+                q++;
+            }
+            return invalid_index;
+        }
+
+        /**
+         * Last position q in [from, to) with excess(q) <= target, or invalid_index.
+         * e is the excess after to - 1.
+         */
+        index_t scan_backward(index_t from, index_t to, index_t e, index_t target) const {
+            using namespace succinct_tree_internal;
+            auto &t = tables();
+            index_t q = to - 1;
+            while (q >= from) {
+                if (q % 8 == 7 && q - 7 >= from) {
+                    auto b = byte(q / 8);
+                    index_t e_before = e - t.delta[b];
+                    if (e_before + t.min_prefix[b] > target) {
+                        e = e_before;
+                        q -= 8;
+                        continue;
+                    }
+                }
+                if (e <= target) {
+                    return q;
+                }
+                e -= bit(q) ? 1 : -1;
+                q--;
+            }
+            return invalid_index;
+        }
+
+        index_t block_excess_before(index_t b) const {
+            return 2 * (index_t) m_block_rank[b] - b * succinct_tree_internal::block_bits;
+        }
+
+        index_t block_end(index_t b) const {
+            using namespace succinct_tree_internal;
+            return (std::min)((b + 1) * block_bits, 2 * m_num_nodes);
+        }
+
+        /**
+         * First block in [b, num_blocks) whose minimum excess is lower than or equal to target, or invalid_index
+         */
+        index_t first_block_below(index_t b, index_t target) const {
+            index_t offset = (index_t) m_min_excess.size() / 2;
+            if (b >= num_blocks()) {
+                return invalid_index;
+            }
+            index_t node = b + offset;
+            while (m_min_excess[node] > target) {
+                // go to the next subtree on the right
+                while (node > 1 && node % 2 == 1) {
+                    node /= 2;
+                }
+                if (node <= 1) {
+                    return invalid_index;
+                }
+                node++;
+            }
+            while (node < offset) {
+                node = (m_min_excess[2 * node] <= target) ? 2 * node : 2 * node + 1;
+            }
+            index_t res = node - offset;
+            return res < num_blocks() ? res : invalid_index;
+        }
+
+        /**
+         * Last block in [0, b] whose minimum excess is lower than or equal to target, or invalid_index
+         */
+        index_t last_block_below(index_t b, index_t target) const {
+            index_t offset = (index_t) m_min_excess.size() / 2;
+            if (b < 0) {
+                return invalid_index;
+            }
+            index_t node = b + offset;
+            while (m_min_excess[node] > target) {
+                // go to the previous subtree on the left
+                while (node > 1 && node % 2 == 0) {
+                    node /= 2;
+                }
+                if (node <= 1) {
+                    return invalid_index;
+                }
+                node--;
+            }
+            while (node < offset) {
+                node = (m_min_excess[2 * node + 1] <= target) ? 2 * node + 1 : 2 * node;
+            }
+            return node - offset;
+        }
+
+        /**
+         * Minimum excess of the blocks in [b1, b2]
+         */
+        index_t blocks_min_excess(index_t b1, index_t b2) const {
+            index_t offset = (index_t) m_min_excess.size() / 2;
+            index_t res = (std::numeric_limits<index_t>::max)();
+            for (index_t l = b1 + offset, r = b2 + offset + 1; l < r; l /= 2, r /= 2) {
+                if (l % 2 == 1) {
+                    res = (std::min<index_t>)(res, m_min_excess[l++]);
+                }
+                if (r % 2 == 1) {
+                    res = (std::min<index_t>)(res, m_min_excess[--r]);
+                }
+            }
+            return res;
+        }
+
+        /**
+         * First position q > p with excess(q) <= target
+         */
+        index_t forward_search(index_t p, index_t target) const {
+            using namespace succinct_tree_internal;
+            index_t b = p / block_bits;
+            index_t q = scan_forward(p + 1, block_end(b), excess(p), target);
+            if (q != invalid_index) {
+                return q;
+            }
+            b = first_block_below(b + 1, target);
+            hg_assert(b != invalid_index, "Unbalanced parentheses sequence.");
+            return scan_forward(b * block_bits, block_end(b), block_excess_before(b), target);
+        }
+
+        /**
+         * Last position q < p with excess(q) <= target, or -1 if there is none and target >= 0
+         */
+        index_t backward_search(index_t p, index_t target) const {
+            using namespace succinct_tree_internal;
+            index_t b = p / block_bits;
+            index_t q = scan_backward(b * block_bits, p, excess(p - 1), target);
+            if (q != invalid_index) {
+                return q;
+            }
+            b = last_block_below(b - 1, target);
+            if (b == invalid_index) {
+                return -1;
+            }
+            return scan_backward(b * block_bits, block_end(b), block_excess_before(b + 1), target);
+        }
+
+        /**
+         * First position of the minimum excess in [p1, p2]
+         */
+        index_t min_excess_position(index_t p1, index_t p2) const {
+            using namespace succinct_tree_internal;
+            index_t b1 = p1 / block_bits;
+            index_t b2 = p2 / block_bits;
+            // minimum excess in the range
+            index_t m = excess(p1);
+            index_t e = m;
+            for (index_t q = p1 + 1; q <= p2 && q < (b1 + 1) * block_bits;) {
+                if (q % 8 == 0 && q + 8 <= (std::min)(p2 + 1, (b1 + 1) * block_bits)) {
+                    auto b = byte(q / 8);
+                    m = (std::min<index_t>)(m, e + tables().min_prefix[b]);
+                    e += tables().delta[b];
+                    q += 8;
+                } else {
+                    e += bit(q) ? 1 : -1;
+                    m = (std::min)(m, e);
+                    q++;
+                }
+            }
+            if (b2 > b1) {
+                if (b2 > b1 + 1) {
+                    m = (std::min)(m, blocks_min_excess(b1 + 1, b2 - 1));
+                }
+                e = block_excess_before(b2);
+                for (index_t q = b2 * block_bits; q <= p2;) {
+                    if (q % 8 == 0 && q + 8 <= p2 + 1) {
+                        auto b = byte(q / 8);
+                        m = (std::min<index_t>)(m, e + tables().min_prefix[b]);
+                        e += tables().delta[b];
+                        q += 8;
+                    } else {
+                        e += bit(q) ? 1 : -1;
+                        m = (std::min)(m, e);
+                        q++;
+                    }
+                }
+            }
+            // the minimum is reached between p1 and p2
+            return (excess(p1) <= m) ? p1 : forward_search(p1, m);
+        }
+
+        void init(const tree &t, array_1d<index_t> &preorder) {
+            using namespace succinct_tree_internal;
+            m_num_nodes = hg::num_vertices(t);
+            m_num_leaves = hg::num_leaves(t);
+            auto &parents = t.parents();
+            const index_t root = t.root();
+
+            // subtree sizes, then offset of each node in the preorder of the subtree of its parent
+            array_1d<index_t> size = xt::ones<index_t>({(size_t) m_num_nodes});
+            for (index_t n = 0; n < root; n++) {
+                size(parents(n)) += size(n);
+            }
+            array_1d<index_t> cursor = xt::ones<index_t>({(size_t) m_num_nodes});
+            preorder = array_1d<index_t>::from_shape({(size_t) m_num_nodes});
+            for (index_t n = 0; n < root; n++) {
+                preorder(n) = cursor(parents(n));
+                cursor(parents(n)) += size(n);
+            }
+            // reuse cursor for the depth
+            auto &depth = cursor;
+            preorder(root) = 0;
+            depth(root) = 0;
+            std::vector<uint64_t> bits((size_t) ((2 * m_num_nodes + 63) / 64), 0);
+            for (index_t n = root; n >= 0; n--) {
+                if (n != root) {
+                    preorder(n) += preorder(parents(n));
+                    depth(n) = depth(parents(n)) + 1;
+                }
+                // position of the opening parenthesis: preorder index plus number of closing parentheses before it
+                index_t p = 2 * preorder(n) - depth(n);
+                bits[p / 64] |= ((uint64_t) 1) << (p % 64);
+            }
+            m_bits = details::make_shared_array_1d(std::move(bits));
+
+            // rank and excess indexes
+            index_t nb = (2 * m_num_nodes + block_bits - 1) / block_bits;
+            index_t offset = tree_leaf_offset(nb);
+            std::vector<uint64_t> block_rank((size_t) nb + 1);
+            std::vector<int64_t> min_excess((size_t) (2 * offset), (std::numeric_limits<int64_t>::max)());
+            auto &tb = tables();
+            index_t r = 0;
+            index_t e = 0;
+            for (index_t b = 0; b < nb; b++) {
+                block_rank[b] = r;
+                index_t m = (std::numeric_limits<index_t>::max)();
+                index_t end = (std::min)((b + 1) * block_bits, 2 * m_num_nodes);
+                for (index_t q = b * block_bits; q < end; q += 8) {
+                    // the last byte can be partial: the trailing closing parentheses only lower the excess after
+                    // the end of the sequence, which is never searched
+                    auto v = byte(q / 8);
+                    if (q + 8 > end) {
+                        for (index_t k = q; k < end; k++) {
+                            e += bit(k) ? 1 : -1;
+                            m = (std::min)(m, e);
+                        }
+                    } else {
+                        m = (std::min<index_t>)(m, e + tb.min_prefix[v]);
+                        e += tb.delta[v];
+                    }
+                }
+                for (index_t w = b * block_words; w < (std::min)((b + 1) * block_words, (index_t) m_bits.size()); w++) {
+                    r += popcount(m_bits[w]);
+                }
+                min_excess[offset + b] = m;
+            }
+            block_rank[nb] = r;
+            for (index_t i = offset - 1; i >= 1; i--) {
+                min_excess[i] = (std::min)(min_excess[2 * i], min_excess[2 * i + 1]);
+            }
+            m_block_rank = details::make_shared_array_1d(std::move(block_rank));
+            m_min_excess = details::make_shared_array_1d(std::move(min_excess));
+        }
+
+        friend remapped_tree<succinct_tree, array_1d<index_t>> make_succinct_tree(const tree &t);
+
+        index_t m_num_nodes = 0;
+        index_t m_num_leaves = 0;
+        array_type m_bits;
+        array_type m_block_rank;
+        excess_array_type m_min_excess;
+    };
+
+    /**
+     * Succinct representation of the given tree (see succinct_tree).
+     *
+     * @param t input tree
+     * @return a remapped_tree whose node_map gives, for each node of the succinct tree (in preorder), the
+     * corresponding node of the input tree
+     */
+    inline remapped_tree<succinct_tree, array_1d<index_t>> make_succinct_tree(const tree &t) {
+        HG_TRACE();
+        succinct_tree st;
+        array_1d<index_t> preorder;
+        st.init(t, preorder);
+        array_1d<index_t> node_map = array_1d<index_t>::from_shape({preorder.size()});
+        for (index_t n = 0; n < (index_t) preorder.size(); n++) {
+            node_map(preorder(n)) = n;
+        }
+        return make_remapped_tree(std::move(st), std::move(node_map));
+    }
+}
@@ -16,6 +16,10 @@
 #include "higra/structure/details/iterators.hpp"
 #include <vector>
 #include <utility>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include "xtensor/xadapt.hpp"
 #include "../utils.hpp"
 #include "array.hpp"
 
@@ -27,6 +31,25 @@ namespace hg {
         partition_tree
     };
 
+    /**
+     * Order of the nodes of a tree.
+     *
+     * The nodes of a tree are always stored in a topological order (leaves first and any node before its parent).
+     * The layout of a tree records a stronger order known on its nodes:
+     *
+     * - topological: no further assumption;
+     * - altitude_sorted: the nodes are sorted by increasing altitudes (see sort_hierarchy_with_altitudes); as a tree
+     *   may be used with several altitude arrays, this is an information on how the tree was produced and functions
+     *   depending on a specific altitude order must still check it;
+     * - post_order: the leaves and the non leaf nodes are both stored in depth first post-order, such that the leaves
+     *   and the non leaf nodes of any sub tree form two contiguous ranges (see relayout_tree).
+     */
+    enum class tree_layout {
+        topological,
+        altitude_sorted,
+        post_order
+    };
+
     /**
      * Enum used in tree node iterator (leaves_to_root_iterator and root_to_leaves_iterator)
      * to include or exclude leaves from the iterator.
@@ -51,6 +74,32 @@ namespace hg {
         template<bool edge_index_iterator>
         struct tree_graph_adjacent_vertex_iterator;
 
+        /**
+         * Copyable atomic boolean: flag of the lazily computed data of a tree which may be queried concurrently
+         * (the copy itself is not atomic).
+         */
+        struct lazy_flag {
+            lazy_flag(bool value = false) : m_value(value) {}
+
+            lazy_flag(const lazy_flag &other) : m_value(other.get()) {}
+
+            lazy_flag &operator=(const lazy_flag &other) {
+                set(other.get());
+                return *this;
+            }
+
+            bool get() const {
+                return m_value.load(std::memory_order_acquire);
+            }
+
+            void set(bool value) {
+                m_value.store(value, std::memory_order_release);
+            }
+
+        private:
+            std::atomic<bool> m_value;
+        };
+
         // forward declaration
         struct tree_graph_node_to_root_iterator;
 
@@ -66,8 +115,7 @@ namespace hg {
             // Graph associated types
             using vertex_descriptor = index_t;
             using edge_index_t = index_t;
-            using children_list_t = std::vector<vertex_descriptor>;
-            using children_iterator = children_list_t::const_iterator;
+            using children_iterator = const vertex_descriptor *;
             using ancestors_iterator = tree_graph_node_to_root_iterator;
             using edge_descriptor = indexed_edge<vertex_descriptor, edge_index_t>;
             using directed_category = graph::undirected_tag;
@@ -89,51 +137,185 @@ namespace hg {
 
             // EdgeListGraph associated types
             using edges_size_type = size_t;
-            using _edge_iterator_transform_function = std::function<edge_descriptor(edge_index_t)>;
+            /**
+             * Transforms an edge index into an edge descriptor
+             */
+            struct edge_transform {
+                const tree *graph;
+
+                edge_descriptor operator()(edge_index_t i) const;
+            };
+
+            using _edge_iterator_transform_function = edge_transform;
             using edge_iterator = transform_forward_iterator <_edge_iterator_transform_function,
             counting_iterator<vertex_descriptor>, edge_descriptor>;
 
+            /**
+             * Transforms a vertex adjacent to a vertex into an edge descriptor whose source
+             * (or target if in_edge is true) is the vertex
+             */
+            template<bool in_edge>
+            struct incident_edge_transform {
+                vertex_descriptor vertex;
+
+                edge_descriptor operator()(vertex_descriptor t) const {
+                    return in_edge ? edge_descriptor(t, vertex, (std::min)(vertex, t)) :
+                           edge_descriptor(vertex, t, (std::min)(vertex, t));
+                }
+            };
 
             // IncidenceGraph associated types
-            using out_iterator_transform_function = std::function<edge_descriptor(vertex_descriptor)>;
+            using out_iterator_transform_function = incident_edge_transform<false>;
             using out_edge_iterator = transform_forward_iterator<out_iterator_transform_function,
                     tree_graph_adjacent_vertex_iterator<false>,
                     edge_descriptor>;
             using degree_size_type = size_t;
 
             //BidirectionalGraph associated types
-            using in_edge_iterator = out_edge_iterator;
+            using in_iterator_transform_function = incident_edge_transform<true>;
+            using in_edge_iterator = transform_forward_iterator<in_iterator_transform_function,
+                    tree_graph_adjacent_vertex_iterator<false>,
+                    edge_descriptor>;
+
+            /**
+             * Range over the children of a node: a view on the contiguous children array of the tree
+             */
+            struct children_range {
+                children_iterator m_begin;
+                children_iterator m_end;
+
+                children_iterator begin() const {
+                    return m_begin;
+                }
+
+                children_iterator end() const {
+                    return m_end;
+                }
+
+                children_iterator cbegin() const {
+                    return m_begin;
+                }
+
+                children_iterator cend() const {
+                    return m_end;
+                }
 
-            tree() : _root(invalid_index), _num_vertices(0), _num_leaves(0) {
+                size_t size() const {
+                    return m_end - m_begin;
+                }
+
+                bool empty() const {
+                    return m_begin == m_end;
+                }
+
+                vertex_descriptor operator[](index_t i) const {
+                    return m_begin[i];
+                }
+            };
+
+            /**
+             * Children of the internal nodes of a tree in compressed sparse row layout: the children of the internal
+             * node n are stored in increasing order in children[offsets[n - num_leaves], offsets[n - num_leaves + 1]).
+             */
+            struct children_csr {
+                array_1d<index_t> offsets;
+                array_1d<vertex_descriptor> children;
+            };
 
+            // read-only view on the parents array sharing the ownership of the array: copies of the view keep the
+            // array alive
+            using parents_type = xt::xtensor_adaptor<xt::xbuffer_adaptor<const vertex_descriptor *,
+                                                                         xt::smart_ownership,
+                                                                         std::shared_ptr<const void>>, 1>;
+
+            tree() : _root(invalid_index), _num_vertices(0), _num_leaves(0),
+                     _children_computed(false), _category(tree_category::partition_tree),
+                     _layout(tree_layout::topological) {
+                _set_parents(nullptr, 0, nullptr);
             }
 
             template<typename T>
             tree(const xt::xexpression<T> &parents = xt::xarray<vertex_descriptor>({0}),
                  tree_category category = tree_category::partition_tree) :
-                    _parents(parents),
                     _children_computed(false),
-                    _children(0),
-                    _category(category) {
+                    _category(category),
+                    _layout(tree_layout::topological) {
                 HG_TRACE();
+                auto storage = std::make_shared<array_1d<vertex_descriptor>>(parents);
+                auto data = storage->data();
+                auto size = storage->size();
+                _set_parents(data, size, std::move(storage));
                 _init();
             };
 
             template<typename T>
             tree(xt::xexpression<T> &&parents = xt::xarray<vertex_descriptor>({0}),
                  tree_category category = tree_category::partition_tree) :
-                    _parents(std::move(parents.derived_cast())),
                     _children_computed(false),
-                    _children(0),
-                    _category(category) {
+                    _category(category),
+                    _layout(tree_layout::topological) {
                 HG_TRACE();
+                auto storage = std::make_shared<array_1d<vertex_descriptor>>(std::move(parents.derived_cast()));
+                auto data = storage->data();
+                auto size = storage->size();
+                _set_parents(data, size, std::move(storage));
                 _init();
             };
 
+            /**
+             * Creates a tree on an external read-only parents buffer, without copying it (for example a memory mapped
+             * file or a numpy array).
+             *
+             * The buffer must not be modified during the lifetime of the tree (and of its copies, which share the
+             * same buffer). The object owner is kept alive as long as the buffer is used by a tree.
+             *
+             * If the number of leaves is given, the tree is trusted to be valid and the buffer is not read
+             * during the construction (its pages are only loaded when they are accessed). Otherwise the
+             * number of leaves is computed and the tree is validated with a linear scan of the buffer.
+             *
+             * @param parents pointer to the parents array
+             * @param num_vertices number of elements in the parents array
+             * @param owner object owning the buffer (can be nullptr if the buffer outlives the tree)
+             * @param category tree category
+             * @param num_leaves number of leaves of the tree or invalid_index to compute it
+             */
+            tree(const vertex_descriptor *parents,
+                 size_t num_vertices,
+                 std::shared_ptr<const void> owner,
+                 tree_category category = tree_category::partition_tree,
+                 index_t num_leaves = invalid_index) :
+                    _children_computed(false),
+                    _category(category),
+                    _layout(tree_layout::topological) {
+                HG_TRACE();
+                _set_parents(parents, num_vertices, std::move(owner));
+                if (num_leaves == invalid_index) {
+                    _init();
+                } else {
+                    hg_assert(num_vertices > 0, "parents must not be empty");
+                    hg_assert(num_leaves > 0 && num_leaves <= (index_t) num_vertices, "Invalid number of leaves.");
+                    _root = _num_vertices - 1;
+                    _num_leaves = num_leaves;
+                }
+            };
+
             const auto &category() const {
                 return _category;
             }
 
+            const auto &layout() const {
+                return _layout;
+            }
+
+            /**
+             * Record the order of the nodes of the tree: the caller guarantees that the nodes follow the given layout.
+             *
+             * @param layout
+             */
+            void set_layout(tree_layout layout) {
+                _layout = layout;
+            }
+
             vertices_size_type num_vertices() const {
                 return _num_vertices;
             }
@@ -146,18 +328,19 @@ namespace hg {
                 return (_num_vertices == 0) ? 0 : _num_vertices - 1;
             }
 
-            const auto &children(vertex_descriptor v) const {
+            children_range children(vertex_descriptor v) const {
                 if (v < _num_leaves) {
-                    return _empty_children;
+                    return {nullptr, nullptr};
                 }
-                return _children[v - _num_leaves];
+                return {_children_data + _children_offsets_data[v - _num_leaves],
+                        _children_data + _children_offsets_data[v - _num_leaves + 1]};
             }
 
             size_t num_children(const vertex_descriptor v) const {
                 if (v < _num_leaves) {
                     return 0;
                 }
-                return _children[v - _num_leaves].size();
+                return _children_offsets_data[v - _num_leaves + 1] - _children_offsets_data[v - _num_leaves];
             }
 
             vertex_descriptor root() const {
@@ -177,16 +360,31 @@ namespace hg {
             }
 
             auto child(index_t i, vertex_descriptor v) const {
-                return _children[v - _num_leaves][i];
+                return _children_data[_children_offsets_data[v - _num_leaves] + i];
+            }
+
+            vertex_descriptor parent(vertex_descriptor v) const {
+                return _parents_data[v];
             }
 
-            template<typename... Args>
-            auto parent(Args &&... args) const {
-                return _parents(std::forward<Args>(args)...);
+            /**
+             * Read-only view on the parents array. The array is shared by the tree, its copies and the copies of the
+             * view: a copy of the view (for example auto p = t.parents();) remains valid after the destruction of
+             * the tree.
+             */
+            const parents_type &parents() const &{
+                return _parents_storage->view;
             }
 
-            const auto &parents() const {
-                return _parents;
+            parents_type parents() const &&{
+                return _parents_storage->view;
+            }
+
+            /**
+             * Pointer to the parents array
+             */
+            const vertex_descriptor *parents_data() const {
+                return _parents_data;
             }
 
             auto leaves_iterator() const {
@@ -223,24 +421,66 @@ namespace hg {
                 return v;
             }
 
+            /**
+             * Computes the children of every node in a compressed sparse row layout (see children_csr).
+             *
+             * Nothing is done if the children have already been computed. This function can be called concurrently
+             * from several threads on the same tree.
+             */
             void compute_children() const {
-                if (!_children_computed) {
-                    _children.resize(_num_vertices - _num_leaves);
-                    for (vertex_descriptor v = 0; v < _root; ++v) {
-                        vertex_descriptor parent_v = _parents(v);
-                        _children[parent_v - _num_leaves].push_back(v);
-                    }
-                    _children_computed = true;
+                if (_children_computed.get()) {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(_parents_storage->children_mutex);
+                if (_children_computed.get()) {
+                    return;
+                }
+                index_t num_internal_nodes = _num_vertices - _num_leaves;
+                auto storage = std::make_shared<children_csr>();
+                auto &offsets = storage->offsets;
+                auto &children = storage->children;
+                offsets = xt::zeros<index_t>({(size_t) num_internal_nodes + 1});
+                children = array_1d<vertex_descriptor>::from_shape({(size_t) num_edges()});
+                for (vertex_descriptor v = 0; v < _root; ++v) {
+                    offsets(_parents_data[v] - _num_leaves)++;
+                }
+                // inclusive prefix sum: offsets[i] is the end of the children of the i-th internal node
+                for (index_t i = 1; i <= num_internal_nodes; ++i) {
+                    offsets(i) += offsets(i - 1);
+                }
+                // filling in decreasing order turns the ends into the starts and keeps children sorted
+                for (vertex_descriptor v = _root - 1; v >= 0; --v) {
+                    children(--offsets(_parents_data[v] - _num_leaves)) = v;
                 }
+                _children_offsets_data = offsets.data();
+                _children_data = children.data();
+                _children_storage = std::move(storage);
+                _children_computed.set(true);
             }
 
+            /**
+             * Removes the children relation (this function is not thread safe).
+             */
             void clear_children() const {
-                _children.clear();
-                _children_computed = false;
+                _children_computed.set(false);
+                _children_storage.reset();
+                _children_offsets_data = nullptr;
+                _children_data = nullptr;
+            }
+
+            /**
+             * Children relation in compressed sparse row layout (computed if needed, see compute_children).
+             *
+             * The storage is shared with the tree (and with its copies) and stays valid after clear_children as long
+             * as the returned pointer is alive.
+             */
+            std::shared_ptr<const children_csr> children_csr_storage() const {
+                compute_children();
+                return _children_storage;
             }
 
             bool children_computed() const {
-                return _children_computed;
+                return _children_computed.get();
             }
 
             auto sources() const{
@@ -248,21 +488,28 @@ namespace hg {
             }
 
             auto targets() const{
-                return xt::strided_view(_parents, {xt::range(0, _num_vertices - 1)});
+                return xt::strided_view(_parents_storage->view, {xt::range(0, _num_vertices - 1)});
             }
 
 
         private:
 
+            void _set_parents(const vertex_descriptor *parents, size_t num_vertices, std::shared_ptr<const void> owner) {
+                _parents_storage = std::make_shared<parents_storage>(
+                        parents_type(typename parents_type::storage_type(parents, num_vertices, std::move(owner)),
+                                     std::array<size_t, 1>{num_vertices}));
+                _parents_data = parents;
+                _num_vertices = num_vertices;
+            }
+
             void _init() {
-                hg_assert(_parents.shape().size() == 1, "parents must be a linear (1d) array");
-                _num_vertices = _parents.size();
+                hg_assert(_num_vertices > 0, "parents must not be empty");
                 _root = _num_vertices - 1;
-                hg_assert(_parents(_root) == _root, "nodes are not in a topological order (last node is not a root)");
+                hg_assert(_parents_data[_root] == _root, "nodes are not in a topological order (last node is not a root)");
 
-                array_1d<index_t> num_children = xt::zeros_like(_parents);
+                array_1d<index_t> num_children = xt::zeros<index_t>({_num_vertices});
                 for (vertex_descriptor v = 0; v < _root; ++v) {
-                    vertex_descriptor parent_v = _parents(v);
+                    vertex_descriptor parent_v = _parents_data[v];
                     hg_assert(parent_v != v, "several root nodes detected");
                     hg_assert(parent_v > v, "nodes are not in a topological order");
                     num_children(parent_v)++;
@@ -283,13 +530,25 @@ namespace hg {
             vertex_descriptor _root;
             size_t _num_vertices;
             index_t _num_leaves;
-            array_1d <vertex_descriptor> _parents;
-            mutable bool _children_computed;
-            mutable std::vector<children_list_t> _children;
-            tree_category _category;
+            // parents array, possibly shared between copies of the tree or owned by an external object
+            struct parents_storage {
+                explicit parents_storage(parents_type view) : view(std::move(view)) {}
+
+                // the view owns the array
+                parents_type view;
+                // protects the lazy computation of the children of the trees sharing this array
+                mutable std::mutex children_mutex;
+            };
 
-            // for leaf nodes
-            children_list_t _empty_children;
+            std::shared_ptr<const parents_storage> _parents_storage;
+            const vertex_descriptor *_parents_data;
+            mutable lazy_flag _children_computed;
+            // children in compressed sparse row layout, possibly shared between copies of the tree
+            mutable std::shared_ptr<const children_csr> _children_storage;
+            mutable const index_t *_children_offsets_data = nullptr;
+            mutable const vertex_descriptor *_children_data = nullptr;
+            tree_category _category;
+            tree_layout _layout;
         };
 
 
@@ -318,7 +577,7 @@ namespace hg {
         public:
             using graph_t = tree;
             using graph_vertex_t = graph_t::vertex_descriptor;
-            using point_list_iterator_t = graph_t::children_list_t::const_iterator;
+            using point_list_iterator_t = graph_t::children_iterator;
 
             tree_graph_adjacent_vertex_iterator() {}
 
@@ -396,6 +655,10 @@ namespace hg {
             const graph_t &m_tree;
         };
 
+        inline
+        tree::edge_descriptor tree::edge_transform::operator()(edge_index_t i) const {
+            return graph->edge_from_index(i);
+        }
     }
 
     using tree = tree_internal::tree;
@@ -458,6 +721,12 @@ namespace hg {
         return t.category();
     }
 
+    inline
+    const auto &
+    layout(const tree &t) {
+        return t.layout();
+    }
+
     inline
     auto
     root(const tree &t) {
@@ -510,6 +779,12 @@ namespace hg {
         return t.parents();
     }
 
+    inline
+    tree::parents_type
+    parents(const tree &&t) {
+        return t.parents();
+    }
+
     inline
     auto
     leaves_to_root_iterator(const tree &t,
@@ -548,7 +823,7 @@ namespace hg {
     inline
     std::pair<tree::children_iterator, tree::children_iterator>
     children(const tree::vertex_descriptor v, const tree &g) {
-        auto &c = g.children(v);
+        auto c = g.children(v);
         return std::make_pair(c.cbegin(), c.cend());
     }
 
@@ -618,9 +893,7 @@ namespace hg {
     std::pair<typename hg::tree::edge_iterator, typename hg::tree::edge_iterator>
     edges(const hg::tree &g) {
         using it = hg::tree::edge_iterator;
-        auto fun = [&g](hg::tree::edge_index_t i) {
-            return g.edge_from_index(i);
-        };
+        hg::tree::_edge_iterator_transform_function fun{&g};
         return std::make_pair(
                 it(counting_iterator<hg::tree::vertex_descriptor>(0),
                    fun),                 // The first iterator position
@@ -632,7 +905,7 @@ namespace hg {
     std::pair<typename hg::tree::adjacency_iterator, typename hg::tree::adjacency_iterator>
     adjacent_vertices(typename hg::tree::vertex_descriptor v, const hg::tree &g) {
         using it = typename hg::tree::adjacency_iterator;
-        auto &c = g.children(v);
+        auto c = g.children(v);
         auto par = g.parent(v);
         return std::make_pair(
                 it(v, par, c.cbegin()),
@@ -643,10 +916,8 @@ namespace hg {
     inline
     std::pair<hg::tree::out_edge_iterator, hg::tree::out_edge_iterator>
     out_edges(hg::tree::vertex_descriptor v, const hg::tree &g) {
-        auto fun = [v](const typename hg::tree::vertex_descriptor t) {
-            return hg::tree::edge_descriptor(v, t, (std::min)(v, t));
-        };
-        auto &c = g.children(v);
+        hg::tree::out_iterator_transform_function fun{v};
+        auto c = g.children(v);
         using it = typename hg::tree::out_edge_iterator;
         using ita = typename hg::tree::adjacency_iterator;
         auto par = g.parent(v);
@@ -656,13 +927,11 @@ namespace hg {
     }
 
     inline
-    std::pair<hg::tree::out_edge_iterator, hg::tree::out_edge_iterator>
+    std::pair<hg::tree::in_edge_iterator, hg::tree::in_edge_iterator>
     in_edges(hg::tree::vertex_descriptor v, const hg::tree &g) {
-        auto fun = [v](const typename hg::tree::vertex_descriptor t) {
-            return hg::tree::edge_descriptor(t, v, (std::min)(v, t));
-        };
-        auto &c = g.children(v);
-        using it = typename hg::tree::out_edge_iterator;
+        hg::tree::in_iterator_transform_function fun{v};
+        auto c = g.children(v);
+        using it = typename hg::tree::in_edge_iterator;
         using ita = typename hg::tree::adjacency_iterator;
         auto par = g.parent(v);
         return std::make_pair(
@@ -0,0 +1,258 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "leaf_ranges.hpp"
+#include "xtensor/xindex_view.hpp"
+
+namespace hg {
+
+    /**
+     * Result of a batch of k nearest leaves queries: the i-th row holds the nearest leaves of the i-th query leaf
+     * and their distances, by increasing distance.
+     */
+    struct ultrametric_nearest_leaves {
+        array_2d<index_t> leaves;
+        array_2d<double> distances;
+    };
+
+    /**
+     * Result of a batch of range queries in compressed sparse row format: the leaves within the given distance of the
+     * i-th query leaf, and their distances, are leaves[offsets[i]:offsets[i + 1]] and
+     * distances[offsets[i]:offsets[i + 1]], by increasing distance.
+     */
+    struct ultrametric_leaves_within {
+        array_1d<index_t> offsets;
+        array_1d<index_t> leaves;
+        array_1d<double> distances;
+    };
+
+    /**
+     * Nearest neighbour index on the leaves of a hierarchy for the ultrametric distance defined by the hierarchy:
+     * the distance between two distinct leaves is the altitude of their lowest common ancestor. The altitudes must be
+     * increasing from the leaves to the root.
+     *
+     * When climbing from a leaf to the root, the leaves of an ancestor p which are not below the previous ancestor c
+     * (the child of p on the path) are exactly the leaves at distance altitude(p) of the query leaf. With the depth
+     * first ordering of the leaves of leaf_ranges, these leaves form the two contiguous ranges [begin(p), begin(c)[
+     * and [end(c), end(p)[: the queries are thus answered by walking up the ancestors of the query leaf, and emitting
+     * contiguous ranges of the leaf permutation, by increasing distance. The walk stops as soon as the query is
+     * answered: if the tree has no node with a single child, each ancestor brings at least one new leaf and a query
+     * costs O(1 + size of the result).
+     *
+     * The query leaf itself is never part of the result. Leaves at equal distance are ordered by ancestor and then by
+     * position in the depth first permutation of the leaves.
+     */
+    struct ultrametric_leaf_index {
+
+        /**
+         * Preprocess the given tree.
+         *
+         * @tparam T
+         * @param t input tree
+         * @param xaltitudes node altitudes, increasing from the leaves to the root
+         */
+        template<typename T>
+        ultrametric_leaf_index(const tree &t, const xt::xexpression<T> &xaltitudes): m_ranges(t) {
+            HG_TRACE();
+            auto &altitudes = xaltitudes.derived_cast();
+            hg_assert_node_weights(t, altitudes);
+            hg_assert_1d_array(altitudes);
+            hg_assert_content(xt::all(xt::index_view(altitudes, parents(t)) >= altitudes),
+                              "The altitudes must be increasing from the leaves to the root.");
+            m_parents = parents(t);
+            m_altitudes = xt::cast<double>(altitudes);
+        }
+
+        /**
+         * Number of leaves of the indexed tree
+         */
+        index_t num_leaves() const {
+            return m_ranges.leaves().size();
+        }
+
+        /**
+         * Depth first ordering of the leaves of the indexed tree
+         */
+        const leaf_ranges &ranges() const {
+            return m_ranges;
+        }
+
+        /**
+         * Ultrametric distance between two leaves: altitude of their lowest common ancestor, 0 if they are equal.
+         */
+        double distance(index_t leaf1, index_t leaf2) const {
+            if (leaf1 == leaf2) {
+                return 0;
+            }
+            // the lowest common ancestor is the first ancestor of leaf1 whose range contains leaf2
+            const index_t pos = m_ranges.begin(leaf2);
+            index_t n = leaf1;
+            while (pos < m_ranges.begin(n) || pos >= m_ranges.end(n)) {
+                n = m_parents(n);
+            }
+            return m_altitudes(n);
+        }
+
+        /**
+         * Largest node containing the given leaf whose altitude is lower than or equal to max_distance, or the leaf
+         * itself if no such node exists: the leaves of this node are the leaves within max_distance of the given
+         * leaf.
+         */
+        index_t ball(index_t leaf, double max_distance) const {
+            index_t n = leaf;
+            while (m_parents(n) != n && m_altitudes(m_parents(n)) <= max_distance) {
+                n = m_parents(n);
+            }
+            return n;
+        }
+
+        /**
+         * Calls fun(begin, end, distance) on the successive ranges [begin, end[ of positions in the depth first
+         * permutation of the leaves (see ranges().leaves()) holding the leaves at distance distance of the given leaf,
+         * by increasing distance. The walk stops when fun returns false. Empty ranges are skipped.
+         */
+        template<typename F>
+        void visit_ranges(index_t leaf, F &&fun) const {
+            index_t c = leaf;
+            while (m_parents(c) != c) {
+                const index_t p = m_parents(c);
+                const double d = m_altitudes(p);
+                if (m_ranges.begin(p) < m_ranges.begin(c) && !fun(m_ranges.begin(p), m_ranges.begin(c), d)) {
+                    return;
+                }
+                if (m_ranges.end(c) < m_ranges.end(p) && !fun(m_ranges.end(c), m_ranges.end(p), d)) {
+                    return;
+                }
+                c = p;
+            }
+        }
+
+        /**
+         * The k nearest leaves of the given leaf (or all the other leaves if k is larger than num_leaves() - 1), and
+         * their distances, by increasing distance.
+         */
+        std::pair<array_1d<index_t>, array_1d<double>> nearest_leaves(index_t leaf, index_t k) const {
+            check_leaf(leaf);
+            const index_t size = num_results(k);
+            std::pair<array_1d<index_t>, array_1d<double>> result{array_1d<index_t>::from_shape({(size_t) size}),
+                                                                  array_1d<double>::from_shape({(size_t) size})};
+            write_nearest_leaves(leaf, size, result.first.data(), result.second.data());
+            return result;
+        }
+
+        /**
+         * Batch version of nearest_leaves: the queries are processed in parallel and the result has
+         * min(k, num_leaves() - 1) columns.
+         */
+        template<typename T>
+        ultrametric_nearest_leaves nearest_leaves(const xt::xexpression<T> &xleaves, index_t k) const {
+            HG_TRACE();
+            auto &leaves = xleaves.derived_cast();
+            hg_assert_1d_array(leaves);
+            hg_assert_integral_value_type(leaves);
+            hg_assert_content(leaves.size() == 0 || ((xt::amin)(leaves)() >= 0 && (xt::amax)(leaves)() < num_leaves()),
+                              "Leaf indices must be positive and smaller than the number of leaves in the tree.");
+            const index_t num_queries = leaves.size();
+            const index_t size = num_results(k);
+            ultrametric_nearest_leaves result{array_2d<index_t>::from_shape({(size_t) num_queries, (size_t) size}),
+                                              array_2d<double>::from_shape({(size_t) num_queries, (size_t) size})};
+            parfor(0, num_queries, [this, &leaves, &result, size](index_t i) {
+                write_nearest_leaves(leaves(i), size, result.leaves.data() + i * size,
+                                     result.distances.data() + i * size);
+            });
+            return result;
+        }
+
+        /**
+         * The leaves at distance lower than or equal to max_distance of the given leaf, and their distances, by
+         * increasing distance.
+         */
+        std::pair<array_1d<index_t>, array_1d<double>> leaves_within(index_t leaf, double max_distance) const {
+            check_leaf(leaf);
+            const index_t size = m_ranges.size(ball(leaf, max_distance)) - 1;
+            std::pair<array_1d<index_t>, array_1d<double>> result{array_1d<index_t>::from_shape({(size_t) size}),
+                                                                  array_1d<double>::from_shape({(size_t) size})};
+            write_nearest_leaves(leaf, size, result.first.data(), result.second.data());
+            return result;
+        }
+
+        /**
+         * Batch version of leaves_within with one maximal distance per query leaf: the queries are processed in
+         * parallel, a first pass computes the number of results of each query and a second one writes them.
+         */
+        template<typename T1, typename T2>
+        ultrametric_leaves_within leaves_within(const xt::xexpression<T1> &xleaves,
+                                                const xt::xexpression<T2> &xmax_distances) const {
+            HG_TRACE();
+            auto &leaves = xleaves.derived_cast();
+            auto &max_distances = xmax_distances.derived_cast();
+            hg_assert_1d_array(leaves);
+            hg_assert_integral_value_type(leaves);
+            hg_assert_1d_array(max_distances);
+            hg_assert_same_shape(leaves, max_distances);
+            hg_assert_content(leaves.size() == 0 || ((xt::amin)(leaves)() >= 0 && (xt::amax)(leaves)() < num_leaves()),
+                              "Leaf indices must be positive and smaller than the number of leaves in the tree.");
+            const index_t num_queries = leaves.size();
+
+            ultrametric_leaves_within result;
+            result.offsets = array_1d<index_t>::from_shape({(size_t) num_queries + 1});
+            result.offsets(0) = 0;
+            parfor(0, num_queries, [this, &leaves, &max_distances, &result](index_t i) {
+                result.offsets(i + 1) = m_ranges.size(ball(leaves(i), (double) max_distances(i))) - 1;
+            });
+            parallel_inclusive_scan(result.offsets.data(), num_queries + 1);
+
+            const index_t total = result.offsets(num_queries);
+            result.leaves = array_1d<index_t>::from_shape({(size_t) total});
+            result.distances = array_1d<double>::from_shape({(size_t) total});
+            parfor(0, num_queries, [this, &leaves, &result](index_t i) {
+                const index_t start = result.offsets(i);
+                write_nearest_leaves(leaves(i), result.offsets(i + 1) - start, result.leaves.data() + start,
+                                     result.distances.data() + start);
+            });
+            return result;
+        }
+
+    private:
+
+        void check_leaf(index_t leaf) const {
+            hg_assert(leaf >= 0 && leaf < num_leaves(),
+                      "Leaf index must be positive and smaller than the number of leaves in the tree.");
+        }
+
+        index_t num_results(index_t k) const {
+            hg_assert(k >= 0, "The number of neighbours cannot be negative.");
+            return (std::min)(k, (std::max)((index_t) 0, num_leaves() - 1));
+        }
+
+        // writes the size nearest leaves of leaf and their distances, size must be smaller than num_leaves()
+        void write_nearest_leaves(index_t leaf, index_t size, index_t *out_leaves, double *out_distances) const {
+            if (size == 0) {
+                return;
+            }
+            const index_t *permutation = m_ranges.leaves().data();
+            index_t count = 0;
+            visit_ranges(leaf, [permutation, size, out_leaves, out_distances, &count](index_t begin, index_t end,
+                                                                                      double d) {
+                const index_t n = (std::min)(end - begin, size - count);
+                std::copy_n(permutation + begin, n, out_leaves + count);
+                std::fill_n(out_distances + count, n, d);
+                count += n;
+                return count < size;
+            });
+        }
+
+        leaf_ranges m_ranges;
+        array_1d<index_t> m_parents;
+        array_1d<double> m_altitudes;
+    };
+}
@@ -14,6 +14,7 @@
 #include "details/graph_concepts.hpp"
 #include "details/indexed_edge.hpp"
 #include "higra/structure/details/iterators.hpp"
+#include "array.hpp"
 #include <vector>
 #include <list>
 #include <unordered_set>
@@ -67,6 +68,26 @@ namespace hg {
             c.erase(v);
         }
 
+        /**
+         * Replaces each element e of the container by map(e) (the removed edges are not in the container).
+         */
+        template<typename ValueType, typename map_t>
+        void remap_container(std::vector<ValueType> &c, const map_t &map) {
+            for (auto &v: c) {
+                v = map(v);
+            }
+        }
+
+        template<typename ValueType, typename map_t>
+        void remap_container(std::unordered_set<ValueType> &c, const map_t &map) {
+            std::unordered_set<ValueType> remapped;
+            remapped.reserve(c.size());
+            for (auto v: c) {
+                remapped.insert(map(v));
+            }
+            c = std::move(remapped);
+        }
+
         template<typename ValueType>
         void add_to_container(std::vector<ValueType> &c, ValueType v) {
             c.push_back(v);
@@ -102,18 +123,51 @@ namespace hg {
             using edges_size_type = size_t;
             using edge_iterator = std::vector<edge_descriptor>::const_iterator;
 
+            /**
+             * Transforms the index of an edge incident to a vertex into an edge descriptor whose source
+             * (or target if in_edge is true) is the vertex
+             */
+            template<bool in_edge>
+            struct incident_edge_transform {
+                vertex_descriptor vertex;
+                const undirected_graph *graph;
+
+                edge_descriptor operator()(edge_index_t ei) const {
+                    const auto &oe = graph->edge_from_index(ei);
+                    auto other = (vertex == oe.source) ? oe.target : oe.source;
+                    return in_edge ? edge_descriptor(other, vertex, oe.index) :
+                           edge_descriptor(vertex, other, oe.index);
+                }
+            };
+
+            /**
+             * Transforms the index of an edge incident to a vertex into the other extremity of the edge
+             */
+            struct adjacent_vertex_transform {
+                vertex_descriptor vertex;
+                const undirected_graph *graph;
+
+                vertex_descriptor operator()(edge_index_t ei) const {
+                    const auto &oe = graph->edge_from_index(ei);
+                    return (vertex == oe.source) ? oe.target : oe.source;
+                }
+            };
+
             // IncidenceGraph associated types
-            using out_iterator_transform_function = std::function<edge_descriptor(edge_index_t)>;
+            using out_iterator_transform_function = incident_edge_transform<false>;
             using out_edge_iterator = transform_forward_iterator<out_iterator_transform_function,
                     out_edge_index_iterator,
                     edge_descriptor>;
             using degree_size_type = size_t;
 
             //BidirectionalGraph associated types
-            using in_edge_iterator = out_edge_iterator;
+            using in_iterator_transform_function = incident_edge_transform<true>;
+            using in_edge_iterator = transform_forward_iterator<in_iterator_transform_function,
+                    out_edge_index_iterator,
+                    edge_descriptor>;
 
             //AdjacencyGraph associated types
-            using adjacent_iterator_transform_function = std::function<vertex_descriptor(edge_index_t)>;
+            using adjacent_iterator_transform_function = adjacent_vertex_transform;
             using adjacency_iterator = transform_forward_iterator<adjacent_iterator_transform_function,
                     out_edge_index_iterator,
                     vertex_descriptor>;
@@ -133,6 +187,22 @@ namespace hg {
                 }
             };
 
+            /**
+             * Creates a graph with the given number of vertices and the edges {sources(i), targets(i)}
+             * (see add_edges).
+             *
+             * @param num_vertices number of vertices of the graph
+             * @param sources 1d array of edge sources
+             * @param targets 1d array of edge targets (same size as sources)
+             */
+            template<typename T1, typename T2>
+            undirected_graph(const size_t num_vertices,
+                             const xt::xexpression<T1> &sources,
+                             const xt::xexpression<T2> &targets) :
+                    _num_vertices(num_vertices), out_edges(num_vertices) {
+                add_edges(sources.derived_cast(), targets.derived_cast());
+            }
+
             vertices_size_type num_vertices() const {
                 return _num_vertices;
             }
@@ -169,6 +239,42 @@ namespace hg {
                 edges[ei].target = invalid_index;
             }
 
+            /**
+             * Removes the edges deleted with remove_edge from the edge array: the remaining edges are renumbered
+             * consecutively in their original order and the out edge lists of the vertices are updated (the order of
+             * the out edges of each vertex is preserved).
+             *
+             * Returns the old to new edge index map: the element i is the new index of the edge of former index i,
+             * or invalid_index if this edge was removed. Edge weights can then be remapped with a single gather
+             * (see compact_edges(g) for the inverse map).
+             *
+             * @return a 1d array of size num_edges() (before compaction)
+             */
+            array_1d<index_t> compact_edges() {
+                HG_TRACE();
+                const index_t num_e = edges.size();
+                array_1d<index_t> edge_map = array_1d<index_t>::from_shape({(size_t) num_e});
+                index_t num_kept = 0;
+                for (index_t ei = 0; ei < num_e; ei++) {
+                    if (edges[ei].source == invalid_index) {
+                        edge_map(ei) = invalid_index;
+                    } else {
+                        edge_map(ei) = num_kept;
+                        edges[num_kept] = edge_descriptor(edges[ei].source, edges[ei].target, num_kept);
+                        num_kept++;
+                    }
+                }
+                if (num_kept == num_e) {
+                    return edge_map;
+                }
+                edges.erase(edges.begin() + num_kept, edges.end());
+                edges.shrink_to_fit();
+                parfor(0, _num_vertices, [this, &edge_map](index_t v) {
+                    remap_container(out_edges[v], edge_map);
+                });
+                return edge_map;
+            }
+
             void set_edge(edge_index_t ei, vertex_descriptor v1, vertex_descriptor v2) {
                 if (v1 > v2) {
                     std::swap(v1, v2);
@@ -223,6 +329,90 @@ namespace hg {
                 return add_edge(e.first, e.second);
             }
 
+            /**
+             * Adds the edges {sources(i), targets(i)}: the result is identical to calls to add_edge in the order of
+             * the edges, but the degrees of the vertices are counted first such that the out edge list of each
+             * vertex is allocated once, and the edge array is filled in parallel.
+             *
+             * @param sources 1d array of edge sources
+             * @param targets 1d array of edge targets (same size as sources)
+             */
+            template<typename T1, typename T2>
+            void add_edges(const T1 &sources, const T2 &targets) {
+                const index_t first = edges.size();
+                const index_t num_new_edges = sources.size();
+                edges.resize(first + num_new_edges, edge_descriptor(invalid_index, invalid_index, invalid_index));
+                parfor(0, num_new_edges, [this, &sources, &targets, first](index_t i) {
+                    vertex_descriptor v1 = sources(i);
+                    vertex_descriptor v2 = targets(i);
+                    if (v1 > v2) {
+                        std::swap(v1, v2);
+                    }
+                    edges[first + i] = edge_descriptor(v1, v2, first + i);
+                });
+
+                std::vector<index_t> degrees(_num_vertices, 0);
+                for (index_t ei = first; ei < first + num_new_edges; ei++) {
+                    degrees[edges[ei].source]++;
+                    if (edges[ei].source != edges[ei].target) {
+                        degrees[edges[ei].target]++;
+                    }
+                }
+                parfor(0, _num_vertices, [this, &degrees](index_t v) {
+                    if (degrees[v] > 0) {
+                        out_edges[v].reserve(out_edges[v].size() + degrees[v]);
+                    }
+                });
+
+                for (index_t ei = first; ei < first + num_new_edges; ei++) {
+                    add_to_container(out_edges[edges[ei].source], ei);
+                    if (edges[ei].source != edges[ei].target) {
+                        add_to_container(out_edges[edges[ei].target], ei);
+                    }
+                }
+            }
+
+            /**
+             * Contiguous array of the num_edges() edges of the graph
+             */
+            const edge_descriptor *edges_data() const {
+                return edges.data();
+            }
+
+            /**
+             * Creates a graph from its edges and its out edge lists, without adding the edges one by one: the out
+             * edges of the vertex i are the edges whose indices are stored in out_edge_indices from position
+             * out_edge_offsets[i] (included) to position out_edge_offsets[i + 1] (excluded).
+             *
+             * The edges and the out edge lists must describe a valid graph (for example they can be obtained from
+             * the functions edges_data, out_edges_cbegin and out_edges_cend of another graph).
+             *
+             * @param num_vertices number of vertices of the graph
+             * @param edges pointer to the array of edges
+             * @param num_edges number of edges of the graph
+             * @param out_edge_offsets array of num_vertices + 1 offsets
+             * @param out_edge_indices array of edge indices
+             * @return a graph
+             */
+            template<typename T1, typename T2>
+            static undirected_graph from_edge_lists(size_t num_vertices,
+                                                    const edge_descriptor *edges,
+                                                    size_t num_edges,
+                                                    const T1 &out_edge_offsets,
+                                                    const T2 &out_edge_indices) {
+                hg_assert(out_edge_offsets.size() == num_vertices + 1, "Invalid size of out edge offsets.");
+                hg_assert((size_t) out_edge_offsets[num_vertices] == out_edge_indices.size(),
+                          "Invalid size of out edge indices.");
+                undirected_graph g(num_vertices);
+                g.edges.assign(edges, edges + num_edges);
+                auto indices = out_edge_indices.data();
+                for (index_t i = 0; i < (index_t) num_vertices; i++) {
+                    g.out_edges[i] = out_edge_container_type(indices + out_edge_offsets[i],
+                                                             indices + out_edge_offsets[i + 1]);
+                }
+                return g;
+            }
+
             auto sources() const {
                 return HG_ADAPT_STRUCT_ARRAY(edges.data(), source, num_edges());
             }
@@ -331,6 +521,31 @@ namespace hg {
         g.remove_edge(ei);
     }
 
+    /**
+     * Removes the edges deleted with remove_edge from the graph and renumbers the remaining edges (see
+     * undirected_graph::compact_edges).
+     *
+     * The edge weights of the compacted graph are obtained from the edge weights of the graph before compaction with
+     * a single gather: new_weights = gather(old_weights, new_to_old) where new_to_old is the second element of the
+     * result.
+     *
+     * @tparam T
+     * @param g input graph, modified in place
+     * @return a pair of 1d arrays: the old to new edge index map (invalid_index for the removed edges) and the new
+     * to old edge index map
+     */
+    template<typename T>
+    auto compact_edges(hg::undirected_graph<T> &g) {
+        auto old_to_new = g.compact_edges();
+        array_1d<index_t> new_to_old = array_1d<index_t>::from_shape({g.num_edges()});
+        for (index_t ei = 0; ei < (index_t) old_to_new.size(); ei++) {
+            if (old_to_new(ei) != invalid_index) {
+                new_to_old(old_to_new(ei)) = ei;
+            }
+        }
+        return std::make_pair(std::move(old_to_new), std::move(new_to_old));
+    }
+
     template<typename T>
     void set_edge(typename hg::undirected_graph<T>::edge_index_t ei,
                   typename hg::undirected_graph<T>::vertex_descriptor v1,
@@ -359,11 +574,7 @@ namespace hg {
     template<typename T>
     std::pair<typename hg::undirected_graph<T>::out_edge_iterator, typename hg::undirected_graph<T>::out_edge_iterator>
     out_edges(typename hg::undirected_graph<T>::vertex_descriptor v, const hg::undirected_graph<T> &g) {
-        auto fun = [v, &g](const typename hg::undirected_graph<T>::edge_index_t &oei) {
-            const auto &oe = g.edge_from_index(oei);
-            return typename hg::undirected_graph<T>::edge_descriptor(v, (v == oe.source) ? oe.target : oe.source,
-                                                                     oe.index);
-        };
+        typename hg::undirected_graph<T>::out_iterator_transform_function fun{v, &g};
         using it = typename hg::undirected_graph<T>::out_edge_iterator;
         return std::make_pair(
                 it(g.out_edges_cbegin(v), fun),
@@ -371,14 +582,10 @@ namespace hg {
     }
 
     template<typename T>
-    std::pair<typename hg::undirected_graph<T>::out_edge_iterator, typename hg::undirected_graph<T>::out_edge_iterator>
+    std::pair<typename hg::undirected_graph<T>::in_edge_iterator, typename hg::undirected_graph<T>::in_edge_iterator>
     in_edges(typename hg::undirected_graph<T>::vertex_descriptor v, const hg::undirected_graph<T> &g) {
-        auto fun = [v, &g](const typename hg::undirected_graph<T>::edge_index_t &oei) {
-            const auto &oe = g.edge_from_index(oei);
-            return typename hg::undirected_graph<T>::edge_descriptor((v == oe.source) ? oe.target : oe.source, v,
-                                                                     oe.index);
-        };
-        using it = typename hg::undirected_graph<T>::out_edge_iterator;
+        typename hg::undirected_graph<T>::in_iterator_transform_function fun{v, &g};
+        using it = typename hg::undirected_graph<T>::in_edge_iterator;
         return std::make_pair(
                 it(g.out_edges_cbegin(v), fun),
                 it(g.out_edges_cend(v), fun));
@@ -387,10 +594,7 @@ namespace hg {
     template<typename T>
     std::pair<typename hg::undirected_graph<T>::adjacency_iterator, typename hg::undirected_graph<T>::adjacency_iterator>
     adjacent_vertices(typename hg::undirected_graph<T>::vertex_descriptor v, const hg::undirected_graph<T> &g) {
-        auto fun = [v, &g](const typename hg::undirected_graph<T>::edge_index_t &oei) {
-            const auto &oe = g.edge_from_index(oei);
-            return (v == oe.source) ? oe.target : oe.source;
-        };
+        typename hg::undirected_graph<T>::adjacent_iterator_transform_function fun{v, &g};
         using it = typename hg::undirected_graph<T>::adjacency_iterator;
         return std::make_pair(
                 it(g.out_edges_cbegin(v), fun),
@@ -11,69 +11,411 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <memory>
 #include "../utils.hpp"
+#include "workspace.hpp"
 
 namespace hg {
 
     namespace union_find_internal {
 
-        template<typename idx_t=index_t>
+        /*
+         * Path compression policies: define how the find operation shortens the path between an element and its
+         * canonical node.
+         */
+
+        /**
+         * Two pass path compression: all the nodes on the path point directly to the canonical node.
+         */
+        struct path_compression {
+            template<typename storage_t, typename idx_t>
+            static idx_t find(storage_t &storage, idx_t element) {
+                idx_t i = element;
+                // find canonical node i
+                while (storage.parent(i) != i)
+                    i = storage.parent(i);
+                // path compression
+                while (storage.parent(element) != i) {
+                    idx_t tmp = element;
+                    element = storage.parent(element);
+                    storage.parent(tmp) = i;
+                }
+                return i;
+            }
+        };
+
+        /**
+         * One pass path halving: every other node on the path points to its grand parent.
+         */
+        struct path_halving {
+            template<typename storage_t, typename idx_t>
+            static idx_t find(storage_t &storage, idx_t element) {
+                while (storage.parent(element) != element) {
+                    auto grand_parent = storage.parent(storage.parent(element));
+                    storage.parent(element) = grand_parent;
+                    element = grand_parent;
+                }
+                return element;
+            }
+        };
+
+        /**
+         * One pass path splitting: every node on the path points to its grand parent.
+         */
+        struct path_splitting {
+            template<typename storage_t, typename idx_t>
+            static idx_t find(storage_t &storage, idx_t element) {
+                while (storage.parent(element) != element) {
+                    auto parent = storage.parent(element);
+                    storage.parent(element) = storage.parent(parent);
+                    element = parent;
+                }
+                return element;
+            }
+        };
+
+        /*
+         * Link policies: define which canonical node becomes the canonical node of the union of two sets.
+         * The value associated to each node in the storage is the rank or the size of the set.
+         */
+
+        /**
+         * Union by rank
+         */
+        struct link_by_rank {
+            template<typename idx_t>
+            static idx_t init_value() {
+                return 0;
+            }
+
+            template<typename storage_t, typename idx_t>
+            static idx_t link(storage_t &storage, idx_t i, idx_t j) {
+                if (storage.value(i) > storage.value(j))
+                    std::swap(i, j);
+                else if (storage.value(i) == storage.value(j)) {
+                    storage.value(j) += 1;
+                }
+                storage.parent(i) = j;
+                return j;
+            }
+        };
+
+        /**
+         * Union by size
+         */
+        struct link_by_size {
+            template<typename idx_t>
+            static idx_t init_value() {
+                return 1;
+            }
+
+            template<typename storage_t, typename idx_t>
+            static idx_t link(storage_t &storage, idx_t i, idx_t j) {
+                if (storage.value(i) > storage.value(j))
+                    std::swap(i, j);
+                storage.value(j) += storage.value(i);
+                storage.parent(i) = j;
+                return j;
+            }
+        };
+
+        /*
+         * Storage layouts of the parent relation and of the rank/size values.
+         */
+
+        /**
+         * Parents and values are stored in two separate arrays.
+         */
+        struct separate_layout {
+            template<typename idx_t, typename allocator_t>
+            struct storage {
+                storage(size_t size, idx_t init_value) : m_parent(size, 0, allocator_t()),
+                                                         m_value(size, init_value, allocator_t()) {}
+
+                idx_t &parent(idx_t i) {
+                    return m_parent[i];
+                }
+
+                const idx_t &parent(idx_t i) const {
+                    return m_parent[i];
+                }
+
+                idx_t &value(idx_t i) {
+                    return m_value[i];
+                }
+
+                void push_back(idx_t parent, idx_t value) {
+                    m_parent.push_back(parent);
+                    m_value.push_back(value);
+                }
+
+                size_t size() const {
+                    return m_parent.size();
+                }
+
+            private:
+                std::vector<idx_t, allocator_t> m_parent;
+                std::vector<idx_t, allocator_t> m_value;
+            };
+        };
+
+        /**
+         * Parents and values are interleaved in a single array: the parent and the value of a node are thus
+         * stored in the same cache line.
+         */
+        struct interleaved_layout {
+            template<typename idx_t, typename allocator_t>
+            struct storage {
+                storage(size_t size, idx_t init_value) : m_data(size, {0, init_value}, node_allocator_t()) {}
+
+                idx_t &parent(idx_t i) {
+                    return m_data[i].parent;
+                }
+
+                const idx_t &parent(idx_t i) const {
+                    return m_data[i].parent;
+                }
+
+                idx_t &value(idx_t i) {
+                    return m_data[i].value;
+                }
+
+                void push_back(idx_t parent, idx_t value) {
+                    m_data.push_back({parent, value});
+                }
+
+                size_t size() const {
+                    return m_data.size();
+                }
+
+            private:
+                struct node {
+                    idx_t parent;
+                    idx_t value;
+                };
+                using node_allocator_t = typename std::allocator_traits<allocator_t>::template rebind_alloc<node>;
+                std::vector<node, node_allocator_t> m_data;
+            };
+        };
+
+        /**
+         * Union-find structure (disjoint set forest).
+         *
+         * @tparam idx_t type used to store node indices (a 32 bits integer type halves the memory footprint
+         *               for sets with less than 2^31 elements)
+         * @tparam compression_t path compression policy: path_compression, path_halving or path_splitting
+         * @tparam link_t link policy: link_by_rank or link_by_size
+         * @tparam layout_t storage layout: separate_layout or interleaved_layout
+         * @tparam allocator_t allocator of the storage (e.g. workspace_allocator<idx_t> for a temporary structure)
+         */
+        template<typename idx_t=index_t,
+                typename compression_t=path_compression,
+                typename link_t=link_by_rank,
+                typename layout_t=separate_layout,
+                typename allocator_t=std::allocator<idx_t>>
         struct union_find {
 
         public:
 
-            union_find(size_t size = 0) : parent(size), rank(size) {
-                for (index_t i = 0; i < (index_t)parent.size(); ++i) {
-                    parent[i] = i;
+            union_find(size_t size = 0) : m_storage(size, link_t::template init_value<idx_t>()) {
+                for (idx_t i = 0; i < (idx_t) m_storage.size(); ++i) {
+                    m_storage.parent(i) = i;
                 }
             }
 
             idx_t make_set() {
-                idx_t i = parent.size();
-                parent.push_back(i);
-                rank.push_back(0);
+                idx_t i = m_storage.size();
+                m_storage.push_back(i, link_t::template init_value<idx_t>());
                 return i;
             }
 
 
             idx_t find(idx_t element) {
-                idx_t i = element;
-                // find canonical node i
-                while (parent[i] != i)
-                    i = parent[i];
-                // path compression
-                while (parent[element] != i) {
-                    idx_t tmp = element;
-                    element = parent[element];
-                    parent[tmp] = i;
+#ifdef HG_ENABLE_PROFILING
+                // length of the path to the canonical node before compression
+                idx_t path_length = 0;
+                for (idx_t i = element; m_storage.parent(i) != i; i = m_storage.parent(i)) {
+                    path_length++;
                 }
-                return i;
+                HG_PROFILE_COUNT("union_find::find path length", path_length);
+#endif
+                return compression_t::find(m_storage, element);
+            }
+
+            /**
+             * Find the canonical node of the given element without path compression.
+             *
+             * The structure is not modified: this function can thus be called concurrently
+             * as long as no other thread modifies the structure.
+             *
+             * @param element
+             * @return index of the canonical node associated to element
+             */
+            idx_t find_root(idx_t element) const {
+                while (m_storage.parent(element) != element)
+                    element = m_storage.parent(element);
+                return element;
             }
 
             /**
-             * Union by rank
+             * Software prefetch of the parent of the given element, to hide the latency of a later find on
+             * this element.
+             *
+             * If parent_level is true, the parent of the parent of the element is prefetched instead: the parent
+             * of the element is read, it should thus have been prefetched a few iterations before.
+             *
+             * @param element
+             * @param parent_level
+             */
+            void prefetch(idx_t element, bool parent_level = false) const {
+                if (parent_level) {
+                    element = m_storage.parent(element);
+                }
+                HG_PREFETCH(&m_storage.parent(element));
+            }
+
+            /**
+             * Union of the sets represented by the canonical nodes i and j, according to the link policy.
+             *
              * @param i index of canonical node
              * @param j index of canonical node
              * @return index of the canonical node representing the union of i and j (either i or j)
              */
             idx_t link(idx_t i, idx_t j) {
-                if (rank[i] > rank[j])
-                    std::swap(i, j);
-                else if (rank[i] == rank[j]) {
-                    rank[j] += 1;
-                }
-                parent[i] = j;
-                return j;
+                return link_t::link(m_storage, i, j);
             }
 
         private:
-            using container_t = std::vector<idx_t>;
+            using storage_t = typename layout_t::template storage<idx_t, allocator_t>;
 
-            container_t parent;
-            container_t rank;
+            storage_t m_storage;
         };
     }
 
     using union_find = union_find_internal::union_find<>;
 
+    /**
+     * Union-find whose storage is drawn from the active workspace (see workspace.hpp): for the temporary
+     * union-find structures of the algorithms.
+     */
+    using workspace_union_find = union_find_internal::union_find<index_t,
+            union_find_internal::path_compression,
+            union_find_internal::link_by_rank,
+            union_find_internal::separate_layout,
+            workspace_allocator<index_t>>;
+
+    /**
+     * Union-find with one pass path halving, union by size and an interleaved storage of parents and sizes.
+     *
+     * @tparam idx_t type used to store node indices
+     */
+    template<typename idx_t=index_t>
+    using union_find_halving = union_find_internal::union_find<idx_t,
+            union_find_internal::path_halving,
+            union_find_internal::link_by_size,
+            union_find_internal::interleaved_layout>;
+
+
+    /**
+     * Lock-free union-find structure supporting concurrent find and unite operations.
+     *
+     * Parent pointers are atomic: find uses path halving where each pointer update is a compare and swap, and unite
+     * links the canonical node of larger index below the canonical node of smaller index with a compare and swap,
+     * retrying if one of the canonical nodes was concurrently linked (see R. J. Anderson and H. Woll, Wait-free
+     * parallel algorithms for the union-find problem, STOC 1991, and S. V. Jayanti and R. E. Tarjan, A randomized
+     * concurrent algorithm for disjoint set union, PODC 2016).
+     *
+     * As parent pointers always point to smaller indices, the canonical node of a set is its element
+     * of smallest index.
+     *
+     * @tparam idx_t type used to store node indices
+     */
+    template<typename idx_t=index_t>
+    struct concurrent_union_find {
+
+    public:
+
+        concurrent_union_find(size_t size = 0) : m_size(size), m_parent(new std::atomic<idx_t>[size]) {
+            for (idx_t i = 0; i < (idx_t) size; ++i) {
+                m_parent[i].store(i, std::memory_order_relaxed);
+            }
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+        /**
+         * Find the canonical node of the given element (thread safe).
+         *
+         * @param element
+         * @return index of the canonical node associated to element
+         */
+        idx_t find(idx_t element) {
+            while (true) {
+                idx_t parent = m_parent[element].load(std::memory_order_relaxed);
+                if (parent == element) {
+                    return element;
+                }
+                idx_t grand_parent = m_parent[parent].load(std::memory_order_relaxed);
+                if (parent != grand_parent) {
+                    m_parent[element].compare_exchange_weak(parent, grand_parent, std::memory_order_relaxed);
+                }
+                element = grand_parent;
+            }
+        }
+
+        /**
+         * Union of the sets containing the elements i and j (thread safe).
+         *
+         * @param i
+         * @param j
+         * @return true if i and j were in different sets, false otherwise
+         */
+        bool unite(idx_t i, idx_t j) {
+            while (true) {
+                i = find(i);
+                j = find(j);
+                if (i == j) {
+                    return false;
+                }
+                if (i < j) {
+                    std::swap(i, j);
+                }
+                idx_t expected = i;
+                if (m_parent[i].compare_exchange_strong(expected, j)) {
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * Test if the elements i and j are in the same set (thread safe).
+         *
+         * The result is exact if no union is performed concurrently.
+         *
+         * @param i
+         * @param j
+         * @return
+         */
+        bool same_set(idx_t i, idx_t j) {
+            while (true) {
+                i = find(i);
+                j = find(j);
+                if (i == j) {
+                    return true;
+                }
+                // i is still a canonical node: i and j were in different sets when j was found
+                if (m_parent[i].load() == i) {
+                    return false;
+                }
+            }
+        }
+
+    private:
+        size_t m_size;
+        std::unique_ptr<std::atomic<idx_t>[]> m_parent;
+    };
+
 }
@@ -0,0 +1,222 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#pragma once
+
+#include "array.hpp"
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <vector>
+
+namespace hg {
+
+    /**
+     * Cache of memory blocks for the temporary arrays of the algorithms.
+     *
+     * When a workspace is active on the current thread (see scoped_workspace), the temporaries allocated with a
+     * workspace_allocator (see workspace_array_1d) are drawn from the workspace and their memory is kept in the
+     * workspace when they are released, so that repeated calls on inputs of similar sizes do not allocate anymore.
+     *
+     * Blocks are grouped by size classes (powers of 2, at least 64 bytes): a request is served by any released
+     * block of the same class. The cached blocks are freed by release() or when the workspace is destroyed.
+     *
+     * A workspace must only be used by one thread at a time and must outlive the arrays allocated from it.
+     */
+    class workspace {
+    public:
+
+        workspace() = default;
+
+        workspace(const workspace &) = delete;
+
+        workspace &operator=(const workspace &) = delete;
+
+        ~workspace() {
+            release();
+        }
+
+        /**
+         * Workspace active on the current thread (nullptr if none).
+         */
+        static workspace *current() noexcept {
+            return current_ref();
+        }
+
+        void *allocate(std::size_t bytes) {
+            auto c = size_class(bytes);
+            auto block = m_free_blocks[c];
+            if (block != nullptr) {
+                m_free_blocks[c] = block->next;
+                m_cached_bytes -= class_size(c);
+                return block;
+            }
+            return ::operator new(class_size(c));
+        }
+
+        void deallocate(void *p, std::size_t bytes) noexcept {
+            auto c = size_class(bytes);
+            auto block = static_cast<free_block *>(p);
+            block->next = m_free_blocks[c];
+            m_free_blocks[c] = block;
+            m_cached_bytes += class_size(c);
+        }
+
+        /**
+         * Number of bytes held by the released blocks of the workspace.
+         */
+        std::size_t cached_bytes() const noexcept {
+            return m_cached_bytes;
+        }
+
+        /**
+         * Frees the released blocks of the workspace.
+         */
+        void release() noexcept {
+            for (auto &block: m_free_blocks) {
+                while (block != nullptr) {
+                    auto next = block->next;
+                    ::operator delete(block);
+                    block = next;
+                }
+            }
+            m_cached_bytes = 0;
+        }
+
+    private:
+
+        friend class scoped_workspace;
+
+        struct free_block {
+            free_block *next;
+        };
+
+        static constexpr std::size_t min_class_bits = 6;
+        static constexpr std::size_t num_classes = sizeof(std::size_t) * 8 - min_class_bits;
+
+        static workspace *&current_ref() noexcept {
+            thread_local workspace *w = nullptr;
+            return w;
+        }
+
+        static std::size_t size_class(std::size_t bytes) noexcept {
+            std::size_t c = 0;
+            while (class_size(c) < bytes) {
+                c++;
+            }
+            return c;
+        }
+
+        static std::size_t class_size(std::size_t c) noexcept {
+            return (std::size_t) 1 << (c + min_class_bits);
+        }
+
+        free_block *m_free_blocks[num_classes] = {};
+        std::size_t m_cached_bytes = 0;
+    };
+
+    /**
+     * Activates the given workspace on the current thread during its lifetime (the previously active workspace is
+     * restored at its destruction).
+     */
+    class scoped_workspace {
+    public:
+        explicit scoped_workspace(workspace &w) noexcept : m_previous(workspace::current_ref()) {
+            workspace::current_ref() = &w;
+        }
+
+        scoped_workspace(const scoped_workspace &) = delete;
+
+        scoped_workspace &operator=(const scoped_workspace &) = delete;
+
+        ~scoped_workspace() {
+            workspace::current_ref() = m_previous;
+        }
+
+    private:
+        workspace *m_previous;
+    };
+
+    /**
+     * Allocator drawing from the workspace active on the current thread at its construction, or from the global
+     * allocation functions if no workspace is active.
+     *
+     * @tparam T value type
+     */
+    template<typename T>
+    struct workspace_allocator {
+        using value_type = T;
+        using reference = T &;
+        using const_reference = const T &;
+        using pointer = T *;
+        using const_pointer = const T *;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        template<typename U>
+        struct rebind {
+            using other = workspace_allocator<U>;
+        };
+
+        workspace_allocator() noexcept : m_workspace(workspace::current()) {
+        }
+
+        explicit workspace_allocator(workspace *w) noexcept : m_workspace(w) {
+        }
+
+        template<typename U>
+        workspace_allocator(const workspace_allocator<U> &other) noexcept : m_workspace(other.get_workspace()) {
+        }
+
+        pointer allocate(size_type n) {
+            if (m_workspace != nullptr) {
+                return static_cast<pointer>(m_workspace->allocate(n * sizeof(T)));
+            }
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(pointer p, size_type n) noexcept {
+            if (m_workspace != nullptr) {
+                m_workspace->deallocate(p, n * sizeof(T));
+            } else {
+                ::operator delete(p);
+            }
+        }
+
+        workspace *get_workspace() const noexcept {
+            return m_workspace;
+        }
+
+    private:
+        workspace *m_workspace;
+    };
+
+    template<typename T, typename U>
+    inline bool operator==(const workspace_allocator<T> &a, const workspace_allocator<U> &b) {
+        return a.get_workspace() == b.get_workspace();
+    }
+
+    template<typename T, typename U>
+    inline bool operator!=(const workspace_allocator<T> &a, const workspace_allocator<U> &b) {
+        return !(a == b);
+    }
+
+    /**
+     * 1d array for the temporaries of the algorithms, drawn from the active workspace if any.
+     */
+    template<typename value_t>
+    using workspace_array_1d = xt::xtensor<value_t, 1, XTENSOR_DEFAULT_LAYOUT, workspace_allocator<value_t>>;
+
+    /**
+     * std::vector for the temporaries of the algorithms, drawn from the active workspace if any.
+     */
+    template<typename value_t>
+    using workspace_vector = std::vector<value_t, workspace_allocator<value_t>>;
+}
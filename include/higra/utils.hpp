@@ -10,28 +10,49 @@
 
 #pragma once
 
+#include "detail/cancellation.hpp"
+#include "detail/memory_tracking.hpp"
+#include "detail/simd_dispatch.hpp"
 #include <stdio.h>
 #include <exception>
 #include <string>
 #include <iostream>
 #include <stack>
+#include <algorithm>
+#include <atomic>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "xtensor/xstrided_view.hpp"
 #include "xtensor/xadapt.hpp"
+#include "xtensor/xtensor.hpp"
 //#include "xtensor/xio.hpp"
 #include "detail/log.hpp"
 
 #ifdef  HG_USE_TBB
 
 #include "tbb/tbb.h"
+#include "tbb/global_control.h"
+#include <memory>
+
+#elif defined(HG_USE_THREAD_POOL)
+
+#include "detail/thread_pool.hpp"
 
 #endif
 
 namespace hg {
 
     /**
-     * Preferred type to represent an index
+     * Preferred type to represent an index: 64 bits signed integer by default, 32 bits signed integer if HG_INDEX_32
+     * is defined (the number of elements of trees, graphs and arrays must then be smaller than 2^31)
      */
+#ifdef HG_INDEX_32
+    using index_t = int32_t;
+#else
     using index_t = int64_t;
+#endif
 
     /**
      * Constant used to represent an invalid index (eg. not initialized)
@@ -46,6 +67,71 @@ namespace hg {
 
 #define HG_MAIN_ASSERT
 
+/*
+ * Validation of the inputs of the functions. hg_assert is always enabled, the level only controls the input
+ * validation helpers (hg_assert_edge_weights, hg_assert_1d_array... and hg_assert_content):
+ *  - level 0: the helpers are disabled;
+ *  - level 1: constant time helpers only (dimensions and shapes of the arrays, scalar indices...);
+ *  - level 2 (default): level 1 plus the checks scanning the content of the arrays (hg_assert_content, index
+ *    ranges...). These checks can be disabled at runtime with set_validation_level.
+ */
+#ifndef HG_VALIDATION_LEVEL
+#define HG_VALIDATION_LEVEL 2
+#endif
+
+namespace hg {
+
+    /**
+     * Runtime validation levels of the inputs, see set_validation_level.
+     */
+    enum class validation_level {
+        shape = 1,
+        full = 2
+    };
+
+    namespace validation_internal {
+        inline std::atomic<int> &current_level() {
+            static std::atomic<int> level{(std::max)(1, (std::min)(HG_VALIDATION_LEVEL, 2))};
+            return level;
+        }
+    }
+
+    /**
+     * Sets the validation level of the inputs for the whole process.
+     *
+     * With validation_level::shape, only the constant time checks are done (dimensions and shapes of the arrays):
+     * the checks scanning whole arrays (for example that all the indices of an array are valid vertex indices) are
+     * skipped. This is useful when the inputs are known to be valid, typically when they have been produced by Higra
+     * itself, and the linear time checks are not negligible compared to the computation. With validation_level::full
+     * (default), all the checks are done.
+     *
+     * The levels cannot exceed the compile time level HG_VALIDATION_LEVEL: if it is 1, the content checks are not
+     * compiled and validation_level::full is equivalent to validation_level::shape; if it is 0, the input validation
+     * helpers are not compiled either. The other checks (hg_assert), for example on the consistency of the files
+     * read, are always done.
+     *
+     * @param level
+     */
+    inline void set_validation_level(validation_level level) {
+        validation_internal::current_level().store((int) level, std::memory_order_relaxed);
+    }
+
+    /**
+     * Current validation level of the inputs, see set_validation_level.
+     */
+    inline validation_level get_validation_level() {
+        return (validation_level) validation_internal::current_level().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * True if the checks scanning the content of the input arrays must be done.
+     */
+    inline bool is_content_validation_enabled() {
+        return HG_VALIDATION_LEVEL >= 2 &&
+               validation_internal::current_level().load(std::memory_order_relaxed) >= (int) validation_level::full;
+    }
+}
+
 #ifndef __FUNCTION_NAME__
 #ifdef WIN32   //WINDOWS
 #define __FUNCTION_NAME__   __FUNCTION__
@@ -54,12 +140,40 @@ namespace hg {
 #endif
 #endif
 
-#ifdef HG_MAIN_ASSERT
 #define hg_assert(test, msg) do { \
     if(!(test)) {\
     throw std::runtime_error(std::string() + __FUNCTION_NAME__ + " in file " + __FILE__ + "(line:" + std::to_string(__LINE__) + "): "  + msg);} \
   } while (0)
 
+#define hg_assert_integral_value_type(array) do { \
+    static_assert(std::is_integral<typename std::decay_t<decltype(array)>::value_type>::value, "Array values of '" #array "' must be integral (char, short, int, long...)."); \
+    } while (0)
+
+// linear time checks on the content of arrays: done only if is_content_validation_enabled()
+#if HG_VALIDATION_LEVEL >= 2
+#define hg_assert_content(test, msg) do { \
+    if (hg::is_content_validation_enabled()) { \
+        hg_assert(test, msg); \
+    } \
+  } while (0)
+#else
+#define hg_assert_content(test, msg) ((void)0)
+#endif
+
+#define hg_assert_vertex_indices(graph, vertex_indices) do { \
+    hg_assert_content((xt::amin)(vertex_indices)() >= 0, \
+              "Vertex indices cannot be negative.");\
+    hg_assert_content((hg::index_t)(xt::amax)(vertex_indices)() < (hg::index_t)hg::num_vertices(graph), "Vertex indices must be smaller than the number of vertices in the graph/tree.");\
+    } while (0)
+
+#define hg_assert_edge_indices(graph, edge_indices) do { \
+    hg_assert_content((xt::amin)(edge_indices)() >= 0, \
+              "Edge indices cannot be negative.");\
+    hg_assert_content((hg::index_t)(xt::amax)(edge_indices)() < (hg::index_t)hg::num_edges(graph), "Edge indices must be smaller than the number of edges in the graph/tree.");\
+    } while (0)
+
+// constant time checks on the shapes of arrays and on scalar indices
+#if HG_VALIDATION_LEVEL >= 1
 #define hg_assert_edge_weights(graph, edge_weights) do { \
     hg_assert(edge_weights.dimension() > 0, \
               "The dimension of the array '" #edge_weights "', representing edge data of the graph '" #graph "' must be at least 1.");\
@@ -92,10 +206,6 @@ namespace hg {
     hg_assert(array.dimension() == 1, "The array '" #array "' must be 1d."); \
     } while (0)
 
-#define hg_assert_integral_value_type(array) do { \
-    static_assert(std::is_integral<typename std::decay_t<decltype(array)>::value_type>::value, "Array values of '" #array "' must be integral (char, short, int, long...)."); \
-    } while (0)
-
 #define hg_assert_same_shape(array1, array2) do { \
     hg_assert(xt::same_shape(array1.shape(), array2.shape()), "Shapes of '" #array1 "' and '" #array2 "' must be equal."); \
     } while (0)
@@ -108,49 +218,46 @@ namespace hg {
     hg_assert(hg::category(tree) == hg::tree_category::partition_tree, "The category of '" #tree "' must be 'partition_tree'."); \
     } while (0)
 
-#define hg_assert_vertex_indices(graph, vertex_indices) do { \
-    hg_assert((xt::amin)(vertex_indices)() >= 0, \
-              "Vertex indices cannot be negative.");\
-    hg_assert((hg::index_t)(xt::amax)(vertex_indices)() < (hg::index_t)hg::num_vertices(graph), "Vertex indices must be smaller than the number of vertices in the graph/tree.");\
-    } while (0)
-
 #define hg_assert_vertex_index(graph, vertex_index) do { \
     hg_assert(vertex_index >= 0, \
               "Vertex index cannot be negative.");\
     hg_assert((hg::index_t)vertex_index < (hg::index_t)hg::num_vertices(graph), "Vertex index must be smaller than the number of vertices in the graph/tree.");\
     } while (0)
 
-#define hg_assert_edge_indices(graph, edge_indices) do { \
-    hg_assert((xt::amin)(edge_indices)() >= 0, \
-              "Edge indices cannot be negative.");\
-    hg_assert((hg::index_t)(xt::amax)(edge_indices)() < (hg::index_t)hg::num_edges(graph), "Edge indices must be smaller than the number of edges in the graph/tree.");\
-    } while (0)
-
 #define hg_assert_edge_index(graph, edge_index) do { \
     hg_assert(edge_index >= 0, \
               "Edge index cannot be negative.");\
     hg_assert((hg::index_t)edge_index < (hg::index_t)hg::num_edges(graph), "Edge index must be smaller than the number of edges in the graph/tree.");\
     } while (0)
 #else
-#define hg_assert(test, msg) ((void)0)
 #define hg_assert_vertex_weights(graph, vertex_weights) ((void)0)
 #define hg_assert_edge_weights(graph, vertex_weights) ((void)0)
 #define hg_assert_node_weights(tree, node_weights) ((void)0)
 #define hg_assert_leaf_weights(tree, leaf_weights) ((void)0)
 #define hg_assert_1d_array(array) ((void)0)
-#define hg_assert_integral_value_type(array) ((void)0)
 #define hg_assert_same_shape(array1, array2) ((void)0)
 #define hg_assert_component_tree(tree) ((void)0)
 #define hg_assert_partition_tree(tree) ((void)0)
-#define hg_assert_vertex_indices(graph, vertex_indices)((void)0)
-#define hg_assert_edge_indices(graph, edge_indices)((void)0)
 #define hg_assert_vertex_index(graph, vertex_index)((void)0)
 #define hg_assert_edge_index(graph, edge_index)((void)0)
 #endif
 
+// arrays of at least HG_HUGE_PAGES_THRESHOLD bytes initialized with parallel_fill are advised to use transparent
+// huge pages (Linux only, 0 disables the advice)
+#ifndef HG_HUGE_PAGES_THRESHOLD
+#define HG_HUGE_PAGES_THRESHOLD (((std::size_t) 1) << 31)
+#endif
+
 #define HG_XSTR(a) HG_STR(a)
 #define HG_STR(a) #a
 
+// software prefetch of the cache line containing the given address for a read
+#if defined(__GNUC__) || defined(__clang__)
+#define HG_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define HG_PREFETCH(address) ((void)0)
+#endif
+
 
 #define HG_TEMPLATE_SINTEGRAL_TYPES   int8_t, int16_t, int32_t, int64_t
 
@@ -198,10 +305,238 @@ namespace xt {
 
 namespace hg {
 
+    /**
+     * Execution policies used to select the serial or the multithreaded version of an algorithm (similar to the
+     * C++17 std::execution policies).
+     *
+     * A parallel policy can carry the granularity of the parallel loops it is used with (see parfor):
+     *
+     * - grain_size: minimum number of consecutive iterations processed by a task (0 lets the backend decide);
+     * - serial_cutoff: loops (or sorts) with less iterations (or elements) than this value are executed serially by
+     *   the calling thread, which avoids the task spawning overhead on small inputs.
+     *
+     * Example: parfor(execution::par.with_grain_size(1024).with_serial_cutoff(4096), 0, n, fun)
+     *
+     * Without parallel backend (see parallel_internal), the parallel versions are executed serially.
+     */
+    namespace execution {
+        struct sequenced_policy {
+        };
+
+        struct parallel_policy {
+            index_t grain_size = 0;
+            index_t serial_cutoff = 0;
+
+            constexpr parallel_policy with_grain_size(index_t grain) const {
+                return parallel_policy{grain, serial_cutoff};
+            }
+
+            constexpr parallel_policy with_serial_cutoff(index_t cutoff) const {
+                return parallel_policy{grain_size, cutoff};
+            }
+        };
+
+        constexpr sequenced_policy seq{};
+        constexpr parallel_policy par{};
+    }
+
+    /**
+     * Parallel backends
+     *
+     * - HG_USE_TBB: Intel TBB
+     * - HG_USE_THREAD_POOL (and not HG_USE_TBB): built-in pool of std::thread (see thread_pool_internal::thread_pool)
+     * - none: the parallel algorithms are executed serially
+     */
+    namespace parallel_internal {
+
+        /**
+         * Maximum number of threads of the parallel algorithms called from the current thread (0 for no limit),
+         * see thread_limit.
+         */
+        inline index_t &current_thread_limit() {
+            static thread_local index_t limit = 0;
+            return limit;
+        }
+
+#ifdef HG_USE_TBB
+
+        inline std::unique_ptr<tbb::global_control> &tbb_thread_control() {
+            static std::unique_ptr<tbb::global_control> control;
+            return control;
+        }
+
+        /**
+         * Executes fun in a TBB arena limited to current_thread_limit() threads if a limit is set.
+         */
+        template<typename lambda_t>
+        void with_thread_limit(const lambda_t &fun) {
+            index_t limit = current_thread_limit();
+            if (limit > 0 && limit < tbb::this_task_arena::max_concurrency()) {
+                tbb::task_arena arena((int) limit);
+                arena.execute(fun);
+            } else {
+                fun();
+            }
+        }
+
+#else
+
+        template<typename lambda_t>
+        void with_thread_limit(const lambda_t &fun) {
+            fun();
+        }
+
+#endif
+    }
+
+    /**
+     * Sets the maximum number of threads used by the parallel algorithms of the library. If num_threads is 0, the
+     * default value (number of logical cores) is restored.
+     *
+     * The limit applies to the whole process (with TBB, through a tbb::global_control object). This has no effect if
+     * Higra is compiled without parallel backend.
+     *
+     * @param num_threads
+     */
+    inline void set_num_threads(index_t num_threads) {
+#ifdef HG_USE_TBB
+        auto &control = parallel_internal::tbb_thread_control();
+        control.reset();
+        if (num_threads > 0) {
+            control.reset(new tbb::global_control(tbb::global_control::max_allowed_parallelism, (size_t) num_threads));
+        }
+#elif defined(HG_USE_THREAD_POOL)
+        thread_pool_internal::thread_pool::instance().set_num_threads(num_threads);
+#else
+        (void) num_threads;
+        HG_LOG_WARNING("Warning: trying to set maximum number of threads but Higra was compiled without multi-threading!");
+#endif
+    }
+
+    /**
+     * Maximum number of threads that a parallel algorithm called from the current thread can use (taking the
+     * current thread_limit into account). This is 1 inside a parallel loop of the built-in thread pool (nested
+     * loops are executed serially) and if Higra is compiled without parallel backend.
+     *
+     * @return
+     */
+    inline index_t get_num_threads() {
+#if defined(HG_USE_TBB) || defined(HG_USE_THREAD_POOL)
+#ifdef HG_USE_TBB
+        index_t num_threads = tbb::this_task_arena::max_concurrency();
+#else
+        if (thread_pool_internal::in_parallel_region()) {
+            return 1;
+        }
+        index_t num_threads = thread_pool_internal::thread_pool::instance().num_threads();
+#endif
+        index_t limit = parallel_internal::current_thread_limit();
+        return (limit > 0) ? (std::min)(limit, num_threads) : num_threads;
+#else
+        return 1;
+#endif
+    }
+
+    /**
+     * Limits the number of threads used by the parallel algorithms called from the current thread during the lifetime
+     * of the object (for example to share the cores with another thread pool of the application). Limits can be
+     * nested, the previous limit is restored at destruction.
+     *
+     * Example:
+     *
+     * {
+     *     thread_limit limit(2);
+     *     auto tree = component_tree_max_tree(graph, vertex_weights); // uses at most 2 threads
+     * }
+     */
+    struct thread_limit {
+        explicit thread_limit(index_t num_threads) : m_previous(parallel_internal::current_thread_limit()) {
+            parallel_internal::current_thread_limit() = num_threads;
+        }
+
+        ~thread_limit() {
+            parallel_internal::current_thread_limit() = m_previous;
+        }
+
+        thread_limit(const thread_limit &) = delete;
+
+        thread_limit &operator=(const thread_limit &) = delete;
+
+    private:
+        index_t m_previous;
+    };
+
+    namespace parallel_internal {
+
+        /**
+         * Global deterministic mode flag, see set_deterministic.
+         */
+        inline std::atomic<bool> &deterministic_mode() {
+#ifdef HG_DETERMINISTIC
+            static std::atomic<bool> mode{true};
+#else
+            static std::atomic<bool> mode{false};
+#endif
+            return mode;
+        }
+    }
+
+    /**
+     * Enables or disables the deterministic mode for the whole process (disabled by default, enabled by default if
+     * Higra is compiled with HG_DETERMINISTIC).
+     *
+     * Most parallel algorithms of the library give results that do not depend on the number of threads. The
+     * exceptions are the floating point reductions that split their input into one block per thread and combine the
+     * partial results of the blocks (accumulate_at with private buffers, the edge sums of the contour attributes,
+     * parallel_inclusive_scan): as floating point addition is not associative, their results may differ in the last
+     * bits when the number of threads changes. In deterministic mode, the number of blocks of these reductions only
+     * depends on the size of their input (see parallel_reduction_num_blocks) and the partial results are always
+     * combined in block order: the results are then bit reproducible whatever the number of threads, the blocks
+     * being still processed in parallel.
+     *
+     * @param deterministic
+     */
+    inline void set_deterministic(bool deterministic) {
+        parallel_internal::deterministic_mode().store(deterministic, std::memory_order_relaxed);
+    }
+
+    /**
+     * True if the deterministic mode is enabled, see set_deterministic.
+     */
+    inline bool is_deterministic() {
+        return parallel_internal::deterministic_mode().load(std::memory_order_relaxed);
+    }
+
+// maximum number of blocks of a parallel reduction in deterministic mode (see parallel_reduction_num_blocks)
+#ifndef HG_DETERMINISTIC_MAX_BLOCKS
+#define HG_DETERMINISTIC_MAX_BLOCKS 32
+#endif
+
+    /**
+     * Number of blocks of a parallel reduction over size elements, each block holding at least min_block_size
+     * elements (except if there is a single block).
+     *
+     * By default, there is at most one block per thread. In deterministic mode (see set_deterministic), the number of
+     * blocks only depends on size and is at most HG_DETERMINISTIC_MAX_BLOCKS.
+     *
+     * @param size number of elements
+     * @param min_block_size minimum number of elements of a block
+     * @return a number of blocks greater than or equal to 1
+     */
+    inline index_t parallel_reduction_num_blocks(index_t size, index_t min_block_size) {
+        const index_t max_blocks = is_deterministic() ? (index_t) HG_DETERMINISTIC_MAX_BLOCKS : get_num_threads();
+        return (std::max)((index_t) 1, (std::min)(max_blocks, size / (std::max)((index_t) 1, min_block_size)));
+    }
+
     template<typename lambda_t>
     void parfor(index_t start_index, index_t end_index, lambda_t fun, index_t step_size = 1) {
 #ifdef HG_USE_TBB
-        tbb::parallel_for(start_index, end_index, step_size, fun);
+        parallel_internal::with_thread_limit([&]() {
+            tbb::parallel_for(start_index, end_index, step_size, fun);
+        });
+#elif defined(HG_USE_THREAD_POOL)
+        thread_pool_internal::thread_pool::instance().parallel_for(start_index, end_index, step_size, fun,
+                                                                   get_num_threads(), 1);
 #else
         for (index_t i = start_index; i < end_index; i += step_size) {
             fun(i);
@@ -209,6 +544,318 @@ namespace hg {
 #endif
     }
 
+    /**
+     * Calls fun(i) for i in [start_index, end_index) in parallel with the granularity given by the policy (see
+     * execution::parallel_policy).
+     *
+     * @tparam lambda_t
+     * @param policy parallel policy
+     * @param start_index
+     * @param end_index
+     * @param fun
+     */
+    template<typename lambda_t>
+    void parfor(const execution::parallel_policy &policy, index_t start_index, index_t end_index, lambda_t fun) {
+        if (end_index - start_index < policy.serial_cutoff) {
+            for (index_t i = start_index; i < end_index; i++) {
+                fun(i);
+            }
+            return;
+        }
+#ifdef HG_USE_TBB
+        if (policy.grain_size > 1) {
+            parallel_internal::with_thread_limit([&]() {
+                tbb::parallel_for(tbb::blocked_range<index_t>(start_index, end_index, (size_t) policy.grain_size),
+                                  [&fun](const tbb::blocked_range<index_t> &range) {
+                                      for (index_t i = range.begin(); i < range.end(); i++) {
+                                          fun(i);
+                                      }
+                                  });
+            });
+        } else {
+            parfor(start_index, end_index, fun);
+        }
+#elif defined(HG_USE_THREAD_POOL)
+        thread_pool_internal::thread_pool::instance().parallel_for(start_index, end_index, 1, fun,
+                                                                   get_num_threads(), policy.grain_size);
+#else
+        for (index_t i = start_index; i < end_index; i++) {
+            fun(i);
+        }
+#endif
+    }
+
+    /**
+     * In place inclusive prefix sum of the first size elements of the given array: data[i] is replaced by
+     * data[0] + ... + data[i].
+     *
+     * The array is split into blocks whose prefix sums are computed in parallel, the sums of the blocks are then
+     * accumulated serially, and the offset of each block is finally added to its elements in parallel. With a single
+     * thread, this is a serial prefix sum, except in deterministic mode (see set_deterministic) where the blocks are
+     * always used so that floating point results do not depend on the number of threads.
+     *
+     * @tparam value_t
+     * @param data pointer to the first element
+     * @param size number of elements
+     */
+    template<typename value_t>
+    void parallel_inclusive_scan(value_t *data, index_t size) {
+        const index_t block_size = 1 << 15;
+        const index_t num_blocks = (size + block_size - 1) / block_size;
+        if (num_blocks > 1 && (get_num_threads() > 1 || is_deterministic())) {
+            std::vector<value_t> block_sums(num_blocks);
+            parfor(0, num_blocks, [data, size, block_size, &block_sums](index_t b) {
+                const index_t end = (std::min)(size, (b + 1) * block_size);
+                for (index_t i = b * block_size + 1; i < end; i++) {
+                    data[i] += data[i - 1];
+                }
+                block_sums[b] = data[end - 1];
+            });
+            for (index_t b = 1; b < num_blocks; b++) {
+                block_sums[b] += block_sums[b - 1];
+            }
+            parfor(1, num_blocks, [data, size, block_size, &block_sums](index_t b) {
+                const index_t end = (std::min)(size, (b + 1) * block_size);
+                const value_t offset = block_sums[b - 1];
+                for (index_t i = b * block_size; i < end; i++) {
+                    data[i] += offset;
+                }
+            });
+            return;
+        }
+        for (index_t i = 1; i < size; i++) {
+            data[i] += data[i - 1];
+        }
+    }
+
+    namespace parallel_fill_internal {
+
+        /**
+         * Arrays smaller than this number of bytes are filled serially: they span only a few pages.
+         */
+        constexpr std::size_t serial_cutoff_bytes = 1 << 20;
+
+        /**
+         * Advises the kernel to back the pages of the given memory range with transparent huge pages if the range is
+         * larger than HG_HUGE_PAGES_THRESHOLD. Must be called before the pages are first touched to be effective.
+         */
+        inline void advise_huge_pages(void *data, std::size_t num_bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            if (HG_HUGE_PAGES_THRESHOLD == 0 || num_bytes < HG_HUGE_PAGES_THRESHOLD) {
+                return;
+            }
+            const auto page_size = (std::uintptr_t) sysconf(_SC_PAGESIZE);
+            const auto begin = ((std::uintptr_t) data + page_size - 1) / page_size * page_size;
+            const auto end = (std::uintptr_t) data + num_bytes;
+            if (end > begin) {
+                // the advice is only a hint: failure is harmless
+                madvise((void *) begin, end - begin, MADV_HUGEPAGE);
+            }
+#else
+            (void) data;
+            (void) num_bytes;
+#endif
+        }
+    }
+
+    /**
+     * Sets the first size elements of the given array to value, the array being split into contiguous blocks filled
+     * in parallel.
+     *
+     * On a NUMA machine, the pages of a freshly allocated array are physically allocated on the memory node of the
+     * thread that writes them first: an array initialized by the main thread (for example with xt::zeros) then lives
+     * on a single node and the threads of the subsequent parallel loops compete for its memory bandwidth. Filling it
+     * with this function distributes its pages over the nodes of the threads of the parallel backend instead. As the
+     * parallel loops use dynamic scheduling, the pages are not necessarily local to the thread that processes them
+     * later, but the load is balanced between the memory nodes.
+     *
+     * Large arrays (see HG_HUGE_PAGES_THRESHOLD) are also advised to use transparent huge pages on Linux.
+     *
+     * Small arrays, and all arrays without parallel backend, are filled serially.
+     *
+     * @tparam value_t
+     * @param data pointer to the first element
+     * @param size number of elements
+     * @param value fill value
+     */
+    template<typename value_t>
+    void parallel_fill(value_t *data, index_t size, const value_t &value) {
+        if (size <= 0) {
+            return;
+        }
+        const std::size_t num_bytes = (std::size_t) size * sizeof(value_t);
+        parallel_fill_internal::advise_huge_pages(data, num_bytes);
+        const index_t num_threads = get_num_threads();
+        if (num_threads == 1 || num_bytes < parallel_fill_internal::serial_cutoff_bytes) {
+            std::fill(data, data + size, value);
+            return;
+        }
+        // a few blocks per thread to absorb the imbalance of the dynamic scheduling
+        const index_t block_size = (size + 4 * num_threads - 1) / (4 * num_threads);
+        parfor(0, size, [data, size, block_size, &value](index_t start) {
+            std::fill(data + start, data + (std::min)(start + block_size, size), value);
+        }, block_size);
+    }
+
+    namespace gather_scatter_internal {
+
+        /**
+         * Number of elements processed by a task of the parallel gather and scatter
+         */
+        constexpr index_t chunk_size = 4096;
+
+        /**
+         * result[i] = values[indices[i]] for i in [0, size[
+         */
+        template<typename value_t, typename index_type, typename result_t>
+        HG_SIMD_DISPATCH
+        void gather_kernel(const value_t *values, const index_type *indices, result_t *result, index_t size) {
+            for (index_t i = 0; i < size; i++) {
+                result[i] = (result_t) values[indices[i]];
+            }
+        }
+
+        /**
+         * result[indices[i]] = values[i] for i in [0, size[
+         */
+        template<typename value_t, typename index_type, typename result_t>
+        HG_SIMD_DISPATCH
+        void scatter_kernel(const value_t *values, const index_type *indices, result_t *result, index_t size) {
+            for (index_t i = 0; i < size; i++) {
+                result[indices[i]] = (result_t) values[i];
+            }
+        }
+
+        template<typename T>
+        bool is_contiguous_1d(const T &array, std::true_type /* has data interface */) {
+            return array.dimension() == 1 && (array.size() <= 1 || array.strides()[0] == 1);
+        }
+
+        template<typename T>
+        bool is_contiguous_1d(const T &, std::false_type /* has data interface */) {
+            return false;
+        }
+
+        template<typename T>
+        bool is_contiguous_1d(const T &array) {
+            return is_contiguous_1d(array, xt::has_data_interface<T>());
+        }
+
+        template<typename T>
+        auto data_pointer(const T &array, std::true_type /* has data interface */) {
+            return array.data() + array.data_offset();
+        }
+
+        template<typename T>
+        const typename T::value_type *data_pointer(const T &, std::false_type /* has data interface */) {
+            return nullptr;
+        }
+
+        template<typename T>
+        auto data_pointer(const T &array) {
+            return data_pointer(array, xt::has_data_interface<T>());
+        }
+    }
+
+    /**
+     * Parallel gather: result[i] = values(indices(i)) for i in [0, indices.size()[.
+     *
+     * If values and indices are contiguous 1d arrays, the elements are processed by chunks with a vectorized kernel
+     * (AVX2 and AVX-512 gather instructions with the runtime dispatch of simd_dispatch.hpp), otherwise the elements
+     * are read with the access operators of the expressions. In both cases, the chunks are processed in parallel.
+     * The indices are not checked.
+     *
+     * @tparam T
+     * @tparam I
+     * @tparam result_t
+     * @param xvalues 1d array of values
+     * @param xindices 1d array of indices in values
+     * @param result pointer to the first element of a buffer of indices.size() elements
+     */
+    template<typename T, typename I, typename result_t>
+    void gather(const xt::xexpression<T> &xvalues, const xt::xexpression<I> &xindices, result_t *result) {
+        auto &values = xvalues.derived_cast();
+        auto &indices = xindices.derived_cast();
+        hg_assert(values.dimension() == 1, "Values must be a 1d array.");
+        hg_assert(indices.dimension() == 1, "Indices must be a 1d array.");
+        const index_t size = indices.size();
+        const index_t chunk_size = gather_scatter_internal::chunk_size;
+        if (gather_scatter_internal::is_contiguous_1d(values) && gather_scatter_internal::is_contiguous_1d(indices)) {
+            const auto values_ptr = gather_scatter_internal::data_pointer(values);
+            const auto indices_ptr = gather_scatter_internal::data_pointer(indices);
+            parfor(0, size, [values_ptr, indices_ptr, result, size, chunk_size](index_t i) {
+                gather_scatter_internal::gather_kernel(values_ptr, indices_ptr + i, result + i,
+                                                       (std::min)(chunk_size, size - i));
+            }, chunk_size);
+        } else {
+            parfor(0, size, [&values, &indices, result, size, chunk_size](index_t i) {
+                const index_t end = (std::min)(i + chunk_size, size);
+                for (index_t j = i; j < end; j++) {
+                    result[j] = (result_t) values(indices(j));
+                }
+            }, chunk_size);
+        }
+    }
+
+    /**
+     * Parallel gather: returns the 1d array result such that result(i) = values(indices(i)) for i in
+     * [0, indices.size()[ (see gather(values, indices, result)).
+     *
+     * This is the same as xt::eval(xt::index_view(values, indices)) for 1d arrays.
+     *
+     * @tparam T
+     * @tparam I
+     * @param xvalues 1d array of values
+     * @param xindices 1d array of indices in values
+     * @return a 1d array with the value type of values
+     */
+    template<typename T, typename I>
+    auto gather(const xt::xexpression<T> &xvalues, const xt::xexpression<I> &xindices) {
+        using value_type = typename T::value_type;
+        auto result = xt::xtensor<value_type, 1>::from_shape({xindices.derived_cast().size()});
+        gather(xvalues, xindices, result.data());
+        return result;
+    }
+
+    /**
+     * Parallel scatter: result[indices(i)] = values(i) for i in [0, indices.size()[.
+     *
+     * The indices must be distinct. As for gather, contiguous 1d arrays are processed with a vectorized kernel (with
+     * AVX-512 scatter instructions with runtime dispatch), and the elements are processed in parallel.
+     *
+     * @tparam T
+     * @tparam I
+     * @tparam result_t
+     * @param xvalues 1d array of values (of the same size as indices)
+     * @param xindices 1d array of distinct indices in result
+     * @param result pointer to the first element of the output buffer
+     */
+    template<typename T, typename I, typename result_t>
+    void scatter(const xt::xexpression<T> &xvalues, const xt::xexpression<I> &xindices, result_t *result) {
+        auto &values = xvalues.derived_cast();
+        auto &indices = xindices.derived_cast();
+        hg_assert(values.dimension() == 1, "Values must be a 1d array.");
+        hg_assert(indices.dimension() == 1, "Indices must be a 1d array.");
+        hg_assert(values.size() == indices.size(), "Values and indices must have the same size.");
+        const index_t size = indices.size();
+        const index_t chunk_size = gather_scatter_internal::chunk_size;
+        if (gather_scatter_internal::is_contiguous_1d(values) && gather_scatter_internal::is_contiguous_1d(indices)) {
+            const auto values_ptr = gather_scatter_internal::data_pointer(values);
+            const auto indices_ptr = gather_scatter_internal::data_pointer(indices);
+            parfor(0, size, [values_ptr, indices_ptr, result, size, chunk_size](index_t i) {
+                gather_scatter_internal::scatter_kernel(values_ptr + i, indices_ptr + i, result,
+                                                        (std::min)(chunk_size, size - i));
+            }, chunk_size);
+        } else {
+            parfor(0, size, [&values, &indices, result, size, chunk_size](index_t i) {
+                const index_t end = (std::min)(i + chunk_size, size);
+                for (index_t j = i; j < end; j++) {
+                    result[indices(j)] = (result_t) values(j);
+                }
+            }, chunk_size);
+        }
+    }
+
 
     /**
      * Insert all elements of collection b at the end of collection a.
@@ -0,0 +1,15 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/binary_partition_tree.hpp"
+
+namespace hg {
+    HG_PREBUILT_FOR_EACH_FLOAT_TYPE(HG_PREBUILT_BINARY_PARTITION_TREE, )
+}
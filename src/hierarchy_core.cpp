@@ -0,0 +1,15 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/hierarchy_core.hpp"
+
+namespace hg {
+    HG_PREBUILT_FOR_EACH_VALUE_TYPE(HG_PREBUILT_HIERARCHY_CORE, )
+}
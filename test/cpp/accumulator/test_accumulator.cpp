@@ -11,6 +11,9 @@
 #include "higra/structure/array.hpp"
 #include "higra/accumulator/accumulator.hpp"
 #include "higra/structure/details/light_axis_view.hpp"
+#include "xtensor/xsort.hpp"
+#include <algorithm>
+#include <random>
 #include <vector>
 
 namespace accumulator {
@@ -20,7 +23,7 @@ namespace accumulator {
         auto inview = hg::make_light_axis_view<vec>(values);
         std::vector<size_t> data_shape(values.shape().begin() + 1, values.shape().end());
 
-        auto out_shape = acc_t::get_output_shape(data_shape);
+        auto out_shape = accFactory.get_output_shape(data_shape);
         if (out_shape.empty())
             out_shape.push_back(1);
         hg::array_nd<double> storage = hg::array_nd<double>::from_shape(out_shape);
@@ -110,4 +113,154 @@ namespace accumulator {
         REQUIRE(res7 == 2);
 
     }
-}
\ No newline at end of file
+
+    template<typename T, typename acc_t, typename reduce_t>
+    void check_wide_rows(acc_t acc_factory, reduce_t reduce, T init) {
+        // rows wider than simd batches, with a remainder
+        const std::size_t num_rows = 7;
+        const std::size_t row_size = 37;
+        hg::array_2d<T> values = hg::array_2d<T>::from_shape({num_rows, row_size});
+        for (std::size_t i = 0; i < num_rows; i++) {
+            for (std::size_t j = 0; j < row_size; j++) {
+                values(i, j) = (T) ((hg::index_t) ((i * 7 + j * 3) % 11) - 4);
+            }
+        }
+
+        hg::array_1d<T> ref = hg::array_1d<T>::from_shape({row_size});
+        for (std::size_t j = 0; j < row_size; j++) {
+            ref(j) = init;
+            for (std::size_t i = 0; i < num_rows; i++) {
+                ref(j) = reduce(values(i, j), ref(j));
+            }
+        }
+
+        hg::array_1d<T> storage = hg::array_1d<T>::from_shape({row_size});
+        auto inview = hg::make_light_axis_view<true>(values);
+        auto acc = acc_factory.template make_accumulator<true>(storage);
+        acc.initialize();
+        for (hg::index_t i = 0; i < (hg::index_t) num_rows; i++) {
+            inview.set_position(i);
+            acc.accumulate(inview.begin());
+        }
+        acc.finalize();
+        REQUIRE((storage == ref));
+    }
+
+    template<typename T>
+    void check_wide_rows_all() {
+        check_wide_rows<T>(hg::accumulator_sum(), [](T a, T b) { return a + b; }, (T) 0);
+        check_wide_rows<T>(hg::accumulator_prod(), [](T a, T b) { return a * b; }, (T) 1);
+        check_wide_rows<T>(hg::accumulator_min(), [](T a, T b) { return (std::min)(a, b); },
+                           (std::numeric_limits<T>::max)());
+        check_wide_rows<T>(hg::accumulator_max(), [](T a, T b) { return (std::max)(a, b); },
+                           std::numeric_limits<T>::lowest());
+    }
+
+    TEST_CASE("accumulator vectorial wide rows", "[accumulator]") {
+        check_wide_rows_all<float>();
+        check_wide_rows_all<double>();
+        check_wide_rows_all<int32_t>();
+        check_wide_rows_all<int64_t>();
+
+        hg::array_nd<double> values = xt::arange<double>(0, 3 * 19);
+        values.reshape({3, 19});
+        auto res = applyAcc<true>(values, hg::accumulator_mean());
+        for (hg::index_t j = 0; j < 19; j++) {
+            REQUIRE(res(j) == j + 19);
+        }
+    }
+
+    TEST_CASE("accumulator statistics scalar", "[accumulator]") {
+        hg::array_nd<double> values{-5, 10, -20, 5, 2, -2};
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_variance())(), 558.0 / 6 - 100.0 / 36));
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_covariance())(), 558.0 / 6 - 100.0 / 36));
+
+        hg::array_nd<double> ref_histogram{1, 2, 3};
+        REQUIRE((applyAccG(values, hg::accumulator_histogram(3, -20, 10)) == ref_histogram));
+        hg::array_nd<double> ref_histogram2{0, 1, 1, 1};
+        REQUIRE((applyAccG(values, hg::accumulator_histogram(4, -8, 4)) == ref_histogram2));
+
+        // small sets: exact quantiles with linear interpolation
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_quantile(0))(), -20));
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_quantile(0.25))(), -4.25));
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_quantile(0.5))(), 0));
+        REQUIRE(isclose(applyAccG(values, hg::accumulator_quantile(1))(), 10));
+
+        hg::array_nd<double> empty = hg::array_nd<double>::from_shape({0});
+        REQUIRE(applyAccG(empty, hg::accumulator_variance())() == 0);
+        REQUIRE(applyAccG(empty, hg::accumulator_quantile(0.5))() == 0);
+    }
+
+    TEST_CASE("accumulator statistics vectorial", "[accumulator]") {
+        hg::array_nd<double> values{{1, 2},
+                                    {3, 1},
+                                    {5, 6},
+                                    {7, 3}};
+        hg::array_nd<double> ref_variance{5, 3.5};
+        REQUIRE(xt::allclose(applyAccG(values, hg::accumulator_variance()), ref_variance));
+
+        // mean (4, 3), centered values (-3, -1), (-1, -2), (1, 3), (3, 0)
+        hg::array_nd<double> ref_covariance{{5, 2},
+                                            {2, 3.5}};
+        REQUIRE(xt::allclose(applyAccG(values, hg::accumulator_covariance()), ref_covariance));
+
+        hg::array_nd<double> ref_histogram{{1, 1, 2},
+                                           {2, 1, 1}};
+        REQUIRE((applyAccG(values, hg::accumulator_histogram(3, 1, 7)) == ref_histogram));
+
+        hg::array_nd<double> ref_median{4, 2.5};
+        REQUIRE(xt::allclose(applyAccG(values, hg::accumulator_quantile(0.5)), ref_median));
+    }
+
+    template<typename accumulator_t>
+    auto merge_halves(const hg::array_nd<double> &values, const accumulator_t &accumulator) {
+        auto out_shape = accumulator.get_output_shape(std::vector<size_t>());
+        if (out_shape.empty())
+            out_shape.push_back(1);
+        hg::array_nd<double> storage = hg::array_nd<double>::from_shape(out_shape);
+        auto acc1 = accumulator.template make_accumulator<false>(storage);
+        auto acc2 = accumulator.template make_accumulator<false>(storage);
+        acc1.initialize();
+        acc2.initialize();
+        hg::index_t half = values.size() / 2;
+        for (hg::index_t i = 0; i < (hg::index_t) values.size(); i++) {
+            if (i < half) {
+                acc1.accumulate(&values(i));
+            } else {
+                acc2.accumulate(&values(i));
+            }
+        }
+        acc1.merge(acc2);
+        acc1.finalize();
+        return storage;
+    }
+
+    TEST_CASE("accumulator statistics merge", "[accumulator]") {
+        std::mt19937 rng(42);
+        std::normal_distribution<double> dist(10, 3);
+        hg::array_nd<double> values = hg::array_nd<double>::from_shape({20000});
+        for (auto &v: values) {
+            v = dist(rng);
+        }
+
+        double mean = xt::mean(values)();
+        double ref_variance = xt::mean(xt::square(values - mean))();
+        REQUIRE(std::abs(merge_halves(values, hg::accumulator_variance())(0) - ref_variance) < 1e-8);
+        REQUIRE(std::abs(merge_halves(values, hg::accumulator_covariance())(0) - ref_variance) < 1e-8);
+        REQUIRE(std::abs(applyAccG(values, hg::accumulator_variance())() - ref_variance) < 1e-8);
+
+        auto histogram = merge_halves(values, hg::accumulator_histogram(10, 0, 20));
+        REQUIRE((histogram == applyAccG(values, hg::accumulator_histogram(10, 0, 20))));
+
+        // the error of a t-digest is bounded in rank: compare the rank of the estimates with q
+        hg::array_nd<double> sorted = xt::sort(values);
+        auto rank = [&sorted](double v) {
+            return (double) (std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin()) / sorted.size();
+        };
+        for (double q: {0.001, 0.01, 0.1, 0.5, 0.9, 0.99, 0.999}) {
+            double tolerance = 0.005;
+            REQUIRE(std::abs(rank(merge_halves(values, hg::accumulator_quantile(q))(0)) - q) < tolerance);
+            REQUIRE(std::abs(rank(applyAccG(values, hg::accumulator_quantile(q))()) - q) < tolerance);
+        }
+    }
+}
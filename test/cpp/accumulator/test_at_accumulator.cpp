@@ -9,6 +9,7 @@
 ****************************************************************************/
 #include "../test_utils.hpp"
 #include "higra/accumulator/at_accumulator.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 
@@ -35,4 +36,95 @@ namespace accumulator {
                 {4, 9}};
         REQUIRE((res_vec == expected_res_vec));
     }
-}
\ No newline at end of file
+
+    template<typename T, typename accumulator_t>
+    void test_parallel_at_accumulate(const array_1d<index_t> &indices, const T &weights,
+                                     const accumulator_t &accumulator) {
+        auto ref = accumulate_at(indices, weights, accumulator);
+        REQUIRE(xt::allclose(ref, accumulate_at(execution::par, indices, weights, accumulator)));
+
+        for (index_t num_blocks: {1, 3, 8}) {
+            if (weights.dimension() == 1) {
+                REQUIRE((ref == at_accumulator_internal::at_accumulate_segmented<false>(
+                        indices, weights, accumulator, num_blocks)));
+            } else {
+                REQUIRE((ref == at_accumulator_internal::at_accumulate_segmented<true>(
+                        indices, weights, accumulator, num_blocks)));
+            }
+        }
+    }
+
+    template<typename T, typename accumulator_t>
+    void test_private_buffers_at_accumulate(const array_1d<index_t> &indices, const T &weights,
+                                            const accumulator_t &accumulator) {
+        auto ref = accumulate_at(indices, weights, accumulator);
+        for (index_t num_blocks: {1, 3, 8}) {
+            if (accumulator_detail::use_scalar_views(accumulator, weights.dimension())) {
+                REQUIRE(xt::allclose(ref, at_accumulator_internal::at_accumulate_private_buffers<false>(
+                        indices, weights, accumulator, num_blocks)));
+            } else {
+                REQUIRE(xt::allclose(ref, at_accumulator_internal::at_accumulate_private_buffers<true>(
+                        indices, weights, accumulator, num_blocks)));
+            }
+        }
+    }
+
+    TEST_CASE("test parallel at_accumulator", "at_accumulator") {
+        xt::random::seed(16);
+        index_t size = 1000;
+        array_1d<index_t> indices = xt::random::randint<index_t>({size}, -1, 37);
+        array_1d<double> weights = xt::random::rand<double>({size});
+        array_2d<double> weights_vec = xt::random::rand<double>({size, (index_t) 3});
+
+        test_parallel_at_accumulate(indices, weights, accumulator_sum());
+        test_parallel_at_accumulate(indices, weights, accumulator_mean());
+        test_parallel_at_accumulate(indices, weights, accumulator_first());
+        test_parallel_at_accumulate(indices, weights, accumulator_argmax());
+        test_parallel_at_accumulate(indices, weights_vec, accumulator_max());
+        test_parallel_at_accumulate(indices, weights_vec, accumulator_last());
+        test_parallel_at_accumulate(indices, weights_vec, accumulator_variance());
+
+        test_private_buffers_at_accumulate(indices, weights, accumulator_sum());
+        test_private_buffers_at_accumulate(indices, weights, accumulator_min());
+        test_private_buffers_at_accumulate(indices, weights_vec, accumulator_prod());
+        test_private_buffers_at_accumulate(indices, weights, accumulator_variance());
+        test_private_buffers_at_accumulate(indices, weights_vec, accumulator_covariance());
+        test_private_buffers_at_accumulate(indices, weights, accumulator_histogram(4, 0, 1));
+
+        // output indices larger than the number of elements with empty segments
+        array_1d<index_t> sparse_indices{5, -1, 12, 5, 0, 12, 12};
+        array_1d<int> sparse_weights{1, 2, 3, 4, 5, 6, 7};
+        test_parallel_at_accumulate(sparse_indices, sparse_weights, accumulator_min());
+        test_parallel_at_accumulate(sparse_indices, sparse_weights, accumulator_counter());
+        test_private_buffers_at_accumulate(sparse_indices, sparse_weights, accumulator_sum());
+    }
+
+    TEST_CASE("test deterministic at_accumulator", "at_accumulator") {
+        xt::random::seed(17);
+        index_t size = 1 << 20;
+        array_1d<index_t> indices = xt::random::randint<index_t>({size}, 0, 10);
+        array_1d<double> weights = xt::random::rand<double>({size}) * 1000;
+
+        set_deterministic(true);
+        REQUIRE(is_deterministic());
+        REQUIRE(parallel_reduction_num_blocks(size, 65536) == 16);
+        REQUIRE(parallel_reduction_num_blocks(size * 64, 65536) == HG_DETERMINISTIC_MAX_BLOCKS);
+        REQUIRE(parallel_reduction_num_blocks(10, 65536) == 1);
+
+        // the private buffers are used and the result does not depend on the number of threads
+        array_nd<double> ref;
+        {
+            thread_limit limit(1);
+            ref = accumulate_at(execution::par, indices, weights, accumulator_mean());
+        }
+        for (index_t num_threads: {2, 3, 0}) {
+            thread_limit limit(num_threads);
+            auto res = accumulate_at(execution::par, indices, weights, accumulator_mean());
+            REQUIRE((res == ref));
+        }
+        REQUIRE(xt::allclose(ref, accumulate_at(indices, weights, accumulator_mean())));
+        set_deterministic(false);
+        REQUIRE(!is_deterministic());
+        REQUIRE(parallel_reduction_num_blocks(size, 65536) == (std::min)(get_num_threads(), (index_t) 16));
+    }
+}
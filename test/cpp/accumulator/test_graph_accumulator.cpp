@@ -11,6 +11,7 @@
 #include "../test_utils.hpp"
 #include "higra/accumulator/graph_accumulator.hpp"
 #include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
 
 namespace graph_accumulator {
 
@@ -75,4 +76,35 @@ namespace graph_accumulator {
         };
         REQUIRE(xt::allclose(ref2, res2));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("accumulator graph parallel", "[graph_accumulator]") {
+        xt::random::seed(17);
+        embedding_grid_2d embedding{97, 143};
+        auto g = get_8_adjacency_graph(embedding);
+        auto ig = get_8_adjacency_implicit_graph(embedding);
+
+        array_1d<double> vertex_weights = xt::random::rand<double>({num_vertices(g)});
+        array_2d<double> vertex_weights2 = xt::random::rand<double>({num_vertices(g), (size_t) 3});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        array_2d<double> edge_weights2 = xt::random::rand<double>({num_edges(g), (size_t) 3});
+
+        auto ref1 = accumulate_graph_vertices(g, vertex_weights, accumulator_sum());
+        REQUIRE((ref1 == accumulate_graph_vertices(ig, vertex_weights, accumulator_sum())));
+        REQUIRE((ref1 == accumulate_graph_vertices(execution::par, g, vertex_weights, accumulator_sum())));
+        REQUIRE((ref1 == accumulate_graph_vertices(execution::par, ig, vertex_weights, accumulator_sum())));
+
+        auto ref2 = accumulate_graph_vertices(g, vertex_weights2, accumulator_mean());
+        REQUIRE((ref2 == accumulate_graph_vertices(ig, vertex_weights2, accumulator_mean())));
+        REQUIRE((ref2 == accumulate_graph_vertices(execution::par, g, vertex_weights2, accumulator_mean())));
+        REQUIRE((ref2 == accumulate_graph_vertices(execution::par, ig, vertex_weights2, accumulator_mean())));
+
+        auto ref3 = accumulate_graph_vertices(g, vertex_weights, accumulator_first());
+        REQUIRE((ref3 == accumulate_graph_vertices(ig, vertex_weights, accumulator_first())));
+
+        auto ref4 = accumulate_graph_edges(g, edge_weights, accumulator_max());
+        REQUIRE((ref4 == accumulate_graph_edges(execution::par, g, edge_weights, accumulator_max())));
+
+        auto ref5 = accumulate_graph_edges(g, edge_weights2, accumulator_sum());
+        REQUIRE((ref5 == accumulate_graph_edges(execution::par, g, edge_weights2, accumulator_sum())));
+    }
+}
@@ -10,6 +10,9 @@
 
 #include "../test_utils.hpp"
 #include "higra/accumulator/tree_accumulator.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
 #include <functional>
 
 
@@ -47,6 +50,28 @@ namespace tree_accumulator {
         array_1d<index_t> ref3{1, 1, 1, 1, 1, 2, 2, 3};
         REQUIRE(xt::allclose(ref3, res3));
 
+        array_1d<double> input4{1, 2, 3, 4, 5, 6, 7, 8};
+        auto res4 = accumulate_parallel(tree, input4, hg::accumulator_mean());
+        array_1d<double> ref4{0, 0, 0, 0, 0, 1.5, 4, 6.5};
+        REQUIRE(xt::allclose(ref4, res4));
+
+    }
+
+    TEST_CASE("accumulator tree sequential output type", "[tree_accumulator]") {
+
+        auto tree = data.t;
+
+        array_1d<unsigned char> vertex_data{200, 200, 200, 200, 200};
+        auto res = accumulate_sequential<hg::tree, decltype(vertex_data), hg::accumulator_sum, double>(
+                tree, vertex_data, hg::accumulator_sum());
+        array_1d<double> ref{200, 200, 200, 200, 200, 400, 600, 1000};
+        REQUIRE((res == ref));
+
+        array_2d<unsigned char> vertex_data2{{1, 200}, {2, 200}, {3, 200}, {4, 200}, {5, 200}};
+        auto res2 = accumulate_sequential<hg::tree, decltype(vertex_data2), hg::accumulator_sum, double>(
+                tree, vertex_data2, hg::accumulator_sum());
+        array_2d<double> ref2{{1, 200}, {2, 200}, {3, 200}, {4, 200}, {5, 200}, {3, 400}, {12, 600}, {15, 1000}};
+        REQUIRE((res2 == ref2));
     }
 
     TEST_CASE("accumulator tree vectorial", "[tree_accumulator]") {
@@ -262,4 +287,203 @@ namespace tree_accumulator {
                            {8,  1}};
         REQUIRE(xt::allclose(ref5, output5));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("accumulator and propagate tree multithreaded", "[tree_accumulator]") {
+        xt::random::seed(13);
+        auto graph = get_4_adjacency_graph({150, 120});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(graph)});
+        auto tree = bpt_canonical(graph, edge_weights).tree;
+        auto num_nodes = num_vertices(tree);
+
+        array_1d<double> input = xt::random::rand<double>({num_nodes});
+        array_2d<double> input2 = xt::random::rand<double>({num_nodes, (size_t) 3});
+        array_1d<bool> condition = xt::random::randint<int>({num_nodes}, 0, 2);
+
+        auto t2 = tree;
+        auto res1 = accumulate_parallel(execution::par, t2, input, hg::accumulator_sum());
+        REQUIRE(t2.children_computed());
+        auto ref1 = accumulate_parallel(tree, input, hg::accumulator_sum());
+        REQUIRE((res1 == ref1));
+
+        tree.compute_children();
+        auto res2 = accumulate_parallel(execution::par, tree, input, hg::accumulator_mean());
+        auto ref2 = accumulate_parallel(tree, input, hg::accumulator_mean());
+        REQUIRE((res2 == ref2));
+
+        auto res3 = accumulate_parallel(execution::par, tree, input2, hg::accumulator_max());
+        auto ref3 = accumulate_parallel(execution::seq, tree, input2, hg::accumulator_max());
+        REQUIRE((res3 == ref3));
+
+        auto res4 = propagate_parallel(execution::par, tree, input);
+        auto ref4 = propagate_parallel(tree, input);
+        REQUIRE((res4 == ref4));
+
+        auto res5 = propagate_parallel(execution::par, tree, input2, condition);
+        auto ref5 = propagate_parallel(execution::seq, tree, input2, condition);
+        REQUIRE((res5 == ref5));
+
+        auto res6 = propagate_sequential(execution::par, tree, input, condition);
+        auto ref6 = propagate_sequential(tree, input, condition);
+        REQUIRE((res6 == ref6));
+
+        auto res7 = propagate_sequential(execution::par, tree, input2, condition);
+        auto ref7 = propagate_sequential(execution::seq, tree, input2, condition);
+        REQUIRE((res7 == ref7));
+    }
+
+    TEST_CASE("tree level schedules", "[tree_accumulator]") {
+        auto s1 = make_leaves_to_root_level_schedule(data.t);
+        REQUIRE(s1.num_levels() == 2);
+        REQUIRE((s1.level_start == array_1d<index_t>{0, 2, 3}));
+        REQUIRE((s1.nodes == array_1d<index_t>{5, 6, 7}));
+
+        auto s2 = make_root_to_leaves_level_schedule(data.t);
+        REQUIRE(s2.num_levels() == 3);
+        REQUIRE((s2.level_start == array_1d<index_t>{0, 1, 3, 8}));
+        REQUIRE((s2.nodes == array_1d<index_t>{7, 5, 6, 0, 1, 2, 3, 4}));
+
+        xt::random::seed(17);
+        auto graph = get_4_adjacency_graph({60, 50});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(graph)});
+        auto tree = bpt_canonical(graph, edge_weights).tree;
+        tree.compute_children();
+        auto num_nodes = num_vertices(tree);
+
+        // every child of a node is a leaf or has been processed before the node
+        array_1d<bool> processed = xt::zeros<bool>({num_nodes});
+        xt::view(processed, xt::range(0, num_leaves(tree))) = true;
+        auto s3 = make_leaves_to_root_level_schedule(tree);
+        REQUIRE(s3.nodes.size() == num_nodes - num_leaves(tree));
+        for (index_t l = 0; l < s3.num_levels(); l++) {
+            for (index_t k = s3.level_start(l); k < s3.level_start(l + 1); k++) {
+                for (auto c: children_iterator(s3.nodes(k), tree)) {
+                    REQUIRE(processed(c));
+                }
+            }
+            for (index_t k = s3.level_start(l); k < s3.level_start(l + 1); k++) {
+                processed(s3.nodes(k)) = true;
+            }
+        }
+        REQUIRE(xt::all(processed));
+
+        // the parent of a node has been processed before the node
+        processed = xt::zeros<bool>({num_nodes});
+        auto s4 = make_root_to_leaves_level_schedule(tree);
+        REQUIRE(s4.nodes.size() == num_nodes);
+        std::vector<index_t> order;
+        s4.for_each_node(execution::par, [&order](index_t n) {
+            order.push_back(n);
+        });
+        REQUIRE(order.size() == num_nodes);
+        for (auto n: order) {
+            REQUIRE((n == (index_t) root(tree) || processed(parent(n, tree))));
+            processed(n) = true;
+        }
+    }
+
+    template<typename tree_t, typename T, typename accumulator_t>
+    void test_accumulate_chunked(const tree_t &tree, const T &input, const accumulator_t &accumulator) {
+        auto numl = num_leaves(tree);
+        auto ref = accumulate_sequential(tree, input, accumulator);
+        auto ref_non_leaves = xt::view(ref, xt::range(numl, num_vertices(tree)));
+
+        for (index_t chunk_size: {1, 7, 64, 1 << 20}) {
+            std::vector<std::pair<index_t, index_t>> ranges;
+            auto producer = [&input, &ranges](index_t begin, index_t end) {
+                ranges.emplace_back(begin, end);
+                return array_nd<typename T::value_type>(xt::view(input, xt::range(begin, end)));
+            };
+            auto res = accumulate_sequential_chunked(tree, producer, accumulator, chunk_size);
+            REQUIRE((res == ref_non_leaves));
+
+            REQUIRE(ranges.front().first == 0);
+            REQUIRE(ranges.back().second == (index_t) numl);
+            for (index_t i = 0; i < (index_t) ranges.size(); i++) {
+                REQUIRE(ranges[i].second - ranges[i].first <= chunk_size);
+                if (i > 0) {
+                    REQUIRE(ranges[i].first == ranges[i - 1].second);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("accumulator tree chunked", "[tree_accumulator]") {
+        array_1d<int> input_small{3, 1, 4, 1, 5};
+        test_accumulate_chunked(data.t, input_small, accumulator_sum());
+        test_accumulate_chunked(data.t, input_small, accumulator_first());
+        test_accumulate_chunked(data.t, input_small, accumulator_last());
+
+        xt::random::seed(14);
+        auto graph = get_4_adjacency_graph({31, 17});
+        array_1d<double> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+        auto tree = bpt_canonical(graph, edge_weights).tree;
+        auto numl = num_leaves(tree);
+
+        array_1d<double> input = xt::random::rand<double>({numl});
+        array_2d<double> input2 = xt::random::rand<double>({numl, (size_t) 3});
+
+        test_accumulate_chunked(tree, input, accumulator_sum());
+        test_accumulate_chunked(tree, input, accumulator_mean());
+        test_accumulate_chunked(tree, input, accumulator_min());
+        test_accumulate_chunked(tree, input, accumulator_argmax());
+        test_accumulate_chunked(tree, input, accumulator_counter());
+        test_accumulate_chunked(tree, input2, accumulator_sum());
+        test_accumulate_chunked(tree, input2, accumulator_mean());
+        test_accumulate_chunked(tree, input2, accumulator_max());
+        test_accumulate_chunked(tree, input2, accumulator_first());
+
+        // same result when the children of the tree are computed
+        tree.compute_children();
+        test_accumulate_chunked(tree, input2, accumulator_prod());
+    }
+
+    TEST_CASE("accumulator tree statistics", "[tree_accumulator]") {
+        array_1d<double> input_small{3, 1, 4, 1, 5};
+        auto res1 = accumulate_sequential(data.t, input_small, accumulator_quantile(0.5));
+        array_1d<double> ref1{3, 1, 4, 1, 5, 2, 4, 3};
+        REQUIRE(xt::allclose(ref1, res1));
+
+        auto res2 = accumulate_sequential(data.t, input_small, accumulator_histogram(3, 0, 6));
+        array_2d<double> ref2{{0, 1, 0},
+                              {1, 0, 0},
+                              {0, 0, 1},
+                              {1, 0, 0},
+                              {0, 0, 1},
+                              {1, 1, 0},
+                              {1, 0, 2},
+                              {2, 1, 2}};
+        REQUIRE(xt::allclose(ref2, res2));
+
+        xt::random::seed(15);
+        auto graph = get_4_adjacency_graph({23, 19});
+        array_1d<double> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+        auto tree = bpt_canonical(graph, edge_weights).tree;
+        auto numl = num_leaves(tree);
+
+        array_1d<double> input = xt::random::rand<double>({numl});
+        array_2d<double> input2 = xt::random::rand<double>({numl, (size_t) 3});
+
+        // variance of each node from the raw moments of its leaves
+        auto count = accumulate_sequential(tree, xt::ones<double>({numl}), accumulator_sum());
+        auto sum = accumulate_sequential(tree, input, accumulator_sum());
+        array_1d<double> input_sqr = input * input;
+        auto sum_sqr = accumulate_sequential(tree, input_sqr, accumulator_sum());
+        array_1d<double> ref_variance = sum_sqr / count - (sum / count) * (sum / count);
+
+        auto variance = accumulate_sequential(tree, input, accumulator_variance());
+        REQUIRE(xt::allclose(ref_variance, variance));
+
+        auto covariance = accumulate_sequential(tree, input2, accumulator_covariance());
+        REQUIRE((covariance.shape() == std::vector<size_t>{num_vertices(tree), 3, 3}));
+        for (index_t c = 0; c < 3; c++) {
+            array_1d<double> column = xt::view(input2, xt::all(), c);
+            auto column_variance = accumulate_sequential(tree, column, accumulator_variance());
+            REQUIRE(xt::allclose(column_variance, xt::view(covariance, xt::all(), c, c)));
+        }
+        REQUIRE(xt::allclose(xt::view(covariance, xt::all(), 0, 1), xt::view(covariance, xt::all(), 1, 0)));
+
+        test_accumulate_chunked(tree, input, accumulator_variance());
+        test_accumulate_chunked(tree, input2, accumulator_variance());
+        test_accumulate_chunked(tree, input, accumulator_histogram(5, 0, 1));
+    }
+}
@@ -85,4 +85,33 @@ namespace tree_contour_accumulator {
             REQUIRE(xt::allclose(result, expected));
 
     }
+
+    TEST_CASE("contour accumulator batch", "[tree_contour_accumulator]") {
+
+        auto graph = get_4_adjacency_graph({3, 3});
+        std::vector<hg::tree> trees{
+                hg::tree(array_1d<index_t>{9, 9, 10, 11, 11, 13, 12, 12, 13, 10, 14, 14, 15, 14, 15, 15}),
+                hg::tree(array_1d<index_t>{9, 10, 10, 11, 12, 17, 14, 16, 15, 10, 17, 13, 13, 17, 16, 16, 17, 17})};
+
+        std::vector<array_1d<index_t>> depths{attribute_depth(trees[0]), attribute_depth(trees[1])};
+        std::vector<array_1d<double>> node_saliency{
+                {0, 0, 0, 0, 0, 0, 20, 0, 0, 5, 2, 7, 3, 8, 1, 50},
+                {0, 0, 0, 0, 0, 0, 0,  0, 0, 5, 2, 8, 1, 3, 9, 2, 8, 20}};
+
+        auto result = accumulate_on_contours(graph, trees, node_saliency, depths, hg::accumulator_max());
+        array_2d<double> expected{{0, 7, 5, 7, 8, 0, 20, 8, 7, 0, 20, 8},
+                                  {5, 8, 0, 3, 2, 8, 9,  3, 8, 8, 9,  2}};
+        REQUIRE(xt::allclose(result, expected));
+
+        std::vector<array_2d<double>> node_saliency2;
+        for (index_t t = 0; t < 2; t++) {
+            node_saliency2.push_back(xt::stack(xt::xtuple(node_saliency[t], node_saliency[t] * 2 + 1), 1));
+        }
+        auto result2 = accumulate_on_contours(graph, trees, node_saliency2, depths, hg::accumulator_sum());
+        REQUIRE((result2.shape()[0] == 2 && result2.shape()[1] == num_edges(graph) && result2.shape()[2] == 2));
+        for (index_t t = 0; t < 2; t++) {
+            auto ref = accumulate_on_contours(graph, trees[t], node_saliency2[t], depths[t], hg::accumulator_sum());
+            REQUIRE(xt::allclose(xt::view(result2, t), ref));
+        }
+    }
 }
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include "higra/image/graph_image.hpp"
 #include "../test_utils.hpp"
 #include "higra/algo/tree.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xsort.hpp"
 
 using namespace hg;
 
@@ -28,6 +31,27 @@ namespace test_alignment {
         REQUIRE((ref_map == map));
     }
 
+    TEST_CASE("project fine to coarse labelisation random", "[alignment]") {
+        xt::random::seed(42);
+        // the largest case is split into several blocks of fine regions when several threads are available
+        for (auto sizes: std::vector<std::array<size_t, 3>>{{1000, 150, 20}, {300000, 5000, 300}}) {
+            const size_t num_elements = sizes[0];
+            const size_t num_fine = sizes[1];
+            const size_t num_coarse = sizes[2];
+            array_1d<index_t> fine_labels = xt::random::randint<index_t>({num_elements}, 0, num_fine);
+            array_1d<index_t> coarse_labels = xt::random::randint<index_t>({num_elements}, 0, num_coarse);
+
+            array_2d<size_t> intersections = xt::zeros<size_t>({num_fine, num_coarse});
+            for (index_t i = 0; i < (index_t) num_elements; i++) {
+                intersections(fine_labels(i), coarse_labels(i))++;
+            }
+            array_1d<index_t> ref_map = xt::argmax(intersections, 1);
+
+            auto map = project_fine_to_coarse_labelisation(fine_labels, coarse_labels, num_fine, num_coarse);
+            REQUIRE((ref_map == map));
+        }
+    }
+
     TEST_CASE("hierarchy alignement", "[alignment]") {
 
         auto g = get_4_adjacency_graph({3, 3});
@@ -80,6 +104,53 @@ namespace test_alignment {
         REQUIRE((sm2_k == sm_k_ref));
     }
 
+    TEST_CASE("hierarchy alignment batch", "[alignment]") {
+
+        auto g = get_4_adjacency_graph({10, 10});
+        xt::random::seed(1);
+        array_1d<double> fine_weights = xt::random::rand<double>({num_edges(g)});
+        auto fine_bpt = bpt_canonical(g, fine_weights);
+        auto fine_labels = labelisation_horizontal_cut_from_threshold(fine_bpt.tree, fine_bpt.altitudes, 0.1);
+        auto aligner = make_hierarchy_aligner_from_labelisation(g, fine_labels);
+
+        std::vector<hg::tree> trees;
+        std::vector<array_1d<double>> altitudes;
+        for (index_t i = 0; i < 4; i++) {
+            array_1d<double> weights = xt::random::rand<double>({num_edges(g)});
+            auto bpt = bpt_canonical(g, weights);
+            // hierarchies with non trivial supervertices
+            array_1d<double> alt = xt::maximum(bpt.altitudes - 0.2, 0);
+            trees.push_back(bpt.tree);
+            altitudes.push_back(alt);
+            // same supervertices, different altitudes
+            trees.push_back(bpt.tree);
+            altitudes.push_back(alt * 2);
+        }
+
+        auto res = aligner.align_hierarchies(trees, altitudes);
+        REQUIRE(res.size() == trees.size());
+        for (index_t i = 0; i < (index_t) trees.size(); i++) {
+            REQUIRE((res[i] == aligner.align_hierarchy(trees[i], altitudes[i])));
+        }
+
+        // trees on common coarse supervertices
+        auto coarse_labels = labelisation_horizontal_cut_from_threshold(fine_bpt.tree, fine_bpt.altitudes, 0.3);
+        auto coarse_rag = make_region_adjacency_graph_from_labelisation(g, coarse_labels);
+        std::vector<hg::tree> coarse_trees;
+        std::vector<array_1d<double>> coarse_altitudes;
+        for (index_t i = 0; i < 3; i++) {
+            array_1d<double> weights = xt::random::rand<double>({num_edges(coarse_rag.rag)});
+            auto bpt = bpt_canonical(coarse_rag.rag, weights);
+            coarse_trees.push_back(bpt.tree);
+            coarse_altitudes.push_back(bpt.altitudes);
+        }
+        auto res2 = aligner.align_hierarchies(coarse_rag.vertex_map, coarse_trees, coarse_altitudes);
+        REQUIRE(res2.size() == coarse_trees.size());
+        for (index_t i = 0; i < (index_t) coarse_trees.size(); i++) {
+            REQUIRE((res2[i] == aligner.align_hierarchy(coarse_rag.vertex_map, coarse_trees[i], coarse_altitudes[i])));
+        }
+    }
+
     TEST_CASE("hierarchy alignment with rag", "[alignment]") {
 
         auto g = get_4_adjacency_graph({3, 3});
@@ -0,0 +1,74 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/algo/connected_filter_pipeline.hpp"
+#include "higra/algo/tree.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace test_connected_filter_pipeline {
+
+    using namespace hg;
+
+    TEST_CASE("connected filter pipeline clauses", "[connected_filter_pipeline]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({23, 17});
+        array_1d<int> vertex_weights = xt::random::randint<int>({23 * 17}, 0, 30);
+
+        for (auto tree_type: {filter_pipeline_tree::max_tree, filter_pipeline_tree::min_tree}) {
+            auto ref_tree = (tree_type == filter_pipeline_tree::max_tree) ?
+                            component_tree_max_tree(graph, vertex_weights) :
+                            component_tree_min_tree(graph, vertex_weights);
+            array_1d<double> area = attribute_area(ref_tree.tree);
+            auto volume = attribute_volume(ref_tree.tree, ref_tree.altitudes, area);
+            auto depth = attribute_depth(ref_tree.tree);
+            array_1d<bool> deleted = (area < 20) || (volume <= 50) || (depth > 10);
+            deleted(root(ref_tree.tree)) = false;
+            auto expected = reconstruct_leaf_data(ref_tree.tree, ref_tree.altitudes, deleted);
+
+            connected_filter_pipeline pipeline(tree_type);
+            auto area_index = pipeline.add_attribute(filter_pipeline_attribute::area);
+            auto volume_index = pipeline.add_attribute(filter_pipeline_attribute::volume);
+            auto depth_index = pipeline.add_attribute(filter_pipeline_attribute::depth);
+            REQUIRE(pipeline.add_attribute(filter_pipeline_attribute::area) == area_index);
+            pipeline.remove_if(area_index, filter_pipeline_comparison::less, 20)
+                    .remove_if(volume_index, filter_pipeline_comparison::less_equal, 50)
+                    .remove_if(depth_index, filter_pipeline_comparison::greater, 10);
+            auto res = pipeline.execute(graph, vertex_weights);
+            REQUIRE((res == expected));
+
+            // the pipeline can be executed several times
+            auto res2 = pipeline.execute(graph, vertex_weights);
+            REQUIRE((res2 == expected));
+        }
+    }
+
+    TEST_CASE("connected filter pipeline predicate", "[connected_filter_pipeline]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_implicit_graph({23, 17});
+        array_1d<double> vertex_weights = xt::random::randint<int>({23 * 17}, 0, 30);
+
+        auto ref_tree = component_tree_max_tree(graph, vertex_weights);
+        array_1d<double> area = attribute_area(ref_tree.tree);
+        auto mean = accumulate_sequential(ref_tree.tree, vertex_weights, accumulator_mean());
+        array_1d<bool> deleted = (area < 10) && (mean > 15);
+        auto expected = reconstruct_leaf_data(ref_tree.tree, ref_tree.altitudes, deleted);
+
+        connected_filter_pipeline pipeline;
+        auto area_index = pipeline.add_attribute(filter_pipeline_attribute::area);
+        auto mean_index = pipeline.add_attribute(filter_pipeline_attribute::mean_vertex_weights);
+        pipeline.set_predicate([area_index, mean_index](index_t n, const filter_pipeline_attribute_values &values) {
+            return values(area_index, n) < 10 && values(mean_index, n) > 15;
+        });
+        auto res = pipeline.execute(graph, vertex_weights);
+        REQUIRE(xt::allclose(res, expected));
+    }
+}
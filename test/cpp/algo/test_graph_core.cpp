@@ -12,6 +12,7 @@
 #include "higra/algo/graph_core.hpp"
 #include "higra/utils.hpp"
 #include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
 #include <set>
 
 using namespace hg;
@@ -28,6 +29,50 @@ namespace test_graph_core {
         REQUIRE(is_in_bijection(labels, ref_labels));
     }
 
+    TEST_CASE("graph cut 2 labelisation label order", "[graph_algorithm]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        array_1d<char> edge_weights = {1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0};
+
+        auto labels = graph_cut_2_labelisation(graph, edge_weights);
+
+        array_1d<index_t> ref_labels = {1, 2, 2, 1, 1, 3, 1, 3, 3};
+        REQUIRE((labels == ref_labels));
+    }
+
+    TEST_CASE("parallel connected components", "[graph_algorithm]") {
+        auto graph = get_4_adjacency_graph({150, 170});
+        auto num_v = num_vertices(graph);
+        xt::random::seed(42);
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 2);
+
+        // sequential traversal: components are numbered in the order of their vertex of smallest index
+        array_1d<index_t> ref_labels = xt::zeros<index_t>({num_v});
+        index_t num_labels = 0;
+        std::vector<index_t> stack;
+        for (index_t v = 0; v < (index_t) num_v; v++) {
+            if (ref_labels(v) == 0) {
+                ref_labels(v) = ++num_labels;
+                stack.push_back(v);
+                while (!stack.empty()) {
+                    auto cv = stack.back();
+                    stack.pop_back();
+                    for (auto e: out_edge_iterator(cv, graph)) {
+                        auto n = target(e, graph);
+                        if (edge_weights(e) == 1 && ref_labels(n) == 0) {
+                            ref_labels(n) = num_labels;
+                            stack.push_back(n);
+                        }
+                    }
+                }
+            }
+        }
+
+        auto labels = parallel_connected_components(graph, [&edge_weights](const auto &e) {
+            return edge_weights(e) == 1;
+        });
+        REQUIRE((labels == ref_labels));
+    }
+
     TEST_CASE("labelisation 2 graph cut", "[graph_algorithm]") {
         auto graph = get_4_adjacency_graph({3, 3});
         array_1d<index_t> labels = {1, 2, 2, 1, 1, 3, 1, 3, 3};
@@ -39,6 +84,38 @@ namespace test_graph_core {
         REQUIRE(is_in_bijection(edge_weights, ref_edge_weights));
     }
 
+    TEST_CASE("labelisation 2 graph cut 4 adjacency grid graph", "[graph_algorithm]") {
+        auto graph = get_4_adjacency_graph({37, 45});
+        auto grid_graph = get_4_adjacency_grid_graph({37, 45});
+        xt::random::seed(42);
+        array_1d<index_t> labels = xt::random::randint<index_t>({num_vertices(graph)}, 0, 4);
+
+        auto ref_edge_weights = labelisation_2_graph_cut(graph, labels);
+        auto edge_weights = labelisation_2_graph_cut(grid_graph, labels);
+        REQUIRE((edge_weights == ref_edge_weights));
+
+        auto labels2 = graph_cut_2_labelisation(graph, edge_weights);
+        REQUIRE((labelisation_2_graph_cut(graph, labels2) == ref_edge_weights));
+    }
+
+    TEST_CASE("graph cut 2 labelisation large graph", "[graph_algorithm]") {
+        // several blocks of the parallel prefix sum
+        auto graph = get_4_adjacency_graph({300, 400});
+        xt::random::seed(42);
+        array_1d<index_t> ref_labels = xt::random::randint<index_t>({num_vertices(graph)}, 0, 3);
+        auto edge_weights = labelisation_2_graph_cut(graph, ref_labels);
+
+        auto labels = graph_cut_2_labelisation(graph, edge_weights);
+        REQUIRE(labels(0) == 1);
+        REQUIRE((labelisation_2_graph_cut(graph, labels) == edge_weights));
+        // labels are numbered in the order of the first vertex of each component
+        index_t max_label = 0;
+        for (index_t v = 0; v < (index_t) labels.size(); v++) {
+            REQUIRE(labels(v) <= max_label + 1);
+            max_label = (std::max)(max_label, labels(v));
+        }
+    }
+
     TEST_CASE("minimum spanning tree", "[graph_algorithm]") {
         auto graph = get_4_adjacency_graph({2, 3});
 
@@ -223,4 +300,48 @@ namespace test_graph_core {
             REQUIRE(res == ref[v]);
         }
     }
+
+    TEST_CASE("line_graph random graph", "[graph_algorithm]") {
+        const index_t num_v = 200;
+        const index_t num_e = 1000;
+        xt::random::seed(7);
+        array_1d<index_t> sources = xt::random::randint<index_t>({num_e}, 0, num_v);
+        array_1d<index_t> targets = xt::random::randint<index_t>({num_e}, 0, num_v);
+        ugraph graph(num_v, sources, targets);
+
+        auto linegraph = line_graph(graph);
+        REQUIRE(num_vertices(linegraph) == num_e);
+
+        // serial reference, edges are expected in the same order
+        std::vector<std::pair<index_t, index_t>> ref;
+        for (auto v: vertex_iterator(graph)) {
+            auto it = graph.out_edges_cbegin(v);
+            index_t n_out = out_degree(v, graph);
+            for (index_t i = 0; i < n_out; ++i) {
+                auto &e1 = edge_from_index(it[i], graph);
+                for (index_t j = i + 1; j < n_out; ++j) {
+                    auto &e2 = edge_from_index(it[j], graph);
+                    if (!(e1.source == e2.source && e1.source < v)) {
+                        ref.emplace_back(std::min(e1.index, e2.index), std::max(e1.index, e2.index));
+                    }
+                }
+            }
+        }
+        REQUIRE(num_edges(linegraph) == ref.size());
+        for (index_t i = 0; i < (index_t) ref.size(); i++) {
+            auto e = edge_from_index(i, linegraph);
+            REQUIRE(e.source == ref[i].first);
+            REQUIRE(e.target == ref[i].second);
+        }
+
+        array_1d<index_t> edge_indices = xt::random::randint<index_t>({300}, 0, num_e);
+        auto subgraph = subgraph_spanning(graph, edge_indices);
+        REQUIRE(num_edges(subgraph) == edge_indices.size());
+        for (index_t i = 0; i < (index_t) edge_indices.size(); i++) {
+            auto e = edge_from_index(i, subgraph);
+            auto eref = edge_from_index(edge_indices(i), graph);
+            REQUIRE(e.source == eref.source);
+            REQUIRE(e.target == eref.target);
+        }
+    }
 }
@@ -10,6 +10,7 @@
 
 #include "higra/image/graph_image.hpp"
 #include "higra/algo/graph_weights.hpp"
+#include "xtensor/xrandom.hpp"
 #include "../test_utils.hpp"
 
 
@@ -99,4 +100,180 @@ namespace test_graph_weights {
         auto r8 = weight_graph(g, data2, hg::weight_functions::L0);
         REQUIRE(xt::allclose(ref8, r8));
     }
+
+    template<typename result_t, typename promoted_t, typename T>
+    void check_grid_graph_weighting(const T &data, const std::vector<hg::weight_functions> &functions) {
+        auto g = get_4_adjacency_grid_graph({7, 5});
+        auto ug = get_4_adjacency_graph({7, 5});
+        for (auto f: functions) {
+            auto res = weight_graph<result_t, promoted_t>(g, data, f);
+            auto ref = weight_graph<result_t, promoted_t>(ug, data, f);
+            REQUIRE((res == ref));
+        }
+    }
+
+    TEST_CASE("grid graph edge weighting", "[graph_weights]") {
+        xt::random::seed(42);
+        std::vector<hg::weight_functions> all_functions{
+                hg::weight_functions::mean, hg::weight_functions::min, hg::weight_functions::max,
+                hg::weight_functions::L0, hg::weight_functions::L1, hg::weight_functions::L2,
+                hg::weight_functions::L_infinity, hg::weight_functions::L2_squared,
+                hg::weight_functions::source, hg::weight_functions::target};
+        std::vector<hg::weight_functions> vectorial_functions{
+                hg::weight_functions::L0, hg::weight_functions::L1, hg::weight_functions::L2,
+                hg::weight_functions::L_infinity, hg::weight_functions::L2_squared,
+                hg::weight_functions::cosine, hg::weight_functions::chi_square};
+
+        array_1d<double> data_d = xt::random::rand<double>({35});
+        data_d(3) = data_d(4);
+        check_grid_graph_weighting<double, double>(data_d, all_functions);
+
+        array_1d<float> data_f = xt::random::rand<float>({35});
+        check_grid_graph_weighting<float, float>(data_f, all_functions);
+        check_grid_graph_weighting<double, double>(data_f, all_functions);
+
+        array_1d<int> data_i = xt::random::randint<int>({35}, 0, 5);
+        check_grid_graph_weighting<double, double>(data_i, all_functions);
+        check_grid_graph_weighting<int, int>(data_i, all_functions);
+
+        array_2d<double> data_2d = xt::random::randint<int>({35, 3}, 0, 3);
+        check_grid_graph_weighting<double, double>(data_2d, vectorial_functions);
+
+        array_3d<float> data_3d = xt::random::rand<float>({35, 2, 3});
+        check_grid_graph_weighting<float, float>(data_3d, vectorial_functions);
+
+        // non contiguous weights
+        array_2d<double> data_t = xt::random::rand<double>({3, 35});
+        check_grid_graph_weighting<double, double>(xt::transpose(data_t), vectorial_functions);
+        check_grid_graph_weighting<double, double>(xt::view(data_t, 1, xt::all()), all_functions);
+
+        auto g1 = get_4_adjacency_grid_graph({1, 1});
+        REQUIRE(weight_graph(g1, array_1d<double>{1}, hg::weight_functions::L1).size() == 0);
+        auto g2 = get_4_adjacency_grid_graph({4, 1});
+        auto r2 = weight_graph(g2, array_1d<double>{1, 3, 6, 10}, hg::weight_functions::L1);
+        REQUIRE((r2 == array_1d<double>{2, 3, 4}));
+    }
+
+    TEST_CASE("graph edge weighting channel widths", "[graph_weights]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({6, 5});
+        auto gg = get_4_adjacency_grid_graph({6, 5});
+        for (index_t channels: {1, 2, 3, 4, 5, 8, 16, 17}) {
+            REQUIRE(dispatch_fixed_width(channels, [](auto width) { return (index_t) width; }) == channels);
+            array_2d<double> data = xt::random::rand<double>({(size_t) 30, (size_t) channels});
+            array_1d<double> ref_L1 = array_1d<double>::from_shape({num_edges(g)});
+            array_1d<double> ref_L_infinity = array_1d<double>::from_shape({num_edges(g)});
+            for (auto e: edge_iterator(g)) {
+                double l1 = 0;
+                double linf = -1;
+                for (index_t k = 0; k < channels; k++) {
+                    double d = std::abs(data(source(e, g), k) - data(target(e, g), k));
+                    l1 += d;
+                    linf = (std::max)(linf, d);
+                }
+                ref_L1(index(e, g)) = l1;
+                ref_L_infinity(index(e, g)) = linf;
+            }
+            REQUIRE(xt::allclose(weight_graph(g, data, hg::weight_functions::L1), ref_L1));
+            REQUIRE(xt::allclose(weight_graph(gg, data, hg::weight_functions::L1), ref_L1));
+            REQUIRE((weight_graph(g, data, hg::weight_functions::L_infinity) == ref_L_infinity));
+            REQUIRE((weight_graph(gg, data, hg::weight_functions::L_infinity) == ref_L_infinity));
+        }
+    }
+
+    TEST_CASE("graph edge weighting cosine and chi square", "[graph_weights]") {
+        auto g = get_4_adjacency_graph({2, 2});
+
+        array_2d<double> data{{1, 0},
+                              {1, 1},
+                              {0, 0},
+                              {0, 2}};
+        // edges: (0, 1), (0, 2), (1, 3), (2, 3)
+        array_1d<double> ref_cosine{1 - 1 / std::sqrt(2), 1, 1 - 1 / std::sqrt(2), 1};
+        REQUIRE(xt::allclose(weight_graph(g, data, hg::weight_functions::cosine), ref_cosine));
+        array_1d<double> ref_chi_square{1, 1, 4.0 / 3, 2};
+        REQUIRE(xt::allclose(weight_graph(g, data, hg::weight_functions::chi_square), ref_chi_square));
+
+        array_2d<double> data_zero = xt::zeros<double>({4, 2});
+        REQUIRE((weight_graph(g, data_zero, hg::weight_functions::cosine) == array_1d<double>{0, 0, 0, 0}));
+        REQUIRE((weight_graph(g, data_zero, hg::weight_functions::chi_square) == array_1d<double>{0, 0, 0, 0}));
+
+        // long vectors to exercise the vectorized loops and their remainders
+        xt::random::seed(1);
+        auto g2 = get_4_adjacency_graph({4, 5});
+        array_2d<float> data2 = xt::random::rand<float>({20, 37});
+        auto r_cosine = weight_graph<float, float>(g2, data2, hg::weight_functions::cosine);
+        auto r_chi_square = weight_graph<float, float>(g2, data2, hg::weight_functions::chi_square);
+        auto sources = hg::sources(g2);
+        auto targets = hg::targets(g2);
+        for (index_t i = 0; i < (index_t) num_edges(g2); i++) {
+            auto a = xt::eval(xt::cast<double>(xt::row(data2, sources(i))));
+            auto b = xt::eval(xt::cast<double>(xt::row(data2, targets(i))));
+            double cos_ref = 1 - xt::sum(a * b)() / std::sqrt(xt::sum(a * a)() * xt::sum(b * b)());
+            double chi_ref = xt::sum((a - b) * (a - b) / (a + b))();
+            REQUIRE(std::abs(r_cosine(i) - cos_ref) < 1e-5);
+            REQUIRE(std::abs(r_chi_square(i) - chi_ref) < 1e-4);
+        }
+    }
+
+    TEST_CASE("graph edge weighting custom kernel", "[graph_weights]") {
+        auto g = get_4_adjacency_graph({2, 2});
+        array_2d<double> data{{0, 1},
+                              {2, 3},
+                              {4, 5},
+                              {6, 7}};
+
+        auto r1 = weight_graph_kernel(g, data, [](const double *a, const double *b, index_t n) {
+            double res = 0;
+            for (index_t k = 0; k < n; k++) {
+                res += std::abs(a[k] - b[k]);
+            }
+            return res;
+        });
+        REQUIRE((r1 == weight_graph(g, data, hg::weight_functions::L1)));
+
+        // non contiguous weights and result type
+        auto r2 = weight_graph_kernel<int>(g, xt::transpose(xt::eval(xt::transpose(data))),
+                                           [](const double *a, const double *b, index_t n) {
+                                               return a[n - 1] + b[n - 1];
+                                           });
+        static_assert(std::is_same<typename decltype(r2)::value_type, int>::value, "");
+        REQUIRE((r2 == array_1d<int>{4, 6, 10, 12}));
+
+        double offset = 10;
+        auto r3 = weight_graph_compiled_kernel(g, data,
+                                               [](const double *a, const double *b, index_t, void *user_data) {
+                                                   return a[0] * b[0] + *static_cast<double *>(user_data);
+                                               }, &offset);
+        REQUIRE((r3 == array_1d<double>{10, 10, 22, 34}));
+    }
+
+    TEST_CASE("exact weight functions", "[graph_weights]") {
+        REQUIRE(is_exact_weight_function<float>(hg::weight_functions::mean));
+        REQUIRE(is_exact_weight_function<uint8_t>(hg::weight_functions::max));
+        REQUIRE(is_exact_weight_function<int16_t>(hg::weight_functions::L0, 3));
+        REQUIRE(is_exact_weight_function<uint8_t>(hg::weight_functions::L1));
+        REQUIRE(is_exact_weight_function<uint8_t>(hg::weight_functions::L_infinity, 3));
+        REQUIRE(!is_exact_weight_function<uint8_t>(hg::weight_functions::L1, 3));
+        REQUIRE(!is_exact_weight_function<int8_t>(hg::weight_functions::L_infinity));
+        REQUIRE(!is_exact_weight_function<uint8_t>(hg::weight_functions::mean));
+        REQUIRE(!is_exact_weight_function<uint16_t>(hg::weight_functions::L2_squared));
+        REQUIRE(!is_exact_weight_function<int64_t>(hg::weight_functions::min));
+
+        auto g = get_4_adjacency_graph({5, 7});
+        auto gg = get_4_adjacency_grid_graph({5, 7});
+        array_1d<uint8_t> data = xt::random::randint<int>({35}, 0, 256);
+        array_2d<uint8_t> data_2d = xt::random::randint<int>({35, 3}, 0, 256);
+        for (auto f: {hg::weight_functions::min, hg::weight_functions::max, hg::weight_functions::L0,
+                      hg::weight_functions::L1, hg::weight_functions::L2, hg::weight_functions::L_infinity}) {
+            auto ref = weight_graph(g, data, f);
+            auto res = weight_graph<uint8_t>(g, data, f);
+            static_assert(std::is_same<typename decltype(res)::value_type, uint8_t>::value, "");
+            REQUIRE((ref == res));
+            REQUIRE((weight_graph<uint8_t>(gg, data, f) == res));
+        }
+        auto ref_2d = weight_graph(g, data_2d, hg::weight_functions::L_infinity);
+        REQUIRE((weight_graph<uint8_t>(g, data_2d, hg::weight_functions::L_infinity) == ref_2d));
+        REQUIRE((weight_graph<uint8_t>(gg, data_2d, hg::weight_functions::L_infinity) == ref_2d));
+    }
 }
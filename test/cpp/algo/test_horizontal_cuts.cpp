@@ -12,6 +12,10 @@
 #include "higra/graph.hpp"
 #include "higra/image/graph_image.hpp"
 #include "higra/algo/horizontal_cuts.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "xtensor/xrandom.hpp"
+#include <random>
 
 using namespace hg;
 namespace test_horizontal_cuts {
@@ -243,5 +247,57 @@ namespace test_horizontal_cuts {
         array_1d<int> ref_cut{0, 0, 0, 0, 0, 1, 0, 0, 1, 0};
         REQUIRE((cut == ref_cut));
     }
-}
 
+    TEST_CASE("horizontal cut navigator", "[horizontal_cuts]") {
+
+        hg::tree tree{
+                array_1d<index_t>{11, 11, 11, 12, 12, 16, 13, 13, 13, 14, 14, 17, 16, 15, 15, 18, 17, 18, 18}
+        };
+        array_1d<int> altitudes{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 3, 1, 2, 3};
+        auto hcn = make_horizontal_cut_navigator(tree, altitudes);
+
+        REQUIRE(hcn.cut_index() == 0);
+        REQUIRE((hcn.labelisation_leaves() == array_1d<index_t>(xt::ones<index_t>({11}) * 18)));
+
+        hcn.set_cut_from_num_regions(3);
+        REQUIRE(hcn.cut_index() == 1);
+        array_1d<index_t> ref_lbls{17, 17, 17, 17, 17, 17, 13, 13, 13, 14, 14};
+        REQUIRE((hcn.labelisation_leaves() == ref_lbls));
+        REQUIRE(hcn.label_leaf(7) == 13);
+
+        hcn.set_cut_from_altitude(0);
+        REQUIRE(hcn.cut_index() == 3);
+        array_1d<index_t> ref_lbls2{0, 1, 2, 3, 4, 5, 13, 13, 13, 9, 10};
+        REQUIRE((hcn.labelisation_leaves() == ref_lbls2));
+        REQUIRE(vectorSame(hcn.horizontal_cut().nodes, array_1d<index_t>{0, 1, 2, 3, 4, 5, 13, 9, 10}));
+
+        hcn.set_cut_index(0);
+        REQUIRE((hcn.labelisation_leaves() == array_1d<index_t>(xt::ones<index_t>({11}) * 18)));
+    }
+
+    TEST_CASE("horizontal cut navigator random moves", "[horizontal_cuts]") {
+        xt::random::seed(11);
+        auto graph = get_4_adjacency_graph({13, 9});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 15);
+        auto bpt = bpt_canonical(graph, edge_weights);
+        auto qfz = quasi_flat_zone_hierarchy(graph, edge_weights);
+        // the area minus one is increasing but not sorted with respect to the node indices
+        array_1d<index_t> area = attribute_area(qfz.tree) - 1;
+
+        auto check = [](const hg::tree &tree, const auto &altitudes) {
+            auto hce = make_horizontal_cut_explorer(tree, altitudes);
+            auto hcn = make_horizontal_cut_navigator(tree, altitudes);
+            std::mt19937 gen(3);
+            std::uniform_int_distribution<index_t> dist(0, hce.num_cuts() - 1);
+            for (index_t i = 0; i < 50; i++) {
+                index_t k = dist(gen);
+                hcn.set_cut_index(k);
+                REQUIRE(hcn.cut_index() == k);
+                REQUIRE((hcn.labelisation_leaves() == hce.horizontal_cut_from_index(k).labelisation_leaves(tree)));
+            }
+        };
+        check(bpt.tree, bpt.altitudes);
+        check(qfz.tree, qfz.altitudes);
+        check(qfz.tree, area);
+    }
+}
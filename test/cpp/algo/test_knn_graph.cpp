@@ -0,0 +1,96 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/algo/knn_graph.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace knn_graph {
+
+    using namespace hg;
+    using namespace std;
+
+    /**
+     * Proportion of the exact k nearest neighbours of the points found in the graph
+     */
+    template<typename T>
+    double knn_recall(const T &points, const ugraph &graph, index_t k) {
+        index_t num_points = points.shape()[0];
+        index_t found = 0;
+        for (index_t v = 0; v < num_points; v++) {
+            std::vector<std::pair<double, index_t>> distances;
+            for (index_t u = 0; u < num_points; u++) {
+                if (u != v) {
+                    distances.emplace_back(xt::sum(xt::square(xt::row(points, u) - xt::row(points, v)))(), u);
+                }
+            }
+            std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+            for (index_t i = 0; i < k; i++) {
+                for (auto u: adjacent_vertex_iterator(v, graph)) {
+                    if (u == distances[i].second) {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        return (double) found / (num_points * k);
+    }
+
+    TEST_CASE("approximate knn graph", "[knn_graph]") {
+        xt::random::seed(4);
+        array_2d<double> points = xt::random::rand<double>({600, 8});
+        index_t k = 10;
+        auto res = approximate_knn_graph(points, k);
+        auto &graph = res.first;
+        auto &edge_weights = res.second;
+
+        REQUIRE(num_vertices(graph) == 600);
+        REQUIRE(num_edges(graph) == edge_weights.size());
+        for (auto e: edge_iterator(graph)) {
+            REQUIRE(source(e, graph) != target(e, graph));
+            REQUIRE(std::abs(edge_weights(index(e, graph)) -
+                             std::sqrt(xt::sum(xt::square(xt::row(points, source(e, graph)) -
+                                                          xt::row(points, target(e, graph))))())) < 1e-12);
+        }
+        // symmetric graph without parallel edges: at least k neighbours per vertex
+        for (auto v: vertex_iterator(graph)) {
+            std::vector<index_t> neighbours;
+            for (auto u: adjacent_vertex_iterator(v, graph)) {
+                neighbours.push_back(u);
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            REQUIRE(std::unique(neighbours.begin(), neighbours.end()) == neighbours.end());
+            REQUIRE((index_t) neighbours.size() >= k);
+        }
+        REQUIRE(knn_recall(points, graph, k) > 0.95);
+    }
+
+    TEST_CASE("approximate knn graph small and integral inputs", "[knn_graph]") {
+        array_2d<int> points{{0, 0},
+                             {1, 0},
+                             {5, 5},
+                             {6, 5}};
+        auto res = approximate_knn_graph(points, 1);
+        REQUIRE(num_edges(res.first) == 2);
+        REQUIRE((res.second == array_1d<double>{1, 1}));
+        REQUIRE(source(edge_from_index(0, res.first), res.first) == 0);
+        REQUIRE(target(edge_from_index(0, res.first), res.first) == 1);
+
+        // k is limited to the number of points minus 1: complete graph
+        auto res2 = approximate_knn_graph(xt::transpose(array_2d<float>{{0, 1, 3}}), 5);
+        REQUIRE(num_edges(res2.first) == 3);
+        REQUIRE((res2.second == array_1d<float>{1, 3, 2}));
+
+        auto res3 = approximate_knn_graph(array_2d<double>::from_shape({1, 3}), 5);
+        REQUIRE(num_vertices(res3.first) == 1);
+        REQUIRE(num_edges(res3.first) == 0);
+    }
+}
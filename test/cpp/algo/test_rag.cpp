@@ -11,6 +11,7 @@
 #include "../test_utils.hpp"
 #include "higra/algo/rag.hpp"
 #include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 
@@ -140,6 +141,90 @@ namespace test_rag {
 
     }
 
+    TEST_CASE("rag parallel", "[rag]") {
+        auto same_rag = [](const region_adjacency_graph &r1, const region_adjacency_graph &r2) {
+            REQUIRE(num_vertices(r1.rag) == num_vertices(r2.rag));
+            REQUIRE(num_edges(r1.rag) == num_edges(r2.rag));
+            for (index_t i = 0; i < (index_t) num_edges(r1.rag); i++) {
+                REQUIRE(edge_from_index(i, r1.rag) == edge_from_index(i, r2.rag));
+            }
+            REQUIRE((r1.vertex_map == r2.vertex_map));
+            REQUIRE((r1.edge_map == r2.edge_map));
+        };
+
+        auto g = hg::get_4_adjacency_graph({4, 4});
+        array_1d<int> vertex_labels{1, 1, 5, 5,
+                                    1, 1, 5, 5,
+                                    1, 1, 3, 3,
+                                    1, 1, 10, 10};
+        same_rag(make_region_adjacency_graph_from_labelisation(execution::par, g, vertex_labels),
+                 make_region_adjacency_graph_from_labelisation(g, vertex_labels));
+
+        xt::random::seed(5);
+        auto g2 = hg::get_8_adjacency_graph({23, 17});
+        for (int max_label: {2, 5, 1000}) {
+            array_1d<int> labels = xt::random::randint<int>({num_vertices(g2)}, 0, max_label);
+            same_rag(make_region_adjacency_graph_from_labelisation(execution::par, g2, labels),
+                     make_region_adjacency_graph_from_labelisation(g2, labels));
+
+            // random cuts are generally not closed: they produce self loops in the rag
+            array_1d<int> cut = xt::equal(xt::random::randint<int>({num_edges(g2)}, 0, max_label), 0);
+            same_rag(make_region_adjacency_graph_from_graph_cut(execution::par, g2, cut),
+                     make_region_adjacency_graph_from_graph_cut(g2, cut));
+        }
+    }
+
+    TEST_CASE("rag with accumulation", "[rag]") {
+        xt::random::seed(8);
+        auto g = hg::get_4_adjacency_graph({19, 23});
+        array_1d<int> labels = xt::random::randint<int>({num_vertices(g)}, 0, 4);
+        array_2d<double> vertex_weights = xt::random::rand<double>({num_vertices(g), (size_t) 3});
+        array_1d<float> edge_weights = xt::random::rand<float>({num_edges(g)});
+
+        auto check = [&](const auto &res) {
+            auto &rag = res.rag;
+            REQUIRE(std::get<0>(res.vertex_values).shape()[0] == num_vertices(rag));
+            REQUIRE((std::get<0>(res.vertex_values) ==
+                     rag_accumulate(res.vertex_map, vertex_weights, accumulator_sum())));
+            REQUIRE((std::get<1>(res.vertex_values) ==
+                     rag_accumulate(res.vertex_map, vertex_weights, accumulator_counter())));
+            REQUIRE((std::get<2>(res.vertex_values) ==
+                     rag_accumulate(res.vertex_map, vertex_weights, accumulator_max())));
+            REQUIRE((std::get<0>(res.edge_values) ==
+                     rag_accumulate(res.edge_map, edge_weights, accumulator_min())));
+            REQUIRE((std::get<1>(res.edge_values) ==
+                     rag_accumulate(res.edge_map, edge_weights, accumulator_mean())));
+            REQUIRE((std::get<2>(res.edge_values) ==
+                     rag_accumulate(res.edge_map, edge_weights, accumulator_counter())));
+        };
+
+        auto res = make_region_adjacency_graph_from_labelisation(
+                g, labels,
+                vertex_weights, std::make_tuple(accumulator_sum(), accumulator_counter(), accumulator_max()),
+                edge_weights, std::make_tuple(accumulator_min(), accumulator_mean(), accumulator_counter()));
+        auto ref = make_region_adjacency_graph_from_labelisation(g, labels);
+        REQUIRE(num_edges(res.rag) == num_edges(ref.rag));
+        REQUIRE((res.vertex_map == ref.vertex_map));
+        REQUIRE((res.edge_map == ref.edge_map));
+        check(res);
+
+        // non closed cut: the rag contains self loops
+        array_1d<int> cut = xt::equal(xt::random::randint<int>({num_edges(g)}, 0, 3), 0);
+        auto res_cut = make_region_adjacency_graph_from_graph_cut(
+                g, cut,
+                vertex_weights, std::make_tuple(accumulator_sum(), accumulator_counter(), accumulator_max()),
+                edge_weights, std::make_tuple(accumulator_min(), accumulator_mean(), accumulator_counter()));
+        auto ref_cut = make_region_adjacency_graph_from_graph_cut(g, cut);
+        REQUIRE((res_cut.vertex_map == ref_cut.vertex_map));
+        REQUIRE((res_cut.edge_map == ref_cut.edge_map));
+        check(res_cut);
+
+        // no accumulator
+        auto res_empty = make_region_adjacency_graph_from_labelisation(g, labels, vertex_weights, std::make_tuple(),
+                                                                       edge_weights, std::make_tuple());
+        REQUIRE((res_empty.edge_map == ref.edge_map));
+    }
+
     TEST_CASE("rag back project vertex weights", "[rag]") {
 
         fixture d;
@@ -0,0 +1,113 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/algo/stochastic_watershed.hpp"
+#include "higra/image/graph_image.hpp"
+#include <random>
+
+using namespace hg;
+
+namespace test_stochastic_watershed {
+
+    TEST_CASE("batched seeded watershed", "[stochastic_watershed]") {
+        auto g = get_4_adjacency_graph({13, 17});
+        std::mt19937 gen(3);
+        // few distinct weights to test tie breaking
+        std::uniform_int_distribution<int> weight_dist(0, 5);
+        std::uniform_int_distribution<index_t> vertex_dist(0, num_vertices(g) - 1);
+        array_1d<int> edge_weights = array_1d<int>::from_shape({num_edges(g)});
+        for (auto &w: edge_weights) {
+            w = weight_dist(gen);
+        }
+
+        batched_seeded_watershed ws(g, edge_weights);
+        REQUIRE(ws.num_vertices() == (index_t) num_vertices(g));
+
+        const index_t num_sets = 40;
+        array_2d<int> seeds = xt::zeros<int>({(size_t) num_sets, num_vertices(g)});
+        for (index_t i = 0; i < num_sets; i++) {
+            for (int s = 1; s <= 1 + i % 7; s++) {
+                seeds(i, vertex_dist(gen)) = s;
+            }
+        }
+
+        auto labels = ws.labelisations(seeds);
+        REQUIRE(labels.shape()[0] == (size_t) num_sets);
+        for (index_t i = 0; i < num_sets; i++) {
+            array_1d<int> seeds_i = xt::view(seeds, i, xt::all());
+            auto ref = labelisation_seeded_watershed(g, edge_weights, seeds_i);
+            REQUIRE((xt::view(labels, i, xt::all()) == ref));
+            REQUIRE((ws.labelisation(seeds_i) == ref));
+        }
+
+        // other background label
+        array_1d<int> seeds2 = -1 * xt::ones<int>({num_vertices(g)});
+        seeds2(0) = 0;
+        seeds2(100) = 4;
+        REQUIRE((ws.labelisation(seeds2, -1) == labelisation_seeded_watershed(g, edge_weights, seeds2, -1)));
+    }
+
+    TEST_CASE("exact stochastic watershed", "[stochastic_watershed]") {
+        auto g = get_4_adjacency_graph({2, 3});
+        array_1d<double> edge_weights{1, 4, 2, 3, 5, 1, 2};
+        array_1d<double> vertex_weights{1, 2, 1, 3, 1, 2};
+        const index_t num_v = num_vertices(g);
+        const double total_weight = xt::sum(vertex_weights)();
+
+        for (index_t num_seeds = 1; num_seeds <= 3; num_seeds++) {
+            // brute force: enumerate all the placements of the seeds
+            array_1d<double> reference = xt::zeros<double>({num_edges(g)});
+            std::vector<index_t> placement(num_seeds, 0);
+            while (true) {
+                double probability = 1;
+                array_1d<int> seeds = xt::zeros<int>({(size_t) num_v});
+                for (index_t s = 0; s < num_seeds; s++) {
+                    probability *= vertex_weights(placement[s]) / total_weight;
+                    seeds(placement[s]) = (int) s + 1;
+                }
+                auto labels = labelisation_seeded_watershed(g, edge_weights, seeds);
+                for (auto e: edge_iterator(g)) {
+                    if (labels(source(e, g)) != labels(target(e, g))) {
+                        reference(index(e, g)) += probability;
+                    }
+                }
+                index_t s = 0;
+                while (s < num_seeds && ++placement[s] == num_v) {
+                    placement[s++] = 0;
+                }
+                if (s == num_seeds) {
+                    break;
+                }
+            }
+
+            batched_seeded_watershed ws(g, edge_weights);
+            auto node_probabilities = ws.boundary_probabilities((double) num_seeds, vertex_weights);
+            REQUIRE(xt::allclose(xt::view(node_probabilities, xt::range(0, num_v)), 0));
+            auto &mst_edge_map = ws.mst_edge_map();
+            for (index_t k = 0; k < (index_t) mst_edge_map.size(); k++) {
+                REQUIRE(node_probabilities(num_v + k) == Approx(reference(mst_edge_map(k))).margin(1e-12));
+            }
+
+            auto edge_probabilities = exact_stochastic_watershed(g, edge_weights, (double) num_seeds, vertex_weights);
+            for (index_t k = 0; k < (index_t) mst_edge_map.size(); k++) {
+                REQUIRE(edge_probabilities(mst_edge_map(k)) == Approx(reference(mst_edge_map(k))).margin(1e-12));
+            }
+            // lower bound on the other edges
+            REQUIRE(xt::all(edge_probabilities <= reference + 1e-12));
+        }
+
+        // a single seed never creates a boundary, uniform weights
+        auto p1 = exact_stochastic_watershed(g, edge_weights, 1);
+        REQUIRE(xt::allclose(p1, 0));
+        auto p0 = exact_stochastic_watershed(g, edge_weights, 0);
+        REQUIRE(xt::allclose(p0, 0));
+    }
+}
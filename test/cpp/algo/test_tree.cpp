@@ -11,8 +11,11 @@
 #include "../test_utils.hpp"
 #include "higra/graph.hpp"
 #include "higra/algo/tree.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
 #include "higra/structure/array.hpp"
 #include <xtensor/xindex_view.hpp>
+#include <xtensor/xrandom.hpp>
 
 using namespace hg;
 
@@ -48,6 +51,27 @@ namespace test_tree_algorithm {
                           {4, 5},
                           {7, 2}};
         REQUIRE(xt::allclose(ref, output));
+
+        auto output_par = reconstruct_leaf_data(execution::par, tree, input, condition);
+        REQUIRE((output_par == output));
+
+        array_1d<int> input1 = xt::view(input, xt::all(), 0);
+        REQUIRE((reconstruct_leaf_data(execution::par, tree, input1, condition) ==
+                 reconstruct_leaf_data(tree, input1, condition)));
+    }
+
+    TEST_CASE("tree reconstruct leaf data parallel random", "[tree_algorithm]") {
+        auto g = get_4_adjacency_graph({31, 27});
+        xt::random::seed(11);
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        auto bpt = bpt_canonical(g, edge_weights);
+        auto &tree = bpt.tree;
+        for (auto p: {0.1, 0.5, 0.9, 1.0}) {
+            array_1d<bool> deleted = xt::random::rand<double>({num_vertices(tree)}) < p;
+            xt::xtensor<float, 3> input = xt::random::rand<float>({num_vertices(tree), (size_t) 2, (size_t) 3});
+            REQUIRE((reconstruct_leaf_data(execution::par, tree, input, deleted) ==
+                     reconstruct_leaf_data(tree, input, deleted)));
+        }
     }
 
     TEST_CASE("tree labelisation horizontal cut", "[tree_algorithm]") {
@@ -68,6 +92,34 @@ namespace test_tree_algorithm {
         REQUIRE(is_in_bijection(ref_t2, output_t2));
     }
 
+    TEST_CASE("tree labelisation horizontal cuts batch", "[tree_algorithm]") {
+
+        auto tree = data.t;
+        array_1d<double> altitudes{0, 0, 0, 0, 0, 1, 0, 2};
+        array_1d<double> thresholds{-1, 0, 0.5, 1, 2, 3};
+        auto output = labelisation_horizontal_cuts_from_thresholds(tree, altitudes, thresholds);
+        REQUIRE(output.shape()[0] == 6);
+        REQUIRE(output.shape()[1] == 5);
+        for (index_t i = 0; i < (index_t) thresholds.size(); i++) {
+            auto ref = labelisation_horizontal_cut_from_threshold(tree, altitudes, thresholds(i));
+            REQUIRE((xt::view(output, i, xt::all()) == ref));
+        }
+
+        auto g = get_4_adjacency_graph({15, 11});
+        xt::random::seed(3);
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 30);
+        auto qfz = quasi_flat_zone_hierarchy(g, edge_weights);
+        array_1d<int> thresholds2 = xt::arange<int>(-1, 32, 2);
+        auto output2 = labelisation_horizontal_cuts_from_thresholds(qfz.tree, qfz.altitudes, thresholds2);
+        for (index_t i = 0; i < (index_t) thresholds2.size(); i++) {
+            auto ref = labelisation_horizontal_cut_from_threshold(qfz.tree, qfz.altitudes, thresholds2(i));
+            REQUIRE((xt::view(output2, i, xt::all()) == ref));
+        }
+
+        array_1d<int> unsorted{2, 1};
+        REQUIRE_THROWS(labelisation_horizontal_cuts_from_thresholds(qfz.tree, qfz.altitudes, unsorted));
+    }
+
     TEST_CASE("tree labelisation supervertices", "[tree_algorithm]") {
 
         auto tree = data.t;
@@ -100,6 +152,31 @@ namespace test_tree_algorithm {
         array_1d<index_t> node_map_ref{9, 12, 6, 11, 13, 14, 15};
         REQUIRE((node_map_ref == node_map_res));
 
+        auto res_par = supervertices_hierarchy(execution::par, t, altitudes);
+        REQUIRE((res_par.tree.parents() == tree_res.parents()));
+        REQUIRE((res_par.supervertex_labelisation == supervertex_labelisation_res));
+        REQUIRE((res_par.node_map == node_map_res));
+    }
+
+    TEST_CASE("tree supervertices parallel random", "[tree_algorithm]") {
+        auto g = get_4_adjacency_graph({23, 29});
+        xt::random::seed(13);
+        auto check = [](const tree &tree, const array_1d<int> &altitudes) {
+            REQUIRE((labelisation_hierarchy_supervertices(execution::par, tree, altitudes) ==
+                     labelisation_hierarchy_supervertices(tree, altitudes)));
+            auto res = supervertices_hierarchy(tree, altitudes);
+            auto res_par = supervertices_hierarchy(execution::par, tree, altitudes);
+            REQUIRE((res_par.tree.parents() == res.tree.parents()));
+            REQUIRE((res_par.supervertex_labelisation == res.supervertex_labelisation));
+            REQUIRE((res_par.node_map == res.node_map));
+        };
+        for (int max_weight: {2, 5, 50}) {
+            array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, max_weight);
+            auto qfz = quasi_flat_zone_hierarchy(g, edge_weights);
+            check(qfz.tree, qfz.altitudes);
+            auto bpt = bpt_canonical(g, edge_weights);
+            check(bpt.tree, bpt.altitudes);
+        }
     }
 
     TEST_CASE("tree test isomorphism", "[tree_algorithm]") {
@@ -138,6 +215,139 @@ namespace test_tree_algorithm {
         REQUIRE((labelisation == ref_labelisation));
     }
 
+    TEST_CASE("tree binary labelisation packed", "[tree_algorithm]") {
+
+        tree t(array_1d<index_t>{9, 9, 9, 10, 10, 12, 13, 11, 11, 14, 12, 15, 13, 14, 15, 15});
+        array_1d<char> object_marker{0, 1, 0, 1, 0, 0, 0, 0, 0};
+        array_1d<char> background_marker{1, 0, 0, 0, 0, 0, 1, 0, 0};
+
+        auto packed = binary_labelisation_from_markers_packed(t, object_marker, background_marker);
+        array_1d<uint8_t> ref_packed{58, 0};
+        REQUIRE((packed == ref_packed));
+
+        array_1d<char> ref_labelisation{0, 1, 0, 1, 1, 1, 0, 0, 0};
+        REQUIRE((unpack_binary_labelisation(packed, 9) == ref_labelisation));
+
+        xt::random::seed(5);
+        array_1d<int> labels = xt::random::randint<int>({1001}, 0, 2);
+        auto packed2 = pack_binary_labelisation(labels);
+        REQUIRE(packed2.size() == 126);
+        REQUIRE((unpack_binary_labelisation(packed2, 1001) == labels));
+        REQUIRE_THROWS(unpack_binary_labelisation(packed2, 1009));
+    }
+
+    TEST_CASE("tree incremental binary labelisation", "[tree_algorithm]") {
+
+        tree t(array_1d<index_t>{9, 9, 9, 10, 10, 12, 13, 11, 11, 14, 12, 15, 13, 14, 15, 15});
+        incremental_binary_labelisation labelisation(t);
+        labelisation.add_object_markers(array_1d<index_t>{1, 3});
+        labelisation.add_background_markers(array_1d<index_t>{0, 6});
+
+        REQUIRE((labelisation.object_nodes() == array_1d<index_t>{1, 12}));
+        REQUIRE((labelisation.labelisation() == array_1d<char>{0, 1, 0, 1, 1, 1, 0, 0, 0}));
+
+        labelisation.remove_background_marker(6);
+        REQUIRE((labelisation.object_nodes() == array_1d<index_t>{1, 13}));
+        REQUIRE((labelisation.labelisation() == array_1d<char>{0, 1, 0, 1, 1, 1, 1, 0, 0}));
+
+        labelisation.add_background_marker(3);
+        labelisation.remove_object_marker(1);
+        REQUIRE(labelisation.object_nodes().size() == 0);
+        REQUIRE(labelisation.num_object_markers() == 1);
+        REQUIRE(labelisation.num_background_markers() == 2);
+
+        REQUIRE((binary_labelisation_from_marker_leaves(t, array_1d<index_t>{1, 3}, array_1d<index_t>{0, 6}) ==
+                 array_1d<char>{0, 1, 0, 1, 1, 1, 0, 0, 0}));
+    }
+
+    TEST_CASE("tree incremental binary labelisation random", "[tree_algorithm]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({15, 20});
+        array_1d<int> weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+        auto bpt = bpt_canonical(graph, weights);
+        auto &altitudes = bpt.altitudes;
+        auto &parents = bpt.tree.parents();
+        // non binary tree: merge the nodes with the same altitude as their parent
+        auto t = simplify_tree(bpt.tree, [&altitudes, &parents](index_t i) {
+            return altitudes(i) == altitudes(parents(i));
+        }).tree;
+        const index_t n = num_leaves(t);
+
+        incremental_binary_labelisation labelisation(t);
+        array_1d<char> object_marker = xt::zeros<char>({n});
+        array_1d<char> background_marker = xt::zeros<char>({n});
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<index_t> random_leaf(0, n - 1);
+        std::uniform_int_distribution<int> random_action(0, 3);
+        for (index_t i = 0; i < 300; i++) {
+            index_t l = random_leaf(rng);
+            switch (random_action(rng)) {
+                case 0:
+                    labelisation.add_object_marker(l);
+                    object_marker(l) = 1;
+                    break;
+                case 1:
+                    labelisation.remove_object_marker(l);
+                    object_marker(l) = 0;
+                    break;
+                case 2:
+                    labelisation.add_background_marker(l);
+                    background_marker(l) = 1;
+                    break;
+                default:
+                    labelisation.remove_background_marker(l);
+                    background_marker(l) = 0;
+            }
+            if (i % 10 == 0) {
+                REQUIRE((labelisation.labelisation() ==
+                         binary_labelisation_from_markers(t, object_marker, background_marker)));
+            }
+        }
+        REQUIRE(labelisation.num_object_markers() == xt::sum(object_marker)());
+        REQUIRE(labelisation.num_background_markers() == xt::sum(background_marker)());
+    }
+
+    TEST_CASE("tree cut stack", "[tree_algorithm]") {
+
+        auto tree = data.t;
+        array_1d<double> altitudes{0, 0, 0, 0, 0, 1, 0, 2};
+        array_1d<double> thresholds{-1, 0, 0.5, 1, 2, 3};
+        auto labelisations = labelisation_horizontal_cuts_from_thresholds(tree, altitudes, thresholds);
+
+        auto stack = encode_cut_stack(tree, labelisations);
+        REQUIRE(stack.num_cuts() == 6);
+        array_1d<index_t> ref_offsets{0, 5, 8, 11, 13, 14, 15};
+        array_1d<index_t> ref_nodes{0, 1, 2, 3, 4, 0, 1, 6, 0, 1, 6, 5, 6, 7, 7};
+        REQUIRE((stack.offsets == ref_offsets));
+        REQUIRE((stack.nodes == ref_nodes));
+
+        auto stack2 = cut_stack_from_thresholds(tree, altitudes, thresholds);
+        REQUIRE((stack2.offsets == ref_offsets));
+        REQUIRE((stack2.nodes == ref_nodes));
+
+        array_1d<double> node_values{1, 2, 3, 4, 5, 6, 7, 8};
+        for (index_t i = 0; i < stack.num_cuts(); i++) {
+            REQUIRE((labelisation_from_cut_nodes(tree, stack.cut_nodes(i)) == xt::view(labelisations, i, xt::all())));
+            array_1d<double> ref = xt::index_view(node_values, xt::view(labelisations, i, xt::all()));
+            REQUIRE((reconstruct_leaf_data_from_cut_nodes(tree, node_values, stack.cut_nodes(i)) == ref));
+        }
+
+        auto g = get_4_adjacency_graph({15, 11});
+        xt::random::seed(3);
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 30);
+        auto qfz = quasi_flat_zone_hierarchy(g, edge_weights);
+        array_1d<int> thresholds3 = xt::arange<int>(-1, 32, 2);
+        auto labelisations3 = labelisation_horizontal_cuts_from_thresholds(qfz.tree, qfz.altitudes, thresholds3);
+        auto stack3 = encode_cut_stack(qfz.tree, labelisations3);
+        auto stack4 = cut_stack_from_thresholds(qfz.tree, qfz.altitudes, thresholds3);
+        REQUIRE((stack3.offsets == stack4.offsets));
+        REQUIRE((stack3.nodes == stack4.nodes));
+        for (index_t i = 0; i < stack3.num_cuts(); i++) {
+            REQUIRE((labelisation_from_cut_nodes(qfz.tree, stack3.cut_nodes(i)) ==
+                     xt::view(labelisations3, i, xt::all())));
+        }
+    }
+
     TEST_CASE("tree sort hierarchy w.r.t. altitudes", "[tree_algorithm]") {
         tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14});
         array_1d<int> altitudes{0, 0, 0, 0, 0, 0, 0, 0, 3, 1, 2, 4, 6, 5, 7};
@@ -149,6 +359,73 @@ namespace test_tree_algorithm {
 
         array_1d<int> ref_altitudes{0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7};
         REQUIRE((ref_altitudes == xt::index_view(altitudes, res.node_map)));
+        REQUIRE(res.tree.layout() == tree_layout::altitude_sorted);
+
+        // already sorted
+        auto res2 = sort_hierarchy_with_altitudes(res.tree, ref_altitudes);
+        REQUIRE((ref_par == parents(res2.tree)));
+        REQUIRE((xt::arange<index_t>(num_vertices(t)) == res2.node_map));
+        REQUIRE(res2.tree.layout() == tree_layout::altitude_sorted);
+    }
+
+    TEST_CASE("sort hierarchy with altitudes sorted runs", "[tree_algorithm]") {
+        tree t(array_1d<index_t>{6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 10});
+        // two sorted runs
+        array_1d<double> altitudes{0, 0, 0, 0, 0, 0, 2, 1, 3, 4, 5};
+
+        auto res = sort_hierarchy_with_altitudes(t, altitudes);
+        array_1d<index_t> ref_node_map{0, 1, 2, 3, 4, 5, 7, 6, 8, 9, 10};
+        array_1d<index_t> ref_par{7, 7, 6, 6, 8, 8, 9, 9, 10, 10, 10};
+        REQUIRE((res.node_map == ref_node_map));
+        REQUIRE((parents(res.tree) == ref_par));
+        REQUIRE(res.tree.layout() == tree_layout::altitude_sorted);
+    }
+
+    TEST_CASE("relayout tree", "[tree_algorithm]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14});
+        REQUIRE(t.layout() == tree_layout::topological);
+
+        auto res = relayout_tree(t, tree_layout::post_order);
+        array_1d<index_t> ref_par{8, 8, 9, 9, 13, 12, 11, 11, 10, 10, 14, 12, 13, 14, 14};
+        array_1d<index_t> ref_node_map{0, 1, 2, 3, 7, 6, 4, 5, 8, 9, 12, 10, 11, 13, 14};
+        REQUIRE((ref_par == parents(res.tree)));
+        REQUIRE((ref_node_map == res.node_map));
+        REQUIRE(res.tree.layout() == tree_layout::post_order);
+
+        auto res2 = relayout_tree(res.tree, tree_layout::post_order);
+        REQUIRE((ref_par == parents(res2.tree)));
+        REQUIRE((xt::arange<index_t>(num_vertices(t)) == res2.node_map));
+
+        auto res3 = relayout_tree(t, tree_layout::topological);
+        REQUIRE((parents(t) == parents(res3.tree)));
+        REQUIRE((xt::arange<index_t>(num_vertices(t)) == res3.node_map));
+
+        array_1d<int> altitudes{0, 0, 0, 0, 0, 0, 0, 0, 3, 1, 2, 4, 5, 6, 7};
+        auto res4 = relayout_tree(t, tree_layout::altitude_sorted, altitudes);
+        REQUIRE(res4.tree.layout() == tree_layout::altitude_sorted);
+        REQUIRE(std::is_sorted(xt::index_view(altitudes, res4.node_map).cbegin(),
+                               xt::index_view(altitudes, res4.node_map).cend()));
+    }
+
+    TEST_CASE("tree traversal orders", "[tree_algorithm]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14});
+
+        array_1d<index_t> ref_preorder{14, 12, 8, 0, 1, 9, 2, 3, 13, 7, 11, 6, 10, 4, 5};
+        REQUIRE((tree_preorder(t) == ref_preorder));
+
+        array_1d<index_t> ref_postorder{0, 1, 8, 2, 3, 9, 12, 7, 6, 4, 5, 10, 11, 13, 14};
+        REQUIRE((tree_postorder(t) == ref_postorder));
+
+        auto levels = tree_depth_levels(t);
+        array_1d<index_t> ref_nodes{14, 12, 13, 7, 8, 9, 11, 0, 1, 2, 3, 6, 10, 4, 5};
+        array_1d<index_t> ref_offsets{0, 1, 3, 7, 13, 15};
+        REQUIRE((levels.nodes == ref_nodes));
+        REQUIRE((levels.offsets == ref_offsets));
+
+        tree t2(array_1d<index_t>{0});
+        REQUIRE((tree_preorder(t2) == array_1d<index_t>{0}));
+        REQUIRE((tree_postorder(t2) == array_1d<index_t>{0}));
+        REQUIRE((tree_depth_levels(t2).offsets == array_1d<index_t>{0, 1}));
     }
 
    TEST_CASE("sub tree", "[tree_sub_tree]") {
@@ -174,4 +451,49 @@ namespace test_tree_algorithm {
         REQUIRE((ref3_node_map == res3.node_map));
     }
 
+    TEST_CASE("sub trees", "[tree_sub_tree]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14});
+
+        array_1d<index_t> roots{13, 3, 14, 11, 13, 8};
+        auto res = sub_trees(t, roots);
+        REQUIRE(res.trees.size() == roots.size());
+        for (index_t i = 0; i < (index_t) roots.size(); i++) {
+            auto ref = sub_tree(t, roots(i));
+            REQUIRE((ref.tree.parents() == res.trees[i].parents()));
+            REQUIRE(num_leaves(ref.tree) == num_leaves(res.trees[i]));
+            REQUIRE((ref.node_map == res.node_map_of(i)));
+        }
+
+        array_1d<index_t> no_roots = xt::empty<index_t>({0});
+        auto res_empty = sub_trees(t, no_roots);
+        REQUIRE(res_empty.trees.empty());
+        REQUIRE(res_empty.node_map.size() == 0);
+    }
+
+    TEST_CASE("sub trees random", "[tree_sub_tree]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({15, 15});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 10));
+        auto h = bpt_canonical(g, w);
+        auto t = simplify_tree(h.tree, xt::equal(h.altitudes, xt::index_view(h.altitudes, parents(h.tree)))).tree;
+
+        array_1d<index_t> roots = xt::random::randint<index_t>({50}, 0, num_vertices(t));
+        auto res = sub_trees(t, roots);
+        for (index_t i = 0; i < (index_t) roots.size(); i++) {
+            auto ref = sub_tree(t, roots(i));
+            REQUIRE((ref.tree.parents() == res.trees[i].parents()));
+            REQUIRE((ref.node_map == res.node_map_of(i)));
+        }
+
+        auto t_post_order = relayout_tree(t, tree_layout::post_order).tree;
+        auto res_post_order = sub_trees(t_post_order, roots);
+        for (index_t i = 0; i < (index_t) roots.size(); i++) {
+            auto ref = sub_tree(t_post_order, roots(i));
+            REQUIRE((ref.tree.parents() == res_post_order.trees[i].parents()));
+            REQUIRE(num_leaves(ref.tree) == num_leaves(res_post_order.trees[i]));
+            REQUIRE((ref.node_map == res_post_order.node_map_of(i)));
+            REQUIRE(res_post_order.trees[i].layout() == tree_layout::post_order);
+        }
+    }
+
 }
\ No newline at end of file
@@ -11,7 +11,9 @@
 #include "../test_utils.hpp"
 #include <cmath>
 #include <sstream>
+#include <random>
 #include "higra/algo/tree_energy_optimization.hpp"
+#include "higra/attribute/tree_attribute.hpp"
 #include "higra/graph.hpp"
 #include "higra/image/graph_image.hpp"
 
@@ -181,6 +183,57 @@ namespace test_linear_energy_function_optimization {
         }
     }
 
+    TEST_CASE("test piecewise_linear_energy_function_arena", "[linear_energy_function_optimization]") {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> dist(0.1, 10);
+
+        // small initial capacity to exercise the growth of the arena
+        piecewise_linear_energy_function_arena<double> arena(2);
+        std::vector<lef_t> ref;
+        std::vector<index_t> slots;
+        auto add_leaf = [&]() {
+            lep_t p(0, dist(gen), dist(gen));
+            ref.emplace_back(p);
+            slots.push_back(arena.allocate());
+            arena.set(slots.back(), p);
+        };
+        for (index_t i = 0; i < 10; i++) {
+            add_leaf();
+        }
+
+        for (index_t k = 0; k < 300; k++) {
+            std::uniform_int_distribution<index_t> select(0, ref.size() - 1);
+            index_t i = select(gen);
+            index_t j = select(gen);
+            int max_pieces = 2 + k % 6;
+            lef_t r = ref[i].sum(ref[j], max_pieces);
+            // the result replaces the first function, the second one is released and replaced by a new leaf
+            arena.sum(slots[i], slots[i], slots[j], max_pieces);
+            ref[i] = r;
+            REQUIRE(arena.function(slots[i]) == ref[i]);
+
+            lep_t p(0, dist(gen) * 10, ref[i][ref[i].size() - 1].slope() * dist(gen) / 10);
+            REQUIRE(arena.infimum(slots[i], p) == ref[i].infimum(p));
+            REQUIRE(arena.function(slots[i]) == ref[i]);
+            REQUIRE(arena.size(slots[i]) == (index_t) ref[i].size());
+
+            double x = dist(gen);
+            index_t piece = ref[i].size() - 1;
+            while (ref[i][piece].origin_x() > x) {
+                piece--;
+            }
+            REQUIRE(arena(slots[i], x) == Approx(ref[i][piece](x)));
+
+            if (i != j) {
+                arena.release(slots[j]);
+                ref.erase(ref.begin() + j);
+                slots.erase(slots.begin() + j);
+                add_leaf();
+            }
+        }
+        REQUIRE(arena.capacity() >= 7);
+    }
+
     TEST_CASE("test labelisation_optimal_cut_from_energy", "[optimal_cut_tree]") {
         tree t(array_1d<index_t>{8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12});
         array_1d<double> energy_attribute{2, 1, 3, 2, 1, 1, 1, 2, 2, 4, 10, 5, 20};
@@ -191,6 +244,57 @@ namespace test_linear_energy_function_optimization {
         REQUIRE(is_in_bijection(res, ref));
     }
 
+    TEST_CASE("test labelisation_optimal_cut_from_energy multithreaded", "[optimal_cut_tree]") {
+        tree t(array_1d<index_t>{8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12});
+        array_1d<double> energy_attribute{2, 1, 3, 2, 1, 1, 1, 2, 2, 4, 10, 5, 20};
+
+        auto res = labelisation_optimal_cut_from_energy(execution::par, t, energy_attribute);
+        REQUIRE((res == labelisation_optimal_cut_from_energy(t, energy_attribute)));
+
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<double> dis(0, 1);
+        auto g = get_4_adjacency_graph({120, 110});
+        array_1d<double> edge_weights = array_1d<double>::from_shape({num_edges(g)});
+        for (auto &w: edge_weights) {
+            w = dis(gen);
+        }
+        auto tree = bpt_canonical(g, edge_weights).tree;
+        // node energies proportional to the node areas such that the optimal cut is neither the root nor the leaves
+        array_1d<double> energy = attribute_area(tree);
+        for (auto &e: energy) {
+            e *= 0.5 + dis(gen);
+        }
+
+        auto res_sum = labelisation_optimal_cut_from_energy(execution::par, tree, energy);
+        auto ref_sum = labelisation_optimal_cut_from_energy(tree, energy);
+        REQUIRE(xt::amax(ref_sum)() > 0);
+        REQUIRE(xt::amax(ref_sum)() < (index_t) num_leaves(tree) - 1);
+        REQUIRE((res_sum == ref_sum));
+
+        auto res_max = labelisation_optimal_cut_from_energy(execution::par, tree, energy, accumulator_max());
+        auto ref_max = labelisation_optimal_cut_from_energy(execution::seq, tree, energy, accumulator_max());
+        REQUIRE((res_max == ref_max));
+
+        // complete binary tree: shallow enough to be processed by levels
+        const index_t num_l = 1 << 15;
+        array_1d<index_t> balanced_parents = array_1d<index_t>::from_shape({(size_t) 2 * num_l - 1});
+        for (index_t i = 0; i < 2 * num_l - 2; i++) {
+            balanced_parents(i) = num_l + i / 2;
+        }
+        balanced_parents(2 * num_l - 2) = 2 * num_l - 2;
+        hg::tree balanced(balanced_parents);
+        array_1d<double> balanced_energy = attribute_area(balanced);
+        for (auto &e: balanced_energy) {
+            e *= 0.5 + dis(gen);
+        }
+
+        auto res_balanced = labelisation_optimal_cut_from_energy(execution::par, balanced, balanced_energy);
+        auto ref_balanced = labelisation_optimal_cut_from_energy(balanced, balanced_energy);
+        REQUIRE(xt::amax(ref_balanced)() > 0);
+        REQUIRE(xt::amax(ref_balanced)() < num_l - 1);
+        REQUIRE((res_balanced == ref_balanced));
+    }
+
     TEST_CASE("test hierarchy_to_optimal_energy_cut_hierarchy", "[optimal_cut_tree]") {
         tree t(array_1d<index_t>{8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12});
         array_1d<double> data_fidelity_attribute{1, 1, 1, 1, 1, 1, 1, 4, 5, 10, 15, 25, 45};
@@ -261,4 +365,38 @@ namespace test_linear_energy_function_optimization {
         REQUIRE(tree.parents() == ref_parents);
         REQUIRE(xt::allclose(altitudes, ref_altitudes));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("test MumfordShah initial edge weights", "[optimal_cut_tree]") {
+        // the closed form used for the initial edges must match the generic apparition scale computation
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> uniform(0, 10);
+        auto g = hg::get_4_adjacency_graph({30, 20});
+        const index_t num_bands = 13;
+        array_1d<double> edge_length = array_1d<double>::from_shape({num_edges(g)});
+        for (auto &v: edge_length) {
+            v = std::floor(uniform(generator) / 3) + 1;
+        }
+        array_1d<double> vertex_perimeter = array_1d<double>::from_shape({num_vertices(g)});
+        for (auto &v: vertex_perimeter) {
+            v = std::floor(uniform(generator)) + 8;
+        }
+        array_2d<double> vertex_values = array_2d<double>::from_shape({num_vertices(g), (size_t) num_bands});
+        for (auto &v: vertex_values) {
+            v = std::floor(uniform(generator));
+        }
+        // some pairs of adjacent vertices with identical values
+        for (index_t c = 0; c < num_bands; c++) {
+            vertex_values(1, c) = vertex_values(0, c);
+        }
+        array_2d<double> squared_vertex_values = vertex_values * vertex_values;
+        array_1d<double> vertex_area = xt::ones<double>({num_vertices(g)});
+
+        hg::tree_energy_optimization_internal::binary_partition_tree_MumfordShah_linkage_weighting_functor<true, ugraph>
+                wf(g, vertex_area, vertex_values, squared_vertex_values, vertex_perimeter, edge_length);
+        auto edge_weights = wf.weight_initial_edges();
+        for (auto e: edge_iterator(g)) {
+            double ref = wf.apparition_scale(source(e, g), target(e, g), edge_length(e));
+            REQUIRE(edge_weights(e) == Approx(ref));
+        }
+    }
+}
@@ -99,4 +99,21 @@ namespace test_tree_fusion {
         REQUIRE(xt::sum(diff - diff(0))() == 0);
     }
 
+
+    TEST_CASE("tree_fusion_depth_map duplicated trees", "[tree_fusion]") {
+        array_1d<int> p1{5, 5, 6, 6, 6, 7, 7, 7};
+        array_1d<int> p2{7, 7, 6, 5, 5, 6, 7, 7};
+
+        tree t1(p1);
+        tree t2(p2);
+
+        // the nodes of a duplicated tree have the same shapes as the nodes of the first copy
+        auto res1 = tree_fusion_depth_map(std::vector<tree *>{&t1, &t1});
+        array_1d<int> expected1{2, 2, 2, 2, 2};
+        REQUIRE((res1 == expected1));
+
+        auto res2 = tree_fusion_depth_map(std::vector<tree *>{&t1, &t2, &t1, &t2});
+        REQUIRE((res2 == tree_fusion_depth_map(std::vector<tree *>{&t1, &t2})));
+    }
+
 }
\ No newline at end of file
@@ -10,6 +10,9 @@
 
 #include "../test_utils.hpp"
 #include "higra/algo/tree_monotonic_regression.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
 
 
 using namespace hg;
@@ -72,4 +75,24 @@ namespace test_tree_monotonic_regression {
         auto res = tree_monotonic_regression(tree, altitudes, weights, "least_square");
         REQUIRE(xt::allclose(res, ref));
     }
+
+    TEST_CASE("tree_monotonic_regression least square random", "[tree_monotonic_regression]") {
+        xt::random::seed(5);
+        auto g = get_4_adjacency_graph({40, 50});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        auto tree = bpt_canonical(g, edge_weights).tree;
+        array_1d<double> altitudes = xt::random::rand<double>({num_vertices(tree)});
+        array_1d<double> weights = xt::random::rand<double>({num_vertices(tree)}) + 0.5;
+
+        auto res = tree_monotonic_regression(tree, altitudes, weights, "least_square");
+        // increasing on the tree
+        for (auto i: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+            REQUIRE(res(i) <= res(parent(i, tree)) + 1e-12);
+        }
+        // weighted means of the blocks: the weighted sum is preserved
+        REQUIRE(std::abs(xt::sum(weights * res)() - xt::sum(weights * altitudes)()) < 1e-8);
+        // monotone altitudes are not modified
+        auto res2 = tree_monotonic_regression(tree, res, weights, "least_square");
+        REQUIRE(xt::allclose(res2, res));
+    }
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "../test_utils.hpp"
 #include "higra/algo/watershed.hpp"
 #include "higra/image/graph_image.hpp"
+#include <random>
 
 using namespace hg;
 
@@ -45,6 +46,28 @@ namespace test_watershed {
         REQUIRE((labels == expected));
     }
 
+    TEST_CASE("watershed cut implicit grid graph", "[watershed_cut]") {
+        embedding_grid_2d embedding{4, 4};
+        array_1d<int> edge_weights{1, 2, 5, 5, 5, 8, 1, 4, 3, 4, 4, 1, 5, 2, 6, 3, 5, 4, 0, 7, 0, 3, 4, 0};
+        REQUIRE((labelisation_watershed(get_4_adjacency_grid_graph(embedding), edge_weights) ==
+                 labelisation_watershed(get_4_adjacency_graph(embedding), edge_weights)));
+
+        // large plateaus
+        std::mt19937 gen(3);
+        std::uniform_int_distribution<int> weight_dist(0, 3);
+        for (auto shape: {std::array<index_t, 2>{1, 17}, std::array<index_t, 2>{23, 1},
+                          std::array<index_t, 2>{31, 27}}) {
+            embedding_grid_2d e(shape);
+            auto graph = get_4_adjacency_graph(e);
+            array_1d<unsigned char> weights = array_1d<unsigned char>::from_shape({num_edges(graph)});
+            for (auto &w: weights) {
+                w = (unsigned char) weight_dist(gen);
+            }
+            REQUIRE((labelisation_watershed(get_4_adjacency_grid_graph(e), weights) ==
+                     labelisation_watershed(graph, weights)));
+        }
+    }
+
     TEST_CASE("seeded watersed 1", "[seeded_watersed_cut]") {
         auto g = hg::get_4_adjacency_graph({4, 4});
         array_1d<int> edge_weights{1, 2, 5, 5, 4, 8, 1, 4, 3, 4, 4, 1, 5, 2, 6, 2, 5, 2, 0, 7, 0, 3, 4, 0};
@@ -128,4 +151,82 @@ namespace test_watershed {
         REQUIRE((labels == expected));
     }
 
+
+    TEST_CASE("incremental seeded watershed", "[seeded_watersed_cut]") {
+        auto g = get_4_adjacency_graph({4, 4});
+        array_1d<int> edge_weights{1, 2, 5, 5, 5, 8, 1, 4, 3, 4, 4, 1, 5, 2, 6, 2, 5, 2, 8, 5, 1, 4, 3, 4};
+        array_1d<int> seeds{1, 1, 0, 0,
+                            1, 0, 0, 0,
+                            0, 0, 0, 0,
+                            0, 0, 0, 0};
+
+        auto ws = make_incremental_seeded_watershed(g, edge_weights, seeds);
+        REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds)));
+        REQUIRE((ws.labels() == array_1d<int>(xt::ones<int>({16}))));
+
+        seeds(15) = 2;
+        ws.set_seed(15, 2);
+        REQUIRE((ws.seeds() == seeds));
+        REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds)));
+
+        seeds(15) = 3;
+        ws.set_seed(15, 3);
+        REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds)));
+
+        seeds(0) = 0;
+        seeds(1) = 0;
+        seeds(4) = 0;
+        ws.update_seeds(seeds);
+        REQUIRE((ws.labels() == array_1d<int>(3 * xt::ones<int>({16}))));
+
+        seeds(15) = 0;
+        ws.set_seed(15, 0);
+        REQUIRE((ws.labels() == array_1d<int>(xt::zeros<int>({16}))));
+    }
+
+    TEST_CASE("incremental seeded watershed random", "[seeded_watersed_cut]") {
+        // two connected components: a 9x11 grid and a path
+        ugraph g(119);
+        auto grid = get_4_adjacency_graph({9, 11});
+        for (auto e: edge_iterator(grid)) {
+            add_edge(source(e, grid), target(e, grid), g);
+        }
+        for (index_t i = 99; i < 118; i++) {
+            add_edge(i, i + 1, g);
+        }
+
+        std::mt19937 gen(7);
+        // few distinct weights to test tie breaking
+        std::uniform_int_distribution<int> weight_dist(0, 5);
+        std::uniform_int_distribution<index_t> vertex_dist(0, num_vertices(g) - 1);
+        std::uniform_int_distribution<int> label_dist(-1, 4);
+        array_1d<int> edge_weights = array_1d<int>::from_shape({num_edges(g)});
+        for (auto &w: edge_weights) {
+            w = weight_dist(gen);
+        }
+
+        const int background = -1;
+        array_1d<int> seeds = background * xt::ones<int>({num_vertices(g)});
+        seeds(3) = 2;
+        auto ws = make_incremental_seeded_watershed(g, edge_weights, seeds, background);
+        REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds, background)));
+
+        for (index_t i = 0; i < 500; i++) {
+            index_t v = vertex_dist(gen);
+            // remove seeds more often once there are many of them
+            int label = (i % 3 == 0) ? background : label_dist(gen);
+            seeds(v) = label;
+            if (i % 10 == 0) {
+                seeds(vertex_dist(gen)) = label_dist(gen);
+                ws.update_seeds(seeds);
+            } else {
+                ws.set_seed(v, label);
+            }
+            REQUIRE((ws.seeds() == seeds));
+            REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds, background)));
+        }
+
+        ws.reset(seeds);
+        REQUIRE((ws.labels() == labelisation_seeded_watershed(g, edge_weights, seeds, background)));
+    }
 }
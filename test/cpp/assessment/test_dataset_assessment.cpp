@@ -0,0 +1,131 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/assessment/dataset_assessment.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace dataset_assessment {
+
+    using namespace hg;
+    using namespace std;
+
+    struct dataset {
+        vector<tree> trees;
+        vector<array_1d<double>> altitudes;
+        vector<array_2d<index_t>> ground_truths;
+    };
+
+    // hierarchies of random images of different sizes with 1 to 3 random ground truths
+    static dataset make_dataset(index_t num_samples) {
+        xt::random::seed(7);
+        dataset d;
+        for (index_t i = 0; i < num_samples; i++) {
+            const index_t h = 5 + i % 4, w = 6 + i % 3;
+            auto graph = get_4_adjacency_graph({h, w});
+            array_1d<double> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+            auto bpt = bpt_canonical(graph, edge_weights);
+            d.trees.push_back(std::move(bpt.tree));
+            d.altitudes.push_back(std::move(bpt.altitudes));
+            d.ground_truths.push_back(xt::random::randint<index_t>({(size_t) (1 + i % 3), (size_t) (h * w)}, 0, 4));
+        }
+        return d;
+    }
+
+    TEST_CASE("dataset assessment per sample results", "[dataset_assessment]") {
+        auto d = make_dataset(11);
+        const size_t max_regions = 30;
+        dataset_assesser assesser(partition_measure::BCE, max_regions, true);
+        assesser.add_samples(d.trees, d.altitudes, d.ground_truths, {}, 3);
+        REQUIRE(assesser.num_samples() == 11);
+
+        index_t k = 0;
+        array_1d<double> score_sums = xt::zeros<double>({max_regions});
+        for (index_t i = 0; i < 11; i++) {
+            for (index_t g = 0; g < (index_t) d.ground_truths[i].shape()[0]; g++) {
+                array_1d<index_t> ground_truth = xt::view(d.ground_truths[i], g, xt::all());
+                auto ref = assess_fragmentation_horizontal_cut(d.trees[i], d.altitudes[i], ground_truth,
+                                                               scorer_partition_BCE(), {}, max_regions);
+                REQUIRE(assesser.sample_indices()(k) == i);
+                REQUIRE(assesser.optimal_scores()(k) == Approx(ref.optimal_score()));
+                REQUIRE(assesser.optimal_numbers_of_regions()(k) == ref.optimal_number_of_regions());
+                REQUIRE(assesser.numbers_of_regions_ground_truth()(k) == ref.num_regions_ground_truth());
+                REQUIRE(assesser.purities()(k) == Approx(dendrogram_purity(d.trees[i], ground_truth)));
+                for (index_t r = 1; r <= (index_t) max_regions; r++) {
+                    index_t c = 0;
+                    while (c + 1 < (index_t) ref.num_regions().size() && ref.num_regions()(c + 1) <= r) {
+                        c++;
+                    }
+                    score_sums(r - 1) += ref.scores()(c);
+                }
+                k++;
+            }
+        }
+        REQUIRE(assesser.num_assessments() == k);
+        REQUIRE(assesser.mean_optimal_score() == Approx(xt::mean(assesser.optimal_scores())()));
+        REQUIRE(assesser.mean_purity() == Approx(xt::mean(assesser.purities())()));
+
+        auto curve = assesser.mean_fragmentation_curve();
+        REQUIRE(curve.num_regions().size() == max_regions);
+        REQUIRE(curve.num_regions()(0) == 1);
+        REQUIRE(xt::allclose(curve.scores(), score_sums / (double) k));
+    }
+
+    TEST_CASE("dataset assessment incremental and deterministic", "[dataset_assessment]") {
+        auto d = make_dataset(10);
+        dataset_assesser all(partition_measure::DCovering, 20);
+        all.add_samples(d.trees, d.altitudes, d.ground_truths, {}, 1);
+        REQUIRE(std::isnan(all.mean_purity()));
+
+        // two calls with pointers on the samples and a different batch size
+        dataset_assesser incremental(partition_measure::DCovering, 20);
+        vector<const tree *> trees1, trees2;
+        vector<const array_1d<double> *> altitudes1, altitudes2;
+        vector<std::reference_wrapper<const array_2d<index_t>>> ground_truths1, ground_truths2;
+        for (index_t i = 0; i < 10; i++) {
+            (i < 4 ? trees1 : trees2).push_back(&d.trees[i]);
+            (i < 4 ? altitudes1 : altitudes2).push_back(&d.altitudes[i]);
+            (i < 4 ? ground_truths1 : ground_truths2).push_back(std::cref(d.ground_truths[i]));
+        }
+        incremental.add_samples(trees1, altitudes1, ground_truths1);
+        incremental.add_samples(trees2, altitudes2, ground_truths2, {}, 4);
+        REQUIRE(incremental.num_samples() == 10);
+        REQUIRE((incremental.sample_indices() == all.sample_indices()));
+        REQUIRE((incremental.optimal_scores() == all.optimal_scores()));
+        REQUIRE((incremental.mean_fragmentation_curve().scores() == all.mean_fragmentation_curve().scores()));
+    }
+
+    TEST_CASE("dataset assessment on rag", "[dataset_assessment]") {
+        auto graph = get_4_adjacency_graph({2, 3});
+        // regions {0, 1}, {2, 5}, {3, 4}
+        array_1d<index_t> vertex_map{0, 0, 1, 2, 2, 1};
+        hg::tree tree{array_1d<index_t>{3, 3, 4, 4, 4}};
+        array_1d<double> altitudes{0, 0, 0, 1, 2};
+        array_2d<index_t> ground_truth{{0, 0, 1, 0, 0, 1}};
+
+        dataset_assesser assesser(partition_measure::DHamming, 10, true);
+        assesser.add_samples(vector<hg::tree>{tree}, vector<array_1d<double>>{altitudes},
+                             vector<array_2d<index_t>>{ground_truth}, vector<array_1d<index_t>>{vertex_map});
+        array_1d<index_t> gt = xt::view(ground_truth, 0, xt::all());
+        auto ref = assess_fragmentation_horizontal_cut(tree, altitudes, gt, scorer_partition_DHamming(), vertex_map,
+                                                       10);
+        REQUIRE(assesser.optimal_scores()(0) == Approx(ref.optimal_score()));
+        REQUIRE(assesser.optimal_scores()(0) == Approx(1));
+        REQUIRE(std::isnan(assesser.purities()(0)));
+        // cuts with 1 and 2 regions, the last one is held up to 10 regions
+        auto curve = assesser.mean_fragmentation_curve();
+        REQUIRE(curve.scores()(9) == Approx(ref.scores()(ref.scores().size() - 1)));
+
+        REQUIRE_THROWS(assesser.add_samples(vector<hg::tree>{tree}, vector<array_1d<double>>{},
+                                            vector<array_2d<index_t>>{ground_truth}));
+    }
+}
@@ -9,12 +9,35 @@
 ****************************************************************************/
 
 #include "higra/assessment/dendrogram_purity.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
 #include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 
 namespace assessment_dendrogram_purity {
 
+    // dense label histograms of all the nodes
+    template<typename tree_t, typename T>
+    double dendrogram_purity_dense(const tree_t &tree, const T &labels) {
+        const index_t num_l = num_leaves(tree);
+        array_2d<double> histo_leaves = xt::zeros<double>({(size_t) num_l, (size_t) xt::amax(labels)() + 1});
+        for (index_t i = 0; i < num_l; i++) {
+            histo_leaves(i, labels(i)) = 1;
+        }
+        array_2d<double> histo = accumulate_sequential(tree, histo_leaves, accumulator_sum());
+        auto area = attribute_area(tree);
+        array_2d<double> weights = attribute_children_pair_sum_product(tree, histo);
+        double total = 0;
+        for (index_t n = num_l; n < (index_t) num_vertices(tree); n++) {
+            for (index_t l = 0; l < (index_t) histo.shape()[1]; l++) {
+                total += histo(n, l) / area(n) * weights(n, l);
+            }
+        }
+        return total / xt::sum(weights)();
+    }
+
     TEST_CASE("dendrogram purity", "[dendrogram purity]") {
         SECTION("binary"){
             tree t(array_1d <index_t>{5,5,6,7,7,6,8,8,8});
@@ -33,4 +56,21 @@ namespace assessment_dendrogram_purity {
             REQUIRE(almost_equal(p, 0.5666666666666667));
         }
     }
+
+    TEST_CASE("dendrogram purity random", "[dendrogram purity]") {
+        xt::random::seed(42);
+        for (index_t size: {10, 150}) {
+            auto graph = get_4_adjacency_graph({size, size});
+            for (index_t i = 0; i < 3; i++) {
+                array_1d<index_t> edge_weights = xt::random::randint<index_t>({num_edges(graph)}, 0, 20);
+                // non binary tree
+                auto tree = quasi_flat_zone_hierarchy(graph, edge_weights).tree;
+                array_1d<index_t> labels = xt::random::randint<index_t>({num_leaves(tree)}, 0, 10);
+                REQUIRE(almost_equal(dendrogram_purity(tree, labels), dendrogram_purity_dense(tree, labels)));
+                // binary tree with many disjoint sub trees
+                auto bpt = bpt_canonical(graph, edge_weights).tree;
+                REQUIRE(almost_equal(dendrogram_purity(bpt, labels), dendrogram_purity_dense(bpt, labels)));
+            }
+        }
+    }
 }
@@ -11,7 +11,9 @@
 #include "higra/assessment/fragmentation_curve.hpp"
 #include "higra/assessment/partition.hpp"
 #include "higra/image/graph_image.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
 #include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 
@@ -238,4 +240,54 @@ namespace assessment_fragmentation_curve {
             REQUIRE(xt::allclose(res_scores, ref_scores / 11));
             REQUIRE(res_k == ref_k);
     }
-}
\ No newline at end of file
+
+    TEST_CASE("fragmentation curve horizontal cut several ground truths", "[fragmentation_curve]") {
+        hg::tree tree{
+                array_1d<index_t>{11, 11, 11, 12, 12, 16, 13, 13, 13, 14, 14, 17, 16, 15, 15, 18, 17, 18, 18}
+        };
+        array_1d<int> altitudes{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 3, 1, 2, 3};
+        array_2d<int> ground_truths{{3, 3, 3, 3, 1, 1, 1, 2, 2, 2, 2},
+                                    {0, 0, 1, 1, 1, 2, 2, 2, 2, 4, 4},
+                                    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}};
+
+        auto res = assess_fragmentation_horizontal_cut_ground_truths(tree, altitudes, ground_truths,
+                                                                     scorer_partition_BCE());
+        REQUIRE(res.size() == 3);
+        for (index_t g = 0; g < 3; g++) {
+            array_1d<int> ground_truth = xt::view(ground_truths, g, xt::all());
+            auto ref = assess_fragmentation_horizontal_cut(tree, altitudes, ground_truth, scorer_partition_BCE());
+            REQUIRE(res[g].num_regions_ground_truth() == ref.num_regions_ground_truth());
+            REQUIRE(xt::allclose(res[g].scores(), ref.scores()));
+            REQUIRE(res[g].num_regions() == ref.num_regions());
+        }
+        REQUIRE(res[1].num_regions_ground_truth() == 4);
+    }
+
+    TEST_CASE("fragmentation curve horizontal cut sparse card intersection", "[fragmentation_curve]") {
+        xt::random::seed(2);
+        auto graph = get_4_adjacency_graph({20, 30});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(graph)});
+        auto bpt = bpt_canonical(graph, edge_weights);
+        array_1d<int> ground_truth = xt::random::randint<int>({num_vertices(graph)}, 0, 7);
+
+        auto card_intersection = fragmentation_curve_internal::compute_sparse_card_intersection_tree_ground_truth(
+                bpt.tree, ground_truth);
+        array_2d<index_t> leaves_intersection = xt::zeros<index_t>({num_vertices(graph), (size_t) 7});
+        for (index_t i = 0; i < (index_t) num_vertices(graph); i++) {
+            leaves_intersection(i, ground_truth(i)) = 1;
+        }
+        auto dense = accumulate_sequential(bpt.tree, leaves_intersection, accumulator_sum());
+        auto all_rows = card_intersection.rows<index_t>(xt::arange<index_t>(num_vertices(bpt.tree)));
+        REQUIRE((all_rows == dense));
+
+        auto res = assess_fragmentation_horizontal_cut(bpt.tree, bpt.altitudes, ground_truth,
+                                                       scorer_partition_DCovering(), {}, 50);
+        REQUIRE(res.scores().size() == 50);
+        hg::horizontal_cut_explorer<hg::tree, double> hce(bpt.tree, bpt.altitudes);
+        for (index_t i = 0; i < 50; i++) {
+            auto nodes = hce.horizontal_cut_from_index(i).nodes;
+            array_2d<double> rows = xt::view(dense, xt::keep(nodes), xt::all());
+            REQUIRE(res.scores()(i) == Approx(scorer_partition_DCovering::score(rows)));
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/assessment/hierarchical_cost.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "../test_utils.hpp"
+
+using namespace hg;
+
+namespace assessment_hierarchical_cost {
+
+    TEST_CASE("dasgupta cost", "[hierarchical_cost]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        array_1d<double> edge_weights{1, 7, 3, 7, 1, 1, 6, 5, 6, 4, 1, 2};
+        auto tree = bpt_canonical(graph, edge_weights).tree;
+
+        double ref = 2. / 1 + 4. / 3 + 9. / 7 + 9. / 7 + 2. / 1 + 2. / 1 + 9. / 5 + 9. / 6 + 9. / 6 + 7. / 4 + 2. / 1 +
+                     3. / 2;
+        REQUIRE(almost_equal(dasgupta_cost(tree, graph, edge_weights), ref));
+
+        // leaves of area 2
+        REQUIRE(almost_equal(dasgupta_cost(tree, graph, edge_weights, xt::ones<double>({9}) * 2), 2 * ref));
+    }
+
+    TEST_CASE("tree sampling divergence", "[hierarchical_cost]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        array_1d<double> edge_weights{0, 6, 2, 6, 0, 0, 5, 4, 5, 3, 2, 2};
+        auto tree = quasi_flat_zone_hierarchy(graph, edge_weights).tree;
+
+        std::vector<double> p{0., 0., 0., 0.05714286, 0.11428571, 0.08571429, 0.74285714};
+        std::vector<double> q{0.03918367, 0.01142857, 0.13469388, 0.10285714, 0.11673469, 0.39428571, 0.93387755};
+        double ref = 0;
+        for (index_t i = 3; i < 7; i++) {
+            ref += p[i] * std::log(p[i] / q[i]);
+        }
+        REQUIRE(std::abs(tree_sampling_divergence(tree, graph, edge_weights) - ref) < 1e-6);
+    }
+}
@@ -10,6 +10,7 @@
 
 #include "higra/assessment/partition.hpp"
 #include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 
@@ -92,4 +93,43 @@ namespace assessment_partition {
             REQUIRE(almost_equal((s1 + s2) / 2.0, cov));
     }
 
+    TEST_CASE("sparse cardinal of intersections", "[assessment_partition]") {
+        array_1d<int> candidate{0, 0, 0, 1, 1, 1, 2, 2, 2};
+        array_1d<int> gt1{0, 0, 1, 1, 1, 2, 2, 3, 3};
+        array_1d<int> gt2{0, 0, 0, 0, 1, 1, 1, 1, 1};
+
+        auto r = sparse_card_intersections(candidate, xt::stack(xt::xtuple(gt1, gt2)));
+        REQUIRE(r.size() == 2);
+        REQUIRE((r[0].row_start == array_1d<index_t>{0, 2, 4, 6}));
+        REQUIRE((r[0].labels == array_1d<index_t>{0, 1, 1, 2, 2, 3}));
+        REQUIRE((r[0].counts == array_1d<index_t>{2, 1, 2, 1, 1, 2}));
+        REQUIRE((r[0].candidate_area == array_1d<index_t>{3, 3, 3}));
+        REQUIRE((r[0].ground_truth_area == array_1d<index_t>{2, 3, 2, 2}));
+        REQUIRE((r[1].to_dense() == card_intersections(candidate, gt2)[0]));
+    }
+
+    TEST_CASE("assess partition sparse random", "[assessment_partition]") {
+        xt::random::seed(42);
+        const index_t num_elements = 2000;
+        array_1d<index_t> candidate = xt::random::randint<index_t>({num_elements}, 0, 700);
+        array_2d<index_t> ground_truths = xt::random::randint<index_t>({3, (int)num_elements}, 0, 20);
+        // dense scorers require non empty regions
+        xt::view(candidate, xt::range(0, 700)) = xt::arange<index_t>(700);
+        xt::view(ground_truths, xt::all(), xt::range(0, 20)) = xt::arange<index_t>(20);
+        // only the labels 0 and 1 in the second ground truth
+        xt::view(ground_truths, 1) = xt::view(ground_truths, 1) % 2;
+
+        auto sparse = sparse_card_intersections(candidate, ground_truths);
+        auto dense = card_intersections<double>(candidate, ground_truths);
+        REQUIRE(sparse.size() == 3);
+        for (index_t g = 0; g < 3; g++) {
+            REQUIRE((sparse[g].to_dense<double>() == dense[g]));
+            REQUIRE(almost_equal(scorer_partition_BCE::score(sparse[g]), scorer_partition_BCE::score(dense[g])));
+            REQUIRE(almost_equal(scorer_partition_DHamming::score(sparse[g]),
+                                 scorer_partition_DHamming::score(dense[g])));
+            REQUIRE(almost_equal(scorer_partition_DCovering::score(sparse[g]),
+                                 scorer_partition_DCovering::score(dense[g])));
+        }
+    }
+
 }
@@ -13,6 +13,8 @@
 #include "higra/image/graph_image.hpp"
 #include "higra/hierarchy/component_tree.hpp"
 #include "higra/io/tree_io.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
 
 namespace tree_attributes {
 
@@ -155,6 +157,22 @@ namespace tree_attributes {
         REQUIRE((ref == res));
     }
 
+    TEST_CASE("tree attribute dynamics random", "[tree_attributes]") {
+        xt::random::seed(19);
+        auto graph = get_4_adjacency_graph({31, 27});
+        array_1d<int> vertex_weights = xt::random::randint<int>({num_vertices(graph)}, 0, 30);
+
+        auto max_tree = component_tree_max_tree(graph, vertex_weights);
+        auto height = attribute_height(max_tree.tree, max_tree.altitudes, false);
+        REQUIRE((attribute_dynamics(max_tree.tree, max_tree.altitudes, false) ==
+                 attribute_extinction_value(max_tree.tree, max_tree.altitudes, height, false)));
+
+        auto min_tree = component_tree_min_tree(graph, vertex_weights);
+        auto height2 = attribute_height(min_tree.tree, min_tree.altitudes, true);
+        REQUIRE((attribute_dynamics(min_tree.tree, min_tree.altitudes, true) ==
+                 attribute_extinction_value(min_tree.tree, min_tree.altitudes, height2, true)));
+    }
+
     TEST_CASE("tree attribute siblings", "[tree_attributes]") {
         auto t = data.t;
 
@@ -206,6 +224,73 @@ namespace tree_attributes {
         REQUIRE(xt::allclose(ref, res));
     }
 
+    TEST_CASE("tree attribute contour length component tree random", "[tree_attributes]") {
+        xt::random::seed(7);
+        embedding_grid_2d embedding{23, 19};
+        auto g = get_4_adjacency_graph(embedding);
+        auto gi = get_4_adjacency_grid_graph(embedding);
+        array_1d<double> vertex_weights = xt::random::randint<int>({num_vertices(g)}, 0, 10);
+        auto res = component_tree_max_tree(g, vertex_weights);
+        auto &t = res.tree;
+        array_1d<double> vertex_perimeters({num_vertices(g)}, 4);
+        array_1d<double> edge_length = xt::random::randint<int>({num_edges(g)}, 1, 3);
+
+        // partition tree formula: perimeter of the leaves minus twice the length of the inner frontiers
+        auto frontier_length = attribute_frontier_length(t, g, edge_length);
+        array_1d<double> ref = -2 * frontier_length;
+        xt::view(ref, xt::range(0, num_leaves(t))) = vertex_perimeters;
+        for (auto i: leaves_to_root_iterator(t, leaves_it::include, root_it::exclude)) {
+            ref(parent(i, t)) += ref(i);
+        }
+
+        REQUIRE(xt::allclose(ref, attribute_contour_length_component_tree(t, g, vertex_perimeters, edge_length)));
+        REQUIRE(xt::allclose(ref, attribute_contour_length_component_tree(t, gi, vertex_perimeters, edge_length)));
+    }
+
+    TEST_CASE("tree attribute frontier length and strength", "[tree_attributes]") {
+        auto g = get_4_adjacency_graph({2, 3});
+        array_1d<index_t> parents{6, 7, 9, 6, 8, 9, 7, 8, 10, 10, 10};
+        tree t(parents);
+        array_1d<double> edge_length{1, 2, 3, 4, 5, 6, 7};
+        array_1d<double> edge_weights{1, 3, 2, 6, 4, 3, 1};
+
+        array_1d<double> ref_length{0, 0, 0, 0, 0, 0, 2, 1, 10, 5, 10};
+        auto res_length = attribute_frontier_length(t, g, edge_length);
+        REQUIRE((ref_length == res_length));
+
+        array_1d<double> ref_strength{0, 0, 0, 0, 0, 0, 1.5, 1, 0.9, 0.8, 0.3};
+        auto res_strength = attribute_frontier_strength(t, g, edge_weights, edge_length);
+        REQUIRE(xt::allclose(ref_strength, res_strength));
+    }
+
+    TEST_CASE("tree attribute frontier length and strength random", "[tree_attributes]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({31, 27});
+        array_1d<double> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+        array_1d<int> edge_length = xt::random::randint<int>({num_edges(graph)}, 1, 5);
+        auto res = bpt_canonical(graph, edge_weights);
+        auto &t = res.tree;
+
+        auto lca = lca_fast(t);
+        array_1d<int> ref_length = xt::zeros<int>({num_vertices(t)});
+        array_1d<double> ref_weights = xt::zeros<double>({num_vertices(t)});
+        for (auto e: edge_iterator(graph)) {
+            auto n = lca.lca(source(e, graph), target(e, graph));
+            ref_length(n) += edge_length(index(e, graph));
+            ref_weights(n) += edge_weights(index(e, graph));
+        }
+        array_1d<double> ref_strength = ref_weights;
+        for (index_t n = num_leaves(t); n < (index_t) num_vertices(t); n++) {
+            ref_strength(n) /= ref_length(n);
+        }
+
+        REQUIRE((ref_length == attribute_frontier_length(t, graph, edge_length)));
+        REQUIRE((ref_length == attribute_frontier_length(t, graph, edge_length, lca_sparse_table(t))));
+        REQUIRE(xt::allclose(ref_strength, attribute_frontier_strength(t, graph, edge_weights, edge_length)));
+        REQUIRE(xt::allclose(ref_strength,
+                             attribute_frontier_strength(t, graph, edge_weights, edge_length, lca_bitmask_block(t))));
+    }
+
     TEST_CASE("tree attribute child number", "[tree_attributes]") {
         auto t = data.t;
 
@@ -214,6 +299,49 @@ namespace tree_attributes {
         REQUIRE((ref == res));
     }
 
+    TEST_CASE("tree structural attributes parallel", "[tree_attributes]") {
+        auto t = data.t;
+        REQUIRE((attribute_depth(execution::par, t) == attribute_depth(t)));
+        REQUIRE((attribute_area(execution::par, t) == attribute_area(t)));
+        REQUIRE((attribute_child_number(execution::par, t) == attribute_child_number(t)));
+        REQUIRE((attribute_sibling(execution::par, t) == attribute_sibling(t)));
+        REQUIRE((attribute_sibling(execution::par, t, -1) == attribute_sibling(t, -1)));
+        REQUIRE((attribute_topological_height(t) == array_1d<index_t>{0, 0, 0, 0, 0, 1, 1, 2}));
+        REQUIRE((attribute_topological_height(execution::par, t) == attribute_topological_height(t)));
+
+        // random trees (non binary, after simplification), a complete binary tree and a deep comb
+        xt::random::seed(3);
+        auto g = get_4_adjacency_graph({31, 29});
+        array_1d<int> weights = xt::random::randint<int>({num_edges(g)}, 0, 5);
+        auto qfz = quasi_flat_zone_hierarchy(g, weights);
+        auto bpt = bpt_canonical(g, xt::random::rand<double>({num_edges(g)}));
+        // leaves 0 and 1 are children of 1000, the leaf i > 1 is a child of 999 + i, 1000, ..., 2000 form a chain
+        array_1d<index_t> comb_parents = array_1d<index_t>::from_shape({2001});
+        comb_parents(0) = 1000;
+        for (index_t i = 1; i < 1000; i++) {
+            comb_parents(i) = 999 + i;
+        }
+        for (index_t i = 1000; i < 2000; i++) {
+            comb_parents(i) = i + 1;
+        }
+        comb_parents(2000) = 2000;
+        for (const auto &tt: {qfz.tree, bpt.tree, tree(comb_parents)}) {
+            array_1d<double> leaf_area = xt::random::randint<int>({num_leaves(tt)}, 0, 10);
+            REQUIRE((attribute_depth(execution::par, tt) == attribute_depth(tt)));
+            REQUIRE((attribute_area(execution::par, tt) == attribute_area(tt)));
+            REQUIRE((attribute_area(execution::par, tt, leaf_area) == attribute_area(tt, leaf_area)));
+            REQUIRE((attribute_child_number(execution::par, tt) == attribute_child_number(tt)));
+            REQUIRE((attribute_sibling(execution::par, tt, 2) == attribute_sibling(tt, 2)));
+            REQUIRE((attribute_topological_height(execution::par, tt) == attribute_topological_height(tt)));
+        }
+        REQUIRE(xt::amax(attribute_depth(execution::par, tree(comb_parents)))() == 1001);
+
+        // serial fallback
+        REQUIRE((attribute_depth(execution::par.with_serial_cutoff(100), t) == attribute_depth(t)));
+        tree single(array_1d<index_t>{0});
+        REQUIRE((attribute_topological_height(execution::par, single) == array_1d<index_t>{0}));
+    }
+
     TEST_CASE("tree attribute smallest enclosing shape ", "[tree_attributes]") {
         array_1d<index_t> pt1{8, 8, 9, 9, 9, 10, 10, 11, 13, 12, 11, 12, 13, 13};
         tree t1(pt1);
@@ -245,5 +373,162 @@ namespace tree_attributes {
         ref.reshape({8, 2});
         REQUIRE(xt::allclose(ref, res));
     }
+    TEST_CASE("tree attribute fused", "[tree_attributes]") {
+        tree t(xt::xarray<index_t>{11, 11, 9, 9, 8, 8, 13, 13, 10, 10, 12, 12, 14, 14, 14});
+        array_1d<double> node_altitude{0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 1, 4, 8, 10};
+        array_1d<double> leaf_area{1, 2, 1, 3, 1, 1, 2, 4};
+        array_1d<int> vertex_weights{3, 1, 4, 1, 5, 9, 2, 6};
+        array_2d<double> vertex_weights2{{1, 0}, {2, 1}, {3, 1}, {4, 2}, {5, 3}, {6, 5}, {7, 8}, {8, 13}};
+
+        auto attributes = make_fused_tree_attributes(t, leaf_area);
+        auto &depth = attributes.add_depth();
+        auto &volume = attributes.add_volume(node_altitude);
+        auto &extrema = attributes.add_extrema(node_altitude);
+        auto &mean = attributes.add_mean_vertex_weights(vertex_weights);
+        auto &mean2 = attributes.add_mean_vertex_weights(vertex_weights2);
+        auto &max = attributes.add_accumulator(vertex_weights, accumulator_max());
+        auto &sum2 = attributes.add_accumulator(vertex_weights2, accumulator_sum());
+        auto &area = attributes.area();
+        attributes.compute();
+
+        auto ref_area = attribute_area(t, leaf_area);
+        REQUIRE((area == ref_area));
+        REQUIRE((depth == attribute_depth(t)));
+        REQUIRE(xt::allclose(volume, attribute_volume(t, node_altitude, ref_area)));
+        REQUIRE((extrema == attribute_extrema(t, node_altitude)));
+        REQUIRE((max == accumulate_sequential(t, vertex_weights, accumulator_max())));
+        REQUIRE(xt::allclose(sum2, accumulate_sequential(t, vertex_weights2, accumulator_sum())));
+
+        array_1d<double> ref_mean = accumulate_sequential(t, xt::cast<double>(vertex_weights), accumulator_sum()) /
+                                    ref_area;
+        REQUIRE(xt::allclose(mean, ref_mean));
+        array_2d<double> ref_mean2 = accumulate_sequential(t, vertex_weights2, accumulator_sum()) /
+                                     xt::view(ref_area, xt::all(), xt::newaxis());
+        REQUIRE(xt::allclose(mean2, ref_mean2));
+
+        // computing again gives the same results
+        attributes.compute();
+        REQUIRE((area == ref_area));
+        REQUIRE((depth == attribute_depth(t)));
+        REQUIRE((extrema == attribute_extrema(t, node_altitude)));
+        REQUIRE(xt::allclose(mean2, ref_mean2));
+    }
+
+    TEST_CASE("tree attribute fused default area", "[tree_attributes]") {
+        auto t = data.t;
+        array_1d<double> node_altitude{0, 0, 0, 0, 0, 2, 1, 4};
+
+        auto attributes = make_fused_tree_attributes(t);
+        auto &volume = attributes.add_volume(node_altitude);
+        auto &depth = attributes.add_depth();
+        attributes.compute();
+
+        array_1d<double> ref_volume{0, 0, 0, 0, 0, 4, 9, 13};
+        REQUIRE((volume == ref_volume));
+        REQUIRE((depth == attribute_depth(t)));
+        REQUIRE((attributes.area() == attribute_area(t)));
+    }
+
+    TEST_CASE("tree attribute gaussian region weights model scalar", "[tree_attributes]") {
+        auto t = data.t;
+        array_1d<double> vertex_weights{1, 3, 0, 2, 4};
+
+        auto res = attribute_gaussian_region_weights_model(t, vertex_weights);
+        array_1d<double> ref_mean{1, 3, 0, 2, 4, 2, 2, 2};
+        array_1d<double> ref_variance{0, 0, 0, 0, 0, 1, 8.0 / 3, 2};
+        REQUIRE(xt::allclose(ref_mean, res.first));
+        REQUIRE(xt::allclose(ref_variance, res.second));
+    }
+
+    TEST_CASE("tree attribute gaussian region weights model scalar integral", "[tree_attributes]") {
+        auto t = data.t;
+        array_1d<unsigned char> vertex_weights{1, 3, 0, 2, 4};
+
+        auto res = attribute_gaussian_region_weights_model(t, vertex_weights);
+        static_assert(std::is_same<typename decltype(res.first)::value_type, double>::value,
+                      "Integral weights are modeled in double precision.");
+        array_1d<double> ref_mean{1, 3, 0, 2, 4, 2, 2, 2};
+        array_1d<double> ref_variance{0, 0, 0, 0, 0, 1, 8.0 / 3, 2};
+        REQUIRE(xt::allclose(ref_mean, res.first));
+        REQUIRE(xt::allclose(ref_variance, res.second));
+    }
+
+    TEST_CASE("tree attribute gaussian region weights model vectorial", "[tree_attributes]") {
+        xt::random::seed(3);
+        auto graph = get_4_adjacency_graph({13, 11});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(graph)});
+        auto t = bpt_canonical(graph, edge_weights).tree;
+        const index_t d = 5;
+        array_2d<float> vertex_weights = xt::random::rand<float>({(size_t) num_leaves(t), (size_t) d});
+
+        auto res = attribute_gaussian_region_weights_model(t, vertex_weights);
+        auto &mean = res.first;
+        auto &variance = res.second;
+        REQUIRE(mean.shape() == std::vector<size_t>{num_vertices(t), (size_t) d});
+        REQUIRE(variance.shape() == std::vector<size_t>{num_vertices(t), (size_t) d, (size_t) d});
+
+        auto area = attribute_area(t);
+        array_2d<double> sums = xt::zeros<double>({num_vertices(t), (size_t) d});
+        xt::xtensor<double, 3> sums2 = xt::zeros<double>({num_vertices(t), (size_t) d, (size_t) d});
+        for (auto l: leaves_iterator(t)) {
+            for (auto n: ancestors_iterator(l, t)) {
+                for (index_t i = 0; i < d; i++) {
+                    sums(n, i) += vertex_weights(l, i);
+                    for (index_t j = 0; j < d; j++) {
+                        sums2(n, i, j) += (double) vertex_weights(l, i) * vertex_weights(l, j);
+                    }
+                }
+            }
+        }
+        for (auto n: vertex_iterator(t)) {
+            for (index_t i = 0; i < d; i++) {
+                REQUIRE(mean(n, i) == Approx(sums(n, i) / area(n)).epsilon(1e-4));
+                for (index_t j = 0; j < d; j++) {
+                    double ref = sums2(n, i, j) / area(n) - sums(n, i) * sums(n, j) / (area(n) * area(n));
+                    REQUIRE(variance(n, i, j) == Approx(ref).margin(1e-4));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("tree attribute remap after simplify", "[tree_attributes]") {
+        xt::random::seed(18);
+        auto graph = get_4_adjacency_graph({17, 23});
+        array_1d<double> vertex_weights = xt::random::randint<int>({num_vertices(graph)}, 0, 20);
+        auto res = component_tree_max_tree(graph, vertex_weights);
+        auto &t = res.tree;
+        auto &altitudes = res.altitudes;
 
-}
\ No newline at end of file
+        auto area = attribute_area(t);
+        auto volume = attribute_volume(t, altitudes, area);
+        array_1d<double> leaf_data = xt::random::rand<double>({num_leaves(t)});
+        auto max_leaf_data = accumulate_sequential(t, leaf_data, accumulator_max());
+
+        array_1d<bool> criterion = xt::random::rand<double>({num_vertices(t)}) < 0.4;
+        auto rtree = simplify_tree(t, criterion);
+        auto &nt = rtree.tree;
+        array_1d<double> new_altitudes = xt::index_view(altitudes, rtree.node_map);
+
+        auto new_area = remap_tree_attribute(rtree, area);
+        REQUIRE((new_area == attribute_area(nt)));
+        REQUIRE((remap_tree_attribute(rtree, area, accumulator_sum()) == new_area));
+        REQUIRE((remap_tree_attribute(rtree, max_leaf_data) == accumulate_sequential(nt, leaf_data, accumulator_max())));
+
+        auto new_volume = update_attribute_volume(rtree, t, altitudes, area, volume);
+        REQUIRE(xt::allclose(new_volume, attribute_volume(nt, new_altitudes, new_area)));
+
+        // non monotone altitudes
+        array_1d<double> random_altitudes = xt::random::rand<double>({num_vertices(t)});
+        auto random_volume = attribute_volume(t, random_altitudes, area);
+        array_1d<double> new_random_altitudes = xt::index_view(random_altitudes, rtree.node_map);
+        REQUIRE(xt::allclose(update_attribute_volume(rtree, t, random_altitudes, area, random_volume),
+                             attribute_volume(nt, new_random_altitudes, new_area)));
+
+        // removed leaves: new leaves keep the attribute of the region they represent
+        auto rtree2 = simplify_tree(t, criterion, true);
+        auto &nt2 = rtree2.tree;
+        array_1d<index_t> new_leaf_area = xt::index_view(area, xt::view(rtree2.node_map, xt::range(0, num_leaves(nt2))));
+        REQUIRE((remap_tree_attribute(rtree2, area, accumulator_sum()) == attribute_area(nt2, new_leaf_area)));
+        REQUIRE(remap_tree_attribute(rtree2, area).shape()[0] == num_vertices(nt2));
+    }
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/hierarchy/binary_partition_tree.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/image/tree_of_shapes.hpp"
+#include "xtensor/xrandom.hpp"
+#include <thread>
+
+namespace test_cancellation {
+
+    using namespace hg;
+
+    TEST_CASE("check cancellation", "[cancellation]") {
+        REQUIRE_NOTHROW(check_cancellation());
+
+        cancellation_token token;
+        {
+            scoped_cancellation_token scope(&token);
+            REQUIRE_NOTHROW(check_cancellation());
+            token.cancel();
+            REQUIRE(token.cancelled());
+            REQUIRE_THROWS_AS(check_cancellation(), operation_cancelled);
+            REQUIRE_THROWS_AS(check_cancellation(0), operation_cancelled);
+            REQUIRE_NOTHROW(check_cancellation(1));
+            {
+                scoped_cancellation_token nested(nullptr);
+                REQUIRE_NOTHROW(check_cancellation());
+            }
+            REQUIRE_THROWS_AS(check_cancellation(), operation_cancelled);
+            token.reset();
+            REQUIRE_NOTHROW(check_cancellation());
+        }
+        token.cancel();
+        REQUIRE_NOTHROW(check_cancellation());
+    }
+
+    TEST_CASE("cancellation token is thread local", "[cancellation]") {
+        cancellation_token token;
+        token.cancel();
+        scoped_cancellation_token scope(&token);
+        bool other_thread_cancelled = true;
+        std::thread t([&other_thread_cancelled]() {
+            other_thread_cancelled = cancellation_internal::current_token() != nullptr;
+        });
+        t.join();
+        REQUIRE(!other_thread_cancelled);
+        REQUIRE_THROWS_AS(check_cancellation(), operation_cancelled);
+    }
+
+    TEST_CASE("cancel hierarchy computations", "[cancellation]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({60, 60});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(graph)});
+        array_2d<double> image = xt::random::rand<double>({60, 60});
+
+        cancellation_token token;
+        scoped_cancellation_token scope(&token);
+        REQUIRE_NOTHROW(bpt_canonical(graph, edge_weights));
+        REQUIRE_NOTHROW(binary_partition_tree_complete_linkage(graph, edge_weights));
+        REQUIRE_NOTHROW(component_tree_tree_of_shapes_image2d(image));
+
+        token.cancel();
+        REQUIRE_THROWS_AS(bpt_canonical(graph, edge_weights), operation_cancelled);
+        REQUIRE_THROWS_AS(binary_partition_tree_complete_linkage(graph, edge_weights), operation_cancelled);
+        REQUIRE_THROWS_AS(component_tree_tree_of_shapes_image2d(image), operation_cancelled);
+    }
+}
@@ -10,7 +10,11 @@
 
 #include "../test_utils.hpp"
 #include "higra/detail/log.hpp"
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace test_log {
 
@@ -19,17 +23,89 @@ namespace test_log {
 
     TEST_CASE("test logger", "[logger]") {
         string ref_msg("This is a test");
-        auto & loggers = logger::callbacks();
-        auto save = loggers.front();
-        loggers.clear();
-        SECTION( "do test" ) {
-            loggers.push_back([&ref_msg](const std::string &msg) {
-                REQUIRE(msg.find(ref_msg) != std::string::npos);
+        logger::flush();
+        auto save = logger::callbacks();
+        std::vector<std::string> messages;
+        logger::set_callbacks({[&messages](const std::string &msg) {
+            messages.push_back(msg);
+        }});
+
+        HG_LOG_INFO("%s", ref_msg.c_str());
+        logger::flush();
+        REQUIRE(messages.size() == 1);
+        REQUIRE(messages[0].find(ref_msg) != std::string::npos);
+
+        logger::set_callbacks(*save);
+    }
+
+    TEST_CASE("test logger threads", "[logger]") {
+        logger::flush();
+        auto save = logger::callbacks();
+        // the callbacks are called by the logger thread or by flush, never concurrently
+        std::vector<std::string> messages;
+        logger::set_callbacks({[&messages](const std::string &msg) {
+            messages.push_back(msg);
+        }});
+        auto dropped = logger::dropped_messages();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([t]() {
+                for (int i = 0; i < 20; i++) {
+                    logger::emit("message %d %d\n", t, i);
+                }
             });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+        logger::flush();
+        // messages are dropped if the queue is full
+        REQUIRE(messages.size() + (logger::dropped_messages() - dropped) == 80);
+        for (const auto &m: messages) {
+            REQUIRE(m.find("message ") == 0);
+        }
+
+        logger::set_callbacks(*save);
+    }
+
+    TEST_CASE("test logger truncated message", "[logger]") {
+        logger::flush();
+        auto save = logger::callbacks();
+        std::vector<std::string> messages;
+        logger::set_callbacks({[&messages](const std::string &msg) {
+            messages.push_back(msg);
+        }});
+        std::string long_message(logger::MAX_MSG_SIZE * 2, 'a');
+        logger::emit("%s", long_message.c_str());
+        logger::flush();
+        REQUIRE(messages.size() == 1);
+        REQUIRE(messages[0].size() == logger::MAX_MSG_SIZE - 1);
+        logger::set_callbacks(*save);
+    }
 
-            HG_LOG_INFO("%s", ref_msg.c_str());
+    TEST_CASE("test logger set callbacks waits for the delivery", "[logger]") {
+        logger::flush();
+        auto save = logger::callbacks();
+        std::atomic<bool> entered{false};
+        std::atomic<bool> done{false};
+        {
+            std::vector<std::string> messages;
+            logger::set_callbacks({[&messages, &entered, &done](const std::string &msg) {
+                entered = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                messages.push_back(msg);
+                done = true;
+            }});
+            logger::emit("%s", "message");
+            while (!entered) {
+                std::this_thread::yield();
+            }
+            // the callback is running in the logger thread: replacing the callbacks waits for its completion,
+            // messages can then be destroyed
+            logger::set_callbacks(*save);
+            REQUIRE(done);
+            REQUIRE(messages.size() == 1);
         }
-        loggers.clear();
-        loggers.push_back(save);
     }
-}
\ No newline at end of file
+}
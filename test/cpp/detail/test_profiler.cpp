@@ -0,0 +1,213 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/detail/profiler.hpp"
+#include "higra/detail/memory_tracking.hpp"
+#include "higra/detail/memory_estimates.hpp"
+#include <sstream>
+#include <thread>
+
+namespace test_profiler {
+
+    using namespace hg;
+    using namespace std;
+
+    const char *scope_a = "test_profiler::scope_a";
+    const char *scope_b = "test_profiler::scope_b";
+
+    void profiled_function(size_t allocation) {
+        profiler::scoped_timer timer(scope_a);
+        profiler::count_allocation(allocation);
+        {
+            profiler::scoped_timer nested(scope_b);
+            profiler::count_allocation(1);
+        }
+    }
+
+    TEST_CASE("profiler scoped timers", "[profiler]") {
+        profiler::reset();
+        for (int i = 0; i < 3; i++) {
+            profiled_function(10);
+        }
+
+        auto stats = profiler::snapshot();
+        REQUIRE(stats.count(scope_a) == 1);
+        REQUIRE(stats.count(scope_b) == 1);
+        REQUIRE(stats[scope_a].calls == 3);
+        REQUIRE(stats[scope_b].calls == 3);
+        // nested scopes are included
+        REQUIRE(stats[scope_a].allocated_bytes == 33);
+        REQUIRE(stats[scope_b].allocated_bytes == 3);
+        REQUIRE(stats[scope_a].time_ns >= stats[scope_b].time_ns);
+
+        profiler::reset();
+        stats = profiler::snapshot();
+        REQUIRE(stats[scope_a].calls == 0);
+        REQUIRE(stats[scope_a].allocated_bytes == 0);
+    }
+
+    TEST_CASE("profiler threads", "[profiler]") {
+        profiler::reset();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([]() {
+                for (int i = 0; i < 100; i++) {
+                    profiled_function(2);
+                }
+            });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+        profiled_function(2);
+
+        // the statistics of the threads that have exited are kept until the next reset
+        auto stats = profiler::snapshot();
+        REQUIRE(stats[scope_a].calls == 401);
+        REQUIRE(stats[scope_b].calls == 401);
+        REQUIRE(stats[scope_a].allocated_bytes == 401 * 3);
+        profiler::reset();
+        REQUIRE(profiler::snapshot()[scope_a].calls == 0);
+    }
+
+    TEST_CASE("profiler trace events", "[profiler]") {
+        profiler::reset();
+        profiled_function(0);
+        profiler::set_events_enabled(true);
+        profiled_function(0);
+        std::thread t([]() { profiled_function(0); });
+        t.join();
+        profiler::set_events_enabled(false);
+        profiled_function(0);
+
+        std::ostringstream out;
+        profiler::write_chrome_trace(out);
+        auto trace = out.str();
+        auto count = [&trace](const std::string &str) {
+            size_t n = 0;
+            for (auto p = trace.find(str); p != std::string::npos; p = trace.find(str, p + 1)) {
+                n++;
+            }
+            return n;
+        };
+        REQUIRE(trace.find("{\"traceEvents\":[") == 0);
+        REQUIRE(count("\"ph\":\"X\"") == 4);
+        REQUIRE(count("\"name\":\"test_profiler::scope_a\"") == 2);
+        REQUIRE(count("\"name\":\"test_profiler::scope_b\"") == 2);
+
+        profiler::reset();
+        std::ostringstream out2;
+        profiler::write_chrome_trace(out2);
+        REQUIRE(out2.str().find("\"ph\"") == std::string::npos);
+
+        std::ostringstream escaped;
+        profiler::write_json_string(escaped, "a\"b\\c\n");
+        REQUIRE(escaped.str() == "a\\\"b\\\\c\\u000a");
+    }
+
+    const char *counter_a = "test_profiler::counter_a";
+
+    TEST_CASE("profiler algorithm counters", "[profiler]") {
+        profiler::reset();
+        auto &counters = profiler::local_store().get_samples(counter_a);
+        profiler::add_sample(counters, 3);
+        profiler::add_sample(counters, 1);
+        std::thread t([]() {
+            profiler::add_sample(profiler::local_store().get_samples(counter_a), 8);
+        });
+        t.join();
+
+        auto stats = profiler::snapshot_counters();
+        REQUIRE(stats[counter_a].samples == 3);
+        REQUIRE(stats[counter_a].total == 12);
+        REQUIRE(stats[counter_a].max == 8);
+        REQUIRE(stats[counter_a].mean() == 4);
+
+#ifdef HG_ENABLE_PROFILING
+        for (int i = 0; i < 4; i++) {
+            HG_PROFILE_COUNT(counter_a, i);
+        }
+        REQUIRE(profiler::snapshot_counters()[counter_a].samples == 7);
+#endif
+
+        profiler::reset();
+        stats = profiler::snapshot_counters();
+        REQUIRE(stats[counter_a].samples == 0);
+        REQUIRE(stats[counter_a].max == 0);
+    }
+
+    void allocating_function(size_t temporary, size_t retained) {
+        profiler::scoped_timer timer(scope_a);
+        profiler::count_allocation(temporary);
+        {
+            profiler::scoped_timer nested(scope_b);
+            profiler::count_allocation(temporary);
+            profiler::count_deallocation(temporary);
+        }
+        profiler::count_deallocation(temporary);
+        profiler::count_allocation(retained);
+    }
+
+    TEST_CASE("profiler memory peak", "[profiler]") {
+        profiler::reset();
+        auto start = profiler::thread_memory();
+        allocating_function(100, 10);
+        allocating_function(50, 20);
+
+        auto stats = profiler::snapshot();
+        REQUIRE(stats[scope_a].allocated_bytes == 2 * 100 + 10 + 2 * 50 + 20);
+        REQUIRE(stats[scope_a].peak_bytes == 200);
+        REQUIRE(stats[scope_a].retained_bytes == 30);
+        REQUIRE(stats[scope_b].peak_bytes == 100);
+        REQUIRE(stats[scope_b].retained_bytes == 0);
+
+        // the peak of the enclosing scope is restored
+        auto end = profiler::thread_memory();
+        REQUIRE(end.current_bytes == start.current_bytes + 30);
+        REQUIRE(end.peak_bytes >= start.current_bytes + 200);
+        profiler::count_deallocation(30);
+        profiler::reset();
+    }
+
+    TEST_CASE("profiler tracking allocator", "[profiler]") {
+        auto start = profiler::thread_memory();
+        {
+            std::vector<int64_t, tracking_allocator<int64_t>> v(100);
+            REQUIRE(profiler::thread_memory().current_bytes == start.current_bytes + 800);
+            REQUIRE(profiler::thread_memory().allocated_bytes == start.allocated_bytes + 800);
+        }
+        REQUIRE(profiler::thread_memory().current_bytes == start.current_bytes);
+
+#ifdef HG_ENABLE_MEMORY_TRACKING
+        {
+            array_1d<double> a = xt::zeros<double>({1000});
+            REQUIRE(profiler::thread_memory().current_bytes >= start.current_bytes + 8000);
+        }
+        REQUIRE(profiler::thread_memory().current_bytes == start.current_bytes);
+#endif
+    }
+
+    TEST_CASE("memory estimates", "[profiler]") {
+        REQUIRE(memory_estimate::ceil_log2(1) == 0);
+        REQUIRE(memory_estimate::ceil_log2(5) == 3);
+        REQUIRE(memory_estimate::ceil_log2(8) == 3);
+
+        size_t v = 1000 * 1000;
+        size_t e = 2 * v;
+        REQUIRE(memory_estimate::bpt_canonical(v, e, 4) < memory_estimate::bpt_canonical(v, e, 8));
+        REQUIRE(memory_estimate::bpt_canonical(v, e, 8) < memory_estimate::watershed_hierarchy(v, e, 8));
+        REQUIRE(memory_estimate::bpt_canonical(v, e, 8) < memory_estimate::binary_partition_tree(v, e, 8));
+        REQUIRE(memory_estimate::lca_sparse_table_block(2 * v) < memory_estimate::lca_sparse_table(2 * v));
+        REQUIRE(memory_estimate::tree_of_shapes_image2d(1000, 1000, 1, false, false) <
+                memory_estimate::tree_of_shapes_image2d(1000, 1000, 1));
+        REQUIRE(memory_estimate::component_tree(v, 1) < memory_estimate::component_tree(v, 8));
+    }
+}
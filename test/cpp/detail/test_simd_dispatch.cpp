@@ -0,0 +1,51 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/detail/simd_dispatch.hpp"
+#include "higra/accumulator/accumulator.hpp"
+#include "higra/sorting.hpp"
+#include "higra/structure/details/range_minimum_query.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xsort.hpp"
+#include "../test_utils.hpp"
+
+namespace test_simd_dispatch {
+
+    using namespace hg;
+
+    TEST_CASE("simd instruction set", "[simd_dispatch]") {
+        std::vector<std::string> names{"avx512f", "avx2", "sse4.2", "sse2", "neon", "generic"};
+        REQUIRE(std::find(names.begin(), names.end(), simd_instruction_set()) != names.end());
+    }
+
+    TEST_CASE("dispatched kernels", "[simd_dispatch]") {
+        xt::random::seed(1);
+        const index_t size = 10007;
+        array_1d<double> a = xt::random::rand<double>({size}) - 0.5;
+        array_1d<double> b = xt::random::rand<double>({size}) - 0.5;
+
+        array_1d<double> s = a;
+        accumulator_detail::reduce_range<accumulator_max>(s.data(), s.data() + size, (const double *) b.data());
+        REQUIRE((s == xt::maximum(a, b)));
+
+        array_1d<uint64_t> keys = array_1d<uint64_t>::from_shape({(size_t) size});
+        sorting_internal::radix_keys(a.data(), keys.data(), size, true);
+        for (index_t i = 1; i < size; i++) {
+            REQUIRE(((keys(i - 1) < keys(i)) == (a(i - 1) > a(i))));
+        }
+
+        array_1d<size_t> previous = xt::arange<size_t>(size);
+        array_1d<size_t> next = array_1d<size_t>::from_shape({(size_t) size - 4});
+        range_minimum_query_internal::sparse_table_next_level(a.data(), previous.data(), next.data(), 4, 0, size - 4);
+        for (index_t i = 0; i < size - 4; i++) {
+            REQUIRE(next(i) == ((a(i) < a(i + 4)) ? (size_t) i : (size_t) i + 4));
+        }
+    }
+}
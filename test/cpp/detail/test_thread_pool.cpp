@@ -0,0 +1,161 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/sorting.hpp"
+#include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
+#include <atomic>
+#include <thread>
+
+namespace test_thread_pool {
+
+    using namespace hg;
+
+    TEST_CASE("parfor visits each index once", "[thread_pool]") {
+        for (index_t size: {0, 1, 7, 1000, 100001}) {
+            std::vector<std::atomic<int>> counts(size);
+            for (auto &c: counts) {
+                c = 0;
+            }
+            parfor(0, size, [&counts](index_t i) { counts[i]++; });
+            for (auto &c: counts) {
+                REQUIRE(c == 1);
+            }
+        }
+
+        std::vector<std::atomic<int>> counts(100);
+        for (auto &c: counts) {
+            c = 0;
+        }
+        parfor(3, 100, [&counts](index_t i) { counts[i]++; }, 7);
+        for (index_t i = 0; i < 100; i++) {
+            REQUIRE(counts[i] == ((i >= 3 && (i - 3) % 7 == 0) ? 1 : 0));
+        }
+    }
+
+    TEST_CASE("parfor nested loops and exceptions", "[thread_pool]") {
+        std::atomic<index_t> sum{0};
+        parfor(0, 100, [&sum](index_t i) {
+            parfor(0, 100, [&sum, i](index_t j) { sum += i * j; });
+        });
+        REQUIRE(sum == 4950 * 4950);
+
+        REQUIRE_THROWS(parfor(0, 10000, [](index_t i) {
+            hg_assert(i != 5000, "error");
+        }));
+
+        // the pool is still usable after an exception
+        std::atomic<index_t> count{0};
+        parfor(0, 10000, [&count](index_t) { count++; });
+        REQUIRE(count == 10000);
+    }
+
+    TEST_CASE("thread limit", "[thread_pool]") {
+        index_t num_threads = get_num_threads();
+        REQUIRE(num_threads >= 1);
+        {
+            thread_limit limit(1);
+            REQUIRE(get_num_threads() == 1);
+            {
+                thread_limit limit2(0);
+                REQUIRE(get_num_threads() == num_threads);
+            }
+            REQUIRE(get_num_threads() == 1);
+            std::atomic<index_t> count{0};
+            parfor(0, 1000, [&count](index_t) { count++; });
+            REQUIRE(count == 1000);
+        }
+        REQUIRE(get_num_threads() == num_threads);
+
+#ifdef HG_USE_THREAD_POOL
+        set_num_threads(3);
+        REQUIRE(get_num_threads() == 3);
+        std::atomic<index_t> count{0};
+        parfor(0, 1000, [&count](index_t) { count++; });
+        REQUIRE(count == 1000);
+        set_num_threads(0);
+        REQUIRE(get_num_threads() == num_threads);
+#endif
+    }
+
+    TEST_CASE("parallel merge sort", "[thread_pool]") {
+        xt::random::seed(42);
+        for (index_t size: {10, 100000, 300001}) {
+            array_1d<int> a = xt::random::randint<int>({size}, 0, 1000);
+            std::vector<int> ref(a.begin(), a.end());
+            std::sort(ref.begin(), ref.end());
+            array_1d<int> b = a;
+            sorting_internal::parallel_merge_sort<false>(b.begin(), b.end(), std::less<int>());
+            REQUIRE(std::equal(b.begin(), b.end(), ref.begin()));
+
+            // stability: sort indices by value
+            std::vector<index_t> indices(size);
+            std::iota(indices.begin(), indices.end(), 0);
+            std::vector<index_t> ref_indices = indices;
+            auto comp = [&a](index_t i, index_t j) { return a(i) < a(j); };
+            std::stable_sort(ref_indices.begin(), ref_indices.end(), comp);
+            sorting_internal::parallel_merge_sort<true>(indices.begin(), indices.end(), comp);
+            REQUIRE((indices == ref_indices));
+        }
+    }
+
+    TEST_CASE("parfor with grain size and serial cutoff", "[thread_pool]") {
+        for (index_t grain: {0, 1, 7, 1000, 5000}) {
+            for (index_t cutoff: {0, 100, 10000}) {
+                auto policy = execution::par.with_grain_size(grain).with_serial_cutoff(cutoff);
+                REQUIRE(policy.grain_size == grain);
+                REQUIRE(policy.serial_cutoff == cutoff);
+                for (index_t size: {0, 1, 50, 4321}) {
+                    std::vector<std::atomic<index_t>> visits(size + 3);
+                    for (auto &v: visits) {
+                        v = 0;
+                    }
+                    parfor(policy, 3, size + 3, [&visits](index_t i) { visits[i]++; });
+                    for (index_t i = 0; i < size + 3; i++) {
+                        REQUIRE(visits[i] == ((i < 3) ? 0 : 1));
+                    }
+                }
+            }
+        }
+
+        // loops below the cutoff are executed by the calling thread
+        auto id = std::this_thread::get_id();
+        bool same_thread = true;
+        parfor(execution::par.with_serial_cutoff(1000), 0, 999, [&id, &same_thread](index_t) {
+            if (std::this_thread::get_id() != id) {
+                same_thread = false;
+            }
+        });
+        REQUIRE(same_thread);
+    }
+
+    TEST_CASE("sort with policy", "[thread_pool]") {
+        xt::random::seed(42);
+        for (index_t size: {10, 100000}) {
+            array_1d<int> a = xt::random::randint<int>({size}, 0, 1000);
+            std::vector<int> ref(a.begin(), a.end());
+            std::sort(ref.begin(), ref.end());
+            for (auto policy: {execution::par, execution::par.with_grain_size(100),
+                               execution::par.with_serial_cutoff(1 << 20)}) {
+                array_1d<int> b = a;
+                hg::sort(policy, b.begin(), b.end(), std::less<int>());
+                REQUIRE(std::equal(b.begin(), b.end(), ref.begin()));
+
+                std::vector<index_t> indices(size);
+                std::iota(indices.begin(), indices.end(), 0);
+                std::vector<index_t> ref_indices = indices;
+                auto comp = [&a](index_t i, index_t j) { return a(i) < a(j); };
+                std::stable_sort(ref_indices.begin(), ref_indices.end(), comp);
+                hg::stable_sort(policy, indices.begin(), indices.end(), comp);
+                REQUIRE((indices == ref_indices));
+            }
+        }
+    }
+}
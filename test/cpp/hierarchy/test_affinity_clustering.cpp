@@ -0,0 +1,122 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/affinity_clustering.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace affinity_clustering_test {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("affinity clustering path graph", "[affinity_clustering]") {
+        ugraph g(5);
+        add_edges(array_1d<index_t>{0, 1, 2, 3}, array_1d<index_t>{1, 2, 3, 4}, g);
+        array_1d<double> weights{1, 5, 2, 6};
+
+        auto res = affinity_clustering(g, weights);
+        array_1d<index_t> expected_parents{5, 5, 6, 6, 6, 7, 7, 7};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 1, 6, 6};
+        REQUIRE((parents(res.tree) == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+
+        auto res2 = affinity_clustering(g, weights, affinity_linkage::single, "none");
+        array_1d<double> expected_altitudes2{0, 0, 0, 0, 0, 1, 6, 5};
+        REQUIRE((parents(res2.tree) == expected_parents));
+        REQUIRE((res2.altitudes == expected_altitudes2));
+    }
+
+    TEST_CASE("affinity clustering thresholds", "[affinity_clustering]") {
+        ugraph g(5);
+        add_edges(array_1d<index_t>{0, 1, 2, 3}, array_1d<index_t>{1, 2, 3, 4}, g);
+        array_1d<double> weights{1, 5, 2, 6};
+
+        // the first round only merges 0 and 1, the second round is unconstrained
+        auto res = affinity_clustering(g, weights, affinity_linkage::single, xt::ones<double>({4}),
+                                       array_1d<double>{1.5}, "max");
+        array_1d<index_t> expected_parents{5, 5, 6, 6, 6, 6, 6};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 1, 6};
+        REQUIRE((parents(res.tree) == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+
+        // no merge below the first threshold
+        auto res2 = affinity_clustering(g, weights, affinity_linkage::single, xt::ones<double>({4}),
+                                        array_1d<double>{0, 1.5}, "max");
+        REQUIRE((parents(res2.tree) == expected_parents));
+    }
+
+    TEST_CASE("affinity clustering linkages", "[affinity_clustering]") {
+        // two clusters {0, 1} and {2, 3} linked by two edges of weights 4 and 6
+        ugraph g(4);
+        add_edges(array_1d<index_t>{0, 1, 2, 3}, array_1d<index_t>{1, 2, 3, 0}, g);
+        array_1d<double> weights{1, 4, 1, 6};
+        array_1d<index_t> expected_parents{4, 4, 5, 5, 6, 6, 6};
+
+        auto res_single = affinity_clustering(g, weights, affinity_linkage::single);
+        REQUIRE((parents(res_single.tree) == expected_parents));
+        REQUIRE(res_single.altitudes(6) == 4);
+
+        auto res_complete = affinity_clustering(g, weights, affinity_linkage::complete);
+        REQUIRE((parents(res_complete.tree) == expected_parents));
+        REQUIRE(res_complete.altitudes(6) == 6);
+
+        auto res_average = affinity_clustering(g, weights, affinity_linkage::average);
+        REQUIRE((parents(res_average.tree) == expected_parents));
+        REQUIRE(res_average.altitudes(6) == 5);
+
+        array_1d<double> weight_weights{1, 3, 1, 1};
+        auto res_average2 = affinity_clustering(g, weights, affinity_linkage::average, weight_weights,
+                                                array_1d<double>::from_shape({0}));
+        REQUIRE(res_average2.altitudes(6) == 4.5);
+    }
+
+    TEST_CASE("affinity clustering disconnected graph", "[affinity_clustering]") {
+        ugraph g(5);
+        add_edges(array_1d<index_t>{0, 1, 3}, array_1d<index_t>{1, 2, 4}, g);
+        array_1d<double> weights{2, 1, 3};
+
+        auto res = affinity_clustering(g, weights);
+        array_1d<index_t> expected_parents{5, 5, 5, 6, 6, 7, 7, 7};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 2, 3, 3};
+        REQUIRE((parents(res.tree) == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+
+        ugraph g2(1);
+        auto res2 = affinity_clustering(g2, array_1d<double>::from_shape({0}));
+        REQUIRE(num_vertices(res2.tree) == 1);
+    }
+
+    TEST_CASE("affinity clustering single linkage random", "[affinity_clustering]") {
+        // the single linkage affinity hierarchy is coarser than the single linkage hierarchy
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({40, 50});
+        array_1d<double> weights = xt::random::randint<int>({num_edges(g)}, 0, 30);
+        auto res = affinity_clustering(g, weights);
+        REQUIRE(num_leaves(res.tree) == num_vertices(g));
+        for (auto n: leaves_to_root_iterator(res.tree, leaves_it::exclude, root_it::exclude)) {
+            REQUIRE(res.altitudes(n) <= res.altitudes(parent(n, res.tree)));
+        }
+
+        auto bpt = bpt_canonical(g, weights);
+        auto sm = saliency_map(g, res.tree, res.altitudes);
+        auto sm_bpt = saliency_map(g, bpt.tree, bpt.altitudes);
+        REQUIRE(xt::all(sm >= sm_bpt));
+        REQUIRE(xt::all(sm_bpt <= weights));
+
+        // each internal node merges at least two clusters
+        res.tree.compute_children();
+        for (auto n: leaves_to_root_iterator(res.tree, leaves_it::exclude)) {
+            REQUIRE(num_children(n, res.tree) >= 2);
+        }
+    }
+}
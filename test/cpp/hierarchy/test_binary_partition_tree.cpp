@@ -84,6 +84,115 @@ namespace binary_partition_tree {
         REQUIRE((expected_levels == levels));
     }
 
+    void complete_linkage_callback(index_t, index_t, index_t, index_t,
+                                   index_t num_neighbours,
+                                   const index_t *,
+                                   const index_t *first_edge_indices,
+                                   const index_t *second_edge_indices,
+                                   double *new_edge_weights,
+                                   void *user_data) {
+        auto weights = static_cast<double *>(user_data);
+        for (index_t i = 0; i < num_neighbours; i++) {
+            double w = weights[first_edge_indices[i]];
+            if (second_edge_indices[i] != invalid_index) {
+                w = (std::max)(w, weights[second_edge_indices[i]]);
+            }
+            new_edge_weights[i] = w;
+            weights[first_edge_indices[i]] = w;
+        }
+    }
+
+    TEST_CASE("custom linkage inspecting the region graph", "[binary_partition_tree]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        index_t ne = (index_t) num_edges(graph);
+        for (index_t i = 0; i < ne; i++) {
+            auto e = edge_from_index(i, graph);
+            add_edge(source(e, graph), target(e, graph), graph);
+        }
+        array_1d<double> edge_weights({1, 8, 2, 10, 15, 3, 11, 4, 12, 13, 5, 6,
+                                       1, 8, 2, 10, 15, 3, 11, 4, 12, 13, 5, 6});
+        array_1d<double> weights = edge_weights;
+
+        index_t num_calls = 0;
+        auto weighter = [&weights, &num_calls](const auto &g,
+                                               index_t fusion_edge_index,
+                                               index_t new_region,
+                                               index_t merged_region1,
+                                               index_t merged_region2,
+                                               const auto &new_neighbours) {
+            num_calls++;
+            REQUIRE(num_vertices(g) == (size_t) new_region + 1);
+            REQUIRE(num_edges(g) == weights.size());
+            REQUIRE(source(edge_from_index(fusion_edge_index, g), g) == invalid_index);
+
+            // the new region is linked to its neighbours, the merged regions are not linked anymore
+            REQUIRE(degree(new_region, g) == new_neighbours.size());
+            REQUIRE(out_degree(merged_region1, g) == 0);
+            REQUIRE(in_degree(merged_region2, g) == 0);
+            std::vector<index_t> neighbours;
+            for (auto n: adjacent_vertex_iterator(new_region, g)) {
+                neighbours.push_back(n);
+            }
+            std::vector<index_t> edge_indices;
+            for (auto e: out_edge_iterator(new_region, g)) {
+                REQUIRE(source(e, g) == new_region);
+                REQUIRE((size_t) target(e, g) < num_vertices(g));
+                REQUIRE(degree(target(e, g), g) > 0);
+                edge_indices.push_back(index(e, g));
+            }
+            std::vector<index_t> expected_neighbours;
+            std::vector<index_t> expected_edge_indices;
+            for (auto &n: new_neighbours) {
+                expected_neighbours.push_back(n.neighbour_vertex());
+                expected_edge_indices.push_back(n.new_edge_index());
+                auto e = edge_from_index(n.new_edge_index(), g);
+                REQUIRE(((e.source == n.neighbour_vertex() && e.target == new_region) ||
+                         (e.source == new_region && e.target == n.neighbour_vertex())));
+                if (n.num_edges() > 1) {
+                    REQUIRE(edge_from_index(n.second_edge_index(), g).source == invalid_index);
+                    weights[n.new_edge_index()] = (std::max)(weights[n.first_edge_index()],
+                                                             weights[n.second_edge_index()]);
+                }
+                n.new_edge_weight() = weights[n.new_edge_index()];
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            std::sort(expected_neighbours.begin(), expected_neighbours.end());
+            std::sort(edge_indices.begin(), edge_indices.end());
+            std::sort(expected_edge_indices.begin(), expected_edge_indices.end());
+            REQUIRE((neighbours == expected_neighbours));
+            REQUIRE((edge_indices == expected_edge_indices));
+        };
+
+        auto res = hg::binary_partition_tree(graph, edge_weights, weighter);
+        auto ref = binary_partition_tree_complete_linkage(graph, edge_weights);
+        REQUIRE(num_calls > 0);
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+    }
+
+    TEST_CASE("compiled linkage callback", "[binary_partition_tree]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        array_1d<double> edge_weights({1, 8, 2, 10, 15, 3, 11, 4, 12, 13, 5, 6});
+        array_1d<double> state = edge_weights;
+        auto res = binary_partition_tree_compiled_linkage(graph, edge_weights, &complete_linkage_callback,
+                                                          state.data());
+
+        array_1d<index_t> expected_parents({9, 9, 10, 11, 11, 12, 13, 13, 14, 10, 16, 12, 15, 14, 15, 16, 16});
+        array_1d<double> expected_levels({0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 13, 15});
+        REQUIRE((expected_parents == res.tree.parents()));
+        REQUIRE((expected_levels == res.altitudes));
+
+        xt::random::seed(7);
+        auto g = get_4_adjacency_graph({20, 25});
+        array_1d<float> random_weights = xt::random::rand<double>({num_edges(g)});
+        array_1d<double> random_state = random_weights;
+        auto r1 = binary_partition_tree_compiled_linkage(g, random_weights, &complete_linkage_callback,
+                                                         random_state.data());
+        auto r2 = binary_partition_tree_complete_linkage(g, random_weights);
+        REQUIRE((r1.tree.parents() == r2.tree.parents()));
+        REQUIRE((r1.altitudes == r2.altitudes));
+    }
+
     TEST_CASE("average linkage clustering simple", "[binary_partition_tree]") {
         auto graph = get_4_adjacency_graph({3, 3});
         array_1d<double> edge_weights({1, 7, 2, 10, 16, 3, 11, 4, 12, 14, 5, 6});
@@ -130,6 +239,45 @@ namespace binary_partition_tree {
         REQUIRE(xt::allclose(expected_altitudes, altitudes));
     }
 
+    TEST_CASE("ward linkage clustering high dimension", "[binary_partition_tree]") {
+        // padded centroid rows, vectorized distances and single precision storage
+        xt::random::seed(1);
+        auto graph = get_4_adjacency_graph({7, 9});
+        for (index_t dim: {5, 8, 21, 64}) {
+            array_2d<double> vertex_centroids = xt::random::rand<double>({(size_t) num_vertices(graph), (size_t) dim});
+            array_1d<double> vertex_sizes = xt::random::randint<int>({num_vertices(graph)}, 1, 5);
+
+            auto res = binary_partition_tree_ward_linkage(graph, vertex_centroids, vertex_sizes, "none");
+
+            // reference: centroids and distances of the clusters recomputed from the tree
+            auto &tree = res.tree;
+            array_1d<double> sizes = xt::zeros<double>({num_vertices(tree)});
+            array_2d<double> sums = xt::zeros<double>({num_vertices(tree), (size_t) dim});
+            for (index_t i = 0; i < (index_t) num_leaves(tree); i++) {
+                sizes(i) = vertex_sizes(i);
+                xt::view(sums, i, xt::all()) = xt::view(vertex_centroids, i, xt::all()) * vertex_sizes(i);
+            }
+            for (auto n: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+                sizes(parent(n, tree)) += sizes(n);
+                xt::view(sums, parent(n, tree), xt::all()) += xt::view(sums, n, xt::all());
+            }
+            tree.compute_children();
+            for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
+                auto c1 = child(0, n, tree);
+                auto c2 = child(1, n, tree);
+                double d = xt::sum(xt::square(xt::view(sums, c1, xt::all()) / sizes(c1) -
+                                              xt::view(sums, c2, xt::all()) / sizes(c2)))();
+                REQUIRE(std::abs(res.altitudes(n) - sizes(c1) * sizes(c2) / (sizes(c1) + sizes(c2)) * d) < 1e-9);
+            }
+
+            array_2d<float> vertex_centroids_f = vertex_centroids;
+            array_1d<float> vertex_sizes_f = vertex_sizes;
+            auto res_f = binary_partition_tree_ward_linkage(graph, vertex_centroids_f, vertex_sizes_f, "none");
+            REQUIRE(num_vertices(res_f.tree) == num_vertices(tree));
+            REQUIRE(res_f.altitudes(0) == 0);
+        }
+    }
+
     TEST_CASE("ward linkage non increasing", "[binary_partition_tree]") {
         ugraph graph(3);
 
@@ -234,4 +382,169 @@ namespace binary_partition_tree {
         REQUIRE(r3.tree.parents() == r3_ref.tree.parents());
     }
 
+    TEST_CASE("exponential linkage clustering large alpha", "[binary_partition_tree]") {
+        xt::random::seed(10);
+        auto g = get_4_adjacency_graph({5, 5});
+        array_1d<float> edge_weights = xt::random::rand<float>({num_edges(g)}) * 100.0f;
+        array_1d<float> edge_weight_weights = xt::random::randint<int>({num_edges(g)}, 1, 10);
+
+        // exp(alpha * w) overflows or underflows in float32 but the log domain state does not
+        auto r1 = binary_partition_tree_exponential_linkage(g, edge_weights, 1000.0f, edge_weight_weights);
+        auto r1_ref = binary_partition_tree_complete_linkage(g, edge_weights);
+        REQUIRE(r1.tree.parents() == r1_ref.tree.parents());
+        REQUIRE((r1.altitudes == r1_ref.altitudes));
+
+        auto r2 = binary_partition_tree_exponential_linkage(g, edge_weights, -1000.0f, edge_weight_weights);
+        auto r2_ref = binary_partition_tree_min_linkage(g, edge_weights);
+        REQUIRE(r2.tree.parents() == r2_ref.tree.parents());
+        REQUIRE((r2.altitudes == r2_ref.altitudes));
+
+        auto inf = std::numeric_limits<float>::infinity();
+        auto r3 = binary_partition_tree_exponential_linkage(g, edge_weights, inf, edge_weight_weights);
+        REQUIRE(r3.tree.parents() == r1_ref.tree.parents());
+        REQUIRE((r3.altitudes == r1_ref.altitudes));
+        auto r4 = binary_partition_tree_exponential_linkage(g, edge_weights, -inf, edge_weight_weights);
+        REQUIRE(r4.tree.parents() == r2_ref.tree.parents());
+        REQUIRE((r4.altitudes == r2_ref.altitudes));
+
+        // altitudes are weighted means of the edge weights
+        auto r5 = binary_partition_tree_exponential_linkage(g, edge_weights, 0.5f, edge_weight_weights);
+        REQUIRE(xt::all(xt::isfinite(r5.altitudes)));
+        REQUIRE(xt::amax(r5.altitudes)() <= xt::amax(edge_weights)());
+    }
+
+    TEST_CASE("exponential linkage clustering multi alpha", "[binary_partition_tree]") {
+        xt::random::seed(10);
+        auto g = get_4_adjacency_graph({6, 7});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        array_1d<double> edge_weight_weights = xt::random::randint<int>({num_edges(g)}, 1, 10);
+        array_1d<double> alphas{-std::numeric_limits<double>::infinity(), -3, 0, 1.5, 50};
+
+        auto res = binary_partition_tree_exponential_linkage_multi(g, edge_weights, alphas, edge_weight_weights);
+        REQUIRE(res.size() == alphas.size());
+        for (index_t i = 0; i < (index_t) alphas.size(); i++) {
+            auto ref = binary_partition_tree_exponential_linkage(g, edge_weights, alphas(i), edge_weight_weights);
+            REQUIRE(res[i].tree.parents() == ref.tree.parents());
+            REQUIRE((res[i].altitudes == ref.altitudes));
+        }
+
+        auto res_nn = binary_partition_tree_exponential_linkage_multi<bpt_nn_chain>(g, edge_weights, alphas,
+                                                                                    edge_weight_weights);
+        REQUIRE(res_nn[2].tree.parents() == res[2].tree.parents());
+    }
+
+    TEST_CASE("linkage clustering heap policies", "[binary_partition_tree]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({20, 25});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        array_1d<double> edge_weight_weights = xt::random::randint<int>({num_edges(g)}, 1, 10);
+
+        auto ref_complete = hg::binary_partition_tree(
+                g, edge_weights,
+                binary_partition_tree_internal::binary_partition_tree_complete_linkage_weighting_functor<array_1d<double>>(
+                        edge_weights));
+        auto r1 = binary_partition_tree_complete_linkage(g, edge_weights);
+        auto r2 = binary_partition_tree_complete_linkage<bpt_fibonacci_heap>(g, edge_weights);
+        auto r3 = binary_partition_tree_complete_linkage<bpt_dary_heap<2>>(g, edge_weights);
+        auto r3b = binary_partition_tree_complete_linkage<bpt_pairing_heap>(g, edge_weights);
+        REQUIRE(r1.tree.parents() == ref_complete.tree.parents());
+        REQUIRE(r2.tree.parents() == ref_complete.tree.parents());
+        REQUIRE(r3.tree.parents() == ref_complete.tree.parents());
+        REQUIRE(r3b.tree.parents() == ref_complete.tree.parents());
+        REQUIRE((r1.altitudes == ref_complete.altitudes));
+
+        auto ref_average = hg::binary_partition_tree(
+                g, edge_weights,
+                binary_partition_tree_internal::binary_partition_tree_average_linkage_weighting_functor<array_1d<double>>(
+                        edge_weights, edge_weight_weights));
+        auto r4 = binary_partition_tree_average_linkage(g, edge_weights, edge_weight_weights);
+        auto r5 = binary_partition_tree_average_linkage<bpt_fibonacci_heap>(g, edge_weights, edge_weight_weights);
+        REQUIRE(r4.tree.parents() == ref_average.tree.parents());
+        REQUIRE(r5.tree.parents() == ref_average.tree.parents());
+        REQUIRE(xt::allclose(r4.altitudes, ref_average.altitudes));
+
+        array_2d<double> vertex_centroids = xt::random::rand<double>({num_vertices(g), (size_t) 3});
+        array_1d<double> vertex_sizes = xt::random::randint<int>({num_vertices(g)}, 1, 10);
+        auto r6 = binary_partition_tree_ward_linkage(g, vertex_centroids, vertex_sizes);
+        auto r7 = binary_partition_tree_ward_linkage<bpt_fibonacci_heap>(g, vertex_centroids, vertex_sizes);
+        REQUIRE(r6.tree.parents() == r7.tree.parents());
+        REQUIRE(xt::allclose(r6.altitudes, r7.altitudes));
+    }
+
+    TEST_CASE("linkage clustering heap policies equal weights", "[binary_partition_tree]") {
+        auto g = get_4_adjacency_graph({10, 10});
+        array_1d<double> edge_weights = xt::ones<double>({num_edges(g)});
+
+        // ties are broken by edge index with the d-ary and pairing heaps
+        auto r1 = binary_partition_tree_complete_linkage(g, edge_weights);
+        auto r2 = binary_partition_tree_complete_linkage<bpt_dary_heap<8>>(g, edge_weights);
+        auto r3 = binary_partition_tree_complete_linkage<bpt_pairing_heap>(g, edge_weights);
+        REQUIRE(r1.tree.parents() == r2.tree.parents());
+        REQUIRE(r1.tree.parents() == r3.tree.parents());
+        REQUIRE(num_leaves(r1.tree) == num_vertices(g));
+        for (index_t i = num_vertices(g); i < (index_t) num_vertices(r1.tree); i++) {
+            REQUIRE(r1.altitudes(i) == 1);
+        }
+    }
+
+    TEST_CASE("linkage clustering nn chain", "[binary_partition_tree]") {
+        xt::random::seed(7);
+        auto g = get_4_adjacency_graph({20, 25});
+        array_1d<double> edge_weights = xt::random::rand<double>({num_edges(g)});
+        array_1d<double> edge_weight_weights = xt::random::randint<int>({num_edges(g)}, 1, 10);
+
+        auto r1 = binary_partition_tree_complete_linkage(g, edge_weights);
+        auto r1_nn = binary_partition_tree_complete_linkage<bpt_nn_chain>(g, edge_weights);
+        REQUIRE(r1.tree.parents() == r1_nn.tree.parents());
+        REQUIRE((r1.altitudes == r1_nn.altitudes));
+
+        auto r2 = binary_partition_tree_average_linkage(g, edge_weights, edge_weight_weights);
+        auto r2_nn = binary_partition_tree_average_linkage<bpt_nn_chain>(g, edge_weights, edge_weight_weights);
+        REQUIRE(r2.tree.parents() == r2_nn.tree.parents());
+        REQUIRE(xt::allclose(r2.altitudes, r2_nn.altitudes));
+
+        auto r3 = binary_partition_tree_exponential_linkage(g, edge_weights, 2, edge_weight_weights);
+        auto r3_nn = binary_partition_tree_exponential_linkage<bpt_nn_chain>(g, edge_weights, 2, edge_weight_weights);
+        REQUIRE(r3.tree.parents() == r3_nn.tree.parents());
+        REQUIRE(xt::allclose(r3.altitudes, r3_nn.altitudes));
+    }
+
+    TEST_CASE("ward linkage clustering nn chain", "[binary_partition_tree]") {
+        ugraph graph(5);
+        array_1d<index_t> sources{0, 0, 0, 1, 2, 2, 3};
+        array_1d<index_t> targets{1, 2, 3, 2, 3, 4, 4};
+        add_edges(sources, targets, graph);
+        array_2d<double> vertex_centroids{
+                {0,  0},
+                {1,  1},
+                {1,  3},
+                {-3, 4},
+                {-1, 5}};
+        array_1d<double> vertex_sizes{1, 1, 1, 2, 1};
+
+        auto res = binary_partition_tree_ward_linkage<bpt_nn_chain>(graph, vertex_centroids, vertex_sizes);
+
+        array_1d<index_t> expected_parents{5, 5, 7, 6, 6, 7, 8, 8, 8};
+        array_1d<double> expected_altitudes{0., 0., 0., 0., 0.,
+                                            1., 3.333333, 4.333333, 27.};
+        REQUIRE((expected_parents == parents(res.tree)));
+        REQUIRE(xt::allclose(expected_altitudes, res.altitudes));
+    }
+
+    TEST_CASE("linkage clustering nn chain small graph", "[binary_partition_tree]") {
+        ugraph graph(6);
+        array_1d<index_t> sources{0, 1, 0, 3, 4, 3};
+        array_1d<index_t> targets{1, 2, 2, 4, 5, 5};
+        add_edges(sources, targets, graph);
+        add_edge(2, 3, graph);
+        array_1d<double> edge_weights{1, 3, 5, 2, 4, 6, 10};
+
+        auto r = binary_partition_tree_complete_linkage(graph, edge_weights);
+        auto r_nn = binary_partition_tree_complete_linkage<bpt_nn_chain>(graph, edge_weights);
+        array_1d<index_t> expected_parents{6, 6, 8, 7, 7, 9, 8, 9, 10, 10, 10};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 0, 1, 2, 5, 6, 10};
+        REQUIRE((r.tree.parents() == expected_parents));
+        REQUIRE((r_nn.tree.parents() == expected_parents));
+        REQUIRE((r_nn.altitudes == expected_altitudes));
+    }
 }
@@ -14,6 +14,7 @@
 #include "higra/image/graph_image.hpp"
 #include "higra/algo/tree.hpp"
 #include "xtensor/xadapt.hpp"
+#include "xtensor/xrandom.hpp"
 
 using namespace hg;
 using namespace std;
@@ -48,11 +49,12 @@ namespace binary_partition_tree {
         std::stable_sort(sorted_vertex_indices.begin(), sorted_vertex_indices.end(),
                          [&vertex_weights](index_t i, index_t j) { return vertex_weights[i] < vertex_weights[j]; });
 
-        array_1d<index_t> parents({0, 0, 9, 2,
-                                   5, 10, 5, 6,
-                                   11, 8, 3, 1,
-                                   13, 14, 10, 14});
+        array_1d<index_t> pre_parents({0, 0, 9, 2,
+                                       5, 10, 5, 6,
+                                       11, 8, 3, 1,
+                                       13, 14, 10, 14});
 
+        array_1d<index_t> parents = pre_parents;
         component_tree_internal::canonize_tree(parents, vertex_weights, sorted_vertex_indices);
 
         array_1d<index_t> expected_parents({0, 0, 9, 2,
@@ -60,6 +62,13 @@ namespace binary_partition_tree {
                                             1, 8, 2, 1,
                                             13, 14, 2, 14});
         REQUIRE((expected_parents == parents));
+
+        for (index_t num_blocks: {1, 2, 3, 5, 16}) {
+            array_1d<index_t> parallel_parents = pre_parents;
+            component_tree_internal::parallel_canonize_tree(parallel_parents, vertex_weights, sorted_vertex_indices,
+                                                            num_blocks);
+            REQUIRE((expected_parents == parallel_parents));
+        }
     }
 
     TEST_CASE("test expand_canonized_parent_relation", "[component_tree]") {
@@ -184,4 +193,131 @@ namespace binary_partition_tree {
 
         REQUIRE((expected_filtered_weights == filtered_weights));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("test parallel max tree and min tree", "[component_tree]") {
+        auto graph = get_4_adjacency_implicit_graph({4, 4});
+        array_1d<double> vertex_weights({0, 1, 4, 4,
+                                         7, 5, 6, 8,
+                                         2, 3, 4, 1,
+                                         9, 8, 6, 7});
+
+        array_1d<index_t> expected_parents({28, 27, 24, 24,
+                                            20, 23, 22, 18,
+                                            26, 25, 24, 27,
+                                            16, 17, 21, 19,
+                                            17, 21, 22, 21, 23, 24, 23, 24, 25, 26, 27, 28, 28});
+        for (index_t num_blocks: {1, 2, 3, 4, 16}) {
+            auto res = component_tree_parallel_max_tree(graph, vertex_weights, num_blocks);
+            REQUIRE(category(res.tree) == tree_category::component_tree);
+            REQUIRE((expected_parents == res.tree.parents()));
+            array_1d<double> neg_weights = -vertex_weights;
+            auto res2 = component_tree_parallel_min_tree(graph, neg_weights, num_blocks);
+            REQUIRE((expected_parents == res2.tree.parents()));
+            REQUIRE((res.altitudes == -res2.altitudes));
+        }
+    }
+
+    TEST_CASE("test parallel max tree random", "[component_tree]") {
+        xt::random::seed(42);
+        auto graph4 = get_4_adjacency_graph({37, 41});
+        auto graph8 = get_8_adjacency_graph({37, 41});
+        for (int num_levels: {3, 20, 1000}) {
+            array_1d<int> vertex_weights = xt::random::randint<int>({37 * 41}, 0, num_levels);
+            auto ref4 = component_tree_max_tree(graph4, vertex_weights);
+            auto ref8 = component_tree_min_tree(graph8, vertex_weights);
+            for (index_t num_blocks: {2, 5, 7, 64, 300}) {
+                auto res4 = component_tree_parallel_max_tree(graph4, vertex_weights, num_blocks);
+                REQUIRE((ref4.tree.parents() == res4.tree.parents()));
+                REQUIRE((ref4.altitudes == res4.altitudes));
+                auto res8 = component_tree_parallel_min_tree(graph8, vertex_weights, num_blocks);
+                REQUIRE((ref8.tree.parents() == res8.tree.parents()));
+                REQUIRE((ref8.altitudes == res8.altitudes));
+            }
+        }
+    }
+
+    TEST_CASE("test max tree regular graph fast path", "[component_tree]") {
+        xt::random::seed(42);
+        auto graph4 = get_4_adjacency_implicit_graph({23, 17});
+        auto graph8 = get_8_adjacency_implicit_graph({23, 17});
+        auto ugraph4 = copy_graph(graph4);
+        auto ugraph8 = copy_graph(graph8);
+        for (int num_levels: {3, 1000}) {
+            array_1d<int> vertex_weights = xt::random::randint<int>({23 * 17}, 0, num_levels);
+            auto res4 = component_tree_max_tree(graph4, vertex_weights);
+            auto ref4 = component_tree_max_tree(ugraph4, vertex_weights);
+            REQUIRE((ref4.tree.parents() == res4.tree.parents()));
+            REQUIRE((ref4.altitudes == res4.altitudes));
+            auto res8 = component_tree_min_tree(graph8, vertex_weights);
+            auto ref8 = component_tree_min_tree(ugraph8, vertex_weights);
+            REQUIRE((ref8.tree.parents() == res8.tree.parents()));
+            REQUIRE((ref8.altitudes == res8.altitudes));
+        }
+    }
+
+    template<typename graph_t>
+    array_1d<int> reference_attribute_filter(const graph_t &graph, const array_1d<int> &vertex_weights,
+                                             double threshold, bool max_tree, bool volume) {
+        auto res = max_tree ? component_tree_max_tree(graph, vertex_weights) :
+                   component_tree_min_tree(graph, vertex_weights);
+        auto &tree = res.tree;
+        array_1d<double> attribute = attribute_area(tree);
+        if (volume) {
+            attribute = attribute_volume(tree, res.altitudes, attribute);
+        }
+        array_1d<bool> deleted = attribute < threshold;
+        deleted(root(tree)) = false;
+        return reconstruct_leaf_data(tree, res.altitudes, deleted);
+    }
+
+    TEST_CASE("test area and volume filters", "[component_tree]") {
+        xt::random::seed(42);
+        auto graph4 = get_4_adjacency_implicit_graph({23, 17});
+        auto graph8 = get_8_adjacency_graph({23, 17});
+        for (int num_levels: {3, 20, 1000}) {
+            array_1d<int> vertex_weights = xt::random::randint<int>({23 * 17}, 0, num_levels);
+            for (double threshold: {1., 2., 5., 30., 1000.}) {
+                REQUIRE((area_opening(graph4, vertex_weights, threshold) ==
+                         reference_attribute_filter(graph4, vertex_weights, threshold, true, false)));
+                REQUIRE((area_closing(graph8, vertex_weights, threshold) ==
+                         reference_attribute_filter(graph8, vertex_weights, threshold, false, false)));
+                REQUIRE((volume_opening(graph8, vertex_weights, threshold * 10) ==
+                         reference_attribute_filter(graph8, vertex_weights, threshold * 10, true, true)));
+                REQUIRE((volume_closing(graph4, vertex_weights, threshold * 10) ==
+                         reference_attribute_filter(graph4, vertex_weights, threshold * 10, false, true)));
+            }
+        }
+    }
+
+    TEST_CASE("test area opening simple", "[component_tree]") {
+        auto graph = get_4_adjacency_implicit_graph({3, 4});
+        array_1d<int> vertex_weights{5, 5, 1, 1,
+                                     5, 1, 1, 3,
+                                     1, 1, 4, 3};
+        array_1d<int> expected{1, 1, 1, 1,
+                               1, 1, 1, 1,
+                               1, 1, 1, 1};
+        REQUIRE((area_opening(graph, vertex_weights, 4) == expected));
+        array_1d<int> expected2{5, 5, 1, 1,
+                                5, 1, 1, 3,
+                                1, 1, 3, 3};
+        REQUIRE((area_opening(graph, vertex_weights, 2) == expected2));
+        REQUIRE((area_opening(graph, vertex_weights, 3) == expected2));
+    }
+
+    TEST_CASE("test area pattern spectrum", "[component_tree]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_implicit_graph({23, 17});
+        array_1d<int> vertex_weights = xt::random::randint<int>({23 * 17}, 0, 50);
+        array_1d<double> thresholds{2, 3, 10, 50, 100, 1000};
+        auto spectrum = area_pattern_spectrum(graph, vertex_weights, thresholds);
+        REQUIRE(spectrum.size() == thresholds.size());
+
+        array_1d<int> previous = vertex_weights;
+        for (index_t i = 0; i < (index_t) thresholds.size(); i++) {
+            array_1d<int> filtered = area_opening(graph, vertex_weights, thresholds(i));
+            REQUIRE(spectrum(i) == (double) xt::sum(previous - filtered)());
+            previous = filtered;
+        }
+    }
+}
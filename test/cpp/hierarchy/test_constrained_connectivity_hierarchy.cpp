@@ -0,0 +1,44 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/constrained_connectivity_hierarchy.hpp"
+#include "higra/image/graph_image.hpp"
+#include "../test_utils.hpp"
+
+namespace test_constrained_connectivity_hierarchy {
+
+    using namespace hg;
+
+    TEST_CASE("alpha omega constrained connectivity hierarchy", "[constrained_connectivity_hierarchy]") {
+        auto graph = get_4_adjacency_graph({3, 3});
+        array_1d<int> vertex_weights{1, 2, 3,
+                                     5, 6, 5,
+                                     22, 21, 20};
+
+        auto res = constrained_connectivity_hierarchy_alpha_omega(graph, vertex_weights);
+
+        array_1d<index_t> expected_parents{11, 11, 11, 9, 9, 9, 10, 10, 10, 11, 12, 12, 12};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 5, 15};
+        REQUIRE((res.tree.parents() == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+    }
+
+    TEST_CASE("strongly constrained connectivity hierarchy", "[constrained_connectivity_hierarchy]") {
+        auto graph = get_4_adjacency_graph({2, 5});
+        array_1d<int> edge_weights{1, 3, 2, 1, 15, 1, 1, 1, 5, 1, 2, 15, 1};
+
+        auto res = constrained_connectivity_hierarchy_strong_connection(graph, edge_weights);
+
+        array_1d<index_t> expected_parents{12, 12, 10, 11, 11, 12, 12, 10, 11, 11, 12, 13, 13, 13};
+        array_1d<int> expected_altitudes{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 5, 3, 15};
+        REQUIRE((res.tree.parents() == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+    }
+}
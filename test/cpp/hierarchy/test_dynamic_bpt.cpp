@@ -0,0 +1,222 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/hierarchy/dynamic_bpt.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+#include <random>
+
+namespace dynamic_bpt {
+
+    using namespace hg;
+    using namespace std;
+
+    /**
+     * Compares the bpt of the dynamic structure with bpt_canonical on the graph made of its active vertices and
+     * remaining edges
+     */
+    template<typename value_t>
+    void check_bpt(const hg::dynamic_bpt<value_t> &dbpt,
+                   const std::vector<index_t> &sources,
+                   const std::vector<index_t> &targets,
+                   index_t num_v) {
+        auto active_vertices = dbpt.active_vertices();
+        std::vector<index_t> vertex_map(num_v, invalid_index);
+        for (index_t i = 0; i < (index_t) active_vertices.size(); i++) {
+            vertex_map[active_vertices(i)] = i;
+        }
+        ugraph g(active_vertices.size());
+        std::vector<index_t> edge_map;
+        std::vector<value_t> weights;
+        for (index_t e = 0; e < (index_t) sources.size(); e++) {
+            if (dbpt.is_edge_alive(e)) {
+                add_edge(vertex_map[sources[e]], vertex_map[targets[e]], g);
+                edge_map.push_back(e);
+                weights.push_back(dbpt.edge_weight(e));
+            }
+        }
+        auto ref = bpt_canonical(g, xt::adapt(weights, {weights.size()}));
+        auto res = dbpt.bpt();
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+        for (index_t i = 0; i < (index_t) ref.mst_edge_map.size(); i++) {
+            REQUIRE(res.mst_edge_map(i) == edge_map[ref.mst_edge_map(i)]);
+        }
+    }
+
+    TEST_CASE("dynamic bpt initial tree", "[dynamic_bpt]") {
+        auto g = get_4_adjacency_graph({2, 3});
+        array_1d<double> edge_weights{1, 0, 2, 1, 1, 1, 2};
+
+        hg::dynamic_bpt<double> dbpt(g, edge_weights);
+        REQUIRE(dbpt.num_mst_edges() == 5);
+        REQUIRE(!dbpt.is_mst_edge(5));
+        REQUIRE(!dbpt.is_mst_edge(6));
+
+        auto res = dbpt.bpt();
+        auto ref = bpt_canonical(g, edge_weights);
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+        REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+    }
+
+    TEST_CASE("dynamic bpt edge updates", "[dynamic_bpt]") {
+        auto g = get_4_adjacency_graph({2, 3});
+        array_1d<double> edge_weights{1, 0, 2, 1, 1, 1, 2};
+        std::vector<index_t> sources(hg::sources(g).begin(), hg::sources(g).end());
+        std::vector<index_t> targets(hg::targets(g).begin(), hg::targets(g).end());
+
+        hg::dynamic_bpt<double> dbpt(g, edge_weights);
+
+        // increase of a forest edge replaced by a non forest edge
+        dbpt.set_edge_weight(1, 3);
+        REQUIRE(!dbpt.is_mst_edge(1));
+        REQUIRE(dbpt.is_mst_edge(5));
+        check_bpt(dbpt, sources, targets, 6);
+
+        // decrease of a non forest edge
+        dbpt.set_edge_weight(1, 0);
+        REQUIRE(dbpt.is_mst_edge(1));
+        REQUIRE(!dbpt.is_mst_edge(5));
+        check_bpt(dbpt, sources, targets, 6);
+
+        // removal of a forest edge
+        dbpt.remove_edge(0);
+        REQUIRE(dbpt.num_mst_edges() == 5);
+        check_bpt(dbpt, sources, targets, 6);
+
+        // insertion of an edge
+        index_t e = dbpt.insert_edge(0, 5, 0.5);
+        sources.push_back(0);
+        targets.push_back(5);
+        REQUIRE(e == 7);
+        REQUIRE(dbpt.is_mst_edge(e));
+        REQUIRE(!dbpt.is_mst_edge(2));
+        check_bpt(dbpt, sources, targets, 6);
+
+        // disconnection
+        dbpt.remove_edge(3);
+        dbpt.remove_edge(e);
+        dbpt.remove_edge(6);
+        REQUIRE(dbpt.num_mst_edges() == 4);
+        REQUIRE_THROWS(dbpt.bpt());
+        REQUIRE_THROWS(dbpt.remove_edge(3));
+        REQUIRE_THROWS(dbpt.insert_edge(0, 6, 1));
+        dbpt.insert_edge(0, 2, 4);
+        sources.push_back(0);
+        targets.push_back(2);
+        REQUIRE(dbpt.num_mst_edges() == 5);
+        check_bpt(dbpt, sources, targets, 6);
+    }
+
+    TEST_CASE("dynamic bpt random updates", "[dynamic_bpt]") {
+        auto g = get_4_adjacency_graph({9, 11});
+        index_t num_v = num_vertices(g);
+        xt::random::seed(11);
+        // few distinct weights to exercise the tie breaking
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 6);
+        std::vector<index_t> sources(hg::sources(g).begin(), hg::sources(g).end());
+        std::vector<index_t> targets(hg::targets(g).begin(), hg::targets(g).end());
+
+        hg::dynamic_bpt<int> dbpt(g, edge_weights);
+        check_bpt(dbpt, sources, targets, num_v);
+
+        std::mt19937 gen(3);
+        std::uniform_int_distribution<int> weight(0, 5);
+        std::uniform_int_distribution<index_t> vertex(0, num_v - 1);
+        std::uniform_int_distribution<int> operation(0, 3);
+        for (index_t i = 0; i < 400; i++) {
+            index_t num_e = sources.size();
+            index_t e = std::uniform_int_distribution<index_t>(0, num_e - 1)(gen);
+            switch (operation(gen)) {
+                case 0: // insertion (possibly a self loop or a parallel edge)
+                    sources.push_back(vertex(gen));
+                    targets.push_back(vertex(gen));
+                    dbpt.insert_edge(sources.back(), targets.back(), weight(gen));
+                    break;
+                case 1: // removal
+                    if (dbpt.is_edge_alive(e)) {
+                        dbpt.remove_edge(e);
+                    }
+                    break;
+                default:
+                    if (dbpt.is_edge_alive(e)) {
+                        dbpt.set_edge_weight(e, weight(gen));
+                    }
+            }
+            if (dbpt.num_mst_edges() == num_v - 1) {
+                check_bpt(dbpt, sources, targets, num_v);
+            }
+        }
+    }
+
+    TEST_CASE("dynamic bpt vertex removal", "[dynamic_bpt]") {
+        auto g = get_4_adjacency_graph({2, 3});
+        array_1d<double> edge_weights{1, 0, 2, 1, 1, 1, 2};
+        std::vector<index_t> sources(hg::sources(g).begin(), hg::sources(g).end());
+        std::vector<index_t> targets(hg::targets(g).begin(), hg::targets(g).end());
+
+        hg::dynamic_bpt<double> dbpt(g, edge_weights);
+        dbpt.remove_vertex(4);
+        REQUIRE(!dbpt.is_vertex_active(4));
+        REQUIRE(dbpt.num_active_vertices() == 5);
+        REQUIRE((dbpt.active_vertices() == array_1d<index_t>{0, 1, 2, 3, 5}));
+        REQUIRE(dbpt.num_mst_edges() == 4);
+        REQUIRE(!dbpt.is_edge_alive(3));
+        REQUIRE(!dbpt.is_edge_alive(5));
+        REQUIRE(!dbpt.is_edge_alive(6));
+        check_bpt(dbpt, sources, targets, 6);
+        REQUIRE_THROWS(dbpt.insert_edge(4, 0, 1));
+
+        REQUIRE(dbpt.add_vertices(2) == 6);
+        REQUIRE(dbpt.insert_edge(6, 7, 1) == 7);
+        REQUIRE(dbpt.insert_edges(array_1d<index_t>{6, 3}, array_1d<index_t>{0, 7}, array_1d<double>{3, 2}) == 8);
+        sources.insert(sources.end(), {6, 6, 3});
+        targets.insert(targets.end(), {7, 0, 7});
+        REQUIRE(dbpt.num_mst_edges() == 6);
+        check_bpt(dbpt, sources, targets, 8);
+    }
+
+    TEST_CASE("dynamic bpt streaming with sliding window", "[dynamic_bpt]") {
+        // single linkage hierarchy of the last points of a stream of random points in the plane
+        std::mt19937 gen(5);
+        std::uniform_real_distribution<double> coordinate(0, 1);
+        const index_t window_size = 30;
+        const index_t num_neighbours = 4;
+
+        hg::dynamic_bpt<double> dbpt;
+        std::vector<double> x, y;
+        std::vector<index_t> sources, targets;
+        for (index_t batch = 0; batch < 12; batch++) {
+            index_t first = dbpt.add_vertices(8);
+            for (index_t v = first; v < first + 8; v++) {
+                x.push_back(coordinate(gen));
+                y.push_back(coordinate(gen));
+                // edges to a few previous active points: the graph stays connected
+                index_t n = 0;
+                for (index_t w = v - 1; w >= 0 && n < num_neighbours; w--) {
+                    if (dbpt.is_vertex_active(w)) {
+                        sources.push_back(w);
+                        targets.push_back(v);
+                        dbpt.insert_edge(w, v, std::hypot(x[v] - x[w], y[v] - y[w]));
+                        n++;
+                    }
+                }
+            }
+            dbpt.keep_last_vertices(window_size);
+            REQUIRE(dbpt.num_active_vertices() == std::min<index_t>(window_size, (batch + 1) * 8));
+            REQUIRE(dbpt.active_vertices()(0) == (index_t) x.size() - dbpt.num_active_vertices());
+            if (dbpt.num_mst_edges() == dbpt.num_active_vertices() - 1) {
+                check_bpt(dbpt, sources, targets, x.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/hierarchy/flat_zone_collapse.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/hierarchy/binary_partition_tree.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace flat_zone_collapse {
+
+    using namespace hg;
+
+    auto bpt_canonical_on_rag = [](const region_adjacency_graph &rag, const array_1d<double> &rag_edge_weights) {
+        auto res = bpt_canonical(rag.rag, rag_edge_weights);
+        return make_node_weighted_tree(std::move(res.tree), std::move(res.altitudes));
+    };
+
+    TEST_CASE("expand collapsed hierarchy", "[flat_zone_collapse]") {
+        // regions {0, 1}, {2}, {3, 4}
+        array_1d<index_t> vertex_map{0, 0, 1, 2, 2};
+        hg::tree tree(array_1d<index_t>{3, 3, 4, 4, 4});
+        array_1d<double> altitudes{0, 0, 0, 2, 3};
+
+        auto res = expand_collapsed_hierarchy(vertex_map, tree, altitudes, 1);
+        array_1d<index_t> ref_parents{5, 5, 7, 6, 6, 7, 8, 8, 8};
+        array_1d<double> ref_altitudes{0, 0, 0, 0, 0, 1, 1, 2, 3};
+        REQUIRE((res.tree.parents() == ref_parents));
+        REQUIRE((res.altitudes == ref_altitudes));
+    }
+
+    TEST_CASE("bpt canonical on collapsed flat zones", "[flat_zone_collapse]") {
+        xt::random::seed(1);
+        auto graph = get_4_adjacency_graph({12, 15});
+        array_1d<double> edge_weights = xt::floor(xt::random::rand<double>({num_edges(graph)}) * 4);
+        auto ref = bpt_canonical(graph, edge_weights);
+        auto ref_saliency = saliency_map(graph, ref.tree, ref.altitudes);
+
+        auto res = hierarchy_on_collapsed_flat_zones(graph, edge_weights, bpt_canonical_on_rag);
+        auto rag = make_region_adjacency_graph_from_graph_cut(graph, edge_weights);
+        REQUIRE(num_leaves(res.tree) == num_vertices(rag.rag));
+        REQUIRE((res.vertex_map == rag.vertex_map));
+        REQUIRE(num_vertices(res.tree) == 2 * num_vertices(rag.rag) - 1);
+
+        auto expanded = hierarchy_on_collapsed_flat_zones(graph, edge_weights, bpt_canonical_on_rag, 0, true);
+        REQUIRE(num_leaves(expanded.tree) == num_vertices(graph));
+        REQUIRE((expanded.vertex_map == xt::arange<index_t>(num_vertices(graph))));
+        REQUIRE((saliency_map(graph, expanded.tree, expanded.altitudes) == ref_saliency));
+
+        auto expanded1 = hierarchy_on_collapsed_flat_zones(graph, edge_weights, bpt_canonical_on_rag, 1, true);
+        array_1d<double> saliency1 = saliency_map(graph, expanded1.tree, expanded1.altitudes);
+        REQUIRE((xt::where(ref_saliency > 1, ref_saliency, 1) == xt::where(saliency1 > 1, saliency1, 1)));
+        REQUIRE(xt::amax(xt::filter(saliency1, ref_saliency <= 1))() <= 1);
+    }
+
+    TEST_CASE("average linkage on collapsed flat zones", "[flat_zone_collapse]") {
+        xt::random::seed(2);
+        auto graph = get_4_adjacency_graph({10, 10});
+        array_1d<double> edge_weights = xt::floor(xt::random::rand<double>({num_edges(graph)}) * 3);
+        array_1d<double> ones = xt::ones<double>({num_edges(graph)});
+
+        auto res = hierarchy_on_collapsed_flat_zones(
+                graph, edge_weights,
+                [&edge_weights, &ones](const region_adjacency_graph &rag, const array_1d<double> &) {
+                    array_1d<double> rag_sums = rag_accumulate(rag.edge_map, edge_weights, accumulator_sum());
+                    array_1d<double> rag_counts = rag_accumulate(rag.edge_map, ones, accumulator_sum());
+                    array_1d<double> rag_means = rag_sums / rag_counts;
+                    return binary_partition_tree_average_linkage(rag.rag, rag_means, rag_counts);
+                }, 0, true);
+
+        auto &tree = res.tree;
+        tree.compute_children();
+        REQUIRE(num_leaves(tree) == num_vertices(graph));
+        for (auto n: leaves_to_root_iterator(tree, leaves_it::include, root_it::exclude)) {
+            REQUIRE(res.altitudes(n) <= res.altitudes(parent(n, tree)));
+        }
+        // the only nodes of altitude 0 are the flat zones, whose children are the vertices of the graph
+        for (auto n: leaves_to_root_iterator(tree, leaves_it::exclude)) {
+            if (res.altitudes(n) == 0) {
+                for (auto c: children_iterator(n, tree)) {
+                    REQUIRE(is_leaf(c, tree));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/hdbscan.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace hdbscan_test {
+
+    using namespace hg;
+    using namespace std;
+
+    // points 0, 1, 3, 10, 11.5, 14, 40 linked by a path graph
+    ugraph path_graph() {
+        ugraph g(7);
+        add_edges(array_1d<index_t>{0, 1, 2, 3, 4, 5}, array_1d<index_t>{1, 2, 3, 4, 5, 6}, g);
+        return g;
+    }
+
+    array_1d<double> path_weights{1, 2, 7, 1.5, 2.5, 26};
+
+    void check_path_condensed_hierarchy(const condensed_hierarchy<tree, array_1d<double>> &res) {
+        array_1d<index_t> expected_parents{7, 7, 7, 8, 8, 8, 9, 9, 9, 9};
+        array_1d<double> expected_altitudes{0, 0, 0, 0, 0, 0, 0, 1, 1.5, 7};
+        array_1d<double> expected_stability{0, 0, 0, 0, 0, 0, 0,
+                                            (0.5 - 1. / 7) + 2 * (1 - 1. / 7),
+                                            (0.4 - 1. / 7) + 2 * (1 / 1.5 - 1. / 7),
+                                            1. / 26 + 6. / 7};
+        REQUIRE((parents(res.tree) == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+        REQUIRE(xt::allclose(res.stability, expected_stability));
+    }
+
+    TEST_CASE("core distances", "[hdbscan]") {
+        auto g = path_graph();
+
+        array_1d<double> expected1 = xt::zeros<double>({7});
+        REQUIRE((core_distances(g, path_weights, 1) == expected1));
+
+        array_1d<double> expected2{1, 1, 2, 1.5, 1.5, 2.5, 26};
+        REQUIRE((core_distances(g, path_weights, 2) == expected2));
+
+        array_1d<double> expected3{1, 2, 7, 7, 2.5, 26, 26};
+        REQUIRE((core_distances(g, path_weights, 3) == expected3));
+
+        array_1d<double> expected_mr{2, 7, 7, 7, 26, 26};
+        REQUIRE((mutual_reachability_weights(g, path_weights, expected3) == expected_mr));
+
+        ugraph g2(2);
+        REQUIRE((core_distances(g2, array_1d<double>::from_shape({0}), 3) == array_1d<double>{0, 0}));
+    }
+
+    TEST_CASE("condense hierarchy", "[hdbscan]") {
+        auto g = path_graph();
+        auto bpt = bpt_canonical(g, path_weights);
+        check_path_condensed_hierarchy(condense_hierarchy(bpt.tree, bpt.altitudes, 2));
+
+        // a single cluster, which vanishes when it splits into two clusters smaller than 4
+        auto res = condense_hierarchy(bpt.tree, bpt.altitudes, 4);
+        array_1d<index_t> expected_parents{7, 7, 7, 7, 7, 7, 7, 7};
+        REQUIRE((parents(res.tree) == expected_parents));
+        REQUIRE(res.altitudes(7) == 7);
+        REQUIRE(res.stability(7) == Approx(1. / 26 + 6. / 7));
+    }
+
+    TEST_CASE("hdbscan hierarchy", "[hdbscan]") {
+        auto g = path_graph();
+        // the mutual reachability distances with min_samples = 2 are equal to the original weights
+        check_path_condensed_hierarchy(hdbscan_hierarchy(g, path_weights, 1, 2));
+        check_path_condensed_hierarchy(hdbscan_hierarchy(g, path_weights, 2, 2));
+    }
+
+    TEST_CASE("hdbscan hierarchy random", "[hdbscan]") {
+        xt::random::seed(42);
+        auto g = get_8_adjacency_graph({30, 40});
+        array_1d<double> weights = xt::random::rand<double>({num_edges(g)}) + 0.1;
+        const index_t min_cluster_size = 10;
+        auto res = hdbscan_hierarchy(g, weights, 5, min_cluster_size);
+        auto &t = res.tree;
+
+        REQUIRE(num_leaves(t) == num_vertices(g));
+        REQUIRE(num_vertices(t) > num_leaves(t) + 1);
+        auto area = attribute_area(t);
+        t.compute_children();
+        for (auto n: leaves_to_root_iterator(t, leaves_it::exclude, root_it::exclude)) {
+            // a cluster is born when its parent cluster vanishes
+            REQUIRE(res.altitudes(n) <= res.altitudes(parent(n, t)));
+            REQUIRE(area(n) >= min_cluster_size);
+            REQUIRE(res.stability(n) > 0);
+        }
+        for (auto n: leaves_to_root_iterator(t, leaves_it::exclude)) {
+            index_t num_cluster_children = 0;
+            for (auto c: children_iterator(n, t)) {
+                if (!t.is_leaf(c)) {
+                    num_cluster_children++;
+                }
+            }
+            REQUIRE(num_cluster_children != 1);
+        }
+    }
+}
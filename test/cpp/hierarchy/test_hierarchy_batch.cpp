@@ -0,0 +1,161 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/hierarchy/hierarchy_batch.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace hierarchy_batch {
+
+    using namespace hg;
+
+    // stack of num_images random images of the given size
+    array_2d<double> random_images(index_t num_images, index_t num_pixels) {
+        xt::random::seed(42);
+        return xt::random::randint<int>({num_images, num_pixels}, 0, 10);
+    }
+
+    TEST_CASE("weight graph batch", "[hierarchy_batch]") {
+        auto g = get_4_adjacency_graph({4, 5});
+        auto images = random_images(6, 20);
+        auto edge_weights = weight_graph_batch(g, images, weight_functions::L1);
+        REQUIRE(edge_weights.shape()[0] == 6);
+        REQUIRE(edge_weights.shape()[1] == num_edges(g));
+        for (index_t i = 0; i < 6; i++) {
+            array_1d<double> image = xt::view(images, i, xt::all());
+            array_1d<double> ref = weight_graph(g, image, weight_functions::L1);
+            REQUIRE((xt::view(edge_weights, i, xt::all()) == ref));
+        }
+    }
+
+    TEST_CASE("bpt canonical batch", "[hierarchy_batch]") {
+        auto g = get_4_adjacency_graph({4, 5});
+        auto edge_weights = weight_graph_batch(g, random_images(7, 20), weight_functions::L1);
+        auto batch = bpt_canonical_batch(g, edge_weights);
+        REQUIRE(batch.num_trees() == 7);
+        REQUIRE(batch.offsets.size() == 8);
+        REQUIRE(batch.parents.size() == 7 * 39);
+        for (index_t i = 0; i < 7; i++) {
+            array_1d<double> weights = xt::view(edge_weights, i, xt::all());
+            auto ref = bpt_canonical(g, weights);
+            REQUIRE(batch.offsets(i) == i * 39);
+            REQUIRE((batch.get_tree(i).parents() == ref.tree.parents()));
+            REQUIRE((batch.tree_altitudes(i) == ref.altitudes));
+            REQUIRE((xt::view(batch.mst_edge_map, i, xt::all()) == ref.mst_edge_map));
+        }
+    }
+
+    TEST_CASE("watershed hierarchy batch", "[hierarchy_batch]") {
+        auto g = get_4_adjacency_graph({4, 5});
+        auto edge_weights = weight_graph_batch(g, random_images(5, 20), weight_functions::L1);
+        array_1d<double> vertex_area = xt::random::randint<int>({20}, 1, 4);
+        std::vector<watershed_attribute> attributes{watershed_attribute::area,
+                                                    watershed_attribute::volume,
+                                                    watershed_attribute::dynamics};
+        for (auto attribute: attributes) {
+            auto batch = watershed_hierarchy_batch(g, edge_weights, attribute, vertex_area);
+            REQUIRE(batch.num_trees() == 5);
+            for (index_t i = 0; i < 5; i++) {
+                array_1d<double> weights = xt::view(edge_weights, i, xt::all());
+                auto ref = watershed_hierarchies_by_attributes(g, weights, {attribute}, vertex_area)[0];
+                REQUIRE((batch.get_tree(i).parents() == ref.tree.parents()));
+                REQUIRE((batch.tree_altitudes(i) == ref.altitudes));
+                // the edge map of the reference is given in the minimum spanning tree of the graph
+                auto bptc = bpt_canonical(g, weights);
+                array_1d<index_t> ref_mst_edge_map = xt::index_view(bptc.mst_edge_map, ref.mst_edge_map);
+                REQUIRE((xt::view(batch.mst_edge_map, i, xt::all()) == ref_mst_edge_map));
+            }
+        }
+
+        auto batch_area = watershed_hierarchy_batch(g, edge_weights, watershed_attribute::area);
+        for (index_t i = 0; i < 5; i++) {
+            array_1d<double> weights = xt::view(edge_weights, i, xt::all());
+            auto ref = watershed_hierarchy_by_area(g, weights);
+            REQUIRE((batch_area.get_tree(i).parents() == ref.tree.parents()));
+            REQUIRE((batch_area.tree_altitudes(i) == ref.altitudes));
+        }
+
+        watershed_hierarchy_by_area_engine engine(g);
+        for (index_t i = 0; i < 5; i++) {
+            engine.compute(xt::view(edge_weights, i, xt::all()));
+            REQUIRE((xt::view(batch_area.mst_edge_map, i, xt::all()) == engine.mst_edge_map()));
+        }
+    }
+
+    TEST_CASE("saliency map batch", "[hierarchy_batch]") {
+        auto g = get_4_adjacency_graph({4, 5});
+        auto edge_weights = weight_graph_batch(g, random_images(4, 20), weight_functions::L1);
+        auto batch = watershed_hierarchy_batch(g, edge_weights, watershed_attribute::area);
+        auto saliency = saliency_map_batch(g, batch);
+        REQUIRE(saliency.shape()[0] == 4);
+        REQUIRE(saliency.shape()[1] == num_edges(g));
+        for (index_t i = 0; i < 4; i++) {
+            array_1d<double> altitudes = batch.tree_altitudes(i);
+            auto ref = saliency_map(g, batch.get_tree(i), altitudes);
+            REQUIRE((xt::view(saliency, i, xt::all()) == ref));
+        }
+    }
+
+    TEST_CASE("hierarchy distance matrix batch", "[hierarchy_batch]") {
+        auto g = get_4_adjacency_graph({4, 5});
+        auto edge_weights = weight_graph_batch(g, random_images(19, 20), weight_functions::L1);
+        auto batch = watershed_hierarchy_batch(g, edge_weights, watershed_attribute::area);
+        auto saliency = saliency_map_batch(g, batch);
+
+        auto l1 = hierarchy_distance_matrix_batch(g, batch, hierarchy_distance::L1);
+        auto l2 = hierarchy_distance_matrix_batch(g, batch, hierarchy_distance::L2);
+        auto corr = hierarchy_distance_matrix_batch(g, batch, hierarchy_distance::correlation);
+        REQUIRE(l1.shape()[0] == 19);
+        REQUIRE(l1.shape()[1] == 19);
+        for (index_t i = 0; i < 19; i++) {
+            array_1d<double> si = xt::view(saliency, i, xt::all());
+            array_1d<double> ci = si - xt::mean(si)();
+            for (index_t j = 0; j < 19; j++) {
+                array_1d<double> sj = xt::view(saliency, j, xt::all());
+                array_1d<double> cj = sj - xt::mean(sj)();
+                REQUIRE(l1(i, j) == Approx(xt::sum(xt::abs(si - sj))()));
+                REQUIRE(l2(i, j) == Approx(std::sqrt(xt::sum(xt::square(si - sj))())));
+                double r = xt::sum(ci * cj)() / std::sqrt(xt::sum(ci * ci)() * xt::sum(cj * cj)());
+                REQUIRE(corr(i, j) == Approx((i == j) ? 0 : 1 - r).margin(1e-12));
+            }
+        }
+
+        array_2d<int> ultrametrics{{1, 1, 1}, {0, 2, 4}, {4, 2, 0}};
+        REQUIRE((ultrametric_distance_matrix(ultrametrics, hierarchy_distance::L1) ==
+                 array_2d<double>{{0, 5, 5}, {5, 0, 8}, {5, 8, 0}}));
+        auto corr2 = ultrametric_distance_matrix(ultrametrics, hierarchy_distance::correlation);
+        REQUIRE(corr2(0, 1) == Approx(1));
+        REQUIRE(corr2(1, 2) == Approx(2));
+    }
+
+    TEST_CASE("tree batch attribute", "[hierarchy_batch]") {
+        // trees of different sizes
+        array_1d<index_t> parents{3, 3, 4, 4, 4, 2, 2, 2};
+        array_1d<double> altitudes{0, 0, 0, 1, 2, 0, 0, 3};
+        array_1d<index_t> offsets{0, 5, 8};
+        auto batch = make_tree_batch(parents, altitudes, offsets);
+        REQUIRE(batch.num_trees() == 2);
+        REQUIRE((batch.get_tree(1).parents() == array_1d<index_t>{2, 2, 2}));
+
+        auto area = tree_batch_attribute(batch, [](const tree &t, const array_1d<double> &) {
+            return attribute_area(t);
+        });
+        REQUIRE((area == array_1d<index_t>{1, 1, 1, 2, 3, 1, 1, 2}));
+
+        auto height = tree_batch_attribute(batch, [](const tree &t, const array_1d<double> &alt) {
+            return attribute_height(t, alt, true);
+        });
+        REQUIRE((height == array_1d<double>{0, 0, 0, 1, 1, 0, 0, 0}));
+
+        REQUIRE_THROWS(make_tree_batch(parents, altitudes, array_1d<index_t>{0, 5, 7}));
+        REQUIRE_THROWS(make_tree_batch(parents, altitudes, array_1d<index_t>{0, 5, 5, 8}));
+    }
+}
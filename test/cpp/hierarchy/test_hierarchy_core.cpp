@@ -11,6 +11,7 @@
 #include "higra/image/graph_image.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
 #include "higra/algo/tree.hpp"
+#include "higra/algo/graph_core.hpp"
 #include "../test_utils.hpp"
 #include "xtensor/xindex_view.hpp"
 #include "xtensor/xrandom.hpp"
@@ -66,6 +67,201 @@ namespace hierarchy_core {
     }
 
 
+    TEST_CASE("canonical binary partition tree filter boruvka", "[hierarchy_core]") {
+        auto graph = get_4_adjacency_graph({2, 3});
+
+        array_1d<double> edge_weights{1, 0, 2, 1, 1, 1, 2};
+
+        auto res = bpt_canonical_filter_boruvka(graph, edge_weights);
+        auto &tree = res.tree;
+        auto &altitudes = res.altitudes;
+        auto &mst_edge_map = res.mst_edge_map;
+
+        REQUIRE(num_vertices(tree) == 11);
+        REQUIRE((hg::parents(tree) == array_1d<index_t>({6, 7, 9, 6, 8, 9, 7, 8, 10, 10, 10})));
+        REQUIRE((altitudes == array_1d<double>({0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2})));
+        REQUIRE((mst_edge_map == array_1d<index_t>({1, 0, 3, 4, 2})));
+    }
+
+    TEST_CASE("canonical binary partition tree filter boruvka equals kruskal", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({60, 70});
+
+        array_1d<int> edge_weights_int = xt::random::randint<int>({num_edges(graph)}, 0, 20);
+        array_1d<float> edge_weights_float = xt::random::rand<float>({num_edges(graph)});
+
+        auto test = [&graph](const auto &edge_weights, index_t serial_cutoff) {
+            auto ref = bpt_canonical(graph, edge_weights);
+            auto msf = hierarchy_core_internal::minimum_spanning_forest_filter_boruvka(sources(graph),
+                                                                                      targets(graph),
+                                                                                      edge_weights,
+                                                                                      num_vertices(graph),
+                                                                                      serial_cutoff);
+            REQUIRE((msf == ref.mst_edge_map));
+        };
+
+        for (index_t serial_cutoff: {1, 100, 100000}) {
+            test(edge_weights_int, serial_cutoff);
+            test(edge_weights_float, serial_cutoff);
+        }
+
+        auto ref = bpt_canonical(graph, edge_weights_int);
+        auto res = bpt_canonical_filter_boruvka(graph, edge_weights_int);
+        REQUIRE((hg::parents(res.tree) == hg::parents(ref.tree)));
+        REQUIRE((res.altitudes == ref.altitudes));
+        REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+    }
+
+    TEST_CASE("canonical binary partition tree pipelined sweep", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto graph = get_8_adjacency_graph({50, 60});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 20);
+        array_1d<index_t> sorted_edges_indices = stable_arg_sort(edge_weights);
+
+        auto ref = hierarchy_core_internal::bpt_canonical_from_sorted_edges(sources(graph),
+                                                                            targets(graph),
+                                                                            sorted_edges_indices,
+                                                                            num_vertices(graph));
+        for (index_t block_size: {1, 7, 1000, 100000}) {
+            for (index_t prefetch_distance: {0, 5, 16}) {
+                auto res = hierarchy_core_internal::bpt_canonical_from_sorted_edges_pipelined(sources(graph),
+                                                                                              targets(graph),
+                                                                                              sorted_edges_indices,
+                                                                                              num_vertices(graph),
+                                                                                              block_size,
+                                                                                              prefetch_distance);
+                REQUIRE((res.first == ref.first));
+                REQUIRE((res.second == ref.second));
+            }
+        }
+    }
+
+    TEST_CASE("canonical binary partition tree from mst", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({30, 40});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 10);
+
+        auto ref = bpt_canonical(graph, edge_weights);
+
+        auto mst_res = minimum_spanning_tree(graph, edge_weights);
+        auto &mst = mst_res.mst;
+        array_1d<int> mst_edge_weights = xt::index_view(edge_weights, mst_res.mst_edge_map);
+
+        auto res = bpt_canonical_from_mst(mst, mst_edge_weights);
+        REQUIRE((hg::parents(res.tree) == hg::parents(ref.tree)));
+        REQUIRE((res.altitudes == ref.altitudes));
+        array_1d<index_t> mst_edge_map = xt::index_view(mst_res.mst_edge_map, res.mst_edge_map);
+        REQUIRE((mst_edge_map == ref.mst_edge_map));
+
+        // bpt_canonical fast path on a tree
+        auto res2 = bpt_canonical(mst, mst_edge_weights);
+        REQUIRE((hg::parents(res2.tree) == hg::parents(res.tree)));
+        REQUIRE((res2.altitudes == res.altitudes));
+        REQUIRE((res2.mst_edge_map == res.mst_edge_map));
+    }
+
+    TEST_CASE("canonical binary partition tree warm start", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({40, 50});
+        array_1d<float> edge_weights = xt::round(xt::random::rand<float>({num_edges(graph)}) * 100);
+
+        array_1d<index_t> sorted_edges{};
+        for (index_t frame = 0; frame < 4; frame++) {
+            auto ref = bpt_canonical(graph, edge_weights);
+            auto res = bpt_canonical_warm_start(graph, edge_weights, sorted_edges);
+            REQUIRE((hg::parents(res.tree) == hg::parents(ref.tree)));
+            REQUIRE((res.altitudes == ref.altitudes));
+            REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+            array_1d<index_t> ref_sorted_edges = stable_arg_sort(edge_weights);
+            REQUIRE((sorted_edges == ref_sorted_edges));
+
+            // next frame: small perturbation of the edge weights
+            for (index_t i = 0; i < 50; i++) {
+                edge_weights(xt::random::randint<index_t>({1}, 0, num_edges(graph))(0)) += 3;
+            }
+        }
+
+        // fast path on a tree
+        auto mst = minimum_spanning_tree(graph, edge_weights);
+        array_1d<float> mst_edge_weights = xt::index_view(edge_weights, mst.mst_edge_map);
+        array_1d<index_t> mst_sorted_edges = xt::arange<index_t>(num_edges(mst.mst));
+        auto ref = bpt_canonical(mst.mst, mst_edge_weights);
+        auto res = bpt_canonical_warm_start(mst.mst, mst_edge_weights, mst_sorted_edges);
+        REQUIRE((hg::parents(res.tree) == hg::parents(ref.tree)));
+        REQUIRE((res.altitudes == ref.altitudes));
+        REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+    }
+
+    TEST_CASE("canonical binary partition tree below and above altitude", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto graph = get_4_adjacency_graph({30, 40});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, 30);
+        const index_t num_v = num_vertices(graph);
+        auto ref = bpt_canonical(graph, edge_weights);
+        auto &ref_parents = hg::parents(ref.tree);
+
+        for (double altitude: {-1., 0., 5., 12.5, 29., 30.}) {
+            auto lower = bpt_canonical_below(graph, edge_weights, altitude);
+            auto upper = bpt_canonical_above(graph, edge_weights, altitude);
+            const index_t num_nodes = lower.parents.size();
+            const index_t num_merges = lower.mst_edge_map.size();
+            const index_t num_supervertices = lower.roots.size();
+            REQUIRE(num_nodes == num_v + num_merges);
+            REQUIRE(num_supervertices == num_v - num_merges);
+            REQUIRE((lower.supervertex_map == upper.supervertex_map));
+
+            // lower part: first nodes of the canonical bpt
+            REQUIRE((lower.mst_edge_map == xt::view(ref.mst_edge_map, xt::range(0, num_merges))));
+            REQUIRE((lower.altitudes == xt::view(ref.altitudes, xt::range(0, num_nodes))));
+            for (index_t n = 0; n < num_nodes; n++) {
+                REQUIRE(((lower.parents(n) == n) || (lower.parents(n) == ref_parents(n))));
+                if (lower.parents(n) == n && n != root(ref.tree)) {
+                    REQUIRE(ref.altitudes(ref_parents(n)) > altitude);
+                }
+            }
+            for (index_t v = 0; v < num_v; v++) {
+                auto r = v;
+                while (lower.parents(r) != r) {
+                    r = lower.parents(r);
+                }
+                REQUIRE(lower.roots(lower.supervertex_map(v)) == r);
+            }
+
+            // upper part: last nodes of the canonical bpt
+            REQUIRE((index_t) num_leaves(upper.tree) == num_supervertices);
+            REQUIRE((index_t) num_vertices(upper.tree) == 2 * num_supervertices - 1);
+            REQUIRE((upper.mst_edge_map == xt::view(ref.mst_edge_map, xt::range(num_merges, num_v - 1))));
+            REQUIRE((xt::view(upper.altitudes, xt::range(num_supervertices, 2 * num_supervertices - 1)) ==
+                     xt::view(ref.altitudes, xt::range(num_nodes, 2 * num_v - 1))));
+            for (index_t n = num_supervertices; n < (index_t) num_vertices(upper.tree); n++) {
+                REQUIRE(parent(n, upper.tree) - num_supervertices ==
+                        ref_parents(n - num_supervertices + num_nodes) - num_nodes);
+            }
+            for (index_t s = 0; s < num_supervertices; s++) {
+                REQUIRE(parent(s, upper.tree) - num_supervertices == ref_parents(lower.roots(s)) - num_nodes);
+            }
+        }
+
+        ugraph g(4);
+        add_edge(0, 1, g);
+        add_edge(2, 3, g);
+        array_1d<int> w{1, 5};
+        auto lower = bpt_canonical_below(g, w, 2);
+        REQUIRE((lower.roots == array_1d<index_t>{4, 2, 3}));
+        REQUIRE((lower.supervertex_map == array_1d<index_t>{0, 0, 1, 2}));
+        REQUIRE_THROWS(bpt_canonical_above(g, w, 2));
+    }
+
+    TEST_CASE("canonical binary partition tree from mst not a tree", "[hierarchy_core]") {
+        ugraph g(4);
+        add_edge(0, 1, g);
+        add_edge(1, 2, g);
+        add_edge(2, 0, g);
+        array_1d<int> edge_weights{1, 2, 3};
+        REQUIRE_THROWS(bpt_canonical_from_mst(g, edge_weights));
+        REQUIRE_THROWS(bpt_canonical(g, edge_weights));
+    }
+
     TEST_CASE("simplify tree", "[hierarchy_core]") {
 
         auto t = data.t;
@@ -201,6 +397,38 @@ namespace hierarchy_core {
         REQUIRE((sm == sm_ref));
     }
 
+    TEST_CASE("quasi flat zone hierarchy is the simplified canonical bpt", "[hierarchy_core]") {
+        xt::random::seed(5);
+        for (index_t max_weight: {2, 5, 50, 1000000}) {
+            auto graph = get_4_adjacency_graph({23, 17});
+            array_1d<int> edge_weights = xt::random::randint<int>({num_edges(graph)}, 0, max_weight);
+
+            auto bpt = bpt_canonical(graph, edge_weights);
+            auto altitude_parents = propagate_parallel(bpt.tree, bpt.altitudes);
+            auto ref = simplify_tree(bpt.tree, xt::equal(bpt.altitudes, altitude_parents));
+            array_1d<int> ref_altitudes = xt::index_view(bpt.altitudes, ref.node_map);
+
+            auto qfz = quasi_flat_zone_hierarchy(graph, edge_weights);
+            REQUIRE((qfz.tree.parents() == ref.tree.parents()));
+            REQUIRE((qfz.altitudes == ref_altitudes));
+
+            // minimum spanning tree: same hierarchy
+            ugraph mst(num_vertices(graph));
+            for (auto ei: bpt.mst_edge_map) {
+                auto e = edge_from_index(ei, graph);
+                add_edge(source(e, graph), target(e, graph), mst);
+            }
+            array_1d<int> mst_weights = xt::index_view(edge_weights, bpt.mst_edge_map);
+            auto qfz_mst = quasi_flat_zone_hierarchy(mst, mst_weights);
+            REQUIRE((qfz_mst.tree.parents() == ref.tree.parents()));
+            REQUIRE((qfz_mst.altitudes == ref_altitudes));
+        }
+
+        ugraph single(1);
+        auto qfz_single = quasi_flat_zone_hierarchy(single, array_1d<int>::from_shape({0}));
+        REQUIRE(num_vertices(qfz_single.tree) == 1);
+    }
+
     TEST_CASE("saliency maps of canonical bpt and qfz hierarchy are the same", "[hierarchy_core]") {
 
         index_t size = 25;
@@ -216,6 +444,41 @@ namespace hierarchy_core {
         REQUIRE((sm_bpt == sm_qfz));
     }
 
+    TEST_CASE("saliency map of canonical bpt", "[hierarchy_core]") {
+        xt::random::seed(7);
+        auto graph = get_4_adjacency_graph({31, 17});
+        auto edge_weights = xt::eval(xt::random::randint<int>({num_edges(graph)}, 0, 10));
+        auto bpt = bpt_canonical(graph, edge_weights);
+
+        lca_bitmask_block lca(bpt.tree);
+        auto sm_ref = xt::eval(xt::index_view(bpt.altitudes, lca.lca(edge_iterator(graph))));
+
+        auto sm = saliency_map(graph, bpt.tree, bpt.altitudes);
+        REQUIRE((sm == sm_ref));
+        auto sm_mst = saliency_map(graph, bpt);
+        REQUIRE((sm_mst == sm_ref));
+
+        auto grid_graph = get_4_adjacency_grid_graph({31, 17});
+        REQUIRE((saliency_map(grid_graph, bpt) == sm_ref));
+    }
+
+    TEST_CASE("lca for_each_lca", "[hierarchy_core]") {
+        tree t(xt::xarray<long>{8, 8, 9, 9, 10, 10, 11, 11, 12, 13, 12, 14, 13, 14, 14});
+        lca_bitmask_block lca(t);
+        array_1d<index_t> v1{0, 0, 1, 3, 5, 8, 2};
+        array_1d<index_t> v2{1, 2, 7, 4, 6, 13, 2};
+        array_1d<index_t> ref{8, 13, 14, 13, 14, 13, 2};
+        for (auto mode: {lca_batch_mode::independent, lca_batch_mode::sorted}) {
+            array_1d<index_t> res = xt::zeros<index_t>({v1.size()});
+            lca.for_each_lca(v1.size(),
+                             [&v1](index_t i) { return v1(i); },
+                             [&v2](index_t i) { return v2(i); },
+                             [&res](index_t i, index_t n) { res(i) = n; },
+                             mode);
+            REQUIRE((res == ref));
+        }
+    }
+
     TEST_CASE("tree_2_binary_tree", "[hierarchy_core]") {
         array_1d<index_t> parents{9, 9, 10, 10, 10, 10, 11, 11, 11, 12, 12, 12, 12};
         tree t(parents);
@@ -229,4 +492,41 @@ namespace hierarchy_core {
         REQUIRE((res.node_map == exp_node_map));
     }
 
-}
\ No newline at end of file
+    TEST_CASE("tree_2_binary_tree random tree", "[hierarchy_core]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({30, 40});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 10);
+        auto t = quasi_flat_zone_hierarchy(g, edge_weights).tree;
+
+        auto res = tree_2_binary_tree(t);
+
+        // sequential numbering of the nodes: extra nodes are created when the nodes are visited in leaves to root order
+        index_t num_l = num_leaves(t);
+        index_t num_v_res = 2 * num_l - 1;
+        array_1d<index_t> node_map = xt::arange<index_t>(num_vertices(t));
+        array_1d<index_t> exp_parents = array_1d<index_t>::from_shape({(size_t) num_v_res});
+        array_1d<index_t> exp_node_map = array_1d<index_t>::from_shape({(size_t) num_v_res});
+        for (index_t i = 0; i < num_l; i++) {
+            exp_node_map(i) = i;
+        }
+        index_t cur = num_l;
+        for (auto i: leaves_to_root_iterator(t, leaves_it::exclude)) {
+            index_t num_c = num_children(i, t);
+            exp_parents(node_map(child(0, i, t))) = cur;
+            exp_parents(node_map(child(1, i, t))) = cur;
+            for (index_t c = 2; c < num_c; c++) {
+                exp_parents(cur) = cur + 1;
+                exp_node_map(cur) = i;
+                cur++;
+                exp_parents(node_map(child(c, i, t))) = cur;
+            }
+            node_map(i) = cur;
+            exp_node_map(cur) = i;
+            cur++;
+        }
+        exp_parents(num_v_res - 1) = num_v_res - 1;
+
+        REQUIRE((res.tree.parents() == exp_parents));
+        REQUIRE((res.node_map == exp_node_map));
+    }
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/hierarchy/random_hierarchy.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "../test_utils.hpp"
+
+namespace test_random_hierarchy {
+
+    using namespace hg;
+
+    // checks that parents is a valid binary partition tree (children before parents, leaves first)
+    template<typename T>
+    void check_binary_partition_tree(const T &parents, index_t num_leaves) {
+        const index_t num_nodes = parents.size();
+        REQUIRE(num_nodes == 2 * num_leaves - 1);
+        REQUIRE(parents(num_nodes - 1) == num_nodes - 1);
+        std::vector<index_t> num_children(num_nodes, 0);
+        for (index_t i = 0; i < num_nodes - 1; i++) {
+            REQUIRE(parents(i) > i);
+            REQUIRE(parents(i) >= num_leaves);
+            num_children[parents(i)]++;
+        }
+        for (index_t i = 0; i < num_nodes; i++) {
+            REQUIRE(num_children[i] == ((i < num_leaves) ? 0 : 2));
+        }
+    }
+
+    TEST_CASE("random binary partition tree perfectly balanced", "[random_hierarchy]") {
+        auto tree = random_binary_partition_tree(32, 0, 42);
+        check_binary_partition_tree(tree.parents(), 32);
+        auto depth = attribute_depth(tree);
+        for (index_t i = 0; i < 6; i++) {
+            REQUIRE((index_t) xt::sum(xt::equal(depth, i))() == ((index_t) 1 << i));
+        }
+    }
+
+    TEST_CASE("random binary partition tree perfectly unbalanced", "[random_hierarchy]") {
+        auto tree = random_binary_partition_tree(32, 1, 42);
+        check_binary_partition_tree(tree.parents(), 32);
+        auto depth = attribute_depth(tree);
+        for (index_t i = 0; i < 32; i++) {
+            REQUIRE(xt::sum(xt::equal(depth, i))() == ((i == 0) ? 1 : 2));
+        }
+    }
+
+    TEST_CASE("random binary partition tree single leaf", "[random_hierarchy]") {
+        auto tree = random_binary_partition_tree(1, 0.5, 42);
+        REQUIRE(num_vertices(tree) == 1);
+        REQUIRE(parent(0, tree) == 0);
+    }
+
+    TEST_CASE("random binary partition tree seed", "[random_hierarchy]") {
+        auto tree1 = random_binary_partition_tree(100, 0.5, 42);
+        auto tree2 = random_binary_partition_tree(100, 0.5, 42);
+        check_binary_partition_tree(tree1.parents(), 100);
+        REQUIRE((tree1.parents() == tree2.parents()));
+    }
+
+    TEST_CASE("random binary partition trees batch", "[random_hierarchy]") {
+        index_t num_trees = 50;
+        index_t num_leaves = 40;
+        auto parents = random_binary_partition_trees(num_trees, num_leaves, 0.3, 7);
+        REQUIRE(parents.shape()[0] == (size_t) num_trees);
+        for (index_t i = 0; i < num_trees; i++) {
+            check_binary_partition_tree(xt::view(parents, i, xt::all()), num_leaves);
+        }
+        auto parents2 = random_binary_partition_trees(num_trees, num_leaves, 0.3, 7);
+        REQUIRE((parents == parents2));
+        REQUIRE((xt::view(parents, 0, xt::all()) != xt::view(parents, 1, xt::all())));
+    }
+}
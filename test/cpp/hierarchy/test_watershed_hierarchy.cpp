@@ -12,6 +12,7 @@
 #include "higra/hierarchy/watershed_hierarchy.hpp"
 #include "higra/image/graph_image.hpp"
 #include "higra/algo/tree.hpp"
+#include "xtensor/xrandom.hpp"
 
 namespace watershed_hierarchy {
 
@@ -124,4 +125,222 @@ namespace watershed_hierarchy {
         REQUIRE((altitudes == ref_altitudes));
     }
 
-}
\ No newline at end of file
+    TEST_CASE("watershed hierarchies by attributes", "[watershed_hierarchy]") {
+        auto g = hg::get_4_adjacency_graph({17, 23});
+        xt::random::seed(7);
+        // many equal weights to exercise the attribute correction
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 8);
+        array_1d<double> vertex_area = xt::random::rand<double>({num_vertices(g)}) + 0.5;
+
+        std::vector<watershed_attribute> attributes{watershed_attribute::dynamics,
+                                                    watershed_attribute::area,
+                                                    watershed_attribute::volume,
+                                                    watershed_attribute::area};
+        auto check = [](const auto &res, const auto &ref) {
+            REQUIRE((res.tree.parents() == ref.tree.parents()));
+            REQUIRE(xt::allclose(res.altitudes, ref.altitudes));
+            REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+        };
+
+        auto res = watershed_hierarchies_by_attributes(g, edge_weights, attributes, vertex_area);
+        REQUIRE(res.size() == 4);
+        check(res[0], watershed_hierarchy_by_dynamics(g, edge_weights));
+        check(res[1], watershed_hierarchy_by_area(g, edge_weights, vertex_area));
+        check(res[2], watershed_hierarchy_by_volume(g, edge_weights, vertex_area));
+        check(res[3], res[1]);
+
+        auto res2 = watershed_hierarchies_by_attributes(g, edge_weights, {watershed_attribute::volume});
+        REQUIRE(res2.size() == 1);
+        check(res2[0], watershed_hierarchy_by_volume(g, edge_weights));
+
+        auto res3 = watershed_hierarchies_by_attributes(g, edge_weights, {});
+        REQUIRE(res3.empty());
+    }
+
+    TEST_CASE("watershed hierarchy on implicit grid graph", "[watershed_hierarchy]") {
+        embedding_grid_2d embedding{9, 14};
+        auto g = hg::get_4_adjacency_graph(embedding);
+        auto grid_graph = hg::get_4_adjacency_grid_graph(embedding);
+        xt::random::seed(3);
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 5);
+
+        auto ref = watershed_hierarchy_by_area(g, edge_weights);
+        auto res = watershed_hierarchy_by_area(grid_graph, edge_weights);
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+        REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+
+        auto ref_d = watershed_hierarchy_by_dynamics(g, edge_weights);
+        auto res_d = watershed_hierarchies_by_attributes(grid_graph, edge_weights, {watershed_attribute::dynamics});
+        REQUIRE((res_d[0].tree.parents() == ref_d.tree.parents()));
+        REQUIRE(xt::allclose(res_d[0].altitudes, ref_d.altitudes));
+    }
+
+    TEST_CASE("watershed hierarchy with integral altitudes", "[watershed_hierarchy]") {
+        auto g = hg::get_4_adjacency_graph({12, 15});
+        xt::random::seed(5);
+        array_1d<uint8_t> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 256);
+
+        auto ref = watershed_hierarchy_by_area(g, edge_weights, xt::ones<double>({num_vertices(g)}));
+        auto res = watershed_hierarchy_by_area(g, edge_weights, xt::ones<uint32_t>({num_vertices(g)}));
+        static_assert(std::is_same<typename decltype(res.altitudes)::value_type, uint32_t>::value, "");
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+
+        auto ref_d = watershed_hierarchy_by_attribute(g, edge_weights, [](const tree &t, const auto &altitudes) {
+            return array_1d<double>(attribute_dynamics(t, altitudes, true));
+        });
+        auto res_d = watershed_hierarchy_by_dynamics(g, edge_weights);
+        static_assert(std::is_same<typename decltype(res_d.altitudes)::value_type, uint8_t>::value, "");
+        REQUIRE((res_d.tree.parents() == ref_d.tree.parents()));
+        REQUIRE((res_d.altitudes == ref_d.altitudes));
+    }
+
+    TEST_CASE("watershed hierarchy by dynamics and minima ordering from Kruskal sweep", "[watershed_hierarchy]") {
+        // many ties and plateaus
+        auto g = hg::get_8_adjacency_graph({13, 17});
+        xt::random::seed(11);
+        for (int i = 0; i < 10; i++) {
+            array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 2 + 3 * i);
+
+            auto ref_d = watershed_hierarchy_by_attribute(g, edge_weights, [](const tree &t, const auto &altitudes) {
+                return attribute_dynamics(t, altitudes, true);
+            });
+            auto res_d = watershed_hierarchy_by_dynamics(g, edge_weights);
+            REQUIRE((res_d.tree.parents() == ref_d.tree.parents()));
+            REQUIRE((res_d.altitudes == ref_d.altitudes));
+            REQUIRE((res_d.mst_edge_map == ref_d.mst_edge_map));
+
+            // ranks of the minima of the watershed by dynamics
+            auto bptc = bpt_canonical(g, edge_weights);
+            auto minima = attribute_extrema(bptc.tree, bptc.altitudes);
+            auto dynamics = attribute_dynamics(bptc.tree, bptc.altitudes, true);
+            array_1d<index_t> minima_ranks = xt::zeros<index_t>({num_vertices(g)});
+            array_1d<index_t> sorted = stable_arg_sort(dynamics);
+            index_t rank = 1;
+            for (auto n: sorted) {
+                if (minima(n)) {
+                    for (auto l: leaves_iterator(bptc.tree)) {
+                        // leaves of the minimum n
+                        index_t a = parent(l, bptc.tree);
+                        while (bptc.altitudes(a) == bptc.altitudes(n) && a != n && a != root(bptc.tree)) {
+                            a = parent(a, bptc.tree);
+                        }
+                        if (a == n && minima_ranks(l) == 0) {
+                            minima_ranks(l) = rank;
+                        }
+                    }
+                    rank++;
+                }
+            }
+            REQUIRE(xt::amax(minima_ranks)() > 1);
+            auto res_m = watershed_hierarchy_by_minima_ordering(g, edge_weights, minima_ranks);
+            auto extinction = accumulate_sequential(bptc.tree, minima_ranks, accumulator_max());
+            xt::view(extinction, xt::range(0, num_leaves(bptc.tree))) = 0;
+            auto persistence = accumulate_parallel(bptc.tree, extinction, accumulator_min());
+            auto mst = watershed_hierarchy_internal::mst_edge_extremities(g, bptc.mst_edge_map);
+            auto ref_m = hierarchy_core_internal::bpt_canonical_from_tree_edges(
+                    mst.first, mst.second,
+                    xt::view(persistence, xt::range(num_leaves(bptc.tree), num_vertices(bptc.tree))),
+                    num_vertices(g));
+            REQUIRE((res_m.tree.parents() == ref_m.tree.parents()));
+            REQUIRE((res_m.altitudes == ref_m.altitudes));
+        }
+    }
+
+    TEST_CASE("watershed hierarchy by area engine", "[watershed_hierarchy]") {
+        auto g = hg::get_4_adjacency_graph({15, 17});
+        array_1d<double> vertex_area = xt::random::randint<int>({num_vertices(g)}, 1, 4);
+
+        watershed_hierarchy_by_area_engine engine(g);
+        watershed_hierarchy_by_area_engine engine_area(g, vertex_area);
+        const index_t *parents_data = engine.parents().data();
+        for (index_t i = 0; i < 3; i++) {
+            array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 10 + 10 * i);
+
+            engine.compute(edge_weights);
+            auto ref = watershed_hierarchy_by_area(g, edge_weights);
+            REQUIRE((engine.parents() == ref.tree.parents()));
+            REQUIRE((engine.altitudes() == ref.altitudes));
+            REQUIRE(engine.parents().data() == parents_data);
+            for (index_t n = 0; n < (index_t) num_vertices(g) - 1; n++) {
+                auto e = edge_from_index(engine.mst_edge_map()(n), g);
+                REQUIRE(lowest_common_ancestor(source(e, g), target(e, g), ref.tree) ==
+                        n + (index_t) num_vertices(g));
+            }
+
+            engine_area.compute(edge_weights);
+            auto ref_area = watershed_hierarchy_by_area(g, edge_weights, vertex_area);
+            REQUIRE((engine_area.parents() == ref_area.tree.parents()));
+            REQUIRE((engine_area.altitudes() == ref_area.altitudes));
+        }
+    }
+
+    TEST_CASE("waterfall hierarchy", "[watershed_hierarchy]") {
+        ugraph g(6);
+        add_edges(array_1d<index_t>{0, 1, 2, 3, 4}, array_1d<index_t>{1, 2, 3, 4, 5}, g);
+        array_1d<int> edge_weights{1, 5, 2, 6, 3};
+
+        auto res = waterfall_hierarchy(g, edge_weights);
+        array_1d<index_t> expected_parents{6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 10};
+        array_1d<index_t> expected_altitudes{0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2};
+        array_1d<index_t> expected_mst_edge_map{0, 2, 4, 1, 3};
+        REQUIRE((hg::parents(res.tree) == expected_parents));
+        REQUIRE((res.altitudes == expected_altitudes));
+        REQUIRE((res.mst_edge_map == expected_mst_edge_map));
+    }
+
+    TEST_CASE("waterfall hierarchy equals iterated watersheds", "[watershed_hierarchy]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({20, 25});
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 10);
+        auto res = waterfall_hierarchy(g, edge_weights);
+
+        // reference: each region is merged with the region at the other end of its lightest adjacent edge in the
+        // graph (ties broken by edge indices), until a single region remains
+        const index_t num_v = num_vertices(g);
+        array_1d<index_t> labels = xt::arange<index_t>(num_v);
+        for (index_t level = 1; xt::amax(labels)() > 0; level++) {
+            const index_t num_regions = xt::amax(labels)() + 1;
+            std::vector<index_t> lightest_edge(num_regions, invalid_index);
+            auto lighter = [&edge_weights](index_t e1, index_t e2) {
+                return e2 == invalid_index || edge_weights(e1) < edge_weights(e2) ||
+                       (edge_weights(e1) == edge_weights(e2) && e1 < e2);
+            };
+            for (auto e: edge_iterator(g)) {
+                auto ls = labels(source(e, g));
+                auto lt = labels(target(e, g));
+                if (ls != lt) {
+                    if (lighter(e.index, lightest_edge[ls])) {
+                        lightest_edge[ls] = e.index;
+                    }
+                    if (lighter(e.index, lightest_edge[lt])) {
+                        lightest_edge[lt] = e.index;
+                    }
+                }
+            }
+            union_find uf(num_regions);
+            for (index_t r = 0; r < num_regions; r++) {
+                auto e = edge_from_index(lightest_edge[r], g);
+                auto c1 = uf.find(labels(source(e, g)));
+                auto c2 = uf.find(labels(target(e, g)));
+                if (c1 != c2) {
+                    uf.link(c1, c2);
+                }
+            }
+            std::vector<index_t> new_labels(num_regions, invalid_index);
+            index_t num_labels = 0;
+            for (index_t v = 0; v < num_v; v++) {
+                auto r = uf.find(labels(v));
+                if (new_labels[r] == invalid_index) {
+                    new_labels[r] = num_labels++;
+                }
+                labels(v) = new_labels[r];
+            }
+
+            auto cut = labelisation_horizontal_cut_from_threshold(res.tree, res.altitudes, level);
+            REQUIRE(is_in_bijection(cut, labels));
+        }
+        REQUIRE(res.altitudes(root(res.tree)) > 1);
+    }
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/image/bpt_4_adjacency.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace bpt_4_adjacency {
+
+    using namespace hg;
+    using namespace std;
+
+    template<typename T>
+    void check_bpt_4_adjacency(const T &image, weight_functions weight) {
+        embedding_grid_2d embedding{(index_t) image.shape()[0], (index_t) image.shape()[1]};
+        auto graph = get_4_adjacency_graph(embedding);
+        array_nd<typename T::value_type> vertex_weights = image;
+        if (image.dimension() == 2) {
+            vertex_weights.reshape({num_vertices(graph)});
+        } else {
+            vertex_weights.reshape({num_vertices(graph), image.size() / num_vertices(graph)});
+        }
+        auto ref = bpt_canonical(graph, weight_graph(graph, vertex_weights, weight));
+
+        auto res = bpt_canonical_4_adjacency(image, weight);
+        REQUIRE((res.tree.parents() == ref.tree.parents()));
+        REQUIRE((res.altitudes == ref.altitudes));
+        REQUIRE((res.mst_edge_map == ref.mst_edge_map));
+    }
+
+    TEST_CASE("bpt canonical 4 adjacency", "[bpt_4_adjacency]") {
+        xt::random::seed(1);
+        array_2d<double> image = xt::random::rand<double>({23, 31});
+        check_bpt_4_adjacency(image, weight_functions::mean);
+        check_bpt_4_adjacency(image, weight_functions::L1);
+
+        // many equal weights
+        array_2d<int> image_int = xt::random::randint<int>({17, 9}, 0, 4);
+        check_bpt_4_adjacency(image_int, weight_functions::max);
+
+        array_nd<float> image_color = xt::random::rand<float>({12, 14, 3});
+        check_bpt_4_adjacency(image_color, weight_functions::L2);
+
+        // non contiguous image
+        check_bpt_4_adjacency(xt::transpose(image), weight_functions::mean);
+
+        array_2d<double> single_row = xt::random::rand<double>({1, 10});
+        check_bpt_4_adjacency(single_row, weight_functions::mean);
+    }
+
+    TEST_CASE("bpt canonical 4 adjacency async", "[bpt_4_adjacency]") {
+        xt::random::seed(2);
+        array_nd<double> image = xt::random::rand<double>({31, 25});
+        auto ref = bpt_canonical_4_adjacency(image, weight_functions::mean);
+
+        auto future1 = bpt_canonical_4_adjacency_async(image, weight_functions::mean);
+        auto future2 = bpt_canonical_4_adjacency_async<double>(xt::transpose(image), weight_functions::mean);
+        auto res1 = future1.get();
+        auto res2 = future2.get();
+        REQUIRE((res1.tree.parents() == ref.tree.parents()));
+        REQUIRE((res1.altitudes == ref.altitudes));
+        REQUIRE((res1.mst_edge_map == ref.mst_edge_map));
+        REQUIRE((res2.tree.parents() == bpt_canonical_4_adjacency(xt::transpose(image),
+                                                                   weight_functions::mean).tree.parents()));
+    }
+}
@@ -242,6 +242,47 @@ namespace test_contour_2d {
         REQUIRE(is_in_bijection(ref, contours_khalimsky));
     }
 
+    TEST_CASE("contour 2d flat storage and polyline subdivide", "[contour_2d]") {
+
+        std::array<index_t, 2> shape{4, 5};
+        auto g = get_4_adjacency_graph(shape);
+
+        xt::xarray<int> data{
+                0, 0, 1, 0, 2, 0, 3, 0, 0, 0, 0, 1, 0, 2, 4, 3, 0, 0, 0, 1, 1, 1, 2, 0, 3, 0, 0, 0, 1, 2,
+                3
+        };
+
+        auto contours = fit_contour_2d(g, shape, data);
+        auto &offsets = contours.polyline_element_offsets();
+        REQUIRE(offsets.size() == contours.size() + 1);
+        REQUIRE(offsets.back() == (index_t) contours.contour_elements().size());
+        REQUIRE(contours.contour_points().size() == contours.contour_elements().size());
+        for (index_t i = 0; i < (index_t) contours.size(); i++) {
+            REQUIRE(contours.num_polyline_control_points(i) == 2);
+            REQUIRE(contours.polyline_control_points(i)[0] == offsets[i]);
+            REQUIRE(contours.polyline_control_points(i)[1] == offsets[i + 1] - 1);
+            REQUIRE(contours[i].size() == 1);
+            REQUIRE(contours[i].number_of_contour_elements() == offsets[i + 1] - offsets[i]);
+        }
+
+        auto contours2 = fit_contour_2d(g, shape, data);
+        contours.subdivide(0.000001, false, 0);
+        for (auto polyline: contours2) {
+            polyline.subdivide(0.000001, false, 0);
+        }
+        for (index_t i = 0; i < (index_t) contours.size(); i++) {
+            REQUIRE(contours.num_polyline_control_points(i) == contours2.num_polyline_control_points(i));
+            for (index_t j = 0; j < contours.num_polyline_control_points(i); j++) {
+                REQUIRE(contours.polyline_control_points(i)[j] == contours2.polyline_control_points(i)[j]);
+            }
+        }
+
+        // subdividing again is a no-op
+        auto contours_khalimsky = contour_2_khalimsky(g, shape, contours);
+        contours.subdivide(0.000001, false, 0);
+        REQUIRE((contours_khalimsky == contour_2_khalimsky(g, shape, contours)));
+    }
+
     TEST_CASE("test rag_2d_vertex_perimeter_and_edge_length simple", "[contour_2d]") {
 
         std::array<index_t, 2> shape{3, 2};
@@ -0,0 +1,123 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/image/distributed_mst.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+#include <sstream>
+
+namespace distributed_mst {
+
+    using namespace hg;
+    using namespace std;
+
+    template<typename T>
+    auto reference_mst(const T &image, weight_functions weight) {
+        auto graph = get_4_adjacency_graph({(index_t) image.shape()[0], (index_t) image.shape()[1]});
+        array_nd<typename T::value_type> vertex_weights = image;
+        if (image.dimension() == 2) {
+            vertex_weights.reshape({num_vertices(graph)});
+        } else {
+            vertex_weights.reshape({num_vertices(graph), image.size() / num_vertices(graph)});
+        }
+        array_1d<index_t> ref = bpt_canonical(graph, weight_graph(graph, vertex_weights, weight)).mst_edge_map;
+        std::sort(ref.begin(), ref.end());
+        return vector<index_t>(ref.begin(), ref.end());
+    }
+
+    /*
+     * Partial minimum spanning trees of the blocks of a regular partition of the image in num_block_rows x
+     * num_block_columns blocks, in raster order.
+     */
+    template<typename T>
+    auto make_block_msts(const T &image, index_t num_block_rows, index_t num_block_columns, vector<index_t> &res,
+                         weight_functions weight) {
+        index_t height = image.shape()[0];
+        index_t width = image.shape()[1];
+        embedding_grid_2d embedding{height, width};
+        vector<region_mst> msts;
+        for (index_t i = 0; i < num_block_rows; i++) {
+            for (index_t j = 0; j < num_block_columns; j++) {
+                index_t y0 = i * height / num_block_rows;
+                index_t y1 = (i + 1) * height / num_block_rows;
+                index_t x0 = j * width / num_block_columns;
+                index_t x1 = (j + 1) * width / num_block_columns;
+                auto values = xt::view(image, xt::range(y0, (std::min)(y1 + 1, height)),
+                                       xt::range(x0, (std::min)(x1 + 1, width)));
+                msts.push_back(make_region_mst(embedding, y0, x0, y1 - y0, x1 - x0, values,
+                                               [&res](index_t ei, double) { res.push_back(ei); }, weight));
+            }
+        }
+        return msts;
+    }
+
+    TEST_CASE("distributed minimum spanning tree sequential merge", "[distributed_mst]") {
+        xt::random::seed(42);
+        array_2d<int> image = xt::random::randint<int>({19, 23}, 0, 4);
+        auto ref = reference_mst(image, weight_functions::L1);
+
+        vector<index_t> res;
+        auto msts = make_block_msts(image, 3, 4, res, weight_functions::L1);
+        REQUIRE(res.size() < ref.size());
+        auto output = [&res](index_t ei, double) { res.push_back(ei); };
+        for (index_t i = 1; i < (index_t) msts.size(); i++) {
+            REQUIRE(!msts[0].complete());
+            merge_region_mst(msts[0], msts[i], output);
+        }
+        REQUIRE(msts[0].complete());
+        REQUIRE(msts[0].edges.empty());
+        std::sort(res.begin(), res.end());
+        REQUIRE(vectorEqual(res, ref));
+    }
+
+    TEST_CASE("distributed minimum spanning tree tree merge", "[distributed_mst]") {
+        xt::random::seed(42);
+        array_3d<double> image = xt::random::rand<double>({17, 29, 2});
+        auto ref = reference_mst(image, weight_functions::L2);
+
+        for (auto blocks: vector<pair<index_t, index_t>>{{1, 1}, {5, 1}, {2, 7}, {4, 4}}) {
+            vector<index_t> res;
+            auto msts = make_block_msts(image, blocks.first, blocks.second, res, weight_functions::L2);
+            auto output = [&res](index_t ei, double) { res.push_back(ei); };
+            // binary reduction tree with serialization, as in mpi_merge_region_mst
+            for (index_t step = 1; step < (index_t) msts.size(); step *= 2) {
+                for (index_t r = 0; r + step < (index_t) msts.size(); r += 2 * step) {
+                    std::stringstream buffer;
+                    save_region_mst(buffer, msts[r + step]);
+                    merge_region_mst(msts[r], read_region_mst(buffer), output);
+                }
+            }
+            REQUIRE(msts[0].complete());
+            REQUIRE(msts[0].edges.empty());
+            std::sort(res.begin(), res.end());
+            REQUIRE(vectorEqual(res, ref));
+        }
+    }
+
+    TEST_CASE("region mst serialization", "[distributed_mst]") {
+        xt::random::seed(42);
+        array_2d<double> image = xt::random::rand<double>({10, 10});
+        vector<index_t> res;
+        auto msts = make_block_msts(image, 2, 2, res, weight_functions::L1);
+        std::stringstream buffer;
+        save_region_mst(buffer, msts[1]);
+        auto mst = read_region_mst(buffer);
+        REQUIRE((mst.embedding.shape() == msts[1].embedding.shape()));
+        REQUIRE(mst.regions == msts[1].regions);
+        REQUIRE(mst.edges.size() == msts[1].edges.size());
+        for (index_t i = 0; i < (index_t) mst.edges.size(); i++) {
+            REQUIRE(mst.edges[i].weight == msts[1].edges[i].weight);
+            REQUIRE(mst.edges[i].index == msts[1].edges[i].index);
+            REQUIRE(mst.edges[i].source == msts[1].edges[i].source);
+            REQUIRE(mst.edges[i].target == msts[1].edges[i].target);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#define HG_DEBUG
+
+#define CATCH_CONFIG_RUNNER
+
+#include "higra/image/distributed_mst_mpi.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+int main(int argc, char *argv[]) {
+    MPI_Init(&argc, &argv);
+    int result = Catch::Session().run(argc, argv);
+    MPI_Finalize();
+    return result;
+}
+
+namespace distributed_mst_mpi {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("mpi distributed minimum spanning tree", "[distributed_mst]") {
+        int rank;
+        int num_processes;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &num_processes);
+
+        // every process generates the same image and processes one horizontal strip
+        xt::random::seed(42);
+        const index_t height = 37;
+        const index_t width = 23;
+        array_2d<double> image = xt::random::rand<double>({(size_t) height, (size_t) width});
+        index_t y0 = rank * height / num_processes;
+        index_t y1 = (rank + 1) * height / num_processes;
+        auto values = xt::view(image, xt::range(y0, (std::min)(y1 + 1, height)), xt::all());
+
+        vector<long long> res;
+        auto mst = mpi_minimum_spanning_tree(MPI_COMM_WORLD, embedding_grid_2d{height, width}, y0, 0, y1 - y0, width,
+                                             values, [&res](index_t ei, double) { res.push_back(ei); });
+        if (rank == 0) {
+            REQUIRE(mst.complete());
+            REQUIRE(mst.edges.empty());
+        }
+
+        int num_local = (int) res.size();
+        vector<int> counts(num_processes);
+        MPI_Gather(&num_local, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+        vector<int> displacements(num_processes, 0);
+        for (int i = 1; i < num_processes; i++) {
+            displacements[i] = displacements[i - 1] + counts[i - 1];
+        }
+        vector<long long> all_edges(rank == 0 ? displacements.back() + counts.back() : 0);
+        MPI_Gatherv(res.data(), num_local, MPI_LONG_LONG, all_edges.data(), counts.data(), displacements.data(),
+                    MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            auto graph = get_4_adjacency_graph({height, width});
+            array_1d<double> vertex_weights = xt::flatten(image);
+            array_1d<index_t> ref = bpt_canonical(graph, weight_graph(graph, vertex_weights, weight_functions::L1))
+                    .mst_edge_map;
+            std::sort(ref.begin(), ref.end());
+            std::sort(all_edges.begin(), all_edges.end());
+            REQUIRE(vectorEqual(all_edges, vector<long long>(ref.begin(), ref.end())));
+        }
+    }
+}
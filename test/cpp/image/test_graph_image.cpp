@@ -9,6 +9,12 @@
 ****************************************************************************/
 
 #include "higra/image/graph_image.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include "higra/algo/tree.hpp"
+#include "higra/hierarchy/component_tree.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xsort.hpp"
 #include "../test_utils.hpp"
 
 namespace graph_image {
@@ -181,4 +187,137 @@ namespace graph_image {
         REQUIRE(xt::allclose(embedding2.shape(), ref_shape));
         REQUIRE(xt::allclose(data, weights2));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("4 adjacency graph to Khalimsky 2d and back, any edge order", "[graph_image]") {
+        embedding_grid_2d embedding{5, 7};
+        auto g = get_4_adjacency_morton_graph(embedding);
+        auto grid_graph = get_4_adjacency_grid_graph(embedding);
+        xt::random::seed(1);
+        array_1d<int> data = xt::random::randint<int>({num_edges(g)}, 1, 20);
+
+        // same graph with edges in reverse order and reversed extremities: generic path
+        ugraph g2(num_vertices(g));
+        array_1d<int> data2 = array_1d<int>::from_shape({num_edges(g)});
+        for (index_t i = (index_t) num_edges(g) - 1; i >= 0; i--) {
+            add_edge(target(edge_from_index(i, g), g), source(edge_from_index(i, g), g), g2);
+            data2(num_edges(g) - 1 - i) = data(i);
+        }
+
+        for (bool border: {false, true}) {
+            auto r = graph_4_adjacency_2_khalimsky(g, embedding, data, border, 25);
+            auto r_grid = graph_4_adjacency_2_khalimsky(grid_graph, embedding, data, border, 25);
+            auto r2 = graph_4_adjacency_2_khalimsky(g2, embedding, data2, border, 25);
+            REQUIRE((r == r_grid));
+            REQUIRE((r == r2));
+            REQUIRE(r.shape()[0] == (border ? 11 : 9));
+            REQUIRE(r.shape()[1] == (border ? 15 : 13));
+            index_t o = border ? 1 : 0;
+            // 1-faces, 0-faces and 2-faces
+            REQUIRE(r(o + 2 * 2, o + 2 * 3 + 1) == data(grid_graph.right_edge(2 * 7 + 3)));
+            REQUIRE(r(o + 2 * 2 + 1, o + 2 * 3) == data(grid_graph.bottom_edge(2 * 7 + 3)));
+            REQUIRE(r(o + 3, o + 5) == std::max({r(o + 2, o + 5), r(o + 4, o + 5), r(o + 3, o + 4), r(o + 3, o + 6)}));
+            REQUIRE(r(o + 2, o + 4) == 0);
+            if (border) {
+                REQUIRE(r(0, 3) == 25);
+                REQUIRE(r(0, 0) == 25);
+            }
+
+            auto back = khalimsky_2_graph_4_adjacency(r, border);
+            REQUIRE((std::get<2>(back) == data));
+
+            // non row major khalimsky grid
+            array_2d<int> rt = xt::transpose(r);
+            auto back_t = khalimsky_2_graph_4_adjacency(xt::transpose(rt), border);
+            REQUIRE((std::get<2>(back_t) == data));
+        }
+    }
+
+    TEST_CASE("ultrametric contour map in Khalimsky 2d", "[graph_image]") {
+        embedding_grid_2d embedding{13, 17};
+        auto g = get_4_adjacency_morton_graph(embedding);
+        xt::random::seed(1);
+        array_1d<double> data = xt::random::rand<double>({num_edges(g)});
+        auto h = bpt_canonical(g, data);
+
+        for (bool border: {false, true}) {
+            auto ref = graph_4_adjacency_2_khalimsky(g, embedding, saliency_map(g, h.tree, h.altitudes), border, 2.);
+            auto r = ucm_khalimsky(h.tree, h.altitudes, embedding, border, 2.);
+            REQUIRE((r == ref));
+        }
+
+        embedding_grid_2d line{1, 5};
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        array_1d<int> altitudes{0, 0, 0, 0, 0, 1, 2, 3};
+        auto r = ucm_khalimsky(t, altitudes, line);
+        array_2d<int> expected{{0, 1, 0, 3, 0, 2, 0, 2, 0}};
+        REQUIRE((r == expected));
+    }
+
+    TEST_CASE("4 adjacency graph morton", "[graph_image]") {
+        embedding_morton_2d embedding({7, 9}, 4);
+        embedding_grid_2d row_major({7, 9});
+        auto g = get_4_adjacency_morton_graph(embedding);
+        auto ref = get_4_adjacency_graph(row_major);
+        REQUIRE(num_vertices(g) == num_vertices(ref));
+        REQUIRE(num_edges(g) == num_edges(ref));
+
+        // same adjacency up to the vertex numbering, edges sorted by source
+        index_t previous_source = 0;
+        for (auto e: edge_iterator(g)) {
+            REQUIRE(source(e, g) >= previous_source);
+            previous_source = source(e, g);
+            auto p1 = embedding.lin2grid(source(e, g));
+            auto p2 = embedding.lin2grid(target(e, g));
+            REQUIRE(std::abs(p1(0) - p2(0)) + std::abs(p1(1) - p2(1)) == 1);
+        }
+        for (index_t v = 0; v < (index_t) num_vertices(g); v++) {
+            REQUIRE(degree(v, g) == degree(row_major.grid2lin(embedding.lin2grid(v)), ref));
+        }
+
+        auto gi = get_4_adjacency_implicit_morton_graph(embedding);
+        for (index_t v = 0; v < (index_t) num_vertices(g); v++) {
+            vector<index_t> n1, n2;
+            for (auto n: adjacent_vertex_iterator(v, g)) {
+                n1.push_back(n);
+            }
+            for (auto n: adjacent_vertex_iterator(v, gi)) {
+                n2.push_back(n);
+            }
+            std::sort(n1.begin(), n1.end());
+            std::sort(n2.begin(), n2.end());
+            REQUIRE(n1 == n2);
+            REQUIRE(out_degree(v, gi) == n2.size());
+        }
+
+        auto g8 = get_8_adjacency_morton_graph(embedding);
+        REQUIRE(num_edges(g8) == num_edges(get_8_adjacency_graph(row_major)));
+    }
+
+    TEST_CASE("hierarchy on morton graph", "[graph_image]") {
+        embedding_morton_2d embedding({37, 45}, 8);
+        embedding_grid_2d row_major({37, 45});
+        array_2d<double> image = xt::random::randint<int>({37, 45}, 0, 10);
+        auto g = get_4_adjacency_graph(row_major);
+        auto gm = get_4_adjacency_morton_graph(embedding);
+        auto bpt = bpt_canonical(g, weight_graph(g, xt::flatten(image), weight_functions::L1));
+        auto bptm = bpt_canonical(gm, weight_graph(gm, to_morton_order(embedding, image), weight_functions::L1));
+        REQUIRE((xt::sort(bpt.altitudes) == xt::sort(bptm.altitudes)));
+
+        // same partitions at any threshold
+        auto labels = labelisation_horizontal_cut_from_threshold(bpt.tree, bpt.altitudes, 3);
+        array_1d<index_t> labelsm = xt::flatten(to_row_major_order(
+                embedding, labelisation_horizontal_cut_from_threshold(bptm.tree, bptm.altitudes, 3)));
+        for (auto e: edge_iterator(g)) {
+            REQUIRE((labels(source(e, g)) == labels(target(e, g))) ==
+                    (labelsm(source(e, g)) == labelsm(target(e, g))));
+        }
+
+        // component trees on the implicit graph
+        auto gi = get_4_adjacency_implicit_graph(row_major);
+        auto gmi = get_4_adjacency_implicit_morton_graph(embedding);
+        auto max_tree = component_tree_max_tree(gi, xt::flatten(image));
+        auto max_treem = component_tree_max_tree(gmi, to_morton_order(embedding, image));
+        REQUIRE(num_vertices(max_tree.tree) == num_vertices(max_treem.tree));
+        REQUIRE((xt::sort(max_tree.altitudes) == xt::sort(max_treem.altitudes)));
+    }
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/image/multiresolution_hierarchy.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace multiresolution_hierarchy {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("multiresolution hierarchy pyramid", "[multiresolution_hierarchy]") {
+        array_2d<double> image{{1, 2, 3, 4, 5},
+                               {6, 7, 8, 9, 10},
+                               {11, 12, 13, 14, 15},
+                               {16, 17, 18, 19, 20},
+                               {21, 22, 23, 24, 25},
+                               {26, 27, 28, 29, 30},
+                               {31, 32, 33, 34, 35}};
+        embedding_grid_2d embedding{7, 5};
+        auto mh = make_multiresolution_bpt_canonical(embedding, image, 3);
+
+        REQUIRE(mh.num_levels() == 3);
+        REQUIRE(mh.level() == 2);
+        REQUIRE(!mh.is_full_resolution());
+        REQUIRE(mh.embedding().shape()[0] == 2);
+        REQUIRE(mh.embedding().shape()[1] == 2);
+        REQUIRE((mh.vertex_area() == array_1d<index_t>{16, 4, 12, 3}));
+        REQUIRE(num_leaves(mh.hierarchy().tree) == 4);
+        REQUIRE((mh.leaf_map() == array_1d<index_t>{0, 0, 0, 0, 1,
+                                                    0, 0, 0, 0, 1,
+                                                    0, 0, 0, 0, 1,
+                                                    0, 0, 0, 0, 1,
+                                                    2, 2, 2, 2, 3,
+                                                    2, 2, 2, 2, 3,
+                                                    2, 2, 2, 2, 3}));
+
+        // coarse pixel values are the means of the blocks they cover
+        auto graph = get_4_adjacency_graph(embedding_grid_2d{2, 2});
+        array_1d<double> means{(1 + 2 + 3 + 4 + 6 + 7 + 8 + 9 + 11 + 12 + 13 + 14 + 16 + 17 + 18 + 19) / 16.,
+                               (5 + 10 + 15 + 20) / 4.,
+                               (21 + 22 + 23 + 24 + 26 + 27 + 28 + 29 + 31 + 32 + 33 + 34) / 12.,
+                               (25 + 30 + 35) / 3.};
+        auto ref = bpt_canonical(graph, weight_graph(graph, means, weight_functions::L1));
+        REQUIRE((mh.hierarchy().tree.parents() == ref.tree.parents()));
+        REQUIRE(xt::allclose(mh.hierarchy().altitudes, ref.altitudes));
+
+        REQUIRE(mh.refine());
+        REQUIRE(mh.level() == 1);
+        REQUIRE(mh.embedding().shape()[0] == 4);
+        REQUIRE(mh.embedding().shape()[1] == 3);
+        REQUIRE(mh.refine());
+        REQUIRE(mh.level() == 0);
+        REQUIRE(mh.is_full_resolution());
+        REQUIRE(!mh.refine());
+        REQUIRE(mh.level() == 0);
+    }
+
+    TEST_CASE("multiresolution hierarchy full resolution hierarchy", "[multiresolution_hierarchy]") {
+        array_2d<double> image{{0, 0, 5, 5, 1},
+                               {0, 1, 5, 6, 1},
+                               {3, 3, 2, 2, 1}};
+        embedding_grid_2d embedding{3, 5};
+        auto mh = make_multiresolution_bpt_canonical(embedding, image, 2);
+        REQUIRE(mh.level() == 1);
+
+        auto h = mh.full_resolution_hierarchy();
+        const auto &coarse = mh.hierarchy();
+        const index_t num_pixels = 15;
+        REQUIRE(num_leaves(h.tree) == num_pixels);
+        REQUIRE(num_vertices(h.tree) == num_pixels + num_vertices(coarse.tree));
+        auto leaf_map = mh.leaf_map();
+        for (index_t i = 0; i < num_pixels; i++) {
+            REQUIRE(parent(i, h.tree) == num_pixels + leaf_map(i));
+            REQUIRE(h.altitudes(i) == 0);
+        }
+        for (index_t i = 0; i < (index_t) num_vertices(coarse.tree); i++) {
+            REQUIRE(parent(num_pixels + i, h.tree) == num_pixels + parent(i, coarse.tree));
+            REQUIRE(h.altitudes(num_pixels + i) == coarse.altitudes(i));
+        }
+    }
+
+    TEST_CASE("multiresolution hierarchy finest level is exact", "[multiresolution_hierarchy]") {
+        xt::random::seed(42);
+        array_3d<double> image = xt::random::rand<double>({13, 22, 3});
+        embedding_grid_2d embedding{13, 22};
+        auto graph = get_4_adjacency_graph(embedding);
+        array_2d<double> vertex_weights = xt::reshape_view(image, {(size_t) num_vertices(graph), (size_t) 3});
+        array_1d<double> edge_weights = weight_graph(graph, vertex_weights, weight_functions::L2);
+
+        auto mh_bpt = make_multiresolution_bpt_canonical(embedding, image, 10, weight_functions::L2);
+        REQUIRE(mh_bpt.num_levels() == 5);
+        index_t num_steps = 0;
+        while (mh_bpt.refine()) {
+            num_steps++;
+        }
+        REQUIRE(num_steps == 4);
+        auto ref_bpt = bpt_canonical(graph, edge_weights);
+        REQUIRE((mh_bpt.hierarchy().tree.parents() == ref_bpt.tree.parents()));
+        REQUIRE((mh_bpt.hierarchy().altitudes == ref_bpt.altitudes));
+        REQUIRE((mh_bpt.full_resolution_hierarchy().tree.parents() == ref_bpt.tree.parents()));
+
+        auto mh_ws = make_multiresolution_watershed_hierarchy_by_area(embedding, image, 3, weight_functions::L2);
+        // coarse pixel areas are counted in full resolution pixels
+        REQUIRE(xt::sum(mh_ws.vertex_area())() == 13 * 22);
+        REQUIRE(mh_ws.hierarchy().altitudes(num_vertices(mh_ws.hierarchy().tree) - 1) <= 13 * 22);
+        while (mh_ws.refine());
+        auto ref_ws = watershed_hierarchy_by_area(graph, edge_weights);
+        REQUIRE((mh_ws.hierarchy().tree.parents() == ref_ws.tree.parents()));
+        REQUIRE((mh_ws.hierarchy().altitudes == ref_ws.altitudes));
+    }
+}
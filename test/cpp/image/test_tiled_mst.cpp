@@ -0,0 +1,87 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/image/tiled_mst.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace tiled_mst {
+
+    using namespace hg;
+    using namespace std;
+
+    template<typename T>
+    void check_tiled_mst(const T &image, index_t tile_height, index_t tile_width, weight_functions weight,
+                         bool prefetch = true) {
+        embedding_grid_2d embedding{(index_t) image.shape()[0], (index_t) image.shape()[1]};
+        auto graph = get_4_adjacency_graph(embedding);
+        array_nd<typename T::value_type> vertex_weights = image;
+        if (image.dimension() == 2) {
+            vertex_weights.reshape({num_vertices(graph)});
+        } else {
+            vertex_weights.reshape({num_vertices(graph), image.size() / num_vertices(graph)});
+        }
+        auto edge_weights = weight_graph(graph, vertex_weights, weight);
+        array_1d<index_t> ref = bpt_canonical(graph, edge_weights).mst_edge_map;
+        std::sort(ref.begin(), ref.end());
+
+        index_t num_loaded_pixels = 0;
+        vector<index_t> res;
+        tiled_minimum_spanning_tree(
+                embedding, tile_height, tile_width,
+                [&image, &num_loaded_pixels](index_t y, index_t x, index_t h, index_t w) {
+                    num_loaded_pixels += h * w;
+                    return xt::view(image, xt::range(y, y + h), xt::range(x, x + w));
+                },
+                [&res, &edge_weights](index_t edge_index, double edge_weight) {
+                    REQUIRE(edge_weights(edge_index) == edge_weight);
+                    res.push_back(edge_index);
+                },
+                weight,
+                prefetch);
+        std::sort(res.begin(), res.end());
+        REQUIRE(num_loaded_pixels == (index_t) num_vertices(graph));
+        REQUIRE(vectorEqual(res, vector<index_t>(ref.begin(), ref.end())));
+    }
+
+    TEST_CASE("tiled minimum spanning tree", "[tiled_mst]") {
+        xt::random::seed(42);
+        array_2d<int> image = xt::random::randint<int>({23, 31}, 0, 4);
+        vector<pair<index_t, index_t>> tile_shapes{{1,  1},
+                                                   {5,  7},
+                                                   {4,  31},
+                                                   {23, 3},
+                                                   {8,  8},
+                                                   {50, 50}};
+        for (auto &s: tile_shapes) {
+            check_tiled_mst(image, s.first, s.second, weight_functions::L1);
+            check_tiled_mst(image, s.first, s.second, weight_functions::max);
+        }
+
+        array_2d<double> image_1d = xt::random::rand<double>({1, 40});
+        check_tiled_mst(image_1d, 1, 6, weight_functions::L1);
+        check_tiled_mst(xt::eval(xt::transpose(image_1d)), 6, 1, weight_functions::L1);
+    }
+
+    TEST_CASE("tiled minimum spanning tree vectorial", "[tiled_mst]") {
+        xt::random::seed(42);
+        array_3d<double> image = xt::random::rand<double>({17, 13, 3});
+        check_tiled_mst(image, 4, 5, weight_functions::L2);
+        check_tiled_mst(image, 7, 13, weight_functions::L_infinity);
+    }
+
+    TEST_CASE("tiled minimum spanning tree without prefetch", "[tiled_mst]") {
+        xt::random::seed(42);
+        array_2d<int> image = xt::random::randint<int>({23, 31}, 0, 4);
+        check_tiled_mst(image, 5, 7, weight_functions::L1, false);
+        check_tiled_mst(image, 50, 50, weight_functions::L1, false);
+    }
+}
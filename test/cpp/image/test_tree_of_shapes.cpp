@@ -399,4 +399,157 @@ TEST_CASE("test tree of shapes self duality", "[tree_of_shapes]") {
     REQUIRE(test_tree_isomorphism(res1.tree, res2.tree));
 }
 
+
+TEST_CASE("test tree of shapes parallel canonization", "[tree_of_shapes]") {
+    xt::random::seed(42);
+    array_2d<int> image = xt::random::randint<int>({23, 31}, 0, 5);
+    auto plain_map = tree_of_shapes_internal::interpolate_plain_map_khalimsky_2d(image, embedding_grid_2d{23, 31});
+    auto graph = get_4_adjacency_implicit_graph({23 * 2 - 1, 31 * 2 - 1});
+    auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, plain_map, 0);
+    auto &sorted_vertex_indices = res_sort.first;
+    auto &enqueued_levels = res_sort.second;
+
+    auto parents = component_tree_internal::pre_tree_construction(graph, sorted_vertex_indices);
+    array_1d<index_t> ref = parents;
+    component_tree_internal::canonize_tree(ref, enqueued_levels, sorted_vertex_indices);
+    for (index_t num_blocks: {1, 2, 3, 7, 16}) {
+        array_1d<index_t> res = parents;
+        component_tree_internal::parallel_canonize_tree(res, enqueued_levels, sorted_vertex_indices, num_blocks);
+        REQUIRE((res == ref));
+    }
+}
+
+TEST_CASE("test tree of shapes parallel pre-tree", "[tree_of_shapes]") {
+    xt::random::seed(42);
+    array_2d<int> image = xt::random::randint<int>({23, 31}, 0, 5);
+    auto plain_map = tree_of_shapes_internal::interpolate_plain_map_khalimsky_2d(image, embedding_grid_2d{23, 31});
+    auto graph = get_4_adjacency_implicit_graph({23 * 2 - 1, 31 * 2 - 1});
+    auto res_sort = tree_of_shapes_internal::sort_vertices_tree_of_shapes(graph, plain_map, 0);
+    auto &sorted_vertex_indices = res_sort.first;
+
+    auto ref = component_tree_internal::pre_tree_construction(graph, sorted_vertex_indices);
+    array_1d<index_t> rank = array_1d<index_t>::from_shape({ref.size()});
+    for (index_t i = 0; i < (index_t) rank.size(); i++) {
+        rank(sorted_vertex_indices(i)) = i;
+    }
+    for (index_t num_blocks: {2, 3, 7, 16}) {
+        auto res = component_tree_internal::parallel_pre_tree_construction(graph, rank, sorted_vertex_indices,
+                                                                          num_blocks);
+        REQUIRE((res == ref));
+    }
+}
+
+TEMPLATE_TEST_CASE("test parallel tree of shapes", "[tree_of_shapes]", unsigned char, float) {
+    xt::random::seed(42);
+    array_2d<TestType> image = xt::random::randint<int>({41, 37}, 0, 20);
+    for (auto padding: {tos_padding::none, tos_padding::zero, tos_padding::mean}) {
+        for (auto original_size: {true, false}) {
+            for (auto immersion: {true, false}) {
+                auto ref = component_tree_tree_of_shapes_image2d(image, padding, original_size, immersion);
+                for (index_t num_blocks: {0, 1, 2, 5, 13}) {
+                    auto res = component_tree_parallel_tree_of_shapes_image2d(image, padding, original_size,
+                                                                              immersion, 0, num_blocks);
+                    REQUIRE((res.tree.parents() == ref.tree.parents()));
+                    REQUIRE((res.altitudes == ref.altitudes));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("test tree of shapes non contiguous image", "[tree_of_shapes]") {
+    xt::random::seed(42);
+    array_2d<double> image = xt::random::rand<double>({17, 12});
+    array_2d<double> transposed = xt::transpose(image);
+    for (auto padding: {tos_padding::none, tos_padding::mean}) {
+        for (auto immersion: {true, false}) {
+            auto res1 = component_tree_tree_of_shapes_image2d(xt::transpose(image), padding, true, immersion);
+            auto res2 = component_tree_tree_of_shapes_image2d(transposed, padding, true, immersion);
+            REQUIRE((res1.tree.parents() == res2.tree.parents()));
+            REQUIRE((res1.altitudes == res2.altitudes));
+        }
+    }
+}
+
+
+TEMPLATE_TEST_CASE("test tree of shapes nd on 2d images", "[tree_of_shapes]", unsigned char, double) {
+    xt::random::seed(42);
+    array_2d<TestType> image = xt::random::randint<int>({9, 13}, 0, 20);
+    for (auto padding: {tos_padding::none, tos_padding::zero, tos_padding::mean}) {
+        for (auto original_size: {true, false}) {
+            for (auto immersion: {true, false}) {
+                auto ref = component_tree_tree_of_shapes_image2d(image, padding, original_size, immersion);
+                auto res = component_tree_tree_of_shapes_image(image, padding, original_size, immersion);
+                REQUIRE((res.tree.parents() == ref.tree.parents()));
+                REQUIRE((res.altitudes == ref.altitudes));
+            }
+        }
+    }
+
+    auto ref = component_tree_tree_of_shapes_image2d(image, tos_padding::mean, true, true, 7);
+    auto res = component_tree_tree_of_shapes_image(image, tos_padding::mean, true, true, 7);
+    REQUIRE((res.tree.parents() == ref.tree.parents()));
+    REQUIRE((res.altitudes == ref.altitudes));
+
+    array_2d<TestType> transposed = xt::transpose(image);
+    auto res_transposed = component_tree_tree_of_shapes_image(xt::transpose(image));
+    auto ref_transposed = component_tree_tree_of_shapes_image2d(transposed);
+    REQUIRE((res_transposed.tree.parents() == ref_transposed.tree.parents()));
+    REQUIRE((res_transposed.altitudes == ref_transposed.altitudes));
+}
+
+TEST_CASE("test tree of shapes nd degenerate axes", "[tree_of_shapes]") {
+    xt::random::seed(42);
+    array_2d<float> image = xt::random::rand<float>({7, 11});
+    auto ref = component_tree_tree_of_shapes_image2d(image, tos_padding::none, false);
+
+    array_nd<float> image4d = image;
+    image4d.reshape({1, 7, 1, 11});
+    auto res4d = component_tree_tree_of_shapes_image(image4d, tos_padding::none, false);
+    REQUIRE((res4d.tree.parents() == ref.tree.parents()));
+    REQUIRE((res4d.altitudes == ref.altitudes));
+
+    array_2d<float> row = xt::view(image, xt::range(0, 1), xt::all());
+    auto ref1d = component_tree_tree_of_shapes_image2d(row, tos_padding::none, false);
+    array_1d<float> image1d = xt::view(image, 0, xt::all());
+    auto res1d = component_tree_tree_of_shapes_image(image1d, tos_padding::none, false);
+    REQUIRE((res1d.tree.parents() == ref1d.tree.parents()));
+    REQUIRE((res1d.altitudes == ref1d.altitudes));
+}
+
+TEST_CASE("test tree of shapes 3d", "[tree_of_shapes]") {
+    array_3d<int> image = xt::zeros<int>({5, 6, 5});
+    xt::view(image, xt::range(1, 4), xt::range(1, 5), xt::range(1, 4)) = 3;
+    image(2, 2, 2) = 5;
+    image(2, 3, 2) = 1;
+
+    auto res = component_tree_tree_of_shapes_image(image);
+    auto &tree = res.tree;
+    auto &altitudes = res.altitudes;
+    REQUIRE(num_leaves(tree) == 5 * 6 * 5);
+    REQUIRE(num_vertices(tree) == 5 * 6 * 5 + 4);
+    auto leaf = [](index_t z, index_t y, index_t x) { return (z * 6 + y) * 5 + x; };
+    auto root = tree.root();
+    REQUIRE(altitudes(root) == 0);
+    REQUIRE(parent(leaf(0, 0, 0), tree) == root);
+    auto cube = parent(leaf(1, 1, 1), tree);
+    REQUIRE(altitudes(cube) == 3);
+    REQUIRE(parent(cube, tree) == root);
+    REQUIRE(altitudes(parent(leaf(2, 2, 2), tree)) == 5);
+    REQUIRE(parent(parent(leaf(2, 2, 2), tree), tree) == cube);
+    REQUIRE(altitudes(parent(leaf(2, 3, 2), tree)) == 1);
+    REQUIRE(parent(parent(leaf(2, 3, 2), tree), tree) == cube);
+
+    auto res_full = component_tree_tree_of_shapes_image(image, tos_padding::mean, false);
+    REQUIRE(num_leaves(res_full.tree) == 13 * 15 * 13);
+}
+
+TEST_CASE("test tree of shapes 3d self duality", "[tree_of_shapes]") {
+    xt::random::seed(42);
+    array_3d<double> image = xt::random::rand<double>({6, 7, 5});
+    auto res1 = component_tree_tree_of_shapes_image(image);
+    auto res2 = component_tree_tree_of_shapes_image(-image);
+    REQUIRE(test_tree_isomorphism(res1.tree, res2.tree));
+}
+
 }
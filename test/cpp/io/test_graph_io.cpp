@@ -0,0 +1,267 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/io/graph_io.hpp"
+#include "higra/image/graph_image.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace graph_io {
+
+    using namespace hg;
+    using namespace std;
+
+    template<typename g1_t, typename g2_t>
+    void check_same_graph(const g1_t &g1, const g2_t &g2) {
+        REQUIRE(num_vertices(g1) == num_vertices(g2));
+        REQUIRE(num_edges(g1) == num_edges(g2));
+        REQUIRE((sources(g1) == sources(g2)));
+        REQUIRE((targets(g1) == targets(g2)));
+        for (auto v: vertex_iterator(g1)) {
+            vector<index_t> out1;
+            vector<index_t> out2;
+            for (auto e: out_edge_iterator(v, g1)) {
+                out1.push_back(index(e, g1));
+                REQUIRE(source(e, g1) == v);
+            }
+            for (auto e: out_edge_iterator(v, g2)) {
+                out2.push_back(index(e, g2));
+                REQUIRE(source(e, g2) == v);
+            }
+            REQUIRE(out1 == out2);
+        }
+    }
+
+    TEST_CASE("save and read undirected graph", "[graph_io]") {
+        ugraph g(5);
+        add_edges(array_1d<index_t>{0, 1, 3, 2, 4, 2}, array_1d<index_t>{1, 2, 4, 2, 0, 3}, g);
+        array_1d<float> edge_weights{1, 2, 3, 4, 5, 6};
+        array_2d<uint8_t> vertex_weights{{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}};
+
+        ostringstream out;
+        save_graph(out, g).add_edge_attribute("w", edge_weights).add_vertex_attribute("color", vertex_weights);
+        string res = out.str();
+        istringstream in(res);
+
+        graph_file_reader reader(in);
+        REQUIRE(reader.kind() == graph_file_kind::undirected);
+        REQUIRE(reader.num_vertices() == 5);
+        REQUIRE(reader.num_edges() == 6);
+        REQUIRE(reader.shape().empty());
+        REQUIRE(reader.attribute_names(graph_attribute_kind::edge) == vector<string>{"w"});
+        REQUIRE(reader.attribute_names(graph_attribute_kind::vertex) == vector<string>{"color"});
+        REQUIRE(reader.attribute_dtype(graph_attribute_kind::edge, "w") == tree_io_dtype::of<float>());
+        REQUIRE(reader.attribute_shape(graph_attribute_kind::vertex, "color") == vector<size_t>{5, 2});
+        REQUIRE(!reader.has_attribute(graph_attribute_kind::vertex, "w"));
+
+        check_same_graph(g, reader.read_undirected_graph());
+        check_same_graph(g, reader.read_csr_graph());
+        REQUIRE((reader.read_attribute<float>(graph_attribute_kind::edge, "w") == edge_weights));
+        REQUIRE((reader.read_attribute<uint8_t>(graph_attribute_kind::vertex, "color") == vertex_weights));
+        REQUIRE((reader.read_attribute<double>(graph_attribute_kind::vertex, "color") == vertex_weights));
+        REQUIRE_THROWS(reader.read_attribute(graph_attribute_kind::edge, "color"));
+        REQUIRE_THROWS(reader.read_regular_graph<2>());
+    }
+
+    TEST_CASE("save and read graph with shape and removed edges", "[graph_io]") {
+        auto g = get_4_adjacency_graph({3, 4});
+        g.remove_edge(2);
+
+        ostringstream out;
+        save_graph(out, g).add_shape({3, 4});
+        istringstream in(out.str());
+
+        graph_file_reader reader(in);
+        REQUIRE(reader.shape() == vector<size_t>{3, 4});
+        auto g2 = reader.read_undirected_graph();
+        check_same_graph(g, g2);
+        REQUIRE(source(edge_from_index(2, g2), g2) == invalid_index);
+
+        ostringstream out2;
+        REQUIRE_THROWS(save_graph(out2, g).add_shape({3, 3}));
+    }
+
+    TEST_CASE("save and read csr graph", "[graph_io]") {
+        auto g = freeze(get_8_adjacency_graph({5, 6}));
+        ostringstream out;
+        save_graph(out, g);
+        istringstream in(out.str());
+
+        graph_file_reader reader(in);
+        check_same_graph(g, reader.read_csr_graph());
+        check_same_graph(g, reader.read_undirected_graph());
+    }
+
+    TEST_CASE("save and read regular graph", "[graph_io]") {
+        auto g = get_4_adjacency_implicit_graph({3, 4});
+        array_1d<double> vertex_weights = xt::arange<double>(12);
+
+        ostringstream out;
+        save_graph(out, g).add_vertex_attribute("v", vertex_weights);
+        istringstream in(out.str());
+
+        graph_file_reader reader(in);
+        REQUIRE(reader.kind() == graph_file_kind::regular);
+        REQUIRE(reader.shape() == vector<size_t>{3, 4});
+        auto g2 = reader.read_regular_graph<2>();
+        REQUIRE((g2.embedding().shape() == g.embedding().shape()));
+        REQUIRE(g2.neighbours().size() == g.neighbours().size());
+        for (index_t i = 0; i < (index_t) g.neighbours().size(); i++) {
+            REQUIRE((g2.neighbours()[i] == g.neighbours()[i]));
+        }
+        REQUIRE_THROWS(reader.read_regular_graph<3>());
+        check_same_graph(get_4_adjacency_graph({3, 4}), reader.read_undirected_graph());
+        check_same_graph(get_4_adjacency_graph({3, 4}), reader.read_csr_graph());
+        REQUIRE((reader.read_attribute<double>(graph_attribute_kind::vertex, "v") == vertex_weights));
+
+        ostringstream out2;
+        REQUIRE_THROWS(save_graph(out2, g).add_edge_attribute("e", vertex_weights));
+    }
+
+    TEST_CASE("graph file memory mapped", "[graph_io]") {
+        auto g = get_4_adjacency_graph({20, 30});
+        array_1d<double> edge_weights = xt::arange<double>(num_edges(g));
+        const char *filename = "test_graph_io_mapped.graph";
+        {
+            ofstream out(filename, ios::binary);
+            save_graph(out, g).add_edge_attribute("w", edge_weights);
+        }
+
+        csr_graph g2;
+        {
+            auto reader = map_graph_file(filename);
+            auto data = (const char *) reader.attribute_data(graph_attribute_kind::edge, "w");
+            REQUIRE(data != nullptr);
+            REQUIRE(std::memcmp(data, edge_weights.data(), num_edges(g) * sizeof(double)) == 0);
+            g2 = reader.read_csr_graph();
+            // the graph is used in place in the mapping
+            REQUIRE(((const char *) g2.edges_data() < data && (const char *) g2.out_edges_data() < data));
+        }
+        // the mapping is kept alive by the graph
+        check_same_graph(g, g2);
+        auto g3 = g2;
+        g2 = csr_graph();
+        check_same_graph(g, g3);
+        g3 = csr_graph();
+        std::remove(filename);
+
+        REQUIRE_THROWS(map_graph_file(filename));
+    }
+
+    TEST_CASE("corrupted graph buffer", "[graph_io]") {
+        ugraph g(5);
+        add_edges(array_1d<index_t>{0, 1, 3, 2, 4, 2}, array_1d<index_t>{1, 2, 4, 2, 0, 3}, g);
+        ostringstream out;
+        save_graph(out, g);
+        const string res = out.str();
+
+        auto buffer = std::make_shared<std::vector<uint64_t>>(res.size() / sizeof(uint64_t) + 1);
+        auto data = (char *) buffer->data();
+        auto reset = [&]() { std::memcpy(data, res.data(), res.size()); };
+        // table of contents: edges, offsets and out edges entries made of 6 fields (kind, dtype, offset, size, ndim,
+        // name size) followed by the shape
+        uint64_t toc;
+        std::memcpy(&toc, res.data() + 48, sizeof(toc));
+        const uint64_t entries[] = {toc, toc + 8 * sizeof(uint64_t), toc + 15 * sizeof(uint64_t)};
+        auto get_field = [&](index_t entry, index_t field) {
+            uint64_t value;
+            std::memcpy(&value, data + entries[entry] + field * sizeof(uint64_t), sizeof(value));
+            return value;
+        };
+        auto set_field = [&](index_t entry, index_t field, uint64_t value) {
+            std::memcpy(data + entries[entry] + field * sizeof(uint64_t), &value, sizeof(value));
+        };
+        auto set_value = [&](index_t entry, index_t i, index_t value) {
+            std::memcpy(data + get_field(entry, 2) + i * sizeof(index_t), &value, sizeof(value));
+        };
+        auto read = [&]() {
+            graph_file_reader reader(data, res.size(), nullptr);
+            reader.read_csr_graph();
+        };
+
+        REQUIRE_THROWS(graph_file_reader(data, 0, nullptr));
+        REQUIRE_THROWS(graph_file_reader(nullptr, 0, nullptr));
+        reset();
+        REQUIRE_NOTHROW(read());
+        REQUIRE_THROWS(graph_file_reader(data, 32, nullptr));
+
+        // unknown data type, or data type of size 0
+        set_field(0, 1, 'i' | (3 << 8));
+        REQUIRE_THROWS(read());
+        set_field(0, 1, 'i');
+        REQUIRE_THROWS(read());
+
+        // out edges stored as a 1d array
+        reset();
+        set_field(2, 4, 1);
+        set_field(2, 3, get_field(2, 3) / 2);
+        REQUIRE_THROWS(read());
+
+        // the structure of the graph is checked whatever the validation level
+        for (auto level: {validation_level::full, validation_level::shape}) {
+            set_validation_level(level);
+
+            // non monotone offsets
+            reset();
+            set_value(1, 1, 10);
+            REQUIRE_THROWS(read());
+
+            // edge and out edge endpoints out of range
+            reset();
+            set_value(0, 0, 5);
+            REQUIRE_THROWS(read());
+            reset();
+            set_value(2, 0, -1);
+            REQUIRE_THROWS(read());
+            reset();
+            set_value(2, 1, 6);
+            REQUIRE_THROWS(read());
+        }
+        set_validation_level(validation_level::full);
+
+        // offsets such that offset + size wraps around
+        reset();
+        set_field(0, 2, (uint64_t) 0 - 64);
+        REQUIRE_THROWS(read());
+        {
+            graph_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.read_undirected_graph());
+        }
+
+        // dimensions, shapes and name lengths larger than the file
+        reset();
+        set_field(2, 4, (uint64_t) 1 << 40);
+        REQUIRE_THROWS(read());
+        reset();
+        set_field(0, 5, (uint64_t) 0 - 1);
+        REQUIRE_THROWS(read());
+        istringstream in(string(data, res.size()));
+        REQUIRE_THROWS(graph_file_reader(in));
+        reset();
+        // number of out edges such that the array size in bytes wraps around to the stored size
+        set_field(2, 6, get_field(2, 6) + ((uint64_t) 1 << 60));
+        REQUIRE_THROWS(read());
+
+        // empty mapped file
+        const char *filename = "test_graph_io_empty.graph";
+        {
+            ofstream empty(filename, ios::binary);
+        }
+        REQUIRE_THROWS(map_graph_file(filename));
+        std::remove(filename);
+    }
+
+    TEST_CASE("invalid graph file", "[graph_io]") {
+        istringstream in("HGTREEV2 not a graph file at all, not a graph file at all, not a graph file at all");
+        REQUIRE_THROWS(graph_file_reader(in));
+    }
+}
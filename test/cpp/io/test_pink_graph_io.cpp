@@ -10,6 +10,8 @@
 
 #include "higra/io/pink_graph_io.hpp"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
 #include <string>
 #include "../test_utils.hpp"
 #include "xtensor/xgenerator.hpp"
@@ -273,4 +275,120 @@ namespace pink_graph_io {
         ostringstream out;
         REQUIRE_THROWS(save_pink_graph(out, g, vertex_weights, edge_weights, shape));
     }
+
+    TEST_CASE("read graph from file", "[pink_graph_io]") {
+        const char *filename = "test_pink_graph_io.graph";
+        {
+            ofstream out(filename);
+            out << s;
+        }
+        auto res = read_pink_graph(string(filename));
+        std::remove(filename);
+
+        istringstream in(s);
+        auto ref = read_pink_graph(in);
+        REQUIRE(num_vertices(res.graph) == num_vertices(ref.graph));
+        REQUIRE((sources(res.graph) == sources(ref.graph)));
+        REQUIRE((targets(res.graph) == targets(ref.graph)));
+        REQUIRE(vectorEqual(res.shape, ref.shape));
+        REQUIRE((res.vertex_weights == ref.vertex_weights));
+        REQUIRE((res.edge_weights == ref.edge_weights));
+
+        REQUIRE_THROWS(read_pink_graph(string(filename)));
+    }
+
+    TEST_CASE("read graph number formats", "[pink_graph_io]") {
+        string s3(
+                "4 4\r\n"
+                "val sommets\r\n"
+                "0 -1.5\r\n"
+                "1 +2\r\n"
+                "2 1e-3\r\n"
+                "3 123456789012345678\r\n"
+                "arcs values\r\n"
+                "1 0 0.1\r\n"
+                "1 2 -7\r\n"
+                "3 3 2.5E2\r\n"
+                "2 0 1\r\n");
+        istringstream in(s3);
+        auto res = read_pink_graph(in);
+
+        array_1d<double> vertex_weights{-1.5, 2, 1e-3, 123456789012345678.};
+        array_1d<double> edge_weights{0.1, -7, 250, 1};
+        REQUIRE((res.vertex_weights == vertex_weights));
+        REQUIRE((res.edge_weights == edge_weights));
+        REQUIRE((sources(res.graph) == array_1d<index_t>{0, 1, 3, 0}));
+        REQUIRE((targets(res.graph) == array_1d<index_t>{1, 2, 3, 2}));
+
+        // same out edges as with add_edge
+        ugraph g(4);
+        add_edge(1, 0, g);
+        add_edge(1, 2, g);
+        add_edge(3, 3, g);
+        add_edge(2, 0, g);
+        for (auto v: vertex_iterator(g)) {
+            REQUIRE(std::vector<index_t>(res.graph.out_edges_cbegin(v), res.graph.out_edges_cend(v)) ==
+                    std::vector<index_t>(g.out_edges_cbegin(v), g.out_edges_cend(v)));
+        }
+    }
+
+    TEST_CASE("read invalid graph", "[pink_graph_io]") {
+        istringstream in1(s.substr(0, s.size() - 10));
+        REQUIRE_THROWS(read_pink_graph(in1));
+
+        string s3(
+                "2 1\n"
+                "val sommets\n"
+                "0 1\n"
+                "1 x\n"
+                "arcs values\n"
+                "0 1 1\n");
+        istringstream in2(s3);
+        REQUIRE_THROWS(read_pink_graph(in2));
+
+        string s4(
+                "2 1\n"
+                "val sommets\n"
+                "0 1\n"
+                "1 1\n"
+                "arcs values\n"
+                "0 2 1\n");
+        istringstream in3(s4);
+        REQUIRE_THROWS(read_pink_graph(in3));
+    }
+
+    TEST_CASE("binary graph round trip", "[pink_graph_io]") {
+        istringstream in(s);
+        auto ref = read_pink_graph(in);
+        array_1d<double> edge_weights = xt::cast<double>(ref.edge_weights) / 3;
+
+        ostringstream out;
+        save_pink_graph_binary(out, ref.graph, ref.vertex_weights, edge_weights, ref.shape);
+        string data = out.str();
+        REQUIRE(data.size() == 64 + 8 * (15 + 3 * 14));
+
+        istringstream in2(data);
+        auto res = read_pink_graph(in2);
+        REQUIRE(num_vertices(res.graph) == 15);
+        REQUIRE((sources(res.graph) == sources(ref.graph)));
+        REQUIRE((targets(res.graph) == targets(ref.graph)));
+        REQUIRE(vectorEqual(res.shape, ref.shape));
+        REQUIRE((res.vertex_weights == ref.vertex_weights));
+        // lossless
+        REQUIRE((res.edge_weights == edge_weights));
+
+        // default weights, no shape
+        ostringstream out2;
+        save_pink_graph_binary(out2, ref.graph, array_1d<double>{}, array_1d<double>{}, std::vector<size_t>{});
+        istringstream in3(out2.str());
+        auto res2 = read_pink_graph(in3);
+        REQUIRE(vectorEqual(res2.shape, std::vector<size_t>{15}));
+        REQUIRE((res2.vertex_weights == xt::ones<double>({15})));
+        REQUIRE((res2.edge_weights == xt::ones<double>({14})));
+
+        // truncated file
+        istringstream in4(data.substr(0, data.size() - 8));
+        REQUIRE_THROWS(read_pink_graph(in4));
+    }
+
 }
\ No newline at end of file
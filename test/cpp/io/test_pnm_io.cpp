@@ -10,30 +10,13 @@
 
 #include "../test_utils.hpp"
 #include "higra/io/pnm_io.hpp"
+#include <cstdio>
 
 namespace pnm_io {
 
     using namespace hg;
     using namespace std;
 
-    TEST_CASE("tokenizer", "[pnm_io]") {
-        string test = "#comment\n"
-                      "2 abc\n"
-                      "####\n"
-                      "3\n"
-                      "jkl\n"
-                      "\n";
-        std::stringstream in(test);
-        pnm_io_internal::tokenizer tok(in);
-
-        string ref[]{"2", "abc", "3", "jkl"};
-        string s;
-        int i = 0;
-        while ((s = tok.next_token()) != "") {
-            REQUIRE(ref[i++] == s);
-        }
-        REQUIRE(i == 4);
-    }
     /*
     * Type	Magic number	Extension	Colors
     *               ASCII	Binary
@@ -182,4 +165,98 @@ namespace pnm_io {
         auto res2 = pnm_io_internal::read_image_pnm(in);
         REQUIRE((res2 == ref));
     }
+
+    TEST_CASE("read PNM 16 bits", "[pnm_io]") {
+        string test = "P5\n"
+                      "3 2\n"
+                      "# comment\n"
+                      "65535\n";
+        const unsigned char data[] = {0, 1, 1, 0, 255, 255, 0, 0, 18, 52, 128, 1};
+        test.append((const char *) data, sizeof(data));
+
+        std::stringstream in(test);
+        auto res = pnm_io_internal::read_image_pnm<uint16_t>(in);
+        array_nd<uint16_t> ref = {
+                {1, 256,  65535},
+                {0, 4660, 32769}
+        };
+        REQUIRE((res == ref));
+
+        std::stringstream in2(test);
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm(in2));
+
+        string test2 = "P2\n"
+                       "3 1 1000\n"
+                       "0 999 1000";
+        std::stringstream in3(test2);
+        auto res2 = pnm_io_internal::read_image_pnm<uint16_t>(in3);
+        REQUIRE((res2 == array_nd<uint16_t>{{0, 999, 1000}}));
+
+        // 8 bits images can be read in a 16 bits array
+        string test3 = "P5\n2 1 255\n\x01\xff";
+        std::stringstream in4(test3);
+        REQUIRE((pnm_io_internal::read_image_pnm<uint16_t>(in4) == array_nd<uint16_t>{{1, 255}}));
+    }
+
+    TEST_CASE("read invalid PNM", "[pnm_io]") {
+        std::stringstream in1("P7\n1 1 255\na");
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm(in1));
+        std::stringstream in2("P5\n2 2 255\naaa");
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm(in2));
+        std::stringstream in3("P2\n2 2 255\n1 2 3");
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm(in3));
+        std::stringstream in4("P2\n2 1 10\n1 20");
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm(in4));
+        std::stringstream in5("P5\n2 1 70000\naaaa");
+        REQUIRE_THROWS(pnm_io_internal::read_image_pnm<uint16_t>(in5));
+    }
+
+    TEST_CASE("save PNM 16 bits", "[pnm_io]") {
+        array_nd<uint16_t> ref = {
+                {0, 10, 1000, 0,   1},
+                {1, 1,  0, 65535, 1},
+                {1, 0,  1, 256,   1}
+        };
+        ostringstream out;
+        pnm_io_internal::save_image_pnm(out, ref);
+        string res = out.str();
+
+        istringstream in(res);
+        auto res2 = pnm_io_internal::read_image_pnm<uint16_t>(in);
+        REQUIRE((res2 == ref));
+    }
+
+    TEST_CASE("map PNM file", "[pnm_io]") {
+        const char *filename = "test_pnm_io_mapped.ppm";
+        array_nd<unsigned char> ref = {
+                {{0, 10, 1}, {0,   1, 25}},
+                {{1, 1,  0}, {255, 1, 12}},
+                {{1, 0,  1}, {34,  1, 1}}
+        };
+        save_image_pnm(filename, ref);
+
+        {
+            auto image = map_image_pnm(filename);
+            REQUIRE(image.has_view());
+            REQUIRE(image.max_value() == 255);
+            REQUIRE(image.shape() == std::vector<size_t>{3, 2, 3});
+            const auto view = image.view();
+            REQUIRE((view == ref));
+            REQUIRE((image.to_array() == ref));
+            REQUIRE((read_image_pnm(filename) == ref));
+        }
+
+        array_nd<uint16_t> ref16 = {{1, 2, 65535}};
+        save_image_pnm(filename, ref16);
+        {
+            auto image = map_image_pnm(filename);
+            REQUIRE(!image.has_view());
+            REQUIRE_THROWS(image.view());
+            REQUIRE((image.to_array<uint16_t>() == ref16));
+            REQUIRE((read_image_pnm<uint16_t>(filename) == ref16));
+            REQUIRE_THROWS(read_image_pnm(filename));
+        }
+        std::remove(filename);
+    }
+
 }
\ No newline at end of file
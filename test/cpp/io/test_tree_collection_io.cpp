@@ -0,0 +1,196 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/io/tree_collection_io.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "xtensor/xrandom.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace tree_collection_io {
+
+    using namespace hg;
+    using namespace std;
+
+    struct collection_data {
+        ugraph graph;
+        array_2d<double> image;
+        vector<node_weighted_tree<tree, array_1d<double>>> trees;
+    };
+
+    // hierarchies of the 3 channels of a color image on the same 4 adjacency graph
+    static collection_data make_collection_data() {
+        xt::random::seed(1);
+        collection_data data{get_4_adjacency_graph({9, 11}), xt::random::rand<double>({99, 3}), {}};
+        for (index_t c = 0; c < 3; c++) {
+            array_1d<double> channel = xt::view(data.image, xt::all(), c);
+            auto bpt = bpt_canonical(data.graph, weight_graph(data.graph, channel, weight_functions::L1));
+            data.trees.push_back(make_node_weighted_tree(std::move(bpt.tree), std::move(bpt.altitudes)));
+        }
+        return data;
+    }
+
+    static void write_collection(ostream &out, const collection_data &data) {
+        const char *names[] = {"red", "green", "blue"};
+        auto writer = save_tree_collection(out);
+        writer.set_leaf_graph(data.graph)
+                .add_shape({9, 11})
+                .add_vertex_attribute("image", data.image);
+        for (index_t c = 0; c < 3; c++) {
+            const auto &t = data.trees[c];
+            writer.add_tree(names[c], t.tree)
+                    .add_attribute("altitudes", t.altitudes)
+                    .add_attribute("area", attribute_area(t.tree));
+        }
+    }
+
+    static void check_collection(tree_collection_reader &reader, const collection_data &data) {
+        REQUIRE(reader.num_trees() == 3);
+        REQUIRE(reader.tree_names() == vector<string>{"red", "green", "blue"});
+        REQUIRE(reader.has_tree("green"));
+        REQUIRE(!reader.has_tree("alpha"));
+        REQUIRE(reader.has_leaf_graph());
+
+        // trees are read in any order, without the leaf graph
+        for (index_t c: {2, 0, 1}) {
+            auto tree_reader = reader.tree_reader(c);
+            auto t = tree_reader.read_tree();
+            REQUIRE((parents(t) == parents(data.trees[c].tree)));
+            REQUIRE((tree_reader.read_attribute<double>("altitudes") == data.trees[c].altitudes));
+            REQUIRE(tree_reader.attribute_dtype("area") == tree_io_dtype::of<index_t>());
+        }
+        auto blue = reader.tree_reader("blue");
+        REQUIRE((parents(blue.read_tree()) == parents(data.trees[2].tree)));
+        REQUIRE_THROWS(reader.tree_reader("alpha"));
+        REQUIRE_THROWS(reader.tree_reader(3));
+
+        auto graph_reader = reader.leaf_graph_reader();
+        auto graph = graph_reader.read_undirected_graph();
+        REQUIRE(num_vertices(graph) == num_vertices(data.graph));
+        REQUIRE((sources(graph) == sources(data.graph)));
+        REQUIRE((targets(graph) == targets(data.graph)));
+        REQUIRE(graph_reader.shape() == vector<size_t>{9, 11});
+        REQUIRE((graph_reader.read_attribute<double>(graph_attribute_kind::vertex, "image") == data.image));
+    }
+
+    TEST_CASE("tree collection stream", "[tree_collection_io]") {
+        auto data = make_collection_data();
+        ostringstream out;
+        // the collection does not need to start at the beginning of the stream
+        out << "prefix";
+        write_collection(out, data);
+        string res = out.str();
+
+        istringstream in(res);
+        in.seekg(6);
+        tree_collection_reader reader(in);
+        check_collection(reader, data);
+
+        tree_collection_reader buffer_reader(res.data() + 6, res.size() - 6, nullptr);
+        check_collection(buffer_reader, data);
+    }
+
+    TEST_CASE("tree collection memory mapped", "[tree_collection_io]") {
+        auto data = make_collection_data();
+        const char *filename = "test_tree_collection_io_mapped.trees";
+        {
+            ofstream out(filename, ios::binary);
+            write_collection(out, data);
+        }
+        {
+            auto reader = map_tree_collection(filename);
+            check_collection(reader, data);
+            // uncompressed arrays are used in place in the mapped file
+            auto tree_reader = reader.tree_reader("green");
+            auto view = tree_reader.attribute_view<double>("altitudes");
+            REQUIRE((view == data.trees[1].altitudes));
+            REQUIRE(tree_reader.attribute_data("altitudes") != nullptr);
+            auto graph = reader.leaf_graph_reader().read_csr_graph();
+            REQUIRE(num_edges(graph) == num_edges(data.graph));
+        }
+        std::remove(filename);
+    }
+
+    TEST_CASE("tree collection without leaf graph", "[tree_collection_io]") {
+        tree t1(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        tree t2(array_1d<index_t>{4, 4, 5, 5, 5, 5});
+        ostringstream out;
+        {
+            auto writer = save_tree_collection(out);
+            writer.add_tree("t1", t1);
+            writer.add_tree("t1 bis", t1).add_attribute("depth", array_1d<float>{3, 3, 2, 2, 2, 2, 1, 0});
+            // duplicated name and different number of leaves
+            REQUIRE_THROWS(writer.add_tree("t1", t1));
+            REQUIRE_THROWS(writer.add_tree("t2", t2));
+            REQUIRE_THROWS(writer.set_leaf_graph(get_4_adjacency_graph({2, 2})));
+        }
+        string res = out.str();
+        tree_collection_reader reader(res.data(), res.size(), nullptr);
+        REQUIRE(reader.num_trees() == 2);
+        REQUIRE(!reader.has_leaf_graph());
+        REQUIRE_THROWS(reader.leaf_graph_reader());
+        REQUIRE((parents(reader.tree_reader("t1").read_tree()) == parents(t1)));
+        auto r = reader.tree_reader("t1 bis");
+        REQUIRE((r.read_attribute<float>("depth") == array_1d<float>{3, 3, 2, 2, 2, 2, 1, 0}));
+    }
+
+    TEST_CASE("tree collection empty and invalid", "[tree_collection_io]") {
+        ostringstream out;
+        save_tree_collection(out).finalize();
+        string res = out.str();
+        tree_collection_reader reader(res.data(), res.size(), nullptr);
+        REQUIRE(reader.num_trees() == 0);
+
+        string invalid(64, 'a');
+        REQUIRE_THROWS(tree_collection_reader(invalid.data(), invalid.size(), nullptr));
+        REQUIRE_THROWS(tree_collection_reader(res.data(), 32, nullptr));
+        REQUIRE_THROWS(tree_collection_reader(nullptr, 0, nullptr));
+
+        const char *filename = "test_tree_collection_io_empty.trees";
+        {
+            ofstream empty(filename, ios::binary);
+        }
+        REQUIRE_THROWS(map_tree_collection(filename));
+        std::remove(filename);
+    }
+
+    TEST_CASE("tree collection corrupted buffer", "[tree_collection_io]") {
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        ostringstream out;
+        save_tree_collection(out).add_tree("t1", t);
+        const string res = out.str();
+        string data = res;
+        // table of contents: sections made of 4 fields (kind, offset, size, name size) followed by the name
+        uint64_t toc;
+        std::memcpy(&toc, res.data() + 24, sizeof(toc));
+        auto set_field = [&](index_t field, uint64_t value) {
+            data = res;
+            std::memcpy(&data[toc + field * sizeof(uint64_t)], &value, sizeof(value));
+        };
+        REQUIRE_NOTHROW(tree_collection_reader(data.data(), data.size(), nullptr).tree_reader("t1").read_tree());
+
+        // section offset such that offset + size wraps around
+        set_field(1, (uint64_t) 0 - 64);
+        REQUIRE_THROWS(tree_collection_reader(data.data(), data.size(), nullptr));
+
+        // name lengths larger than the file
+        for (uint64_t name_size: {(uint64_t) 1 << 40, (uint64_t) 0 - 1}) {
+            set_field(3, name_size);
+            REQUIRE_THROWS(tree_collection_reader(data.data(), data.size(), nullptr));
+            istringstream in(data);
+            REQUIRE_THROWS(tree_collection_reader(in));
+        }
+    }
+}
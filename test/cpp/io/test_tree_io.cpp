@@ -10,6 +10,8 @@
 
 #include "../test_utils.hpp"
 #include "higra/io/tree_io.hpp"
+#include <cstdio>
+#include <fstream>
 
 namespace tree_io {
 
@@ -40,4 +42,354 @@ namespace tree_io {
             REQUIRE(attributes.count("attr2") == 1);
             REQUIRE(xt::allclose(attributes["attr2"], attr2));
     }
-}
\ No newline at end of file
+
+    TEST_CASE("read tree v1", "[tree_io]") {
+        array_1d<int> parent{5, 5, 6, 6, 6, 7, 7, 7};
+        array_1d<double> attr1{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+        tree t(parent);
+        ostringstream out;
+        save_tree_v1(out, t).add_attribute("attr1", attr1).finalize();
+
+        istringstream in(out.str());
+        auto tree_attr = read_tree(in);
+        REQUIRE((parent == parents(tree_attr.first)));
+        REQUIRE(tree_attr.second.size() == 1);
+        REQUIRE((tree_attr.second["attr1"] == attr1));
+    }
+
+    TEST_CASE("tree file v2 native types", "[tree_io]") {
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        array_1d<double> attr1{1.5, 2, 3, 4, 5, 6, 7, 8};
+        array_1d<uint8_t> attr2{8, 7, 6, 5, 4, 3, 2, 1};
+        array_1d<int64_t> attr3{-1, (int64_t) 1 << 40, 3, 4, 5, 6, 7, 8};
+        array_1d<bool> attr4{true, false, true, true, false, false, true, false};
+        array_1d<float> attr5{0.5, 1, 2, 3, 4, 5, 6, 7};
+
+        ostringstream out;
+        // the tree file does not need to start at the beginning of the stream
+        out << "prefix";
+        save_tree(out, t)
+                .add_attribute("attr1", attr1)
+                .add_attribute("attr2", attr2)
+                .add_attribute("attr3", attr3)
+                .add_attribute("attr4", attr4)
+                .add_attribute("attr5", attr5)
+                .finalize();
+        string res = out.str();
+
+        istringstream in(res);
+        in.seekg(6);
+        tree_file_reader reader(in);
+        REQUIRE(reader.num_vertices() == 8);
+        REQUIRE(reader.num_leaves() == 5);
+        REQUIRE((reader.attribute_names() == std::vector<std::string>{"attr1", "attr2", "attr3", "attr4", "attr5"}));
+        REQUIRE(!reader.has_attribute("attr6"));
+        REQUIRE(reader.attribute_dtype("attr1").str() == "f8");
+        REQUIRE(reader.attribute_dtype("attr2").str() == "u1");
+        REQUIRE(reader.attribute_dtype("attr3").str() == "i8");
+        REQUIRE(reader.attribute_dtype("attr4").str() == "b1");
+        REQUIRE(reader.attribute_dtype("attr5").str() == "f4");
+        REQUIRE(reader.attribute_codec("attr1") == tree_io_codec::none);
+
+        // attributes are read independently, in any order
+        REQUIRE((reader.read_attribute<int64_t>("attr3") == attr3));
+        REQUIRE((reader.read_attribute<uint8_t>("attr2") == attr2));
+        REQUIRE((reader.read_attribute<float>("attr5") == attr5));
+        REQUIRE((reader.read_attribute<bool>("attr4") == attr4));
+        REQUIRE((reader.read_attribute("attr1") == attr1));
+        array_1d<double> attr2_d = attr2;
+        REQUIRE((reader.read_attribute<double>("attr2") == attr2_d));
+        array_1d<double> raw = array_1d<double>::from_shape({8});
+        reader.read_raw_attribute("attr1", raw.data());
+        REQUIRE((raw == attr1));
+        REQUIRE_THROWS_AS(reader.read_attribute("attr6"), std::runtime_error);
+
+        auto t2 = reader.read_tree();
+        REQUIRE((parents(t2) == parents(t)));
+        REQUIRE(num_leaves(t2) == 5);
+
+        // all attributes, converted to double
+        in.seekg(6);
+        auto tree_attr = read_tree(in);
+        REQUIRE((parents(tree_attr.first) == parents(t)));
+        REQUIRE(tree_attr.second.size() == 5);
+        REQUIRE((tree_attr.second["attr3"] == xt::cast<double>(attr3)));
+    }
+
+    TEST_CASE("tree file v2 views and expressions", "[tree_io]") {
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        array_1d<double> values{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+        array_1d<double> even{1, 3, 5, 7, 9, 11, 13, 15};
+        array_1d<double> last{9, 10, 11, 12, 13, 14, 15, 16};
+
+        ostringstream out;
+        save_tree(out, t)
+                .add_attribute("strided", xt::view(values, xt::range(0, 16, 2)))
+                .add_attribute("contiguous", xt::view(values, xt::range(8, 16)))
+                .add_attribute("expression", even * 2)
+                .finalize();
+        string res = out.str();
+
+        istringstream in(res);
+        tree_file_reader reader(in);
+        REQUIRE((reader.read_attribute("strided") == even));
+        REQUIRE((reader.read_attribute("contiguous") == last));
+        REQUIRE((reader.read_attribute("expression") == even * 2));
+    }
+
+    TEST_CASE("tree file v2 in memory buffer", "[tree_io]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 12, 13, 13, 14, 14});
+        array_1d<int32_t> attr1 = xt::arange<int32_t>(15);
+
+        ostringstream out;
+        save_tree(out, t).add_attribute("attr1", attr1);
+        string res = out.str();
+
+        // aligned copy of the file content, released with the last tree using it
+        auto buffer = std::make_shared<std::vector<uint64_t>>(res.size() / sizeof(uint64_t) + 1);
+        std::memcpy(buffer->data(), res.data(), res.size());
+        auto data = (const char *) buffer->data();
+        std::weak_ptr<std::vector<uint64_t>> weak_buffer = buffer;
+
+        tree t2;
+        {
+            tree_file_reader reader(data, res.size(), std::move(buffer));
+            REQUIRE((reader.read_attribute<int32_t>("attr1") == attr1));
+            t2 = reader.read_tree();
+        }
+        // parents are used in place
+        REQUIRE((const char *) t2.parents_data() > data);
+        REQUIRE((const char *) t2.parents_data() < data + res.size());
+        REQUIRE((parents(t2) == parents(t)));
+        REQUIRE(!weak_buffer.expired());
+        t2 = tree();
+        REQUIRE(weak_buffer.expired());
+    }
+
+    TEST_CASE("tree file v2 memory mapped", "[tree_io]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 12, 13, 13, 14, 14});
+        array_1d<float> attr1 = xt::arange<float>(15) / 2;
+        array_1d<uint8_t> attr2 = xt::arange<uint8_t>(15);
+        const char *filename = "test_tree_io_mapped.tree";
+        {
+            ofstream out(filename, ios::binary);
+            save_tree(out, t).add_attribute("attr1", attr1).add_attribute("attr2", attr2);
+        }
+
+        tree t2;
+        {
+            auto reader = map_tree_file(filename);
+            const char *data = (const char *) reader.attribute_data("attr1");
+            REQUIRE(data != nullptr);
+            const auto view1 = reader.attribute_view<float>("attr1");
+            REQUIRE((const char *) view1.data() == data);
+            REQUIRE((view1 == attr1));
+            REQUIRE((reader.attribute_view<uint8_t>("attr2") == attr2));
+            REQUIRE_THROWS(reader.attribute_view<double>("attr1"));
+            t2 = reader.read_tree();
+            // parents are used in place in the mapping
+            REQUIRE(t2.parents_data() != nullptr);
+            REQUIRE(std::abs((const char *) t2.parents_data() - data) < 4096);
+        }
+        // the mapping is kept alive by the tree
+        REQUIRE((parents(t2) == parents(t)));
+        t2 = tree();
+        std::remove(filename);
+
+        REQUIRE_THROWS(map_tree_file(filename));
+    }
+
+    TEST_CASE("tree file v2 corrupted buffer", "[tree_io]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 12, 13, 13, 14, 14});
+        array_1d<int32_t> attr1 = xt::arange<int32_t>(15);
+
+        ostringstream out;
+        save_tree(out, t).add_attribute("attr1", attr1);
+        const string res = out.str();
+
+        auto buffer = std::make_shared<std::vector<uint64_t>>(res.size() / sizeof(uint64_t) + 1);
+        auto data = (char *) buffer->data();
+        auto reset = [&]() { std::memcpy(data, res.data(), res.size()); };
+        // table of contents: entries of 8 fields (kind, dtype, codec, offset, stored size...) followed by the name
+        uint64_t toc;
+        std::memcpy(&toc, res.data() + 48, sizeof(toc));
+        auto set_field = [&](uint64_t entry_position, index_t field, uint64_t value) {
+            std::memcpy(data + entry_position + field * sizeof(uint64_t), &value, sizeof(value));
+        };
+        const uint64_t attr1_entry = toc + 8 * sizeof(uint64_t);
+
+        REQUIRE_THROWS(tree_file_reader(data, 0, nullptr));
+        REQUIRE_THROWS(tree_file_reader(nullptr, 0, nullptr));
+        reset();
+        REQUIRE_THROWS(tree_file_reader(data, 32, nullptr));
+
+        // unknown data type, or data type of size 0
+        set_field(attr1_entry, 1, 'i' | (3 << 8));
+        REQUIRE_THROWS(tree_file_reader(data, res.size(), nullptr));
+        set_field(attr1_entry, 1, 'i');
+        REQUIRE_THROWS(tree_file_reader(data, res.size(), nullptr));
+
+        // stored sizes not matching the number of elements
+        reset();
+        set_field(attr1_entry, 4, 4);
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.attribute_data("attr1"));
+            REQUIRE_THROWS(reader.read_attribute("attr1"));
+        }
+        reset();
+        set_field(toc, 4, 8);
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.read_tree());
+        }
+
+        // offsets such that offset + size wraps around
+        reset();
+        set_field(attr1_entry, 3, (uint64_t) 0 - 64);
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.attribute_data("attr1"));
+            REQUIRE_THROWS(reader.read_attribute<double>("attr1"));
+        }
+        reset();
+        set_field(toc, 3, (uint64_t) 0 - 64);
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.read_tree());
+        }
+
+        // number of elements such that the array size in bytes wraps around to the stored size
+        reset();
+        const uint64_t wrapping_num_vertices = ((uint64_t) 1 << 62) + 15;
+        std::memcpy(data + 16, &wrapping_num_vertices, sizeof(wrapping_num_vertices));
+        set_field(toc, 5, wrapping_num_vertices);
+        set_field(attr1_entry, 5, wrapping_num_vertices);
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.attribute_data("attr1"));
+        }
+
+        // name lengths larger than the file
+        for (uint64_t name_size: {(uint64_t) 1 << 40, (uint64_t) 0 - 1, (uint64_t) 1 << 10}) {
+            reset();
+            set_field(attr1_entry, 7, name_size);
+            REQUIRE_THROWS(tree_file_reader(data, res.size(), nullptr));
+            istringstream in(string(data, res.size()));
+            REQUIRE_THROWS(tree_file_reader(in));
+        }
+
+        // wrong number of leaves, detected when the tree is validated
+        reset();
+        uint64_t wrong_num_leaves = 7;
+        std::memcpy(data + 24, &wrong_num_leaves, sizeof(wrong_num_leaves));
+        {
+            tree_file_reader reader(data, res.size(), nullptr);
+            REQUIRE_THROWS(reader.read_tree());
+        }
+
+        // empty mapped file
+        const char *filename = "test_tree_io_empty.tree";
+        {
+            ofstream empty(filename, ios::binary);
+        }
+        REQUIRE_THROWS(map_tree_file(filename));
+        std::remove(filename);
+    }
+
+    TEST_CASE("tree file v2 compression", "[tree_io]") {
+        // complete binary tree
+        const index_t num_leaves = 1 << 17;
+        array_1d<index_t> parents_array = num_leaves + xt::arange<index_t>(2 * num_leaves - 1) / 2;
+        parents_array(2 * num_leaves - 2) = 2 * num_leaves - 2;
+        tree t(parents_array);
+        array_1d<double> attr1 = xt::cast<double>(parents(t)) / 3;
+
+        for (auto codec: {tree_io_codec::lz4, tree_io_codec::zstd}) {
+            bool available = true;
+            try {
+                tree_io_internal::check_codec(codec);
+            } catch (std::runtime_error &) {
+                available = false;
+            }
+            ostringstream out;
+            if (!available) {
+                REQUIRE_THROWS_AS(save_tree(out, t, codec), std::runtime_error);
+                continue;
+            }
+            save_tree(out, t, codec).add_attribute("attr1", attr1).add_attribute("attr2", attr1, tree_io_codec::none);
+            string res = out.str();
+
+            istringstream in(res);
+            tree_file_reader reader(in);
+            REQUIRE(reader.attribute_codec("attr1") == codec);
+            REQUIRE(reader.attribute_codec("attr2") == tree_io_codec::none);
+            REQUIRE((reader.read_attribute("attr1") == attr1));
+            REQUIRE((reader.read_attribute("attr2") == attr1));
+            REQUIRE((parents(reader.read_tree()) == parents(t)));
+        }
+    }
+
+    TEMPLATE_TEST_CASE("read and save lca", "[tree_io]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 12, 13, 13, 14, 14});
+        TestType lca(t);
+        array_1d<index_t> v1{0, 0, 1, 3, 2, 7, 4, 14};
+        array_1d<index_t> v2{0, 3, 0, 4, 6, 1, 5, 9};
+        auto ref = lca.lca(v1, v2);
+
+        ostringstream out;
+        save_lca(out, lca);
+        string res = out.str();
+
+        istringstream in(res);
+        auto lca2 = read_lca<TestType>(in);
+        REQUIRE(lca2.num_elements() == (index_t) num_vertices(t));
+        REQUIRE((lca2.lca(v1, v2) == ref));
+
+        // aligned copy of the file content, released with the last lca using it
+        auto buffer = std::make_shared<std::vector<uint64_t>>(res.size() / sizeof(uint64_t) + 1);
+        std::memcpy(buffer->data(), res.data(), res.size());
+        auto data = (const char *) buffer->data();
+        REQUIRE(lca_file_algorithm(data, res.size()) ==
+                lca_io_internal::algorithm_id<typename TestType::rmq_type>::value);
+        auto lca3 = read_lca<TestType>(data, res.size(), std::move(buffer));
+        REQUIRE(lca3.num_elements() == (index_t) num_vertices(t));
+        REQUIRE((lca3.lca(v1, v2) == ref));
+    }
+
+    TEST_CASE("read and save succinct tree", "[tree_io]") {
+        tree t(array_1d<index_t>{8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 12, 13, 13, 14, 14});
+        succinct_tree st(t);
+        array_1d<index_t> v1{0, 0, 1, 3, 2, 7, 4, 14};
+        array_1d<index_t> v2{0, 3, 0, 4, 6, 1, 5, 9};
+        auto ref = st.lowest_common_ancestor(v1, v2);
+        array_1d<index_t> ref_parents = parents(st.to_tree().tree);
+
+        ostringstream out;
+        save_succinct_tree(out, st);
+        string res = out.str();
+
+        istringstream in(res);
+        auto st2 = read_succinct_tree(in);
+        REQUIRE(st2.num_vertices() == st.num_vertices());
+        REQUIRE(st2.num_leaves() == st.num_leaves());
+        REQUIRE((st2.lowest_common_ancestor(v1, v2) == ref));
+        REQUIRE((parents(st2.to_tree().tree) == ref_parents));
+
+        // aligned copy of the file content, released with the last succinct tree using it
+        auto buffer = std::make_shared<std::vector<uint64_t>>(res.size() / sizeof(uint64_t) + 1);
+        std::memcpy(buffer->data(), res.data(), res.size());
+        auto data = (const char *) buffer->data();
+        auto st3 = read_succinct_tree(data, res.size(), std::move(buffer));
+        REQUIRE(st3.bits().data() != st.bits().data());
+        REQUIRE((const char *) st3.bits().data() > data);
+        REQUIRE(st3.num_vertices() == st.num_vertices());
+        REQUIRE((st3.lowest_common_ancestor(v1, v2) == ref));
+        REQUIRE((parents(st3.to_tree().tree) == ref_parents));
+        for (index_t i = 0; i < st.num_vertices(); i++) {
+            REQUIRE(st3.parent(i) == st.parent(i));
+            REQUIRE(st3.subtree_size(i) == st.subtree_size(i));
+        }
+    }
+}
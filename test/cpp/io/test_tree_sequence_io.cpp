@@ -0,0 +1,227 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "../test_utils.hpp"
+#include "higra/io/tree_sequence_io.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace tree_sequence_io {
+
+    using namespace hg;
+    using namespace std;
+
+    // hierarchies of the frames of a synthetic video: a few leaves are swapped and a few altitudes change between
+    // consecutive frames, the nodes keep their indices
+    static vector<pair<tree, array_1d<double>>> make_stable_frames(index_t num_frames, size_t size) {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> value(0, 255);
+        auto graph = get_4_adjacency_graph({(index_t) size, (index_t) size});
+        array_1d<double> image = array_1d<double>::from_shape({size * size});
+        for (auto &v: image) {
+            v = value(generator);
+        }
+        auto bpt = bpt_canonical(graph, weight_graph(graph, image, weight_functions::L1));
+        array_1d<index_t> parents = hg::parents(bpt.tree);
+        array_1d<double> altitudes = bpt.altitudes;
+        const index_t num_l = num_leaves(bpt.tree);
+        std::uniform_int_distribution<index_t> leaf(0, num_l - 1);
+        std::uniform_int_distribution<index_t> node(num_l, parents.size() - 1);
+        vector<pair<tree, array_1d<double>>> frames;
+        for (index_t f = 0; f < num_frames; f++) {
+            for (int i = 0; i < 3; i++) {
+                std::swap(parents(leaf(generator)), parents(leaf(generator)));
+                altitudes(node(generator)) += value(generator) / 16;
+            }
+            frames.emplace_back(tree(parents), altitudes);
+        }
+        return frames;
+    }
+
+    // canonical binary partition trees of the frames of a synthetic video: the nodes are renumbered between frames
+    static vector<pair<tree, array_1d<double>>> make_bpt_frames(index_t num_frames, size_t size) {
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<int> value(0, 255);
+        std::uniform_int_distribution<size_t> pixel(0, size * size - 1);
+        auto graph = get_4_adjacency_graph({(index_t) size, (index_t) size});
+        array_1d<double> image = array_1d<double>::from_shape({size * size});
+        for (auto &v: image) {
+            v = value(generator);
+        }
+        vector<pair<tree, array_1d<double>>> frames;
+        for (index_t f = 0; f < num_frames; f++) {
+            for (int i = 0; i < 3; i++) {
+                image(pixel(generator)) = value(generator);
+            }
+            auto bpt = bpt_canonical(graph, weight_graph(graph, image, weight_functions::L1));
+            frames.emplace_back(std::move(bpt.tree), std::move(bpt.altitudes));
+        }
+        return frames;
+    }
+
+    static bool same_frame(const pair<tree, array_1d<double>> &a, const pair<tree, array_1d<double>> &b) {
+        return num_leaves(a.first) == num_leaves(b.first) &&
+               parents(a.first) == parents(b.first) &&
+               a.second == b.second;
+    }
+
+    TEST_CASE("tree sequence round trip and random access", "[tree_sequence_io]") {
+        auto frames = make_stable_frames(10, 16);
+        ostringstream out;
+        // the file does not need to start at the beginning of the stream
+        out << "prefix";
+        {
+            auto writer = save_tree_sequence(out, 4);
+            for (const auto &f: frames) {
+                writer.add_frame(f.first, f.second);
+            }
+        }
+        string res = out.str();
+
+        istringstream in(res);
+        in.seekg(6);
+        tree_sequence_reader reader(in);
+        REQUIRE(reader.num_frames() == frames.size());
+        REQUIRE(reader.keyframe_interval() == 4);
+        for (index_t i = 0; i < (index_t) frames.size(); i++) {
+            REQUIRE(reader.is_keyframe(i) == (i % 4 == 0));
+        }
+        // deltas are much smaller than keyframes
+        REQUIRE(reader.frame_size(1) * 10 < reader.frame_size(0));
+
+        // sequential, backward and random access
+        for (index_t i = 0; i < (index_t) frames.size(); i++) {
+            REQUIRE(same_frame(reader.read_frame(i), frames[i]));
+        }
+        for (index_t i = frames.size() - 1; i >= 0; i--) {
+            REQUIRE(same_frame(reader.read_frame(i), frames[i]));
+        }
+        for (index_t i: {7, 2, 9, 5, 6, 0, 3}) {
+            REQUIRE(same_frame(reader.read_frame(i), frames[i]));
+        }
+
+        tree_sequence_reader buffer_reader(res.data() + 6, res.size() - 6, nullptr);
+        for (index_t i: {3, 8, 1, 9}) {
+            REQUIRE(same_frame(buffer_reader.read_frame(i), frames[i]));
+        }
+        REQUIRE_THROWS(buffer_reader.read_frame(10));
+    }
+
+    TEST_CASE("tree sequence renumbered nodes", "[tree_sequence_io]") {
+        auto frames = make_bpt_frames(6, 16);
+        ostringstream out;
+        {
+            auto writer = save_tree_sequence(out, 4);
+            for (const auto &f: frames) {
+                writer.add_frame(f.first, f.second);
+            }
+        }
+        string res = out.str();
+        tree_sequence_reader reader(res.data(), res.size(), nullptr);
+        for (index_t i: {5, 1, 4, 0, 2, 3}) {
+            REQUIRE(same_frame(reader.read_frame(i), frames[i]));
+            // a delta is never larger than a keyframe
+            REQUIRE(reader.frame_size(i) <= reader.frame_size(0) * 11 / 10);
+        }
+    }
+
+    TEST_CASE("tree sequence keyframe on size change", "[tree_sequence_io]") {
+        tree t1(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        tree t2(array_1d<index_t>{5, 5, 6, 6, 7, 6, 7, 7});
+        tree t3(array_1d<index_t>{3, 3, 4, 4, 4});
+        double inf = std::numeric_limits<double>::infinity();
+        array_1d<double> a1{0, 0, 0, 0, 0, 1, 2, 3};
+        array_1d<double> a2{0, -0.0, 0, 0, 1e-300, 1.5, inf, -inf};
+        array_1d<float> a3{0, 0, 0, 0.25, 7};
+
+        ostringstream out;
+        save_tree_sequence(out, 16)
+                .add_frame(t1, a1)
+                .add_frame(t2, a2)
+                .add_frame(t3, a3)
+                .add_frame(t1, a1)
+                .finalize();
+        string res = out.str();
+
+        tree_sequence_reader reader(res.data(), res.size(), nullptr);
+        REQUIRE(reader.num_frames() == 4);
+        REQUIRE(reader.is_keyframe(0));
+        REQUIRE(!reader.is_keyframe(1));
+        REQUIRE(reader.is_keyframe(2));
+        REQUIRE(reader.is_keyframe(3));
+
+        auto f1 = reader.read_frame(1);
+        REQUIRE((parents(f1.first) == parents(t2)));
+        REQUIRE((f1.second == a2));
+        auto f2 = reader.read_frame(2);
+        REQUIRE((parents(f2.first) == parents(t3)));
+        REQUIRE((f2.second == xt::cast<double>(a3)));
+        auto f0 = reader.read_frame(0);
+        REQUIRE((parents(f0.first) == parents(t1)));
+        REQUIRE((f0.second == a1));
+    }
+
+    TEST_CASE("tree sequence empty and invalid", "[tree_sequence_io]") {
+        ostringstream out;
+        save_tree_sequence(out).finalize();
+        string res = out.str();
+        tree_sequence_reader reader(res.data(), res.size(), nullptr);
+        REQUIRE(reader.num_frames() == 0);
+        REQUIRE_THROWS(reader.read_frame(0));
+
+        string invalid(64, 'a');
+        REQUIRE_THROWS(tree_sequence_reader(invalid.data(), invalid.size(), nullptr));
+        REQUIRE_THROWS(tree_sequence_reader(res.data(), 32, nullptr));
+        REQUIRE_THROWS(tree_sequence_reader(nullptr, 0, nullptr));
+    }
+
+    TEST_CASE("tree sequence corrupted buffer", "[tree_sequence_io]") {
+        auto frames = make_stable_frames(3, 4);
+        ostringstream out;
+        {
+            auto writer = save_tree_sequence(out);
+            for (const auto &f: frames) {
+                writer.add_frame(f.first, f.second);
+            }
+        }
+        const string res = out.str();
+        string data;
+        // header: number of frames at 16 and position of the frame index at 32, frame index made of 3 fields
+        // (offset, size, keyframe) per frame
+        uint64_t index;
+        std::memcpy(&index, res.data() + 32, sizeof(index));
+        auto set_value = [&](uint64_t position, uint64_t value) {
+            data = res;
+            std::memcpy(&data[position], &value, sizeof(value));
+        };
+
+        // numbers of frames larger than the file
+        for (uint64_t num_frames: {(uint64_t) 1 << 40, (uint64_t) 0 - 1, ((uint64_t) 1 << 63) / 3 + 1}) {
+            set_value(16, num_frames);
+            REQUIRE_THROWS(tree_sequence_reader(data.data(), data.size(), nullptr));
+            istringstream in(data);
+            REQUIRE_THROWS(tree_sequence_reader(in));
+        }
+
+        // frame offsets such that offset + size wraps around
+        for (uint64_t offset: {(uint64_t) 0 - 8, (uint64_t) 1 << 40}) {
+            set_value(index, offset);
+            tree_sequence_reader reader(data.data(), data.size(), nullptr);
+            REQUIRE_THROWS(reader.read_frame(0));
+            istringstream in(data);
+            tree_sequence_reader stream_reader(in);
+            REQUIRE_THROWS(stream_reader.read_frame(0));
+        }
+    }
+}
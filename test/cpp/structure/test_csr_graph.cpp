@@ -0,0 +1,147 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/accumulator/graph_accumulator.hpp"
+#include "../test_utils.hpp"
+#include "xtensor/xrandom.hpp"
+
+namespace test_csr_graph {
+
+    using namespace std;
+    using namespace hg;
+
+    // 0 - 1
+    // | /
+    // 2   3
+    csr_graph data() {
+        array_1d<index_t> sources{0, 2, 0};
+        array_1d<index_t> targets{1, 1, 2};
+        return csr_graph(4, sources, targets);
+    }
+
+    TEST_CASE("csr graph size and iterators", "[csr_graph]") {
+        auto g = data();
+
+        REQUIRE(num_vertices(g) == 4);
+        REQUIRE(num_edges(g) == 3);
+        REQUIRE(out_degree(0, g) == 2);
+        REQUIRE(in_degree(1, g) == 2);
+        REQUIRE(degree(3, g) == 0);
+
+        vector<pair<index_t, index_t>> eref{{0, 1},
+                                            {1, 2},
+                                            {0, 2}};
+        vector<pair<index_t, index_t>> etest;
+        for (auto e: edge_iterator(g)) {
+            etest.push_back(e);
+            REQUIRE(edge_from_index(e.index, g).index == e.index);
+        }
+        REQUIRE(vectorEqual(eref, etest));
+        REQUIRE((sources(g) == array_1d<index_t>{0, 1, 0}));
+        REQUIRE((targets(g) == array_1d<index_t>{1, 2, 2}));
+
+        vector<vector<pair<index_t, index_t>>> out_ref{{{0, 1}, {0, 2}},
+                                                       {{1, 0}, {1, 2}},
+                                                       {{2, 1}, {2, 0}},
+                                                       {}};
+        vector<vector<index_t>> out_index_ref{{0, 2},
+                                              {0, 1},
+                                              {1, 2},
+                                              {}};
+        vector<vector<index_t>> adj_ref{{1, 2},
+                                        {0, 2},
+                                        {1, 0},
+                                        {}};
+        for (auto v: vertex_iterator(g)) {
+            vector<pair<index_t, index_t>> out_test;
+            vector<pair<index_t, index_t>> in_test;
+            vector<index_t> out_index_test;
+            vector<index_t> adj_test;
+            for (auto e: out_edge_iterator(v, g)) {
+                out_test.push_back({source(e, g), target(e, g)});
+                out_index_test.push_back(index(e, g));
+            }
+            for (auto e: in_edge_iterator(v, g)) {
+                in_test.push_back({target(e, g), source(e, g)});
+            }
+            for (auto n: adjacent_vertex_iterator(v, g)) {
+                adj_test.push_back(n);
+            }
+            REQUIRE(vectorEqual(out_ref[v], out_test));
+            REQUIRE(vectorEqual(out_ref[v], in_test));
+            REQUIRE(vectorEqual(out_index_ref[v], out_index_test));
+            REQUIRE(vectorEqual(adj_ref[v], adj_test));
+        }
+    }
+
+    TEST_CASE("csr graph freeze and copy", "[csr_graph]") {
+        auto g0 = get_8_adjacency_graph({5, 7});
+        add_edge(3, 3, g0);
+        add_edge(10, 2, g0);
+        auto g = freeze(g0);
+
+        REQUIRE(num_vertices(g) == num_vertices(g0));
+        REQUIRE(num_edges(g) == num_edges(g0));
+        REQUIRE((sources(g) == sources(g0)));
+        REQUIRE((targets(g) == targets(g0)));
+        for (auto v: vertex_iterator(g)) {
+            REQUIRE(degree(v, g) == degree(v, g0));
+            vector<index_t> ref;
+            vector<index_t> test;
+            for (auto e: out_edge_iterator(v, g0)) {
+                ref.push_back(e.index);
+                ref.push_back(target(e, g0));
+            }
+            for (auto e: out_edge_iterator(v, g)) {
+                test.push_back(e.index);
+                test.push_back(target(e, g));
+            }
+            REQUIRE(vectorEqual(ref, test));
+        }
+
+        auto g2 = copy_graph<ugraph>(g);
+        REQUIRE((sources(g2) == sources(g0)));
+        REQUIRE((targets(g2) == targets(g0)));
+
+        auto g3 = copy_graph<csr_graph>(g);
+        REQUIRE((sources(g3) == sources(g0)));
+
+        tree t(array_1d<index_t>{4, 4, 5, 5, 6, 6, 6});
+        auto gt = freeze(t);
+        REQUIRE(num_edges(gt) == 6);
+        REQUIRE((sources(gt) == sources(t)));
+        REQUIRE((targets(gt) == targets(t)));
+    }
+
+    TEST_CASE("csr graph algorithms", "[csr_graph]") {
+        auto g0 = get_4_adjacency_graph({20, 25});
+        auto g = freeze(g0);
+        xt::random::seed(42);
+        array_1d<int> edge_weights = xt::random::randint<int>({num_edges(g0)}, 0, 10);
+
+        auto ref = bpt_canonical(g0, edge_weights);
+        auto res = bpt_canonical(g, edge_weights);
+        REQUIRE((ref.tree.parents() == res.tree.parents()));
+        REQUIRE((ref.altitudes == res.altitudes));
+        REQUIRE((ref.mst_edge_map == res.mst_edge_map));
+
+        auto acc_ref = accumulate_graph_edges(g0, edge_weights, accumulator_sum());
+        auto acc = accumulate_graph_edges(g, edge_weights, accumulator_sum());
+        REQUIRE((acc_ref == acc));
+
+        array_1d<int> vertex_weights = xt::random::randint<int>({num_vertices(g0)}, 0, 10);
+        auto accv_ref = accumulate_graph_vertices(g0, vertex_weights, accumulator_max());
+        auto accv = accumulate_graph_vertices(g, vertex_weights, accumulator_max());
+        REQUIRE((accv_ref == accv));
+    }
+}
@@ -10,6 +10,7 @@
 
 #include "../test_utils.hpp"
 #include "higra/structure/embedding.hpp"
+#include "higra/structure/embedding_morton.hpp"
 #include "xtensor/xview.hpp"
 #include "xtensor/xgenerator.hpp"
 #include "xtensor/xinfo.hpp"
@@ -133,6 +134,36 @@ namespace embedding {
         REQUIRE((res == coords));
     }
 
+    TEST_CASE("linear coordinates to grid odd shapes", "[embedding]") {
+        hg::embedding_grid_3d e1{7, 13, 3};
+        xt::xtensor<hg::index_t, 2> indices = xt::reshape_view(xt::arange<hg::index_t>(0, (hg::index_t) e1.size()),
+                                                               {21, 13});
+        auto res = e1.lin2grid(indices);
+        REQUIRE((res.shape() == std::vector<std::size_t>{21, 13, 3}));
+        for (hg::index_t i = 0; i < (hg::index_t) e1.size(); i++) {
+            hg::point_3d_i ref{{i / 39, (i % 39) / 3, i % 3}};
+            auto p = e1.lin2grid(i);
+            REQUIRE((p == ref));
+            REQUIRE((xt::view(res, i / 13, i % 13) == ref));
+            REQUIRE(e1.grid2lin(p) == i);
+        }
+    }
+
+    TEST_CASE("fast divider", "[embedding]") {
+        std::vector<uint64_t> divisors{1, 2, 3, 5, 7, 10, 64, 641, 1000003, (1ull << 32) - 1, (1ull << 32) + 1,
+                                       (1ull << 63) - 25, 1ull << 63, (1ull << 63) + 1, ~0ull};
+        std::vector<uint64_t> numerators{0, 1, 2, 3, 1000, 123456789, (1ull << 32), (1ull << 63) - 1, 1ull << 63,
+                                         ~0ull - 1, ~0ull};
+        for (auto d: divisors) {
+            hg::fast_divider divider(d);
+            for (auto n: numerators) {
+                REQUIRE(divider.divide(n) == n / d);
+                REQUIRE(divider.divide(n + d - 1) == (n + d - 1) / d);
+                REQUIRE(divider.divide(n * d) == (n * d) / d);
+            }
+        }
+    }
+
     TEST_CASE("contains", "[embedding]") {
         xt::xarray<hg::index_t> shape = {5, 10};
         hg::embedding_grid_2d e1(shape);
@@ -146,4 +177,82 @@ namespace embedding {
         auto res = e1.contains(coords);
         REQUIRE((res == ref));
     }
+
+    TEST_CASE("embedding morton 2d", "[embedding]") {
+        hg::embedding_morton_2d e1({6, 5}, 4);
+        REQUIRE(e1.size() == 30);
+        REQUIRE(e1.dimension() == 2);
+        REQUIRE(e1.tile_size() == 4);
+
+        // full tile in Morton order, then partial tiles in row major order
+        hg::array_2d<hg::index_t> ref{{0,  1,  4,  5,  16},
+                                      {2,  3,  6,  7,  17},
+                                      {8,  9,  12, 13, 18},
+                                      {10, 11, 14, 15, 19},
+                                      {20, 21, 22, 23, 28},
+                                      {24, 25, 26, 27, 29}};
+        for (hg::index_t i = 0; i < 6; i++) {
+            for (hg::index_t j = 0; j < 5; j++) {
+                REQUIRE(e1.grid2lin(i, j) == ref(i, j));
+                REQUIRE(e1.grid2lin({i, j}) == ref(i, j));
+                auto p = e1.lin2grid(ref(i, j));
+                REQUIRE(p(0) == i);
+                REQUIRE(p(1) == j);
+            }
+        }
+
+        REQUIRE(e1.contains({5, 4}));
+        REQUIRE(!e1.contains({6, 0}));
+    }
+
+    TEST_CASE("embedding morton 2d bijection", "[embedding]") {
+        for (auto shape: std::vector<std::array<hg::index_t, 2>>{{1, 1}, {64, 64}, {70, 33}, {33, 70}, {200, 131}}) {
+            for (hg::index_t tile_size: {1, 2, 16, 64}) {
+                hg::embedding_morton_2d e(shape, tile_size);
+                std::vector<bool> seen(e.size(), false);
+                for (hg::index_t i = 0; i < shape[0]; i++) {
+                    for (hg::index_t j = 0; j < shape[1]; j++) {
+                        auto v = e.grid2lin(i, j);
+                        REQUIRE((v >= 0 && v < (hg::index_t) e.size()));
+                        REQUIRE(!seen[v]);
+                        seen[v] = true;
+                        auto p = e.lin2grid(v);
+                        REQUIRE((p(0) == i && p(1) == j));
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_CASE("embedding morton 2d vectorial", "[embedding]") {
+        hg::embedding_morton_2d e1({6, 5}, 4);
+        hg::array_1d<hg::index_t> indices{0, 3, 16, 29};
+        hg::array_2d<hg::index_t> coords{{0, 0},
+                                         {1, 1},
+                                         {0, 4},
+                                         {5, 4}};
+        REQUIRE((e1.lin2grid(indices) == coords));
+        REQUIRE((e1.grid2lin(coords) == indices));
+    }
+
+    TEST_CASE("embedding morton 2d image conversion", "[embedding]") {
+        hg::embedding_morton_2d e1({6, 5}, 4);
+        hg::array_2d<int> image = xt::reshape_view(xt::arange<int>(30), {6, 5});
+        auto values = hg::to_morton_order(e1, image);
+        REQUIRE(values.dimension() == 1);
+        for (hg::index_t i = 0; i < 6; i++) {
+            for (hg::index_t j = 0; j < 5; j++) {
+                REQUIRE(values(e1.grid2lin(i, j)) == image(i, j));
+            }
+        }
+        REQUIRE((hg::to_row_major_order(e1, values) == image));
+
+        hg::array_3d<double> color = xt::reshape_view(xt::arange<double>(90), {6, 5, 3});
+        auto color_values = hg::to_morton_order(e1, color);
+        REQUIRE(color_values.dimension() == 2);
+        REQUIRE(color_values.shape()[0] == 30);
+        REQUIRE(color_values.shape()[1] == 3);
+        REQUIRE((xt::view(color_values, e1.grid2lin(5, 2)) == xt::view(color, 5, 2)));
+        REQUIRE((hg::to_row_major_order(e1, color_values) == color));
+    }
 }
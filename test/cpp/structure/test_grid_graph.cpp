@@ -0,0 +1,100 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/algo/graph_weights.hpp"
+#include "higra/algo/watershed.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace grid_graph {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("grid 4 adjacency graph is equivalent to the explicit 4 adjacency graph", "[grid_graph]") {
+        for (auto shape: std::vector<std::vector<index_t>>{{1, 1}, {1, 5}, {5, 1}, {2, 2}, {3, 4}, {7, 5}}) {
+            embedding_grid_2d embedding(shape);
+            auto g = get_4_adjacency_grid_graph(embedding);
+            auto ref = get_4_adjacency_graph(embedding);
+
+            REQUIRE(num_vertices(g) == num_vertices(ref));
+            REQUIRE(num_edges(g) == num_edges(ref));
+            REQUIRE((sources(g) == sources(ref)));
+            REQUIRE((targets(g) == targets(ref)));
+
+            index_t i = 0;
+            for (auto e: edge_iterator(g)) {
+                auto er = edge_from_index(i, ref);
+                REQUIRE(index(e, g) == i);
+                REQUIRE(source(e, g) == source(er, ref));
+                REQUIRE(target(e, g) == target(er, ref));
+                i++;
+            }
+            REQUIRE(i == (index_t) num_edges(ref));
+
+            for (auto v: vertex_iterator(g)) {
+                REQUIRE(degree(v, g) == degree(v, ref));
+                std::vector<index_t> out, out_ref, in, in_ref, adj, adj_ref;
+                for (auto e: out_edge_iterator(v, g)) {
+                    REQUIRE(source(e, g) == v);
+                    out.push_back(target(e, g));
+                    out.push_back(index(e, g));
+                }
+                for (auto e: out_edge_iterator(v, ref)) {
+                    out_ref.push_back(target(e, ref));
+                    out_ref.push_back(index(e, ref));
+                }
+                for (auto e: in_edge_iterator(v, g)) {
+                    REQUIRE(target(e, g) == v);
+                    in.push_back(source(e, g));
+                    in.push_back(index(e, g));
+                }
+                for (auto e: in_edge_iterator(v, ref)) {
+                    in_ref.push_back(source(e, ref));
+                    in_ref.push_back(index(e, ref));
+                }
+                for (auto a: adjacent_vertex_iterator(v, g)) {
+                    adj.push_back(a);
+                }
+                for (auto a: adjacent_vertex_iterator(v, ref)) {
+                    adj_ref.push_back(a);
+                }
+                REQUIRE(out == out_ref);
+                REQUIRE(in == in_ref);
+                REQUIRE(adj == adj_ref);
+            }
+        }
+    }
+
+    TEST_CASE("grid 4 adjacency graph algorithms", "[grid_graph]") {
+        xt::random::seed(42);
+        embedding_grid_2d embedding{13, 17};
+        auto g = get_4_adjacency_grid_graph(embedding);
+        auto ref = get_4_adjacency_graph(embedding);
+
+        array_1d<double> vertex_weights = xt::random::randint<int>({num_vertices(g)}, 0, 10);
+        auto edge_weights = weight_graph(g, vertex_weights, weight_functions::L1);
+        REQUIRE((edge_weights == weight_graph(ref, vertex_weights, weight_functions::L1)));
+
+        REQUIRE((labelisation_watershed(g, edge_weights) == labelisation_watershed(ref, edge_weights)));
+
+        auto res = bpt_canonical(g, edge_weights);
+        auto res_ref = bpt_canonical(ref, edge_weights);
+        REQUIRE((parents(res.tree) == parents(res_ref.tree)));
+        REQUIRE((res.altitudes == res_ref.altitudes));
+        REQUIRE((res.mst_edge_map == res_ref.mst_edge_map));
+
+        auto mst = freeze(g);
+        REQUIRE(num_edges(mst) == num_edges(ref));
+    }
+}
@@ -0,0 +1,141 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/hierarchical_queue.hpp"
+#include "../test_utils.hpp"
+#include <deque>
+#include <random>
+
+namespace test_hierarchical_queue {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("hierarchical queue push-top-pop", "[hierarchical_queue]") {
+        hierarchical_queue<index_t> q(200);
+        REQUIRE(q.empty());
+        REQUIRE(q.num_levels() == 200);
+        REQUIRE(q.first_non_empty_level() == invalid_index);
+        REQUIRE(q.last_non_empty_level() == invalid_index);
+        REQUIRE(q.find_closest_non_empty_level(100) == invalid_index);
+
+        q.push(130, 1);
+        q.push(3, 2);
+        q.push(130, 3);
+        q.push(64, 4);
+        REQUIRE(q.size() == 4);
+        REQUIRE(!q.level_empty(130));
+        REQUIRE(q.level_empty(131));
+        REQUIRE(q.first_non_empty_level() == 3);
+        REQUIRE(q.last_non_empty_level() == 130);
+
+        // FIFO order inside a level
+        REQUIRE(q.top(130) == 1);
+        q.pop(130);
+        REQUIRE(q.top(130) == 3);
+        q.pop(130);
+        REQUIRE(q.level_empty(130));
+        REQUIRE(q.last_non_empty_level() == 64);
+
+        // freed nodes are reused
+        q.push(199, 5);
+        q.push(199, 6);
+        REQUIRE(q.last_non_empty_level() == 199);
+        REQUIRE(q.top(199) == 5);
+        REQUIRE(q.size() == 4);
+
+        q.clear();
+        REQUIRE(q.empty());
+        for (index_t l = 0; l < 200; l++) {
+            REQUIRE(q.level_empty(l));
+        }
+        REQUIRE(q.first_non_empty_level() == invalid_index);
+        q.push(0, 7);
+        REQUIRE(q.first_non_empty_level() == 0);
+        REQUIRE(q.top(0) == 7);
+    }
+
+    TEST_CASE("hierarchical queue closest non empty level", "[hierarchical_queue]") {
+        hierarchical_queue<int> q(10000);
+        q.push(5, 0);
+        q.push(63, 0);
+        q.push(4100, 0);
+        q.push(9999, 0);
+
+        REQUIRE(q.next_non_empty_level(0) == 5);
+        REQUIRE(q.next_non_empty_level(6) == 63);
+        REQUIRE(q.next_non_empty_level(64) == 4100);
+        REQUIRE(q.next_non_empty_level(4101) == 9999);
+        REQUIRE(q.previous_non_empty_level(9998) == 4100);
+        REQUIRE(q.previous_non_empty_level(4099) == 63);
+        REQUIRE(q.previous_non_empty_level(62) == 5);
+        REQUIRE(q.previous_non_empty_level(4) == invalid_index);
+
+        REQUIRE(q.find_closest_non_empty_level(0) == 5);
+        REQUIRE(q.find_closest_non_empty_level(34) == 5); // tie: smallest level
+        REQUIRE(q.find_closest_non_empty_level(35) == 63);
+        REQUIRE(q.find_closest_non_empty_level(2081) == 63);
+        REQUIRE(q.find_closest_non_empty_level(2082) == 4100);
+        REQUIRE(q.find_closest_non_empty_level(9999) == 9999);
+    }
+
+    TEST_CASE("hierarchical queue random", "[hierarchical_queue]") {
+        const index_t num_levels = 65536;
+        hierarchical_queue<index_t> q(num_levels);
+        vector<deque<index_t>> ref(num_levels);
+        index_t ref_size = 0;
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<index_t> level_dist(0, num_levels - 1);
+        // cluster the levels to exercise both sparse and dense bitmap words
+        std::uniform_int_distribution<index_t> cluster_dist(0, 300);
+
+        auto ref_closest = [&ref, num_levels](index_t level) {
+            for (index_t d = 0; d < num_levels; d++) {
+                if (level - d >= 0 && !ref[level - d].empty()) {
+                    return level - d;
+                }
+                if (level + d < num_levels && !ref[level + d].empty()) {
+                    return level + d;
+                }
+            }
+            return invalid_index;
+        };
+
+        for (index_t i = 0; i < 3000; i++) {
+            index_t level = (i % 3 == 0) ? level_dist(gen) : (30000 + cluster_dist(gen));
+            if (i % 4 != 3) {
+                q.push(level, i);
+                ref[level].push_back(i);
+                ref_size++;
+            }
+            REQUIRE(q.size() == ref_size);
+            index_t query = level_dist(gen);
+            index_t c = q.find_closest_non_empty_level(query);
+            REQUIRE(c == ref_closest(query));
+            if (i % 2 == 1 && c != invalid_index) {
+                REQUIRE(q.top(c) == ref[c].front());
+                q.pop(c);
+                ref[c].pop_front();
+                ref_size--;
+            }
+        }
+
+        // drain in increasing level order
+        while (!q.empty()) {
+            index_t l = q.first_non_empty_level();
+            REQUIRE(l == ref_closest(0));
+            REQUIRE(q.top(l) == ref[l].front());
+            q.pop(l);
+            ref[l].pop_front();
+        }
+        REQUIRE(q.last_non_empty_level() == invalid_index);
+    }
+}
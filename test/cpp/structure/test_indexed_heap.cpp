@@ -0,0 +1,270 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/indexed_heap.hpp"
+#include "../test_utils.hpp"
+#include <random>
+#include <set>
+
+namespace test_indexed_heap {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("indexed heap push-top-pop", "[indexed_heap]") {
+        indexed_dary_heap<double> heap(6);
+        REQUIRE(heap.empty());
+        REQUIRE(heap.capacity() == 6);
+
+        heap.push(0, 5);
+        heap.push(1, 3);
+        heap.push(2, 7);
+        heap.push(3, 3);
+        heap.push(4, 1);
+        REQUIRE(heap.size() == 5);
+        REQUIRE(heap.contains(2));
+        REQUIRE(!heap.contains(5));
+        REQUIRE(heap.value(0) == 5);
+
+        // ties are broken by increasing key
+        std::vector<index_t> ref_keys{4, 1, 3, 0, 2};
+        std::vector<double> ref_values{1, 3, 3, 5, 7};
+        for (index_t i = 0; i < (index_t) ref_keys.size(); i++) {
+            REQUIRE(heap.top() == ref_keys[i]);
+            REQUIRE(heap.top_value() == ref_values[i]);
+            heap.pop();
+            REQUIRE(!heap.contains(ref_keys[i]));
+        }
+        REQUIRE(heap.empty());
+    }
+
+    TEST_CASE("indexed heap update erase", "[indexed_heap]") {
+        indexed_dary_heap<int, 2> heap(5);
+        for (index_t i = 0; i < 5; i++) {
+            heap.push(i, (int) (10 * i));
+        }
+        heap.update(3, -1);
+        REQUIRE(heap.top() == 3);
+        heap.update(3, 25);
+        REQUIRE(heap.top() == 0);
+        heap.update(0, 30);
+        REQUIRE(heap.top() == 1);
+        heap.erase(1);
+        REQUIRE(!heap.contains(1));
+        REQUIRE(heap.size() == 4);
+
+        std::vector<index_t> ref_keys{2, 3, 0, 4};
+        for (auto k: ref_keys) {
+            REQUIRE(heap.top() == k);
+            heap.pop();
+        }
+        REQUIRE(heap.empty());
+
+        heap.push(1, 2);
+        heap.push(4, 1);
+        heap.clear();
+        REQUIRE(heap.empty());
+        REQUIRE(!heap.contains(1));
+        REQUIRE(!heap.contains(4));
+    }
+
+    template<typename heap_t>
+    void randomized_test(index_t capacity, int num_operations) {
+        std::uniform_int_distribution<int> op_dist(0, 99);
+        std::uniform_int_distribution<index_t> key_dist(0, capacity - 1);
+        std::uniform_int_distribution<int> value_dist(0, 50);
+        std::mt19937 rng(150000);
+
+        heap_t heap(capacity);
+        std::set<std::pair<int, index_t>> ref;
+        std::vector<int> values(capacity);
+
+        for (int i = 0; i < num_operations; i++) {
+            int op = op_dist(rng);
+            auto key = key_dist(rng);
+            if (op < 40) {
+                auto value = value_dist(rng);
+                if (heap.contains(key)) {
+                    heap.update(key, value);
+                    ref.erase(std::make_pair(values[key], key));
+                } else {
+                    heap.push(key, value);
+                }
+                values[key] = value;
+                ref.insert(std::make_pair(value, key));
+            } else if (op < 70) {
+                if (!ref.empty()) {
+                    REQUIRE(heap.top() == ref.begin()->second);
+                    REQUIRE(heap.top_value() == ref.begin()->first);
+                    heap.pop();
+                    ref.erase(ref.begin());
+                }
+            } else {
+                if (heap.contains(key)) {
+                    heap.erase(key);
+                    ref.erase(std::make_pair(values[key], key));
+                }
+            }
+            REQUIRE(heap.size() == ref.size());
+            if (!ref.empty()) {
+                REQUIRE(heap.top() == ref.begin()->second);
+            }
+        }
+    }
+
+    TEST_CASE("indexed heap randomized stress test", "[indexed_heap]") {
+        randomized_test<indexed_dary_heap<int, 2>>(100, 5000);
+        randomized_test<indexed_dary_heap<int, 3>>(100, 5000);
+        randomized_test<indexed_dary_heap<int, 4>>(1000, 20000);
+        randomized_test<indexed_dary_heap<int, 8>>(1000, 20000);
+        randomized_test<indexed_pairing_heap<int>>(100, 5000);
+        randomized_test<indexed_pairing_heap<int>>(1000, 20000);
+    }
+
+    TEST_CASE("indexed pairing heap update erase", "[indexed_heap]") {
+        indexed_pairing_heap<int> heap(5);
+        for (index_t i = 0; i < 5; i++) {
+            heap.push(i, (int) (10 * i));
+        }
+        heap.update(3, -1);
+        REQUIRE(heap.top() == 3);
+        heap.update(3, 25);
+        REQUIRE(heap.top() == 0);
+        heap.update(0, 30);
+        REQUIRE(heap.top() == 1);
+        heap.erase(1);
+        REQUIRE(!heap.contains(1));
+        REQUIRE(heap.size() == 4);
+
+        std::vector<index_t> ref_keys{2, 3, 0, 4};
+        for (auto k: ref_keys) {
+            REQUIRE(heap.top() == k);
+            heap.pop();
+        }
+        REQUIRE(heap.empty());
+    }
+
+    template<typename heap_t>
+    void merge_test() {
+        heap_t heap1(10);
+        heap_t heap2(10);
+        for (index_t i = 0; i < 10; i++) {
+            if (i % 3 == 0) {
+                heap1.push(i, (int) (20 - i));
+            } else {
+                heap2.push(i, (int) (20 - i));
+            }
+        }
+        heap1.merge(heap2);
+        REQUIRE(heap2.empty());
+        REQUIRE(!heap2.contains(1));
+        REQUIRE(heap1.size() == 10);
+        for (index_t i = 9; i >= 0; i--) {
+            REQUIRE(heap1.top() == i);
+            REQUIRE(heap1.top_value() == 20 - i);
+            heap1.pop();
+        }
+        REQUIRE(heap1.empty());
+
+        heap2.push(4, 3);
+        heap1.merge(heap2);
+        REQUIRE(heap1.top() == 4);
+        heap1.clear();
+        REQUIRE(!heap1.contains(4));
+    }
+
+    TEST_CASE("indexed heaps merge", "[indexed_heap]") {
+        merge_test<indexed_dary_heap<int>>();
+        merge_test<indexed_dary_heap<int, 2>>();
+        merge_test<indexed_pairing_heap<int>>();
+        merge_test<indexed_radix_heap<int>>();
+    }
+
+    TEST_CASE("indexed radix heap push-top-pop", "[indexed_heap]") {
+        indexed_radix_heap<unsigned int> heap(6);
+        heap.push(0, 5);
+        heap.push(1, 3);
+        heap.push(2, 700);
+        heap.push(3, 4);
+        heap.push(4, 1);
+        REQUIRE(heap.size() == 5);
+        REQUIRE(heap.top() == 4);
+        heap.pop();
+        REQUIRE(heap.top() == 1);
+        heap.push(5, 3);
+        heap.update(2, 3);
+        heap.erase(3);
+        REQUIRE(heap.top_value() == 3);
+        std::vector<index_t> popped;
+        while (!heap.empty() && heap.top_value() == 3) {
+            popped.push_back(heap.top());
+            heap.pop();
+        }
+        std::sort(popped.begin(), popped.end());
+        REQUIRE((popped == std::vector<index_t>{1, 2, 5}));
+        REQUIRE(heap.top() == 0);
+        heap.pop();
+        REQUIRE(heap.empty());
+
+        // negative values
+        indexed_radix_heap<int> heap2(3);
+        heap2.push(0, -5);
+        heap2.push(1, 7);
+        heap2.push(2, -2);
+        REQUIRE(heap2.top() == 0);
+        heap2.pop();
+        REQUIRE(heap2.top() == 2);
+        heap2.pop();
+        REQUIRE(heap2.top() == 1);
+    }
+
+    TEST_CASE("indexed radix heap randomized monotone test", "[indexed_heap]") {
+        const index_t capacity = 500;
+        std::uniform_int_distribution<int> op_dist(0, 99);
+        std::uniform_int_distribution<index_t> key_dist(0, capacity - 1);
+        std::uniform_int_distribution<int64_t> increment_dist(0, 1000);
+        std::mt19937 rng(42);
+
+        indexed_radix_heap<int64_t> heap(capacity);
+        std::set<std::pair<int64_t, index_t>> ref;
+        std::vector<int64_t> values(capacity);
+        int64_t min_value = 0;
+
+        for (int i = 0; i < 20000; i++) {
+            int op = op_dist(rng);
+            auto key = key_dist(rng);
+            if (op < 40) {
+                int64_t value = min_value + increment_dist(rng);
+                if (heap.contains(key)) {
+                    heap.update(key, value);
+                    ref.erase(std::make_pair(values[key], key));
+                } else {
+                    heap.push(key, value);
+                }
+                values[key] = value;
+                ref.insert(std::make_pair(value, key));
+            } else if (op < 70) {
+                if (!ref.empty()) {
+                    REQUIRE(heap.top_value() == ref.begin()->first);
+                    index_t top = heap.top();
+                    min_value = ref.begin()->first;
+                    heap.pop();
+                    ref.erase(std::make_pair(values[top], top));
+                }
+            } else {
+                if (heap.contains(key)) {
+                    heap.erase(key);
+                    ref.erase(std::make_pair(values[key], key));
+                }
+            }
+            REQUIRE(heap.size() == ref.size());
+        }
+    }
+}
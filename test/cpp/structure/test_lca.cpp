@@ -8,12 +8,12 @@
 * The full license is in the file LICENSE, distributed with this software. *
 ****************************************************************************/
 
-#include "xtensor/xio.hpp"
-#include "xtensor/xrandom.hpp"
 #include "higra/graph.hpp"
 #include "higra/image/graph_image.hpp"
 #include "higra/structure/lca_fast.hpp"
 #include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xio.hpp"
+#include "xtensor/xrandom.hpp"
 #include "../test_utils.hpp"
 
 namespace lca {
@@ -31,7 +31,8 @@ namespace lca {
     } data;
 
 
-    TEMPLATE_TEST_CASE("lca pairs of vertices", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block) {
+    TEMPLATE_TEST_CASE("lca pairs of vertices", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
         auto t = data.t;
         TestType lca(t);
         REQUIRE(lca.lca(0, 0) == 0);
@@ -49,7 +50,8 @@ namespace lca {
         REQUIRE(lca.lca(2, 6) == 6);
     }
 
-    TEMPLATE_TEST_CASE("lca iterators", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block) {
+    TEMPLATE_TEST_CASE("lca iterators", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
         auto g = get_4_adjacency_graph({2, 2});
         tree t(array_1d<index_t>{4, 4, 5, 5, 6, 6, 6});
         TestType lca(t);
@@ -58,7 +60,8 @@ namespace lca {
         REQUIRE((l == ref));
     }
 
-    TEMPLATE_TEST_CASE("lca tensors", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block) {
+    TEMPLATE_TEST_CASE("lca tensors", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
         tree t(array_1d<index_t>{4, 4, 5, 5, 6, 6, 6});
         TestType lca(t);
         array_1d<index_t> v1{0, 0, 1, 3};
@@ -68,7 +71,31 @@ namespace lca {
         REQUIRE((l == ref));
     }
 
-    TEMPLATE_TEST_CASE("lca sanity", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block) {
+    TEMPLATE_TEST_CASE("lca batch modes", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
+        xt::random::seed(42);
+        auto g = hg::get_4_adjacency_graph({30, 25});
+        auto w = xt::eval(xt::random::rand<double>({num_edges(g)}));
+        auto h = hg::bpt_canonical(g, w);
+        auto &tree = h.tree;
+
+        TestType lca(tree);
+        array_1d<index_t> v1 = xt::random::randint<index_t>({2000}, 0, num_vertices(tree));
+        array_1d<index_t> v2 = xt::random::randint<index_t>({2000}, 0, num_vertices(tree));
+        v2(0) = v1(0);
+        auto ref = lca.lca(v1, v2, hg::lca_batch_mode::independent);
+        for (index_t i = 0; i < (index_t) v1.size(); i++) {
+            REQUIRE(ref(i) == lowest_common_ancestor(v1(i), v2(i), tree));
+        }
+        REQUIRE((lca.lca(v1, v2, hg::lca_batch_mode::sorted) == ref));
+
+        auto ref_edges = lca.lca(edge_iterator(g), hg::lca_batch_mode::independent);
+        REQUIRE((lca.lca(edge_iterator(g), hg::lca_batch_mode::sorted) == ref_edges));
+        REQUIRE((lca.lca(edge_iterator(g)) == ref_edges));
+    }
+
+    TEMPLATE_TEST_CASE("lca sanity", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
         xt::random::seed(42);
         auto g = hg::get_4_adjacency_graph({20, 20});
         auto w = xt::eval(xt::random::rand<double>({num_edges(g)}));
@@ -106,7 +133,39 @@ namespace lca {
         }
     }
 
-    TEMPLATE_TEST_CASE("lca serialization", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block) {
+    TEST_CASE("rmq sparse table block all ranges", "[lca]") {
+        xt::random::seed(42);
+        // many equal values
+        array_1d<index_t> data = xt::random::randint<index_t>({300}, 0, 20);
+        for (index_t block_size: {1, 7, 32, 64, 100, 1024}) {
+            range_minimum_query_internal::rmq_sparse_table_block<index_t> rmq(data, block_size);
+            for (index_t l = 0; l < (index_t) data.size(); l++) {
+                for (index_t r = l + 1; r <= (index_t) data.size(); r++) {
+                    auto res = rmq.query(l, r);
+                    REQUIRE(res >= l);
+                    REQUIRE(res < r);
+                    REQUIRE(data(res) == *std::min_element(data.begin() + l, data.begin() + r));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("lca table bytes", "[lca]") {
+        auto g = hg::get_4_adjacency_graph({10, 10});
+        auto w = xt::eval(xt::arange<double>(num_edges(g)));
+        auto h = hg::bpt_canonical(g, w);
+        // the Euler tour has 2 * 199 - 1 = 397 elements
+        hg::lca_sparse_table lca1(h.tree);
+        REQUIRE(lca1.table_bytes() == sizeof(size_t) * (397 + 396 + 394 + 390 + 382 + 366 + 334 + 270 + 142));
+        hg::lca_sparse_table_block lca2(h.tree, 64);
+        // prefix and suffix minima are padded to 7 blocks of 64 elements, plus 13 sub-blocks minima
+        REQUIRE(lca2.table_bytes() == sizeof(index_t) * (2 * 448 + 13) + sizeof(size_t) * (7 + 6 + 4));
+        hg::lca_bitmask_block lca3(h.tree);
+        REQUIRE(lca3.table_bytes() == sizeof(uint64_t) * 397 + sizeof(size_t) * (7 + 6 + 4));
+    }
+
+    TEMPLATE_TEST_CASE("lca serialization", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
         tree t(array_1d<index_t>{4, 4, 5, 5, 6, 6, 6});
         TestType lca(t);
         array_1d<index_t> v1{0, 0, 1, 3};
@@ -123,4 +182,24 @@ namespace lca {
         auto l2 = lca3.lca(v1, v2);
         REQUIRE((l2 == ref));
     }
+
+    TEMPLATE_TEST_CASE("lca shared state", "[lca]", hg::lca_sparse_table, hg::lca_sparse_table_block,
+                       hg::lca_bitmask_block) {
+        tree t(array_1d<index_t>{4, 4, 5, 5, 6, 6, 6});
+        TestType lca(t);
+        array_1d<index_t> v1{0, 0, 1, 3};
+        array_1d<index_t> v2{0, 3, 0, 0};
+
+        auto state = lca.get_shared_state();
+        auto state2 = lca.get_shared_state();
+        // the buffers are shared
+        REQUIRE(state.tree_Euler_tour_map.data() == state2.tree_Euler_tour_map.data());
+        REQUIRE((xt::adapt(state.tree_Euler_tour_map.data(), {state.tree_Euler_tour_map.size()}) ==
+                 lca.get_state().tree_Euler_tour_map));
+
+        TestType lca2 = TestType::make_from_state(std::move(state));
+        array_1d<index_t> ref{0, 6, 4, 6};
+        REQUIRE((lca2.lca(v1, v2) == ref));
+        REQUIRE(lca2.get_shared_state().tree_Euler_tour_map.data() == state2.tree_Euler_tour_map.data());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/leaf_ranges.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "higra/accumulator/tree_accumulator.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace leaf_ranges {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("leaf ranges simple tree", "[leaf_ranges]") {
+        tree t(array_1d<index_t>{9, 9, 10, 11, 11, 10, 12, 12, 13, 14, 14, 16, 13, 15, 15, 16, 16});
+        hg::leaf_ranges lr(t);
+        REQUIRE(lr.num_elements() == 17);
+
+        array_1d<index_t> ref_leaves{3, 4, 8, 6, 7, 0, 1, 2, 5};
+        REQUIRE((lr.leaves() == ref_leaves));
+
+        vector<vector<index_t>> ref{{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8},
+                                    {0, 1}, {2, 5}, {3, 4}, {6, 7}, {8, 6, 7},
+                                    {0, 1, 2, 5}, {8, 6, 7, 0, 1, 2, 5},
+                                    {3, 4, 8, 6, 7, 0, 1, 2, 5}};
+        for (index_t n = 0; n < 17; n++) {
+            REQUIRE(lr.size(n) == (index_t) ref[n].size());
+            REQUIRE(lr.end(n) - lr.begin(n) == lr.size(n));
+            auto leaves = lr.leaves(n);
+            REQUIRE(vector<index_t>(leaves.begin(), leaves.end()) == ref[n]);
+        }
+    }
+
+    TEST_CASE("leaf ranges random bpt", "[leaf_ranges]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({40, 30});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 50));
+        auto h = bpt_canonical(g, w);
+        auto &t = h.tree;
+        hg::leaf_ranges lr(t);
+
+        auto area = attribute_area(t);
+        REQUIRE((lr.ends() - lr.begins() == area));
+
+        // each leaf of a node has this node as ancestor
+        for (index_t n = 0; n < (index_t) num_vertices(t); n++) {
+            for (auto l: lr.leaves(n)) {
+                index_t a = l;
+                while (a != n && a != root(t)) {
+                    a = parent(a, t);
+                }
+                REQUIRE(a == n);
+            }
+        }
+    }
+
+    TEST_CASE("leaf ranges leaf sums", "[leaf_ranges]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({200, 210});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 50));
+        auto h = bpt_canonical(g, w);
+        auto &t = h.tree;
+        hg::leaf_ranges lr(t);
+
+        array_1d<index_t> ones = xt::ones<index_t>({num_leaves(t)});
+        REQUIRE((lr.leaf_sums(ones) == attribute_area(t)));
+
+        array_1d<long> signal1 = xt::random::randint<long>({num_leaves(t)}, -100, 100);
+        REQUIRE((lr.leaf_sums(signal1) == accumulate_sequential(t, signal1, accumulator_sum())));
+
+        array_2d<long> signal2 = xt::random::randint<long>({num_leaves(t), (size_t) 3}, -100, 100);
+        auto ref2 = accumulate_sequential(t, signal2, accumulator_sum());
+        REQUIRE((lr.leaf_sums(signal2) == ref2));
+
+        set_deterministic(true);
+        REQUIRE((lr.leaf_sums(signal2) == ref2));
+        set_deterministic(false);
+
+        array_1d<double> signal3 = xt::random::rand<double>({num_leaves(t)});
+        REQUIRE(xt::allclose(lr.leaf_sums(signal3), accumulate_sequential(t, signal3, accumulator_sum())));
+    }
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/level_ancestors.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace level_ancestors {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("level ancestors simple tree", "[level_ancestors]") {
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        hg::level_ancestors la(t);
+        REQUIRE(la.num_elements() == 8);
+
+        array_1d<index_t> ref_depth{2, 2, 2, 2, 2, 1, 1, 0};
+        for (index_t i = 0; i < 8; i++) {
+            REQUIRE(la.depth(i) == ref_depth(i));
+        }
+        REQUIRE(la.level_ancestor(0, 2) == 0);
+        REQUIRE(la.level_ancestor(0, 1) == 5);
+        REQUIRE(la.level_ancestor(0, 0) == 7);
+        REQUIRE(la.level_ancestor(3, 1) == 6);
+        REQUIRE(la.level_ancestor(6, 0) == 7);
+
+        array_1d<double> altitudes{0, 0, 0, 0, 0, 2, 1, 3};
+        array_1d<index_t> vertices{0, 0, 0, 3, 3, 3, 7};
+        array_1d<double> lambdas{1, 3, 4, 0, 2, 4, 5};
+        array_1d<index_t> ref{0, 5, 7, 3, 6, 7, 7};
+        REQUIRE((la.find_region(vertices, lambdas, altitudes) == ref));
+    }
+
+    TEST_CASE("level ancestors random bpt", "[level_ancestors]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({40, 30});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 50));
+        auto h = bpt_canonical(g, w);
+        auto &t = h.tree;
+        auto &altitudes = h.altitudes;
+        hg::level_ancestors la(t);
+
+        auto depth = attribute_depth(t);
+        for (index_t i = 0; i < (index_t) num_vertices(t); i++) {
+            REQUIRE(la.depth(i) == depth(i));
+        }
+
+        array_1d<index_t> vertices = xt::random::randint<index_t>({3000}, 0, num_vertices(t));
+        array_1d<index_t> depths = xt::empty<index_t>({3000});
+        array_1d<int> lambdas = xt::random::randint<int>({3000}, 0, 52);
+        for (index_t i = 0; i < 3000; i++) {
+            depths(i) = xt::random::randint<index_t>({1}, 0, depth(vertices(i)) + 1)(0);
+        }
+
+        auto res_level = la.level_ancestor(vertices, depths);
+        auto res_region = la.find_region(vertices, lambdas, altitudes);
+        REQUIRE((res_region == find_region(vertices, lambdas, altitudes, t)));
+        for (index_t i = 0; i < 3000; i++) {
+            auto v = vertices(i);
+            while (depth(v) > depths(i)) {
+                v = parent(v, t);
+            }
+            REQUIRE(res_level(i) == v);
+        }
+    }
+}
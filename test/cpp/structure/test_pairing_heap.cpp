@@ -0,0 +1,112 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/pairing_heap.hpp"
+#include "../test_utils.hpp"
+#include <random>
+#include <set>
+
+namespace test_pairing_heap {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("pairing heap push pop", "[pairing_heap]") {
+        pairing_heap_forest<double> heaps(6);
+        index_t h = invalid_index;
+        h = heaps.push(h, 0, 5);
+        h = heaps.push(h, 1, 2);
+        h = heaps.push(h, 2, 8);
+        h = heaps.push(h, 3, 1);
+        h = heaps.push(h, 4, 4);
+        REQUIRE(h == 3);
+        REQUIRE(heaps.key(h) == 1);
+
+        vector<index_t> order;
+        while (h != invalid_index) {
+            order.push_back(h);
+            h = heaps.pop(h);
+        }
+        REQUIRE((order == vector<index_t>{3, 1, 4, 0, 2}));
+
+        // elements can be reinserted after being popped
+        h = heaps.push(h, 2, 3);
+        h = heaps.push(h, 5, 0);
+        REQUIRE(h == 5);
+        h = heaps.pop(h);
+        REQUIRE(h == 2);
+        h = heaps.pop(h);
+        REQUIRE(h == invalid_index);
+    }
+
+    TEST_CASE("pairing heap max heap", "[pairing_heap]") {
+        pairing_heap_forest<double, std::greater<double>> heaps(4);
+        index_t h = invalid_index;
+        for (index_t i = 0; i < 4; i++) {
+            h = heaps.push(h, i, (double) ((i * 3) % 4));
+        }
+        vector<double> keys;
+        while (h != invalid_index) {
+            keys.push_back(heaps.key(h));
+            h = heaps.pop(h);
+        }
+        REQUIRE((keys == vector<double>{3, 2, 1, 0}));
+    }
+
+    TEST_CASE("pairing heap random meld", "[pairing_heap]") {
+        const index_t num_elements = 2000;
+        const index_t num_heaps = 20;
+        std::mt19937 gen(11);
+        std::uniform_int_distribution<int> key_dis(0, 100);
+        std::uniform_int_distribution<index_t> heap_dis(0, num_heaps - 1);
+        std::uniform_int_distribution<int> op_dis(0, 9);
+
+        pairing_heap_forest<int> heaps(num_elements);
+        vector<index_t> tops(num_heaps, invalid_index);
+        vector<multiset<pair<int, index_t>>> refs(num_heaps);
+
+        index_t next_element = 0;
+        while (next_element < num_elements) {
+            index_t h = heap_dis(gen);
+            int op = op_dis(gen);
+            if (op < 6) {
+                int key = key_dis(gen);
+                tops[h] = heaps.push(tops[h], next_element, key);
+                refs[h].insert({key, next_element});
+                next_element++;
+            } else if (op < 9) {
+                if (!refs[h].empty()) {
+                    REQUIRE(heaps.key(tops[h]) == refs[h].begin()->first);
+                    refs[h].erase(refs[h].find({heaps.key(tops[h]), tops[h]}));
+                    tops[h] = heaps.pop(tops[h]);
+                } else {
+                    REQUIRE(tops[h] == invalid_index);
+                }
+            } else {
+                index_t h2 = heap_dis(gen);
+                if (h2 != h) {
+                    tops[h] = heaps.meld(tops[h], tops[h2]);
+                    tops[h2] = invalid_index;
+                    refs[h].insert(refs[h2].begin(), refs[h2].end());
+                    refs[h2].clear();
+                }
+            }
+        }
+
+        for (index_t h = 0; h < num_heaps; h++) {
+            while (!refs[h].empty()) {
+                REQUIRE(heaps.key(tops[h]) == refs[h].begin()->first);
+                refs[h].erase(refs[h].find({heaps.key(tops[h]), tops[h]}));
+                tops[h] = heaps.pop(tops[h]);
+            }
+            REQUIRE(tops[h] == invalid_index);
+        }
+    }
+}
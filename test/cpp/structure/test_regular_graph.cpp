@@ -9,6 +9,7 @@
 ****************************************************************************/
 
 #include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
 #include "../test_utils.hpp"
 
 namespace regular_graph {
@@ -155,6 +156,84 @@ namespace regular_graph {
         }
     }
 
+    template<typename graph_t>
+    void check_scan_regular_graph(const graph_t &g, index_t start, index_t end) {
+        index_t next = start;
+        index_t num_interior = 0;
+        scan_regular_graph(g, start, end,
+                           [&g, &next, &num_interior](index_t first, index_t last, const auto &offsets) {
+                               REQUIRE(first == next);
+                               REQUIRE(first < last);
+                               for (index_t v = first; v < last; v++) {
+                                   vector<index_t> adj(adjacent_vertex_iterator(v, g).begin(),
+                                                       adjacent_vertex_iterator(v, g).end());
+                                   REQUIRE(adj.size() == offsets.size());
+                                   for (index_t k = 0; k < (index_t) offsets.size(); k++) {
+                                       REQUIRE(adj[k] == v + offsets[k]);
+                                   }
+                               }
+                               num_interior += last - first;
+                               next = last;
+                           },
+                           [&g, &next](index_t v, const auto &coordinates) {
+                               REQUIRE(v == next);
+                               REQUIRE(g.embedding().grid2lin(coordinates) == v);
+                               next++;
+                           });
+        REQUIRE(next == (std::max)(start, end));
+        if (start == 0 && end == (index_t) num_vertices(g)) {
+            index_t ref_interior = 1;
+            for (index_t d = 0; d < (index_t) g.embedding().dimension(); d++) {
+                ref_interior *= (std::max)(g.safe_upper_bound()(d) - g.safe_lower_bound()(d) + 1, (index_t) 0);
+            }
+            REQUIRE(num_interior == ref_interior);
+        }
+    }
+
+    TEST_CASE("scan regular graph", "[regular_graph]") {
+        auto g4 = get_4_adjacency_implicit_graph({5, 7});
+        auto g8 = get_8_adjacency_implicit_graph({5, 7});
+        auto g8_small = get_8_adjacency_implicit_graph({2, 7});
+        vector<pair<index_t, index_t>> ranges{{0, 35}, {0, 1}, {3, 19}, {8, 9}, {12, 35}, {20, 20}, {0, 14}};
+        for (auto &r: ranges) {
+            check_scan_regular_graph(g4, r.first, r.second);
+            check_scan_regular_graph(g8, r.first, r.second);
+            check_scan_regular_graph(g8_small, r.first, (std::min)(r.second, (index_t) 14));
+        }
+
+        hg::regular_grid_graph_1d g1({6}, {{-1}, {1}});
+        check_scan_regular_graph(g1, 0, 6);
+        check_scan_regular_graph(g1, 2, 4);
+
+        std::vector<point_3d_i> neighbours6{{-1, 0, 0},
+                                            {0, -1, 0},
+                                            {0, 0, -1},
+                                            {0, 0, 1},
+                                            {0, 1, 0},
+                                            {1, 0, 0}};
+        std::vector<point_3d_i> neighbours26;
+        for (index_t i = -1; i <= 1; i++) {
+            for (index_t j = -1; j <= 1; j++) {
+                for (index_t k = -1; k <= 1; k++) {
+                    if (i != 0 || j != 0 || k != 0) {
+                        neighbours26.push_back({i, j, k});
+                    }
+                }
+            }
+        }
+        hg::regular_grid_graph_3d g6({4, 3, 5}, neighbours6);
+        hg::regular_grid_graph_3d g26({4, 3, 5}, neighbours26);
+        for (auto &r: vector<pair<index_t, index_t>>{{0, 60}, {7, 41}, {21, 24}}) {
+            check_scan_regular_graph(g6, r.first, r.second);
+            check_scan_regular_graph(g26, r.first, r.second);
+        }
+
+        // non usual adjacency: offsets are given as a vector
+        hg::regular_grid_graph_2d g2({4, 6}, {{0, -2}, {-1, 1}, {2, 0}});
+        check_scan_regular_graph(g2, 0, 24);
+        check_scan_regular_graph(g2, 5, 17);
+    }
+
     TEST_CASE("regular graph to ugraph", "[regular_graph]") {
         hg::embedding_grid_1d embedding1{2};
         std::vector<point_1d_i> neighbours1{{-1},
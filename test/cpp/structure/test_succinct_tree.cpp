@@ -0,0 +1,158 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/succinct_tree.hpp"
+#include "higra/structure/lca_fast.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/attribute/tree_attribute.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace succinct_tree_test {
+
+    using namespace hg;
+    using namespace std;
+
+    // checks all the queries of the succinct representation of t against t
+    void check_succinct_tree(const tree &t) {
+        auto res = make_succinct_tree(t);
+        auto &st = res.tree;
+        auto &node_map = res.node_map;
+        const index_t n = num_vertices(t);
+        REQUIRE(st.num_vertices() == n);
+        REQUIRE(st.num_leaves() == (index_t) num_leaves(t));
+        REQUIRE(node_map(st.root()) == t.root());
+
+        array_1d<index_t> preorder = array_1d<index_t>::from_shape({(size_t) n});
+        for (index_t i = 0; i < n; i++) {
+            preorder(node_map(i)) = i;
+        }
+        array_1d<index_t> size = xt::ones<index_t>({(size_t) n});
+        for (auto i: leaves_to_root_iterator(t, leaves_it::include, root_it::exclude)) {
+            size(parent(i, t)) += size(i);
+        }
+        auto depth = attribute_depth(t);
+        t.compute_children();
+
+        for (index_t i = 0; i < n; i++) {
+            auto v = node_map(i);
+            REQUIRE(st.parent(i) == preorder(parent(v, t)));
+            REQUIRE(st.subtree_size(i) == size(v));
+            REQUIRE(st.depth(i) == depth(v));
+            REQUIRE(st.is_leaf(i) == t.is_leaf(v));
+            std::vector<index_t> ref_children;
+            for (auto c: children_iterator(v, t)) {
+                ref_children.push_back(preorder(c));
+            }
+            REQUIRE(st.children(i) == ref_children);
+            REQUIRE(st.num_children(i) == (index_t) ref_children.size());
+        }
+
+        lca_sparse_table_block lca(t);
+        array_1d<index_t> v1 = xt::random::randint<index_t>({2000}, 0, n);
+        array_1d<index_t> v2 = xt::random::randint<index_t>({2000}, 0, n);
+        auto ref = lca.lca(v1, v2);
+        array_1d<index_t> sv1 = xt::index_view(preorder, v1);
+        array_1d<index_t> sv2 = xt::index_view(preorder, v2);
+        auto lcas = st.lowest_common_ancestor(sv1, sv2);
+        for (index_t i = 0; i < (index_t) v1.size(); i++) {
+            REQUIRE(node_map(lcas(i)) == ref(i));
+        }
+
+        auto back = st.to_tree();
+        REQUIRE(num_vertices(back.tree) == (size_t) n);
+        REQUIRE(num_leaves(back.tree) == num_leaves(t));
+        for (index_t i = 0; i < n; i++) {
+            REQUIRE(back.node_map(parent(i, back.tree)) == st.parent(back.node_map(i)));
+        }
+    }
+
+    TEST_CASE("succinct tree simple tree", "[succinct_tree]") {
+        tree t(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        auto res = make_succinct_tree(t);
+        auto &st = res.tree;
+        // preorder: 7 5 0 1 6 2 3 4
+        array_1d<index_t> ref_node_map{7, 5, 0, 1, 6, 2, 3, 4};
+        REQUIRE((res.node_map == ref_node_map));
+        REQUIRE(st.num_vertices() == 8);
+        REQUIRE(st.num_leaves() == 5);
+        REQUIRE(st.bits()(0) == 0b0001010110010111);
+
+        REQUIRE(st.parent(0) == 0);
+        REQUIRE(st.parent(2) == 1);
+        REQUIRE(st.parent(4) == 0);
+        REQUIRE(st.parent(7) == 4);
+        REQUIRE(st.subtree_size(0) == 8);
+        REQUIRE(st.subtree_size(1) == 3);
+        REQUIRE(st.subtree_size(3) == 1);
+        REQUIRE(st.children(0) == std::vector<index_t>{1, 4});
+        REQUIRE(st.children(4) == std::vector<index_t>{5, 6, 7});
+        REQUIRE(st.children(6).empty());
+        REQUIRE(st.first_child(6) == invalid_index);
+        REQUIRE(st.next_sibling(7) == invalid_index);
+        REQUIRE(st.lowest_common_ancestor(2, 3) == 1);
+        REQUIRE(st.lowest_common_ancestor(3, 6) == 0);
+        REQUIRE(st.lowest_common_ancestor(5, 7) == 4);
+        REQUIRE(st.lowest_common_ancestor(7, 4) == 4);
+        REQUIRE(st.lowest_common_ancestor(0, 5) == 0);
+
+        auto back = st.to_tree();
+        array_1d<index_t> ref_parents{6, 6, 5, 5, 5, 7, 7, 7};
+        REQUIRE((parents(back.tree) == ref_parents));
+        array_1d<index_t> ref_back_node_map{2, 3, 5, 6, 7, 4, 1, 0};
+        REQUIRE((back.node_map == ref_back_node_map));
+        check_succinct_tree(t);
+    }
+
+    TEST_CASE("succinct tree single node", "[succinct_tree]") {
+        tree t(array_1d<index_t>{0});
+        succinct_tree st(t);
+        REQUIRE(st.num_vertices() == 1);
+        REQUIRE(st.parent(0) == 0);
+        REQUIRE(st.subtree_size(0) == 1);
+        REQUIRE(st.is_leaf(0));
+        REQUIRE(st.lowest_common_ancestor(0, 0) == 0);
+        REQUIRE(num_vertices(st.to_tree().tree) == 1);
+    }
+
+    TEST_CASE("succinct tree random bpt", "[succinct_tree]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({60, 50});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 50));
+        auto h = bpt_canonical(g, w);
+        check_succinct_tree(h.tree);
+
+        // non binary tree
+        array_1d<bool> criterion = xt::equal(xt::index_view(h.altitudes, parents(h.tree)), h.altitudes);
+        auto t2 = simplify_tree(h.tree, criterion).tree;
+        check_succinct_tree(t2);
+    }
+
+    TEST_CASE("succinct tree deep tree", "[succinct_tree]") {
+        // caterpillar: the parentheses of the deepest nodes are far from those of the root
+        const index_t num_l = 3000;
+        array_1d<index_t> p = array_1d<index_t>::from_shape({(size_t) (2 * num_l - 1)});
+        p(0) = num_l;
+        for (index_t i = 1; i < num_l; i++) {
+            p(i) = num_l + i - 1;
+        }
+        for (index_t i = num_l; i < 2 * num_l - 2; i++) {
+            p(i) = i + 1;
+        }
+        p(2 * num_l - 2) = 2 * num_l - 2;
+        tree t(p);
+        check_succinct_tree(t);
+
+        succinct_tree st(t);
+        REQUIRE(st.memory_usage() < (size_t) num_vertices(t));
+    }
+}
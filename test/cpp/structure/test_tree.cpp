@@ -8,8 +8,8 @@
 * The full license is in the file LICENSE, distributed with this software. *
 ****************************************************************************/
 
-#include "xtensor/xio.hpp"
 #include "higra/graph.hpp"
+#include "xtensor/xio.hpp"
 #include "../test_utils.hpp"
 #include <functional>
 
@@ -324,6 +324,44 @@ namespace tree {
         REQUIRE((child(1, vertices, g) == ref_child1));
     }
 
+    TEST_CASE("tree concurrent compute children", "[tree]") {
+        auto g = data.t;
+        g.clear_children();
+        REQUIRE(!g.children_computed());
+
+        array_1d<index_t> counts = xt::zeros<index_t>({64});
+        parfor(0, 64, [&g, &counts](index_t i) {
+            g.compute_children();
+            for (auto c: children_iterator(i % (index_t) num_vertices(g), g)) {
+                counts(i) += c;
+            }
+        });
+        REQUIRE(g.children_computed());
+        array_1d<index_t> ref_sums{0, 0, 0, 0, 0, 1, 9, 11};
+        for (index_t i = 0; i < 64; i++) {
+            REQUIRE(counts(i) == ref_sums(i % 8));
+        }
+    }
+
+    TEST_CASE("tree children csr storage", "[tree]") {
+        auto g = data.t;
+        g.clear_children();
+        auto csr = g.children_csr_storage();
+        REQUIRE(g.children_computed());
+        REQUIRE((csr->offsets == array_1d<index_t>{0, 2, 5, 7}));
+        REQUIRE((csr->children == array_1d<index_t>{0, 1, 2, 3, 4, 5, 6}));
+
+        // the storage outlives the children relation of the tree
+        g.clear_children();
+        REQUIRE(!g.children_computed());
+        REQUIRE((csr->children == array_1d<index_t>{0, 1, 2, 3, 4, 5, 6}));
+        REQUIRE(g.children_csr_storage() != csr);
+
+        // copies share the storage
+        auto g2 = g;
+        REQUIRE(g2.children_csr_storage() == g.children_csr_storage());
+    }
+
     TEST_CASE("tree tree topological order iterator", "[tree]") {
         auto tree = data.t;
 
@@ -475,4 +513,53 @@ namespace tree {
         REQUIRE(num_vertices(t) == 8);
         REQUIRE(num_edges(t) == 7);
     }
-}
\ No newline at end of file
+
+    TEST_CASE("tree on external buffer", "[tree]") {
+        auto parents = std::make_shared<std::vector<index_t>>(std::vector<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        const index_t *buffer = parents->data();
+
+        hg::tree t(buffer, parents->size(), parents);
+        parents.reset();
+        REQUIRE(t.parents_data() == buffer);
+        REQUIRE(num_vertices(t) == 8);
+        REQUIRE(num_leaves(t) == 5);
+        REQUIRE(root(t) == 7);
+        REQUIRE((hg::parents(t) == data.t.parents()));
+
+        // copies share the buffer
+        auto t2 = t;
+        REQUIRE(t2.parents_data() == buffer);
+        t2.compute_children();
+        REQUIRE(t2.num_children(6) == 3);
+        REQUIRE(t2.child(1, 6) == 3);
+
+        // trusted number of leaves
+        std::vector<index_t> parents2{4, 4, 5, 5, 6, 6, 6};
+        hg::tree t3(parents2.data(), parents2.size(), nullptr, tree_category::partition_tree, 4);
+        REQUIRE(num_leaves(t3) == 4);
+        REQUIRE(root(t3) == 6);
+        REQUIRE(parent(2, t3) == 5);
+    }
+
+    TEST_CASE("tree parents outliving the tree", "[tree]") {
+        auto parents = std::make_shared<std::vector<index_t>>(std::vector<index_t>{5, 5, 6, 6, 6, 7, 7, 7});
+        std::weak_ptr<std::vector<index_t>> weak_parents = parents;
+        auto t = std::make_unique<hg::tree>(parents->data(), parents->size(), parents);
+        parents.reset();
+
+        // copies of the parents view share the ownership of the array
+        auto p = t->parents();
+        t.reset();
+        REQUIRE(!weak_parents.expired());
+        REQUIRE((p == data.t.parents()));
+        p = hg::tree().parents();
+        REQUIRE(weak_parents.expired());
+
+        // parents of temporary trees
+        auto p2 = hg::tree(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7}).parents();
+        REQUIRE((p2 == data.t.parents()));
+        REQUIRE((hg::parents(hg::tree(array_1d<index_t>{5, 5, 6, 6, 6, 7, 7, 7})) == data.t.parents()));
+        array_1d<index_t> owned = hg::parents(hg::tree(array_1d<index_t>{3, 3, 3, 3}));
+        REQUIRE((owned == array_1d<index_t>{3, 3, 3, 3}));
+    }
+}
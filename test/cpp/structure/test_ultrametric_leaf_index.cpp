@@ -0,0 +1,114 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2021)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "higra/image/graph_image.hpp"
+#include "higra/structure/ultrametric_leaf_index.hpp"
+#include "higra/structure/lca_fast.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xsort.hpp"
+#include <set>
+#include "../test_utils.hpp"
+
+namespace ultrametric_leaf_index {
+
+    using namespace hg;
+    using namespace std;
+
+    TEST_CASE("ultrametric leaf index simple tree", "[ultrametric_leaf_index]") {
+        // depth first order of the leaves: 3, 4, 8, 6, 7, 0, 1, 2, 5
+        tree t(array_1d<index_t>{9, 9, 10, 11, 11, 10, 12, 12, 13, 14, 14, 16, 13, 15, 15, 16, 16});
+        array_1d<double> altitudes{0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 1, 3, 4, 5, 6};
+        hg::ultrametric_leaf_index index(t, altitudes);
+        REQUIRE(index.num_leaves() == 9);
+        REQUIRE(index.distance(0, 0) == 0);
+        REQUIRE(index.distance(0, 1) == 1);
+        REQUIRE(index.distance(5, 0) == 4);
+        REQUIRE(index.distance(6, 3) == 6);
+
+        auto r1 = index.nearest_leaves(0, 3);
+        REQUIRE((r1.first == array_1d<index_t>{1, 2, 5}));
+        REQUIRE((r1.second == array_1d<double>{1, 4, 4}));
+
+        auto r2 = index.nearest_leaves(0, 100);
+        REQUIRE((r2.first == array_1d<index_t>{1, 2, 5, 8, 6, 7, 3, 4}));
+        REQUIRE((r2.second == array_1d<double>{1, 4, 4, 5, 5, 5, 6, 6}));
+
+        REQUIRE(index.nearest_leaves(0, 0).first.size() == 0);
+
+        REQUIRE(index.ball(0, 4.5) == 14);
+        REQUIRE(index.ball(0, 0.5) == 0);
+        auto r3 = index.leaves_within(0, 4.5);
+        REQUIRE((r3.first == array_1d<index_t>{1, 2, 5}));
+        REQUIRE((r3.second == array_1d<double>{1, 4, 4}));
+        REQUIRE(index.leaves_within(0, 0.5).first.size() == 0);
+        REQUIRE(index.leaves_within(8, 6).first.size() == 8);
+
+        auto r4 = index.nearest_leaves(array_1d<index_t>{0, 3}, 2);
+        REQUIRE((r4.leaves == array_2d<index_t>{{1, 2}, {4, 8}}));
+        REQUIRE((r4.distances == array_2d<double>{{1, 4}, {1, 6}}));
+
+        auto r5 = index.leaves_within(array_1d<index_t>{0, 3, 7}, array_1d<double>{4, 1, 0});
+        REQUIRE((r5.offsets == array_1d<index_t>{0, 3, 4, 4}));
+        REQUIRE((r5.leaves == array_1d<index_t>{1, 2, 5, 4}));
+        REQUIRE((r5.distances == array_1d<double>{1, 4, 4, 1}));
+
+        array_1d<double> non_increasing = altitudes;
+        non_increasing(13) = 10;
+        REQUIRE_THROWS(hg::ultrametric_leaf_index(t, non_increasing));
+    }
+
+    TEST_CASE("ultrametric leaf index random bpt", "[ultrametric_leaf_index]") {
+        xt::random::seed(42);
+        auto g = get_4_adjacency_graph({25, 20});
+        auto w = xt::eval(xt::random::randint<int>({num_edges(g)}, 0, 20));
+        auto h = bpt_canonical(g, w);
+        auto &t = h.tree;
+        hg::ultrametric_leaf_index index(t, h.altitudes);
+        lca_fast lca(t);
+        const index_t num_l = num_leaves(t);
+
+        array_1d<index_t> queries = xt::random::randint<index_t>({50}, 0, num_l);
+        const index_t k = 30;
+        auto knn = index.nearest_leaves(queries, k);
+        array_1d<double> max_distances = xt::random::randint<int>({50}, 0, 20);
+        auto within = index.leaves_within(queries, max_distances);
+
+        for (index_t i = 0; i < (index_t) queries.size(); i++) {
+            const index_t q = queries(i);
+            // brute force distances to all the other leaves
+            array_1d<double> distances = array_1d<double>::from_shape({(size_t) num_l});
+            for (index_t j = 0; j < num_l; j++) {
+                distances(j) = (j == q) ? -1 : h.altitudes(lca.lca(q, j));
+                REQUIRE(index.distance(q, j) == (std::max)(0.0, distances(j)));
+            }
+            array_1d<double> sorted = xt::sort(distances);
+
+            REQUIRE((xt::view(knn.distances, i) == xt::view(sorted, xt::range(1, k + 1))));
+            set<index_t> seen;
+            for (index_t j = 0; j < k; j++) {
+                const index_t l = knn.leaves(i, j);
+                REQUIRE(l != q);
+                REQUIRE(distances(l) == knn.distances(i, j));
+                seen.insert(l);
+            }
+            REQUIRE((index_t) seen.size() == k);
+
+            const index_t start = within.offsets(i);
+            const index_t end = within.offsets(i + 1);
+            REQUIRE(end - start == (index_t) xt::sum(distances >= 0 && distances <= max_distances(i))());
+            for (index_t j = start; j < end; j++) {
+                REQUIRE(distances(within.leaves(j)) == within.distances(j));
+                REQUIRE(within.distances(j) <= max_distances(i));
+            }
+        }
+    }
+}
@@ -10,6 +10,7 @@
 
 #include "higra/graph.hpp"
 #include "../test_utils.hpp"
+#include "xtensor/xindex_view.hpp"
 
 
 /**
@@ -314,6 +315,57 @@ namespace test_undirected_graph {
             }
         }
 
+        SECTION("compact edges") {
+            auto g = data<TestType>::g();
+            add_edge(2, 3, g);
+            array_1d<double> edge_weights{1, 2, 3, 4};
+
+            remove_edge(1, g);
+            remove_edge(0, g);
+
+            auto res = compact_edges(g);
+            auto &old_to_new = res.first;
+            auto &new_to_old = res.second;
+
+            array_1d<index_t> old_to_new_ref{invalid_index, invalid_index, 0, 1};
+            array_1d<index_t> new_to_old_ref{2, 3};
+            REQUIRE((old_to_new == old_to_new_ref));
+            REQUIRE((new_to_old == new_to_old_ref));
+
+            REQUIRE(num_edges(g) == 2);
+            vector<pair<index_t, index_t>> eref{{0, 2},
+                                                {2, 3}};
+            vector<pair<index_t, index_t>> etest;
+            for (auto e: hg::edge_iterator(g)) {
+                REQUIRE(index(e, g) == (index_t) etest.size());
+                etest.push_back(e);
+            }
+            REQUIRE(vectorSame(eref, etest));
+
+            array_1d<double> new_weights = xt::index_view(edge_weights, new_to_old);
+            array_1d<double> new_weights_ref{3, 4};
+            REQUIRE((new_weights == new_weights_ref));
+
+            vector<vector<index_t>> out_ref{{0},
+                                            {},
+                                            {0, 1},
+                                            {1}};
+            for (auto v: hg::vertex_iterator(g)) {
+                vector<index_t> out;
+                for (auto e: hg::out_edge_iterator(v, g)) {
+                    REQUIRE(source(e, g) == v);
+                    out.push_back(index(e, g));
+                }
+                std::sort(out.begin(), out.end());
+                REQUIRE(out == out_ref[v]);
+            }
+
+            // nothing to compact
+            auto res2 = compact_edges(g);
+            REQUIRE((res2.first == array_1d<index_t>{0, 1}));
+            REQUIRE(num_edges(g) == 2);
+        }
+
         SECTION("set edge") {
             auto g = data<TestType>::g();
 
@@ -399,5 +451,111 @@ namespace test_undirected_graph {
             REQUIRE((targets_ref == tgt));
 
         }
+
+        SECTION("from edge lists") {
+            auto g = data<TestType>::g();
+            g.set_edge(0, 2, 3);
+
+            array_1d<index_t> offsets = xt::zeros<index_t>({num_vertices(g) + 1});
+            std::vector<index_t> indices;
+            for (index_t v = 0; v < (index_t) num_vertices(g); v++) {
+                indices.insert(indices.end(), g.out_edges_cbegin(v), g.out_edges_cend(v));
+                offsets(v + 1) = indices.size();
+            }
+
+            auto g2 = TestType::from_edge_lists(num_vertices(g), g.edges_data(), num_edges(g), offsets, indices);
+            REQUIRE(num_vertices(g2) == num_vertices(g));
+            REQUIRE(num_edges(g2) == num_edges(g));
+            REQUIRE((sources(g2) == sources(g)));
+            REQUIRE((targets(g2) == targets(g)));
+            for (auto v: vertex_iterator(g)) {
+                std::vector<index_t> out1(g.out_edges_cbegin(v), g.out_edges_cend(v));
+                std::vector<index_t> out2(g2.out_edges_cbegin(v), g2.out_edges_cend(v));
+                std::sort(out1.begin(), out1.end());
+                std::sort(out2.begin(), out2.end());
+                REQUIRE(out1 == out2);
+            }
+
+            REQUIRE_THROWS(TestType::from_edge_lists(num_vertices(g) + 1, g.edges_data(), num_edges(g), offsets,
+                                                     indices));
+        }
+
+        SECTION("bulk add edges") {
+            array_1d<index_t> sources{0, 2, 3, 1, 4, 4, 0};
+            array_1d<index_t> targets{1, 1, 0, 3, 4, 2, 1};
+
+            TestType g_ref(5ul);
+            add_edge(0, 2, g_ref);
+            for (index_t i = 0; i < (index_t) sources.size(); i++) {
+                add_edge(sources(i), targets(i), g_ref);
+            }
+
+            TestType g(5ul);
+            add_edge(0, 2, g);
+            add_edges(sources, targets, g);
+            TestType g2(5, xt::concatenate(xt::xtuple(array_1d<index_t>{0}, sources)),
+                        xt::concatenate(xt::xtuple(array_1d<index_t>{2}, targets)));
+
+            for (auto g_test: {&g, &g2}) {
+                REQUIRE(num_edges(*g_test) == num_edges(g_ref));
+                REQUIRE((hg::sources(*g_test) == hg::sources(g_ref)));
+                REQUIRE((hg::targets(*g_test) == hg::targets(g_ref)));
+                for (auto v: vertex_iterator(g_ref)) {
+                    std::vector<index_t> out_ref(g_ref.out_edges_cbegin(v), g_ref.out_edges_cend(v));
+                    std::vector<index_t> out(g_test->out_edges_cbegin(v), g_test->out_edges_cend(v));
+                    if (!std::is_same<TestType, ugraph>::value) {
+                        // no order in hash sets
+                        std::sort(out_ref.begin(), out_ref.end());
+                        std::sort(out.begin(), out.end());
+                    }
+                    REQUIRE(out == out_ref);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("undirected graph csr adjacency", "[undirected_graph]") {
+        ugraph g(5);
+        add_edge(0, 1, g);
+        add_edge(2, 0, g);
+        add_edge(3, 3, g);
+        add_edge(1, 2, g);
+        add_edge(4, 2, g);
+
+        auto csr = undirected_graph_2_csr_adjacency(g);
+        array_1d<index_t> ref_indptr{0, 2, 4, 7, 8, 9};
+        array_1d<index_t> ref_indices{1, 2, 0, 2, 0, 1, 4, 3, 2};
+        array_1d<index_t> ref_edge_indices{0, 1, 0, 3, 1, 3, 4, 2, 4};
+        REQUIRE((csr.indptr == ref_indptr));
+        REQUIRE((csr.indices == ref_indices));
+        REQUIRE((csr.edge_indices == ref_edge_indices));
+
+        // entries of the lower triangle are ignored, edges follow the row major order of the upper triangle
+        auto res = csr_adjacency_2_undirected_graph(csr.indptr, csr.indices);
+        auto &g2 = res.first;
+        REQUIRE(num_vertices(g2) == 5);
+        REQUIRE(num_edges(g2) == 5);
+        array_1d<index_t> ref_sources{0, 0, 1, 2, 3};
+        array_1d<index_t> ref_targets{1, 2, 2, 4, 3};
+        REQUIRE((sources(g2) == ref_sources));
+        REQUIRE((targets(g2) == ref_targets));
+        array_1d<index_t> ref_edge_map{0, 1, 3, 6, 7};
+        REQUIRE((res.second == ref_edge_map));
+
+        ugraph g3(5, ref_sources, ref_targets);
+        for (index_t v = 0; v < 5; v++) {
+            std::vector<index_t> out_edges2;
+            std::vector<index_t> out_edges3;
+            for (auto e: out_edge_iterator(v, g2)) {
+                out_edges2.push_back(index(e, g2));
+            }
+            for (auto e: out_edge_iterator(v, g3)) {
+                out_edges3.push_back(index(e, g3));
+            }
+            REQUIRE(out_edges2 == out_edges3);
+        }
+
+        REQUIRE_THROWS(csr_adjacency_2_undirected_graph(array_1d<index_t>{0, 1}, array_1d<index_t>{1}));
+        REQUIRE_THROWS(csr_adjacency_2_undirected_graph(array_1d<index_t>{0, 2}, array_1d<index_t>{0}));
     }
-}
\ No newline at end of file
+}
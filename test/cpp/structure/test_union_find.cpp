@@ -0,0 +1,152 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/unionfind.hpp"
+#include "../test_utils.hpp"
+#include <random>
+#include <numeric>
+
+namespace test_union_find {
+
+    using namespace hg;
+    using namespace hg::union_find_internal;
+
+    using uf_compression_halving = union_find_internal::union_find<index_t, path_halving>;
+    using uf_compression_splitting = union_find_internal::union_find<index_t, path_splitting>;
+    using uf_size = union_find_internal::union_find<index_t, path_compression, link_by_size>;
+    using uf_interleaved = union_find_internal::union_find<index_t, path_compression, link_by_rank, interleaved_layout>;
+    using uf_32 = union_find_internal::union_find<int32_t, path_splitting, link_by_size, interleaved_layout>;
+
+    TEMPLATE_TEST_CASE("union find", "[union_find]",
+                       hg::union_find,
+                       uf_compression_halving,
+                       uf_compression_splitting,
+                       uf_size,
+                       uf_interleaved,
+                       uf_32,
+                       hg::union_find_halving<>,
+                       hg::union_find_halving<int32_t>,
+                       hg::workspace_union_find) {
+        TestType uf(4);
+        for (index_t i = 0; i < 4; i++) {
+            REQUIRE(uf.find(i) == i);
+        }
+        auto r = uf.link(uf.find(0), uf.find(1));
+        REQUIRE((r == 0 || r == 1));
+        REQUIRE(uf.find(0) == uf.find(1));
+        REQUIRE(uf.find(0) != uf.find(2));
+
+        auto n = uf.make_set();
+        REQUIRE(n == 4);
+        REQUIRE(uf.find(4) == 4);
+        uf.link(uf.find(4), uf.find(2));
+        REQUIRE(uf.find(2) == uf.find(4));
+        REQUIRE(uf.find_root(2) == uf.find(4));
+
+        uf.link(uf.find(4), uf.find(0));
+        for (index_t i: {0, 1, 2, 4}) {
+            REQUIRE(uf.find(i) == uf.find(0));
+        }
+        REQUIRE(uf.find(3) == 3);
+    }
+
+    TEMPLATE_TEST_CASE("union find random", "[union_find]",
+                       hg::union_find,
+                       uf_compression_halving,
+                       uf_compression_splitting,
+                       uf_size,
+                       uf_interleaved,
+                       uf_32,
+                       hg::union_find_halving<>) {
+        const index_t size = 1000;
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<index_t> dis(0, size - 1);
+
+        TestType uf(size);
+        // naive reference: explicit labels
+        std::vector<index_t> labels(size);
+        std::iota(labels.begin(), labels.end(), 0);
+
+        for (index_t k = 0; k < 800; k++) {
+            auto a = dis(gen);
+            auto b = dis(gen);
+            auto ca = uf.find(a);
+            auto cb = uf.find(b);
+            REQUIRE(((ca == cb) == (labels[a] == labels[b])));
+            if (ca != cb) {
+                uf.link(ca, cb);
+                auto la = labels[a];
+                for (auto &l: labels) {
+                    if (l == la) {
+                        l = labels[b];
+                    }
+                }
+            }
+        }
+        for (index_t i = 0; i < size; i++) {
+            for (index_t j = i + 1; j < size; j += 17) {
+                REQUIRE(((uf.find(i) == uf.find(j)) == (labels[i] == labels[j])));
+            }
+        }
+    }
+
+    TEST_CASE("concurrent union find", "[union_find]") {
+        concurrent_union_find<index_t> uf(5);
+        REQUIRE(uf.size() == 5);
+        for (index_t i = 0; i < 5; i++) {
+            REQUIRE(uf.find(i) == i);
+        }
+        REQUIRE(uf.unite(3, 1));
+        REQUIRE(!uf.unite(1, 3));
+        REQUIRE(uf.find(3) == 1);
+        REQUIRE(uf.unite(4, 3));
+        REQUIRE(uf.find(4) == 1);
+        REQUIRE(uf.same_set(1, 4));
+        REQUIRE(!uf.same_set(0, 4));
+        REQUIRE(uf.unite(4, 0));
+        for (index_t i: {0, 1, 3, 4}) {
+            REQUIRE(uf.find(i) == 0);
+        }
+        REQUIRE(uf.find(2) == 2);
+    }
+
+    TEST_CASE("concurrent union find parallel", "[union_find]") {
+        const index_t size = 20000;
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<index_t> dis(0, size - 1);
+        std::vector<std::pair<index_t, index_t>> pairs(15000);
+        for (auto &p: pairs) {
+            p = {dis(gen), dis(gen)};
+        }
+
+        hg::union_find ref(size);
+        for (auto &p: pairs) {
+            auto c1 = ref.find(p.first);
+            auto c2 = ref.find(p.second);
+            if (c1 != c2) {
+                ref.link(c1, c2);
+            }
+        }
+
+        concurrent_union_find<int32_t> uf(size);
+        parfor(0, (index_t) pairs.size(), [&uf, &pairs](index_t i) {
+            uf.unite((int32_t) pairs[i].first, (int32_t) pairs[i].second);
+        });
+
+        for (index_t i = 0; i < size; i++) {
+            REQUIRE(uf.find((int32_t) i) <= i);
+        }
+        for (index_t i = 0; i < size; i += 7) {
+            for (index_t j = i + 1; j < size; j += 131) {
+                REQUIRE(((uf.find((int32_t) i) == uf.find((int32_t) j)) == (ref.find(i) == ref.find(j))));
+            }
+        }
+    }
+}
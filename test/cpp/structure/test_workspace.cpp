@@ -0,0 +1,98 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/workspace.hpp"
+#include "higra/graph.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/hierarchy/watershed_hierarchy.hpp"
+#include "higra/algo/tree.hpp"
+#include "higra/image/graph_image.hpp"
+#include "xtensor/xrandom.hpp"
+#include "../test_utils.hpp"
+
+namespace test_workspace {
+
+    using namespace hg;
+
+    TEST_CASE("workspace reuses released blocks", "[workspace]") {
+        workspace w;
+        REQUIRE(workspace::current() == nullptr);
+        {
+            scoped_workspace scope(w);
+            REQUIRE(workspace::current() == &w);
+            const index_t *data;
+            {
+                workspace_array_1d<index_t> a = xt::arange<index_t>(100);
+                data = a.data();
+                REQUIRE(a(99) == 99);
+            }
+            REQUIRE(w.cached_bytes() == 1024);
+            {
+                // same size class
+                workspace_array_1d<index_t> b = xt::zeros<index_t>({90});
+                REQUIRE(b.data() == data);
+                REQUIRE(w.cached_bytes() == 0);
+            }
+            {
+                workspace nested;
+                scoped_workspace nested_scope(nested);
+                REQUIRE(workspace::current() == &nested);
+                workspace_vector<int> v(10);
+            }
+            REQUIRE(workspace::current() == &w);
+        }
+        REQUIRE(workspace::current() == nullptr);
+
+        // without active workspace the arrays use the global allocation functions
+        {
+            workspace_array_1d<double> c = xt::ones<double>({10});
+            REQUIRE(c.storage().get_allocator().get_workspace() == nullptr);
+        }
+        REQUIRE(w.cached_bytes() == 1024);
+        w.release();
+        REQUIRE(w.cached_bytes() == 0);
+    }
+
+    TEST_CASE("hierarchies with workspace", "[workspace]") {
+        auto g = get_4_adjacency_graph({20, 30});
+        array_1d<double> edge_weights = xt::random::randint<int>({num_edges(g)}, 0, 10);
+
+        auto bpt_ref = bpt_canonical(g, edge_weights);
+        auto qfz_ref = quasi_flat_zone_hierarchy(g, edge_weights);
+        auto wsh_ref = watershed_hierarchy_by_area(g, edge_weights);
+        auto labels_ref = labelisation_horizontal_cut_from_threshold(wsh_ref.tree, wsh_ref.altitudes, 3);
+        auto bin_ref = tree_2_binary_tree(qfz_ref.tree);
+
+        workspace w;
+        scoped_workspace scope(w);
+        for (index_t i = 0; i < 2; i++) {
+            auto bpt = bpt_canonical(g, edge_weights);
+            REQUIRE((bpt.tree.parents() == bpt_ref.tree.parents()));
+            REQUIRE((bpt.mst_edge_map == bpt_ref.mst_edge_map));
+
+            auto qfz = quasi_flat_zone_hierarchy(g, edge_weights);
+            REQUIRE((qfz.tree.parents() == qfz_ref.tree.parents()));
+
+            auto wsh = watershed_hierarchy_by_area(g, edge_weights);
+            REQUIRE((wsh.tree.parents() == wsh_ref.tree.parents()));
+            REQUIRE((wsh.altitudes == wsh_ref.altitudes));
+
+            auto labels = labelisation_horizontal_cut_from_threshold(wsh.tree, wsh.altitudes, 3);
+            REQUIRE((labels == labels_ref));
+
+            auto bin = tree_2_binary_tree(qfz.tree);
+            REQUIRE((bin.tree.parents() == bin_ref.tree.parents()));
+
+            auto simplified = simplify_tree(qfz.tree, [&qfz](index_t n) { return qfz.altitudes(n) < 2; }, true);
+            REQUIRE(num_leaves(simplified.tree) <= num_leaves(qfz.tree));
+            REQUIRE(w.cached_bytes() > 0);
+        }
+    }
+}
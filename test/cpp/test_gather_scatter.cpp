@@ -0,0 +1,70 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/array.hpp"
+#include "test_utils.hpp"
+#include "xtensor/xrandom.hpp"
+#include "xtensor/xindex_view.hpp"
+
+namespace test_gather_scatter {
+
+    using namespace hg;
+
+    TEST_CASE("gather", "[gather_scatter]") {
+        array_1d<double> values{1.5, 2.5, 3.5, 4.5};
+        array_1d<index_t> indices{3, 0, 0, 2, 1};
+        array_1d<double> ref{4.5, 1.5, 1.5, 3.5, 2.5};
+        REQUIRE((gather(values, indices) == ref));
+
+        // non contiguous expressions
+        auto strided_values = xt::view(array_1d<double>{1.5, 0, 2.5, 0, 3.5, 0, 4.5}, xt::range(0, 7, 2));
+        REQUIRE((gather(strided_values, indices) == ref));
+        REQUIRE((gather(values, xt::view(indices, xt::range(1, 4))) == array_1d<double>{1.5, 1.5, 3.5}));
+        REQUIRE((gather(values * 2, indices) == ref * 2));
+
+        // conversion of the result
+        array_1d<int> result = array_1d<int>::from_shape({5});
+        gather(array_1d<int64_t>{10, 20, 30, 40}, indices, result.data());
+        REQUIRE((result == array_1d<int>{40, 10, 10, 30, 20}));
+
+        REQUIRE(gather(values, array_1d<index_t>::from_shape({0})).size() == 0);
+    }
+
+    TEST_CASE("gather large", "[gather_scatter]") {
+        xt::random::seed(42);
+        array_1d<float> values = xt::random::rand<float>({100000});
+        array_1d<index_t> indices = xt::random::randint<index_t>({250000}, 0, 100000);
+        array_1d<float> ref = xt::index_view(values, indices);
+        REQUIRE((gather(values, indices) == ref));
+    }
+
+    TEST_CASE("scatter", "[gather_scatter]") {
+        array_1d<double> values{1.5, 2.5, 3.5};
+        array_1d<index_t> indices{3, 0, 2};
+        array_1d<double> result = xt::zeros<double>({5});
+        scatter(values, indices, result.data());
+        REQUIRE((result == array_1d<double>{2.5, 0, 3.5, 1.5, 0}));
+
+        array_1d<double> result2 = xt::zeros<double>({5});
+        scatter(xt::view(array_1d<double>{1.5, 0, 2.5, 0, 3.5}, xt::range(0, 5, 2)), indices, result2.data());
+        REQUIRE((result2 == array_1d<double>{2.5, 0, 3.5, 1.5, 0}));
+    }
+
+    TEST_CASE("scatter large", "[gather_scatter]") {
+        xt::random::seed(42);
+        const index_t size = 100000;
+        array_1d<index_t> permutation = xt::arange<index_t>(size);
+        xt::random::shuffle(permutation);
+        array_1d<double> values = xt::random::rand<double>({size});
+        array_1d<double> result = array_1d<double>::from_shape({(size_t) size});
+        scatter(values, permutation, result.data());
+        REQUIRE((gather(result, permutation) == values));
+    }
+}
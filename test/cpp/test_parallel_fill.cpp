@@ -0,0 +1,49 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/structure/array.hpp"
+#include "test_utils.hpp"
+
+namespace test_parallel_fill {
+
+    using namespace hg;
+
+    TEST_CASE("parallel fill", "[parallel_fill]") {
+        std::vector<int> small(10, 0);
+        parallel_fill(small.data() + 2, 5, 3);
+        REQUIRE((small == std::vector<int>{0, 0, 3, 3, 3, 3, 3, 0, 0, 0}));
+
+        // larger than the serial cutoff
+        const index_t size = 1000003;
+        std::vector<double> large(size, 0);
+        parallel_fill(large.data(), size, 2.5);
+        REQUIRE(std::all_of(large.begin(), large.end(), [](double v) { return v == 2.5; }));
+
+        parallel_fill(large.data(), 0, 1.0);
+        REQUIRE(large[0] == 2.5);
+    }
+
+    TEST_CASE("parallel full and zeros", "[parallel_fill]") {
+        auto a = parallel_full<array_1d<index_t>>({5}, 7);
+        REQUIRE((a == array_1d<index_t>{7, 7, 7, 7, 7}));
+
+        auto b = parallel_zeros<array_1d<double>>({(size_t) 1 << 18});
+        REQUIRE(b.size() == ((size_t) 1 << 18));
+        REQUIRE(xt::all(xt::equal(b, 0.0)));
+
+        std::vector<size_t> shape{300000, 2};
+        auto c = parallel_full<array_nd<float>>(shape, 1.5f);
+        REQUIRE((c.shape()[0] == 300000 && c.shape()[1] == 2));
+        REQUIRE(xt::all(xt::equal(c, 1.5f)));
+
+        auto d = parallel_zeros<array_nd<int>>(std::vector<size_t>{0, 3});
+        REQUIRE(d.size() == 0);
+    }
+}
@@ -0,0 +1,61 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+// compiled in the executable test_prebuilt_exe, linked with the prebuilt library (CMake option HG_BUILD_LIBRARY)
+
+#include "higra/image/graph_image.hpp"
+#include "higra/hierarchy/hierarchy_core.hpp"
+#include "higra/hierarchy/binary_partition_tree.hpp"
+#include "higra/hierarchy/component_tree.hpp"
+#include "test_utils.hpp"
+
+namespace test_prebuilt_library {
+
+    using namespace hg;
+
+    TEST_CASE("prebuilt bpt canonical and quasi flat zones", "[prebuilt]") {
+        auto graph = get_4_adjacency_graph({2, 3});
+
+        array_1d<float> edge_weights{1, 0, 2, 1, 1, 1, 2};
+        auto res = bpt_canonical(graph, edge_weights);
+        REQUIRE((res.tree.parents() == array_1d<index_t>{6, 7, 9, 6, 8, 9, 7, 8, 10, 10, 10}));
+        REQUIRE((res.altitudes == array_1d<float>{0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2}));
+
+        array_1d<uint8_t> edge_weights_8{1, 0, 2, 1, 1, 1, 2};
+        auto res_8 = bpt_canonical(graph, edge_weights_8);
+        REQUIRE((res_8.tree.parents() == res.tree.parents()));
+
+        auto qfz = quasi_flat_zone_hierarchy(graph, array_1d<double>{1, 0, 2, 1, 1, 1, 2});
+        REQUIRE((qfz.tree.parents() == array_1d<index_t>{6, 7, 8, 6, 7, 8, 7, 9, 9, 9}));
+        REQUIRE((qfz.altitudes == array_1d<double>{0, 0, 0, 0, 0, 0, 0, 1, 1, 2}));
+    }
+
+    TEST_CASE("prebuilt linkages", "[prebuilt]") {
+        auto graph = get_4_adjacency_graph({2, 3});
+        array_1d<double> edge_weights{1, 0, 2, 1, 1, 1, 2};
+
+        auto complete = binary_partition_tree_complete_linkage(graph, edge_weights);
+        REQUIRE(num_vertices(complete.tree) == 11);
+        REQUIRE(complete.altitudes(10) == 2);
+
+        auto average = binary_partition_tree_average_linkage(graph, edge_weights, array_1d<double>{1, 1, 1, 1, 1, 1, 1});
+        REQUIRE(num_vertices(average.tree) == 11);
+    }
+
+    TEST_CASE("prebuilt component trees", "[prebuilt]") {
+        auto graph = get_4_adjacency_implicit_graph({2, 3});
+        array_1d<uint8_t> vertex_weights{0, 1, 1, 0, 2, 1};
+
+        auto max_tree = component_tree_max_tree(graph, vertex_weights);
+        auto min_tree = component_tree_min_tree(graph, vertex_weights);
+        REQUIRE(max_tree.altitudes(root(max_tree.tree)) == 0);
+        REQUIRE(min_tree.altitudes(root(min_tree.tree)) == 2);
+    }
+}
@@ -10,6 +10,7 @@
 
 #include "higra/sorting.hpp"
 #include "test_utils.hpp"
+#include "xtensor/xrandom.hpp"
 
 namespace test_sorting {
 
@@ -72,4 +73,102 @@ namespace test_sorting {
         array_1d<int> ref2 = {4, 0, 1, 2, 3};
         REQUIRE((i2 == ref2));
     }
-}
\ No newline at end of file
+
+    template<typename value_t, typename comp_t>
+    void test_radix_stable_arg_sort(const array_1d<value_t> &a, comp_t comp) {
+        array_1d<index_t> ref = xt::arange<index_t>(a.size());
+        std::stable_sort(ref.begin(), ref.end(), [&a, &comp](index_t i, index_t j) { return comp(a(i), a(j)); });
+        auto res = hg::stable_arg_sort(a, comp);
+        REQUIRE((res == ref));
+    }
+
+    template<typename value_t>
+    void test_radix_stable_arg_sort(const array_1d<value_t> &a) {
+        test_radix_stable_arg_sort(a, std::less<value_t>());
+        test_radix_stable_arg_sort(a, std::greater<value_t>());
+    }
+
+    TEST_CASE("stable arg sort radix integral", "[sorting]") {
+        xt::random::seed(42);
+        for (size_t size: {100, 5000, 100000}) {
+            test_radix_stable_arg_sort<uint8_t>(xt::random::randint<int>({size}, 0, 256));
+            test_radix_stable_arg_sort<int8_t>(xt::random::randint<int>({size}, -128, 128));
+            test_radix_stable_arg_sort<uint16_t>(xt::random::randint<int>({size}, 0, 65536));
+            test_radix_stable_arg_sort<int16_t>(xt::random::randint<int>({size}, -32768, 32768));
+            test_radix_stable_arg_sort<uint16_t>(xt::random::randint<int>({size}, 10, 20));
+            test_radix_stable_arg_sort<int32_t>(xt::random::randint<int>({size}, -1000000, 1000000));
+            test_radix_stable_arg_sort<uint32_t>(xt::random::randint<uint32_t>({size}, 0, 4000000000u));
+            test_radix_stable_arg_sort<int64_t>(xt::random::randint<int64_t>({size}, -10000000000, 10000000000));
+            test_radix_stable_arg_sort<uint64_t>(xt::random::randint<uint64_t>({size}, 0, 20));
+        }
+    }
+
+    TEST_CASE("stable arg sort radix floating point", "[sorting]") {
+        xt::random::seed(42);
+        for (size_t size: {100, 5000, 100000}) {
+            array_1d<float> af = xt::random::randn<float>({size});
+            test_radix_stable_arg_sort(af);
+            array_1d<float> aq = xt::round(xt::random::randn<float>({size}) * 3);
+            test_radix_stable_arg_sort(aq);
+            array_1d<double> ad = xt::random::randn<double>({size}) * 1e10;
+            test_radix_stable_arg_sort(ad);
+        }
+
+        array_1d<float> zeros{0.f, -0.f, 1.f, -0.f, 0.f, -1.f};
+        zeros = xt::concatenate(xt::xtuple(zeros, zeros, zeros, zeros, zeros, zeros, zeros, zeros, zeros, zeros, zeros,
+                                           zeros));
+        test_radix_stable_arg_sort(zeros);
+    }
+
+    TEST_CASE("stable arg sort runs", "[sorting]") {
+        array_1d<int> a{3, 5, 5, 1, 2, 5, 0, 7, 2, 2, 2};
+        REQUIRE(count_sorted_runs(a) == 4);
+        REQUIRE(count_sorted_runs(array_1d<int>{}) == 0);
+        REQUIRE(count_sorted_runs(array_1d<int>{1, 1, 2}) == 1);
+
+        array_1d<index_t> ref = stable_arg_sort(a);
+        REQUIRE((stable_arg_sort_runs(a) == ref));
+        array_1d<index_t> ref2 = stable_arg_sort(a, std::greater<int>());
+        REQUIRE((stable_arg_sort_runs(a, std::greater<int>()) == ref2));
+        REQUIRE((stable_arg_sort_runs(array_1d<int>{}).size() == 0));
+
+        xt::random::seed(42);
+        for (index_t num_runs: {1, 2, 3, 7, 16}) {
+            array_1d<int> b = xt::random::randint<int>({(size_t) 10000}, 0, 100);
+            index_t run_size = 10000 / num_runs;
+            for (index_t r = 0; r < num_runs; r++) {
+                std::sort(b.begin() + r * run_size, (r == num_runs - 1) ? b.end() : b.begin() + (r + 1) * run_size);
+            }
+            REQUIRE(count_sorted_runs(b) <= num_runs);
+            array_1d<index_t> refb = stable_arg_sort(b);
+            REQUIRE((stable_arg_sort_runs(b) == refb));
+        }
+    }
+
+    TEST_CASE("stable arg sort warm start", "[sorting]") {
+        array_1d<int> a{3, 5, 5, 1, 2, 5, 0, 7, 2, 2, 2};
+        array_1d<index_t> ref = stable_arg_sort(a);
+        REQUIRE((stable_arg_sort_warm_start(a, ref) == ref));
+        REQUIRE((stable_arg_sort_warm_start(a, array_1d<index_t>{}) == ref));
+        array_1d<index_t> identity = xt::arange<index_t>(a.size());
+        REQUIRE((stable_arg_sort_warm_start(a, identity, std::less<int>(), 1) == ref));
+        array_1d<index_t> ref2 = stable_arg_sort(a, std::greater<int>());
+        REQUIRE((stable_arg_sort_warm_start(a, ref, std::greater<int>(), 1) == ref2));
+        REQUIRE_THROWS(stable_arg_sort_warm_start(a, array_1d<index_t>{0, 1}));
+
+        xt::random::seed(42);
+        const size_t size = 10000;
+        array_1d<float> b = xt::round(xt::random::rand<float>({size}) * 1000);
+        array_1d<index_t> order = stable_arg_sort(b);
+        for (double ratio: {0.001, 0.01, 0.1, 0.5}) {
+            // perturbation of a fraction of the values
+            array_1d<float> c = b;
+            for (index_t i = 0; i < (index_t) (ratio * size); i++) {
+                c(xt::random::randint<index_t>({1}, 0, size)(0)) += xt::random::randn<float>({1})(0) * 20;
+            }
+            array_1d<index_t> refc = stable_arg_sort(c);
+            REQUIRE((stable_arg_sort_warm_start(c, order) == refc));
+            REQUIRE((stable_arg_sort_warm_start(c, order, std::less<float>(), 1) == refc));
+        }
+    }
+}
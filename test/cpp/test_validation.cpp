@@ -0,0 +1,45 @@
+/***************************************************************************
+* Copyright ESIEE Paris (2018)                                             *
+*                                                                          *
+* Contributor(s) : Benjamin Perret                                         *
+*                                                                          *
+* Distributed under the terms of the CECILL-B License.                     *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "higra/graph.hpp"
+#include "test_utils.hpp"
+
+namespace test_validation {
+
+    using namespace hg;
+
+    TEST_CASE("validation levels", "[validation]") {
+        ugraph g(3);
+        add_edge(0, 1, g);
+        array_1d<index_t> invalid_vertices{0, 5};
+        array_1d<index_t> invalid_edges{-1};
+        array_1d<double> invalid_edge_weights{1, 2};
+
+        REQUIRE(get_validation_level() == validation_level::full);
+        REQUIRE(is_content_validation_enabled());
+        REQUIRE_THROWS([&] { hg_assert_vertex_indices(g, invalid_vertices); }());
+        REQUIRE_THROWS([&] { hg_assert_edge_indices(g, invalid_edges); }());
+        REQUIRE_THROWS([&] { hg_assert_edge_weights(g, invalid_edge_weights); }());
+
+        set_validation_level(validation_level::shape);
+        REQUIRE(get_validation_level() == validation_level::shape);
+        REQUIRE(!is_content_validation_enabled());
+        // content checks are skipped, shape checks are still done
+        REQUIRE_NOTHROW([&] { hg_assert_vertex_indices(g, invalid_vertices); }());
+        REQUIRE_NOTHROW([&] { hg_assert_edge_indices(g, invalid_edges); }());
+        REQUIRE_THROWS([&] { hg_assert_edge_weights(g, invalid_edge_weights); }());
+        REQUIRE_THROWS([&] { hg_assert_vertex_index(g, 5); }());
+        // hg_assert does not depend on the validation level
+        REQUIRE_THROWS([&] { hg_assert(false, "always checked"); }());
+
+        set_validation_level(validation_level::full);
+        REQUIRE_THROWS([&] { hg_assert_vertex_indices(g, invalid_vertices); }());
+    }
+}
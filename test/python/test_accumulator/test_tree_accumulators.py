@@ -61,6 +61,11 @@ class TestTreeAccumulators(unittest.TestCase):
         ref = np.asarray((-1, -1, -1, -1, -1, 1, 2, 1))
         self.assertTrue(np.allclose(ref, res))
 
+        leaf_data = np.asarray((1, 3, 2, 4, 6), dtype=np.float64)
+        res = hg.accumulate_sequential(tree, leaf_data, hg.Accumulators.variance)
+        ref = np.asarray((0, 0, 0, 0, 0, 1, 8 / 3, 2.96))
+        self.assertTrue(np.allclose(ref, res))
+
     def test_tree_accumulatorVec(self):
         tree = TestTreeAccumulators.get_tree()
         input_array = np.asarray(((1, 0),
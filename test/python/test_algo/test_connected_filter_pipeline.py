@@ -0,0 +1,47 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+
+class TestConnectedFilterPipeline(unittest.TestCase):
+
+    def test_connected_filter_pipeline(self):
+        np.random.seed(42)
+        graph = hg.get_4_adjacency_implicit_graph((20, 15))
+        image = np.random.randint(0, 30, (20, 15))
+
+        for tree_type, component_tree in (("max_tree", hg.component_tree_max_tree),
+                                          ("min_tree", hg.component_tree_min_tree)):
+            tree, altitudes = component_tree(graph, image)
+            area = hg.attribute_area(tree)
+            volume = hg.attribute_volume(tree, altitudes, area)
+            deleted = np.logical_or(area < 20, volume <= 50)
+            deleted[tree.root()] = False
+            expected = hg.reconstruct_leaf_data(tree, altitudes, deleted)
+
+            pipeline = hg.ConnectedFilterPipeline(tree_type).remove_if("area", "<", 20).remove_if("volume", "<=", 50)
+            res = pipeline(graph, image)
+            self.assertTrue(res.shape == image.shape)
+            self.assertTrue(np.all(res == expected))
+
+            # a pipeline can be applied several times
+            self.assertTrue(np.all(pipeline(graph, image) == expected))
+
+    def test_connected_filter_pipeline_no_clause(self):
+        graph = hg.get_4_adjacency_graph((4, 5))
+        image = np.arange(20).reshape((4, 5))
+        self.assertTrue(np.all(hg.ConnectedFilterPipeline()(graph, image) == image))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -171,6 +171,44 @@ class TestAlgorithmGraphCore(unittest.TestCase):
         with self.assertRaises(ValueError):
             hg.adjacency_matrix_2_undirected_graph(ref_adj_mat, non_edge_value=-1)
 
+    def test_adjacency_matrix_2_undirected_graph_sparse_csr(self):
+        np.random.seed(42)
+        dense = np.random.randint(0, 4, (30, 30)) * (np.random.rand(30, 30) < 0.3)
+        dense = np.triu(dense)
+        dense = dense + dense.T
+        graph, edge_weights = hg.adjacency_matrix_2_undirected_graph(sp.csr_matrix(dense))
+        ref_graph, ref_edge_weights = hg.adjacency_matrix_2_undirected_graph(dense)
+        self.assertTrue(np.all(graph.edge_list()[0] == ref_graph.edge_list()[0]))
+        self.assertTrue(np.all(graph.edge_list()[1] == ref_graph.edge_list()[1]))
+        self.assertTrue(np.all(edge_weights == ref_edge_weights))
+        for v in range(graph.num_vertices()):
+            self.assertTrue(list(graph.out_edges(v)) == list(ref_graph.out_edges(v)))
+
+        # non canonical matrix: duplicate entries and explicit zeros
+        A = sp.csr_matrix((np.asarray((1, 2, 0, 3, 3)), np.asarray((1, 1, 2, 0, 0)), np.asarray((0, 3, 5, 5))),
+                          shape=(3, 3))
+        graph, edge_weights = hg.adjacency_matrix_2_undirected_graph(A)
+        self.assertTrue(graph.num_edges() == 1)
+        self.assertTrue(edge_weights[0] == 3)
+
+        A = sp.coo_matrix(dense)
+        graph, edge_weights = hg.adjacency_matrix_2_undirected_graph(A)
+        self.assertTrue(np.all(edge_weights == ref_edge_weights))
+
+    def test_undirected_graph_2_adjacency_matrix_sparse_csr(self):
+        graph = hg.get_4_adjacency_graph((5, 6))
+        graph.add_edge(3, 3)
+        edge_weights = np.arange(1, graph.num_edges() + 1)
+        A = hg.undirected_graph_2_adjacency_matrix(graph, edge_weights)
+        self.assertTrue(sp.isspmatrix_csr(A))
+        self.assertTrue(A[3, 3] == edge_weights[-1])
+        ref_A = hg.undirected_graph_2_adjacency_matrix(graph, edge_weights, sparse=False)
+        self.assertTrue(np.all(A.toarray() == ref_A))
+
+        graph2, edge_weights2 = hg.adjacency_matrix_2_undirected_graph(A)
+        self.assertTrue(graph2.num_edges() == graph.num_edges())
+        self.assertTrue(np.all(hg.undirected_graph_2_adjacency_matrix(graph2, edge_weights2, sparse=False) == ref_A))
+
     def ultrametric_open(self):
         graph = hg.get_4_adjacency_graph((3, 3))
         edge_weights = np.asarray((2, 3, 9, 5, 10, 1, 5, 8, 2, 2, 4, 3), dtype=np.int32)
@@ -252,6 +290,23 @@ class TestAlgorithmGraphCore(unittest.TestCase):
 
         self.assertTrue(TestAlgorithmGraphCore.graph_equal(g, ew, g_ref, w_ref))
 
+    def test_approximate_knn_graph(self):
+        np.random.seed(1)
+        X = np.random.rand(300, 5)
+        g, ew = hg.approximate_knn_graph(X, n_neighbors=10)
+        self.assertTrue(g.num_vertices() == 300)
+
+        sources, targets = g.edge_list()
+        self.assertTrue(np.allclose(ew, np.linalg.norm(X[sources] - X[targets], axis=1)))
+
+        g_ref, _ = hg.make_graph_from_points(X, graph_type="knn", symmetrization="max", n_neighbors=10)
+        edges = set(zip(*np.sort(np.stack(g.edge_list()), axis=0)))
+        edges_ref = set(zip(*np.sort(np.stack(g_ref.edge_list()), axis=0)))
+        self.assertTrue(len(edges & edges_ref) > 0.95 * len(edges_ref))
+
+        g2, ew2 = hg.make_graph_from_points(X.astype(np.float32), graph_type="approximate_knn", n_neighbors=10)
+        self.assertTrue(ew2.dtype == np.float32)
+
     def test_make_graph_from_points_knn_and_mst(self):
         X = np.asarray(((0, 0), (0, 1), (1, 0), (0, 3), (0, 4), (1, 3), (2, 3)))
         sqrt2 = np.sqrt(2)
@@ -12,6 +12,7 @@ import unittest
 import higra as hg
 import numpy as np
 import math
+import ctypes
 
 
 class TestGraphWeights(unittest.TestCase):
@@ -73,6 +74,60 @@ class TestGraphWeights(unittest.TestCase):
         r = hg.weight_graph(g, data, hg.WeightFunction.L2_squared)
         self.assertTrue(np.allclose(ref, r))
 
+    def test_weighting_graph_preserve_dtype(self):
+        g = hg.get_4_adjacency_graph((2, 2))
+        data = np.asarray((0, 250, 2, 3), dtype=np.uint8)
+
+        r = hg.weight_graph(g, data, hg.WeightFunction.L1, preserve_dtype=True)
+        self.assertTrue(r.dtype == np.uint8)
+        self.assertTrue(np.all(r == (250, 2, 247, 1)))
+
+        r = hg.weight_graph(g, data, hg.WeightFunction.max, preserve_dtype=True)
+        self.assertTrue(r.dtype == np.uint8)
+        self.assertTrue(np.all(r == (250, 2, 250, 3)))
+
+        with self.assertRaises(Exception):
+            hg.weight_graph(g, data, hg.WeightFunction.mean, preserve_dtype=True)
+
+        data = np.asarray(((0, 1), (250, 2), (2, 9), (3, 4)), dtype=np.uint8)
+        r = hg.weight_graph(g, data, hg.WeightFunction.L_infinity, preserve_dtype=True)
+        self.assertTrue(r.dtype == np.uint8)
+        self.assertTrue(np.all(r == (250, 8, 247, 5)))
+
+        with self.assertRaises(Exception):
+            hg.weight_graph(g, data, hg.WeightFunction.L1, preserve_dtype=True)
+
+    def test_weighting_graph_cosine_chi_square(self):
+        g = hg.get_4_adjacency_graph((2, 2))
+        data = np.asarray(((1, 0), (1, 1), (0, 0), (0, 2)), dtype=np.float64)
+
+        r = hg.weight_graph(g, data, hg.WeightFunction.cosine)
+        self.assertTrue(np.allclose(r, (1 - 1 / math.sqrt(2), 1, 1 - 1 / math.sqrt(2), 1)))
+
+        r = hg.weight_graph(g, data, hg.WeightFunction.chi_square)
+        self.assertTrue(np.allclose(r, (1, 1, 4 / 3, 2)))
+
+    def test_weighting_graph_compiled_kernel(self):
+        g = hg.get_4_adjacency_graph((2, 2))
+        data = np.asarray(((0, 1), (2, 3), (4, 5), (6, 7)), dtype=np.int32)
+
+        @hg.weight_kernel_ctypes_prototype()
+        def l1(a, b, num_channels, user_data):
+            return sum(abs(a[k] - b[k]) for k in range(num_channels))
+
+        r = hg.weight_graph(g, data, l1)
+        self.assertTrue(r.dtype == np.float64)
+        self.assertTrue(np.all(r == hg.weight_graph(g, data, hg.WeightFunction.L1)))
+
+        offset = np.asarray((10,), dtype=np.float64)
+
+        @hg.weight_kernel_ctypes_prototype()
+        def product(a, b, num_channels, user_data):
+            return a[0] * b[0] + ctypes.cast(user_data, ctypes.POINTER(ctypes.c_double))[0]
+
+        r = hg.weight_graph(g, data, product, user_data=offset)
+        self.assertTrue(np.all(r == (10, 10, 22, 34)))
+
 
 if __name__ == '__main__':
     unittest.main()
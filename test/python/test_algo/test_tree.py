@@ -251,6 +251,64 @@ class TestAlgorithmTree(unittest.TestCase):
 
         self.assertTrue(np.all(labelisation == ref_labelisation))
 
+    def test_binary_labelisation_from_markers_packed(self):
+        tree = hg.Tree(np.asarray((9, 9, 9, 10, 10, 12, 13, 11, 11, 14, 12, 15, 13, 14, 15, 15)))
+        object_marker = np.asarray((0, 1, 0, 1, 0, 0, 0, 0, 0), dtype=np.int8)
+        background_marker = np.asarray((1, 0, 0, 0, 0, 0, 1, 0, 0), dtype=np.int8)
+
+        packed = hg.binary_labelisation_from_markers(tree, object_marker, background_marker, packed=True)
+        self.assertTrue(packed.dtype == np.uint8)
+        self.assertTrue(np.all(packed == (58, 0)))
+
+        ref_labelisation = np.asarray((0, 1, 0, 1, 1, 1, 0, 0, 0), dtype=np.int8)
+        self.assertTrue(np.all(hg.unpack_binary_labelisation(packed, tree.num_leaves()) == ref_labelisation))
+
+        labels = np.random.randint(0, 2, size=(1001,))
+        packed = np.packbits(labels, bitorder='little')
+        self.assertTrue(np.all(hg.unpack_binary_labelisation(packed, 1001) == labels))
+
+    def test_incremental_binary_labelisation(self):
+        tree = hg.Tree(np.asarray((9, 9, 9, 10, 10, 12, 13, 11, 11, 14, 12, 15, 13, 14, 15, 15)))
+        labelisation = hg.IncrementalBinaryLabelisation(tree)
+        labelisation.add_object_markers(np.asarray((1, 3)))
+        labelisation.add_background_markers(np.asarray((0, 6)))
+
+        self.assertTrue(np.all(labelisation.object_nodes() == (1, 12)))
+        self.assertTrue(np.all(labelisation.labelisation() == (0, 1, 0, 1, 1, 1, 0, 0, 0)))
+
+        labelisation.remove_background_markers(np.asarray((6,)))
+        self.assertTrue(np.all(labelisation.object_nodes() == (1, 13)))
+        self.assertTrue(np.all(labelisation.labelisation() == (0, 1, 0, 1, 1, 1, 1, 0, 0)))
+
+        labelisation.add_background_markers(np.asarray((3,)))
+        labelisation.remove_object_markers(np.asarray((1,)))
+        self.assertTrue(labelisation.object_nodes().size == 0)
+        self.assertTrue(labelisation.num_object_markers() == 1)
+        self.assertTrue(labelisation.num_background_markers() == 2)
+
+    def test_cut_stack(self):
+        tree = hg.Tree(np.asarray((5, 5, 6, 6, 6, 7, 7, 7)))
+        altitudes = np.asarray((0, 0, 0, 0, 0, 1, 0, 2), dtype=np.float64)
+        thresholds = (-1, 0, 0.5, 1, 2, 3)
+        labelisations = np.stack(
+            [hg.labelisation_horizontal_cut_from_threshold(tree, altitudes, t) for t in thresholds])
+
+        offsets, nodes = hg.encode_cut_stack(tree, labelisations)
+        self.assertTrue(np.all(offsets == (0, 5, 8, 11, 13, 14, 15)))
+        self.assertTrue(np.all(nodes == (0, 1, 2, 3, 4, 0, 1, 6, 0, 1, 6, 5, 6, 7, 7)))
+
+        offsets2, nodes2 = hg.cut_stack_from_thresholds(tree, altitudes, thresholds)
+        self.assertTrue(np.all(offsets2 == offsets))
+        self.assertTrue(np.all(nodes2 == nodes))
+
+        node_values = np.arange(1, tree.num_vertices() + 1)
+        for i in range(len(thresholds)):
+            cut_nodes = nodes[offsets[i]:offsets[i + 1]]
+            labels = hg.reconstruct_leaf_data(tree, np.arange(tree.num_vertices()), cut_nodes=cut_nodes)
+            self.assertTrue(np.all(labels == labelisations[i]))
+            leaf_values = hg.reconstruct_leaf_data(tree, node_values, cut_nodes=cut_nodes)
+            self.assertTrue(np.all(leaf_values == node_values[labelisations[i]]))
+
     def test_sort_hierarchy_with_altitudes(self):
         tree = hg.Tree(np.asarray((8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14)))
         altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 0, 3, 1, 2, 4, 6, 5, 7))
@@ -268,6 +326,43 @@ class TestAlgorithmTree(unittest.TestCase):
         with self.assertRaises(ValueError):
             hg.sort_hierarchy_with_altitudes(tree, altitudes)
 
+    def test_relayout_tree(self):
+        tree = hg.Tree(np.asarray((8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14)))
+        self.assertTrue(tree.layout() == hg.TreeLayout.Topological)
+
+        ntree, node_map = hg.relayout_tree(tree, hg.TreeLayout.PostOrder)
+        self.assertTrue(ntree.layout() == hg.TreeLayout.PostOrder)
+        self.assertTrue(np.all(ntree.parents() == (8, 8, 9, 9, 13, 12, 11, 11, 10, 10, 14, 12, 13, 14, 14)))
+        self.assertTrue(np.all(node_map == (0, 1, 2, 3, 7, 6, 4, 5, 8, 9, 12, 10, 11, 13, 14)))
+
+        altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 0, 3, 1, 2, 4, 6, 5, 7))
+        ntree, node_map = hg.relayout_tree(tree, hg.TreeLayout.AltitudeSorted, altitudes)
+        self.assertTrue(ntree.layout() == hg.TreeLayout.AltitudeSorted)
+        self.assertTrue(np.all(ntree.parents() == (10, 10, 8, 8, 9, 9, 11, 12, 13, 11, 13, 12, 14, 14, 14)))
+        self.assertTrue(np.all(altitudes[node_map] == (0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7)))
+
+        with self.assertRaises(ValueError):
+            hg.relayout_tree(tree, hg.TreeLayout.AltitudeSorted)
+
+    def test_tree_traversal_orders(self):
+        tree = hg.Tree(np.asarray((8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14)))
+
+        self.assertTrue(np.all(hg.tree_preorder(tree) == (14, 12, 8, 0, 1, 9, 2, 3, 13, 7, 11, 6, 10, 4, 5)))
+        self.assertTrue(np.all(hg.tree_postorder(tree) == (0, 1, 8, 2, 3, 9, 12, 7, 6, 4, 5, 10, 11, 13, 14)))
+
+        nodes, offsets = hg.tree_depth_levels(tree)
+        self.assertTrue(np.all(nodes == (14, 12, 13, 7, 8, 9, 11, 0, 1, 2, 3, 6, 10, 4, 5)))
+        self.assertTrue(np.all(offsets == (0, 1, 3, 7, 13, 15)))
+
+        # bottom-up traversal by levels
+        area = np.zeros(tree.num_vertices(), dtype=np.int64)
+        area[:tree.num_leaves()] = 1
+        parents = tree.parents()
+        for d in range(len(offsets) - 2, 0, -1):
+            level = nodes[offsets[d]:offsets[d + 1]]
+            np.add.at(area, parents[level], area[level])
+        self.assertTrue(np.all(area == hg.attribute_area(tree)))
+
     def test_test_altitudes_increasingness(self):
         tree = hg.Tree(np.asarray((5, 5, 6, 6, 7, 7, 7, 7)))
 
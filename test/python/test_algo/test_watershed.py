@@ -128,5 +128,33 @@ class TestWatershed(unittest.TestCase):
         self.assertTrue(np.all(labels == expected))
 
 
+    def test_seeded_watershed_batch(self):
+        g = hg.get_4_adjacency_graph((5, 6))
+        np.random.seed(1)
+        edge_weights = np.random.randint(0, 4, g.num_edges())
+        seeds = np.zeros((20, 5, 6), dtype=np.int32)
+        for i in range(20):
+            seeds[i].flat[np.random.randint(0, 30, 1 + i % 4)] = np.arange(1, 2 + i % 4)
+
+        labels = hg.labelisation_seeded_watershed_batch(g, edge_weights, seeds)
+        self.assertTrue(labels.shape == seeds.shape)
+        for i in range(20):
+            ref = hg.labelisation_seeded_watershed(g, edge_weights, seeds[i])
+            self.assertTrue(np.all(labels[i] == ref))
+
+    def test_exact_stochastic_watershed(self):
+        g = hg.get_4_adjacency_graph((1, 4))
+        edge_weights = np.asarray((1, 3, 2))
+
+        # 2 uniform seeds: an edge is a boundary if both regions merged by this edge contain a seed
+        probabilities = hg.exact_stochastic_watershed(g, edge_weights, 2)
+        self.assertTrue(np.allclose(probabilities, (2 / 16, 2 * 2 * 2 / 16, 2 / 16)))
+
+        ws = hg.BatchedSeededWatershed(g, edge_weights)
+        node_probabilities = ws.boundary_probabilities(2)
+        self.assertTrue(np.allclose(node_probabilities, (0, 0, 0, 0, 2 / 16, 2 / 16, 8 / 16)))
+        self.assertTrue(np.all(ws.mst_edge_map() == (0, 2, 1)))
+
+
 if __name__ == '__main__':
     unittest.main()
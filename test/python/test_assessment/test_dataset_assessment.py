@@ -0,0 +1,91 @@
+############################################################################
+# Copyright ESIEE Paris (2021)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+
+class TestDatasetAssessment(unittest.TestCase):
+
+    @staticmethod
+    def make_dataset(num_samples):
+        np.random.seed(3)
+        trees, altitudes, ground_truths = [], [], []
+        for i in range(num_samples):
+            shape = (5 + i % 3, 6 + i % 2)
+            graph = hg.get_4_adjacency_graph(shape)
+            tree, alt = hg.bpt_canonical(graph, np.random.randint(0, 10, graph.num_edges()))
+            trees.append(tree)
+            altitudes.append(alt)
+            if i % 2 == 0:
+                ground_truths.append(np.random.randint(0, 4, shape[0] * shape[1]))
+            else:
+                ground_truths.append(np.random.randint(0, 4, (2, shape[0] * shape[1])))
+        return trees, altitudes, ground_truths
+
+    def test_assess_dataset(self):
+        trees, altitudes, ground_truths = TestDatasetAssessment.make_dataset(7)
+        res = hg.assess_dataset(trees, altitudes, ground_truths, hg.PartitionMeasure.BCE, max_regions=20,
+                                compute_purity=True, max_samples_in_flight=2)
+        self.assertTrue(res.num_samples() == 7)
+        self.assertTrue(res.num_assessments() == 10)
+
+        k = 0
+        ref_curve = np.zeros(20)
+        for i in range(7):
+            for ground_truth in np.atleast_2d(ground_truths[i]):
+                ref = hg.assess_fragmentation_horizontal_cut(trees[i], altitudes[i], ground_truth,
+                                                             hg.PartitionMeasure.BCE, max_regions=20)
+                self.assertTrue(res.sample_indices()[k] == i)
+                self.assertTrue(np.isclose(res.optimal_scores()[k], np.max(ref.scores())))
+                self.assertTrue(res.numbers_of_regions_ground_truth()[k] == ref.num_regions_ground_truth())
+                self.assertTrue(np.isclose(res.purities()[k], hg.dendrogram_purity(trees[i], ground_truth)))
+                positions = np.searchsorted(ref.num_regions(), np.arange(1, 21), side="right") - 1
+                ref_curve += ref.scores()[positions]
+                k += 1
+
+        self.assertTrue(np.isclose(res.mean_optimal_score(), np.mean(res.optimal_scores())))
+        self.assertTrue(np.isclose(res.mean_purity(), np.mean(res.purities())))
+        curve = res.mean_fragmentation_curve()
+        self.assertTrue(np.all(curve.num_regions() == np.arange(1, 21)))
+        self.assertTrue(np.allclose(curve.scores(), ref_curve / k))
+
+    def test_incremental(self):
+        trees, altitudes, ground_truths = TestDatasetAssessment.make_dataset(6)
+        res1 = hg.assess_dataset(trees, altitudes, ground_truths, hg.PartitionMeasure.DHamming)
+        self.assertTrue(np.all(np.isnan(res1.purities())))
+
+        res2 = hg.DatasetAssesser(hg.PartitionMeasure.DHamming)
+        res2.add_samples(trees[:2], altitudes[:2], ground_truths[:2])
+        res2.add_samples(trees[2:], altitudes[2:], ground_truths[2:], max_samples_in_flight=1)
+        self.assertTrue(res2.num_samples() == 6)
+        self.assertTrue(np.all(res1.sample_indices() == res2.sample_indices()))
+        self.assertTrue(np.all(res1.optimal_scores() == res2.optimal_scores()))
+        self.assertTrue(np.all(res1.mean_fragmentation_curve().scores() == res2.mean_fragmentation_curve().scores()))
+
+    def test_rag(self):
+        graph = hg.get_4_adjacency_graph((2, 3))
+        labels = np.asarray((0, 0, 1, 2, 2, 1))
+        rag = hg.make_region_adjacency_graph_from_labelisation(graph, labels)
+        tree = hg.Tree((3, 3, 4, 4, 4))
+        hg.CptHierarchy.link(tree, rag)
+        altitudes = np.asarray((0, 0, 0, 1, 2))
+        ground_truth = np.asarray((0, 0, 1, 0, 0, 1))
+
+        res = hg.assess_dataset([tree], [altitudes], [ground_truth], hg.PartitionMeasure.DHamming, max_regions=10)
+        ref = hg.assess_fragmentation_horizontal_cut(tree, altitudes, ground_truth, hg.PartitionMeasure.DHamming,
+                                                     max_regions=10)
+        self.assertTrue(np.isclose(res.optimal_scores()[0], np.max(ref.scores())))
+        self.assertTrue(np.isclose(res.optimal_scores()[0], 1))
+
+
+if __name__ == '__main__':
+    unittest.main()
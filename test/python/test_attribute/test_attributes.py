@@ -322,6 +322,18 @@ class TestAttributes(unittest.TestCase):
         attribute = hg.attribute_mean_vertex_weights(tree, vertex_weights=leaf_data)
         self.assertTrue(np.allclose(ref_attribute, attribute))
 
+    def test_mean_vertex_weights_uint8(self):
+        tree, altitudes = TestAttributes.get_test_tree()
+
+        leaf_data = np.asarray((0, 1, 2, 3, 4, 5, 6, 7, 8), dtype=np.uint8) + 200
+        ref_attribute = np.asarray((0, 1, 2, 3, 4, 5, 6, 7, 8,
+                                    1. / 2, 7. / 2, 7. / 2, 13. / 2, 7.,
+                                    2., 29. / 7, 4.)) + 200
+
+        attribute = hg.attribute_mean_vertex_weights(tree, vertex_weights=leaf_data)
+        self.assertTrue(attribute.dtype == np.float64)
+        self.assertTrue(np.allclose(ref_attribute, attribute))
+
     def test_mean_vertex_weights_vectorial(self):
         tree, altitudes = TestAttributes.get_test_tree()
 
@@ -668,5 +680,27 @@ class TestAttributes(unittest.TestCase):
                0.1481, 0.2222, 0.16, 0.2222, 0.2756)
         self.assertTrue(np.allclose(res,ref,atol=0.0001))
 
+    def test_fused_tree_attributes(self):
+        tree, altitudes = TestAttributes.get_test_tree()
+        leaf_data = np.asarray((0, 1, 2, 3, 4, 5, 6, 7, 8), dtype=np.float64)
+        leaf_data2 = np.asarray(((0, 1), (1, 0), (2, 2), (3, 1), (4, 4), (5, 0), (6, 6), (7, 2), (8, 1)),
+                                dtype=np.float64)
+
+        area, volume, depth, extrema, mean, max_data, sum_data2 = hg.fused_tree_attributes(
+            tree,
+            ("area", "volume", "depth", "extrema", "mean_vertex_weights",
+             (leaf_data, hg.Accumulators.max), (leaf_data2, hg.Accumulators.sum)),
+            altitudes=altitudes,
+            vertex_weights=leaf_data)
+
+        self.assertTrue(np.allclose(area, hg.attribute_area(tree)))
+        self.assertTrue(np.allclose(volume, hg.attribute_volume(tree, altitudes)))
+        self.assertTrue(np.all(depth == hg.attribute_depth(tree)))
+        self.assertTrue(np.all(extrema == hg.attribute_extrema(tree, altitudes)))
+        self.assertTrue(np.allclose(mean, hg.attribute_mean_vertex_weights(tree, leaf_data)))
+        self.assertTrue(np.allclose(max_data, hg.accumulate_sequential(tree, leaf_data, hg.Accumulators.max)))
+        self.assertTrue(np.allclose(sum_data2, hg.accumulate_sequential(tree, leaf_data2, hg.Accumulators.sum)))
+
+
 if __name__ == '__main__':
     unittest.main()
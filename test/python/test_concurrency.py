@@ -0,0 +1,195 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import asyncio
+import concurrent.futures
+import threading
+import numpy as np
+import higra as hg
+
+
+class TestConcurrency(unittest.TestCase):
+    """
+    The heavy bindings release the GIL: calls from concurrent Python threads must give the same results as
+    sequential calls.
+    """
+
+    num_tasks = 32
+    num_threads = 8
+
+    @staticmethod
+    def make_input(seed):
+        np.random.seed(seed)
+        graph = hg.get_4_adjacency_graph((40, 50))
+        edge_weights = np.random.rand(graph.num_edges())
+        return graph, edge_weights
+
+    @staticmethod
+    def process(graph, edge_weights):
+        tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+        wtree, waltitudes = hg.watershed_hierarchy_by_area(graph, edge_weights)
+        area = hg.attribute_area(wtree)
+        height = hg.attribute_height(tree, altitudes)
+        mean = hg.accumulate_sequential(tree, np.arange(tree.num_leaves(), dtype=np.float64), hg.Accumulators.mean)
+        cost = hg.dasgupta_cost(tree, edge_weights + 1, graph)
+        return tree.parents(), altitudes, wtree.parents(), waltitudes, area, height, mean, cost
+
+    def run_concurrently(self, shared_input):
+        if shared_input:
+            inputs = [TestConcurrency.make_input(0)] * self.num_tasks
+        else:
+            inputs = [TestConcurrency.make_input(i) for i in range(self.num_tasks)]
+        expected = [TestConcurrency.process(*args) for args in inputs]
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.num_threads) as executor:
+            futures = [executor.submit(TestConcurrency.process, *args) for args in inputs]
+            results = [f.result() for f in futures]
+
+        for res, ref in zip(results, expected):
+            for r, e in zip(res, ref):
+                self.assertTrue(np.all(r == e))
+
+    def test_concurrent_calls(self):
+        self.run_concurrently(shared_input=False)
+
+    def test_concurrent_calls_shared_input(self):
+        self.run_concurrently(shared_input=True)
+
+    def test_concurrent_calls_shared_tree(self):
+        graph, edge_weights = TestConcurrency.make_input(1)
+        ref_tree, ref_altitudes = hg.bpt_canonical(graph, edge_weights)
+        expected = hg.attribute_extinction_value(ref_tree, ref_altitudes, hg.attribute_area(ref_tree), "increasing")
+
+        tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+        # the children of the shared tree are computed lazily by the first thread that needs them
+        tree.clear_children()
+
+        def task(_):
+            area = hg.attribute_area(tree)
+            return hg.attribute_extinction_value(tree, altitudes, area, "increasing")
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.num_threads) as executor:
+            results = list(executor.map(task, range(self.num_tasks)))
+
+        for res in results:
+            self.assertTrue(np.all(res == expected))
+
+    def test_concurrent_lazy_attributes_shared_tree(self):
+        graph, edge_weights = TestConcurrency.make_input(2)
+        tree, altitudes = hg.bpt_canonical(graph, edge_weights)
+        vertices1 = np.arange(tree.num_vertices())
+        vertices2 = vertices1[::-1].copy()
+        expected = tree._lowest_common_ancestor(vertices1, vertices2)
+        barrier = threading.Barrier(self.num_threads)
+
+        def task(_):
+            barrier.wait()
+            lca = tree.lowest_common_ancestor_preprocess()
+            leaf_ranges = tree.leaf_ranges_preprocess()
+            area = hg.attribute_area(tree)
+            return lca, leaf_ranges, area, tree.lowest_common_ancestor(vertices1, vertices2)
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.num_threads) as executor:
+            results = list(executor.map(task, range(self.num_threads)))
+
+        # each lazy structure has been computed once and is shared by all the threads
+        for lca, leaf_ranges, area, res in results:
+            self.assertTrue(lca is results[0][0])
+            self.assertTrue(leaf_ranges is results[0][1])
+            self.assertTrue(area is results[0][2])
+            self.assertTrue(np.all(res == expected))
+
+    def test_get_or_compute_attribute(self):
+        class Obj:
+            pass
+
+        obj = Obj()
+        count = [0]
+        barrier = threading.Barrier(self.num_threads)
+
+        def compute():
+            count[0] += 1
+            return count[0]
+
+        def task(_):
+            barrier.wait()
+            return hg.get_or_compute_attribute(obj, "value", compute)
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.num_threads) as executor:
+            results = list(executor.map(task, range(self.num_threads)))
+
+        self.assertTrue(count[0] == 1)
+        self.assertTrue(all(r == 1 for r in results))
+        self.assertTrue(hg.get_attribute(obj, "value") == 1)
+        self.assertTrue(hg.get_or_compute_attribute(obj, "value", compute, force_recompute=True) == 2)
+
+    def test_submit_async(self):
+        graph, edge_weights = TestConcurrency.make_input(1)
+        ref_tree, ref_altitudes = hg.bpt_canonical(graph, edge_weights)
+
+        future = hg.submit_async(hg.bpt_canonical, graph, edge_weights)
+        tree, altitudes = future.result()
+        self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+        self.assertTrue(np.all(altitudes == ref_altitudes))
+
+        def fail():
+            raise ValueError("error")
+
+        with self.assertRaises(ValueError):
+            hg.submit_async(fail).result()
+
+    def test_cancellation_scope(self):
+        graph, edge_weights = TestConcurrency.make_input(1)
+        token = hg.CancellationToken()
+        token.cancel()
+        with hg.cancellation_scope(token):
+            with self.assertRaises(hg.OperationCancelled):
+                hg.bpt_canonical(graph, edge_weights)
+        # the token is uninstalled at the end of the block
+        hg.bpt_canonical(graph, edge_weights)
+
+        token.reset()
+        self.assertFalse(token.cancelled())
+        with hg.cancellation_scope(token):
+            hg.bpt_canonical(graph, edge_weights)
+
+    def test_submit_async_cancel_running(self):
+        graph, edge_weights = TestConcurrency.make_input(1)
+        started = threading.Event()
+        resume = threading.Event()
+
+        def task():
+            started.set()
+            resume.wait()
+            return hg.bpt_canonical(graph, edge_weights)
+
+        future = hg.submit_async(task)
+        started.wait()
+        # a running computation can only be stopped at a cancellation point
+        self.assertFalse(future.cancel())
+        resume.set()
+        with self.assertRaises(concurrent.futures.CancelledError):
+            future.result()
+
+    def test_run_async(self):
+        graph, edge_weights = TestConcurrency.make_input(1)
+        ref_tree, ref_altitudes = hg.bpt_canonical(graph, edge_weights)
+
+        async def main():
+            return await hg.run_async(hg.bpt_canonical, graph, edge_weights)
+
+        tree, altitudes = asyncio.run(main())
+        self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+        self.assertTrue(np.all(altitudes == ref_altitudes))
+
+
+if __name__ == '__main__':
+    unittest.main()
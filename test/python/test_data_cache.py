@@ -9,6 +9,8 @@
 ############################################################################
 
 import unittest
+import tempfile
+import numpy as np
 import higra as hg
 
 
@@ -84,6 +86,21 @@ def default_attr(o, v=1):
     return 4
 
 
+@hg.auto_cache
+def ordered_attr(o, a, b):
+    return a - b
+
+
+num_calls_persistent_attr = 0
+
+
+@hg.auto_cache
+def persistent_attr(tree, values, scale=1):
+    global num_calls_persistent_attr
+    num_calls_persistent_attr += 1
+    return hg.accumulate_sequential(tree, values, hg.Accumulators.sum) * scale
+
+
 class TestDataCache(unittest.TestCase):
 
     def test_auto_cache_and_force_recompute(self):
@@ -245,6 +262,81 @@ class TestDataCache(unittest.TestCase):
         self.assertTrue(default_attr(obj1, 1) == 4)
         self.assertRaises(Exception, default_attr, obj1, 1, force_recompute=True)
 
+    def test_auto_cache_parameter_order(self):
+        obj1 = Dummy(1)
+        self.assertTrue(ordered_attr(obj1, 1, 2) == -1)
+        self.assertTrue(ordered_attr(obj1, 2, 1) == 1)
+        self.assertTrue(ordered_attr(obj1, b=1, a=2) == 1)
+        self.assertTrue(ordered_attr(o=obj1, b=2, a=1) == -1)
+        hg.clear_all_attributes()
+
+    def test_persistent_cache(self):
+        global num_calls_persistent_attr
+        with tempfile.TemporaryDirectory() as directory:
+            hg.set_persistent_cache(directory)
+            try:
+                values = np.asarray((1, 2, 3, 4, 5), dtype=np.float64)
+                num_calls_persistent_attr = 0
+                r1 = persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values)
+                self.assertTrue(num_calls_persistent_attr == 1)
+
+                # new objects with the same content: the result comes from the persistent cache
+                r2 = persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values.copy())
+                self.assertTrue(num_calls_persistent_attr == 1)
+                self.assertTrue(np.all(r1 == r2))
+                self.assertTrue(r1.dtype == r2.dtype)
+
+                # different content or arguments
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values, 2)
+                self.assertTrue(num_calls_persistent_attr == 2)
+                persistent_attr(hg.Tree((5, 5, 5, 6, 6, 7, 7, 7)), values)
+                self.assertTrue(num_calls_persistent_attr == 3)
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values + 1)
+                self.assertTrue(num_calls_persistent_attr == 4)
+
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values, force_recompute=True)
+                self.assertTrue(num_calls_persistent_attr == 5)
+
+                hg.get_persistent_cache().clear()
+                self.assertTrue(hg.get_persistent_cache().size() == 0)
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values)
+                self.assertTrue(num_calls_persistent_attr == 6)
+            finally:
+                hg.set_persistent_cache(None)
+                hg.clear_all_attributes()
+
+    def test_persistent_cache_eviction(self):
+        global num_calls_persistent_attr
+        with tempfile.TemporaryDirectory() as directory:
+            cache = hg.set_persistent_cache(directory, max_size=1)
+            try:
+                values = np.asarray((1, 2, 3, 4, 5), dtype=np.float64)
+                num_calls_persistent_attr = 0
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values)
+                # the result is larger than the maximal size of the store: it is immediately evicted
+                self.assertTrue(cache.size() == 0)
+                persistent_attr(hg.Tree((5, 5, 6, 6, 6, 7, 7, 7)), values)
+                self.assertTrue(num_calls_persistent_attr == 2)
+            finally:
+                hg.set_persistent_cache(None)
+                hg.clear_all_attributes()
+
+    def test_persistent_cache_graph_attribute(self):
+        with tempfile.TemporaryDirectory() as directory:
+            hg.set_persistent_cache(directory)
+            try:
+                graph = hg.get_4_adjacency_graph((4, 5))
+                tree, altitudes = hg.bpt_canonical(graph, np.arange(graph.num_edges(), dtype=np.float64))
+                lca_map = hg.attribute_lca_map(tree, leaf_graph=graph)
+                self.assertTrue(hg.get_persistent_cache().size() > 0)
+
+                tree2 = hg.Tree(tree.parents().copy())
+                lca_map2 = hg.attribute_lca_map(tree2, leaf_graph=graph)
+                self.assertTrue(np.all(lca_map == lca_map2))
+            finally:
+                hg.set_persistent_cache(None)
+                hg.clear_all_attributes()
+
 
 if __name__ == '__main__':
     unittest.main()
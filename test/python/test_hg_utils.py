@@ -9,6 +9,11 @@
 ############################################################################
 
 import unittest
+import json
+import os
+import subprocess
+import sys
+import tempfile
 import higra as hg
 import numpy as np
 
@@ -155,6 +160,18 @@ class TestHGUtils(unittest.TestCase):
         self.assertTrue(hg.common_type(a_bool, a_uint16, a_int8, safety_level='overflow') == np.float64)
         self.assertTrue(hg.common_type(a_uint16, a_uint16, safety_level='overflow') == np.float64)
 
+    def test_linearize_delinearize_vertex_weights_no_copy(self):
+        g = hg.get_4_adjacency_graph((4, 5))
+        a = np.ones((4, 5, 3), dtype=np.uint8)
+
+        r = hg.linearize_vertex_weights(a, g, (4, 5))
+        self.assertTrue(r.shape == (20, 3))
+        self.assertTrue(np.shares_memory(r, a))
+
+        r2 = hg.delinearize_vertex_weights(r, g, (4, 5))
+        self.assertTrue(r2.shape == (4, 5, 3))
+        self.assertTrue(np.shares_memory(r2, a))
+
     def test_cast_to_common_type(self):
         a_uint16 = np.zeros((1, 1), dtype=np.uint16)
         a_int8 = np.zeros((1, 1), dtype=np.int8)
@@ -169,6 +186,8 @@ class TestHGUtils(unittest.TestCase):
 
         self.assertTrue(id(c) == id(a_int64))
 
+        self.assertTrue(hg.cast_to_dtype(a_int64, np.int64) is a_int64)
+
     def test_type_consistency(self):
         tree = hg.Tree((2, 2, 2))
         for t in (np.bool, np.int8, np.uint8, np.int16, np.uint16, np.int32, np.uint32, np.int64, np.uint64, np.float, np.double):
@@ -189,3 +208,107 @@ class TestHGUtils(unittest.TestCase):
 
         a.foo = lambda x: x
         self.assertTrue(hg.has_method(a, "foo"))
+
+    def test_profiler_and_trace_events(self):
+        hg.reset_profiler_stats()
+        hg.set_trace(True, events=True)
+        try:
+            g = hg.get_4_adjacency_graph((10, 10))
+            hg.watershed_hierarchy_by_area(g, np.random.rand(g.num_edges()))
+        finally:
+            hg.set_trace(False)
+
+        stats = hg.get_profiler_stats()
+        with tempfile.TemporaryDirectory() as directory:
+            filename = os.path.join(directory, "trace.json")
+            hg.save_trace_events(filename)
+            with open(filename) as f:
+                trace = json.load(f)
+
+        if hg.is_profiler_enabled():
+            self.assertTrue(any("bpt_canonical" in name for name in stats))
+            self.assertTrue(all(s["calls"] > 0 for s in stats.values()))
+            self.assertTrue(len(trace["traceEvents"]) > 0)
+            self.assertTrue(all(e["ph"] == "X" for e in trace["traceEvents"]))
+        else:
+            self.assertTrue(len(stats) == 0)
+            self.assertTrue(len(trace["traceEvents"]) == 0)
+        hg.reset_profiler_stats()
+
+    def test_profiler_counters(self):
+        hg.reset_profiler_stats()
+        g = hg.get_4_adjacency_graph((10, 10))
+        edge_weights = np.random.randint(0, 3, g.num_edges()).astype(np.float64)
+        hg.bpt_canonical(g, edge_weights)
+        hg.binary_partition_tree_average_linkage(g, edge_weights)
+        hg.labelisation_watershed(g, edge_weights)
+
+        counters = hg.get_profiler_counters()
+        if hg.is_profiler_enabled():
+            self.assertTrue(counters["union_find::find path length"]["samples"] > 0)
+            self.assertTrue(counters["binary_partition_tree heap pop"]["samples"] == g.num_vertices() - 1)
+            plateaus = counters["labelisation_watershed plateau size"]
+            self.assertTrue(plateaus["total"] >= g.num_vertices())
+            self.assertTrue(plateaus["max"] >= plateaus["mean"])
+        else:
+            self.assertTrue(len(counters) == 0)
+        hg.reset_profiler_stats()
+        if hg.is_profiler_enabled():
+            self.assertTrue(all(c["samples"] == 0 for c in hg.get_profiler_counters().values()))
+
+    def test_deterministic(self):
+        self.assertFalse(hg.is_deterministic())
+        indices = np.random.randint(0, 10, 300000)
+        weights = np.random.rand(300000)
+        with hg.deterministic():
+            self.assertTrue(hg.is_deterministic())
+            with hg.thread_limit(1):
+                ref = hg.accumulate_at(indices, weights, hg.Accumulators.sum)
+            res = hg.accumulate_at(indices, weights, hg.Accumulators.sum)
+            self.assertTrue(np.all(res == ref))
+        self.assertFalse(hg.is_deterministic())
+
+    def test_validation_level(self):
+        self.assertTrue(hg.get_validation_level() == "full")
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        invalid_vertices = np.asarray((0, 8), dtype=np.int64)
+        with self.assertRaises(RuntimeError):
+            tree.lowest_common_ancestor(invalid_vertices, invalid_vertices)
+        with hg.validation_level("shape"):
+            self.assertTrue(hg.get_validation_level() == "shape")
+            self.assertFalse(hg.cpp._is_content_validation_enabled())
+            vertices = np.asarray((0, 3), dtype=np.int64)
+            self.assertTrue(np.all(tree.lowest_common_ancestor(vertices, vertices) == (0, 3)))
+        self.assertTrue(hg.get_validation_level() == "full")
+        with self.assertRaises(RuntimeError):
+            hg.set_validation_level("none")
+
+    def test_lazy_modules(self):
+        # optional modules are only imported on first access to one of their members
+        code = "import sys; import higra as hg; " \
+               "assert 'higra.plot' not in sys.modules and 'higra.interop' not in sys.modules; " \
+               "hg.binary_hierarchy_to_scipy_linkage_matrix; " \
+               "assert 'higra.interop' in sys.modules; " \
+               "assert hg.plot.plot_partition_tree is hg.plot_partition_tree"
+        env = dict(os.environ)
+        env["PYTHONPATH"] = os.pathsep.join([os.path.dirname(os.path.dirname(hg.__file__))] + sys.path)
+        subprocess.check_call([sys.executable, "-c", code], env=env)
+
+        self.assertTrue(callable(hg.read_tree))
+        with self.assertRaises(AttributeError):
+            hg.this_attribute_does_not_exist
+        self.assertTrue("save_graph_pink" in dir(hg))
+
+    def test_simd_instruction_set(self):
+        self.assertTrue(hg.simd_instruction_set() in ("avx512f", "avx2", "sse4.2", "sse2", "neon", "generic"))
+
+    def test_thread_limit(self):
+        num_threads = hg.get_num_threads()
+        self.assertTrue(num_threads >= 1)
+        with hg.thread_limit(1):
+            self.assertTrue(hg.get_num_threads() == 1)
+            a = np.random.rand(100000)
+            b = a.copy()
+            hg.sort(b)
+            self.assertTrue(np.all(b == np.sort(a)))
+        self.assertTrue(hg.get_num_threads() == num_threads)
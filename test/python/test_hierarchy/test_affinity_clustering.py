@@ -0,0 +1,72 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import higra as hg
+import numpy as np
+
+
+class TestAffinityClustering(unittest.TestCase):
+
+    def test_affinity_clustering(self):
+        g = hg.UndirectedGraph(5)
+        g.add_edges((0, 1, 2, 3), (1, 2, 3, 4))
+        edge_weights = np.asarray((1, 5, 2, 6), dtype=np.float64)
+
+        tree, altitudes = hg.affinity_clustering(g, edge_weights)
+        self.assertTrue(np.all(tree.parents() == (5, 5, 6, 6, 6, 7, 7, 7)))
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 1, 6, 6)))
+        self.assertTrue(hg.CptHierarchy.get_leaf_graph(tree) is g)
+
+        tree, altitudes = hg.affinity_clustering(g, edge_weights, altitude_correction="none")
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 1, 6, 5)))
+
+    def test_affinity_clustering_thresholds(self):
+        g = hg.UndirectedGraph(5)
+        g.add_edges((0, 1, 2, 3), (1, 2, 3, 4))
+        edge_weights = np.asarray((1, 5, 2, 6), dtype=np.float64)
+
+        tree, altitudes = hg.affinity_clustering(g, edge_weights, thresholds=(1.5,))
+        self.assertTrue(np.all(tree.parents() == (5, 5, 6, 6, 6, 6, 6)))
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 1, 6)))
+
+    def test_affinity_clustering_linkages(self):
+        g = hg.UndirectedGraph(4)
+        g.add_edges((0, 1, 2, 3), (1, 2, 3, 0))
+        edge_weights = np.asarray((1, 4, 1, 6), dtype=np.float32)
+        ref_parents = (4, 4, 5, 5, 6, 6, 6)
+
+        for linkage, root_altitude in (("single", 4), ("complete", 6), ("average", 5)):
+            tree, altitudes = hg.affinity_clustering(g, edge_weights, linkage=linkage)
+            self.assertTrue(np.all(tree.parents() == ref_parents))
+            self.assertTrue(altitudes[6] == root_altitude)
+
+        tree, altitudes = hg.affinity_clustering(g, edge_weights, linkage="average",
+                                                 edge_weight_weights=np.asarray((1, 3, 1, 1)))
+        self.assertTrue(altitudes[6] == 4.5)
+
+        with self.assertRaises(Exception):
+            hg.affinity_clustering(g, edge_weights, linkage="ward")
+
+    def test_affinity_clustering_single_linkage_approximation(self):
+        np.random.seed(1)
+        g = hg.get_4_adjacency_graph((15, 17))
+        edge_weights = np.random.rand(g.num_edges())
+
+        tree, altitudes = hg.affinity_clustering(g, edge_weights)
+        self.assertTrue(np.all(altitudes[tree.parents()] >= altitudes))
+
+        # merges are done along minimum spanning tree edges, at a larger altitude than the exact single linkage
+        tree_ref, altitudes_ref = hg.bpt_canonical(g, edge_weights)
+        self.assertTrue(np.all(hg.saliency(tree, altitudes) >= hg.saliency(tree_ref, altitudes_ref)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -9,6 +9,7 @@
 ############################################################################
 
 import unittest
+import ctypes
 import higra as hg
 import numpy as np
 
@@ -67,6 +68,60 @@ class TestBinaryPartitionTree(unittest.TestCase):
         self.assertTrue(np.all(expected_parents == tree.parents()))
         self.assertTrue(np.all(expected_altitudes == altitudes))
 
+    def test_binary_partition_tree_region_graph(self):
+        graph = hg.get_4_adjacency_graph((3, 3))
+        edge_weights = np.asarray((1, 8, 2, 10, 15, 3, 11, 4, 12, 13, 5, 6), np.float64)
+        state = edge_weights.copy()
+
+        def complete_linkage(graph, fusion_edge_index, new_region, merged_region1, merged_region2, new_neighbours):
+            self.assertTrue(graph.num_vertices() == new_region + 1)
+            self.assertTrue(graph.degree(merged_region1) == 0)
+            self.assertTrue(graph.degree(merged_region2) == 0)
+            new_neighbours = list(new_neighbours)
+            self.assertTrue(graph.degree(new_region) == len(new_neighbours))
+            self.assertTrue(sorted(graph.adjacent_vertices(new_region)) ==
+                            sorted(n.neighbour_vertex() for n in new_neighbours))
+            self.assertTrue(sorted(graph.index(e) for e in graph.out_edges(new_region)) ==
+                            sorted(n.new_edge_index() for n in new_neighbours))
+            for n in new_neighbours:
+                new_weight = state[n.first_edge_index()]
+                if n.num_edges() > 1:
+                    new_weight = max(new_weight, state[n.second_edge_index()])
+                n.set_new_edge_weight(new_weight)
+                state[n.new_edge_index()] = new_weight
+
+        tree, altitudes = hg.binary_partition_tree(graph, complete_linkage, edge_weights)
+
+        expected_parents = np.asarray((9, 9, 10, 11, 11, 12, 13, 13, 14, 10, 16, 12, 15, 14, 15, 16, 16))
+        expected_altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 13, 15))
+        self.assertTrue(np.all(tree.parents() == expected_parents))
+        self.assertTrue(np.allclose(altitudes, expected_altitudes))
+
+    def test_binary_partition_tree_compiled_linkage(self):
+        graph = hg.get_4_adjacency_graph((3, 3))
+        edge_weights = np.asarray((1, 8, 2, 10, 15, 3, 11, 4, 12, 13, 5, 6), np.float64)
+        state = edge_weights.copy()
+
+        def complete_linkage(fusion_edge, new_region, region1, region2, num_neighbours,
+                             neighbours, first_edges, second_edges, new_weights, user_data):
+            w = ctypes.cast(user_data, ctypes.POINTER(ctypes.c_double))
+            for i in range(num_neighbours):
+                new_weight = w[first_edges[i]]
+                if second_edges[i] >= 0:
+                    new_weight = max(new_weight, w[second_edges[i]])
+                new_weights[i] = new_weight
+                w[first_edges[i]] = new_weight
+
+        callback = hg.linkage_callback_ctypes_prototype()(complete_linkage)
+        tree, altitudes = hg.binary_partition_tree(graph, callback, edge_weights, user_data=state)
+
+        expected_parents = np.asarray((9, 9, 10, 11, 11, 12, 13, 13, 14, 10, 16, 12, 15, 14, 15, 16, 16))
+        expected_altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 13, 15))
+        self.assertTrue(np.all(tree.parents() == expected_parents))
+        self.assertTrue(np.allclose(altitudes, expected_altitudes))
+        self.assertTrue(hg.CptHierarchy.get_leaf_graph(tree) is graph)
+        self.assertTrue(isinstance(hg.linkage_callback_numba_signature(), str))
+
     def test_binary_partition_tree_average_linkage2(self):
         graph = hg.UndirectedGraph(10)
         graph.add_edges((0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 4, 4, 5, 5, 7, 7),
@@ -168,6 +223,34 @@ class TestBinaryPartitionTree(unittest.TestCase):
         self.assertTrue(np.all(tree.parents() == t_ref.parents()))
         self.assertTrue(np.allclose(altitudes, alt_ref))
 
+    def test_binary_partition_tree_exponential_linkage_large_alpha(self):
+        np.random.seed(10)
+
+        g = hg.get_4_adjacency_graph((10, 10))
+        edge_weights = (np.random.rand(g.num_edges()) * 100).astype(np.float32)
+
+        tree, altitudes = hg.binary_partition_tree_exponential_linkage(g, edge_weights, 1000)
+        t_ref, alt_ref = hg.binary_partition_tree_complete_linkage(g, edge_weights)
+        self.assertTrue(np.all(tree.parents() == t_ref.parents()))
+        self.assertTrue(np.all(altitudes == alt_ref))
+
+    def test_binary_partition_tree_exponential_linkage_multi_alpha(self):
+        np.random.seed(10)
+
+        g = hg.get_4_adjacency_graph((10, 10))
+        edge_weights = np.random.rand(g.num_edges())
+        edge_weight_weights = np.random.randint(1, 10, g.num_edges())
+        alphas = (-5, 0.5, 2)
+
+        res = hg.binary_partition_tree_exponential_linkage(g, edge_weights, alphas, edge_weight_weights)
+        self.assertTrue(len(res) == len(alphas))
+        for (tree, altitudes), alpha in zip(res, alphas):
+            t_ref, alt_ref = hg.binary_partition_tree_exponential_linkage(g, edge_weights, alpha,
+                                                                          edge_weight_weights)
+            self.assertTrue(hg.CptHierarchy.validate(tree))
+            self.assertTrue(np.all(tree.parents() == t_ref.parents()))
+            self.assertTrue(np.all(altitudes == alt_ref))
+
 
 if __name__ == '__main__':
     unittest.main()
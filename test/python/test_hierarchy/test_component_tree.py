@@ -84,6 +84,47 @@ class TestConstrainedConnectivityHierarchy(unittest.TestCase):
 
         self.assertTrue(np.all(filtered_weights == expected_filtered_weights))
 
+        self.assertTrue(np.all(hg.area_opening(graph, vertex_weights, 5) == expected_filtered_weights))
+
+    def test_attribute_filters(self):
+        np.random.seed(42)
+        graph = hg.get_4_adjacency_graph((20, 15))
+        vertex_weights = np.random.randint(0, 30, (20, 15))
+
+        def reference(component_tree, attribute, threshold):
+            tree, altitudes = component_tree(graph, vertex_weights)
+            area = hg.attribute_area(tree)
+            values = area if attribute == "area" else hg.attribute_volume(tree, altitudes, area)
+            deleted = values < threshold
+            deleted[tree.root()] = False
+            return hg.reconstruct_leaf_data(tree, altitudes, deleted)
+
+        for threshold in (2, 10, 100):
+            self.assertTrue(np.all(hg.area_opening(graph, vertex_weights, threshold) ==
+                                   reference(hg.component_tree_max_tree, "area", threshold)))
+            self.assertTrue(np.all(hg.area_closing(graph, vertex_weights, threshold) ==
+                                   reference(hg.component_tree_min_tree, "area", threshold)))
+            self.assertTrue(np.all(hg.volume_opening(graph, vertex_weights, threshold * 10) ==
+                                   reference(hg.component_tree_max_tree, "volume", threshold * 10)))
+            self.assertTrue(np.all(hg.volume_closing(graph, vertex_weights, threshold * 10) ==
+                                   reference(hg.component_tree_min_tree, "volume", threshold * 10)))
+
+    def test_area_pattern_spectrum(self):
+        np.random.seed(42)
+        graph = hg.get_4_adjacency_implicit_graph((20, 15))
+        vertex_weights = np.random.randint(0, 30, (20, 15))
+        thresholds = (2, 5, 20, 100)
+
+        spectrum = hg.area_pattern_spectrum(graph, vertex_weights, thresholds)
+
+        previous = vertex_weights
+        expected = []
+        for t in thresholds:
+            filtered = hg.area_opening(graph, vertex_weights, t)
+            expected.append(np.sum(previous - filtered))
+            previous = filtered
+        self.assertTrue(np.allclose(spectrum, expected))
+
 
 if __name__ == '__main__':
     unittest.main()
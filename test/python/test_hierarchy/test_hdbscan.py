@@ -0,0 +1,64 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import higra as hg
+import numpy as np
+
+
+class TestHDBSCAN(unittest.TestCase):
+
+    @staticmethod
+    def get_path_graph():
+        # points 0, 1, 3, 10, 11.5, 14, 40 linked by a path graph
+        g = hg.UndirectedGraph(7)
+        g.add_edges(np.arange(6), np.arange(1, 7))
+        edge_weights = np.asarray((1, 2, 7, 1.5, 2.5, 26), dtype=np.float64)
+        return g, edge_weights
+
+    def check_path_condensed_hierarchy(self, tree, altitudes, stability):
+        self.assertTrue(np.all(tree.parents() == (7, 7, 7, 8, 8, 8, 9, 9, 9, 9)))
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 0, 0, 1, 1.5, 7)))
+        ref_stability = (0, 0, 0, 0, 0, 0, 0,
+                         (0.5 - 1 / 7) + 2 * (1 - 1 / 7),
+                         (0.4 - 1 / 7) + 2 * (1 / 1.5 - 1 / 7),
+                         1 / 26 + 6 / 7)
+        self.assertTrue(np.allclose(stability, ref_stability))
+
+    def test_hdbscan_hierarchy(self):
+        g, edge_weights = TestHDBSCAN.get_path_graph()
+
+        # the mutual reachability distances with min_samples = 2 are equal to the original weights
+        tree, altitudes, stability = hg.hdbscan_hierarchy(g, edge_weights, min_samples=2, min_cluster_size=2)
+        self.check_path_condensed_hierarchy(tree, altitudes, stability)
+        self.assertTrue(hg.CptHierarchy.get_leaf_graph(tree) is g)
+
+        tree, altitudes, stability = hg.hdbscan_hierarchy(g, edge_weights, min_samples=3, min_cluster_size=2)
+        self.assertTrue(np.all(tree.parents() == (7, 7, 7, 7, 7, 7, 7, 7)))
+
+    def test_condense_hierarchy(self):
+        g, edge_weights = TestHDBSCAN.get_path_graph()
+        bpt, bpt_altitudes = hg.bpt_canonical(g, edge_weights)
+
+        tree, altitudes, stability = hg.condense_hierarchy(bpt, bpt_altitudes, 2)
+        self.check_path_condensed_hierarchy(tree, altitudes, stability)
+        self.assertTrue(hg.CptHierarchy.get_leaf_graph(tree) is g)
+
+        tree, altitudes, stability = hg.condense_hierarchy(bpt, bpt_altitudes, 4)
+        self.assertTrue(np.all(tree.parents() == (7, 7, 7, 7, 7, 7, 7, 7)))
+        self.assertTrue(altitudes[7] == 7)
+        self.assertTrue(np.isclose(stability[7], 1 / 26 + 6 / 7))
+
+        with self.assertRaises(Exception):
+            hg.condense_hierarchy(bpt, bpt_altitudes, 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,105 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import higra as hg
+import numpy as np
+
+
+class TestHierarchyBatch(unittest.TestCase):
+
+    @staticmethod
+    def get_data(num_images=5, shape=(4, 5)):
+        np.random.seed(42)
+        images = np.random.randint(0, 10, (num_images,) + shape).astype(np.float64)
+        graph = hg.get_4_adjacency_graph(shape)
+        return graph, images
+
+    def test_weight_graph_batch(self):
+        graph, images = TestHierarchyBatch.get_data()
+        edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+        self.assertTrue(edge_weights.shape == (images.shape[0], graph.num_edges()))
+        for i in range(images.shape[0]):
+            ref = hg.weight_graph(graph, images[i], hg.WeightFunction.L1)
+            self.assertTrue(np.all(edge_weights[i] == ref))
+
+    def test_bpt_canonical_batch(self):
+        graph, images = TestHierarchyBatch.get_data()
+        edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+        parents, altitudes, offsets = hg.bpt_canonical_batch(graph, edge_weights)
+        self.assertTrue(offsets.size == images.shape[0] + 1)
+        for i in range(images.shape[0]):
+            tree, ref_altitudes = hg.bpt_canonical(graph, edge_weights[i])
+            self.assertTrue(np.all(parents[offsets[i]:offsets[i + 1]] == tree.parents()))
+            self.assertTrue(np.all(altitudes[offsets[i]:offsets[i + 1]] == ref_altitudes))
+
+    def test_watershed_hierarchy_batch(self):
+        graph, images = TestHierarchyBatch.get_data()
+        edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+        functions = {"area": hg.watershed_hierarchy_by_area,
+                     "volume": hg.watershed_hierarchy_by_volume,
+                     "dynamics": hg.watershed_hierarchy_by_dynamics}
+        for attribute, function in functions.items():
+            parents, altitudes, offsets = hg.watershed_hierarchy_batch(graph, edge_weights, attribute)
+            for i in range(images.shape[0]):
+                tree, ref_altitudes = function(graph, edge_weights[i], canonize_tree=False)
+                self.assertTrue(np.all(parents[offsets[i]:offsets[i + 1]] == tree.parents()))
+                self.assertTrue(np.allclose(altitudes[offsets[i]:offsets[i + 1]], ref_altitudes))
+
+    def test_saliency_map_batch(self):
+        graph, images = TestHierarchyBatch.get_data()
+        edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+        parents, altitudes, offsets = hg.watershed_hierarchy_batch(graph, edge_weights)
+        saliency = hg.saliency_map_batch(graph, parents, altitudes, offsets)
+        self.assertTrue(saliency.shape == (images.shape[0], graph.num_edges()))
+        for i in range(images.shape[0]):
+            tree = hg.Tree(parents[offsets[i]:offsets[i + 1]])
+            ref = hg.saliency(tree, altitudes[offsets[i]:offsets[i + 1]], graph)
+            self.assertTrue(np.all(saliency[i] == ref))
+
+    def test_hierarchy_distance_matrix_batch(self):
+        graph, images = TestHierarchyBatch.get_data(num_images=11)
+        edge_weights = hg.weight_graph_batch(graph, images, hg.WeightFunction.L1)
+        parents, altitudes, offsets = hg.watershed_hierarchy_batch(graph, edge_weights)
+        saliency = hg.saliency_map_batch(graph, parents, altitudes, offsets)
+
+        l1 = hg.hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets)
+        ref_l1 = np.sum(np.abs(saliency[:, None, :] - saliency[None, :, :]), axis=2)
+        self.assertTrue(np.allclose(l1, ref_l1))
+
+        l2 = hg.hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets, "L2")
+        ref_l2 = np.sqrt(np.sum((saliency[:, None, :] - saliency[None, :, :]) ** 2, axis=2))
+        self.assertTrue(np.allclose(l2, ref_l2))
+
+        corr = hg.hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets, "correlation")
+        ref_corr = 1 - np.corrcoef(saliency)
+        np.fill_diagonal(ref_corr, 0)
+        self.assertTrue(np.allclose(corr, ref_corr))
+
+        with self.assertRaises(Exception):
+            hg.hierarchy_distance_matrix_batch(graph, parents, altitudes, offsets, "L3")
+
+    def test_attribute_batch(self):
+        parents = np.asarray((3, 3, 4, 4, 4, 2, 2, 2), dtype=np.int64)
+        altitudes = np.asarray((0, 0, 0, 1, 2, 0, 0, 3), dtype=np.float64)
+        offsets = np.asarray((0, 5, 8), dtype=np.int64)
+
+        area = hg.attribute_batch(parents, altitudes, offsets, "area")
+        self.assertTrue(np.all(area == (1, 1, 1, 2, 3, 1, 1, 2)))
+
+        depth = hg.attribute_batch(parents, altitudes, offsets, "depth")
+        self.assertTrue(np.all(depth == (2, 2, 1, 1, 0, 1, 1, 0)))
+
+        height = hg.attribute_batch(parents, altitudes, offsets, "height")
+        self.assertTrue(np.all(height == (0, 0, 0, 1, 1, 0, 0, 0)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -142,6 +142,33 @@ class TestHierarchyCore(unittest.TestCase):
         self.assertTrue(np.all(altitudes == ref_altitudes_no_weights))
         self.assertTrue(np.all(tree.mst_edge_map == ref_mst_edge_map))
 
+    def test_bpt_canonical_below_above(self):
+        np.random.seed(42)
+        g = hg.get_4_adjacency_graph((10, 12))
+        edge_weights = np.random.randint(0, 20, g.num_edges())
+        ref_tree, ref_altitudes = hg.bpt_canonical(g, edge_weights)
+        ref_parents = ref_tree.parents()
+        num_v = g.num_vertices()
+
+        for altitude in (-1, 4, 9.5, 19):
+            parents, altitudes, mst_edge_map, supervertex_map, roots = hg.bpt_canonical_below(g, edge_weights, altitude)
+            num_nodes = parents.size
+            self.assertTrue(np.all(mst_edge_map == ref_tree.mst_edge_map[:num_nodes - num_v]))
+            self.assertTrue(np.all(altitudes == ref_altitudes[:num_nodes]))
+            non_roots = parents != np.arange(num_nodes)
+            self.assertTrue(np.all(parents[non_roots] == ref_parents[:num_nodes][non_roots]))
+            self.assertTrue(roots.size == num_nodes - np.count_nonzero(non_roots))
+
+            tree, altitudes2, mst_edge_map2, supervertex_map2 = hg.bpt_canonical_above(g, edge_weights, altitude)
+            self.assertTrue(np.all(supervertex_map == supervertex_map2))
+            self.assertTrue(tree.num_leaves() == roots.size)
+            self.assertTrue(np.all(mst_edge_map2 == ref_tree.mst_edge_map[num_nodes - num_v:]))
+            self.assertTrue(np.all(altitudes2[tree.num_leaves():] == ref_altitudes[num_nodes:]))
+
+            labels = hg.labelisation_horizontal_cut_from_threshold(tree, altitudes2, 19)[supervertex_map]
+            ref_labels = hg.labelisation_horizontal_cut_from_threshold(ref_tree, ref_altitudes, 19)
+            self.assertTrue(hg.is_in_bijection(labels, ref_labels))
+
     def test_QFZ(self):
         graph = hg.get_4_adjacency_graph((2, 3))
 
@@ -154,6 +181,34 @@ class TestHierarchyCore(unittest.TestCase):
         self.assertTrue(hg.test_tree_isomorphism(tree, tref))
         self.assertTrue(np.allclose(altitudes, (0, 0, 0, 0, 0, 0, 0, 1, 1, 2)))
 
+    def test_hierarchy_on_collapsed_flat_zones(self):
+        np.random.seed(1)
+        graph = hg.get_4_adjacency_graph((10, 12))
+        edge_weights = np.floor(np.random.rand(graph.num_edges()) * 4)
+
+        tree_ref, altitudes_ref = hg.bpt_canonical(graph, edge_weights)
+        saliency_ref = hg.saliency(tree_ref, altitudes_ref)
+
+        tree, altitudes = hg.hierarchy_on_collapsed_flat_zones(graph, edge_weights, hg.bpt_canonical)
+        rag = hg.CptHierarchy.get_leaf_graph(tree)
+        self.assertTrue(tree.num_leaves() == rag.num_vertices())
+        self.assertTrue(np.all(hg.saliency(tree, altitudes) == saliency_ref))
+
+        tree, altitudes = hg.hierarchy_on_collapsed_flat_zones(graph, edge_weights, hg.bpt_canonical,
+                                                               expand_leaves=True)
+        self.assertTrue(tree.num_leaves() == graph.num_vertices())
+        self.assertTrue(np.all(hg.saliency(tree, altitudes) == saliency_ref))
+
+        def average_linkage(rag, rag_edge_weights):
+            counts = hg.rag_accumulate_on_edges(rag, hg.Accumulators.sum, np.ones_like(edge_weights))
+            means = hg.rag_accumulate_on_edges(rag, hg.Accumulators.mean, edge_weights)
+            return hg.binary_partition_tree_average_linkage(rag, means, counts)
+
+        tree, altitudes = hg.hierarchy_on_collapsed_flat_zones(graph, edge_weights, average_linkage, 1, True)
+        self.assertTrue(tree.num_leaves() == graph.num_vertices())
+        self.assertTrue(np.all(altitudes[tree.parents()] >= altitudes))
+        self.assertTrue(np.all(altitudes[graph.num_vertices():] >= 1))
+
     def test_simplify_tree(self):
         t = TestHierarchyCore.getTree()
 
@@ -267,6 +322,59 @@ class TestHierarchyCore(unittest.TestCase):
         self.assertTrue(np.all(new_tree.parents() == exp_parents))
         self.assertTrue(np.all(node_map == exp_node_map))
 
+    def test_dynamic_bpt(self):
+        g = hg.get_4_adjacency_graph((2, 3))
+        edge_weights = np.asarray((1, 0, 2, 1, 1, 1, 2), dtype=np.float64)
+        dbpt = hg.DynamicBPT(g, edge_weights)
+        self.assertTrue(dbpt.num_mst_edges() == 5)
+        self.assertFalse(dbpt.is_mst_edge(5))
+
+        def check(sources, targets, weights):
+            graph = hg.UndirectedGraph(6)
+            graph.add_edges(sources, targets)
+            ref_tree, ref_altitudes = hg.bpt_canonical(graph, np.asarray(weights, dtype=np.float64))
+            tree, altitudes, mst_edge_map = dbpt.bpt()
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.all(altitudes == ref_altitudes))
+
+        sources, targets = g.edge_list()
+        weights = edge_weights.copy()
+        dbpt.set_edge_weight(1, 3)
+        weights[1] = 3
+        self.assertFalse(dbpt.is_mst_edge(1))
+        self.assertTrue(dbpt.is_mst_edge(5))
+        self.assertTrue(dbpt.edge_weight(1) == 3)
+        check(sources, targets, weights)
+
+        e = dbpt.insert_edge(0, 5, 0.5)
+        self.assertTrue(e == 7)
+        self.assertTrue(dbpt.is_mst_edge(e))
+        check(np.append(sources, 0), np.append(targets, 5), np.append(weights, 0.5))
+
+        dbpt.remove_edge(e)
+        check(sources, targets, weights)
+
+    def test_dynamic_bpt_streaming(self):
+        dbpt = hg.DynamicBPT()
+        points = np.zeros((0, 2))
+        for batch in range(5):
+            first = dbpt.add_vertices(10)
+            points = np.concatenate((points, np.random.rand(10, 2)))
+            # path graph on the points
+            sources = np.arange(max(0, first - 1), first + 9)
+            targets = sources + 1
+            dbpt.insert_edges(sources, targets, np.linalg.norm(points[sources] - points[targets], axis=1))
+            dbpt.keep_last_vertices(25)
+            active = dbpt.active_vertices()
+            self.assertTrue(np.all(active == np.arange(max(0, first + 10 - 25), first + 10)))
+
+            tree, altitudes, mst_edge_map = dbpt.bpt()
+            graph = hg.get_4_adjacency_graph((1, active.size))
+            ref_tree, ref_altitudes = hg.bpt_canonical(
+                graph, np.linalg.norm(points[active[:-1]] - points[active[1:]], axis=1))
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.allclose(altitudes, ref_altitudes))
+
 
 if __name__ == '__main__':
     unittest.main()
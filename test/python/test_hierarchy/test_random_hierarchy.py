@@ -46,3 +46,28 @@ class TestRandomHierarchy(unittest.TestCase):
         self.assertTrue(np.all(hg.CptMinimumSpanningTree.get_edge_map(mst) == hg.CptBinaryHierarchy.get_mst_edge_map(tree)))
         self.assertTrue(mst == leaf_graph)
         self.assertTrue(leaf_graph == hg.CptMinimumSpanningTree.get_base_graph(mst))
+
+    def test_random_binary_partition_tree_seed(self):
+        tree1, _ = hg.random_binary_partition_tree(100, 0.5, seed=42)
+        tree2, _ = hg.random_binary_partition_tree(100, 0.5, seed=42)
+        self.assertTrue(np.all(tree1.parents() == tree2.parents()))
+
+    def test_random_binary_partition_trees(self):
+        num_trees = 20
+        size = 32
+        parents = hg.random_binary_partition_trees(num_trees, size, 0, seed=1)
+        self.assertTrue(parents.shape == (num_trees, 2 * size - 1))
+        for i in range(num_trees):
+            tree = hg.Tree(parents[i])
+            self.assertTrue(tree.num_leaves() == size)
+            depth = hg.attribute_depth(tree)
+            for d in range(6):
+                self.assertTrue(np.sum(depth == d) == 2**d)
+
+        parents1 = hg.random_binary_partition_trees(num_trees, size, 0.5, seed=1)
+        parents2 = hg.random_binary_partition_trees(num_trees, size, 0.5, seed=1)
+        self.assertTrue(np.all(parents1 == parents2))
+
+
+if __name__ == '__main__':
+    unittest.main()
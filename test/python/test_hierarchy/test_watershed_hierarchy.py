@@ -87,6 +87,52 @@ class TestWatershedHierarchy(unittest.TestCase):
         self.assertTrue(hg.test_tree_isomorphism(tree, ref_tree))
         self.assertTrue(np.allclose(altitudes, ref_altitudes))
 
+    def test_watershed_hierarchy_integral_altitudes(self):
+        g = hg.get_4_adjacency_graph((10, 12))
+        image = np.random.randint(0, 256, (10, 12)).astype(np.uint8)
+        edge_weights = hg.weight_graph(g, image, hg.WeightFunction.L1, preserve_dtype=True)
+        self.assertTrue(edge_weights.dtype == np.uint8)
+
+        ref_tree, ref_altitudes = hg.watershed_hierarchy_by_area(g, edge_weights)
+        tree, altitudes = hg.watershed_hierarchy_by_area(g, edge_weights,
+                                                         np.ones(hg.num_vertices(g), dtype=np.uint32))
+        self.assertTrue(altitudes.dtype == np.uint32)
+        self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+        self.assertTrue(np.all(altitudes == ref_altitudes))
+
+        tree, altitudes = hg.watershed_hierarchy_by_dynamics(g, edge_weights)
+        self.assertTrue(np.issubdtype(altitudes.dtype, np.integer))
+        ref_tree, ref_altitudes = hg.watershed_hierarchy_by_dynamics(g, edge_weights.astype(np.float64))
+        self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+        self.assertTrue(np.all(altitudes == ref_altitudes))
+
+    def test_watershed_hierarchy_by_area_engine(self):
+        g = hg.get_4_adjacency_graph((10, 12))
+        vertex_area = np.random.randint(1, 4, hg.num_vertices(g))
+        engine = hg.WatershedHierarchyByAreaEngine(g)
+        engine_area = hg.WatershedHierarchyByAreaEngine(g, vertex_area)
+        self.assertTrue(engine.graph is g)
+
+        for i in range(3):
+            edge_weights = np.random.randint(0, 10 + 10 * i, hg.num_edges(g))
+
+            tree, altitudes = engine.compute(edge_weights)
+            ref_tree, ref_altitudes = hg.watershed_hierarchy_by_area(g, edge_weights)
+            self.assertTrue(hg.CptHierarchy.validate(tree))
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.allclose(altitudes, ref_altitudes))
+
+            tree, altitudes = engine.compute(edge_weights, canonize_tree=False)
+            ref_tree, ref_altitudes = hg.watershed_hierarchy_by_area(g, edge_weights, canonize_tree=False)
+            self.assertTrue(hg.CptBinaryHierarchy.validate(tree))
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.allclose(altitudes, ref_altitudes))
+
+            tree, altitudes = engine_area.compute(edge_weights)
+            ref_tree, ref_altitudes = hg.watershed_hierarchy_by_area(g, edge_weights, vertex_area)
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.allclose(altitudes, ref_altitudes))
+
     def test_watershed_hierarchy_by_dynamics(self):
         g = hg.get_4_adjacency_graph((1, 7))
         edge_weights = np.asarray((1, 4, 1, 0, 10, 8))
@@ -127,5 +173,18 @@ class TestWatershedHierarchy(unittest.TestCase):
         self.assertTrue(np.allclose(altitudes, ref_altitudes))
 
 
+    def test_waterfall_hierarchy(self):
+        g = hg.get_4_adjacency_graph((1, 6))
+        edge_weights = np.asarray((1, 5, 2, 6, 3))
+
+        tree, altitudes = hg.waterfall_hierarchy(g, edge_weights)
+        self.assertTrue(np.all(tree.parents() == (6, 6, 7, 7, 8, 8, 9, 9, 9, 9)))
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 0, 1, 1, 1, 2)))
+
+        tree, altitudes = hg.waterfall_hierarchy(g, edge_weights, canonize_tree=False)
+        self.assertTrue(np.all(tree.parents() == (6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 10)))
+        self.assertTrue(np.all(altitudes == (0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2)))
+        self.assertTrue(np.all(tree.mst_edge_map == (0, 2, 4, 1, 3)))
+
 if __name__ == '__main__':
     unittest.main()
@@ -36,6 +36,17 @@ class TestGraphImage(unittest.TestCase):
         self.assertTrue(np.allclose(shape, (2, 3)))
         self.assertTrue(np.allclose(data, weights))
 
+    def test_ucm_khalimsky(self):
+        g = hg.get_4_adjacency_graph((4, 5))
+        np.random.seed(1)
+        data = np.random.rand(g.num_edges())
+        tree, altitudes = hg.bpt_canonical(g, data)
+
+        for border in (False, True):
+            ref = hg.graph_4_adjacency_2_khalimsky(g, hg.saliency(tree, altitudes), add_extra_border=border)
+            r = hg.ucm_khalimsky(tree, altitudes, add_extra_border=border)
+            self.assertTrue(np.all(ref == r))
+
     def test_get_4_adjacency_graph(self):
         shape = (2, 3)
         graph = hg.get_4_adjacency_graph(shape)
@@ -98,6 +109,68 @@ class TestGraphImage(unittest.TestCase):
 
         self.assertTrue(ref_edges == res_edges)
 
+    def test_bpt_canonical_4_adjacency(self):
+        image = np.random.rand(13, 17)
+        graph = hg.get_4_adjacency_graph(image.shape)
+        for weight_function in (hg.WeightFunction.mean, hg.WeightFunction.L1):
+            ref_tree, ref_altitudes = hg.bpt_canonical(graph, hg.weight_graph(graph, image, weight_function))
+            ref_mst_edge_map = hg.CptBinaryHierarchy.get_mst_edge_map(ref_tree)
+
+            tree, altitudes, mst_edge_map = hg.bpt_canonical_4_adjacency(image, weight_function)
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.all(altitudes == ref_altitudes))
+            self.assertTrue(np.all(mst_edge_map == ref_mst_edge_map))
+
+            future = hg.bpt_canonical_4_adjacency_async(image, weight_function)
+            tree, altitudes, mst_edge_map = future.result()
+            self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+            self.assertTrue(np.all(altitudes == ref_altitudes))
+
+    def test_tiled_minimum_spanning_tree(self):
+        image = np.random.rand(23, 31)
+        graph = hg.get_4_adjacency_graph(image.shape)
+        for weight_function in (hg.WeightFunction.L1, hg.WeightFunction.max):
+            edge_weights = hg.weight_graph(graph, image, weight_function)
+            ref_tree, _ = hg.bpt_canonical(graph, edge_weights)
+            ref_mst_edge_map = np.sort(hg.CptBinaryHierarchy.get_mst_edge_map(ref_tree))
+
+            for prefetch in (True, False):
+                mst_edges, mst_edge_weights = hg.tiled_minimum_spanning_tree(image, (5, 7), weight_function,
+                                                                             prefetch)
+                self.assertTrue(np.all(np.sort(mst_edges) == ref_mst_edge_map))
+                self.assertTrue(np.allclose(mst_edge_weights, edge_weights[mst_edges]))
+
+        mst_edges, _ = hg.tiled_minimum_spanning_tree(image)
+        self.assertTrue(mst_edges.size == image.size - 1)
+
+    def test_get_4_adjacency_morton_graph(self):
+        image = np.random.randint(0, 10, (37, 45)).astype(np.float64)
+        embedding = hg.EmbeddingMorton2d(image.shape, 8)
+        graph = hg.get_4_adjacency_morton_graph(embedding)
+        ref_graph = hg.get_4_adjacency_graph(image.shape)
+        self.assertTrue(graph.num_vertices() == ref_graph.num_vertices())
+        self.assertTrue(graph.num_edges() == ref_graph.num_edges())
+
+        # same adjacency up to the vertex numbering
+        sources, targets = graph.edge_list()
+        ref_sources, ref_targets = ref_graph.edge_list()
+        to_row_major = embedding.to_row_major_order(np.arange(image.size)).ravel()
+        edges = np.sort(np.stack((to_row_major[sources], to_row_major[targets]), axis=1), axis=1)
+        ref_edges = np.stack((ref_sources, ref_targets), axis=1)
+        self.assertTrue(np.all(np.unique(edges, axis=0) == np.unique(ref_edges, axis=0)))
+
+        # same hierarchy up to the vertex numbering
+        tree, altitudes = hg.bpt_canonical(ref_graph, hg.weight_graph(ref_graph, image, hg.WeightFunction.L1))
+        tree_m, altitudes_m = hg.bpt_canonical(
+            graph, hg.weight_graph(graph, embedding.to_morton_order(image), hg.WeightFunction.L1))
+        self.assertTrue(np.all(np.sort(altitudes) == np.sort(altitudes_m)))
+        labels = hg.labelisation_horizontal_cut_from_threshold(tree, altitudes, 3).reshape(image.shape)
+        labels_m = embedding.to_row_major_order(hg.labelisation_horizontal_cut_from_threshold(tree_m, altitudes_m, 3))
+        self.assertTrue(hg.is_in_bijection(labels, labels_m))
+
+        graph8 = hg.get_8_adjacency_morton_graph(embedding)
+        self.assertTrue(graph8.num_edges() == hg.get_8_adjacency_graph(image.shape).num_edges())
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -26,6 +26,28 @@ class TestSciPyInterop(unittest.TestCase):
         self.assertTrue(np.allclose(ref, res))
         self.assertTrue(res.dtype == np.float64)
 
+    def test_binary_hierarchy_to_scipy_linkage_matrix_default_attributes(self):
+        t = hg.Tree((5, 5, 7, 6, 6, 7, 8, 8, 8))
+        regular_altitudes = hg.attribute_regular_altitudes(t)
+        ref = np.asarray(((0, 1, regular_altitudes[5], 2),
+                          (3, 4, regular_altitudes[6], 2),
+                          (2, 5, regular_altitudes[7], 3),
+                          (6, 7, regular_altitudes[8], 5)))
+        res = hg.binary_hierarchy_to_scipy_linkage_matrix(t)
+        self.assertTrue(np.allclose(ref, res))
+
+        area = np.asarray((1, 2, 3, 4, 5, 3, 9, 6, 15), dtype=np.int32)
+        res = hg.binary_hierarchy_to_scipy_linkage_matrix(t, area=area)
+        self.assertTrue(np.allclose(res[:, 3], (3, 9, 6, 15)))
+
+    def test_binary_hierarchy_to_scipy_linkage_matrix_not_binary(self):
+        t = hg.Tree((4, 4, 4, 5, 5, 6, 6))
+        with self.assertRaises(RuntimeError):
+            hg.binary_hierarchy_to_scipy_linkage_matrix(t)
+        t = hg.Tree((3, 3, 3, 3))
+        with self.assertRaises(RuntimeError):
+            hg.binary_hierarchy_to_scipy_linkage_matrix(t)
+
     def test_scipy_linkage_matrix_to_binary_hierarchy(self):
         linkage_matrix = np.asarray(((0, 1, 1, 2),
                                      (3, 4, 2, 2),
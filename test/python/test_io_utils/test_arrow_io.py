@@ -0,0 +1,118 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+import os
+import os.path
+
+try:
+    import pyarrow
+
+    has_pyarrow = True
+except ImportError:
+    has_pyarrow = False
+
+
+def silent_remove(filename):
+    try:
+        os.remove(filename)
+    except:
+        pass
+
+
+@unittest.skipIf(not has_pyarrow, "pyarrow is not installed")
+class TestArrowIO(unittest.TestCase):
+
+    def check_tree_round_trip(self, format):
+        filename = "testArrowIO." + format
+        silent_remove(filename)
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        altitudes = np.asarray((0, 0, 0, 0, 0, 1, 2, 3), dtype=np.float64)
+        area = hg.attribute_area(tree)
+        flag = np.asarray((True, False, True, False, True, False, True, False))
+
+        # small row groups: several batches are written
+        hg.save_tree_arrow(filename, tree, altitudes, {"area": area, "flag": flag}, format=format, row_group_size=3)
+
+        tree2, attributes = hg.read_tree_arrow(filename)
+        self.assertTrue(np.all(tree2.parents() == tree.parents()))
+        self.assertTrue(tree2.num_leaves() == tree.num_leaves())
+        self.assertTrue(tree2.category() == tree.category())
+        self.assertTrue(set(attributes.keys()) == {"altitude", "area", "flag"})
+        self.assertTrue(np.all(attributes["altitude"] == altitudes))
+        self.assertTrue(np.all(attributes["area"] == area))
+        self.assertTrue(attributes["area"].dtype == area.dtype)
+        self.assertTrue(np.all(attributes["flag"] == flag))
+        self.assertTrue(np.all(hg.get_attribute(tree2, "area") == area))
+
+        del tree2, attributes
+        silent_remove(filename)
+
+    def test_save_tree_arrow(self):
+        self.check_tree_round_trip("arrow")
+
+    def test_save_tree_parquet(self):
+        self.check_tree_round_trip("parquet")
+
+    def test_save_tree_arrow_batches(self):
+        filename = "testArrowIOBatches.arrow"
+        silent_remove(filename)
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        hg.save_tree_arrow(filename, tree, row_group_size=3)
+
+        reader = pyarrow.ipc.open_file(pyarrow.memory_map(filename, "r"))
+        self.assertTrue(reader.num_record_batches == 3)
+        self.assertTrue(reader.schema.names == ["parent"])
+
+        del reader
+        silent_remove(filename)
+
+    def test_save_graph_arrow(self):
+        for format in ("arrow", "parquet"):
+            filename = "testGraphArrowIO." + format
+            silent_remove(filename)
+
+            graph = hg.get_4_adjacency_graph((3, 4))
+            edge_weights = np.arange(graph.num_edges(), dtype=np.float32)
+            label = np.arange(graph.num_edges(), dtype=np.int8) % 3
+
+            hg.save_graph_arrow(filename, graph, edge_weights, {"label": label}, format=format, row_group_size=4)
+
+            graph2, attributes = hg.read_graph_arrow(filename)
+            self.assertTrue(graph2.num_vertices() == graph.num_vertices())
+            s1, t1 = graph.edge_list()
+            s2, t2 = graph2.edge_list()
+            self.assertTrue(np.all(s1 == s2))
+            self.assertTrue(np.all(t1 == t2))
+            self.assertTrue(np.all(attributes["weight"] == edge_weights))
+            self.assertTrue(attributes["weight"].dtype == np.float32)
+            self.assertTrue(np.all(attributes["label"] == label))
+
+            del graph2, attributes
+            silent_remove(filename)
+
+    def test_save_tree_arrow_errors(self):
+        tree = hg.Tree((2, 2, 2))
+        with self.assertRaises(ValueError):
+            hg.save_tree_arrow("testArrowIOError.arrow", tree, format="csv")
+        with self.assertRaises(ValueError):
+            hg.save_tree_arrow("testArrowIOError.arrow", tree, attributes={"parent": np.zeros(3)})
+        with self.assertRaises(ValueError):
+            hg.save_tree_arrow("testArrowIOError.arrow", tree, attributes={"a": np.zeros(2)})
+        silent_remove("testArrowIOError.arrow")
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,102 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+import os
+import os.path
+
+
+def silent_remove(filename):
+    try:
+        os.remove(filename)
+    except:
+        pass
+
+
+class TestGraphIO(unittest.TestCase):
+
+    def test_graph_read_write(self):
+        filename = "testGraphIO.hgg"
+        silent_remove(filename)
+
+        graph = hg.UndirectedGraph(5)
+        graph.add_edges((0, 1, 3, 2, 4), (1, 2, 4, 2, 0))
+        edge_weights = np.asarray((1, 2, 3, 4, 5), dtype=np.float32)
+        vertex_weights = np.arange(10, dtype=np.uint8).reshape((5, 2))
+
+        hg.save_graph(filename, graph, {"color": vertex_weights}, {"w": edge_weights})
+        graph2, vertex_attributes, edge_attributes = hg.read_graph(filename)
+
+        self.assertTrue(graph2.num_vertices() == 5)
+        self.assertTrue(np.all(graph2.sources() == graph.sources()))
+        self.assertTrue(np.all(graph2.targets() == graph.targets()))
+        for v in range(5):
+            self.assertTrue(list(graph2.out_edges(v)) == list(graph.out_edges(v)))
+        self.assertTrue(edge_attributes["w"].dtype == np.float32)
+        self.assertTrue(np.all(edge_attributes["w"] == edge_weights))
+        self.assertTrue(vertex_attributes["color"].dtype == np.uint8)
+        self.assertTrue(np.all(vertex_attributes["color"] == vertex_weights))
+
+        # without attributes
+        hg.save_graph(filename, graph)
+        graph2, vertex_attributes, edge_attributes = hg.read_graph(filename)
+        silent_remove(filename)
+        self.assertTrue(np.all(graph2.sources() == graph.sources()))
+        self.assertTrue(len(vertex_attributes) == 0 and len(edge_attributes) == 0)
+
+    def test_graph_read_write_mmap(self):
+        filename = "testGraphIOMmap.hgg"
+        silent_remove(filename)
+
+        graph = hg.get_4_adjacency_graph((4, 5))
+        edge_weights = np.arange(graph.num_edges(), dtype=np.float64)
+        image = np.arange(20, dtype=np.int32).reshape((4, 5))
+
+        hg.save_graph(filename, graph, {"image": image}, {"w": edge_weights})
+        graph2, vertex_attributes, edge_attributes = hg.read_graph(filename, mmap=True)
+
+        self.assertTrue(hg.CptGridGraph.validate(graph2))
+        self.assertTrue(hg.CptGridGraph.get_shape(graph2) == (4, 5))
+        self.assertTrue(np.all(graph2.sources() == graph.sources()))
+        self.assertTrue(np.all(graph2.targets() == graph.targets()))
+        self.assertTrue(np.all(edge_attributes["w"] == edge_weights))
+        self.assertTrue(np.all(vertex_attributes["image"] == image))
+        self.assertFalse(edge_attributes["w"].flags.writeable)
+        self.assertFalse(edge_attributes["w"].flags.owndata)
+
+        del graph2, vertex_attributes, edge_attributes
+        silent_remove(filename)
+
+    def test_regular_graph_read_write(self):
+        filename = "testGraphIORegular.hgg"
+        silent_remove(filename)
+
+        graph = hg.get_8_adjacency_implicit_graph((3, 4))
+        image = np.arange(12, dtype=np.float64).reshape((3, 4))
+
+        hg.save_graph(filename, graph, {"image": image})
+        graph2, vertex_attributes, edge_attributes = hg.read_graph(filename)
+
+        self.assertTrue(type(graph2) == type(graph))
+        self.assertTrue(np.all(graph2.shape() == (3, 4)))
+        self.assertTrue(np.all(graph2.neighbour_list() == graph.neighbour_list()))
+        self.assertTrue(np.all(vertex_attributes["image"] == image))
+        self.assertTrue(len(edge_attributes) == 0)
+
+        with self.assertRaises(ValueError):
+            hg.save_graph(filename, graph, edge_attributes={"w": np.ones(10)})
+        silent_remove(filename)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -84,6 +84,24 @@ class TestPinkGraphIO(unittest.TestCase):
         self.assertTrue(os.path.exists(filename))
         silent_remove(filename)
 
+    def test_graphReadWriteBinary(self):
+        global graph_file
+        filename = "testWriteGraphPinkBinary.graph"
+        silent_remove(filename)
+
+        graph, vertex_weights, edge_weights = hg.read_graph_pink(graph_file)
+        edge_weights = edge_weights / 3
+
+        hg.save_graph_pink(filename, graph, vertex_weights, edge_weights, binary=True)
+        graph2, vertex_weights2, edge_weights2 = hg.read_graph_pink(filename)
+        silent_remove(filename)
+
+        self.assertTrue(hg.get_attribute(graph2, "shape") == [3, 5])
+        self.assertTrue(np.all(graph.sources() == graph2.sources()))
+        self.assertTrue(np.all(graph.targets() == graph2.targets()))
+        self.assertTrue(np.all(vertex_weights == vertex_weights2))
+        self.assertTrue(np.all(edge_weights == edge_weights2))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -56,6 +56,201 @@ class TestTreeIO(unittest.TestCase):
 
         self.assertTrue(np.allclose(tree.parents(), parents))
 
+    def test_treeReadWriteNativeTypes(self):
+        filename = "testTreeIONative.graph"
+        silent_remove(filename)
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        attributes = {"f32": np.arange(8, dtype=np.float32) / 2,
+                      "u8": np.arange(8, dtype=np.uint8),
+                      "i64": -np.arange(8, dtype=np.int64),
+                      "b": np.arange(8) % 2 == 0}
+
+        hg.save_tree(filename, tree, attributes)
+
+        for mmap in (False, True):
+            tree2, attributes2 = hg.read_tree(filename, mmap=mmap)
+            self.assertTrue(np.all(tree2.parents() == tree.parents()))
+            self.assertTrue(set(attributes2.keys()) == set(attributes.keys()))
+            for k in attributes:
+                self.assertTrue(attributes2[k].dtype == attributes[k].dtype)
+                self.assertTrue(np.all(attributes2[k] == attributes[k]))
+                self.assertTrue(np.all(hg.get_attribute(tree2, k) == attributes[k]))
+            del tree2
+
+        # attributes are read-only views on the mapped file
+        tree2, attributes2 = hg.read_tree(filename, mmap=True)
+        for k in attributes:
+            self.assertFalse(attributes2[k].flags.writeable)
+            self.assertFalse(attributes2[k].flags.owndata)
+        del tree2, attributes2
+
+        a = hg.read_tree_attribute(filename, "u8")
+        self.assertTrue(a.dtype == np.uint8)
+        self.assertTrue(np.all(a == attributes["u8"]))
+
+        with self.assertRaises(Exception):
+            hg.read_tree_attribute(filename, "unknown")
+
+        silent_remove(filename)
+
+    def test_treeReadWriteCompression(self):
+        filename = "testTreeIOCompression.graph"
+        silent_remove(filename)
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        attr = np.asarray((1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0))
+
+        for compression in ("none", "lz4", "zstd"):
+            try:
+                hg.save_tree(filename, tree, {"attr": attr}, compression=compression)
+            except RuntimeError:
+                # codec not available in this build
+                continue
+            tree2, attributes2 = hg.read_tree(filename)
+            self.assertTrue(np.all(tree2.parents() == tree.parents()))
+            self.assertTrue(np.all(attributes2["attr"] == attr))
+            self.assertTrue(np.all(hg.read_tree_attribute(filename, "attr") == attr))
+
+        with self.assertRaises(Exception):
+            hg.save_tree(filename, tree, compression="unknown")
+
+        silent_remove(filename)
+
+    def test_treeReadWriteLCA(self):
+        filename = "testTreeIOLCA.graph"
+        silent_remove(filename)
+        silent_remove(filename + ".lca")
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        for algorithm in ("sparse_table", "sparse_table_block", "bitmask_block"):
+            lca = tree.lowest_common_ancestor_preprocess(algorithm=algorithm, block_size=2, force_recompute=True)
+            hg.save_tree(filename, tree, lca_index=True)
+
+            tree2, _ = hg.read_tree(filename, lca_index=True)
+            lca2 = hg.get_attribute(tree2, "lca_fast")
+            self.assertTrue(type(lca2) is type(lca))
+            self.assertTrue(tree2.lowest_common_ancestor_preprocess() is lca2)
+
+            v1 = np.asarray((0, 0, 1, 3, 2, 7), dtype=np.int64)
+            v2 = np.asarray((0, 3, 0, 4, 6, 1), dtype=np.int64)
+            self.assertTrue(np.all(lca2.lca(v1, v2) == lca.lca(v1, v2)))
+            del tree2, lca2
+
+        silent_remove(filename)
+        silent_remove(filename + ".lca")
+
+    def test_succinctTreeReadWrite(self):
+        filename = "testTreeIOSuccinct.bp"
+        silent_remove(filename)
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        altitudes = np.asarray((0, 0, 0, 0, 0, 2, 1, 3))
+        node_map = hg.save_succinct_tree(filename, tree)
+        self.assertTrue(np.all(node_map == (7, 5, 0, 1, 6, 2, 3, 4)))
+        altitudes_preorder = altitudes[node_map]
+
+        for mmap in (False, True):
+            stree = hg.read_succinct_tree(filename, mmap=mmap)
+            self.assertTrue(stree.num_vertices() == 8)
+            self.assertTrue(stree.num_leaves() == 5)
+            self.assertTrue(np.all(stree.parent(np.arange(8)) == (0, 0, 1, 1, 0, 4, 4, 4)))
+            self.assertTrue(altitudes_preorder[stree.lowest_common_ancestor(2, 5)] == 3)
+            tree2, node_map2 = stree.to_tree()
+            self.assertTrue(np.all(tree2.parents() == (6, 6, 5, 5, 5, 7, 7, 7)))
+            self.assertTrue(np.all(altitudes_preorder[node_map2] == (0, 0, 0, 0, 0, 1, 2, 3)))
+            del stree
+
+        self.assertTrue(hg.save_succinct_tree(filename, hg.SuccinctTree(tree)) is None)
+        self.assertTrue(hg.read_succinct_tree(filename).num_vertices() == 8)
+
+        silent_remove(filename)
+
+    def test_tree_sequence(self):
+        filename = "testTreeSequence.hgseq"
+        silent_remove(filename)
+
+        tree1 = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        tree2 = hg.Tree((5, 5, 6, 6, 7, 6, 7, 7))
+        tree3 = hg.Tree((3, 3, 4, 4, 4))
+        trees = (tree1, tree2, tree2, tree3, tree1)
+        altitudes = (np.asarray((0, 0, 0, 0, 0, 1, 2, 3)),
+                     np.asarray((0, 0, 0, 0, 0, 1, 2.5, 3)),
+                     np.asarray((0, 0, 0, 0, 0, 1, 2.5, 3), dtype=np.int32),
+                     np.asarray((0, 0, 0, 1, 2)),
+                     np.asarray((0, 0, 0, 0, 0, 1, 2, 3)))
+        hg.save_tree_sequence(filename, trees, altitudes, keyframe_interval=2)
+
+        reader = hg.read_tree_sequence(filename)
+        self.assertTrue(len(reader) == 5)
+        self.assertTrue(reader.keyframe_interval() == 2)
+        self.assertTrue([reader.is_keyframe(i) for i in range(5)] == [True, False, True, True, True])
+
+        for i in (4, 1, 3, 0, 2, -1):
+            tree, alt = reader[i]
+            self.assertTrue(np.all(tree.parents() == trees[i].parents()))
+            self.assertTrue(np.all(alt == altitudes[i]))
+            self.assertTrue(alt.dtype == np.float64)
+
+        frames = list(reader)
+        self.assertTrue(len(frames) == 5)
+        self.assertTrue(np.all(frames[3][0].parents() == tree3.parents()))
+
+        with self.assertRaises(IndexError):
+            reader[5]
+
+        del reader, frames
+        silent_remove(filename)
+
+    def test_tree_collection(self):
+        filename = "testTreeCollection.hgcol"
+        silent_remove(filename)
+
+        image = np.random.rand(9, 11, 3)
+        graph = hg.get_4_adjacency_graph(image.shape[:2])
+        trees = {}
+        for c in range(3):
+            tree, altitudes = hg.bpt_canonical(graph, hg.weight_graph(graph, image[:, :, c], hg.WeightFunction.L1))
+            trees["channel" + str(c)] = (tree, {"altitudes": altitudes, "area": hg.attribute_area(tree)})
+        trees["tree"] = hg.Tree((99,) * 99 + (99,))
+        hg.save_tree_collection(filename, trees, vertex_attributes={"image": image})
+
+        for mmap in (True, False):
+            collection = hg.read_tree_collection(filename, mmap=mmap)
+            self.assertTrue(len(collection) == 4)
+            self.assertTrue(list(collection) == ["channel0", "channel1", "channel2", "tree"])
+            self.assertTrue("channel1" in collection)
+            self.assertFalse("channel3" in collection)
+            self.assertTrue(collection.has_leaf_graph())
+
+            for name in ("channel2", "tree", "channel0"):
+                tree, attributes = collection[name]
+                ref_tree = trees[name][0] if name != "tree" else trees[name]
+                self.assertTrue(np.all(tree.parents() == ref_tree.parents()))
+                if name != "tree":
+                    self.assertTrue(np.all(attributes["altitudes"] == trees[name][1]["altitudes"]))
+                    self.assertTrue(np.all(tree.altitudes == trees[name][1]["altitudes"]))
+                    self.assertTrue(attributes["area"].dtype == trees[name][1]["area"].dtype)
+
+            leaf_graph, vertex_attributes = collection.leaf_graph()
+            self.assertTrue(hg.CptHierarchy.get_leaf_graph(collection["channel1"][0]) is leaf_graph)
+            self.assertTrue(hg.CptGridGraph.get_shape(leaf_graph) == (9, 11))
+            self.assertTrue(np.all(vertex_attributes["image"] == image))
+            self.assertTrue(np.all(leaf_graph.edge_list()[0] == graph.edge_list()[0]))
+
+            with self.assertRaises(KeyError):
+                collection["channel3"]
+            del collection, tree, attributes, leaf_graph, vertex_attributes
+
+        silent_remove(filename)
+
+        hg.save_tree_collection(filename, {"a": hg.Tree((2, 2, 2))})
+        collection = hg.read_tree_collection(filename)
+        self.assertFalse(collection.has_leaf_graph())
+        self.assertTrue(np.all(collection["a"][0].parents() == (2, 2, 2)))
+        del collection
+        silent_remove(filename)
+
     def test_print_partition_tree(self):
         tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
         s = hg.print_partition_tree(tree, altitudes=np.asarray([0, 0, 0, 0, 0, 100, 1100, 20000]),
@@ -80,6 +275,29 @@ class TestTreeIO(unittest.TestCase):
         self.assertTrue(ref == s)
 
     # this is really just a non throw test...
+    def test_treeReadWriteLCA(self):
+        filename = "testTreeIOLCA.graph"
+        silent_remove(filename)
+        silent_remove(filename + ".lca")
+
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        for algorithm in ("sparse_table", "sparse_table_block", "bitmask_block"):
+            lca = tree.lowest_common_ancestor_preprocess(algorithm=algorithm, block_size=2, force_recompute=True)
+            hg.save_tree(filename, tree, lca_index=True)
+
+            tree2, _ = hg.read_tree(filename, lca_index=True)
+            lca2 = hg.get_attribute(tree2, "lca_fast")
+            self.assertTrue(type(lca2) is type(lca))
+            self.assertTrue(tree2.lowest_common_ancestor_preprocess() is lca2)
+
+            v1 = np.asarray((0, 0, 1, 3, 2, 7), dtype=np.int64)
+            v2 = np.asarray((0, 3, 0, 4, 6, 1), dtype=np.int64)
+            self.assertTrue(np.all(lca2.lca(v1, v2) == lca.lca(v1, v2)))
+            del tree2, lca2
+
+        silent_remove(filename)
+        silent_remove(filename + ".lca")
+
     def test_print_partition_tree(self):
         tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
 
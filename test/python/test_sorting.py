@@ -37,3 +37,20 @@ class TestSorting(unittest.TestCase):
                         (2, 2, 2, 1, 0))).T
         i = hg.arg_sort(a, stable=True)
         self.assertTrue(np.all(i == (3, 2, 0, 1, 4)))
+
+    def test_arg_sort_initial_order(self):
+        a = np.asarray((3, 5, 5, 1, 2, 5, 0, 7, 2, 2, 2))
+        ref = hg.arg_sort(a, stable=True)
+        self.assertTrue(np.all(hg.arg_sort(a, initial_order=ref) == ref))
+        self.assertTrue(np.all(hg.arg_sort(a, initial_order=np.arange(a.size)) == ref))
+
+        np.random.seed(42)
+        b = np.round(np.random.rand(5000) * 100)
+        order = hg.arg_sort(b, stable=True)
+        b[np.random.randint(0, b.size, 50)] += 3
+        self.assertTrue(np.all(hg.arg_sort(b, initial_order=order) == np.argsort(b, kind="stable")))
+
+        with self.assertRaises(RuntimeError):
+            hg.arg_sort(a, initial_order=(0, 1))
+        with self.assertRaises(RuntimeError):
+            hg.arg_sort(a, initial_order=np.arange(a.size) + 1)
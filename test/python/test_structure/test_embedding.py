@@ -114,6 +114,37 @@ class TestEmbedding(unittest.TestCase):
             self.assertTrue(e.test == e2.test)
             self.assertTrue(hg.has_tag(e2, "foo"))
 
+    def test_embedding_morton_2d(self):
+        import pickle
+        e = hg.EmbeddingMorton2d((6, 5), 4)
+        self.assertTrue(e.size() == 30)
+        self.assertTrue(e.dimension() == 2)
+        self.assertTrue(e.tile_size() == 4)
+
+        ref = np.array(((0, 1, 4, 5, 16),
+                        (2, 3, 6, 7, 17),
+                        (8, 9, 12, 13, 18),
+                        (10, 11, 14, 15, 19),
+                        (20, 21, 22, 23, 28),
+                        (24, 25, 26, 27, 29)))
+        coords = np.stack(np.meshgrid(np.arange(6), np.arange(5), indexing="ij"), axis=-1)
+        self.assertTrue(np.all(e.grid2lin(coords) == ref))
+        self.assertTrue(np.all(e.lin2grid(ref) == coords))
+        self.assertTrue(e.grid2lin((4, 3)) == 23)
+        self.assertTrue(np.all(e.lin2grid(23) == (4, 3)))
+        self.assertTrue(e.contains((5, 4)))
+        self.assertFalse(e.contains((6, 0)))
+
+        image = np.random.rand(6, 5, 3)
+        values = e.to_morton_order(image)
+        self.assertTrue(values.shape == (30, 3))
+        self.assertTrue(np.all(values[ref] == image))
+        self.assertTrue(np.all(e.to_row_major_order(values) == image))
+
+        e2 = pickle.loads(pickle.dumps(e))
+        self.assertTrue(np.all(e2.shape() == e.shape()))
+        self.assertTrue(e2.tile_size() == 4)
+
 
 if __name__ == '__main__':
     unittest.main()
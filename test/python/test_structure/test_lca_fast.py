@@ -8,6 +8,7 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+import sys
 import unittest
 import numpy as np
 import higra as hg
@@ -22,7 +23,7 @@ class TestLCAFast(unittest.TestCase):
 
     def test_LCAFast(self):
         t = TestLCAFast.getTree()
-        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block]:
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
             with self.subTest(lca_type=lca_t):
                 lca = lca_t(t)
 
@@ -62,7 +63,7 @@ class TestLCAFast(unittest.TestCase):
     def test_LCAFastV(self):
         g = hg.get_4_adjacency_graph((2, 2))
         t = hg.Tree((4, 4, 5, 5, 6, 6, 6))
-        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block]:
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
             with self.subTest(lca_type=lca_t):
                 lca = lca_t(t)
 
@@ -72,7 +73,7 @@ class TestLCAFast(unittest.TestCase):
 
     def test_LCAFastVertices(self):
         t = hg.Tree((4, 4, 5, 5, 6, 6, 6))
-        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block]:
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
             with self.subTest(lca_type=lca_t):
                 lca = lca_t(t)
                 res = lca.lca((0, 0, 1, 3), (0, 3, 0, 0))
@@ -80,7 +81,7 @@ class TestLCAFast(unittest.TestCase):
 
     def test_dynamic_attributes(self):
         t = hg.Tree((4, 4, 5, 5, 6, 6, 6))
-        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block]:
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
             with self.subTest(lca_type=lca_t):
                 lca = lca_t(t)
                 lca.new_attribute = 42
@@ -89,7 +90,7 @@ class TestLCAFast(unittest.TestCase):
     def test_pickle(self):
         import pickle
         tree = hg.Tree((4, 4, 5, 5, 6, 6, 6))
-        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block]:
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
             with self.subTest(lca_type=lca_t):
                 lca = lca_t(tree)
                 hg.set_attribute(lca, "test", (1, 2, 3))
@@ -105,6 +106,24 @@ class TestLCAFast(unittest.TestCase):
                 self.assertTrue(lca.test == lca2.test)
                 self.assertTrue(hg.has_tag(lca2, "foo"))
 
+    @unittest.skipIf(sys.version_info < (3, 8), "pickle protocol 5 requires python 3.8")
+    def test_pickle_out_of_band(self):
+        import pickle
+        tree = hg.Tree((4, 4, 5, 5, 6, 6, 6))
+        for lca_t in [hg.LCA_rmq_sparse_table, hg.LCA_rmq_sparse_table_block, hg.LCA_rmq_bitmask_block]:
+            with self.subTest(lca_type=lca_t):
+                lca = lca_t(tree)
+
+                buffers = []
+                data = pickle.dumps(lca, protocol=5, buffer_callback=buffers.append)
+                self.assertTrue(len(buffers) > 0)
+                lca2 = pickle.loads(data, buffers=buffers)
+
+                # the state arrays are not copied
+                self.assertTrue(np.shares_memory(lca._get_state()[0][0], lca2._get_state()[0][0]))
+                res = lca2.lca((0, 0, 1, 3), (0, 3, 0, 0))
+                self.assertTrue(np.all(res == (0, 6, 4, 6)))
+
 
 if __name__ == '__main__':
     unittest.main()
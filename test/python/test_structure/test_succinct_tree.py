@@ -0,0 +1,67 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+
+class TestSuccinctTree(unittest.TestCase):
+
+    def test_simple_tree(self):
+        tree = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
+        stree, node_map = hg.make_succinct_tree(tree)
+        self.assertTrue(np.all(node_map == (7, 5, 0, 1, 6, 2, 3, 4)))
+
+        self.assertTrue(stree.num_vertices() == 8)
+        self.assertTrue(stree.num_leaves() == 5)
+        self.assertTrue(stree.root() == 0)
+        self.assertTrue(stree.parent(0) == 0)
+        self.assertTrue(stree.parent(3) == 1)
+        self.assertTrue(np.all(stree.parent(np.asarray((2, 4, 7), dtype=np.int64)) == (1, 0, 4)))
+        self.assertTrue(stree.subtree_size(1) == 3)
+        self.assertTrue(np.all(stree.subtree_size(np.arange(8)) == (8, 3, 1, 1, 4, 1, 1, 1)))
+        self.assertTrue(np.all(stree.depth(np.arange(8)) == (0, 1, 2, 2, 1, 2, 2, 2)))
+        self.assertTrue(stree.is_leaf(2))
+        self.assertFalse(stree.is_leaf(4))
+        self.assertTrue(np.all(stree.children(4) == (5, 6, 7)))
+        self.assertTrue(stree.num_children(0) == 2)
+        self.assertTrue(stree.lowest_common_ancestor(2, 3) == 1)
+        self.assertTrue(np.all(stree.lowest_common_ancestor(np.asarray((2, 3, 5), dtype=np.int64),
+                                                            np.asarray((3, 6, 7), dtype=np.int64)) == (1, 0, 4)))
+
+        tree2, node_map2 = stree.to_tree()
+        self.assertTrue(np.all(tree2.parents() == (6, 6, 5, 5, 5, 7, 7, 7)))
+        self.assertTrue(np.all(node_map2 == (2, 3, 5, 6, 7, 4, 1, 0)))
+
+        with self.assertRaises(Exception):
+            stree.parent(8)
+
+    def test_random_tree(self):
+        np.random.seed(1)
+        graph = hg.get_4_adjacency_graph((30, 40))
+        edge_weights = np.random.randint(0, 20, graph.num_edges())
+        tree, altitudes = hg.quasi_flat_zone_hierarchy(graph, edge_weights)
+        stree, node_map = hg.make_succinct_tree(tree)
+        preorder = np.empty_like(node_map)
+        preorder[node_map] = np.arange(tree.num_vertices())
+
+        self.assertTrue(np.all(node_map[stree.parent(preorder)] == tree.parents()))
+        self.assertTrue(np.all(stree.depth(preorder) == hg.attribute_depth(tree)))
+
+        v1 = np.random.randint(0, tree.num_vertices(), 500)
+        v2 = np.random.randint(0, tree.num_vertices(), 500)
+        lca = node_map[stree.lowest_common_ancestor(preorder[v1], preorder[v2])]
+        self.assertTrue(np.all(lca == tree.lowest_common_ancestor(v1, v2)))
+        self.assertTrue(stree.memory_usage() * 8 < 4 * tree.num_vertices())
+
+
+if __name__ == '__main__':
+    unittest.main()
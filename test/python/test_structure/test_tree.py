@@ -8,6 +8,7 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+import sys
 import unittest
 import numpy as np
 import higra as hg
@@ -238,6 +239,25 @@ class TestTree(unittest.TestCase):
         self.assertTrue(np.all(t.child(0, (5, 7, 6)) == (0, 5, 2)))
         self.assertTrue(np.all(t.child(1, (5, 7, 6)) == (1, 6, 3)))
 
+    def test_children_csr(self):
+        t = TestTree.get_tree()
+        t.clear_children()
+
+        offsets, children = t.children_csr()
+        self.assertTrue(np.all(offsets == (0, 2, 5, 7)))
+        self.assertTrue(np.all(children == (0, 1, 2, 3, 4, 5, 6)))
+        self.assertFalse(offsets.flags.writeable)
+        self.assertFalse(children.flags.writeable)
+        num_leaves = t.num_leaves()
+        for n in range(num_leaves, t.num_vertices()):
+            b, e = offsets[n - num_leaves], offsets[n - num_leaves + 1]
+            self.assertTrue(np.all(children[b:e] == t.children(n)))
+
+        # the views stay valid if the children relation is cleared or if the tree is destroyed
+        t.clear_children()
+        del t
+        self.assertTrue(np.all(children == (0, 1, 2, 3, 4, 5, 6)))
+
     def test_leaves_iterator(self):
         t = TestTree.get_tree()
 
@@ -265,6 +285,57 @@ class TestTree(unittest.TestCase):
 
         self.assertTrue(np.all(tree.find_region(vertices, lambdas, altitudes) == expected_results))
 
+    def test_find_region_level_ancestors(self):
+        tree = hg.Tree((8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12))
+
+        altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 2, 2, 3), dtype=np.int32)
+        vertices = np.asarray((0, 0, 0, 2, 2, 9, 9, 12), dtype=np.int64)
+        lambdas = np.asarray((2, 3, 4, 1, 2, 2, 3, 3), dtype=np.float64)
+
+        expected_results = np.asarray((0, 10, 12, 2, 9, 9, 10, 12), dtype=np.int64)
+
+        level_ancestors = tree.level_ancestors_preprocess()
+        self.assertTrue(tree.level_ancestors_preprocess() is level_ancestors)
+
+        for i in range(vertices.size):
+            self.assertTrue(tree.find_region(vertices[i], lambdas[i], altitudes) == expected_results[i])
+            self.assertTrue(level_ancestors.find_region(vertices[i], lambdas[i], altitudes) == expected_results[i])
+
+        self.assertTrue(np.all(tree.find_region(vertices, lambdas, altitudes) == expected_results))
+        self.assertTrue(np.all(level_ancestors.find_region(vertices, lambdas, altitudes) == expected_results))
+
+        depths = np.asarray((3, 2, 1, 0, 1, 2, 1, 0), dtype=np.int64)
+        expected_ancestors = np.asarray((0, 8, 10, 12, 10, 9, 10, 12), dtype=np.int64)
+        self.assertTrue(np.all(level_ancestors.level_ancestor(vertices, depths) == expected_ancestors))
+
+    def test_leaf_ranges(self):
+        tree = hg.Tree((8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12))
+
+        leaf_ranges = tree.leaf_ranges_preprocess()
+        self.assertTrue(tree.leaf_ranges_preprocess() is leaf_ranges)
+        self.assertTrue(leaf_ranges.num_elements() == 13)
+
+        self.assertTrue(np.all(leaf_ranges.leaves() == (0, 1, 2, 3, 4, 5, 6)))
+        self.assertTrue(np.all(leaf_ranges.begins() == (0, 1, 2, 3, 4, 5, 6, 3, 0, 2, 0, 5, 0)))
+        self.assertTrue(np.all(leaf_ranges.ends() == (1, 2, 3, 4, 5, 6, 7, 5, 2, 5, 5, 7, 7)))
+        self.assertTrue(np.all(leaf_ranges.leaves(9) == (2, 3, 4)))
+        self.assertTrue(np.all(leaf_ranges.leaves(7) == (3, 4)))
+        self.assertFalse(leaf_ranges.leaves(9).flags.writeable)
+
+    def test_leaf_ranges_leaf_sums(self):
+        tree = hg.Tree((8, 8, 9, 7, 7, 11, 11, 9, 10, 10, 12, 12, 12))
+        leaf_ranges = tree.leaf_ranges_preprocess()
+
+        signal = np.asarray((1, 2, 3, 4, 5, 6, 7), dtype=np.int64)
+        ref = hg.accumulate_sequential(tree, signal, hg.Accumulators.sum)
+        self.assertTrue(np.all(leaf_ranges.leaf_sums(signal) == ref))
+
+        signal2 = np.random.rand(tree.num_leaves(), 2, 3)
+        ref2 = hg.accumulate_sequential(tree, signal2, hg.Accumulators.sum)
+        res2 = leaf_ranges.leaf_sums(signal2)
+        self.assertTrue(res2.shape == (tree.num_vertices(), 2, 3))
+        self.assertTrue(np.allclose(res2, ref2))
+
     def test_lowest_common_ancestor_scalar(self):
         t = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7))
 
@@ -310,6 +381,59 @@ class TestTree(unittest.TestCase):
         self.assertTrue(t.test == t2.test)
         self.assertTrue(hg.has_tag(t2, "foo"))
 
+    @unittest.skipIf(sys.version_info < (3, 8), "pickle protocol 5 requires python 3.8")
+    def test_pickle_out_of_band(self):
+        import pickle
+        t = hg.Tree((5, 5, 6, 6, 6, 7, 7, 7), category=hg.TreeCategory.ComponentTree)
+        hg.set_attribute(t, "test", (1, 2, 3))
+
+        buffers = []
+        data = pickle.dumps(t, protocol=5, buffer_callback=buffers.append)
+        self.assertTrue(len(buffers) > 0)
+        t2 = pickle.loads(data, buffers=buffers)
+
+        # the parents are not copied
+        self.assertTrue(np.shares_memory(t.parents(), t2.parents()))
+        self.assertTrue(np.all(t.parents() == t2.parents()))
+        self.assertTrue(t2.num_leaves() == 5)
+        self.assertTrue(t2.category() == hg.TreeCategory.ComponentTree)
+        self.assertTrue(np.all(t2.children(6) == (2, 3, 4)))
+        self.assertTrue(hg.get_attribute(t2, "test") == (1, 2, 3))
+
+    def test_from_buffer(self):
+        parents = np.asarray((5, 5, 6, 6, 6, 7, 7, 7), dtype=hg.index_t)
+        t = hg.Tree.from_buffer(parents)
+        self.assertTrue(t.num_leaves() == 5)
+        self.assertTrue(np.all(t.parents() == parents))
+        self.assertTrue(t.parents().dtype == hg.index_t)
+        self.assertTrue(np.all(t.children(6) == (2, 3, 4)))
+        self.assertFalse(t.parents().flags.writeable)
+
+        t2 = hg.Tree.from_buffer(parents, num_leaves=5)
+        self.assertTrue(t2.num_leaves() == 5)
+        self.assertTrue(np.all(t2.parents() == parents))
+
+    def test_ctr_read_only_parents_no_copy(self):
+        parents = np.asarray((5, 5, 6, 6, 6, 7, 7, 7), dtype=hg.index_t)
+        parents.setflags(write=False)
+        t = hg.Tree(parents)
+        self.assertTrue(np.shares_memory(t.parents(), parents))
+        self.assertTrue(t.num_leaves() == 5)
+
+        # the parents of a tree are read-only
+        t2 = hg.Tree(t.parents())
+        self.assertTrue(np.shares_memory(t2.parents(), parents))
+
+        # writeable arrays are copied
+        parents2 = parents.copy()
+        t3 = hg.Tree(parents2)
+        self.assertFalse(np.shares_memory(t3.parents(), parents2))
+
+        with self.assertRaises(RuntimeError):
+            invalid = np.asarray((5, 0, 6, 6, 6, 7, 7, 7), dtype=hg.index_t)
+            invalid.setflags(write=False)
+            hg.Tree(invalid)
+
     def test_sub_tree(self):
         tree = hg.Tree(np.asarray((8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14)))
 
@@ -328,6 +452,18 @@ class TestTree(unittest.TestCase):
         self.assertTrue(np.all(sub_tree.parents() == (0,)))
         self.assertTrue(np.all(node_map == (3,)))
 
+    def test_sub_trees(self):
+        tree = hg.Tree(np.asarray((8, 8, 9, 9, 10, 10, 11, 13, 12, 12, 11, 13, 14, 14, 14)))
+
+        roots = (13, 3, 14, 11, 13)
+        sub_trees, node_maps = tree.sub_trees(roots)
+        self.assertTrue(len(sub_trees) == len(roots))
+        self.assertTrue(len(node_maps) == len(roots))
+        for root, sub_tree, node_map in zip(roots, sub_trees, node_maps):
+            ref_sub_tree, ref_node_map = tree.sub_tree(root)
+            self.assertTrue(np.all(ref_sub_tree.parents() == sub_tree.parents()))
+            self.assertTrue(np.all(ref_node_map == node_map))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,82 @@
+############################################################################
+# Copyright ESIEE Paris (2021)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+
+class TestUltrametricLeafIndex(unittest.TestCase):
+
+    @staticmethod
+    def get_index():
+        # depth first order of the leaves: 3, 4, 8, 6, 7, 0, 1, 2, 5
+        tree = hg.Tree((9, 9, 10, 11, 11, 10, 12, 12, 13, 14, 14, 16, 13, 15, 15, 16, 16))
+        altitudes = np.asarray((0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 1, 1, 3, 4, 5, 6), dtype=np.float64)
+        return hg.UltrametricLeafIndex(tree, altitudes)
+
+    def test_single_queries(self):
+        index = TestUltrametricLeafIndex.get_index()
+        self.assertTrue(index.num_leaves() == 9)
+        self.assertTrue(index.distance(5, 0) == 4)
+        self.assertTrue(index.ball(0, 4.5) == 14)
+        self.assertTrue(np.all(index.leaf_ranges().leaves() == (3, 4, 8, 6, 7, 0, 1, 2, 5)))
+
+        leaves, distances = index.nearest_leaves(0, 3)
+        self.assertTrue(np.all(leaves == (1, 2, 5)))
+        self.assertTrue(np.all(distances == (1, 4, 4)))
+
+        leaves, distances = index.nearest_leaves(0, 100)
+        self.assertTrue(np.all(leaves == (1, 2, 5, 8, 6, 7, 3, 4)))
+        self.assertTrue(np.all(distances == (1, 4, 4, 5, 5, 5, 6, 6)))
+
+        leaves, distances = index.leaves_within(0, 4.5)
+        self.assertTrue(np.all(leaves == (1, 2, 5)))
+        self.assertTrue(np.all(distances == (1, 4, 4)))
+        leaves, distances = index.leaves_within(0, 0.5)
+        self.assertTrue(leaves.size == 0)
+
+    def test_batch_queries(self):
+        index = TestUltrametricLeafIndex.get_index()
+        leaves, distances = index.nearest_leaves(np.asarray((0, 3)), 2)
+        self.assertTrue(np.all(leaves == ((1, 2), (4, 8))))
+        self.assertTrue(np.all(distances == ((1, 4), (1, 6))))
+
+        offsets, leaves, distances = index.leaves_within(np.asarray((0, 3, 7)), np.asarray((4, 1, 0)))
+        self.assertTrue(np.all(offsets == (0, 3, 4, 4)))
+        self.assertTrue(np.all(leaves == (1, 2, 5, 4)))
+        self.assertTrue(np.all(distances == (1, 4, 4, 1)))
+
+        offsets, leaves, distances = index.leaves_within(np.asarray((0, 3)), 1)
+        self.assertTrue(np.all(offsets == (0, 1, 2)))
+        self.assertTrue(np.all(leaves == (1, 4)))
+
+    def test_random_bpt(self):
+        np.random.seed(1)
+        graph = hg.get_4_adjacency_graph((15, 12))
+        tree, altitudes = hg.bpt_canonical(graph, np.random.randint(0, 10, graph.num_edges()))
+        index = hg.UltrametricLeafIndex(tree, altitudes)
+        num_leaves = tree.num_leaves()
+        queries = np.random.randint(0, num_leaves, 20)
+
+        knn_leaves, knn_distances = index.nearest_leaves(queries, 15)
+        offsets, within_leaves, within_distances = index.leaves_within(queries, 4)
+        lca = tree.lowest_common_ancestor_preprocess()
+        for i, q in enumerate(queries):
+            others = np.setdiff1d(np.arange(num_leaves), (q,))
+            ref = altitudes[lca.lca(np.full_like(others, q), others)]
+            self.assertTrue(np.all(knn_distances[i] == np.sort(ref)[:15]))
+            self.assertTrue(q not in knn_leaves[i])
+            self.assertTrue(np.all(altitudes[lca.lca(np.full(15, q), knn_leaves[i])] == knn_distances[i]))
+            self.assertTrue(np.all(np.sort(within_leaves[offsets[i]:offsets[i + 1]]) == others[ref <= 4]))
+
+
+if __name__ == '__main__':
+    unittest.main()
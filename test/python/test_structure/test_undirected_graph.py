@@ -8,6 +8,7 @@
 # The full license is in the file LICENSE, distributed with this software. #
 ############################################################################
 
+import sys
 import unittest
 import higra as hg
 import numpy as np
@@ -72,6 +73,23 @@ class TestUndirectedGraph(unittest.TestCase):
         for i in range(g2.num_edges()):
             self.assertTrue(g.edge_from_index(i) == g2.edge_from_index(i))
 
+    def test_constructor_from_edges(self):
+        sources = np.asarray((0, 2, 3, 1, 0), dtype=np.int64)
+        targets = np.asarray((1, 1, 0, 3, 3), dtype=np.int64)
+        g = hg.UndirectedGraph(4, sources, targets)
+
+        g_ref = hg.UndirectedGraph(4)
+        for s, t in zip(sources, targets):
+            g_ref.add_edge(s, t)
+
+        self.assertTrue(g.num_vertices() == 4)
+        self.assertTrue(g.num_edges() == 5)
+        for v in range(4):
+            self.assertTrue(list(g.out_edges(v)) == list(g_ref.out_edges(v)))
+
+        with self.assertRaises(RuntimeError):
+            hg.UndirectedGraph(3, sources, targets)
+
     def test_dynamic_attributes(self):
         g = TestUndirectedGraph.test_graph()
         g.new_attribute = 42
@@ -235,6 +253,43 @@ class TestUndirectedGraph(unittest.TestCase):
         self.assertTrue(g.test == g2.test)
         self.assertTrue(hg.has_tag(g2, "foo"))
 
+    @unittest.skipIf(sys.version_info < (3, 8), "pickle protocol 5 requires python 3.8")
+    def test_pickle_out_of_band(self):
+        import pickle
+        g = TestUndirectedGraph.test_graph()
+        g.set_edge(0, 2, 3)
+        g.remove_edge(1)
+
+        buffers = []
+        data = pickle.dumps(g, protocol=5, buffer_callback=buffers.append)
+        self.assertTrue(len(buffers) > 0)
+        g2 = pickle.loads(data, buffers=buffers)
+
+        self.assertTrue(g.num_vertices() == g2.num_vertices())
+        self.assertTrue(g.num_edges() == g2.num_edges())
+        self.assertTrue(np.all(g.sources() == g2.sources()))
+        self.assertTrue(np.all(g.targets() == g2.targets()))
+        for v in g.vertices():
+            self.assertTrue(list(g.out_edges(v)) == list(g2.out_edges(v)))
+
+    def test_compact_edges(self):
+        g = TestUndirectedGraph.test_graph()
+        g.add_edge(2, 3)
+        edge_weights = np.arange(g.num_edges())
+        g.remove_edge(1)
+        g.remove_edge(3)
+
+        old_to_new, new_to_old = g.compact_edges()
+        self.assertTrue(np.all(old_to_new == (0, -1, 1, -1)))
+        self.assertTrue(np.all(new_to_old == (0, 2)))
+        self.assertTrue(g.num_edges() == 2)
+        self.assertTrue(np.all(g.sources() == (0, 0)))
+        self.assertTrue(np.all(g.targets() == (1, 2)))
+        self.assertTrue(np.all(edge_weights[new_to_old] == (0, 2)))
+        out_edges = [[(e[0], e[1], e[2]) for e in g.out_edges(v)] for v in g.vertices()]
+        self.assertTrue(out_edges == [[(0, 1, 0), (0, 2, 1)], [(1, 0, 0)], [(2, 0, 1)], []])
+
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,53 @@
+############################################################################
+# Copyright ESIEE Paris (2018)                                             #
+#                                                                          #
+# Contributor(s) : Benjamin Perret                                         #
+#                                                                          #
+# Distributed under the terms of the CECILL-B License.                     #
+#                                                                          #
+# The full license is in the file LICENSE, distributed with this software. #
+############################################################################
+
+import unittest
+import numpy as np
+import higra as hg
+
+
+class TestWorkspace(unittest.TestCase):
+
+    def test_workspace(self):
+        graph = hg.get_4_adjacency_graph((10, 12))
+        edge_weights = np.random.randint(0, 10, hg.num_edges(graph)).astype(np.float64)
+
+        tree_ref, altitudes_ref = hg.watershed_hierarchy_by_area(graph, edge_weights)
+        labels_ref = hg.labelisation_horizontal_cut_from_threshold(tree_ref, altitudes_ref, 3)
+
+        workspace = hg.Workspace()
+        self.assertTrue(workspace.cached_bytes() == 0)
+        for _ in range(2):
+            with workspace:
+                tree, altitudes = hg.watershed_hierarchy_by_area(graph, edge_weights)
+                labels = hg.labelisation_horizontal_cut_from_threshold(tree, altitudes, 3)
+            self.assertTrue(np.all(tree.parents() == tree_ref.parents()))
+            self.assertTrue(np.all(altitudes == altitudes_ref))
+            self.assertTrue(np.all(labels == labels_ref))
+            self.assertTrue(workspace.cached_bytes() > 0)
+
+        workspace.release()
+        self.assertTrue(workspace.cached_bytes() == 0)
+
+    def test_nested_workspaces(self):
+        graph = hg.get_4_adjacency_graph((4, 5))
+        edge_weights = np.arange(hg.num_edges(graph), dtype=np.float64)
+        workspace1 = hg.Workspace()
+        workspace2 = hg.Workspace()
+        with workspace1:
+            with workspace2:
+                hg.bpt_canonical(graph, edge_weights)
+            hg.bpt_canonical(graph, edge_weights)
+        self.assertTrue(workspace1.cached_bytes() > 0)
+        self.assertTrue(workspace2.cached_bytes() > 0)
+
+
+if __name__ == '__main__':
+    unittest.main()